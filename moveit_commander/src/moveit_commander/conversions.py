@@ -37,6 +37,7 @@ from moveit_commander import MoveItCommanderException
 from geometry_msgs.msg import Pose, PoseStamped, Transform
 import rospy
 import tf
+import numpy
 
 def msg_to_string(msg):
     buf = StringIO.StringIO()
@@ -108,3 +109,13 @@ def list_to_transform(trf_list):
     trf_msg.rotation.z = trf_list[5]
     trf_msg.rotation.w = trf_list[6]
     return trf_msg
+
+def array_to_buffer(values):
+    """ Get a contiguous float64 array of the values, which the bindings read without copying if it already is one """
+    return numpy.ascontiguousarray(values, dtype=numpy.float64)
+
+def buffer_to_array(buf, *shape):
+    """ Wrap a buffer of float64 values returned by the bindings in a NumPy array of the given shape, without copying """
+    if len(buf) == 0:
+        return numpy.zeros(0).reshape(shape)
+    return numpy.frombuffer(buf, dtype=numpy.float64).reshape(shape)
@@ -99,6 +99,10 @@ class MoveGroupCommander(object):
         """ Get the current configuration of the group as a list (these are values published on /joint_states) """
         return self._g.get_current_joint_values()
 
+    def get_current_joint_values_array(self):
+        """ Get the current configuration of the group as a NumPy array """
+        return conversions.buffer_to_array(self._g.get_current_joint_values_array(), -1)
+
     def get_current_pose(self, end_effector_link = ""):
         """ Get the current pose of the end-effector of the group. Throws an exception if there is not end-effector. """
         if len(end_effector_link) > 0 or self.has_end_effector_link():
@@ -475,6 +479,18 @@ class MoveGroupCommander(object):
         plan.deserialize(self._g.compute_plan())
         return plan
 
+    def plan_arrays(self):
+        """ Plan to the set goal state and return the joint trajectory as NumPy arrays instead of a RobotTrajectory message: a tuple (success, joint_names, positions, velocities, accelerations, time_from_start). positions, velocities and accelerations have one row per waypoint; velocities and accelerations are empty if the planner did not set them. """
+        (success, names, pos, vel, acc, times) = self._g.compute_plan_arrays()
+        n = max(len(names), 1)
+        return (success, names, conversions.buffer_to_array(pos, -1, n), conversions.buffer_to_array(vel, -1, n),
+                conversions.buffer_to_array(acc, -1, n), conversions.buffer_to_array(times, -1))
+
+    def execute_arrays(self, joint_names, positions, time_from_start, velocities = [], accelerations = [], wait = True):
+        """ Execute a joint trajectory given as arrays with one row per waypoint, as returned by plan_arrays() """
+        return self._g.execute_arrays(joint_names, conversions.array_to_buffer(positions), conversions.array_to_buffer(velocities),
+                                      conversions.array_to_buffer(accelerations), conversions.array_to_buffer(time_from_start), wait)
+
     def compute_cartesian_path(self, waypoints, eef_step, jump_threshold, avoid_collisions = True):
         """ Compute a sequence of waypoints that make the end-effector move in straight line segments that follow the poses specified as waypoints. Configurations are computed for every eef_step meters; The jump_threshold specifies the maximum distance in configuration space between consecutive points in the resultingpath. The return value is a tuple: a fraction of how much of the path was followed, the actual RobotTrajectory. """
         (ser_path, fraction) = self._g.compute_cartesian_path([conversions.pose_to_list(p) for p in waypoints], eef_step, jump_threshold, avoid_collisions)
@@ -35,6 +35,7 @@
 from moveit_commander import MoveGroupCommander, MoveItCommanderException
 from moveit_ros_planning_interface import _moveit_robot_interface
 from moveit_msgs.msg import RobotState
+import numpy
 import conversions
 
 
@@ -198,6 +199,58 @@ class RobotCommander(object):
         s.deserialize(self._r.get_current_state())
         return s
 
+    def get_current_variable_array(self):
+        """
+        Get the current values of all the variables of the robot as a NumPy
+        array, in the order of get_variable_names()
+        """
+        return conversions.buffer_to_array(self._r.get_current_variable_array(), -1)
+
+    def get_variable_names(self, group=None):
+        """
+        Get the names of the variables of a group, in the order used by the
+        batched calls, or the names of all variables of the robot
+        """
+        if group is not None:
+            return self._r.get_group_variable_names(group)
+        return self._r.get_variable_names()
+
+    def compute_fk_batch(self, group, link, positions):
+        """
+        Compute the pose of a link for many configurations of a group at once.
+        positions is an N x get_group_variable_count array; the result is an
+        N x 7 array of (x, y, z, qx, qy, qz, qw) poses in the planning frame.
+        Variables outside the group keep their current values.
+        """
+        return conversions.buffer_to_array(self._r.compute_fk_batch(group, link, conversions.array_to_buffer(positions)), -1, 7)
+
+    def compute_ik_batch(self, group, poses, tip="", timeout=0.0):
+        """
+        Compute IK for an N x 7 array of poses (x, y, z, qx, qy, qz, qw) in the
+        planning frame. Each solution seeds the next one. Returns the N x n
+        array of solutions (NaN rows where IK failed) and a boolean array of
+        which poses were solved.
+        """
+        n = self._r.get_group_variable_count(group)
+        (solutions, found) = self._r.compute_ik_batch(group, conversions.array_to_buffer(poses), tip, timeout)
+        return (conversions.buffer_to_array(solutions, -1, n), numpy.array(found, dtype=bool))
+
+    def is_valid_batch(self, group, positions):
+        """
+        Check many configurations of a group at once against the joint bounds
+        and for self-collision. Objects in the planning scene are not taken
+        into account. Returns a boolean array.
+        """
+        return numpy.array(self._r.is_valid_batch(group, conversions.array_to_buffer(positions)), dtype=bool)
+
+    def get_jacobian_batch(self, group, positions, link=""):
+        """
+        Compute the 6 x n Jacobian of a link (by default the last link of the
+        group) for many configurations of the group. Returns an N x 6 x n array.
+        """
+        n = self._r.get_group_variable_count(group)
+        return conversions.buffer_to_array(self._r.get_jacobian_batch(group, conversions.array_to_buffer(positions), link), -1, 6, n)
+
     def get_current_variable_values(self):
         """
         Get a dictionary mapping variable names to values.
@@ -37,6 +37,7 @@
 #ifndef MOVEIT_BACKGROUND_PROCESSING_
 #define MOVEIT_BACKGROUND_PROCESSING_
 
+#include <chrono>
 #include <deque>
 #include <string>
 #include <boost/thread.hpp>
@@ -53,7 +54,10 @@ namespace tools
 {
 /** \brief This class provides simple API for executing background
     jobs. A queue of jobs is created and the specified jobs are
-    executed in order, one at a time. */
+    executed in order, one at a time. Jobs can be given a priority:
+    with more than one worker thread, jobs of different priorities
+    run in parallel, while jobs of the same priority are still
+    executed one at a time, in the order they were added. */
 class BackgroundProcessing : private boost::noncopyable
 {
 public:
@@ -68,25 +72,54 @@ public:
     COMPLETE
   };
 
+  /** \brief Priority classes for jobs. A worker that becomes free starts the oldest queued job of the highest
+      priority that no other worker is executing. Jobs that depend on each other must have the same priority. */
+  enum JobPriority
+  {
+    HIGH_PRIORITY,
+    NORMAL_PRIORITY,
+    LOW_PRIORITY
+  };
+
   /** \brief The signature for callback triggered when job events take place: the event that took place and the name of
    * the job */
   typedef boost::function<void(JobEvent, const std::string&)> JobUpdateCallback;
 
+  /** \brief The signature for callback triggered when a job is completed: the name of the job, the time it waited in
+   * the queue and the time its execution took, in seconds */
+  typedef boost::function<void(const std::string&, double, double)> JobTimingCallback;
+
   /** \brief The signature for job callbacks */
   typedef boost::function<void()> JobCallback;
 
-  /** \brief Constructor. The background thread is activated automatically. */
-  BackgroundProcessing();
+  /** \brief The identifier of a job returned by addJob(). Identifiers are never 0. */
+  typedef std::size_t JobId;
+
+  /** \brief Constructor. The \e worker_count background threads are activated automatically. */
+  explicit BackgroundProcessing(unsigned int worker_count = 1);
 
-  /** \brief Finishes currently executing job, clears the remaining queue. */
+  /** \brief Finishes currently executing jobs, executes the remaining queue. */
   ~BackgroundProcessing();
 
   /** \brief Add a job to the queue of jobs to execute. A name is also specifies for the job */
-  void addJob(const JobCallback& job, const std::string& name);
+  JobId addJob(const JobCallback& job, const std::string& name, JobPriority priority = NORMAL_PRIORITY);
 
-  /** \brief Get the size of the queue of jobs (includes currently processed job). */
+  /** \brief Remove a job from the queue without executing it. Returns false if the job is not queued (any more);
+      jobs that are being executed cannot be cancelled. */
+  bool cancelJob(JobId id);
+
+  /** \brief Remove all queued jobs with the name \e name without executing them. Returns the number of removed jobs. */
+  std::size_t cancelJobs(const std::string& name);
+
+  /** \brief Get the size of the queue of jobs (includes currently processed jobs). */
   std::size_t getJobCount() const;
 
+  /** \brief Get the number of worker threads */
+  unsigned int getWorkerCount() const
+  {
+    return worker_count_;
+  }
+
   /** \brief Clear the queue of jobs */
   void clear();
 
@@ -96,20 +129,46 @@ public:
   /** \brief Clear the callback to be triggered when events in JobEvent take place */
   void clearJobUpdateEvent();
 
+  /** \brief Set the callback to be triggered with the timing of each completed job */
+  void setJobTimingEvent(const JobTimingCallback& event);
+
+  /** \brief Clear the callback to be triggered with the timing of each completed job */
+  void clearJobTimingEvent();
+
 private:
-  std::unique_ptr<boost::thread> processing_thread_;
+  static const unsigned int PRIORITY_COUNT = 3;
+
+  struct Job
+  {
+    JobCallback callback_;
+    std::string name_;
+    JobId id_;
+    std::chrono::steady_clock::time_point queued_;
+  };
+
+  boost::thread_group processing_threads_;
+  unsigned int worker_count_;
   bool run_processing_thread_;
 
   mutable boost::mutex action_lock_;
   boost::condition_variable new_action_condition_;
-  std::deque<JobCallback> actions_;
-  std::deque<std::string> action_names_;
+  std::deque<Job> actions_[PRIORITY_COUNT];
+  JobId next_job_id_;
 
   JobUpdateCallback queue_change_event_;
+  JobTimingCallback timing_event_;
 
-  bool processing_;
+  // whether a job of each priority is being executed
+  bool processing_[PRIORITY_COUNT];
 
   void processingThread();
+
+  /** \brief Take the next job to execute from the queue; false if there is none that can be started now. Must be called
+      with action_lock_ held. */
+  bool popJob(Job& job, unsigned int& priority);
+
+  /** \brief Remove the queued jobs for which \e match is true, then trigger the REMOVE events for them */
+  std::size_t removeJobs(const boost::function<bool(const Job&)>& match);
 };
 }
 }
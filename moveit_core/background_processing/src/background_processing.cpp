@@ -36,90 +36,179 @@
 
 #include <moveit/background_processing/background_processing.h>
 #include <console_bridge/console.h>
+#include <boost/bind.hpp>
 
-moveit::tools::BackgroundProcessing::BackgroundProcessing()
+moveit::tools::BackgroundProcessing::BackgroundProcessing(unsigned int worker_count)
 {
-  // spin a thread that will process user events
+  worker_count_ = std::max(1u, worker_count);
+  next_job_id_ = 1;
+  for (unsigned int i = 0; i < PRIORITY_COUNT; ++i)
+    processing_[i] = false;
+
+  // spin the threads that will process user events
   run_processing_thread_ = true;
-  processing_ = false;
-  processing_thread_.reset(new boost::thread(boost::bind(&BackgroundProcessing::processingThread, this)));
+  for (unsigned int i = 0; i < worker_count_; ++i)
+    processing_threads_.create_thread(boost::bind(&BackgroundProcessing::processingThread, this));
 }
 
 moveit::tools::BackgroundProcessing::~BackgroundProcessing()
 {
-  run_processing_thread_ = false;
+  {
+    boost::mutex::scoped_lock _(action_lock_);
+    run_processing_thread_ = false;
+  }
   new_action_condition_.notify_all();
-  processing_thread_->join();
+  processing_threads_.join_all();
+}
+
+bool moveit::tools::BackgroundProcessing::popJob(Job& job, unsigned int& priority)
+{
+  for (unsigned int i = 0; i < PRIORITY_COUNT; ++i)
+    if (!processing_[i] && !actions_[i].empty())
+    {
+      job = actions_[i].front();
+      actions_[i].pop_front();
+      priority = i;
+      return true;
+    }
+  return false;
 }
 
 void moveit::tools::BackgroundProcessing::processingThread()
 {
   boost::unique_lock<boost::mutex> ulock(action_lock_);
 
-  while (run_processing_thread_)
+  while (true)
   {
-    while (actions_.empty() && run_processing_thread_)
+    Job job;
+    unsigned int priority;
+    if (!popJob(job, priority))
+    {
+      // the jobs still queued are executed before the threads stop
+      bool queued = false;
+      for (unsigned int i = 0; i < PRIORITY_COUNT && !queued; ++i)
+        queued = !actions_[i].empty();
+      if (!run_processing_thread_ && !queued)
+        break;
       new_action_condition_.wait(ulock);
+      continue;
+    }
+    processing_[priority] = true;
 
-    while (!actions_.empty())
+    // make sure we are unlocked while we process the event
+    ulock.unlock();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    try
     {
-      JobCallback fn = actions_.front();
-      std::string action_name = action_names_.front();
-      actions_.pop_front();
-      action_names_.pop_front();
-      processing_ = true;
-
-      // make sure we are unlocked while we process the event
-      action_lock_.unlock();
-      try
-      {
-        logDebug("moveit.background: Begin executing '%s'", action_name.c_str());
-        fn();
-        logDebug("moveit.background: Done executing '%s'", action_name.c_str());
-      }
-      catch (std::exception& ex)
-      {
-        logError("Exception caught while processing action '%s': %s", action_name.c_str(), ex.what());
-      }
-      processing_ = false;
-      if (queue_change_event_)
-        queue_change_event_(COMPLETE, action_name);
-      action_lock_.lock();
+      logDebug("moveit.background: Begin executing '%s'", job.name_.c_str());
+      job.callback_();
     }
+    catch (std::exception& ex)
+    {
+      logError("Exception caught while processing action '%s': %s", job.name_.c_str(), ex.what());
+    }
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    double queued_time = std::chrono::duration<double>(start - job.queued_).count();
+    double execution_time = std::chrono::duration<double>(end - start).count();
+    logDebug("moveit.background: Done executing '%s' in %lf s (queued for %lf s)", job.name_.c_str(), execution_time,
+             queued_time);
+
+    ulock.lock();
+    processing_[priority] = false;
+    // the next job of this priority can be started by any worker
+    new_action_condition_.notify_all();
+    ulock.unlock();
+
+    if (timing_event_)
+      timing_event_(job.name_, queued_time, execution_time);
+    if (queue_change_event_)
+      queue_change_event_(COMPLETE, job.name_);
+    ulock.lock();
   }
 }
 
-void moveit::tools::BackgroundProcessing::addJob(const boost::function<void()>& job, const std::string& name)
+moveit::tools::BackgroundProcessing::JobId moveit::tools::BackgroundProcessing::addJob(const JobCallback& job,
+                                                                                       const std::string& name,
+                                                                                       JobPriority priority)
 {
+  JobId id;
   {
     boost::mutex::scoped_lock _(action_lock_);
-    actions_.push_back(job);
-    action_names_.push_back(name);
+    id = next_job_id_++;
+    Job entry;
+    entry.callback_ = job;
+    entry.name_ = name;
+    entry.id_ = id;
+    entry.queued_ = std::chrono::steady_clock::now();
+    actions_[priority].push_back(entry);
     new_action_condition_.notify_all();
   }
   if (queue_change_event_)
     queue_change_event_(ADD, name);
+  return id;
 }
 
-void moveit::tools::BackgroundProcessing::clear()
+namespace
+{
+bool jobHasId(moveit::tools::BackgroundProcessing::JobId id, moveit::tools::BackgroundProcessing::JobId job_id)
+{
+  return id == job_id;
+}
+
+bool jobHasName(const std::string& name, const std::string& job_name)
+{
+  return name == job_name;
+}
+
+bool anyJob()
+{
+  return true;
+}
+}
+
+std::size_t moveit::tools::BackgroundProcessing::removeJobs(const boost::function<bool(const Job&)>& match)
 {
-  bool update = false;
-  std::deque<std::string> removed;
+  std::vector<std::string> removed;
   {
     boost::mutex::scoped_lock _(action_lock_);
-    update = !actions_.empty();
-    actions_.clear();
-    action_names_.swap(removed);
+    for (unsigned int i = 0; i < PRIORITY_COUNT; ++i)
+      for (std::deque<Job>::iterator it = actions_[i].begin(); it != actions_[i].end();)
+        if (match(*it))
+        {
+          removed.push_back(it->name_);
+          it = actions_[i].erase(it);
+        }
+        else
+          ++it;
   }
-  if (update && queue_change_event_)
-    for (std::deque<std::string>::iterator it = removed.begin(); it != removed.end(); ++it)
-      queue_change_event_(REMOVE, *it);
+  if (queue_change_event_)
+    for (std::size_t i = 0; i < removed.size(); ++i)
+      queue_change_event_(REMOVE, removed[i]);
+  return removed.size();
+}
+
+bool moveit::tools::BackgroundProcessing::cancelJob(JobId id)
+{
+  return removeJobs(boost::bind(&jobHasId, id, boost::bind(&Job::id_, _1))) > 0;
+}
+
+std::size_t moveit::tools::BackgroundProcessing::cancelJobs(const std::string& name)
+{
+  return removeJobs(boost::bind(&jobHasName, boost::cref(name), boost::bind(&Job::name_, _1)));
+}
+
+void moveit::tools::BackgroundProcessing::clear()
+{
+  removeJobs(boost::bind(&anyJob));
 }
 
 std::size_t moveit::tools::BackgroundProcessing::getJobCount() const
 {
   boost::mutex::scoped_lock _(action_lock_);
-  return actions_.size() + (processing_ ? 1 : 0);
+  std::size_t count = 0;
+  for (unsigned int i = 0; i < PRIORITY_COUNT; ++i)
+    count += actions_[i].size() + (processing_[i] ? 1 : 0);
+  return count;
 }
 
 void moveit::tools::BackgroundProcessing::setJobUpdateEvent(const JobUpdateCallback& event)
@@ -132,3 +221,14 @@ void moveit::tools::BackgroundProcessing::clearJobUpdateEvent()
 {
   setJobUpdateEvent(JobUpdateCallback());
 }
+
+void moveit::tools::BackgroundProcessing::setJobTimingEvent(const JobTimingCallback& event)
+{
+  boost::mutex::scoped_lock _(action_lock_);
+  timing_event_ = event;
+}
+
+void moveit::tools::BackgroundProcessing::clearJobTimingEvent()
+{
+  setJobTimingEvent(JobTimingCallback());
+}
@@ -0,0 +1,289 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+/* Micro-benchmarks of the hot paths of moveit_core on the PR2 model. Run with
+   --benchmark_format=json (or --benchmark_out=<file> --benchmark_out_format=json) to get machine-readable output that
+   can be compared against a previous run. */
+
+#include <benchmark/benchmark.h>
+#include <moveit/planning_scene/planning_scene.h>
+#include <moveit/kinematic_constraints/kinematic_constraint.h>
+#include <moveit/kinematic_constraints/utils.h>
+#include <moveit/distance_field/propagation_distance_field.h>
+#include <moveit/robot_trajectory/robot_trajectory.h>
+#include <moveit/trajectory_processing/iterative_time_parameterization.h>
+#include <eigen_conversions/eigen_msg.h>
+#include <geometric_shapes/shapes.h>
+#include <urdf_parser/urdf_parser.h>
+#include <moveit_resources/config.h>
+#include <boost/filesystem/path.hpp>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+const std::size_t STATE_COUNT = 64;
+
+/// The PR2 model, a scene with a few obstacles and a fixed set of random states, shared by all benchmarks
+class Pr2Fixture
+{
+public:
+  static const Pr2Fixture& instance()
+  {
+    static Pr2Fixture fixture;
+    return fixture;
+  }
+
+  robot_model::RobotModelConstPtr robot_model;
+  planning_scene::PlanningScenePtr scene;
+  const robot_model::JointModelGroup* arm;
+  const robot_model::LinkModel* tip;
+  std::vector<robot_state::RobotState> states;
+
+private:
+  Pr2Fixture()
+  {
+    boost::filesystem::path res_path(MOVEIT_TEST_RESOURCES_DIR);
+    std::ifstream xml_file((res_path / "pr2_description/urdf/robot.xml").string().c_str());
+    std::stringstream xml_string;
+    xml_string << xml_file.rdbuf();
+    urdf::ModelInterfaceSharedPtr urdf_model = urdf::parseURDF(xml_string.str());
+    srdf::ModelSharedPtr srdf_model(new srdf::Model());
+    srdf_model->initFile(*urdf_model, (res_path / "pr2_description/srdf/robot.xml").string());
+
+    robot_model.reset(new robot_model::RobotModel(urdf_model, srdf_model));
+    scene.reset(new planning_scene::PlanningScene(robot_model));
+    arm = robot_model->getJointModelGroup("right_arm");
+    tip = robot_model->getLinkModel("r_wrist_roll_link");
+
+    // obstacles around the arms, close enough for broadphase pairs but mostly not in collision
+    collision_detection::WorldPtr world = scene->getWorldNonConst();
+    for (int i = 0; i < 4; ++i)
+    {
+      Eigen::Affine3d pose = Eigen::Affine3d::Identity();
+      pose.translation() = Eigen::Vector3d(0.9, -0.6 + 0.4 * i, 0.6 + 0.1 * i);
+      world->addToObject("box" + std::to_string(i), shapes::ShapeConstPtr(new shapes::Box(0.2, 0.2, 0.2)), pose);
+    }
+
+    random_numbers::RandomNumberGenerator rng(42);
+    const robot_model::JointModelGroup* left_arm = robot_model->getJointModelGroup("left_arm");
+    robot_state::RobotState state(robot_model);
+    state.setToDefaultValues();
+    for (std::size_t i = 0; i < STATE_COUNT; ++i)
+    {
+      state.setToRandomPositions(arm, rng);
+      state.setToRandomPositions(left_arm, rng);
+      state.update();
+      states.push_back(state);
+    }
+  }
+};
+
+/// A trajectory of \e size waypoints through the random states of the fixture
+robot_trajectory::RobotTrajectory makeTrajectory(const Pr2Fixture& pr2, std::size_t size)
+{
+  robot_trajectory::RobotTrajectory trajectory(pr2.robot_model, pr2.arm->getName());
+  robot_state::RobotState state(pr2.states[0]);
+  for (std::size_t i = 0; i < size; ++i)
+  {
+    const double t = static_cast<double>(i % 8) / 8.0;
+    pr2.states[i / 8 % STATE_COUNT].interpolate(pr2.states[(i / 8 + 1) % STATE_COUNT], t, state, pr2.arm);
+    trajectory.addSuffixWayPoint(state, 0.0);
+  }
+  return trajectory;
+}
+}
+
+static void BM_RobotStateUpdate(benchmark::State& bm)
+{
+  const Pr2Fixture& pr2 = Pr2Fixture::instance();
+  robot_state::RobotState state(pr2.states[0]);
+  std::size_t i = 0;
+  while (bm.KeepRunning())
+  {
+    state.setVariablePositions(pr2.states[++i % STATE_COUNT].getVariablePositions());
+    state.update();
+  }
+}
+BENCHMARK(BM_RobotStateUpdate);
+
+static void BM_RobotStateJacobian(benchmark::State& bm)
+{
+  const Pr2Fixture& pr2 = Pr2Fixture::instance();
+  Eigen::MatrixXd jacobian;
+  std::size_t i = 0;
+  while (bm.KeepRunning())
+    benchmark::DoNotOptimize(pr2.states[++i % STATE_COUNT].getJacobian(pr2.arm, pr2.tip, Eigen::Vector3d::Zero(),
+                                                                        jacobian));
+}
+BENCHMARK(BM_RobotStateJacobian);
+
+static void BM_RobotStateCopy(benchmark::State& bm)
+{
+  const Pr2Fixture& pr2 = Pr2Fixture::instance();
+  robot_state::RobotState state(pr2.states[0]);
+  std::size_t i = 0;
+  while (bm.KeepRunning())
+    state = pr2.states[++i % STATE_COUNT];
+}
+BENCHMARK(BM_RobotStateCopy);
+
+static void BM_SelfCollision(benchmark::State& bm)
+{
+  const Pr2Fixture& pr2 = Pr2Fixture::instance();
+  collision_detection::CollisionRequest req;
+  std::size_t i = 0;
+  while (bm.KeepRunning())
+  {
+    collision_detection::CollisionResult res;
+    pr2.scene->checkSelfCollision(req, res, pr2.states[++i % STATE_COUNT]);
+    benchmark::DoNotOptimize(res.collision);
+  }
+}
+BENCHMARK(BM_SelfCollision);
+
+static void BM_WorldCollision(benchmark::State& bm)
+{
+  const Pr2Fixture& pr2 = Pr2Fixture::instance();
+  collision_detection::CollisionRequest req;
+  std::size_t i = 0;
+  while (bm.KeepRunning())
+  {
+    collision_detection::CollisionResult res;
+    pr2.scene->getCollisionWorld()->checkRobotCollision(req, res, *pr2.scene->getCollisionRobot(),
+                                                        pr2.states[++i % STATE_COUNT],
+                                                        pr2.scene->getAllowedCollisionMatrix());
+    benchmark::DoNotOptimize(res.collision);
+  }
+}
+BENCHMARK(BM_WorldCollision);
+
+static void BM_DistanceSelf(benchmark::State& bm)
+{
+  const Pr2Fixture& pr2 = Pr2Fixture::instance();
+  std::size_t i = 0;
+  while (bm.KeepRunning())
+    benchmark::DoNotOptimize(pr2.scene->getCollisionRobot()->distanceSelf(pr2.states[++i % STATE_COUNT],
+                                                                           pr2.scene->getAllowedCollisionMatrix()));
+}
+BENCHMARK(BM_DistanceSelf);
+
+static void BM_AllowedCollisionMatrixLookup(benchmark::State& bm)
+{
+  const Pr2Fixture& pr2 = Pr2Fixture::instance();
+  const collision_detection::AllowedCollisionMatrix& acm = pr2.scene->getAllowedCollisionMatrix();
+  const std::vector<std::string>& links = pr2.robot_model->getLinkModelNamesWithCollisionGeometry();
+  collision_detection::AllowedCollision::Type type;
+  std::size_t i = 0;
+  while (bm.KeepRunning())
+  {
+    ++i;
+    benchmark::DoNotOptimize(acm.getEntry(links[i % links.size()], links[i / links.size() % links.size()], type));
+  }
+}
+BENCHMARK(BM_AllowedCollisionMatrixLookup);
+
+static void BM_KinematicConstraintSetDecide(benchmark::State& bm)
+{
+  const Pr2Fixture& pr2 = Pr2Fixture::instance();
+  geometry_msgs::PoseStamped pose;
+  pose.header.frame_id = pr2.robot_model->getModelFrame();
+  tf::poseEigenToMsg(pr2.states[0].getGlobalLinkTransform(pr2.tip), pose.pose);
+  moveit_msgs::Constraints goal = kinematic_constraints::mergeConstraints(
+      kinematic_constraints::constructGoalConstraints(pr2.tip->getName(), pose, 0.05, 0.1),
+      kinematic_constraints::constructGoalConstraints(pr2.states[0], pr2.arm, 0.5));
+  kinematic_constraints::KinematicConstraintSet constraints(pr2.robot_model);
+  constraints.add(goal, pr2.scene->getTransforms());
+  std::size_t i = 0;
+  while (bm.KeepRunning())
+    benchmark::DoNotOptimize(constraints.decide(pr2.states[++i % STATE_COUNT]).satisfied);
+}
+BENCHMARK(BM_KinematicConstraintSetDecide);
+
+static void BM_PropagationDistanceFieldAddPoints(benchmark::State& bm)
+{
+  distance_field::PropagationDistanceField df(2.0, 2.0, 2.0, 0.02, -1.0, -1.0, -1.0, 0.4);
+  random_numbers::RandomNumberGenerator rng(42);
+  EigenSTL::vector_Vector3d points(bm.range(0));
+  for (std::size_t i = 0; i < points.size(); ++i)
+    points[i] = Eigen::Vector3d(rng.uniformReal(-0.8, 0.8), rng.uniformReal(-0.8, 0.8), rng.uniformReal(-0.8, 0.8));
+  while (bm.KeepRunning())
+  {
+    bm.PauseTiming();
+    df.reset();
+    bm.ResumeTiming();
+    df.addPointsToField(points);
+  }
+  bm.SetItemsProcessed(bm.iterations() * points.size());
+}
+BENCHMARK(BM_PropagationDistanceFieldAddPoints)->Arg(100)->Arg(10000);
+
+static void BM_IterativeParabolicTimeParameterization(benchmark::State& bm)
+{
+  const Pr2Fixture& pr2 = Pr2Fixture::instance();
+  robot_trajectory::RobotTrajectory trajectory = makeTrajectory(pr2, bm.range(0));
+  trajectory_processing::IterativeParabolicTimeParameterization iptp;
+  while (bm.KeepRunning())
+    benchmark::DoNotOptimize(iptp.computeTimeStamps(trajectory));
+  bm.SetItemsProcessed(bm.iterations() * trajectory.getWayPointCount());
+}
+BENCHMARK(BM_IterativeParabolicTimeParameterization)->Arg(10)->Arg(100)->Arg(1000);
+
+static void BM_RobotTrajectoryToMsg(benchmark::State& bm)
+{
+  const Pr2Fixture& pr2 = Pr2Fixture::instance();
+  robot_trajectory::RobotTrajectory trajectory = makeTrajectory(pr2, bm.range(0));
+  while (bm.KeepRunning())
+  {
+    moveit_msgs::RobotTrajectory msg;
+    trajectory.getRobotTrajectoryMsg(msg);
+    benchmark::DoNotOptimize(msg.joint_trajectory.points.size());
+  }
+  bm.SetItemsProcessed(bm.iterations() * trajectory.getWayPointCount());
+}
+BENCHMARK(BM_RobotTrajectoryToMsg)->Arg(10)->Arg(1000);
+
+static void BM_RobotTrajectoryFromMsg(benchmark::State& bm)
+{
+  const Pr2Fixture& pr2 = Pr2Fixture::instance();
+  moveit_msgs::RobotTrajectory msg;
+  makeTrajectory(pr2, bm.range(0)).getRobotTrajectoryMsg(msg);
+  robot_trajectory::RobotTrajectory trajectory(pr2.robot_model, pr2.arm->getName());
+  while (bm.KeepRunning())
+    trajectory.setRobotTrajectoryMsg(pr2.states[0], msg);
+  bm.SetItemsProcessed(bm.iterations() * trajectory.getWayPointCount());
+}
+BENCHMARK(BM_RobotTrajectoryFromMsg)->Arg(10)->Arg(1000);
+
+BENCHMARK_MAIN();
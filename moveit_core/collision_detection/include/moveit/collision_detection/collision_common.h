@@ -95,6 +95,34 @@ struct Contact
   BodyType body_type_2;
 };
 
+/** \brief A contact point stored in the flat contact buffer of a CollisionResult. The bodies are identified by
+    their index in CollisionResult::body_names, so storing a contact copies no strings */
+struct FlatContact
+{
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  /** \brief contact position */
+  Eigen::Vector3d pos;
+
+  /** \brief normal unit vector at contact */
+  Eigen::Vector3d normal;
+
+  /** \brief depth (penetration between bodies) */
+  double depth;
+
+  /** \brief The index of the name of the first body involved in the contact */
+  std::size_t body_id_1;
+
+  /** \brief The type of the first body involved in the contact */
+  BodyType body_type_1;
+
+  /** \brief The index of the name of the second body involved in the contact */
+  std::size_t body_id_2;
+
+  /** \brief The type of the second body involved in the contact */
+  BodyType body_type_2;
+};
+
 /** \brief When collision costs are computed, this structure contains information about the partial cost incurred in a
  * particular volume */
 struct CostSource
@@ -138,23 +166,84 @@ struct CollisionResult
   {
   }
   typedef std::map<std::pair<std::string, std::string>, std::vector<Contact> > ContactMap;
+  typedef std::map<std::pair<std::string, std::string>, double> DistanceMap;
 
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
-  /** \brief Clear a previously stored result */
+  /** \brief Clear a previously stored result. The capacity of the flat contact buffer and the body names are kept,
+      so a result that is reused stores flat contacts without allocating */
   void clear()
   {
     collision = false;
     distance = std::numeric_limits<double>::max();
     contact_count = 0;
     contacts.clear();
+    flat_contacts.clear();
     cost_sources.clear();
+    pair_distances.clear();
+  }
+
+  /** \brief Preallocate room for \e count flat contacts */
+  void reserveFlatContacts(std::size_t count)
+  {
+    flat_contacts.reserve(count);
+  }
+
+  /** \brief Get the index of the body called \e name in body_names, adding the name if it is not known yet */
+  std::size_t getBodyId(const std::string& name)
+  {
+    std::map<std::string, std::size_t>::const_iterator it = body_ids.find(name);
+    if (it != body_ids.end())
+      return it->second;
+    body_ids[name] = body_names.size();
+    body_names.push_back(name);
+    return body_names.size() - 1;
+  }
+
+  /** \brief Get the name of the body with index \e id in body_names */
+  const std::string& getBodyName(std::size_t id) const
+  {
+    return body_names[id];
+  }
+
+  /** \brief Count the flat contacts stored for the pair of bodies \e id1 and \e id2 (in any order) */
+  std::size_t countFlatContacts(std::size_t id1, std::size_t id2) const
+  {
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < flat_contacts.size(); ++i)
+      if ((flat_contacts[i].body_id_1 == id1 && flat_contacts[i].body_id_2 == id2) ||
+          (flat_contacts[i].body_id_1 == id2 && flat_contacts[i].body_id_2 == id1))
+        ++count;
+    return count;
+  }
+
+  /** \brief Resolve the body names of the flat contacts and add them to \e contact_map, in the same layout as \e
+   * contacts */
+  void getFlatContacts(ContactMap& contact_map) const
+  {
+    for (std::size_t i = 0; i < flat_contacts.size(); ++i)
+    {
+      const FlatContact& fc = flat_contacts[i];
+      Contact c;
+      c.pos = fc.pos;
+      c.normal = fc.normal;
+      c.depth = fc.depth;
+      c.body_name_1 = body_names[fc.body_id_1];
+      c.body_type_1 = fc.body_type_1;
+      c.body_name_2 = body_names[fc.body_id_2];
+      c.body_type_2 = fc.body_type_2;
+      if (c.body_name_1 < c.body_name_2)
+        contact_map[std::make_pair(c.body_name_1, c.body_name_2)].push_back(c);
+      else
+        contact_map[std::make_pair(c.body_name_2, c.body_name_1)].push_back(c);
+    }
   }
 
   /** \brief True if collision was found, false otherwise */
   bool collision;
 
-  /** \brief Closest distance between two bodies */
+  /** \brief Closest distance between two bodies. If no bodies are closer than the \e max_distance of the request,
+      this is not computed exactly and is only known to be at least \e max_distance */
   double distance;
 
   /** \brief Number of contacts returned */
@@ -164,8 +253,22 @@ struct CollisionResult
    */
   ContactMap contacts;
 
+  /** \brief The contacts found when the request asks for \e flat_contacts. \e contacts is left empty then */
+  std::vector<FlatContact> flat_contacts;
+
+  /** \brief The names of the bodies referenced by \e flat_contacts, indexed by body id. They are kept by clear(), so
+      the ids of a reused result stay valid */
+  std::vector<std::string> body_names;
+
+  /** \brief The index of each name in \e body_names */
+  std::map<std::string, std::size_t> body_ids;
+
   /** \brief When costs are computed, the individual cost sources are  */
   std::set<CostSource> cost_sources;
+
+  /** \brief When pair distances are requested, the distance between each pair of bodies (identified by their ids)
+      that are closer than the \e max_distance of the request; a negative value means the pair is in collision */
+  DistanceMap pair_distances;
 };
 
 /** \brief Representation of a collision checking request */
@@ -173,10 +276,13 @@ struct CollisionRequest
 {
   CollisionRequest()
     : distance(false)
+    , max_distance(std::numeric_limits<double>::max())
+    , pair_distances(false)
     , cost(false)
     , contacts(false)
     , max_contacts(1)
     , max_contacts_per_pair(1)
+    , flat_contacts(false)
     , max_cost_sources(1)
     , min_cost_density(0.2)
     , verbose(false)
@@ -192,6 +298,14 @@ struct CollisionRequest
   /** \brief If true, compute proximity distance */
   bool distance;
 
+  /** \brief When computing proximity distance, pairs of bodies that are farther apart than this are not considered.
+      Queries that only need to know whether the clearance exceeds a threshold are much cheaper with a cutoff. */
+  double max_distance;
+
+  /** \brief When computing proximity distance, also report the distance of every pair of bodies closer than
+      \e max_distance */
+  bool pair_distances;
+
   /** \brief If true, a collision cost is computed */
   bool cost;
 
@@ -205,6 +319,10 @@ struct CollisionRequest
    * configurations) */
   std::size_t max_contacts_per_pair;
 
+  /** \brief If true, contacts are stored in the flat contact buffer of the result, with bodies identified by integer
+      ids, instead of the \e contacts map. Supported by the FCL collision checkers */
+  bool flat_contacts;
+
   /** \brief When costs are computed, this value defines how many of the top cost sources should be returned */
   std::size_t max_cost_sources;
 
@@ -39,9 +39,12 @@
 
 #include <moveit/collision_detection/collision_common.h>
 #include <moveit/macros/class_forward.h>
+#include <moveit/robot_model/robot_model.h>
 #include <moveit_msgs/AllowedCollisionMatrix.h>
 #include <boost/function.hpp>
+#include <boost/unordered_map.hpp>
 #include <iostream>
+#include <memory>
 #include <vector>
 #include <string>
 #include <map>
@@ -73,6 +76,7 @@ enum Type
 typedef boost::function<bool(collision_detection::Contact&)> DecideContactFn;
 
 MOVEIT_CLASS_FORWARD(AllowedCollisionMatrix);
+MOVEIT_CLASS_FORWARD(CompiledAllowedCollisionMatrix);
 
 /** @class AllowedCollisionMatrix
  *  @brief Definition of a structure for the allowed collision matrix. All elements in the collision world are referred
@@ -95,6 +99,9 @@ public:
   /** @brief Copy constructor */
   AllowedCollisionMatrix(const AllowedCollisionMatrix& acm);
 
+  /** @brief Assignment operator */
+  AllowedCollisionMatrix& operator=(const AllowedCollisionMatrix& acm);
+
   /** @brief Get the type of the allowed collision between two elements. Return true if the entry is included in the
    * collision matrix.
    * Return false if the entry is not found.
@@ -267,15 +274,85 @@ public:
   bool getAllowedCollision(const std::string& name1, const std::string& name2,
                            AllowedCollision::Type& allowed_collision) const;
 
+  /** @brief Get the compiled form of this matrix for the links of \e model. The compiled form is built on first use
+   *  and kept until the matrix is modified; it is safe to call this function from multiple threads, as long as none
+   *  of them modifies the matrix at the same time. Looking up the kept form does not take a lock. */
+  CompiledAllowedCollisionMatrixConstPtr getCompiled(const robot_model::RobotModelConstPtr& model) const;
+
   /** @brief Print the allowed collision matrix */
   void print(std::ostream& out) const;
 
 private:
+  friend class CompiledAllowedCollisionMatrix;
+
+  /** @brief Drop the compiled form; called by every function that modifies the matrix */
+  void invalidateCompiled();
+
   std::map<std::string, std::map<std::string, AllowedCollision::Type> > entries_;
   std::map<std::string, std::map<std::string, DecideContactFn> > allowed_contacts_;
 
   std::map<std::string, AllowedCollision::Type> default_entries_;
   std::map<std::string, DecideContactFn> default_allowed_contacts_;
+
+  /// Only accessed through std::atomic_load() and std::atomic_store(), so concurrent readers need no lock
+  mutable CompiledAllowedCollisionMatrixConstPtr compiled_;
+};
+
+/** @class CompiledAllowedCollisionMatrix
+ *  @brief A read-only copy of the allowed collision types of an AllowedCollisionMatrix, stored in a dense matrix so
+ *  that the type for a pair of bodies can be found without any string comparison. Robot links are indexed by
+ *  LinkModel::getLinkIndex(); all other names known to the collision matrix (attached bodies, world objects) get the
+ *  indices following the links. Predicates for AllowedCollision::CONDITIONAL entries are not compiled and still need
+ *  to be retrieved from the AllowedCollisionMatrix. */
+class CompiledAllowedCollisionMatrix
+{
+public:
+  CompiledAllowedCollisionMatrix(const AllowedCollisionMatrix& acm, const robot_model::RobotModelConstPtr& model);
+
+  /** @brief The robot model whose link indices are used */
+  const robot_model::RobotModelConstPtr& getRobotModel() const
+  {
+    return robot_model_;
+  }
+
+  /** @brief Get the index of a link; \e link must belong to the robot model this matrix was compiled for */
+  int getIndex(const robot_model::LinkModel* link) const
+  {
+    return link->getLinkIndex();
+  }
+
+  /** @brief Get the index of a named element, or -1 if the name is unknown to the collision matrix */
+  int getIndex(const std::string& name) const
+  {
+    boost::unordered_map<std::string, int>::const_iterator it = indices_.find(name);
+    return it == indices_.end() ? -1 : it->second;
+  }
+
+  /** @brief Equivalent to AllowedCollisionMatrix::getAllowedCollision(), for the elements at indices \e index1 and
+   *  \e index2 (either of which may be -1) */
+  bool getAllowedCollision(int index1, int index2, AllowedCollision::Type& allowed_collision) const
+  {
+    unsigned char v;
+    if (index1 < 0)
+      v = index2 < 0 ? 0 : defaults_[index2];
+    else if (index2 < 0)
+      v = defaults_[index1];
+    else
+      v = entries_[index1 * size_ + index2];
+    if (v == 0)
+      return false;
+    allowed_collision = static_cast<AllowedCollision::Type>(v - 1);
+    return true;
+  }
+
+private:
+  robot_model::RobotModelConstPtr robot_model_;
+  boost::unordered_map<std::string, int> indices_;
+  std::size_t size_;
+
+  // 0 means no entry, otherwise AllowedCollision::Type + 1
+  std::vector<unsigned char> entries_;
+  std::vector<unsigned char> defaults_;
 };
 }
 
@@ -57,10 +57,16 @@ namespace collision_detection
  *  @param Whether to request a depth estimate from the algorithm (experimental...)
  *  @param The iso-surface threshold value (0.5 is a reasonable default).
  *  @param The metaball radius, as a multiple of the octomap cell size (1.5 is a reasonable default)
+ *  @param The number of contacts above which the refinement is coarsened (0, the default, means no limit): the
+ *  contacts within each cell of a grid as large as the search region share one normal, estimated at their centroid
+ *
+ *  Contacts in the same grid cell share one query of the octree, and the cells are refined on multiple threads.
+ *  @return The number of normals changed
  */
 int refineContactNormals(const World::ObjectConstPtr& object, CollisionResult& res,
                          double cell_bbx_search_distance = 1.0, double allowed_angle_divergence = 0.0,
-                         bool estimate_depth = false, double iso_value = 0.5, double metaball_radius_multiple = 1.5);
+                         bool estimate_depth = false, double iso_value = 0.5, double metaball_radius_multiple = 1.5,
+                         std::size_t max_refined_contacts = 0);
 }
 
 #endif
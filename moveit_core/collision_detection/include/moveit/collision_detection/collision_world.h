@@ -110,6 +110,37 @@ public:
                               const robot_state::RobotState& state1, const robot_state::RobotState& state2,
                               const AllowedCollisionMatrix& acm) const;
 
+  /** \brief Check a batch of states for collisions of the robot with itself or the world.
+   *  Any collision between any pair of links is checked for, NO collisions are ignored.
+   *  @param req A CollisionRequest object that encapsulates the collision request used for every state
+   *  @param res The collision results; resized to the number of states and cleared, so the same vector can be
+   *  passed again to reuse its storage. res[i] is the result for states[i]
+   *  @param robot The collision model for the robot
+   *  @param states The kinematic states for which checks are being made
+   *  @param stop_at_first_collision If true, checking ends once a state in collision is found; the results of the
+   *  states after it are left cleared
+   *  @return The index of the first state in collision, or states.size() if no state is in collision */
+  virtual std::size_t checkCollisionBatch(const CollisionRequest& req, std::vector<CollisionResult>& res,
+                                          const CollisionRobot& robot,
+                                          const std::vector<const robot_state::RobotState*>& states,
+                                          bool stop_at_first_collision = true) const;
+
+  /** \brief Check a batch of states for collisions of the robot with itself or the world.
+   *  Allowed collisions specified by the allowed collision matrix are taken into account.
+   *  @param req A CollisionRequest object that encapsulates the collision request used for every state
+   *  @param res The collision results; resized to the number of states and cleared, so the same vector can be
+   *  passed again to reuse its storage. res[i] is the result for states[i]
+   *  @param robot The collision model for the robot
+   *  @param states The kinematic states for which checks are being made
+   *  @param acm The allowed collision matrix.
+   *  @param stop_at_first_collision If true, checking ends once a state in collision is found; the results of the
+   *  states after it are left cleared
+   *  @return The index of the first state in collision, or states.size() if no state is in collision */
+  virtual std::size_t checkCollisionBatch(const CollisionRequest& req, std::vector<CollisionResult>& res,
+                                          const CollisionRobot& robot,
+                                          const std::vector<const robot_state::RobotState*>& states,
+                                          const AllowedCollisionMatrix& acm, bool stop_at_first_collision = true) const;
+
   /** \brief Check whether the robot model is in collision with the world. Any collisions between a robot link
    *  and the world are considered. Self collisions are not checked.
    *  @param req A CollisionRequest object that encapsulates the collision request
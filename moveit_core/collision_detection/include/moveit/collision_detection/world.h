@@ -44,6 +44,7 @@
 #include <map>
 #include <memory>
 #include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
 #include <Eigen/Geometry>
 #include <eigen_stl_containers/eigen_stl_vector_container.h>
 
@@ -65,7 +66,8 @@ public:
 
   /** \brief A copy constructor.
    * \e other should not be changed while the copy constructor is running
-   * This does copy on write and should be quick. */
+   * This does copy on write and should be quick: the object map itself is shared
+   * with \e other until either world is modified. */
   World(const World& other);
 
   ~World();
@@ -113,27 +115,30 @@ public:
   /** \brief Get a particular object */
   ObjectConstPtr getObject(const std::string& id) const;
 
+  /** The map type used to store objects, indexed by id */
+  typedef std::map<std::string, ObjectPtr> ObjectMap;
+
   /** iterator over the objects in the world. */
-  typedef std::map<std::string, ObjectPtr>::const_iterator const_iterator;
+  typedef ObjectMap::const_iterator const_iterator;
   /** iterator pointing to first change */
   const_iterator begin() const
   {
-    return objects_.begin();
+    return objects_->begin();
   }
   /** iterator pointing to end of changes */
   const_iterator end() const
   {
-    return objects_.end();
+    return objects_->end();
   }
   /** number of changes stored */
   std::size_t size() const
   {
-    return objects_.size();
+    return objects_->size();
   }
   /** find changes for a named object */
   const_iterator find(const std::string& id) const
   {
-    return objects_.find(id);
+    return objects_->find(id);
   }
 
   /** \brief Check if a particular object exists in the collision world*/
@@ -241,10 +246,53 @@ public:
    * Used which switching from one world to another. */
   void notifyObserverAllObjects(const ObserverHandle observer_handle, Action action) const;
 
+  /** \brief Start a batch of changes.
+   * Until the matching commitBatch(), observers are not called; the changes made meanwhile are collected instead and
+   * commitBatch() reports each changed object once, with the combined action. Objects created and destroyed within
+   * the batch are not reported at all. Batches can be nested; only the outermost commitBatch() notifies. */
+  void beginBatch();
+
+  /** \brief End the batch started by the matching beginBatch() and notify the observers of the collected changes */
+  void commitBatch();
+
+  /** \brief Check if changes are currently being collected in a batch */
+  bool isBatchActive() const
+  {
+    return batch_depth_ > 0;
+  }
+
+  /** \brief The number of objects whose changes commitBatch() is reporting while it notifies the observers, or 0
+   * outside of commitBatch(). Observers can use it to handle a large batch in one go instead of object by object. */
+  std::size_t getCommittedChangeCount() const
+  {
+    return committed_change_count_;
+  }
+
+  /** \brief Collect the changes made to \e world during the lifetime of this instance in one batch */
+  class ScopedBatch : private boost::noncopyable
+  {
+  public:
+    explicit ScopedBatch(World& world) : world_(world)
+    {
+      world_.beginBatch();
+    }
+
+    ~ScopedBatch()
+    {
+      world_.commitBatch();
+    }
+
+  private:
+    World& world_;
+  };
+
 private:
-  /** notify all observers of a change */
+  /** notify all observers of a change, or record it if a batch is active */
   void notify(const ObjectConstPtr&, Action);
 
+  /** call all observers */
+  void callObservers(const ObjectConstPtr&, Action);
+
   /** send notification of change to all objects. */
   void notifyAll(Action action);
 
@@ -253,12 +301,18 @@ private:
    * clone is made so that it can be safely modified later on. */
   void ensureUnique(ObjectPtr& obj);
 
+  /** \brief Make sure the object map is not shared with any other World
+   * instance and return it, so it can be safely modified. The objects
+   * themselves remain shared until ensureUnique() is called on them. */
+  ObjectMap& getObjectMapForWrite();
+
   /* Add a shape with no checking */
   virtual void addToObjectInternal(const ObjectPtr& obj, const shapes::ShapeConstPtr& shape,
                                    const Eigen::Affine3d& pose);
 
-  /** The objects maintained in the world */
-  std::map<std::string, ObjectPtr> objects_;
+  /** The objects maintained in the world. The map is shared between copies
+   * of a World and only duplicated by getObjectMapForWrite() */
+  std::shared_ptr<ObjectMap> objects_;
 
   /* observers to call when something changes */
   class Observer
@@ -270,6 +324,20 @@ private:
     ObserverCallbackFn callback_;
   };
   std::vector<Observer*> observers_;
+
+  /* the changes to one object, collected while a batch is active */
+  struct BatchedChange
+  {
+    BatchedChange() : action_(UNINITIALIZED), created_(false)
+    {
+    }
+    ObjectConstPtr object_;
+    int action_;
+    bool created_;  // the object did not exist when its first change of the batch was made
+  };
+  std::map<std::string, BatchedChange> batched_changes_;
+  unsigned int batch_depth_;
+  std::size_t committed_change_count_;
 };
 }
 
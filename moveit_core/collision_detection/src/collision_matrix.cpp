@@ -75,6 +75,21 @@ collision_detection::AllowedCollisionMatrix::AllowedCollisionMatrix(const Allowe
   allowed_contacts_ = acm.allowed_contacts_;
   default_entries_ = acm.default_entries_;
   default_allowed_contacts_ = acm.default_allowed_contacts_;
+  std::atomic_store(&compiled_, std::atomic_load(&acm.compiled_));
+}
+
+collision_detection::AllowedCollisionMatrix& collision_detection::AllowedCollisionMatrix::
+operator=(const AllowedCollisionMatrix& acm)
+{
+  if (this != &acm)
+  {
+    entries_ = acm.entries_;
+    allowed_contacts_ = acm.allowed_contacts_;
+    default_entries_ = acm.default_entries_;
+    default_allowed_contacts_ = acm.default_allowed_contacts_;
+    std::atomic_store(&compiled_, std::atomic_load(&acm.compiled_));
+  }
+  return *this;
 }
 
 bool collision_detection::AllowedCollisionMatrix::getEntry(const std::string& name1, const std::string& name2,
@@ -122,6 +137,7 @@ bool collision_detection::AllowedCollisionMatrix::hasEntry(const std::string& na
 void collision_detection::AllowedCollisionMatrix::setEntry(const std::string& name1, const std::string& name2,
                                                            bool allowed)
 {
+  invalidateCompiled();
   const AllowedCollision::Type v = allowed ? AllowedCollision::ALWAYS : AllowedCollision::NEVER;
   entries_[name1][name2] = entries_[name2][name1] = v;
 
@@ -145,12 +161,14 @@ void collision_detection::AllowedCollisionMatrix::setEntry(const std::string& na
 void collision_detection::AllowedCollisionMatrix::setEntry(const std::string& name1, const std::string& name2,
                                                            const DecideContactFn& fn)
 {
+  invalidateCompiled();
   entries_[name1][name2] = entries_[name2][name1] = AllowedCollision::CONDITIONAL;
   allowed_contacts_[name1][name2] = allowed_contacts_[name2][name1] = fn;
 }
 
 void collision_detection::AllowedCollisionMatrix::removeEntry(const std::string& name)
 {
+  invalidateCompiled();
   entries_.erase(name);
   allowed_contacts_.erase(name);
   for (std::map<std::string, std::map<std::string, AllowedCollision::Type> >::iterator it = entries_.begin();
@@ -163,6 +181,7 @@ void collision_detection::AllowedCollisionMatrix::removeEntry(const std::string&
 
 void collision_detection::AllowedCollisionMatrix::removeEntry(const std::string& name1, const std::string& name2)
 {
+  invalidateCompiled();
   std::map<std::string, std::map<std::string, AllowedCollision::Type> >::iterator jt = entries_.find(name1);
   if (jt != entries_.end())
   {
@@ -223,6 +242,7 @@ void collision_detection::AllowedCollisionMatrix::setEntry(const std::string& na
 
 void collision_detection::AllowedCollisionMatrix::setEntry(bool allowed)
 {
+  invalidateCompiled();
   const AllowedCollision::Type v = allowed ? AllowedCollision::ALWAYS : AllowedCollision::NEVER;
   for (std::map<std::string, std::map<std::string, AllowedCollision::Type> >::iterator it1 = entries_.begin();
        it1 != entries_.end(); ++it1)
@@ -233,6 +253,7 @@ void collision_detection::AllowedCollisionMatrix::setEntry(bool allowed)
 
 void collision_detection::AllowedCollisionMatrix::setDefaultEntry(const std::string& name, bool allowed)
 {
+  invalidateCompiled();
   const AllowedCollision::Type v = allowed ? AllowedCollision::ALWAYS : AllowedCollision::NEVER;
   default_entries_[name] = v;
   default_allowed_contacts_.erase(name);
@@ -240,6 +261,7 @@ void collision_detection::AllowedCollisionMatrix::setDefaultEntry(const std::str
 
 void collision_detection::AllowedCollisionMatrix::setDefaultEntry(const std::string& name, const DecideContactFn& fn)
 {
+  invalidateCompiled();
   default_entries_[name] = AllowedCollision::CONDITIONAL;
   default_allowed_contacts_[name] = fn;
 }
@@ -329,6 +351,7 @@ bool collision_detection::AllowedCollisionMatrix::getAllowedCollision(const std:
 
 void collision_detection::AllowedCollisionMatrix::clear()
 {
+  invalidateCompiled();
   entries_.clear();
   allowed_contacts_.clear();
   default_entries_.clear();
@@ -382,6 +405,59 @@ void collision_detection::AllowedCollisionMatrix::getMessage(moveit_msgs::Allowe
   }
 }
 
+collision_detection::CompiledAllowedCollisionMatrixConstPtr
+collision_detection::AllowedCollisionMatrix::getCompiled(const robot_model::RobotModelConstPtr& model) const
+{
+  CompiledAllowedCollisionMatrixConstPtr compiled = std::atomic_load(&compiled_);
+  if (!compiled || compiled->getRobotModel() != model)
+  {
+    // threads that get here at the same time build equivalent copies; the last one stored is kept
+    compiled.reset(new CompiledAllowedCollisionMatrix(*this, model));
+    std::atomic_store(&compiled_, compiled);
+  }
+  return compiled;
+}
+
+void collision_detection::AllowedCollisionMatrix::invalidateCompiled()
+{
+  std::atomic_store(&compiled_, CompiledAllowedCollisionMatrixConstPtr());
+}
+
+collision_detection::CompiledAllowedCollisionMatrix::CompiledAllowedCollisionMatrix(
+    const AllowedCollisionMatrix& acm, const robot_model::RobotModelConstPtr& model)
+  : robot_model_(model)
+{
+  // links keep their index in the robot model; the other names known to the matrix follow
+  const std::vector<const robot_model::LinkModel*>& links = model->getLinkModels();
+  std::vector<std::string> names(links.size());
+  for (std::size_t i = 0; i < links.size(); ++i)
+  {
+    names[links[i]->getLinkIndex()] = links[i]->getName();
+    indices_[links[i]->getName()] = links[i]->getLinkIndex();
+  }
+  for (std::map<std::string, std::map<std::string, AllowedCollision::Type> >::const_iterator it = acm.entries_.begin();
+       it != acm.entries_.end(); ++it)
+    if (indices_.insert(std::make_pair(it->first, static_cast<int>(names.size()))).second)
+      names.push_back(it->first);
+  for (std::map<std::string, AllowedCollision::Type>::const_iterator it = acm.default_entries_.begin();
+       it != acm.default_entries_.end(); ++it)
+    if (indices_.insert(std::make_pair(it->first, static_cast<int>(names.size()))).second)
+      names.push_back(it->first);
+
+  size_ = names.size();
+  entries_.resize(size_ * size_, 0);
+  defaults_.resize(size_, 0);
+  for (std::size_t i = 0; i < size_; ++i)
+  {
+    AllowedCollision::Type type;
+    if (acm.getDefaultEntry(names[i], type))
+      defaults_[i] = type + 1;
+    for (std::size_t j = i; j < size_; ++j)
+      if (acm.getAllowedCollision(names[i], names[j], type))
+        entries_[i * size_ + j] = entries_[j * size_ + i] = type + 1;
+  }
+}
+
 void collision_detection::AllowedCollisionMatrix::print(std::ostream& out) const
 {
   std::vector<std::string> names;
@@ -41,7 +41,13 @@
 #include <octomap/math/Utils.h>
 #include <octomap/octomap.h>
 #include <geometric_shapes/shapes.h>
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#include <algorithm>
+#include <cmath>
+#include <map>
 #include <memory>
+#include <tuple>
 
 // static const double ISO_VALUE  = 0.5; // TODO magic number! (though, probably a good one).
 // static const double R_MULTIPLE = 1.5; // TODO magic number! (though, probably a good one).
@@ -58,9 +64,167 @@ bool findSurface(const octomap::point3d_list& cloud, const double& spacing, cons
 bool sampleCloud(const octomap::point3d_list& cloud, const double& spacing, const double& r_multiple,
                  const octomath::Vector3& position, double& intensity, octomath::Vector3& gradient);
 
+namespace
+{
+// each thread refines the contacts of at least this many neighborhoods
+static const std::size_t MIN_NEIGHBORHOODS_PER_THREAD = 4;
+
+struct RefinementParameters
+{
+  const octomap::OcTree* octree;
+  double cell_size;
+  double cell_bbx_search_distance;
+  double allowed_angle_divergence;
+  bool estimate_depth;
+  double iso_value;
+  double metaball_radius_multiple;
+  // whether the contacts of a neighborhood share one estimate instead of being refined one by one
+  bool coarse;
+};
+
+// contacts close enough to each other that the occupied cells around all of them are found by one query of the octree
+struct ContactNeighborhood
+{
+  std::vector<collision_detection::Contact*> contacts;
+  int modified;
+};
+
+// an occupied leaf, with the range of keys it covers so the leaves within the search box of a contact can be picked
+struct OccupiedLeaf
+{
+  octomap::point3d center;
+  int low[3];
+  int high[3];
+};
+
+void applyRefinement(const RefinementParameters& p, collision_detection::Contact& contact, const octomath::Vector3& n,
+                     double depth, int& modified)
+{
+  // only modify normal if the refinement predicts a "very different" result.
+  octomath::Vector3 contact_normal(contact.normal[0], contact.normal[1], contact.normal[2]);
+  double divergence = contact_normal.angleTo(n);
+  if (divergence > p.allowed_angle_divergence)
+  {
+    modified++;
+    contact.normal = Eigen::Vector3d(n.x(), n.y(), n.z());
+  }
+
+  if (p.estimate_depth)
+    contact.depth = depth;
+}
+
+void refineNeighborhood(const RefinementParameters& p, ContactNeighborhood& neighborhood)
+{
+  const octomap::OcTree& octree = *p.octree;
+  const octomath::Vector3 half_box = octomath::Vector3(1, 1, 1) * (p.cell_size * p.cell_bbx_search_distance);
+  neighborhood.modified = 0;
+
+  // the union of the search boxes of the contacts
+  octomath::Vector3 bbx_min, bbx_max;
+  for (std::size_t i = 0; i < neighborhood.contacts.size(); ++i)
+  {
+    const Eigen::Vector3d& point = neighborhood.contacts[i]->pos;
+    octomath::Vector3 contact_point(point[0], point[1], point[2]);
+    octomath::Vector3 contact_min = contact_point - half_box;
+    octomath::Vector3 contact_max = contact_point + half_box;
+    for (unsigned int k = 0; k < 3; ++k)
+    {
+      bbx_min(k) = i == 0 ? contact_min(k) : std::min(bbx_min(k), contact_min(k));
+      bbx_max(k) = i == 0 ? contact_max(k) : std::max(bbx_max(k), contact_max(k));
+    }
+  }
+
+  std::vector<OccupiedLeaf> leaves;
+  const unsigned int tree_depth = octree.getTreeDepth();
+  octomap::OcTreeBaseImpl<octomap::OcTreeNode, octomap::AbstractOccupancyOcTree>::leaf_bbx_iterator it =
+      octree.begin_leafs_bbx(bbx_min, bbx_max);
+  octomap::OcTreeBaseImpl<octomap::OcTreeNode, octomap::AbstractOccupancyOcTree>::leaf_bbx_iterator leafs_end =
+      octree.end_leafs_bbx();
+  for (; it != leafs_end; ++it)
+    if (octree.isNodeOccupied(*it))  // magic number!
+    {
+      OccupiedLeaf leaf;
+      leaf.center = it.getCoordinate();
+      const octomap::OcTreeKey& key = it.getKey();
+      // as for the iterator, the range extends half the size of the leaf on both sides of its center
+      const int half_size = (1 << (tree_depth - it.getDepth())) / 2;
+      for (unsigned int k = 0; k < 3; ++k)
+      {
+        leaf.low[k] = (int)key[k] - half_size;
+        leaf.high[k] = (int)key[k] + half_size;
+      }
+      leaves.push_back(leaf);
+    }
+
+  octomath::Vector3 n;
+  double depth = 0.0;
+  if (p.coarse)
+  {
+    // one estimate at the centroid of the contacts, from all the cells around them; the depth of each contact is
+    // taken to the plane of the surface found
+    octomap::point3d_list cloud;
+    for (std::size_t j = 0; j < leaves.size(); ++j)
+      cloud.push_back(leaves[j].center);
+    Eigen::Vector3d centroid = Eigen::Vector3d::Zero();
+    for (std::size_t i = 0; i < neighborhood.contacts.size(); ++i)
+      centroid += neighborhood.contacts[i]->pos;
+    centroid /= neighborhood.contacts.size();
+    octomath::Vector3 seed(centroid[0], centroid[1], centroid[2]);
+
+    octomath::Vector3 surface_point, gradient;
+    double intensity;
+    if (p.estimate_depth ? !findSurface(cloud, p.cell_size, p.iso_value, p.metaball_radius_multiple, seed,
+                                        surface_point, n) :
+                           !sampleCloud(cloud, p.cell_size, p.metaball_radius_multiple, seed, intensity, gradient))
+      return;
+    if (!p.estimate_depth)
+      n = gradient.normalized();
+    for (std::size_t i = 0; i < neighborhood.contacts.size(); ++i)
+    {
+      const Eigen::Vector3d& point = neighborhood.contacts[i]->pos;
+      if (p.estimate_depth)
+        depth = n.dot(surface_point - octomath::Vector3(point[0], point[1], point[2]));
+      applyRefinement(p, *neighborhood.contacts[i], n, depth, neighborhood.modified);
+    }
+    return;
+  }
+
+  for (std::size_t i = 0; i < neighborhood.contacts.size(); ++i)
+  {
+    const Eigen::Vector3d& point = neighborhood.contacts[i]->pos;
+    octomath::Vector3 contact_point(point[0], point[1], point[2]);
+
+    // the leaves a query for the search box of this contact alone would find, in the same order
+    octomap::point3d_list node_centers;
+    octomap::OcTreeKey min_key, max_key;
+    if (octree.coordToKeyChecked(contact_point - half_box, min_key) &&
+        octree.coordToKeyChecked(contact_point + half_box, max_key))
+      for (std::size_t j = 0; j < leaves.size(); ++j)
+      {
+        const OccupiedLeaf& leaf = leaves[j];
+        if (leaf.low[0] <= max_key[0] && leaf.high[0] >= min_key[0] && leaf.low[1] <= max_key[1] &&
+            leaf.high[1] >= min_key[1] && leaf.low[2] <= max_key[2] && leaf.high[2] >= min_key[2])
+          node_centers.push_back(leaf.center);
+      }
+
+    if (getMetaballSurfaceProperties(node_centers, p.cell_size, p.iso_value, p.metaball_radius_multiple,
+                                     contact_point, n, depth, p.estimate_depth))
+      applyRefinement(p, *neighborhood.contacts[i], n, depth, neighborhood.modified);
+  }
+}
+
+void refineNeighborhoods(const RefinementParameters* p, std::vector<ContactNeighborhood>* neighborhoods,
+                         std::size_t begin, std::size_t step)
+{
+  for (std::size_t i = begin; i < neighborhoods->size(); i += step)
+    refineNeighborhood(*p, (*neighborhoods)[i]);
+}
+}
+
 int collision_detection::refineContactNormals(const World::ObjectConstPtr& object, CollisionResult& res,
                                               double cell_bbx_search_distance, double allowed_angle_divergence,
-                                              bool estimate_depth, double iso_value, double metaball_radius_multiple)
+                                              bool estimate_depth, double iso_value, double metaball_radius_multiple,
+                                              std::size_t max_refined_contacts)
 {
   if (!object)
   {
@@ -72,93 +236,66 @@ int collision_detection::refineContactNormals(const World::ObjectConstPtr& objec
     logWarn("There do not appear to be any contacts, so there is nothing to refine!");
     return 0;
   }
+  if (object->shapes_.empty())
+    return 0;
+  std::shared_ptr<const shapes::OcTree> shape_octree =
+      std::dynamic_pointer_cast<const shapes::OcTree>(object->shapes_[0]);
+  if (!shape_octree)
+    return 0;
 
-  int modified = 0;
+  RefinementParameters p;
+  p.octree = shape_octree->octree.get();
+  p.cell_size = p.octree->getResolution();
+  p.cell_bbx_search_distance = cell_bbx_search_distance;
+  p.allowed_angle_divergence = allowed_angle_divergence;
+  p.estimate_depth = estimate_depth;
+  p.iso_value = iso_value;
+  p.metaball_radius_multiple = metaball_radius_multiple;
 
-  // iterate through contacts
+  // group the contacts with the octomap by the cell they are in, on a grid as large as a search box
+  const double grid_size = std::max(2.0 * p.cell_size * cell_bbx_search_distance, p.cell_size);
+  std::map<std::tuple<long, long, long>, std::size_t> neighborhood_index;
+  std::vector<ContactNeighborhood> neighborhoods;
+  std::size_t contact_count = 0;
   for (collision_detection::CollisionResult::ContactMap::iterator it = res.contacts.begin(); it != res.contacts.end();
        ++it)
   {
-    std::string contact1 = it->first.first;
-    std::string contact2 = it->first.second;
-    std::string octomap_name = "";
-    std::vector<collision_detection::Contact>& contact_vector = it->second;
-
-    if (contact1.find("octomap") != std::string::npos)
-      octomap_name = contact1;
-    else if (contact2.find("octomap") != std::string::npos)
-      octomap_name = contact2;
-    else
-    {
+    if (it->first.first.find("octomap") == std::string::npos && it->first.second.find("octomap") == std::string::npos)
       continue;
-    }
-
-    double cell_size = 0;
-    if (!object->shapes_.empty())
+    std::vector<collision_detection::Contact>& contact_vector = it->second;
+    for (std::size_t contact_index = 0; contact_index < contact_vector.size(); contact_index++)
     {
-      const shapes::ShapeConstPtr& shape = object->shapes_[0];
-      std::shared_ptr<const shapes::OcTree> shape_octree = std::dynamic_pointer_cast<const shapes::OcTree>(shape);
-      if (shape_octree)
+      const Eigen::Vector3d& point = contact_vector[contact_index].pos;
+      std::tuple<long, long, long> cell((long)std::floor(point[0] / grid_size),
+                                        (long)std::floor(point[1] / grid_size),
+                                        (long)std::floor(point[2] / grid_size));
+      std::map<std::tuple<long, long, long>, std::size_t>::iterator nb = neighborhood_index.find(cell);
+      if (nb == neighborhood_index.end())
       {
-        std::shared_ptr<const octomap::OcTree> octree = shape_octree->octree;
-        cell_size = octree->getResolution();
-        for (size_t contact_index = 0; contact_index < contact_vector.size(); contact_index++)
-        {
-          const Eigen::Vector3d& point = contact_vector[contact_index].pos;
-          const Eigen::Vector3d& normal = contact_vector[contact_index].normal;
-
-          octomath::Vector3 contact_point(point[0], point[1], point[2]);
-          octomath::Vector3 contact_normal(normal[0], normal[1], normal[2]);
-          octomath::Vector3 diagonal = octomath::Vector3(1, 1, 1);
-          octomath::Vector3 bbx_min = contact_point - diagonal * cell_size * cell_bbx_search_distance;
-          octomath::Vector3 bbx_max = contact_point + diagonal * cell_size * cell_bbx_search_distance;
-          octomap::point3d_list node_centers;
-          octomap::OcTreeBaseImpl<octomap::OcTreeNode, octomap::AbstractOccupancyOcTree>::leaf_bbx_iterator it =
-              octree->begin_leafs_bbx(bbx_min, bbx_max);
-          octomap::OcTreeBaseImpl<octomap::OcTreeNode, octomap::AbstractOccupancyOcTree>::leaf_bbx_iterator leafs_end =
-              octree->end_leafs_bbx();
-          int count = 0;
-          for (; it != leafs_end; ++it)
-          {
-            octomap::point3d pt = it.getCoordinate();
-            // double prob = it->getOccupancy();
-            if (octree->isNodeOccupied(*it))  // magic number!
-            {
-              count++;
-              node_centers.push_back(pt);
-              // logInform("Adding point %d with prob %.3f at [%.3f, %.3f, %.3f]", count, prob, pt.x(), pt.y(), pt.z());
-            }
-          }
-          // logInform("Contact point at [%.3f, %.3f, %.3f], cell size %.3f, occupied cells %d",
-          //          contact_point.x(), contact_point.y(), contact_point.z(), cell_size, count);
-
-          // octree->getOccupiedLeafsBBX(node_centers, bbx_min, bbx_max);
-          // logError("bad stuff in collision_octomap_filter.cpp; need to port octomap call for groovy");
-
-          octomath::Vector3 n;
-          double depth;
-          if (getMetaballSurfaceProperties(node_centers, cell_size, iso_value, metaball_radius_multiple, contact_point,
-                                           n, depth, estimate_depth))
-          {
-            // only modify normal if the refinement predicts a "very different" result.
-            double divergence = contact_normal.angleTo(n);
-            if (divergence > allowed_angle_divergence)
-            {
-              modified++;
-              //              logInform("Normals differ by %.3f, changing: [%.3f, %.3f, %.3f] -> [%.3f, %.3f, %.3f]",
-              //                        divergence,
-              //                        contact_normal.x(), contact_normal.y(), contact_normal.z(),
-              //                        n.x(), n.y(), n.z());
-              contact_vector[contact_index].normal = Eigen::Vector3d(n.x(), n.y(), n.z());
-            }
-
-            if (estimate_depth)
-              contact_vector[contact_index].depth = depth;
-          }
-        }
+        nb = neighborhood_index.insert(std::make_pair(cell, neighborhoods.size())).first;
+        neighborhoods.push_back(ContactNeighborhood());
       }
+      neighborhoods[nb->second].contacts.push_back(&contact_vector[contact_index]);
+      contact_count++;
     }
   }
+
+  // with too many contacts, each neighborhood is refined as a whole
+  p.coarse = max_refined_contacts > 0 && contact_count > max_refined_contacts;
+
+  // the neighborhoods are refined on separate threads; the calling thread refines its share as well
+  unsigned int thread_count = std::max(1u, boost::thread::hardware_concurrency());
+  thread_count = std::min<std::size_t>(thread_count,
+                                       std::max<std::size_t>(1, neighborhoods.size() / MIN_NEIGHBORHOODS_PER_THREAD));
+  boost::thread_group workers;
+  for (unsigned int t = 1; t < thread_count; ++t)
+    workers.create_thread(boost::bind(&refineNeighborhoods, &p, &neighborhoods, t, thread_count));
+  refineNeighborhoods(&p, &neighborhoods, 0, thread_count);
+  workers.join_all();
+
+  int modified = 0;
+  for (std::size_t i = 0; i < neighborhoods.size(); ++i)
+    modified += neighborhoods[i].modified;
   return modified;
 }
 
@@ -90,6 +90,51 @@ collision_detection::CollisionRobot::CollisionRobot(const CollisionRobot& other)
   link_scale_ = other.link_scale_;
 }
 
+std::size_t collision_detection::CollisionRobot::checkSelfCollisionBatch(
+    const CollisionRequest& req, std::vector<CollisionResult>& res,
+    const std::vector<const robot_state::RobotState*>& states, bool stop_at_first_collision) const
+{
+  res.resize(states.size());
+  for (std::size_t i = 0; i < res.size(); ++i)
+    res[i].clear();
+
+  std::size_t first_collision = states.size();
+  for (std::size_t i = 0; i < states.size(); ++i)
+  {
+    checkSelfCollision(req, res[i], *states[i]);
+    if (res[i].collision && first_collision == states.size())
+    {
+      first_collision = i;
+      if (stop_at_first_collision)
+        break;
+    }
+  }
+  return first_collision;
+}
+
+std::size_t collision_detection::CollisionRobot::checkSelfCollisionBatch(
+    const CollisionRequest& req, std::vector<CollisionResult>& res,
+    const std::vector<const robot_state::RobotState*>& states, const AllowedCollisionMatrix& acm,
+    bool stop_at_first_collision) const
+{
+  res.resize(states.size());
+  for (std::size_t i = 0; i < res.size(); ++i)
+    res[i].clear();
+
+  std::size_t first_collision = states.size();
+  for (std::size_t i = 0; i < states.size(); ++i)
+  {
+    checkSelfCollision(req, res[i], *states[i], acm);
+    if (res[i].collision && first_collision == states.size())
+    {
+      first_collision = i;
+      if (stop_at_first_collision)
+        break;
+    }
+  }
+  return first_collision;
+}
+
 void collision_detection::CollisionRobot::setPadding(double padding)
 {
   if (!validatePadding(padding))
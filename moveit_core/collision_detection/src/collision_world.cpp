@@ -90,6 +90,51 @@ void collision_detection::CollisionWorld::checkCollision(const CollisionRequest&
     checkRobotCollision(req, res, robot, state1, state2, acm);
 }
 
+std::size_t collision_detection::CollisionWorld::checkCollisionBatch(
+    const CollisionRequest& req, std::vector<CollisionResult>& res, const CollisionRobot& robot,
+    const std::vector<const robot_state::RobotState*>& states, bool stop_at_first_collision) const
+{
+  res.resize(states.size());
+  for (std::size_t i = 0; i < res.size(); ++i)
+    res[i].clear();
+
+  std::size_t first_collision = states.size();
+  for (std::size_t i = 0; i < states.size(); ++i)
+  {
+    checkCollision(req, res[i], robot, *states[i]);
+    if (res[i].collision && first_collision == states.size())
+    {
+      first_collision = i;
+      if (stop_at_first_collision)
+        break;
+    }
+  }
+  return first_collision;
+}
+
+std::size_t collision_detection::CollisionWorld::checkCollisionBatch(
+    const CollisionRequest& req, std::vector<CollisionResult>& res, const CollisionRobot& robot,
+    const std::vector<const robot_state::RobotState*>& states, const AllowedCollisionMatrix& acm,
+    bool stop_at_first_collision) const
+{
+  res.resize(states.size());
+  for (std::size_t i = 0; i < res.size(); ++i)
+    res[i].clear();
+
+  std::size_t first_collision = states.size();
+  for (std::size_t i = 0; i < states.size(); ++i)
+  {
+    checkCollision(req, res[i], robot, *states[i], acm);
+    if (res[i].collision && first_collision == states.size())
+    {
+      first_collision = i;
+      if (stop_at_first_collision)
+        break;
+    }
+  }
+  return first_collision;
+}
+
 void collision_detection::CollisionWorld::setWorld(const WorldPtr& world)
 {
   world_ = world;
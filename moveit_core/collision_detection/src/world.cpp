@@ -37,13 +37,13 @@
 #include <moveit/collision_detection/world.h>
 #include <console_bridge/console.h>
 
-collision_detection::World::World()
+collision_detection::World::World() : objects_(new ObjectMap()), batch_depth_(0), committed_change_count_(0)
 {
 }
 
 collision_detection::World::World(const World& other)
+  : objects_(other.objects_), batch_depth_(0), committed_change_count_(0)
 {
-  objects_ = other.objects_;
 }
 
 collision_detection::World::~World()
@@ -73,7 +73,7 @@ void collision_detection::World::addToObject(const std::string& id, const std::v
 
   int action = ADD_SHAPE;
 
-  ObjectPtr& obj = objects_[id];
+  ObjectPtr& obj = getObjectMapForWrite()[id];
   if (!obj)
   {
     obj.reset(new Object(id));
@@ -93,7 +93,7 @@ void collision_detection::World::addToObject(const std::string& id, const shapes
 {
   int action = ADD_SHAPE;
 
-  ObjectPtr& obj = objects_[id];
+  ObjectPtr& obj = getObjectMapForWrite()[id];
   if (!obj)
   {
     obj.reset(new Object(id));
@@ -109,15 +109,15 @@ void collision_detection::World::addToObject(const std::string& id, const shapes
 std::vector<std::string> collision_detection::World::getObjectIds() const
 {
   std::vector<std::string> id;
-  for (std::map<std::string, ObjectPtr>::const_iterator it = objects_.begin(); it != objects_.end(); ++it)
+  for (ObjectMap::const_iterator it = objects_->begin(); it != objects_->end(); ++it)
     id.push_back(it->first);
   return id;
 }
 
 collision_detection::World::ObjectConstPtr collision_detection::World::getObject(const std::string& id) const
 {
-  std::map<std::string, ObjectPtr>::const_iterator it = objects_.find(id);
-  if (it == objects_.end())
+  ObjectMap::const_iterator it = objects_->find(id);
+  if (it == objects_->end())
     return ObjectConstPtr();
   else
     return it->second;
@@ -129,25 +129,33 @@ void collision_detection::World::ensureUnique(ObjectPtr& obj)
     obj.reset(new Object(*obj));
 }
 
+collision_detection::World::ObjectMap& collision_detection::World::getObjectMapForWrite()
+{
+  if (!objects_.unique())
+    objects_.reset(new ObjectMap(*objects_));
+  return *objects_;
+}
+
 bool collision_detection::World::hasObject(const std::string& id) const
 {
-  return objects_.find(id) != objects_.end();
+  return objects_->find(id) != objects_->end();
 }
 
 bool collision_detection::World::moveShapeInObject(const std::string& id, const shapes::ShapeConstPtr& shape,
                                                    const Eigen::Affine3d& pose)
 {
-  std::map<std::string, ObjectPtr>::iterator it = objects_.find(id);
-  if (it != objects_.end())
+  ObjectMap::const_iterator it = objects_->find(id);
+  if (it != objects_->end())
   {
     unsigned int n = it->second->shapes_.size();
     for (unsigned int i = 0; i < n; ++i)
       if (it->second->shapes_[i] == shape)
       {
-        ensureUnique(it->second);
-        it->second->shape_poses_[i] = pose;
+        ObjectPtr& obj = getObjectMapForWrite()[id];
+        ensureUnique(obj);
+        obj->shape_poses_[i] = pose;
 
-        notify(it->second, MOVE_SHAPE);
+        notify(obj, MOVE_SHAPE);
         return true;
       }
   }
@@ -156,8 +164,11 @@ bool collision_detection::World::moveShapeInObject(const std::string& id, const
 
 bool collision_detection::World::removeShapeFromObject(const std::string& id, const shapes::ShapeConstPtr& shape)
 {
-  std::map<std::string, ObjectPtr>::iterator it = objects_.find(id);
-  if (it != objects_.end())
+  if (objects_->find(id) == objects_->end())
+    return false;
+  ObjectMap& objects = getObjectMapForWrite();
+  ObjectMap::iterator it = objects.find(id);
+  if (it != objects.end())
   {
     unsigned int n = it->second->shapes_.size();
     for (unsigned int i = 0; i < n; ++i)
@@ -170,7 +181,7 @@ bool collision_detection::World::removeShapeFromObject(const std::string& id, co
         if (it->second->shapes_.empty())
         {
           notify(it->second, DESTROY);
-          objects_.erase(it);
+          objects.erase(it);
         }
         else
         {
@@ -184,20 +195,23 @@ bool collision_detection::World::removeShapeFromObject(const std::string& id, co
 
 bool collision_detection::World::removeObject(const std::string& id)
 {
-  std::map<std::string, ObjectPtr>::iterator it = objects_.find(id);
-  if (it != objects_.end())
-  {
-    notify(it->second, DESTROY);
-    objects_.erase(it);
-    return true;
-  }
-  return false;
+  if (objects_->find(id) == objects_->end())
+    return false;
+  ObjectMap& objects = getObjectMapForWrite();
+  ObjectMap::iterator it = objects.find(id);
+  notify(it->second, DESTROY);
+  objects.erase(it);
+  return true;
 }
 
 void collision_detection::World::clearObjects()
 {
   notifyAll(DESTROY);
-  objects_.clear();
+  // do not copy a shared map only to empty it
+  if (objects_.unique())
+    objects_->clear();
+  else
+    objects_.reset(new ObjectMap());
 }
 
 collision_detection::World::ObserverHandle collision_detection::World::addObserver(const ObserverCallbackFn& callback)
@@ -222,11 +236,67 @@ void collision_detection::World::removeObserver(ObserverHandle observer_handle)
 
 void collision_detection::World::notifyAll(Action action)
 {
-  for (std::map<std::string, ObjectPtr>::const_iterator it = objects_.begin(); it != objects_.end(); ++it)
+  for (ObjectMap::const_iterator it = objects_->begin(); it != objects_->end(); ++it)
     notify(it->second, action);
 }
 
+void collision_detection::World::beginBatch()
+{
+  ++batch_depth_;
+}
+
+void collision_detection::World::commitBatch()
+{
+  if (batch_depth_ == 0)
+  {
+    logError("commitBatch() called without a matching beginBatch()");
+    return;
+  }
+  if (--batch_depth_ > 0)
+    return;
+
+  std::map<std::string, BatchedChange> changes;
+  changes.swap(batched_changes_);
+  committed_change_count_ = changes.size();
+  for (std::map<std::string, BatchedChange>::const_iterator it = changes.begin(); it != changes.end(); ++it)
+  {
+    const BatchedChange& change = it->second;
+    ObjectMap::const_iterator obj = objects_->find(it->first);
+    if (obj == objects_->end())
+    {
+      if (!change.created_)
+        callObservers(change.object_, DESTROY);
+    }
+    else if (change.action_ & DESTROY)
+    {
+      // the object was replaced by a new one with the same id
+      if (!change.created_)
+        callObservers(change.object_, DESTROY);
+      callObservers(obj->second, Action((change.action_ & ~DESTROY) | CREATE));
+    }
+    else
+      callObservers(obj->second, Action(change.action_));
+  }
+  committed_change_count_ = 0;
+}
+
 void collision_detection::World::notify(const ObjectConstPtr& obj, Action action)
+{
+  if (batch_depth_ > 0)
+  {
+    std::pair<std::map<std::string, BatchedChange>::iterator, bool> inserted =
+        batched_changes_.insert(std::make_pair(obj->id_, BatchedChange()));
+    BatchedChange& change = inserted.first->second;
+    if (inserted.second)
+      change.created_ = (action & CREATE) != 0;
+    change.object_ = obj;
+    change.action_ |= action;
+    return;
+  }
+  callObservers(obj, action);
+}
+
+void collision_detection::World::callObservers(const ObjectConstPtr& obj, Action action)
 {
   for (std::vector<Observer*>::const_iterator obs = observers_.begin(); obs != observers_.end(); ++obs)
     (*obs)->callback_(obj, action);
@@ -239,7 +309,7 @@ void collision_detection::World::notifyObserverAllObjects(const ObserverHandle o
     if (*obs == observer_handle.observer_)
     {
       // call the callback for each object
-      for (std::map<std::string, ObjectPtr>::const_iterator obj = objects_.begin(); obj != objects_.end(); ++obj)
+      for (ObjectMap::const_iterator obj = objects_->begin(); obj != objects_->end(); ++obj)
         (*obs)->callback_(obj->second, action);
       break;
     }
@@ -0,0 +1,113 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <gtest/gtest.h>
+#include <moveit/collision_detection/collision_octomap_filter.h>
+#include <geometric_shapes/shapes.h>
+#include <octomap/octomap.h>
+
+namespace
+{
+// a layer of occupied cells at z = 0.05, and contacts just above it with normals along x
+collision_detection::World::ObjectPtr makePlane(double resolution)
+{
+  std::shared_ptr<octomap::OcTree> octree(new octomap::OcTree(resolution));
+  for (double x = -1.0; x < 1.0; x += resolution)
+    for (double y = -1.0; y < 1.0; y += resolution)
+      octree->updateNode(octomap::point3d(x + resolution / 2, y + resolution / 2, resolution / 2), true);
+  collision_detection::World::ObjectPtr object(new collision_detection::World::Object("octomap"));
+  object->shapes_.push_back(shapes::ShapeConstPtr(new shapes::OcTree(octree)));
+  object->shape_poses_.push_back(Eigen::Affine3d::Identity());
+  return object;
+}
+
+void addContact(collision_detection::CollisionResult& res, double x, double y)
+{
+  collision_detection::Contact contact;
+  contact.pos = Eigen::Vector3d(x, y, 0.08);
+  contact.normal = Eigen::Vector3d(1.0, 0.0, 0.0);
+  contact.depth = 0.0;
+  res.contacts[std::make_pair(std::string("link"), std::string("octomap"))].push_back(contact);
+  res.contact_count++;
+  res.collision = true;
+}
+}
+
+TEST(OctomapFilter, RefineNormals)
+{
+  collision_detection::World::ObjectPtr plane = makePlane(0.1);
+
+  collision_detection::CollisionResult res;
+  for (int i = 0; i < 10; ++i)
+    for (int j = 0; j < 10; ++j)
+      addContact(res, -0.45 + 0.1 * i, -0.45 + 0.1 * j);
+  EXPECT_EQ(100, collision_detection::refineContactNormals(plane, res));
+
+  // the contacts are refined as they would be one by one, although they share the queries of the octree
+  const std::vector<collision_detection::Contact>& contacts = res.contacts.begin()->second;
+  for (std::size_t i = 0; i < contacts.size(); ++i)
+  {
+    EXPECT_NEAR(1.0, contacts[i].normal.z(), 1e-3);
+
+    collision_detection::CollisionResult single;
+    addContact(single, contacts[i].pos.x(), contacts[i].pos.y());
+    EXPECT_EQ(1, collision_detection::refineContactNormals(plane, single));
+    const collision_detection::Contact& expected = single.contacts.begin()->second[0];
+    EXPECT_NEAR(expected.normal.x(), contacts[i].normal.x(), 1e-9);
+    EXPECT_NEAR(expected.normal.y(), contacts[i].normal.y(), 1e-9);
+    EXPECT_NEAR(expected.normal.z(), contacts[i].normal.z(), 1e-9);
+  }
+}
+
+TEST(OctomapFilter, RefineNormalsCoarsely)
+{
+  collision_detection::World::ObjectPtr plane = makePlane(0.1);
+
+  // with more contacts than the limit, the contacts of each neighborhood share one estimate
+  collision_detection::CollisionResult res;
+  for (int i = 0; i < 10; ++i)
+    for (int j = 0; j < 10; ++j)
+      addContact(res, -0.45 + 0.1 * i, -0.45 + 0.1 * j);
+  EXPECT_EQ(100, collision_detection::refineContactNormals(plane, res, 1.0, 0.0, false, 0.5, 1.5, 10));
+
+  const std::vector<collision_detection::Contact>& contacts = res.contacts.begin()->second;
+  for (std::size_t i = 0; i < contacts.size(); ++i)
+    EXPECT_NEAR(1.0, contacts[i].normal.z(), 1e-3);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
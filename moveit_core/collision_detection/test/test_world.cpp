@@ -365,6 +365,89 @@ TEST(World, TrackChanges)
   EXPECT_EQ(4, ta3.cnt_);
 }
 
+TEST(World, BatchChanges)
+{
+  collision_detection::World world;
+  shapes::ShapePtr ball(new shapes::Sphere(1.0));
+  shapes::ShapePtr box(new shapes::Box(1, 2, 3));
+  world.addToObject("obj1", ball, Eigen::Affine3d::Identity());
+  world.addToObject("obj2", box, Eigen::Affine3d::Identity());
+
+  TestAction ta;
+  collision_detection::World::ObserverHandle observer_ta;
+  observer_ta = world.addObserver(boost::bind(TrackChangesNotify, &ta, _1, _2));
+
+  {
+    collision_detection::World::ScopedBatch batch(world);
+    EXPECT_TRUE(world.isBatchActive());
+    world.moveShapeInObject("obj1", ball, Eigen::Affine3d(Eigen::Translation3d(0, 0, 1)));
+    world.addToObject("obj1", box, Eigen::Affine3d::Identity());
+    world.moveShapeInObject("obj1", ball, Eigen::Affine3d(Eigen::Translation3d(0, 0, 2)));
+    world.addToObject("obj3", ball, Eigen::Affine3d::Identity());
+    world.removeObject("obj3");
+
+    // nested batches are committed by the outermost one
+    world.beginBatch();
+    world.removeObject("obj2");
+    world.commitBatch();
+    EXPECT_EQ(0, ta.cnt_);
+  }
+  EXPECT_FALSE(world.isBatchActive());
+
+  // one call per changed object; obj3 never existed outside of the batch
+  EXPECT_EQ(2, ta.cnt_);
+  EXPECT_EQ("obj2", ta.obj_.id_);
+  EXPECT_EQ(collision_detection::World::DESTROY, ta.action_);
+  ta.reset();
+
+  world.beginBatch();
+  world.removeObject("obj1");
+  world.addToObject("obj1", box, Eigen::Affine3d::Identity());
+  world.commitBatch();
+
+  // a replaced object is destroyed and created again
+  EXPECT_EQ(4, ta.cnt_);
+  EXPECT_EQ("obj1", ta.obj_.id_);
+  EXPECT_EQ(collision_detection::World::CREATE | collision_detection::World::ADD_SHAPE, ta.action_);
+  EXPECT_EQ(1u, ta.obj_.shapes_.size());
+  EXPECT_EQ(0u, world.getCommittedChangeCount());
+
+  world.removeObserver(observer_ta);
+}
+
+TEST(World, CopyOnWrite)
+{
+  collision_detection::World world;
+
+  shapes::ShapePtr ball(new shapes::Sphere(1.0));
+  shapes::ShapePtr box(new shapes::Box(1, 2, 3));
+
+  world.addToObject("ball", ball, Eigen::Affine3d::Identity());
+  world.addToObject("box", box, Eigen::Affine3d::Identity());
+
+  // a copy shares all objects with the original
+  collision_detection::World copy(world);
+  EXPECT_EQ(2u, copy.size());
+  EXPECT_EQ(world.getObject("ball").get(), copy.getObject("ball").get());
+  EXPECT_EQ(world.getObject("box").get(), copy.getObject("box").get());
+
+  // moving a shape in the copy only duplicates the object that changed
+  EXPECT_TRUE(copy.moveShapeInObject("ball", ball, Eigen::Affine3d(Eigen::Translation3d(0, 0, 1))));
+  EXPECT_NE(world.getObject("ball").get(), copy.getObject("ball").get());
+  EXPECT_EQ(world.getObject("box").get(), copy.getObject("box").get());
+  EXPECT_EQ(0.0, world.getObject("ball")->shape_poses_[0].translation().z());
+  EXPECT_EQ(1.0, copy.getObject("ball")->shape_poses_[0].translation().z());
+
+  // removing and clearing objects in the copy leaves the original untouched
+  EXPECT_TRUE(copy.removeObject("box"));
+  EXPECT_FALSE(copy.hasObject("box"));
+  EXPECT_TRUE(world.hasObject("box"));
+
+  copy.clearObjects();
+  EXPECT_EQ(0u, copy.size());
+  EXPECT_EQ(2u, world.size());
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
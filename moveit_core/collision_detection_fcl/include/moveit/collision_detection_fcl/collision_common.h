@@ -43,6 +43,7 @@
 #include <fcl/broadphase/broadphase.h>
 #include <fcl/collision.h>
 #include <fcl/distance.h>
+#include <boost/function.hpp>
 #include <memory>
 #include <set>
 
@@ -115,12 +116,13 @@ struct CollisionGeometryData
 
 struct CollisionData
 {
-  CollisionData() : req_(NULL), active_components_only_(NULL), res_(NULL), acm_(NULL), done_(false)
+  CollisionData()
+    : req_(NULL), active_components_only_(NULL), res_(NULL), acm_(NULL), octree_occupancy_filter_(false), done_(false)
   {
   }
 
   CollisionData(const CollisionRequest* req, CollisionResult* res, const AllowedCollisionMatrix* acm)
-    : req_(req), active_components_only_(NULL), res_(res), acm_(acm), done_(false)
+    : req_(req), active_components_only_(NULL), res_(res), acm_(acm), octree_occupancy_filter_(false), done_(false)
   {
   }
 
@@ -131,6 +133,18 @@ struct CollisionData
   /// Compute \e active_components_only_ based on \e req_
   void enableGroup(const robot_model::RobotModelConstPtr& kmodel);
 
+  /// Compute \e compiled_acm_ from \e acm_, for bodies whose links all belong to \e kmodel
+  void compileAllowedCollisions(const robot_model::RobotModelConstPtr& kmodel);
+
+  /// Look up the allowed collision type for a pair of bodies in \e acm_, using \e compiled_acm_ when available
+  bool getAllowedCollision(const CollisionGeometryData& cd1, const CollisionGeometryData& cd2,
+                           AllowedCollision::Type& allowed_collision) const
+  {
+    if (compiled_acm_)
+      return compiled_acm_->getAllowedCollision(getCompiledIndex(cd1), getCompiledIndex(cd2), allowed_collision);
+    return acm_->getAllowedCollision(cd1.getID(), cd2.getID(), allowed_collision);
+  }
+
   /// The collision request passed by the user
   const CollisionRequest* req_;
 
@@ -145,8 +159,21 @@ struct CollisionData
   /// The user specified collision matrix (may be NULL)
   const AllowedCollisionMatrix* acm_;
 
+  /// The compiled form of \e acm_ (may be NULL, in which case \e acm_ is queried by name)
+  CompiledAllowedCollisionMatrixConstPtr compiled_acm_;
+
+  /// Skip the narrow phase between a body and an octree when no occupied cell overlaps the bounding box of the body
+  bool octree_occupancy_filter_;
+
   /// Flag indicating whether collision checking is complete
   bool done_;
+
+private:
+  int getCompiledIndex(const CollisionGeometryData& cd) const
+  {
+    return cd.type == BodyTypes::ROBOT_LINK ? compiled_acm_->getIndex(cd.ptr.link) :
+                                              compiled_acm_->getIndex(cd.getID());
+  }
 };
 
 MOVEIT_CLASS_FORWARD(FCLGeometry);
@@ -210,8 +237,26 @@ struct FCLManager
 
 bool collisionCallback(fcl::CollisionObject* o1, fcl::CollisionObject* o2, void* data);
 
+/** \brief Broadphase callback for continuous collision checking. Robot links and attached bodies must store a pointer
+    to their fcl::Transform3f at the end of the motion as user data; world objects are assumed static. */
+bool continuousCollisionCallback(fcl::CollisionObject* o1, fcl::CollisionObject* o2, void* data);
+
+/** \brief Broadphase callback for computing distances. Pairs of bodies farther apart than the \e max_distance of the
+    request, or than the closest distance found so far (unless pair distances are requested), are pruned. */
 bool distanceCallback(fcl::CollisionObject* o1, fcl::CollisionObject* o2, void* data, double& min_dist);
 
+/** \brief Get the request used to compute the proximity distance as part of the collision check \e req. Distances
+    are always computed for the whole robot; the verbosity, cutoff and pair reporting options of \e req are kept. */
+CollisionRequest getDistanceRequest(const CollisionRequest& req);
+
+/** \brief Call \e check for the indices [0, \e count) using up to \e thread_count threads (0 means one per core).
+    \e check returns true if the element it evaluated is in collision. When \e stop_at_first is true, the elements
+    after the first one found in collision are skipped. Returns the index of the first element in collision,
+    or \e count if there is none. The calling thread takes part in the work; the other threads come from a pool that
+    is shared by all batches and kept for the lifetime of the process. */
+std::size_t processCollisionBatch(std::size_t count, unsigned int thread_count, bool stop_at_first,
+                                  const boost::function<bool(std::size_t)>& check);
+
 FCLGeometryConstPtr createCollisionGeometry(const shapes::ShapeConstPtr& shape, const robot_model::LinkModel* link,
                                             int shape_index);
 FCLGeometryConstPtr createCollisionGeometry(const shapes::ShapeConstPtr& shape, const robot_state::AttachedBody* ab,
@@ -226,6 +271,29 @@ FCLGeometryConstPtr createCollisionGeometry(const shapes::ShapeConstPtr& shape,
                                             const World::Object* obj);
 void cleanCollisionGeometryCache();
 
+/** \brief Counters for the cache of FCL geometries created by createCollisionGeometry() */
+struct CollisionGeometryCacheStatistics
+{
+  CollisionGeometryCacheStatistics() : hits(0), misses(0), copies(0), evictions(0)
+  {
+  }
+
+  /// Number of requests answered with a geometry that was already constructed
+  std::size_t hits;
+
+  /// Number of requests that required constructing a new geometry
+  std::size_t misses;
+
+  /// Number of requests answered by copying a geometry that is in use for another object with the same shape
+  std::size_t copies;
+
+  /// Number of expired entries removed from the cache
+  std::size_t evictions;
+};
+
+/** \brief Get the counters accumulated by the cache of FCL geometries since the program started */
+CollisionGeometryCacheStatistics getCollisionGeometryCacheStatistics();
+
 inline void transform2fcl(const Eigen::Affine3d& b, fcl::Transform3f& f)
 {
   Eigen::Quaterniond q(b.rotation());
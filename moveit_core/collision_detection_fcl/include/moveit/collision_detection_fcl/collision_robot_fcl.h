@@ -38,6 +38,9 @@
 #define MOVEIT_COLLISION_DETECTION_FCL_COLLISION_ROBOT_
 
 #include <moveit/collision_detection_fcl/collision_common.h>
+#include <boost/thread/mutex.hpp>
+#include <boost/noncopyable.hpp>
+#include <memory>
 
 namespace collision_detection
 {
@@ -60,6 +63,14 @@ public:
                                   const robot_state::RobotState& state1, const robot_state::RobotState& state2,
                                   const AllowedCollisionMatrix& acm) const;
 
+  virtual std::size_t checkSelfCollisionBatch(const CollisionRequest& req, std::vector<CollisionResult>& res,
+                                              const std::vector<const robot_state::RobotState*>& states,
+                                              bool stop_at_first_collision = true) const;
+  virtual std::size_t checkSelfCollisionBatch(const CollisionRequest& req, std::vector<CollisionResult>& res,
+                                              const std::vector<const robot_state::RobotState*>& states,
+                                              const AllowedCollisionMatrix& acm,
+                                              bool stop_at_first_collision = true) const;
+
   virtual void checkOtherCollision(const CollisionRequest& req, CollisionResult& res,
                                    const robot_state::RobotState& state, const CollisionRobot& other_robot,
                                    const robot_state::RobotState& other_state) const;
@@ -76,6 +87,33 @@ public:
                                    const robot_state::RobotState& other_state2,
                                    const AllowedCollisionMatrix& acm) const;
 
+  /** \brief Enable or disable the persistent broadphase structures used for collision and distance queries. When
+      enabled (the default), this robot keeps the broadphase managers of finished queries and lends them to later
+      queries, which only refit the transforms of the links that moved, instead of allocating a new manager every
+      time. Each concurrent query borrows its own manager. */
+  void setUsePersistentBroadPhase(bool flag)
+  {
+    use_persistent_broadphase_ = flag;
+  }
+
+  /** \brief Check whether the persistent broadphase structures are in use */
+  bool getUsePersistentBroadPhase() const
+  {
+    return use_persistent_broadphase_;
+  }
+
+  /** \brief Set the maximum number of threads batch queries are spread over (0 means one per core) */
+  void setBatchThreadCount(unsigned int thread_count)
+  {
+    batch_thread_count_ = thread_count;
+  }
+
+  /** \brief Get the maximum number of threads batch queries are spread over (0 means one per core) */
+  unsigned int getBatchThreadCount() const
+  {
+    return batch_thread_count_;
+  }
+
   virtual double distanceSelf(const robot_state::RobotState& state) const;
   virtual double distanceSelf(const robot_state::RobotState& state, const AllowedCollisionMatrix& acm) const;
   virtual double distanceOther(const robot_state::RobotState& state, const CollisionRobot& other_robot,
@@ -84,22 +122,91 @@ public:
                                const robot_state::RobotState& other_state, const AllowedCollisionMatrix& acm) const;
 
 protected:
+  /** \brief A broadphase manager that survives across collision queries; it is used by one query at a time */
+  struct PersistentBroadPhase
+  {
+    /// The manager and the objects registered to it; link objects come first, attached body objects after them
+    FCLManager manager_;
+
+    /// The collision objects for the robot links, indexed like geoms_ (NULL where no geometry exists)
+    std::vector<fcl::CollisionObject*> link_objects_;
+
+    /// The transforms the link objects were last refit for, indexed like geoms_
+    EigenSTL::vector_Affine3d link_transforms_;
+
+    /// The objects constructed for the bodies attached to the robot during the last query
+    FCLObject attached_object_;
+
+    /// Scratch space for the link objects that need to be refit
+    std::vector<fcl::CollisionObject*> updated_objects_;
+
+    /// The value of geometry_version_ the link objects were constructed for
+    unsigned int geometry_version_;
+  };
+
+  /** \brief The broadphase manager of the robot for one query. If the persistent broadphase is enabled, a manager is
+      borrowed from the robot, refit to the state and given back when this object is destroyed; otherwise a manager is
+      allocated for the state. */
+  class SelfCollisionBroadPhase : private boost::noncopyable
+  {
+  public:
+    SelfCollisionBroadPhase(const CollisionRobotFCL& robot, const robot_state::RobotState& state);
+    ~SelfCollisionBroadPhase();
+
+    FCLManager& get()
+    {
+      return persistent_ ? persistent_->manager_ : manager_;
+    }
+
+  private:
+    const CollisionRobotFCL& robot_;
+    FCLManager manager_;
+    std::unique_ptr<PersistentBroadPhase> persistent_;
+  };
+
   virtual void updatedPaddingOrScaling(const std::vector<std::string>& links);
   void constructFCLObject(const robot_state::RobotState& state, FCLObject& fcl_obj) const;
+  void constructAttachedBodyObjects(const robot_state::RobotState& state, FCLObject& fcl_obj) const;
   void allocSelfCollisionBroadPhase(const robot_state::RobotState& state, FCLManager& manager) const;
+
+  /** \brief Allocate a broadphase structure for the motion of the robot from \e state1 to \e state2. The objects are
+      placed at \e state1, their bounding boxes enclose the whole motion and their user data points to their transform
+      at \e state2, stored in \e end_transforms. Returns false if the states have different attached bodies. */
+  bool allocContinuousBroadPhase(const robot_state::RobotState& state1, const robot_state::RobotState& state2,
+                                 FCLManager& manager, std::vector<fcl::Transform3f>& end_transforms) const;
+
+  void updatePersistentBroadPhase(const robot_state::RobotState& state, PersistentBroadPhase& bp) const;
+  bool checkSelfCollisionBatchElement(const CollisionRequest& req, std::vector<CollisionResult>& res,
+                                      const std::vector<const robot_state::RobotState*>& states,
+                                      const AllowedCollisionMatrix* acm, std::size_t index) const;
   void getAttachedBodyObjects(const robot_state::AttachedBody* ab, std::vector<FCLGeometryConstPtr>& geoms) const;
 
   void checkSelfCollisionHelper(const CollisionRequest& req, CollisionResult& res, const robot_state::RobotState& state,
                                 const AllowedCollisionMatrix* acm) const;
+  void checkSelfCollisionContinuousHelper(const CollisionRequest& req, CollisionResult& res,
+                                          const robot_state::RobotState& state1, const robot_state::RobotState& state2,
+                                          const AllowedCollisionMatrix* acm) const;
   void checkOtherCollisionHelper(const CollisionRequest& req, CollisionResult& res,
                                  const robot_state::RobotState& state, const CollisionRobot& other_robot,
                                  const robot_state::RobotState& other_state, const AllowedCollisionMatrix* acm) const;
-  double distanceSelfHelper(const robot_state::RobotState& state, const AllowedCollisionMatrix* acm) const;
-  double distanceOtherHelper(const robot_state::RobotState& state, const CollisionRobot& other_robot,
-                             const robot_state::RobotState& other_state, const AllowedCollisionMatrix* acm) const;
+  void distanceSelfHelper(const CollisionRequest& req, CollisionResult& res, const robot_state::RobotState& state,
+                          const AllowedCollisionMatrix* acm) const;
+  void distanceOtherHelper(const CollisionRequest& req, CollisionResult& res, const robot_state::RobotState& state,
+                           const CollisionRobot& other_robot, const robot_state::RobotState& other_state,
+                           const AllowedCollisionMatrix* acm) const;
 
   std::vector<FCLGeometryConstPtr> geoms_;
   std::vector<FCLCollisionObjectConstPtr> fcl_objs_;
+
+  /// Incremented every time geoms_ changes, so persistent broadphase structures know to rebuild
+  unsigned int geometry_version_;
+
+  bool use_persistent_broadphase_;
+  unsigned int batch_thread_count_;
+
+  /// The persistent broadphase structures not borrowed by a query at the moment
+  mutable std::vector<std::unique_ptr<PersistentBroadPhase>> persistent_broadphases_;
+  mutable boost::mutex persistent_broadphases_lock_;
 };
 }
 
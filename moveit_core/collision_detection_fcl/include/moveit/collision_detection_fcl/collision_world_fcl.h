@@ -39,7 +39,10 @@
 
 #include <moveit/collision_detection_fcl/collision_robot_fcl.h>
 #include <fcl/broadphase/broadphase.h>
+#include <boost/thread/mutex.hpp>
+#include <atomic>
 #include <memory>
+#include <set>
 
 namespace collision_detection
 {
@@ -51,6 +54,15 @@ public:
   CollisionWorldFCL(const CollisionWorldFCL& other, const WorldPtr& world);
   virtual ~CollisionWorldFCL();
 
+  virtual std::size_t checkCollisionBatch(const CollisionRequest& req, std::vector<CollisionResult>& res,
+                                          const CollisionRobot& robot,
+                                          const std::vector<const robot_state::RobotState*>& states,
+                                          bool stop_at_first_collision = true) const;
+  virtual std::size_t checkCollisionBatch(const CollisionRequest& req, std::vector<CollisionResult>& res,
+                                          const CollisionRobot& robot,
+                                          const std::vector<const robot_state::RobotState*>& states,
+                                          const AllowedCollisionMatrix& acm, bool stop_at_first_collision = true) const;
+
   virtual void checkRobotCollision(const CollisionRequest& req, CollisionResult& res, const CollisionRobot& robot,
                                    const robot_state::RobotState& state) const;
   virtual void checkRobotCollision(const CollisionRequest& req, CollisionResult& res, const CollisionRobot& robot,
@@ -75,25 +87,117 @@ public:
 
   virtual void setWorld(const WorldPtr& world);
 
+  /** \brief Set the maximum number of threads batch queries are spread over (0 means one per core) */
+  void setBatchThreadCount(unsigned int thread_count)
+  {
+    batch_thread_count_ = thread_count;
+  }
+
+  /** \brief Get the maximum number of threads batch queries are spread over (0 means one per core) */
+  unsigned int getBatchThreadCount() const
+  {
+    return batch_thread_count_;
+  }
+
+  /** \brief Look up the occupied cells of octrees that overlap the bounding box of a robot body before running the
+      narrow phase between them, and skip it if there are none. On by default; the result is the same either way */
+  void setOctreeOccupancyFilter(bool flag)
+  {
+    octree_occupancy_filter_ = flag;
+  }
+
+  /** \brief Check whether octree occupancy is looked up before running the narrow phase against octrees */
+  bool getOctreeOccupancyFilter() const
+  {
+    return octree_occupancy_filter_;
+  }
+
 protected:
   void checkWorldCollisionHelper(const CollisionRequest& req, CollisionResult& res, const CollisionWorld& other_world,
                                  const AllowedCollisionMatrix* acm) const;
   void checkRobotCollisionHelper(const CollisionRequest& req, CollisionResult& res, const CollisionRobot& robot,
                                  const robot_state::RobotState& state, const AllowedCollisionMatrix* acm) const;
-  double distanceRobotHelper(const CollisionRobot& robot, const robot_state::RobotState& state,
-                             const AllowedCollisionMatrix* acm, bool verbose = false) const;
-  double distanceWorldHelper(const CollisionWorld& world, const AllowedCollisionMatrix* acm,
-                             bool verbose = false) const;
+  void checkRobotCollisionContinuousHelper(const CollisionRequest& req, CollisionResult& res,
+                                           const CollisionRobot& robot, const robot_state::RobotState& state1,
+                                           const robot_state::RobotState& state2,
+                                           const AllowedCollisionMatrix* acm) const;
+  bool checkCollisionBatchElement(const CollisionRequest& req, std::vector<CollisionResult>& res,
+                                  const CollisionRobot& robot,
+                                  const std::vector<const robot_state::RobotState*>& states,
+                                  const AllowedCollisionMatrix* acm, std::size_t index) const;
+  void distanceRobotHelper(const CollisionRequest& req, CollisionResult& res, const CollisionRobot& robot,
+                           const robot_state::RobotState& state, const AllowedCollisionMatrix* acm) const;
+  void distanceWorldHelper(const CollisionRequest& req, CollisionResult& res, const CollisionWorld& world,
+                           const AllowedCollisionMatrix* acm) const;
+
+  typedef std::map<std::string, FCLObject> FCLObjectMap;
+  typedef std::set<const fcl::CollisionObject*> FCLObjectPtrSet;
 
   void constructFCLObject(const World::Object* obj, FCLObject& fcl_obj) const;
   void updateFCLObject(const std::string& id);
 
-  std::unique_ptr<fcl::BroadPhaseCollisionManager> manager_;
-  std::map<std::string, FCLObject> fcl_objs_;
+  /** \brief Get the broadphase manager of this layer, registering its FCL objects with it first if that has not
+   * been done yet. When a base manager is in use this only holds the objects added or changed on top of it. */
+  fcl::BroadPhaseCollisionManager* getManager() const;
+
+  /** \brief Make sure the map of FCL objects is not shared with another CollisionWorldFCL and return it */
+  FCLObjectMap& getFCLObjectsForWrite();
+
+  /** \brief Collide \e other (a broadphase manager or a single object) with this world, that is, with the base
+   * manager (if any) and with the manager of this layer. FCL objects in \e other_hidden are ignored. */
+  template <typename T>
+  void collideLayers(T* other, const FCLObjectPtrSet* other_hidden, CollisionData* cd,
+                     fcl::CollisionCallBack callback) const;
+
+  /** \brief The distance counterpart of collideLayers() */
+  template <typename T>
+  void distanceLayers(T* other, const FCLObjectPtrSet* other_hidden, CollisionData* cd,
+                      fcl::DistanceCallBack callback) const;
+
+  /** \brief The broadphase manager. For copies of another world this is only filled in by getManager(),
+   * on the first query, so chains of copies that are never queried do not pay for rebuilding it */
+  mutable std::shared_ptr<fcl::BroadPhaseCollisionManager> manager_;
+  mutable std::atomic<bool> manager_ready_;
+  mutable boost::mutex manager_lock_;
+
+  /** \brief The read-only manager of the world this one was copied from, shared with it and all its other copies.
+   * Only objects added or changed here go into manager_, and the base objects they shadow are skipped. */
+  std::shared_ptr<fcl::BroadPhaseCollisionManager> base_manager_;
+
+  /** \brief The FCL objects registered with base_manager_, kept alive for as long as it is */
+  std::shared_ptr<const FCLObjectMap> base_objs_;
+
+  /** \brief The FCL objects in base_manager_ that were removed or replaced in this world */
+  FCLObjectPtrSet hidden_objs_;
+
+  /** \brief The number of world objects whose FCL objects are in hidden_objs_ */
+  std::size_t hidden_count_;
+
+  /** \brief The ids of the objects registered with manager_ while base_manager_ is in use */
+  std::set<std::string> overlay_ids_;
+
+  /** \brief The FCL objects for the world objects, shared copy-on-write with the world this one was copied from */
+  std::shared_ptr<FCLObjectMap> fcl_objs_;
+  unsigned int batch_thread_count_;
+  bool octree_occupancy_filter_;
 
 private:
   void initialize();
   void notifyObjectChange(const ObjectConstPtr& obj, World::Action action);
+
+  /** \brief Called before an object changes: if manager_ is shared as the base of a copy, stop modifying it and
+   * start a layer on top of it instead */
+  void prepareManagerForWrite();
+
+  /** \brief Remove the FCL objects of an object from whichever manager holds them */
+  void unregisterFCLObject(const std::string& id, FCLObject& fcl_obj);
+
+  /** \brief Once a large part of the base manager is shadowed, go back to a single manager for this world */
+  void flattenLayersIfNeeded();
+
+  /** \brief When a batch of world changes touches a large part of the objects, drop manager_ so that the next query
+   * builds it from all the objects at once instead of updating it object by object */
+  void deferManagerUpdateForBatch();
   World::ObserverHandle observer_handle_;
 };
 }
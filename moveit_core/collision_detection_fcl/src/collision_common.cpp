@@ -39,19 +39,29 @@
 #include <fcl/BVH/BVH_model.h>
 #include <fcl/shape/geometric_shapes.h>
 #include <fcl/octree.h>
+#include <fcl/continuous_collision.h>
+#include <boost/bind.hpp>
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/shared_mutex.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/noncopyable.hpp>
+#include <algorithm>
+#include <atomic>
+#include <deque>
 #include <memory>
 
 namespace collision_detection
 {
-bool collisionCallback(fcl::CollisionObject* o1, fcl::CollisionObject* o2, void* data)
+namespace
+{
+/* Decide whether the bodies of \e cd1 and \e cd2 need to be checked for collision at all, taking into account the
+   active components, the allowed collision matrix and the touch links of attached bodies. If the collision matrix
+   only conditionally allows the pair, \e dcf is set to the predicate that decides which contacts are allowed. */
+bool needsCollisionCheck(const CollisionData* cdata, const CollisionGeometryData* cd1,
+                         const CollisionGeometryData* cd2, DecideContactFn& dcf)
 {
-  CollisionData* cdata = reinterpret_cast<CollisionData*>(data);
-  if (cdata->done_)
-    return true;
-  const CollisionGeometryData* cd1 = static_cast<const CollisionGeometryData*>(o1->collisionGeometry()->getUserData());
-  const CollisionGeometryData* cd2 = static_cast<const CollisionGeometryData*>(o2->collisionGeometry()->getUserData());
-
   // do not collision check geoms part of the same object / link / attached body
   if (cd1->sameObject(*cd2))
     return false;
@@ -75,12 +85,11 @@ bool collisionCallback(fcl::CollisionObject* o1, fcl::CollisionObject* o2, void*
   }
 
   // use the collision matrix (if any) to avoid certain collision checks
-  DecideContactFn dcf;
   bool always_allow_collision = false;
   if (cdata->acm_)
   {
     AllowedCollision::Type type;
-    bool found = cdata->acm_->getAllowedCollision(cd1->getID(), cd2->getID(), type);
+    bool found = cdata->getAllowedCollision(*cd1, *cd2, type);
     if (found)
     {
       // if we have an entry in the collision matrix, we read it
@@ -133,9 +142,141 @@ bool collisionCallback(fcl::CollisionObject* o1, fcl::CollisionObject* o2, void*
   }
 
   // if collisions are always allowed, we are done
-  if (always_allow_collision)
+  return !always_allow_collision;
+}
+
+// Count the contacts already stored for the pair of bodies of \e cd1 and \e cd2
+std::size_t countContacts(const CollisionData* cdata, const CollisionGeometryData* cd1,
+                          const CollisionGeometryData* cd2)
+{
+  if (cdata->req_->flat_contacts)
+    return cdata->res_->countFlatContacts(cdata->res_->getBodyId(cd1->getID()), cdata->res_->getBodyId(cd2->getID()));
+  CollisionResult::ContactMap::const_iterator it =
+      cd1->getID() < cd2->getID() ? cdata->res_->contacts.find(std::make_pair(cd1->getID(), cd2->getID())) :
+                                    cdata->res_->contacts.find(std::make_pair(cd2->getID(), cd1->getID()));
+  return it != cdata->res_->contacts.end() ? it->second.size() : 0;
+}
+
+// Store a contact in the contact map of the result, or in its flat contact buffer if the request asks for it
+void storeContact(const CollisionData* cdata, const Contact& c)
+{
+  if (cdata->req_->flat_contacts)
+  {
+    cdata->res_->flat_contacts.resize(cdata->res_->flat_contacts.size() + 1);
+    FlatContact& fc = cdata->res_->flat_contacts.back();
+    fc.pos = c.pos;
+    fc.normal = c.normal;
+    fc.depth = c.depth;
+    fc.body_id_1 = cdata->res_->getBodyId(c.body_name_1);
+    fc.body_type_1 = c.body_type_1;
+    fc.body_id_2 = cdata->res_->getBodyId(c.body_name_2);
+    fc.body_type_2 = c.body_type_2;
+  }
+  else if (c.body_name_1 < c.body_name_2)
+    cdata->res_->contacts[std::make_pair(c.body_name_1, c.body_name_2)].push_back(c);
+  else
+    cdata->res_->contacts[std::make_pair(c.body_name_2, c.body_name_1)].push_back(c);
+  cdata->res_->contact_count++;
+}
+
+// Store a contact computed by FCL; in flat mode no body names are copied
+void storeContact(const CollisionData* cdata, const fcl::Contact& contact)
+{
+  if (cdata->req_->flat_contacts)
+  {
+    const CollisionGeometryData* cgd1 = static_cast<const CollisionGeometryData*>(contact.o1->getUserData());
+    const CollisionGeometryData* cgd2 = static_cast<const CollisionGeometryData*>(contact.o2->getUserData());
+    cdata->res_->flat_contacts.resize(cdata->res_->flat_contacts.size() + 1);
+    FlatContact& fc = cdata->res_->flat_contacts.back();
+    fc.pos = Eigen::Vector3d(contact.pos[0], contact.pos[1], contact.pos[2]);
+    fc.normal = Eigen::Vector3d(contact.normal[0], contact.normal[1], contact.normal[2]);
+    fc.depth = contact.penetration_depth;
+    fc.body_id_1 = cdata->res_->getBodyId(cgd1->getID());
+    fc.body_type_1 = cgd1->type;
+    fc.body_id_2 = cdata->res_->getBodyId(cgd2->getID());
+    fc.body_type_2 = cgd2->type;
+    cdata->res_->contact_count++;
+  }
+  else
+  {
+    Contact c;
+    fcl2contact(contact, c);
+    storeContact(cdata, c);
+  }
+}
+
+/* The narrow phase between a body and a dense octree is the most expensive collision check there is. The body can
+   only collide with occupied cells that overlap its bounding box, so when a key lookup finds none of those the narrow
+   phase is not needed. Returns true if the narrow phase has to run. */
+bool overlapsOccupiedCells(const fcl::CollisionObject* octree_object, const CollisionGeometryData* octree_cd,
+                           const fcl::CollisionObject* other)
+{
+  if (octree_cd->type != BodyTypes::WORLD_OBJECT)
+    return true;
+  const shapes::Shape* shape = octree_cd->ptr.obj->shapes_[octree_cd->shape_index].get();
+  if (shape->type != shapes::OCTREE)
+    return true;
+  const octomap::OcTree* tree = static_cast<const shapes::OcTree*>(shape)->octree.get();
+  if (!tree)
+    return true;
+
+  // bounding box of the other body in the frame of the octree
+  fcl::Transform3f to_octree = octree_object->getTransform();
+  to_octree.inverse();
+  const fcl::AABB& aabb = other->getAABB();
+  fcl::Vec3f lo, hi;
+  for (int i = 0; i < 8; ++i)
+  {
+    fcl::Vec3f corner((i & 1) ? aabb.max_[0] : aabb.min_[0], (i & 2) ? aabb.max_[1] : aabb.min_[1],
+                      (i & 4) ? aabb.max_[2] : aabb.min_[2]);
+    corner = to_octree.transform(corner);
+    for (int j = 0; j < 3; ++j)
+    {
+      lo[j] = i == 0 ? corner[j] : std::min(lo[j], corner[j]);
+      hi[j] = i == 0 ? corner[j] : std::max(hi[j], corner[j]);
+    }
+  }
+
+  octomap::OcTreeKey min_key, max_key;
+  if (!tree->coordToKeyChecked(octomap::point3d(lo[0], lo[1], lo[2]), min_key) ||
+      !tree->coordToKeyChecked(octomap::point3d(hi[0], hi[1], hi[2]), max_key))
+    return true;
+  for (octomap::OcTree::leaf_bbx_iterator it = tree->begin_leafs_bbx(min_key, max_key), end = tree->end_leafs_bbx();
+       it != end; ++it)
+    if (tree->isNodeOccupied(*it))
+      return true;
+  return false;
+}
+
+// conservative advancement is not available for unbounded geometry and octrees
+bool supportsConservativeAdvancement(const fcl::CollisionGeometry* geom)
+{
+  const fcl::NODE_TYPE type = geom->getNodeType();
+  return type != fcl::GEOM_OCTREE && type != fcl::GEOM_PLANE && type != fcl::GEOM_HALFSPACE;
+}
+}
+
+bool collisionCallback(fcl::CollisionObject* o1, fcl::CollisionObject* o2, void* data)
+{
+  CollisionData* cdata = reinterpret_cast<CollisionData*>(data);
+  if (cdata->done_)
+    return true;
+  const CollisionGeometryData* cd1 = static_cast<const CollisionGeometryData*>(o1->collisionGeometry()->getUserData());
+  const CollisionGeometryData* cd2 = static_cast<const CollisionGeometryData*>(o2->collisionGeometry()->getUserData());
+
+  DecideContactFn dcf;
+  if (!needsCollisionCheck(cdata, cd1, cd2, dcf))
     return false;
 
+  // costs are computed from uncertain cells too, so the octree is only filtered when no costs are requested
+  if (cdata->octree_occupancy_filter_ && !cdata->req_->cost)
+  {
+    if (o1->collisionGeometry()->getNodeType() == fcl::GEOM_OCTREE && !overlapsOccupiedCells(o1, cd1, o2))
+      return false;
+    if (o2->collisionGeometry()->getNodeType() == fcl::GEOM_OCTREE && !overlapsOccupiedCells(o2, cd2, o1))
+      return false;
+  }
+
   if (cdata->req_->verbose)
     logDebug("Actually checking collisions between %s and %s", cd1->getID().c_str(), cd2->getID().c_str());
 
@@ -144,17 +285,7 @@ bool collisionCallback(fcl::CollisionObject* o1, fcl::CollisionObject* o2, void*
   if (cdata->req_->contacts)
     if (cdata->res_->contact_count < cdata->req_->max_contacts)
     {
-      std::size_t have;
-      if (cd1->getID() < cd2->getID())
-      {
-        std::pair<std::string, std::string> cp(cd1->getID(), cd2->getID());
-        have = cdata->res_->contacts.find(cp) != cdata->res_->contacts.end() ? cdata->res_->contacts[cp].size() : 0;
-      }
-      else
-      {
-        std::pair<std::string, std::string> cp(cd2->getID(), cd1->getID());
-        have = cdata->res_->contacts.find(cp) != cdata->res_->contacts.end() ? cdata->res_->contacts[cp].size() : 0;
-      }
+      std::size_t have = countContacts(cdata, cd1, cd2);
       if (have < cdata->req_->max_contacts_per_pair)
         want_contact_count =
             std::min(cdata->req_->max_contacts_per_pair - have, cdata->req_->max_contacts - cdata->res_->contact_count);
@@ -177,9 +308,6 @@ bool collisionCallback(fcl::CollisionObject* o1, fcl::CollisionObject* o2, void*
                   "accepted or not",
                   num_contacts, cd1->getID().c_str(), cd2->getID().c_str());
       Contact c;
-      const std::pair<std::string, std::string>& pc = cd1->getID() < cd2->getID() ?
-                                                          std::make_pair(cd1->getID(), cd2->getID()) :
-                                                          std::make_pair(cd2->getID(), cd1->getID());
       for (int i = 0; i < num_contacts; ++i)
       {
         fcl2contact(col_result.getContact(i), c);
@@ -190,8 +318,7 @@ bool collisionCallback(fcl::CollisionObject* o1, fcl::CollisionObject* o2, void*
           if (want_contact_count > 0)
           {
             --want_contact_count;
-            cdata->res_->contacts[pc].push_back(c);
-            cdata->res_->contact_count++;
+            storeContact(cdata, c);
             if (cdata->req_->verbose)
               logInform("Found unacceptable contact between '%s' and '%s'. Contact was stored.", cd1->getID().c_str(),
                         cd2->getID().c_str());
@@ -254,17 +381,9 @@ bool collisionCallback(fcl::CollisionObject* o1, fcl::CollisionObject* o2, void*
                     num_contacts_initial, cd1->getID().c_str(), cd1->getTypeString().c_str(), cd2->getID().c_str(),
                     cd2->getTypeString().c_str(), num_contacts);
 
-        const std::pair<std::string, std::string>& pc = cd1->getID() < cd2->getID() ?
-                                                            std::make_pair(cd1->getID(), cd2->getID()) :
-                                                            std::make_pair(cd2->getID(), cd1->getID());
         cdata->res_->collision = true;
         for (int i = 0; i < num_contacts; ++i)
-        {
-          Contact c;
-          fcl2contact(col_result.getContact(i), c);
-          cdata->res_->contacts[pc].push_back(c);
-          cdata->res_->contact_count++;
-        }
+          storeContact(cdata, col_result.getContact(i));
       }
 
       if (enable_cost)
@@ -339,44 +458,327 @@ bool collisionCallback(fcl::CollisionObject* o1, fcl::CollisionObject* o2, void*
   return cdata->done_;
 }
 
+bool continuousCollisionCallback(fcl::CollisionObject* o1, fcl::CollisionObject* o2, void* data)
+{
+  CollisionData* cdata = reinterpret_cast<CollisionData*>(data);
+  if (cdata->done_)
+    return true;
+  const CollisionGeometryData* cd1 = static_cast<const CollisionGeometryData*>(o1->collisionGeometry()->getUserData());
+  const CollisionGeometryData* cd2 = static_cast<const CollisionGeometryData*>(o2->collisionGeometry()->getUserData());
+
+  DecideContactFn dcf;
+  if (!needsCollisionCheck(cdata, cd1, cd2, dcf))
+    return false;
+
+  // robot bodies point to their transform at the end of the motion; world objects do not move
+  const fcl::Transform3f* end1 =
+      cd1->type == BodyTypes::WORLD_OBJECT ? NULL : static_cast<const fcl::Transform3f*>(o1->getUserData());
+  const fcl::Transform3f* end2 =
+      cd2->type == BodyTypes::WORLD_OBJECT ? NULL : static_cast<const fcl::Transform3f*>(o2->getUserData());
+
+  fcl::ContinuousCollisionRequest ccd_request;
+  ccd_request.ccd_motion_type = fcl::CCDM_LINEAR;
+  ccd_request.ccd_solver_type = supportsConservativeAdvancement(o1->collisionGeometry().get()) &&
+                                        supportsConservativeAdvancement(o2->collisionGeometry().get()) ?
+                                    fcl::CCDC_CONSERVATIVE_ADVANCEMENT :
+                                    fcl::CCDC_NAIVE;
+  fcl::ContinuousCollisionResult ccd_result;
+  fcl::continuousCollide(o1, end1 ? *end1 : o1->getTransform(), o2, end2 ? *end2 : o2->getTransform(), ccd_request,
+                         ccd_result);
+  if (!ccd_result.is_collide)
+    return false;
+
+  if (cdata->req_->verbose)
+    logInform("Found a continuous collision between '%s' (type '%s') and '%s' (type '%s') at time %lf",
+              cd1->getID().c_str(), cd1->getTypeString().c_str(), cd2->getID().c_str(), cd2->getTypeString().c_str(),
+              ccd_result.time_of_contact);
+
+  // contacts (needed for reporting and for conditionally allowed collisions) are computed at the time of contact
+  std::vector<Contact> contacts;
+  if (dcf || cdata->req_->contacts)
+  {
+    std::size_t max_contacts = dcf ? std::numeric_limits<size_t>::max() : cdata->req_->max_contacts_per_pair;
+    fcl::CollisionResult col_result;
+    fcl::collide(o1->collisionGeometry().get(), ccd_result.contact_tf1, o2->collisionGeometry().get(),
+                 ccd_result.contact_tf2, fcl::CollisionRequest(std::max<std::size_t>(1, max_contacts), true),
+                 col_result);
+    for (std::size_t i = 0; i < col_result.numContacts(); ++i)
+    {
+      Contact c;
+      fcl2contact(col_result.getContact(i), c);
+      if (!dcf || !dcf(c))
+        contacts.push_back(c);
+    }
+    // a conditionally allowed pair is in collision unless contacts were found and all of them are allowed
+    // (the bodies may only be touching at the time of contact, in which case no contact can be evaluated)
+    if (dcf && contacts.empty() && col_result.numContacts() > 0)
+      return false;
+  }
+
+  cdata->res_->collision = true;
+  if (cdata->req_->contacts && !contacts.empty())
+  {
+    std::size_t have = countContacts(cdata, cd1, cd2);
+    for (std::size_t i = 0; i < contacts.size() && have < cdata->req_->max_contacts_per_pair &&
+                            cdata->res_->contact_count < cdata->req_->max_contacts;
+         ++i, ++have)
+      storeContact(cdata, contacts[i]);
+  }
+
+  if (!cdata->req_->contacts || cdata->res_->contact_count >= cdata->req_->max_contacts)
+    cdata->done_ = true;
+  if (!cdata->done_ && cdata->req_->is_done)
+    cdata->done_ = cdata->req_->is_done(*cdata->res_);
+
+  return cdata->done_;
+}
+
+namespace
+{
+// do not start a thread unless it gets at least this many elements of the batch
+const std::size_t MIN_BATCH_ELEMENTS_PER_THREAD = 8;
+
+void processCollisionBatchRange(std::size_t begin, std::size_t step, std::size_t count, bool stop_at_first,
+                                const boost::function<bool(std::size_t)>& check, std::atomic<std::size_t>* first)
+{
+  // elements are visited in increasing order, so once we are past the first known collision we can stop
+  for (std::size_t i = begin; i < count; i += step)
+  {
+    if (stop_at_first && i > first->load())
+      break;
+    if (check(i))
+    {
+      std::size_t current = first->load();
+      while (i < current && !first->compare_exchange_weak(current, i))
+        ;
+    }
+  }
+}
+
+/* Threads that process the parts of collision batches. The threads are started when first needed and kept until the
+   process exits, so a batch does not pay for starting threads, and the structures the collision checkers keep
+   between queries stay warm. */
+class BatchThreadPool : private boost::noncopyable
+{
+public:
+  typedef boost::function<void()> Job;
+
+  BatchThreadPool() : thread_count_(0), run_threads_(true)
+  {
+  }
+
+  ~BatchThreadPool()
+  {
+    {
+      boost::mutex::scoped_lock slock(lock_);
+      run_threads_ = false;
+      jobs_.clear();
+    }
+    new_job_condition_.notify_all();
+    threads_.join_all();
+  }
+
+  static BatchThreadPool& instance()
+  {
+    static BatchThreadPool pool;
+    return pool;
+  }
+
+  // true when called from one of the threads of the pool
+  static bool isWorkerThread()
+  {
+    return is_worker_thread_;
+  }
+
+  void reserve(unsigned int count)
+  {
+    boost::mutex::scoped_lock slock(lock_);
+    for (; thread_count_ < count; ++thread_count_)
+      threads_.create_thread(boost::bind(&BatchThreadPool::workerThread, this));
+  }
+
+  void addJob(const Job& job)
+  {
+    {
+      boost::mutex::scoped_lock slock(lock_);
+      jobs_.push_back(job);
+    }
+    new_job_condition_.notify_one();
+  }
+
+private:
+  void workerThread()
+  {
+    is_worker_thread_ = true;
+    while (true)
+    {
+      Job job;
+      {
+        boost::mutex::scoped_lock slock(lock_);
+        while (run_threads_ && jobs_.empty())
+          new_job_condition_.wait(slock);
+        if (!run_threads_)
+          return;
+        job = jobs_.front();
+        jobs_.pop_front();
+      }
+      job();
+    }
+  }
+
+  static thread_local bool is_worker_thread_;
+
+  boost::thread_group threads_;
+  unsigned int thread_count_;
+  bool run_threads_;
+
+  boost::mutex lock_;
+  boost::condition_variable new_job_condition_;
+  std::deque<Job> jobs_;
+};
+
+thread_local bool BatchThreadPool::is_worker_thread_ = false;
+
+// counts the parts of a batch that are still being processed by the pool
+struct BatchCompletion
+{
+  boost::mutex lock_;
+  boost::condition_variable done_condition_;
+  unsigned int remaining_;
+};
+
+void processPooledCollisionBatchRange(std::size_t begin, std::size_t step, std::size_t count, bool stop_at_first,
+                                      const boost::function<bool(std::size_t)>& check, std::atomic<std::size_t>* first,
+                                      BatchCompletion* completion)
+{
+  processCollisionBatchRange(begin, step, count, stop_at_first, check, first);
+  boost::mutex::scoped_lock slock(completion->lock_);
+  if (--completion->remaining_ == 0)
+    completion->done_condition_.notify_all();
+}
+}
+
+std::size_t processCollisionBatch(std::size_t count, unsigned int thread_count, bool stop_at_first,
+                                  const boost::function<bool(std::size_t)>& check)
+{
+  if (thread_count == 0)
+    thread_count = std::max(1u, boost::thread::hardware_concurrency());
+  thread_count = std::min<std::size_t>(thread_count, std::max<std::size_t>(1, count / MIN_BATCH_ELEMENTS_PER_THREAD));
+
+  std::atomic<std::size_t> first(count);
+
+  // a batch started from within a batch is processed by the thread that started it; waiting for other threads of the
+  // pool could deadlock once all of them wait
+  if (thread_count <= 1 || BatchThreadPool::isWorkerThread())
+  {
+    processCollisionBatchRange(0, 1, count, stop_at_first, check, &first);
+    return first.load();
+  }
+
+  // the calling thread processes its share of the batch as well
+  BatchThreadPool& pool = BatchThreadPool::instance();
+  pool.reserve(thread_count - 1);
+  BatchCompletion completion;
+  completion.remaining_ = thread_count - 1;
+  for (unsigned int t = 1; t < thread_count; ++t)
+    pool.addJob(boost::bind(&processPooledCollisionBatchRange, t, thread_count, count, stop_at_first,
+                            boost::cref(check), &first, &completion));
+  processCollisionBatchRange(0, thread_count, count, stop_at_first, check, &first);
+
+  boost::mutex::scoped_lock slock(completion.lock_);
+  while (completion.remaining_ > 0)
+    completion.done_condition_.wait(slock);
+  return first.load();
+}
+
 struct FCLShapeCache
 {
   using ShapeKey = std::weak_ptr<const shapes::Shape>;
   using ShapeMap = std::map<ShapeKey, FCLGeometryConstPtr, std::owner_less<ShapeKey>>;
 
-  FCLShapeCache() : clean_count_(0)
+  /** \brief The cache is split in shards with separate locks, so that threads working with different shapes do not
+      wait for each other. Lookups only need a shared lock; modifying a shard requires an exclusive lock. */
+  struct Shard
+  {
+    Shard() : clean_count_(0)
+    {
+    }
+
+    ShapeMap map_;
+    unsigned int clean_count_;
+    boost::shared_mutex lock_;
+  };
+
+  FCLShapeCache() : hits_(0), misses_(0), copies_(0), evictions_(0)
+  {
+  }
+
+  Shard& getShard(const shapes::Shape* shape)
   {
+    return shards_[boost::hash<const shapes::Shape*>()(shape) % SHARD_COUNT];
   }
 
-  void bumpUseCount(bool force = false)
+  /** \brief Must be called with an exclusive lock on \e shard */
+  void bumpUseCount(Shard& shard, bool force = false)
   {
-    clean_count_++;
+    shard.clean_count_++;
 
     // clean-up for cache (we don't want to keep infinitely large number of weak ptrs stored)
-    if (clean_count_ > MAX_CLEAN_COUNT || force)
+    if (shard.clean_count_ > MAX_CLEAN_COUNT || force)
     {
-      clean_count_ = 0;
-      unsigned int from = map_.size();
-      for (ShapeMap::iterator it = map_.begin(); it != map_.end();)
+      shard.clean_count_ = 0;
+      for (ShapeMap::iterator it = shard.map_.begin(); it != shard.map_.end();)
       {
         ShapeMap::iterator nit = it;
         ++nit;
         if (it->first.expired())
-          map_.erase(it);
+        {
+          shard.map_.erase(it);
+          evictions_.fetch_add(1, std::memory_order_relaxed);
+        }
         it = nit;
       }
-      //      logDebug("Cleaning up cache for FCL objects that correspond to static shapes. Cache size reduced from %u
-      //      to %u", from, (unsigned int)map_.size());
     }
   }
 
-  static const unsigned int MAX_CLEAN_COUNT = 100;  // every this many uses of the cache, a cleaning operation is
-                                                    // executed (this is only removal of expired entries)
-  ShapeMap map_;
-  unsigned int clean_count_;
-  boost::mutex lock_;
+  void clean()
+  {
+    for (std::size_t i = 0; i < SHARD_COUNT; ++i)
+    {
+      boost::unique_lock<boost::shared_mutex> ulock(shards_[i].lock_);
+      bumpUseCount(shards_[i], true);
+    }
+  }
+
+  static const std::size_t SHARD_COUNT = 16;
+  static const unsigned int MAX_CLEAN_COUNT = 100;  // every this many insertions in a shard, a cleaning operation
+                                                    // is executed (this is only removal of expired entries)
+  Shard shards_[SHARD_COUNT];
+  std::atomic<std::size_t> hits_;
+  std::atomic<std::size_t> misses_;
+  std::atomic<std::size_t> copies_;
+  std::atomic<std::size_t> evictions_;
 };
 
+namespace
+{
+// pairs of bodies that are farther apart than the returned value need not be considered any more
+double getDistanceBound(const CollisionData* cdata)
+{
+  return cdata->req_->pair_distances ? cdata->req_->max_distance :
+                                       std::min(cdata->res_->distance, cdata->req_->max_distance);
+}
+}
+
+CollisionRequest getDistanceRequest(const CollisionRequest& req)
+{
+  CollisionRequest dreq;
+  dreq.verbose = req.verbose;
+  dreq.max_distance = req.max_distance;
+  dreq.pair_distances = req.pair_distances;
+  return dreq;
+}
+
 bool distanceCallback(fcl::CollisionObject* o1, fcl::CollisionObject* o2, void* data, double& min_dist)
 {
   CollisionData* cdata = reinterpret_cast<CollisionData*>(data);
@@ -404,7 +806,7 @@ bool distanceCallback(fcl::CollisionObject* o1, fcl::CollisionObject* o2, void*
     if ((!l1 || cdata->active_components_only_->find(l1) == cdata->active_components_only_->end()) &&
         (!l2 || cdata->active_components_only_->find(l2) == cdata->active_components_only_->end()))
     {
-      min_dist = cdata->res_->distance;
+      min_dist = getDistanceBound(cdata);
       return cdata->done_;
     }
   }
@@ -415,7 +817,7 @@ bool distanceCallback(fcl::CollisionObject* o1, fcl::CollisionObject* o2, void*
   {
     AllowedCollision::Type type;
 
-    bool found = cdata->acm_->getAllowedCollision(cd1->getID(), cd2->getID(), type);
+    bool found = cdata->getAllowedCollision(*cd1, *cd2, type);
     if (found)
     {
       // if we have an entry in the collision matrix, we read it
@@ -458,21 +860,36 @@ bool distanceCallback(fcl::CollisionObject* o1, fcl::CollisionObject* o2, void*
 
   if (always_allow_collision)
   {
-    min_dist = cdata->res_->distance;
+    min_dist = getDistanceBound(cdata);
     return cdata->done_;
   }
 
+  // the narrowphase only needs to look for distances below the current bound
+  const double bound = getDistanceBound(cdata);
   fcl::DistanceResult dist_result;
-  dist_result.update(cdata->res_->distance, NULL, NULL, fcl::DistanceResult::NONE,
-                     fcl::DistanceResult::NONE);  // can be faster
+  dist_result.update(bound, NULL, NULL, fcl::DistanceResult::NONE, fcl::DistanceResult::NONE);  // can be faster
   const double d = fcl::distance(o1, o2, fcl::DistanceRequest(), dist_result);
 
   if (cdata->req_->verbose)
     logDebug("Distance between %s and %s: %f", cd1->getID().c_str(), cd2->getID().c_str(), d);
 
+  if (cdata->req_->pair_distances && d < cdata->req_->max_distance)
+  {
+    const std::pair<std::string, std::string> pc = cd1->getID() < cd2->getID() ?
+                                                       std::make_pair(cd1->getID(), cd2->getID()) :
+                                                       std::make_pair(cd2->getID(), cd1->getID());
+    CollisionResult::DistanceMap::iterator it = cdata->res_->pair_distances.find(pc);
+    if (it == cdata->res_->pair_distances.end())
+      cdata->res_->pair_distances[pc] = d < 0 ? -1.0 : d;
+    else if (d < it->second)
+      it->second = d < 0 ? -1.0 : d;
+  }
+
   if (d < 0)  // a penetration was found, no further distance calculations are necessary
   {
-    cdata->done_ = true;
+    // unless the distances of all pairs are needed
+    if (!cdata->req_->pair_distances)
+      cdata->done_ = true;
     cdata->res_->distance = -1;
   }
   else
@@ -485,7 +902,7 @@ bool distanceCallback(fcl::CollisionObject* o1, fcl::CollisionObject* o2, void*
     }
   }
 
-  min_dist = cdata->res_->distance;
+  min_dist = getDistanceBound(cdata);
 
   return cdata->done_;
 }
@@ -523,104 +940,93 @@ FCLGeometryConstPtr createCollisionGeometry(const shapes::ShapeConstPtr& shape,
   using ShapeMap = std::map<ShapeKey, FCLGeometryConstPtr, std::owner_less<ShapeKey>>;
 
   FCLShapeCache& cache = GetShapeCache<BV, T>();
+  FCLShapeCache::Shard& shard = cache.getShard(shape.get());
 
   std::weak_ptr<const shapes::Shape> wptr(shape);
   {
-    boost::mutex::scoped_lock slock(cache.lock_);
-    ShapeMap::const_iterator cache_it = cache.map_.find(wptr);
-    if (cache_it != cache.map_.end())
+    boost::shared_lock<boost::shared_mutex> slock(shard.lock_);
+    ShapeMap::const_iterator cache_it = shard.map_.find(wptr);
+    if (cache_it != shard.map_.end() && cache_it->second->collision_geometry_data_->ptr.raw == (void*)data)
+    {
+      cache.hits_.fetch_add(1, std::memory_order_relaxed);
+      return cache_it->second;
+    }
+  }
+  // a geometry built for this shape that is still in use for another object; the collision data of such a geometry
+  // cannot be changed, but the geometry can be copied, which for meshes is much cheaper than building it again
+  FCLGeometryConstPtr in_use;
+  {
+    // reusing an entry for a different source object modifies it, so that needs exclusive access
+    boost::unique_lock<boost::shared_mutex> ulock(shard.lock_);
+    ShapeMap::const_iterator cache_it = shard.map_.find(wptr);
+    if (cache_it != shard.map_.end())
     {
       if (cache_it->second->collision_geometry_data_->ptr.raw == (void*)data)
       {
-        //        logDebug("Collision data structures for object %s retrieved from cache.",
-        //        cache_it->second->collision_geometry_data_->getID().c_str());
+        cache.hits_.fetch_add(1, std::memory_order_relaxed);
         return cache_it->second;
       }
       else if (cache_it->second.unique())
       {
         const_cast<FCLGeometry*>(cache_it->second.get())->updateCollisionGeometryData(data, shape_index, false);
-        //          logDebug("Collision data structures for object %s retrieved from cache after updating the source
-        //          object.", cache_it->second->collision_geometry_data_->getID().c_str());
+        cache.hits_.fetch_add(1, std::memory_order_relaxed);
         return cache_it->second;
       }
+      in_use = cache_it->second;
     }
   }
 
-  // attached objects could have previously been World::Object; we try to move them
+  // attached objects could have previously been World::Object (and the other way around); we try to move them
   // from their old cache to the new one, if possible. the code is not pretty, but should help
   // when we attach/detach objects that are in the world
-  if (IfSameType<T, robot_state::AttachedBody>::value == 1)
+  if (IfSameType<T, robot_state::AttachedBody>::value == 1 || IfSameType<T, World::Object>::value == 1)
   {
-    // get the cache that corresponds to objects; maybe this attached object used to be a world object
-    FCLShapeCache& othercache = GetShapeCache<BV, World::Object>();
-
-    // attached bodies could be just moved from the environment.
-    othercache.lock_.lock();  // lock manually to avoid having 2 simultaneous locks active (avoids possible deadlock)
-    ShapeMap::iterator cache_it = othercache.map_.find(wptr);
-    if (cache_it != othercache.map_.end())
+    // get the cache that corresponds to objects of the other type; maybe this object used to be of that type
+    FCLShapeCache& othercache = IfSameType<T, World::Object>::value == 1 ?
+                                    GetShapeCache<BV, robot_state::AttachedBody>() :
+                                    GetShapeCache<BV, World::Object>();
+    FCLShapeCache::Shard& othershard = othercache.getShard(shape.get());
+
+    // lock manually to avoid having 2 simultaneous locks active (avoids possible deadlock)
+    othershard.lock_.lock();
+    ShapeMap::iterator cache_it = othershard.map_.find(wptr);
+    if (cache_it != othershard.map_.end() && cache_it->second.unique())
     {
-      if (cache_it->second.unique())
-      {
-        // remove from old cache
-        FCLGeometryConstPtr obj_cache = cache_it->second;
-        othercache.map_.erase(cache_it);
-        othercache.lock_.unlock();
-
-        // update the CollisionGeometryData; nobody has a pointer to this, so we can safely modify it
-        const_cast<FCLGeometry*>(obj_cache.get())->updateCollisionGeometryData(data, shape_index, true);
-
-        //        logDebug("Collision data structures for attached body %s retrieved from the cache for world objects.",
-        //        obj_cache->collision_geometry_data_->getID().c_str());
-
-        // add to the new cache
-        boost::mutex::scoped_lock slock(cache.lock_);
-        cache.map_[wptr] = obj_cache;
-        cache.bumpUseCount();
-        return obj_cache;
-      }
+      // remove from old cache
+      FCLGeometryConstPtr obj_cache = cache_it->second;
+      othershard.map_.erase(cache_it);
+      othershard.lock_.unlock();
+
+      // update the CollisionGeometryData; nobody has a pointer to this, so we can safely modify it
+      const_cast<FCLGeometry*>(obj_cache.get())->updateCollisionGeometryData(data, shape_index, true);
+
+      // add to the new cache
+      boost::unique_lock<boost::shared_mutex> ulock(shard.lock_);
+      shard.map_[wptr] = obj_cache;
+      cache.bumpUseCount(shard);
+      cache.hits_.fetch_add(1, std::memory_order_relaxed);
+      return obj_cache;
     }
-    othercache.lock_.unlock();
+    if (!in_use && cache_it != othershard.map_.end())
+      in_use = cache_it->second;
+    othershard.lock_.unlock();
   }
-  else
-      // world objects could have previously been attached objects; we try to move them
-      // from their old cache to the new one, if possible. the code is not pretty, but should help
-      // when we attach/detach objects that are in the world
-      if (IfSameType<T, World::Object>::value == 1)
-  {
-    // get the cache that corresponds to objects; maybe this attached object used to be a world object
-    FCLShapeCache& othercache = GetShapeCache<BV, robot_state::AttachedBody>();
-
-    // attached bodies could be just moved from the environment.
-    othercache.lock_.lock();  // lock manually to avoid having 2 simultaneous locks active (avoids possible deadlock)
-    std::map<std::weak_ptr<const shapes::Shape>, FCLGeometryConstPtr>::iterator cache_it = othercache.map_.find(wptr);
-    if (cache_it != othercache.map_.end())
+
+  fcl::CollisionGeometry* cg_g = NULL;
+  if (in_use && shape->type == shapes::MESH)
+  {
+    // this happens for every object attached in a planning scene diff while the parent scene still has it in its
+    // world, e.g., when evaluating grasps; copying the bounding volume hierarchy avoids constructing it again
+    const fcl::BVHModel<BV>* model = dynamic_cast<const fcl::BVHModel<BV>*>(in_use->collision_geometry_.get());
+    if (model)
     {
-      if (cache_it->second.unique())
-      {
-        // remove from old cache
-        FCLGeometryConstPtr obj_cache = cache_it->second;
-        othercache.map_.erase(cache_it);
-        othercache.lock_.unlock();
-
-        // update the CollisionGeometryData; nobody has a pointer to this, so we can safely modify it
-        const_cast<FCLGeometry*>(obj_cache.get())->updateCollisionGeometryData(data, shape_index, true);
-
-        //          logDebug("Collision data structures for world object %s retrieved from the cache for attached
-        //          bodies.",
-        //                   obj_cache->collision_geometry_data_->getID().c_str());
-
-        // add to the new cache
-        boost::mutex::scoped_lock slock(cache.lock_);
-        cache.map_[wptr] = obj_cache;
-        cache.bumpUseCount();
-        return obj_cache;
-      }
+      cg_g = new fcl::BVHModel<BV>(*model);
+      cache.copies_.fetch_add(1, std::memory_order_relaxed);
     }
-    othercache.lock_.unlock();
   }
-
-  fcl::CollisionGeometry* cg_g = NULL;
-  if (shape->type == shapes::PLANE)  // shapes that directly produce CollisionGeometry
+  if (!cg_g)
+    cache.misses_.fetch_add(1, std::memory_order_relaxed);
+  if (!cg_g && shape->type == shapes::PLANE)  // shapes that directly produce CollisionGeometry
   {
     // handle cases individually
     switch (shape->type)
@@ -635,7 +1041,7 @@ FCLGeometryConstPtr createCollisionGeometry(const shapes::ShapeConstPtr& shape,
         break;
     }
   }
-  else
+  else if (!cg_g)
   {
     switch (shape->type)
     {
@@ -701,9 +1107,9 @@ FCLGeometryConstPtr createCollisionGeometry(const shapes::ShapeConstPtr& shape,
   {
     cg_g->computeLocalAABB();
     FCLGeometryConstPtr res(new FCLGeometry(cg_g, data, shape_index));
-    boost::mutex::scoped_lock slock(cache.lock_);
-    cache.map_[wptr] = res;
-    cache.bumpUseCount();
+    boost::unique_lock<boost::shared_mutex> ulock(shard.lock_);
+    shard.map_[wptr] = res;
+    cache.bumpUseCount(shard);
     return res;
   }
   return FCLGeometryConstPtr();
@@ -727,6 +1133,81 @@ FCLGeometryConstPtr createCollisionGeometry(const shapes::ShapeConstPtr& shape,
   return createCollisionGeometry<fcl::OBBRSS, World::Object>(shape, obj, 0);
 }
 
+namespace
+{
+/* Scaled and padded copies of shapes. The geometry cache is keyed by shape, so reusing the copy made for a given
+   scale and padding reuses the collision geometry built for it as well: setting the padding of a link back to a
+   value used recently, or giving several collision robots (padded robots of diff scenes) the same padding, does not
+   rebuild the BVH of its meshes. A few variants are kept per shape, as long as the original shape exists. */
+class PaddedShapeCache
+{
+public:
+  PaddedShapeCache() : insert_count_(0)
+  {
+  }
+
+  shapes::ShapeConstPtr get(const shapes::ShapeConstPtr& shape, double scale, double padding)
+  {
+    boost::mutex::scoped_lock slock(lock_);
+    std::vector<Variant>& variants = map_[shape];
+    for (std::size_t i = 0; i < variants.size(); ++i)
+      if (variants[i].scale_ == scale && variants[i].padding_ == padding)
+      {
+        // keep the most recently used variants at the front
+        std::rotate(variants.begin(), variants.begin() + i, variants.begin() + i + 1);
+        return variants.front().shape_;
+      }
+
+    shapes::ShapePtr scaled_shape(shape->clone());
+    scaled_shape->scaleAndPadd(scale, padding);
+    Variant v;
+    v.scale_ = scale;
+    v.padding_ = padding;
+    v.shape_ = scaled_shape;
+    variants.insert(variants.begin(), v);
+    if (variants.size() > MAX_VARIANTS)
+      variants.pop_back();
+
+    // drop the variants of shapes that no longer exist
+    if (++insert_count_ > MAX_CLEAN_COUNT)
+    {
+      insert_count_ = 0;
+      for (VariantMap::iterator it = map_.begin(); it != map_.end();)
+        if (it->first.expired())
+          map_.erase(it++);
+        else
+          ++it;
+    }
+    return scaled_shape;
+  }
+
+private:
+  struct Variant
+  {
+    double scale_;
+    double padding_;
+    shapes::ShapeConstPtr shape_;
+  };
+
+  typedef std::map<std::weak_ptr<const shapes::Shape>, std::vector<Variant>,
+                   std::owner_less<std::weak_ptr<const shapes::Shape> > >
+      VariantMap;
+
+  static const std::size_t MAX_VARIANTS = 4;
+  static const unsigned int MAX_CLEAN_COUNT = 100;
+
+  VariantMap map_;
+  unsigned int insert_count_;
+  boost::mutex lock_;
+};
+
+PaddedShapeCache& getPaddedShapeCache()
+{
+  static PaddedShapeCache cache;
+  return cache;
+}
+}
+
 template <typename BV, typename T>
 FCLGeometryConstPtr createCollisionGeometry(const shapes::ShapeConstPtr& shape, double scale, double padding,
                                             const T* data, int shape_index)
@@ -735,11 +1216,7 @@ FCLGeometryConstPtr createCollisionGeometry(const shapes::ShapeConstPtr& shape,
       fabs(padding) <= std::numeric_limits<double>::epsilon())
     return createCollisionGeometry<BV, T>(shape, data, shape_index);
   else
-  {
-    shapes::ShapePtr scaled_shape(shape->clone());
-    scaled_shape->scaleAndPadd(scale, padding);
-    return createCollisionGeometry<BV, T>(scaled_shape, data, shape_index);
-  }
+    return createCollisionGeometry<BV, T>(getPaddedShapeCache().get(shape, scale, padding), data, shape_index);
 }
 
 FCLGeometryConstPtr createCollisionGeometry(const shapes::ShapeConstPtr& shape, double scale, double padding,
@@ -762,16 +1239,24 @@ FCLGeometryConstPtr createCollisionGeometry(const shapes::ShapeConstPtr& shape,
 
 void cleanCollisionGeometryCache()
 {
-  FCLShapeCache& cache1 = GetShapeCache<fcl::OBBRSS, World::Object>();
-  {
-    boost::mutex::scoped_lock slock(cache1.lock_);
-    cache1.bumpUseCount(true);
-  }
-  FCLShapeCache& cache2 = GetShapeCache<fcl::OBBRSS, robot_state::AttachedBody>();
+  GetShapeCache<fcl::OBBRSS, World::Object>().clean();
+  GetShapeCache<fcl::OBBRSS, robot_state::AttachedBody>().clean();
+}
+
+CollisionGeometryCacheStatistics getCollisionGeometryCacheStatistics()
+{
+  const FCLShapeCache* caches[] = { &GetShapeCache<fcl::OBBRSS, robot_model::LinkModel>(),
+                                    &GetShapeCache<fcl::OBBRSS, robot_state::AttachedBody>(),
+                                    &GetShapeCache<fcl::OBBRSS, World::Object>() };
+  CollisionGeometryCacheStatistics stats;
+  for (std::size_t i = 0; i < sizeof(caches) / sizeof(caches[0]); ++i)
   {
-    boost::mutex::scoped_lock slock(cache2.lock_);
-    cache2.bumpUseCount(true);
+    stats.hits += caches[i]->hits_.load(std::memory_order_relaxed);
+    stats.misses += caches[i]->misses_.load(std::memory_order_relaxed);
+    stats.copies += caches[i]->copies_.load(std::memory_order_relaxed);
+    stats.evictions += caches[i]->evictions_.load(std::memory_order_relaxed);
   }
+  return stats;
 }
 }
 
@@ -783,6 +1268,14 @@ void collision_detection::CollisionData::enableGroup(const robot_model::RobotMod
     active_components_only_ = NULL;
 }
 
+void collision_detection::CollisionData::compileAllowedCollisions(const robot_model::RobotModelConstPtr& kmodel)
+{
+  if (acm_)
+    compiled_acm_ = acm_->getCompiled(kmodel);
+  else
+    compiled_acm_.reset();
+}
+
 void collision_detection::FCLObject::registerTo(fcl::BroadPhaseCollisionManager* manager)
 {
   std::vector<fcl::CollisionObject*> collision_objects(collision_objects_.size());
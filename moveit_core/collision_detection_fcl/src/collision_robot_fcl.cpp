@@ -35,10 +35,14 @@
 /* Author: Ioan Sucan */
 
 #include <moveit/collision_detection_fcl/collision_robot_fcl.h>
+#include <boost/bind.hpp>
 
 collision_detection::CollisionRobotFCL::CollisionRobotFCL(const robot_model::RobotModelConstPtr& model, double padding,
                                                           double scale)
   : CollisionRobot(model, padding, scale)
+  , geometry_version_(0)
+  , use_persistent_broadphase_(true)
+  , batch_thread_count_(0)
 {
   const std::vector<const robot_model::LinkModel*>& links = robot_model_->getLinkModelsWithCollisionGeometry();
   std::size_t index;
@@ -66,7 +70,11 @@ collision_detection::CollisionRobotFCL::CollisionRobotFCL(const robot_model::Rob
     }
 }
 
-collision_detection::CollisionRobotFCL::CollisionRobotFCL(const CollisionRobotFCL& other) : CollisionRobot(other)
+collision_detection::CollisionRobotFCL::CollisionRobotFCL(const CollisionRobotFCL& other)
+  : CollisionRobot(other)
+  , geometry_version_(0)
+  , use_persistent_broadphase_(other.use_persistent_broadphase_)
+  , batch_thread_count_(other.batch_thread_count_)
 {
   geoms_ = other.geoms_;
   fcl_objs_ = other.fcl_objs_;
@@ -102,6 +110,14 @@ void collision_detection::CollisionRobotFCL::constructFCLObject(const robot_stat
       fcl_obj.collision_objects_.push_back(FCLCollisionObjectPtr(collObj));
     }
 
+  constructAttachedBodyObjects(state, fcl_obj);
+}
+
+void collision_detection::CollisionRobotFCL::constructAttachedBodyObjects(const robot_state::RobotState& state,
+                                                                          FCLObject& fcl_obj) const
+{
+  fcl::Transform3f fcl_tf;
+
   // TODO: Implement a method for caching fcl::CollisionObject's for robot_state::AttachedBody's
   std::vector<const robot_state::AttachedBody*> ab;
   state.getAttachedBodies(ab);
@@ -134,6 +150,148 @@ void collision_detection::CollisionRobotFCL::allocSelfCollisionBroadPhase(const
   // manager.manager_->update();
 }
 
+bool collision_detection::CollisionRobotFCL::allocContinuousBroadPhase(
+    const robot_state::RobotState& state1, const robot_state::RobotState& state2, FCLManager& manager,
+    std::vector<fcl::Transform3f>& end_transforms) const
+{
+  FCLObject end_object;
+  constructFCLObject(state1, manager.object_);
+  constructFCLObject(state2, end_object);
+  if (manager.object_.collision_objects_.size() != end_object.collision_objects_.size())
+  {
+    logError("Continuous collision checking requires the same bodies to be attached to the robot at both ends of the "
+             "motion");
+    manager.object_.clear();
+    return false;
+  }
+
+  // the pointers into end_transforms are stored as user data, so it must not be resized after this point
+  end_transforms.resize(end_object.collision_objects_.size());
+  for (std::size_t i = 0; i < end_transforms.size(); ++i)
+  {
+    fcl::CollisionObject* obj = manager.object_.collision_objects_[i].get();
+    end_transforms[i] = end_object.collision_objects_[i]->getTransform();
+    obj->setUserData(&end_transforms[i]);
+
+    // each point of the object moves within a sphere around the interpolated origin of the object, so the swept
+    // volume is enclosed by the box around the motion of the origin, inflated by the radius of that sphere
+    const fcl::CollisionGeometry* geom = obj->collisionGeometry().get();
+    const fcl::FCL_REAL r = geom->aabb_center.length() + geom->aabb_radius;
+    const fcl::Vec3f& t1 = obj->getTranslation();
+    const fcl::Vec3f& t2 = end_transforms[i].getTranslation();
+    fcl::AABB swept(t1, t2);
+    swept.min_ -= fcl::Vec3f(r, r, r);
+    swept.max_ += fcl::Vec3f(r, r, r);
+    obj->aabb = swept;
+  }
+
+  manager.manager_.reset(new fcl::DynamicAABBTreeCollisionManager());
+  manager.object_.registerTo(manager.manager_.get());
+  return true;
+}
+
+collision_detection::CollisionRobotFCL::SelfCollisionBroadPhase::SelfCollisionBroadPhase(
+    const CollisionRobotFCL& robot, const robot_state::RobotState& state)
+  : robot_(robot)
+{
+  if (!robot_.use_persistent_broadphase_)
+  {
+    robot_.allocSelfCollisionBroadPhase(state, manager_);
+    return;
+  }
+
+  {
+    boost::mutex::scoped_lock slock(robot_.persistent_broadphases_lock_);
+    if (!robot_.persistent_broadphases_.empty())
+    {
+      persistent_ = std::move(robot_.persistent_broadphases_.back());
+      robot_.persistent_broadphases_.pop_back();
+    }
+  }
+  if (!persistent_)
+  {
+    persistent_.reset(new PersistentBroadPhase());
+    persistent_->geometry_version_ = robot_.geometry_version_ + 1;  // force construction of the link objects
+  }
+  robot_.updatePersistentBroadPhase(state, *persistent_);
+}
+
+collision_detection::CollisionRobotFCL::SelfCollisionBroadPhase::~SelfCollisionBroadPhase()
+{
+  if (!persistent_)
+    return;
+  // the objects of the attached bodies belong to the state that was checked; do not keep them alive
+  if (!persistent_->attached_object_.collision_objects_.empty())
+  {
+    persistent_->attached_object_.unregisterFrom(persistent_->manager_.manager_.get());
+    persistent_->attached_object_.clear();
+  }
+  boost::mutex::scoped_lock slock(robot_.persistent_broadphases_lock_);
+  robot_.persistent_broadphases_.push_back(std::move(persistent_));
+}
+
+void collision_detection::CollisionRobotFCL::updatePersistentBroadPhase(const robot_state::RobotState& state,
+                                                                        PersistentBroadPhase& bp) const
+{
+  fcl::Transform3f fcl_tf;
+
+  if (bp.geometry_version_ != geometry_version_)
+  {
+    // the geometry of the links changed (or was never constructed); build the manager from scratch
+    bp.manager_.manager_.reset(new fcl::DynamicAABBTreeCollisionManager());
+    bp.manager_.object_.clear();
+    bp.attached_object_.clear();
+    bp.link_objects_.assign(geoms_.size(), NULL);
+    bp.link_transforms_.resize(geoms_.size());
+    bp.updated_objects_.reserve(geoms_.size());
+
+    for (std::size_t i = 0; i < geoms_.size(); ++i)
+      if (geoms_[i] && geoms_[i]->collision_geometry_)
+      {
+        const Eigen::Affine3d& t = state.getCollisionBodyTransform(geoms_[i]->collision_geometry_data_->ptr.link,
+                                                                   geoms_[i]->collision_geometry_data_->shape_index);
+        transform2fcl(t, fcl_tf);
+        fcl::CollisionObject* collObj = new fcl::CollisionObject(*fcl_objs_[i]);
+        collObj->setTransform(fcl_tf);
+        collObj->computeAABB();
+        bp.manager_.object_.collision_objects_.push_back(FCLCollisionObjectPtr(collObj));
+        bp.link_objects_[i] = collObj;
+        bp.link_transforms_[i] = t;
+      }
+    bp.manager_.object_.registerTo(bp.manager_.manager_.get());
+    bp.geometry_version_ = geometry_version_;
+  }
+  else
+  {
+    // only refit the bounding volumes of the links that moved since the previous query
+    bp.updated_objects_.clear();
+    for (std::size_t i = 0; i < bp.link_objects_.size(); ++i)
+      if (bp.link_objects_[i])
+      {
+        const Eigen::Affine3d& t = state.getCollisionBodyTransform(geoms_[i]->collision_geometry_data_->ptr.link,
+                                                                   geoms_[i]->collision_geometry_data_->shape_index);
+        if (t.matrix() == bp.link_transforms_[i].matrix())
+          continue;
+        transform2fcl(t, fcl_tf);
+        bp.link_objects_[i]->setTransform(fcl_tf);
+        bp.link_objects_[i]->computeAABB();
+        bp.link_transforms_[i] = t;
+        bp.updated_objects_.push_back(bp.link_objects_[i]);
+      }
+    if (!bp.updated_objects_.empty())
+      bp.manager_.manager_->update(bp.updated_objects_);
+  }
+
+  // attached bodies belong to the state being checked, so their objects are always replaced
+  if (!bp.attached_object_.collision_objects_.empty())
+  {
+    bp.attached_object_.unregisterFrom(bp.manager_.manager_.get());
+    bp.attached_object_.clear();
+  }
+  constructAttachedBodyObjects(state, bp.attached_object_);
+  bp.attached_object_.registerTo(bp.manager_.manager_.get());
+}
+
 void collision_detection::CollisionRobotFCL::checkSelfCollision(const CollisionRequest& req, CollisionResult& res,
                                                                 const robot_state::RobotState& state) const
 {
@@ -151,7 +309,7 @@ void collision_detection::CollisionRobotFCL::checkSelfCollision(const CollisionR
                                                                 const robot_state::RobotState& state1,
                                                                 const robot_state::RobotState& state2) const
 {
-  logError("FCL continuous collision checking not yet implemented");
+  checkSelfCollisionContinuousHelper(req, res, state1, state2, NULL);
 }
 
 void collision_detection::CollisionRobotFCL::checkSelfCollision(const CollisionRequest& req, CollisionResult& res,
@@ -159,20 +317,79 @@ void collision_detection::CollisionRobotFCL::checkSelfCollision(const CollisionR
                                                                 const robot_state::RobotState& state2,
                                                                 const AllowedCollisionMatrix& acm) const
 {
-  logError("FCL continuous collision checking not yet implemented");
+  checkSelfCollisionContinuousHelper(req, res, state1, state2, &acm);
+}
+
+void collision_detection::CollisionRobotFCL::checkSelfCollisionContinuousHelper(const CollisionRequest& req,
+                                                                                CollisionResult& res,
+                                                                                const robot_state::RobotState& state1,
+                                                                                const robot_state::RobotState& state2,
+                                                                                const AllowedCollisionMatrix* acm) const
+{
+  FCLManager manager;
+  std::vector<fcl::Transform3f> end_transforms;
+  if (!allocContinuousBroadPhase(state1, state2, manager, end_transforms))
+  {
+    // without a well defined motion, check the end points of the segment
+    checkSelfCollisionHelper(req, res, state1, acm);
+    if (!res.collision || (req.contacts && res.contact_count < req.max_contacts))
+      checkSelfCollisionHelper(req, res, state2, acm);
+    return;
+  }
+
+  CollisionData cd(&req, &res, acm);
+  cd.enableGroup(getRobotModel());
+  cd.compileAllowedCollisions(getRobotModel());
+  manager.manager_->collide(&cd, &continuousCollisionCallback);
 }
 
 void collision_detection::CollisionRobotFCL::checkSelfCollisionHelper(const CollisionRequest& req, CollisionResult& res,
                                                                       const robot_state::RobotState& state,
                                                                       const AllowedCollisionMatrix* acm) const
 {
-  FCLManager manager;
-  allocSelfCollisionBroadPhase(state, manager);
+  SelfCollisionBroadPhase broadphase(*this, state);
+  FCLManager& manager = broadphase.get();
   CollisionData cd(&req, &res, acm);
   cd.enableGroup(getRobotModel());
+  cd.compileAllowedCollisions(getRobotModel());
   manager.manager_->collide(&cd, &collisionCallback);
   if (req.distance)
-    res.distance = distanceSelfHelper(state, acm);
+    distanceSelfHelper(getDistanceRequest(req), res, state, acm);
+}
+
+std::size_t collision_detection::CollisionRobotFCL::checkSelfCollisionBatch(
+    const CollisionRequest& req, std::vector<CollisionResult>& res,
+    const std::vector<const robot_state::RobotState*>& states, bool stop_at_first_collision) const
+{
+  res.resize(states.size());
+  for (std::size_t i = 0; i < res.size(); ++i)
+    res[i].clear();
+  return processCollisionBatch(states.size(), batch_thread_count_, stop_at_first_collision,
+                               boost::bind(&CollisionRobotFCL::checkSelfCollisionBatchElement, this, boost::cref(req),
+                                           boost::ref(res), boost::cref(states),
+                                           static_cast<const AllowedCollisionMatrix*>(NULL), _1));
+}
+
+std::size_t collision_detection::CollisionRobotFCL::checkSelfCollisionBatch(
+    const CollisionRequest& req, std::vector<CollisionResult>& res,
+    const std::vector<const robot_state::RobotState*>& states, const AllowedCollisionMatrix& acm,
+    bool stop_at_first_collision) const
+{
+  res.resize(states.size());
+  for (std::size_t i = 0; i < res.size(); ++i)
+    res[i].clear();
+  return processCollisionBatch(states.size(), batch_thread_count_, stop_at_first_collision,
+                               boost::bind(&CollisionRobotFCL::checkSelfCollisionBatchElement, this, boost::cref(req),
+                                           boost::ref(res), boost::cref(states), &acm, _1));
+}
+
+bool collision_detection::CollisionRobotFCL::checkSelfCollisionBatchElement(
+    const CollisionRequest& req, std::vector<CollisionResult>& res,
+    const std::vector<const robot_state::RobotState*>& states, const AllowedCollisionMatrix* acm,
+    std::size_t index) const
+{
+  checkSelfCollisionHelper(req, res[index], *states[index], acm);
+  return res[index].collision;
 }
 
 void collision_detection::CollisionRobotFCL::checkOtherCollision(const CollisionRequest& req, CollisionResult& res,
@@ -220,8 +437,8 @@ void collision_detection::CollisionRobotFCL::checkOtherCollisionHelper(const Col
                                                                        const robot_state::RobotState& other_state,
                                                                        const AllowedCollisionMatrix* acm) const
 {
-  FCLManager manager;
-  allocSelfCollisionBroadPhase(state, manager);
+  SelfCollisionBroadPhase broadphase(*this, state);
+  FCLManager& manager = broadphase.get();
 
   const CollisionRobotFCL& fcl_rob = dynamic_cast<const CollisionRobotFCL&>(other_robot);
   FCLObject other_fcl_obj;
@@ -232,7 +449,7 @@ void collision_detection::CollisionRobotFCL::checkOtherCollisionHelper(const Col
   for (std::size_t i = 0; !cd.done_ && i < other_fcl_obj.collision_objects_.size(); ++i)
     manager.manager_->collide(other_fcl_obj.collision_objects_[i].get(), &cd, &collisionCallback);
   if (req.distance)
-    res.distance = distanceOtherHelper(state, other_robot, other_state, acm);
+    distanceOtherHelper(getDistanceRequest(req), res, state, other_robot, other_state, acm);
 }
 
 void collision_detection::CollisionRobotFCL::updatedPaddingOrScaling(const std::vector<std::string>& links)
@@ -258,40 +475,53 @@ void collision_detection::CollisionRobotFCL::updatedPaddingOrScaling(const std::
     else
       logError("Updating padding or scaling for unknown link: '%s'", links[i].c_str());
   }
+  ++geometry_version_;
+
+  // the kept broadphase structures refer to the old geometry
+  boost::mutex::scoped_lock slock(persistent_broadphases_lock_);
+  persistent_broadphases_.clear();
 }
 
 double collision_detection::CollisionRobotFCL::distanceSelf(const robot_state::RobotState& state) const
 {
-  return distanceSelfHelper(state, NULL);
+  CollisionRequest req;
+  CollisionResult res;
+  distanceSelfHelper(req, res, state, NULL);
+  return res.distance;
 }
 
 double collision_detection::CollisionRobotFCL::distanceSelf(const robot_state::RobotState& state,
                                                             const AllowedCollisionMatrix& acm) const
 {
-  return distanceSelfHelper(state, &acm);
+  CollisionRequest req;
+  CollisionResult res;
+  distanceSelfHelper(req, res, state, &acm);
+  return res.distance;
 }
 
-double collision_detection::CollisionRobotFCL::distanceSelfHelper(const robot_state::RobotState& state,
-                                                                  const AllowedCollisionMatrix* acm) const
+void collision_detection::CollisionRobotFCL::distanceSelfHelper(const CollisionRequest& req, CollisionResult& res,
+                                                                const robot_state::RobotState& state,
+                                                                const AllowedCollisionMatrix* acm) const
 {
-  FCLManager manager;
-  allocSelfCollisionBroadPhase(state, manager);
+  SelfCollisionBroadPhase broadphase(*this, state);
+  FCLManager& manager = broadphase.get();
 
-  CollisionRequest req;
-  CollisionResult res;
+  res.distance = std::numeric_limits<double>::max();
   CollisionData cd(&req, &res, acm);
   cd.enableGroup(getRobotModel());
+  cd.compileAllowedCollisions(getRobotModel());
 
   manager.manager_->distance(&cd, &distanceCallback);
-
-  return res.distance;
 }
 
 double collision_detection::CollisionRobotFCL::distanceOther(const robot_state::RobotState& state,
                                                              const CollisionRobot& other_robot,
                                                              const robot_state::RobotState& other_state) const
 {
-  return distanceOtherHelper(state, other_robot, other_state, NULL);
+  CollisionRequest req;
+  CollisionResult res;
+  distanceOtherHelper(req, res, state, other_robot, other_state, NULL);
+  return res.distance;
 }
 
 double collision_detection::CollisionRobotFCL::distanceOther(const robot_state::RobotState& state,
@@ -299,27 +529,28 @@ double collision_detection::CollisionRobotFCL::distanceOther(const robot_state::
                                                              const robot_state::RobotState& other_state,
                                                              const AllowedCollisionMatrix& acm) const
 {
-  return distanceOtherHelper(state, other_robot, other_state, &acm);
+  CollisionRequest req;
+  CollisionResult res;
+  distanceOtherHelper(req, res, state, other_robot, other_state, &acm);
+  return res.distance;
 }
 
-double collision_detection::CollisionRobotFCL::distanceOtherHelper(const robot_state::RobotState& state,
-                                                                   const CollisionRobot& other_robot,
-                                                                   const robot_state::RobotState& other_state,
-                                                                   const AllowedCollisionMatrix* acm) const
+void collision_detection::CollisionRobotFCL::distanceOtherHelper(const CollisionRequest& req, CollisionResult& res,
+                                                                 const robot_state::RobotState& state,
+                                                                 const CollisionRobot& other_robot,
+                                                                 const robot_state::RobotState& other_state,
+                                                                 const AllowedCollisionMatrix* acm) const
 {
-  FCLManager manager;
-  allocSelfCollisionBroadPhase(state, manager);
+  SelfCollisionBroadPhase broadphase(*this, state);
+  FCLManager& manager = broadphase.get();
 
   const CollisionRobotFCL& fcl_rob = dynamic_cast<const CollisionRobotFCL&>(other_robot);
   FCLObject other_fcl_obj;
   fcl_rob.constructFCLObject(other_state, other_fcl_obj);
 
-  CollisionRequest req;
-  CollisionResult res;
+  res.distance = std::numeric_limits<double>::max();
   CollisionData cd(&req, &res, acm);
   cd.enableGroup(getRobotModel());
   for (std::size_t i = 0; !cd.done_ && i < other_fcl_obj.collision_objects_.size(); ++i)
     manager.manager_->distance(other_fcl_obj.collision_objects_[i].get(), &cd, &distanceCallback);
-
-  return res.distance;
 }
@@ -41,7 +41,81 @@
 #include <fcl/collision_node.h>
 #include <boost/bind.hpp>
 
-collision_detection::CollisionWorldFCL::CollisionWorldFCL() : CollisionWorld()
+namespace
+{
+// below this many shadowed objects a layered world never bothers to go back to a single manager
+const std::size_t MIN_FLATTEN_SIZE = 16;
+
+struct LayerFilterData
+{
+  void* data_;
+  const std::set<const fcl::CollisionObject*>* hidden1_;
+  const std::set<const fcl::CollisionObject*>* hidden2_;
+  fcl::CollisionCallBack collision_callback_;
+  fcl::DistanceCallBack distance_callback_;
+};
+
+bool isHidden(const LayerFilterData* fd, fcl::CollisionObject* o1, fcl::CollisionObject* o2)
+{
+  return (fd->hidden1_ && fd->hidden1_->find(o1) != fd->hidden1_->end()) ||
+         (fd->hidden2_ && fd->hidden2_->find(o2) != fd->hidden2_->end());
+}
+
+bool layerCollisionCallback(fcl::CollisionObject* o1, fcl::CollisionObject* o2, void* data)
+{
+  LayerFilterData* fd = reinterpret_cast<LayerFilterData*>(data);
+  if (isHidden(fd, o1, o2))
+    return false;
+  return fd->collision_callback_(o1, o2, fd->data_);
+}
+
+bool layerDistanceCallback(fcl::CollisionObject* o1, fcl::CollisionObject* o2, void* data, double& min_dist)
+{
+  LayerFilterData* fd = reinterpret_cast<LayerFilterData*>(data);
+  if (isHidden(fd, o1, o2))
+    return false;
+  return fd->distance_callback_(o1, o2, fd->data_, min_dist);
+}
+
+// FCL passes the objects of the manager being queried as o1 and those of the argument as o2
+template <typename T>
+void collideFiltered(fcl::BroadPhaseCollisionManager* manager, T* other,
+                     const std::set<const fcl::CollisionObject*>* hidden1,
+                     const std::set<const fcl::CollisionObject*>* hidden2, collision_detection::CollisionData* cd,
+                     fcl::CollisionCallBack callback)
+{
+  if (!hidden1 && !hidden2)
+  {
+    manager->collide(other, cd, callback);
+    return;
+  }
+  LayerFilterData fd = { cd, hidden1, hidden2, callback, NULL };
+  manager->collide(other, &fd, &layerCollisionCallback);
+}
+
+template <typename T>
+void distanceFiltered(fcl::BroadPhaseCollisionManager* manager, T* other,
+                      const std::set<const fcl::CollisionObject*>* hidden1,
+                      const std::set<const fcl::CollisionObject*>* hidden2, collision_detection::CollisionData* cd,
+                      fcl::DistanceCallBack callback)
+{
+  if (!hidden1 && !hidden2)
+  {
+    manager->distance(other, cd, callback);
+    return;
+  }
+  LayerFilterData fd = { cd, hidden1, hidden2, NULL, callback };
+  manager->distance(other, &fd, &layerDistanceCallback);
+}
+}
+
+collision_detection::CollisionWorldFCL::CollisionWorldFCL()
+  : CollisionWorld()
+  , manager_ready_(true)
+  , hidden_count_(0)
+  , fcl_objs_(new FCLObjectMap())
+  , batch_thread_count_(0)
+  , octree_occupancy_filter_(true)
 {
   fcl::DynamicAABBTreeCollisionManager* m = new fcl::DynamicAABBTreeCollisionManager();
   // m->tree_init_level = 2;
@@ -51,7 +125,13 @@ collision_detection::CollisionWorldFCL::CollisionWorldFCL() : CollisionWorld()
   observer_handle_ = getWorld()->addObserver(boost::bind(&CollisionWorldFCL::notifyObjectChange, this, _1, _2));
 }
 
-collision_detection::CollisionWorldFCL::CollisionWorldFCL(const WorldPtr& world) : CollisionWorld(world)
+collision_detection::CollisionWorldFCL::CollisionWorldFCL(const WorldPtr& world)
+  : CollisionWorld(world)
+  , manager_ready_(true)
+  , hidden_count_(0)
+  , fcl_objs_(new FCLObjectMap())
+  , batch_thread_count_(0)
+  , octree_occupancy_filter_(true)
 {
   fcl::DynamicAABBTreeCollisionManager* m = new fcl::DynamicAABBTreeCollisionManager();
   // m->tree_init_level = 2;
@@ -64,15 +144,33 @@ collision_detection::CollisionWorldFCL::CollisionWorldFCL(const WorldPtr& world)
 
 collision_detection::CollisionWorldFCL::CollisionWorldFCL(const CollisionWorldFCL& other, const WorldPtr& world)
   : CollisionWorld(other, world)
+  , manager_ready_(false)
+  , hidden_count_(0)
+  , fcl_objs_(other.fcl_objs_)
+  , batch_thread_count_(other.batch_thread_count_)
+  , octree_occupancy_filter_(other.octree_occupancy_filter_)
 {
+  // the FCL objects are shared with other; they are only registered with our manager on the first query
   fcl::DynamicAABBTreeCollisionManager* m = new fcl::DynamicAABBTreeCollisionManager();
   // m->tree_init_level = 2;
   manager_.reset(m);
 
-  fcl_objs_ = other.fcl_objs_;
-  for (std::map<std::string, FCLObject>::iterator it = fcl_objs_.begin(); it != fcl_objs_.end(); ++it)
-    it->second.registerTo(manager_.get());
-  // manager_->update();
+  // reuse the broadphase tree of other as our base, so our own manager only gets the objects that change here
+  if (other.base_manager_)
+  {
+    base_manager_ = other.base_manager_;
+    base_objs_ = other.base_objs_;
+    hidden_objs_ = other.hidden_objs_;
+    hidden_count_ = other.hidden_count_;
+    overlay_ids_ = other.overlay_ids_;
+  }
+  else
+  {
+    other.getManager();
+    base_manager_ = other.manager_;
+    base_objs_ = other.fcl_objs_;
+    manager_ready_ = true;
+  }
 
   // request notifications about changes to new world
   observer_handle_ = getWorld()->addObserver(boost::bind(&CollisionWorldFCL::notifyObjectChange, this, _1, _2));
@@ -83,6 +181,158 @@ collision_detection::CollisionWorldFCL::~CollisionWorldFCL()
   getWorld()->removeObserver(observer_handle_);
 }
 
+fcl::BroadPhaseCollisionManager* collision_detection::CollisionWorldFCL::getManager() const
+{
+  if (!manager_ready_)
+  {
+    boost::mutex::scoped_lock slock(manager_lock_);
+    if (!manager_ready_)
+    {
+      // register everything in one call, so the manager builds a balanced tree instead of inserting one by one
+      std::vector<fcl::CollisionObject*> collision_objects;
+      if (base_manager_)
+      {
+        for (std::set<std::string>::const_iterator it = overlay_ids_.begin(); it != overlay_ids_.end(); ++it)
+        {
+          const FCLObject& fcl_obj = fcl_objs_->find(*it)->second;
+          for (std::size_t i = 0; i < fcl_obj.collision_objects_.size(); ++i)
+            collision_objects.push_back(fcl_obj.collision_objects_[i].get());
+        }
+      }
+      else
+        for (FCLObjectMap::const_iterator it = fcl_objs_->begin(); it != fcl_objs_->end(); ++it)
+          for (std::size_t i = 0; i < it->second.collision_objects_.size(); ++i)
+            collision_objects.push_back(it->second.collision_objects_[i].get());
+      if (!collision_objects.empty())
+        manager_->registerObjects(collision_objects);
+      manager_ready_ = true;
+    }
+  }
+  return manager_.get();
+}
+
+collision_detection::CollisionWorldFCL::FCLObjectMap& collision_detection::CollisionWorldFCL::getFCLObjectsForWrite()
+{
+  if (!fcl_objs_.unique())
+    fcl_objs_.reset(new FCLObjectMap(*fcl_objs_));
+  return *fcl_objs_;
+}
+
+void collision_detection::CollisionWorldFCL::prepareManagerForWrite()
+{
+  if (base_manager_ || !manager_ready_ || manager_.unique())
+    return;
+
+  // a copy of this world uses manager_ as its base, so leave it as it is and put our changes on top of it
+  base_manager_ = manager_;
+  base_objs_ = fcl_objs_;
+  manager_.reset(new fcl::DynamicAABBTreeCollisionManager());
+}
+
+void collision_detection::CollisionWorldFCL::unregisterFCLObject(const std::string& id, FCLObject& fcl_obj)
+{
+  if (base_manager_ && overlay_ids_.erase(id) == 0)
+  {
+    // the object is part of the base manager, which is not ours to modify
+    for (std::size_t i = 0; i < fcl_obj.collision_objects_.size(); ++i)
+      hidden_objs_.insert(fcl_obj.collision_objects_[i].get());
+    ++hidden_count_;
+  }
+  else if (manager_ready_)
+    fcl_obj.unregisterFrom(manager_.get());
+}
+
+void collision_detection::CollisionWorldFCL::flattenLayersIfNeeded()
+{
+  // all counts are of world objects; a world object can have many FCL objects
+  if (!base_manager_ || hidden_count_ + overlay_ids_.size() <= std::max(MIN_FLATTEN_SIZE, base_objs_->size() / 2))
+    return;
+
+  // querying two managers and skipping many shadowed objects now costs more than rebuilding a single manager
+  base_manager_.reset();
+  base_objs_.reset();
+  hidden_objs_.clear();
+  hidden_count_ = 0;
+  overlay_ids_.clear();
+  manager_.reset(new fcl::DynamicAABBTreeCollisionManager());
+  manager_ready_ = false;
+}
+
+void collision_detection::CollisionWorldFCL::deferManagerUpdateForBatch()
+{
+  if (!manager_ready_ || base_manager_ || !manager_.unique() ||
+      getWorld()->getCommittedChangeCount() <= std::max(MIN_FLATTEN_SIZE, fcl_objs_->size() / 2))
+    return;
+  manager_.reset(new fcl::DynamicAABBTreeCollisionManager());
+  manager_ready_ = false;
+}
+
+template <typename T>
+void collision_detection::CollisionWorldFCL::collideLayers(T* other, const FCLObjectPtrSet* other_hidden,
+                                                           CollisionData* cd, fcl::CollisionCallBack callback) const
+{
+  if (base_manager_)
+  {
+    collideFiltered(base_manager_.get(), other, hidden_objs_.empty() ? NULL : &hidden_objs_, other_hidden, cd,
+                    callback);
+    if (cd->done_)
+      return;
+  }
+  collideFiltered(getManager(), other, NULL, other_hidden, cd, callback);
+}
+
+template <typename T>
+void collision_detection::CollisionWorldFCL::distanceLayers(T* other, const FCLObjectPtrSet* other_hidden,
+                                                            CollisionData* cd, fcl::DistanceCallBack callback) const
+{
+  if (base_manager_)
+  {
+    distanceFiltered(base_manager_.get(), other, hidden_objs_.empty() ? NULL : &hidden_objs_, other_hidden, cd,
+                     callback);
+    if (cd->done_)
+      return;
+  }
+  distanceFiltered(getManager(), other, NULL, other_hidden, cd, callback);
+}
+
+std::size_t collision_detection::CollisionWorldFCL::checkCollisionBatch(
+    const CollisionRequest& req, std::vector<CollisionResult>& res, const CollisionRobot& robot,
+    const std::vector<const robot_state::RobotState*>& states, bool stop_at_first_collision) const
+{
+  res.resize(states.size());
+  for (std::size_t i = 0; i < res.size(); ++i)
+    res[i].clear();
+  return processCollisionBatch(states.size(), batch_thread_count_, stop_at_first_collision,
+                               boost::bind(&CollisionWorldFCL::checkCollisionBatchElement, this, boost::cref(req),
+                                           boost::ref(res), boost::cref(robot), boost::cref(states),
+                                           static_cast<const AllowedCollisionMatrix*>(NULL), _1));
+}
+
+std::size_t collision_detection::CollisionWorldFCL::checkCollisionBatch(
+    const CollisionRequest& req, std::vector<CollisionResult>& res, const CollisionRobot& robot,
+    const std::vector<const robot_state::RobotState*>& states, const AllowedCollisionMatrix& acm,
+    bool stop_at_first_collision) const
+{
+  res.resize(states.size());
+  for (std::size_t i = 0; i < res.size(); ++i)
+    res[i].clear();
+  return processCollisionBatch(states.size(), batch_thread_count_, stop_at_first_collision,
+                               boost::bind(&CollisionWorldFCL::checkCollisionBatchElement, this, boost::cref(req),
+                                           boost::ref(res), boost::cref(robot), boost::cref(states), &acm, _1));
+}
+
+bool collision_detection::CollisionWorldFCL::checkCollisionBatchElement(
+    const CollisionRequest& req, std::vector<CollisionResult>& res, const CollisionRobot& robot,
+    const std::vector<const robot_state::RobotState*>& states, const AllowedCollisionMatrix* acm,
+    std::size_t index) const
+{
+  if (acm)
+    checkCollision(req, res[index], robot, *states[index], *acm);
+  else
+    checkCollision(req, res[index], robot, *states[index]);
+  return res[index].collision;
+}
+
 void collision_detection::CollisionWorldFCL::checkRobotCollision(const CollisionRequest& req, CollisionResult& res,
                                                                  const CollisionRobot& robot,
                                                                  const robot_state::RobotState& state) const
@@ -103,7 +353,7 @@ void collision_detection::CollisionWorldFCL::checkRobotCollision(const Collision
                                                                  const robot_state::RobotState& state1,
                                                                  const robot_state::RobotState& state2) const
 {
-  logError("FCL continuous collision checking not yet implemented");
+  checkRobotCollisionContinuousHelper(req, res, robot, state1, state2, NULL);
 }
 
 void collision_detection::CollisionWorldFCL::checkRobotCollision(const CollisionRequest& req, CollisionResult& res,
@@ -112,7 +362,30 @@ void collision_detection::CollisionWorldFCL::checkRobotCollision(const Collision
                                                                  const robot_state::RobotState& state2,
                                                                  const AllowedCollisionMatrix& acm) const
 {
-  logError("FCL continuous collision checking not yet implemented");
+  checkRobotCollisionContinuousHelper(req, res, robot, state1, state2, &acm);
+}
+
+void collision_detection::CollisionWorldFCL::checkRobotCollisionContinuousHelper(
+    const CollisionRequest& req, CollisionResult& res, const CollisionRobot& robot,
+    const robot_state::RobotState& state1, const robot_state::RobotState& state2,
+    const AllowedCollisionMatrix* acm) const
+{
+  const CollisionRobotFCL& robot_fcl = dynamic_cast<const CollisionRobotFCL&>(robot);
+  FCLManager robot_manager;
+  std::vector<fcl::Transform3f> end_transforms;
+  if (!robot_fcl.allocContinuousBroadPhase(state1, state2, robot_manager, end_transforms))
+  {
+    // without a well defined motion, check the end points of the segment
+    checkRobotCollisionHelper(req, res, robot, state1, acm);
+    if (!res.collision || (req.contacts && res.contact_count < req.max_contacts))
+      checkRobotCollisionHelper(req, res, robot, state2, acm);
+    return;
+  }
+
+  CollisionData cd(&req, &res, acm);
+  cd.enableGroup(robot.getRobotModel());
+  cd.compileAllowedCollisions(robot.getRobotModel());
+  collideLayers(robot_manager.manager_.get(), NULL, &cd, &continuousCollisionCallback);
 }
 
 void collision_detection::CollisionWorldFCL::checkRobotCollisionHelper(const CollisionRequest& req,
@@ -122,16 +395,27 @@ void collision_detection::CollisionWorldFCL::checkRobotCollisionHelper(const Col
                                                                        const AllowedCollisionMatrix* acm) const
 {
   const CollisionRobotFCL& robot_fcl = dynamic_cast<const CollisionRobotFCL&>(robot);
-  FCLObject fcl_obj;
-  robot_fcl.constructFCLObject(state, fcl_obj);
-
   CollisionData cd(&req, &res, acm);
   cd.enableGroup(robot.getRobotModel());
-  for (std::size_t i = 0; !cd.done_ && i < fcl_obj.collision_objects_.size(); ++i)
-    manager_->collide(fcl_obj.collision_objects_[i].get(), &cd, &collisionCallback);
+  cd.compileAllowedCollisions(robot.getRobotModel());
+  cd.octree_occupancy_filter_ = octree_occupancy_filter_;
+
+  if (robot_fcl.getUsePersistentBroadPhase())
+  {
+    // the broadphase structure of the robot is kept by the robot anyway; collide it with the world as a whole
+    CollisionRobotFCL::SelfCollisionBroadPhase robot_broadphase(robot_fcl, state);
+    collideLayers(robot_broadphase.get().manager_.get(), NULL, &cd, &collisionCallback);
+  }
+  else
+  {
+    FCLObject fcl_obj;
+    robot_fcl.constructFCLObject(state, fcl_obj);
+    for (std::size_t i = 0; !cd.done_ && i < fcl_obj.collision_objects_.size(); ++i)
+      collideLayers(fcl_obj.collision_objects_[i].get(), NULL, &cd, &collisionCallback);
+  }
 
   if (req.distance)
-    res.distance = distanceRobotHelper(robot, state, acm, req.verbose);
+    distanceRobotHelper(getDistanceRequest(req), res, robot, state, acm);
 }
 
 void collision_detection::CollisionWorldFCL::checkWorldCollision(const CollisionRequest& req, CollisionResult& res,
@@ -154,10 +438,15 @@ void collision_detection::CollisionWorldFCL::checkWorldCollisionHelper(const Col
 {
   const CollisionWorldFCL& other_fcl_world = dynamic_cast<const CollisionWorldFCL&>(other_world);
   CollisionData cd(&req, &res, acm);
-  manager_->collide(other_fcl_world.manager_.get(), &cd, &collisionCallback);
+  if (other_fcl_world.base_manager_)
+    collideLayers(other_fcl_world.base_manager_.get(),
+                  other_fcl_world.hidden_objs_.empty() ? NULL : &other_fcl_world.hidden_objs_, &cd,
+                  &collisionCallback);
+  if (!cd.done_)
+    collideLayers(other_fcl_world.getManager(), NULL, &cd, &collisionCallback);
 
   if (req.distance)
-    res.distance = distanceWorldHelper(other_world, acm);
+    distanceWorldHelper(getDistanceRequest(req), res, other_world, acm);
 }
 
 void collision_detection::CollisionWorldFCL::constructFCLObject(const World::Object* obj, FCLObject& fcl_obj) const
@@ -176,11 +465,16 @@ void collision_detection::CollisionWorldFCL::constructFCLObject(const World::Obj
 
 void collision_detection::CollisionWorldFCL::updateFCLObject(const std::string& id)
 {
+  // if the manager has not been filled in yet, it will pick up the updated objects when it is
+  prepareManagerForWrite();
+  FCLObjectMap& fcl_objs = getFCLObjectsForWrite();
+  bool manager_ready = manager_ready_;
+
   // remove FCL objects that correspond to this object
-  std::map<std::string, FCLObject>::iterator jt = fcl_objs_.find(id);
-  if (jt != fcl_objs_.end())
+  FCLObjectMap::iterator jt = fcl_objs.find(id);
+  if (jt != fcl_objs.end())
   {
-    jt->second.unregisterFrom(manager_.get());
+    unregisterFCLObject(id, jt->second);
     jt->second.clear();
   }
 
@@ -189,22 +483,20 @@ void collision_detection::CollisionWorldFCL::updateFCLObject(const std::string&
   if (it != getWorld()->end())
   {
     // construct FCL objects that correspond to this object
-    if (jt != fcl_objs_.end())
-    {
-      constructFCLObject(it->second.get(), jt->second);
+    if (jt == fcl_objs.end())
+      jt = fcl_objs.insert(std::make_pair(id, FCLObject())).first;
+    constructFCLObject(it->second.get(), jt->second);
+    if (base_manager_)
+      overlay_ids_.insert(id);
+    if (manager_ready)
       jt->second.registerTo(manager_.get());
-    }
-    else
-    {
-      constructFCLObject(it->second.get(), fcl_objs_[id]);
-      fcl_objs_[id].registerTo(manager_.get());
-    }
   }
   else
   {
-    if (jt != fcl_objs_.end())
-      fcl_objs_.erase(jt);
+    if (jt != fcl_objs.end())
+      fcl_objs.erase(jt);
   }
+  flattenLayersIfNeeded();
 
   // manager_->update();
 }
@@ -217,9 +509,15 @@ void collision_detection::CollisionWorldFCL::setWorld(const WorldPtr& world)
   // turn off notifications about old world
   getWorld()->removeObserver(observer_handle_);
 
-  // clear out objects from old world
-  manager_->clear();
-  fcl_objs_.clear();
+  // clear out objects from old world; the manager may be the base of a copy, so it is replaced rather than cleared
+  manager_.reset(new fcl::DynamicAABBTreeCollisionManager());
+  manager_ready_ = true;
+  base_manager_.reset();
+  base_objs_.reset();
+  hidden_objs_.clear();
+  hidden_count_ = 0;
+  overlay_ids_.clear();
+  fcl_objs_.reset(new FCLObjectMap());
   cleanCollisionGeometryCache();
 
   CollisionWorld::setWorld(world);
@@ -233,14 +531,18 @@ void collision_detection::CollisionWorldFCL::setWorld(const WorldPtr& world)
 
 void collision_detection::CollisionWorldFCL::notifyObjectChange(const ObjectConstPtr& obj, World::Action action)
 {
+  deferManagerUpdateForBatch();
   if (action == World::DESTROY)
   {
-    std::map<std::string, FCLObject>::iterator it = fcl_objs_.find(obj->id_);
-    if (it != fcl_objs_.end())
+    if (fcl_objs_->find(obj->id_) != fcl_objs_->end())
     {
-      it->second.unregisterFrom(manager_.get());
+      prepareManagerForWrite();
+      FCLObjectMap& fcl_objs = getFCLObjectsForWrite();
+      FCLObjectMap::iterator it = fcl_objs.find(obj->id_);
+      unregisterFCLObject(obj->id_, it->second);
       it->second.clear();
-      fcl_objs_.erase(it);
+      fcl_objs.erase(it);
+      flattenLayersIfNeeded();
     }
     cleanCollisionGeometryCache();
   }
@@ -252,63 +554,85 @@ void collision_detection::CollisionWorldFCL::notifyObjectChange(const ObjectCons
   }
 }
 
-double collision_detection::CollisionWorldFCL::distanceRobotHelper(const CollisionRobot& robot,
-                                                                   const robot_state::RobotState& state,
-                                                                   const AllowedCollisionMatrix* acm,
-                                                                   bool verbose) const
+void collision_detection::CollisionWorldFCL::distanceRobotHelper(const CollisionRequest& req, CollisionResult& res,
+                                                                 const CollisionRobot& robot,
+                                                                 const robot_state::RobotState& state,
+                                                                 const AllowedCollisionMatrix* acm) const
 {
   const CollisionRobotFCL& robot_fcl = dynamic_cast<const CollisionRobotFCL&>(robot);
-  FCLObject fcl_obj;
-  robot_fcl.constructFCLObject(state, fcl_obj);
 
-  CollisionRequest req;
-  req.verbose = verbose;
-  CollisionResult res;
+  res.distance = std::numeric_limits<double>::max();
   CollisionData cd(&req, &res, acm);
   cd.enableGroup(robot.getRobotModel());
+  cd.compileAllowedCollisions(robot.getRobotModel());
 
-  for (std::size_t i = 0; !cd.done_ && i < fcl_obj.collision_objects_.size(); ++i)
-    manager_->distance(fcl_obj.collision_objects_[i].get(), &cd, &distanceCallback);
-
-  return res.distance;
+  if (robot_fcl.getUsePersistentBroadPhase())
+  {
+    CollisionRobotFCL::SelfCollisionBroadPhase robot_broadphase(robot_fcl, state);
+    distanceLayers(robot_broadphase.get().manager_.get(), NULL, &cd, &distanceCallback);
+  }
+  else
+  {
+    FCLObject fcl_obj;
+    robot_fcl.constructFCLObject(state, fcl_obj);
+    for (std::size_t i = 0; !cd.done_ && i < fcl_obj.collision_objects_.size(); ++i)
+      distanceLayers(fcl_obj.collision_objects_[i].get(), NULL, &cd, &distanceCallback);
+  }
 }
 
 double collision_detection::CollisionWorldFCL::distanceRobot(const CollisionRobot& robot,
                                                              const robot_state::RobotState& state, bool verbose) const
 {
-  return distanceRobotHelper(robot, state, NULL, verbose);
+  CollisionRequest req;
+  req.verbose = verbose;
+  CollisionResult res;
+  distanceRobotHelper(req, res, robot, state, NULL);
+  return res.distance;
 }
 
 double collision_detection::CollisionWorldFCL::distanceRobot(const CollisionRobot& robot,
                                                              const robot_state::RobotState& state,
                                                              const AllowedCollisionMatrix& acm, bool verbose) const
 {
-  return distanceRobotHelper(robot, state, &acm, verbose);
+  CollisionRequest req;
+  req.verbose = verbose;
+  CollisionResult res;
+  distanceRobotHelper(req, res, robot, state, &acm);
+  return res.distance;
 }
 
 double collision_detection::CollisionWorldFCL::distanceWorld(const CollisionWorld& world, bool verbose) const
 {
-  return distanceWorldHelper(world, NULL, verbose);
+  CollisionRequest req;
+  req.verbose = verbose;
+  CollisionResult res;
+  distanceWorldHelper(req, res, world, NULL);
+  return res.distance;
 }
 
 double collision_detection::CollisionWorldFCL::distanceWorld(const CollisionWorld& world,
                                                              const AllowedCollisionMatrix& acm, bool verbose) const
 {
-  return distanceWorldHelper(world, &acm, verbose);
+  CollisionRequest req;
+  req.verbose = verbose;
+  CollisionResult res;
+  distanceWorldHelper(req, res, world, &acm);
+  return res.distance;
 }
 
-double collision_detection::CollisionWorldFCL::distanceWorldHelper(const CollisionWorld& other_world,
-                                                                   const AllowedCollisionMatrix* acm,
-                                                                   bool verbose) const
+void collision_detection::CollisionWorldFCL::distanceWorldHelper(const CollisionRequest& req, CollisionResult& res,
+                                                                 const CollisionWorld& other_world,
+                                                                 const AllowedCollisionMatrix* acm) const
 {
   const CollisionWorldFCL& other_fcl_world = dynamic_cast<const CollisionWorldFCL&>(other_world);
-  CollisionRequest req;
-  req.verbose = verbose;
-  CollisionResult res;
+  res.distance = std::numeric_limits<double>::max();
   CollisionData cd(&req, &res, acm);
-  manager_->distance(other_fcl_world.manager_.get(), &cd, &distanceCallback);
-
-  return res.distance;
+  if (other_fcl_world.base_manager_)
+    distanceLayers(other_fcl_world.base_manager_.get(),
+                   other_fcl_world.hidden_objs_.empty() ? NULL : &other_fcl_world.hidden_objs_, &cd,
+                   &distanceCallback);
+  if (!cd.done_)
+    distanceLayers(other_fcl_world.getManager(), NULL, &cd, &distanceCallback);
 }
 
 #include <moveit/collision_detection_fcl/collision_detector_allocator_fcl.h>
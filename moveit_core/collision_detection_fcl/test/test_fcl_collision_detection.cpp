@@ -42,6 +42,7 @@
 
 #include <urdf_parser/urdf_parser.h>
 #include <geometric_shapes/shape_operations.h>
+#include <octomap/octomap.h>
 
 #include <gtest/gtest.h>
 #include <sstream>
@@ -230,6 +231,99 @@ TEST_F(FclCollisionDetectionTester, ContactReporting)
   EXPECT_LE(res.contact_count, 10);
 }
 
+TEST_F(FclCollisionDetectionTester, FlatContactReporting)
+{
+  collision_detection::CollisionRequest req;
+  req.contacts = true;
+  req.max_contacts = 10;
+  req.max_contacts_per_pair = 2;
+
+  robot_state::RobotState kstate(kmodel_);
+  kstate.setToDefaultValues();
+  kstate.update();
+
+  Eigen::Affine3d offset = Eigen::Affine3d::Identity();
+  offset.translation().x() = .01;
+  kstate.updateStateWithLinkAt("base_link", Eigen::Affine3d::Identity());
+  kstate.updateStateWithLinkAt("base_bellow_link", offset);
+  kstate.updateStateWithLinkAt("r_gripper_palm_link", Eigen::Affine3d::Identity());
+  kstate.updateStateWithLinkAt("l_gripper_palm_link", offset);
+  kstate.update();
+
+  acm_->setEntry("base_link", "base_bellow_link", false);
+  acm_->setEntry("r_gripper_palm_link", "l_gripper_palm_link", false);
+
+  collision_detection::CollisionResult res;
+  crobot_->checkSelfCollision(req, res, kstate, *acm_);
+  ASSERT_TRUE(res.collision);
+
+  req.flat_contacts = true;
+  collision_detection::CollisionResult flat_res;
+  flat_res.reserveFlatContacts(req.max_contacts);
+  crobot_->checkSelfCollision(req, flat_res, kstate, *acm_);
+  ASSERT_TRUE(flat_res.collision);
+  EXPECT_TRUE(flat_res.contacts.empty());
+  EXPECT_EQ(res.contact_count, flat_res.contact_count);
+  EXPECT_EQ(flat_res.contact_count, flat_res.flat_contacts.size());
+
+  // resolving the names gives back the same pairs as the contact map
+  collision_detection::CollisionResult::ContactMap resolved;
+  flat_res.getFlatContacts(resolved);
+  ASSERT_EQ(res.contacts.size(), resolved.size());
+  for (collision_detection::CollisionResult::ContactMap::const_iterator it = res.contacts.begin();
+       it != res.contacts.end(); ++it)
+  {
+    ASSERT_TRUE(resolved.find(it->first) != resolved.end());
+    EXPECT_EQ(it->second.size(), resolved[it->first].size());
+  }
+
+  // clearing keeps the buffer and the body ids for the next query
+  const std::size_t capacity = flat_res.flat_contacts.capacity();
+  const std::size_t body_count = flat_res.body_names.size();
+  flat_res.clear();
+  EXPECT_TRUE(flat_res.flat_contacts.empty());
+  EXPECT_EQ(capacity, flat_res.flat_contacts.capacity());
+  crobot_->checkSelfCollision(req, flat_res, kstate, *acm_);
+  EXPECT_EQ(res.contact_count, flat_res.contact_count);
+  EXPECT_EQ(body_count, flat_res.body_names.size());
+}
+
+TEST_F(FclCollisionDetectionTester, OctreeOccupancyFilter)
+{
+  collision_detection::CollisionRequest req;
+  robot_state::RobotState kstate(kmodel_);
+  kstate.setToDefaultValues();
+  kstate.update();
+
+  // the occupied cells are away from the robot, except for one the gripper is moved to
+  std::shared_ptr<octomap::OcTree> tree(new octomap::OcTree(0.02));
+  for (int i = 0; i < 50; ++i)
+    tree->updateNode(octomap::point3d(-3.0 + 0.02 * i, 2.0, 0.5), true);
+  tree->updateNode(octomap::point3d(5.0, 0.0, 1.0), true);
+  cworld_->getWorld()->addToObject("octree", shapes::ShapeConstPtr(new shapes::OcTree(tree)),
+                                   Eigen::Affine3d::Identity());
+
+  collision_detection::CollisionWorldFCL& cworld = static_cast<collision_detection::CollisionWorldFCL&>(*cworld_);
+  for (int filter = 0; filter < 2; ++filter)
+  {
+    cworld.setOctreeOccupancyFilter(filter == 1);
+
+    Eigen::Affine3d pos = Eigen::Affine3d::Identity();
+    kstate.updateStateWithLinkAt("r_gripper_palm_link", pos);
+    kstate.update();
+    collision_detection::CollisionResult res;
+    cworld_->checkRobotCollision(req, res, *crobot_, kstate, *acm_);
+    EXPECT_FALSE(res.collision);
+
+    pos.translation() = Eigen::Vector3d(5.0, 0.0, 1.0);
+    kstate.updateStateWithLinkAt("r_gripper_palm_link", pos);
+    kstate.update();
+    res.clear();
+    cworld_->checkRobotCollision(req, res, *crobot_, kstate, *acm_);
+    EXPECT_TRUE(res.collision);
+  }
+}
+
 TEST_F(FclCollisionDetectionTester, ContactPositions)
 {
   collision_detection::CollisionRequest req;
@@ -367,6 +461,247 @@ TEST_F(FclCollisionDetectionTester, AttachedBodyTester)
   ASSERT_TRUE(res.collision);
 }
 
+TEST_F(FclCollisionDetectionTester, PersistentBroadPhase)
+{
+  collision_detection::CollisionRobotFCL* fcl_robot =
+      dynamic_cast<collision_detection::CollisionRobotFCL*>(crobot_.get());
+  ASSERT_TRUE(fcl_robot != NULL);
+  collision_detection::CollisionRobotFCL rebuilding_robot(*fcl_robot);
+  rebuilding_robot.setUsePersistentBroadPhase(false);
+  EXPECT_TRUE(fcl_robot->getUsePersistentBroadPhase());
+
+  robot_state::RobotState kstate(kmodel_);
+  kstate.setToDefaultValues();
+  kstate.update();
+
+  collision_detection::CollisionRequest req;
+  req.distance = true;
+  for (int i = 0; i < 50; ++i)
+  {
+    // alternate between states in and out of collision, so the refit broadphase is exercised in both directions
+    if (i % 5 == 0)
+      kstate.setToDefaultValues();
+    else
+      kstate.setToRandomPositions();
+    kstate.update();
+
+    collision_detection::CollisionResult res1, res2;
+    fcl_robot->checkSelfCollision(req, res1, kstate, *acm_);
+    rebuilding_robot.checkSelfCollision(req, res2, kstate, *acm_);
+    EXPECT_EQ(res1.collision, res2.collision);
+    EXPECT_NEAR(res1.distance, res2.distance, 1e-6);
+  }
+
+  // attaching a body must be picked up by the persistent structure as well
+  Eigen::Affine3d offset = Eigen::Affine3d::Identity();
+  kstate.setToDefaultValues();
+  kstate.updateStateWithLinkAt("r_gripper_palm_link", offset);
+  std::vector<shapes::ShapeConstPtr> shapes(1, shapes::ShapeConstPtr(new shapes::Box(.1, .1, .1)));
+  EigenSTL::vector_Affine3d poses(1, Eigen::Affine3d::Identity());
+  kstate.attachBody("box", shapes, poses, std::vector<std::string>(), "r_gripper_palm_link");
+  kstate.update();
+
+  collision_detection::CollisionRequest req2;
+  collision_detection::CollisionResult res;
+  crobot_->checkSelfCollision(req2, res, kstate, *acm_);
+  EXPECT_TRUE(res.collision);
+
+  kstate.clearAttachedBody("box");
+  kstate.update();
+  collision_detection::CollisionResult res3;
+  crobot_->checkSelfCollision(req2, res3, kstate, *acm_);
+  collision_detection::CollisionResult res4;
+  rebuilding_robot.checkSelfCollision(req2, res4, kstate, *acm_);
+  EXPECT_EQ(res3.collision, res4.collision);
+
+  // the structures kept from earlier queries must not be reused with the old geometry after the padding changes
+  fcl_robot->setPadding(0.05);
+  rebuilding_robot.setPadding(0.05);
+  collision_detection::CollisionResult res5, res6;
+  fcl_robot->checkSelfCollision(req, res5, kstate, *acm_);
+  rebuilding_robot.checkSelfCollision(req, res6, kstate, *acm_);
+  EXPECT_EQ(res5.collision, res6.collision);
+  EXPECT_NEAR(res5.distance, res6.distance, 1e-6);
+}
+
+TEST_F(FclCollisionDetectionTester, CollisionBatch)
+{
+  robot_state::RobotState free_state(kmodel_);
+  free_state.setToDefaultValues();
+  free_state.update();
+
+  robot_state::RobotState colliding_state(free_state);
+  Eigen::Affine3d offset = Eigen::Affine3d::Identity();
+  offset.translation().x() = .01;
+  colliding_state.updateStateWithLinkAt("base_link", Eigen::Affine3d::Identity());
+  colliding_state.updateStateWithLinkAt("base_bellow_link", offset);
+  colliding_state.update();
+  acm_->setEntry("base_link", "base_bellow_link", false);
+
+  std::vector<const robot_state::RobotState*> states(100, &free_state);
+  states[70] = &colliding_state;
+  states[90] = &colliding_state;
+
+  collision_detection::CollisionRequest req;
+  std::vector<collision_detection::CollisionResult> res;
+  EXPECT_EQ(70u, crobot_->checkSelfCollisionBatch(req, res, states, *acm_));
+  ASSERT_EQ(states.size(), res.size());
+  EXPECT_TRUE(res[70].collision);
+  for (std::size_t i = 0; i < 70; ++i)
+    EXPECT_FALSE(res[i].collision);
+
+  // without early exit every state is checked
+  EXPECT_EQ(70u, cworld_->checkCollisionBatch(req, res, *crobot_, states, *acm_, false));
+  EXPECT_TRUE(res[70].collision);
+  EXPECT_TRUE(res[90].collision);
+  EXPECT_FALSE(res[80].collision);
+
+  // the whole batch is free once the pair is allowed, and results are reset between calls
+  acm_->setEntry("base_link", "base_bellow_link", true);
+  EXPECT_EQ(states.size(), cworld_->checkCollisionBatch(req, res, *crobot_, states, *acm_));
+  for (std::size_t i = 0; i < res.size(); ++i)
+    EXPECT_FALSE(res[i].collision);
+}
+
+TEST_F(FclCollisionDetectionTester, CompiledAllowedCollisionMatrix)
+{
+  acm_->setEntry("base_link", "base_bellow_link", false);
+  acm_->setEntry("base_link", "box", true);
+  acm_->setDefaultEntry("kinect", false);
+
+  collision_detection::CompiledAllowedCollisionMatrixConstPtr compiled = acm_->getCompiled(kmodel_);
+  ASSERT_TRUE(compiled);
+  EXPECT_TRUE(compiled == acm_->getCompiled(kmodel_));
+
+  std::vector<std::string> names = kmodel_->getLinkModelNames();
+  names.push_back("box");
+  names.push_back("kinect");
+  names.push_back("unknown_object");
+  for (std::size_t i = 0; i < names.size(); ++i)
+    for (std::size_t j = 0; j < names.size(); ++j)
+    {
+      collision_detection::AllowedCollision::Type expected = collision_detection::AllowedCollision::CONDITIONAL;
+      collision_detection::AllowedCollision::Type actual = collision_detection::AllowedCollision::CONDITIONAL;
+      bool expected_found = acm_->getAllowedCollision(names[i], names[j], expected);
+      bool actual_found =
+          compiled->getAllowedCollision(compiled->getIndex(names[i]), compiled->getIndex(names[j]), actual);
+      ASSERT_EQ(expected_found, actual_found) << names[i] << " " << names[j];
+      if (expected_found)
+        EXPECT_EQ(expected, actual) << names[i] << " " << names[j];
+    }
+
+  // modifying the matrix invalidates the compiled form
+  acm_->setEntry("base_link", "base_bellow_link", true);
+  collision_detection::CompiledAllowedCollisionMatrixConstPtr recompiled = acm_->getCompiled(kmodel_);
+  EXPECT_TRUE(compiled != recompiled);
+  collision_detection::AllowedCollision::Type type;
+  ASSERT_TRUE(recompiled->getAllowedCollision(recompiled->getIndex(kmodel_->getLinkModel("base_link")),
+                                              recompiled->getIndex(kmodel_->getLinkModel("base_bellow_link")), type));
+  EXPECT_EQ(collision_detection::AllowedCollision::ALWAYS, type);
+}
+
+TEST_F(FclCollisionDetectionTester, CollisionGeometryCache)
+{
+  shapes::ShapeConstPtr shape(new shapes::Box(.1, .1, .1));
+  const robot_model::LinkModel* link = kmodel_->getLinkModel("base_link");
+
+  collision_detection::CollisionGeometryCacheStatistics before =
+      collision_detection::getCollisionGeometryCacheStatistics();
+  collision_detection::FCLGeometryConstPtr g1 = collision_detection::createCollisionGeometry(shape, link, 0);
+  collision_detection::FCLGeometryConstPtr g2 = collision_detection::createCollisionGeometry(shape, link, 0);
+  collision_detection::CollisionGeometryCacheStatistics after =
+      collision_detection::getCollisionGeometryCacheStatistics();
+
+  ASSERT_TRUE(g1);
+  EXPECT_EQ(g1, g2);
+  EXPECT_EQ(before.misses + 1, after.misses);
+  EXPECT_EQ(before.hits + 1, after.hits);
+}
+
+TEST_F(FclCollisionDetectionTester, PaddedCollisionGeometryCache)
+{
+  shapes::ShapeConstPtr shape(shapes::createMeshFromResource(kinect_dae_resource_));
+  ASSERT_TRUE(shape);
+  const robot_model::LinkModel* link = kmodel_->getLinkModel("base_link");
+
+  // going back to a padding used before reuses the padded geometry instead of rebuilding it
+  collision_detection::FCLGeometryConstPtr g1 = collision_detection::createCollisionGeometry(shape, 1.0, 0.1, link, 0);
+  collision_detection::FCLGeometryConstPtr g2 = collision_detection::createCollisionGeometry(shape, 1.0, 0.2, link, 0);
+  collision_detection::CollisionGeometryCacheStatistics before =
+      collision_detection::getCollisionGeometryCacheStatistics();
+  collision_detection::FCLGeometryConstPtr g3 = collision_detection::createCollisionGeometry(shape, 1.0, 0.1, link, 0);
+  collision_detection::CollisionGeometryCacheStatistics after =
+      collision_detection::getCollisionGeometryCacheStatistics();
+
+  ASSERT_TRUE(g1);
+  ASSERT_TRUE(g2);
+  EXPECT_NE(g1, g2);
+  EXPECT_EQ(g1, g3);
+  EXPECT_EQ(before.misses, after.misses);
+  EXPECT_EQ(before.hits + 1, after.hits);
+}
+
+TEST_F(FclCollisionDetectionTester, CollisionGeometryCopy)
+{
+  shapes::ShapeConstPtr shape(shapes::createMeshFromResource(kinect_dae_resource_));
+  ASSERT_TRUE(shape);
+  collision_detection::World::Object world_object("object");
+  robot_state::AttachedBody* attached_body = NULL;
+
+  // while the geometry of the world object is in use, the geometry of the attached body is copied from it
+  collision_detection::FCLGeometryConstPtr g1 = collision_detection::createCollisionGeometry(shape, &world_object);
+  collision_detection::CollisionGeometryCacheStatistics before =
+      collision_detection::getCollisionGeometryCacheStatistics();
+  collision_detection::FCLGeometryConstPtr g2 = collision_detection::createCollisionGeometry(shape, attached_body, 0);
+  collision_detection::CollisionGeometryCacheStatistics after =
+      collision_detection::getCollisionGeometryCacheStatistics();
+
+  ASSERT_TRUE(g1);
+  ASSERT_TRUE(g2);
+  EXPECT_NE(g1->collision_geometry_, g2->collision_geometry_);
+  EXPECT_EQ(before.copies + 1, after.copies);
+  EXPECT_EQ(before.misses, after.misses);
+  EXPECT_EQ(g1->collision_geometry_->getNodeType(), g2->collision_geometry_->getNodeType());
+  EXPECT_EQ(collision_detection::BodyTypes::WORLD_OBJECT, g1->collision_geometry_data_->type);
+  EXPECT_EQ(collision_detection::BodyTypes::ROBOT_ATTACHED, g2->collision_geometry_data_->type);
+}
+
+TEST_F(FclCollisionDetectionTester, BoundedDistance)
+{
+  robot_state::RobotState kstate(kmodel_);
+  kstate.setToDefaultValues();
+  kstate.update();
+
+  double exact = crobot_->distanceSelf(kstate, *acm_);
+  ASSERT_GT(exact, 0.0);
+
+  collision_detection::CollisionRequest req;
+  req.distance = true;
+  collision_detection::CollisionResult res;
+
+  // the cutoff is below the actual distance, so only the bound is known
+  req.max_distance = exact / 2.0;
+  crobot_->checkSelfCollision(req, res, kstate, *acm_);
+  EXPECT_GE(res.distance, req.max_distance);
+
+  // the cutoff is above the actual distance, so the distance is exact
+  res.clear();
+  req.max_distance = exact * 2.0;
+  req.pair_distances = true;
+  crobot_->checkSelfCollision(req, res, kstate, *acm_);
+  EXPECT_NEAR(res.distance, exact, 1e-6);
+  ASSERT_FALSE(res.pair_distances.empty());
+
+  double closest = std::numeric_limits<double>::max();
+  for (collision_detection::CollisionResult::DistanceMap::const_iterator it = res.pair_distances.begin();
+       it != res.pair_distances.end(); ++it)
+  {
+    EXPECT_LT(it->second, req.max_distance);
+    closest = std::min(closest, it->second);
+  }
+  EXPECT_NEAR(closest, exact, 1e-6);
+}
+
 TEST_F(FclCollisionDetectionTester, DiffSceneTester)
 {
   robot_state::RobotState kstate(kmodel_);
@@ -576,6 +911,63 @@ TEST_F(FclCollisionDetectionTester, TestChangingShapeSize)
   }
 }
 
+TEST_F(FclCollisionDetectionTester, LayeredWorldCopies)
+{
+  collision_detection::CollisionRequest req;
+  collision_detection::CollisionResult res;
+
+  robot_state::RobotState kstate(kmodel_);
+  kstate.setToDefaultValues();
+  Eigen::Affine3d pos1 = Eigen::Affine3d::Identity();
+  pos1.translation().x() = 5.0;
+  kstate.updateStateWithLinkAt("r_gripper_palm_link", pos1);
+  kstate.update();
+
+  Eigen::Affine3d far_away = Eigen::Affine3d::Identity();
+  far_away.translation().x() = 50.0;
+  cworld_->getWorld()->addToObject("box", shapes::ShapeConstPtr(new shapes::Box(.1, .1, .1)), pos1);
+  cworld_->getWorld()->addToObject("far", shapes::ShapeConstPtr(new shapes::Box(.1, .1, .1)), far_away);
+  cworld_->checkRobotCollision(req, res, *crobot_, kstate);
+  ASSERT_TRUE(res.collision);
+
+  // the copy checks against the broadphase manager of cworld_ plus whatever changes on top of it
+  collision_detection::WorldPtr world_copy(new collision_detection::World(*cworld_->getWorld()));
+  DefaultCWorldType cworld_copy(dynamic_cast<const DefaultCWorldType&>(*cworld_), world_copy);
+  res = collision_detection::CollisionResult();
+  cworld_copy.checkRobotCollision(req, res, *crobot_, kstate);
+  EXPECT_TRUE(res.collision);
+
+  // moving the box in the copy shadows it in the shared manager
+  world_copy->moveShapeInObject("box", world_copy->getObject("box")->shapes_[0], far_away);
+  res = collision_detection::CollisionResult();
+  cworld_copy.checkRobotCollision(req, res, *crobot_, kstate);
+  EXPECT_FALSE(res.collision);
+  res = collision_detection::CollisionResult();
+  cworld_->checkRobotCollision(req, res, *crobot_, kstate);
+  EXPECT_TRUE(res.collision);
+
+  world_copy->addToObject("box2", shapes::ShapeConstPtr(new shapes::Box(.1, .1, .1)), pos1);
+  res = collision_detection::CollisionResult();
+  cworld_copy.checkRobotCollision(req, res, *crobot_, kstate);
+  EXPECT_TRUE(res.collision);
+
+  // changing the original once its manager is shared must not affect the copy
+  cworld_->getWorld()->removeObject("box");
+  res = collision_detection::CollisionResult();
+  cworld_->checkRobotCollision(req, res, *crobot_, kstate);
+  EXPECT_FALSE(res.collision);
+  cworld_->getWorld()->moveShapeInObject("far", cworld_->getWorld()->getObject("far")->shapes_[0], pos1);
+  res = collision_detection::CollisionResult();
+  cworld_->checkRobotCollision(req, res, *crobot_, kstate);
+  EXPECT_TRUE(res.collision);
+
+  world_copy->removeObject("box2");
+  res = collision_detection::CollisionResult();
+  cworld_copy.checkRobotCollision(req, res, *crobot_, kstate);
+  EXPECT_FALSE(res.collision);
+  EXPECT_LT(0.0, cworld_copy.distanceRobot(*crobot_, kstate));
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
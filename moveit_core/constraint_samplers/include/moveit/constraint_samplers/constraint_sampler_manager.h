@@ -39,6 +39,8 @@
 
 #include <moveit/constraint_samplers/constraint_sampler_allocator.h>
 #include <moveit/macros/class_forward.h>
+#include <boost/thread/mutex.hpp>
+#include <list>
 
 namespace constraint_samplers
 {
@@ -61,7 +63,7 @@ public:
    * \brief Empty constructor
    *
    */
-  ConstraintSamplerManager()
+  ConstraintSamplerManager() : sampler_cache_size_(0)
   {
   }
   /**
@@ -86,12 +88,37 @@ public:
    * @param group_name The group name for which to allocate the constraint sampler
    * @param constr The constraints
    *
+   * If a sampler cache is enabled (see setSamplerCacheSize()), a
+   * sampler built earlier for the same request is returned instead,
+   * as long as nobody else holds it.
+   *
    * @return An allocated ConstraintSamplerPtr,
    * or an empty pointer if none could be allocated
    */
   ConstraintSamplerPtr selectSampler(const planning_scene::PlanningSceneConstPtr& scene, const std::string& group_name,
                                      const moveit_msgs::Constraints& constr) const;
 
+  /**
+   * \brief Keep up to \e max_entries samplers built by selectSampler()
+   * for reuse, so that repeated requests skip configuring a new
+   * sampler and continue from the state of the previous one.
+   *
+   * Samplers are looked up by group, robot model, constraints message
+   * and the versions of the world and attached bodies of the scene
+   * (see planning_scene::PlanningScene::getWorldVersion()), which are
+   * what the frames of the constraints are resolved against. A cached
+   * sampler is only handed out when it is not in use, and its validity
+   * callback and verbosity are reset first. A \e max_entries of 0 (the
+   * default) disables the cache.
+   */
+  void setSamplerCacheSize(std::size_t max_entries);
+
+  /** \brief Get the maximum number of cached samplers (see setSamplerCacheSize()) */
+  std::size_t getSamplerCacheSize() const
+  {
+    return sampler_cache_size_;
+  }
+
   /**
    * \brief Default logic to select a ConstraintSampler given a
    * constraints message.
@@ -140,8 +167,20 @@ public:
                                                    const moveit_msgs::Constraints& constr);
 
 private:
+  /** \brief A sampler built by selectSampler(), with the request it was built for */
+  struct CachedSampler
+  {
+    std::size_t hash;
+    std::string key;
+    ConstraintSamplerPtr sampler;
+  };
+
   std::vector<ConstraintSamplerAllocatorPtr>
       sampler_alloc_; /**< \brief Holds the constraint sampler allocators, which will be tested in order  */
+
+  std::size_t sampler_cache_size_;                    /**< \brief The maximum number of cached samplers */
+  mutable std::list<CachedSampler> sampler_cache_;    /**< \brief Cached samplers, most recently used first */
+  mutable boost::mutex sampler_cache_lock_;
 };
 }
 
@@ -192,7 +192,6 @@ protected:
 
   virtual void clear();
 
-  random_numbers::RandomNumberGenerator random_number_generator_; /**< \brief Random number generator used to sample */
   std::vector<JointInfo> bounds_; /**< \brief The bounds for any joint with bounds that are more restrictive than the
                                      joint limits */
 
@@ -510,17 +509,24 @@ protected:
   bool callIK(const geometry_msgs::Pose& ik_query,
               const kinematics::KinematicsBase::IKCallbackFn& adapted_ik_validity_callback, double timeout,
               robot_state::RobotState& state, bool use_as_seed);
+
+  /** \brief Eigen version of callIK(), which reuses the seed and solution buffers of the sampler */
+  bool callIK(const Eigen::Affine3d& ik_query,
+              const kinematics::KinematicsBase::IKCallbackFn& adapted_ik_validity_callback, double timeout,
+              robot_state::RobotState& state, bool use_as_seed);
   bool sampleHelper(robot_state::RobotState& state, const robot_state::RobotState& reference_state,
                     unsigned int max_attempts, bool project);
   bool validate(robot_state::RobotState& state) const;
 
-  random_numbers::RandomNumberGenerator random_number_generator_; /**< \brief Random generator used by the sampler */
-  IKSamplingPose sampling_pose_;                                  /**< \brief Holder for the pose used for sampling */
-  kinematics::KinematicsBaseConstPtr kb_;                         /**< \brief Holds the kinematics solver */
-  double ik_timeout_;                                             /**< \brief Holds the timeout associated with IK */
-  std::string ik_frame_;                                          /**< \brief Holds the base from of the IK solver */
+  IKSamplingPose sampling_pose_;          /**< \brief Holder for the pose used for sampling */
+  kinematics::KinematicsBaseConstPtr kb_; /**< \brief Holds the kinematics solver */
+  double ik_timeout_;                     /**< \brief Holds the timeout associated with IK */
+  std::string ik_frame_;                  /**< \brief Holds the base from of the IK solver */
   bool transform_ik_; /**< \brief True if the frame associated with the kinematic model is different than the base frame
                          of the IK solver */
+  std::vector<double> ik_values_; /**< \brief Buffer for the group variables passed to and from IK */
+  Eigen::VectorXd ik_seed_;       /**< \brief Buffer for the IK seed, in the order of the solver */
+  Eigen::VectorXd ik_solution_;   /**< \brief Buffer for the IK solution, in the order of the solver */
 };
 }
 
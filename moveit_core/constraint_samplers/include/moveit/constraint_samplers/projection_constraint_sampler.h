@@ -0,0 +1,173 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_CONSTRAINT_SAMPLERS_PROJECTION_CONSTRAINT_SAMPLER_
+#define MOVEIT_CONSTRAINT_SAMPLERS_PROJECTION_CONSTRAINT_SAMPLER_
+
+#include <moveit/constraint_samplers/constraint_sampler.h>
+#include <moveit/constraint_samplers/constraint_sampler_allocator.h>
+#include <moveit/macros/class_forward.h>
+#include <random_numbers/random_numbers.h>
+#include <set>
+
+namespace constraint_samplers
+{
+MOVEIT_CLASS_FORWARD(ProjectionConstraintSampler);
+
+/**
+ * \brief A sampler that moves states onto the manifold defined by
+ * position and orientation constraints using the Jacobian of the group.
+ *
+ * Each sample starts from random joint values for the group. The
+ * violated position and orientation constraints are then reduced with
+ * damped least squares steps until the whole set of constraints is
+ * satisfied. This way, path constraints such as keeping an object
+ * upright are satisfied by construction instead of by rejecting
+ * random states. Joint and visibility constraints in the message are
+ * only checked, not projected onto.
+ *
+ * The group needs to be a chain (see RobotState::getJacobian()) and
+ * all constrained links need to be moved by it.
+ */
+class ProjectionConstraintSampler : public ConstraintSampler
+{
+public:
+  /** \brief The default maximum number of steps taken to project a single state */
+  static const unsigned int DEFAULT_MAX_ITERATIONS = 50;
+
+  /**
+   * \brief Constructor
+   *
+   * @param [in] scene The planning scene used to check the constraint
+   *
+   * @param [in] group_name The group name associated with the
+   * constraint.  Will be invalid if no group name is passed in or the
+   * joint model group cannot be found in the kinematic model
+   *
+   */
+  ProjectionConstraintSampler(const planning_scene::PlanningSceneConstPtr& scene, const std::string& group_name);
+
+  /**
+   * \brief Configures the sampler given a Constraints message.
+   *
+   * Succeeds if the group is a chain, the message contains at least
+   * one enabled position or orientation constraint, and all such
+   * constraints are on links moved by the group.
+   *
+   * @param [in] constr The message containing the constraints
+   *
+   * @return True if the conditions are met, otherwise false
+   */
+  virtual bool configure(const moveit_msgs::Constraints& constr);
+
+  virtual bool sample(robot_state::RobotState& state, const robot_state::RobotState& reference_state,
+                      unsigned int max_attempts);
+
+  virtual bool project(robot_state::RobotState& state, unsigned int max_attempts);
+
+  /** \brief Get the maximum number of steps taken to project a single state */
+  unsigned int getMaxIterations() const
+  {
+    return max_iterations_;
+  }
+
+  /** \brief Set the maximum number of steps taken to project a single state */
+  void setMaxIterations(unsigned int max_iterations)
+  {
+    max_iterations_ = max_iterations;
+  }
+
+  /** \brief Get the largest change of the group's joint values (in norm) allowed for a single step */
+  double getMaxStepSize() const
+  {
+    return max_step_size_;
+  }
+
+  /** \brief Set the largest change of the group's joint values (in norm) allowed for a single step */
+  void setMaxStepSize(double max_step_size)
+  {
+    max_step_size_ = max_step_size;
+  }
+
+  virtual const std::string& getName() const
+  {
+    static const std::string SAMPLER_NAME = "ProjectionConstraintSampler";
+    return SAMPLER_NAME;
+  }
+
+protected:
+  virtual void clear();
+
+  /** \brief Move the group's joint values in \e state until all constraints are satisfied or the iterations run out */
+  bool projectOntoConstraints(robot_state::RobotState& state);
+
+  /** \brief Call the validity callback, if one is set */
+  bool callValidityCallback(robot_state::RobotState& state) const;
+
+  kinematic_constraints::KinematicConstraintSetPtr constraint_set_; /**< \brief All the constraints being sampled */
+  /** \brief The position and orientation constraints that states are stepped onto */
+  std::vector<kinematic_constraints::PositionConstraintPtr> position_constraints_;
+  std::vector<kinematic_constraints::OrientationConstraintPtr> orientation_constraints_;
+  unsigned int max_iterations_; /**< \brief Maximum number of steps for projecting a single state */
+  double max_step_size_;        /**< \brief Maximum norm of the change in joint values of a single step */
+};
+
+MOVEIT_CLASS_FORWARD(ProjectionConstraintSamplerAllocator);
+
+/**
+ * \brief Allocates ProjectionConstraintSampler instances for a chosen
+ * set of groups, so projection can be enabled per group through
+ * ConstraintSamplerManager::registerSamplerAllocator().
+ */
+class ProjectionConstraintSamplerAllocator : public ConstraintSamplerAllocator
+{
+public:
+  /** \brief Serve the groups in \e group_names; an empty set serves every group */
+  ProjectionConstraintSamplerAllocator(const std::set<std::string>& group_names = std::set<std::string>())
+    : group_names_(group_names)
+  {
+  }
+
+  virtual ConstraintSamplerPtr alloc(const planning_scene::PlanningSceneConstPtr& scene, const std::string& group_name,
+                                     const moveit_msgs::Constraints& constr);
+
+  virtual bool canService(const planning_scene::PlanningSceneConstPtr& scene, const std::string& group_name,
+                          const moveit_msgs::Constraints& constr) const;
+
+private:
+  std::set<std::string> group_names_;
+};
+}
+
+#endif
@@ -143,6 +143,12 @@ public:
    * passed in as an argument.  If any sampler fails, the sample fails
    * altogether.
    *
+   * When a sampler fails whose frames do not depend on any of the
+   * samplers before it, the values produced by those earlier samplers
+   * are kept and the next call with the same reference state resumes
+   * at the failing sampler instead of sampling everything again.  This
+   * is bounded by \ref setMaxPartialSampleReuse.
+   *
    * @param [in] state State where the group sample is written to
    * @param [in] reference_state Reference kinematic state that will be passed through to samplers
    * @param [in] max_attempts Max attempts, which will be passed through to samplers
@@ -165,8 +171,59 @@ public:
     return SAMPLER_NAME;
   }
 
+  /**
+   * \brief Counters describing how a single sorted sampler performed in \ref sample
+   */
+  struct SamplerStatistics
+  {
+    SamplerStatistics() : attempts(0), successes(0)
+    {
+    }
+
+    std::size_t attempts;  /**< \brief Number of times the sampler was asked for a sample */
+    std::size_t successes; /**< \brief Number of times the sampler produced a sample */
+  };
+
+  /**
+   * \brief Get the statistics of the internal samplers, in the same order as \ref getSamplers
+   */
+  const std::vector<SamplerStatistics>& getSamplerStatistics() const
+  {
+    return statistics_;
+  }
+
+  /**
+   * \brief Set how many consecutive calls to \ref sample may resume
+   * from the values kept after a failed sample. Zero disables reuse.
+   */
+  void setMaxPartialSampleReuse(unsigned int max_reuse)
+  {
+    max_partial_reuse_ = max_reuse;
+    clearPartialSample();
+  }
+
+  unsigned int getMaxPartialSampleReuse() const
+  {
+    return max_partial_reuse_;
+  }
+
 protected:
+  /** \brief Forget the values kept from a previously failed sample */
+  void clearPartialSample()
+  {
+    partial_count_ = 0;
+    partial_reuse_ = 0;
+  }
+
   std::vector<ConstraintSamplerPtr> samplers_; /**< \brief Holder for sorted internal list of samplers*/
+  std::vector<SamplerStatistics> statistics_;  /**< \brief Statistics for each sampler in \ref samplers_ */
+  std::vector<bool> independent_; /**< \brief True if a sampler does not depend on frames updated by earlier ones */
+
+  std::vector<double> partial_sample_;    /**< \brief State values produced by the samplers before a failure */
+  std::vector<double> partial_reference_; /**< \brief Reference state values \ref partial_sample_ was built from */
+  std::size_t partial_count_;             /**< \brief Number of samplers whose values \ref partial_sample_ holds */
+  unsigned int partial_reuse_;            /**< \brief Number of times \ref partial_sample_ has been resumed */
+  unsigned int max_partial_reuse_;        /**< \brief Bound on \ref partial_reuse_ */
 };
 }
 
@@ -37,18 +37,81 @@
 #include <moveit/constraint_samplers/constraint_sampler_manager.h>
 #include <moveit/constraint_samplers/default_constraint_samplers.h>
 #include <moveit/constraint_samplers/union_constraint_sampler.h>
+#include <ros/serialization.h>
+#include <boost/functional/hash.hpp>
 #include <sstream>
 
+namespace
+{
+// everything a sampler built by selectSampler() depends on, as a string that compares equal for equal requests
+std::string makeSamplerCacheKey(const planning_scene::PlanningScene& scene, const std::string& group_name,
+                                const moveit_msgs::Constraints& constr)
+{
+  std::stringstream header;
+  header << scene.getRobotModel().get() << ' ' << scene.getWorldVersion() << ' ' << scene.getAttachedBodiesVersion()
+         << ' ' << group_name << ' ';
+  std::string key = header.str();
+  std::size_t offset = key.size();
+  key.resize(offset + ros::serialization::serializationLength(constr));
+  ros::serialization::OStream stream(reinterpret_cast<uint8_t*>(&key[offset]), key.size() - offset);
+  ros::serialization::serialize(stream, constr);
+  return key;
+}
+}
+
 constraint_samplers::ConstraintSamplerPtr constraint_samplers::ConstraintSamplerManager::selectSampler(
     const planning_scene::PlanningSceneConstPtr& scene, const std::string& group_name,
     const moveit_msgs::Constraints& constr) const
 {
-  for (std::size_t i = 0; i < sampler_alloc_.size(); ++i)
+  std::string key;
+  std::size_t hash = 0;
+  if (sampler_cache_size_ > 0)
+  {
+    key = makeSamplerCacheKey(*scene, group_name, constr);
+    hash = boost::hash<std::string>()(key);
+    boost::mutex::scoped_lock slock(sampler_cache_lock_);
+    for (std::list<CachedSampler>::iterator it = sampler_cache_.begin(); it != sampler_cache_.end(); ++it)
+      // only the cache holds a sampler that is not in use, and it cannot be handed out elsewhere while we hold the
+      // lock
+      if (it->hash == hash && it->sampler.use_count() == 1 && it->key == key)
+      {
+        sampler_cache_.splice(sampler_cache_.begin(), sampler_cache_, it);
+        ConstraintSamplerPtr sampler = sampler_cache_.front().sampler;
+        sampler->setGroupStateValidityCallback(robot_state::GroupStateValidityCallbackFn());
+        sampler->setVerbose(false);
+        return sampler;
+      }
+  }
+
+  ConstraintSamplerPtr sampler;
+  for (std::size_t i = 0; i < sampler_alloc_.size() && !sampler; ++i)
     if (sampler_alloc_[i]->canService(scene, group_name, constr))
-      return sampler_alloc_[i]->alloc(scene, group_name, constr);
+      sampler = sampler_alloc_[i]->alloc(scene, group_name, constr);
 
   // if no default sampler was used, try a default one
-  return selectDefaultSampler(scene, group_name, constr);
+  if (!sampler)
+    sampler = selectDefaultSampler(scene, group_name, constr);
+
+  if (sampler && sampler_cache_size_ > 0)
+  {
+    CachedSampler entry;
+    entry.hash = hash;
+    entry.key.swap(key);
+    entry.sampler = sampler;
+    boost::mutex::scoped_lock slock(sampler_cache_lock_);
+    sampler_cache_.push_front(entry);
+    if (sampler_cache_.size() > sampler_cache_size_)
+      sampler_cache_.pop_back();
+  }
+  return sampler;
+}
+
+void constraint_samplers::ConstraintSamplerManager::setSamplerCacheSize(std::size_t max_entries)
+{
+  boost::mutex::scoped_lock slock(sampler_cache_lock_);
+  sampler_cache_size_ = max_entries;
+  if (sampler_cache_.size() > max_entries)
+    sampler_cache_.resize(max_entries);
 }
 
 constraint_samplers::ConstraintSamplerPtr constraint_samplers::ConstraintSamplerManager::selectDefaultSampler(
@@ -160,14 +160,15 @@ bool constraint_samplers::JointConstraintSampler::sample(robot_state::RobotState
   for (std::size_t i = 0; i < unbounded_.size(); ++i)
   {
     v.resize(unbounded_[i]->getVariableCount());
-    unbounded_[i]->getVariableRandomPositions(random_number_generator_, &v[0]);
+    unbounded_[i]->getVariableRandomPositions(moveit::core::getThreadRandomNumberGenerator(), &v[0]);
     for (std::size_t j = 0; j < v.size(); ++j)
       values_[uindex_[i] + j] = v[j];
   }
 
   // enforce the constraints for the constrained components (could be all of them)
+  random_numbers::RandomNumberGenerator& rng = moveit::core::getThreadRandomNumberGenerator();
   for (std::size_t i = 0; i < bounds_.size(); ++i)
-    values_[bounds_[i].index_] = random_number_generator_.uniformReal(bounds_[i].min_bound_, bounds_[i].max_bound_);
+    values_[bounds_[i].index_] = rng.uniformReal(bounds_[i].min_bound_, bounds_[i].max_bound_);
 
   state.setJointGroupPositions(jmg_, values_);
 
@@ -422,9 +423,9 @@ bool constraint_samplers::IKConstraintSampler::samplePose(Eigen::Vector3d& pos,
     if (!b.empty())
     {
       bool found = false;
-      std::size_t k = random_number_generator_.uniformInteger(0, b.size() - 1);
+      std::size_t k = moveit::core::getThreadRandomNumberGenerator().uniformInteger(0, b.size() - 1);
       for (std::size_t i = 0; i < b.size(); ++i)
-        if (b[(i + k) % b.size()]->samplePointInside(random_number_generator_, max_attempts, pos))
+        if (b[(i + k) % b.size()]->samplePointInside(moveit::core::getThreadRandomNumberGenerator(), max_attempts, pos))
         {
           found = true;
           break;
@@ -459,13 +460,13 @@ bool constraint_samplers::IKConstraintSampler::samplePose(Eigen::Vector3d& pos,
   {
     // sample a rotation matrix within the allowed bounds
     double angle_x =
-        2.0 * (random_number_generator_.uniform01() - 0.5) *
+        2.0 * (moveit::core::getThreadRandomNumberGenerator().uniform01() - 0.5) *
         (sampling_pose_.orientation_constraint_->getXAxisTolerance() - std::numeric_limits<double>::epsilon());
     double angle_y =
-        2.0 * (random_number_generator_.uniform01() - 0.5) *
+        2.0 * (moveit::core::getThreadRandomNumberGenerator().uniform01() - 0.5) *
         (sampling_pose_.orientation_constraint_->getYAxisTolerance() - std::numeric_limits<double>::epsilon());
     double angle_z =
-        2.0 * (random_number_generator_.uniform01() - 0.5) *
+        2.0 * (moveit::core::getThreadRandomNumberGenerator().uniform01() - 0.5) *
         (sampling_pose_.orientation_constraint_->getZAxisTolerance() - std::numeric_limits<double>::epsilon());
     Eigen::Affine3d diff(Eigen::AngleAxisd(angle_x, Eigen::Vector3d::UnitX()) *
                          Eigen::AngleAxisd(angle_y, Eigen::Vector3d::UnitY()) *
@@ -486,7 +487,7 @@ bool constraint_samplers::IKConstraintSampler::samplePose(Eigen::Vector3d& pos,
   {
     // sample a random orientation
     double q[4];
-    random_number_generator_.quaternion(q);
+    moveit::core::getThreadRandomNumberGenerator().quaternion(q);
     quat = Eigen::Quaterniond(q[3], q[0], q[1], q[2]);
   }
 
@@ -565,14 +566,7 @@ bool constraint_samplers::IKConstraintSampler::sampleHelper(robot_state::RobotSt
       return false;
     }
 
-    geometry_msgs::Pose ik_query;
-    ik_query.position.x = point.x();
-    ik_query.position.y = point.y();
-    ik_query.position.z = point.z();
-    ik_query.orientation.x = quat.x();
-    ik_query.orientation.y = quat.y();
-    ik_query.orientation.z = quat.z();
-    ik_query.orientation.w = quat.w();
+    Eigen::Affine3d ik_query(Eigen::Translation3d(point) * quat);
 
     if (callIK(ik_query, adapted_ik_validity_callback, ik_timeout_, state, project && a == 0))
       return true;
@@ -598,32 +592,34 @@ bool constraint_samplers::IKConstraintSampler::callIK(
     const geometry_msgs::Pose& ik_query, const kinematics::KinematicsBase::IKCallbackFn& adapted_ik_validity_callback,
     double timeout, robot_state::RobotState& state, bool use_as_seed)
 {
-  const std::vector<unsigned int>& ik_joint_bijection = jmg_->getKinematicsSolverJointBijection();
-  std::vector<double> seed(ik_joint_bijection.size(), 0.0);
-  std::vector<double> vals;
+  Eigen::Affine3d ik_pose;
+  tf::poseMsgToEigen(ik_query, ik_pose);
+  return callIK(ik_pose, adapted_ik_validity_callback, timeout, state, use_as_seed);
+}
 
+bool constraint_samplers::IKConstraintSampler::callIK(
+    const Eigen::Affine3d& ik_query, const kinematics::KinematicsBase::IKCallbackFn& adapted_ik_validity_callback,
+    double timeout, robot_state::RobotState& state, bool use_as_seed)
+{
+  const std::vector<unsigned int>& ik_joint_bijection = jmg_->getKinematicsSolverJointBijection();
   if (use_as_seed)
-    state.copyJointGroupPositions(jmg_, vals);
+    state.copyJointGroupPositions(jmg_, ik_values_);
   else
     // sample a seed value
-    jmg_->getVariableRandomPositions(random_number_generator_, vals);
+    jmg_->getVariableRandomPositions(moveit::core::getThreadRandomNumberGenerator(), ik_values_);
 
-  assert(vals.size() == ik_joint_bijection.size());
+  assert(ik_values_.size() == ik_joint_bijection.size());
+  ik_seed_.resize(ik_joint_bijection.size());
+  ik_solution_.resize(ik_joint_bijection.size());
   for (std::size_t i = 0; i < ik_joint_bijection.size(); ++i)
-    seed[i] = vals[ik_joint_bijection[i]];
+    ik_seed_[i] = ik_values_[ik_joint_bijection[i]];
 
-  std::vector<double> ik_sol;
   moveit_msgs::MoveItErrorCodes error;
-
-  if (adapted_ik_validity_callback ?
-          kb_->searchPositionIK(ik_query, seed, timeout, ik_sol, adapted_ik_validity_callback, error) :
-          kb_->searchPositionIK(ik_query, seed, timeout, ik_sol, error))
+  if (kb_->searchPositionIK(ik_query, ik_seed_, timeout, ik_solution_, adapted_ik_validity_callback, error))
   {
-    assert(ik_sol.size() == ik_joint_bijection.size());
-    std::vector<double> solution(ik_joint_bijection.size());
     for (std::size_t i = 0; i < ik_joint_bijection.size(); ++i)
-      solution[ik_joint_bijection[i]] = ik_sol[i];
-    state.setJointGroupPositions(jmg_, solution);
+      ik_values_[ik_joint_bijection[i]] = ik_solution_[i];
+    state.setJointGroupPositions(jmg_, ik_values_);
 
     return validate(state);
   }
@@ -0,0 +1,299 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/constraint_samplers/projection_constraint_sampler.h>
+#include <limits>
+
+namespace
+{
+// damping (squared) of the least squares steps, keeps steps bounded near singularities
+const double PROJECTION_DAMPING = 1e-4;
+
+// fraction of the orientation tolerances used when computing the error, since rotation vector components only
+// approximate the XYZ Euler angles the tolerances are checked on
+const double ORIENTATION_TOLERANCE_MARGIN = 0.5;
+}
+
+constraint_samplers::ProjectionConstraintSampler::ProjectionConstraintSampler(
+    const planning_scene::PlanningSceneConstPtr& scene, const std::string& group_name)
+  : ConstraintSampler(scene, group_name), max_iterations_(DEFAULT_MAX_ITERATIONS), max_step_size_(0.2)
+{
+}
+
+void constraint_samplers::ProjectionConstraintSampler::clear()
+{
+  ConstraintSampler::clear();
+  constraint_set_.reset();
+  position_constraints_.clear();
+  orientation_constraints_.clear();
+}
+
+bool constraint_samplers::ProjectionConstraintSampler::configure(const moveit_msgs::Constraints& constr)
+{
+  clear();
+
+  if (!jmg_)
+  {
+    logError("NULL group specified for constraint sampler");
+    return false;
+  }
+  if (!jmg_->isChain())
+  {
+    logDebug("Group '%s' is not a chain; projection sampling needs its Jacobian", jmg_->getName().c_str());
+    return false;
+  }
+
+  for (std::size_t p = 0; p < constr.position_constraints.size(); ++p)
+  {
+    kinematic_constraints::PositionConstraintPtr pc(
+        new kinematic_constraints::PositionConstraint(scene_->getRobotModel()));
+    if (!pc->configure(constr.position_constraints[p], scene_->getTransforms()) || !pc->enabled())
+      continue;
+    if (!jmg_->isLinkUpdated(pc->getLinkModel()->getName()))
+    {
+      logDebug("Link '%s' is not moved by group '%s'; cannot project onto its position constraint",
+               pc->getLinkModel()->getName().c_str(), jmg_->getName().c_str());
+      clear();
+      return false;
+    }
+    if (pc->mobileReferenceFrame())
+      frame_depends_.push_back(pc->getReferenceFrame());
+    position_constraints_.push_back(pc);
+  }
+
+  for (std::size_t o = 0; o < constr.orientation_constraints.size(); ++o)
+  {
+    kinematic_constraints::OrientationConstraintPtr oc(
+        new kinematic_constraints::OrientationConstraint(scene_->getRobotModel()));
+    if (!oc->configure(constr.orientation_constraints[o], scene_->getTransforms()) || !oc->enabled())
+      continue;
+    if (!jmg_->isLinkUpdated(oc->getLinkModel()->getName()))
+    {
+      logDebug("Link '%s' is not moved by group '%s'; cannot project onto its orientation constraint",
+               oc->getLinkModel()->getName().c_str(), jmg_->getName().c_str());
+      clear();
+      return false;
+    }
+    if (oc->mobileReferenceFrame())
+      frame_depends_.push_back(oc->getReferenceFrame());
+    orientation_constraints_.push_back(oc);
+  }
+
+  if (position_constraints_.empty() && orientation_constraints_.empty())
+  {
+    logDebug("No valid position or orientation constraints to project onto");
+    return false;
+  }
+
+  constraint_set_.reset(new kinematic_constraints::KinematicConstraintSet(scene_->getRobotModel()));
+  constraint_set_->add(constr, scene_->getTransforms());
+  is_valid_ = true;
+  return true;
+}
+
+bool constraint_samplers::ProjectionConstraintSampler::sample(robot_state::RobotState& state,
+                                                              const robot_state::RobotState& reference_state,
+                                                              unsigned int max_attempts)
+{
+  if (!is_valid_)
+  {
+    logWarn("ProjectionConstraintSampler not configured, won't sample");
+    return false;
+  }
+
+  // mobile frames are looked up in the state being projected, since moving the group may move them
+  for (unsigned int a = 0; a < max_attempts; ++a)
+  {
+    state.setToRandomPositions(jmg_, moveit::core::getThreadRandomNumberGenerator());
+    if (projectOntoConstraints(state) && callValidityCallback(state))
+      return true;
+  }
+  return false;
+}
+
+bool constraint_samplers::ProjectionConstraintSampler::project(robot_state::RobotState& state,
+                                                               unsigned int max_attempts)
+{
+  if (!is_valid_)
+  {
+    logWarn("ProjectionConstraintSampler not configured, won't project");
+    return false;
+  }
+
+  // start from the given state, then from random ones
+  for (unsigned int a = 0; a < max_attempts; ++a)
+  {
+    if (a > 0)
+      state.setToRandomPositions(jmg_, moveit::core::getThreadRandomNumberGenerator());
+    if (projectOntoConstraints(state) && callValidityCallback(state))
+      return true;
+  }
+  return false;
+}
+
+bool constraint_samplers::ProjectionConstraintSampler::callValidityCallback(robot_state::RobotState& state) const
+{
+  if (!group_state_validity_callback_)
+    return true;
+  std::vector<double> values;
+  state.copyJointGroupPositions(jmg_, values);
+  return group_state_validity_callback_(&state, jmg_, &values[0]);
+}
+
+bool constraint_samplers::ProjectionConstraintSampler::projectOntoConstraints(robot_state::RobotState& state)
+{
+  const std::size_t columns = jmg_->getVariableCount();
+  const std::size_t rows = 3 * (position_constraints_.size() + orientation_constraints_.size());
+  // the Jacobians are expressed in the frame of the parent link of the first joint in the group
+  const robot_model::LinkModel* root_link = jmg_->getJointModels()[0]->getParentLinkModel();
+
+  Eigen::MatrixXd jacobian(rows, columns);
+  Eigen::MatrixXd link_jacobian;
+  Eigen::VectorXd error(rows);
+  Eigen::VectorXd values;
+  state.copyJointGroupPositions(jmg_, values);
+
+  for (unsigned int i = 0;; ++i)
+  {
+    state.update();
+    if (constraint_set_->isSatisfied(state, verbose_))
+      return true;
+    if (i >= max_iterations_)
+      return false;
+
+    Eigen::Matrix3d to_root = Eigen::Matrix3d::Identity();
+    if (root_link)
+      to_root = state.getGlobalLinkTransform(root_link).linear().transpose();
+    jacobian.setZero();
+    error.setZero();
+    std::size_t row = 0;
+
+    for (std::size_t p = 0; p < position_constraints_.size(); ++p, row += 3)
+    {
+      const kinematic_constraints::PositionConstraint& pc = *position_constraints_[p];
+      if (pc.decide(state).satisfied)
+        continue;
+
+      // step towards the closest region center; the regions are convex, so this ends up inside
+      const Eigen::Vector3d point = state.getGlobalLinkTransform(pc.getLinkModel()) * pc.getLinkOffset();
+      const std::vector<bodies::BodyPtr>& regions = pc.getConstraintRegions();
+      Eigen::Vector3d target = point;
+      double closest = std::numeric_limits<double>::infinity();
+      for (std::size_t k = 0; k < regions.size(); ++k)
+      {
+        Eigen::Vector3d center = regions[k]->getPose().translation();
+        if (pc.mobileReferenceFrame())
+          center = state.getFrameTransform(pc.getReferenceFrame()) * center;
+        double d = (center - point).squaredNorm();
+        if (d < closest)
+        {
+          closest = d;
+          target = center;
+        }
+      }
+
+      if (!state.getJacobian(jmg_, pc.getLinkModel(), pc.getLinkOffset(), link_jacobian))
+        return false;
+      jacobian.block(row, 0, 3, columns) = link_jacobian.topRows(3);
+      error.segment<3>(row) = to_root * (target - point);
+    }
+
+    for (std::size_t o = 0; o < orientation_constraints_.size(); ++o, row += 3)
+    {
+      const kinematic_constraints::OrientationConstraint& oc = *orientation_constraints_[o];
+      if (oc.decide(state).satisfied)
+        continue;
+
+      Eigen::Matrix3d desired = oc.getDesiredRotationMatrix();
+      if (oc.mobileReferenceFrame())
+        desired = state.getFrameTransform(oc.getReferenceFrame()).rotation() * desired;
+      const Eigen::Matrix3d current = state.getGlobalLinkTransform(oc.getLinkModel()).rotation();
+
+      // only remove the part of the rotation from the desired orientation that exceeds the tolerances, so samples
+      // still cover the allowed rotations (e.g., about the vertical axis when keeping something upright)
+      Eigen::AngleAxisd diff(desired.transpose() * current);
+      Eigen::Vector3d excess = diff.angle() * diff.axis();
+      const Eigen::Vector3d tolerance(ORIENTATION_TOLERANCE_MARGIN * oc.getXAxisTolerance(),
+                                      ORIENTATION_TOLERANCE_MARGIN * oc.getYAxisTolerance(),
+                                      ORIENTATION_TOLERANCE_MARGIN * oc.getZAxisTolerance());
+      for (int k = 0; k < 3; ++k)
+        excess(k) = excess(k) > tolerance(k) ? excess(k) - tolerance(k) :
+                                               (excess(k) < -tolerance(k) ? excess(k) + tolerance(k) : 0.0);
+
+      if (!state.getJacobian(jmg_, oc.getLinkModel(), Eigen::Vector3d::Zero(), link_jacobian))
+        return false;
+      jacobian.block(row, 0, 3, columns) = link_jacobian.bottomRows(3);
+      error.segment<3>(row) = -(to_root * current * excess);
+    }
+
+    // only constraints we do not step onto are violated
+    if (error.isZero())
+      return false;
+
+    // damped least squares step
+    Eigen::MatrixXd jjt = jacobian * jacobian.transpose();
+    jjt.diagonal().array() += PROJECTION_DAMPING;
+    Eigen::VectorXd step = jacobian.transpose() * jjt.ldlt().solve(error);
+    double norm = step.norm();
+    if (norm > max_step_size_)
+      step *= max_step_size_ / norm;
+
+    values += step;
+    state.setJointGroupPositions(jmg_, values);
+    state.enforceBounds(jmg_);
+    state.copyJointGroupPositions(jmg_, values);
+  }
+}
+
+constraint_samplers::ConstraintSamplerPtr constraint_samplers::ProjectionConstraintSamplerAllocator::alloc(
+    const planning_scene::PlanningSceneConstPtr& scene, const std::string& group_name,
+    const moveit_msgs::Constraints& constr)
+{
+  ProjectionConstraintSamplerPtr sampler(new ProjectionConstraintSampler(scene, group_name));
+  if (sampler->configure(constr))
+    return sampler;
+  return ConstraintSamplerPtr();
+}
+
+bool constraint_samplers::ProjectionConstraintSamplerAllocator::canService(
+    const planning_scene::PlanningSceneConstPtr& scene, const std::string& group_name,
+    const moveit_msgs::Constraints& constr) const
+{
+  if (!group_names_.empty() && group_names_.find(group_name) == group_names_.end())
+    return false;
+  if (constr.position_constraints.empty() && constr.orientation_constraints.empty())
+    return false;
+  return scene->getRobotModel()->hasJointModelGroup(group_name) &&
+         scene->getRobotModel()->getJointModelGroup(group_name)->isChain();
+}
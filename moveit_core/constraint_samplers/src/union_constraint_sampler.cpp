@@ -107,16 +107,29 @@ struct OrderSamplers
 constraint_samplers::UnionConstraintSampler::UnionConstraintSampler(const planning_scene::PlanningSceneConstPtr& scene,
                                                                     const std::string& group_name,
                                                                     const std::vector<ConstraintSamplerPtr>& samplers)
-  : ConstraintSampler(scene, group_name), samplers_(samplers)
+  : ConstraintSampler(scene, group_name)
+  , samplers_(samplers)
+  , partial_count_(0)
+  , partial_reuse_(0)
+  , max_partial_reuse_(4)
 {
   // using stable sort to preserve order of equivalents
   std::stable_sort(samplers_.begin(), samplers_.end(), OrderSamplers());
 
+  statistics_.resize(samplers_.size());
+  independent_.resize(samplers_.size(), true);
+  std::set<std::string> updated_links;
   for (std::size_t i = 0; i < samplers_.size(); ++i)
   {
     const std::vector<std::string>& fd = samplers_[i]->getFrameDependency();
     for (std::size_t j = 0; j < fd.size(); ++j)
+    {
       frame_depends_.push_back(fd[j]);
+      if (updated_links.find(fd[j]) != updated_links.end())
+        independent_[i] = false;
+    }
+    const std::vector<std::string>& ul = samplers_[i]->getJointModelGroup()->getUpdatedLinkModelNames();
+    updated_links.insert(ul.begin(), ul.end());
 
     logDebug("Union sampler for group '%s' includes sampler for group '%s'", jmg_->getName().c_str(),
              samplers_[i]->getJointModelGroup()->getName().c_str());
@@ -127,24 +140,58 @@ bool constraint_samplers::UnionConstraintSampler::sample(robot_state::RobotState
                                                          const robot_state::RobotState& reference_state,
                                                          unsigned int max_attempts)
 {
-  state = reference_state;
-  state.setToRandomPositions(jmg_);
+  const double* reference_values = reference_state.getVariablePositions();
+  const std::size_t variable_count = reference_state.getVariableCount();
 
-  if (samplers_.size() >= 1)
+  // resume from the samplers that succeeded last time, as long as the reference state is unchanged
+  std::size_t start = 0;
+  if (partial_count_ > 0 && partial_reuse_ < max_partial_reuse_ && partial_sample_.size() == variable_count &&
+      std::equal(partial_reference_.begin(), partial_reference_.end(), reference_values))
   {
-    if (!samplers_[0]->sample(state, reference_state, max_attempts))
-      return false;
+    state = reference_state;
+    state.setVariablePositions(partial_sample_);
+    start = partial_count_;
+    ++partial_reuse_;
+  }
+  else
+  {
+    clearPartialSample();
+    state = reference_state;
+    state.setToRandomPositions(jmg_);
   }
 
-  for (std::size_t i = 1; i < samplers_.size(); ++i)
+  for (std::size_t i = start; i < samplers_.size(); ++i)
   {
     // ConstraintSampler::sample returns states with dirty link transforms (because it only writes values)
     // but requires a state with clean link transforms as input. This means that we need to clean the link
     // transforms between calls to ConstraintSampler::sample.
-    state.updateLinkTransforms();
-    if (!samplers_[i]->sample(state, state, max_attempts))
+    if (i > 0)
+      state.updateLinkTransforms();
+
+    // the values of the earlier samplers are only worth keeping if this sampler cannot have failed because of them
+    bool keep = i > 0 && independent_[i] && max_partial_reuse_ > 0;
+    if (keep && partial_count_ != i)
+    {
+      partial_sample_.assign(state.getVariablePositions(), state.getVariablePositions() + variable_count);
+      partial_reference_.assign(reference_values, reference_values + variable_count);
+    }
+
+    ++statistics_[i].attempts;
+    if (!samplers_[i]->sample(state, i == 0 ? reference_state : state, max_attempts))
+    {
+      if (keep)
+      {
+        if (partial_count_ != i)
+          partial_reuse_ = 0;
+        partial_count_ = i;
+      }
+      else
+        clearPartialSample();
       return false;
+    }
+    ++statistics_[i].successes;
   }
+  clearPartialSample();
   return true;
 }
 
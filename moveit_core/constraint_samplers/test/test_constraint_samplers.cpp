@@ -38,6 +38,7 @@
 #include <moveit/kinematic_constraints/kinematic_constraint.h>
 #include <moveit/constraint_samplers/default_constraint_samplers.h>
 #include <moveit/constraint_samplers/union_constraint_sampler.h>
+#include <moveit/constraint_samplers/projection_constraint_sampler.h>
 #include <moveit/constraint_samplers/constraint_sampler_manager.h>
 #include <moveit/constraint_samplers/constraint_sampler_tools.h>
 #include <moveit_msgs/DisplayTrajectory.h>
@@ -51,6 +52,7 @@
 #include <urdf_parser/urdf_parser.h>
 #include <fstream>
 #include <boost/bind.hpp>
+#include <boost/math/constants/constants.hpp>
 #include <boost/filesystem/path.hpp>
 
 #include "pr2_arm_kinematics_plugin.h"
@@ -380,6 +382,59 @@ TEST_F(LoadPlanningModelsPr2, OrientationConstraintsSampler)
   }
 }
 
+TEST_F(LoadPlanningModelsPr2, ProjectionConstraintSampler)
+{
+  robot_state::RobotState ks(kmodel);
+  ks.setToDefaultValues();
+  ks.update();
+
+  // keep the gripper level, with any rotation about the vertical axis
+  moveit_msgs::Constraints constr;
+  constr.orientation_constraints.resize(1);
+  moveit_msgs::OrientationConstraint& ocm = constr.orientation_constraints[0];
+  ocm.link_name = "r_wrist_roll_link";
+  ocm.header.frame_id = kmodel->getModelFrame();
+  ocm.orientation.w = 1.0;
+  ocm.absolute_x_axis_tolerance = 0.1;
+  ocm.absolute_y_axis_tolerance = 0.1;
+  ocm.absolute_z_axis_tolerance = boost::math::constants::pi<double>();
+  ocm.weight = 1.0;
+
+  kinematic_constraints::OrientationConstraint oc(kmodel);
+  EXPECT_TRUE(oc.configure(ocm, ps->getTransforms()));
+
+  constraint_samplers::ProjectionConstraintSampler pcs(ps, "right_arm");
+  EXPECT_TRUE(pcs.configure(constr));
+  EXPECT_EQ(pcs.getName(), "ProjectionConstraintSampler");
+
+  // the group needs to move the constrained link
+  constraint_samplers::ProjectionConstraintSampler left(ps, "left_arm");
+  EXPECT_FALSE(left.configure(constr));
+
+  int succeeded = 0;
+  for (int t = 0; t < 100; ++t)
+    if (pcs.sample(ks, ks, 10))
+    {
+      ++succeeded;
+      EXPECT_TRUE(oc.decide(ks).satisfied);
+    }
+  EXPECT_GT(succeeded, 90);
+
+  // projection starts from the given state when possible
+  ks.setToDefaultValues();
+  ks.update();
+  EXPECT_TRUE(pcs.project(ks, 10));
+  EXPECT_TRUE(oc.decide(ks).satisfied);
+
+  constraint_samplers::ProjectionConstraintSamplerAllocator all;
+  EXPECT_TRUE(all.canService(ps, "right_arm", constr));
+  EXPECT_TRUE(all.alloc(ps, "right_arm", constr));
+  std::set<std::string> groups;
+  groups.insert("left_arm");
+  constraint_samplers::ProjectionConstraintSamplerAllocator left_only(groups);
+  EXPECT_FALSE(left_only.canService(ps, "right_arm", constr));
+}
+
 TEST_F(LoadPlanningModelsPr2, IKConstraintsSamplerValid)
 {
   robot_state::RobotState ks(kmodel);
@@ -580,6 +635,14 @@ TEST_F(LoadPlanningModelsPr2, UnionConstraintSampler)
     EXPECT_TRUE(pc.decide(ks).satisfied);
   }
 
+  // every sampler was asked once per successful union sample
+  ASSERT_EQ(ucs.getSamplerStatistics().size(), 3);
+  for (std::size_t i = 0; i < ucs.getSamplerStatistics().size(); ++i)
+  {
+    EXPECT_EQ(ucs.getSamplerStatistics()[i].attempts, ucs.getSamplerStatistics()[i].successes);
+    EXPECT_EQ(ucs.getSamplerStatistics()[i].successes, 100);
+  }
+
   // now we add a position constraint on right arm
   pcm.link_name = "r_wrist_roll_link";
   ocm.link_name = "r_wrist_roll_link";
@@ -41,6 +41,7 @@
 #include <string>
 #include <moveit_msgs/RobotTrajectory.h>
 #include <moveit/macros/class_forward.h>
+#include <boost/function.hpp>
 
 /// Namespace for the base class of a MoveIt controller manager
 namespace moveit_controller_manager
@@ -105,6 +106,9 @@ MOVEIT_CLASS_FORWARD(MoveItControllerHandle);
 class MoveItControllerHandle
 {
 public:
+  /** \brief Signature of the function a handle calls when the execution of a trajectory it was sent completes */
+  typedef boost::function<void(MoveItControllerHandle* handle)> ExecutionCompleteCallback;
+
   /** \brief Each controller has a name. The handle is initialized with that name */
   MoveItControllerHandle(const std::string& name) : name_(name)
   {
@@ -137,6 +141,15 @@ public:
   /** \brief Return the execution status of the last trajectory sent to the controller. */
   virtual ExecutionStatus getLastExecutionStatus() = 0;
 
+  /** \brief Set the function to call, from any thread, each time the execution of a trajectory completes or is
+   * canceled, so the completion can be waited for without blocking in waitForExecution(). An empty function removes
+   * the callback. Return false if the handle does not report completions (the default), in which case
+   * waitForExecution() has to be used. */
+  virtual bool setExecutionCompleteCallback(const ExecutionCompleteCallback& callback)
+  {
+    return false;
+  }
+
 protected:
   std::string name_;
 };
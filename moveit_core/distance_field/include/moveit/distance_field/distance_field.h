@@ -323,6 +323,45 @@ public:
    */
   double getDistanceGradient(double x, double y, double z, double& gradient_x, double& gradient_y, double& gradient_z,
                              bool& in_bounds) const;
+
+  /**
+   * \brief Gets the distances and gradients at many locations at
+   * once, as \ref getDistanceGradient would for each of them.
+   * Locations that are not valid for gradient purposes get the
+   * uninitialized distance and a zero gradient.
+   *
+   * The default implementation calls \ref getDistanceGradient for
+   * every location; derived classes can look the cells up without
+   * a virtual call per cell.
+   *
+   * @param [in] points The locations to look up
+   * @param [out] distances The distance to the closest occupied cell for every location
+   * @param [out] gradients The gradient to the closest occupied cell for every location
+   */
+  virtual void getDistanceGradients(const EigenSTL::vector_Vector3d& points, std::vector<double>& distances,
+                                    EigenSTL::vector_Vector3d& gradients) const;
+
+  /**
+   * \brief Gets trilinearly interpolated distances and their exact
+   * gradients at many locations at once.
+   *
+   * Unlike \ref getDistanceGradient, the distance varies continuously
+   * between cell centers and the gradient is the derivative of the
+   * interpolated distance.  Locations that do not lie between the
+   * centers of cells of the field get the uninitialized distance and
+   * a zero gradient.
+   *
+   * The default implementation reads the eight cells around every
+   * location with \ref getDistance; derived classes can read them
+   * without a virtual call per cell.
+   *
+   * @param [in] points The n locations to look up
+   * @param [in] n The number of locations
+   * @param [out] distances The n interpolated distances
+   * @param [out] gradients The n gradients of the interpolated distances
+   */
+  virtual void getDistancesAndGradients(const Eigen::Vector3d* points, std::size_t n, double* distances,
+                                        Eigen::Vector3d* gradients) const;
   /**
    * \brief Gets the distance to the closest obstacle at the given
    * integer cell location. The particulars of this function are
@@ -615,6 +654,62 @@ protected:
   void setPoint(int xCell, int yCell, int zCell, double dist, geometry_msgs::Point& point, std_msgs::ColorRGBA& color,
                 double max_distance) const;
 
+  /**
+   * \brief Finds the cell whose center is the lower corner of the
+   * interpolation cube around \e point, and the fractions of the way
+   * to the opposite corner.
+   *
+   * @return False if the cube is not inside a field of num_x by num_y
+   * by num_z cells
+   */
+  bool getInterpolationCell(const Eigen::Vector3d& point, int num_x, int num_y, int num_z, int& x, int& y, int& z,
+                            Eigen::Vector3d& fraction) const
+  {
+    const double inv_resolution = 1.0 / resolution_;
+    const double ux = (point.x() - origin_x_) * inv_resolution;
+    const double uy = (point.y() - origin_y_) * inv_resolution;
+    const double uz = (point.z() - origin_z_) * inv_resolution;
+    x = int(floor(ux));
+    y = int(floor(uy));
+    z = int(floor(uz));
+    if (x < 0 || y < 0 || z < 0 || x >= num_x - 1 || y >= num_y - 1 || z >= num_z - 1)
+      return false;
+    fraction = Eigen::Vector3d(ux - x, uy - y, uz - z);
+    return true;
+  }
+
+  /**
+   * \brief Trilinear interpolation of the distances at the corners of
+   * an interpolation cube.
+   *
+   * @param [in] corners The eight corner distances, corner (dx, dy, dz) at index 4 * dx + 2 * dy + dz
+   * @param [in] fraction The location within the cube, from \ref getInterpolationCell
+   * @param [out] gradient The gradient of the interpolated distance
+   *
+   * @return The interpolated distance
+   */
+  double interpolateDistance(const double* corners, const Eigen::Vector3d& fraction, Eigen::Vector3d& gradient) const
+  {
+    const double fx = fraction.x(), fy = fraction.y(), fz = fraction.z();
+    // interpolate along Z, then Y, then X
+    const double c00 = corners[0] + (corners[1] - corners[0]) * fz;
+    const double c01 = corners[2] + (corners[3] - corners[2]) * fz;
+    const double c10 = corners[4] + (corners[5] - corners[4]) * fz;
+    const double c11 = corners[6] + (corners[7] - corners[6]) * fz;
+    const double c0 = c00 + (c01 - c00) * fy;
+    const double c1 = c10 + (c11 - c10) * fy;
+
+    const double inv_resolution = 1.0 / resolution_;
+    gradient.x() = (c1 - c0) * inv_resolution;
+    gradient.y() = ((c01 - c00) * (1.0 - fx) + (c11 - c10) * fx) * inv_resolution;
+    const double dz00 = corners[1] - corners[0];
+    const double dz01 = corners[3] - corners[2];
+    const double dz10 = corners[5] - corners[4];
+    const double dz11 = corners[7] - corners[6];
+    gradient.z() = ((dz00 + (dz01 - dz00) * fy) * (1.0 - fx) + (dz10 + (dz11 - dz10) * fy) * fx) * inv_resolution;
+    return c0 + (c1 - c0) * fx;
+  }
+
   double size_x_;            /**< \brief X size of the distance field */
   double size_y_;            /**< \brief Y size of the distance field */
   double size_z_;            /**< \brief Z size of the distance field */
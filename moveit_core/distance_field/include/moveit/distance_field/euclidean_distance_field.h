@@ -0,0 +1,174 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_DISTANCE_FIELD_EUCLIDEAN_DISTANCE_FIELD_
+#define MOVEIT_DISTANCE_FIELD_EUCLIDEAN_DISTANCE_FIELD_
+
+#include <moveit/distance_field/voxel_grid.h>
+#include <moveit/distance_field/distance_field.h>
+#include <vector>
+
+namespace distance_field
+{
+MOVEIT_CLASS_FORWARD(EuclideanDistanceField);
+
+/**
+ * \brief A DistanceField implementation that computes the exact
+ * Euclidean distance transform of all occupied cells at once.
+ *
+ * The transform is separable: the squared distances are computed
+ * along the Z lines of the grid, then along the Y lines and then
+ * along the X lines, using the lower envelope of parabolas of
+ * Felzenszwalb and Huttenlocher ("Distance Transforms of Sampled
+ * Functions").  Every line of a pass is independent of the others,
+ * so the passes run in parallel when OpenMP is available.  The
+ * time taken is linear in the number of cells and does not depend
+ * on the number of obstacles or the maximum distance.
+ *
+ * Every change of the obstacle cells recomputes the whole field.
+ * This makes the field suited to complete rebuilds, e.g. from a new
+ * sensor scan: reset() it and add all the points in one
+ * addPointsToField() call.  For small incremental changes the \ref
+ * PropagationDistanceField is faster.
+ *
+ * The distances follow the conventions of the \ref
+ * PropagationDistanceField: free cells hold the distance to the
+ * closest obstacle cell, obstacle cells hold zero or, for a signed
+ * field, the negative distance to the closest free cell.  Distances
+ * are limited to the maximum distance.
+ */
+class EuclideanDistanceField : public DistanceField
+{
+public:
+  /**
+   * \brief Constructor that initializes entire distance field to
+   * empty - all cells will be assigned maximum distance values.
+   *
+   * @param [in] size_x The X dimension in meters of the volume to represent
+   * @param [in] size_y The Y dimension in meters of the volume to represent
+   * @param [in] size_z The Z dimension in meters of the volume to represent
+   * @param [in] resolution The resolution in meters of the volume
+   * @param [in] origin_x The minimum X point of the volume
+   * @param [in] origin_y The minimum Y point of the volume
+   * @param [in] origin_z The minimum Z point of the volume
+   * @param [in] max_distance Cells that are further than this from the closest obstacle get this distance
+   * @param [in] propagate_negative_distances Whether obstacle cells get the negative distance to the closest free
+   * cell instead of zero
+   */
+  EuclideanDistanceField(double size_x, double size_y, double size_z, double resolution, double origin_x,
+                         double origin_y, double origin_z, double max_distance,
+                         bool propagate_negative_distances = false);
+
+  virtual ~EuclideanDistanceField();
+
+  /**
+   * \brief Marks the cells of \e points as obstacles and recomputes
+   * the field.
+   */
+  virtual void addPointsToField(const EigenSTL::vector_Vector3d& points);
+
+  /**
+   * \brief Marks the cells of \e points as free and recomputes the
+   * field.
+   */
+  virtual void removePointsFromField(const EigenSTL::vector_Vector3d& points);
+
+  /**
+   * \brief Marks the cells of \e old_points as free and the cells of
+   * \e new_points as obstacles, then recomputes the field once.
+   */
+  virtual void updatePointsInField(const EigenSTL::vector_Vector3d& old_points,
+                                   const EigenSTL::vector_Vector3d& new_points);
+
+  /**
+   * \brief Removes all obstacles; all cells get the maximum distance.
+   */
+  virtual void reset();
+
+  virtual double getDistance(double x, double y, double z) const;
+  virtual double getDistance(int x, int y, int z) const;
+  virtual bool isCellValid(int x, int y, int z) const;
+  virtual int getXNumCells() const;
+  virtual int getYNumCells() const;
+  virtual int getZNumCells() const;
+  virtual bool gridToWorld(int x, int y, int z, double& world_x, double& world_y, double& world_z) const;
+  virtual bool worldToGrid(double world_x, double world_y, double world_z, int& x, int& y, int& z) const;
+
+  /**
+   * \brief Writes the obstacle cells in the format of \ref
+   * PropagationDistanceField::writeToStream.
+   */
+  virtual bool writeToStream(std::ostream& stream) const;
+
+  /**
+   * \brief Reads obstacle cells written by \ref writeToStream (or by
+   * a \ref PropagationDistanceField) and recomputes the field.
+   */
+  virtual bool readFromStream(std::istream& stream);
+
+  virtual double getUninitializedDistance() const
+  {
+    return max_distance_;
+  }
+
+  /**
+   * \brief Whether the cell at the given index is an obstacle cell.
+   */
+  bool isOccupied(int x, int y, int z) const
+  {
+    return occupancy_grid_->getCell(x, y, z) != 0;
+  }
+
+private:
+  void initialize();
+
+  /// Mark the cells of \e points as obstacles (\e occupied true) or as free
+  void setOccupancy(const EigenSTL::vector_Vector3d& points, bool occupied);
+
+  /// Recompute the distances of all cells from the occupancy grid
+  void computeDistances();
+
+  /// Compute the squared distance, in cells, from every cell to the closest cell whose occupancy is \e target
+  void computeSquaredDistances(char target, VoxelGrid<float>& squared_distances) const;
+
+  bool propagate_negative_;
+  double max_distance_;
+
+  VoxelGrid<char>::Ptr occupancy_grid_; /**< \brief Non-zero for obstacle cells */
+  VoxelGrid<float>::Ptr distance_grid_;  /**< \brief The distance of every cell in meters */
+  VoxelGrid<float>::Ptr negative_grid_;  /**< \brief Scratch grid for the distances inside obstacles */
+};
+}
+
+#endif
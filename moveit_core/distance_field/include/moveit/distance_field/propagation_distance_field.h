@@ -38,6 +38,7 @@
 #define MOVEIT_DISTANCE_FIELD_PROPAGATION_DISTANCE_FIELD_
 
 #include <moveit/distance_field/voxel_grid.h>
+#include <moveit/distance_field/sparse_voxel_grid.h>
 #include <moveit/distance_field/distance_field.h>
 #include <vector>
 #include <list>
@@ -113,9 +114,10 @@ struct PropDistanceFieldVoxel
  * this maximum distance from the nearest cell will have maximum
  * distance measurements.
  *
- * This class uses a \ref VoxelGrid to hold all data.  One important
- * decision that must be made on construction is whether or not to
- * create a signed version of the distance field.  If the distance
+ * This class uses a \ref VoxelGrid, or optionally a \ref
+ * SparseVoxelGrid for large volumes with few obstacles, to hold all
+ * data.  One important decision that must be made on construction is
+ * whether or not to create a signed version of the distance field.  If the distance
  * field is unsigned, it means that the minumum obstacle distance is
  * 0, a value that will be assigned to all obstacle cells.  Gradient
  * queries for obstacle cells will not give useful information, as the
@@ -157,10 +159,16 @@ public:
    * \ref PropagationDistanceField description for more information on
    * the implications of this.
    *
+   * @param [in] sparse_storage Whether to hold the data in a \ref
+   * SparseVoxelGrid instead of a \ref VoxelGrid.  Only the cells
+   * within the maximum distance of obstacles are then stored, which
+   * makes large, mostly empty volumes affordable at the price of
+   * somewhat slower lookups.
+   *
    */
   PropagationDistanceField(double size_x, double size_y, double size_z, double resolution, double origin_x,
                            double origin_y, double origin_z, double max_distance,
-                           bool propagate_negative_distances = false);
+                           bool propagate_negative_distances = false, bool sparse_storage = false);
 
   /**
    * \brief Constructor based on an OcTree and bounding box
@@ -321,6 +329,24 @@ public:
    */
   virtual double getDistance(int x, int y, int z) const;
 
+  /**
+   * \brief Gets the distances and gradients at many locations at
+   * once, see \ref DistanceField::getDistanceGradients. The voxels
+   * are read directly, without the virtual calls of
+   * \ref getDistanceGradient.
+   */
+  virtual void getDistanceGradients(const EigenSTL::vector_Vector3d& points, std::vector<double>& distances,
+                                    EigenSTL::vector_Vector3d& gradients) const;
+
+  /**
+   * \brief Gets interpolated distances and gradients at many
+   * locations at once, see \ref
+   * DistanceField::getDistancesAndGradients.  The voxels are read
+   * directly, without the virtual calls of \ref getDistance.
+   */
+  virtual void getDistancesAndGradients(const Eigen::Vector3d* points, std::size_t n, double* distances,
+                                        Eigen::Vector3d* gradients) const;
+
   virtual bool isCellValid(int x, int y, int z) const;
   virtual int getXNumCells() const;
   virtual int getYNumCells() const;
@@ -383,7 +409,7 @@ public:
    */
   const PropDistanceFieldVoxel& getCell(int x, int y, int z) const
   {
-    return voxel_grid_->getCell(x, y, z);
+    return getVoxel(x, y, z);
   }
 
   /**
@@ -406,19 +432,19 @@ public:
    */
   const PropDistanceFieldVoxel* getNearestCell(int x, int y, int z, double& dist, Eigen::Vector3i& pos) const
   {
-    const PropDistanceFieldVoxel* cell = &voxel_grid_->getCell(x, y, z);
+    const PropDistanceFieldVoxel* cell = &getVoxel(x, y, z);
     if (cell->distance_square_ > 0)
     {
       dist = sqrt_table_[cell->distance_square_];
       pos = cell->closest_point_;
-      const PropDistanceFieldVoxel* ncell = &voxel_grid_->getCell(pos.x(), pos.y(), pos.z());
+      const PropDistanceFieldVoxel* ncell = &getVoxel(pos.x(), pos.y(), pos.z());
       return ncell == cell ? NULL : ncell;
     }
     if (cell->negative_distance_square_ > 0)
     {
       dist = -sqrt_table_[cell->negative_distance_square_];
       pos = cell->closest_negative_point_;
-      const PropDistanceFieldVoxel* ncell = &voxel_grid_->getCell(pos.x(), pos.y(), pos.z());
+      const PropDistanceFieldVoxel* ncell = &getVoxel(pos.x(), pos.y(), pos.z());
       return ncell == cell ? NULL : ncell;
     }
     dist = 0.0;
@@ -452,6 +478,22 @@ private:
    */
   void initialize();
 
+  /**
+   * \brief The voxel at a valid cell, from whichever grid holds the
+   * data.  For a sparse grid, the non-const version allocates the
+   * block of the cell.
+   */
+  PropDistanceFieldVoxel& getVoxel(int x, int y, int z)
+  {
+    return sparse_grid_ ? sparse_grid_->getCell(x, y, z) : voxel_grid_->getCell(x, y, z);
+  }
+  const PropDistanceFieldVoxel& getVoxel(int x, int y, int z) const
+  {
+    // through a const pointer, so reading never allocates blocks
+    const SparseVoxelGrid<PropDistanceFieldVoxel>* sparse_grid = sparse_grid_.get();
+    return sparse_grid ? sparse_grid->getCell(x, y, z) : voxel_grid_->getCell(x, y, z);
+  }
+
   /**
    * \brief Adds a valid set of integer points to the voxel grid
    *
@@ -546,7 +588,10 @@ private:
 
   bool propagate_negative_; /**< \brief Whether or not to propagate negative distances */
 
+  bool sparse_storage_;     /**< \brief Whether the data is held in sparse_grid_ instead of voxel_grid_ */
+
   VoxelGrid<PropDistanceFieldVoxel>::Ptr voxel_grid_; /**< \brief Actual container for distance data */
+  SparseVoxelGrid<PropDistanceFieldVoxel>::Ptr sparse_grid_; /**< \brief Container for sparse distance data */
 
   /// \brief Structure used to hold propagation frontier
   std::vector<std::vector<Eigen::Vector3i> > bucket_queue_; /**< \brief Data member that holds points from which to
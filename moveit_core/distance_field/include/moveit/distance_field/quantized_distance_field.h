@@ -0,0 +1,193 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_DISTANCE_FIELD_QUANTIZED_DISTANCE_FIELD_
+#define MOVEIT_DISTANCE_FIELD_QUANTIZED_DISTANCE_FIELD_
+
+#include <moveit/distance_field/distance_field.h>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/cstdint.hpp>
+#include <vector>
+#include <string>
+
+namespace distance_field
+{
+MOVEIT_CLASS_FORWARD(QuantizedDistanceField);
+
+/**
+ * \brief A read-only DistanceField that holds precomputed distances
+ * quantized to 8 or 16 bits.
+ *
+ * The distances of any other distance field can be saved with \ref
+ * save, e.g. after an expensive propagation for a static workcell,
+ * and loaded later without any propagation.  The file starts with
+ * a versioned header, followed by the quantized distances of all
+ * cells.  Uncompressed files are memory-mapped, so loading does not
+ * read the distances at all; compressed files are smaller, but are
+ * decompressed into memory.
+ *
+ * The distances are quantized uniformly between the smallest
+ * distance of the field and its maximum distance, so the error is at
+ * most half a step: (max - min) / 510 for 8 bits and (max - min) /
+ * 131070 for 16 bits.
+ *
+ * All functions that would change the obstacles of the field fail
+ * with an error message.
+ */
+class QuantizedDistanceField : public DistanceField
+{
+public:
+  /** \brief The version of the file format written by \ref save */
+  static const boost::uint32_t FORMAT_VERSION = 1;
+
+  /**
+   * \brief Constructs an empty field; use \ref load or \ref
+   * readFromStream to fill it.
+   */
+  QuantizedDistanceField();
+
+  /**
+   * \brief Constructs the field from a file written by \ref save.
+   * Check \ref isLoaded for success.
+   */
+  QuantizedDistanceField(const std::string& filename);
+
+  virtual ~QuantizedDistanceField();
+
+  /**
+   * \brief Writes the distances of \e field to \e filename.
+   *
+   * @param [in] field The field to save
+   * @param [in] filename The file to write
+   * @param [in] bits The bits per distance, 8 or 16
+   * @param [in] compress Whether to compress the distances with zlib; compressed files cannot be memory-mapped
+   *
+   * @return True if the file was written
+   */
+  static bool save(const DistanceField& field, const std::string& filename, unsigned int bits = 16,
+                   bool compress = false);
+
+  /**
+   * \brief Loads a file written by \ref save, memory-mapping it
+   * unless it is compressed.
+   *
+   * @return True if the file was loaded; otherwise the field is empty
+   */
+  bool load(const std::string& filename);
+
+  /** \brief Whether the field holds distances */
+  bool isLoaded() const
+  {
+    return data_ != NULL;
+  }
+
+  /** \brief Whether the distances are read from a memory-mapped file */
+  bool isMapped() const
+  {
+    return mapped_file_.is_open();
+  }
+
+  /** \brief The bits per stored distance, 8 or 16 */
+  unsigned int getBits() const
+  {
+    return bits_;
+  }
+
+  virtual void addPointsToField(const EigenSTL::vector_Vector3d& points);
+  virtual void removePointsFromField(const EigenSTL::vector_Vector3d& points);
+  virtual void updatePointsInField(const EigenSTL::vector_Vector3d& old_points,
+                                   const EigenSTL::vector_Vector3d& new_points);
+  virtual void reset();
+
+  virtual double getDistance(double x, double y, double z) const;
+  virtual double getDistance(int x, int y, int z) const
+  {
+    const std::size_t index = (std::size_t(x) * num_cells_[1] + y) * num_cells_[2] + z;
+    const unsigned int q = bits_ == 8 ? static_cast<const boost::uint8_t*>(data_)[index] :
+                                        static_cast<const boost::uint16_t*>(data_)[index];
+    return min_distance_ + q * step_;
+  }
+  virtual bool isCellValid(int x, int y, int z) const;
+  virtual int getXNumCells() const;
+  virtual int getYNumCells() const;
+  virtual int getZNumCells() const;
+  virtual bool gridToWorld(int x, int y, int z, double& world_x, double& world_y, double& world_z) const;
+  virtual bool worldToGrid(double world_x, double world_y, double world_z, int& x, int& y, int& z) const;
+
+  /**
+   * \brief Writes the field in the format of \ref save, uncompressed.
+   */
+  virtual bool writeToStream(std::ostream& stream) const;
+
+  /**
+   * \brief Reads a field written by \ref save or \ref writeToStream
+   * into memory.
+   */
+  virtual bool readFromStream(std::istream& stream);
+
+  virtual double getUninitializedDistance() const
+  {
+    return max_distance_;
+  }
+
+private:
+  /// Writes the header and the distances of \e field to \e stream
+  static bool write(const DistanceField& field, std::ostream& stream, unsigned int bits, bool compress);
+
+  struct FileHeader;
+
+  /// Checks \e header and takes the geometry of the field from it
+  bool readHeader(const FileHeader& header);
+
+  /// Reads the distances of a field with the geometry from readHeader into buffer_
+  bool readDistances(std::istream& stream, bool compressed);
+
+  /// The number of bytes of the distances
+  std::size_t getDataSize() const;
+
+  void clear();
+
+  int num_cells_[3];
+  double max_distance_;
+  double min_distance_;  /**< \brief The distance of quantized value 0 */
+  double step_;          /**< \brief The distance between consecutive quantized values */
+  unsigned int bits_;
+
+  const void* data_;                               /**< \brief The quantized distances, or NULL */
+  std::vector<char> buffer_;                       /**< \brief Holds the distances unless they are mapped */
+  boost::iostreams::mapped_file_source mapped_file_; /**< \brief Holds the distances if they are mapped */
+};
+}
+
+#endif
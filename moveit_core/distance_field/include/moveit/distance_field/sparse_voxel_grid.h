@@ -0,0 +1,359 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_DISTANCE_FIELD_SPARSE_VOXEL_GRID_
+#define MOVEIT_DISTANCE_FIELD_SPARSE_VOXEL_GRID_
+
+#include <moveit/distance_field/voxel_grid.h>
+#include <vector>
+
+namespace distance_field
+{
+/**
+ * \brief SparseVoxelGrid holds a block-sparse 3D, axis-aligned set of
+ * data at a given resolution, with the interface of \ref VoxelGrid.
+ *
+ * The volume is divided into blocks of BLOCK_SIZE^3 cells.  A block
+ * is only allocated when one of its cells is first accessed through
+ * the non-const getCell() or setCell(); until then all its cells hold
+ * the default object.  The memory used thus scales with the part of
+ * the volume that is written, e.g. the band around obstacles of a
+ * distance field, instead of with the whole volume.  A flat table of
+ * block pointers (one pointer per block) keeps lookups to two
+ * indexing operations.  Within a block the cells are stored in
+ * Morton (Z-) order, so the neighbors of a cell mostly share its
+ * cache lines.
+ *
+ * Read-only access must use the const accessors, which never
+ * allocate.
+ */
+template <typename T>
+class SparseVoxelGrid
+{
+public:
+  MOVEIT_DECLARE_PTR_MEMBER(SparseVoxelGrid);
+
+  /** \brief The number of cells along each side of a block */
+  static const int BLOCK_SIZE = 8;
+
+  /**
+   * \brief Constructor for the SparseVoxelGrid; see \ref
+   * VoxelGrid::VoxelGrid.
+   *
+   * @param [in] default_object The object held by all cells until
+   * they are written, and returned for any queries that are not valid
+   */
+  SparseVoxelGrid(double size_x, double size_y, double size_z, double resolution, double origin_x, double origin_y,
+                  double origin_z, T default_object);
+  ~SparseVoxelGrid();
+
+  /** \copydoc VoxelGrid::operator()(double, double, double) const */
+  const T& operator()(double x, double y, double z) const;
+  const T& operator()(const Eigen::Vector3d& pos) const;
+
+  /**
+   * \brief Gives the value of the given cell, allocating its block if
+   * it is not allocated yet.  If x,y,z is invalid then corruption
+   * and/or SEGFAULTS will occur.
+   */
+  T& getCell(int x, int y, int z);
+  T& getCell(const Eigen::Vector3i& pos);
+
+  /**
+   * \brief Gives the value of the given cell, or the default object
+   * if its block is not allocated.  If x,y,z is invalid then
+   * corruption and/or SEGFAULTS will occur.
+   */
+  const T& getCell(int x, int y, int z) const;
+  const T& getCell(const Eigen::Vector3i& pos) const;
+
+  void setCell(int x, int y, int z, const T& obj);
+  void setCell(const Eigen::Vector3i& pos, const T& obj);
+
+  /**
+   * \brief Frees all blocks, so every cell holds \e initial.  \e
+   * initial also becomes the default object.
+   */
+  void reset(const T& initial);
+
+  double getSize(Dimension dim) const;
+  double getResolution() const;
+  double getOrigin(Dimension dim) const;
+  int getNumCells(Dimension dim) const;
+
+  void gridToWorld(int x, int y, int z, double& world_x, double& world_y, double& world_z) const;
+  bool worldToGrid(double world_x, double world_y, double world_z, int& x, int& y, int& z) const;
+
+  bool isCellValid(int x, int y, int z) const;
+  bool isCellValid(const Eigen::Vector3i& pos) const;
+  bool isCellValid(Dimension dim, int cell) const;
+
+  /** \brief The number of blocks that are allocated */
+  std::size_t getNumAllocatedBlocks() const
+  {
+    return num_allocated_blocks_;
+  }
+
+private:
+  // not copyable: the blocks are owned by the grid
+  SparseVoxelGrid(const SparseVoxelGrid&);
+  SparseVoxelGrid& operator=(const SparseVoxelGrid&);
+
+  static const int LOG2_BLOCK_SIZE = 3;
+  static const int BLOCK_MASK = BLOCK_SIZE - 1;
+  static const int BLOCK_CELLS = BLOCK_SIZE * BLOCK_SIZE * BLOCK_SIZE;
+
+  /// The index of the block of a cell in blocks_
+  int blockRef(int x, int y, int z) const;
+
+  /// The Morton index of a cell in its block
+  static int cellRef(int x, int y, int z);
+
+  /// Spreads the bits of a cell index within a block to every third bit
+  static int spreadBits(int v);
+
+  int getCellFromLocation(Dimension dim, double loc) const;
+  double getLocationFromCell(Dimension dim, int cell) const;
+
+  std::vector<T*> blocks_;            /**< \brief The blocks, NULL where not allocated */
+  std::size_t num_allocated_blocks_;  /**< \brief The number of non-NULL entries of blocks_ */
+  T default_object_;                  /**< \brief The value of unallocated cells and out-of-bounds queries */
+  double size_[3];                    /**< \brief The size of each dimension in meters (in Dimension order) */
+  double resolution_;                 /**< \brief The resolution of each dimension in meters */
+  double oo_resolution_;              /**< \brief 1.0/resolution_ */
+  double origin_[3];                  /**< \brief The origin (minumum point) of each dimension in meters */
+  double origin_minus_[3];            /**< \brief origin - 0.5/resolution */
+  int num_cells_[3];                  /**< \brief The number of cells in each dimension (in Dimension order) */
+  int num_blocks_[3];                 /**< \brief The number of blocks in each dimension (in Dimension order) */
+};
+
+//////////////////////////// template function definitions follow //////////////////
+
+template <typename T>
+SparseVoxelGrid<T>::SparseVoxelGrid(double size_x, double size_y, double size_z, double resolution, double origin_x,
+                                    double origin_y, double origin_z, T default_object)
+  : num_allocated_blocks_(0), default_object_(default_object), resolution_(resolution)
+{
+  size_[DIM_X] = size_x;
+  size_[DIM_Y] = size_y;
+  size_[DIM_Z] = size_z;
+  origin_[DIM_X] = origin_x;
+  origin_[DIM_Y] = origin_y;
+  origin_[DIM_Z] = origin_z;
+  oo_resolution_ = 1.0 / resolution_;
+  std::size_t num_blocks_total = 1;
+  for (int i = DIM_X; i <= DIM_Z; ++i)
+  {
+    origin_minus_[i] = origin_[i] - 0.5 * resolution_;
+    num_cells_[i] = size_[i] * oo_resolution_;
+    num_blocks_[i] = (num_cells_[i] + BLOCK_MASK) >> LOG2_BLOCK_SIZE;
+    num_blocks_total *= num_blocks_[i];
+  }
+  blocks_.resize(num_blocks_total, NULL);
+}
+
+template <typename T>
+SparseVoxelGrid<T>::~SparseVoxelGrid()
+{
+  reset(default_object_);
+}
+
+template <typename T>
+inline int SparseVoxelGrid<T>::blockRef(int x, int y, int z) const
+{
+  return ((x >> LOG2_BLOCK_SIZE) * num_blocks_[DIM_Y] + (y >> LOG2_BLOCK_SIZE)) * num_blocks_[DIM_Z] +
+         (z >> LOG2_BLOCK_SIZE);
+}
+
+template <typename T>
+inline int SparseVoxelGrid<T>::spreadBits(int v)
+{
+  return (v & 1) | ((v & 2) << 2) | ((v & 4) << 4);
+}
+
+template <typename T>
+inline int SparseVoxelGrid<T>::cellRef(int x, int y, int z)
+{
+  return (spreadBits(x & BLOCK_MASK) << 2) | (spreadBits(y & BLOCK_MASK) << 1) | spreadBits(z & BLOCK_MASK);
+}
+
+template <typename T>
+inline T& SparseVoxelGrid<T>::getCell(int x, int y, int z)
+{
+  T*& block = blocks_[blockRef(x, y, z)];
+  if (!block)
+  {
+    block = new T[BLOCK_CELLS];
+    std::fill(block, block + BLOCK_CELLS, default_object_);
+    ++num_allocated_blocks_;
+  }
+  return block[cellRef(x, y, z)];
+}
+
+template <typename T>
+inline T& SparseVoxelGrid<T>::getCell(const Eigen::Vector3i& pos)
+{
+  return getCell(pos.x(), pos.y(), pos.z());
+}
+
+template <typename T>
+inline const T& SparseVoxelGrid<T>::getCell(int x, int y, int z) const
+{
+  const T* block = blocks_[blockRef(x, y, z)];
+  return block ? block[cellRef(x, y, z)] : default_object_;
+}
+
+template <typename T>
+inline const T& SparseVoxelGrid<T>::getCell(const Eigen::Vector3i& pos) const
+{
+  return getCell(pos.x(), pos.y(), pos.z());
+}
+
+template <typename T>
+inline void SparseVoxelGrid<T>::setCell(int x, int y, int z, const T& obj)
+{
+  getCell(x, y, z) = obj;
+}
+
+template <typename T>
+inline void SparseVoxelGrid<T>::setCell(const Eigen::Vector3i& pos, const T& obj)
+{
+  getCell(pos.x(), pos.y(), pos.z()) = obj;
+}
+
+template <typename T>
+void SparseVoxelGrid<T>::reset(const T& initial)
+{
+  for (std::size_t i = 0; i < blocks_.size(); ++i)
+  {
+    delete[] blocks_[i];
+    blocks_[i] = NULL;
+  }
+  num_allocated_blocks_ = 0;
+  default_object_ = initial;
+}
+
+template <typename T>
+inline const T& SparseVoxelGrid<T>::operator()(double x, double y, double z) const
+{
+  int cell_x = getCellFromLocation(DIM_X, x);
+  int cell_y = getCellFromLocation(DIM_Y, y);
+  int cell_z = getCellFromLocation(DIM_Z, z);
+  if (!isCellValid(cell_x, cell_y, cell_z))
+    return default_object_;
+  return getCell(cell_x, cell_y, cell_z);
+}
+
+template <typename T>
+inline const T& SparseVoxelGrid<T>::operator()(const Eigen::Vector3d& pos) const
+{
+  return this->operator()(pos.x(), pos.y(), pos.z());
+}
+
+template <typename T>
+inline double SparseVoxelGrid<T>::getSize(Dimension dim) const
+{
+  return size_[dim];
+}
+
+template <typename T>
+inline double SparseVoxelGrid<T>::getResolution() const
+{
+  return resolution_;
+}
+
+template <typename T>
+inline double SparseVoxelGrid<T>::getOrigin(Dimension dim) const
+{
+  return origin_[dim];
+}
+
+template <typename T>
+inline int SparseVoxelGrid<T>::getNumCells(Dimension dim) const
+{
+  return num_cells_[dim];
+}
+
+template <typename T>
+inline bool SparseVoxelGrid<T>::isCellValid(int x, int y, int z) const
+{
+  return (x >= 0 && x < num_cells_[DIM_X] && y >= 0 && y < num_cells_[DIM_Y] && z >= 0 && z < num_cells_[DIM_Z]);
+}
+
+template <typename T>
+inline bool SparseVoxelGrid<T>::isCellValid(const Eigen::Vector3i& pos) const
+{
+  return isCellValid(pos.x(), pos.y(), pos.z());
+}
+
+template <typename T>
+inline bool SparseVoxelGrid<T>::isCellValid(Dimension dim, int cell) const
+{
+  return cell >= 0 && cell < num_cells_[dim];
+}
+
+template <typename T>
+inline int SparseVoxelGrid<T>::getCellFromLocation(Dimension dim, double loc) const
+{
+  // the rounded quantized location, as in VoxelGrid
+  return int(floor((loc - origin_minus_[dim]) * oo_resolution_));
+}
+
+template <typename T>
+inline double SparseVoxelGrid<T>::getLocationFromCell(Dimension dim, int cell) const
+{
+  return origin_[dim] + resolution_ * (double(cell));
+}
+
+template <typename T>
+inline void SparseVoxelGrid<T>::gridToWorld(int x, int y, int z, double& world_x, double& world_y,
+                                            double& world_z) const
+{
+  world_x = getLocationFromCell(DIM_X, x);
+  world_y = getLocationFromCell(DIM_Y, y);
+  world_z = getLocationFromCell(DIM_Z, z);
+}
+
+template <typename T>
+inline bool SparseVoxelGrid<T>::worldToGrid(double world_x, double world_y, double world_z, int& x, int& y,
+                                            int& z) const
+{
+  x = getCellFromLocation(DIM_X, world_x);
+  y = getCellFromLocation(DIM_Y, world_y);
+  z = getCellFromLocation(DIM_Z, world_z);
+  return isCellValid(x, y, z);
+}
+
+}  // namespace distance_field
+#endif
@@ -85,6 +85,42 @@ double distance_field::DistanceField::getDistanceGradient(double x, double y, do
   return getDistance(gx, gy, gz);
 }
 
+void distance_field::DistanceField::getDistanceGradients(const EigenSTL::vector_Vector3d& points,
+                                                          std::vector<double>& distances,
+                                                          EigenSTL::vector_Vector3d& gradients) const
+{
+  distances.resize(points.size());
+  gradients.resize(points.size());
+  bool in_bounds;
+  for (std::size_t i = 0; i < points.size(); ++i)
+    distances[i] = getDistanceGradient(points[i].x(), points[i].y(), points[i].z(), gradients[i].x(), gradients[i].y(),
+                                       gradients[i].z(), in_bounds);
+}
+
+void distance_field::DistanceField::getDistancesAndGradients(const Eigen::Vector3d* points, std::size_t n,
+                                                              double* distances, Eigen::Vector3d* gradients) const
+{
+  const int num_x = getXNumCells();
+  const int num_y = getYNumCells();
+  const int num_z = getZNumCells();
+  const double uninitialized = getUninitializedDistance();
+  double corners[8];
+  Eigen::Vector3d fraction;
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    int x, y, z;
+    if (!getInterpolationCell(points[i], num_x, num_y, num_z, x, y, z, fraction))
+    {
+      distances[i] = uninitialized;
+      gradients[i].setZero();
+      continue;
+    }
+    for (int c = 0; c < 8; ++c)
+      corners[c] = getDistance(x + (c >> 2), y + ((c >> 1) & 1), z + (c & 1));
+    distances[i] = interpolateDistance(corners, fraction, gradients[i]);
+  }
+}
+
 void distance_field::DistanceField::getIsoSurfaceMarkers(double min_distance, double max_distance,
                                                          const std::string& frame_id, const ros::Time stamp,
                                                          visualization_msgs::Marker& inf_marker) const
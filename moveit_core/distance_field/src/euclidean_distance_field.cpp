@@ -0,0 +1,343 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/distance_field/euclidean_distance_field.h>
+#include <console_bridge/console.h>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <bitset>
+
+namespace distance_field
+{
+namespace
+{
+// squared distance of cells without a site; larger than any squared distance within a grid
+static const double EDT_INFINITY = 1e20;
+
+// One-dimensional squared distance transform of the sampled function f (Felzenszwalb and
+// Huttenlocher): d[q] = min_p((q - p)^2 + f[p]).  Samples of f that are EDT_INFINITY are no sites.
+// v, z are scratch space of at least n and n + 1 entries.
+void squaredDistanceTransform(const double* f, int n, double* d, int* v, double* z)
+{
+  int k = -1;
+  for (int q = 0; q < n; ++q)
+  {
+    if (f[q] >= EDT_INFINITY)
+      continue;
+    if (k < 0)
+    {
+      k = 0;
+      v[0] = q;
+      z[0] = -EDT_INFINITY;
+      z[1] = EDT_INFINITY;
+      continue;
+    }
+    // the intersection with the parabola of the last site of the lower envelope
+    double s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.0 * (q - v[k]));
+    while (s <= z[k])
+    {
+      --k;
+      s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.0 * (q - v[k]));
+    }
+    ++k;
+    v[k] = q;
+    z[k] = s;
+    z[k + 1] = EDT_INFINITY;
+  }
+
+  if (k < 0)
+  {
+    for (int q = 0; q < n; ++q)
+      d[q] = EDT_INFINITY;
+    return;
+  }
+  k = 0;
+  for (int q = 0; q < n; ++q)
+  {
+    while (z[k + 1] < q)
+      ++k;
+    d[q] = (q - v[k]) * (q - v[k]) + f[v[k]];
+  }
+}
+}
+
+EuclideanDistanceField::EuclideanDistanceField(double size_x, double size_y, double size_z, double resolution,
+                                               double origin_x, double origin_y, double origin_z, double max_distance,
+                                               bool propagate_negative_distances)
+  : DistanceField(size_x, size_y, size_z, resolution, origin_x, origin_y, origin_z)
+  , propagate_negative_(propagate_negative_distances)
+  , max_distance_(max_distance)
+{
+  initialize();
+}
+
+EuclideanDistanceField::~EuclideanDistanceField()
+{
+}
+
+void EuclideanDistanceField::initialize()
+{
+  occupancy_grid_.reset(
+      new VoxelGrid<char>(size_x_, size_y_, size_z_, resolution_, origin_x_, origin_y_, origin_z_, 0));
+  distance_grid_.reset(new VoxelGrid<float>(size_x_, size_y_, size_z_, resolution_, origin_x_, origin_y_, origin_z_,
+                                            max_distance_));
+  if (propagate_negative_)
+    negative_grid_.reset(new VoxelGrid<float>(size_x_, size_y_, size_z_, resolution_, origin_x_, origin_y_,
+                                              origin_z_, 0.0f));
+  else
+    negative_grid_.reset();
+}
+
+void EuclideanDistanceField::setOccupancy(const EigenSTL::vector_Vector3d& points, bool occupied)
+{
+  for (std::size_t i = 0; i < points.size(); ++i)
+  {
+    int x, y, z;
+    if (occupancy_grid_->worldToGrid(points[i].x(), points[i].y(), points[i].z(), x, y, z))
+      occupancy_grid_->getCell(x, y, z) = occupied ? 1 : 0;
+  }
+}
+
+void EuclideanDistanceField::addPointsToField(const EigenSTL::vector_Vector3d& points)
+{
+  setOccupancy(points, true);
+  computeDistances();
+}
+
+void EuclideanDistanceField::removePointsFromField(const EigenSTL::vector_Vector3d& points)
+{
+  setOccupancy(points, false);
+  computeDistances();
+}
+
+void EuclideanDistanceField::updatePointsInField(const EigenSTL::vector_Vector3d& old_points,
+                                                 const EigenSTL::vector_Vector3d& new_points)
+{
+  setOccupancy(old_points, false);
+  setOccupancy(new_points, true);
+  computeDistances();
+}
+
+void EuclideanDistanceField::reset()
+{
+  occupancy_grid_->reset(0);
+  distance_grid_->reset(max_distance_);
+}
+
+void EuclideanDistanceField::computeSquaredDistances(char target, VoxelGrid<float>& squared_distances) const
+{
+  const int num_x = getXNumCells();
+  const int num_y = getYNumCells();
+  const int num_z = getZNumCells();
+  const int max_cells = std::max(num_x, std::max(num_y, num_z));
+
+  // the transforms along Z, then Y, then X; the lines of each pass are independent
+  for (int dim = DIM_Z; dim >= DIM_X; --dim)
+  {
+    const int num_lines = dim == DIM_X ? num_y : num_x;
+    const int num_inner = dim == DIM_Z ? num_y : num_z;
+    const int n = dim == DIM_X ? num_x : dim == DIM_Y ? num_y : num_z;
+
+#pragma omp parallel
+    {
+      std::vector<double> f(max_cells), d(max_cells), z(max_cells + 1);
+      std::vector<int> v(max_cells);
+
+#pragma omp for
+      for (int a = 0; a < num_lines; ++a)
+      {
+        for (int b = 0; b < num_inner; ++b)
+        {
+          for (int q = 0; q < n; ++q)
+          {
+            if (dim == DIM_Z)
+              f[q] = occupancy_grid_->getCell(a, b, q) == target ? 0.0 : EDT_INFINITY;
+            else if (dim == DIM_Y)
+              f[q] = squared_distances.getCell(a, q, b);
+            else
+              f[q] = squared_distances.getCell(q, a, b);
+          }
+          squaredDistanceTransform(&f[0], n, &d[0], &v[0], &z[0]);
+          for (int q = 0; q < n; ++q)
+          {
+            if (dim == DIM_Z)
+              squared_distances.getCell(a, b, q) = d[q];
+            else if (dim == DIM_Y)
+              squared_distances.getCell(a, q, b) = d[q];
+            else
+              squared_distances.getCell(q, a, b) = d[q];
+          }
+        }
+      }
+    }
+  }
+}
+
+void EuclideanDistanceField::computeDistances()
+{
+  computeSquaredDistances(1, *distance_grid_);
+  if (propagate_negative_)
+    computeSquaredDistances(0, *negative_grid_);
+
+  const int num_x = getXNumCells();
+  const int num_y = getYNumCells();
+  const int num_z = getZNumCells();
+#pragma omp parallel for
+  for (int x = 0; x < num_x; ++x)
+    for (int y = 0; y < num_y; ++y)
+      for (int z = 0; z < num_z; ++z)
+      {
+        float& distance = distance_grid_->getCell(x, y, z);
+        distance = std::min(sqrt(distance) * resolution_, max_distance_);
+        if (propagate_negative_)
+          distance -= std::min(sqrt(negative_grid_->getCell(x, y, z)) * resolution_, max_distance_);
+      }
+}
+
+double EuclideanDistanceField::getDistance(double x, double y, double z) const
+{
+  return (*distance_grid_.get())(x, y, z);
+}
+
+double EuclideanDistanceField::getDistance(int x, int y, int z) const
+{
+  return distance_grid_->getCell(x, y, z);
+}
+
+bool EuclideanDistanceField::isCellValid(int x, int y, int z) const
+{
+  return distance_grid_->isCellValid(x, y, z);
+}
+
+int EuclideanDistanceField::getXNumCells() const
+{
+  return distance_grid_->getNumCells(DIM_X);
+}
+
+int EuclideanDistanceField::getYNumCells() const
+{
+  return distance_grid_->getNumCells(DIM_Y);
+}
+
+int EuclideanDistanceField::getZNumCells() const
+{
+  return distance_grid_->getNumCells(DIM_Z);
+}
+
+bool EuclideanDistanceField::gridToWorld(int x, int y, int z, double& world_x, double& world_y, double& world_z) const
+{
+  distance_grid_->gridToWorld(x, y, z, world_x, world_y, world_z);
+  return true;
+}
+
+bool EuclideanDistanceField::worldToGrid(double world_x, double world_y, double world_z, int& x, int& y, int& z) const
+{
+  return distance_grid_->worldToGrid(world_x, world_y, world_z, x, y, z);
+}
+
+bool EuclideanDistanceField::writeToStream(std::ostream& os) const
+{
+  os << "resolution: " << resolution_ << std::endl;
+  os << "size_x: " << size_x_ << std::endl;
+  os << "size_y: " << size_y_ << std::endl;
+  os << "size_z: " << size_z_ << std::endl;
+  os << "origin_x: " << origin_x_ << std::endl;
+  os << "origin_y: " << origin_y_ << std::endl;
+  os << "origin_z: " << origin_z_ << std::endl;
+
+  // the obstacle cells as bits, eight cells along Z to a byte, zlib compressed
+  boost::iostreams::filtering_ostream out;
+  out.push(boost::iostreams::zlib_compressor());
+  out.push(os);
+
+  for (int x = 0; x < getXNumCells(); ++x)
+    for (int y = 0; y < getYNumCells(); ++y)
+      for (int z = 0; z < getZNumCells(); z += 8)
+      {
+        std::bitset<8> bs(0);
+        int zv = std::min(8, getZNumCells() - z);
+        for (int zi = 0; zi < zv; ++zi)
+          if (isOccupied(x, y, z + zi))
+            bs[zi] = 1;
+        out.write((char*)&bs, sizeof(char));
+      }
+  out.flush();
+  return true;
+}
+
+bool EuclideanDistanceField::readFromStream(std::istream& is)
+{
+  if (!is.good())
+    return false;
+
+  std::string temp;
+  static const char* keys[] = { "resolution:", "size_x:", "size_y:", "size_z:", "origin_x:", "origin_y:", "origin_z:" };
+  double* values[] = { &resolution_, &size_x_, &size_y_, &size_z_, &origin_x_, &origin_y_, &origin_z_ };
+  for (std::size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); ++i)
+  {
+    is >> temp;
+    if (temp != keys[i])
+      return false;
+    is >> *values[i];
+  }
+
+  // previous values for propagate_negative_ and max_distance_ will be used
+  initialize();
+
+  // this should be newline
+  char nl;
+  is.get(nl);
+
+  boost::iostreams::filtering_istream in;
+  in.push(boost::iostreams::zlib_decompressor());
+  in.push(is);
+
+  for (int x = 0; x < getXNumCells(); ++x)
+    for (int y = 0; y < getYNumCells(); ++y)
+      for (int z = 0; z < getZNumCells(); z += 8)
+      {
+        char inchar;
+        if (!in.good())
+          return false;
+        in.get(inchar);
+        std::bitset<8> inbit((unsigned long long)inchar);
+        int zv = std::min(8, getZNumCells() - z);
+        for (int zi = 0; zi < zv; ++zi)
+          if (inbit[zi] == 1)
+            occupancy_grid_->getCell(x, y, z + zi) = 1;
+      }
+  computeDistances();
+  return true;
+}
+}
@@ -45,9 +45,10 @@ namespace distance_field
 {
 PropagationDistanceField::PropagationDistanceField(double size_x, double size_y, double size_z, double resolution,
                                                    double origin_x, double origin_y, double origin_z,
-                                                   double max_distance, bool propagate_negative)
+                                                   double max_distance, bool propagate_negative, bool sparse_storage)
   : DistanceField(size_x, size_y, size_z, resolution, origin_x, origin_y, origin_z)
   , propagate_negative_(propagate_negative)
+  , sparse_storage_(sparse_storage)
   , max_distance_(max_distance)
 {
   initialize();
@@ -59,6 +60,7 @@ PropagationDistanceField::PropagationDistanceField(const octomap::OcTree& octree
   : DistanceField(bbx_max.x() - bbx_min.x(), bbx_max.y() - bbx_min.y(), bbx_max.z() - bbx_min.z(),
                   octree.getResolution(), bbx_min.x(), bbx_min.y(), bbx_min.z())
   , propagate_negative_(propagate_negative_distances)
+  , sparse_storage_(false)
   , max_distance_(max_distance)
 {
   initialize();
@@ -67,7 +69,10 @@ PropagationDistanceField::PropagationDistanceField(const octomap::OcTree& octree
 
 PropagationDistanceField::PropagationDistanceField(std::istream& is, double max_distance,
                                                    bool propagate_negative_distances)
-  : DistanceField(0, 0, 0, 0, 0, 0, 0), propagate_negative_(propagate_negative_distances), max_distance_(max_distance)
+  : DistanceField(0, 0, 0, 0, 0, 0, 0)
+  , propagate_negative_(propagate_negative_distances)
+  , sparse_storage_(false)
+  , max_distance_(max_distance)
 {
   readFromStream(is);
 }
@@ -75,8 +80,20 @@ PropagationDistanceField::PropagationDistanceField(std::istream& is, double max_
 void PropagationDistanceField::initialize()
 {
   max_distance_sq_ = ceil(max_distance_ / resolution_) * ceil(max_distance_ / resolution_);
-  voxel_grid_.reset(new VoxelGrid<PropDistanceFieldVoxel>(size_x_, size_y_, size_z_, resolution_, origin_x_, origin_y_,
-                                                          origin_z_, PropDistanceFieldVoxel(max_distance_sq_, 0)));
+  if (sparse_storage_)
+  {
+    voxel_grid_.reset();
+    sparse_grid_.reset(new SparseVoxelGrid<PropDistanceFieldVoxel>(size_x_, size_y_, size_z_, resolution_, origin_x_,
+                                                                   origin_y_, origin_z_,
+                                                                   PropDistanceFieldVoxel(max_distance_sq_, 0)));
+  }
+  else
+  {
+    sparse_grid_.reset();
+    voxel_grid_.reset(new VoxelGrid<PropDistanceFieldVoxel>(size_x_, size_y_, size_z_, resolution_, origin_x_,
+                                                            origin_y_, origin_z_,
+                                                            PropDistanceFieldVoxel(max_distance_sq_, 0)));
+  }
 
   initNeighborhoods();
 
@@ -162,7 +179,7 @@ void PropagationDistanceField::updatePointsInField(const EigenSTL::vector_Vector
   std::vector<Eigen::Vector3i> new_not_in_current;
   for (unsigned int i = 0; i < new_not_old.size(); i++)
   {
-    if (voxel_grid_->getCell(new_not_old[i].x(), new_not_old[i].y(), new_not_old[i].z()).distance_square_ != 0)
+    if (getVoxel(new_not_old[i].x(), new_not_old[i].y(), new_not_old[i].z()).distance_square_ != 0)
     {
       new_not_in_current.push_back(new_not_old[i]);
     }
@@ -193,7 +210,7 @@ void PropagationDistanceField::addPointsToField(const EigenSTL::vector_Vector3d&
 
     if (valid)
     {
-      if (voxel_grid_->getCell(voxel_loc.x(), voxel_loc.y(), voxel_loc.z()).distance_square_ > 0)
+      if (getVoxel(voxel_loc.x(), voxel_loc.y(), voxel_loc.z()).distance_square_ > 0)
       {
         voxel_points.push_back(voxel_loc);
       }
@@ -232,13 +249,13 @@ void PropagationDistanceField::addNewObstacleVoxels(const std::vector<Eigen::Vec
   std::vector<Eigen::Vector3i> negative_stack;
   if (propagate_negative_)
   {
-    negative_stack.reserve(getXNumCells() * getYNumCells() * getZNumCells());
+    negative_stack.reserve(sparse_storage_ ? voxel_points.size() : getXNumCells() * getYNumCells() * getZNumCells());
     negative_bucket_queue_[0].reserve(voxel_points.size());
   }
 
   for (unsigned int i = 0; i < voxel_points.size(); i++)
   {
-    PropDistanceFieldVoxel& voxel = voxel_grid_->getCell(voxel_points[i].x(), voxel_points[i].y(), voxel_points[i].z());
+    PropDistanceFieldVoxel& voxel = getVoxel(voxel_points[i].x(), voxel_points[i].y(), voxel_points[i].z());
     const Eigen::Vector3i& loc = voxel_points[i];
     voxel.distance_square_ = 0;
     voxel.closest_point_ = loc;
@@ -269,14 +286,14 @@ void PropagationDistanceField::addNewObstacleVoxels(const std::vector<Eigen::Vec
 
         if (isCellValid(nloc.x(), nloc.y(), nloc.z()))
         {
-          PropDistanceFieldVoxel& nvoxel = voxel_grid_->getCell(nloc.x(), nloc.y(), nloc.z());
+          PropDistanceFieldVoxel& nvoxel = getVoxel(nloc.x(), nloc.y(), nloc.z());
           Eigen::Vector3i& close_point = nvoxel.closest_negative_point_;
           if (!isCellValid(close_point.x(), close_point.y(), close_point.z()))
           {
             close_point = nloc;
           }
           PropDistanceFieldVoxel& closest_point_voxel =
-              voxel_grid_->getCell(close_point.x(), close_point.y(), close_point.z());
+              getVoxel(close_point.x(), close_point.y(), close_point.z());
 
           // our closest non-obstacle cell has become an obstacle
           if (closest_point_voxel.negative_distance_square_ != 0)
@@ -314,11 +331,11 @@ void PropagationDistanceField::removeObstacleVoxels(const std::vector<Eigen::Vec
   std::vector<Eigen::Vector3i> negative_stack;
   int initial_update_direction = getDirectionNumber(0, 0, 0);
 
-  stack.reserve(getXNumCells() * getYNumCells() * getZNumCells());
+  stack.reserve(sparse_storage_ ? voxel_points.size() : getXNumCells() * getYNumCells() * getZNumCells());
   bucket_queue_[0].reserve(voxel_points.size());
   if (propagate_negative_)
   {
-    negative_stack.reserve(getXNumCells() * getYNumCells() * getZNumCells());
+    negative_stack.reserve(sparse_storage_ ? voxel_points.size() : getXNumCells() * getYNumCells() * getZNumCells());
     negative_bucket_queue_[0].reserve(voxel_points.size());
   }
 
@@ -332,7 +349,7 @@ void PropagationDistanceField::removeObstacleVoxels(const std::vector<Eigen::Vec
   //     continue;
   for (unsigned int i = 0; i < voxel_points.size(); i++)
   {
-    PropDistanceFieldVoxel& voxel = voxel_grid_->getCell(voxel_points[i].x(), voxel_points[i].y(), voxel_points[i].z());
+    PropDistanceFieldVoxel& voxel = getVoxel(voxel_points[i].x(), voxel_points[i].y(), voxel_points[i].z());
     voxel.distance_square_ = max_distance_sq_;
     voxel.closest_point_ = voxel_points[i];
     voxel.update_direction_ = initial_update_direction;  // not needed?
@@ -359,14 +376,14 @@ void PropagationDistanceField::removeObstacleVoxels(const std::vector<Eigen::Vec
 
       if (isCellValid(nloc.x(), nloc.y(), nloc.z()))
       {
-        PropDistanceFieldVoxel& nvoxel = voxel_grid_->getCell(nloc.x(), nloc.y(), nloc.z());
+        PropDistanceFieldVoxel& nvoxel = getVoxel(nloc.x(), nloc.y(), nloc.z());
         Eigen::Vector3i& close_point = nvoxel.closest_point_;
         if (!isCellValid(close_point.x(), close_point.y(), close_point.z()))
         {
           close_point = nloc;
         }
         PropDistanceFieldVoxel& closest_point_voxel =
-            voxel_grid_->getCell(close_point.x(), close_point.y(), close_point.z());
+            getVoxel(close_point.x(), close_point.y(), close_point.z());
 
         if (closest_point_voxel.distance_square_ != 0)
         {  // closest point no longer exists
@@ -404,7 +421,7 @@ void PropagationDistanceField::propagatePositive()
     for (; list_it != list_end; ++list_it)
     {
       const Eigen::Vector3i& loc = *list_it;
-      PropDistanceFieldVoxel* vptr = &voxel_grid_->getCell(loc.x(), loc.y(), loc.z());
+      PropDistanceFieldVoxel* vptr = &getVoxel(loc.x(), loc.y(), loc.z());
 
       // select the neighborhood list based on the update direction:
       std::vector<Eigen::Vector3i>* neighborhood;
@@ -430,7 +447,7 @@ void PropagationDistanceField::propagatePositive()
 
         // the real update code:
         // calculate the neighbor's new distance based on my closest filled voxel:
-        PropDistanceFieldVoxel* neighbor = &voxel_grid_->getCell(nloc.x(), nloc.y(), nloc.z());
+        PropDistanceFieldVoxel* neighbor = &getVoxel(nloc.x(), nloc.y(), nloc.z());
         int new_distance_sq = eucDistSq(vptr->closest_point_, nloc);
         if (new_distance_sq > max_distance_sq_)
           continue;
@@ -461,7 +478,7 @@ void PropagationDistanceField::propagateNegative()
     for (; list_it != list_end; ++list_it)
     {
       const Eigen::Vector3i& loc = *list_it;
-      PropDistanceFieldVoxel* vptr = &voxel_grid_->getCell(loc.x(), loc.y(), loc.z());
+      PropDistanceFieldVoxel* vptr = &getVoxel(loc.x(), loc.y(), loc.z());
 
       // select the neighborhood list based on the update direction:
       std::vector<Eigen::Vector3i>* neighborhood;
@@ -488,7 +505,7 @@ void PropagationDistanceField::propagateNegative()
 
         // the real update code:
         // calculate the neighbor's new distance based on my closest filled voxel:
-        PropDistanceFieldVoxel* neighbor = &voxel_grid_->getCell(nloc.x(), nloc.y(), nloc.z());
+        PropDistanceFieldVoxel* neighbor = &getVoxel(nloc.x(), nloc.y(), nloc.z());
         int new_distance_sq = eucDistSq(vptr->closest_negative_point_, nloc);
         if (new_distance_sq > max_distance_sq_)
           continue;
@@ -514,6 +531,13 @@ void PropagationDistanceField::propagateNegative()
 
 void PropagationDistanceField::reset()
 {
+  if (sparse_storage_)
+  {
+    // free cells keep an uninitialized closest_negative_point_, which the negative propagation treats like the cell
+    // itself, so no cell needs to be touched
+    sparse_grid_->reset(PropDistanceFieldVoxel(max_distance_sq_, 0));
+    return;
+  }
   voxel_grid_->reset(PropDistanceFieldVoxel(max_distance_sq_, 0));
   for (int x = 0; x < getXNumCells(); x++)
   {
@@ -521,7 +545,7 @@ void PropagationDistanceField::reset()
     {
       for (int z = 0; z < getZNumCells(); z++)
       {
-        PropDistanceFieldVoxel& voxel = voxel_grid_->getCell(x, y, z);
+        PropDistanceFieldVoxel& voxel = getVoxel(x, y, z);
         voxel.closest_negative_point_.x() = x;
         voxel.closest_negative_point_.y() = y;
         voxel.closest_negative_point_.z() = z;
@@ -602,42 +626,115 @@ Eigen::Vector3i PropagationDistanceField::getLocationDifference(int directionNum
 
 double PropagationDistanceField::getDistance(double x, double y, double z) const
 {
+  if (sparse_storage_)
+    return getDistance((*sparse_grid_.get())(x, y, z));
   return getDistance((*voxel_grid_.get())(x, y, z));
 }
 
 double PropagationDistanceField::getDistance(int x, int y, int z) const
 {
-  return getDistance(voxel_grid_->getCell(x, y, z));
+  return getDistance(getVoxel(x, y, z));
+}
+
+void PropagationDistanceField::getDistanceGradients(const EigenSTL::vector_Vector3d& points,
+                                                    std::vector<double>& distances,
+                                                    EigenSTL::vector_Vector3d& gradients) const
+{
+  if (sparse_storage_)
+  {
+    DistanceField::getDistanceGradients(points, distances, gradients);
+    return;
+  }
+  distances.resize(points.size());
+  gradients.resize(points.size());
+
+  const VoxelGrid<PropDistanceFieldVoxel>& grid = *voxel_grid_;
+  const int num_x = grid.getNumCells(DIM_X) - 1;
+  const int num_y = grid.getNumCells(DIM_Y) - 1;
+  const int num_z = grid.getNumCells(DIM_Z) - 1;
+  const double uninitialized = getUninitializedDistance();
+  for (std::size_t i = 0; i < points.size(); ++i)
+  {
+    int x, y, z;
+    grid.worldToGrid(points[i].x(), points[i].y(), points[i].z(), x, y, z);
+
+    // the gradient needs one cell of padding on either side, as in getDistanceGradient()
+    if (x < 1 || y < 1 || z < 1 || x >= num_x || y >= num_y || z >= num_z)
+    {
+      distances[i] = uninitialized;
+      gradients[i].setZero();
+      continue;
+    }
+    gradients[i].x() = (PropagationDistanceField::getDistance(grid.getCell(x + 1, y, z)) -
+                        PropagationDistanceField::getDistance(grid.getCell(x - 1, y, z))) *
+                       inv_twice_resolution_;
+    gradients[i].y() = (PropagationDistanceField::getDistance(grid.getCell(x, y + 1, z)) -
+                        PropagationDistanceField::getDistance(grid.getCell(x, y - 1, z))) *
+                       inv_twice_resolution_;
+    gradients[i].z() = (PropagationDistanceField::getDistance(grid.getCell(x, y, z + 1)) -
+                        PropagationDistanceField::getDistance(grid.getCell(x, y, z - 1))) *
+                       inv_twice_resolution_;
+    distances[i] = PropagationDistanceField::getDistance(grid.getCell(x, y, z));
+  }
+}
+
+void PropagationDistanceField::getDistancesAndGradients(const Eigen::Vector3d* points, std::size_t n,
+                                                        double* distances, Eigen::Vector3d* gradients) const
+{
+  const int num_x = getXNumCells();
+  const int num_y = getYNumCells();
+  const int num_z = getZNumCells();
+  const double uninitialized = getUninitializedDistance();
+  double corners[8];
+  Eigen::Vector3d fraction;
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    int x, y, z;
+    if (!getInterpolationCell(points[i], num_x, num_y, num_z, x, y, z, fraction))
+    {
+      distances[i] = uninitialized;
+      gradients[i].setZero();
+      continue;
+    }
+    for (int c = 0; c < 8; ++c)
+      corners[c] = PropagationDistanceField::getDistance(getVoxel(x + (c >> 2), y + ((c >> 1) & 1), z + (c & 1)));
+    distances[i] = interpolateDistance(corners, fraction, gradients[i]);
+  }
 }
 
 bool PropagationDistanceField::isCellValid(int x, int y, int z) const
 {
-  return voxel_grid_->isCellValid(x, y, z);
+  return sparse_storage_ ? sparse_grid_->isCellValid(x, y, z) : voxel_grid_->isCellValid(x, y, z);
 }
 
 int PropagationDistanceField::getXNumCells() const
 {
-  return voxel_grid_->getNumCells(DIM_X);
+  return sparse_storage_ ? sparse_grid_->getNumCells(DIM_X) : voxel_grid_->getNumCells(DIM_X);
 }
 
 int PropagationDistanceField::getYNumCells() const
 {
-  return voxel_grid_->getNumCells(DIM_Y);
+  return sparse_storage_ ? sparse_grid_->getNumCells(DIM_Y) : voxel_grid_->getNumCells(DIM_Y);
 }
 
 int PropagationDistanceField::getZNumCells() const
 {
-  return voxel_grid_->getNumCells(DIM_Z);
+  return sparse_storage_ ? sparse_grid_->getNumCells(DIM_Z) : voxel_grid_->getNumCells(DIM_Z);
 }
 
 bool PropagationDistanceField::gridToWorld(int x, int y, int z, double& world_x, double& world_y, double& world_z) const
 {
-  voxel_grid_->gridToWorld(x, y, z, world_x, world_y, world_z);
+  if (sparse_storage_)
+    sparse_grid_->gridToWorld(x, y, z, world_x, world_y, world_z);
+  else
+    voxel_grid_->gridToWorld(x, y, z, world_x, world_y, world_z);
   return true;
 }
 
 bool PropagationDistanceField::worldToGrid(double world_x, double world_y, double world_z, int& x, int& y, int& z) const
 {
+  if (sparse_storage_)
+    return sparse_grid_->worldToGrid(world_x, world_y, world_z, x, y, z);
   return voxel_grid_->worldToGrid(world_x, world_y, world_z, x, y, z);
 }
 
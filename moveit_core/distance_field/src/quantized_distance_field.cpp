@@ -0,0 +1,384 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/distance_field/quantized_distance_field.h>
+#include <console_bridge/console.h>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+namespace distance_field
+{
+namespace
+{
+static const char FILE_MAGIC[8] = { 'M', 'V', 'T', 'Q', 'D', 'F', '\n', '\0' };
+// written in the byte order of the writer, to detect files from machines of different endianness
+static const boost::uint32_t BYTE_ORDER_MARK = 0x01020304;
+}
+
+// the fixed-size start of the file; the quantized distances follow directly, in VoxelGrid cell order
+struct QuantizedDistanceField::FileHeader
+{
+  char magic[8];
+  boost::uint32_t version;
+  boost::uint32_t byte_order;
+  boost::uint32_t bits;
+  boost::uint32_t compressed;
+  boost::int32_t num_cells[3];
+  boost::uint32_t reserved;
+  double resolution;
+  double origin[3];
+  double min_distance;
+  double max_distance;
+};
+
+QuantizedDistanceField::QuantizedDistanceField() : DistanceField(0, 0, 0, 1, 0, 0, 0)
+{
+  clear();
+}
+
+QuantizedDistanceField::QuantizedDistanceField(const std::string& filename) : DistanceField(0, 0, 0, 1, 0, 0, 0)
+{
+  clear();
+  load(filename);
+}
+
+QuantizedDistanceField::~QuantizedDistanceField()
+{
+}
+
+void QuantizedDistanceField::clear()
+{
+  if (mapped_file_.is_open())
+    mapped_file_.close();
+  buffer_.clear();
+  data_ = NULL;
+  for (int i = 0; i < 3; ++i)
+    num_cells_[i] = 0;
+  max_distance_ = 0.0;
+  min_distance_ = 0.0;
+  step_ = 0.0;
+  bits_ = 16;
+}
+
+std::size_t QuantizedDistanceField::getDataSize() const
+{
+  return std::size_t(num_cells_[0]) * num_cells_[1] * num_cells_[2] * (bits_ / 8);
+}
+
+bool QuantizedDistanceField::save(const DistanceField& field, const std::string& filename, unsigned int bits,
+                                  bool compress)
+{
+  std::ofstream stream(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!stream.good())
+  {
+    logError("Unable to open '%s' for writing the distance field", filename.c_str());
+    return false;
+  }
+  if (!write(field, stream, bits, compress))
+    return false;
+  stream.close();
+  return !stream.fail();
+}
+
+bool QuantizedDistanceField::write(const DistanceField& field, std::ostream& stream, unsigned int bits,
+                                   bool compress)
+{
+  if (bits != 8 && bits != 16)
+  {
+    logError("Distance fields can only be quantized to 8 or 16 bits, not %u", bits);
+    return false;
+  }
+  if (field.getXNumCells() <= 0 || field.getYNumCells() <= 0 || field.getZNumCells() <= 0)
+  {
+    logError("Cannot write an empty distance field");
+    return false;
+  }
+
+  FileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+  header.version = FORMAT_VERSION;
+  header.byte_order = BYTE_ORDER_MARK;
+  header.bits = bits;
+  header.compressed = compress ? 1 : 0;
+  header.num_cells[0] = field.getXNumCells();
+  header.num_cells[1] = field.getYNumCells();
+  header.num_cells[2] = field.getZNumCells();
+  header.resolution = field.getResolution();
+  field.gridToWorld(0, 0, 0, header.origin[0], header.origin[1], header.origin[2]);
+  header.max_distance = field.getUninitializedDistance();
+
+  const std::size_t num_cells = std::size_t(header.num_cells[0]) * header.num_cells[1] * header.num_cells[2];
+  std::vector<double> distances;
+  distances.reserve(num_cells);
+  header.min_distance = header.max_distance;
+  for (int x = 0; x < header.num_cells[0]; ++x)
+    for (int y = 0; y < header.num_cells[1]; ++y)
+      for (int z = 0; z < header.num_cells[2]; ++z)
+      {
+        distances.push_back(field.getDistance(x, y, z));
+        header.min_distance = std::min(header.min_distance, distances.back());
+      }
+
+  const unsigned int max_value = (1u << bits) - 1;
+  const double range = header.max_distance - header.min_distance;
+  const double inv_step = range > 0.0 ? max_value / range : 0.0;
+  std::vector<char> data(num_cells * (bits / 8));
+  for (std::size_t i = 0; i < num_cells; ++i)
+  {
+    double value = (std::min(distances[i], header.max_distance) - header.min_distance) * inv_step + 0.5;
+    unsigned int q = std::min(static_cast<unsigned int>(value), max_value);
+    if (bits == 8)
+      reinterpret_cast<boost::uint8_t*>(&data[0])[i] = q;
+    else
+      reinterpret_cast<boost::uint16_t*>(&data[0])[i] = q;
+  }
+
+  stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  if (compress)
+  {
+    boost::iostreams::filtering_ostream out;
+    out.push(boost::iostreams::zlib_compressor());
+    out.push(stream);
+    out.write(&data[0], data.size());
+    out.flush();
+  }
+  else
+    stream.write(&data[0], data.size());
+  return stream.good();
+}
+
+bool QuantizedDistanceField::readHeader(const FileHeader& header)
+{
+  if (std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0)
+  {
+    logError("Not a quantized distance field");
+    return false;
+  }
+  if (header.byte_order != BYTE_ORDER_MARK)
+  {
+    logError("Quantized distance field was written on a machine with a different byte order");
+    return false;
+  }
+  if (header.version != FORMAT_VERSION)
+  {
+    logError("Unsupported quantized distance field version %u (expected %u)", header.version, FORMAT_VERSION);
+    return false;
+  }
+  if ((header.bits != 8 && header.bits != 16) || header.num_cells[0] <= 0 || header.num_cells[1] <= 0 ||
+      header.num_cells[2] <= 0 || header.resolution <= 0.0)
+  {
+    logError("Invalid quantized distance field header");
+    return false;
+  }
+
+  bits_ = header.bits;
+  for (int i = 0; i < 3; ++i)
+    num_cells_[i] = header.num_cells[i];
+  resolution_ = header.resolution;
+  inv_twice_resolution_ = 1.0 / (2.0 * resolution_);
+  origin_x_ = header.origin[0];
+  origin_y_ = header.origin[1];
+  origin_z_ = header.origin[2];
+  size_x_ = num_cells_[0] * resolution_;
+  size_y_ = num_cells_[1] * resolution_;
+  size_z_ = num_cells_[2] * resolution_;
+  min_distance_ = header.min_distance;
+  max_distance_ = header.max_distance;
+  step_ = (max_distance_ - min_distance_) / ((1u << bits_) - 1);
+  return true;
+}
+
+bool QuantizedDistanceField::readDistances(std::istream& stream, bool compressed)
+{
+  buffer_.resize(getDataSize());
+  if (compressed)
+  {
+    boost::iostreams::filtering_istream in;
+    in.push(boost::iostreams::zlib_decompressor());
+    in.push(stream);
+    in.read(&buffer_[0], buffer_.size());
+    if (in.gcount() != static_cast<std::streamsize>(buffer_.size()))
+      return false;
+  }
+  else
+  {
+    stream.read(&buffer_[0], buffer_.size());
+    if (stream.gcount() != static_cast<std::streamsize>(buffer_.size()))
+      return false;
+  }
+  data_ = &buffer_[0];
+  return true;
+}
+
+bool QuantizedDistanceField::load(const std::string& filename)
+{
+  clear();
+  try
+  {
+    mapped_file_.open(filename);
+  }
+  catch (std::exception& ex)
+  {
+    logError("Unable to map distance field '%s': %s", filename.c_str(), ex.what());
+    return false;
+  }
+
+  FileHeader header;
+  if (mapped_file_.size() < sizeof(header))
+  {
+    logError("Distance field '%s' is truncated", filename.c_str());
+    clear();
+    return false;
+  }
+  std::memcpy(&header, mapped_file_.data(), sizeof(header));
+  if (!readHeader(header))
+  {
+    clear();
+    return false;
+  }
+
+  if (!header.compressed)
+  {
+    if (mapped_file_.size() < sizeof(header) + getDataSize())
+    {
+      logError("Distance field '%s' is truncated", filename.c_str());
+      clear();
+      return false;
+    }
+    data_ = mapped_file_.data() + sizeof(header);
+    return true;
+  }
+
+  // compressed distances cannot be used in place
+  mapped_file_.close();
+  std::ifstream stream(filename.c_str(), std::ios::in | std::ios::binary);
+  stream.seekg(sizeof(header));
+  if (!readDistances(stream, true))
+  {
+    logError("Unable to decompress distance field '%s'", filename.c_str());
+    clear();
+    return false;
+  }
+  return true;
+}
+
+bool QuantizedDistanceField::writeToStream(std::ostream& stream) const
+{
+  return write(*this, stream, bits_, false);
+}
+
+bool QuantizedDistanceField::readFromStream(std::istream& stream)
+{
+  clear();
+  FileHeader header;
+  stream.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (stream.gcount() != static_cast<std::streamsize>(sizeof(header)) || !readHeader(header) || !readDistances(stream, header.compressed))
+  {
+    clear();
+    return false;
+  }
+  return true;
+}
+
+void QuantizedDistanceField::addPointsToField(const EigenSTL::vector_Vector3d& points)
+{
+  logError("Cannot add points to a read-only quantized distance field");
+}
+
+void QuantizedDistanceField::removePointsFromField(const EigenSTL::vector_Vector3d& points)
+{
+  logError("Cannot remove points from a read-only quantized distance field");
+}
+
+void QuantizedDistanceField::updatePointsInField(const EigenSTL::vector_Vector3d& old_points,
+                                                 const EigenSTL::vector_Vector3d& new_points)
+{
+  logError("Cannot update points in a read-only quantized distance field");
+}
+
+void QuantizedDistanceField::reset()
+{
+  logError("Cannot reset a read-only quantized distance field");
+}
+
+double QuantizedDistanceField::getDistance(double x, double y, double z) const
+{
+  int gx, gy, gz;
+  if (!worldToGrid(x, y, z, gx, gy, gz))
+    return max_distance_;
+  return getDistance(gx, gy, gz);
+}
+
+bool QuantizedDistanceField::isCellValid(int x, int y, int z) const
+{
+  return x >= 0 && x < num_cells_[0] && y >= 0 && y < num_cells_[1] && z >= 0 && z < num_cells_[2];
+}
+
+int QuantizedDistanceField::getXNumCells() const
+{
+  return num_cells_[0];
+}
+
+int QuantizedDistanceField::getYNumCells() const
+{
+  return num_cells_[1];
+}
+
+int QuantizedDistanceField::getZNumCells() const
+{
+  return num_cells_[2];
+}
+
+bool QuantizedDistanceField::gridToWorld(int x, int y, int z, double& world_x, double& world_y, double& world_z) const
+{
+  world_x = origin_x_ + resolution_ * x;
+  world_y = origin_y_ + resolution_ * y;
+  world_z = origin_z_ + resolution_ * z;
+  return true;
+}
+
+bool QuantizedDistanceField::worldToGrid(double world_x, double world_y, double world_z, int& x, int& y, int& z) const
+{
+  // the rounded quantized location, computed as in VoxelGrid
+  const double oo_resolution = 1.0 / resolution_;
+  x = int(floor((world_x - (origin_x_ - 0.5 * resolution_)) * oo_resolution));
+  y = int(floor((world_y - (origin_y_ - 0.5 * resolution_)) * oo_resolution));
+  z = int(floor((world_z - (origin_z_ - 0.5 * resolution_)) * oo_resolution));
+  return isCellValid(x, y, z);
+}
+}
@@ -38,6 +38,8 @@
 
 #include <moveit/distance_field/voxel_grid.h>
 #include <moveit/distance_field/propagation_distance_field.h>
+#include <moveit/distance_field/euclidean_distance_field.h>
+#include <moveit/distance_field/quantized_distance_field.h>
 #include <moveit/distance_field/find_internal_points.h>
 #include <console_bridge/console.h>
 #include <geometric_shapes/body_operations.h>
@@ -45,6 +47,7 @@
 #include <octomap/octomap.h>
 
 #include <memory>
+#include <sstream>
 
 using namespace distance_field;
 
@@ -429,6 +432,30 @@ TEST(TestPropagationDistanceField, TestAddRemovePoints)
     }
   }
   ASSERT_FALSE(first);
+
+  // the batched lookup agrees with the lookup of single locations, including out of bounds
+  EigenSTL::vector_Vector3d lookup_points;
+  for (int x = 0; x < df.getXNumCells(); x++)
+    for (int y = 0; y < df.getYNumCells(); y++)
+    {
+      double wx, wy, wz;
+      df.gridToWorld(x, y, 1, wx, wy, wz);
+      lookup_points.push_back(Eigen::Vector3d(wx, wy, wz));
+    }
+  lookup_points.push_back(Eigen::Vector3d(1000.0, 1000.0, 1000.0));
+  std::vector<double> distances;
+  EigenSTL::vector_Vector3d gradients;
+  df.getDistanceGradients(lookup_points, distances, gradients);
+  ASSERT_EQ(distances.size(), lookup_points.size());
+  ASSERT_EQ(gradients.size(), lookup_points.size());
+  for (std::size_t i = 0; i < lookup_points.size(); i++)
+  {
+    Eigen::Vector3d grad(0.0, 0.0, 0.0);
+    double dist = df.getDistanceGradient(lookup_points[i].x(), lookup_points[i].y(), lookup_points[i].z(), grad.x(),
+                                         grad.y(), grad.z(), in_bounds);
+    EXPECT_NEAR(dist, distances[i], .0001) << i;
+    EXPECT_NEAR((grad - gradients[i]).norm(), 0.0, .0001) << i;
+  }
 }
 
 TEST(TestSignedPropagationDistanceField, TestSignedAddRemovePoints)
@@ -932,6 +959,190 @@ TEST(TestSignedPropagationDistanceField, TestReadWrite)
   EXPECT_FALSE(areDistanceFieldsDistancesEqual(df, df3));
 }
 
+TEST(TestSignedPropagationDistanceField, TestSparseStorage)
+{
+  PropagationDistanceField dense_df(PERF_WIDTH, PERF_HEIGHT, PERF_DEPTH, PERF_RESOLUTION, PERF_ORIGIN_X, PERF_ORIGIN_Y,
+                                    PERF_ORIGIN_Z, PERF_MAX_DIST, true);
+  PropagationDistanceField sparse_df(PERF_WIDTH, PERF_HEIGHT, PERF_DEPTH, PERF_RESOLUTION, PERF_ORIGIN_X,
+                                     PERF_ORIGIN_Y, PERF_ORIGIN_Z, PERF_MAX_DIST, true, true);
+
+  shapes::Sphere sphere(.25);
+  Eigen::Affine3d p = Eigen::Translation3d(0.5, 0.5, 0.5) * Eigen::Quaterniond(0.0, 0.0, 0.0, 1.0);
+  dense_df.addShapeToField(&sphere, p);
+  sparse_df.addShapeToField(&sphere, p);
+  EXPECT_TRUE(areDistanceFieldsDistancesEqual(dense_df, sparse_df));
+
+  Eigen::Affine3d np = Eigen::Translation3d(0.7, 0.5, 0.5) * Eigen::Quaterniond(0.0, 0.0, 0.0, 1.0);
+  dense_df.moveShapeInField(&sphere, p, np);
+  sparse_df.moveShapeInField(&sphere, p, np);
+  EXPECT_TRUE(areDistanceFieldsDistancesEqual(dense_df, sparse_df));
+
+  EigenSTL::vector_Vector3d points;
+  points.push_back(Eigen::Vector3d(2.5, 2.5, 3.5));
+  dense_df.addPointsToField(points);
+  sparse_df.addPointsToField(points);
+  EXPECT_TRUE(areDistanceFieldsDistancesEqual(dense_df, sparse_df));
+  EXPECT_NEAR(sparse_df.getDistance(2.5, 2.5, 3.6), dense_df.getDistance(2.5, 2.5, 3.6), 1e-6);
+
+  sparse_df.reset();
+  dense_df.reset();
+  EXPECT_TRUE(areDistanceFieldsDistancesEqual(dense_df, sparse_df));
+}
+
+TEST(TestSignedPropagationDistanceField, TestInterpolatedDistances)
+{
+  PropagationDistanceField df(width, height, depth, resolution, origin_x, origin_y, origin_z, max_dist, true);
+  PropagationDistanceField sparse_df(width, height, depth, resolution, origin_x, origin_y, origin_z, max_dist, true,
+                                     true);
+  EigenSTL::vector_Vector3d obstacles;
+  obstacles.push_back(Eigen::Vector3d(0.5, 0.5, 0.5));
+  obstacles.push_back(Eigen::Vector3d(0.6, 0.5, 0.5));
+  df.addPointsToField(obstacles);
+  sparse_df.addPointsToField(obstacles);
+
+  EigenSTL::vector_Vector3d points;
+  points.push_back(Eigen::Vector3d(0.3, 0.5, 0.5));    // a cell center
+  points.push_back(Eigen::Vector3d(0.35, 0.5, 0.5));   // halfway between two cell centers
+  points.push_back(Eigen::Vector3d(0.42, 0.47, 0.53));
+  points.push_back(Eigen::Vector3d(0.55, 0.5, 0.5));   // between two obstacle cells
+  points.push_back(Eigen::Vector3d(-0.1, 0.5, 0.5));   // outside
+  points.push_back(Eigen::Vector3d(0.5, 0.5, 0.95));   // beyond the last cell center
+
+  std::vector<double> distances(points.size()), base_distances(points.size()), sparse_distances(points.size());
+  EigenSTL::vector_Vector3d gradients(points.size()), base_gradients(points.size()), sparse_gradients(points.size());
+  df.getDistancesAndGradients(&points[0], points.size(), &distances[0], &gradients[0]);
+  df.DistanceField::getDistancesAndGradients(&points[0], points.size(), &base_distances[0], &base_gradients[0]);
+  sparse_df.getDistancesAndGradients(&points[0], points.size(), &sparse_distances[0], &sparse_gradients[0]);
+  for (unsigned int i = 0; i < points.size(); i++)
+  {
+    EXPECT_NEAR(distances[i], base_distances[i], 1e-9);
+    EXPECT_NEAR(distances[i], sparse_distances[i], 1e-9);
+    EXPECT_NEAR((gradients[i] - base_gradients[i]).norm(), 0.0, 1e-9);
+    EXPECT_NEAR((gradients[i] - sparse_gradients[i]).norm(), 0.0, 1e-9);
+  }
+
+  EXPECT_NEAR(distances[0], 0.2, 1e-6);
+  EXPECT_NEAR(distances[1], 0.15, 1e-6);
+  EXPECT_NEAR(gradients[1].x(), -1.0, 1e-6);
+  EXPECT_NEAR(distances[3], -resolution, 1e-6);
+  EXPECT_NEAR(distances[4], df.getUninitializedDistance(), 1e-9);
+  EXPECT_NEAR(gradients[4].norm(), 0.0, 1e-9);
+  EXPECT_NEAR(distances[5], df.getUninitializedDistance(), 1e-9);
+}
+
+TEST(TestEuclideanDistanceField, TestAddRemovePoints)
+{
+  EuclideanDistanceField df(width, height, depth, resolution, origin_x, origin_y, origin_z, max_dist);
+  EXPECT_NEAR(df.getDistance(5, 5, 5), max_dist, 1e-6);
+
+  EigenSTL::vector_Vector3d points;
+  points.push_back(point1);
+  points.push_back(point2);
+  points.push_back(point3);
+  df.addPointsToField(points);
+
+  // the distances are exact, up to the maximum distance
+  for (int x = 0; x < df.getXNumCells(); x++)
+  {
+    for (int y = 0; y < df.getYNumCells(); y++)
+    {
+      for (int z = 0; z < df.getZNumCells(); z++)
+      {
+        double closest = max_dist;
+        for (unsigned int i = 0; i < points.size(); i++)
+        {
+          int px, py, pz;
+          df.worldToGrid(points[i].x(), points[i].y(), points[i].z(), px, py, pz);
+          closest = std::min(closest, sqrt(double(dist_sq(x - px, y - py, z - pz))) * resolution);
+        }
+        ASSERT_NEAR(df.getDistance(x, y, z), closest, 1e-6) << x << " " << y << " " << z;
+      }
+    }
+  }
+
+  EigenSTL::vector_Vector3d removed;
+  removed.push_back(point1);
+  removed.push_back(point2);
+  df.removePointsFromField(removed);
+  EXPECT_FALSE(df.isOccupied(1, 0, 0));
+  EXPECT_NEAR(df.getDistance(2, 0, 0), 0.2, 1e-6);
+
+  df.reset();
+  EXPECT_FALSE(df.isOccupied(4, 0, 0));
+  EXPECT_NEAR(df.getDistance(4, 0, 0), max_dist, 1e-6);
+}
+
+TEST(TestEuclideanDistanceField, TestSignedShape)
+{
+  PropagationDistanceField pdf(width, height, depth, resolution, origin_x, origin_y, origin_z, max_dist, true);
+  EuclideanDistanceField edf(width, height, depth, resolution, origin_x, origin_y, origin_z, max_dist, true);
+
+  shapes::Sphere sphere(0.25);
+  Eigen::Affine3d p = Eigen::Translation3d(0.5, 0.5, 0.5) * Eigen::Quaterniond(0.0, 0.0, 0.0, 1.0);
+  pdf.addShapeToField(&sphere, p);
+  edf.addShapeToField(&sphere, p);
+
+  // the propagation field approximates the exact distances to within a cell
+  for (int x = 0; x < edf.getXNumCells(); x++)
+  {
+    for (int y = 0; y < edf.getYNumCells(); y++)
+    {
+      for (int z = 0; z < edf.getZNumCells(); z++)
+      {
+        EXPECT_EQ(edf.isOccupied(x, y, z), pdf.getCell(x, y, z).distance_square_ == 0);
+        ASSERT_NEAR(edf.getDistance(x, y, z), pdf.getDistance(x, y, z), resolution) << x << " " << y << " " << z;
+      }
+    }
+  }
+
+  std::stringstream stream;
+  edf.writeToStream(stream);
+  PropagationDistanceField pdf2(stream, max_dist, true);
+  EXPECT_TRUE(areDistanceFieldsDistancesEqual(pdf, pdf2));
+}
+
+TEST(TestQuantizedDistanceField, TestSaveLoad)
+{
+  PropagationDistanceField df(width, height, depth, resolution, origin_x, origin_y, origin_z, max_dist, true);
+  shapes::Sphere sphere(0.25);
+  Eigen::Affine3d p = Eigen::Translation3d(0.5, 0.5, 0.5) * Eigen::Quaterniond(0.0, 0.0, 0.0, 1.0);
+  df.addShapeToField(&sphere, p);
+
+  for (unsigned int bits = 8; bits <= 16; bits += 8)
+  {
+    for (int compress = 0; compress < 2; compress++)
+    {
+      ASSERT_TRUE(QuantizedDistanceField::save(df, "test_quantized.df", bits, compress));
+      QuantizedDistanceField qdf("test_quantized.df");
+      ASSERT_TRUE(qdf.isLoaded());
+      EXPECT_EQ(qdf.isMapped(), !compress);
+      EXPECT_EQ(qdf.getBits(), bits);
+      ASSERT_EQ(qdf.getXNumCells(), df.getXNumCells());
+      ASSERT_EQ(qdf.getYNumCells(), df.getYNumCells());
+      ASSERT_EQ(qdf.getZNumCells(), df.getZNumCells());
+      EXPECT_EQ(qdf.getUninitializedDistance(), df.getUninitializedDistance());
+
+      // half a quantization step between the smallest distance and the maximum distance
+      const double tolerance = 2.0 * max_dist / ((1 << bits) - 1);
+      for (int x = 0; x < df.getXNumCells(); x++)
+        for (int y = 0; y < df.getYNumCells(); y++)
+          for (int z = 0; z < df.getZNumCells(); z++)
+            ASSERT_NEAR(qdf.getDistance(x, y, z), df.getDistance(x, y, z), tolerance);
+      EXPECT_NEAR(qdf.getDistance(0.51, 0.52, 0.13), df.getDistance(0.51, 0.52, 0.13), tolerance);
+      EXPECT_EQ(qdf.getDistance(-1.0, 0.5, 0.5), qdf.getUninitializedDistance());
+
+      // the field is read-only
+      EigenSTL::vector_Vector3d points;
+      points.push_back(point1);
+      qdf.addPointsToField(points);
+      EXPECT_NEAR(qdf.getDistance(1, 0, 0), df.getDistance(1, 0, 0), tolerance);
+    }
+  }
+
+  QuantizedDistanceField missing("no_such_file.df");
+  EXPECT_FALSE(missing.isLoaded());
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
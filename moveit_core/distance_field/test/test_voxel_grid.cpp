@@ -37,6 +37,7 @@
 #include <gtest/gtest.h>
 
 #include <moveit/distance_field/voxel_grid.h>
+#include <moveit/distance_field/sparse_voxel_grid.h>
 #include <ros/ros.h>
 
 using namespace distance_field;
@@ -95,6 +96,43 @@ TEST(TestVoxelGrid, TestReadWrite)
       }
 }
 
+TEST(TestSparseVoxelGrid, TestReadWrite)
+{
+  int def = -100;
+  SparseVoxelGrid<int> vg(0.2, 0.1, 0.3, 0.01, 0, 0, 0, def);
+  const SparseVoxelGrid<int>& cvg = vg;
+
+  EXPECT_EQ(vg.getNumCells(DIM_X), 20);
+  EXPECT_EQ(vg.getNumCells(DIM_Y), 10);
+  EXPECT_EQ(vg.getNumCells(DIM_Z), 30);
+
+  // reading does not allocate
+  EXPECT_EQ(cvg.getCell(5, 5, 5), def);
+  EXPECT_EQ(cvg(0.1, 0.05, 0.2), def);
+  EXPECT_EQ(cvg(-1.0, 0.0, 0.0), def);
+  EXPECT_EQ(vg.getNumAllocatedBlocks(), 0u);
+
+  // writing allocates the block of the cell only
+  vg.getCell(1, 2, 3) = 7;
+  vg.setCell(19, 9, 29, 8);
+  EXPECT_EQ(vg.getNumAllocatedBlocks(), 2u);
+  EXPECT_EQ(cvg.getCell(1, 2, 3), 7);
+  EXPECT_EQ(cvg.getCell(19, 9, 29), 8);
+  EXPECT_EQ(cvg.getCell(0, 0, 0), def);
+  EXPECT_EQ(cvg.getCell(10, 2, 3), def);
+
+  int x, y, z;
+  EXPECT_TRUE(vg.worldToGrid(0.01, 0.02, 0.03, x, y, z));
+  EXPECT_EQ(x, 1);
+  EXPECT_EQ(y, 2);
+  EXPECT_EQ(z, 3);
+  EXPECT_EQ(cvg(0.01, 0.02, 0.03), 7);
+
+  vg.reset(0);
+  EXPECT_EQ(vg.getNumAllocatedBlocks(), 0u);
+  EXPECT_EQ(cvg.getCell(1, 2, 3), 0);
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
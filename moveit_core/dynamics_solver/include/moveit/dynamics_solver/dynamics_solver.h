@@ -42,6 +42,7 @@
 #include <kdl/chainidsolver_recursive_newton_euler.hpp>
 
 #include <moveit/robot_state/robot_state.h>
+#include <moveit/robot_trajectory/robot_trajectory.h>
 #include <geometry_msgs/Vector3.h>
 #include <geometry_msgs/Wrench.h>
 
@@ -115,6 +116,32 @@ public:
   bool getPayloadTorques(const std::vector<double>& joint_angles, double payload,
                          std::vector<double>& joint_torques) const;
 
+  /**
+   * @brief Get the torques for every waypoint of a trajectory, with no external wrenches acting on the
+   * links. Waypoints without velocities or accelerations are computed with zero velocities or accelerations.
+   * The waypoints are split in contiguous ranges that are processed in parallel, each thread using its own
+   * KDL solver and buffers.
+   * @param trajectory The trajectory; it must include the joints of this group
+   * @param torques One vector of torques per waypoint is filled in here (same order as getMaxTorques())
+   * @param max_threads The maximum number of threads to use; 0 uses one per core
+   * @return False if the solver was not initialized or computing the torques failed for a waypoint
+   */
+  bool getTrajectoryTorques(const robot_trajectory::RobotTrajectory& trajectory,
+                            std::vector<std::vector<double> >& torques, unsigned int max_threads = 0) const;
+
+  /**
+   * @brief Check that the torques needed for every waypoint of a trajectory are within the effort limits of the
+   * joints (see getTrajectoryTorques()). Joints without an effort limit are not checked.
+   * @param trajectory The trajectory; it must include the joints of this group
+   * @param first_violation If not NULL, the index of the first waypoint that exceeds a limit is stored here
+   * @param joint_saturated If not NULL, the index of the first joint that exceeds its limit at that waypoint is
+   * stored here
+   * @param max_threads The maximum number of threads to use; 0 uses one per core
+   * @return True if all torques are within the limits; false otherwise, or if the torques could not be computed
+   */
+  bool checkTorqueLimits(const robot_trajectory::RobotTrajectory& trajectory, std::size_t* first_violation = NULL,
+                         unsigned int* joint_saturated = NULL, unsigned int max_threads = 0) const;
+
   /**
    * @brief Get maximum torques for this group
    * @return Vector of max torques
@@ -136,6 +163,11 @@ public:
   }
 
 private:
+  /** \brief Compute the torques for the waypoints [begin, end) of \e trajectory with a solver of its own.
+      \e success is cleared on failure */
+  void getTrajectoryTorquesRange(const robot_trajectory::RobotTrajectory& trajectory, std::size_t begin,
+                                 std::size_t end, std::vector<std::vector<double> >* torques, bool* success) const;
+
   std::shared_ptr<KDL::ChainIdSolver_RNE> chain_id_solver_;  // KDL chain inverse dynamics
   KDL::Chain kdl_chain_;                                     // KDL chain
 
@@ -148,7 +180,8 @@ private:
   unsigned int num_joints_, num_segments_;  // number of joints in group, number of segments in group
   std::vector<double> max_torques_;         // vector of max torques
 
-  double gravity_;  // Norm of the gravity vector passed in initialize()
+  KDL::Vector gravity_vector_;  // Gravity vector passed in initialize(), used by the trajectory solvers
+  double gravity_;              // Norm of the gravity vector passed in initialize()
 };
 }
 #endif
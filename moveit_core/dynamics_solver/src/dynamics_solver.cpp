@@ -45,10 +45,16 @@
 #include <kdl/chainjnttojacsolver.hpp>
 #include <kdl/tree.hpp>
 
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
 namespace dynamics_solver
 {
 namespace
 {
+// fewer waypoints than this per thread are not worth starting a thread for
+const std::size_t MIN_WAYPOINTS_PER_THREAD = 32;
+
 inline geometry_msgs::Vector3 transformVector(const Eigen::Affine3d& transform, const geometry_msgs::Vector3& vector)
 {
   Eigen::Vector3d p;
@@ -133,12 +139,12 @@ DynamicsSolver::DynamicsSolver(const robot_model::RobotModelConstPtr& robot_mode
       max_torques_.push_back(0.0);
   }
 
-  KDL::Vector gravity(gravity_vector.x, gravity_vector.y,
-                      gravity_vector.z);  // \todo Not sure if KDL expects the negative of this (Sachin)
-  gravity_ = gravity.Norm();
+  gravity_vector_ = KDL::Vector(gravity_vector.x, gravity_vector.y,
+                                gravity_vector.z);  // \todo Not sure if KDL expects the negative of this (Sachin)
+  gravity_ = gravity_vector_.Norm();
   logDebug("moveit.dynamics_solver: Gravity norm set to %f", gravity_);
 
-  chain_id_solver_.reset(new KDL::ChainIdSolver_RNE(kdl_chain_, gravity));
+  chain_id_solver_.reset(new KDL::ChainIdSolver_RNE(kdl_chain_, gravity_vector_));
 }
 
 bool DynamicsSolver::getTorques(const std::vector<double>& joint_angles, const std::vector<double>& joint_velocities,
@@ -311,6 +317,125 @@ bool DynamicsSolver::getPayloadTorques(const std::vector<double>& joint_angles,
   return true;
 }
 
+bool DynamicsSolver::getTrajectoryTorques(const robot_trajectory::RobotTrajectory& trajectory,
+                                          std::vector<std::vector<double> >& torques, unsigned int max_threads) const
+{
+  if (!joint_model_group_)
+  {
+    logDebug("moveit.dynamics_solver: Did not construct DynamicsSolver object properly. Check error logs.");
+    return false;
+  }
+  if (joint_model_group_->getVariableCount() != num_joints_)
+  {
+    logError("moveit.dynamics_solver: Group '%s' has %u variables but its chain has %u joints",
+             joint_model_group_->getName().c_str(), joint_model_group_->getVariableCount(), num_joints_);
+    return false;
+  }
+
+  const std::size_t count = trajectory.getWayPointCount();
+  torques.resize(count);
+  if (count == 0)
+    return true;
+
+  if (max_threads == 0)
+    max_threads = std::max(1u, boost::thread::hardware_concurrency());
+  std::size_t thread_count =
+      std::min<std::size_t>(max_threads, std::max<std::size_t>(1, count / MIN_WAYPOINTS_PER_THREAD));
+
+  // each thread gets a contiguous range of waypoints and reports its own success flag
+  std::unique_ptr<bool[]> success(new bool[thread_count]);
+  const std::size_t range = (count + thread_count - 1) / thread_count;
+  boost::thread_group workers;
+  for (std::size_t t = 0; t < thread_count; ++t)
+  {
+    success[t] = true;
+    if (t > 0)
+      workers.create_thread(boost::bind(&DynamicsSolver::getTrajectoryTorquesRange, this, boost::cref(trajectory),
+                                        t * range, std::min(count, (t + 1) * range), &torques, &success[t]));
+  }
+  // the calling thread processes the first range
+  getTrajectoryTorquesRange(trajectory, 0, std::min(count, range), &torques, &success[0]);
+  workers.join_all();
+
+  for (std::size_t t = 0; t < thread_count; ++t)
+    if (!success[t])
+      return false;
+  return true;
+}
+
+void DynamicsSolver::getTrajectoryTorquesRange(const robot_trajectory::RobotTrajectory& trajectory,
+                                               std::size_t begin, std::size_t end,
+                                               std::vector<std::vector<double> >* torques, bool* success) const
+{
+  // KDL solvers keep intermediate results as members, so threads cannot share one
+  KDL::ChainIdSolver_RNE solver(kdl_chain_, gravity_vector_);
+  KDL::JntArray kdl_angles(num_joints_), kdl_velocities(num_joints_), kdl_accelerations(num_joints_),
+      kdl_torques(num_joints_);
+  KDL::Wrenches kdl_wrenches(num_segments_, KDL::Wrench::Zero());
+  std::vector<double> values(num_joints_);
+
+  for (std::size_t i = begin; i < end; ++i)
+  {
+    const robot_state::RobotState& waypoint = trajectory.getWayPoint(i);
+    waypoint.copyJointGroupPositions(joint_model_group_, values);
+    for (unsigned int j = 0; j < num_joints_; ++j)
+      kdl_angles(j) = values[j];
+
+    if (waypoint.hasVelocities())
+    {
+      waypoint.copyJointGroupVelocities(joint_model_group_, values);
+      for (unsigned int j = 0; j < num_joints_; ++j)
+        kdl_velocities(j) = values[j];
+    }
+    else
+      SetToZero(kdl_velocities);
+
+    if (waypoint.hasAccelerations())
+    {
+      waypoint.copyJointGroupAccelerations(joint_model_group_, values);
+      for (unsigned int j = 0; j < num_joints_; ++j)
+        kdl_accelerations(j) = values[j];
+    }
+    else
+      SetToZero(kdl_accelerations);
+
+    if (solver.CartToJnt(kdl_angles, kdl_velocities, kdl_accelerations, kdl_wrenches, kdl_torques) < 0)
+    {
+      logError("moveit.dynamics_solver: Something went wrong computing torques for waypoint %zu", i);
+      *success = false;
+      return;
+    }
+
+    std::vector<double>& waypoint_torques = (*torques)[i];
+    waypoint_torques.resize(num_joints_);
+    for (unsigned int j = 0; j < num_joints_; ++j)
+      waypoint_torques[j] = kdl_torques(j);
+  }
+}
+
+bool DynamicsSolver::checkTorqueLimits(const robot_trajectory::RobotTrajectory& trajectory,
+                                       std::size_t* first_violation, unsigned int* joint_saturated,
+                                       unsigned int max_threads) const
+{
+  std::vector<std::vector<double> > torques;
+  if (!getTrajectoryTorques(trajectory, torques, max_threads))
+    return false;
+
+  for (std::size_t i = 0; i < torques.size(); ++i)
+    for (unsigned int j = 0; j < num_joints_; ++j)
+      if (max_torques_[j] > 0.0 && fabs(torques[i][j]) > max_torques_[j])
+      {
+        logDebug("moveit.dynamics_solver: Waypoint %zu: joint %u needs torque %f, max allowed: %f", i, j,
+                 torques[i][j], max_torques_[j]);
+        if (first_violation)
+          *first_violation = i;
+        if (joint_saturated)
+          *joint_saturated = j;
+        return false;
+      }
+  return true;
+}
+
 const std::vector<double>& DynamicsSolver::getMaxTorques() const
 {
   return max_torques_;
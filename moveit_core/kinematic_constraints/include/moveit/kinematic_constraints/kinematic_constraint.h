@@ -109,6 +109,19 @@ public:
    */
   virtual ConstraintEvaluationResult decide(const robot_state::RobotState& state, bool verbose = false) const = 0;
 
+  /**
+   * \brief Decide whether the constraint is satisfied in each of a
+   * number of states. The default implementation calls decide() for
+   * each state; constraints override this to evaluate all states
+   * together.
+   *
+   * @param [in] states The kinematic states used for evaluation
+   * @param [in] count The number of states
+   * @param [out] results The result for each state
+   */
+  virtual void decideBatch(const robot_state::RobotState* const* states, std::size_t count,
+                           ConstraintEvaluationResult* results) const;
+
   /** \brief This function returns true if this constraint is
       configured and able to decide whether states do meet the
       constraint or not. If this function returns false it means
@@ -149,6 +162,32 @@ public:
   {
   }
 
+  /**
+   * \brief Get a rough estimate of how expensive decide() is,
+   * relative to a joint constraint. Constraint sets check cheaper
+   * constraints first when only satisfaction is asked for.
+   *
+   * @return The relative cost of decide()
+   */
+  virtual double getEvaluationCost() const
+  {
+    return 1.0;
+  }
+
+  /**
+   * \brief Append the links whose global transforms decide() reads to
+   * \e links, so that only those need to be computed before the
+   * constraint is checked (see RobotState::updateLinkTransformChain()).
+   *
+   * @return False if decide() may read other transforms too (frames,
+   * attached bodies, collision bodies), and the link transforms of the
+   * state need a full update
+   */
+  virtual bool getLinkDependencies(std::vector<const robot_model::LinkModel*>& links) const
+  {
+    return false;
+  }
+
   /**
    *
    * \brief The weight of a constraint is a multiplicative factor associated to the distance computed by the decide()
@@ -247,9 +286,16 @@ public:
   virtual bool equal(const KinematicConstraint& other, double margin) const;
 
   virtual ConstraintEvaluationResult decide(const robot_state::RobotState& state, bool verbose = false) const;
+  virtual void decideBatch(const robot_state::RobotState* const* states, std::size_t count,
+                           ConstraintEvaluationResult* results) const;
   virtual bool enabled() const;
   virtual void clear();
   virtual void print(std::ostream& out = std::cout) const;
+  // decide() only reads joint values
+  virtual bool getLinkDependencies(std::vector<const robot_model::LinkModel*>& links) const
+  {
+    return true;
+  }
 
   /**
    * \brief Get the joint model for which this constraint operates
@@ -396,8 +442,15 @@ public:
 
   virtual void clear();
   virtual ConstraintEvaluationResult decide(const robot_state::RobotState& state, bool verbose = false) const;
+  virtual void decideBatch(const robot_state::RobotState* const* states, std::size_t count,
+                           ConstraintEvaluationResult* results) const;
   virtual bool enabled() const;
   virtual void print(std::ostream& out = std::cout) const;
+  virtual double getEvaluationCost() const
+  {
+    return 2.0;
+  }
+  virtual bool getLinkDependencies(std::vector<const robot_model::LinkModel*>& links) const;
 
   /**
    * \brief Gets the subject link model
@@ -567,8 +620,15 @@ public:
 
   virtual void clear();
   virtual ConstraintEvaluationResult decide(const robot_state::RobotState& state, bool verbose = false) const;
+  virtual void decideBatch(const robot_state::RobotState* const* states, std::size_t count,
+                           ConstraintEvaluationResult* results) const;
   virtual bool enabled() const;
   virtual void print(std::ostream& out = std::cout) const;
+  virtual double getEvaluationCost() const
+  {
+    return 4.0;
+  }
+  virtual bool getLinkDependencies(std::vector<const robot_model::LinkModel*>& links) const;
 
   /**
    * \brief Returns the associated link model, or NULL if not enabled
@@ -647,6 +707,33 @@ public:
   void swapLinkModel(const robot_model::LinkModel* new_link, const Eigen::Affine3d& update);
 
 protected:
+  /**
+   * \brief Precomputed data that answers most containment queries for
+   * a region without the exact test, in the frame of the region.
+   * Points outside of the bounding sphere are outside of the region,
+   * and since all bodies are convex, points in a voxel whose corners
+   * are all inside the region are inside as well.
+   */
+  struct RegionLookup
+  {
+    Eigen::Vector3d center;      /**< \brief Center of the bounding sphere */
+    double radius_squared;       /**< \brief Squared radius of the bounding sphere */
+    Eigen::Vector3d grid_origin; /**< \brief Lowest corner of the voxel grid */
+    double cell_size;            /**< \brief Edge length of a voxel */
+    unsigned int cells;          /**< \brief Voxels along each axis; 0 if there is no grid */
+    std::vector<char> inside;    /**< \brief For each voxel, whether it is entirely inside the region */
+  };
+
+  /** \brief Compute region_lookup_ and region_inverse_pose_ for the configured regions */
+  void buildRegionLookup();
+
+  /** \brief Quick containment test of a point given in the frame of region \e i:
+   * 1 if it is inside, -1 if it is outside and 0 if the exact test is needed */
+  int quickRegionTest(std::size_t i, const Eigen::Vector3d& local_pt) const;
+
+  /** \brief Whether the (fixed frame) region \e i contains \e pt, falling back to the exact test when needed */
+  bool regionContainsPoint(std::size_t i, const Eigen::Vector3d& pt, bool verbose) const;
+
   Eigen::Vector3d offset_;                         /**< \brief The target offset */
   bool has_offset_;                                /**< \brief Whether the offset is substantially different than 0.0 */
   std::vector<bodies::BodyPtr> constraint_region_; /**< \brief The constraint region vector */
@@ -654,9 +741,61 @@ protected:
   bool mobile_frame_;                                /**< \brief Whether or not a mobile frame is employed*/
   std::string constraint_frame_id_;                  /**< \brief The constraint frame id */
   const robot_model::LinkModel* link_model_;         /**< \brief The link model constraint subject */
+  std::vector<RegionLookup> region_lookup_;          /**< \brief Quick containment tests, per region */
+  EigenSTL::vector_Affine3d region_inverse_pose_;    /**< \brief Inverse poses of the (fixed frame) regions */
 };
 
 MOVEIT_CLASS_FORWARD(VisibilityConstraint);
+MOVEIT_CLASS_FORWARD(VisibilityEvaluator);
+
+/**
+ * \brief Interface for deciding whether the target of a
+ * VisibilityConstraint is occluded by the robot.
+ *
+ * By default a VisibilityConstraint checks a cone mesh for collisions
+ * with the robot. An evaluator set with
+ * VisibilityConstraint::setVisibilityEvaluator replaces that check,
+ * for instance by rendering the robot from the sensor's viewpoint.
+ * Evaluators are only asked about states that already satisfy the
+ * view and range angle checks.
+ */
+class VisibilityEvaluator
+{
+public:
+  virtual ~VisibilityEvaluator()
+  {
+  }
+
+  /**
+   * \brief Decide whether the target of \e constraint is visible from its sensor in \e state
+   *
+   * @param [in] constraint The visibility constraint being evaluated
+   * @param [in] state The state to evaluate, with up to date link transforms
+   * @param [in] verbose Whether to print information about the evaluation
+   *
+   * @return Satisfied if the target is not occluded by the robot
+   */
+  virtual ConstraintEvaluationResult decideOcclusion(const VisibilityConstraint& constraint,
+                                                     const robot_state::RobotState& state, bool verbose) = 0;
+
+  /**
+   * \brief Decide the occlusion of the target of \e constraint for several states at once
+   *
+   * The default implementation calls decideOcclusion() for each state; evaluators that can
+   * amortize setup over many states should override it.
+   *
+   * @param [in] constraint The visibility constraint being evaluated
+   * @param [in] states The states to evaluate, with up to date link transforms
+   * @param [in] count The number of states
+   * @param [out] results The result for each state
+   */
+  virtual void decideOcclusion(const VisibilityConstraint& constraint, const robot_state::RobotState* const* states,
+                               std::size_t count, ConstraintEvaluationResult* results)
+  {
+    for (std::size_t i = 0; i < count; ++i)
+      results[i] = decideOcclusion(constraint, *states[i], false);
+  }
+};
 
 /**
  * \brief Class for constraints on the visibility relationship between
@@ -826,9 +965,80 @@ public:
 
   virtual bool enabled() const;
   virtual ConstraintEvaluationResult decide(const robot_state::RobotState& state, bool verbose = false) const;
+
+  /**
+   * \brief The angle checks are done per state. If a \ref
+   * VisibilityEvaluator is set, the occlusion of all remaining states
+   * is decided by a single call to it.
+   */
+  virtual void decideBatch(const robot_state::RobotState* const* states, std::size_t count,
+                           ConstraintEvaluationResult* results) const;
+
   virtual void print(std::ostream& out = std::cout) const;
+  // decide() checks a cone for collisions with the robot
+  virtual double getEvaluationCost() const
+  {
+    return 100.0;
+  }
+
+  /**
+   * \brief Replace the cone collision check with \e evaluator. Passing an empty pointer restores the cone check
+   */
+  void setVisibilityEvaluator(const VisibilityEvaluatorPtr& evaluator)
+  {
+    evaluator_ = evaluator;
+  }
+
+  const VisibilityEvaluatorPtr& getVisibilityEvaluator() const
+  {
+    return evaluator_;
+  }
+
+  /** \brief Get the pose of the sensor in the model frame for \e state */
+  Eigen::Affine3d getSensorPose(const robot_state::RobotState& state) const
+  {
+    return mobile_sensor_frame_ ? Eigen::Affine3d(state.getFrameTransform(sensor_frame_id_) * sensor_pose_) :
+                                  sensor_pose_;
+  }
+
+  /** \brief Get the pose of the target disc in the model frame for \e state */
+  Eigen::Affine3d getTargetPose(const robot_state::RobotState& state) const
+  {
+    return mobile_target_frame_ ? Eigen::Affine3d(state.getFrameTransform(target_frame_id_) * target_pose_) :
+                                  target_pose_;
+  }
+
+  const std::string& getSensorFrameId() const
+  {
+    return sensor_frame_id_;
+  }
+
+  const std::string& getTargetFrameId() const
+  {
+    return target_frame_id_;
+  }
+
+  double getTargetRadius() const
+  {
+    return target_radius_;
+  }
+
+  /**
+   * \brief Check the visibility cone for collisions with the robot
+   *
+   * This is the occlusion test used when no \ref VisibilityEvaluator
+   * is set. Evaluators may fall back to it.
+   */
+  ConstraintEvaluationResult decideCone(const robot_state::RobotState& state, bool verbose) const;
 
 protected:
+  /**
+   * \brief Check the view and range angles of the sensor relative to the target
+   *
+   * @return True if neither angle is violated
+   */
+  bool decideViewAngles(const robot_state::RobotState& state, bool verbose) const;
+
   /**
    * \brief Function that gets passed into collision checking to allow some collisions.
    *
@@ -854,6 +1064,7 @@ protected:
   double target_radius_;             /**< \brief Storage for the target radius */
   double max_view_angle_;            /**< \brief Storage for the max view angle */
   double max_range_angle_;           /**< \brief Storage for the max range angle */
+  VisibilityEvaluatorPtr evaluator_; /**< \brief Optional replacement for the cone collision check */
 };
 
 MOVEIT_CLASS_FORWARD(KinematicConstraintSet);
@@ -877,7 +1088,8 @@ public:
    *
    * @param [in] model The kinematic model used for constraint evaluation
    */
-  KinematicConstraintSet(const robot_model::RobotModelConstPtr& model) : robot_model_(model)
+  KinematicConstraintSet(const robot_model::RobotModelConstPtr& model)
+    : robot_model_(model), link_dependencies_known_(true)
   {
   }
 
@@ -971,6 +1183,44 @@ public:
   ConstraintEvaluationResult decide(const robot_state::RobotState& state,
                                     std::vector<ConstraintEvaluationResult>& results, bool verbose = false) const;
 
+  /**
+   * \brief Determines whether all constraints are satisfied by state.
+   *
+   * Unlike decide(), this checks the constraints in order of their
+   * getEvaluationCost() and stops at the first one that is violated,
+   * so no distance is computed.
+   *
+   * @param [in] state The state to test
+   * @param [in] verbose Whether or not to make each constraint give debug output
+   *
+   * @return True if all constraints are satisfied
+   */
+  bool isSatisfied(const robot_state::RobotState& state, bool verbose = false) const;
+
+  /**
+   * \brief Bring the link transforms of \e state that the constraints
+   * read up to date. When all constraints report their dependencies
+   * (see KinematicConstraint::getLinkDependencies()), only the chains
+   * leading to those links are computed, so a violated constraint can
+   * be detected without a full forward kinematics update. Otherwise
+   * this is RobotState::updateLinkTransforms().
+   *
+   * @param [in,out] state The state to update
+   */
+  void updateLinkTransforms(robot_state::RobotState& state) const;
+
+  /**
+   * \brief Determines whether all constraints are satisfied by each
+   * of a number of states, evaluating each constraint for all states
+   * at once with KinematicConstraint::decideBatch().
+   *
+   * @param [in] states The states to test
+   * @param [in] count The number of states
+   * @param [out] results For each state, the same result decide() gives
+   */
+  void decideBatch(const robot_state::RobotState* const* states, std::size_t count,
+                   ConstraintEvaluationResult* results) const;
+
   /**
    * \brief Whether or not another KinematicConstraintSet is equal to
    * this one.
@@ -1061,6 +1311,17 @@ public:
     return kinematic_constraints_.empty();
   }
 
+  /**
+   * \brief Use \e evaluator for deciding occlusion in all current
+   * and future visibility constraints of the set
+   */
+  void setVisibilityEvaluator(const VisibilityEvaluatorPtr& evaluator);
+
+  const VisibilityEvaluatorPtr& getVisibilityEvaluator() const
+  {
+    return visibility_evaluator_;
+  }
+
 protected:
   robot_model::RobotModelConstPtr robot_model_; /**< \brief The kinematic model used for by the Set */
   std::vector<KinematicConstraintPtr>
@@ -1075,6 +1336,20 @@ protected:
   std::vector<moveit_msgs::VisibilityConstraint> visibility_constraints_;   /**<  \brief Messages corresponding to all
                                                                                internal visibility constraints */
   moveit_msgs::Constraints all_constraints_; /**<  \brief Messages corresponding to all internal constraints */
+
+  std::vector<unsigned int> evaluation_order_; /**<  \brief Indices of kinematic_constraints_, cheapest first */
+
+  std::vector<const robot_model::LinkModel*> link_dependencies_; /**<  \brief Links whose transforms are read */
+  bool link_dependencies_known_; /**<  \brief Whether link_dependencies_ are all the transforms that are read */
+
+  VisibilityEvaluatorPtr visibility_evaluator_; /**<  \brief Evaluator given to visibility constraints, if any */
+
+private:
+  /** \brief Sort evaluation_order_ after constraints have been added */
+  void updateEvaluationOrder();
+
+  /** \brief Collect link_dependencies_ after constraints have been added */
+  void updateLinkDependencies();
 };
 }
 
@@ -43,6 +43,7 @@
 #include <boost/math/constants/constants.hpp>
 #include <eigen_conversions/eigen_msg.h>
 #include <boost/bind.hpp>
+#include <algorithm>
 #include <limits>
 #include <memory>
 
@@ -68,6 +69,14 @@ kinematic_constraints::KinematicConstraint::~KinematicConstraint()
 {
 }
 
+void kinematic_constraints::KinematicConstraint::decideBatch(const robot_state::RobotState* const* states,
+                                                             std::size_t count,
+                                                             ConstraintEvaluationResult* results) const
+{
+  for (std::size_t i = 0; i < count; ++i)
+    results[i] = decide(*states[i]);
+}
+
 bool kinematic_constraints::JointConstraint::configure(const moveit_msgs::JointConstraint& jc)
 {
   // clearing before we configure to get rid of any old data
@@ -236,6 +245,39 @@ kinematic_constraints::JointConstraint::decide(const robot_state::RobotState& st
   return ConstraintEvaluationResult(result, constraint_weight_ * fabs(dif));
 }
 
+void kinematic_constraints::JointConstraint::decideBatch(const robot_state::RobotState* const* states,
+                                                         std::size_t count, ConstraintEvaluationResult* results) const
+{
+  if (!joint_model_)
+  {
+    std::fill(results, results + count, ConstraintEvaluationResult(true, 0.0));
+    return;
+  }
+
+  // gather the joint positions first, so the loops below run over packed values and can be vectorized
+  std::vector<double> dif(count);
+  for (std::size_t i = 0; i < count; ++i)
+    dif[i] = states[i]->getVariablePosition(joint_variable_index_);
+
+  if (joint_is_continuous_)
+  {
+    const double pi = boost::math::constants::pi<double>();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      double d = normalizeAngle(dif[i]) - joint_position_;
+      dif[i] = d > pi ? 2.0 * pi - d : (d < -pi ? d + 2.0 * pi : d);
+    }
+  }
+  else
+    for (std::size_t i = 0; i < count; ++i)
+      dif[i] -= joint_position_;
+
+  const double above = joint_tolerance_above_ + 2.0 * std::numeric_limits<double>::epsilon();
+  const double below = -joint_tolerance_below_ - 2.0 * std::numeric_limits<double>::epsilon();
+  for (std::size_t i = 0; i < count; ++i)
+    results[i] = ConstraintEvaluationResult(dif[i] <= above && dif[i] >= below, constraint_weight_ * fabs(dif[i]));
+}
+
 bool kinematic_constraints::JointConstraint::enabled() const
 {
   return joint_model_;
@@ -366,9 +408,84 @@ bool kinematic_constraints::PositionConstraint::configure(const moveit_msgs::Pos
   else
     constraint_weight_ = pc.weight;
 
+  buildRegionLookup();
   return !constraint_region_.empty();
 }
 
+namespace
+{
+// the number of voxels along each axis of the grid built over mesh regions
+const unsigned int REGION_GRID_CELLS = 16;
+}
+
+void kinematic_constraints::PositionConstraint::buildRegionLookup()
+{
+  region_lookup_.resize(constraint_region_.size());
+  region_inverse_pose_.resize(constraint_region_.size());
+  for (std::size_t i = 0; i < constraint_region_.size(); ++i)
+  {
+    // everything is computed in the frame of the region, so it holds for mobile frames too
+    bodies::BodyPtr body(constraint_region_[i]->cloneAt(Eigen::Affine3d::Identity()));
+    bodies::BoundingSphere sphere;
+    body->computeBoundingSphere(sphere);
+    RegionLookup& lookup = region_lookup_[i];
+    lookup.center = sphere.center;
+    lookup.radius_squared = (sphere.radius + 1e-9) * (sphere.radius + 1e-9);
+    lookup.cells = 0;
+    lookup.inside.clear();
+    region_inverse_pose_[i] = constraint_region_[i]->getPose().inverse(Eigen::Isometry);
+
+    // primitives are cheap to test exactly; meshes get a grid, from the containment of the corners of its voxels
+    if (body->getType() != shapes::MESH || sphere.radius <= 0.0)
+      continue;
+    const unsigned int n = REGION_GRID_CELLS;
+    lookup.cells = n;
+    lookup.cell_size = 2.0 * sphere.radius / n;
+    lookup.grid_origin = sphere.center - Eigen::Vector3d::Constant(sphere.radius);
+    std::vector<char> corners((n + 1) * (n + 1) * (n + 1));
+    for (unsigned int z = 0; z <= n; ++z)
+      for (unsigned int y = 0; y <= n; ++y)
+        for (unsigned int x = 0; x <= n; ++x)
+          corners[(z * (n + 1) + y) * (n + 1) + x] =
+              body->containsPoint(lookup.grid_origin + lookup.cell_size * Eigen::Vector3d(x, y, z));
+    lookup.inside.resize(n * n * n);
+    for (unsigned int z = 0; z < n; ++z)
+      for (unsigned int y = 0; y < n; ++y)
+        for (unsigned int x = 0; x < n; ++x)
+        {
+          bool inside = true;
+          for (unsigned int c = 0; c < 8 && inside; ++c)
+            inside = corners[((z + (c >> 2)) * (n + 1) + y + ((c >> 1) & 1)) * (n + 1) + x + (c & 1)];
+          lookup.inside[(z * n + y) * n + x] = inside;
+        }
+  }
+}
+
+int kinematic_constraints::PositionConstraint::quickRegionTest(std::size_t i, const Eigen::Vector3d& local_pt) const
+{
+  const RegionLookup& lookup = region_lookup_[i];
+  if ((local_pt - lookup.center).squaredNorm() > lookup.radius_squared)
+    return -1;
+  if (lookup.cells > 0)
+  {
+    Eigen::Vector3d index = (local_pt - lookup.grid_origin) / lookup.cell_size;
+    if (index.x() >= 0.0 && index.y() >= 0.0 && index.z() >= 0.0 && index.x() < lookup.cells &&
+        index.y() < lookup.cells && index.z() < lookup.cells &&
+        lookup.inside[(static_cast<unsigned int>(index.z()) * lookup.cells + static_cast<unsigned int>(index.y())) *
+                          lookup.cells +
+                      static_cast<unsigned int>(index.x())])
+      return 1;
+  }
+  return 0;
+}
+
+bool kinematic_constraints::PositionConstraint::regionContainsPoint(std::size_t i, const Eigen::Vector3d& pt,
+                                                                    bool verbose) const
+{
+  int quick = quickRegionTest(i, region_inverse_pose_[i] * pt);
+  return quick != 0 ? quick > 0 : constraint_region_[i]->containsPoint(pt, verbose);
+}
+
 void kinematic_constraints::PositionConstraint::swapLinkModel(const robot_model::LinkModel* new_link,
                                                               const Eigen::Affine3d& update)
 {
@@ -450,7 +567,8 @@ kinematic_constraints::PositionConstraint::decide(const robot_state::RobotState&
     for (std::size_t i = 0; i < constraint_region_.size(); ++i)
     {
       Eigen::Affine3d tmp = state.getFrameTransform(constraint_frame_id_) * constraint_region_pose_[i];
-      bool result = constraint_region_[i]->cloneAt(tmp)->containsPoint(pt, verbose);
+      int quick = quickRegionTest(i, tmp.inverse(Eigen::Isometry) * pt);
+      bool result = quick != 0 ? quick > 0 : constraint_region_[i]->cloneAt(tmp)->containsPoint(pt, verbose);
       if (result || (i + 1 == constraint_region_pose_.size()))
         return finishPositionConstraintDecision(pt, tmp.translation(), link_model_->getName(), constraint_weight_,
                                                 result, verbose);
@@ -463,7 +581,7 @@ kinematic_constraints::PositionConstraint::decide(const robot_state::RobotState&
   {
     for (std::size_t i = 0; i < constraint_region_.size(); ++i)
     {
-      bool result = constraint_region_[i]->containsPoint(pt, true);
+      bool result = regionContainsPoint(i, pt, true);
       if (result || (i + 1 == constraint_region_.size()))
         return finishPositionConstraintDecision(pt, constraint_region_[i]->getPose().translation(),
                                                 link_model_->getName(), constraint_weight_, result, verbose);
@@ -475,6 +593,65 @@ kinematic_constraints::PositionConstraint::decide(const robot_state::RobotState&
   return ConstraintEvaluationResult(false, 0.0);
 }
 
+void kinematic_constraints::PositionConstraint::decideBatch(const robot_state::RobotState* const* states,
+                                                            std::size_t count,
+                                                            ConstraintEvaluationResult* results) const
+{
+  if (mobile_frame_ || !link_model_ || constraint_region_.empty())
+  {
+    KinematicConstraint::decideBatch(states, count, results);
+    return;
+  }
+
+  Eigen::Matrix3Xd pts(3, count);
+  for (std::size_t i = 0; i < count; ++i)
+    pts.col(i) = states[i]->getGlobalLinkTransform(link_model_) * offset_;
+
+  // for each state, the first region that contains the point, as in decide()
+  std::vector<int> inside(count, -1);
+  for (std::size_t r = 0; r < constraint_region_.size(); ++r)
+  {
+    const bodies::Body* body = constraint_region_[r].get();
+    const Eigen::Affine3d& pose = body->getPose();
+    if (body->getType() == shapes::BOX || body->getType() == shapes::SPHERE)
+    {
+      // boxes and spheres are tested for all points at once, in the frame of the region (as bodies:: does it)
+      Eigen::Matrix3Xd local = pose.rotation().transpose() * (pts.colwise() - pose.translation());
+      const std::vector<double>& dims = body->getDimensions();
+      if (body->getType() == shapes::SPHERE)
+      {
+        double radius = dims[0] * body->getScale() + body->getPadding();
+        Eigen::Array<bool, 1, Eigen::Dynamic> c = local.colwise().squaredNorm().array() < radius * radius;
+        for (std::size_t i = 0; i < count; ++i)
+          if (inside[i] < 0 && c(i))
+            inside[i] = r;
+      }
+      else
+      {
+        Eigen::Array3d half;
+        for (int k = 0; k < 3; ++k)
+          half[k] = (dims[k] * body->getScale() + 2.0 * body->getPadding()) / 2.0;
+        Eigen::Array<bool, 1, Eigen::Dynamic> c = (local.array().abs() <= half.replicate(1, count)).colwise().all();
+        for (std::size_t i = 0; i < count; ++i)
+          if (inside[i] < 0 && c(i))
+            inside[i] = r;
+      }
+    }
+    else
+      for (std::size_t i = 0; i < count; ++i)
+        if (inside[i] < 0 && regionContainsPoint(r, pts.col(i), false))
+          inside[i] = r;
+  }
+
+  // the distance is to the region that contains the point, or to the last one
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    std::size_t r = inside[i] >= 0 ? inside[i] : constraint_region_.size() - 1;
+    results[i] = ConstraintEvaluationResult(
+        inside[i] >= 0, constraint_weight_ * (constraint_region_[r]->getPose().translation() - pts.col(i)).norm());
+  }
+}
+
 void kinematic_constraints::PositionConstraint::print(std::ostream& out) const
 {
   if (enabled())
@@ -489,6 +666,8 @@ void kinematic_constraints::PositionConstraint::clear()
   has_offset_ = false;
   constraint_region_.clear();
   constraint_region_pose_.clear();
+  region_lookup_.clear();
+  region_inverse_pose_.clear();
   mobile_frame_ = false;
   constraint_frame_id_ = "";
   link_model_ = NULL;
@@ -499,6 +678,16 @@ bool kinematic_constraints::PositionConstraint::enabled() const
   return link_model_ && !constraint_region_.empty();
 }
 
+bool kinematic_constraints::PositionConstraint::getLinkDependencies(
+    std::vector<const robot_model::LinkModel*>& links) const
+{
+  if (mobile_frame_)
+    return false;
+  if (enabled())
+    links.push_back(link_model_);
+  return true;
+}
+
 bool kinematic_constraints::OrientationConstraint::configure(const moveit_msgs::OrientationConstraint& oc,
                                                              const robot_state::Transforms& tf)
 {
@@ -606,6 +795,16 @@ bool kinematic_constraints::OrientationConstraint::enabled() const
   return link_model_;
 }
 
+bool kinematic_constraints::OrientationConstraint::getLinkDependencies(
+    std::vector<const robot_model::LinkModel*>& links) const
+{
+  if (mobile_frame_)
+    return false;
+  if (link_model_)
+    links.push_back(link_model_);
+  return true;
+}
+
 kinematic_constraints::ConstraintEvaluationResult
 kinematic_constraints::OrientationConstraint::decide(const robot_state::RobotState& state, bool verbose) const
 {
@@ -648,6 +847,36 @@ kinematic_constraints::OrientationConstraint::decide(const robot_state::RobotSta
   return ConstraintEvaluationResult(result, constraint_weight_ * (xyz(0) + xyz(1) + xyz(2)));
 }
 
+void kinematic_constraints::OrientationConstraint::decideBatch(const robot_state::RobotState* const* states,
+                                                               std::size_t count,
+                                                               ConstraintEvaluationResult* results) const
+{
+  if (mobile_frame_ || !link_model_)
+  {
+    KinematicConstraint::decideBatch(states, count, results);
+    return;
+  }
+
+  // the rotation differences for all states are a single product, with the link rotations side by side
+  Eigen::Matrix3Xd rotations(3, 3 * count);
+  for (std::size_t i = 0; i < count; ++i)
+    rotations.block<3, 3>(0, 3 * i) = states[i]->getGlobalLinkTransform(link_model_).rotation();
+  Eigen::Matrix3Xd diffs = desired_rotation_matrix_inv_ * rotations;
+
+  Eigen::Matrix3Xd xyz(3, count);
+  for (std::size_t i = 0; i < count; ++i)
+    xyz.col(i) = Eigen::Matrix3d(diffs.block<3, 3>(0, 3 * i)).eulerAngles(0, 1, 2);
+  xyz = xyz.array().abs().min(-xyz.array().abs() + boost::math::constants::pi<double>());
+
+  const Eigen::Array3d tolerance(absolute_x_axis_tolerance_ + std::numeric_limits<double>::epsilon(),
+                                 absolute_y_axis_tolerance_ + std::numeric_limits<double>::epsilon(),
+                                 absolute_z_axis_tolerance_ + std::numeric_limits<double>::epsilon());
+  Eigen::Array<bool, 1, Eigen::Dynamic> satisfied = (xyz.array() < tolerance.replicate(1, count)).colwise().all();
+  Eigen::RowVectorXd distance = constraint_weight_ * xyz.colwise().sum();
+  for (std::size_t i = 0; i < count; ++i)
+    results[i] = ConstraintEvaluationResult(satisfied(i), distance(i));
+}
+
 void kinematic_constraints::OrientationConstraint::print(std::ostream& out) const
 {
   if (link_model_)
@@ -936,12 +1165,9 @@ void kinematic_constraints::VisibilityConstraint::getMarkers(const robot_state::
   markers.markers.push_back(mka);
 }
 
-kinematic_constraints::ConstraintEvaluationResult
-kinematic_constraints::VisibilityConstraint::decide(const robot_state::RobotState& state, bool verbose) const
+bool kinematic_constraints::VisibilityConstraint::decideViewAngles(const robot_state::RobotState& state,
+                                                                   bool verbose) const
 {
-  if (target_radius_ <= std::numeric_limits<double>::epsilon())
-    return ConstraintEvaluationResult(true, 0.0);
-
   if (max_view_angle_ > 0.0 || max_range_angle_ > 0.0)
   {
     const Eigen::Affine3d& sp =
@@ -961,7 +1187,7 @@ kinematic_constraints::VisibilityConstraint::decide(const robot_state::RobotStat
       {
         if (verbose)
           logInform("Visibility constraint is violated because the sensor is looking at the wrong side");
-        return ConstraintEvaluationResult(false, 0.0);
+        return false;
       }
       if (max_view_angle_ < ang)
       {
@@ -969,7 +1195,7 @@ kinematic_constraints::VisibilityConstraint::decide(const robot_state::RobotStat
           logInform("Visibility constraint is violated because the view angle is %lf (above the maximum allowed of "
                     "%lf)",
                     ang, max_view_angle_);
-        return ConstraintEvaluationResult(false, 0.0);
+        return false;
       }
     }
     if (max_range_angle_ > 0.0)
@@ -980,7 +1206,7 @@ kinematic_constraints::VisibilityConstraint::decide(const robot_state::RobotStat
       {
         if (verbose)
           logInform("Visibility constraint is violated because the sensor is looking at the wrong side");
-        return ConstraintEvaluationResult(false, 0.0);
+        return false;
       }
 
       double ang = acos(dp);
@@ -990,11 +1216,60 @@ kinematic_constraints::VisibilityConstraint::decide(const robot_state::RobotStat
           logInform("Visibility constraint is violated because the range angle is %lf (above the maximum allowed of "
                     "%lf)",
                     ang, max_range_angle_);
-        return ConstraintEvaluationResult(false, 0.0);
+        return false;
       }
     }
   }
+  return true;
+}
+
+kinematic_constraints::ConstraintEvaluationResult
+kinematic_constraints::VisibilityConstraint::decide(const robot_state::RobotState& state, bool verbose) const
+{
+  if (target_radius_ <= std::numeric_limits<double>::epsilon())
+    return ConstraintEvaluationResult(true, 0.0);
+
+  if (!decideViewAngles(state, verbose))
+    return ConstraintEvaluationResult(false, 0.0);
+
+  if (evaluator_)
+    return evaluator_->decideOcclusion(*this, state, verbose);
+  return decideCone(state, verbose);
+}
 
+void kinematic_constraints::VisibilityConstraint::decideBatch(const robot_state::RobotState* const* states,
+                                                              std::size_t count,
+                                                              ConstraintEvaluationResult* results) const
+{
+  std::fill(results, results + count, ConstraintEvaluationResult(true, 0.0));
+  if (target_radius_ <= std::numeric_limits<double>::epsilon())
+    return;
+
+  // only the states that pass the angle checks need an occlusion test
+  std::vector<const robot_state::RobotState*> remaining;
+  std::vector<std::size_t> remaining_index;
+  for (std::size_t i = 0; i < count; ++i)
+    if (!decideViewAngles(*states[i], false))
+      results[i] = ConstraintEvaluationResult(false, 0.0);
+    else if (evaluator_)
+    {
+      remaining.push_back(states[i]);
+      remaining_index.push_back(i);
+    }
+    else
+      results[i] = decideCone(*states[i], false);
+
+  if (remaining.empty())
+    return;
+  std::vector<ConstraintEvaluationResult> occlusion(remaining.size());
+  evaluator_->decideOcclusion(*this, &remaining[0], remaining.size(), &occlusion[0]);
+  for (std::size_t i = 0; i < remaining_index.size(); ++i)
+    results[remaining_index[i]] = occlusion[i];
+}
+
+kinematic_constraints::ConstraintEvaluationResult
+kinematic_constraints::VisibilityConstraint::decideCone(const robot_state::RobotState& state, bool verbose) const
+{
   shapes::Mesh* m = getVisibilityCone(state);
   if (!m)
     return ConstraintEvaluationResult(false, 0.0);
@@ -1060,6 +1335,14 @@ void kinematic_constraints::VisibilityConstraint::print(std::ostream& out) const
     out << "No constraint" << std::endl;
 }
 
+void kinematic_constraints::KinematicConstraintSet::setVisibilityEvaluator(const VisibilityEvaluatorPtr& evaluator)
+{
+  visibility_evaluator_ = evaluator;
+  for (std::size_t i = 0; i < kinematic_constraints_.size(); ++i)
+    if (kinematic_constraints_[i]->getType() == VISIBILITY_CONSTRAINT)
+      static_cast<VisibilityConstraint*>(kinematic_constraints_[i].get())->setVisibilityEvaluator(evaluator);
+}
+
 void kinematic_constraints::KinematicConstraintSet::clear()
 {
   all_constraints_ = moveit_msgs::Constraints();
@@ -1068,6 +1351,9 @@ void kinematic_constraints::KinematicConstraintSet::clear()
   position_constraints_.clear();
   orientation_constraints_.clear();
   visibility_constraints_.clear();
+  evaluation_order_.clear();
+  link_dependencies_.clear();
+  link_dependencies_known_ = true;
 }
 
 bool kinematic_constraints::KinematicConstraintSet::add(const std::vector<moveit_msgs::JointConstraint>& jc)
@@ -1082,6 +1368,8 @@ bool kinematic_constraints::KinematicConstraintSet::add(const std::vector<moveit
     joint_constraints_.push_back(jc[i]);
     all_constraints_.joint_constraints.push_back(jc[i]);
   }
+  updateEvaluationOrder();
+  updateLinkDependencies();
   return result;
 }
 
@@ -1098,6 +1386,8 @@ bool kinematic_constraints::KinematicConstraintSet::add(const std::vector<moveit
     position_constraints_.push_back(pc[i]);
     all_constraints_.position_constraints.push_back(pc[i]);
   }
+  updateEvaluationOrder();
+  updateLinkDependencies();
   return result;
 }
 
@@ -1114,6 +1404,8 @@ bool kinematic_constraints::KinematicConstraintSet::add(const std::vector<moveit
     orientation_constraints_.push_back(oc[i]);
     all_constraints_.orientation_constraints.push_back(oc[i]);
   }
+  updateEvaluationOrder();
+  updateLinkDependencies();
   return result;
 }
 
@@ -1125,11 +1417,14 @@ bool kinematic_constraints::KinematicConstraintSet::add(const std::vector<moveit
   {
     VisibilityConstraint* ev = new VisibilityConstraint(robot_model_);
     bool u = ev->configure(vc[i], tf);
+    ev->setVisibilityEvaluator(visibility_evaluator_);
     result = result && u;
     kinematic_constraints_.push_back(KinematicConstraintPtr(ev));
     visibility_constraints_.push_back(vc[i]);
     all_constraints_.visibility_constraints.push_back(vc[i]);
   }
+  updateEvaluationOrder();
+  updateLinkDependencies();
   return result;
 }
 
@@ -1143,6 +1438,62 @@ bool kinematic_constraints::KinematicConstraintSet::add(const moveit_msgs::Const
   return j && p && o && v;
 }
 
+namespace
+{
+struct CheaperConstraint
+{
+  CheaperConstraint(const std::vector<kinematic_constraints::KinematicConstraintPtr>& constraints)
+    : constraints_(constraints)
+  {
+  }
+
+  bool operator()(unsigned int a, unsigned int b) const
+  {
+    return constraints_[a]->getEvaluationCost() < constraints_[b]->getEvaluationCost();
+  }
+
+  const std::vector<kinematic_constraints::KinematicConstraintPtr>& constraints_;
+};
+}
+
+void kinematic_constraints::KinematicConstraintSet::updateEvaluationOrder()
+{
+  evaluation_order_.resize(kinematic_constraints_.size());
+  for (unsigned int i = 0; i < evaluation_order_.size(); ++i)
+    evaluation_order_[i] = i;
+  std::stable_sort(evaluation_order_.begin(), evaluation_order_.end(), CheaperConstraint(kinematic_constraints_));
+}
+
+void kinematic_constraints::KinematicConstraintSet::updateLinkDependencies()
+{
+  link_dependencies_.clear();
+  link_dependencies_known_ = true;
+  for (std::size_t i = 0; i < kinematic_constraints_.size() && link_dependencies_known_; ++i)
+    link_dependencies_known_ = kinematic_constraints_[i]->getLinkDependencies(link_dependencies_);
+  if (!link_dependencies_known_)
+    link_dependencies_.clear();
+}
+
+void kinematic_constraints::KinematicConstraintSet::updateLinkTransforms(robot_state::RobotState& state) const
+{
+  if (!link_dependencies_known_)
+  {
+    state.updateLinkTransforms();
+    return;
+  }
+  for (std::size_t i = 0; i < link_dependencies_.size(); ++i)
+    state.updateLinkTransformChain(link_dependencies_[i]);
+}
+
+bool kinematic_constraints::KinematicConstraintSet::isSatisfied(const robot_state::RobotState& state,
+                                                                bool verbose) const
+{
+  for (std::size_t i = 0; i < evaluation_order_.size(); ++i)
+    if (!kinematic_constraints_[evaluation_order_[i]]->decide(state, verbose).satisfied)
+      return false;
+  return true;
+}
+
 kinematic_constraints::ConstraintEvaluationResult
 kinematic_constraints::KinematicConstraintSet::decide(const robot_state::RobotState& state, bool verbose) const
 {
@@ -1172,6 +1523,23 @@ kinematic_constraints::ConstraintEvaluationResult kinematic_constraints::Kinemat
   return result;
 }
 
+void kinematic_constraints::KinematicConstraintSet::decideBatch(const robot_state::RobotState* const* states,
+                                                                std::size_t count,
+                                                                ConstraintEvaluationResult* results) const
+{
+  std::fill(results, results + count, ConstraintEvaluationResult(true, 0.0));
+  std::vector<ConstraintEvaluationResult> r(count);
+  for (std::size_t i = 0; i < kinematic_constraints_.size(); ++i)
+  {
+    kinematic_constraints_[i]->decideBatch(states, count, count ? &r[0] : NULL);
+    for (std::size_t j = 0; j < count; ++j)
+    {
+      results[j].satisfied = results[j].satisfied && r[j].satisfied;
+      results[j].distance += r[j].distance;
+    }
+  }
+}
+
 void kinematic_constraints::KinematicConstraintSet::print(std::ostream& out) const
 {
   out << kinematic_constraints_.size() << " kinematic constraints" << std::endl;
@@ -731,6 +731,82 @@ TEST_F(LoadPlanningModelsPr2, VisibilityConstraintsSimple)
   EXPECT_FALSE(vc.decide(ks, true).satisfied);
 }
 
+namespace
+{
+// reports every target as occluded, and counts the states it is asked about
+class OccludedEvaluator : public kinematic_constraints::VisibilityEvaluator
+{
+public:
+  OccludedEvaluator() : evaluated(0)
+  {
+  }
+
+  virtual kinematic_constraints::ConstraintEvaluationResult
+  decideOcclusion(const kinematic_constraints::VisibilityConstraint& constraint, const robot_state::RobotState& state,
+                  bool verbose)
+  {
+    ++evaluated;
+    return kinematic_constraints::ConstraintEvaluationResult(false, 1.0);
+  }
+
+  unsigned int evaluated;
+};
+}
+
+TEST_F(LoadPlanningModelsPr2, VisibilityConstraintsEvaluator)
+{
+  robot_state::RobotState ks(kmodel);
+  ks.setToDefaultValues();
+  ks.update();
+  robot_state::Transforms tf(kmodel->getModelFrame());
+
+  moveit_msgs::Constraints c;
+  c.visibility_constraints.resize(1);
+  moveit_msgs::VisibilityConstraint& vcm = c.visibility_constraints[0];
+  vcm.sensor_pose.header.frame_id = "base_footprint";
+  vcm.sensor_pose.pose.position.z = -1.0;
+  vcm.sensor_pose.pose.orientation.y = 1.0;
+  vcm.target_pose.header.frame_id = "base_footprint";
+  vcm.target_pose.pose.position.z = -2.0;
+  vcm.target_pose.pose.orientation.w = 1.0;
+  vcm.target_radius = .2;
+  vcm.cone_sides = 10;
+  vcm.max_view_angle = .1;
+  vcm.sensor_view_direction = moveit_msgs::VisibilityConstraint::SENSOR_Z;
+  vcm.weight = 1.0;
+
+  kinematic_constraints::KinematicConstraintSet kcs(kmodel);
+  EXPECT_TRUE(kcs.add(c, tf));
+  EXPECT_TRUE(kcs.decide(ks).satisfied);
+
+  // the evaluator replaces the cone check, for single and batched decisions
+  std::shared_ptr<OccludedEvaluator> evaluator(new OccludedEvaluator());
+  kcs.setVisibilityEvaluator(evaluator);
+  EXPECT_FALSE(kcs.decide(ks).satisfied);
+  EXPECT_EQ(evaluator->evaluated, 1u);
+
+  const robot_state::RobotState* states[3] = { &ks, &ks, &ks };
+  kinematic_constraints::ConstraintEvaluationResult results[3];
+  kcs.decideBatch(states, 3, results);
+  for (int i = 0; i < 3; ++i)
+    EXPECT_FALSE(results[i].satisfied);
+  EXPECT_EQ(evaluator->evaluated, 4u);
+
+  // states violating the view angle are never passed to the evaluator
+  kinematic_constraints::VisibilityConstraint vc(kmodel);
+  vcm.target_pose.pose.orientation.y = 0.06;
+  vcm.target_pose.pose.orientation.w = .9981;
+  EXPECT_TRUE(vc.configure(vcm, tf));
+  vc.setVisibilityEvaluator(evaluator);
+  EXPECT_FALSE(vc.decide(ks).satisfied);
+  EXPECT_EQ(evaluator->evaluated, 4u);
+
+  // without an evaluator the cone check is used again
+  kcs.setVisibilityEvaluator(kinematic_constraints::VisibilityEvaluatorPtr());
+  EXPECT_TRUE(kcs.decide(ks).satisfied);
+  EXPECT_EQ(evaluator->evaluated, 4u);
+}
+
 TEST_F(LoadPlanningModelsPr2, VisibilityConstraintsPR2)
 {
   robot_state::RobotState ks(kmodel);
@@ -871,6 +947,53 @@ TEST_F(LoadPlanningModelsPr2, TestKinematicConstraintSet)
   EXPECT_FALSE(kcs.decide(ks).satisfied);
 }
 
+TEST_F(LoadPlanningModelsPr2, TestKinematicConstraintSetIsSatisfied)
+{
+  robot_state::RobotState ks(kmodel);
+  ks.setToDefaultValues();
+  ks.update();
+  robot_state::Transforms tf(kmodel->getModelFrame());
+
+  kinematic_constraints::KinematicConstraintSet kcs(kmodel);
+  EXPECT_TRUE(kcs.isSatisfied(ks));
+
+  // a position constraint that holds in the default state, added before a joint constraint that does not
+  moveit_msgs::PositionConstraint pcm;
+  pcm.link_name = "r_wrist_roll_link";
+  pcm.header.frame_id = kmodel->getModelFrame();
+  pcm.constraint_region.primitives.resize(1);
+  pcm.constraint_region.primitives[0].type = shape_msgs::SolidPrimitive::SPHERE;
+  pcm.constraint_region.primitives[0].dimensions.resize(1);
+  pcm.constraint_region.primitives[0].dimensions[0] = 10.0;
+  pcm.constraint_region.primitive_poses.resize(1);
+  pcm.constraint_region.primitive_poses[0].orientation.w = 1.0;
+  pcm.weight = 1.0;
+  EXPECT_TRUE(kcs.add(std::vector<moveit_msgs::PositionConstraint>(1, pcm), tf));
+  EXPECT_TRUE(kcs.isSatisfied(ks));
+
+  moveit_msgs::JointConstraint jcm;
+  jcm.joint_name = "head_pan_joint";
+  jcm.position = 0.4;
+  jcm.tolerance_above = 0.1;
+  jcm.tolerance_below = 0.05;
+  jcm.weight = 1.0;
+  EXPECT_TRUE(kcs.add(std::vector<moveit_msgs::JointConstraint>(1, jcm)));
+
+  // the answer is the same as that of decide()
+  EXPECT_FALSE(kcs.decide(ks).satisfied);
+  EXPECT_FALSE(kcs.isSatisfied(ks));
+
+  std::map<std::string, double> jvals;
+  jvals[jcm.joint_name] = 0.41;
+  ks.setVariablePositions(jvals);
+  ks.update();
+  EXPECT_TRUE(kcs.decide(ks).satisfied);
+  EXPECT_TRUE(kcs.isSatisfied(ks));
+
+  kcs.clear();
+  EXPECT_TRUE(kcs.isSatisfied(ks));
+}
+
 TEST_F(LoadPlanningModelsPr2, TestKinematicConstraintSetEquality)
 {
   robot_state::RobotState ks(kmodel);
@@ -950,6 +1073,145 @@ TEST_F(LoadPlanningModelsPr2, TestKinematicConstraintSetEquality)
   EXPECT_TRUE(kcs2.equal(kcs, .1));
 }
 
+TEST_F(LoadPlanningModelsPr2, PositionConstraintsMeshRegion)
+{
+  robot_state::Transforms tf(kmodel->getModelFrame());
+
+  // the same cube, once as a box and once as a mesh
+  moveit_msgs::PositionConstraint box_pcm;
+  box_pcm.link_name = "r_wrist_roll_link";
+  box_pcm.header.frame_id = kmodel->getModelFrame();
+  box_pcm.constraint_region.primitives.resize(1);
+  box_pcm.constraint_region.primitives[0].type = shape_msgs::SolidPrimitive::BOX;
+  box_pcm.constraint_region.primitives[0].dimensions.resize(3, 0.5);
+  box_pcm.constraint_region.primitive_poses.resize(1);
+  box_pcm.constraint_region.primitive_poses[0].position.x = 0.5;
+  box_pcm.constraint_region.primitive_poses[0].position.y = -0.3;
+  box_pcm.constraint_region.primitive_poses[0].position.z = 0.8;
+  box_pcm.constraint_region.primitive_poses[0].orientation.z = sin(0.2);
+  box_pcm.constraint_region.primitive_poses[0].orientation.w = cos(0.2);
+  box_pcm.weight = 1.0;
+
+  moveit_msgs::PositionConstraint mesh_pcm = box_pcm;
+  mesh_pcm.constraint_region.primitives.clear();
+  mesh_pcm.constraint_region.mesh_poses = box_pcm.constraint_region.primitive_poses;
+  mesh_pcm.constraint_region.primitive_poses.clear();
+  mesh_pcm.constraint_region.meshes.resize(1);
+  shape_msgs::Mesh& mesh = mesh_pcm.constraint_region.meshes[0];
+  for (int i = 0; i < 8; ++i)
+  {
+    geometry_msgs::Point p;
+    p.x = (i & 1) ? 0.25 : -0.25;
+    p.y = (i & 2) ? 0.25 : -0.25;
+    p.z = (i & 4) ? 0.25 : -0.25;
+    mesh.vertices.push_back(p);
+  }
+  const unsigned int faces[12][3] = { { 0, 2, 1 }, { 1, 2, 3 }, { 4, 5, 6 }, { 5, 7, 6 }, { 0, 1, 4 }, { 1, 5, 4 },
+                                      { 2, 6, 3 }, { 3, 6, 7 }, { 0, 4, 2 }, { 2, 4, 6 }, { 1, 3, 5 }, { 3, 7, 5 } };
+  for (int i = 0; i < 12; ++i)
+  {
+    shape_msgs::MeshTriangle t;
+    t.vertex_indices[0] = faces[i][0];
+    t.vertex_indices[1] = faces[i][1];
+    t.vertex_indices[2] = faces[i][2];
+    mesh.triangles.push_back(t);
+  }
+
+  kinematic_constraints::PositionConstraint box_pc(kmodel);
+  kinematic_constraints::PositionConstraint mesh_pc(kmodel);
+  EXPECT_TRUE(box_pc.configure(box_pcm, tf));
+  EXPECT_TRUE(mesh_pc.configure(mesh_pcm, tf));
+
+  // the quick tests of the mesh region agree with the exact test of the box
+  robot_state::RobotState ks(kmodel);
+  ks.setToDefaultValues();
+  const robot_model::JointModelGroup* jmg = kmodel->getJointModelGroup("right_arm");
+  unsigned int inside = 0;
+  for (int i = 0; i < 500; ++i)
+  {
+    ks.setToRandomPositions(jmg);
+    ks.update();
+    bool satisfied = box_pc.decide(ks).satisfied;
+    EXPECT_EQ(satisfied, mesh_pc.decide(ks).satisfied);
+    inside += satisfied;
+  }
+  EXPECT_GT(inside, 0u);
+}
+
+TEST_F(LoadPlanningModelsPr2, TestKinematicConstraintSetDecideBatch)
+{
+  robot_state::Transforms tf(kmodel->getModelFrame());
+  kinematic_constraints::KinematicConstraintSet kcs(kmodel);
+
+  moveit_msgs::Constraints c;
+  c.joint_constraints.resize(2);
+  c.joint_constraints[0].joint_name = "r_shoulder_pan_joint";
+  c.joint_constraints[0].tolerance_above = 0.5;
+  c.joint_constraints[0].tolerance_below = 0.5;
+  c.joint_constraints[0].weight = 1.0;
+  c.joint_constraints[1].joint_name = "r_forearm_roll_joint";  // continuous
+  c.joint_constraints[1].position = 3.0;
+  c.joint_constraints[1].tolerance_above = 1.0;
+  c.joint_constraints[1].tolerance_below = 1.0;
+  c.joint_constraints[1].weight = 1.0;
+
+  c.position_constraints.resize(1);
+  moveit_msgs::PositionConstraint& pcm = c.position_constraints[0];
+  pcm.link_name = "r_wrist_roll_link";
+  pcm.header.frame_id = kmodel->getModelFrame();
+  pcm.constraint_region.primitives.resize(2);
+  pcm.constraint_region.primitives[0].type = shape_msgs::SolidPrimitive::BOX;
+  pcm.constraint_region.primitives[0].dimensions.resize(3, 0.6);
+  pcm.constraint_region.primitives[1].type = shape_msgs::SolidPrimitive::SPHERE;
+  pcm.constraint_region.primitives[1].dimensions.resize(1, 0.4);
+  pcm.constraint_region.primitive_poses.resize(2);
+  pcm.constraint_region.primitive_poses[0].position.x = 0.6;
+  pcm.constraint_region.primitive_poses[0].position.y = -0.2;
+  pcm.constraint_region.primitive_poses[0].position.z = 0.8;
+  pcm.constraint_region.primitive_poses[0].orientation.z = sin(0.3);
+  pcm.constraint_region.primitive_poses[0].orientation.w = cos(0.3);
+  pcm.constraint_region.primitive_poses[1].position.x = 0.3;
+  pcm.constraint_region.primitive_poses[1].position.y = -0.6;
+  pcm.constraint_region.primitive_poses[1].position.z = 1.0;
+  pcm.constraint_region.primitive_poses[1].orientation.w = 1.0;
+  pcm.weight = 1.0;
+
+  c.orientation_constraints.resize(1);
+  c.orientation_constraints[0].link_name = "r_wrist_roll_link";
+  c.orientation_constraints[0].header.frame_id = kmodel->getModelFrame();
+  c.orientation_constraints[0].orientation.w = 1.0;
+  c.orientation_constraints[0].absolute_x_axis_tolerance = 1.0;
+  c.orientation_constraints[0].absolute_y_axis_tolerance = 1.0;
+  c.orientation_constraints[0].absolute_z_axis_tolerance = 1.0;
+  c.orientation_constraints[0].weight = 1.0;
+  EXPECT_TRUE(kcs.add(c, tf));
+
+  // the batch results are the same as evaluating each state on its own
+  const robot_model::JointModelGroup* jmg = kmodel->getJointModelGroup("right_arm");
+  std::vector<robot_state::RobotStatePtr> states;
+  std::vector<const robot_state::RobotState*> state_ptrs;
+  for (int i = 0; i < 200; ++i)
+  {
+    states.push_back(robot_state::RobotStatePtr(new robot_state::RobotState(kmodel)));
+    states.back()->setToDefaultValues();
+    states.back()->setToRandomPositions(jmg);
+    states.back()->update();
+    state_ptrs.push_back(states.back().get());
+  }
+  std::vector<kinematic_constraints::ConstraintEvaluationResult> results(states.size());
+  kcs.decideBatch(&state_ptrs[0], states.size(), &results[0]);
+
+  unsigned int satisfied = 0;
+  for (std::size_t i = 0; i < states.size(); ++i)
+  {
+    kinematic_constraints::ConstraintEvaluationResult r = kcs.decide(*states[i]);
+    EXPECT_EQ(r.satisfied, results[i].satisfied);
+    EXPECT_NEAR(r.distance, results[i].distance, 1e-9);
+    satisfied += r.satisfied;
+  }
+  EXPECT_LT(satisfied, states.size());
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
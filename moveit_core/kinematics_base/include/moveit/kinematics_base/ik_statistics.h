@@ -0,0 +1,108 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_KINEMATICS_BASE_IK_STATISTICS_
+#define MOVEIT_KINEMATICS_BASE_IK_STATISTICS_
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+
+namespace kinematics
+{
+/**
+ * @class IKStatistics
+ * @brief Counters and a latency histogram for a stream of IK queries, which may be updated from several threads.
+ * Recording only happens once the statistics are enabled; until then the cost for the caller is a single load of an
+ * atomic flag.
+ */
+class IKStatistics
+{
+public:
+  /** @brief A snapshot of the statistics; latencies are in seconds */
+  struct Summary
+  {
+    std::size_t queries;
+    std::size_t successes;
+    std::size_t restarts;
+    double success_rate;
+    double mean_latency;
+    double p50_latency;
+    double p99_latency;
+    double max_latency;
+  };
+
+  IKStatistics();
+
+  void setEnabled(bool enabled)
+  {
+    enabled_.store(enabled, std::memory_order_relaxed);
+  }
+
+  bool isEnabled() const
+  {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  /** @brief Record a query that took \e seconds and needed \e restarts restarts from new seeds */
+  void record(double seconds, bool success, std::size_t restarts = 0);
+
+  /** @brief Clear all counters (but do not change whether recording is enabled) */
+  void reset();
+
+  Summary getSummary() const;
+
+  /** @brief Format a summary as a single human readable line */
+  static std::string toString(const Summary& summary);
+
+private:
+  /** @brief The latency histogram has BUCKETS_PER_OCTAVE logarithmic buckets per doubling of latency, starting at
+   * one microsecond; BUCKET_COUNT of them cover up to about 16 seconds */
+  static const unsigned int BUCKETS_PER_OCTAVE = 4;
+  static const unsigned int BUCKET_COUNT = 96;
+
+  static unsigned int getBucket(double seconds);
+  static double getBucketLatency(unsigned int bucket);
+
+  std::atomic<bool> enabled_;
+  std::atomic<std::size_t> queries_;
+  std::atomic<std::size_t> successes_;
+  std::atomic<std::size_t> restarts_;
+  std::atomic<unsigned long long> total_nanoseconds_;
+  std::atomic<unsigned long long> max_nanoseconds_;
+  std::atomic<std::size_t> buckets_[BUCKET_COUNT];
+};
+}
+
+#endif
@@ -40,6 +40,9 @@
 #include <geometry_msgs/PoseStamped.h>
 #include <moveit_msgs/MoveItErrorCodes.h>
 #include <moveit/macros/class_forward.h>
+#include <moveit/kinematics_base/ik_statistics.h>
+#include <eigen_stl_containers/eigen_stl_vector_container.h>
+#include <Eigen/Geometry>
 #include <boost/function.hpp>
 #include <console_bridge/console.h>
 #include <string>
@@ -135,6 +138,35 @@ struct KinematicsResult
 };
 
 MOVEIT_CLASS_FORWARD(KinematicsBase);
+MOVEIT_CLASS_FORWARD(IKTrackingSession);
+
+/**
+ * @class IKTrackingSession
+ * @brief Solves IK for a sequence of nearby poses, such as the waypoints of a Cartesian path, each query starting
+ * from the solution of the previous one. Sessions are created by KinematicsBase::beginTracking(); they must not
+ * outlive their solver and must not be used by several threads at once.
+ */
+class IKTrackingSession
+{
+public:
+  virtual ~IKTrackingSession()
+  {
+  }
+
+  /**
+   * @brief Solve IK for a pose close to the previous one. This is meant to be much cheaper than a search and may
+   * give up where a search with random restarts would succeed, so callers fall back to searchPositionIK() on failure.
+   * @param ik_pose The desired pose of the tip link, in the base frame of the solver
+   * @param solution The solution; on success it is also where the next query starts from
+   * @param error_code an error code that encodes the reason for failure or success
+   * @return True if a valid solution was found, false otherwise
+   */
+  virtual bool track(const Eigen::Affine3d& ik_pose, std::vector<double>& solution,
+                     moveit_msgs::MoveItErrorCodes& error_code) = 0;
+
+  /** @brief Start the next query from \e seed instead of the last solution */
+  virtual void reset(const std::vector<double>& seed) = 0;
+};
 
 /**
  * @class KinematicsBase
@@ -185,6 +217,54 @@ public:
                              std::vector<std::vector<double> >& solutions, KinematicsResult& result,
                              const kinematics::KinematicsQueryOptions& options) const;
 
+  /**
+   * @brief Compute IK solutions for many poses of the tip link at once, as needed for ranking grasps or
+   * analyzing reachability. Solvers can override this to reuse their workspaces across poses; the default
+   * implementation calls getPositionIK() for each pose.
+   *
+   * @param poses The desired poses of the tip link, in the base frame of the solver
+   * @param seeds Either one seed state used for all poses, or one seed state per pose, concatenated
+   * @param solutions Filled with one entry per pose; entries for poses without a solution are left empty
+   * @param error_codes Filled with the error code of each pose
+   * @param options Options passed on to each IK query
+   * @return The number of poses a solution was found for
+   */
+  virtual std::size_t
+  getPositionIKBatch(const EigenSTL::vector_Affine3d& poses, const std::vector<double>& seeds,
+                     std::vector<std::vector<double> >& solutions,
+                     std::vector<moveit_msgs::MoveItErrorCodes>& error_codes,
+                     const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions()) const;
+
+  /**
+   * @brief Start a session that solves IK for a sequence of nearby poses, each from the previous solution.
+   * Solvers can override this to keep their internal state between the queries and skip random restarts; by default
+   * tracking is not supported and NULL is returned.
+   * @param ik_seed_state The state the first query starts from
+   * @param options Options passed on to each IK query
+   * @return The session, or NULL if the solver does not support tracking
+   */
+  virtual IKTrackingSessionPtr
+  beginTracking(const std::vector<double>& ik_seed_state,
+                const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions()) const;
+
+  /**
+   * @brief Eigen counterpart of searchPositionIK() with a solution callback, for tight loops over IK queries.
+   * Solvers can override this to work without allocating memory; the default implementation converts the
+   * arguments and calls the message-based version.
+   * @param ik_pose the desired pose of the tip link, in the base frame of the solver
+   * @param ik_seed_state an initial guess solution for the inverse kinematics
+   * @param timeout The amount of time (in seconds) available to the solver
+   * @param solution the solution vector; it must already have the size of the seed
+   * @param solution_callback A callback to validate solutions; it may be empty
+   * @param error_code an error code that encodes the reason for failure or success
+   * @return True if a valid solution was found, false otherwise
+   */
+  virtual bool
+  searchPositionIK(const Eigen::Affine3d& ik_pose, const Eigen::Ref<const Eigen::VectorXd>& ik_seed_state,
+                   double timeout, Eigen::Ref<Eigen::VectorXd> solution, const IKCallbackFn& solution_callback,
+                   moveit_msgs::MoveItErrorCodes& error_code,
+                   const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions()) const;
+
   /**
    * @brief Given a desired pose of the end-effector, search for the joint angles required to reach it.
    * This particular method is intended for "searching" for a solutions by stepping through the redundancy
@@ -327,6 +407,15 @@ public:
   virtual bool getPositionFK(const std::vector<std::string>& link_names, const std::vector<double>& joint_angles,
                              std::vector<geometry_msgs::Pose>& poses) const = 0;
 
+  /**
+   * @brief Eigen counterpart of getPositionFK() for the tip frame. Solvers can override this to work without
+   * allocating memory; the default implementation converts the arguments and calls the message-based version.
+   * @param joint_angles The state for which FK is being computed
+   * @param tip_pose The resultant pose of the tip frame (in the frame returned by getBaseFrame())
+   * @return True if a valid solution was found, false otherwise
+   */
+  virtual bool getPositionFK(const Eigen::Ref<const Eigen::VectorXd>& joint_angles, Eigen::Affine3d& tip_pose) const;
+
   /**
    * @brief Set the parameters for the solver, for use with kinematic chain IK solvers
    * @param robot_description This parameter can be used as an identifier for the robot kinematics it is computed for;
@@ -552,7 +641,7 @@ public:
 
   /** @brief For functions that require a timeout specified but one is not specified using arguments,
       a default timeout is used, as set by this function (and initialized to KinematicsBase::DEFAULT_TIMEOUT) */
-  void setDefaultTimeout(double timeout)
+  virtual void setDefaultTimeout(double timeout)
   {
     default_timeout_ = timeout;
   }
@@ -564,6 +653,34 @@ public:
     return default_timeout_;
   }
 
+  /** @brief Set the number of threads a search for an IK solution may use (initialized to 1; 0 means one per core).
+      Solvers that support it run random restarts from different seeds in parallel and return the first solution
+      that is accepted; solution callbacks are never called concurrently. */
+  virtual void setSearchThreadCount(unsigned int thread_count)
+  {
+    search_thread_count_ = thread_count;
+  }
+
+  /** @brief Get the number of threads a search for an IK solution may use (see setSearchThreadCount()) */
+  unsigned int getSearchThreadCount() const
+  {
+    return search_thread_count_;
+  }
+
+  /** @brief Statistics of the IK searches this solver ran, if the solver records them (KDL and LMA do).
+      Recording is disabled until IKStatistics::setEnabled() is called. */
+  IKStatistics& getSearchStatistics() const
+  {
+    return search_statistics_;
+  }
+
+  /** @brief Statistics of the RobotState::setFromIK() calls answered by this solver; a restart is counted for every
+      attempt after the first. Recording is disabled until IKStatistics::setEnabled() is called. */
+  IKStatistics& getSetFromIKStatistics() const
+  {
+    return set_from_ik_statistics_;
+  }
+
   /**
    * @brief  Virtual destructor for the interface
    */
@@ -577,6 +694,7 @@ public:
        // (if multiple tip frames provided, this variable will be unset)
     search_discretization_(DEFAULT_SEARCH_DISCRETIZATION)
     , default_timeout_(DEFAULT_TIMEOUT)
+    , search_thread_count_(1)
   {
     supported_methods_.push_back(DiscretizationMethods::NO_DISCRETIZATION);
   }
@@ -594,10 +712,14 @@ protected:
                                   // now stored in the redundant_joint_discretization_ member
 
   double default_timeout_;
+  unsigned int search_thread_count_;
   std::vector<unsigned int> redundant_joint_indices_;
   std::map<int, double> redundant_joint_discretization_;
   std::vector<DiscretizationMethod> supported_methods_;
 
+  mutable IKStatistics search_statistics_;
+  mutable IKStatistics set_from_ik_statistics_;
+
 private:
   std::string removeSlash(const std::string& str) const;
 };
@@ -0,0 +1,140 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/kinematics_base/ik_statistics.h>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+namespace kinematics
+{
+const unsigned int IKStatistics::BUCKETS_PER_OCTAVE;
+const unsigned int IKStatistics::BUCKET_COUNT;
+
+IKStatistics::IKStatistics() : enabled_(false)
+{
+  reset();
+}
+
+unsigned int IKStatistics::getBucket(double seconds)
+{
+  double microseconds = seconds * 1e6;
+  if (!(microseconds > 1.0))
+    return 0;
+  double bucket = std::floor(std::log2(microseconds) * BUCKETS_PER_OCTAVE);
+  return bucket < BUCKET_COUNT ? static_cast<unsigned int>(bucket) : BUCKET_COUNT - 1;
+}
+
+double IKStatistics::getBucketLatency(unsigned int bucket)
+{
+  // the geometric center of the bucket
+  return 1e-6 * std::exp2((bucket + 0.5) / BUCKETS_PER_OCTAVE);
+}
+
+void IKStatistics::record(double seconds, bool success, std::size_t restarts)
+{
+  if (!isEnabled())
+    return;
+  queries_.fetch_add(1, std::memory_order_relaxed);
+  if (success)
+    successes_.fetch_add(1, std::memory_order_relaxed);
+  restarts_.fetch_add(restarts, std::memory_order_relaxed);
+  buckets_[getBucket(seconds)].fetch_add(1, std::memory_order_relaxed);
+
+  unsigned long long nanoseconds = seconds > 0.0 ? static_cast<unsigned long long>(seconds * 1e9) : 0;
+  total_nanoseconds_.fetch_add(nanoseconds, std::memory_order_relaxed);
+  unsigned long long max = max_nanoseconds_.load(std::memory_order_relaxed);
+  while (nanoseconds > max && !max_nanoseconds_.compare_exchange_weak(max, nanoseconds, std::memory_order_relaxed))
+    ;
+}
+
+void IKStatistics::reset()
+{
+  queries_.store(0, std::memory_order_relaxed);
+  successes_.store(0, std::memory_order_relaxed);
+  restarts_.store(0, std::memory_order_relaxed);
+  total_nanoseconds_.store(0, std::memory_order_relaxed);
+  max_nanoseconds_.store(0, std::memory_order_relaxed);
+  for (unsigned int i = 0; i < BUCKET_COUNT; ++i)
+    buckets_[i].store(0, std::memory_order_relaxed);
+}
+
+IKStatistics::Summary IKStatistics::getSummary() const
+{
+  // the counters are read one at a time, so queries recorded meanwhile may be counted in some but not all of them
+  Summary summary;
+  summary.queries = queries_.load(std::memory_order_relaxed);
+  summary.successes = successes_.load(std::memory_order_relaxed);
+  summary.restarts = restarts_.load(std::memory_order_relaxed);
+  summary.success_rate = summary.queries ? static_cast<double>(summary.successes) / summary.queries : 0.0;
+  summary.mean_latency =
+      summary.queries ? 1e-9 * total_nanoseconds_.load(std::memory_order_relaxed) / summary.queries : 0.0;
+  summary.max_latency = 1e-9 * max_nanoseconds_.load(std::memory_order_relaxed);
+
+  std::size_t counts[BUCKET_COUNT];
+  std::size_t total = 0;
+  for (unsigned int i = 0; i < BUCKET_COUNT; ++i)
+    total += counts[i] = buckets_[i].load(std::memory_order_relaxed);
+
+  summary.p50_latency = 0.0;
+  summary.p99_latency = 0.0;
+  std::size_t seen = 0;
+  bool p50_found = false;
+  for (unsigned int i = 0; i < BUCKET_COUNT && total > 0; ++i)
+  {
+    seen += counts[i];
+    if (!p50_found && 2 * seen >= total)
+    {
+      summary.p50_latency = getBucketLatency(i);
+      p50_found = true;
+    }
+    if (100 * seen >= 99 * total)
+    {
+      summary.p99_latency = getBucketLatency(i);
+      break;
+    }
+  }
+  return summary;
+}
+
+std::string IKStatistics::toString(const Summary& summary)
+{
+  std::stringstream ss;
+  ss << summary.queries << " queries, " << std::fixed << std::setprecision(1) << 100.0 * summary.success_rate
+     << "% successful, " << summary.restarts << " restarts, latency mean " << std::setprecision(3)
+     << 1e3 * summary.mean_latency << " ms, p50 " << 1e3 * summary.p50_latency << " ms, p99 "
+     << 1e3 * summary.p99_latency << " ms, max " << 1e3 * summary.max_latency << " ms";
+  return ss.str();
+}
+}
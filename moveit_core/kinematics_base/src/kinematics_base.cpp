@@ -36,6 +36,7 @@
 
 #include <moveit/kinematics_base/kinematics_base.h>
 #include <moveit/robot_model/joint_model_group.h>
+#include <eigen_conversions/eigen_msg.h>
 
 const double kinematics::KinematicsBase::DEFAULT_SEARCH_DISCRETIZATION = 0.1;
 const double kinematics::KinematicsBase::DEFAULT_TIMEOUT = 1.0;
@@ -171,3 +172,85 @@ bool kinematics::KinematicsBase::getPositionIK(const std::vector<geometry_msgs::
 
   return true;
 }
+
+std::size_t kinematics::KinematicsBase::getPositionIKBatch(const EigenSTL::vector_Affine3d& poses,
+                                                           const std::vector<double>& seeds,
+                                                           std::vector<std::vector<double> >& solutions,
+                                                           std::vector<moveit_msgs::MoveItErrorCodes>& error_codes,
+                                                           const kinematics::KinematicsQueryOptions& options) const
+{
+  solutions.assign(poses.size(), std::vector<double>());
+  error_codes.resize(poses.size());
+  if (poses.empty())
+    return 0;
+
+  // unless there is one seed per pose, the same seed is used for all of them
+  std::size_t dimension = getJointNames().size();
+  bool seed_per_pose = poses.size() > 1 && seeds.size() == dimension * poses.size();
+  std::vector<double> seed(seeds.begin(), seed_per_pose ? seeds.begin() + dimension : seeds.end());
+
+  std::size_t solved = 0;
+  geometry_msgs::Pose pose;
+  for (std::size_t i = 0; i < poses.size(); ++i)
+  {
+    if (seed_per_pose)
+      seed.assign(seeds.begin() + i * dimension, seeds.begin() + (i + 1) * dimension);
+    tf::poseEigenToMsg(poses[i], pose);
+    if (getPositionIK(pose, seed, solutions[i], error_codes[i], options))
+      ++solved;
+    else
+      solutions[i].clear();
+  }
+  return solved;
+}
+
+bool kinematics::KinematicsBase::searchPositionIK(const Eigen::Affine3d& ik_pose,
+                                                  const Eigen::Ref<const Eigen::VectorXd>& ik_seed_state,
+                                                  double timeout, Eigen::Ref<Eigen::VectorXd> solution,
+                                                  const IKCallbackFn& solution_callback,
+                                                  moveit_msgs::MoveItErrorCodes& error_code,
+                                                  const kinematics::KinematicsQueryOptions& options) const
+{
+  geometry_msgs::Pose pose;
+  tf::poseEigenToMsg(ik_pose, pose);
+  std::vector<double> seed(ik_seed_state.size());
+  for (std::size_t i = 0; i < seed.size(); ++i)
+    seed[i] = ik_seed_state[i];
+
+  std::vector<double> sol;
+  if (!(solution_callback ? searchPositionIK(pose, seed, timeout, sol, solution_callback, error_code, options) :
+                            searchPositionIK(pose, seed, timeout, sol, error_code, options)))
+    return false;
+  if (sol.size() != (std::size_t)solution.size())
+  {
+    logError("moveit.kinematics_base: IK solution has size %u instead of %u", (unsigned int)sol.size(),
+             (unsigned int)solution.size());
+    error_code.val = moveit_msgs::MoveItErrorCodes::NO_IK_SOLUTION;
+    return false;
+  }
+  for (std::size_t i = 0; i < sol.size(); ++i)
+    solution[i] = sol[i];
+  return true;
+}
+
+kinematics::IKTrackingSessionPtr
+kinematics::KinematicsBase::beginTracking(const std::vector<double>& ik_seed_state,
+                                          const kinematics::KinematicsQueryOptions& options) const
+{
+  return IKTrackingSessionPtr();
+}
+
+bool kinematics::KinematicsBase::getPositionFK(const Eigen::Ref<const Eigen::VectorXd>& joint_angles,
+                                               Eigen::Affine3d& tip_pose) const
+{
+  std::vector<std::string> link_names(1, getTipFrame());
+  std::vector<double> values(joint_angles.size());
+  for (std::size_t i = 0; i < values.size(); ++i)
+    values[i] = joint_angles[i];
+
+  std::vector<geometry_msgs::Pose> poses;
+  if (!getPositionFK(link_names, values, poses) || poses.size() != 1)
+    return false;
+  tf::poseMsgToEigen(poses[0], tip_pose);
+  return true;
+}
@@ -79,6 +79,42 @@ public:
                               const robot_model::JointModelGroup* joint_model_group, double& manipulability_index,
                               bool translation = false) const;
 
+  /**
+   * @brief Get the manipulability for a given group at a given joint configuration, computing the Jacobian into
+   * \e jacobian so that its storage can be reused across calls (groups of 6 or 7 variables use fixed-size
+   * matrices and do not touch it)
+   * @param state Complete kinematic state for the robot
+   * @param joint_model_group A pointer to the desired joint model group
+   * @param manipulability_index The computed manipulability = sqrt(det(JJ^T))
+   * @param jacobian Storage for the Jacobian
+   * @return False if the group is not a chain or the Jacobian could not be computed
+   */
+  bool getManipulabilityIndex(const robot_state::RobotState& state,
+                              const robot_model::JointModelGroup* joint_model_group, double& manipulability_index,
+                              bool translation, Eigen::MatrixXd& jacobian) const;
+
+  /**
+   * @brief Get the manipulability for a given group at many joint configurations
+   * @param states The kinematic states for the robot
+   * @param group_name The group name (e.g. "arm")
+   * @param manipulability_indices Resized to the number of states; element i is the manipulability for states[i]
+   * @return False if the group was not found or the manipulability could not be computed for one of the states
+   */
+  bool getManipulabilityIndices(const std::vector<const robot_state::RobotState*>& states,
+                                const std::string& group_name, std::vector<double>& manipulability_indices,
+                                bool translation = false) const;
+
+  /**
+   * @brief Get the manipulability for a given group at many joint configurations
+   * @param states The kinematic states for the robot
+   * @param joint_model_group A pointer to the desired joint model group
+   * @param manipulability_indices Resized to the number of states; element i is the manipulability for states[i]
+   * @return False if the group is not a chain or the manipulability could not be computed for one of the states
+   */
+  bool getManipulabilityIndices(const std::vector<const robot_state::RobotState*>& states,
+                                const robot_model::JointModelGroup* joint_model_group,
+                                std::vector<double>& manipulability_indices, bool translation = false) const;
+
   /**
    * @brief Get the (translation) manipulability ellipsoid for a given group at a given joint configuration
    * @param state Complete kinematic state for the robot
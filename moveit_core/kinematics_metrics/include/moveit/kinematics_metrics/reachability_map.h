@@ -0,0 +1,186 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_KINEMATICS_METRICS_REACHABILITY_MAP_
+#define MOVEIT_KINEMATICS_METRICS_REACHABILITY_MAP_
+
+#include <moveit/macros/class_forward.h>
+#include <moveit/robot_model/robot_model.h>
+#include <boost/cstdint.hpp>
+#include <Eigen/Geometry>
+#include <string>
+#include <vector>
+
+namespace kinematics_metrics
+{
+MOVEIT_CLASS_FORWARD(ReachabilityMap);
+
+/**
+ * \brief A voxel grid over the workspace of a chain group. For every voxel it stores how many sampled joint states
+ * put the tip link of the group in it, and the best manipulability any of them had there.
+ *
+ * Positions are expressed in the base frame of the group (the parent link of its root joint), so a map stays valid
+ * when the rest of the robot moves. Only the position of the tip link is considered: a voxel that was never reached
+ * is (up to sampling density) unreachable, but a reached voxel may still be unreachable for some orientations.
+ */
+class ReachabilityMap
+{
+public:
+  /** \brief The data stored for each voxel */
+  struct Voxel
+  {
+    Voxel() : samples(0), manipulability(0.0f)
+    {
+    }
+
+    /** \brief The number of sampled states that placed the tip link in this voxel */
+    boost::uint32_t samples;
+
+    /** \brief The largest manipulability index of these states */
+    float manipulability;
+  };
+
+  /** \brief Parameters for generate() */
+  struct GenerationOptions
+  {
+    GenerationOptions() : resolution(0.05), samples(1000000), thread_count(0)
+    {
+    }
+
+    /** \brief The edge length of a voxel (m) */
+    double resolution;
+
+    /** \brief The number of joint states to sample */
+    std::size_t samples;
+
+    /** \brief The number of threads to sample with (0 means one per core) */
+    unsigned int thread_count;
+  };
+
+  ReachabilityMap();
+
+  /** \brief Build the map for the chain group \e group_name by sampling random states of the group in parallel.
+   * The tip is the last link of the group, as for RobotState::getJacobian(). */
+  bool generate(const robot_model::RobotModelConstPtr& robot_model, const std::string& group_name,
+                const GenerationOptions& options = GenerationOptions());
+
+  /** \brief Write the map to a binary file (in host byte order) */
+  bool saveToFile(const std::string& filename) const;
+
+  /** \brief Read a map written by saveToFile() */
+  bool loadFromFile(const std::string& filename);
+
+  /** \brief Get the voxel that contains \e position (in the base frame), or NULL if that is outside the map */
+  const Voxel* getVoxel(const Eigen::Vector3d& position) const
+  {
+    if (voxels_.empty())
+      return NULL;
+    const Eigen::Vector3d index = (position - origin_) / resolution_;
+    if (index.x() < 0.0 || index.y() < 0.0 || index.z() < 0.0 || index.x() >= size_[0] || index.y() >= size_[1] ||
+        index.z() >= size_[2])
+      return NULL;
+    return &voxels_[(static_cast<std::size_t>(index.z()) * size_[1] + static_cast<std::size_t>(index.y())) * size_[0] +
+                    static_cast<std::size_t>(index.x())];
+  }
+
+  /** \brief Check if the tip link was ever sampled at \e position (in the base frame) */
+  bool isReachable(const Eigen::Vector3d& position) const
+  {
+    const Voxel* voxel = getVoxel(position);
+    return voxel && voxel->samples > 0;
+  }
+
+  /** \brief Get the number of samples at \e position relative to the most sampled voxel, in [0, 1] */
+  double getReachability(const Eigen::Vector3d& position) const;
+
+  /** \brief Get the largest manipulability index sampled at \e position, 0 if none */
+  double getManipulability(const Eigen::Vector3d& position) const;
+
+  /** \brief Check if the map holds any data */
+  bool empty() const
+  {
+    return voxels_.empty();
+  }
+
+  const std::string& getGroupName() const
+  {
+    return group_name_;
+  }
+
+  /** \brief The frame positions are expressed in */
+  const std::string& getBaseFrame() const
+  {
+    return base_frame_;
+  }
+
+  /** \brief The link whose positions were sampled */
+  const std::string& getTipFrame() const
+  {
+    return tip_frame_;
+  }
+
+  double getResolution() const
+  {
+    return resolution_;
+  }
+
+  /** \brief The corner of the map with the smallest coordinates */
+  const Eigen::Vector3d& getOrigin() const
+  {
+    return origin_;
+  }
+
+  /** \brief The number of voxels along axis \e axis */
+  unsigned int getSize(unsigned int axis) const
+  {
+    return size_[axis];
+  }
+
+private:
+  std::string group_name_;
+  std::string base_frame_;
+  std::string tip_frame_;
+  double resolution_;
+  Eigen::Vector3d origin_;
+  unsigned int size_[3];
+
+  /** \brief The largest sample count of any voxel */
+  boost::uint32_t max_samples_;
+
+  /** \brief The voxels, x varying fastest */
+  std::vector<Voxel> voxels_;
+};
+}
+
+#endif
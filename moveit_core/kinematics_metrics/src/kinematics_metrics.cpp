@@ -40,6 +40,34 @@
 
 namespace kinematics_metrics
 {
+namespace
+{
+/* The product of the singular values of an m x n Jacobian is sqrt(det(J J^T)) if m <= n and sqrt(det(J^T J))
+   otherwise, so the manipulability index does not need a singular value decomposition. For the 6 and 7 variable
+   groups the matrices have fixed sizes and no heap allocations are made. */
+template <typename MatrixType>
+double singularValueProduct(const MatrixType& jacobian)
+{
+  const typename MatrixType::PlainObject matrix = jacobian;
+  const double determinant = matrix.rows() <= matrix.cols() ? (matrix * matrix.transpose()).determinant() :
+                                                              (matrix.transpose() * matrix).determinant();
+  // rounding can make the determinant of a singular Jacobian slightly negative
+  return sqrt(std::max(0.0, determinant));
+}
+
+/* sigma_min / sigma_max of the Jacobian */
+template <typename MatrixType>
+double conditionRatio(const MatrixType& jacobian)
+{
+  Eigen::JacobiSVD<typename MatrixType::PlainObject> svdsolver(jacobian);
+  const typename Eigen::JacobiSVD<typename MatrixType::PlainObject>::SingularValuesType& singular_values =
+      svdsolver.singularValues();
+  for (int i = 0; i < singular_values.rows(); ++i)
+    logDebug("moveit.kin_metrics: Singular value: %d %f", i, singular_values(i));
+  return singular_values.minCoeff() / singular_values.maxCoeff();
+}
+}
+
 double KinematicsMetrics::getJointLimitsPenalty(const robot_state::RobotState& state,
                                                 const robot_model::JointModelGroup* joint_model_group) const
 {
@@ -103,6 +131,15 @@ bool KinematicsMetrics::getManipulabilityIndex(const robot_state::RobotState& st
 bool KinematicsMetrics::getManipulabilityIndex(const robot_state::RobotState& state,
                                                const robot_model::JointModelGroup* joint_model_group,
                                                double& manipulability_index, bool translation) const
+{
+  Eigen::MatrixXd jacobian;
+  return getManipulabilityIndex(state, joint_model_group, manipulability_index, translation, jacobian);
+}
+
+bool KinematicsMetrics::getManipulabilityIndex(const robot_state::RobotState& state,
+                                               const robot_model::JointModelGroup* joint_model_group,
+                                               double& manipulability_index, bool translation,
+                                               Eigen::MatrixXd& jacobian) const
 {
   // state.getJacobian() only works for chain groups.
   if (!joint_model_group->isChain())
@@ -110,54 +147,59 @@ bool KinematicsMetrics::getManipulabilityIndex(const robot_state::RobotState& st
     return false;
   }
 
-  Eigen::MatrixXd jacobian = state.getJacobian(joint_model_group);
-  // Get joint limits penalty
-  double penalty = getJointLimitsPenalty(state, joint_model_group);
-  if (translation)
+  const robot_model::LinkModel* tip = joint_model_group->getLinkModels().back();
+  const Eigen::Vector3d reference_point(0.0, 0.0, 0.0);
+  switch (joint_model_group->getVariableCount())
   {
-    if (jacobian.cols() < 6)
+    case 6:
     {
-      Eigen::JacobiSVD<Eigen::MatrixXd> svdsolver(jacobian.topLeftCorner(3, jacobian.cols()));
-      Eigen::MatrixXd singular_values = svdsolver.singularValues();
-      manipulability_index = 1.0;
-      for (unsigned int i = 0; i < singular_values.rows(); ++i)
-      {
-        logDebug("moveit.kin_metrics: Singular value: %d %f", i, singular_values(i, 0));
-        manipulability_index *= singular_values(i, 0);
-      }
-      // Get manipulability index
-      manipulability_index = penalty * manipulability_index;
+      Eigen::Matrix<double, 6, 6> jacobian_6;
+      if (!state.getJacobian(joint_model_group, tip, reference_point, jacobian_6))
+        return false;
+      manipulability_index = translation ? singularValueProduct(jacobian_6.topRows<3>()) :
+                                           singularValueProduct(jacobian_6);
+      break;
     }
-    else
+    case 7:
     {
-      Eigen::MatrixXd jacobian_2 = jacobian.topLeftCorner(3, jacobian.cols());
-      Eigen::MatrixXd matrix = jacobian_2 * jacobian_2.transpose();
-      // Get manipulability index
-      manipulability_index = penalty * sqrt(matrix.determinant());
+      Eigen::Matrix<double, 6, 7> jacobian_7;
+      if (!state.getJacobian(joint_model_group, tip, reference_point, jacobian_7))
+        return false;
+      manipulability_index = translation ? singularValueProduct(jacobian_7.topRows<3>()) :
+                                           singularValueProduct(jacobian_7);
+      break;
     }
+    default:
+      if (!state.getJacobian(joint_model_group, tip, reference_point, jacobian))
+        return false;
+      manipulability_index =
+          translation ? singularValueProduct(jacobian.topRows(3)) : singularValueProduct(jacobian);
   }
+  // Get joint limits penalty
+  manipulability_index *= getJointLimitsPenalty(state, joint_model_group);
+  return true;
+}
+
+bool KinematicsMetrics::getManipulabilityIndices(const std::vector<const robot_state::RobotState*>& states,
+                                                 const std::string& group_name,
+                                                 std::vector<double>& manipulability_indices, bool translation) const
+{
+  const robot_model::JointModelGroup* joint_model_group = robot_model_->getJointModelGroup(group_name);
+  if (joint_model_group)
+    return getManipulabilityIndices(states, joint_model_group, manipulability_indices, translation);
   else
-  {
-    if (jacobian.cols() < 6)
-    {
-      Eigen::JacobiSVD<Eigen::MatrixXd> svdsolver(jacobian);
-      Eigen::MatrixXd singular_values = svdsolver.singularValues();
-      manipulability_index = 1.0;
-      for (unsigned int i = 0; i < singular_values.rows(); ++i)
-      {
-        logDebug("moveit.kin_metrics: Singular value: %d %f", i, singular_values(i, 0));
-        manipulability_index *= singular_values(i, 0);
-      }
-      // Get manipulability index
-      manipulability_index = penalty * manipulability_index;
-    }
-    else
-    {
-      Eigen::MatrixXd matrix = jacobian * jacobian.transpose();
-      // Get manipulability index
-      manipulability_index = penalty * sqrt(matrix.determinant());
-    }
-  }
+    return false;
+}
+
+bool KinematicsMetrics::getManipulabilityIndices(const std::vector<const robot_state::RobotState*>& states,
+                                                 const robot_model::JointModelGroup* joint_model_group,
+                                                 std::vector<double>& manipulability_indices, bool translation) const
+{
+  manipulability_indices.resize(states.size());
+  Eigen::MatrixXd jacobian;
+  for (std::size_t i = 0; i < states.size(); ++i)
+    if (!getManipulabilityIndex(*states[i], joint_model_group, manipulability_indices[i], translation, jacobian))
+      return false;
   return true;
 }
 
@@ -183,9 +225,10 @@ bool KinematicsMetrics::getManipulabilityEllipsoid(const robot_state::RobotState
     return false;
   }
 
+  // only the translation rows of J J^T are needed
   Eigen::MatrixXd jacobian = state.getJacobian(joint_model_group);
-  Eigen::MatrixXd matrix = jacobian * jacobian.transpose();
-  Eigen::EigenSolver<Eigen::MatrixXd> eigensolver(matrix.block(0, 0, 3, 3));
+  Eigen::Matrix3d matrix = jacobian.topRows(3) * jacobian.topRows(3).transpose();
+  Eigen::EigenSolver<Eigen::Matrix3d> eigensolver(matrix);
   eigen_values = eigensolver.eigenvalues();
   eigen_vectors = eigensolver.eigenvectors();
   return true;
@@ -210,26 +253,36 @@ bool KinematicsMetrics::getManipulability(const robot_state::RobotState& state,
   {
     return false;
   }
-  // Get joint limits penalty
-  double penalty = getJointLimitsPenalty(state, joint_model_group);
-  if (translation)
+  const robot_model::LinkModel* tip = joint_model_group->getLinkModels().back();
+  const Eigen::Vector3d reference_point(0.0, 0.0, 0.0);
+  switch (joint_model_group->getVariableCount())
   {
-    Eigen::MatrixXd jacobian = state.getJacobian(joint_model_group);
-    Eigen::JacobiSVD<Eigen::MatrixXd> svdsolver(jacobian.topLeftCorner(3, jacobian.cols()));
-    Eigen::MatrixXd singular_values = svdsolver.singularValues();
-    for (int i = 0; i < singular_values.rows(); ++i)
-      logDebug("moveit.kin_metrics: Singular value: %d %f", i, singular_values(i, 0));
-    manipulability = penalty * singular_values.minCoeff() / singular_values.maxCoeff();
-  }
-  else
-  {
-    Eigen::MatrixXd jacobian = state.getJacobian(joint_model_group);
-    Eigen::JacobiSVD<Eigen::MatrixXd> svdsolver(jacobian);
-    Eigen::MatrixXd singular_values = svdsolver.singularValues();
-    for (int i = 0; i < singular_values.rows(); ++i)
-      logDebug("moveit.kin_metrics: Singular value: %d %f", i, singular_values(i, 0));
-    manipulability = penalty * singular_values.minCoeff() / singular_values.maxCoeff();
+    case 6:
+    {
+      Eigen::Matrix<double, 6, 6> jacobian;
+      if (!state.getJacobian(joint_model_group, tip, reference_point, jacobian))
+        return false;
+      manipulability = translation ? conditionRatio(jacobian.topRows<3>()) : conditionRatio(jacobian);
+      break;
+    }
+    case 7:
+    {
+      Eigen::Matrix<double, 6, 7> jacobian;
+      if (!state.getJacobian(joint_model_group, tip, reference_point, jacobian))
+        return false;
+      manipulability = translation ? conditionRatio(jacobian.topRows<3>()) : conditionRatio(jacobian);
+      break;
+    }
+    default:
+    {
+      Eigen::MatrixXd jacobian;
+      if (!state.getJacobian(joint_model_group, tip, reference_point, jacobian))
+        return false;
+      manipulability = translation ? conditionRatio(jacobian.topRows(3)) : conditionRatio(jacobian);
+    }
   }
+  // Get joint limits penalty
+  manipulability *= getJointLimitsPenalty(state, joint_model_group);
   return true;
 }
 
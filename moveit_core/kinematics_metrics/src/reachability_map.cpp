@@ -0,0 +1,303 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/kinematics_metrics/reachability_map.h>
+#include <moveit/kinematics_metrics/kinematics_metrics.h>
+#include <moveit/robot_state/robot_state.h>
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#include <console_bridge/console.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+namespace kinematics_metrics
+{
+namespace
+{
+const char FILE_MAGIC[4] = { 'M', 'R', 'M', 'P' };
+const boost::uint32_t FILE_VERSION = 1;
+
+// the largest map we are willing to allocate, to catch bad resolutions and corrupt files
+const std::size_t MAX_VOXELS = 1u << 28;
+
+struct WorkspaceSample
+{
+  Eigen::Vector3d position;
+  double manipulability;
+};
+
+void sampleWorkspace(const robot_model::RobotModelConstPtr& robot_model, const robot_model::JointModelGroup* group,
+                     std::size_t count, std::vector<WorkspaceSample>* samples)
+{
+  robot_state::RobotState state(robot_model);
+  state.setToDefaultValues();
+  random_numbers::RandomNumberGenerator& rng = moveit::core::getThreadRandomNumberGenerator();
+  KinematicsMetrics metrics(robot_model);
+  const robot_model::LinkModel* tip = group->getLinkModels().back();
+  const robot_model::LinkModel* base = group->getCommonRoot()->getParentLinkModel();
+
+  samples->resize(count);
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    state.setToRandomPositions(group, rng);
+    state.update();
+    WorkspaceSample& sample = (*samples)[i];
+    sample.position = base ? state.getGlobalLinkTransform(base).inverse(Eigen::Isometry) *
+                                 state.getGlobalLinkTransform(tip).translation() :
+                             state.getGlobalLinkTransform(tip).translation();
+    if (!metrics.getManipulabilityIndex(state, group, sample.manipulability))
+      sample.manipulability = 0.0;
+  }
+}
+
+template <typename T>
+void writeValue(std::ofstream& out, const T& value)
+{
+  out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool readValue(std::ifstream& in, T& value)
+{
+  return in.read(reinterpret_cast<char*>(&value), sizeof(T)).good();
+}
+
+void writeString(std::ofstream& out, const std::string& value)
+{
+  writeValue(out, static_cast<boost::uint32_t>(value.size()));
+  out.write(value.data(), value.size());
+}
+
+bool readString(std::ifstream& in, std::string& value)
+{
+  boost::uint32_t size;
+  if (!readValue(in, size) || size > 4096)
+    return false;
+  value.resize(size);
+  return size == 0 || in.read(&value[0], size).good();
+}
+}
+
+ReachabilityMap::ReachabilityMap() : resolution_(0.0), origin_(Eigen::Vector3d::Zero()), max_samples_(0)
+{
+  size_[0] = size_[1] = size_[2] = 0;
+}
+
+bool ReachabilityMap::generate(const robot_model::RobotModelConstPtr& robot_model, const std::string& group_name,
+                               const GenerationOptions& options)
+{
+  const robot_model::JointModelGroup* group = robot_model->getJointModelGroup(group_name);
+  if (!group)
+  {
+    logError("Group '%s' not found", group_name.c_str());
+    return false;
+  }
+  if (!group->isChain())
+  {
+    logError("Reachability maps can only be generated for chain groups and '%s' is not one", group_name.c_str());
+    return false;
+  }
+  if (options.resolution <= 0.0 || options.samples == 0)
+  {
+    logError("Reachability maps need a positive resolution and number of samples");
+    return false;
+  }
+
+  // sample the workspace in parallel; each thread has its own state and random number generator
+  unsigned int thread_count = options.thread_count;
+  if (thread_count == 0)
+    thread_count = std::max(1u, boost::thread::hardware_concurrency());
+  thread_count = std::min<std::size_t>(thread_count, options.samples);
+  std::vector<std::vector<WorkspaceSample> > samples(thread_count);
+  boost::thread_group threads;
+  for (unsigned int i = 0; i < thread_count; ++i)
+  {
+    std::size_t count = options.samples / thread_count + (i < options.samples % thread_count ? 1 : 0);
+    threads.create_thread(boost::bind(&sampleWorkspace, robot_model, group, count, &samples[i]));
+  }
+  threads.join_all();
+
+  // the map only covers the bounding box of the samples
+  Eigen::Vector3d min_position = samples[0][0].position;
+  Eigen::Vector3d max_position = min_position;
+  for (std::size_t i = 0; i < samples.size(); ++i)
+    for (std::size_t j = 0; j < samples[i].size(); ++j)
+    {
+      min_position = min_position.cwiseMin(samples[i][j].position);
+      max_position = max_position.cwiseMax(samples[i][j].position);
+    }
+
+  Eigen::Vector3d origin;
+  std::size_t voxel_count = 1;
+  unsigned int size[3];
+  for (int i = 0; i < 3; ++i)
+  {
+    origin[i] = std::floor(min_position[i] / options.resolution) * options.resolution;
+    size[i] = static_cast<unsigned int>((max_position[i] - origin[i]) / options.resolution) + 1;
+    voxel_count *= size[i];
+  }
+  if (voxel_count > MAX_VOXELS)
+  {
+    logError("A reachability map of group '%s' with resolution %lf would have %zu voxels; use a coarser resolution",
+             group_name.c_str(), options.resolution, voxel_count);
+    return false;
+  }
+
+  const robot_model::LinkModel* base = group->getCommonRoot()->getParentLinkModel();
+  group_name_ = group_name;
+  base_frame_ = base ? base->getName() : robot_model->getModelFrame();
+  tip_frame_ = group->getLinkModels().back()->getName();
+  resolution_ = options.resolution;
+  origin_ = origin;
+  std::copy(size, size + 3, size_);
+  voxels_.assign(voxel_count, Voxel());
+  max_samples_ = 0;
+
+  for (std::size_t i = 0; i < samples.size(); ++i)
+    for (std::size_t j = 0; j < samples[i].size(); ++j)
+    {
+      // samples on the upper boundary can land outside of the map through rounding
+      Voxel* voxel = const_cast<Voxel*>(getVoxel(samples[i][j].position));
+      if (!voxel)
+        continue;
+      if (voxel->samples < std::numeric_limits<boost::uint32_t>::max())
+        voxel->samples++;
+      voxel->manipulability = std::max(voxel->manipulability, static_cast<float>(samples[i][j].manipulability));
+      max_samples_ = std::max(max_samples_, voxel->samples);
+    }
+
+  logInform("Generated a reachability map of group '%s' with %u x %u x %u voxels of %lf m from %zu samples",
+            group_name.c_str(), size_[0], size_[1], size_[2], resolution_, options.samples);
+  return true;
+}
+
+double ReachabilityMap::getReachability(const Eigen::Vector3d& position) const
+{
+  const Voxel* voxel = getVoxel(position);
+  return voxel && max_samples_ > 0 ? static_cast<double>(voxel->samples) / static_cast<double>(max_samples_) : 0.0;
+}
+
+double ReachabilityMap::getManipulability(const Eigen::Vector3d& position) const
+{
+  const Voxel* voxel = getVoxel(position);
+  return voxel ? voxel->manipulability : 0.0;
+}
+
+bool ReachabilityMap::saveToFile(const std::string& filename) const
+{
+  std::ofstream out(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!out)
+  {
+    logError("Unable to open '%s' for writing", filename.c_str());
+    return false;
+  }
+
+  out.write(FILE_MAGIC, sizeof(FILE_MAGIC));
+  writeValue(out, FILE_VERSION);
+  writeString(out, group_name_);
+  writeString(out, base_frame_);
+  writeString(out, tip_frame_);
+  writeValue(out, resolution_);
+  for (int i = 0; i < 3; ++i)
+    writeValue(out, origin_[i]);
+  for (int i = 0; i < 3; ++i)
+    writeValue(out, static_cast<boost::uint32_t>(size_[i]));
+  for (std::size_t i = 0; i < voxels_.size(); ++i)
+  {
+    writeValue(out, voxels_[i].samples);
+    writeValue(out, voxels_[i].manipulability);
+  }
+
+  if (!out.good())
+  {
+    logError("Failed writing reachability map to '%s'", filename.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool ReachabilityMap::loadFromFile(const std::string& filename)
+{
+  std::ifstream in(filename.c_str(), std::ios::in | std::ios::binary);
+  if (!in)
+  {
+    logError("Unable to open '%s' for reading", filename.c_str());
+    return false;
+  }
+
+  char magic[sizeof(FILE_MAGIC)];
+  boost::uint32_t version;
+  if (!in.read(magic, sizeof(magic)) || memcmp(magic, FILE_MAGIC, sizeof(magic)) != 0 || !readValue(in, version) ||
+      version != FILE_VERSION)
+  {
+    logError("'%s' is not a reachability map", filename.c_str());
+    return false;
+  }
+
+  ReachabilityMap map;
+  bool ok = readString(in, map.group_name_) && readString(in, map.base_frame_) && readString(in, map.tip_frame_) &&
+            readValue(in, map.resolution_);
+  for (int i = 0; ok && i < 3; ++i)
+    ok = readValue(in, map.origin_[i]);
+  std::size_t voxel_count = 1;
+  for (int i = 0; ok && i < 3; ++i)
+  {
+    boost::uint32_t size;
+    ok = readValue(in, size);
+    map.size_[i] = size;
+    voxel_count *= size;
+  }
+  ok = ok && map.resolution_ > 0.0 && voxel_count > 0 && voxel_count <= MAX_VOXELS;
+  if (ok)
+  {
+    map.voxels_.resize(voxel_count);
+    for (std::size_t i = 0; ok && i < voxel_count; ++i)
+    {
+      ok = readValue(in, map.voxels_[i].samples) && readValue(in, map.voxels_[i].manipulability);
+      map.max_samples_ = std::max(map.max_samples_, map.voxels_[i].samples);
+    }
+  }
+  if (!ok)
+  {
+    logError("Reachability map '%s' is corrupt", filename.c_str());
+    return false;
+  }
+
+  *this = map;
+  return true;
+}
+}
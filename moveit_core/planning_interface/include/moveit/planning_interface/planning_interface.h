@@ -40,6 +40,7 @@
 #include <moveit/macros/class_forward.h>
 #include <moveit/planning_interface/planning_request.h>
 #include <moveit/planning_interface/planning_response.h>
+#include <boost/function.hpp>
 #include <string>
 #include <map>
 
@@ -76,6 +77,11 @@ typedef std::map<std::string, PlannerConfigurationSettings> PlannerConfiguration
 
 MOVEIT_CLASS_FORWARD(PlanningContext);
 
+/** \brief A function called with the solutions a planning context finds while solve() is still running, each better
+    than the previous one. The trajectories are geometric paths from the start state; they are neither post-processed
+    nor time parameterized. The function may be called from planning threads */
+typedef boost::function<void(const robot_trajectory::RobotTrajectoryPtr&)> IntermediateSolutionCallback;
+
 /** \brief Representation of a particular planning context -- the planning scene and the request are known,
     solution is not yet computed. */
 class PlanningContext
@@ -116,6 +122,18 @@ public:
   /** \brief Set the planning request for this context */
   void setMotionPlanRequest(const MotionPlanRequest& request);
 
+  /** \brief Set the function called with the improving solutions found while solve() runs. Planning contexts that do
+   * not report intermediate solutions ignore it. Implementations of clear() reset it */
+  void setIntermediateSolutionCallback(const IntermediateSolutionCallback& callback)
+  {
+    intermediate_solution_callback_ = callback;
+  }
+
+  const IntermediateSolutionCallback& getIntermediateSolutionCallback() const
+  {
+    return intermediate_solution_callback_;
+  }
+
   /** \brief Solve the motion planning problem and store the result in \e res. This function should not clear data
    * structures before computing. The constructor and clear() do that. */
   virtual bool solve(MotionPlanResponse& res) = 0;
@@ -143,6 +161,9 @@ protected:
 
   /// The planning request for this context
   MotionPlanRequest request_;
+
+  /// The function solve() reports intermediate solutions to, if any
+  IntermediateSolutionCallback intermediate_solution_callback_;
 };
 
 MOVEIT_CLASS_FORWARD(PlannerManager);
@@ -41,6 +41,8 @@
 #include <moveit_msgs/MoveItErrorCodes.h>
 #include <moveit_msgs/MotionPlanResponse.h>
 #include <moveit_msgs/MotionPlanDetailedResponse.h>
+#include <map>
+#include <string>
 
 namespace planning_interface
 {
@@ -55,6 +57,17 @@ struct MotionPlanResponse
   robot_trajectory::RobotTrajectoryPtr trajectory_;
   double planning_time_;
   moveit_msgs::MoveItErrorCodes error_code_;
+
+  /// the stages the request went through, when it was planned through a PlanningRequestAdapterChain: the description
+  /// of each planning request adapter, in order, followed by that of the planner; empty otherwise. Callers that
+  /// process the plan further (e.g. a PlanningPipeline checking the solution path) may append their own stages.
+  std::vector<std::string> stage_description_;
+  /// the wall time spent in each of the stages in stage_description_, not counting the stages it called
+  std::vector<double> stage_processing_time_;
+
+  /// counters and timings the planner reports about how it computed the plan, by name; these are not part of the
+  /// message
+  std::map<std::string, double> statistics_;
 };
 
 struct MotionPlanDetailedResponse
@@ -65,6 +78,9 @@ struct MotionPlanDetailedResponse
   std::vector<std::string> description_;
   std::vector<double> processing_time_;
   moveit_msgs::MoveItErrorCodes error_code_;
+
+  /// counters the planner reports about how it computed the plan, by name; these are not part of the message
+  std::map<std::string, double> statistics_;
 };
 
 }  // planning_interface
@@ -35,11 +35,10 @@
 /* Author: Ioan Sucan */
 
 #include <moveit/planning_request_adapter/planning_request_adapter.h>
+#include <ros/time.h>
 #include <boost/bind.hpp>
 #include <algorithm>
 
-// we could really use some c++11 lambda functions here :)
-
 namespace planning_request_adapter
 {
 namespace
@@ -79,41 +78,84 @@ namespace planning_request_adapter
 {
 namespace
 {
-// boost bind is not happy with overloading, so we add intermediate function objects
-
-bool callAdapter1(const PlanningRequestAdapter* adapter, const planning_interface::PlannerManagerPtr& planner,
-                  const planning_scene::PlanningSceneConstPtr& planning_scene,
-                  const planning_interface::MotionPlanRequest& req, planning_interface::MotionPlanResponse& res,
-                  std::vector<std::size_t>& added_path_index)
+/* Runs the adapters of a chain: adapter i is given a planner function that runs adapter i + 1, and the last adapter
+   one that calls the planner. The request and response are passed along by reference, and the wall time spent in
+   each stage (including the stages it calls) is accumulated in inclusive_time_ */
+class AdapterChainCall
 {
-  try
+public:
+  AdapterChainCall(const std::vector<PlanningRequestAdapterConstPtr>& adapters,
+                   const planning_interface::PlannerManagerPtr& planner)
+    : adapters_(adapters)
+    , planner_(planner)
+    , added_path_index_(adapters.size())
+    , inclusive_time_(adapters.size() + 1, 0.0)
   {
-    return adapter->adaptAndPlan(planner, planning_scene, req, res, added_path_index);
   }
-  catch (std::exception& ex)
+
+  bool call(std::size_t index, const planning_scene::PlanningSceneConstPtr& planning_scene,
+            const planning_interface::MotionPlanRequest& req, planning_interface::MotionPlanResponse& res)
   {
-    logError("Exception caught executing *final* adapter '%s': %s", adapter->getDescription().c_str(), ex.what());
-    added_path_index.clear();
-    return callPlannerInterfaceSolve(planner.get(), planning_scene, req, res);
+    ros::WallTime start = ros::WallTime::now();
+    bool result;
+    if (index < adapters_.size())
+    {
+      PlanningRequestAdapter::PlannerFn next = boost::bind(&AdapterChainCall::call, this, index + 1, _1, _2, _3);
+      try
+      {
+        result = adapters_[index]->adaptAndPlan(next, planning_scene, req, res, added_path_index_[index]);
+      }
+      catch (std::exception& ex)
+      {
+        logError("Exception caught executing %s adapter '%s': %s", index + 1 < adapters_.size() ? "*next*" : "*final*",
+                 adapters_[index]->getDescription().c_str(), ex.what());
+        added_path_index_[index].clear();
+        result = next(planning_scene, req, res);
+      }
+    }
+    else
+      result = callPlannerInterfaceSolve(planner_.get(), planning_scene, req, res);
+    inclusive_time_[index] += (ros::WallTime::now() - start).toSec();
+    return result;
   }
-}
 
-bool callAdapter2(const PlanningRequestAdapter* adapter, const PlanningRequestAdapter::PlannerFn& planner,
-                  const planning_scene::PlanningSceneConstPtr& planning_scene,
-                  const planning_interface::MotionPlanRequest& req, planning_interface::MotionPlanResponse& res,
-                  std::vector<std::size_t>& added_path_index)
-{
-  try
+  /* merge the index values added by each adapter into \e added_path_index */
+  void getAddedPathIndex(std::vector<std::size_t>& added_path_index) const
   {
-    return adapter->adaptAndPlan(planner, planning_scene, req, res, added_path_index);
+    added_path_index.clear();
+    for (std::size_t i = 0; i < added_path_index_.size(); ++i)
+      for (std::size_t j = 0; j < added_path_index_[i].size(); ++j)
+      {
+        for (std::size_t k = 0; k < added_path_index.size(); ++k)
+          if (added_path_index_[i][j] <= added_path_index[k])
+            added_path_index[k]++;
+        added_path_index.push_back(added_path_index_[i][j]);
+      }
+    std::sort(added_path_index.begin(), added_path_index.end());
   }
-  catch (std::exception& ex)
+
+  /* report the time spent in each stage, without the stages it called, in \e res */
+  void getStageTimes(planning_interface::MotionPlanResponse& res) const
   {
-    logError("Exception caught executing *next* adapter '%s': %s", adapter->getDescription().c_str(), ex.what());
-    added_path_index.clear();
-    return planner(planning_scene, req, res);
+    res.stage_description_.resize(adapters_.size() + 1);
+    res.stage_processing_time_.resize(adapters_.size() + 1);
+    for (std::size_t i = 0; i < adapters_.size(); ++i)
+    {
+      res.stage_description_[i] = adapters_[i]->getDescription();
+      res.stage_processing_time_[i] = std::max(0.0, inclusive_time_[i] - inclusive_time_[i + 1]);
+    }
+    res.stage_description_.back() = planner_->getDescription();
+    res.stage_processing_time_.back() = inclusive_time_.back();
   }
-}
+
+private:
+  const std::vector<PlanningRequestAdapterConstPtr>& adapters_;
+  const planning_interface::PlannerManagerPtr& planner_;
+
+  // the index values added by each adapter
+  std::vector<std::vector<std::size_t> > added_path_index_;
+  std::vector<double> inclusive_time_;
+};
 }
 }
 
@@ -134,32 +176,16 @@ bool planning_request_adapter::PlanningRequestAdapterChain::adaptAndPlan(
   if (adapters_.empty())
   {
     added_path_index.clear();
+    res.stage_description_.clear();
+    res.stage_processing_time_.clear();
     return callPlannerInterfaceSolve(planner.get(), planning_scene, req, res);
   }
   else
   {
-    // the index values added by each adapter
-    std::vector<std::vector<std::size_t> > added_path_index_each(adapters_.size());
-
-    // if there are adapters, construct a function pointer for each, in order,
-    // so that in the end we have a nested sequence of function pointers that call the adapters in the correct order.
-    PlanningRequestAdapter::PlannerFn fn = boost::bind(&callAdapter1, adapters_.back().get(), planner, _1, _2, _3,
-                                                       boost::ref(added_path_index_each.back()));
-    for (int i = adapters_.size() - 2; i >= 0; --i)
-      fn = boost::bind(&callAdapter2, adapters_[i].get(), fn, _1, _2, _3, boost::ref(added_path_index_each[i]));
-    bool result = fn(planning_scene, req, res);
-    added_path_index.clear();
-
-    // merge the index values from each adapter
-    for (std::size_t i = 0; i < added_path_index_each.size(); ++i)
-      for (std::size_t j = 0; j < added_path_index_each[i].size(); ++j)
-      {
-        for (std::size_t k = 0; k < added_path_index.size(); ++k)
-          if (added_path_index_each[i][j] <= added_path_index[k])
-            added_path_index[k]++;
-        added_path_index.push_back(added_path_index_each[i][j]);
-      }
-    std::sort(added_path_index.begin(), added_path_index.end());
+    AdapterChainCall chain(adapters_, planner);
+    bool result = chain.call(0, planning_scene, req, res);
+    chain.getAddedPathIndex(added_path_index);
+    chain.getStageTimes(res);
     return result;
   }
 }
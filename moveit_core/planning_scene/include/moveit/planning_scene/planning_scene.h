@@ -54,6 +54,7 @@
 #include <boost/noncopyable.hpp>
 #include <boost/function.hpp>
 #include <boost/concept_check.hpp>
+#include <cstdint>
 #include <memory>
 
 /** \brief This namespace includes the central class for representing planning contexts */
@@ -98,6 +99,10 @@ public:
   static const std::string OCTOMAP_NS;
   static const std::string DEFAULT_SCENE_NAME;
 
+  /** \brief The id used in octomap messages that only carry the leaves changed since the previous version of the
+   * octomap (see processOctomapDiffMsg()) */
+  static const std::string OCTOMAP_DIFF_ID;
+
   ~PlanningScene();
 
   /** \brief Get the name of the planning scene. This is empty by default */
@@ -219,6 +224,12 @@ public:
    * body id or a collision object */
   bool knowsFrameTransform(const robot_state::RobotState& state, const std::string& id) const;
 
+  /** \brief Find the transform corresponding to the frame \e id with a single pass over the link names, attached
+   * bodies, collision objects and fixed transforms. Return NULL when no transform is available, so callers that would
+   * use knowsFrameTransform() followed by getFrameTransform() resolve the frame only once. The pointer stays valid
+   * until the state, the world or the fixed transforms are changed */
+  const Eigen::Affine3d* findFrameTransform(const robot_state::RobotState& state, const std::string& id) const;
+
   /**@}*/
 
   /**
@@ -400,10 +411,25 @@ public:
   }
 
   /** \brief Check whether a specified state (\e kstate) is in collision. The collision transforms of \e kstate are
-   * expected to be up to date. */
+   * expected to be up to date. If a collision cache is set (setCollisionCache()), the result may come from it. */
   void checkCollision(const collision_detection::CollisionRequest& req, collision_detection::CollisionResult& res,
                       const robot_state::RobotState& kstate) const;
 
+  /** \brief Cache the results of up to \e max_entries calls to checkCollision() for the allowed collision matrix of
+   * the scene, so that states checked repeatedly (by planning request adapters, the planner, path simplification and
+   * isPathValid()) are only checked once. States are looked up by their variable values rounded to \e resolution,
+   * together with the versions of the world, octomap, allowed collision matrix and padding (see getWorldVersion()),
+   * so any change to the scene makes the entries for the previous versions unreachable. Only requests that ask for
+   * nothing but the collision flag are cached, and states with attached bodies are always checked. The cache is
+   * shared with diff scenes created afterwards. A \e max_entries of 0 (the default) disables the cache. */
+  void setCollisionCache(std::size_t max_entries, double resolution = 1e-6);
+
+  /** \brief Get the maximum number of cached collision results (0 if there is no cache; see setCollisionCache()) */
+  std::size_t getCollisionCacheSize() const;
+
+  /** \brief Get the resolution joint values are rounded to when looking up cached collision results */
+  double getCollisionCacheResolution() const;
+
   /** \brief Check whether a specified state (\e kstate) is in collision, with respect to a given
       allowed collision matrix (\e acm). This variant of the function takes
       a non-const \e kstate and updates its link transforms if needed. */
@@ -420,6 +446,25 @@ public:
                       const robot_state::RobotState& kstate,
                       const collision_detection::AllowedCollisionMatrix& acm) const;
 
+  /** \brief Check a batch of states for collision, as checkCollision() does for each of them, using up to
+   * \e thread_count threads (0 means one per core). The collision transforms of the states are expected to be up to
+   * date. \e res is resized to the number of states and res[i] is the result for states[i]. If
+   * \e stop_at_first_collision is true, the states after the first one found in collision may be left unchecked
+   * (with cleared results). Returns the index of the first state in collision, or states.size() if there is none. */
+  std::size_t checkCollisionBatch(const collision_detection::CollisionRequest& req,
+                                  std::vector<collision_detection::CollisionResult>& res,
+                                  const std::vector<const robot_state::RobotState*>& states,
+                                  unsigned int thread_count = 0, bool stop_at_first_collision = true) const;
+
+  /** \brief Check a batch of states for collision with respect to a given allowed collision matrix (\e acm), as
+   * checkCollision() does for each of them. The other arguments and the return value are as for the
+   * checkCollisionBatch() that uses the scene's allowed collision matrix. */
+  std::size_t checkCollisionBatch(const collision_detection::CollisionRequest& req,
+                                  std::vector<collision_detection::CollisionResult>& res,
+                                  const std::vector<const robot_state::RobotState*>& states,
+                                  const collision_detection::AllowedCollisionMatrix& acm,
+                                  unsigned int thread_count = 0, bool stop_at_first_collision = true) const;
+
   /** \brief Check whether the current state is in collision,
       but use a collision_detection::CollisionRobot instance that has no padding.
       Since the function is non-const, the current state transforms are also updated if needed. */
@@ -674,6 +719,16 @@ public:
   /** \brief Load the geometry of the planning scene from a stream at a certain location using offset*/
   void loadGeometryFromStream(std::istream& in, const Eigen::Affine3d& offset);
 
+  /** \brief Save the geometry of the planning scene to a stream, in the binary format read by
+      loadGeometryFromBinaryStream(). The stream should be opened in binary mode. */
+  void saveGeometryToBinaryStream(std::ostream& out) const;
+
+  /** \brief Load the geometry saved by saveGeometryToBinaryStream(), moved by \e offset. The objects are decoded by
+      \e thread_count threads (0 means one per core). Returns false, and leaves the scene unchanged, if the stream does
+      not hold valid binary geometry. */
+  bool loadGeometryFromBinaryStream(std::istream& in, const Eigen::Affine3d& offset = Eigen::Affine3d::Identity(),
+                                    unsigned int thread_count = 0);
+
   /** \brief Fill the message \e scene with the differences between this instance of PlanningScene with respect to the
      parent.
       If there is no parent, everything is considered to be a diff and the function behaves like getPlanningSceneMsg()
@@ -713,6 +768,67 @@ public:
   void processOctomapMsg(const octomap_msgs::Octomap& map);
   void processOctomapPtr(const std::shared_ptr<const octomap::OcTree>& octree, const Eigen::Affine3d& t);
 
+  /** \brief Apply an incremental octomap update. The message has the id OCTOMAP_DIFF_ID and contains the leaves of
+   * the octree that changed, with their new values. header.seq is the version of the octomap the update produces; it
+   * only applies to the version before it. Returns false if it does not apply (see canApplyOctomapDiff()), in which
+   * case the full octomap should be requested again. */
+  bool processOctomapDiffMsg(const octomap_msgs::OctomapWithPose& map);
+
+  /** \brief Check if the incremental octomap update \e map applies to the octomap of this scene */
+  bool canApplyOctomapDiff(const octomap_msgs::OctomapWithPose& map) const;
+
+  /** \brief Get the version of the octomap, as received in the header.seq field of octomap messages. 0 if the
+   * octomap is not versioned. This number is also reported in the octomap messages produced by this scene. */
+  unsigned int getOctomapSequenceNumber() const
+  {
+    return octomap_seq_;
+  }
+
+  /** \brief Set the version of the octomap (see getOctomapSequenceNumber()) */
+  void setOctomapSequenceNumber(unsigned int seq)
+  {
+    octomap_seq_ = seq;
+  }
+
+  /** \brief Get the version of the world geometry (collision objects other than the octomap).
+   *
+   * Versions are issued from a single counter shared by all planning scenes, so they only ever increase and two
+   * scenes report the same version for a component only if one inherited it from the other (e.g. through diff()).
+   * Data derived from a component (distance fields, compiled matrices, broadphase structures) can be reused for as
+   * long as the corresponding version does not change. Components a diff scene does not maintain itself report the
+   * version of the parent. */
+  uint64_t getWorldVersion() const
+  {
+    return world_version_;
+  }
+
+  /** \brief Get the version of the octomap contents and pose (see getWorldVersion()) */
+  uint64_t getOctomapVersion() const
+  {
+    return octomap_version_;
+  }
+
+  /** \brief Get the version of the allowed collision matrix (see getWorldVersion()). Any call to
+   * getAllowedCollisionMatrixNonConst() counts as a change. */
+  uint64_t getAllowedCollisionMatrixVersion() const
+  {
+    return acm_ || !parent_ ? acm_version_ : parent_->getAllowedCollisionMatrixVersion();
+  }
+
+  /** \brief Get the version of the padding and scaling of the active collision robot (see getWorldVersion()). Any
+   * call to getCollisionRobotNonConst() and any change of the active collision detector counts as a change. */
+  uint64_t getRobotPaddingVersion() const
+  {
+    return active_collision_->crobot_ || !parent_ ? padding_version_ : parent_->getRobotPaddingVersion();
+  }
+
+  /** \brief Get the version of the bodies attached to the current state (see getWorldVersion()). Bodies attached
+   * or detached through the current state and calls to setCurrentState() are tracked. */
+  uint64_t getAttachedBodiesVersion() const
+  {
+    return kstate_ || !parent_ ? attached_bodies_version_ : parent_->getAttachedBodiesVersion();
+  }
+
   /**
    * \brief Clear all collision objects in planning scene
    */
@@ -834,6 +950,23 @@ public:
   bool isStateValid(const robot_state::RobotState& state, const kinematic_constraints::KinematicConstraintSet& constr,
                     const std::string& group = "", bool verbose = false) const;
 
+  /** \brief Set the number of threads the waypoints of a path are checked with by isPathValid() (0 means one per
+   * core; the default, 1, checks the path serially). With more than one thread, waypoints are checked in
+   * coarse-to-fine order (the end points, then the middle, then the middles of the halves, ...), so that an invalid
+   * section is typically found after checking a few states. When no \e invalid_index is requested, checking stops
+   * at the first invalid waypoint found. Any feasibility predicate (setStateFeasibilityPredicate()) must be safe to
+   * call from multiple threads. */
+  void setPathValidityThreadCount(unsigned int thread_count)
+  {
+    path_validity_thread_count_ = thread_count;
+  }
+
+  /** \brief Get the number of threads used to check paths (see setPathValidityThreadCount()) */
+  unsigned int getPathValidityThreadCount() const
+  {
+    return path_validity_thread_count_;
+  }
+
   /** \brief Check if a given path is valid. Each state is checked for validity (collision avoidance and feasibility) */
   bool isPathValid(const moveit_msgs::RobotState& start_state, const moveit_msgs::RobotTrajectory& trajectory,
                    const std::string& group = "", bool verbose = false,
@@ -977,6 +1110,35 @@ private:
   void allocateCollisionDetectors();
   void allocateCollisionDetectors(CollisionDetector& detector);
 
+  /* update the world and octomap versions when world_ changes */
+  void addWorldVersionObserver();
+  void updateWorldVersion(const collision_detection::World::ObjectConstPtr& obj,
+                          collision_detection::World::Action action);
+
+  /* check states[k] for checkCollisionBatch(), storing the result in res[k]; returns whether it is in collision.
+     If acm is NULL, the scene's allowed collision matrix is used */
+  bool checkBatchState(const collision_detection::CollisionRequest& req,
+                       std::vector<collision_detection::CollisionResult>* res,
+                       const std::vector<const robot_state::RobotState*>& states,
+                       const collision_detection::AllowedCollisionMatrix* acm, std::size_t k) const;
+
+  /* check waypoint order[k] of a path for isPathValid(), given which waypoints violate the path constraints;
+     records and returns whether the waypoint is invalid */
+  bool checkPathWayPoint(const robot_trajectory::RobotTrajectory& trajectory,
+                         const std::vector<char>& violates_constraints, const std::vector<std::size_t>& order,
+                         const std::string& group, bool verbose, std::vector<char>* invalid, std::size_t k) const;
+
+  /* the attached body callback installed on kstate_: updates the attached bodies version and calls
+   * current_state_attached_body_callback_ */
+  void attachedBodyUpdated(robot_state::AttachedBody* body, bool attached);
+
+  /* a bounded least-recently-used map from quantized states (and scene versions) to collision results */
+  class CollisionCache;
+
+  /* look up or compute the collision result for checkCollision(); returns false if the query cannot be cached */
+  bool checkCollisionCached(const collision_detection::CollisionRequest& req, collision_detection::CollisionResult& res,
+                            const robot_state::RobotState& kstate) const;
+
   std::string name_;  // may be empty
 
   PlanningSceneConstPtr parent_;  // Null unless this is a diff scene
@@ -1007,6 +1169,24 @@ private:
 
   // a map of object types
   std::unique_ptr<ObjectTypeMap> object_types_;
+
+  // the version of the octomap, for incremental octomap updates
+  unsigned int octomap_seq_;
+
+  // versions of the scene components (see getWorldVersion()); the last three are only used when the component is
+  // maintained by this scene rather than the parent
+  uint64_t world_version_;
+  uint64_t octomap_version_;
+  uint64_t acm_version_;
+  uint64_t padding_version_;
+  uint64_t attached_bodies_version_;
+  collision_detection::World::ObserverHandle world_version_observer_handle_;
+
+  // number of threads used by isPathValid()
+  unsigned int path_validity_thread_count_;
+
+  // results of checkCollision(); may be shared with the parent and with diffs; NULL unless enabled
+  std::shared_ptr<CollisionCache> collision_cache_;
 };
 }
 
@@ -37,6 +37,7 @@
 #include <boost/algorithm/string.hpp>
 #include <moveit/planning_scene/planning_scene.h>
 #include <moveit/collision_detection_fcl/collision_detector_allocator_fcl.h>
+#include <moveit/collision_detection_fcl/collision_common.h>
 #include <geometric_shapes/shape_operations.h>
 #include <moveit/collision_detection/collision_tools.h>
 #include <moveit/trajectory_processing/trajectory_tools.h>
@@ -44,13 +45,321 @@
 #include <moveit/exceptions/exceptions.h>
 #include <octomap_msgs/conversions.h>
 #include <eigen_conversions/eigen_msg.h>
+#include <ros/serialization.h>
+#include <boost/bind.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/thread/mutex.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <list>
+#include <map>
+#include <deque>
+#include <iterator>
 #include <memory>
 #include <set>
+#include <sstream>
 
 namespace planning_scene
 {
 const std::string PlanningScene::OCTOMAP_NS = "<octomap>";
 const std::string PlanningScene::DEFAULT_SCENE_NAME = "(noname)";
+const std::string PlanningScene::OCTOMAP_DIFF_ID = "OcTreeDiff";
+
+namespace
+{
+// versions of scene components are issued from one counter so they are unique across scenes
+std::atomic<uint64_t> last_component_version(0);
+
+uint64_t nextComponentVersion()
+{
+  return ++last_component_version;
+}
+
+// Meshes decoded from messages, indexed by a hash of their content. Scenes often contain many identical objects
+// (bins, pallets, fixtures); decoding their meshes to the same shape lets all instances share the vertex data, and
+// the FCL geometry cache then copies the bounding volume hierarchy built for the first instance instead of
+// constructing it again for every other one
+struct MeshMsgCache
+{
+  MeshMsgCache() : insert_count_(0)
+  {
+  }
+
+  boost::mutex lock_;
+  std::multimap<std::size_t, std::weak_ptr<const shapes::Shape> > meshes_;
+  unsigned int insert_count_;
+};
+
+MeshMsgCache& getMeshMsgCache()
+{
+  static MeshMsgCache cache;
+  return cache;
+}
+
+std::size_t hashMeshMsg(const shape_msgs::Mesh& msg)
+{
+  std::size_t seed = 0;
+  for (std::size_t i = 0; i < msg.vertices.size(); ++i)
+  {
+    boost::hash_combine(seed, msg.vertices[i].x);
+    boost::hash_combine(seed, msg.vertices[i].y);
+    boost::hash_combine(seed, msg.vertices[i].z);
+  }
+  for (std::size_t i = 0; i < msg.triangles.size(); ++i)
+    boost::hash_range(seed, msg.triangles[i].vertex_indices.begin(), msg.triangles[i].vertex_indices.end());
+  return seed;
+}
+
+// meshes that do not compare equal are simply not shared, so this only needs to recognize exact copies
+bool meshMatchesMsg(const shapes::Shape& shape, const shape_msgs::Mesh& msg)
+{
+  if (shape.type != shapes::MESH)
+    return false;
+  const shapes::Mesh& mesh = static_cast<const shapes::Mesh&>(shape);
+  if (mesh.vertex_count != msg.vertices.size() || mesh.triangle_count != msg.triangles.size())
+    return false;
+  for (std::size_t i = 0; i < msg.vertices.size(); ++i)
+    if (mesh.vertices[3 * i] != msg.vertices[i].x || mesh.vertices[3 * i + 1] != msg.vertices[i].y ||
+        mesh.vertices[3 * i + 2] != msg.vertices[i].z)
+      return false;
+  for (std::size_t i = 0; i < msg.triangles.size(); ++i)
+    for (std::size_t j = 0; j < 3; ++j)
+      if (mesh.triangles[3 * i + j] != msg.triangles[i].vertex_indices[j])
+        return false;
+  return true;
+}
+
+// decode a mesh message, reusing the shape of an identical mesh that is still in use
+shapes::ShapeConstPtr constructMeshFromMsg(const shape_msgs::Mesh& msg)
+{
+  const std::size_t hash = hashMeshMsg(msg);
+  MeshMsgCache& cache = getMeshMsgCache();
+  {
+    boost::mutex::scoped_lock slock(cache.lock_);
+    typedef std::multimap<std::size_t, std::weak_ptr<const shapes::Shape> >::iterator Iterator;
+    std::pair<Iterator, Iterator> range = cache.meshes_.equal_range(hash);
+    for (Iterator it = range.first; it != range.second; ++it)
+    {
+      shapes::ShapeConstPtr shape = it->second.lock();
+      if (shape && meshMatchesMsg(*shape, msg))
+        return shape;
+    }
+  }
+
+  shapes::ShapeConstPtr shape(shapes::constructShapeFromMsg(msg));
+  if (!shape)
+    return shape;
+
+  boost::mutex::scoped_lock slock(cache.lock_);
+  cache.meshes_.insert(std::make_pair(hash, std::weak_ptr<const shapes::Shape>(shape)));
+
+  // drop the entries of meshes that are no longer used
+  if (++cache.insert_count_ > 100)
+  {
+    cache.insert_count_ = 0;
+    for (std::multimap<std::size_t, std::weak_ptr<const shapes::Shape> >::iterator it = cache.meshes_.begin();
+         it != cache.meshes_.end();)
+      if (it->second.expired())
+        cache.meshes_.erase(it++);
+      else
+        ++it;
+  }
+  return shape;
+}
+
+// order the indices [0, count) coarse to fine: first the end points, then the middle, then the middles of the
+// two halves and so on, so that the states checked first are spread over the whole path
+void computeBisectionOrder(std::size_t count, std::vector<std::size_t>& order)
+{
+  order.clear();
+  order.reserve(count);
+  if (count == 0)
+    return;
+  order.push_back(0);
+  if (count == 1)
+    return;
+  order.push_back(count - 1);
+
+  std::deque<std::pair<std::size_t, std::size_t> > intervals;
+  intervals.push_back(std::make_pair(0, count - 1));
+  while (!intervals.empty())
+  {
+    std::pair<std::size_t, std::size_t> interval = intervals.front();
+    intervals.pop_front();
+    if (interval.second - interval.first < 2)
+      continue;
+    std::size_t middle = (interval.first + interval.second) / 2;
+    order.push_back(middle);
+    intervals.push_back(std::make_pair(interval.first, middle));
+    intervals.push_back(std::make_pair(middle, interval.second));
+  }
+}
+
+// binary geometry format: magic, version, scene name and object count, then per object its id and the length of
+// the rest of its record (color, shape count and, per shape, its kind, pose and serialized message), so that the
+// records can be located first and decoded in parallel
+const char BINARY_GEOMETRY_MAGIC[] = "MOVEIT_SCENE_GEOMETRY";
+const uint32_t BINARY_GEOMETRY_VERSION = 1;
+
+template <typename T>
+void writeBinary(std::ostream& out, const T& value)
+{
+  out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void writeBinary(std::ostream& out, const std::string& value)
+{
+  writeBinary(out, static_cast<uint32_t>(value.size()));
+  out.write(value.data(), value.size());
+}
+
+class BinaryReader
+{
+public:
+  BinaryReader(const std::string& data, std::size_t offset = 0, std::size_t end = std::string::npos)
+    : data_(data), offset_(offset), end_(std::min(end, data.size()))
+  {
+  }
+
+  template <typename T>
+  bool read(T& value)
+  {
+    if (end_ - offset_ < sizeof(value))
+      return false;
+    memcpy(&value, &data_[offset_], sizeof(value));
+    offset_ += sizeof(value);
+    return true;
+  }
+
+  bool read(std::string& value)
+  {
+    uint32_t size;
+    if (!read(size) || end_ - offset_ < size)
+      return false;
+    value.assign(data_, offset_, size);
+    offset_ += size;
+    return true;
+  }
+
+  template <typename T>
+  bool readMessage(T& msg)
+  {
+    uint32_t size;
+    if (!read(size) || end_ - offset_ < size)
+      return false;
+    try
+    {
+      ros::serialization::IStream stream(reinterpret_cast<uint8_t*>(const_cast<char*>(&data_[offset_])), size);
+      ros::serialization::deserialize(stream, msg);
+    }
+    catch (ros::Exception& ex)
+    {
+      return false;
+    }
+    offset_ += size;
+    return true;
+  }
+
+  bool skip(std::size_t size)
+  {
+    if (end_ - offset_ < size)
+      return false;
+    offset_ += size;
+    return true;
+  }
+
+  std::size_t offset() const
+  {
+    return offset_;
+  }
+
+private:
+  const std::string& data_;
+  std::size_t offset_;
+  std::size_t end_;
+};
+
+class ShapeVisitorWriteBinary : public boost::static_visitor<void>
+{
+public:
+  ShapeVisitorWriteBinary(std::ostream& out) : out_(out)
+  {
+  }
+
+  template <typename T>
+  void operator()(const T& shape_msg) const
+  {
+    uint32_t size = ros::serialization::serializationLength(shape_msg);
+    std::vector<uint8_t> buffer(size);
+    ros::serialization::OStream stream(buffer.data(), size);
+    ros::serialization::serialize(stream, shape_msg);
+    writeBinary(out_, size);
+    out_.write(reinterpret_cast<const char*>(buffer.data()), size);
+  }
+
+private:
+  std::ostream& out_;
+};
+
+// an object of the binary format, located in the data before it is decoded
+struct BinaryGeometryObject
+{
+  std::string id;
+  std::size_t offset;
+  std::size_t length;
+  std::vector<shapes::ShapeConstPtr> shapes;
+  EigenSTL::vector_Affine3d poses;
+  std_msgs::ColorRGBA color;
+};
+
+// decode the shapes of object k; returns true on failure, as processCollisionBatch() stops at the first true
+bool decodeBinaryGeometryObject(const std::string& data, std::vector<BinaryGeometryObject>* objects, std::size_t k)
+{
+  BinaryGeometryObject& obj = (*objects)[k];
+  BinaryReader reader(data, obj.offset, obj.offset + obj.length);
+  uint32_t shape_count;
+  if (!reader.read(obj.color.r) || !reader.read(obj.color.g) || !reader.read(obj.color.b) ||
+      !reader.read(obj.color.a) || !reader.read(shape_count) || shape_count > obj.length)
+    return true;
+  for (uint32_t i = 0; i < shape_count; ++i)
+  {
+    uint8_t kind;
+    double pose[7];
+    if (!reader.read(kind) || !reader.read(pose))
+      return true;
+    shapes::ShapeConstPtr s;
+    if (kind == 0)
+    {
+      shape_msgs::SolidPrimitive msg;
+      if (!reader.readMessage(msg))
+        return true;
+      s.reset(shapes::constructShapeFromMsg(msg));
+    }
+    else if (kind == 1)
+    {
+      shape_msgs::Mesh msg;
+      if (!reader.readMessage(msg))
+        return true;
+      s = constructMeshFromMsg(msg);
+    }
+    else if (kind == 2)
+    {
+      shape_msgs::Plane msg;
+      if (!reader.readMessage(msg))
+        return true;
+      s.reset(shapes::constructShapeFromMsg(msg));
+    }
+    if (!s)
+      return true;
+    obj.shapes.push_back(s);
+    obj.poses.push_back(Eigen::Translation3d(pose[0], pose[1], pose[2]) *
+                        Eigen::Quaterniond(pose[6], pose[3], pose[4], pose[5]));
+  }
+  return false;
+}
+}
 
 class SceneTransforms : public robot_state::Transforms
 {
@@ -94,6 +403,90 @@ private:
 
   const PlanningScene* scene_;
 };
+
+class PlanningScene::CollisionCache
+{
+public:
+  // the group name, the scene component versions and the quantized variable values a result is stored for
+  struct Key
+  {
+    std::string group_;
+    std::vector<int64_t> values_;
+
+    bool operator<(const Key& other) const
+    {
+      return values_ < other.values_ || (values_ == other.values_ && group_ < other.group_);
+    }
+  };
+
+  CollisionCache(std::size_t max_entries, double resolution) : max_entries_(max_entries), resolution_(resolution)
+  {
+  }
+
+  std::size_t getMaxEntries() const
+  {
+    return max_entries_;
+  }
+
+  double getResolution() const
+  {
+    return resolution_;
+  }
+
+  void makeKey(const PlanningScene& scene, const std::string& group, const robot_state::RobotState& state,
+               Key& key) const
+  {
+    key.group_ = group;
+    key.values_.clear();
+    key.values_.reserve(4 + state.getVariableCount());
+    key.values_.push_back(scene.getWorldVersion());
+    key.values_.push_back(scene.getOctomapVersion());
+    key.values_.push_back(scene.getAllowedCollisionMatrixVersion());
+    key.values_.push_back(scene.getRobotPaddingVersion());
+    const double* positions = state.getVariablePositions();
+    for (std::size_t i = 0; i < state.getVariableCount(); ++i)
+      key.values_.push_back(static_cast<int64_t>(std::floor(positions[i] / resolution_ + 0.5)));
+  }
+
+  bool lookup(const Key& key, bool& collision)
+  {
+    boost::mutex::scoped_lock slock(lock_);
+    std::map<Key, EntryList::iterator>::iterator it = index_.find(key);
+    if (it == index_.end())
+      return false;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    collision = it->second->second;
+    return true;
+  }
+
+  void insert(const Key& key, bool collision)
+  {
+    boost::mutex::scoped_lock slock(lock_);
+    std::map<Key, EntryList::iterator>::iterator it = index_.find(key);
+    if (it != index_.end())
+    {
+      // another thread checked the same state in the meantime
+      entries_.splice(entries_.begin(), entries_, it->second);
+      return;
+    }
+    entries_.push_front(std::make_pair(key, collision));
+    index_[key] = entries_.begin();
+    if (entries_.size() > max_entries_)
+    {
+      index_.erase(entries_.back().first);
+      entries_.pop_back();
+    }
+  }
+
+private:
+  typedef std::list<std::pair<Key, bool> > EntryList;
+
+  std::size_t max_entries_;
+  double resolution_;
+  EntryList entries_;  // most recently used first
+  std::map<Key, EntryList::iterator> index_;
+  boost::mutex lock_;
+};
 }
 
 bool planning_scene::PlanningScene::isEmpty(const moveit_msgs::PlanningScene& msg)
@@ -148,16 +541,26 @@ planning_scene::PlanningScene::~PlanningScene()
 {
   if (current_world_object_update_callback_)
     world_->removeObserver(current_world_object_update_observer_handle_);
+  world_->removeObserver(world_version_observer_handle_);
 }
 
 void planning_scene::PlanningScene::initialize()
 {
   name_ = DEFAULT_SCENE_NAME;
+  octomap_seq_ = 0;
+  world_version_ = nextComponentVersion();
+  octomap_version_ = nextComponentVersion();
+  acm_version_ = nextComponentVersion();
+  padding_version_ = nextComponentVersion();
+  attached_bodies_version_ = nextComponentVersion();
+  addWorldVersionObserver();
+  path_validity_thread_count_ = 1;
 
   ftf_.reset(new SceneTransforms(this));
 
   kstate_.reset(new robot_state::RobotState(kmodel_));
   kstate_->setToDefaultValues();
+  kstate_->setAttachedBodyUpdateCallback(boost::bind(&PlanningScene::attachedBodyUpdated, this, _1, _2));
 
   acm_.reset(new collision_detection::AllowedCollisionMatrix());
   // Use default collision operations in the SRDF to setup the acm
@@ -192,11 +595,20 @@ planning_scene::PlanningScene::PlanningScene(const PlanningSceneConstPtr& parent
     name_ = parent_->getName() + "+";
 
   kmodel_ = parent_->kmodel_;
+  octomap_seq_ = parent_->octomap_seq_;
 
   // maintain a separate world.  Copy on write ensures that most of the object
   // info is shared until it is modified.
   world_.reset(new collision_detection::World(*parent_->world_));
   world_const_ = world_;
+  world_version_ = parent_->world_version_;
+  octomap_version_ = parent_->octomap_version_;
+  acm_version_ = 0;
+  padding_version_ = 0;
+  attached_bodies_version_ = 0;
+  addWorldVersionObserver();
+  path_validity_thread_count_ = parent_->path_validity_thread_count_;
+  collision_cache_ = parent_->collision_cache_;
 
   // record changes to the world
   world_diff_.reset(new collision_detection::WorldDiff(world_));
@@ -336,6 +748,7 @@ void planning_scene::PlanningScene::setActiveCollisionDetector(
     {
       collision_[allocator->getName()] = p;
       active_collision_ = p;
+      padding_version_ = nextComponentVersion();
       return;
     }
   }
@@ -349,6 +762,8 @@ bool planning_scene::PlanningScene::setActiveCollisionDetector(const std::string
   CollisionDetectorIterator it = collision_.find(collision_detector_name);
   if (it != collision_.end())
   {
+    if (active_collision_ != it->second)
+      padding_version_ = nextComponentVersion();
     active_collision_ = it->second;
     return true;
   }
@@ -417,8 +832,12 @@ void planning_scene::PlanningScene::clearDiffs()
     return;
 
   // clear everything, reset the world, record diffs
+  world_->removeObserver(world_version_observer_handle_);
   world_.reset(new collision_detection::World(*parent_->world_));
   world_const_ = world_;
+  world_version_ = parent_->world_version_;
+  octomap_version_ = parent_->octomap_version_;
+  addWorldVersionObserver();
   world_diff_.reset(new collision_detection::WorldDiff(world_));
   if (current_world_object_update_callback_)
     current_world_object_update_observer_handle_ = world_->addObserver(current_world_object_update_callback_);
@@ -527,6 +946,9 @@ void planning_scene::PlanningScene::checkCollision(const collision_detection::Co
                                                    collision_detection::CollisionResult& res,
                                                    const robot_state::RobotState& kstate) const
 {
+  if (collision_cache_ && checkCollisionCached(req, res, kstate))
+    return;
+
   // check collision with the world using the padded version
   getCollisionWorld()->checkRobotCollision(req, res, *getCollisionRobot(), kstate, getAllowedCollisionMatrix());
 
@@ -537,6 +959,49 @@ void planning_scene::PlanningScene::checkCollision(const collision_detection::Co
   }
 }
 
+bool planning_scene::PlanningScene::checkCollisionCached(const collision_detection::CollisionRequest& req,
+                                                         collision_detection::CollisionResult& res,
+                                                         const robot_state::RobotState& kstate) const
+{
+  // only the collision flag is cached, and attached bodies are a property of the state the key does not capture
+  if (req.distance || req.cost || req.contacts || req.verbose || req.is_done || res.collision ||
+      kstate.getRobotModel() != kmodel_ || kstate.hasAttachedBodies())
+    return false;
+
+  CollisionCache::Key key;
+  collision_cache_->makeKey(*this, req.group_name, kstate, key);
+  bool collision;
+  if (!collision_cache_->lookup(key, collision))
+  {
+    getCollisionWorld()->checkRobotCollision(req, res, *getCollisionRobot(), kstate, getAllowedCollisionMatrix());
+    if (!res.collision)
+      getCollisionRobotUnpadded()->checkSelfCollision(req, res, kstate, getAllowedCollisionMatrix());
+    collision_cache_->insert(key, res.collision);
+    return true;
+  }
+
+  res.collision = collision;
+  return true;
+}
+
+void planning_scene::PlanningScene::setCollisionCache(std::size_t max_entries, double resolution)
+{
+  if (max_entries == 0 || resolution <= 0.0)
+    collision_cache_.reset();
+  else
+    collision_cache_.reset(new CollisionCache(max_entries, resolution));
+}
+
+std::size_t planning_scene::PlanningScene::getCollisionCacheSize() const
+{
+  return collision_cache_ ? collision_cache_->getMaxEntries() : 0;
+}
+
+double planning_scene::PlanningScene::getCollisionCacheResolution() const
+{
+  return collision_cache_ ? collision_cache_->getResolution() : 0.0;
+}
+
 void planning_scene::PlanningScene::checkSelfCollision(const collision_detection::CollisionRequest& req,
                                                        collision_detection::CollisionResult& res)
 {
@@ -559,6 +1024,46 @@ void planning_scene::PlanningScene::checkCollision(const collision_detection::Co
     getCollisionRobotUnpadded()->checkSelfCollision(req, res, kstate, acm);
 }
 
+std::size_t planning_scene::PlanningScene::checkCollisionBatch(
+    const collision_detection::CollisionRequest& req, std::vector<collision_detection::CollisionResult>& res,
+    const std::vector<const robot_state::RobotState*>& states, unsigned int thread_count,
+    bool stop_at_first_collision) const
+{
+  res.resize(states.size());
+  for (std::size_t i = 0; i < res.size(); ++i)
+    res[i].clear();
+  return collision_detection::processCollisionBatch(
+      states.size(), thread_count, stop_at_first_collision,
+      boost::bind(&PlanningScene::checkBatchState, this, boost::cref(req), &res, boost::cref(states),
+                  static_cast<const collision_detection::AllowedCollisionMatrix*>(NULL), _1));
+}
+
+std::size_t planning_scene::PlanningScene::checkCollisionBatch(
+    const collision_detection::CollisionRequest& req, std::vector<collision_detection::CollisionResult>& res,
+    const std::vector<const robot_state::RobotState*>& states, const collision_detection::AllowedCollisionMatrix& acm,
+    unsigned int thread_count, bool stop_at_first_collision) const
+{
+  res.resize(states.size());
+  for (std::size_t i = 0; i < res.size(); ++i)
+    res[i].clear();
+  return collision_detection::processCollisionBatch(
+      states.size(), thread_count, stop_at_first_collision,
+      boost::bind(&PlanningScene::checkBatchState, this, boost::cref(req), &res, boost::cref(states), &acm, _1));
+}
+
+bool planning_scene::PlanningScene::checkBatchState(const collision_detection::CollisionRequest& req,
+                                                    std::vector<collision_detection::CollisionResult>* res,
+                                                    const std::vector<const robot_state::RobotState*>& states,
+                                                    const collision_detection::AllowedCollisionMatrix* acm,
+                                                    std::size_t k) const
+{
+  if (acm)
+    checkCollision(req, (*res)[k], *states[k], *acm);
+  else
+    checkCollision(req, (*res)[k], *states[k]);
+  return (*res)[k].collision;
+}
+
 void planning_scene::PlanningScene::checkCollisionUnpadded(const collision_detection::CollisionRequest& req,
                                                            collision_detection::CollisionResult& res)
 {
@@ -638,6 +1143,7 @@ const collision_detection::CollisionRobotPtr& planning_scene::PlanningScene::get
         active_collision_->alloc_->allocateRobot(active_collision_->parent_->getCollisionRobot());
     active_collision_->crobot_const_ = active_collision_->crobot_;
   }
+  padding_version_ = nextComponentVersion();
   return active_collision_->crobot_;
 }
 
@@ -646,7 +1152,8 @@ robot_state::RobotState& planning_scene::PlanningScene::getCurrentStateNonConst(
   if (!kstate_)
   {
     kstate_.reset(new robot_state::RobotState(parent_->getCurrentState()));
-    kstate_->setAttachedBodyUpdateCallback(current_state_attached_body_callback_);
+    kstate_->setAttachedBodyUpdateCallback(boost::bind(&PlanningScene::attachedBodyUpdated, this, _1, _2));
+    attached_bodies_version_ = parent_->getAttachedBodiesVersion();
   }
   kstate_->update();
   return *kstate_;
@@ -663,8 +1170,28 @@ planning_scene::PlanningScene::getCurrentStateUpdated(const moveit_msgs::RobotSt
 void planning_scene::PlanningScene::setAttachedBodyUpdateCallback(const robot_state::AttachedBodyCallback& callback)
 {
   current_state_attached_body_callback_ = callback;
-  if (kstate_)
-    kstate_->setAttachedBodyUpdateCallback(callback);
+}
+
+void planning_scene::PlanningScene::attachedBodyUpdated(robot_state::AttachedBody* body, bool attached)
+{
+  attached_bodies_version_ = nextComponentVersion();
+  if (current_state_attached_body_callback_)
+    current_state_attached_body_callback_(body, attached);
+}
+
+void planning_scene::PlanningScene::addWorldVersionObserver()
+{
+  world_version_observer_handle_ =
+      world_->addObserver(boost::bind(&PlanningScene::updateWorldVersion, this, _1, _2));
+}
+
+void planning_scene::PlanningScene::updateWorldVersion(const collision_detection::World::ObjectConstPtr& obj,
+                                                       collision_detection::World::Action action)
+{
+  if (obj->id_ == OCTOMAP_NS)
+    octomap_version_ = nextComponentVersion();
+  else
+    world_version_ = nextComponentVersion();
 }
 
 void planning_scene::PlanningScene::setCollisionObjectUpdateCallback(
@@ -681,6 +1208,7 @@ collision_detection::AllowedCollisionMatrix& planning_scene::PlanningScene::getA
 {
   if (!acm_)
     acm_.reset(new collision_detection::AllowedCollisionMatrix(parent_->getAllowedCollisionMatrix()));
+  acm_version_ = nextComponentVersion();
   return *acm_;
 }
 
@@ -856,6 +1384,7 @@ void planning_scene::PlanningScene::getPlanningSceneMsgCollisionObjects(moveit_m
 void planning_scene::PlanningScene::getPlanningSceneMsgOctomap(moveit_msgs::PlanningScene& scene_msg) const
 {
   scene_msg.world.octomap.header.frame_id = getPlanningFrame();
+  scene_msg.world.octomap.header.seq = octomap_seq_;
   scene_msg.world.octomap.octomap = octomap_msgs::Octomap();
 
   collision_detection::CollisionWorld::ObjectConstPtr map = world_->getObject(OCTOMAP_NS);
@@ -1033,6 +1562,11 @@ void planning_scene::PlanningScene::loadGeometryFromStream(std::istream& in, con
       boost::algorithm::trim(ns);
       unsigned int shape_count;
       in >> shape_count;
+      // the shapes are added together, so the collision world updates the object once
+      std::vector<shapes::ShapeConstPtr> shapes;
+      EigenSTL::vector_Affine3d poses;
+      std_msgs::ColorRGBA color;
+      bool has_color = false;
       for (std::size_t i = 0; i < shape_count && in.good() && !in.eof(); ++i)
       {
         shapes::Shape* s = shapes::constructShapeFromText(in);
@@ -1046,24 +1580,141 @@ void planning_scene::PlanningScene::loadGeometryFromStream(std::istream& in, con
           Eigen::Affine3d pose = Eigen::Translation3d(x, y, z) * Eigen::Quaterniond(rw, rx, ry, rz);
           // Transform pose by input pose offset
           pose = offset * pose;
-          world_->addToObject(ns, shapes::ShapePtr(s), pose);
+          shapes.push_back(shapes::ShapeConstPtr(s));
+          poses.push_back(pose);
           if (r > 0.0f || g > 0.0f || b > 0.0f || a > 0.0f)
           {
-            std_msgs::ColorRGBA color;
             color.r = r;
             color.g = g;
             color.b = b;
             color.a = a;
-            setObjectColor(ns, color);
+            has_color = true;
           }
         }
       }
+      world_->addToObject(ns, shapes, poses);
+      if (has_color)
+        setObjectColor(ns, color);
     }
     else
       break;
   } while (true);
 }
 
+void planning_scene::PlanningScene::saveGeometryToBinaryStream(std::ostream& out) const
+{
+  std::vector<collision_detection::CollisionWorld::ObjectConstPtr> objects;
+  const std::vector<std::string>& ns = world_->getObjectIds();
+  for (std::size_t i = 0; i < ns.size(); ++i)
+    if (ns[i] != OCTOMAP_NS)
+    {
+      collision_detection::CollisionWorld::ObjectConstPtr obj = world_->getObject(ns[i]);
+      if (obj)
+        objects.push_back(obj);
+    }
+
+  out.write(BINARY_GEOMETRY_MAGIC, sizeof(BINARY_GEOMETRY_MAGIC) - 1);
+  writeBinary(out, BINARY_GEOMETRY_VERSION);
+  writeBinary(out, name_);
+  writeBinary(out, static_cast<uint32_t>(objects.size()));
+
+  std::ostringstream record;
+  for (std::size_t i = 0; i < objects.size(); ++i)
+  {
+    const collision_detection::CollisionWorld::Object& obj = *objects[i];
+    std::vector<shapes::ShapeMsg> msgs;
+    std::vector<std::size_t> shape_index;
+    for (std::size_t j = 0; j < obj.shapes_.size(); ++j)
+    {
+      shapes::ShapeMsg sm;
+      if (constructMsgFromShape(obj.shapes_[j].get(), sm))
+      {
+        msgs.push_back(sm);
+        shape_index.push_back(j);
+      }
+    }
+
+    record.str("");
+    std_msgs::ColorRGBA color;
+    if (hasObjectColor(obj.id_))
+      color = getObjectColor(obj.id_);
+    writeBinary(record, color.r);
+    writeBinary(record, color.g);
+    writeBinary(record, color.b);
+    writeBinary(record, color.a);
+    writeBinary(record, static_cast<uint32_t>(msgs.size()));
+    for (std::size_t j = 0; j < msgs.size(); ++j)
+    {
+      const Eigen::Affine3d& p = obj.shape_poses_[shape_index[j]];
+      Eigen::Quaterniond q(p.rotation());
+      double pose[7] = { p.translation().x(), p.translation().y(), p.translation().z(), q.x(), q.y(), q.z(), q.w() };
+      writeBinary(record, static_cast<uint8_t>(msgs[j].which()));
+      writeBinary(record, pose);
+      boost::apply_visitor(ShapeVisitorWriteBinary(record), msgs[j]);
+    }
+
+    const std::string& data = record.str();
+    writeBinary(out, obj.id_);
+    writeBinary(out, data);
+  }
+}
+
+bool planning_scene::PlanningScene::loadGeometryFromBinaryStream(std::istream& in, const Eigen::Affine3d& offset,
+                                                                  unsigned int thread_count)
+{
+  std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  BinaryReader reader(data);
+
+  char magic[sizeof(BINARY_GEOMETRY_MAGIC) - 1];
+  uint32_t version, count;
+  std::string name;
+  if (!reader.read(magic) || memcmp(magic, BINARY_GEOMETRY_MAGIC, sizeof(magic)) != 0 || !reader.read(version) ||
+      version != BINARY_GEOMETRY_VERSION || !reader.read(name) || !reader.read(count) || count > data.size())
+  {
+    logError("The stream does not contain binary planning scene geometry");
+    return false;
+  }
+
+  // locate the objects, then decode them in parallel
+  std::vector<BinaryGeometryObject> objects(count);
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    uint32_t length;
+    if (!reader.read(objects[i].id) || !reader.read(length))
+    {
+      logError("Binary planning scene geometry is truncated");
+      return false;
+    }
+    objects[i].offset = reader.offset();
+    objects[i].length = length;
+    if (!reader.skip(length))
+    {
+      logError("Binary planning scene geometry is truncated");
+      return false;
+    }
+  }
+
+  std::size_t failed = collision_detection::processCollisionBatch(
+      count, thread_count, true, boost::bind(&decodeBinaryGeometryObject, boost::cref(data), &objects, _1));
+  if (failed < count)
+  {
+    logError("Unable to decode object '%s' of binary planning scene geometry", objects[failed].id.c_str());
+    return false;
+  }
+
+  name_ = name;
+  for (std::size_t i = 0; i < objects.size(); ++i)
+  {
+    for (std::size_t j = 0; j < objects[i].poses.size(); ++j)
+      objects[i].poses[j] = offset * objects[i].poses[j];
+    world_->addToObject(objects[i].id, objects[i].shapes, objects[i].poses);
+    const std_msgs::ColorRGBA& c = objects[i].color;
+    if (c.r > 0.0f || c.g > 0.0f || c.b > 0.0f || c.a > 0.0f)
+      setObjectColor(objects[i].id, c);
+  }
+  return true;
+}
+
 void planning_scene::PlanningScene::setCurrentState(const moveit_msgs::RobotState& state)
 {
   // The attached bodies will be processed separately by processAttachedCollisionObjectMsgs
@@ -1076,7 +1727,8 @@ void planning_scene::PlanningScene::setCurrentState(const moveit_msgs::RobotStat
     if (!kstate_)
     {
       kstate_.reset(new robot_state::RobotState(parent_->getCurrentState()));
-      kstate_->setAttachedBodyUpdateCallback(current_state_attached_body_callback_);
+      kstate_->setAttachedBodyUpdateCallback(boost::bind(&PlanningScene::attachedBodyUpdated, this, _1, _2));
+      attached_bodies_version_ = parent_->getAttachedBodiesVersion();
     }
     robot_state::robotStateMsgToRobotState(getTransforms(), state_no_attached, *kstate_);
   }
@@ -1098,7 +1750,14 @@ void planning_scene::PlanningScene::setCurrentState(const moveit_msgs::RobotStat
 
 void planning_scene::PlanningScene::setCurrentState(const robot_state::RobotState& state)
 {
-  getCurrentStateNonConst() = state;
+  // copying the state replaces the attached bodies without calling the attached body callback
+  robot_state::RobotState& current_state = getCurrentStateNonConst();
+  std::vector<const robot_state::AttachedBody*> previous_bodies, new_bodies;
+  current_state.getAttachedBodies(previous_bodies);
+  state.getAttachedBodies(new_bodies);
+  current_state = state;
+  if (!previous_bodies.empty() || !new_bodies.empty())
+    attached_bodies_version_ = nextComponentVersion();
 }
 
 void planning_scene::PlanningScene::decoupleParent()
@@ -1115,12 +1774,18 @@ void planning_scene::PlanningScene::decoupleParent()
   if (!kstate_)
   {
     kstate_.reset(new robot_state::RobotState(parent_->getCurrentState()));
-    kstate_->setAttachedBodyUpdateCallback(current_state_attached_body_callback_);
+    kstate_->setAttachedBodyUpdateCallback(boost::bind(&PlanningScene::attachedBodyUpdated, this, _1, _2));
+    attached_bodies_version_ = parent_->getAttachedBodiesVersion();
   }
 
   if (!acm_)
+  {
     acm_.reset(new collision_detection::AllowedCollisionMatrix(parent_->getAllowedCollisionMatrix()));
+    acm_version_ = parent_->getAllowedCollisionMatrixVersion();
+  }
 
+  if (!active_collision_->crobot_)
+    padding_version_ = parent_->getRobotPaddingVersion();
   for (CollisionDetectorIterator it = collision_.begin(); it != collision_.end(); ++it)
   {
     if (!it->second->crobot_)
@@ -1199,10 +1864,14 @@ bool planning_scene::PlanningScene::setPlanningSceneDiffMsg(const moveit_msgs::P
 
   // if at least some links are mentioned in the allowed collision matrix, then we have an update
   if (!scene_msg.allowed_collision_matrix.entry_names.empty())
+  {
     acm_.reset(new collision_detection::AllowedCollisionMatrix(scene_msg.allowed_collision_matrix));
+    acm_version_ = nextComponentVersion();
+  }
 
   if (!scene_msg.link_padding.empty() || !scene_msg.link_scale.empty())
   {
+    padding_version_ = nextComponentVersion();
     for (CollisionDetectorIterator it = collision_.begin(); it != collision_.end(); ++it)
     {
       if (!it->second->crobot_)
@@ -1219,13 +1888,19 @@ bool planning_scene::PlanningScene::setPlanningSceneDiffMsg(const moveit_msgs::P
   for (std::size_t i = 0; i < scene_msg.object_colors.size(); ++i)
     setObjectColor(scene_msg.object_colors[i].id, scene_msg.object_colors[i].color);
 
-  // process collision object updates
+  // process collision object updates; the observers of the world see them all at once
+  collision_detection::World::ScopedBatch batch(*world_);
   for (std::size_t i = 0; i < scene_msg.world.collision_objects.size(); ++i)
     result &= processCollisionObjectMsg(scene_msg.world.collision_objects[i]);
 
-  // if an octomap was specified, replace the one we have with that one
+  // if an octomap was specified, replace the one we have with that one, or apply the changes it contains
   if (!scene_msg.world.octomap.octomap.data.empty())
-    processOctomapMsg(scene_msg.world.octomap);
+  {
+    if (scene_msg.world.octomap.octomap.id == OCTOMAP_DIFF_ID)
+      result &= processOctomapDiffMsg(scene_msg.world.octomap);
+    else
+      processOctomapMsg(scene_msg.world.octomap);
+  }
 
   return result;
 }
@@ -1246,6 +1921,8 @@ bool planning_scene::PlanningScene::setPlanningSceneMsg(const moveit_msgs::Plann
   ftf_->setTransforms(scene_msg.fixed_frame_transforms);
   setCurrentState(scene_msg.robot_state);
   acm_.reset(new collision_detection::AllowedCollisionMatrix(scene_msg.allowed_collision_matrix));
+  acm_version_ = nextComponentVersion();
+  padding_version_ = nextComponentVersion();
   for (CollisionDetectorIterator it = collision_.begin(); it != collision_.end(); ++it)
   {
     if (!it->second->crobot_)
@@ -1259,6 +1936,7 @@ bool planning_scene::PlanningScene::setPlanningSceneMsg(const moveit_msgs::Plann
   object_colors_.reset(new ObjectColorMap());
   for (std::size_t i = 0; i < scene_msg.object_colors.size(); ++i)
     setObjectColor(scene_msg.object_colors[i].id, scene_msg.object_colors[i].color);
+  collision_detection::World::ScopedBatch batch(*world_);
   world_->clearObjects();
   return processPlanningSceneWorldMsg(scene_msg.world);
 }
@@ -1266,6 +1944,7 @@ bool planning_scene::PlanningScene::setPlanningSceneMsg(const moveit_msgs::Plann
 bool planning_scene::PlanningScene::processPlanningSceneWorldMsg(const moveit_msgs::PlanningSceneWorld& world)
 {
   bool result = true;
+  collision_detection::World::ScopedBatch batch(*world_);
   for (std::size_t i = 0; i < world.collision_objects.size(); ++i)
     result &= processCollisionObjectMsg(world.collision_objects[i]);
   processOctomapMsg(world.octomap);
@@ -1338,6 +2017,53 @@ void planning_scene::PlanningScene::processOctomapMsg(const octomap_msgs::Octoma
   tf::poseMsgToEigen(map.origin, p);
   p = t * p;
   world_->addToObject(OCTOMAP_NS, shapes::ShapeConstPtr(new shapes::OcTree(om)), p);
+  octomap_seq_ = map.header.seq;
+}
+
+bool planning_scene::PlanningScene::canApplyOctomapDiff(const octomap_msgs::OctomapWithPose& map) const
+{
+  if (octomap_seq_ == 0 || map.header.seq != octomap_seq_ + 1)
+    return false;
+  collision_detection::CollisionWorld::ObjectConstPtr obj = world_->getObject(OCTOMAP_NS);
+  if (!obj || obj->shapes_.size() != 1)
+    return false;
+  const shapes::OcTree* o = static_cast<const shapes::OcTree*>(obj->shapes_[0].get());
+  return fabs(o->octree->getResolution() - map.octomap.resolution) < std::numeric_limits<double>::epsilon();
+}
+
+bool planning_scene::PlanningScene::processOctomapDiffMsg(const octomap_msgs::OctomapWithPose& map)
+{
+  if (!canApplyOctomapDiff(map))
+  {
+    logWarn("Octomap update %u does not apply to octomap version %u. The full octomap is needed.", map.header.seq,
+            octomap_seq_);
+    return false;
+  }
+
+  // the diff is serialized as a regular octree
+  octomap_msgs::Octomap diff_msg = map.octomap;
+  diff_msg.id = "OcTree";
+  std::unique_ptr<octomap::OcTree> diff(static_cast<octomap::OcTree*>(octomap_msgs::msgToMap(diff_msg)));
+  if (!diff)
+  {
+    logError("Unable to decode octomap update %u", map.header.seq);
+    return false;
+  }
+
+  // the current octree may be shared (e.g., with collision checkers), so the changes are applied to a copy
+  collision_detection::CollisionWorld::ObjectConstPtr obj = world_->getObject(OCTOMAP_NS);
+  const shapes::OcTree* o = static_cast<const shapes::OcTree*>(obj->shapes_[0].get());
+  std::shared_ptr<octomap::OcTree> om(new octomap::OcTree(*o->octree));
+  for (octomap::OcTree::leaf_iterator it = diff->begin_leafs(), end = diff->end_leafs(); it != end; ++it)
+    om->setNodeValue(it.getKey(), it->getLogOdds(), true);
+  om->updateInnerOccupancy();
+
+  Eigen::Affine3d pose = obj->shape_poses_[0];
+  obj.reset();
+  world_->removeObject(OCTOMAP_NS);
+  world_->addToObject(OCTOMAP_NS, shapes::ShapeConstPtr(new shapes::OcTree(om)), pose);
+  octomap_seq_ = map.header.seq;
+  return true;
 }
 
 void planning_scene::PlanningScene::processOctomapPtr(const std::shared_ptr<const octomap::OcTree>& octree,
@@ -1355,6 +2081,8 @@ void planning_scene::PlanningScene::processOctomapPtr(const std::shared_ptr<cons
         // if the pose changed, we update it
         if (map->shape_poses_[0].isApprox(t, std::numeric_limits<double>::epsilon() * 100.0))
         {
+          // the octree was modified in place
+          octomap_version_ = nextComponentVersion();
           if (world_diff_)
             world_diff_->set(OCTOMAP_NS, collision_detection::World::DESTROY | collision_detection::World::CREATE |
                                              collision_detection::World::ADD_SHAPE);
@@ -1392,7 +2120,8 @@ bool planning_scene::PlanningScene::processAttachedCollisionObjectMsg(
   if (!kstate_)  // there must be a parent in this case
   {
     kstate_.reset(new robot_state::RobotState(parent_->getCurrentState()));
-    kstate_->setAttachedBodyUpdateCallback(current_state_attached_body_callback_);
+    kstate_->setAttachedBodyUpdateCallback(boost::bind(&PlanningScene::attachedBodyUpdated, this, _1, _2));
+    attached_bodies_version_ = parent_->getAttachedBodiesVersion();
   }
   kstate_->update();
 
@@ -1478,12 +2207,12 @@ bool planning_scene::PlanningScene::processAttachedCollisionObjectMsg(
         }
         for (std::size_t i = 0; i < object.object.meshes.size(); ++i)
         {
-          shapes::Shape* s = shapes::constructShapeFromMsg(object.object.meshes[i]);
+          shapes::ShapeConstPtr s = constructMeshFromMsg(object.object.meshes[i]);
           if (s)
           {
             Eigen::Affine3d p;
             tf::poseMsgToEigen(object.object.mesh_poses[i], p);
-            shapes.push_back(shapes::ShapeConstPtr(s));
+            shapes.push_back(s);
             poses.push_back(p);
           }
         }
@@ -1670,12 +2399,12 @@ bool planning_scene::PlanningScene::processCollisionObjectMsg(const moveit_msgs:
     }
     for (std::size_t i = 0; i < object.meshes.size(); ++i)
     {
-      shapes::Shape* s = shapes::constructShapeFromMsg(object.meshes[i]);
+      shapes::ShapeConstPtr s = constructMeshFromMsg(object.meshes[i]);
       if (s)
       {
         Eigen::Affine3d p;
         tf::poseMsgToEigen(object.mesh_poses[i], p);
-        world_->addToObject(object.id, shapes::ShapeConstPtr(s), t * p);
+        world_->addToObject(object.id, s, t * p);
       }
     }
     for (std::size_t i = 0; i < object.planes.size(); ++i)
@@ -1774,24 +2503,34 @@ const Eigen::Affine3d& planning_scene::PlanningScene::getFrameTransform(const st
 const Eigen::Affine3d& planning_scene::PlanningScene::getFrameTransform(const robot_state::RobotState& state,
                                                                         const std::string& id) const
 {
+  const Eigen::Affine3d* transform = findFrameTransform(state, id);
+  if (transform)
+    return *transform;
   if (!id.empty() && id[0] == '/')
-    return getFrameTransform(id.substr(1));
-  if (state.knowsFrameTransform(id))
-    return state.getFrameTransform(id);
-  if (getWorld()->hasObject(id))
+    return getFrameTransform(state, id.substr(1));
+  collision_detection::World::ObjectConstPtr obj = getWorld()->getObject(id);
+  if (obj && obj->shape_poses_.size() > 1)
   {
-    collision_detection::World::ObjectConstPtr obj = getWorld()->getObject(id);
-    if (obj->shape_poses_.size() > 1)
-    {
-      logWarn("More than one shapes in object '%s'. Using first one to decide transform");
-      return obj->shape_poses_[0];
-    }
-    else if (obj->shape_poses_.size() == 1)
-      return obj->shape_poses_[0];
+    logWarn("More than one shapes in object '%s'. Using first one to decide transform", id.c_str());
+    return obj->shape_poses_[0];
   }
   return getTransforms().Transforms::getTransform(id);
 }
 
+const Eigen::Affine3d* planning_scene::PlanningScene::findFrameTransform(const robot_state::RobotState& state,
+                                                                         const std::string& id) const
+{
+  if (!id.empty() && id[0] == '/')
+    return findFrameTransform(state, id.substr(1));
+  const Eigen::Affine3d* transform = state.findFrameTransform(id);
+  if (transform)
+    return transform;
+  collision_detection::World::ObjectConstPtr obj = getWorld()->getObject(id);
+  if (obj)
+    return obj->shape_poses_.size() == 1 ? &obj->shape_poses_[0] : NULL;
+  return getTransforms().Transforms::findTransform(id);
+}
+
 bool planning_scene::PlanningScene::knowsFrameTransform(const std::string& id) const
 {
   return knowsFrameTransform(getCurrentState(), id);
@@ -1800,16 +2539,7 @@ bool planning_scene::PlanningScene::knowsFrameTransform(const std::string& id) c
 bool planning_scene::PlanningScene::knowsFrameTransform(const robot_state::RobotState& state,
                                                         const std::string& id) const
 {
-  if (!id.empty() && id[0] == '/')
-    return knowsFrameTransform(id.substr(1));
-  if (state.knowsFrameTransform(id))
-    return true;
-  if (getWorld()->hasObject(id))
-  {
-    collision_detection::World::ObjectConstPtr obj = getWorld()->getObject(id);
-    return obj->shape_poses_.size() == 1;
-  }
-  return getTransforms().Transforms::canTransform(id);
+  return findFrameTransform(state, id) != NULL;
 }
 
 bool planning_scene::PlanningScene::hasObjectType(const std::string& id) const
@@ -1985,7 +2715,7 @@ bool planning_scene::PlanningScene::isStateConstrained(const robot_state::RobotS
                                                        const kinematic_constraints::KinematicConstraintSet& constr,
                                                        bool verbose) const
 {
-  return constr.decide(state, verbose).satisfied;
+  return constr.isSatisfied(state, verbose);
 }
 
 bool planning_scene::PlanningScene::isStateValid(const robot_state::RobotState& state, const std::string& group,
@@ -2090,52 +2820,111 @@ bool planning_scene::PlanningScene::isPathValid(const robot_trajectory::RobotTra
   kinematic_constraints::KinematicConstraintSet ks_p(getRobotModel());
   ks_p.add(path_constraints, getTransforms());
   std::size_t n_wp = trajectory.getWayPointCount();
-  for (std::size_t i = 0; i < n_wp; ++i)
-  {
-    const robot_state::RobotState& st = trajectory.getWayPoint(i);
 
-    bool this_state_valid = true;
-    if (isStateColliding(st, group, verbose))
-      this_state_valid = false;
-    if (!isStateFeasible(st, verbose))
-      this_state_valid = false;
-    if (!ks_p.empty() && !ks_p.decide(st, verbose).satisfied)
-      this_state_valid = false;
+  // path constraints are evaluated for all waypoints at once, before the (much more expensive) collision checks
+  std::vector<char> violates_constraints(n_wp, 0);
+  if (!ks_p.empty() && n_wp > 0)
+  {
+    if (verbose)
+      for (std::size_t i = 0; i < n_wp; ++i)
+        violates_constraints[i] = !ks_p.isSatisfied(trajectory.getWayPoint(i), verbose);
+    else
+    {
+      std::vector<const robot_state::RobotState*> states(n_wp);
+      for (std::size_t i = 0; i < n_wp; ++i)
+        states[i] = &trajectory.getWayPoint(i);
+      std::vector<kinematic_constraints::ConstraintEvaluationResult> constraint_results(n_wp);
+      ks_p.decideBatch(&states[0], n_wp, &constraint_results[0]);
+      for (std::size_t i = 0; i < n_wp; ++i)
+        violates_constraints[i] = !constraint_results[i].satisfied;
+    }
+    if (!invalid_index)
+      for (std::size_t i = 0; i < n_wp; ++i)
+        if (violates_constraints[i])
+          return false;
+  }
 
-    if (!this_state_valid)
+  if (path_validity_thread_count_ != 1 && n_wp > 1)
+  {
+    std::vector<std::size_t> order;
+    computeBisectionOrder(n_wp, order);
+    std::vector<char> invalid(n_wp, 0);
+    std::size_t first = collision_detection::processCollisionBatch(
+        n_wp, path_validity_thread_count_, !invalid_index,
+        boost::bind(&PlanningScene::checkPathWayPoint, this, boost::cref(trajectory), boost::cref(violates_constraints),
+                    boost::cref(order), boost::cref(group), verbose, &invalid, _1));
+    if (first < n_wp)
     {
-      if (invalid_index)
-        invalid_index->push_back(i);
-      else
+      if (!invalid_index)
         return false;
       result = false;
+      for (std::size_t i = 0; i < n_wp; ++i)
+        if (invalid[i])
+          invalid_index->push_back(i);
     }
-
-    // check goal for last state
-    if (i + 1 == n_wp && !goal_constraints.empty())
+  }
+  else
+  {
+    for (std::size_t i = 0; i < n_wp; ++i)
     {
-      bool found = false;
-      for (std::size_t k = 0; k < goal_constraints.size(); ++k)
-      {
-        if (isStateConstrained(st, goal_constraints[k]))
-        {
-          found = true;
-          break;
-        }
-      }
-      if (!found)
+      const robot_state::RobotState& st = trajectory.getWayPoint(i);
+
+      bool this_state_valid = true;
+      if (isStateColliding(st, group, verbose))
+        this_state_valid = false;
+      if (!isStateFeasible(st, verbose))
+        this_state_valid = false;
+      if (violates_constraints[i])
+        this_state_valid = false;
+
+      if (!this_state_valid)
       {
-        if (verbose)
-          logInform("Goal not satisfied");
         if (invalid_index)
           invalid_index->push_back(i);
+        else
+          return false;
         result = false;
       }
     }
   }
+
+  // check goal for last state
+  if (n_wp > 0 && !goal_constraints.empty())
+  {
+    const robot_state::RobotState& st = trajectory.getWayPoint(n_wp - 1);
+    bool found = false;
+    for (std::size_t k = 0; k < goal_constraints.size(); ++k)
+    {
+      if (isStateConstrained(st, goal_constraints[k]))
+      {
+        found = true;
+        break;
+      }
+    }
+    if (!found)
+    {
+      if (verbose)
+        logInform("Goal not satisfied");
+      if (invalid_index)
+        invalid_index->push_back(n_wp - 1);
+      result = false;
+    }
+  }
   return result;
 }
 
+bool planning_scene::PlanningScene::checkPathWayPoint(
+    const robot_trajectory::RobotTrajectory& trajectory,
+    const std::vector<char>& violates_constraints, const std::vector<std::size_t>& order, const std::string& group,
+    bool verbose, std::vector<char>* invalid, std::size_t k) const
+{
+  const robot_state::RobotState& st = trajectory.getWayPoint(order[k]);
+  bool this_state_invalid =
+      violates_constraints[order[k]] || isStateColliding(st, group, verbose) || !isStateFeasible(st, verbose);
+  (*invalid)[order[k]] = this_state_invalid;
+  return this_state_invalid;
+}
+
 bool planning_scene::PlanningScene::isPathValid(const robot_trajectory::RobotTrajectory& trajectory,
                                                 const moveit_msgs::Constraints& path_constraints,
                                                 const moveit_msgs::Constraints& goal_constraints,
@@ -36,8 +36,10 @@
 
 #include <gtest/gtest.h>
 #include <moveit/planning_scene/planning_scene.h>
+#include <octomap_msgs/conversions.h>
 #include <urdf_parser/urdf_parser.h>
 #include <fstream>
+#include <sstream>
 #include <boost/filesystem/path.hpp>
 #include <moveit_resources/config.h>
 
@@ -135,6 +137,296 @@ TEST(PlanningScene, MakeAttachedDiff)
   ps->checkCollision(req, res);
 }
 
+TEST(PlanningScene, OctomapDiff)
+{
+  urdf::ModelInterfaceSharedPtr urdf_model;
+  loadRobotModel(urdf_model);
+  srdf::ModelSharedPtr srdf_model(new srdf::Model());
+  planning_scene::PlanningScene ps(urdf_model, srdf_model);
+
+  // a full octomap with one occupied cell, as version 1
+  octomap::OcTree tree(0.1);
+  tree.updateNode(octomap::point3d(1.0, 0.0, 0.0), true);
+  moveit_msgs::PlanningScene msg;
+  msg.is_diff = true;
+  msg.world.octomap.header.frame_id = ps.getPlanningFrame();
+  msg.world.octomap.header.seq = 1;
+  msg.world.octomap.origin.orientation.w = 1.0;
+  octomap_msgs::fullMapToMsg(tree, msg.world.octomap.octomap);
+  EXPECT_TRUE(ps.setPlanningSceneDiffMsg(msg));
+  EXPECT_EQ(1u, ps.getOctomapSequenceNumber());
+
+  // version 2 only contains a second cell
+  octomap::OcTree diff(0.1);
+  diff.updateNode(octomap::point3d(2.0, 0.0, 0.0), true);
+  msg.world.octomap.header.seq = 2;
+  octomap_msgs::fullMapToMsg(diff, msg.world.octomap.octomap);
+  msg.world.octomap.octomap.id = planning_scene::PlanningScene::OCTOMAP_DIFF_ID;
+  EXPECT_TRUE(ps.setPlanningSceneDiffMsg(msg));
+  EXPECT_EQ(2u, ps.getOctomapSequenceNumber());
+
+  collision_detection::World::ObjectConstPtr map = ps.getWorld()->getObject(planning_scene::PlanningScene::OCTOMAP_NS);
+  ASSERT_TRUE(map);
+  const octomap::OcTree& result = *static_cast<const shapes::OcTree*>(map->shapes_[0].get())->octree;
+  ASSERT_TRUE(result.search(1.0, 0.0, 0.0));
+  ASSERT_TRUE(result.search(2.0, 0.0, 0.0));
+  EXPECT_TRUE(result.isNodeOccupied(result.search(1.0, 0.0, 0.0)));
+  EXPECT_TRUE(result.isNodeOccupied(result.search(2.0, 0.0, 0.0)));
+
+  // version 4 does not apply after version 2
+  msg.world.octomap.header.seq = 4;
+  EXPECT_FALSE(ps.canApplyOctomapDiff(msg.world.octomap));
+  EXPECT_FALSE(ps.setPlanningSceneDiffMsg(msg));
+  EXPECT_EQ(2u, ps.getOctomapSequenceNumber());
+}
+
+TEST(PlanningScene, ComponentVersions)
+{
+  srdf::ModelSharedPtr srdf_model(new srdf::Model());
+  urdf::ModelInterfaceSharedPtr urdf_model;
+  loadRobotModel(urdf_model);
+
+  planning_scene::PlanningScenePtr ps(new planning_scene::PlanningScene(urdf_model, srdf_model));
+  uint64_t world_version = ps->getWorldVersion();
+  uint64_t octomap_version = ps->getOctomapVersion();
+  uint64_t acm_version = ps->getAllowedCollisionMatrixVersion();
+  uint64_t padding_version = ps->getRobotPaddingVersion();
+  uint64_t attached_version = ps->getAttachedBodiesVersion();
+
+  // changing the world only changes the world version
+  ps->getWorldNonConst()->addToObject("sphere", shapes::ShapeConstPtr(new shapes::Sphere(0.4)),
+                                      Eigen::Affine3d::Identity());
+  EXPECT_LT(world_version, ps->getWorldVersion());
+  EXPECT_EQ(octomap_version, ps->getOctomapVersion());
+  EXPECT_EQ(acm_version, ps->getAllowedCollisionMatrixVersion());
+  EXPECT_EQ(padding_version, ps->getRobotPaddingVersion());
+  EXPECT_EQ(attached_version, ps->getAttachedBodiesVersion());
+  world_version = ps->getWorldVersion();
+
+  // a diff reports the versions of its parent until it changes something itself
+  planning_scene::PlanningScenePtr child = ps->diff();
+  EXPECT_EQ(world_version, child->getWorldVersion());
+  EXPECT_EQ(acm_version, child->getAllowedCollisionMatrixVersion());
+  EXPECT_EQ(attached_version, child->getAttachedBodiesVersion());
+
+  ps->getAllowedCollisionMatrixNonConst().setEntry("sphere", true);
+  EXPECT_LT(acm_version, ps->getAllowedCollisionMatrixVersion());
+  EXPECT_EQ(ps->getAllowedCollisionMatrixVersion(), child->getAllowedCollisionMatrixVersion());
+
+  moveit_msgs::AttachedCollisionObject att_obj;
+  att_obj.link_name = "r_wrist_roll_link";
+  att_obj.object.operation = moveit_msgs::CollisionObject::ADD;
+  att_obj.object.id = "sphere";
+  EXPECT_TRUE(child->processAttachedCollisionObjectMsg(att_obj));
+  EXPECT_LT(attached_version, child->getAttachedBodiesVersion());
+  EXPECT_LT(world_version, child->getWorldVersion());
+  EXPECT_EQ(attached_version, ps->getAttachedBodiesVersion());
+  EXPECT_EQ(world_version, ps->getWorldVersion());
+
+  child->getCollisionRobotNonConst()->setPadding(0.1);
+  EXPECT_LT(padding_version, child->getRobotPaddingVersion());
+  EXPECT_EQ(padding_version, ps->getRobotPaddingVersion());
+}
+
+// a feasibility predicate that rejects states whose first variable is 1 or more
+static bool isFirstVariableBelowOne(const robot_state::RobotState& state, bool verbose)
+{
+  return state.getVariablePosition(0) < 1.0;
+}
+
+TEST(PlanningScene, ParallelPathValidity)
+{
+  srdf::ModelSharedPtr srdf_model(new srdf::Model());
+  urdf::ModelInterfaceSharedPtr urdf_model;
+  loadRobotModel(urdf_model);
+
+  planning_scene::PlanningScenePtr ps(new planning_scene::PlanningScene(urdf_model, srdf_model));
+  ps->getAllowedCollisionMatrixNonConst().setEntry(true);
+  ps->setStateFeasibilityPredicate(&isFirstVariableBelowOne);
+
+  robot_trajectory::RobotTrajectory trajectory(ps->getRobotModel(), "");
+  robot_state::RobotState state(ps->getRobotModel());
+  state.setToDefaultValues();
+  for (std::size_t i = 0; i < 100; ++i)
+  {
+    state.setVariablePosition(0, i == 17 || i == 64 ? 1.0 : 0.0);
+    state.update();
+    trajectory.addSuffixWayPoint(state, 0.1);
+  }
+
+  std::vector<std::size_t> serial_invalid;
+  EXPECT_FALSE(ps->isPathValid(trajectory, "", false, &serial_invalid));
+  ASSERT_EQ(2u, serial_invalid.size());
+  EXPECT_EQ(17u, serial_invalid[0]);
+  EXPECT_EQ(64u, serial_invalid[1]);
+
+  ps->setPathValidityThreadCount(4);
+  std::vector<std::size_t> parallel_invalid;
+  EXPECT_FALSE(ps->isPathValid(trajectory, "", false, &parallel_invalid));
+  EXPECT_EQ(serial_invalid, parallel_invalid);
+  EXPECT_FALSE(ps->isPathValid(trajectory));
+
+  // the thread count is inherited by diffs
+  planning_scene::PlanningScenePtr child = ps->diff();
+  EXPECT_EQ(4u, child->getPathValidityThreadCount());
+  child->setStateFeasibilityPredicate(planning_scene::StateFeasibilityFn());
+  EXPECT_TRUE(child->isPathValid(trajectory));
+}
+
+TEST(PlanningScene, CollisionCache)
+{
+  srdf::ModelSharedPtr srdf_model(new srdf::Model());
+  urdf::ModelInterfaceSharedPtr urdf_model;
+  loadRobotModel(urdf_model);
+
+  planning_scene::PlanningScenePtr ps(new planning_scene::PlanningScene(urdf_model, srdf_model));
+  ps->getAllowedCollisionMatrixNonConst().setEntry(true);
+  EXPECT_EQ(0u, ps->getCollisionCacheSize());
+  ps->setCollisionCache(16, 1e-3);
+  EXPECT_EQ(16u, ps->getCollisionCacheSize());
+  EXPECT_DOUBLE_EQ(1e-3, ps->getCollisionCacheResolution());
+
+  robot_state::RobotState state(ps->getRobotModel());
+  state.setToDefaultValues();
+  state.update();
+  EXPECT_FALSE(ps->isStateColliding(state));
+  EXPECT_FALSE(ps->isStateColliding(state));
+
+  // a change to the world must not be hidden by the results cached for the previous version
+  ps->getWorldNonConst()->addToObject("sphere", shapes::ShapeConstPtr(new shapes::Sphere(0.4)),
+                                      Eigen::Affine3d::Identity());
+  EXPECT_TRUE(ps->isStateColliding(state));
+  EXPECT_TRUE(ps->isStateColliding(state));
+
+  // diffs share the cache, but look up the versions of their own components
+  planning_scene::PlanningScenePtr child = ps->diff();
+  EXPECT_EQ(16u, child->getCollisionCacheSize());
+  EXPECT_TRUE(child->isStateColliding(state));
+  child->getWorldNonConst()->removeObject("sphere");
+  EXPECT_FALSE(child->isStateColliding(state));
+  EXPECT_TRUE(ps->isStateColliding(state));
+
+  // only the collision flag is cached; requests for contacts are always computed
+  collision_detection::CollisionRequest req;
+  req.contacts = true;
+  collision_detection::CollisionResult res;
+  ps->checkCollision(req, res, state);
+  EXPECT_TRUE(res.collision);
+  EXPECT_FALSE(res.contacts.empty());
+
+  ps->setCollisionCache(0);
+  EXPECT_EQ(0u, ps->getCollisionCacheSize());
+}
+
+TEST(PlanningScene, BinaryGeometry)
+{
+  srdf::ModelSharedPtr srdf_model(new srdf::Model());
+  urdf::ModelInterfaceSharedPtr urdf_model;
+  loadRobotModel(urdf_model);
+
+  planning_scene::PlanningScene ps(urdf_model, srdf_model);
+  ps.setName("binary");
+  Eigen::Affine3d pose = Eigen::Translation3d(1.0, 2.0, 3.0) * Eigen::AngleAxisd(0.5, Eigen::Vector3d::UnitZ());
+  for (int i = 0; i < 20; ++i)
+  {
+    std::string id = "object" + std::to_string(i);
+    ps.getWorldNonConst()->addToObject(id, shapes::ShapeConstPtr(new shapes::Box(0.1, 0.2, 0.3)), pose);
+    ps.getWorldNonConst()->addToObject(id, shapes::ShapeConstPtr(new shapes::Sphere(0.4)),
+                                       Eigen::Affine3d::Identity());
+  }
+  std_msgs::ColorRGBA color;
+  color.r = 0.5f;
+  color.a = 1.0f;
+  ps.setObjectColor("object3", color);
+
+  std::stringstream stream;
+  ps.saveGeometryToBinaryStream(stream);
+  const std::string data = stream.str();
+
+  planning_scene::PlanningScene loaded(urdf_model, srdf_model);
+  std::istringstream in(data);
+  EXPECT_TRUE(loaded.loadGeometryFromBinaryStream(in, Eigen::Affine3d::Identity(), 4));
+  EXPECT_EQ("binary", loaded.getName());
+  EXPECT_EQ(20u, loaded.getWorld()->size());
+  collision_detection::World::ObjectConstPtr obj = loaded.getWorld()->getObject("object7");
+  ASSERT_TRUE(obj != NULL);
+  ASSERT_EQ(2u, obj->shapes_.size());
+  EXPECT_EQ(shapes::BOX, obj->shapes_[0]->type);
+  EXPECT_EQ(shapes::SPHERE, obj->shapes_[1]->type);
+  EXPECT_TRUE(obj->shape_poses_[0].isApprox(pose));
+  EXPECT_TRUE(loaded.hasObjectColor("object3"));
+  EXPECT_FALSE(loaded.hasObjectColor("object4"));
+  EXPECT_FLOAT_EQ(0.5f, loaded.getObjectColor("object3").r);
+
+  // a truncated stream is rejected without changing the scene
+  planning_scene::PlanningScene truncated(urdf_model, srdf_model);
+  std::istringstream truncated_in(data.substr(0, data.size() - 10));
+  EXPECT_FALSE(truncated.loadGeometryFromBinaryStream(truncated_in));
+  EXPECT_EQ(0u, truncated.getWorld()->size());
+}
+
+TEST(PlanningScene, SharedMeshes)
+{
+  srdf::ModelSharedPtr srdf_model(new srdf::Model());
+  urdf::ModelInterfaceSharedPtr urdf_model;
+  loadRobotModel(urdf_model);
+  planning_scene::PlanningScene ps(urdf_model, srdf_model);
+
+  shape_msgs::Mesh mesh;
+  mesh.vertices.resize(3);
+  mesh.vertices[1].x = 1.0;
+  mesh.vertices[2].y = 1.0;
+  mesh.triangles.resize(1);
+  mesh.triangles[0].vertex_indices[0] = 0;
+  mesh.triangles[0].vertex_indices[1] = 1;
+  mesh.triangles[0].vertex_indices[2] = 2;
+
+  moveit_msgs::CollisionObject co;
+  co.header.frame_id = ps.getPlanningFrame();
+  co.operation = moveit_msgs::CollisionObject::ADD;
+  co.meshes.push_back(mesh);
+  co.mesh_poses.resize(1);
+  co.mesh_poses[0].orientation.w = 1.0;
+  co.id = "bin1";
+  EXPECT_TRUE(ps.processCollisionObjectMsg(co));
+  co.id = "bin2";
+  EXPECT_TRUE(ps.processCollisionObjectMsg(co));
+  co.meshes[0].vertices[2].z = 1.0;
+  co.id = "bin3";
+  EXPECT_TRUE(ps.processCollisionObjectMsg(co));
+
+  // identical meshes decode to the same shape, other meshes do not
+  shapes::ShapeConstPtr shape1 = ps.getWorld()->getObject("bin1")->shapes_[0];
+  EXPECT_EQ(shape1, ps.getWorld()->getObject("bin2")->shapes_[0]);
+  EXPECT_NE(shape1, ps.getWorld()->getObject("bin3")->shapes_[0]);
+}
+
+TEST(PlanningScene, FindFrameTransform)
+{
+  srdf::ModelSharedPtr srdf_model(new srdf::Model());
+  urdf::ModelInterfaceSharedPtr urdf_model;
+  loadRobotModel(urdf_model);
+
+  planning_scene::PlanningScene ps(urdf_model, srdf_model);
+  Eigen::Affine3d pose = Eigen::Translation3d(1.0, 2.0, 3.0) * Eigen::Affine3d::Identity();
+  ps.getWorldNonConst()->addToObject("box", shapes::ShapeConstPtr(new shapes::Box(0.1, 0.2, 0.3)), pose);
+  ps.getTransformsNonConst().setTransform(pose, "/fixed_frame");
+  const robot_state::RobotState& state = ps.getCurrentState();
+
+  // links, collision objects and fixed frames resolve with or without the leading slash
+  const char* frames[] = { "r_wrist_roll_link", "/r_wrist_roll_link", "box", "/box", "fixed_frame", "/fixed_frame" };
+  for (std::size_t i = 0; i < sizeof(frames) / sizeof(frames[0]); ++i)
+  {
+    const Eigen::Affine3d* transform = ps.findFrameTransform(state, frames[i]);
+    ASSERT_TRUE(transform != NULL) << frames[i];
+    EXPECT_TRUE(transform->isApprox(ps.getFrameTransform(frames[i]))) << frames[i];
+    EXPECT_TRUE(ps.knowsFrameTransform(frames[i])) << frames[i];
+  }
+  EXPECT_TRUE(ps.findFrameTransform(state, "box")->isApprox(pose));
+  EXPECT_TRUE(ps.findFrameTransform(state, "unknown_frame") == NULL);
+  EXPECT_FALSE(ps.knowsFrameTransform("unknown_frame"));
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,160 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_PROFILER_TRACER_
+#define MOVEIT_PROFILER_TRACER_
+
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/shared_ptr.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace moveit
+{
+namespace tools
+{
+/** \brief Identifier of an interned trace event name, see Tracer::intern() */
+typedef std::uint32_t TraceEventId;
+
+/** \brief A low-overhead recorder of timed scopes, meant to stay compiled into hot paths.
+
+    Unlike Profiler, which aggregates times in maps keyed by strings under a lock, the tracer records individual
+    events: every thread appends (event id, start, end) to its own fixed-size ring buffer, without locks or
+    allocation once the buffer of the thread exists. When tracing is disabled, a scope costs one relaxed atomic load.
+    The recorded events can be exported in the Chrome trace event format, which chrome://tracing and Perfetto open.
+
+    If the environment variable MOVEIT_TRACE_FILE is set, tracing is enabled at startup and the trace is written to
+    that file when the process exits. */
+class Tracer : private boost::noncopyable
+{
+public:
+  /** \brief Records the time spent between construction and destruction as event \e id, if tracing is enabled at
+      construction */
+  class ScopedTrace
+  {
+  public:
+    explicit ScopedTrace(TraceEventId id) : id_(id), start_(Tracer::Instance().isEnabled() ? Tracer::now() : 0)
+    {
+    }
+
+    ~ScopedTrace()
+    {
+      if (start_)
+        Tracer::Instance().record(id_, start_, Tracer::now());
+    }
+
+  private:
+    TraceEventId id_;
+    std::uint64_t start_;
+  };
+
+  /** \brief Return the process-wide tracer */
+  static Tracer& Instance();
+
+  /** \brief The time stamps used for events, in nanoseconds of a monotonic clock (never 0) */
+  static std::uint64_t now()
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count() | 1;
+  }
+
+  /** \brief Return the id for the event named \e name; equal names get equal ids. This takes a lock, so it is meant
+      to be called once per call site (MOVEIT_TRACE_SCOPE() keeps the id in a function-local static). */
+  TraceEventId intern(const std::string& name);
+
+  /** \brief Enable or disable recording. Disabling keeps the events recorded so far. */
+  void setEnabled(bool enabled)
+  {
+    enabled_.store(enabled, std::memory_order_relaxed);
+  }
+
+  bool isEnabled() const
+  {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  /** \brief Set the number of events kept per thread (the oldest are overwritten first). Only affects threads that
+      have not recorded an event yet. */
+  void setBufferCapacity(std::size_t events);
+
+  /** \brief Record event \e id of the calling thread, spanning [\e start, \e end] (see now()) */
+  void record(TraceEventId id, std::uint64_t start, std::uint64_t end);
+
+  /** \brief Forget the events recorded so far */
+  void clear();
+
+  /** \brief Write the recorded events to \e out in the Chrome trace event (JSON) format */
+  void exportChromeTrace(std::ostream& out) const;
+
+  /** \brief Write the recorded events to the file \e filename in the Chrome trace event (JSON) format */
+  bool exportChromeTrace(const std::string& filename) const;
+
+private:
+  struct ThreadBuffer;
+
+  Tracer();
+  ~Tracer();
+
+  ThreadBuffer* createThreadBuffer();
+
+  /// The buffer of the calling thread; owned by buffers_, so the events outlive the thread
+  static thread_local ThreadBuffer* thread_buffer_;
+
+  std::atomic<bool> enabled_;
+  std::size_t buffer_capacity_;
+  std::string trace_file_;
+
+  mutable boost::mutex lock_;
+  std::vector<std::string> names_;
+  std::vector<boost::shared_ptr<ThreadBuffer> > buffers_;
+};
+}
+}
+
+#define MOVEIT_TRACE_CONCAT_(a, b) a##b
+#define MOVEIT_TRACE_CONCAT(a, b) MOVEIT_TRACE_CONCAT_(a, b)
+
+/** \brief Trace the rest of the enclosing scope as the event \e name (a string literal) */
+#define MOVEIT_TRACE_SCOPE(name)                                                                                       \
+  static const moveit::tools::TraceEventId MOVEIT_TRACE_CONCAT(moveit_trace_id_, __LINE__) =                          \
+      moveit::tools::Tracer::Instance().intern(name);                                                                  \
+  moveit::tools::Tracer::ScopedTrace MOVEIT_TRACE_CONCAT(moveit_trace_scope_, __LINE__)(                               \
+      MOVEIT_TRACE_CONCAT(moveit_trace_id_, __LINE__))
+
+#endif
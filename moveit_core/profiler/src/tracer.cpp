@@ -0,0 +1,196 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/profiler/tracer.h>
+#include <console_bridge/console.h>
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <unistd.h>
+
+struct moveit::tools::Tracer::ThreadBuffer
+{
+  /// Fields are atomic because exportChromeTrace() may read a slot while its thread overwrites it
+  struct Event
+  {
+    std::atomic<TraceEventId> id;
+    std::atomic<std::uint64_t> start;
+    std::atomic<std::uint64_t> end;
+  };
+
+  ThreadBuffer(std::size_t capacity, unsigned int thread)
+    : events(new Event[capacity]), capacity(capacity), thread(thread), head(0), first(0)
+  {
+  }
+
+  std::unique_ptr<Event[]> events;
+  std::size_t capacity;
+  unsigned int thread;
+
+  /// Number of events ever written; only the owning thread writes it
+  std::atomic<std::uint64_t> head;
+
+  /// Events before this one were cleared
+  std::atomic<std::uint64_t> first;
+};
+
+thread_local moveit::tools::Tracer::ThreadBuffer* moveit::tools::Tracer::thread_buffer_ = NULL;
+
+namespace
+{
+void writeEscaped(std::ostream& out, const std::string& s)
+{
+  for (std::size_t i = 0; i < s.size(); ++i)
+  {
+    if (s[i] == '"' || s[i] == '\\')
+      out << '\\';
+    out << s[i];
+  }
+}
+}
+
+moveit::tools::Tracer& moveit::tools::Tracer::Instance()
+{
+  static Tracer tracer;
+  return tracer;
+}
+
+moveit::tools::Tracer::Tracer() : enabled_(false), buffer_capacity_(1 << 16)
+{
+  const char* file = std::getenv("MOVEIT_TRACE_FILE");
+  if (file && *file)
+  {
+    trace_file_ = file;
+    setEnabled(true);
+  }
+}
+
+moveit::tools::Tracer::~Tracer()
+{
+  if (!trace_file_.empty())
+    exportChromeTrace(trace_file_);
+}
+
+moveit::tools::TraceEventId moveit::tools::Tracer::intern(const std::string& name)
+{
+  boost::mutex::scoped_lock slock(lock_);
+  for (std::size_t i = 0; i < names_.size(); ++i)
+    if (names_[i] == name)
+      return i;
+  names_.push_back(name);
+  return names_.size() - 1;
+}
+
+void moveit::tools::Tracer::setBufferCapacity(std::size_t events)
+{
+  boost::mutex::scoped_lock slock(lock_);
+  buffer_capacity_ = std::max<std::size_t>(events, 1);
+}
+
+moveit::tools::Tracer::ThreadBuffer* moveit::tools::Tracer::createThreadBuffer()
+{
+  boost::mutex::scoped_lock slock(lock_);
+  buffers_.push_back(boost::shared_ptr<ThreadBuffer>(new ThreadBuffer(buffer_capacity_, buffers_.size())));
+  return buffers_.back().get();
+}
+
+void moveit::tools::Tracer::record(TraceEventId id, std::uint64_t start, std::uint64_t end)
+{
+  if (!thread_buffer_)
+    thread_buffer_ = createThreadBuffer();
+
+  const std::uint64_t head = thread_buffer_->head.load(std::memory_order_relaxed);
+  ThreadBuffer::Event& event = thread_buffer_->events[head % thread_buffer_->capacity];
+  event.id.store(id, std::memory_order_relaxed);
+  event.start.store(start, std::memory_order_relaxed);
+  event.end.store(end, std::memory_order_relaxed);
+  thread_buffer_->head.store(head + 1, std::memory_order_release);
+}
+
+void moveit::tools::Tracer::clear()
+{
+  boost::mutex::scoped_lock slock(lock_);
+  for (std::size_t i = 0; i < buffers_.size(); ++i)
+    buffers_[i]->first.store(buffers_[i]->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+}
+
+void moveit::tools::Tracer::exportChromeTrace(std::ostream& out) const
+{
+  boost::mutex::scoped_lock slock(lock_);
+  const int pid = getpid();
+  bool first_event = true;
+  out << "{\"traceEvents\":[";
+  out << std::fixed << std::setprecision(3);
+  for (std::size_t b = 0; b < buffers_.size(); ++b)
+  {
+    const ThreadBuffer& buffer = *buffers_[b];
+    const std::uint64_t head = buffer.head.load(std::memory_order_acquire);
+    std::uint64_t begin = buffer.first.load(std::memory_order_relaxed);
+    if (head > buffer.capacity && begin < head - buffer.capacity)
+      begin = head - buffer.capacity;
+    for (std::uint64_t i = begin; i < head; ++i)
+    {
+      const ThreadBuffer::Event& event = buffer.events[i % buffer.capacity];
+      const TraceEventId id = event.id.load(std::memory_order_relaxed);
+      const std::uint64_t start = event.start.load(std::memory_order_relaxed);
+      const std::uint64_t end = event.end.load(std::memory_order_relaxed);
+
+      // the thread may have overwritten the slot while we read it; such events are dropped
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (buffer.head.load(std::memory_order_relaxed) >= i + buffer.capacity || id >= names_.size())
+        continue;
+
+      out << (first_event ? "\n" : ",\n") << "{\"name\":\"";
+      writeEscaped(out, names_[id]);
+      out << "\",\"ph\":\"X\",\"pid\":" << pid << ",\"tid\":" << buffer.thread << ",\"ts\":" << start / 1000.0
+          << ",\"dur\":" << (end - start) / 1000.0 << "}";
+      first_event = false;
+    }
+  }
+  out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+}
+
+bool moveit::tools::Tracer::exportChromeTrace(const std::string& filename) const
+{
+  std::ofstream out(filename.c_str());
+  if (!out.good())
+  {
+    logError("Unable to open '%s' to write a trace", filename.c_str());
+    return false;
+  }
+  exportChromeTrace(out);
+  return true;
+}
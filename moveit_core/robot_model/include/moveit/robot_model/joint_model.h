@@ -45,6 +45,7 @@
 #include <moveit_msgs/JointLimits.h>
 #include <random_numbers/random_numbers.h>
 #include <Eigen/Geometry>
+#include <atomic>
 
 namespace moveit
 {
@@ -330,6 +331,13 @@ public:
   /** \brief Override joint limits loaded from URDF. Unknown variables are ignored. */
   void setVariableBounds(const std::vector<moveit_msgs::JointLimits>& jlim);
 
+  /** \brief Set the counter to increment whenever the bounds of this joint are set. The robot model shares one
+      counter among its joints, so its groups know when to refresh the copies of the bounds they keep. */
+  void setVariableBoundsUpdateCounter(std::atomic<unsigned int>* counter)
+  {
+    variable_bounds_update_counter_ = counter;
+  }
+
   /** \brief Get the joint limits known to this model, as a message. */
   const std::vector<moveit_msgs::JointLimits>& getVariableBoundsMsg() const
   {
@@ -507,6 +515,9 @@ protected:
 
   /** \brief Index for this joint in the array of joints of the complete model */
   int joint_index_;
+
+  /** \brief Incremented when the bounds of this joint are set; owned by the robot model, if any */
+  std::atomic<unsigned int>* variable_bounds_update_counter_;
 };
 
 /** \brief Operator overload for printing variable bounds to a stream */
@@ -43,6 +43,7 @@
 #include <moveit/kinematics_base/kinematics_base.h>
 #include <srdfdom/model.h>
 #include <boost/function.hpp>
+#include <memory>
 #include <set>
 
 namespace moveit
@@ -367,6 +368,21 @@ public:
   void getVariableRandomPositions(random_numbers::RandomNumberGenerator& rng, double* values,
                                   const JointBoundsVector& active_joint_bounds) const;
 
+  /** \brief Compute \e count random states of the joint group at once, stored one after the other in \e values. The
+      samples are the same as those of \e count calls to getVariableRandomPositions(), but the variables of joints that
+      are not continuous are scaled to their bounds as one vector per sample. */
+  void getVariableRandomPositions(random_numbers::RandomNumberGenerator& rng, double* values, std::size_t count) const;
+
+  /** \brief Compute \e count random states of the joint group at once; \e values is resized to hold them one after
+      the other */
+  void getVariableRandomPositions(random_numbers::RandomNumberGenerator& rng, std::vector<double>& values,
+                                  std::size_t count) const
+  {
+    values.resize(variable_count_ * count);
+    if (!values.empty())
+      getVariableRandomPositions(rng, &values[0], count);
+  }
+
   /** \brief Compute random values for the state of the joint group */
   void getVariableRandomPositionsNearBy(random_numbers::RandomNumberGenerator& rng, double* values,
                                         const JointBoundsVector& active_joint_bounds, const double* near,
@@ -584,6 +600,22 @@ protected:
       there are no values to be read (\e values is only the group state) */
   void updateMimicJoints(double* values) const;
 
+  /** \brief Copies of the position bounds of the bounded variables, taken when the update count of the parent model
+      was \e update_count_ */
+  struct FlatBounds
+  {
+    Eigen::ArrayXd min_;
+    Eigen::ArrayXd max_;
+    Eigen::ArrayXd range_;
+    unsigned int update_count_;
+  };
+  typedef std::shared_ptr<const FlatBounds> FlatBoundsConstPtr;
+
+  /** \brief Get the copies of the bounds of the bounded variables; new copies are made if the bounds of a joint of
+      the parent model were set since the current ones were taken. Callers keep the returned pointer for the whole
+      call, so they see one consistent set of bounds. */
+  FlatBoundsConstPtr getFlatBounds() const;
+
   /** \brief Owner model */
   const RobotModel* parent_model_;
 
@@ -733,6 +765,26 @@ protected:
 
   std::vector<GroupMimicUpdate> group_mimic_update_;
 
+  /** \brief The indices in active_joint_model_vector_ of the joints with a single bounded variable (revolute joints
+      that are not continuous, and prismatic joints). When the group's own bounds are used, these joints are checked,
+      enforced and sampled using the flat arrays below, instead of calls to the joint models. */
+  std::vector<std::size_t> bounded_joint_index_;
+
+  /** \brief For each joint in bounded_joint_index_, the index of its variable in the group state */
+  std::vector<int> bounded_variable_index_;
+
+  /** \brief The indices in active_joint_model_vector_ of the joints not in bounded_joint_index_ */
+  std::vector<std::size_t> other_joint_index_;
+
+  /** \brief True if bounded_variable_index_ is 0, 1, 2, ..., so the bounded variables can be accessed as one block */
+  bool bounded_variables_contiguous_;
+
+  /** \brief Copies of the position bounds of the bounded variables. Joint bounds may be set after the group is
+      constructed (e.g. joint limits loaded from the parameter server), so new copies are made when
+      RobotModel::getVariableBoundsUpdateCount() changes. The copies are never modified once published, and the
+      pointer is only accessed through std::atomic_load() and std::atomic_store(), so readers need no lock. */
+  mutable FlatBoundsConstPtr flat_bounds_;
+
   std::pair<KinematicsSolver, KinematicsSolverMap> group_kinematics_;
 
   srdf::Model::Group config_;
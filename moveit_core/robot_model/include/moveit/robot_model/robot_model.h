@@ -68,7 +68,11 @@ MOVEIT_CLASS_FORWARD(RobotModel);
 class RobotModel
 {
 public:
-  /** \brief Construct a kinematic model from a parsed description and a list of planning groups */
+  /** \brief Construct a kinematic model from a parsed description and a list of planning groups
+
+      Link meshes are shared with the other robot models of the process. If the environment variable
+      MOVEIT_MESH_CACHE_DIR is set, decoded meshes of local mesh files are also stored in that directory and reused by
+      later processes while the mesh files are unchanged. */
   RobotModel(const urdf::ModelInterfaceSharedPtr& urdf_model, const srdf::ModelConstSharedPtr& srdf_model);
 
   /** \brief Destructor. Clear all memory. */
@@ -382,6 +386,13 @@ public:
     return variable_count_;
   }
 
+  /** \brief Get a number that changes whenever the bounds of a joint of this model are set. Joint model groups use it
+      to refresh the copies of the bounds they keep. */
+  unsigned int getVariableBoundsUpdateCount() const
+  {
+    return variable_bounds_update_count_;
+  }
+
   /** \brief Get the names of the variables that make up the joints that form this state. Fixed joints have no DOF, so
      they are not here,
       but the variables for mimic joints are included. The number of returned elements is always equal to
@@ -409,13 +420,19 @@ public:
   /** \brief Get the index of a variable in the robot state */
   int getVariableIndex(const std::string& variable) const;
 
-  /** \brief Get the deepest joint in the kinematic tree that is a common parent of both joints passed as argument */
+  /** \brief Get the deepest joint in the kinematic tree that is a common parent of both joints passed as argument.
+      This takes constant time: the common roots of all pairs of joints are computed when the model is constructed. */
   const JointModel* getCommonRoot(const JointModel* a, const JointModel* b) const
   {
     if (!a)
       return b;
     if (!b)
       return a;
+    // the common root of a joint and itself, or of the root joint and any joint, needs no lookup in the table
+    if (a == b || a == root_joint_)
+      return a;
+    if (b == root_joint_)
+      return b;
     return joint_model_vector_[common_joint_roots_[a->getJointIndex() * joint_model_vector_.size() +
                                                    b->getJointIndex()]];
   }
@@ -522,6 +539,9 @@ protected:
   /** \brief Get the number of variables necessary to describe this model */
   std::size_t variable_count_;
 
+  /** \brief Incremented by the joints of this model whenever their bounds are set */
+  std::atomic<unsigned int> variable_bounds_update_count_;
+
   /** \brief The state includes all the joint variables that make up the joints the state consists of.
       This map gives the position in the state vector of the group for each of these variables.
       Additionaly, it includes the names of the joints and the index for the first variable of that joint. */
@@ -597,8 +617,9 @@ protected:
   /** \brief Given a urdf link, build the corresponding LinkModel object*/
   LinkModel* constructLinkModel(const urdf::Link* urdf_link);
 
-  /** \brief Given a geometry spec from the URDF and a filename (for a mesh), construct the corresponding shape object*/
-  shapes::ShapePtr constructShape(const urdf::Geometry* geom);
+  /** \brief Given a geometry spec from the URDF and a filename (for a mesh), construct the corresponding shape object.
+      Meshes are shared with the other robot models of the process that loaded the same resource at the same scale */
+  shapes::ShapeConstPtr constructShape(const urdf::Geometry* geom);
 };
 }
 }
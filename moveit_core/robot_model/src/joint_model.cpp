@@ -52,6 +52,7 @@ moveit::core::JointModel::JointModel(const std::string& name)
   , distance_factor_(1.0)
   , first_variable_index_(-1)
   , joint_index_(-1)
+  , variable_bounds_update_counter_(NULL)
 {
 }
 
@@ -125,6 +126,8 @@ void moveit::core::JointModel::setVariableBounds(const std::string& variable, co
 {
   variable_bounds_[getLocalVariableIndex(variable)] = bounds;
   computeVariableBoundsMsg();
+  if (variable_bounds_update_counter_)
+    ++*variable_bounds_update_counter_;
 }
 
 void moveit::core::JointModel::setVariableBounds(const std::vector<moveit_msgs::JointLimits>& jlim)
@@ -154,6 +157,8 @@ void moveit::core::JointModel::setVariableBounds(const std::vector<moveit_msgs::
         break;
       }
   computeVariableBoundsMsg();
+  if (variable_bounds_update_counter_)
+    ++*variable_bounds_update_counter_;
 }
 
 void moveit::core::JointModel::computeVariableBoundsMsg()
@@ -182,6 +182,24 @@ moveit::core::JointModelGroup::JointModelGroup(const std::string& group_name, co
         break;
       }
 
+  // joints with a single bounded variable are checked, enforced and sampled using flat copies of their bounds
+  bounded_variables_contiguous_ = true;
+  for (std::size_t i = 0; i < active_joint_model_vector_.size(); ++i)
+  {
+    const JointModel* jm = active_joint_model_vector_[i];
+    if ((jm->getType() == JointModel::REVOLUTE && !static_cast<const RevoluteJointModel*>(jm)->isContinuous()) ||
+        jm->getType() == JointModel::PRISMATIC)
+    {
+      if (active_joint_model_start_index_[i] != static_cast<int>(bounded_variable_index_.size()))
+        bounded_variables_contiguous_ = false;
+      bounded_joint_index_.push_back(i);
+      bounded_variable_index_.push_back(active_joint_model_start_index_[i]);
+    }
+    else
+      other_joint_index_.push_back(i);
+  }
+  getFlatBounds();
+
   // when updating/sampling a group state only, only mimic joints that have their parent within the group get updated.
   for (std::size_t i = 0; i < mimic_joints_.size(); ++i)
     // if the joint we mimic is also in this group, we will need to do updates when sampling
@@ -314,28 +332,122 @@ const moveit::core::JointModel* moveit::core::JointModelGroup::getJointModel(con
   return it->second;
 }
 
+moveit::core::JointModelGroup::FlatBoundsConstPtr moveit::core::JointModelGroup::getFlatBounds() const
+{
+  // the count is read before the bounds, so copies taken while bounds are being set are replaced on the next call
+  const unsigned int update_count = parent_model_->getVariableBoundsUpdateCount();
+  FlatBoundsConstPtr flat_bounds = std::atomic_load(&flat_bounds_);
+  if (flat_bounds && flat_bounds->update_count_ == update_count)
+    return flat_bounds;
+
+  std::shared_ptr<FlatBounds> copy(new FlatBounds());
+  copy->min_.resize(bounded_joint_index_.size());
+  copy->max_.resize(bounded_joint_index_.size());
+  copy->range_.resize(bounded_joint_index_.size());
+  for (std::size_t k = 0; k < bounded_joint_index_.size(); ++k)
+  {
+    const VariableBounds& bounds = (*active_joint_models_bounds_[bounded_joint_index_[k]])[0];
+    copy->min_[k] = bounds.min_position_;
+    copy->max_[k] = bounds.max_position_;
+    copy->range_[k] = bounds.max_position_ - bounds.min_position_;
+  }
+  copy->update_count_ = update_count;
+
+  // concurrent callers may each make a copy; any of them is correct for this update count
+  flat_bounds = copy;
+  std::atomic_store(&flat_bounds_, flat_bounds);
+  return flat_bounds;
+}
+
 void moveit::core::JointModelGroup::getVariableRandomPositions(random_numbers::RandomNumberGenerator& rng,
                                                                double* values,
                                                                const JointBoundsVector& active_joint_bounds) const
 {
   assert(active_joint_bounds.size() == active_joint_model_vector_.size());
-  for (std::size_t i = 0; i < active_joint_model_vector_.size(); ++i)
-    active_joint_model_vector_[i]->getVariableRandomPositions(rng, values + active_joint_model_start_index_[i],
-                                                              *active_joint_bounds[i]);
+  if (&active_joint_bounds == &active_joint_models_bounds_)
+  {
+    const FlatBoundsConstPtr flat_bounds = getFlatBounds();
+    for (std::size_t k = 0; k < bounded_variable_index_.size(); ++k)
+      values[bounded_variable_index_[k]] = rng.uniformReal(flat_bounds->min_[k], flat_bounds->max_[k]);
+    for (std::size_t k = 0; k < other_joint_index_.size(); ++k)
+    {
+      const std::size_t i = other_joint_index_[k];
+      active_joint_model_vector_[i]->getVariableRandomPositions(rng, values + active_joint_model_start_index_[i],
+                                                                *active_joint_bounds[i]);
+    }
+  }
+  else
+    for (std::size_t i = 0; i < active_joint_model_vector_.size(); ++i)
+      active_joint_model_vector_[i]->getVariableRandomPositions(rng, values + active_joint_model_start_index_[i],
+                                                                *active_joint_bounds[i]);
 
   updateMimicJoints(values);
 }
 
+void moveit::core::JointModelGroup::getVariableRandomPositions(random_numbers::RandomNumberGenerator& rng,
+                                                               double* values, std::size_t count) const
+{
+  const FlatBoundsConstPtr flat_bounds = getFlatBounds();
+  const std::size_t bounded_count = bounded_variable_index_.size();
+  for (std::size_t s = 0; s < count; ++s)
+  {
+    double* sample = values + s * variable_count_;
+
+    // draw the variables in the same order as getVariableRandomPositions(); uniformReal(min, max) is
+    // min + (max - min) * uniform01(), which is applied to all the bounded variables of the sample at once
+    for (std::size_t k = 0; k < bounded_count; ++k)
+      sample[bounded_variable_index_[k]] = rng.uniform01();
+    for (std::size_t k = 0; k < other_joint_index_.size(); ++k)
+    {
+      const std::size_t i = other_joint_index_[k];
+      active_joint_model_vector_[i]->getVariableRandomPositions(rng, sample + active_joint_model_start_index_[i],
+                                                                *active_joint_models_bounds_[i]);
+    }
+
+    if (bounded_variables_contiguous_)
+    {
+      Eigen::Map<Eigen::ArrayXd> bounded(sample, bounded_count);
+      bounded = flat_bounds->range_ * bounded + flat_bounds->min_;
+    }
+    else
+      for (std::size_t k = 0; k < bounded_count; ++k)
+      {
+        double& v = sample[bounded_variable_index_[k]];
+        v = flat_bounds->range_[k] * v + flat_bounds->min_[k];
+      }
+
+    updateMimicJoints(sample);
+  }
+}
+
 void moveit::core::JointModelGroup::getVariableRandomPositionsNearBy(random_numbers::RandomNumberGenerator& rng,
                                                                      double* values,
                                                                      const JointBoundsVector& active_joint_bounds,
                                                                      const double* near, double distance) const
 {
   assert(active_joint_bounds.size() == active_joint_model_vector_.size());
-  for (std::size_t i = 0; i < active_joint_model_vector_.size(); ++i)
-    active_joint_model_vector_[i]->getVariableRandomPositionsNearBy(
-        rng, values + active_joint_model_start_index_[i], *active_joint_bounds[i],
-        near + active_joint_model_start_index_[i], distance);
+  if (&active_joint_bounds == &active_joint_models_bounds_)
+  {
+    const FlatBoundsConstPtr flat_bounds = getFlatBounds();
+    for (std::size_t k = 0; k < bounded_variable_index_.size(); ++k)
+    {
+      const int v = bounded_variable_index_[k];
+      values[v] = rng.uniformReal(std::max(flat_bounds->min_[k], near[v] - distance),
+                                  std::min(flat_bounds->max_[k], near[v] + distance));
+    }
+    for (std::size_t k = 0; k < other_joint_index_.size(); ++k)
+    {
+      const std::size_t i = other_joint_index_[k];
+      active_joint_model_vector_[i]->getVariableRandomPositionsNearBy(
+          rng, values + active_joint_model_start_index_[i], *active_joint_bounds[i],
+          near + active_joint_model_start_index_[i], distance);
+    }
+  }
+  else
+    for (std::size_t i = 0; i < active_joint_model_vector_.size(); ++i)
+      active_joint_model_vector_[i]->getVariableRandomPositionsNearBy(
+          rng, values + active_joint_model_start_index_[i], *active_joint_bounds[i],
+          near + active_joint_model_start_index_[i], distance);
   updateMimicJoints(values);
 }
 
@@ -384,6 +496,32 @@ bool moveit::core::JointModelGroup::satisfiesPositionBounds(const double* state,
                                                             double margin) const
 {
   assert(active_joint_bounds.size() == active_joint_model_vector_.size());
+  if (&active_joint_bounds == &active_joint_models_bounds_)
+  {
+    const FlatBoundsConstPtr flat_bounds = getFlatBounds();
+    if (bounded_variables_contiguous_)
+    {
+      Eigen::Map<const Eigen::ArrayXd> bounded(state, bounded_variable_index_.size());
+      if (((bounded < flat_bounds->min_ - margin) || (bounded > flat_bounds->max_ + margin)).any())
+        return false;
+    }
+    else
+      for (std::size_t k = 0; k < bounded_variable_index_.size(); ++k)
+      {
+        const double v = state[bounded_variable_index_[k]];
+        if (v < flat_bounds->min_[k] - margin || v > flat_bounds->max_[k] + margin)
+          return false;
+      }
+    for (std::size_t k = 0; k < other_joint_index_.size(); ++k)
+    {
+      const std::size_t i = other_joint_index_[k];
+      if (!active_joint_model_vector_[i]->satisfiesPositionBounds(state + active_joint_model_start_index_[i],
+                                                                  *active_joint_bounds[i], margin))
+        return false;
+    }
+    return true;
+  }
+
   for (std::size_t i = 0; i < active_joint_model_vector_.size(); ++i)
     if (!active_joint_model_vector_[i]->satisfiesPositionBounds(state + active_joint_model_start_index_[i],
                                                                 *active_joint_bounds[i], margin))
@@ -396,10 +534,47 @@ bool moveit::core::JointModelGroup::enforcePositionBounds(double* state,
 {
   assert(active_joint_bounds.size() == active_joint_model_vector_.size());
   bool change = false;
-  for (std::size_t i = 0; i < active_joint_model_vector_.size(); ++i)
-    if (active_joint_model_vector_[i]->enforcePositionBounds(state + active_joint_model_start_index_[i],
-                                                             *active_joint_bounds[i]))
-      change = true;
+  if (&active_joint_bounds == &active_joint_models_bounds_)
+  {
+    const FlatBoundsConstPtr flat_bounds = getFlatBounds();
+    if (bounded_variables_contiguous_)
+    {
+      Eigen::Map<Eigen::ArrayXd> bounded(state, bounded_variable_index_.size());
+      if (((bounded < flat_bounds->min_) || (bounded > flat_bounds->max_)).any())
+      {
+        bounded = (bounded < flat_bounds->min_)
+                      .select(flat_bounds->min_, (bounded > flat_bounds->max_).select(flat_bounds->max_, bounded));
+        change = true;
+      }
+    }
+    else
+      for (std::size_t k = 0; k < bounded_variable_index_.size(); ++k)
+      {
+        double& v = state[bounded_variable_index_[k]];
+        if (v < flat_bounds->min_[k])
+        {
+          v = flat_bounds->min_[k];
+          change = true;
+        }
+        else if (v > flat_bounds->max_[k])
+        {
+          v = flat_bounds->max_[k];
+          change = true;
+        }
+      }
+    for (std::size_t k = 0; k < other_joint_index_.size(); ++k)
+    {
+      const std::size_t i = other_joint_index_[k];
+      if (active_joint_model_vector_[i]->enforcePositionBounds(state + active_joint_model_start_index_[i],
+                                                               *active_joint_bounds[i]))
+        change = true;
+    }
+  }
+  else
+    for (std::size_t i = 0; i < active_joint_model_vector_.size(); ++i)
+      if (active_joint_model_vector_[i]->enforcePositionBounds(state + active_joint_model_start_index_[i],
+                                                               *active_joint_bounds[i]))
+        change = true;
   if (change)
     updateMimicJoints(state);
   return change;
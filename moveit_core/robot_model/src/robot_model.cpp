@@ -39,11 +39,19 @@
 #include <geometric_shapes/shape_operations.h>
 #include <boost/math/constants/constants.hpp>
 #include <moveit/profiler/profiler.h>
+#include <ros/package.h>
+#include <boost/filesystem.hpp>
 #include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <limits>
 #include <queue>
 #include <cmath>
 #include <memory>
+#include <mutex>
 #include "order_robot_model_items.inc"
 
 /* ------------------------ RobotModel ------------------------ */
@@ -86,6 +94,7 @@ void moveit::core::RobotModel::buildModel(const urdf::ModelInterface& urdf_model
   root_link_ = NULL;
   link_geometry_count_ = 0;
   variable_count_ = 0;
+  variable_bounds_update_count_ = 0;
   model_name_ = urdf_model.getName();
   logInform("Loading robot model '%s'...", model_name_.c_str());
 
@@ -263,6 +272,7 @@ void moveit::core::RobotModel::buildJointInfo()
   for (std::size_t i = 0; i < joint_model_vector_.size(); ++i)
   {
     joint_model_vector_[i]->setJointIndex(i);
+    joint_model_vector_[i]->setVariableBoundsUpdateCounter(&variable_bounds_update_count_);
     const std::vector<std::string>& name_order = joint_model_vector_[i]->getVariableNames();
 
     // compute index map
@@ -960,6 +970,234 @@ static inline Eigen::Affine3d urdfPose2Affine3d(const urdf::Pose& pose)
   Eigen::Affine3d af(Eigen::Translation3d(pose.position.x, pose.position.y, pose.position.z) * q.toRotationMatrix());
   return af;
 }
+
+// Meshes loaded from resources, shared by all the robot models of the process that are still using them. Sharing
+// the shape instances also lets the collision checkers reuse the collision geometry they built for them.
+typedef std::map<std::pair<std::string, std::vector<double> >, std::weak_ptr<const shapes::Shape> > MeshCache;
+
+struct MeshCacheData
+{
+  std::mutex lock_;
+  MeshCache meshes_;
+};
+
+MeshCacheData& getMeshCache()
+{
+  static MeshCacheData cache;
+  return cache;
+}
+
+// Decoded meshes can also be kept on disk, in the directory named by the MOVEIT_MESH_CACHE_DIR environment variable,
+// so that other processes skip parsing the mesh files. A stored mesh is only used while its source file is unchanged.
+struct MeshFileHeader
+{
+  char magic_[8];
+  std::uint64_t source_size_;
+  std::int64_t source_time_;
+  double scale_[3];
+  std::uint32_t resource_length_;
+  std::uint32_t vertex_count_;
+  std::uint32_t triangle_count_;
+  std::uint32_t normals_;  // bit 0: triangle normals are stored, bit 1: vertex normals are stored
+};
+
+static const char MESH_FILE_MAGIC[8] = { 'M', 'O', 'V', 'E', 'M', 'S', 'H', '1' };
+
+// find the local file a mesh resource refers to; meshes from other resources are not kept on disk
+bool resolveMeshFile(const std::string& resource, std::string& path)
+{
+  static const std::string package_prefix = "package://";
+  static const std::string file_prefix = "file://";
+  if (resource.compare(0, package_prefix.size(), package_prefix) == 0)
+  {
+    std::size_t slash = resource.find('/', package_prefix.size());
+    if (slash == std::string::npos)
+      return false;
+    std::string package_path =
+        ros::package::getPath(resource.substr(package_prefix.size(), slash - package_prefix.size()));
+    if (package_path.empty())
+      return false;
+    path = package_path + resource.substr(slash);
+  }
+  else if (resource.compare(0, file_prefix.size(), file_prefix) == 0)
+    path = resource.substr(file_prefix.size());
+  else if (resource.find("://") == std::string::npos)
+    path = resource;
+  else
+    return false;
+  boost::system::error_code ec;
+  return boost::filesystem::is_regular_file(path, ec);
+}
+
+// fill in the header identifying the decoded mesh of \e resource, as long as its source file stays the same
+bool getMeshFileHeader(const std::string& resource, const Eigen::Vector3d& scale, MeshFileHeader& header)
+{
+  std::string path;
+  if (!resolveMeshFile(resource, path))
+    return false;
+  boost::system::error_code ec;
+  std::uintmax_t size = boost::filesystem::file_size(path, ec);
+  if (ec)
+    return false;
+  std::time_t time = boost::filesystem::last_write_time(path, ec);
+  if (ec)
+    return false;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic_, MESH_FILE_MAGIC, sizeof(header.magic_));
+  header.source_size_ = size;
+  header.source_time_ = time;
+  for (int i = 0; i < 3; ++i)
+    header.scale_[i] = scale[i];
+  header.resource_length_ = resource.size();
+  return true;
+}
+
+// name the file a mesh is stored in after a (FNV-1a) hash of the resource and scale
+std::string getMeshFileName(const std::string& directory, const std::string& resource, const Eigen::Vector3d& scale)
+{
+  std::uint64_t hash = 14695981039346656037ULL;
+  std::string key = resource;
+  key.append(reinterpret_cast<const char*>(scale.data()), 3 * sizeof(double));
+  for (std::size_t i = 0; i < key.size(); ++i)
+  {
+    hash ^= static_cast<unsigned char>(key[i]);
+    hash *= 1099511628211ULL;
+  }
+  char name[32];
+  snprintf(name, sizeof(name), "%016llx.mesh", static_cast<unsigned long long>(hash));
+  return (boost::filesystem::path(directory) / name).string();
+}
+
+shapes::Mesh* readMeshFile(const std::string& file_name, const std::string& resource, const MeshFileHeader& expected)
+{
+  std::ifstream in(file_name.c_str(), std::ios::binary);
+  if (!in)
+    return nullptr;
+  MeshFileHeader header;
+  if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+      std::memcmp(header.magic_, expected.magic_, sizeof(header.magic_)) != 0 ||
+      header.source_size_ != expected.source_size_ || header.source_time_ != expected.source_time_ ||
+      std::memcmp(header.scale_, expected.scale_, sizeof(header.scale_)) != 0 ||
+      header.resource_length_ != expected.resource_length_)
+    return nullptr;
+  std::string stored_resource(header.resource_length_, '\0');
+  if (!in.read(&stored_resource[0], stored_resource.size()) || stored_resource != resource)
+    return nullptr;
+
+  std::unique_ptr<shapes::Mesh> mesh(new shapes::Mesh(header.vertex_count_, header.triangle_count_));
+  in.read(reinterpret_cast<char*>(mesh->vertices), 3 * header.vertex_count_ * sizeof(double));
+  in.read(reinterpret_cast<char*>(mesh->triangles), 3 * header.triangle_count_ * sizeof(unsigned int));
+  if (header.normals_ & 1)
+  {
+    if (!mesh->triangle_normals)
+      mesh->triangle_normals = new double[3 * header.triangle_count_];
+    in.read(reinterpret_cast<char*>(mesh->triangle_normals), 3 * header.triangle_count_ * sizeof(double));
+  }
+  if (header.normals_ & 2)
+  {
+    if (!mesh->vertex_normals)
+      mesh->vertex_normals = new double[3 * header.vertex_count_];
+    in.read(reinterpret_cast<char*>(mesh->vertex_normals), 3 * header.vertex_count_ * sizeof(double));
+  }
+  if (!in)
+    return nullptr;
+  for (std::size_t i = 0; i < 3 * mesh->triangle_count; ++i)
+    if (mesh->triangles[i] >= mesh->vertex_count)
+      return nullptr;
+  return mesh.release();
+}
+
+// store the mesh under a temporary name first, so concurrent readers only ever see complete files
+void writeMeshFile(const std::string& file_name, const std::string& resource, const MeshFileHeader& stamp,
+                   const shapes::Mesh& mesh)
+{
+  MeshFileHeader header = stamp;
+  header.vertex_count_ = mesh.vertex_count;
+  header.triangle_count_ = mesh.triangle_count;
+  header.normals_ = (mesh.triangle_normals ? 1 : 0) | (mesh.vertex_normals ? 2 : 0);
+
+  boost::system::error_code ec;
+  boost::filesystem::path path(file_name);
+  boost::filesystem::create_directories(path.parent_path(), ec);
+  boost::filesystem::path tmp_path = path;
+  tmp_path += boost::filesystem::unique_path(".%%%%-%%%%-%%%%.tmp", ec);
+  {
+    std::ofstream out(tmp_path.string().c_str(), std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(resource.data(), resource.size());
+    out.write(reinterpret_cast<const char*>(mesh.vertices), 3 * mesh.vertex_count * sizeof(double));
+    out.write(reinterpret_cast<const char*>(mesh.triangles), 3 * mesh.triangle_count * sizeof(unsigned int));
+    if (mesh.triangle_normals)
+      out.write(reinterpret_cast<const char*>(mesh.triangle_normals), 3 * mesh.triangle_count * sizeof(double));
+    if (mesh.vertex_normals)
+      out.write(reinterpret_cast<const char*>(mesh.vertex_normals), 3 * mesh.vertex_count * sizeof(double));
+    out.close();
+    if (!out)
+    {
+      logWarn("Unable to store the mesh of '%s' in '%s'", resource.c_str(), file_name.c_str());
+      boost::filesystem::remove(tmp_path, ec);
+      return;
+    }
+  }
+  boost::filesystem::rename(tmp_path, path, ec);
+  if (ec)
+    boost::filesystem::remove(tmp_path, ec);
+}
+
+// decode a mesh resource, going through the on-disk cache if one is configured
+shapes::Mesh* decodeMeshResource(const std::string& resource, const Eigen::Vector3d& scale)
+{
+  const char* directory = std::getenv("MOVEIT_MESH_CACHE_DIR");
+  MeshFileHeader header;
+  if (!directory || !*directory || !getMeshFileHeader(resource, scale, header))
+    return shapes::createMeshFromResource(resource, scale);
+
+  std::string file_name = getMeshFileName(directory, resource, scale);
+  shapes::Mesh* mesh = readMeshFile(file_name, resource, header);
+  if (mesh)
+    return mesh;
+  mesh = shapes::createMeshFromResource(resource, scale);
+  if (mesh)
+    writeMeshFile(file_name, resource, header, *mesh);
+  return mesh;
+}
+
+shapes::ShapeConstPtr loadMeshFromResource(const std::string& filename, const Eigen::Vector3d& scale)
+{
+  std::vector<double> scale_key(scale.data(), scale.data() + 3);
+  MeshCache::key_type key(filename, scale_key);
+  MeshCacheData& cache = getMeshCache();
+  {
+    std::lock_guard<std::mutex> slock(cache.lock_);
+    MeshCache::iterator it = cache.meshes_.find(key);
+    if (it != cache.meshes_.end())
+    {
+      shapes::ShapeConstPtr mesh = it->second.lock();
+      if (mesh)
+        return mesh;
+    }
+  }
+
+  // load the mesh outside the lock; if another thread loaded the same mesh meanwhile, its copy is used instead
+  shapes::ShapeConstPtr mesh(decodeMeshResource(filename, scale));
+  if (!mesh)
+    return mesh;
+
+  std::lock_guard<std::mutex> slock(cache.lock_);
+  std::weak_ptr<const shapes::Shape>& cached = cache.meshes_[key];
+  shapes::ShapeConstPtr other = cached.lock();
+  if (other)
+    return other;
+  cached = mesh;
+
+  // drop the entries of meshes no robot model uses anymore
+  for (MeshCache::iterator it = cache.meshes_.begin(); it != cache.meshes_.end();)
+    if (it->second.expired())
+      cache.meshes_.erase(it++);
+    else
+      ++it;
+  return mesh;
+}
 }
 
 moveit::core::LinkModel* moveit::core::RobotModel::constructLinkModel(const urdf::Link* urdf_link)
@@ -1030,7 +1268,7 @@ moveit::core::LinkModel* moveit::core::RobotModel::constructLinkModel(const urdf
   return result;
 }
 
-shapes::ShapePtr moveit::core::RobotModel::constructShape(const urdf::Geometry* geom)
+shapes::ShapeConstPtr moveit::core::RobotModel::constructShape(const urdf::Geometry* geom)
 {
   moveit::tools::Profiler::ScopedBlock prof_block("RobotModel::constructShape");
 
@@ -1056,8 +1294,7 @@ shapes::ShapePtr moveit::core::RobotModel::constructShape(const urdf::Geometry*
       if (!mesh->filename.empty())
       {
         Eigen::Vector3d scale(mesh->scale.x, mesh->scale.y, mesh->scale.z);
-        shapes::Mesh* m = shapes::createMeshFromResource(mesh->filename, scale);
-        result = m;
+        return loadMeshFromResource(mesh->filename, scale);
       }
     }
     break;
@@ -1066,7 +1303,7 @@ shapes::ShapePtr moveit::core::RobotModel::constructShape(const urdf::Geometry*
       break;
   }
 
-  return shapes::ShapePtr(result);
+  return shapes::ShapeConstPtr(result);
 }
 
 bool moveit::core::RobotModel::hasJointModel(const std::string& name) const
@@ -36,9 +36,12 @@
 
 #include <moveit/robot_model/robot_model.h>
 #include <urdf_parser/urdf_parser.h>
+#include <cstdlib>
 #include <fstream>
+#include <set>
 #include <gtest/gtest.h>
 #include <boost/filesystem/path.hpp>
+#include <boost/filesystem/operations.hpp>
 #include <moveit/profiler/profiler.h>
 #include <moveit_resources/config.h>
 
@@ -102,6 +105,133 @@ TEST_F(LoadPlanningModelsPr2, Model)
   moveit::tools::Profiler::Status();
 }
 
+TEST_F(LoadPlanningModelsPr2, SharedMeshes)
+{
+  // a second model of the same robot reuses the meshes the first one loaded
+  moveit::core::RobotModel other_model(urdf_model, srdf_model);
+  const std::vector<const moveit::core::LinkModel*>& links = robot_model->getLinkModels();
+  for (std::size_t i = 0; i < links.size(); ++i)
+  {
+    const moveit::core::LinkModel* other_link = other_model.getLinkModel(links[i]->getName());
+    ASSERT_EQ(links[i]->getShapes().size(), other_link->getShapes().size());
+    for (std::size_t j = 0; j < links[i]->getShapes().size(); ++j)
+      if (links[i]->getShapes()[j]->type == shapes::MESH)
+        EXPECT_EQ(links[i]->getShapes()[j], other_link->getShapes()[j]);
+      else
+        EXPECT_NE(links[i]->getShapes()[j], other_link->getShapes()[j]);
+  }
+}
+
+TEST_F(LoadPlanningModelsPr2, StoredMeshes)
+{
+  // meshes decoded while MOVEIT_MESH_CACHE_DIR is set are stored there and read back by later models
+  boost::filesystem::path cache_dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+  setenv("MOVEIT_MESH_CACHE_DIR", cache_dir.string().c_str(), 1);
+  robot_model.reset();
+
+  std::vector<shapes::ShapePtr> decoded;
+  {
+    moveit::core::RobotModel model(urdf_model, srdf_model);
+    const std::vector<const moveit::core::LinkModel*>& links = model.getLinkModels();
+    for (std::size_t i = 0; i < links.size(); ++i)
+      for (std::size_t j = 0; j < links[i]->getShapes().size(); ++j)
+        if (links[i]->getShapes()[j]->type == shapes::MESH)
+          decoded.push_back(shapes::ShapePtr(links[i]->getShapes()[j]->clone()));
+  }
+  ASSERT_FALSE(decoded.empty());
+  EXPECT_FALSE(boost::filesystem::is_empty(cache_dir));
+
+  moveit::core::RobotModel stored_model(urdf_model, srdf_model);
+  unsetenv("MOVEIT_MESH_CACHE_DIR");
+  std::size_t k = 0;
+  const std::vector<const moveit::core::LinkModel*>& links = stored_model.getLinkModels();
+  for (std::size_t i = 0; i < links.size(); ++i)
+    for (std::size_t j = 0; j < links[i]->getShapes().size(); ++j)
+      if (links[i]->getShapes()[j]->type == shapes::MESH)
+      {
+        ASSERT_LT(k, decoded.size());
+        const shapes::Mesh* expected = static_cast<const shapes::Mesh*>(decoded[k++].get());
+        const shapes::Mesh* mesh = static_cast<const shapes::Mesh*>(links[i]->getShapes()[j].get());
+        ASSERT_EQ(expected->vertex_count, mesh->vertex_count);
+        ASSERT_EQ(expected->triangle_count, mesh->triangle_count);
+        for (unsigned int v = 0; v < 3 * mesh->vertex_count; ++v)
+          EXPECT_EQ(expected->vertices[v], mesh->vertices[v]);
+        for (unsigned int t = 0; t < 3 * mesh->triangle_count; ++t)
+          EXPECT_EQ(expected->triangles[t], mesh->triangles[t]);
+      }
+  EXPECT_EQ(k, decoded.size());
+  boost::filesystem::remove_all(cache_dir);
+}
+
+TEST_F(LoadPlanningModelsPr2, CommonRoots)
+{
+  // the precomputed common roots match those found by walking up the tree
+  const std::vector<const moveit::core::JointModel*>& joints = robot_model->getJointModels();
+  for (std::size_t i = 0; i < joints.size(); ++i)
+  {
+    std::set<const moveit::core::JointModel*> ancestors;
+    const moveit::core::JointModel* a = joints[i];
+    while (a)
+    {
+      ancestors.insert(a);
+      a = a->getParentLinkModel() ? a->getParentLinkModel()->getParentJointModel() : NULL;
+    }
+    for (std::size_t j = 0; j < joints.size(); ++j)
+    {
+      const moveit::core::JointModel* b = joints[j];
+      while (!ancestors.count(b))
+        b = b->getParentLinkModel()->getParentJointModel();
+      EXPECT_EQ(b, robot_model->getCommonRoot(joints[i], joints[j]))
+          << joints[i]->getName() << ", " << joints[j]->getName();
+    }
+  }
+}
+
+TEST_F(LoadPlanningModelsPr2, GroupBounds)
+{
+  moveit::core::RobotModelPtr model(new moveit::core::RobotModel(urdf_model, srdf_model));
+
+  // samples drawn at once are the same as samples drawn one by one, and are within bounds
+  const std::vector<const moveit::core::JointModelGroup*>& groups = robot_model->getJointModelGroups();
+  for (std::size_t g = 0; g < groups.size(); ++g)
+  {
+    const std::size_t n = groups[g]->getVariableCount();
+    random_numbers::RandomNumberGenerator rng_batch(42), rng_single(42);
+    std::vector<double> batch, single;
+    groups[g]->getVariableRandomPositions(rng_batch, batch, 10);
+    ASSERT_EQ(10 * n, batch.size());
+    for (std::size_t s = 0; s < 10; ++s)
+    {
+      groups[g]->getVariableRandomPositions(rng_single, single);
+      for (std::size_t i = 0; i < n; ++i)
+        EXPECT_NEAR(single[i], batch[s * n + i], 1e-12) << groups[g]->getName();
+      EXPECT_TRUE(groups[g]->satisfiesPositionBounds(&batch[s * n])) << groups[g]->getName();
+    }
+  }
+
+  const moveit::core::JointModelGroup* jmg = model->getJointModelGroup("right_arm");
+  random_numbers::RandomNumberGenerator rng(42);
+  std::vector<double> values;
+  jmg->getVariableRandomPositions(rng, values);
+  const int index = jmg->getVariableGroupIndex("r_elbow_flex_joint");
+  const moveit::core::VariableBounds bounds = model->getVariableBounds("r_elbow_flex_joint");
+
+  values[index] = bounds.max_position_ + 1.0;
+  EXPECT_FALSE(jmg->satisfiesPositionBounds(&values[0]));
+  EXPECT_TRUE(jmg->satisfiesPositionBounds(&values[0], 1.5));
+  EXPECT_TRUE(jmg->enforcePositionBounds(&values[0]));
+  EXPECT_EQ(bounds.max_position_, values[index]);
+  EXPECT_FALSE(jmg->enforcePositionBounds(&values[0]));
+
+  // the group notices bounds that are set after it was constructed
+  moveit::core::VariableBounds wider = bounds;
+  wider.max_position_ += 2.0;
+  model->getJointModel("r_elbow_flex_joint")->setVariableBounds("r_elbow_flex_joint", wider);
+  values[index] = bounds.max_position_ + 1.0;
+  EXPECT_TRUE(jmg->satisfiesPositionBounds(&values[0]));
+  EXPECT_FALSE(jmg->enforcePositionBounds(&values[0]));
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,154 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2026, the MoveIt contributors
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the copyright holder nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+#ifndef MOVEIT_ROBOT_STATE_BATCH_ROBOT_STATE_
+#define MOVEIT_ROBOT_STATE_BATCH_ROBOT_STATE_
+
+#include <moveit/robot_state/robot_state.h>
+
+namespace moveit
+{
+namespace core
+{
+MOVEIT_CLASS_FORWARD(BatchRobotState);
+
+/** @brief Forward kinematics for the links of a joint model group, computed for many configurations of the group at
+    once.
+
+    The global transforms of the links updated by the group are stored as a structure of arrays: for each link, each of
+    the 12 entries of the top 3x4 part of its transform is stored contiguously for all the configurations of the batch.
+    Joint transforms and their products are computed in loops that run over the batch, so the compiler can vectorize
+    them. This is much faster than setting each configuration in a RobotState and calling RobotState::update(). */
+class BatchRobotState
+{
+public:
+  /** \brief Construct the batch computation for the variables of \e group. The values of all other variables of the
+      robot, and the transforms of the links that are not updated by \e group, are taken from \e reference_state */
+  BatchRobotState(const RobotState& reference_state, const JointModelGroup* group);
+
+  const JointModelGroup* getJointModelGroup() const
+  {
+    return group_;
+  }
+
+  /** \brief Get the number of configurations passed to the last call of computeFKBatch() */
+  std::size_t getBatchSize() const
+  {
+    return batch_size_;
+  }
+
+  /** \brief Compute the transforms of the links updated by the group for \e count configurations. \e positions holds
+      the \e count configurations one after the other, each as the values of the variables of the group in the order
+      of JointModelGroup::getVariableNames(). Mimic joints follow the joints they mimic. */
+  void computeFKBatch(const double* positions, std::size_t count);
+
+  /** \brief Check if the transform of \e link is computed by this batch */
+  bool isLinkUpdated(const LinkModel* link) const
+  {
+    return link_update_index_[link->getLinkIndex()] >= 0;
+  }
+
+  /** \brief Get the global transform of \e link for configuration \e index of the last batch. Links that are not
+      updated by the group have the transform they had in the reference state. */
+  Eigen::Affine3d getGlobalLinkTransform(const LinkModel* link, std::size_t index) const;
+
+  /** \brief Get the global transform of the link named \e link for configuration \e index of the last batch */
+  Eigen::Affine3d getGlobalLinkTransform(const std::string& link, std::size_t index) const
+  {
+    return getGlobalLinkTransform(group_->getParentModel().getLinkModel(link), index);
+  }
+
+  /** \brief Get the transforms of \e link for all the configurations of the last batch, or NULL if \e link is not
+      updated by the group. Entry (\e row, \e col) of the transform for configuration \e i is at position
+      (4 * \e row + \e col) * getBatchSize() + \e i. */
+  const double* getGlobalLinkTransformBlock(const LinkModel* link) const
+  {
+    int index = link_update_index_[link->getLinkIndex()];
+    return index < 0 ? NULL : &transforms_[12 * batch_size_ * index];
+  }
+
+private:
+  /** \brief Where the value of a joint variable comes from: the variable of the group at \e group_index_, or the
+      constant \e value_ if that index is negative. The value is then scaled by \e factor_ and offset by \e offset_,
+      which handles mimic joints. */
+  struct VariableSource
+  {
+    int group_index_;
+    double value_;
+    double factor_;
+    double offset_;
+  };
+
+  struct LinkUpdate
+  {
+    const LinkModel* link_;
+
+    /// Index in link_updates_ of the parent link, or -1 if the transform of the parent link is constant
+    int parent_;
+
+    /// The joint origin transform, premultiplied by the global transform of the parent link if that is constant
+    /// (row major, top 3x4 part)
+    double origin_[12];
+
+    std::vector<VariableSource> variables_;
+  };
+
+  void computeJointTransforms(const LinkUpdate& update, const double* positions, double* out) const;
+
+  const JointModelGroup* group_;
+
+  /// The variables of the group are the first variable_count_ values of each configuration
+  std::size_t variable_count_;
+
+  std::vector<LinkUpdate> link_updates_;
+
+  /// For each link of the robot model, the index of its entry in link_updates_, or -1 if the link is not updated
+  std::vector<int> link_update_index_;
+
+  /// The global transforms of all links, as in the reference state
+  EigenSTL::vector_Affine3d reference_transforms_;
+
+  std::size_t batch_size_;
+
+  /// 12 * batch_size_ values for every entry of link_updates_
+  std::vector<double> transforms_;
+
+  /// Scratch space for the transforms of a single joint over the batch
+  std::vector<double> joint_transforms_;
+  std::vector<double> local_transforms_;
+};
+}
+}
+
+#endif
@@ -0,0 +1,139 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2026, the MoveIt contributors
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the copyright holder nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+#ifndef MOVEIT_ROBOT_STATE_CARTESIAN_SERVO_
+#define MOVEIT_ROBOT_STATE_CARTESIAN_SERVO_
+
+#include <moveit/robot_state/robot_state.h>
+#include <Eigen/Eigenvalues>
+
+namespace moveit
+{
+namespace core
+{
+MOVEIT_CLASS_FORWARD(CartesianServo);
+
+/** @brief Turns a stream of twists for the tip link of a chain into joint velocities and positions.
+
+    This is meant for teleoperation and visual servoing at the rate of the controllers. All the storage is allocated
+    when the servo is constructed, so computing a command does not allocate memory. The pseudo-inverse of the
+    Jacobian is damped, and the commanded velocity is scaled down without changing its direction as the chain gets
+    close to a singularity, a position limit or an obstacle, and to respect the velocity limits. Obstacles are
+    reported by an optional proximity function, which update() evaluates once per command, so the time taken by a
+    command is bounded if that function is (e.g. a query of a distance field). */
+class CartesianServo
+{
+public:
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+  /** \brief Function returning the distance between the robot in \e state and the nearest obstacle */
+  typedef boost::function<double(const RobotState& state)> ProximityFn;
+
+  /** \brief Construct a servo for \e tip, which must be a link of the chain \e group */
+  CartesianServo(const JointModelGroup* group, const LinkModel* tip);
+
+  const JointModelGroup* getGroup() const
+  {
+    return group_;
+  }
+
+  const LinkModel* getTip() const
+  {
+    return tip_;
+  }
+
+  /** \brief Set the damping of the pseudo-inverse. Larger values trade tracking accuracy for smaller velocities close
+      to singularities (default 0.01) */
+  void setDamping(double damping);
+
+  /** \brief Scale the velocity down linearly as the smallest singular value of the Jacobian decreases from \e slowdown
+      to \e stop (defaults 0.05 and 0.01) */
+  void setSingularityThresholds(double slowdown, double stop);
+
+  /** \brief Scale motion towards a position limit down linearly within \e margin of the limit (default 0.1) */
+  void setJointLimitMargin(double margin);
+
+  /** \brief Scale the velocity down linearly as the distance returned by \e fn decreases from \e slowdown to \e stop.
+      Commands that would take the robot closer than \e stop to an obstacle are rejected by update(), so motion away
+      from obstacles remains possible. An empty function disables the check. */
+  void setProximityFunction(const ProximityFn& fn, double slowdown, double stop);
+
+  /** \brief Compute the joint velocities \e qdot of the group for \e twist, the velocity of the tip in its own frame.
+      The transforms of \e state must be up to date. Returns the factor in [0, 1] the velocity was scaled by; 0 means
+      the servo stopped. \e qdot is only resized if it does not have one element per variable of the group. */
+  double computeJointVelocity(const RobotState& state, const Eigen::Matrix<double, 6, 1>& twist,
+                              Eigen::VectorXd& qdot);
+
+  /** \brief Compute the joint velocities for \e twist, also accounting for obstacles, and apply them to \e state for
+      \e dt seconds. The transforms of \e state must be up to date, and are updated again. Returns the factor the
+      velocity was scaled by, as computeJointVelocity() does. The velocities applied are available from
+      getJointVelocity(). */
+  double update(RobotState& state, const Eigen::Matrix<double, 6, 1>& twist, double dt);
+
+  /** \brief Get the joint velocities applied by the last call to update() */
+  const Eigen::VectorXd& getJointVelocity() const
+  {
+    return qdot_;
+  }
+
+private:
+  const JointModelGroup* group_;
+  const LinkModel* tip_;
+
+  double damping_;
+  double singularity_slowdown_;
+  double singularity_stop_;
+  double joint_limit_margin_;
+
+  ProximityFn proximity_fn_;
+  double proximity_slowdown_;
+  double proximity_stop_;
+  /// The distance to the nearest obstacle at the state the last update() produced; NaN if not known
+  double distance_;
+
+  /// The bounds of each variable of the group
+  std::vector<const VariableBounds*> bounds_;
+
+  Eigen::MatrixXd jacobian_;
+  Eigen::Matrix<double, 6, 6> jjt_;
+  Eigen::SelfAdjointEigenSolver<Eigen::Matrix<double, 6, 6> > eigen_solver_;
+  Eigen::Matrix<double, 6, 1> task_;
+  Eigen::VectorXd positions_;
+  Eigen::VectorXd next_positions_;
+  Eigen::VectorXd qdot_;
+};
+}
+}
+
+#endif
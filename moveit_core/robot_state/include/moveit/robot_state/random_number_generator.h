@@ -0,0 +1,61 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2026, the MoveIt contributors
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the copyright holder nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+#ifndef MOVEIT_ROBOT_STATE_RANDOM_NUMBER_GENERATOR_
+#define MOVEIT_ROBOT_STATE_RANDOM_NUMBER_GENERATOR_
+
+#include <random_numbers/random_numbers.h>
+#include <boost/cstdint.hpp>
+
+namespace moveit
+{
+namespace core
+{
+/** \brief Get the random number generator of the calling thread.
+
+    The generator is constructed the first time a thread asks for it, and seeded like any
+    random_numbers::RandomNumberGenerator unless seedThreadRandomNumberGenerator() was called. Code that needs random
+    numbers and does not get a generator from its caller should use this one: it avoids constructing a generator for
+    every state, sampler or solver, is safe to use from several threads, and makes runs reproducible once seeded. */
+random_numbers::RandomNumberGenerator& getThreadRandomNumberGenerator();
+
+/** \brief Replace the random number generator of the calling thread with one seeded with \e seed, e.g. at the start of
+    a planning request, so that the samples drawn on this thread can be reproduced. References returned by
+    getThreadRandomNumberGenerator() on this thread before the call are no longer valid. The OMPL planning contexts
+    call this on every thread of a request when their random_seed parameter is set. */
+void seedThreadRandomNumberGenerator(boost::uint32_t seed);
+}
+}
+
+#endif
@@ -40,11 +40,13 @@
 
 #include <moveit/robot_model/robot_model.h>
 #include <moveit/robot_state/attached_body.h>
+#include <moveit/robot_state/random_number_generator.h>
 #include <sensor_msgs/JointState.h>
 #include <visualization_msgs/MarkerArray.h>
 #include <std_msgs/ColorRGBA.h>
 #include <geometry_msgs/Twist.h>
 #include <cassert>
+#include <cstring>
 
 #include <boost/assert.hpp>
 
@@ -62,6 +64,11 @@ typedef boost::function<bool(RobotState* robot_state, const JointModelGroup* joi
                              const double* joint_group_variable_values)>
     GroupStateValidityCallbackFn;
 
+/** \brief Signature for functions that verify a sequence of \e states of the group \e joint_group at once, e.g. with a
+    batched collision check. Returns the index of the first invalid state, or states.size() if all states are valid */
+typedef boost::function<std::size_t(const std::vector<const RobotState*>& states, const JointModelGroup* joint_group)>
+    GroupStatesValidityCallbackFn;
+
 /** \brief Representation of a robot's state. This includes position,
     velocity, acceleration and effort.
 
@@ -1159,6 +1166,22 @@ as the new values that correspond to the group */
                               const GroupStateValidityCallbackFn& validCallback = GroupStateValidityCallbackFn(),
                               const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions());
 
+  /** \brief Compute the sequence of joint values that perform a general Cartesian path, validating all the computed
+      states with a single call of \e validCallback.
+
+      This behaves like computeCartesianPath() for a set of \e waypoints, but IK is solved for all the waypoints first,
+      each solution seeding the next one, and the resulting states are checked together afterwards. This allows
+      expensive checks such as collision checking to be batched. The path is truncated before the first state found
+      invalid, or before the first jump in joint space (see \e jump_threshold). Since IK does not see \e validCallback,
+      the solver cannot look for an alternative solution when a state is invalid. Each segment starts at the pose the
+      previous one targeted. */
+  double computeCartesianPathBatch(const JointModelGroup* group, std::vector<RobotStatePtr>& traj,
+                                   const LinkModel* link, const EigenSTL::vector_Affine3d& waypoints,
+                                   bool global_reference_frame, double max_step, double jump_threshold,
+                                   const GroupStatesValidityCallbackFn& validCallback = GroupStatesValidityCallbackFn(),
+                                   const kinematics::KinematicsQueryOptions& options =
+                                       kinematics::KinematicsQueryOptions());
+
   /** \brief Compute the Jacobian with reference to a particular point on a given link, for a specified group.
    * \param group The group to compute the Jacobian for
    * \param link_name The name of the link
@@ -1171,6 +1194,16 @@ as the new values that correspond to the group */
   bool getJacobian(const JointModelGroup* group, const LinkModel* link, const Eigen::Vector3d& reference_point_position,
                    Eigen::MatrixXd& jacobian, bool use_quaternion_representation = false) const;
 
+  /** \brief Compute the Jacobian of a group with 6 variables with reference to a particular point on a given link.
+   * The fixed-size matrix avoids heap allocations. Returns false if the group does not have 6 variables. */
+  bool getJacobian(const JointModelGroup* group, const LinkModel* link, const Eigen::Vector3d& reference_point_position,
+                   Eigen::Matrix<double, 6, 6>& jacobian) const;
+
+  /** \brief Compute the Jacobian of a group with 7 variables with reference to a particular point on a given link.
+   * The fixed-size matrix avoids heap allocations. Returns false if the group does not have 7 variables. */
+  bool getJacobian(const JointModelGroup* group, const LinkModel* link, const Eigen::Vector3d& reference_point_position,
+                   Eigen::Matrix<double, 6, 7>& jacobian) const;
+
   /** \brief Compute the Jacobian with reference to a particular point on a given link, for a specified group.
    * \param group The group to compute the Jacobian for
    * \param link_name The name of the link
@@ -1211,7 +1244,8 @@ as the new values that correspond to the group */
   }
 
   /** \brief Given a twist for a particular link (\e tip), compute the corresponding velocity for every variable and
-   * store it in \e qdot */
+   * store it in \e qdot. For groups with 6 or 7 variables, nothing is allocated on the heap if \e qdot already has
+   * the right size. */
   void computeVariableVelocity(const JointModelGroup* jmg, Eigen::VectorXd& qdot, const Eigen::VectorXd& twist,
                                const LinkModel* tip) const;
 
@@ -1296,6 +1330,11 @@ as the new values that correspond to the group */
   /** \brief Update all transforms. */
   void update(bool force = false);
 
+  /** \brief Update the global transform of \e link, computing only the out of date transforms on the path from the
+      root of the model to \e link. The transforms of other links remain out of date until the next full update, but
+      the transform of \e link (and its ancestors) can be read from a const state in the meantime. */
+  void updateLinkTransformChain(const LinkModel* link);
+
   /** \brief Update the state after setting a particular link to the input global transform pose.*/
   void updateStateWithLinkAt(const std::string& link_name, const Eigen::Affine3d& transform, bool backward = false)
   {
@@ -1351,7 +1390,7 @@ as the new values that correspond to the group */
 
   const Eigen::Affine3d& getGlobalLinkTransform(const LinkModel* link) const
   {
-    BOOST_VERIFY(checkLinkTransforms());
+    BOOST_VERIFY(checkLinkTransform(link));
     return global_link_transforms_[link->getLinkIndex()];
   }
 
@@ -1387,11 +1426,36 @@ as the new values that correspond to the group */
     return dirty_link_transforms_;
   }
 
+  /** \brief Check whether the global transform of \e link is out of date (see updateLinkTransformChain()) */
+  bool dirtyLinkTransform(const LinkModel* link) const
+  {
+    if (dirty_link_transforms_ == NULL)
+      return false;
+    for (; link; link = link->getParentLinkModel())
+      if (dirty_link_flags_[link->getLinkIndex()])
+        return true;
+    return false;
+  }
+
   bool dirtyCollisionBodyTransforms() const
   {
     return dirty_link_transforms_ || dirty_collision_body_transforms_;
   }
 
+  /** \brief Get the number of link transforms computed by this instance so far. Updates only recompute the links
+      affected by the joints that changed, so this measures the cost of the updates. */
+  std::size_t getLinkTransformUpdateCount() const
+  {
+    return link_transform_update_count_;
+  }
+
+  /** \brief Get the number of collision body transforms computed by this instance so far (see
+      getLinkTransformUpdateCount()) */
+  std::size_t getCollisionBodyTransformUpdateCount() const
+  {
+    return collision_body_transform_update_count_;
+  }
+
   /** \brief Returns true if anything in this state is dirty */
   bool dirty() const
   {
@@ -1592,6 +1656,12 @@ as the new values that correspond to the group */
   /** \brief Check if an attached body named \e id exists in this state */
   bool hasAttachedBody(const std::string& id) const;
 
+  /** \brief Check if any bodies are attached to this state */
+  bool hasAttachedBodies() const
+  {
+    return !attached_body_map_.empty();
+  }
+
   void setAttachedBodyUpdateCallback(const AttachedBodyCallback& callback);
   /** @} */
 
@@ -1607,12 +1677,11 @@ as the new values that correspond to the group */
     static_cast<const RobotState*>(this)->computeAABB(aabb);
   }
 
-  /** \brief Return the instance of a random number generator */
+  /** \brief Return the random number generator used by this state, which is the generator of the calling thread
+      (see getThreadRandomNumberGenerator()) */
   random_numbers::RandomNumberGenerator& getRandomNumberGenerator()
   {
-    if (!rng_)
-      rng_ = new random_numbers::RandomNumberGenerator();
-    return *rng_;
+    return getThreadRandomNumberGenerator();
   }
 
   /** \brief Get the transformation matrix from the model frame to the frame identified by \e id */
@@ -1624,6 +1693,10 @@ as the new values that correspond to the group */
   /** \brief Check if a transformation matrix from the model frame to frame \e id is known */
   bool knowsFrameTransform(const std::string& id) const;
 
+  /** \brief Find the transformation matrix from the model frame to the frame identified by \e id with a single lookup.
+      Return NULL if the frame is not known. The pointer stays valid until bodies are attached or detached */
+  const Eigen::Affine3d* findFrameTransform(const std::string& id) const;
+
   /** @brief Get a MarkerArray that fully describes the robot markers for a given robot.
    *  @param arr The returned marker array
    *  @param link_names The list of link names for which the markers should be created.
@@ -1681,6 +1754,9 @@ as the new values that correspond to the group */
   std::string getStateTreeString(const std::string& prefix = "") const;
 
 private:
+  // resets the flags of the states it recycles
+  friend class RobotStatePool;
+
   void allocMemory();
 
   void copyFrom(const RobotState& other);
@@ -1688,6 +1764,7 @@ private:
   void markDirtyJointTransforms(const JointModel* joint)
   {
     dirty_joint_transforms_[joint->getJointIndex()] = 1;
+    dirty_link_flags_[joint->getChildLinkModel()->getLinkIndex()] = 1;
     dirty_link_transforms_ =
         dirty_link_transforms_ == NULL ? joint : robot_model_->getCommonRoot(dirty_link_transforms_, joint);
   }
@@ -1696,12 +1773,25 @@ private:
   {
     const std::vector<const JointModel*>& jm = group->getActiveJointModels();
     for (std::size_t i = 0; i < jm.size(); ++i)
+    {
       dirty_joint_transforms_[jm[i]->getJointIndex()] = 1;
+      dirty_link_flags_[jm[i]->getChildLinkModel()->getLinkIndex()] = 1;
+    }
     dirty_link_transforms_ = dirty_link_transforms_ == NULL ?
                                  group->getCommonRoot() :
                                  robot_model_->getCommonRoot(dirty_link_transforms_, group->getCommonRoot());
   }
 
+  void markDirtyAllTransforms()
+  {
+    memset(dirty_joint_transforms_, 1, robot_model_->getJointModelCount() * sizeof(unsigned char));
+    memset(dirty_link_flags_, 1, robot_model_->getLinkModelCount() * sizeof(unsigned char));
+    dirty_link_transforms_ = robot_model_->getRootJoint();
+  }
+
+  /** \brief Check that the Jacobian of \e group can be computed for \e link */
+  bool checkJacobianInputs(const JointModelGroup* group, const LinkModel* link) const;
+
   void markVelocity();
   void markAcceleration();
   void markEffort();
@@ -1714,6 +1804,7 @@ private:
     {
       position_[mim[i]->getFirstVariableIndex()] = mim[i]->getMimicFactor() * v + mim[i]->getMimicOffset();
       dirty_joint_transforms_[mim[i]->getJointIndex()] = 1;
+      dirty_link_flags_[mim[i]->getChildLinkModel()->getLinkIndex()] = 1;
     }
   }
 
@@ -1726,11 +1817,15 @@ private:
       position_[fvi] =
           mim[i]->getMimicFactor() * position_[mim[i]->getMimic()->getFirstVariableIndex()] + mim[i]->getMimicOffset();
       dirty_joint_transforms_[mim[i]->getJointIndex()] = 1;
+      dirty_link_flags_[mim[i]->getChildLinkModel()->getLinkIndex()] = 1;
     }
   }
 
   void updateLinkTransformsInternal(const JointModel* start);
 
+  /** \brief Recompute the global transform of \e link from the one of its parent and mark its children out of date */
+  void computeLinkTransform(const LinkModel* link);
+
   void getMissingKeys(const std::map<std::string, double>& variable_map,
                       std::vector<std::string>& missing_variables) const;
   void getStateTreeJointString(std::ostream& ss, const JointModel* jm, const std::string& pfx0, bool last) const;
@@ -1741,6 +1836,9 @@ private:
   /** \brief This function is only called in debug mode */
   bool checkLinkTransforms() const;
 
+  /** \brief This function is only called in debug mode */
+  bool checkLinkTransform(const LinkModel* link) const;
+
   /** \brief This function is only called in debug mode */
   bool checkCollisionTransforms() const;
 
@@ -1758,24 +1856,26 @@ private:
   const JointModel* dirty_link_transforms_;
   const JointModel* dirty_collision_body_transforms_;
 
+  /// Number of link transforms and collision body transforms computed by this instance
+  std::size_t link_transform_update_count_;
+  std::size_t collision_body_transform_update_count_;
+
   Eigen::Affine3d* variable_joint_transforms_;         // this points to an element in transforms_, so it is aligned
   Eigen::Affine3d* global_link_transforms_;            // this points to an element in transforms_, so it is aligned
   Eigen::Affine3d* global_collision_body_transforms_;  // this points to an element in transforms_, so it is aligned
   unsigned char* dirty_joint_transforms_;
 
+  /// Within the subtrees marked dirty above, only the links with these flags set are updated (indexed by link index):
+  /// the link transform needs to be recomputed, or the transforms of its collision bodies do
+  unsigned char* dirty_link_flags_;
+  unsigned char* dirty_collision_body_flags_;
+
   /** \brief All attached bodies that are part of this state, indexed by their name */
   std::map<std::string, AttachedBody*> attached_body_map_;
 
   /** \brief This event is called when there is a change in the attached bodies for this state;
       The event specifies the body that changed and whether it was just attached or about to be detached. */
   AttachedBodyCallback attached_body_update_callback_;
-
-  /** \brief For certain operations a state needs a random number generator. However, it may be slightly expensive
-      to allocate the random number generator if many state instances are generated. For this reason, the generator
-      is allocated on a need basis, by the getRandomNumberGenerator() function. Never use the rng_ member directly, but
-     call
-      getRandomNumberGenerator() instead. */
-  random_numbers::RandomNumberGenerator* rng_;
 };
 
 /** \brief Operator overload for printing variable bounds to a stream */
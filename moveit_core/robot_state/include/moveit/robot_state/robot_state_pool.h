@@ -0,0 +1,95 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2026, the MoveIt contributors
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the copyright holder nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+#ifndef MOVEIT_ROBOT_STATE_ROBOT_STATE_POOL_
+#define MOVEIT_ROBOT_STATE_ROBOT_STATE_POOL_
+
+#include <moveit/robot_state/robot_state.h>
+
+namespace moveit
+{
+namespace core
+{
+MOVEIT_CLASS_FORWARD(RobotStatePool);
+
+/** @brief A pool of RobotState instances for one robot model.
+
+    The states handed out by the pool return to it when the last pointer to them is released, instead of being freed.
+    Once the pool holds enough states, getting a state from it does not allocate the memory for variables and
+    transforms, and copying a state into it is done in place. This is useful for code that creates and drops many
+    states, such as trajectory construction. The pool is thread safe, and states may outlive the pool. */
+class RobotStatePool
+{
+public:
+  /** \brief Construct a pool for states of \e robot_model that keeps at most \e max_size unused states */
+  RobotStatePool(const RobotModelConstPtr& robot_model, std::size_t max_size = 1024);
+  ~RobotStatePool();
+
+  const RobotModelConstPtr& getRobotModel() const
+  {
+    return robot_model_;
+  }
+
+  /** \brief Get a state from the pool. The values of its variables are unspecified, it has no velocities,
+      accelerations or efforts, and its transforms are dirty, even if the state was used before */
+  RobotStatePtr allocate();
+
+  /** \brief Get a state from the pool and copy \e state into it. \e state must be a state of the robot model of the
+      pool. */
+  RobotStatePtr allocate(const RobotState& state);
+
+  /** \brief Make sure the pool holds at least \e count unused states */
+  void reserve(std::size_t count);
+
+  /** \brief Get the number of unused states held by the pool */
+  std::size_t getCachedCount() const;
+
+  /** \brief Free the unused states held by the pool */
+  void clear();
+
+private:
+  class Storage;
+  struct ReturnToStorage;
+  MOVEIT_DECLARE_PTR(Storage, Storage);
+
+  /** \brief Clear the flags a state kept from its previous use, so it looks like a newly constructed one */
+  static void resetState(RobotState* state);
+
+  RobotModelConstPtr robot_model_;
+  StoragePtr storage_;
+};
+}
+}
+
+#endif
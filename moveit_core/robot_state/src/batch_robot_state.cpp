@@ -0,0 +1,304 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2026, the MoveIt contributors
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the copyright holder nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+#include <moveit/robot_state/batch_robot_state.h>
+#include <moveit/robot_model/revolute_joint_model.h>
+#include <moveit/robot_model/prismatic_joint_model.h>
+#include <algorithm>
+
+namespace moveit
+{
+namespace core
+{
+namespace
+{
+// Transforms are represented by the top 3x4 part of their matrix, in row major order. A batch of transforms stores
+// each of the 12 entries contiguously for the n transforms of the batch. All loops run over the batch, so they can be
+// vectorized.
+
+void affineToArray(const Eigen::Affine3d& t, double* a)
+{
+  for (int r = 0; r < 3; ++r)
+    for (int c = 0; c < 4; ++c)
+      a[4 * r + c] = t(r, c);
+}
+
+// out = a * b, where a is a single transform and b is a batch
+void multiplyConstantBatch(const double* a, const double* b, double* out, std::size_t n)
+{
+  for (int r = 0; r < 3; ++r)
+    for (int c = 0; c < 4; ++c)
+    {
+      const double a0 = a[4 * r], a1 = a[4 * r + 1], a2 = a[4 * r + 2];
+      const double t = c == 3 ? a[4 * r + 3] : 0.0;
+      const double* b0 = b + c * n;
+      const double* b1 = b + (4 + c) * n;
+      const double* b2 = b + (8 + c) * n;
+      double* o = out + (4 * r + c) * n;
+      for (std::size_t i = 0; i < n; ++i)
+        o[i] = a0 * b0[i] + a1 * b1[i] + a2 * b2[i] + t;
+    }
+}
+
+// out = a * b, where a and b are batches; out must not overlap with a or b
+void multiplyBatchBatch(const double* a, const double* b, double* out, std::size_t n)
+{
+  for (int r = 0; r < 3; ++r)
+    for (int c = 0; c < 4; ++c)
+    {
+      const double* a0 = a + (4 * r) * n;
+      const double* a1 = a + (4 * r + 1) * n;
+      const double* a2 = a + (4 * r + 2) * n;
+      const double* b0 = b + c * n;
+      const double* b1 = b + (4 + c) * n;
+      const double* b2 = b + (8 + c) * n;
+      double* o = out + (4 * r + c) * n;
+      if (c == 3)
+      {
+        const double* a3 = a + (4 * r + 3) * n;
+        for (std::size_t i = 0; i < n; ++i)
+          o[i] = a0[i] * b0[i] + a1[i] * b1[i] + a2[i] * b2[i] + a3[i];
+      }
+      else
+        for (std::size_t i = 0; i < n; ++i)
+          o[i] = a0[i] * b0[i] + a1[i] * b1[i] + a2[i] * b2[i];
+    }
+}
+
+// out = a * b, where a is a batch and b is a single transform
+void multiplyBatchConstant(const double* a, const double* b, double* out, std::size_t n)
+{
+  for (int r = 0; r < 3; ++r)
+    for (int c = 0; c < 4; ++c)
+    {
+      const double b0 = b[c], b1 = b[4 + c], b2 = b[8 + c];
+      const double* a0 = a + (4 * r) * n;
+      const double* a1 = a + (4 * r + 1) * n;
+      const double* a2 = a + (4 * r + 2) * n;
+      double* o = out + (4 * r + c) * n;
+      if (c == 3)
+      {
+        const double* a3 = a + (4 * r + 3) * n;
+        for (std::size_t i = 0; i < n; ++i)
+          o[i] = a0[i] * b0 + a1[i] * b1 + a2[i] * b2 + a3[i];
+      }
+      else
+        for (std::size_t i = 0; i < n; ++i)
+          o[i] = a0[i] * b0 + a1[i] * b1 + a2[i] * b2;
+    }
+}
+
+void broadcastConstant(const double* a, double* out, std::size_t n)
+{
+  for (int k = 0; k < 12; ++k)
+    std::fill(out + k * n, out + (k + 1) * n, a[k]);
+}
+}
+}
+}
+
+moveit::core::BatchRobotState::BatchRobotState(const RobotState& reference_state, const JointModelGroup* group)
+  : group_(group), variable_count_(group->getVariableCount()), batch_size_(0)
+{
+  const RobotModel& model = group->getParentModel();
+  RobotState state(reference_state);
+  state.updateLinkTransforms();
+  reference_transforms_.resize(model.getLinkModelCount());
+  for (std::size_t i = 0; i < model.getLinkModels().size(); ++i)
+    reference_transforms_[model.getLinkModels()[i]->getLinkIndex()] =
+        state.getGlobalLinkTransform(model.getLinkModels()[i]);
+
+  // the updated links are sorted so that parents come before their children
+  const std::vector<const LinkModel*>& links = group->getUpdatedLinkModels();
+  link_update_index_.resize(model.getLinkModelCount(), -1);
+  link_updates_.resize(links.size());
+  for (std::size_t i = 0; i < links.size(); ++i)
+  {
+    LinkUpdate& update = link_updates_[i];
+    update.link_ = links[i];
+    link_update_index_[links[i]->getLinkIndex()] = i;
+
+    const LinkModel* parent = links[i]->getParentLinkModel();
+    update.parent_ = parent ? link_update_index_[parent->getLinkIndex()] : -1;
+    if (parent && update.parent_ < 0)
+      affineToArray(reference_transforms_[parent->getLinkIndex()] * links[i]->getJointOriginTransform(),
+                    update.origin_);
+    else
+      affineToArray(links[i]->getJointOriginTransform(), update.origin_);
+
+    if (links[i]->parentJointIsFixed())
+      continue;
+
+    // mimic joints take their value from the joint they mimic
+    const JointModel* joint = links[i]->getParentJointModel();
+    const JointModel* source = joint->getMimic() ? joint->getMimic() : joint;
+    update.variables_.resize(joint->getVariableCount());
+    for (std::size_t k = 0; k < update.variables_.size(); ++k)
+    {
+      VariableSource& var = update.variables_[k];
+      var.group_index_ =
+          group->hasJointModel(source->getName()) ? group->getVariableGroupIndex(source->getVariableNames()[k]) : -1;
+      var.value_ = state.getVariablePosition(source->getFirstVariableIndex() + k);
+      var.factor_ = joint->getMimic() ? joint->getMimicFactor() : 1.0;
+      var.offset_ = joint->getMimic() ? joint->getMimicOffset() : 0.0;
+    }
+  }
+}
+
+void moveit::core::BatchRobotState::computeJointTransforms(const LinkUpdate& update, const double* positions,
+                                                           double* out) const
+{
+  const std::size_t n = batch_size_;
+  const JointModel* joint = update.link_->getParentJointModel();
+  if (joint->getType() == JointModel::REVOLUTE || joint->getType() == JointModel::PRISMATIC)
+  {
+    // the joint values go in the translation entries first, which are overwritten at the end
+    const VariableSource& var = update.variables_[0];
+    double* q = out + 3 * n;
+    if (var.group_index_ < 0)
+      std::fill(q, q + n, var.value_ * var.factor_ + var.offset_);
+    else
+      for (std::size_t i = 0; i < n; ++i)
+        q[i] = positions[i * variable_count_ + var.group_index_] * var.factor_ + var.offset_;
+
+    if (joint->getType() == JointModel::REVOLUTE)
+    {
+      const Eigen::Vector3d& axis = static_cast<const RevoluteJointModel*>(joint)->getAxis();
+      const double x = axis.x(), y = axis.y(), z = axis.z();
+      for (std::size_t i = 0; i < n; ++i)
+      {
+        const double c = cos(q[i]);
+        const double s = sin(q[i]);
+        const double t = 1.0 - c;
+        out[i] = t * x * x + c;
+        out[n + i] = t * x * y - z * s;
+        out[2 * n + i] = t * x * z + y * s;
+        out[4 * n + i] = t * x * y + z * s;
+        out[5 * n + i] = t * y * y + c;
+        out[6 * n + i] = t * y * z - x * s;
+        out[8 * n + i] = t * x * z - y * s;
+        out[9 * n + i] = t * y * z + x * s;
+        out[10 * n + i] = t * z * z + c;
+      }
+      std::fill(out + 3 * n, out + 4 * n, 0.0);
+      std::fill(out + 7 * n, out + 8 * n, 0.0);
+      std::fill(out + 11 * n, out + 12 * n, 0.0);
+    }
+    else
+    {
+      const Eigen::Vector3d& axis = static_cast<const PrismaticJointModel*>(joint)->getAxis();
+      static const double IDENTITY[12] = { 1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0 };
+      for (int k = 0; k < 12; ++k)
+        if (k != 3)
+          std::fill(out + k * n, out + (k + 1) * n, IDENTITY[k]);
+      for (std::size_t i = 0; i < n; ++i)
+      {
+        out[7 * n + i] = axis.y() * q[i];
+        out[11 * n + i] = axis.z() * q[i];
+        out[3 * n + i] = axis.x() * q[i];
+      }
+    }
+  }
+  else
+  {
+    // other joint types have several variables; compute their transforms one by one
+    std::vector<double> values(update.variables_.size());
+    Eigen::Affine3d t;
+    double a[12];
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      for (std::size_t k = 0; k < values.size(); ++k)
+      {
+        const VariableSource& var = update.variables_[k];
+        values[k] = (var.group_index_ < 0 ? var.value_ : positions[i * variable_count_ + var.group_index_]) *
+                        var.factor_ +
+                    var.offset_;
+      }
+      joint->computeTransform(&values[0], t);
+      affineToArray(t, a);
+      for (int k = 0; k < 12; ++k)
+        out[k * n + i] = a[k];
+    }
+  }
+}
+
+void moveit::core::BatchRobotState::computeFKBatch(const double* positions, std::size_t count)
+{
+  batch_size_ = count;
+  const std::size_t n = count;
+  transforms_.resize(12 * n * link_updates_.size());
+  joint_transforms_.resize(12 * n);
+  local_transforms_.resize(12 * n);
+  if (n == 0)
+    return;
+
+  for (std::size_t l = 0; l < link_updates_.size(); ++l)
+  {
+    const LinkUpdate& update = link_updates_[l];
+    double* out = &transforms_[12 * n * l];
+    const double* parent = update.parent_ < 0 ? NULL : &transforms_[12 * n * update.parent_];
+
+    if (update.link_->parentJointIsFixed())
+    {
+      if (parent)
+        multiplyBatchConstant(parent, update.origin_, out, n);
+      else
+        broadcastConstant(update.origin_, out, n);
+      continue;
+    }
+
+    computeJointTransforms(update, positions, &joint_transforms_[0]);
+    if (parent)
+    {
+      multiplyConstantBatch(update.origin_, &joint_transforms_[0], &local_transforms_[0], n);
+      multiplyBatchBatch(parent, &local_transforms_[0], out, n);
+    }
+    else
+      multiplyConstantBatch(update.origin_, &joint_transforms_[0], out, n);
+  }
+}
+
+Eigen::Affine3d moveit::core::BatchRobotState::getGlobalLinkTransform(const LinkModel* link, std::size_t index) const
+{
+  const double* block = getGlobalLinkTransformBlock(link);
+  if (!block)
+    return reference_transforms_[link->getLinkIndex()];
+
+  Eigen::Affine3d t;
+  t.matrix().row(3) << 0.0, 0.0, 0.0, 1.0;
+  for (int r = 0; r < 3; ++r)
+    for (int c = 0; c < 4; ++c)
+      t(r, c) = block[(4 * r + c) * batch_size_ + index];
+  return t;
+}
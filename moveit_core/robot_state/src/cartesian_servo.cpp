@@ -0,0 +1,216 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2026, the MoveIt contributors
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the copyright holder nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+#include <moveit/robot_state/cartesian_servo.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace moveit
+{
+namespace core
+{
+namespace
+{
+/** \brief 1 for values of at least \e slowdown, 0 for values of at most \e stop, and linear in between */
+double rampFactor(double value, double stop, double slowdown)
+{
+  if (value >= slowdown)
+    return 1.0;
+  if (value <= stop)
+    return 0.0;
+  return (value - stop) / (slowdown - stop);
+}
+}
+
+CartesianServo::CartesianServo(const JointModelGroup* group, const LinkModel* tip)
+  : group_(group)
+  , tip_(tip)
+  , damping_(0.01)
+  , singularity_slowdown_(0.05)
+  , singularity_stop_(0.01)
+  , joint_limit_margin_(0.1)
+  , proximity_slowdown_(0.0)
+  , proximity_stop_(0.0)
+  , distance_(std::numeric_limits<double>::quiet_NaN())
+  , jacobian_(6, group->getVariableCount())
+  , positions_(group->getVariableCount())
+  , next_positions_(group->getVariableCount())
+  , qdot_(Eigen::VectorXd::Zero(group->getVariableCount()))
+{
+  const std::vector<std::string>& variables = group->getVariableNames();
+  bounds_.resize(variables.size());
+  for (std::size_t i = 0; i < variables.size(); ++i)
+    bounds_[i] = &group->getParentModel().getVariableBounds(variables[i]);
+  jjt_.setZero();
+  task_.setZero();
+}
+
+void CartesianServo::setDamping(double damping)
+{
+  damping_ = damping;
+}
+
+void CartesianServo::setSingularityThresholds(double slowdown, double stop)
+{
+  singularity_slowdown_ = slowdown;
+  singularity_stop_ = stop;
+}
+
+void CartesianServo::setJointLimitMargin(double margin)
+{
+  joint_limit_margin_ = margin;
+}
+
+void CartesianServo::setProximityFunction(const ProximityFn& fn, double slowdown, double stop)
+{
+  proximity_fn_ = fn;
+  proximity_slowdown_ = slowdown;
+  proximity_stop_ = stop;
+  distance_ = std::numeric_limits<double>::quiet_NaN();
+}
+
+double CartesianServo::computeJointVelocity(const RobotState& state, const Eigen::Matrix<double, 6, 1>& twist,
+                                            Eigen::VectorXd& qdot)
+{
+  const int variable_count = jacobian_.cols();
+  if (qdot.rows() != variable_count)
+    qdot.resize(variable_count);
+  if (!state.getJacobian(group_, tip_, Eigen::Vector3d(0.0, 0.0, 0.0), jacobian_))
+  {
+    qdot.setZero();
+    return 0.0;
+  }
+
+  // Rotate the jacobian to the tip frame, one column at a time so that only fixed-size temporaries are needed
+  const Eigen::Matrix3d tRb = state.getGlobalLinkTransform(tip_).linear().transpose();
+  for (int i = 0; i < variable_count; ++i)
+  {
+    jacobian_.col(i).head<3>() = tRb * jacobian_.col(i).head<3>();
+    jacobian_.col(i).tail<3>() = tRb * jacobian_.col(i).tail<3>();
+  }
+
+  // Damped least squares, qdot = J^T (J J^T + damping^2 I)^-1 twist, using the eigen decomposition of J J^T. Its
+  // eigenvalues are the squares of the singular values of J.
+  jjt_ = jacobian_.lazyProduct(jacobian_.transpose());
+  eigen_solver_.compute(jjt_);
+  const Eigen::Matrix<double, 6, 1>& eigenvalues = eigen_solver_.eigenvalues();
+  task_.noalias() = eigen_solver_.eigenvectors().transpose() * twist;
+  for (int i = 0; i < 6; ++i)
+  {
+    const double d = std::max(eigenvalues(i), 0.0) + damping_ * damping_;
+    task_(i) = d > std::numeric_limits<double>::epsilon() ? task_(i) / d : 0.0;
+  }
+  task_ = eigen_solver_.eigenvectors() * task_;
+  qdot = jacobian_.transpose().lazyProduct(task_);
+
+  // Slow down close to singularities; the eigenvalues are sorted in increasing order, and groups with fewer than 6
+  // variables only have as many non-zero singular values as variables
+  const int rank = std::min(variable_count, 6);
+  double scale =
+      rampFactor(std::sqrt(std::max(eigenvalues(6 - rank), 0.0)), singularity_stop_, singularity_slowdown_);
+
+  // Slow down motion towards position limits
+  state.copyJointGroupPositions(group_, positions_.data());
+  for (int i = 0; i < variable_count && scale > 0.0; ++i)
+  {
+    const VariableBounds& bounds = *bounds_[i];
+    if (!bounds.position_bounded_ || qdot(i) == 0.0)
+      continue;
+    const double room = qdot(i) > 0.0 ? bounds.max_position_ - positions_(i) : positions_(i) - bounds.min_position_;
+    scale = std::min(scale, rampFactor(room, 0.0, joint_limit_margin_));
+  }
+  qdot *= scale;
+
+  // Respect the velocity limits
+  double velocity_scale = 1.0;
+  for (int i = 0; i < variable_count; ++i)
+  {
+    const VariableBounds& bounds = *bounds_[i];
+    if (!bounds.velocity_bounded_ || qdot(i) == 0.0)
+      continue;
+    const double limit = qdot(i) > 0.0 ? bounds.max_velocity_ : -bounds.min_velocity_;
+    if (std::fabs(qdot(i)) > limit)
+      velocity_scale = std::min(velocity_scale, std::max(limit, 0.0) / std::fabs(qdot(i)));
+  }
+  qdot *= velocity_scale;
+
+  return scale * velocity_scale;
+}
+
+double CartesianServo::update(RobotState& state, const Eigen::Matrix<double, 6, 1>& twist, double dt)
+{
+  double scale = computeJointVelocity(state, twist, qdot_);
+
+  if (proximity_fn_)
+  {
+    if (std::isnan(distance_))
+      distance_ = proximity_fn_(state);
+    // once closer than the stop distance, commands are only checked after they are applied, so that the robot can
+    // still move away from the obstacle
+    if (distance_ > proximity_stop_)
+    {
+      const double factor = rampFactor(distance_, proximity_stop_, proximity_slowdown_);
+      qdot_ *= factor;
+      scale *= factor;
+    }
+  }
+  if (scale <= 0.0)
+  {
+    qdot_.setZero();
+    return 0.0;
+  }
+
+  next_positions_ = positions_ + dt * qdot_;
+  state.setJointGroupPositions(group_, next_positions_.data());
+  state.enforceBounds(group_);
+  state.update();
+
+  if (proximity_fn_)
+  {
+    const double distance = proximity_fn_(state);
+    if (distance < proximity_stop_ && distance < distance_)
+    {
+      // the command takes the robot too close to an obstacle; go back to where it was
+      state.setJointGroupPositions(group_, positions_.data());
+      state.update();
+      qdot_.setZero();
+      return 0.0;
+    }
+    distance_ = distance;
+  }
+  return scale;
+}
+}
+}
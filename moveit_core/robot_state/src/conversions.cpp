@@ -39,6 +39,7 @@
 #include <geometric_shapes/shape_operations.h>
 #include <eigen_conversions/eigen_msg.h>
 #include <boost/lexical_cast.hpp>
+#include <mutex>
 
 namespace moveit
 {
@@ -217,6 +218,138 @@ static void _attachedBodyToMsg(const AttachedBody& attached_body, moveit_msgs::A
   }
 }
 
+static bool primitiveMatchesMsg(const shapes::Shape& shape, const shape_msgs::SolidPrimitive& msg)
+{
+  switch (msg.type)
+  {
+    case shape_msgs::SolidPrimitive::BOX:
+    {
+      if (shape.type != shapes::BOX || msg.dimensions.size() < 3)
+        return false;
+      const double* size = static_cast<const shapes::Box&>(shape).size;
+      return size[0] == msg.dimensions[shape_msgs::SolidPrimitive::BOX_X] &&
+             size[1] == msg.dimensions[shape_msgs::SolidPrimitive::BOX_Y] &&
+             size[2] == msg.dimensions[shape_msgs::SolidPrimitive::BOX_Z];
+    }
+    case shape_msgs::SolidPrimitive::SPHERE:
+      return shape.type == shapes::SPHERE && msg.dimensions.size() >= 1 &&
+             static_cast<const shapes::Sphere&>(shape).radius ==
+                 msg.dimensions[shape_msgs::SolidPrimitive::SPHERE_RADIUS];
+    case shape_msgs::SolidPrimitive::CYLINDER:
+      return shape.type == shapes::CYLINDER && msg.dimensions.size() >= 2 &&
+             static_cast<const shapes::Cylinder&>(shape).radius ==
+                 msg.dimensions[shape_msgs::SolidPrimitive::CYLINDER_RADIUS] &&
+             static_cast<const shapes::Cylinder&>(shape).length ==
+                 msg.dimensions[shape_msgs::SolidPrimitive::CYLINDER_HEIGHT];
+    case shape_msgs::SolidPrimitive::CONE:
+      return shape.type == shapes::CONE && msg.dimensions.size() >= 2 &&
+             static_cast<const shapes::Cone&>(shape).radius ==
+                 msg.dimensions[shape_msgs::SolidPrimitive::CONE_RADIUS] &&
+             static_cast<const shapes::Cone&>(shape).length ==
+                 msg.dimensions[shape_msgs::SolidPrimitive::CONE_HEIGHT];
+    default:
+      return false;
+  }
+}
+
+static bool meshMatchesMsg(const shapes::Shape& shape, const shape_msgs::Mesh& msg)
+{
+  if (shape.type != shapes::MESH)
+    return false;
+  const shapes::Mesh& mesh = static_cast<const shapes::Mesh&>(shape);
+  if (mesh.vertex_count != msg.vertices.size() || mesh.triangle_count != msg.triangles.size())
+    return false;
+  for (std::size_t i = 0; i < msg.vertices.size(); ++i)
+    if (mesh.vertices[3 * i] != msg.vertices[i].x || mesh.vertices[3 * i + 1] != msg.vertices[i].y ||
+        mesh.vertices[3 * i + 2] != msg.vertices[i].z)
+      return false;
+  for (std::size_t i = 0; i < msg.triangles.size(); ++i)
+    for (std::size_t j = 0; j < 3; ++j)
+      if (mesh.triangles[3 * i + j] != msg.triangles[i].vertex_indices[j])
+        return false;
+  return true;
+}
+
+static bool planeMatchesMsg(const shapes::Shape& shape, const shape_msgs::Plane& msg)
+{
+  if (shape.type != shapes::PLANE)
+    return false;
+  const shapes::Plane& plane = static_cast<const shapes::Plane&>(shape);
+  return plane.a == msg.coef[0] && plane.b == msg.coef[1] && plane.c == msg.coef[2] && plane.d == msg.coef[3];
+}
+
+// The shapes last constructed for the attached collision objects in messages, by object id. Converting a message
+// that describes the same geometry again reuses them, so that the states converted from it share their shapes (and
+// the collision geometry the collision checkers built for them) instead of constructing new ones.
+typedef std::map<std::string, std::vector<std::weak_ptr<const shapes::Shape> > > AttachedShapeCache;
+
+struct AttachedShapeCacheData
+{
+  std::mutex lock_;
+  AttachedShapeCache objects_;
+};
+
+static AttachedShapeCacheData& getAttachedShapeCache()
+{
+  static AttachedShapeCacheData cache;
+  return cache;
+}
+
+static bool getCachedAttachedShapes(const moveit_msgs::CollisionObject& object,
+                                    std::vector<shapes::ShapeConstPtr>& shapes)
+{
+  AttachedShapeCacheData& cache = getAttachedShapeCache();
+  std::lock_guard<std::mutex> slock(cache.lock_);
+  AttachedShapeCache::const_iterator it = cache.objects_.find(object.id);
+  if (it == cache.objects_.end() ||
+      it->second.size() != object.primitives.size() + object.meshes.size() + object.planes.size())
+    return false;
+
+  shapes.resize(it->second.size());
+  for (std::size_t i = 0; i < shapes.size(); ++i)
+  {
+    shapes[i] = it->second[i].lock();
+    if (!shapes[i])
+    {
+      shapes.clear();
+      return false;
+    }
+  }
+
+  // the shapes are in the order they were constructed in: primitives, meshes, planes
+  std::size_t k = 0;
+  bool match = true;
+  for (std::size_t i = 0; i < object.primitives.size() && match; ++i)
+    match = primitiveMatchesMsg(*shapes[k++], object.primitives[i]);
+  for (std::size_t i = 0; i < object.meshes.size() && match; ++i)
+    match = meshMatchesMsg(*shapes[k++], object.meshes[i]);
+  for (std::size_t i = 0; i < object.planes.size() && match; ++i)
+    match = planeMatchesMsg(*shapes[k++], object.planes[i]);
+  if (!match)
+    shapes.clear();
+  return match;
+}
+
+static void cacheAttachedShapes(const moveit_msgs::CollisionObject& object,
+                                const std::vector<shapes::ShapeConstPtr>& shapes)
+{
+  AttachedShapeCacheData& cache = getAttachedShapeCache();
+  std::lock_guard<std::mutex> slock(cache.lock_);
+  cache.objects_[object.id].assign(shapes.begin(), shapes.end());
+
+  // drop the entries of objects whose shapes are no longer used
+  for (AttachedShapeCache::iterator it = cache.objects_.begin(); it != cache.objects_.end();)
+  {
+    bool expired = true;
+    for (std::size_t i = 0; i < it->second.size() && expired; ++i)
+      expired = it->second[i].expired();
+    if (expired)
+      cache.objects_.erase(it++);
+    else
+      ++it;
+  }
+}
+
 static void _msgToAttachedBody(const Transforms* tf, const moveit_msgs::AttachedCollisionObject& aco, RobotState& state)
 {
   if (aco.object.operation == moveit_msgs::CollisionObject::ADD)
@@ -247,39 +380,56 @@ static void _msgToAttachedBody(const Transforms* tf, const moveit_msgs::Attached
         std::vector<shapes::ShapeConstPtr> shapes;
         EigenSTL::vector_Affine3d poses;
 
-        for (std::size_t i = 0; i < aco.object.primitives.size(); ++i)
+        if (getCachedAttachedShapes(aco.object, shapes))
         {
-          shapes::Shape* s = shapes::constructShapeFromMsg(aco.object.primitives[i]);
-          if (s)
-          {
-            Eigen::Affine3d p;
-            tf::poseMsgToEigen(aco.object.primitive_poses[i], p);
-            shapes.push_back(shapes::ShapeConstPtr(s));
-            poses.push_back(p);
-          }
+          poses.resize(shapes.size());
+          std::size_t k = 0;
+          for (std::size_t i = 0; i < aco.object.primitive_poses.size(); ++i)
+            tf::poseMsgToEigen(aco.object.primitive_poses[i], poses[k++]);
+          for (std::size_t i = 0; i < aco.object.mesh_poses.size(); ++i)
+            tf::poseMsgToEigen(aco.object.mesh_poses[i], poses[k++]);
+          for (std::size_t i = 0; i < aco.object.plane_poses.size(); ++i)
+            tf::poseMsgToEigen(aco.object.plane_poses[i], poses[k++]);
         }
-        for (std::size_t i = 0; i < aco.object.meshes.size(); ++i)
+        else
         {
-          shapes::Shape* s = shapes::constructShapeFromMsg(aco.object.meshes[i]);
-          if (s)
+          for (std::size_t i = 0; i < aco.object.primitives.size(); ++i)
           {
-            Eigen::Affine3d p;
-            tf::poseMsgToEigen(aco.object.mesh_poses[i], p);
-            shapes.push_back(shapes::ShapeConstPtr(s));
-            poses.push_back(p);
+            shapes::Shape* s = shapes::constructShapeFromMsg(aco.object.primitives[i]);
+            if (s)
+            {
+              Eigen::Affine3d p;
+              tf::poseMsgToEigen(aco.object.primitive_poses[i], p);
+              shapes.push_back(shapes::ShapeConstPtr(s));
+              poses.push_back(p);
+            }
           }
-        }
-        for (std::size_t i = 0; i < aco.object.planes.size(); ++i)
-        {
-          shapes::Shape* s = shapes::constructShapeFromMsg(aco.object.planes[i]);
-          if (s)
+          for (std::size_t i = 0; i < aco.object.meshes.size(); ++i)
           {
-            Eigen::Affine3d p;
-            tf::poseMsgToEigen(aco.object.plane_poses[i], p);
-
-            shapes.push_back(shapes::ShapeConstPtr(s));
-            poses.push_back(p);
+            shapes::Shape* s = shapes::constructShapeFromMsg(aco.object.meshes[i]);
+            if (s)
+            {
+              Eigen::Affine3d p;
+              tf::poseMsgToEigen(aco.object.mesh_poses[i], p);
+              shapes.push_back(shapes::ShapeConstPtr(s));
+              poses.push_back(p);
+            }
+          }
+          for (std::size_t i = 0; i < aco.object.planes.size(); ++i)
+          {
+            shapes::Shape* s = shapes::constructShapeFromMsg(aco.object.planes[i]);
+            if (s)
+            {
+              Eigen::Affine3d p;
+              tf::poseMsgToEigen(aco.object.plane_poses[i], p);
+
+              shapes.push_back(shapes::ShapeConstPtr(s));
+              poses.push_back(p);
+            }
           }
+          // only complete sets of shapes can be matched against later messages
+          if (shapes.size() == aco.object.primitives.size() + aco.object.meshes.size() + aco.object.planes.size())
+            cacheAttachedShapes(aco.object, shapes);
         }
 
         // transform poses to link frame
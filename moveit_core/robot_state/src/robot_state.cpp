@@ -42,6 +42,22 @@
 #include <moveit/backtrace/backtrace.h>
 #include <moveit/profiler/profiler.h>
 #include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+// The bottom row of the transforms of links and joints is always (0 0 0 1), so only their 3x4 parts need to be
+// multiplied: 36 multiplications instead of the 64 of a full 4x4 product, with the same result
+inline void multiplyRigidTransforms(const Eigen::Affine3d& a, const Eigen::Affine3d& b, Eigen::Affine3d& result)
+{
+  result.linear().noalias() = a.linear() * b.linear();
+  result.translation().noalias() = a.linear() * b.translation();
+  result.translation() += a.translation();
+  result.makeAffine();
+}
+}
 
 moveit::core::RobotState::RobotState(const RobotModelConstPtr& robot_model)
   : robot_model_(robot_model)
@@ -50,17 +66,20 @@ moveit::core::RobotState::RobotState(const RobotModelConstPtr& robot_model)
   , has_effort_(false)
   , dirty_link_transforms_(robot_model_->getRootJoint())
   , dirty_collision_body_transforms_(NULL)
-  , rng_(NULL)
+  , link_transform_update_count_(0)
+  , collision_body_transform_update_count_(0)
 {
   allocMemory();
 
-  // all transforms are dirty initially
-  const int nr_doubles_for_dirty_joint_transforms =
-      1 + robot_model_->getJointModelCount() / (sizeof(double) / sizeof(unsigned char));
-  memset(dirty_joint_transforms_, 1, sizeof(double) * nr_doubles_for_dirty_joint_transforms);
+  // all transforms are dirty initially (this also sets the dirty flags of all links)
+  const int nr_doubles_for_dirty_flags =
+      1 + (robot_model_->getJointModelCount() + 2 * robot_model_->getLinkModelCount()) /
+              (sizeof(double) / sizeof(unsigned char));
+  memset(dirty_joint_transforms_, 1, sizeof(double) * nr_doubles_for_dirty_flags);
 }
 
-moveit::core::RobotState::RobotState(const RobotState& other) : rng_(NULL)
+moveit::core::RobotState::RobotState(const RobotState& other)
+  : link_transform_update_count_(0), collision_body_transform_update_count_(0)
 {
   robot_model_ = other.robot_model_;
   allocMemory();
@@ -71,19 +90,18 @@ moveit::core::RobotState::~RobotState()
 {
   clearAttachedBodies();
   free(memory_);
-  if (rng_)
-    delete rng_;
 }
 
 void moveit::core::RobotState::allocMemory(void)
 {
-  // memory for the dirty joint transforms
-  const int nr_doubles_for_dirty_joint_transforms =
-      1 + robot_model_->getJointModelCount() / (sizeof(double) / sizeof(unsigned char));
+  // memory for the dirty flags of joint transforms, link transforms and collision body transforms
+  const int nr_doubles_for_dirty_flags =
+      1 + (robot_model_->getJointModelCount() + 2 * robot_model_->getLinkModelCount()) /
+              (sizeof(double) / sizeof(unsigned char));
   const size_t bytes =
       sizeof(Eigen::Affine3d) * (robot_model_->getJointModelCount() + robot_model_->getLinkModelCount() +
                                  robot_model_->getLinkGeometryCount()) +
-      sizeof(double) * (robot_model_->getVariableCount() * 3 + nr_doubles_for_dirty_joint_transforms) + 15;
+      sizeof(double) * (robot_model_->getVariableCount() * 3 + nr_doubles_for_dirty_flags) + 15;
   memory_ = malloc(bytes);
 
   // make the memory for transforms align at 16 bytes
@@ -92,7 +110,9 @@ void moveit::core::RobotState::allocMemory(void)
   global_collision_body_transforms_ = global_link_transforms_ + robot_model_->getLinkModelCount();
   dirty_joint_transforms_ =
       reinterpret_cast<unsigned char*>(global_collision_body_transforms_ + robot_model_->getLinkGeometryCount());
-  position_ = reinterpret_cast<double*>(dirty_joint_transforms_) + nr_doubles_for_dirty_joint_transforms;
+  dirty_link_flags_ = dirty_joint_transforms_ + robot_model_->getJointModelCount();
+  dirty_collision_body_flags_ = dirty_link_flags_ + robot_model_->getLinkModelCount();
+  position_ = reinterpret_cast<double*>(dirty_joint_transforms_) + nr_doubles_for_dirty_flags;
   velocity_ = position_ + robot_model_->getVariableCount();
   // acceleration and effort share the memory (not both can be specified)
   effort_ = acceleration_ = velocity_ + robot_model_->getVariableCount();
@@ -122,31 +142,38 @@ void moveit::core::RobotState::copyFrom(const RobotState& other)
                                             ((has_acceleration_ || has_effort_) ? 1 : 0)));
 
     // mark all transforms as dirty
-    const int nr_doubles_for_dirty_joint_transforms =
-        1 + robot_model_->getJointModelCount() / (sizeof(double) / sizeof(unsigned char));
-    memset(dirty_joint_transforms_, 1, sizeof(double) * nr_doubles_for_dirty_joint_transforms);
+    const int nr_doubles_for_dirty_flags =
+        1 + (robot_model_->getJointModelCount() + 2 * robot_model_->getLinkModelCount()) /
+                (sizeof(double) / sizeof(unsigned char));
+    memset(dirty_joint_transforms_, 1, sizeof(double) * nr_doubles_for_dirty_flags);
   }
   else
   {
     // copy all the memory; maybe avoid copying velocity and acceleration if possible
-    const int nr_doubles_for_dirty_joint_transforms =
-        1 + robot_model_->getJointModelCount() / (sizeof(double) / sizeof(unsigned char));
+    const int nr_doubles_for_dirty_flags =
+        1 + (robot_model_->getJointModelCount() + 2 * robot_model_->getLinkModelCount()) /
+                (sizeof(double) / sizeof(unsigned char));
     const size_t bytes =
         sizeof(Eigen::Affine3d) * (robot_model_->getJointModelCount() + robot_model_->getLinkModelCount() +
                                    robot_model_->getLinkGeometryCount()) +
         sizeof(double) *
             (robot_model_->getVariableCount() * (1 + ((has_velocity_ || has_acceleration_ || has_effort_) ? 1 : 0) +
                                                  ((has_acceleration_ || has_effort_) ? 1 : 0)) +
-             nr_doubles_for_dirty_joint_transforms);
+             nr_doubles_for_dirty_flags);
     memcpy(variable_joint_transforms_, other.variable_joint_transforms_, bytes);
   }
 
-  // copy attached bodies
+  // copy attached bodies; their geometry is shared with the other state and their global transforms match the link
+  // transforms and dirty flags copied above, so they do not need to be recomputed here
   clearAttachedBodies();
   for (std::map<std::string, AttachedBody*>::const_iterator it = other.attached_body_map_.begin();
        it != other.attached_body_map_.end(); ++it)
-    attachBody(it->second->getName(), it->second->getShapes(), it->second->getFixedTransforms(),
-               it->second->getTouchLinks(), it->second->getAttachedLinkName(), it->second->getDetachPosture());
+  {
+    AttachedBody* ab = new AttachedBody(*it->second);
+    attached_body_map_[ab->getName()] = ab;
+    if (attached_body_update_callback_)
+      attached_body_update_callback_(ab, true);
+  }
 }
 
 bool moveit::core::RobotState::checkJointTransforms(const JointModel* joint) const
@@ -169,6 +196,16 @@ bool moveit::core::RobotState::checkLinkTransforms() const
   return true;
 }
 
+bool moveit::core::RobotState::checkLinkTransform(const LinkModel* link) const
+{
+  if (dirtyLinkTransform(link))
+  {
+    logWarn("Returning dirty link transform for '%s'", link->getName().c_str());
+    return false;
+  }
+  return true;
+}
+
 bool moveit::core::RobotState::checkCollisionTransforms() const
 {
   if (dirtyCollisionBodyTransforms())
@@ -212,8 +249,7 @@ void moveit::core::RobotState::setToRandomPositions()
 {
   random_numbers::RandomNumberGenerator& rng = getRandomNumberGenerator();
   robot_model_->getVariableRandomPositions(rng, position_);
-  memset(dirty_joint_transforms_, 1, robot_model_->getJointModelCount() * sizeof(unsigned char));
-  dirty_link_transforms_ = robot_model_->getRootJoint();
+  markDirtyAllTransforms();
   // mimic values are correctly set in RobotModel
 }
 
@@ -282,20 +318,20 @@ void moveit::core::RobotState::setToDefaultValues()
   robot_model_->getVariableDefaultPositions(position_);  // mimic values are updated
   // set velocity & acceleration to 0
   memset(velocity_, 0, sizeof(double) * 2 * robot_model_->getVariableCount());
-  memset(dirty_joint_transforms_, 1, robot_model_->getJointModelCount() * sizeof(unsigned char));
-  dirty_link_transforms_ = robot_model_->getRootJoint();
+  markDirtyAllTransforms();
 }
 
 void moveit::core::RobotState::setVariablePositions(const double* position)
 {
-  // assume everything is in order in terms of array lengths (for efficiency reasons)
-  memcpy(position_, position, robot_model_->getVariableCount() * sizeof(double));
+  // assume everything is in order in terms of array lengths (for efficiency reasons);
+  // the values may also have been written in place through getVariablePositions()
+  if (position != position_)
+    memcpy(position_, position, robot_model_->getVariableCount() * sizeof(double));
 
   // the full state includes mimic joint values, so no need to update mimic here
 
   // Since all joint values have potentially changed, we will need to recompute all transforms
-  memset(dirty_joint_transforms_, 1, robot_model_->getJointModelCount() * sizeof(unsigned char));
-  dirty_link_transforms_ = robot_model_->getRootJoint();
+  markDirtyAllTransforms();
 }
 
 void moveit::core::RobotState::setVariablePositions(const std::map<std::string, double>& variable_map)
@@ -538,8 +574,7 @@ void moveit::core::RobotState::update(bool force)
   // make sure we do everything from scratch if needed
   if (force)
   {
-    memset(dirty_joint_transforms_, 1, robot_model_->getJointModelCount() * sizeof(unsigned char));
-    dirty_link_transforms_ = robot_model_->getRootJoint();
+    markDirtyAllTransforms();
   }
 
   // this actually triggers all needed updates
@@ -558,14 +593,22 @@ void moveit::core::RobotState::updateCollisionBodyTransforms()
 
     for (std::size_t i = 0; i < links.size(); ++i)
     {
+      const int index_l = links[i]->getLinkIndex();
+      // only the links whose transform changed since their collision bodies were updated
+      if (!dirty_collision_body_flags_[index_l])
+        continue;
+      dirty_collision_body_flags_[index_l] = 0;
+
       const EigenSTL::vector_Affine3d& ot = links[i]->getCollisionOriginTransforms();
       const std::vector<int>& ot_id = links[i]->areCollisionOriginTransformsIdentity();
       const int index_co = links[i]->getFirstCollisionBodyTransformIndex();
-      const int index_l = links[i]->getLinkIndex();
       for (std::size_t j = 0; j < ot.size(); ++j)
-        global_collision_body_transforms_[index_co + j].matrix().noalias() =
-            ot_id[j] ? global_link_transforms_[index_l].matrix() :
-                       global_link_transforms_[index_l].matrix() * ot[j].matrix();
+        if (ot_id[j])
+          global_collision_body_transforms_[index_co + j] = global_link_transforms_[index_l];
+        else
+          multiplyRigidTransforms(global_link_transforms_[index_l], ot[j],
+                                  global_collision_body_transforms_[index_co + j]);
+      collision_body_transform_update_count_ += ot.size();
     }
   }
 }
@@ -584,64 +627,68 @@ void moveit::core::RobotState::updateLinkTransforms()
   }
 }
 
-void moveit::core::RobotState::updateLinkTransformsInternal(const JointModel* start)
+void moveit::core::RobotState::updateLinkTransformChain(const LinkModel* link)
 {
-  const std::vector<const LinkModel*>& links = start->getDescendantLinkModels();
-  if (!links.empty())
+  if (dirty_link_transforms_ == NULL)
+    return;
+  // the parent needs to be up to date first; the links outside the chain are marked out of date as the chain is
+  // recomputed, so the next full update still covers them
+  if (link->getParentLinkModel())
+    updateLinkTransformChain(link->getParentLinkModel());
+  if (dirty_link_flags_[link->getLinkIndex()])
+    computeLinkTransform(link);
+}
+
+void moveit::core::RobotState::computeLinkTransform(const LinkModel* link)
+{
+  const int index = link->getLinkIndex();
+  dirty_link_flags_[index] = 0;
+
+  Eigen::Affine3d& result = global_link_transforms_[index];
+  const LinkModel* parent = link->getParentLinkModel();
+  if (parent)
   {
-    const LinkModel* parent = links[0]->getParentLinkModel();
-    if (parent)
-    {
-      if (links[0]->parentJointIsFixed())
-        global_link_transforms_[links[0]->getLinkIndex()].matrix().noalias() =
-            global_link_transforms_[parent->getLinkIndex()].matrix() * links[0]->getJointOriginTransform().matrix();
-      else
-      {
-        if (links[0]->jointOriginTransformIsIdentity())
-          global_link_transforms_[links[0]->getLinkIndex()].matrix().noalias() =
-              global_link_transforms_[parent->getLinkIndex()].matrix() *
-              getJointTransform(links[0]->getParentJointModel()).matrix();
-        else
-          global_link_transforms_[links[0]->getLinkIndex()].matrix().noalias() =
-              global_link_transforms_[parent->getLinkIndex()].matrix() * links[0]->getJointOriginTransform().matrix() *
-              getJointTransform(links[0]->getParentJointModel()).matrix();
-      }
-    }
+    const Eigen::Affine3d& parent_transform = global_link_transforms_[parent->getLinkIndex()];
+    if (link->parentJointIsFixed())
+      multiplyRigidTransforms(parent_transform, link->getJointOriginTransform(), result);
+    else if (link->jointOriginTransformIsIdentity())
+      multiplyRigidTransforms(parent_transform, getJointTransform(link->getParentJointModel()), result);
     else
     {
-      if (links[0]->jointOriginTransformIsIdentity())
-        global_link_transforms_[links[0]->getLinkIndex()] = getJointTransform(links[0]->getParentJointModel());
-      else
-        global_link_transforms_[links[0]->getLinkIndex()].matrix().noalias() =
-            links[0]->getJointOriginTransform().matrix() * getJointTransform(links[0]->getParentJointModel()).matrix();
-    }
-
-    // we know the rest of the links have parents
-    for (std::size_t i = 1; i < links.size(); ++i)
-    {
-      if (links[i]->parentJointIsFixed())
-        global_link_transforms_[links[i]->getLinkIndex()].matrix().noalias() =
-            global_link_transforms_[links[i]->getParentLinkModel()->getLinkIndex()].matrix() *
-            links[i]->getJointOriginTransform().matrix();
-      else
-      {
-        if (links[i]->jointOriginTransformIsIdentity())
-          global_link_transforms_[links[i]->getLinkIndex()].matrix().noalias() =
-              global_link_transforms_[links[i]->getParentLinkModel()->getLinkIndex()].matrix() *
-              getJointTransform(links[i]->getParentJointModel()).matrix();
-        else
-          global_link_transforms_[links[i]->getLinkIndex()].matrix().noalias() =
-              global_link_transforms_[links[i]->getParentLinkModel()->getLinkIndex()].matrix() *
-              links[i]->getJointOriginTransform().matrix() *
-              getJointTransform(links[i]->getParentJointModel()).matrix();
-      }
+      Eigen::Affine3d origin;
+      multiplyRigidTransforms(parent_transform, link->getJointOriginTransform(), origin);
+      multiplyRigidTransforms(origin, getJointTransform(link->getParentJointModel()), result);
     }
   }
+  else
+  {
+    if (link->jointOriginTransformIsIdentity())
+      result = getJointTransform(link->getParentJointModel());
+    else
+      multiplyRigidTransforms(link->getJointOriginTransform(), getJointTransform(link->getParentJointModel()), result);
+  }
+  ++link_transform_update_count_;
+
+  dirty_collision_body_flags_[index] = 1;
+  const std::vector<const JointModel*>& cj = link->getChildJointModels();
+  for (std::size_t j = 0; j < cj.size(); ++j)
+    dirty_link_flags_[cj[j]->getChildLinkModel()->getLinkIndex()] = 1;
+}
 
-  // update attached bodies tf; these are usually very few, so we update them all
+void moveit::core::RobotState::updateLinkTransformsInternal(const JointModel* start)
+{
+  // links are ordered so that parents come before their descendants; a link is only recomputed if its parent joint
+  // changed or if its parent link was recomputed, which is propagated through the dirty flags of the child links
+  const std::vector<const LinkModel*>& links = start->getDescendantLinkModels();
+  for (std::size_t i = 0; i < links.size(); ++i)
+    if (dirty_link_flags_[links[i]->getLinkIndex()])
+      computeLinkTransform(links[i]);
+
+  // update the transforms of the bodies attached to links that moved; these are usually very few
   for (std::map<std::string, AttachedBody*>::const_iterator it = attached_body_map_.begin();
        it != attached_body_map_.end(); ++it)
-    it->second->computeTransform(global_link_transforms_[it->second->getAttachedLink()->getLinkIndex()]);
+    if (dirty_collision_body_flags_[it->second->getAttachedLink()->getLinkIndex()])
+      it->second->computeTransform(global_link_transforms_[it->second->getAttachedLink()->getLinkIndex()]);
 }
 
 void moveit::core::RobotState::updateStateWithLinkAt(const LinkModel* link, const Eigen::Affine3d& transform,
@@ -657,11 +704,15 @@ void moveit::core::RobotState::updateStateWithLinkAt(const LinkModel* link, cons
     dirty_collision_body_transforms_ = link->getParentJointModel();
 
   global_link_transforms_[link->getLinkIndex()] = transform;
+  dirty_collision_body_flags_[link->getLinkIndex()] = 1;
 
   // update link transforms for descendant links only (leaving the transform for the current link untouched)
   const std::vector<const JointModel*>& cj = link->getChildJointModels();
   for (std::size_t i = 0; i < cj.size(); ++i)
+  {
+    dirty_link_flags_[cj[i]->getChildLinkModel()->getLinkIndex()] = 1;
     updateLinkTransformsInternal(cj[i]);
+  }
 
   // if we also need to go backward
   if (backward)
@@ -679,13 +730,17 @@ void moveit::core::RobotState::updateStateWithLinkAt(const LinkModel* link, cons
           (child_link->getJointOriginTransform() *
            variable_joint_transforms_[child_link->getParentJointModel()->getJointIndex()])
               .inverse();
+      dirty_collision_body_flags_[parent_link->getLinkIndex()] = 1;
 
       // update link transforms for descendant links only (leaving the transform for the current link untouched)
       // with the exception of the child link we are coming backwards from
       const std::vector<const JointModel*>& cj = parent_link->getChildJointModels();
       for (std::size_t i = 0; i < cj.size(); ++i)
         if (cj[i] != child_link->getParentJointModel())
+        {
+          dirty_link_flags_[cj[i]->getChildLinkModel()->getLinkIndex()] = 1;
           updateLinkTransformsInternal(cj[i]);
+        }
     }
     // update the root joint of the model to match (as best as possible given #DOF) the transform we wish to obtain for
     // the root link.
@@ -693,12 +748,16 @@ void moveit::core::RobotState::updateStateWithLinkAt(const LinkModel* link, cons
     //    parent_link->getParentJointModel()->computeVariableValues(global_link_transforms_[parent_link->getLinkIndex()],
     //                                                              position_ +
     //                                                              parent_link->getParentJointModel()->getFirstVariableIndex());
+
+    // links above the given one moved as well; only flagged links are recomputed, so starting from the root is cheap
+    dirty_collision_body_transforms_ = robot_model_->getRootJoint();
   }
 
-  // update attached bodies tf; these are usually very few, so we update them all
+  // update attached bodies tf for the links that moved; these are usually very few
   for (std::map<std::string, AttachedBody*>::const_iterator it = attached_body_map_.begin();
        it != attached_body_map_.end(); ++it)
-    it->second->computeTransform(global_link_transforms_[it->second->getAttachedLink()->getLinkIndex()]);
+    if (dirty_collision_body_flags_[it->second->getAttachedLink()->getLinkIndex()])
+      it->second->computeTransform(global_link_transforms_[it->second->getAttachedLink()->getLinkIndex()]);
 }
 
 bool moveit::core::RobotState::satisfiesBounds(double margin) const
@@ -819,8 +878,7 @@ void moveit::core::RobotState::interpolate(const RobotState& to, double t, Robot
 {
   robot_model_->interpolate(getVariablePositions(), to.getVariablePositions(), t, state.getVariablePositions());
 
-  memset(state.dirty_joint_transforms_, 1, state.robot_model_->getJointModelCount() * sizeof(unsigned char));
-  state.dirty_link_transforms_ = state.robot_model_->getRootJoint();
+  state.markDirtyAllTransforms();
 }
 
 void moveit::core::RobotState::interpolate(const RobotState& to, double t, RobotState& state,
@@ -979,47 +1037,49 @@ const Eigen::Affine3d& moveit::core::RobotState::getFrameTransform(const std::st
 
 const Eigen::Affine3d& moveit::core::RobotState::getFrameTransform(const std::string& id) const
 {
+  BOOST_VERIFY(checkLinkTransforms());
+  const Eigen::Affine3d* transform = findFrameTransform(id);
+  if (transform)
+    return *transform;
   if (!id.empty() && id[0] == '/')
     return getFrameTransform(id.substr(1));
-  BOOST_VERIFY(checkLinkTransforms());
 
   static const Eigen::Affine3d identity_transform = Eigen::Affine3d::Identity();
-  if (id.size() + 1 == robot_model_->getModelFrame().size() && '/' + id == robot_model_->getModelFrame())
-    return identity_transform;
-  if (robot_model_->hasLinkModel(id))
-  {
-    const LinkModel* lm = robot_model_->getLinkModel(id);
-    return global_link_transforms_[lm->getLinkIndex()];
-  }
-  std::map<std::string, AttachedBody*>::const_iterator jt = attached_body_map_.find(id);
-  if (jt == attached_body_map_.end())
-  {
+  if (attached_body_map_.find(id) == attached_body_map_.end())
     logError("Transform from frame '%s' to frame '%s' is not known ('%s' should be a link name or an attached body "
              "id).",
              id.c_str(), robot_model_->getModelFrame().c_str(), id.c_str());
-    return identity_transform;
-  }
-  const EigenSTL::vector_Affine3d& tf = jt->second->getGlobalCollisionBodyTransforms();
-  if (tf.empty())
-  {
+  else
     logError("Attached body '%s' has no geometry associated to it. No transform to return.", id.c_str());
-    return identity_transform;
-  }
-  if (tf.size() > 1)
-    logDebug("There are multiple geometries associated to attached body '%s'. Returning the transform for the first "
-             "one.",
-             id.c_str());
-  return tf[0];
+  return identity_transform;
 }
 
 bool moveit::core::RobotState::knowsFrameTransform(const std::string& id) const
+{
+  return findFrameTransform(id) != NULL;
+}
+
+const Eigen::Affine3d* moveit::core::RobotState::findFrameTransform(const std::string& id) const
 {
   if (!id.empty() && id[0] == '/')
-    return knowsFrameTransform(id.substr(1));
+    return findFrameTransform(id.substr(1));
+
+  static const Eigen::Affine3d identity_transform = Eigen::Affine3d::Identity();
+  if (id.size() + 1 == robot_model_->getModelFrame().size() && '/' + id == robot_model_->getModelFrame())
+    return &identity_transform;
   if (robot_model_->hasLinkModel(id))
-    return true;
-  std::map<std::string, AttachedBody*>::const_iterator it = attached_body_map_.find(id);
-  return it != attached_body_map_.end() && it->second->getGlobalCollisionBodyTransforms().size() >= 1;
+    return &global_link_transforms_[robot_model_->getLinkModel(id)->getLinkIndex()];
+  std::map<std::string, AttachedBody*>::const_iterator jt = attached_body_map_.find(id);
+  if (jt == attached_body_map_.end())
+    return NULL;
+  const EigenSTL::vector_Affine3d& tf = jt->second->getGlobalCollisionBodyTransforms();
+  if (tf.empty())
+    return NULL;
+  if (tf.size() > 1)
+    logDebug("There are multiple geometries associated to attached body '%s'. Returning the transform for the first "
+             "one.",
+             id.c_str());
+  return &tf[0];
 }
 
 void moveit::core::RobotState::getRobotMarkers(visualization_msgs::MarkerArray& arr,
@@ -1117,84 +1177,57 @@ Eigen::MatrixXd moveit::core::RobotState::getJacobian(const JointModelGroup* gro
   return result;
 }
 
-bool moveit::core::RobotState::getJacobian(const JointModelGroup* group, const LinkModel* link,
-                                           const Eigen::Vector3d& reference_point_position, Eigen::MatrixXd& jacobian,
-                                           bool use_quaternion_representation) const
+namespace
 {
-  BOOST_VERIFY(checkLinkTransforms());
-
-  if (!group->isChain())
-  {
-    logError("The group '%s' is not a chain. Cannot compute Jacobian.", group->getName().c_str());
-    return false;
-  }
-
-  if (!group->isLinkUpdated(link->getName()))
-  {
-    logError("Link name '%s' does not exist in the chain '%s' or is not a child for this chain",
-             link->getName().c_str(), group->getName().c_str());
-    return false;
-  }
-
-  const robot_model::JointModel* root_joint_model = group->getJointModels()[0];  // group->getJointRoots()[0];
-  const robot_model::LinkModel* root_link_model = root_joint_model->getParentLinkModel();
+/** \brief Fill the position and orientation rows of a zero-initialized \e jacobian; the matrix type is either dynamic
+    or has as many columns as the group has variables, so that fixed-size chains avoid heap allocations */
+template <typename JacobianType>
+void computeJacobian(const moveit::core::RobotState& state, const moveit::core::JointModelGroup* group,
+                     const moveit::core::LinkModel* link, const Eigen::Vector3d& reference_point_position,
+                     Eigen::Affine3d& link_transform, JacobianType& jacobian)
+{
+  const moveit::core::JointModel* root_joint_model = group->getJointModels()[0];  // group->getJointRoots()[0];
+  const moveit::core::LinkModel* root_link_model = root_joint_model->getParentLinkModel();
   Eigen::Affine3d reference_transform =
-      root_link_model ? getGlobalLinkTransform(root_link_model).inverse() : Eigen::Affine3d::Identity();
-  int rows = use_quaternion_representation ? 7 : 6;
-  int columns = group->getVariableCount();
-  jacobian = Eigen::MatrixXd::Zero(rows, columns);
+      root_link_model ? state.getGlobalLinkTransform(root_link_model).inverse() : Eigen::Affine3d::Identity();
 
-  Eigen::Affine3d link_transform = reference_transform * getGlobalLinkTransform(link);
+  link_transform = reference_transform * state.getGlobalLinkTransform(link);
   Eigen::Vector3d point_transform = link_transform * reference_point_position;
 
-  /*
-  logDebug("Point from reference origin expressed in world coordinates: %f %f %f",
-           point_transform.x(),
-           point_transform.y(),
-           point_transform.z());
-  */
-
   Eigen::Vector3d joint_axis;
   Eigen::Affine3d joint_transform;
 
   while (link)
   {
-    /*
-    logDebug("Link: %s, %f %f %f",link_state->getName().c_str(),
-             link_state->getGlobalLinkTransform().translation().x(),
-             link_state->getGlobalLinkTransform().translation().y(),
-             link_state->getGlobalLinkTransform().translation().z());
-    logDebug("Joint: %s",link_state->getParentJointState()->getName().c_str());
-    */
-    const JointModel* pjm = link->getParentJointModel();
+    const moveit::core::JointModel* pjm = link->getParentJointModel();
     if (pjm->getVariableCount() > 0)
     {
       unsigned int joint_index = group->getVariableGroupIndex(pjm->getName());
-      if (pjm->getType() == robot_model::JointModel::REVOLUTE)
+      if (pjm->getType() == moveit::core::JointModel::REVOLUTE)
       {
-        joint_transform = reference_transform * getGlobalLinkTransform(link);
-        joint_axis = joint_transform.rotation() * static_cast<const robot_model::RevoluteJointModel*>(pjm)->getAxis();
-        jacobian.block<3, 1>(0, joint_index) =
-            jacobian.block<3, 1>(0, joint_index) + joint_axis.cross(point_transform - joint_transform.translation());
-        jacobian.block<3, 1>(3, joint_index) = jacobian.block<3, 1>(3, joint_index) + joint_axis;
+        joint_transform = reference_transform * state.getGlobalLinkTransform(link);
+        joint_axis = joint_transform.linear() * static_cast<const moveit::core::RevoluteJointModel*>(pjm)->getAxis();
+        jacobian.template block<3, 1>(0, joint_index) +=
+            joint_axis.cross(point_transform - joint_transform.translation());
+        jacobian.template block<3, 1>(3, joint_index) += joint_axis;
       }
-      else if (pjm->getType() == robot_model::JointModel::PRISMATIC)
+      else if (pjm->getType() == moveit::core::JointModel::PRISMATIC)
       {
-        joint_transform = reference_transform * getGlobalLinkTransform(link);
-        joint_axis = joint_transform * static_cast<const robot_model::PrismaticJointModel*>(pjm)->getAxis();
-        jacobian.block<3, 1>(0, joint_index) = jacobian.block<3, 1>(0, joint_index) + joint_axis;
+        joint_transform = reference_transform * state.getGlobalLinkTransform(link);
+        joint_axis = joint_transform * static_cast<const moveit::core::PrismaticJointModel*>(pjm)->getAxis();
+        jacobian.template block<3, 1>(0, joint_index) += joint_axis;
       }
-      else if (pjm->getType() == robot_model::JointModel::PLANAR)
+      else if (pjm->getType() == moveit::core::JointModel::PLANAR)
       {
-        joint_transform = reference_transform * getGlobalLinkTransform(link);
+        joint_transform = reference_transform * state.getGlobalLinkTransform(link);
         joint_axis = joint_transform * Eigen::Vector3d(1.0, 0.0, 0.0);
-        jacobian.block<3, 1>(0, joint_index) = jacobian.block<3, 1>(0, joint_index) + joint_axis;
+        jacobian.template block<3, 1>(0, joint_index) += joint_axis;
         joint_axis = joint_transform * Eigen::Vector3d(0.0, 1.0, 0.0);
-        jacobian.block<3, 1>(0, joint_index + 1) = jacobian.block<3, 1>(0, joint_index + 1) + joint_axis;
+        jacobian.template block<3, 1>(0, joint_index + 1) += joint_axis;
         joint_axis = joint_transform * Eigen::Vector3d(0.0, 0.0, 1.0);
-        jacobian.block<3, 1>(0, joint_index + 2) = jacobian.block<3, 1>(0, joint_index + 2) +
-                                                   joint_axis.cross(point_transform - joint_transform.translation());
-        jacobian.block<3, 1>(3, joint_index + 2) = jacobian.block<3, 1>(3, joint_index + 2) + joint_axis;
+        jacobian.template block<3, 1>(0, joint_index + 2) +=
+            joint_axis.cross(point_transform - joint_transform.translation());
+        jacobian.template block<3, 1>(3, joint_index + 2) += joint_axis;
       }
       else
         logError("Unknown type of joint in Jacobian computation");
@@ -1203,6 +1236,104 @@ bool moveit::core::RobotState::getJacobian(const JointModelGroup* group, const L
       break;
     link = pjm->getParentLinkModel();
   }
+}
+
+/** \brief Compute the velocities of the variables of a group with \e Columns variables, using fixed-size matrices */
+template <int Columns>
+void computeFixedSizeVariableVelocity(const moveit::core::RobotState& state, const moveit::core::JointModelGroup* jmg,
+                                      Eigen::Matrix<double, Columns, 1>& qdot, const Eigen::Matrix<double, 6, 1>& twist,
+                                      const moveit::core::LinkModel* tip)
+{
+  Eigen::Matrix<double, 6, Columns> J;
+  if (!state.getJacobian(jmg, tip, Eigen::Vector3d(0.0, 0.0, 0.0), J))
+  {
+    qdot.setZero();
+    return;
+  }
+
+  // Rotate the jacobian to the end-effector frame
+  const Eigen::Matrix3d eRb = state.getGlobalLinkTransform(tip).inverse().linear();
+  J.template topRows<3>() = eRb * J.template topRows<3>();
+  J.template bottomRows<3>() = eRb * J.template bottomRows<3>();
+
+  // Do the Jacobian moore-penrose pseudo-inverse; thin U and V are not available for fixed-size matrices, but only
+  // the first 6 columns of V are needed
+  Eigen::JacobiSVD<Eigen::Matrix<double, 6, Columns> > svdOfJ(J, Eigen::ComputeFullU | Eigen::ComputeFullV);
+  const Eigen::Matrix<double, 6, 1>& S = svdOfJ.singularValues();
+
+  Eigen::Matrix<double, 6, 1> Sinv;
+  static const double pinvtoler = std::numeric_limits<float>::epsilon();
+  const double maxsv = S.cwiseAbs().maxCoeff();
+  for (int i = 0; i < 6; ++i)
+  {
+    // Those singular values smaller than a percentage of the maximum singular value are removed
+    if (fabs(S(i)) > maxsv * pinvtoler)
+      Sinv(i) = 1.0 / S(i);
+    else
+      Sinv(i) = 0.0;
+  }
+
+  // Compute joint velocity
+  qdot = svdOfJ.matrixV().template leftCols<6>() * (Sinv.asDiagonal() * (svdOfJ.matrixU().transpose() * twist));
+}
+
+/** \brief setFromDiffIK() for a group with \e Columns variables; all the vectors are fixed-size, so nothing is
+    allocated on the heap */
+template <int Columns>
+bool setFromFixedSizeDiffIK(moveit::core::RobotState& state, const moveit::core::JointModelGroup* jmg,
+                            const Eigen::Matrix<double, 6, 1>& twist, const moveit::core::LinkModel* tip, double dt,
+                            const moveit::core::GroupStateValidityCallbackFn& constraint)
+{
+  state.updateLinkTransforms();
+  Eigen::Matrix<double, Columns, 1> qdot;
+  computeFixedSizeVariableVelocity<Columns>(state, jmg, qdot, twist, tip);
+
+  Eigen::Matrix<double, Columns, 1> q;
+  state.copyJointGroupPositions(jmg, q.data());
+  q += dt * qdot;
+  state.setJointGroupPositions(jmg, q.data());
+  state.enforceBounds(jmg);
+
+  if (!constraint)
+    return true;
+  state.copyJointGroupPositions(jmg, q.data());
+  return constraint(&state, jmg, q.data());
+}
+}
+
+bool moveit::core::RobotState::checkJacobianInputs(const JointModelGroup* group, const LinkModel* link) const
+{
+  BOOST_VERIFY(checkLinkTransforms());
+
+  if (!group->isChain())
+  {
+    logError("The group '%s' is not a chain. Cannot compute Jacobian.", group->getName().c_str());
+    return false;
+  }
+
+  if (!group->isLinkUpdated(link->getName()))
+  {
+    logError("Link name '%s' does not exist in the chain '%s' or is not a child for this chain",
+             link->getName().c_str(), group->getName().c_str());
+    return false;
+  }
+  return true;
+}
+
+bool moveit::core::RobotState::getJacobian(const JointModelGroup* group, const LinkModel* link,
+                                           const Eigen::Vector3d& reference_point_position, Eigen::MatrixXd& jacobian,
+                                           bool use_quaternion_representation) const
+{
+  if (!checkJacobianInputs(group, link))
+    return false;
+
+  int rows = use_quaternion_representation ? 7 : 6;
+  int columns = group->getVariableCount();
+  jacobian = Eigen::MatrixXd::Zero(rows, columns);
+
+  Eigen::Affine3d link_transform;
+  computeJacobian(*this, group, link, reference_point_position, link_transform, jacobian);
+
   if (use_quaternion_representation)
   {  // Quaternion representation
     // From "Advanced Dynamics and Motion Simulation" by Paul Mitiguy
@@ -1219,10 +1350,52 @@ bool moveit::core::RobotState::getJacobian(const JointModelGroup* group, const L
   return true;
 }
 
+bool moveit::core::RobotState::getJacobian(const JointModelGroup* group, const LinkModel* link,
+                                           const Eigen::Vector3d& reference_point_position,
+                                           Eigen::Matrix<double, 6, 6>& jacobian) const
+{
+  if (!checkJacobianInputs(group, link))
+    return false;
+  if (group->getVariableCount() != 6)
+  {
+    logError("The group '%s' has %u variables. Cannot compute a 6x6 Jacobian.", group->getName().c_str(),
+             group->getVariableCount());
+    return false;
+  }
+  jacobian.setZero();
+  Eigen::Affine3d link_transform;
+  computeJacobian(*this, group, link, reference_point_position, link_transform, jacobian);
+  return true;
+}
+
+bool moveit::core::RobotState::getJacobian(const JointModelGroup* group, const LinkModel* link,
+                                           const Eigen::Vector3d& reference_point_position,
+                                           Eigen::Matrix<double, 6, 7>& jacobian) const
+{
+  if (!checkJacobianInputs(group, link))
+    return false;
+  if (group->getVariableCount() != 7)
+  {
+    logError("The group '%s' has %u variables. Cannot compute a 6x7 Jacobian.", group->getName().c_str(),
+             group->getVariableCount());
+    return false;
+  }
+  jacobian.setZero();
+  Eigen::Affine3d link_transform;
+  computeJacobian(*this, group, link, reference_point_position, link_transform, jacobian);
+  return true;
+}
+
 bool moveit::core::RobotState::setFromDiffIK(const JointModelGroup* jmg, const Eigen::VectorXd& twist,
                                              const std::string& tip, double dt,
                                              const GroupStateValidityCallbackFn& constraint)
 {
+  // most arms have 6 or 7 joints; use fixed-size vectors for those
+  if (twist.rows() == 6 && jmg->getVariableCount() == 6)
+    return setFromFixedSizeDiffIK<6>(*this, jmg, twist.head<6>(), getLinkModel(tip), dt, constraint);
+  if (twist.rows() == 6 && jmg->getVariableCount() == 7)
+    return setFromFixedSizeDiffIK<7>(*this, jmg, twist.head<6>(), getLinkModel(tip), dt, constraint);
+
   Eigen::VectorXd qdot;
   computeVariableVelocity(jmg, qdot, twist, getLinkModel(tip));
   return integrateVariableVelocity(jmg, qdot, dt, constraint);
@@ -1234,12 +1407,32 @@ bool moveit::core::RobotState::setFromDiffIK(const JointModelGroup* jmg, const g
 {
   Eigen::Matrix<double, 6, 1> t;
   tf::twistMsgToEigen(twist, t);
-  return setFromDiffIK(jmg, t, tip, dt, constraint);
+  if (jmg->getVariableCount() == 6)
+    return setFromFixedSizeDiffIK<6>(*this, jmg, t, getLinkModel(tip), dt, constraint);
+  if (jmg->getVariableCount() == 7)
+    return setFromFixedSizeDiffIK<7>(*this, jmg, t, getLinkModel(tip), dt, constraint);
+  return setFromDiffIK(jmg, Eigen::VectorXd(t), tip, dt, constraint);
 }
 
 void moveit::core::RobotState::computeVariableVelocity(const JointModelGroup* jmg, Eigen::VectorXd& qdot,
                                                        const Eigen::VectorXd& twist, const LinkModel* tip) const
 {
+  // most arms have 6 or 7 joints; use fixed-size matrices for those, and only resize qdot if it has another size
+  if (twist.rows() == 6 && jmg->getVariableCount() == 6)
+  {
+    Eigen::Matrix<double, 6, 1> v;
+    computeFixedSizeVariableVelocity<6>(*this, jmg, v, twist.head<6>(), tip);
+    qdot = v;
+    return;
+  }
+  if (twist.rows() == 6 && jmg->getVariableCount() == 7)
+  {
+    Eigen::Matrix<double, 7, 1> v;
+    computeFixedSizeVariableVelocity<7>(*this, jmg, v, twist.head<6>(), tip);
+    qdot = v;
+    return;
+  }
+
   // Get the Jacobian of the group at the current configuration
   Eigen::MatrixXd J(6, jmg->getVariableCount());
   Eigen::Vector3d reference_point(0.0, 0.0, 0.0);
@@ -1365,6 +1558,48 @@ bool ikCallbackFnAdapter(RobotState* state, const JointModelGroup* group,
     error_code.val = moveit_msgs::MoveItErrorCodes::NO_IK_SOLUTION;
   return true;
 }
+
+// one IK query of setFromIKSubgroups(), self-contained so that it can run on a separate thread
+struct SubgroupIKQuery
+{
+  const kinematics::KinematicsBase* solver;
+  const geometry_msgs::Pose* pose;
+  const std::vector<double>* consistency_limits;
+  double timeout;
+  std::vector<double> seed;
+  std::vector<double> solution;
+  bool success;
+};
+
+void solveSubgroupIK(SubgroupIKQuery* query)
+{
+  moveit_msgs::MoveItErrorCodes error;
+  query->success = query->solver->searchPositionIK(*query->pose, query->seed, query->timeout,
+                                                   *query->consistency_limits, query->solution, error);
+}
+
+// the seed is in the order of the solver's joints
+void getSubgroupIKSeed(RobotState* state, const JointModelGroup* group, bool random, std::vector<double>& seed)
+{
+  const std::vector<unsigned int>& bij = group->getKinematicsSolverJointBijection();
+  std::vector<double> values;
+  if (random)
+    group->getVariableRandomPositions(state->getRandomNumberGenerator(), values);
+  else
+    state->copyJointGroupPositions(group, values);
+  seed.resize(bij.size());
+  for (std::size_t i = 0; i < bij.size(); ++i)
+    seed[i] = values[bij[i]];
+}
+
+void setSubgroupIKSolution(RobotState* state, const JointModelGroup* group, const std::vector<double>& ik_sol)
+{
+  const std::vector<unsigned int>& bij = group->getKinematicsSolverJointBijection();
+  std::vector<double> solution(bij.size());
+  for (std::size_t i = 0; i < bij.size(); ++i)
+    solution[bij[i]] = ik_sol[i];
+  state->setJointGroupPositions(group, solution);
+}
 }
 }
 }
@@ -1625,6 +1860,12 @@ bool moveit::core::RobotState::setFromIK(const JointModelGroup* jmg, const Eigen
   // Bijection
   const std::vector<unsigned int>& bij = jmg->getKinematicsSolverJointBijection();
 
+  kinematics::IKStatistics& statistics = solver->getSetFromIKStatistics();
+  const bool record_statistics = statistics.isEnabled();
+  std::chrono::steady_clock::time_point start_time;
+  if (record_statistics)
+    start_time = std::chrono::steady_clock::now();
+
   bool first_seed = true;
   std::vector<double> initial_values;
   for (unsigned int st = 0; st < attempts; ++st)
@@ -1671,9 +1912,15 @@ bool moveit::core::RobotState::setFromIK(const JointModelGroup* jmg, const Eigen
       for (std::size_t i = 0; i < bij.size(); ++i)
         solution[bij[i]] = ik_sol[i];
       setJointGroupPositions(jmg, solution);
+      if (record_statistics)
+        statistics.record(std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count(), true,
+                          st);
       return true;
     }
   }
+  if (record_statistics)
+    statistics.record(std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count(), false,
+                      attempts > 0 ? attempts - 1 : 0);
   return false;
 }
 
@@ -1818,60 +2065,97 @@ bool moveit::core::RobotState::setFromIKSubgroups(const JointModelGroup* jmg, co
   if (timeout < std::numeric_limits<double>::epsilon())
     timeout = jmg->getDefaultIKTimeout();
 
+  // subgroups that share joints are solved one after the other, each seeded with the solutions of the ones before
+  // it; the others are independent of each other and are solved concurrently
+  std::vector<bool> coupled(sub_groups.size(), false);
+  for (std::size_t i = 0; i < sub_groups.size(); ++i)
+  {
+    const std::vector<const JointModel*>& joints = sub_groups[i]->getActiveJointModels();
+    for (std::size_t j = i + 1; j < sub_groups.size(); ++j)
+      for (std::size_t k = 0; k < joints.size(); ++k)
+        if (sub_groups[j]->hasJointModel(joints[k]->getName()))
+        {
+          coupled[i] = coupled[j] = true;
+          break;
+        }
+  }
+
+  bool has_coupled = std::find(coupled.begin(), coupled.end(), true) != coupled.end();
+
+  const std::vector<double> no_consistency_limits;
+  std::vector<SubgroupIKQuery> queries(sub_groups.size());
+  for (std::size_t sg = 0; sg < sub_groups.size(); ++sg)
+  {
+    queries[sg].solver = solvers[sg].get();
+    queries[sg].pose = &ik_queries[sg];
+    queries[sg].consistency_limits = consistency_limits.empty() ? &no_consistency_limits : &consistency_limits[sg];
+    queries[sg].timeout = timeout;
+    queries[sg].success = false;
+  }
+
   bool first_seed = true;
   for (unsigned int st = 0; st < attempts; ++st)
   {
-    bool found_solution = true;
+    logDebug("IK attempt: %d of %d", st, attempts);
+
+    // independent subgroups solved in an earlier attempt keep their solution; the rest are solved again
+    std::vector<SubgroupIKQuery*> independent;
     for (std::size_t sg = 0; sg < sub_groups.size(); ++sg)
-    {
-      const std::vector<unsigned int>& bij = sub_groups[sg]->getKinematicsSolverJointBijection();
-      std::vector<double> seed(bij.size());
-      // the first seed is the initial state
-      if (first_seed)
+      if (!coupled[sg] && !queries[sg].success)
       {
-        std::vector<double> initial_values;
-        copyJointGroupPositions(sub_groups[sg], initial_values);
-        for (std::size_t i = 0; i < bij.size(); ++i)
-          seed[i] = initial_values[bij[i]];
-      }
-      else
-      {
-        // sample a random seed
-        random_numbers::RandomNumberGenerator& rng = getRandomNumberGenerator();
-        std::vector<double> random_values;
-        sub_groups[sg]->getVariableRandomPositions(rng, random_values);
-        for (std::size_t i = 0; i < bij.size(); ++i)
-          seed[i] = random_values[bij[i]];
+        getSubgroupIKSeed(this, sub_groups[sg], !first_seed, queries[sg].seed);
+        independent.push_back(&queries[sg]);
       }
 
-      // compute the IK solution
-      std::vector<double> ik_sol;
-      moveit_msgs::MoveItErrorCodes error;
-      const std::vector<double>& climits = consistency_limits.empty() ? std::vector<double>() : consistency_limits[sg];
-      if (solvers[sg]->searchPositionIK(ik_queries[sg], seed, timeout, climits, ik_sol, error))
-      {
-        std::vector<double> solution(bij.size());
-        for (std::size_t i = 0; i < bij.size(); ++i)
-          solution[bij[i]] = ik_sol[i];
-        setJointGroupPositions(sub_groups[sg], solution);
-      }
-      else
+    // when there is nothing coupled to solve, this thread takes the first query itself
+    boost::thread_group threads;
+    for (std::size_t i = has_coupled ? 0 : 1; i < independent.size(); ++i)
+      threads.create_thread(boost::bind(&solveSubgroupIK, independent[i]));
+    if (!has_coupled && !independent.empty())
+      solveSubgroupIK(independent[0]);
+
+    // the coupled subgroups are solved on this thread meanwhile, in order, through the state itself
+    bool coupled_failed = false;
+    for (std::size_t sg = 0; sg < sub_groups.size() && !coupled_failed; ++sg)
+      if (coupled[sg] && !queries[sg].success)
       {
-        found_solution = false;
-        break;
+        getSubgroupIKSeed(this, sub_groups[sg], !first_seed, queries[sg].seed);
+        solveSubgroupIK(&queries[sg]);
+        if (queries[sg].success)
+          setSubgroupIKSolution(this, sub_groups[sg], queries[sg].solution);
+        else
+          coupled_failed = true;
       }
-      logDebug("IK attempt: %d of %d", st, attempts);
-    }
-    if (found_solution)
+    threads.join_all();
+    first_seed = false;
+
+    // a coupled subgroup that fails invalidates the solutions of the others it is coupled with
+    if (coupled_failed)
+      for (std::size_t sg = 0; sg < sub_groups.size(); ++sg)
+        if (coupled[sg])
+          queries[sg].success = false;
+
+    bool found_solution = !coupled_failed;
+    for (std::size_t sg = 0; sg < sub_groups.size(); ++sg)
+      if (!coupled[sg])
+        found_solution &= queries[sg].success;
+    if (!found_solution)
+      continue;
+
+    for (std::size_t sg = 0; sg < sub_groups.size(); ++sg)
+      if (!coupled[sg])
+        setSubgroupIKSolution(this, sub_groups[sg], queries[sg].solution);
+    std::vector<double> full_solution;
+    copyJointGroupPositions(jmg, full_solution);
+    if (constraint ? constraint(this, jmg, &full_solution[0]) : true)
     {
-      std::vector<double> full_solution;
-      copyJointGroupPositions(jmg, full_solution);
-      if (constraint ? constraint(this, jmg, &full_solution[0]) : true)
-      {
-        logDebug("Found IK solution");
-        return true;
-      }
+      logDebug("Found IK solution");
+      return true;
     }
+
+    // the combination is invalid, so none of the solutions can be kept
+    for (std::size_t sg = 0; sg < sub_groups.size(); ++sg)
+      queries[sg].success = false;
   }
   return false;
 }
@@ -1928,6 +2212,20 @@ double moveit::core::RobotState::computeCartesianPath(const JointModelGroup* gro
   std::vector<double> dist_vector;
   double total_dist = 0.0;
 
+  // consecutive waypoints are close to each other, so if the solver supports it we track the solution along the
+  // path and only search (with random restarts) for the waypoints where that fails
+  const kinematics::KinematicsBaseConstPtr& solver = group->getSolverInstance();
+  const std::vector<unsigned int>& bij = group->getKinematicsSolverJointBijection();
+  kinematics::IKTrackingSessionPtr tracking;
+  std::vector<double> values, ik_seed(bij.size()), ik_sol;
+  if (solver && solver->getTipFrames().size() == 1 && solver->getTipFrames()[0] == link->getName())
+  {
+    copyJointGroupPositions(group, values);
+    for (std::size_t i = 0; i < bij.size(); ++i)
+      ik_seed[i] = values[bij[i]];
+    tracking = solver->beginTracking(ik_seed, options);
+  }
+
   double last_valid_percentage = 0.0;
   Eigen::Quaterniond start_quaternion(start_pose.rotation());
   Eigen::Quaterniond target_quaternion(rotated_target.rotation());
@@ -1938,7 +2236,33 @@ double moveit::core::RobotState::computeCartesianPath(const JointModelGroup* gro
     Eigen::Affine3d pose(start_quaternion.slerp(percentage, target_quaternion));
     pose.translation() = percentage * rotated_target.translation() + (1 - percentage) * start_pose.translation();
 
-    if (setFromIK(group, pose, link->getName(), 1, 0.0, validCallback, options))
+    bool found = false;
+    if (tracking)
+    {
+      Eigen::Affine3d ik_pose = pose;
+      moveit_msgs::MoveItErrorCodes error;
+      if (setToIKSolverFrame(ik_pose, solver) && tracking->track(ik_pose, ik_sol, error))
+      {
+        for (std::size_t j = 0; j < bij.size(); ++j)
+          values[bij[j]] = ik_sol[j];
+        setJointGroupPositions(group, values);
+        found = !validCallback || validCallback(this, group, &values[0]);
+      }
+    }
+    if (!found && setFromIK(group, pose, link->getName(), 1, 0.0, validCallback, options))
+    {
+      found = true;
+      if (tracking)
+      {
+        // continue tracking from the solution the search found
+        copyJointGroupPositions(group, values);
+        for (std::size_t j = 0; j < bij.size(); ++j)
+          ik_seed[j] = values[bij[j]];
+        tracking->reset(ik_seed);
+      }
+    }
+
+    if (found)
     {
       traj.push_back(RobotStatePtr(new RobotState(*this)));
 
@@ -2007,6 +2331,109 @@ double moveit::core::RobotState::computeCartesianPath(const JointModelGroup* gro
   return percentage_solved;
 }
 
+double moveit::core::RobotState::computeCartesianPathBatch(const JointModelGroup* group,
+                                                           std::vector<RobotStatePtr>& traj, const LinkModel* link,
+                                                           const EigenSTL::vector_Affine3d& waypoints,
+                                                           bool global_reference_frame, double max_step,
+                                                           double jump_threshold,
+                                                           const GroupStatesValidityCallbackFn& validCallback,
+                                                           const kinematics::KinematicsQueryOptions& options)
+{
+  traj.clear();
+  if (waypoints.empty())
+    return 0.0;
+
+  const std::vector<const JointModel*>& cjnt = group->getContinuousJointModels();
+  // make sure that continuous joints wrap
+  for (std::size_t i = 0; i < cjnt.size(); ++i)
+    enforceBounds(cjnt[i]);
+
+  bool test_joint_space_jump = jump_threshold > 0.0;
+
+  // for every state after the first one, the waypoint segment it belongs to and the fraction of that segment
+  // completed once the state is reached
+  std::vector<std::size_t> segment;
+  std::vector<double> segment_percentage;
+
+  traj.push_back(RobotStatePtr(new RobotState(*this)));
+
+  // solve IK for all the poses of all the segments, each solution seeding the next one; validity is checked at the end
+  Eigen::Affine3d start_pose = getGlobalLinkTransform(link);
+  bool ik_failed = false;
+  for (std::size_t w = 0; w < waypoints.size() && !ik_failed; ++w)
+  {
+    // the target can be in the local reference frame (in which case we rotate it)
+    Eigen::Affine3d rotated_target = global_reference_frame ? waypoints[w] : start_pose * waypoints[w];
+
+    double distance = (rotated_target.translation() - start_pose.translation()).norm();
+    unsigned int steps = (test_joint_space_jump ? 5 : 1) + (unsigned int)floor(distance / max_step);
+
+    Eigen::Quaterniond start_quaternion(start_pose.rotation());
+    Eigen::Quaterniond target_quaternion(rotated_target.rotation());
+    for (unsigned int i = 1; i <= steps; ++i)
+    {
+      double percentage = (double)i / (double)steps;
+
+      Eigen::Affine3d pose(start_quaternion.slerp(percentage, target_quaternion));
+      pose.translation() = percentage * rotated_target.translation() + (1 - percentage) * start_pose.translation();
+
+      if (!setFromIK(group, pose, link->getName(), 1, 0.0, GroupStateValidityCallbackFn(), options))
+      {
+        ik_failed = true;
+        break;
+      }
+      traj.push_back(RobotStatePtr(new RobotState(*this)));
+      segment.push_back(w);
+      segment_percentage.push_back(percentage);
+    }
+
+    // the next segment starts where this one was supposed to end
+    start_pose = rotated_target;
+  }
+
+  // validate all the computed states at once; the first state is the start state and is not checked
+  std::size_t valid = traj.size();
+  if (validCallback && traj.size() > 1)
+  {
+    std::vector<const RobotState*> states(traj.size() - 1);
+    for (std::size_t i = 1; i < traj.size(); ++i)
+      states[i - 1] = traj[i].get();
+    valid = 1 + validCallback(states, group);
+  }
+
+  // check for jumps in joint space, relative to the average distance between consecutive states of each segment
+  if (test_joint_space_jump && valid > 1)
+  {
+    std::vector<double> dist_vector(valid - 1);
+    for (std::size_t i = 1; i < valid; ++i)
+      dist_vector[i - 1] = traj[i]->distance(*traj[i - 1], group);
+
+    for (std::size_t first = 0; first < dist_vector.size();)
+    {
+      std::size_t last = first;
+      double total_dist = 0.0;
+      while (last < dist_vector.size() && segment[last] == segment[first])
+        total_dist += dist_vector[last++];
+      double thres = jump_threshold * (total_dist / (double)(last - first));
+      for (std::size_t i = first; i < last; ++i)
+        if (dist_vector[i] > thres)
+        {
+          logDebug("Truncating Cartesian path due to detected jump in joint-space distance");
+          valid = i + 1;
+          break;
+        }
+      if (valid <= last)
+        break;
+      first = last;
+    }
+  }
+
+  traj.resize(valid);
+  if (valid < 2)
+    return 0.0;
+  return ((double)segment[valid - 2] + segment_percentage[valid - 2]) / (double)waypoints.size();
+}
+
 namespace
 {
 static inline void updateAABB(const Eigen::Affine3d& t, const Eigen::Vector3d& e, std::vector<double>& aabb)
@@ -0,0 +1,178 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2026, the MoveIt contributors
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the copyright holder nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+#include <moveit/robot_state/robot_state_pool.h>
+#include <boost/thread/mutex.hpp>
+
+namespace moveit
+{
+namespace core
+{
+/** \brief The unused states of a pool. The states handed out hold a pointer to this, so they can return to it even if
+    the pool itself was destroyed. */
+class RobotStatePool::Storage
+{
+public:
+  Storage(const RobotModelConstPtr& robot_model, std::size_t max_size) : robot_model_(robot_model), max_size_(max_size)
+  {
+  }
+
+  ~Storage()
+  {
+    clear();
+  }
+
+  RobotState* pop()
+  {
+    {
+      boost::mutex::scoped_lock slock(lock_);
+      if (!states_.empty())
+      {
+        RobotState* state = states_.back();
+        states_.pop_back();
+        return state;
+      }
+    }
+    return new RobotState(robot_model_);
+  }
+
+  void push(RobotState* state)
+  {
+    // do not keep attached bodies (and their shapes) alive while the state is unused
+    state->clearAttachedBodies();
+    {
+      boost::mutex::scoped_lock slock(lock_);
+      if (states_.size() < max_size_)
+      {
+        states_.push_back(state);
+        return;
+      }
+    }
+    delete state;
+  }
+
+  void reserve(std::size_t count)
+  {
+    boost::mutex::scoped_lock slock(lock_);
+    while (states_.size() < count)
+      states_.push_back(new RobotState(robot_model_));
+  }
+
+  std::size_t size() const
+  {
+    boost::mutex::scoped_lock slock(lock_);
+    return states_.size();
+  }
+
+  void clear()
+  {
+    std::vector<RobotState*> states;
+    {
+      boost::mutex::scoped_lock slock(lock_);
+      states.swap(states_);
+    }
+    for (std::size_t i = 0; i < states.size(); ++i)
+      delete states[i];
+  }
+
+private:
+  RobotModelConstPtr robot_model_;
+  std::size_t max_size_;
+  std::vector<RobotState*> states_;
+  mutable boost::mutex lock_;
+};
+
+/** \brief The deleter of the states handed out by a pool */
+struct RobotStatePool::ReturnToStorage
+{
+  ReturnToStorage(const StoragePtr& storage) : storage_(storage)
+  {
+  }
+
+  void operator()(RobotState* state) const
+  {
+    storage_->push(state);
+  }
+
+  StoragePtr storage_;
+};
+}
+}
+
+moveit::core::RobotStatePool::RobotStatePool(const RobotModelConstPtr& robot_model, std::size_t max_size)
+  : robot_model_(robot_model), storage_(new Storage(robot_model, max_size))
+{
+}
+
+moveit::core::RobotStatePool::~RobotStatePool()
+{
+}
+
+moveit::core::RobotStatePtr moveit::core::RobotStatePool::allocate()
+{
+  RobotState* state = storage_->pop();
+  resetState(state);
+  return RobotStatePtr(state, ReturnToStorage(storage_));
+}
+
+moveit::core::RobotStatePtr moveit::core::RobotStatePool::allocate(const RobotState& state)
+{
+  RobotStatePtr result = allocate();
+  *result = state;
+  return result;
+}
+
+void moveit::core::RobotStatePool::resetState(RobotState* state)
+{
+  state->has_velocity_ = false;
+  state->has_acceleration_ = false;
+  state->has_effort_ = false;
+  state->markDirtyAllTransforms();
+  state->dirty_collision_body_transforms_ = NULL;
+}
+
+void moveit::core::RobotStatePool::reserve(std::size_t count)
+{
+  storage_->reserve(count);
+}
+
+std::size_t moveit::core::RobotStatePool::getCachedCount() const
+{
+  return storage_->size();
+}
+
+void moveit::core::RobotStatePool::clear()
+{
+  storage_->clear();
+}
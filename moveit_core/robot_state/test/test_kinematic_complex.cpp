@@ -36,6 +36,9 @@
 
 #include <moveit/robot_model/robot_model.h>
 #include <moveit/robot_state/robot_state.h>
+#include <moveit/robot_state/batch_robot_state.h>
+#include <moveit/robot_state/cartesian_servo.h>
+#include <moveit/robot_state/robot_state_pool.h>
 #include <moveit/robot_state/conversions.h>
 #include <urdf_parser/urdf_parser.h>
 #include <fstream>
@@ -276,6 +279,289 @@ TEST_F(LoadPlanningModelsPr2, FullTest)
   ASSERT_EQ(attached_bodies_2.size(), 0);
 }
 
+TEST_F(LoadPlanningModelsPr2, BatchForwardKinematics)
+{
+  const moveit::core::JointModelGroup* jmg = robot_model->getJointModelGroup("whole_body");
+  ASSERT_TRUE(jmg);
+
+  moveit::core::RobotState state(robot_model);
+  state.setToDefaultValues();
+  moveit::core::BatchRobotState batch(state, jmg);
+
+  const std::size_t count = 10;
+  std::vector<moveit::core::RobotState> states(count, state);
+  std::vector<double> positions;
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    states[i].setToRandomPositions(jmg);
+    states[i].update();
+    std::vector<double> values;
+    states[i].copyJointGroupPositions(jmg, values);
+    positions.insert(positions.end(), values.begin(), values.end());
+  }
+  batch.computeFKBatch(&positions[0], count);
+  EXPECT_EQ(count, batch.getBatchSize());
+
+  const std::vector<const moveit::core::LinkModel*>& links = robot_model->getLinkModels();
+  for (std::size_t i = 0; i < count; ++i)
+    for (std::size_t j = 0; j < links.size(); ++j)
+      EXPECT_TRUE(batch.getGlobalLinkTransform(links[j], i).isApprox(states[i].getGlobalLinkTransform(links[j]), 1e-9))
+          << "link " << links[j]->getName() << " of configuration " << i;
+}
+
+TEST_F(LoadPlanningModelsPr2, RobotStatePool)
+{
+  moveit::core::RobotState state(robot_model);
+  state.setToRandomPositions();
+
+  moveit::core::RobotStatePool pool(robot_model, 2);
+  pool.reserve(1);
+  EXPECT_EQ(1u, pool.getCachedCount());
+
+  moveit::core::RobotStatePtr copy = pool.allocate(state);
+  EXPECT_EQ(0u, pool.getCachedCount());
+  for (std::size_t i = 0; i < robot_model->getVariableCount(); ++i)
+    EXPECT_EQ(state.getVariablePosition(i), copy->getVariablePosition(i));
+
+  // released states go back to the pool and are handed out again, as if they were new
+  copy->setVariableVelocities(std::vector<double>(robot_model->getVariableCount(), 1.0));
+  copy->update();
+  EXPECT_FALSE(copy->dirty());
+  moveit::core::RobotState* address = copy.get();
+  copy.reset();
+  EXPECT_EQ(1u, pool.getCachedCount());
+  copy = pool.allocate();
+  EXPECT_EQ(address, copy.get());
+  EXPECT_TRUE(copy->dirtyLinkTransforms());
+  EXPECT_TRUE(copy->dirtyCollisionBodyTransforms());
+  EXPECT_FALSE(copy->hasVelocities());
+
+  // the pool keeps at most two unused states
+  std::vector<moveit::core::RobotStatePtr> states(4);
+  for (std::size_t i = 0; i < states.size(); ++i)
+    states[i] = pool.allocate(state);
+  states.clear();
+  EXPECT_EQ(2u, pool.getCachedCount());
+
+  // states may outlive the pool
+  moveit::core::RobotStatePoolPtr temporary_pool(new moveit::core::RobotStatePool(robot_model));
+  copy = temporary_pool->allocate(state);
+  temporary_pool.reset();
+  copy.reset();
+}
+
+TEST_F(LoadPlanningModelsPr2, IncrementalLinkUpdates)
+{
+  moveit::core::RobotState state(robot_model);
+  state.setToRandomPositions();
+  state.updateCollisionBodyTransforms();
+  const std::size_t link_count = state.getLinkTransformUpdateCount();
+  const std::size_t body_count = state.getCollisionBodyTransformUpdateCount();
+
+  // moving a wrist joint only recomputes the links below it
+  state.setVariablePosition("r_wrist_roll_joint", state.getVariablePosition("r_wrist_roll_joint") + 0.5);
+  state.updateCollisionBodyTransforms();
+  EXPECT_LT(state.getLinkTransformUpdateCount() - link_count, robot_model->getLinkModelCount() / 2);
+  EXPECT_GT(state.getLinkTransformUpdateCount(), link_count);
+  EXPECT_LT(state.getCollisionBodyTransformUpdateCount() - body_count, body_count);
+
+  // the result matches a state that computed everything
+  moveit::core::RobotState reference(robot_model);
+  reference.setVariablePositions(state.getVariablePositions());
+  reference.updateCollisionBodyTransforms();
+  const std::vector<const moveit::core::LinkModel*>& links = robot_model->getLinkModels();
+  for (std::size_t i = 0; i < links.size(); ++i)
+  {
+    EXPECT_TRUE(state.getGlobalLinkTransform(links[i]).isApprox(reference.getGlobalLinkTransform(links[i]), 1e-9))
+        << "link " << links[i]->getName();
+    for (std::size_t j = 0; j < links[i]->getShapes().size(); ++j)
+    {
+      const Eigen::Affine3d& expected = reference.getCollisionBodyTransform(links[i], j);
+      EXPECT_TRUE(state.getCollisionBodyTransform(links[i], j).isApprox(expected, 1e-9))
+          << "link " << links[i]->getName();
+    }
+  }
+}
+
+TEST_F(LoadPlanningModelsPr2, LinkTransformChain)
+{
+  moveit::core::RobotState state(robot_model);
+  state.setToRandomPositions();
+  state.update();
+
+  // the torso moves both arms, but only the chain to the right wrist is computed
+  state.setVariablePosition("torso_lift_joint", state.getVariablePosition("torso_lift_joint") + 0.05);
+  state.setVariablePosition("r_shoulder_pan_joint", state.getVariablePosition("r_shoulder_pan_joint") + 0.3);
+  const moveit::core::LinkModel* right = robot_model->getLinkModel("r_wrist_roll_link");
+  const moveit::core::LinkModel* left = robot_model->getLinkModel("l_wrist_roll_link");
+  state.updateLinkTransformChain(right);
+  const moveit::core::RobotState& const_state = state;
+  EXPECT_FALSE(const_state.dirtyLinkTransform(right));
+  EXPECT_TRUE(const_state.dirtyLinkTransform(left));
+  EXPECT_TRUE(const_state.dirtyLinkTransforms());
+
+  moveit::core::RobotState reference(robot_model);
+  reference.setVariablePositions(state.getVariablePositions());
+  reference.update();
+  EXPECT_TRUE(const_state.getGlobalLinkTransform(right).isApprox(reference.getGlobalLinkTransform(right), 1e-9));
+
+  // the next full update still covers the links outside the chain
+  state.update();
+  const std::vector<const moveit::core::LinkModel*>& links = robot_model->getLinkModels();
+  for (std::size_t i = 0; i < links.size(); ++i)
+    EXPECT_TRUE(state.getGlobalLinkTransform(links[i]).isApprox(reference.getGlobalLinkTransform(links[i]), 1e-9))
+        << "link " << links[i]->getName();
+}
+
+TEST_F(LoadPlanningModelsPr2, FixedSizeJacobian)
+{
+  moveit::core::RobotState state(robot_model);
+  state.setToRandomPositions();
+  state.update();
+
+  const moveit::core::JointModelGroup* jmg = robot_model->getJointModelGroup("right_arm");
+  ASSERT_TRUE(jmg->isChain());
+  ASSERT_EQ(7u, jmg->getVariableCount());
+  const moveit::core::LinkModel* tip = jmg->getLinkModels().back();
+  Eigen::Vector3d reference_point(0.1, 0.0, 0.0);
+
+  Eigen::MatrixXd dynamic_jacobian;
+  Eigen::Matrix<double, 6, 7> fixed_jacobian;
+  Eigen::Matrix<double, 6, 6> wrong_size_jacobian;
+  EXPECT_TRUE(state.getJacobian(jmg, tip, reference_point, dynamic_jacobian));
+  EXPECT_TRUE(state.getJacobian(jmg, tip, reference_point, fixed_jacobian));
+  EXPECT_FALSE(state.getJacobian(jmg, tip, reference_point, wrong_size_jacobian));
+  EXPECT_TRUE(fixed_jacobian.isApprox(dynamic_jacobian, 1e-12));
+
+  // the fixed-size velocity computation matches the pseudo-inverse of the generic Jacobian
+  Eigen::VectorXd twist(6);
+  twist << 0.1, -0.2, 0.05, 0.0, 0.3, -0.1;
+  Eigen::VectorXd qdot;
+  state.computeVariableVelocity(jmg, qdot, twist, tip);
+  ASSERT_EQ(7, qdot.rows());
+
+  state.getJacobian(jmg, tip, Eigen::Vector3d(0.0, 0.0, 0.0), dynamic_jacobian);
+  Eigen::MatrixXd eWb = Eigen::MatrixXd::Zero(6, 6);
+  eWb.block(0, 0, 3, 3) = state.getGlobalLinkTransform(tip).inverse().linear();
+  eWb.block(3, 3, 3, 3) = eWb.block(0, 0, 3, 3);
+  Eigen::MatrixXd J = eWb * dynamic_jacobian;
+  Eigen::VectorXd expected = J.jacobiSvd(Eigen::ComputeThinU | Eigen::ComputeThinV).solve(twist);
+  EXPECT_TRUE(qdot.isApprox(expected, 1e-6));
+}
+
+TEST_F(LoadPlanningModelsPr2, CartesianServo)
+{
+  moveit::core::RobotState state(robot_model);
+  state.setToRandomPositions();
+  state.update();
+
+  const moveit::core::JointModelGroup* jmg = robot_model->getJointModelGroup("right_arm");
+  const moveit::core::LinkModel* tip = jmg->getLinkModels().back();
+  moveit::core::CartesianServo servo(jmg, tip);
+
+  // without damping and singularity or position limit margins, the velocity is the pseudo-inverse solution, scaled
+  // to respect the velocity limits
+  servo.setDamping(0.0);
+  servo.setSingularityThresholds(0.0, 0.0);
+  servo.setJointLimitMargin(0.0);
+  Eigen::Matrix<double, 6, 1> twist;
+  twist << 0.1, -0.2, 0.05, 0.0, 0.3, -0.1;
+  Eigen::VectorXd qdot;
+  double scale = servo.computeJointVelocity(state, twist, qdot);
+  ASSERT_EQ(7, qdot.rows());
+  ASSERT_GT(scale, 0.0);
+  EXPECT_LE(scale, 1.0);
+  Eigen::VectorXd expected;
+  state.computeVariableVelocity(jmg, expected, twist, tip);
+  EXPECT_TRUE(qdot.isApprox(scale * expected, 1e-6));
+
+  // commands that take the robot closer than the stop distance to an obstacle are rejected, unless it moves away
+  std::vector<double> distances = { 0.02, 0.03, 0.01 };
+  std::size_t calls = 0;
+  servo.setProximityFunction([&](const moveit::core::RobotState&) { return distances[calls++]; }, 0.1, 0.05);
+
+  Eigen::VectorXd start, positions;
+  state.copyJointGroupPositions(jmg, start);
+  EXPECT_GT(servo.update(state, twist, 0.01), 0.0);
+  state.copyJointGroupPositions(jmg, positions);
+  EXPECT_FALSE(positions.isApprox(start));
+
+  start = positions;
+  EXPECT_EQ(0.0, servo.update(state, twist, 0.01));
+  state.copyJointGroupPositions(jmg, positions);
+  EXPECT_TRUE(positions.isApprox(start));
+  EXPECT_TRUE(servo.getJointVelocity().isZero());
+  EXPECT_EQ(3u, calls);
+}
+
+TEST_F(LoadPlanningModelsPr2, ThreadRandomNumberGenerator)
+{
+  // states share the generator of the thread, which can be seeded to reproduce the samples
+  moveit::core::RobotState state1(robot_model);
+  moveit::core::RobotState state2(robot_model);
+  EXPECT_EQ(&state1.getRandomNumberGenerator(), &state2.getRandomNumberGenerator());
+
+  moveit::core::seedThreadRandomNumberGenerator(42);
+  state1.setToRandomPositions();
+  moveit::core::seedThreadRandomNumberGenerator(42);
+  state2.setToRandomPositions();
+  for (std::size_t i = 0; i < robot_model->getVariableCount(); ++i)
+    EXPECT_EQ(state1.getVariablePosition(i), state2.getVariablePosition(i));
+}
+
+TEST_F(LoadPlanningModelsPr2, SharedAttachedBodyGeometry)
+{
+  moveit::core::RobotModelPtr robot_model(new moveit::core::RobotModel(urdf_model, srdf_model));
+  moveit::core::RobotState state(robot_model);
+  state.setToDefaultValues();
+  state.update();
+
+  std::vector<shapes::ShapeConstPtr> shapes(1, shapes::ShapeConstPtr(new shapes::Box(.1, .1, .1)));
+  EigenSTL::vector_Affine3d poses(1, Eigen::Affine3d::Identity());
+  state.attachBody("box", shapes, poses, std::set<std::string>(), "r_gripper_palm_link");
+
+  // copies share the geometry and get the global transforms of the original
+  moveit::core::RobotState copy(state);
+  const moveit::core::AttachedBody* body = state.getAttachedBody("box");
+  const moveit::core::AttachedBody* copied_body = copy.getAttachedBody("box");
+  ASSERT_TRUE(copied_body);
+  EXPECT_EQ(body->getShapes()[0], copied_body->getShapes()[0]);
+  EXPECT_TRUE(copied_body->getGlobalCollisionBodyTransforms()[0].isApprox(
+      copy.getGlobalLinkTransform("r_gripper_palm_link"), 1e-12));
+
+  // and move with the state they are in
+  copy.setToRandomPositions();
+  copy.update();
+  EXPECT_TRUE(copied_body->getGlobalCollisionBodyTransforms()[0].isApprox(
+      copy.getGlobalLinkTransform("r_gripper_palm_link"), 1e-12));
+
+  // padding a copy does not change the original
+  const_cast<moveit::core::AttachedBody*>(copied_body)->setPadding(0.1);
+  EXPECT_NE(body->getShapes()[0], copied_body->getShapes()[0]);
+  EXPECT_DOUBLE_EQ(0.1, static_cast<const shapes::Box*>(body->getShapes()[0].get())->size[0]);
+
+  // converting the same attached object again reuses its shapes
+  moveit_msgs::RobotState msg;
+  moveit::core::robotStateToRobotStateMsg(state, msg);
+  moveit::core::RobotState converted1(robot_model);
+  converted1.setToDefaultValues();
+  moveit::core::robotStateMsgToRobotState(msg, converted1);
+  moveit::core::RobotState converted2(robot_model);
+  converted2.setToDefaultValues();
+  moveit::core::robotStateMsgToRobotState(msg, converted2);
+  ASSERT_TRUE(converted1.getAttachedBody("box") && converted2.getAttachedBody("box"));
+  EXPECT_EQ(converted1.getAttachedBody("box")->getShapes()[0], converted2.getAttachedBody("box")->getShapes()[0]);
+
+  // unless the object changed
+  msg.attached_collision_objects[0].object.primitives[0].dimensions[0] = 0.2;
+  moveit::core::RobotState converted3(robot_model);
+  converted3.setToDefaultValues();
+  moveit::core::robotStateMsgToRobotState(msg, converted3);
+  const moveit::core::AttachedBody* converted_body = converted3.getAttachedBody("box");
+  ASSERT_TRUE(converted_body);
+  EXPECT_DOUBLE_EQ(0.2, static_cast<const shapes::Box*>(converted_body->getShapes()[0].get())->size[0]);
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,219 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_ROBOT_TRAJECTORY_COMPACT_ROBOT_TRAJECTORY_
+#define MOVEIT_ROBOT_TRAJECTORY_COMPACT_ROBOT_TRAJECTORY_
+
+#include <moveit/robot_trajectory/robot_trajectory.h>
+#include <vector>
+
+namespace robot_trajectory
+{
+MOVEIT_CLASS_FORWARD(CompactRobotTrajectory);
+
+/** \brief A sequence of waypoints of a joint model group, stored contiguously.
+
+    The positions, velocities and accelerations of the variables of the group are kept in row-major arrays, one row of
+    getVariableCount() values per waypoint; the variables outside the group take their values from a reference state.
+    Unlike RobotTrajectory, no RobotState is allocated per waypoint: states are only built when requested, and a
+    single state can be reused to visit all waypoints. */
+class CompactRobotTrajectory
+{
+public:
+  /** \brief Create an empty trajectory of \e group; if \e group is NULL, all variables of the robot are stored */
+  CompactRobotTrajectory(const robot_state::RobotState& reference_state, const robot_model::JointModelGroup* group);
+
+  /** \brief Copy the waypoints of \e trajectory. Its first waypoint, or the default state if it is empty, becomes the
+      reference state. */
+  explicit CompactRobotTrajectory(const RobotTrajectory& trajectory);
+
+  const robot_model::RobotModelConstPtr& getRobotModel() const
+  {
+    return reference_state_.getRobotModel();
+  }
+
+  const robot_model::JointModelGroup* getGroup() const
+  {
+    return group_;
+  }
+
+  /** \brief The state the variables outside the group are taken from */
+  const robot_state::RobotState& getReferenceState() const
+  {
+    return reference_state_;
+  }
+
+  /** \brief The number of values in each row of positions, velocities or accelerations */
+  std::size_t getVariableCount() const
+  {
+    return variable_indices_.size();
+  }
+
+  /** \brief The indices in a RobotState of the variables in each row */
+  const std::vector<int>& getVariableIndices() const
+  {
+    return variable_indices_;
+  }
+
+  std::size_t getWayPointCount() const
+  {
+    return durations_.size();
+  }
+
+  bool empty() const
+  {
+    return durations_.empty();
+  }
+
+  const double* getWayPointPositions(std::size_t index) const
+  {
+    return &positions_[index * variable_indices_.size()];
+  }
+
+  double* getWayPointPositions(std::size_t index)
+  {
+    return &positions_[index * variable_indices_.size()];
+  }
+
+  /** \brief True if velocities are stored. They are stored for all waypoints or for none: a waypoint added without
+      velocities drops them. */
+  bool hasVelocities() const
+  {
+    return !velocities_.empty();
+  }
+
+  const double* getWayPointVelocities(std::size_t index) const
+  {
+    return &velocities_[index * variable_indices_.size()];
+  }
+
+  double* getWayPointVelocities(std::size_t index)
+  {
+    return &velocities_[index * variable_indices_.size()];
+  }
+
+  /** \brief True if accelerations are stored, for all waypoints or for none, like velocities */
+  bool hasAccelerations() const
+  {
+    return !accelerations_.empty();
+  }
+
+  const double* getWayPointAccelerations(std::size_t index) const
+  {
+    return &accelerations_[index * variable_indices_.size()];
+  }
+
+  double* getWayPointAccelerations(std::size_t index)
+  {
+    return &accelerations_[index * variable_indices_.size()];
+  }
+
+  /** \brief Store velocities for all waypoints, zero for the waypoints that had none */
+  void enableVelocities()
+  {
+    velocities_.resize(positions_.size(), 0.0);
+  }
+
+  /** \brief Store accelerations for all waypoints, zero for the waypoints that had none */
+  void enableAccelerations()
+  {
+    accelerations_.resize(positions_.size(), 0.0);
+  }
+
+  const std::vector<double>& getWayPointDurations() const
+  {
+    return durations_;
+  }
+
+  double getWayPointDurationFromPrevious(std::size_t index) const
+  {
+    return index < durations_.size() ? durations_[index] : 0.0;
+  }
+
+  void setWayPointDurationFromPrevious(std::size_t index, double value)
+  {
+    durations_[index] = value;
+  }
+
+  /** @brief  Returns the duration after start that a waypoint will be reached.
+   *  @param  The waypoint index; the last waypoint is used if it is out of range.
+   */
+  double getWayPointDurationFromStart(std::size_t index) const;
+
+  void reserve(std::size_t count);
+
+  void clear();
+
+  /**
+   * \brief Add a point to the trajectory
+   * \param positions - getVariableCount() positions
+   * \param velocities - getVariableCount() velocities, or NULL if not known
+   * \param accelerations - getVariableCount() accelerations, or NULL if not known
+   * \param dt - duration from previous
+   */
+  void addSuffixWayPoint(const double* positions, const double* velocities, const double* accelerations, double dt);
+
+  /**
+   * \brief Add a point to the trajectory, taking the values of the stored variables from \e state
+   * \param state - the waypoint
+   * \param dt - duration from previous
+   */
+  void addSuffixWayPoint(const robot_state::RobotState& state, double dt);
+
+  /** \brief Write waypoint \e index into \e state and update its transforms. Only the stored variables are written,
+      so a copy of the reference state can be reused for all waypoints. */
+  void getWayPoint(std::size_t index, robot_state::RobotState& state) const;
+
+  /** \brief Build a new state for waypoint \e index from the reference state */
+  robot_state::RobotStatePtr createWayPointState(std::size_t index) const;
+
+  /** \brief Replace the content of \e trajectory by the waypoints of this trajectory */
+  void getRobotTrajectory(RobotTrajectory& trajectory) const;
+
+  /** \brief Same as RobotTrajectory::getRobotTrajectoryMsg(), without building a RobotState per waypoint */
+  void getRobotTrajectoryMsg(moveit_msgs::RobotTrajectory& trajectory) const;
+
+private:
+  robot_state::RobotState reference_state_;
+  const robot_model::JointModelGroup* group_;
+  std::vector<int> variable_indices_;
+
+  std::vector<double> positions_;
+  std::vector<double> velocities_;
+  std::vector<double> accelerations_;
+  std::vector<double> durations_;
+};
+}
+
+#endif
@@ -42,7 +42,10 @@
 #include <moveit/robot_state/robot_state.h>
 #include <moveit_msgs/RobotTrajectory.h>
 #include <moveit_msgs/RobotState.h>
+#include <boost/thread/mutex.hpp>
 #include <deque>
+#include <vector>
+#include <memory>
 
 namespace robot_trajectory
 {
@@ -57,6 +60,10 @@ public:
 
   RobotTrajectory(const robot_model::RobotModelConstPtr& robot_model, const robot_model::JointModelGroup* group);
 
+  RobotTrajectory(const RobotTrajectory& other);
+
+  RobotTrajectory& operator=(const RobotTrajectory& other);
+
   const robot_model::RobotModelConstPtr& getRobotModel() const
   {
     return robot_model_;
@@ -132,6 +139,7 @@ public:
     if (duration_from_previous_.size() <= index)
       duration_from_previous_.resize(index + 1, 0.0);
     duration_from_previous_[index] = value;
+    time_from_start_.reset();
   }
 
   bool empty() const
@@ -159,6 +167,7 @@ public:
     state->update();
     waypoints_.push_back(state);
     duration_from_previous_.push_back(dt);
+    time_from_start_.reset();
   }
 
   void addPrefixWayPoint(const robot_state::RobotState& state, double dt)
@@ -171,6 +180,7 @@ public:
     state->update();
     waypoints_.push_front(state);
     duration_from_previous_.push_front(dt);
+    time_from_start_.reset();
   }
 
   void insertWayPoint(std::size_t index, const robot_state::RobotState& state, double dt)
@@ -183,6 +193,7 @@ public:
     state->update();
     waypoints_.insert(waypoints_.begin() + index, state);
     duration_from_previous_.insert(duration_from_previous_.begin() + index, dt);
+    time_from_start_.reset();
   }
 
   /**
@@ -198,6 +209,8 @@ public:
 
   double getAverageSegmentDuration() const;
 
+  /** \brief Convert to a message. The memory of a \e trajectory converted into before is reused, so streaming a
+      trajectory at a high rate does not reallocate it */
   void getRobotTrajectoryMsg(moveit_msgs::RobotTrajectory& trajectory) const;
 
   /** \brief Copy the content of the trajectory message into this class. The trajectory message itself is not required
@@ -233,7 +246,7 @@ public:
   void unwind();
   void unwind(const robot_state::RobotState& state);
 
-  /** @brief Finds the waypoint indicies before and after a duration from start.
+  /** @brief Finds the waypoint indicies before and after a duration from start, by binary search.
    *  @param The duration from start.
    *  @param The waypoint index before the supplied duration.
    *  @param The waypoint index after (or equal to) the supplied duration.
@@ -251,10 +264,58 @@ public:
   bool getStateAtDurationFromStart(const double request_duration, robot_state::RobotStatePtr& output_state) const;
 
 private:
+  friend class TrajectoryCursor;
+
+  typedef std::shared_ptr<const std::vector<double> > TimeFromStartConstPtr;
+
+  /** \brief Get the duration from start of each waypoint. It is computed on the first call after the durations
+      changed and shared until they change again. */
+  TimeFromStartConstPtr getTimeFromStart() const;
+
   robot_model::RobotModelConstPtr robot_model_;
   const robot_model::JointModelGroup* group_;
   std::deque<robot_state::RobotStatePtr> waypoints_;
   std::deque<double> duration_from_previous_;
+
+  mutable boost::mutex time_from_start_lock_;
+  mutable TimeFromStartConstPtr time_from_start_;
+};
+
+/** \brief Samples a trajectory at increasing times. Each step only moves past the waypoints it skips, so sampling a
+    trajectory from start to end costs time linear in the number of waypoints and samples, instead of a search per
+    sample. The trajectory must outlive the cursor and not change while it is used. */
+class TrajectoryCursor
+{
+public:
+  /** \brief Place the cursor at \e time on \e trajectory */
+  TrajectoryCursor(const RobotTrajectory& trajectory, double time = 0.0);
+
+  /** \brief Move the cursor to \e time by binary search */
+  void reset(double time = 0.0);
+
+  /** \brief Move the cursor \e dt forward; a negative \e dt moves it back by binary search */
+  void advance(double dt);
+
+  double getTime() const
+  {
+    return time_;
+  }
+
+  /** \brief True if the cursor is at or past the last waypoint */
+  bool atEnd() const;
+
+  /** \brief The waypoints before and after the cursor, and the progress (0 to 1) between them, as returned by
+      RobotTrajectory::findWayPointIndicesForDurationAfterStart() */
+  void getWayPointIndices(int& before, int& after, double& blend) const;
+
+  /** \brief Interpolate the state at the cursor into \e output_state. Returns false if the trajectory is empty. */
+  bool getState(robot_state::RobotState& output_state) const;
+
+private:
+  const RobotTrajectory& trajectory_;
+  RobotTrajectory::TimeFromStartConstPtr time_from_start_;
+  double time_;
+  std::size_t index_;  // the first waypoint whose duration from start is not below time_
 };
 }
 
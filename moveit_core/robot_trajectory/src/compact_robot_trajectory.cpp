@@ -0,0 +1,271 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/robot_trajectory/compact_robot_trajectory.h>
+#include <eigen_conversions/eigen_msg.h>
+#include <numeric>
+
+namespace robot_trajectory
+{
+namespace
+{
+void getVariableIndices(const robot_model::RobotModel& robot_model, const robot_model::JointModelGroup* group,
+                        std::vector<int>& indices)
+{
+  if (group)
+    indices = group->getVariableIndexList();
+  else
+  {
+    indices.resize(robot_model.getVariableCount());
+    for (std::size_t i = 0; i < indices.size(); ++i)
+      indices[i] = i;
+  }
+}
+
+// append the row of values, or drop the values of all waypoints when the row is missing
+void appendRow(std::vector<double>& values, const double* row, std::size_t row_size, bool first)
+{
+  if (row && (first || !values.empty()))
+    values.insert(values.end(), row, row + row_size);
+  else
+    values.clear();
+}
+}
+
+CompactRobotTrajectory::CompactRobotTrajectory(const robot_state::RobotState& reference_state,
+                                               const robot_model::JointModelGroup* group)
+  : reference_state_(reference_state), group_(group)
+{
+  getVariableIndices(*reference_state_.getRobotModel(), group_, variable_indices_);
+}
+
+CompactRobotTrajectory::CompactRobotTrajectory(const RobotTrajectory& trajectory)
+  : reference_state_(trajectory.empty() ? robot_state::RobotState(trajectory.getRobotModel()) :
+                                          trajectory.getFirstWayPoint())
+  , group_(trajectory.getGroup())
+{
+  if (trajectory.empty())
+    reference_state_.setToDefaultValues();
+  getVariableIndices(*reference_state_.getRobotModel(), group_, variable_indices_);
+
+  reserve(trajectory.getWayPointCount());
+  for (std::size_t i = 0; i < trajectory.getWayPointCount(); ++i)
+    addSuffixWayPoint(trajectory.getWayPoint(i), trajectory.getWayPointDurationFromPrevious(i));
+}
+
+double CompactRobotTrajectory::getWayPointDurationFromStart(std::size_t index) const
+{
+  if (durations_.empty())
+    return 0.0;
+  index = std::min(index, durations_.size() - 1);
+  return std::accumulate(durations_.begin(), durations_.begin() + index + 1, 0.0);
+}
+
+void CompactRobotTrajectory::reserve(std::size_t count)
+{
+  positions_.reserve(count * variable_indices_.size());
+  velocities_.reserve(count * variable_indices_.size());
+  accelerations_.reserve(count * variable_indices_.size());
+  durations_.reserve(count);
+}
+
+void CompactRobotTrajectory::clear()
+{
+  positions_.clear();
+  velocities_.clear();
+  accelerations_.clear();
+  durations_.clear();
+}
+
+void CompactRobotTrajectory::addSuffixWayPoint(const double* positions, const double* velocities,
+                                               const double* accelerations, double dt)
+{
+  const std::size_t n = variable_indices_.size();
+  appendRow(velocities_, velocities, n, empty());
+  appendRow(accelerations_, accelerations, n, empty());
+  positions_.insert(positions_.end(), positions, positions + n);
+  durations_.push_back(dt);
+}
+
+void CompactRobotTrajectory::addSuffixWayPoint(const robot_state::RobotState& state, double dt)
+{
+  const std::size_t n = variable_indices_.size();
+  const bool first = empty();
+  const std::size_t row = positions_.size();
+  positions_.resize(row + n);
+  for (std::size_t j = 0; j < n; ++j)
+    positions_[row + j] = state.getVariablePosition(variable_indices_[j]);
+
+  if (state.hasVelocities() && (first || !velocities_.empty()))
+  {
+    velocities_.resize(row + n);
+    for (std::size_t j = 0; j < n; ++j)
+      velocities_[row + j] = state.getVariableVelocity(variable_indices_[j]);
+  }
+  else
+    velocities_.clear();
+
+  if (state.hasAccelerations() && (first || !accelerations_.empty()))
+  {
+    accelerations_.resize(row + n);
+    for (std::size_t j = 0; j < n; ++j)
+      accelerations_[row + j] = state.getVariableAcceleration(variable_indices_[j]);
+  }
+  else
+    accelerations_.clear();
+
+  durations_.push_back(dt);
+}
+
+void CompactRobotTrajectory::getWayPoint(std::size_t index, robot_state::RobotState& state) const
+{
+  // the rows of a group are in the order the group setters expect, and these also update the mimic joints
+  if (group_)
+  {
+    state.setJointGroupPositions(group_, getWayPointPositions(index));
+    if (hasVelocities())
+      state.setJointGroupVelocities(group_, getWayPointVelocities(index));
+    if (hasAccelerations())
+      state.setJointGroupAccelerations(group_, getWayPointAccelerations(index));
+  }
+  else
+  {
+    state.setVariablePositions(getWayPointPositions(index));
+    if (hasVelocities())
+      state.setVariableVelocities(getWayPointVelocities(index));
+    if (hasAccelerations())
+      state.setVariableAccelerations(getWayPointAccelerations(index));
+  }
+  state.update();
+}
+
+robot_state::RobotStatePtr CompactRobotTrajectory::createWayPointState(std::size_t index) const
+{
+  robot_state::RobotStatePtr state(new robot_state::RobotState(reference_state_));
+  getWayPoint(index, *state);
+  return state;
+}
+
+void CompactRobotTrajectory::getRobotTrajectory(RobotTrajectory& trajectory) const
+{
+  trajectory = RobotTrajectory(reference_state_.getRobotModel(), group_);
+  for (std::size_t i = 0; i < durations_.size(); ++i)
+    trajectory.addSuffixWayPoint(createWayPointState(i), durations_[i]);
+}
+
+void CompactRobotTrajectory::getRobotTrajectoryMsg(moveit_msgs::RobotTrajectory& trajectory) const
+{
+  trajectory = moveit_msgs::RobotTrajectory();
+  if (durations_.empty())
+    return;
+
+  /* the column of the first variable of each active joint; the variables of a joint are stored next to each other */
+  const robot_model::RobotModel& robot_model = *reference_state_.getRobotModel();
+  const std::vector<const robot_model::JointModel*>& jnt =
+      group_ ? group_->getActiveJointModels() : robot_model.getActiveJointModels();
+  std::vector<const robot_model::JointModel*> onedof;
+  std::vector<const robot_model::JointModel*> mdof;
+  std::vector<std::size_t> onedof_column;
+  std::vector<std::size_t> mdof_column;
+  for (std::size_t i = 0; i < jnt.size(); ++i)
+  {
+    const std::size_t column =
+        group_ ? group_->getVariableGroupIndex(jnt[i]->getVariableNames()[0]) : jnt[i]->getFirstVariableIndex();
+    if (jnt[i]->getVariableCount() == 1)
+    {
+      trajectory.joint_trajectory.joint_names.push_back(jnt[i]->getName());
+      onedof.push_back(jnt[i]);
+      onedof_column.push_back(column);
+    }
+    else
+    {
+      trajectory.multi_dof_joint_trajectory.joint_names.push_back(jnt[i]->getName());
+      mdof.push_back(jnt[i]);
+      mdof_column.push_back(column);
+    }
+  }
+
+  const std::size_t n = variable_indices_.size();
+  double total_time = 0.0;
+  if (!onedof.empty())
+  {
+    trajectory.joint_trajectory.header.frame_id = robot_model.getModelFrame();
+    trajectory.joint_trajectory.header.stamp = ros::Time(0);
+    trajectory.joint_trajectory.points.resize(durations_.size());
+    for (std::size_t i = 0; i < durations_.size(); ++i)
+    {
+      trajectory_msgs::JointTrajectoryPoint& point = trajectory.joint_trajectory.points[i];
+      total_time += durations_[i];
+      point.time_from_start = ros::Duration(total_time);
+      point.positions.resize(onedof.size());
+      for (std::size_t j = 0; j < onedof.size(); ++j)
+        point.positions[j] = positions_[i * n + onedof_column[j]];
+      if (hasVelocities())
+      {
+        point.velocities.resize(onedof.size());
+        for (std::size_t j = 0; j < onedof.size(); ++j)
+          point.velocities[j] = velocities_[i * n + onedof_column[j]];
+      }
+      if (hasAccelerations())
+      {
+        point.accelerations.resize(onedof.size());
+        for (std::size_t j = 0; j < onedof.size(); ++j)
+          point.accelerations[j] = accelerations_[i * n + onedof_column[j]];
+      }
+    }
+  }
+
+  if (!mdof.empty())
+  {
+    // the transforms of multi-dof joints are computed by a scratch state, without updating any link transforms
+    robot_state::RobotState state(reference_state_);
+    trajectory.multi_dof_joint_trajectory.header.frame_id = robot_model.getModelFrame();
+    trajectory.multi_dof_joint_trajectory.header.stamp = ros::Time(0);
+    trajectory.multi_dof_joint_trajectory.points.resize(durations_.size());
+    total_time = 0.0;
+    for (std::size_t i = 0; i < durations_.size(); ++i)
+    {
+      trajectory_msgs::MultiDOFJointTrajectoryPoint& point = trajectory.multi_dof_joint_trajectory.points[i];
+      total_time += durations_[i];
+      point.time_from_start = ros::Duration(total_time);
+      point.transforms.resize(mdof.size());
+      for (std::size_t j = 0; j < mdof.size(); ++j)
+      {
+        state.setJointPositions(mdof[j], &positions_[i * n + mdof_column[j]]);
+        tf::transformEigenToMsg(state.getJointTransform(mdof[j]), point.transforms[j]);
+      }
+    }
+  }
+}
+}
@@ -38,8 +38,71 @@
 #include <moveit/robot_state/conversions.h>
 #include <eigen_conversions/eigen_msg.h>
 #include <boost/math/constants/constants.hpp>
+#include <algorithm>
 #include <numeric>
 
+namespace
+{
+/* The waypoints before and after \e duration and the progress between them, given the duration from start of the
+   first \e count waypoints and \e index, the first of them whose duration from start is not below \e duration */
+void getWayPointIndices(const std::vector<double>& time_from_start, std::size_t count, std::size_t index,
+                        double duration, int& before, int& after, double& blend)
+{
+  if (duration < 0.0 || count == 0)
+  {
+    before = 0;
+    after = 0;
+    blend = 0;
+    return;
+  }
+
+  before = std::max<int>((int)index - 1, 0);
+  after = std::min<int>(index, count - 1);
+  if (after == before)
+    blend = 1.0;
+  else
+  {
+    const double segment = time_from_start[after] - time_from_start[before];
+    blend = segment > 0.0 ? (duration - time_from_start[before]) / segment : 1.0;
+  }
+}
+
+/* Copy the \e values of the variables at \e indices into \e output, reusing its memory */
+void copyVariables(const double* values, const std::vector<int>& indices, std::vector<double>& output)
+{
+  output.resize(indices.size());
+  for (std::size_t j = 0; j < indices.size(); ++j)
+    output[j] = values[indices[j]];
+}
+
+/* The indices of the variables named in a trajectory message, looked up once for all its points */
+std::vector<int> getVariableIndices(const robot_model::RobotModel& robot_model, const std::vector<std::string>& names)
+{
+  std::vector<int> indices(names.size());
+  for (std::size_t j = 0; j < names.size(); ++j)
+    indices[j] = robot_model.getVariableIndex(names[j]);
+  return indices;
+}
+
+/* Set the variables of \e state at \e indices to the values of a trajectory point */
+void setVariables(robot_state::RobotState& state, const std::vector<int>& indices,
+                  const trajectory_msgs::JointTrajectoryPoint& point)
+{
+  const std::size_t count = std::min(indices.size(), point.positions.size());
+  for (std::size_t j = 0; j < count; ++j)
+    state.setVariablePosition(indices[j], point.positions[j]);
+  if (!point.velocities.empty())
+    for (std::size_t j = 0; j < std::min(indices.size(), point.velocities.size()); ++j)
+      state.setVariableVelocity(indices[j], point.velocities[j]);
+  if (!point.accelerations.empty())
+    for (std::size_t j = 0; j < std::min(indices.size(), point.accelerations.size()); ++j)
+      state.setVariableAcceleration(indices[j], point.accelerations[j]);
+  if (!point.effort.empty())
+    for (std::size_t j = 0; j < std::min(indices.size(), point.effort.size()); ++j)
+      state.setVariableEffort(indices[j], point.effort[j]);
+}
+}
+
 robot_trajectory::RobotTrajectory::RobotTrajectory(const robot_model::RobotModelConstPtr& robot_model,
                                                    const std::string& group)
   : robot_model_(robot_model), group_(group.empty() ? NULL : robot_model->getJointModelGroup(group))
@@ -52,6 +115,35 @@ robot_trajectory::RobotTrajectory::RobotTrajectory(const robot_model::RobotModel
 {
 }
 
+robot_trajectory::RobotTrajectory::RobotTrajectory(const RobotTrajectory& other)
+  : robot_model_(other.robot_model_)
+  , group_(other.group_)
+  , waypoints_(other.waypoints_)
+  , duration_from_previous_(other.duration_from_previous_)
+{
+  boost::mutex::scoped_lock slock(other.time_from_start_lock_);
+  time_from_start_ = other.time_from_start_;
+}
+
+robot_trajectory::RobotTrajectory& robot_trajectory::RobotTrajectory::operator=(const RobotTrajectory& other)
+{
+  if (this != &other)
+  {
+    robot_model_ = other.robot_model_;
+    group_ = other.group_;
+    waypoints_ = other.waypoints_;
+    duration_from_previous_ = other.duration_from_previous_;
+    TimeFromStartConstPtr time_from_start;
+    {
+      boost::mutex::scoped_lock slock(other.time_from_start_lock_);
+      time_from_start = other.time_from_start_;
+    }
+    boost::mutex::scoped_lock slock(time_from_start_lock_);
+    time_from_start_ = time_from_start;
+  }
+  return *this;
+}
+
 void robot_trajectory::RobotTrajectory::setGroupName(const std::string& group_name)
 {
   group_ = robot_model_->getJointModelGroup(group_name);
@@ -80,6 +172,8 @@ void robot_trajectory::RobotTrajectory::swap(robot_trajectory::RobotTrajectory&
   std::swap(group_, other.group_);
   waypoints_.swap(other.waypoints_);
   duration_from_previous_.swap(other.duration_from_previous_);
+  time_from_start_.reset();
+  other.time_from_start_.reset();
 }
 
 void robot_trajectory::RobotTrajectory::append(const RobotTrajectory& source, double dt)
@@ -90,6 +184,7 @@ void robot_trajectory::RobotTrajectory::append(const RobotTrajectory& source, do
                                  source.duration_from_previous_.end());
   if (duration_from_previous_.size() > index)
     duration_from_previous_[index] += dt;
+  time_from_start_.reset();
 }
 
 void robot_trajectory::RobotTrajectory::reverse()
@@ -101,6 +196,7 @@ void robot_trajectory::RobotTrajectory::reverse()
     std::reverse(duration_from_previous_.begin(), duration_from_previous_.end());
     duration_from_previous_.pop_back();
   }
+  time_from_start_.reset();
 }
 
 void robot_trajectory::RobotTrajectory::unwind()
@@ -188,18 +284,23 @@ void robot_trajectory::RobotTrajectory::clear()
 {
   waypoints_.clear();
   duration_from_previous_.clear();
+  time_from_start_.reset();
 }
 
 void robot_trajectory::RobotTrajectory::getRobotTrajectoryMsg(moveit_msgs::RobotTrajectory& trajectory) const
 {
-  trajectory = moveit_msgs::RobotTrajectory();
   if (waypoints_.empty())
+  {
+    trajectory = moveit_msgs::RobotTrajectory();
     return;
+  }
   const std::vector<const robot_model::JointModel*>& jnt =
       group_ ? group_->getActiveJointModels() : robot_model_->getActiveJointModels();
 
-  std::vector<const robot_model::JointModel*> onedof;
+  // the variable indices are looked up once, so each point is a plain copy into the message; the vectors of a
+  // message passed in again are reused, so converting at a high rate does not reallocate them
   std::vector<const robot_model::JointModel*> mdof;
+  std::vector<int> onedof;
   trajectory.joint_trajectory.joint_names.clear();
   trajectory.multi_dof_joint_trajectory.joint_names.clear();
 
@@ -207,7 +308,7 @@ void robot_trajectory::RobotTrajectory::getRobotTrajectoryMsg(moveit_msgs::Robot
     if (jnt[i]->getVariableCount() == 1)
     {
       trajectory.joint_trajectory.joint_names.push_back(jnt[i]->getName());
-      onedof.push_back(jnt[i]);
+      onedof.push_back(jnt[i]->getFirstVariableIndex());
     }
     else
     {
@@ -220,6 +321,8 @@ void robot_trajectory::RobotTrajectory::getRobotTrajectoryMsg(moveit_msgs::Robot
     trajectory.joint_trajectory.header.stamp = ros::Time(0);
     trajectory.joint_trajectory.points.resize(waypoints_.size());
   }
+  else
+    trajectory.joint_trajectory = trajectory_msgs::JointTrajectory();
 
   if (!mdof.empty())
   {
@@ -227,59 +330,50 @@ void robot_trajectory::RobotTrajectory::getRobotTrajectoryMsg(moveit_msgs::Robot
     trajectory.multi_dof_joint_trajectory.header.stamp = ros::Time(0);
     trajectory.multi_dof_joint_trajectory.points.resize(waypoints_.size());
   }
+  else
+    trajectory.multi_dof_joint_trajectory = trajectory_msgs::MultiDOFJointTrajectory();
 
   static const ros::Duration zero_duration(0.0);
   double total_time = 0.0;
+  Eigen::Affine3d transform;
   for (std::size_t i = 0; i < waypoints_.size(); ++i)
   {
     if (duration_from_previous_.size() > i)
       total_time += duration_from_previous_[i];
+    const ros::Duration time_from_start =
+        duration_from_previous_.size() > i ? ros::Duration(total_time) : zero_duration;
+    const robot_state::RobotState& waypoint = *waypoints_[i];
 
     if (!onedof.empty())
     {
-      trajectory.joint_trajectory.points[i].positions.resize(onedof.size());
-      trajectory.joint_trajectory.points[i].velocities.reserve(onedof.size());
-
-      for (std::size_t j = 0; j < onedof.size(); ++j)
-      {
-        trajectory.joint_trajectory.points[i].positions[j] =
-            waypoints_[i]->getVariablePosition(onedof[j]->getFirstVariableIndex());
-        // if we have velocities/accelerations/effort, copy those too
-        if (waypoints_[i]->hasVelocities())
-          trajectory.joint_trajectory.points[i].velocities.push_back(
-              waypoints_[i]->getVariableVelocity(onedof[j]->getFirstVariableIndex()));
-        if (waypoints_[i]->hasAccelerations())
-          trajectory.joint_trajectory.points[i].accelerations.push_back(
-              waypoints_[i]->getVariableAcceleration(onedof[j]->getFirstVariableIndex()));
-        if (waypoints_[i]->hasEffort())
-          trajectory.joint_trajectory.points[i].effort.push_back(
-              waypoints_[i]->getVariableEffort(onedof[j]->getFirstVariableIndex()));
-      }
-      // clear velocities if we have an incomplete specification
-      if (trajectory.joint_trajectory.points[i].velocities.size() != onedof.size())
-        trajectory.joint_trajectory.points[i].velocities.clear();
-      // clear accelerations if we have an incomplete specification
-      if (trajectory.joint_trajectory.points[i].accelerations.size() != onedof.size())
-        trajectory.joint_trajectory.points[i].accelerations.clear();
-      // clear effort if we have an incomplete specification
-      if (trajectory.joint_trajectory.points[i].effort.size() != onedof.size())
-        trajectory.joint_trajectory.points[i].effort.clear();
-
-      if (duration_from_previous_.size() > i)
-        trajectory.joint_trajectory.points[i].time_from_start = ros::Duration(total_time);
+      trajectory_msgs::JointTrajectoryPoint& point = trajectory.joint_trajectory.points[i];
+      copyVariables(waypoint.getVariablePositions(), onedof, point.positions);
+      // if we have velocities/accelerations/effort, copy those too
+      if (waypoint.hasVelocities())
+        copyVariables(waypoint.getVariableVelocities(), onedof, point.velocities);
+      else
+        point.velocities.clear();
+      if (waypoint.hasAccelerations())
+        copyVariables(waypoint.getVariableAccelerations(), onedof, point.accelerations);
+      else
+        point.accelerations.clear();
+      if (waypoint.hasEffort())
+        copyVariables(waypoint.getVariableEffort(), onedof, point.effort);
       else
-        trajectory.joint_trajectory.points[i].time_from_start = zero_duration;
+        point.effort.clear();
+      point.time_from_start = time_from_start;
     }
     if (!mdof.empty())
     {
-      trajectory.multi_dof_joint_trajectory.points[i].transforms.resize(mdof.size());
+      trajectory_msgs::MultiDOFJointTrajectoryPoint& point = trajectory.multi_dof_joint_trajectory.points[i];
+      point.transforms.resize(mdof.size());
+      // the joint transforms are computed from the variables, without updating the transforms of the waypoint
       for (std::size_t j = 0; j < mdof.size(); ++j)
-        tf::transformEigenToMsg(waypoints_[i]->getJointTransform(mdof[j]),
-                                trajectory.multi_dof_joint_trajectory.points[i].transforms[j]);
-      if (duration_from_previous_.size() > i)
-        trajectory.multi_dof_joint_trajectory.points[i].time_from_start = ros::Duration(total_time);
-      else
-        trajectory.multi_dof_joint_trajectory.points[i].time_from_start = zero_duration;
+      {
+        mdof[j]->computeTransform(waypoint.getVariablePositions() + mdof[j]->getFirstVariableIndex(), transform);
+        tf::transformEigenToMsg(transform, point.transforms[j]);
+      }
+      point.time_from_start = time_from_start;
     }
   }
 }
@@ -293,18 +387,13 @@ void robot_trajectory::RobotTrajectory::setRobotTrajectoryMsg(const robot_state:
   std::size_t state_count = trajectory.points.size();
   ros::Time last_time_stamp = trajectory.header.stamp;
   ros::Time this_time_stamp = last_time_stamp;
+  const std::vector<int> indices = getVariableIndices(*robot_model_, trajectory.joint_names);
 
   for (std::size_t i = 0; i < state_count; ++i)
   {
     this_time_stamp = trajectory.header.stamp + trajectory.points[i].time_from_start;
     robot_state::RobotStatePtr st(new robot_state::RobotState(copy));
-    st->setVariablePositions(trajectory.joint_names, trajectory.points[i].positions);
-    if (!trajectory.points[i].velocities.empty())
-      st->setVariableVelocities(trajectory.joint_names, trajectory.points[i].velocities);
-    if (!trajectory.points[i].accelerations.empty())
-      st->setVariableAccelerations(trajectory.joint_names, trajectory.points[i].accelerations);
-    if (!trajectory.points[i].effort.empty())
-      st->setVariableEffort(trajectory.joint_names, trajectory.points[i].effort);
+    setVariables(*st, indices, trajectory.points[i]);
     addSuffixWayPoint(st, (this_time_stamp - last_time_stamp).toSec());
     last_time_stamp = this_time_stamp;
   }
@@ -323,33 +412,29 @@ void robot_trajectory::RobotTrajectory::setRobotTrajectoryMsg(const robot_state:
                                   trajectory.multi_dof_joint_trajectory.header.stamp :
                                   trajectory.joint_trajectory.header.stamp;
   ros::Time this_time_stamp = last_time_stamp;
+  const std::vector<int> indices = getVariableIndices(*robot_model_, trajectory.joint_trajectory.joint_names);
+  std::vector<const robot_model::JointModel*> mdof(trajectory.multi_dof_joint_trajectory.joint_names.size());
+  for (std::size_t j = 0; j < mdof.size(); ++j)
+    mdof[j] = robot_model_->getJointModel(trajectory.multi_dof_joint_trajectory.joint_names[j]);
+  Eigen::Affine3d transform;
 
   for (std::size_t i = 0; i < state_count; ++i)
   {
     robot_state::RobotStatePtr st(new robot_state::RobotState(copy));
     if (trajectory.joint_trajectory.points.size() > i)
     {
-      st->setVariablePositions(trajectory.joint_trajectory.joint_names,
-                               trajectory.joint_trajectory.points[i].positions);
-      if (!trajectory.joint_trajectory.points[i].velocities.empty())
-        st->setVariableVelocities(trajectory.joint_trajectory.joint_names,
-                                  trajectory.joint_trajectory.points[i].velocities);
-      if (!trajectory.joint_trajectory.points[i].accelerations.empty())
-        st->setVariableAccelerations(trajectory.joint_trajectory.joint_names,
-                                     trajectory.joint_trajectory.points[i].accelerations);
-      if (!trajectory.joint_trajectory.points[i].effort.empty())
-        st->setVariableEffort(trajectory.joint_trajectory.joint_names, trajectory.joint_trajectory.points[i].effort);
+      setVariables(*st, indices, trajectory.joint_trajectory.points[i]);
       this_time_stamp =
           trajectory.joint_trajectory.header.stamp + trajectory.joint_trajectory.points[i].time_from_start;
     }
     if (trajectory.multi_dof_joint_trajectory.points.size() > i)
     {
-      for (std::size_t j = 0; j < trajectory.multi_dof_joint_trajectory.joint_names.size(); ++j)
-      {
-        Eigen::Affine3d t;
-        tf::transformMsgToEigen(trajectory.multi_dof_joint_trajectory.points[i].transforms[j], t);
-        st->setJointPositions(trajectory.multi_dof_joint_trajectory.joint_names[j], t);
-      }
+      for (std::size_t j = 0; j < mdof.size(); ++j)
+        if (mdof[j])
+        {
+          tf::transformMsgToEigen(trajectory.multi_dof_joint_trajectory.points[i].transforms[j], transform);
+          st->setJointPositions(mdof[j], transform);
+        }
       this_time_stamp = trajectory.multi_dof_joint_trajectory.header.stamp +
                         trajectory.multi_dof_joint_trajectory.points[i].time_from_start;
     }
@@ -371,32 +456,23 @@ void robot_trajectory::RobotTrajectory::setRobotTrajectoryMsg(const robot_state:
 void robot_trajectory::RobotTrajectory::findWayPointIndicesForDurationAfterStart(const double& duration, int& before,
                                                                                  int& after, double& blend) const
 {
-  if (duration < 0.0)
-  {
-    before = 0;
-    after = 0;
-    blend = 0;
-    return;
-  }
+  TimeFromStartConstPtr time_from_start = getTimeFromStart();
+  const std::size_t count = std::min(waypoints_.size(), time_from_start->size());
+  const std::size_t index =
+      std::lower_bound(time_from_start->begin(), time_from_start->begin() + count, duration) - time_from_start->begin();
+  getWayPointIndices(*time_from_start, count, index, duration, before, after, blend);
+}
 
-  // Find indicies
-  std::size_t index = 0, num_points = waypoints_.size();
-  double running_duration = 0.0;
-  for (; index < num_points; ++index)
+robot_trajectory::RobotTrajectory::TimeFromStartConstPtr robot_trajectory::RobotTrajectory::getTimeFromStart() const
+{
+  boost::mutex::scoped_lock slock(time_from_start_lock_);
+  if (!time_from_start_)
   {
-    running_duration += duration_from_previous_[index];
-    if (running_duration >= duration)
-      break;
+    std::shared_ptr<std::vector<double> > time_from_start(new std::vector<double>(duration_from_previous_.size()));
+    std::partial_sum(duration_from_previous_.begin(), duration_from_previous_.end(), time_from_start->begin());
+    time_from_start_ = time_from_start;
   }
-  before = std::max<int>(index - 1, 0);
-  after = std::min<int>(index, num_points - 1);
-
-  // Compute duration blend
-  double before_time = running_duration - duration_from_previous_[index];
-  if (after == before)
-    blend = 1.0;
-  else
-    blend = (duration - before_time) / duration_from_previous_[index];
+  return time_from_start_;
 }
 
 double robot_trajectory::RobotTrajectory::getWayPointDurationFromStart(std::size_t index) const
@@ -405,11 +481,7 @@ double robot_trajectory::RobotTrajectory::getWayPointDurationFromStart(std::size
     return 0.0;
   if (index >= duration_from_previous_.size())
     index = duration_from_previous_.size() - 1;
-
-  double time = 0.0;
-  for (std::size_t i = 0; i <= index; ++i)
-    time += duration_from_previous_[i];
-  return time;
+  return (*getTimeFromStart())[index];
 }
 
 double robot_trajectory::RobotTrajectory::getWaypointDurationFromStart(std::size_t index) const
@@ -431,3 +503,55 @@ bool robot_trajectory::RobotTrajectory::getStateAtDurationFromStart(const double
   waypoints_[before]->interpolate(*waypoints_[after], blend, *output_state);
   return true;
 }
+
+robot_trajectory::TrajectoryCursor::TrajectoryCursor(const RobotTrajectory& trajectory, double time)
+  : trajectory_(trajectory)
+{
+  reset(time);
+}
+
+void robot_trajectory::TrajectoryCursor::reset(double time)
+{
+  time_from_start_ = trajectory_.getTimeFromStart();
+  const std::size_t count = std::min(trajectory_.getWayPointCount(), time_from_start_->size());
+  time_ = time;
+  index_ =
+      std::lower_bound(time_from_start_->begin(), time_from_start_->begin() + count, time) - time_from_start_->begin();
+}
+
+void robot_trajectory::TrajectoryCursor::advance(double dt)
+{
+  if (dt < 0.0)
+  {
+    reset(time_ + dt);
+    return;
+  }
+  time_ += dt;
+  const std::size_t count = std::min(trajectory_.getWayPointCount(), time_from_start_->size());
+  while (index_ < count && (*time_from_start_)[index_] < time_)
+    ++index_;
+}
+
+bool robot_trajectory::TrajectoryCursor::atEnd() const
+{
+  const std::size_t count = std::min(trajectory_.getWayPointCount(), time_from_start_->size());
+  return count == 0 || time_ >= (*time_from_start_)[count - 1];
+}
+
+void robot_trajectory::TrajectoryCursor::getWayPointIndices(int& before, int& after, double& blend) const
+{
+  ::getWayPointIndices(*time_from_start_, std::min(trajectory_.getWayPointCount(), time_from_start_->size()), index_,
+                       time_, before, after, blend);
+}
+
+bool robot_trajectory::TrajectoryCursor::getState(robot_state::RobotState& output_state) const
+{
+  if (trajectory_.empty())
+    return false;
+
+  int before = 0, after = 0;
+  double blend = 1.0;
+  getWayPointIndices(before, after, blend);
+  trajectory_.getWayPoint(before).interpolate(trajectory_.getWayPoint(after), blend, output_state);
+  return true;
+}
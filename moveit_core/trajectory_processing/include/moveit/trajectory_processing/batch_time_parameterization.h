@@ -0,0 +1,57 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_TRAJECTORY_PROCESSING_BATCH_TIME_PARAMETERIZATION_
+#define MOVEIT_TRAJECTORY_PROCESSING_BATCH_TIME_PARAMETERIZATION_
+
+#include <moveit/robot_trajectory/robot_trajectory.h>
+#include <boost/function.hpp>
+#include <vector>
+
+namespace trajectory_processing
+{
+/** \brief A time parameterization of one trajectory, for instance a bound call to
+    IterativeParabolicTimeParameterization::computeTimeStamps(). It is called from several threads at once. */
+typedef boost::function<bool(robot_trajectory::RobotTrajectory&)> TimeParameterizationFn;
+
+/** \brief Compute the time stamps of the segments of a plan, such as the approach and retreat of a grasp, on up to \e
+    max_threads threads (0 for one per core). Each segment is parameterized on its own, from rest to rest. Where a
+    segment ends at the state the next one starts from, both boundary waypoints are set exactly to rest, so the
+    segments join without a jump in velocity or acceleration. Waypoint states shared between segments are copied
+    first. Returns false if the time parameterization of any segment failed. */
+bool computeTimeStamps(const std::vector<robot_trajectory::RobotTrajectoryPtr>& trajectories,
+                       const TimeParameterizationFn& time_parameterization, unsigned int max_threads = 0);
+}
+
+#endif
@@ -0,0 +1,105 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_TRAJECTORY_PROCESSING_JERK_LIMITED_SMOOTHING_
+#define MOVEIT_TRAJECTORY_PROCESSING_JERK_LIMITED_SMOOTHING_
+
+#include <moveit/robot_trajectory/robot_trajectory.h>
+
+namespace trajectory_processing
+{
+/// \brief This class limits the jerk of a time parameterized trajectory.
+///
+/// Velocities and accelerations are estimated at each waypoint by central differences, and the duration of each
+/// segment whose jerk exceeds the limit is stretched by the cube root of the excess, until no segment exceeds it.
+/// The estimated velocities and accelerations are stored in the waypoints, so the trajectory can be sampled with a
+/// JerkLimitedSampler. The trajectory starts and ends at rest.
+class JerkLimitedSmoothing
+{
+public:
+  /// \param max_jerk the jerk limit of every variable of the trajectory group
+  /// \param max_iterations the largest number of times the durations are stretched
+  JerkLimitedSmoothing(double max_jerk = 10.0, unsigned int max_iterations = 100);
+  ~JerkLimitedSmoothing();
+
+  bool smooth(robot_trajectory::RobotTrajectory& trajectory, const double max_jerk_scaling_factor = 1.0) const;
+
+private:
+  double max_jerk_;              /// @brief jerk limit of every variable
+  unsigned int max_iterations_;  /// @brief maximal number of passes stretching the durations
+};
+
+/// \brief Streams samples of a trajectory at a fixed period, as a controller consumes them, without densifying the
+/// trajectory in memory.
+///
+/// Between waypoints, every single variable joint of the trajectory group follows the quintic polynomial that matches
+/// the positions, velocities and accelerations of both waypoints, so positions and velocities are smooth and
+/// accelerations are continuous. Waypoints without velocities or accelerations are taken as at rest. Other joints are
+/// interpolated linearly. The trajectory must outlive the sampler and not change while it is used.
+class JerkLimitedSampler
+{
+public:
+  /// \param period the time between samples, typically the controller period
+  JerkLimitedSampler(const robot_trajectory::RobotTrajectory& trajectory, double period);
+
+  /// \brief Restart sampling from the start of the trajectory
+  void reset();
+
+  /// \brief Write the next sample into \e state and advance by one period. The last sample is the last waypoint.
+  /// Returns false once the last sample has been produced, or if the trajectory is empty.
+  bool next(robot_state::RobotState& state);
+
+  /// \brief The time from start of the sample next() produces
+  double getTime() const
+  {
+    return cursor_.getTime();
+  }
+
+  /// \brief True once the last sample has been produced
+  bool done() const
+  {
+    return done_;
+  }
+
+private:
+  void sample(robot_state::RobotState& state) const;
+
+  const robot_trajectory::RobotTrajectory& trajectory_;
+  robot_trajectory::TrajectoryCursor cursor_;
+  double period_;
+  bool done_;
+};
+}
+
+#endif
@@ -0,0 +1,127 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/trajectory_processing/batch_time_parameterization.h>
+#include <console_bridge/console.h>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <atomic>
+#include <set>
+
+namespace trajectory_processing
+{
+namespace
+{
+// the last waypoint of a segment and the first of the next one are the same state if they are closer than this
+const double BOUNDARY_DISTANCE = 1e-6;
+
+void parameterizeSegments(const std::vector<robot_trajectory::RobotTrajectoryPtr>* trajectories,
+                          const TimeParameterizationFn* time_parameterization, std::atomic<std::size_t>* next,
+                          std::atomic<bool>* success)
+{
+  for (std::size_t i = (*next)++; i < trajectories->size(); i = (*next)++)
+  {
+    robot_trajectory::RobotTrajectory& trajectory = *(*trajectories)[i];
+    try
+    {
+      if (!(*time_parameterization)(trajectory))
+        *success = false;
+    }
+    catch (std::exception& ex)
+    {
+      logError("Time parameterization of trajectory segment %u failed: %s", (unsigned int)i, ex.what());
+      *success = false;
+    }
+  }
+}
+
+void setWayPointAtRest(robot_state::RobotState& state, const robot_model::JointModelGroup* group)
+{
+  const std::vector<int>& idx = group->getVariableIndexList();
+  for (std::size_t j = 0; j < idx.size(); ++j)
+  {
+    state.setVariableVelocity(idx[j], 0.0);
+    state.setVariableAcceleration(idx[j], 0.0);
+  }
+}
+}
+
+bool computeTimeStamps(const std::vector<robot_trajectory::RobotTrajectoryPtr>& trajectories,
+                       const TimeParameterizationFn& time_parameterization, unsigned int max_threads)
+{
+  std::vector<robot_trajectory::RobotTrajectoryPtr> segments;
+  for (std::size_t i = 0; i < trajectories.size(); ++i)
+    if (trajectories[i] && !trajectories[i]->empty())
+      segments.push_back(trajectories[i]);
+  if (segments.empty())
+    return true;
+
+  // the segments are modified concurrently, so they must not share waypoints
+  std::set<const robot_state::RobotState*> states;
+  for (std::size_t i = 0; i < segments.size(); ++i)
+    for (std::size_t k = 0; k < segments[i]->getWayPointCount(); ++k)
+    {
+      robot_state::RobotStatePtr& state = segments[i]->getWayPointPtr(k);
+      if (!states.insert(state.get()).second)
+        state.reset(new robot_state::RobotState(*state));
+    }
+
+  std::atomic<std::size_t> next(0);
+  std::atomic<bool> success(true);
+  std::size_t thread_count = max_threads > 0 ? max_threads : boost::thread::hardware_concurrency();
+  thread_count = std::max<std::size_t>(1, std::min(thread_count, segments.size()));
+
+  // the calling thread takes part, so a single segment is parameterized without starting any thread
+  boost::thread_group threads;
+  for (std::size_t i = 1; i < thread_count; ++i)
+    threads.create_thread(boost::bind(&parameterizeSegments, &segments, &time_parameterization, &next, &success));
+  parameterizeSegments(&segments, &time_parameterization, &next, &success);
+  threads.join_all();
+
+  for (std::size_t i = 0; i + 1 < segments.size(); ++i)
+  {
+    const robot_model::JointModelGroup* group = segments[i]->getGroup();
+    if (!group || group != segments[i + 1]->getGroup())
+      continue;
+    robot_state::RobotState& last = *segments[i]->getLastWayPointPtr();
+    robot_state::RobotState& first = *segments[i + 1]->getFirstWayPointPtr();
+    if (last.distance(first, group) > BOUNDARY_DISTANCE)
+      continue;
+    setWayPointAtRest(last, group);
+    setWayPointAtRest(first, group);
+    segments[i + 1]->setWayPointDurationFromPrevious(0, 0.0);
+  }
+  return success;
+}
+}
@@ -0,0 +1,241 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/trajectory_processing/jerk_limited_smoothing.h>
+#include <moveit/robot_model/revolute_joint_model.h>
+#include <console_bridge/console.h>
+#include <boost/math/constants/constants.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace trajectory_processing
+{
+namespace
+{
+// duration given to segments that are not time parameterized yet
+const double MIN_SEGMENT_DURATION = 1e-3;
+
+// least factor a segment exceeding the jerk limit is stretched by, so the iteration makes progress
+const double MIN_STRETCH = 1.01;
+
+// estimate velocities and accelerations by central differences of the row-major positions, at rest at both ends
+void estimateDerivatives(const std::vector<double>& positions, const std::vector<double>& durations, std::size_t count,
+                         std::size_t variables, std::vector<double>& velocities, std::vector<double>& accelerations)
+{
+  std::fill(velocities.begin(), velocities.end(), 0.0);
+  std::fill(accelerations.begin(), accelerations.end(), 0.0);
+  for (std::size_t i = 1; i + 1 < count; ++i)
+  {
+    const double span = durations[i] + durations[i + 1];
+    for (std::size_t j = 0; j < variables; ++j)
+      velocities[i * variables + j] = (positions[(i + 1) * variables + j] - positions[(i - 1) * variables + j]) / span;
+  }
+  for (std::size_t i = 1; i + 1 < count; ++i)
+  {
+    const double span = durations[i] + durations[i + 1];
+    for (std::size_t j = 0; j < variables; ++j)
+      accelerations[i * variables + j] =
+          (velocities[(i + 1) * variables + j] - velocities[(i - 1) * variables + j]) / span;
+  }
+}
+
+bool isContinuous(const robot_model::JointModel* joint)
+{
+  return joint->getType() == robot_model::JointModel::REVOLUTE &&
+         static_cast<const robot_model::RevoluteJointModel*>(joint)->isContinuous();
+}
+}
+
+JerkLimitedSmoothing::JerkLimitedSmoothing(double max_jerk, unsigned int max_iterations)
+  : max_jerk_(max_jerk), max_iterations_(max_iterations)
+{
+}
+
+JerkLimitedSmoothing::~JerkLimitedSmoothing()
+{
+}
+
+bool JerkLimitedSmoothing::smooth(robot_trajectory::RobotTrajectory& trajectory,
+                                  const double max_jerk_scaling_factor) const
+{
+  if (trajectory.empty())
+    return true;
+
+  const robot_model::JointModelGroup* group = trajectory.getGroup();
+  if (!group)
+  {
+    logError("It looks like the planner did not set the group the plan was computed for");
+    return false;
+  }
+
+  double jerk_scaling_factor = 1.0;
+  if (max_jerk_scaling_factor > 0.0 && max_jerk_scaling_factor <= 1.0)
+    jerk_scaling_factor = max_jerk_scaling_factor;
+  else if (max_jerk_scaling_factor != 0.0)
+    logWarn("Invalid max_jerk_scaling_factor %f specified, defaulting to %f instead.", max_jerk_scaling_factor,
+            jerk_scaling_factor);
+  const double max_jerk = max_jerk_ * jerk_scaling_factor;
+  if (max_jerk <= 0.0)
+  {
+    logError("Invalid jerk limit %f", max_jerk);
+    return false;
+  }
+
+  const std::vector<int>& idx = group->getVariableIndexList();
+  const std::size_t count = trajectory.getWayPointCount();
+  const std::size_t variables = idx.size();
+  std::vector<double> positions(count * variables);
+  std::vector<double> velocities(count * variables);
+  std::vector<double> accelerations(count * variables);
+  std::vector<double> durations(count, 0.0);
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    const robot_state::RobotState& waypoint = trajectory.getWayPoint(i);
+    for (std::size_t j = 0; j < variables; ++j)
+      positions[i * variables + j] = waypoint.getVariablePosition(idx[j]);
+    if (i > 0)
+      durations[i] = std::max(trajectory.getWayPointDurationFromPrevious(i), MIN_SEGMENT_DURATION);
+  }
+
+  bool within_limit = count < 2;
+  for (unsigned int iteration = 0; iteration < max_iterations_ && !within_limit; ++iteration)
+  {
+    estimateDerivatives(positions, durations, count, variables, velocities, accelerations);
+    within_limit = true;
+    for (std::size_t i = 1; i < count; ++i)
+    {
+      double excess = 0.0;
+      for (std::size_t j = 0; j < variables; ++j)
+        excess = std::max(excess, std::abs(accelerations[i * variables + j] - accelerations[(i - 1) * variables + j]) /
+                                      (durations[i] * max_jerk));
+      // the jerk falls with the cube of the duration
+      if (excess > 1.0)
+      {
+        durations[i] *= std::max(std::cbrt(excess), MIN_STRETCH);
+        within_limit = false;
+      }
+    }
+  }
+  if (!within_limit)
+    logWarn("The jerk limit %f was not met within %u iterations", max_jerk, max_iterations_);
+
+  estimateDerivatives(positions, durations, count, variables, velocities, accelerations);
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    robot_state::RobotState& waypoint = *trajectory.getWayPointPtr(i);
+    for (std::size_t j = 0; j < variables; ++j)
+    {
+      waypoint.setVariableVelocity(idx[j], velocities[i * variables + j]);
+      waypoint.setVariableAcceleration(idx[j], accelerations[i * variables + j]);
+    }
+    if (i > 0)
+      trajectory.setWayPointDurationFromPrevious(i, durations[i]);
+  }
+  return within_limit;
+}
+
+JerkLimitedSampler::JerkLimitedSampler(const robot_trajectory::RobotTrajectory& trajectory, double period)
+  : trajectory_(trajectory), cursor_(trajectory), period_(period > 0.0 ? period : MIN_SEGMENT_DURATION)
+{
+  if (period <= 0.0)
+    logWarn("Invalid sampling period %f specified, defaulting to %f instead.", period, period_);
+  reset();
+}
+
+void JerkLimitedSampler::reset()
+{
+  cursor_.reset(0.0);
+  done_ = trajectory_.empty();
+}
+
+bool JerkLimitedSampler::next(robot_state::RobotState& state)
+{
+  if (done_)
+    return false;
+  if (cursor_.atEnd())
+  {
+    state = trajectory_.getLastWayPoint();
+    done_ = true;
+    return true;
+  }
+  sample(state);
+  cursor_.advance(period_);
+  return true;
+}
+
+void JerkLimitedSampler::sample(robot_state::RobotState& state) const
+{
+  int before = 0, after = 0;
+  double blend = 1.0;
+  cursor_.getWayPointIndices(before, after, blend);
+  const robot_state::RobotState& from = trajectory_.getWayPoint(before);
+  const robot_state::RobotState& to = trajectory_.getWayPoint(after);
+  from.interpolate(to, blend, state);
+
+  const robot_model::JointModelGroup* group = trajectory_.getGroup();
+  const double duration = trajectory_.getWayPointDurationFromPrevious(after);
+  if (!group || before == after || duration <= 0.0)
+    return;
+
+  const double t = blend * duration;
+  const double d2 = duration * duration;
+  const double d3 = d2 * duration;
+  const std::vector<const robot_model::JointModel*>& joints = group->getActiveJointModels();
+  for (std::size_t k = 0; k < joints.size(); ++k)
+  {
+    if (joints[k]->getVariableCount() != 1)
+      continue;
+    const int index = joints[k]->getFirstVariableIndex();
+    const double p0 = from.getVariablePosition(index);
+    double delta = to.getVariablePosition(index) - p0;
+    if (isContinuous(joints[k]))
+      delta = std::remainder(delta, 2.0 * boost::math::constants::pi<double>());
+    const double v0 = from.hasVelocities() ? from.getVariableVelocity(index) : 0.0;
+    const double v1 = to.hasVelocities() ? to.getVariableVelocity(index) : 0.0;
+    const double a0 = from.hasAccelerations() ? from.getVariableAcceleration(index) : 0.0;
+    const double a1 = to.hasAccelerations() ? to.getVariableAcceleration(index) : 0.0;
+
+    // quintic polynomial p0 + v0 t + a0 t^2 / 2 + c3 t^3 + c4 t^4 + c5 t^5 matching both waypoints
+    const double c3 = (20.0 * delta - (8.0 * v1 + 12.0 * v0) * duration - (3.0 * a0 - a1) * d2) / (2.0 * d3);
+    const double c4 =
+        (-30.0 * delta + (14.0 * v1 + 16.0 * v0) * duration + (3.0 * a0 - 2.0 * a1) * d2) / (2.0 * d3 * duration);
+    const double c5 = (12.0 * delta - 6.0 * (v1 + v0) * duration - (a0 - a1) * d2) / (2.0 * d3 * d2);
+    state.setVariablePosition(index, p0 + t * (v0 + t * (0.5 * a0 + t * (c3 + t * (c4 + t * c5)))));
+    state.setVariableVelocity(index, v0 + t * (a0 + t * (3.0 * c3 + t * (4.0 * c4 + t * 5.0 * c5))));
+    state.setVariableAcceleration(index, a0 + t * (6.0 * c3 + t * (12.0 * c4 + t * 20.0 * c5)));
+    if (isContinuous(joints[k]))
+      state.enforcePositionBounds(joints[k]);
+  }
+}
+}
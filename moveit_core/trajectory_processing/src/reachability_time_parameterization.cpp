@@ -0,0 +1,324 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/trajectory_processing/reachability_time_parameterization.h>
+#include <console_bridge/console.h>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+namespace trajectory_processing
+{
+static const double DEFAULT_VEL_MAX = 1.0;
+static const double DEFAULT_ACCEL_MAX = 1.0;
+
+ReachabilityTimeParameterization::ReachabilityTimeParameterization(unsigned int path_subdivisions)
+  : path_subdivisions_(std::max(path_subdivisions, 1u))
+{
+}
+
+ReachabilityTimeParameterization::~ReachabilityTimeParameterization()
+{
+}
+
+namespace
+{
+// waypoints closer than this in joint space are considered identical
+const double PATH_EPSILON = 1e-9;
+
+// the largest squared path velocity considered, for the parts of the path where no limit applies
+const double MAX_PATH_VELOCITY_SQUARED = 1e8;
+
+// enough bisection steps to bring the bound on the squared path velocity to double precision
+const unsigned int BISECTION_STEPS = 60;
+
+double verifyScalingFactor(double factor, const char* name)
+{
+  if (factor > 0.0 && factor <= 1.0)
+    return factor;
+  if (factor == 0.0)
+    logDebug("A %s of 0.0 was specified, defaulting to 1.0 instead.", name);
+  else
+    logWarn("Invalid %s %f specified, defaulting to 1.0 instead.", name, factor);
+  return 1.0;
+}
+
+/* The second derivatives, at the waypoints, of the natural cubic spline through the waypoints q over the path
+   parameter s. The tridiagonal system is the same for all joints, so it is eliminated once. */
+void computeSplineCurvature(const std::vector<double>& s, const std::vector<std::vector<double> >& q,
+                            std::vector<std::vector<double> >& m)
+{
+  const std::size_t n = s.size() - 1;
+  const std::size_t num_joints = q[0].size();
+  m.assign(n + 1, std::vector<double>(num_joints, 0.0));
+  if (n < 2)
+    return;
+
+  std::vector<double> c(n, 0.0), w(n, 0.0);
+  for (std::size_t i = 1; i < n; ++i)
+  {
+    const double h0 = s[i] - s[i - 1];
+    const double h1 = s[i + 1] - s[i];
+    w[i] = 2.0 * (h0 + h1) - h0 * c[i - 1];
+    c[i] = h1 / w[i];
+    for (std::size_t j = 0; j < num_joints; ++j)
+    {
+      const double d = 6.0 * ((q[i + 1][j] - q[i][j]) / h1 - (q[i][j] - q[i - 1][j]) / h0);
+      m[i][j] = (d - h0 * m[i - 1][j]) / w[i];
+    }
+  }
+  for (std::size_t i = n - 1; i > 0; --i)
+    for (std::size_t j = 0; j < num_joints; ++j)
+      m[i][j] -= c[i] * m[i + 1][j];
+}
+
+// The first and second derivatives of the spline at distance t into the segment that starts at waypoint i
+void evaluateSpline(const std::vector<double>& s, const std::vector<std::vector<double> >& q,
+                    const std::vector<std::vector<double> >& m, std::size_t i, double t, std::vector<double>& dq,
+                    std::vector<double>& ddq)
+{
+  const double h = s[i + 1] - s[i];
+  const double a = (h - t) / h;
+  const double b = t / h;
+  dq.resize(q[i].size());
+  ddq.resize(q[i].size());
+  for (std::size_t j = 0; j < q[i].size(); ++j)
+  {
+    dq[j] = (q[i + 1][j] - q[i][j]) / h + h * ((3.0 * b * b - 1.0) * m[i + 1][j] - (3.0 * a * a - 1.0) * m[i][j]) / 6.0;
+    ddq[j] = a * m[i][j] + b * m[i + 1][j];
+  }
+}
+
+/* The range of path accelerations u for which all joints stay within their acceleration limits, where the path has
+   derivatives dq and ddq and the squared path velocity is x. Returns false if the range is empty. */
+bool getPathAccelerationRange(const std::vector<double>& dq, const std::vector<double>& ddq,
+                              const std::vector<double>& a_max, double x, double& u_min, double& u_max)
+{
+  u_min = -std::numeric_limits<double>::infinity();
+  u_max = std::numeric_limits<double>::infinity();
+  for (std::size_t j = 0; j < dq.size(); ++j)
+  {
+    // the joint acceleration is dq * u + ddq * x
+    if (std::abs(dq[j]) < PATH_EPSILON)
+    {
+      if (std::abs(ddq[j] * x) > a_max[j])
+        return false;
+      continue;
+    }
+    double lo = (-a_max[j] - ddq[j] * x) / dq[j];
+    double hi = (a_max[j] - ddq[j] * x) / dq[j];
+    if (dq[j] < 0.0)
+      std::swap(lo, hi);
+    u_min = std::max(u_min, lo);
+    u_max = std::min(u_max, hi);
+  }
+  return u_min <= u_max;
+}
+
+/* Compute the squared path velocities x and the path accelerations u at the points of a grid over the path, with
+   interval lengths h and path derivatives dq and ddq at the points, such that the path is traversed in minimum time
+   from rest to rest. */
+void parameterizePath(const std::vector<double>& h, const std::vector<std::vector<double> >& dq,
+                      const std::vector<std::vector<double> >& ddq, const std::vector<double>& v_max,
+                      const std::vector<double>& a_max, std::vector<double>& x, std::vector<double>& u)
+{
+  const std::size_t n = h.size();
+  double u_min, u_max;
+
+  /* backward pass: the largest squared path velocity at each point from which the end of the path can be reached at
+     rest; the set of such velocities is an interval starting at zero */
+  std::vector<double> x_max(n + 1, 0.0);
+  for (std::size_t k = n; k-- > 0;)
+  {
+    double bound = MAX_PATH_VELOCITY_SQUARED;
+    for (std::size_t j = 0; j < dq[k].size(); ++j)
+      if (std::abs(dq[k][j]) > PATH_EPSILON)
+        bound = std::min(bound, v_max[j] * v_max[j] / (dq[k][j] * dq[k][j]));
+
+    // the next point is reached with x + 2 * h * u, which must lie in [0, x_max[k + 1]]
+    double lo = 0.0, hi = bound;
+    for (unsigned int step = 0; step <= BISECTION_STEPS; ++step)
+    {
+      const double xk = step == 0 ? hi : 0.5 * (lo + hi);
+      const bool feasible = getPathAccelerationRange(dq[k], ddq[k], a_max, xk, u_min, u_max) &&
+                            2.0 * h[k] * u_min <= x_max[k + 1] - xk && 2.0 * h[k] * u_max >= -xk;
+      if (feasible)
+        lo = xk;
+      else
+        hi = xk;
+      if (feasible && step == 0)
+        break;
+    }
+    x_max[k] = lo;
+  }
+
+  // forward pass: accelerate as much as the limits allow while staying where the end can still be reached
+  x.assign(n + 1, 0.0);
+  u.assign(n + 1, 0.0);
+  for (std::size_t k = 0; k < n; ++k)
+  {
+    const double u_reach = (x_max[k + 1] - x[k]) / (2.0 * h[k]);
+    if (getPathAccelerationRange(dq[k], ddq[k], a_max, x[k], u_min, u_max))
+      u[k] = std::max(std::min(u_max, u_reach), u_min);
+    else
+      u[k] = u_reach;
+    x[k + 1] = std::max(0.0, std::min(x[k] + 2.0 * h[k] * u[k], x_max[k + 1]));
+    u[k] = (x[k + 1] - x[k]) / (2.0 * h[k]);
+  }
+  u[n] = u[n - 1];
+}
+}
+
+bool ReachabilityTimeParameterization::computeTimeStamps(robot_trajectory::RobotTrajectory& trajectory,
+                                                         const double max_velocity_scaling_factor,
+                                                         const double max_acceleration_scaling_factor) const
+{
+  if (trajectory.empty())
+    return true;
+
+  const robot_model::JointModelGroup* group = trajectory.getGroup();
+  if (!group)
+  {
+    logError("It looks like the planner did not set the group the plan was computed for");
+    return false;
+  }
+
+  // the path is interpolated in joint space, which is only meaningful once the continuous joints are unwound
+  trajectory.unwind();
+
+  const std::vector<std::string>& vars = group->getVariableNames();
+  const std::vector<int>& idx = group->getVariableIndexList();
+  const robot_model::RobotModel& rmodel = group->getParentModel();
+  const std::size_t num_points = trajectory.getWayPointCount();
+  const std::size_t num_joints = vars.size();
+
+  const double velocity_scaling_factor =
+      verifyScalingFactor(max_velocity_scaling_factor, "max_velocity_scaling_factor");
+  const double acceleration_scaling_factor =
+      verifyScalingFactor(max_acceleration_scaling_factor, "max_acceleration_scaling_factor");
+  std::vector<double> v_max(num_joints, DEFAULT_VEL_MAX * velocity_scaling_factor);
+  std::vector<double> a_max(num_joints, DEFAULT_ACCEL_MAX * acceleration_scaling_factor);
+  for (std::size_t j = 0; j < num_joints; ++j)
+  {
+    const robot_model::VariableBounds& b = rmodel.getVariableBounds(vars[j]);
+    if (b.velocity_bounded_)
+      v_max[j] = std::min(fabs(b.max_velocity_), fabs(b.min_velocity_)) * velocity_scaling_factor;
+    if (b.acceleration_bounded_)
+      a_max[j] = std::min(fabs(b.max_acceleration_), fabs(b.min_acceleration_)) * acceleration_scaling_factor;
+  }
+
+  /* the path is parameterized by arc length in joint space; repeated waypoints are passed through with no delay,
+     so only the distinct ones take part */
+  std::vector<std::vector<double> > q;
+  std::vector<double> s;
+  std::vector<std::size_t> point_index(num_points);
+  for (std::size_t i = 0; i < num_points; ++i)
+  {
+    const robot_state::RobotState& waypoint = trajectory.getWayPoint(i);
+    std::vector<double> position(num_joints);
+    for (std::size_t j = 0; j < num_joints; ++j)
+      position[j] = waypoint.getVariablePosition(idx[j]);
+    double distance = 0.0;
+    if (!q.empty())
+    {
+      for (std::size_t j = 0; j < num_joints; ++j)
+        distance += (position[j] - q.back()[j]) * (position[j] - q.back()[j]);
+      distance = std::sqrt(distance);
+    }
+    if (q.empty() || distance > PATH_EPSILON)
+    {
+      s.push_back(q.empty() ? 0.0 : s.back() + distance);
+      q.push_back(position);
+    }
+    point_index[i] = q.size() - 1;
+  }
+
+  std::vector<double> x, u;
+  std::vector<std::vector<double> > dq, ddq;
+  std::vector<double> segment_duration;
+  if (q.size() > 1)
+  {
+    std::vector<std::vector<double> > m;
+    computeSplineCurvature(s, q, m);
+
+    // the grid divides each segment between distinct waypoints into path_subdivisions_ intervals
+    const std::size_t num_segments = q.size() - 1;
+    const std::size_t grid_size = num_segments * path_subdivisions_ + 1;
+    std::vector<double> h(grid_size - 1);
+    dq.resize(grid_size);
+    ddq.resize(grid_size);
+    for (std::size_t i = 0; i < num_segments; ++i)
+    {
+      const double step = (s[i + 1] - s[i]) / path_subdivisions_;
+      for (unsigned int k = 0; k < path_subdivisions_; ++k)
+      {
+        const std::size_t g = i * path_subdivisions_ + k;
+        h[g] = step;
+        evaluateSpline(s, q, m, i, step * k, dq[g], ddq[g]);
+      }
+    }
+    evaluateSpline(s, q, m, num_segments - 1, s[num_segments] - s[num_segments - 1], dq.back(), ddq.back());
+
+    parameterizePath(h, dq, ddq, v_max, a_max, x, u);
+
+    segment_duration.assign(num_segments, 0.0);
+    for (std::size_t g = 0; g < h.size(); ++g)
+      segment_duration[g / path_subdivisions_] += 2.0 * h[g] / (std::sqrt(x[g]) + std::sqrt(x[g + 1]));
+  }
+
+  for (std::size_t i = 0; i < num_points; ++i)
+  {
+    const std::size_t p = point_index[i];
+    const bool first_at_point = i == 0 || point_index[i - 1] != p;
+    trajectory.setWayPointDurationFromPrevious(i, first_at_point && p > 0 ? segment_duration[p - 1] : 0.0);
+
+    const robot_state::RobotStatePtr& waypoint = trajectory.getWayPointPtr(i);
+    for (std::size_t j = 0; j < num_joints; ++j)
+    {
+      if (q.size() > 1)
+      {
+        const std::size_t g = p * path_subdivisions_;
+        waypoint->setVariableVelocity(idx[j], dq[g][j] * std::sqrt(x[g]));
+        waypoint->setVariableAcceleration(idx[j], dq[g][j] * u[g] + ddq[g][j] * x[g]);
+      }
+      else
+      {
+        waypoint->setVariableVelocity(idx[j], 0.0);
+        waypoint->setVariableAcceleration(idx[j], 0.0);
+      }
+    }
+  }
+  return true;
+}
+}
@@ -194,6 +194,14 @@ public:
    */
   virtual const Eigen::Affine3d& getTransform(const std::string& from_frame) const;
 
+  /**
+   * @brief Find the fixed transform for from_frame (w.r.t target frame) with a single lookup
+   * @param from_frame The string id of the frame for which the transform is being computed
+   * @return A pointer to the transform maintained by this object, or NULL if the frame is not known. The pointer stays
+   * valid until the transform of \e from_frame is set again or setAllTransforms() is called
+   */
+  const Eigen::Affine3d* findTransform(const std::string& from_frame) const;
+
 protected:
   std::string target_frame_;
   FixedTransformsMap transforms_;
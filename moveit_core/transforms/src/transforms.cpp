@@ -88,21 +88,23 @@ void moveit::core::Transforms::setAllTransforms(const FixedTransformsMap& transf
 
 bool moveit::core::Transforms::isFixedFrame(const std::string& frame) const
 {
-  if (frame.empty())
-    return false;
-  else
-    return (frame[0] == '/' ? transforms_.find(frame) : transforms_.find('/' + frame)) != transforms_.end();
+  return findTransform(frame) != NULL;
+}
+
+const Eigen::Affine3d* moveit::core::Transforms::findTransform(const std::string& from_frame) const
+{
+  if (from_frame.empty())
+    return NULL;
+  FixedTransformsMap::const_iterator it =
+      (from_frame[0] == '/' ? transforms_.find(from_frame) : transforms_.find('/' + from_frame));
+  return it != transforms_.end() ? &it->second : NULL;
 }
 
 const Eigen::Affine3d& moveit::core::Transforms::getTransform(const std::string& from_frame) const
 {
-  if (!from_frame.empty())
-  {
-    FixedTransformsMap::const_iterator it =
-        (from_frame[0] == '/' ? transforms_.find(from_frame) : transforms_.find('/' + from_frame));
-    if (it != transforms_.end())
-      return it->second;
-  }
+  const Eigen::Affine3d* transform = findTransform(from_frame);
+  if (transform)
+    return *transform;
 
   logError("Unable to transform from frame '%s' to frame '%s'. Returning identity.", from_frame.c_str(),
            target_frame_.c_str());
@@ -114,11 +116,7 @@ const Eigen::Affine3d& moveit::core::Transforms::getTransform(const std::string&
 
 bool moveit::core::Transforms::canTransform(const std::string& from_frame) const
 {
-  if (from_frame.empty())
-    return false;
-  else
-    return (from_frame[0] == '/' ? transforms_.find(from_frame) : transforms_.find('/' + from_frame)) !=
-           transforms_.end();
+  return findTransform(from_frame) != NULL;
 }
 
 void moveit::core::Transforms::setTransform(const Eigen::Affine3d& t, const std::string& from_frame)
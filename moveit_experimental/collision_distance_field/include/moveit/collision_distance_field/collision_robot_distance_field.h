@@ -43,6 +43,7 @@
 #include <moveit/collision_distance_field/collision_common_distance_field.h>
 #include <moveit/planning_scene/planning_scene.h>
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
 
 namespace collision_detection
 {
@@ -230,6 +231,13 @@ protected:
   void getGroupStateRepresentation(const DistanceFieldCacheEntryConstPtr& dfce, const moveit::core::RobotState& state,
                                    GroupStateRepresentationPtr& gsr) const;
 
+  /** \brief Get the group state representation the calling thread keeps for \e group_name. It is reset if it was
+      built for a distance field cache entry that does not match \e state and \e acm any more, so that
+      checkSelfCollisionHelper() regenerates it; otherwise only the sphere centers are updated. */
+  GroupStateRepresentationPtr&
+  getThreadGroupStateRepresentation(const std::string& group_name, const moveit::core::RobotState& state,
+                                    const collision_detection::AllowedCollisionMatrix* acm) const;
+
   bool compareCacheEntryToState(const DistanceFieldCacheEntryConstPtr& dfce,
                                 const moveit::core::RobotState& state) const;
 
@@ -253,6 +261,9 @@ protected:
   std::map<std::string, std::map<std::string, bool>> in_group_update_map_;
   std::map<std::string, GroupStateRepresentationPtr> pregenerated_group_state_representation_map_;
 
+  // the group state representations kept by each thread for the checks that are not handed one, by group name
+  mutable boost::thread_specific_ptr<std::map<std::string, GroupStateRepresentationPtr>> thread_gsr_map_;
+
   planning_scene::PlanningScenePtr planning_scene_;
 };
 }
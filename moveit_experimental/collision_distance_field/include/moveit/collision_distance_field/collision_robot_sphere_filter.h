@@ -0,0 +1,112 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_COLLISION_DISTANCE_FIELD_COLLISION_ROBOT_SPHERE_FILTER_H_
+#define MOVEIT_COLLISION_DISTANCE_FIELD_COLLISION_ROBOT_SPHERE_FILTER_H_
+
+#include <moveit/collision_detection_fcl/collision_robot_fcl.h>
+#include <boost/thread/tss.hpp>
+
+namespace collision_detection
+{
+/** \brief An FCL robot that runs a conservative bounding sphere test over all pairs of collision bodies first and
+    only passes the pairs whose spheres overlap on to FCL's narrowphase. The contacts, costs and allowed collision
+    semantics are those of CollisionRobotFCL, since the flagged pairs go through the same FCL callback. */
+class CollisionRobotSphereFilter : public CollisionRobotFCL
+{
+public:
+  /** \brief The bounding spheres of the robot's collision bodies at one state, kept by a single thread. Link bodies
+      come first, indexed like the collision body transforms of the robot, followed by the attached body objects. */
+  struct PosedSpheres
+  {
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    /// The sphere centers in the world frame
+    EigenSTL::vector_Vector3d centers_;
+
+    /// The sphere radii; negative where a link has no collision geometry, infinite where no bound is known
+    std::vector<double> radii_;
+
+    /// Copies of the link objects, only placed at the state once a pair involving them reaches the narrowphase
+    std::vector<FCLCollisionObjectPtr> link_objects_;
+
+    /// Whether the link object at the same index was placed for the current state
+    std::vector<char> link_object_posed_;
+
+    /// The objects constructed for the bodies attached to the robot at the current state
+    FCLObject attached_object_;
+
+    /// The value of geometry_version_ link_objects_ were copied for
+    unsigned int geometry_version_;
+  };
+
+  CollisionRobotSphereFilter(const robot_model::RobotModelConstPtr& kmodel, double padding = 0.0, double scale = 1.0);
+
+  CollisionRobotSphereFilter(const CollisionRobotSphereFilter& other);
+
+  virtual void checkSelfCollision(const CollisionRequest& req, CollisionResult& res,
+                                  const robot_state::RobotState& state) const;
+  virtual void checkSelfCollision(const CollisionRequest& req, CollisionResult& res,
+                                  const robot_state::RobotState& state, const AllowedCollisionMatrix& acm) const;
+  using CollisionRobotFCL::checkSelfCollision;
+
+  /** \brief Compute the bounding spheres of the collision bodies of the robot at \e state. The returned structure
+      belongs to the calling thread and is overwritten by its next query. */
+  PosedSpheres& getPosedSpheres(const robot_state::RobotState& state) const;
+
+  /** \brief Get the FCL object for body \e index of \e spheres, placed at \e state (the state \e spheres were
+      computed for) */
+  fcl::CollisionObject* getPosedObject(PosedSpheres& spheres, std::size_t index,
+                                       const robot_state::RobotState& state) const;
+
+protected:
+  virtual void updatedPaddingOrScaling(const std::vector<std::string>& links);
+
+  void checkSelfCollisionFiltered(const CollisionRequest& req, CollisionResult& res,
+                                  const robot_state::RobotState& state, const AllowedCollisionMatrix* acm) const;
+
+  /** \brief Compute the bounding sphere of link body \e index, in the frame of its shape */
+  void computeLinkSphere(std::size_t index);
+
+  /// The bounding sphere centers of the link bodies in the frames of their shapes, indexed like geoms_
+  EigenSTL::vector_Vector3d link_sphere_centers_;
+
+  /// The bounding sphere radii of the link bodies, indexed like geoms_ (see PosedSpheres::radii_)
+  std::vector<double> link_sphere_radii_;
+
+  mutable boost::thread_specific_ptr<PosedSpheres> posed_spheres_;
+};
+}
+
+#endif
@@ -89,6 +89,19 @@ public:
                               const robot_state::RobotState& state, const AllowedCollisionMatrix& acm,
                               GroupStateRepresentationPtr& gsr) const;
 
+  /** \brief Check a batch of states against the voxelized world. The sphere representation of the robot is
+      generated for the first state only and updated in place for the others, so the states are expected to
+      share their attached bodies, as when a GroupStateRepresentationPtr is passed to checkCollision() directly */
+  virtual std::size_t checkCollisionBatch(const CollisionRequest& req, std::vector<CollisionResult>& res,
+                                          const CollisionRobot& robot,
+                                          const std::vector<const robot_state::RobotState*>& states,
+                                          bool stop_at_first_collision = true) const;
+
+  virtual std::size_t checkCollisionBatch(const CollisionRequest& req, std::vector<CollisionResult>& res,
+                                          const CollisionRobot& robot,
+                                          const std::vector<const robot_state::RobotState*>& states,
+                                          const AllowedCollisionMatrix& acm, bool stop_at_first_collision = true) const;
+
   virtual void checkRobotCollision(const CollisionRequest& req, CollisionResult& res, const CollisionRobot& robot,
                                    const robot_state::RobotState& state) const;
 
@@ -151,6 +164,7 @@ public:
 
   collision_detection::GroupStateRepresentationConstPtr getLastGroupStateRepresentation() const
   {
+    boost::mutex::scoped_lock slock(last_gsr_lock_);
     return last_gsr_;
   }
 
@@ -177,6 +191,10 @@ protected:
 
   static void notifyObjectChange(CollisionWorldDistanceField* self, const ObjectConstPtr& obj, World::Action action);
 
+  /** \brief Remember \e gsr as the last group state representation; the checks that call this can run concurrently
+   * on different group state representations */
+  void setLastGroupStateRepresentation(const GroupStateRepresentationPtr& gsr) const;
+
   Eigen::Vector3d size_;
   Eigen::Vector3d origin_;
   bool use_signed_distance_field_;
@@ -187,6 +205,7 @@ protected:
   mutable boost::mutex update_cache_lock_;
   DistanceFieldCacheEntryPtr distance_field_cache_entry_;
   GroupStateRepresentationPtr last_gsr_;
+  mutable boost::mutex last_gsr_lock_;
   World::ObserverHandle observer_handle_;
 };
 }
@@ -0,0 +1,70 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_COLLISION_DISTANCE_FIELD_COLLISION_WORLD_SPHERE_FILTER_H_
+#define MOVEIT_COLLISION_DISTANCE_FIELD_COLLISION_WORLD_SPHERE_FILTER_H_
+
+#include <moveit/collision_detection_fcl/collision_world_fcl.h>
+#include <moveit/collision_distance_field/collision_robot_sphere_filter.h>
+
+namespace collision_detection
+{
+/** \brief An FCL world that tests the bounding spheres of a CollisionRobotSphereFilter against the bounding boxes of
+    the world objects and only runs FCL's narrowphase for the pairs that overlap. Other robots are checked the way
+    CollisionWorldFCL checks them. */
+class CollisionWorldSphereFilter : public CollisionWorldFCL
+{
+public:
+  CollisionWorldSphereFilter();
+  explicit CollisionWorldSphereFilter(const WorldPtr& world);
+  CollisionWorldSphereFilter(const CollisionWorldSphereFilter& other, const WorldPtr& world);
+
+  virtual ~CollisionWorldSphereFilter()
+  {
+  }
+
+  virtual void checkRobotCollision(const CollisionRequest& req, CollisionResult& res, const CollisionRobot& robot,
+                                   const robot_state::RobotState& state) const;
+  virtual void checkRobotCollision(const CollisionRequest& req, CollisionResult& res, const CollisionRobot& robot,
+                                   const robot_state::RobotState& state, const AllowedCollisionMatrix& acm) const;
+  using CollisionWorldFCL::checkRobotCollision;
+
+protected:
+  void checkRobotCollisionFiltered(const CollisionRequest& req, CollisionResult& res,
+                                   const CollisionRobotSphereFilter& robot, const robot_state::RobotState& state,
+                                   const AllowedCollisionMatrix* acm) const;
+};
+}
+
+#endif
@@ -42,7 +42,6 @@
 #include <memory>
 
 const static double RESOLUTION_SCALE = 1.0;
-const static double EPSILON = 0.0001;
 
 std::vector<collision_detection::CollisionSphere>
 collision_detection::determineCollisionSpheres(const bodies::Body* body, Eigen::Affine3d& relative_transform)
@@ -137,18 +136,16 @@ bool collision_detection::getCollisionSphereGradients(const distance_field::Dist
 {
   // assumes gradient is properly initialized
 
+  // all spheres are looked up in one pass; the buffers are kept per thread so their storage is reused across calls
+  static thread_local std::vector<double> sphere_distances;
+  static thread_local EigenSTL::vector_Vector3d sphere_gradients;
+  distance_field->getDistanceGradients(sphere_centers, sphere_distances, sphere_gradients);
+
   bool in_collision = false;
   for (unsigned int i = 0; i < sphere_list.size(); i++)
   {
-    Eigen::Vector3d p = sphere_centers[i];
-    Eigen::Vector3d grad;
-    bool in_bounds;
-    double dist = distance_field->getDistanceGradient(p.x(), p.y(), p.z(), grad.x(), grad.y(), grad.z(), in_bounds);
-    if (!in_bounds && grad.norm() > EPSILON)
-    {
-      ROS_DEBUG("Collision sphere point is out of bounds %lf, %lf, %lf", p.x(), p.y(), p.z());
-      return true;
-    }
+    double dist = sphere_distances[i];
+    const Eigen::Vector3d& grad = sphere_gradients[i];
 
     if (dist < maximum_value)
     {
@@ -206,11 +206,29 @@ DistanceFieldCacheEntryConstPtr CollisionRobotDistanceField::getDistanceFieldCac
   return cur;
 }
 
+GroupStateRepresentationPtr& CollisionRobotDistanceField::getThreadGroupStateRepresentation(
+    const std::string& group_name, const moveit::core::RobotState& state,
+    const collision_detection::AllowedCollisionMatrix* acm) const
+{
+  std::map<std::string, GroupStateRepresentationPtr>* gsr_map = thread_gsr_map_.get();
+  if (!gsr_map)
+  {
+    gsr_map = new std::map<std::string, GroupStateRepresentationPtr>();
+    thread_gsr_map_.reset(gsr_map);
+  }
+  GroupStateRepresentationPtr& gsr = (*gsr_map)[group_name];
+  if (gsr && gsr->dfce_ != getDistanceFieldCacheEntry(group_name, state, acm))
+  {
+    gsr.reset();
+  }
+  return gsr;
+}
+
 void CollisionRobotDistanceField::checkSelfCollision(const collision_detection::CollisionRequest& req,
                                                      collision_detection::CollisionResult& res,
                                                      const moveit::core::RobotState& state) const
 {
-  GroupStateRepresentationPtr gsr;
+  GroupStateRepresentationPtr& gsr = getThreadGroupStateRepresentation(req.group_name, state, NULL);
   checkSelfCollisionHelper(req, res, state, NULL, gsr);
 }
 
@@ -227,7 +245,7 @@ void CollisionRobotDistanceField::checkSelfCollision(const collision_detection::
                                                      const moveit::core::RobotState& state,
                                                      const collision_detection::AllowedCollisionMatrix& acm) const
 {
-  GroupStateRepresentationPtr gsr;
+  GroupStateRepresentationPtr& gsr = getThreadGroupStateRepresentation(req.group_name, state, &acm);
   checkSelfCollisionHelper(req, res, state, &acm, gsr);
 }
 
@@ -1251,13 +1269,7 @@ void CollisionRobotDistanceField::getGroupStateRepresentation(const DistanceFiel
 bool CollisionRobotDistanceField::compareCacheEntryToState(const DistanceFieldCacheEntryConstPtr& dfce,
                                                            const moveit::core::RobotState& state) const
 {
-  std::vector<double> new_state_values(state.getVariableCount());
-  for (unsigned int i = 0; i < new_state_values.size(); i++)
-  {
-    new_state_values[i] = state.getVariablePosition(i);
-  }
-
-  if (dfce->state_values_.size() != new_state_values.size())
+  if (dfce->state_values_.size() != state.getVariableCount())
   {
     ROS_ERROR("State value size mismatch");
     return false;
@@ -1265,8 +1277,8 @@ bool CollisionRobotDistanceField::compareCacheEntryToState(const DistanceFieldCa
 
   for (unsigned int i = 0; i < dfce->state_check_indices_.size(); i++)
   {
-    double diff =
-        fabs(dfce->state_values_[dfce->state_check_indices_[i]] - new_state_values[dfce->state_check_indices_[i]]);
+    double diff = fabs(dfce->state_values_[dfce->state_check_indices_[i]] -
+                       state.getVariablePosition(dfce->state_check_indices_[i]));
     if (diff > EPSILON)
     {
       ROS_WARN_STREAM("State for Variable " << state.getVariableNames()[dfce->state_check_indices_[i]]
@@ -1274,8 +1286,9 @@ bool CollisionRobotDistanceField::compareCacheEntryToState(const DistanceFieldCa
       return false;
     }
   }
-  std::vector<const moveit::core::AttachedBody*> attached_bodies_dfce;
-  std::vector<const moveit::core::AttachedBody*> attached_bodies_state;
+  // this runs for every check made with a cached group state representation, so the buffers are kept per thread
+  static thread_local std::vector<const moveit::core::AttachedBody*> attached_bodies_dfce;
+  static thread_local std::vector<const moveit::core::AttachedBody*> attached_bodies_state;
   dfce->state_->getAttachedBodies(attached_bodies_dfce);
   state.getAttachedBodies(attached_bodies_state);
   if (attached_bodies_dfce.size() != attached_bodies_state.size())
@@ -0,0 +1,197 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/collision_distance_field/collision_robot_sphere_filter.h>
+#include <geometric_shapes/bodies.h>
+#include <boost/scoped_ptr.hpp>
+#include <limits>
+
+collision_detection::CollisionRobotSphereFilter::CollisionRobotSphereFilter(
+    const robot_model::RobotModelConstPtr& kmodel, double padding, double scale)
+  : CollisionRobotFCL(kmodel, padding, scale)
+{
+  link_sphere_centers_.resize(geoms_.size(), Eigen::Vector3d::Zero());
+  link_sphere_radii_.resize(geoms_.size(), -1.0);
+  for (std::size_t i = 0; i < geoms_.size(); ++i)
+    computeLinkSphere(i);
+}
+
+collision_detection::CollisionRobotSphereFilter::CollisionRobotSphereFilter(const CollisionRobotSphereFilter& other)
+  : CollisionRobotFCL(other)
+  , link_sphere_centers_(other.link_sphere_centers_)
+  , link_sphere_radii_(other.link_sphere_radii_)
+{
+}
+
+void collision_detection::CollisionRobotSphereFilter::computeLinkSphere(std::size_t index)
+{
+  link_sphere_centers_[index] = Eigen::Vector3d::Zero();
+  link_sphere_radii_[index] = -1.0;
+  if (!geoms_[index] || !geoms_[index]->collision_geometry_)
+    return;
+
+  const robot_model::LinkModel* link = geoms_[index]->collision_geometry_data_->ptr.link;
+  std::size_t shape_index = geoms_[index]->collision_geometry_data_->shape_index;
+  boost::scoped_ptr<bodies::Body> body(bodies::createBodyFromShape(link->getShapes()[shape_index].get()));
+  if (!body)
+  {
+    // no bound is known for this shape (octrees, for instance); always pass its pairs on to FCL
+    link_sphere_radii_[index] = std::numeric_limits<double>::infinity();
+    return;
+  }
+  body->setScale(getLinkScale(link->getName()));
+  body->setPadding(getLinkPadding(link->getName()));
+  bodies::BoundingSphere sphere;
+  body->computeBoundingSphere(sphere);
+  link_sphere_centers_[index] = sphere.center;
+  link_sphere_radii_[index] = sphere.radius;
+}
+
+void collision_detection::CollisionRobotSphereFilter::updatedPaddingOrScaling(const std::vector<std::string>& links)
+{
+  CollisionRobotFCL::updatedPaddingOrScaling(links);
+  for (std::size_t i = 0; i < links.size(); ++i)
+  {
+    const robot_model::LinkModel* lmodel = robot_model_->getLinkModel(links[i]);
+    if (lmodel)
+      for (std::size_t j = 0; j < lmodel->getShapes().size(); ++j)
+        computeLinkSphere(lmodel->getFirstCollisionBodyTransformIndex() + j);
+  }
+}
+
+collision_detection::CollisionRobotSphereFilter::PosedSpheres&
+collision_detection::CollisionRobotSphereFilter::getPosedSpheres(const robot_state::RobotState& state) const
+{
+  PosedSpheres* spheres = posed_spheres_.get();
+  if (!spheres)
+  {
+    spheres = new PosedSpheres();
+    spheres->geometry_version_ = geometry_version_ - 1;
+    posed_spheres_.reset(spheres);
+  }
+  if (spheres->geometry_version_ != geometry_version_)
+  {
+    spheres->link_objects_.assign(geoms_.size(), FCLCollisionObjectPtr());
+    for (std::size_t i = 0; i < geoms_.size(); ++i)
+      if (geoms_[i] && geoms_[i]->collision_geometry_)
+        spheres->link_objects_[i].reset(new fcl::CollisionObject(*fcl_objs_[i]));
+    spheres->geometry_version_ = geometry_version_;
+  }
+
+  spheres->centers_.resize(geoms_.size());
+  spheres->radii_.resize(geoms_.size());
+  spheres->link_object_posed_.assign(geoms_.size(), 0);
+  for (std::size_t i = 0; i < geoms_.size(); ++i)
+  {
+    spheres->radii_[i] = link_sphere_radii_[i];
+    if (link_sphere_radii_[i] >= 0.0)
+      spheres->centers_[i] = state.getCollisionBodyTransform(geoms_[i]->collision_geometry_data_->ptr.link,
+                                                             geoms_[i]->collision_geometry_data_->shape_index) *
+                             link_sphere_centers_[i];
+  }
+
+  // attached bodies change from state to state; bound the objects constructed for them by their bounding boxes
+  spheres->attached_object_.clear();
+  constructAttachedBodyObjects(state, spheres->attached_object_);
+  for (std::size_t i = 0; i < spheres->attached_object_.collision_objects_.size(); ++i)
+  {
+    const fcl::AABB& aabb = spheres->attached_object_.collision_objects_[i]->getAABB();
+    const fcl::Vec3f center = aabb.center();
+    spheres->centers_.push_back(Eigen::Vector3d(center[0], center[1], center[2]));
+    spheres->radii_.push_back(aabb.radius());
+  }
+  return *spheres;
+}
+
+fcl::CollisionObject* collision_detection::CollisionRobotSphereFilter::getPosedObject(
+    PosedSpheres& spheres, std::size_t index, const robot_state::RobotState& state) const
+{
+  if (index >= spheres.link_objects_.size())
+    return spheres.attached_object_.collision_objects_[index - spheres.link_objects_.size()].get();
+
+  fcl::CollisionObject* object = spheres.link_objects_[index].get();
+  if (!spheres.link_object_posed_[index])
+  {
+    object->setTransform(transform2fcl(state.getCollisionBodyTransform(
+        geoms_[index]->collision_geometry_data_->ptr.link, geoms_[index]->collision_geometry_data_->shape_index)));
+    object->computeAABB();
+    spheres.link_object_posed_[index] = 1;
+  }
+  return object;
+}
+
+void collision_detection::CollisionRobotSphereFilter::checkSelfCollision(const CollisionRequest& req,
+                                                                         CollisionResult& res,
+                                                                         const robot_state::RobotState& state) const
+{
+  checkSelfCollisionFiltered(req, res, state, NULL);
+}
+
+void collision_detection::CollisionRobotSphereFilter::checkSelfCollision(const CollisionRequest& req,
+                                                                         CollisionResult& res,
+                                                                         const robot_state::RobotState& state,
+                                                                         const AllowedCollisionMatrix& acm) const
+{
+  checkSelfCollisionFiltered(req, res, state, &acm);
+}
+
+void collision_detection::CollisionRobotSphereFilter::checkSelfCollisionFiltered(
+    const CollisionRequest& req, CollisionResult& res, const robot_state::RobotState& state,
+    const AllowedCollisionMatrix* acm) const
+{
+  PosedSpheres& spheres = getPosedSpheres(state);
+  CollisionData cd(&req, &res, acm);
+  cd.enableGroup(getRobotModel());
+  cd.compileAllowedCollisions(getRobotModel());
+
+  const std::size_t count = spheres.radii_.size();
+  for (std::size_t i = 0; !cd.done_ && i < count; ++i)
+  {
+    if (spheres.radii_[i] < 0.0)
+      continue;
+    for (std::size_t j = i + 1; !cd.done_ && j < count; ++j)
+    {
+      if (spheres.radii_[j] < 0.0)
+        continue;
+      double r = spheres.radii_[i] + spheres.radii_[j];
+      if ((spheres.centers_[i] - spheres.centers_[j]).squaredNorm() > r * r)
+        continue;
+      // the bounds overlap; FCL decides, and applies the group, the allowed collisions and the contact limits
+      collisionCallback(getPosedObject(spheres, i, state), getPosedObject(spheres, j, state), &cd);
+    }
+  }
+
+  if (req.distance)
+    distanceSelfHelper(getDistanceRequest(req), res, state, acm);
+}
@@ -143,7 +143,7 @@ void CollisionWorldDistanceField::checkCollision(const CollisionRequest& req, Co
     return;
   }
 
-  (const_cast<CollisionWorldDistanceField*>(this))->last_gsr_ = gsr;
+  setLastGroupStateRepresentation(gsr);
 }
 
 void CollisionWorldDistanceField::checkCollision(const CollisionRequest& req, CollisionResult& res,
@@ -186,7 +186,59 @@ void CollisionWorldDistanceField::checkCollision(const CollisionRequest& req, Co
     return;
   }
 
-  (const_cast<CollisionWorldDistanceField*>(this))->last_gsr_ = gsr;
+  setLastGroupStateRepresentation(gsr);
+}
+
+std::size_t CollisionWorldDistanceField::checkCollisionBatch(const CollisionRequest& req,
+                                                             std::vector<CollisionResult>& res,
+                                                             const CollisionRobot& robot,
+                                                             const std::vector<const robot_state::RobotState*>& states,
+                                                             bool stop_at_first_collision) const
+{
+  res.resize(states.size());
+  for (std::size_t i = 0; i < res.size(); ++i)
+    res[i].clear();
+
+  // one representation for the whole batch; only the sphere centers move from one state to the next
+  GroupStateRepresentationPtr gsr;
+  std::size_t first_collision = states.size();
+  for (std::size_t i = 0; i < states.size(); ++i)
+  {
+    checkCollision(req, res[i], robot, *states[i], gsr);
+    if (res[i].collision && first_collision == states.size())
+    {
+      first_collision = i;
+      if (stop_at_first_collision)
+        break;
+    }
+  }
+  return first_collision;
+}
+
+std::size_t CollisionWorldDistanceField::checkCollisionBatch(const CollisionRequest& req,
+                                                             std::vector<CollisionResult>& res,
+                                                             const CollisionRobot& robot,
+                                                             const std::vector<const robot_state::RobotState*>& states,
+                                                             const AllowedCollisionMatrix& acm,
+                                                             bool stop_at_first_collision) const
+{
+  res.resize(states.size());
+  for (std::size_t i = 0; i < res.size(); ++i)
+    res[i].clear();
+
+  GroupStateRepresentationPtr gsr;
+  std::size_t first_collision = states.size();
+  for (std::size_t i = 0; i < states.size(); ++i)
+  {
+    checkCollision(req, res[i], robot, *states[i], acm, gsr);
+    if (res[i].collision && first_collision == states.size())
+    {
+      first_collision = i;
+      if (stop_at_first_collision)
+        break;
+    }
+  }
+  return first_collision;
 }
 
 void CollisionWorldDistanceField::checkRobotCollision(const CollisionRequest& req, CollisionResult& res,
@@ -215,7 +267,7 @@ void CollisionWorldDistanceField::checkRobotCollision(const CollisionRequest& re
       cdr.updateGroupStateRepresentationState(state, gsr);
     }
     getEnvironmentCollisions(req, res, env_distance_field, gsr);
-    (const_cast<CollisionWorldDistanceField*>(this))->last_gsr_ = gsr;
+    setLastGroupStateRepresentation(gsr);
 
     // checkRobotCollisionHelper(req, res, robot, state, &acm);
   }
@@ -253,7 +305,7 @@ void CollisionWorldDistanceField::checkRobotCollision(const CollisionRequest& re
       cdr.updateGroupStateRepresentationState(state, gsr);
     }
     getEnvironmentCollisions(req, res, env_distance_field, gsr);
-    (const_cast<CollisionWorldDistanceField*>(this))->last_gsr_ = gsr;
+    setLastGroupStateRepresentation(gsr);
 
     // checkRobotCollisionHelper(req, res, robot, state, &acm);
   }
@@ -292,6 +344,12 @@ void CollisionWorldDistanceField::getCollisionGradients(const CollisionRequest&
     return;
   }
 
+  setLastGroupStateRepresentation(gsr);
+}
+
+void CollisionWorldDistanceField::setLastGroupStateRepresentation(const GroupStateRepresentationPtr& gsr) const
+{
+  boost::mutex::scoped_lock slock(last_gsr_lock_);
   (const_cast<CollisionWorldDistanceField*>(this))->last_gsr_ = gsr;
 }
 
@@ -322,7 +380,7 @@ void CollisionWorldDistanceField::getAllCollisions(const CollisionRequest& req,
     return;
   }
 
-  (const_cast<CollisionWorldDistanceField*>(this))->last_gsr_ = gsr;
+  setLastGroupStateRepresentation(gsr);
 }
 
 bool CollisionWorldDistanceField::getEnvironmentCollisions(
@@ -483,8 +541,8 @@ void CollisionWorldDistanceField::notifyObjectChange(CollisionWorldDistanceField
   }
   else if (action & (World::MOVE_SHAPE | World::REMOVE_SHAPE))
   {
-    self->distance_field_cache_entry_->distance_field_->removePointsFromField(subtract_points);
-    self->distance_field_cache_entry_->distance_field_->addPointsToField(add_points);
+    // the old and new decompositions of a moved object usually overlap; only the cells that differ are propagated
+    self->distance_field_cache_entry_->distance_field_->updatePointsInField(subtract_points, add_points);
   }
   else
   {
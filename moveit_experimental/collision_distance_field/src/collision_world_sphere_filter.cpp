@@ -0,0 +1,123 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/collision_distance_field/collision_world_sphere_filter.h>
+
+namespace
+{
+// squared distance from a point to an axis aligned box
+double squaredDistanceToAABB(const Eigen::Vector3d& point, const fcl::AABB& aabb)
+{
+  double d = 0.0;
+  for (int k = 0; k < 3; ++k)
+  {
+    if (point[k] < aabb.min_[k])
+      d += (aabb.min_[k] - point[k]) * (aabb.min_[k] - point[k]);
+    else if (point[k] > aabb.max_[k])
+      d += (point[k] - aabb.max_[k]) * (point[k] - aabb.max_[k]);
+  }
+  return d;
+}
+}
+
+collision_detection::CollisionWorldSphereFilter::CollisionWorldSphereFilter() : CollisionWorldFCL()
+{
+}
+
+collision_detection::CollisionWorldSphereFilter::CollisionWorldSphereFilter(const WorldPtr& world)
+  : CollisionWorldFCL(world)
+{
+}
+
+collision_detection::CollisionWorldSphereFilter::CollisionWorldSphereFilter(const CollisionWorldSphereFilter& other,
+                                                                            const WorldPtr& world)
+  : CollisionWorldFCL(other, world)
+{
+}
+
+void collision_detection::CollisionWorldSphereFilter::checkRobotCollision(const CollisionRequest& req,
+                                                                          CollisionResult& res,
+                                                                          const CollisionRobot& robot,
+                                                                          const robot_state::RobotState& state) const
+{
+  const CollisionRobotSphereFilter* robot_sf = dynamic_cast<const CollisionRobotSphereFilter*>(&robot);
+  if (robot_sf)
+    checkRobotCollisionFiltered(req, res, *robot_sf, state, NULL);
+  else
+    CollisionWorldFCL::checkRobotCollision(req, res, robot, state);
+}
+
+void collision_detection::CollisionWorldSphereFilter::checkRobotCollision(const CollisionRequest& req,
+                                                                          CollisionResult& res,
+                                                                          const CollisionRobot& robot,
+                                                                          const robot_state::RobotState& state,
+                                                                          const AllowedCollisionMatrix& acm) const
+{
+  const CollisionRobotSphereFilter* robot_sf = dynamic_cast<const CollisionRobotSphereFilter*>(&robot);
+  if (robot_sf)
+    checkRobotCollisionFiltered(req, res, *robot_sf, state, &acm);
+  else
+    CollisionWorldFCL::checkRobotCollision(req, res, robot, state, acm);
+}
+
+void collision_detection::CollisionWorldSphereFilter::checkRobotCollisionFiltered(
+    const CollisionRequest& req, CollisionResult& res, const CollisionRobotSphereFilter& robot,
+    const robot_state::RobotState& state, const AllowedCollisionMatrix* acm) const
+{
+  CollisionRobotSphereFilter::PosedSpheres& spheres = robot.getPosedSpheres(state);
+  CollisionData cd(&req, &res, acm);
+  cd.enableGroup(robot.getRobotModel());
+  cd.compileAllowedCollisions(robot.getRobotModel());
+
+  // fcl_objs_ holds every object of this world, whether it is registered with the base manager or with manager_
+  for (FCLObjectMap::const_iterator it = fcl_objs_->begin(); !cd.done_ && it != fcl_objs_->end(); ++it)
+    for (std::size_t k = 0; !cd.done_ && k < it->second.collision_objects_.size(); ++k)
+    {
+      fcl::CollisionObject* world_object = it->second.collision_objects_[k].get();
+      const fcl::AABB& aabb = world_object->getAABB();
+      for (std::size_t i = 0; !cd.done_ && i < spheres.radii_.size(); ++i)
+      {
+        double r = spheres.radii_[i];
+        if (r < 0.0 || squaredDistanceToAABB(spheres.centers_[i], aabb) > r * r)
+          continue;
+        collisionCallback(robot.getPosedObject(spheres, i, state), world_object, &cd);
+      }
+    }
+
+  if (req.distance)
+    distanceRobotHelper(getDistanceRequest(req), res, robot, state, acm);
+}
+
+#include <moveit/collision_distance_field/collision_detector_allocator_sphere_filter.h>
+const std::string collision_detection::CollisionDetectorAllocatorSphereFilter::NAME_("SPHERE_FILTER");
@@ -40,6 +40,7 @@
 #include <moveit/collision_distance_field/collision_distance_field_types.h>
 #include <moveit/collision_distance_field/collision_robot_distance_field.h>
 #include <moveit/collision_distance_field/collision_world_distance_field.h>
+#include <moveit/collision_distance_field/collision_robot_sphere_filter.h>
 #include <moveit_resources/config.h>
 
 #include <geometric_shapes/shape_operations.h>
@@ -180,6 +181,41 @@ TEST_F(DistanceFieldCollisionDetectionTester, LinksInCollision)
   ASSERT_TRUE(res3.collision);
 }
 
+TEST_F(DistanceFieldCollisionDetectionTester, ReusedGroupStateRepresentation)
+{
+  collision_detection::CollisionRequest req;
+  req.group_name = "whole_body";
+
+  robot_state::RobotState default_state(robot_model_);
+  default_state.setToDefaultValues();
+  default_state.update();
+
+  robot_state::RobotState colliding_state(default_state);
+  Eigen::Affine3d offset = Eigen::Affine3d::Identity();
+  offset.translation().x() = .01;
+  colliding_state.updateStateWithLinkAt("r_gripper_palm_link", Eigen::Affine3d::Identity());
+  colliding_state.updateStateWithLinkAt("l_gripper_palm_link", offset);
+  acm_->setEntry("r_gripper_palm_link", "l_gripper_palm_link", false);
+
+  // the checks without a group state representation reuse the one kept for this thread
+  for (unsigned int i = 0; i < 3; i++)
+  {
+    collision_detection::CollisionResult res1;
+    crobot_->checkSelfCollision(req, res1, colliding_state, *acm_);
+    ASSERT_TRUE(res1.collision);
+
+    collision_detection::CollisionResult res2;
+    crobot_->checkSelfCollision(req, res2, default_state, *acm_);
+    ASSERT_FALSE(res2.collision);
+  }
+
+  // and agree with a check made with a newly generated one
+  collision_detection::GroupStateRepresentationPtr gsr;
+  collision_detection::CollisionResult res3;
+  crobot_->checkSelfCollision(req, res3, colliding_state, *acm_, gsr);
+  ASSERT_TRUE(res3.collision);
+}
+
 TEST_F(DistanceFieldCollisionDetectionTester, ContactReporting)
 {
   collision_detection::CollisionRequest req;
@@ -363,6 +399,77 @@ TEST_F(DistanceFieldCollisionDetectionTester, AttachedBodyTester)
   ASSERT_TRUE(res.collision);
 }
 
+TEST_F(DistanceFieldCollisionDetectionTester, WorldCollisionBatch)
+{
+  collision_detection::CollisionRequest req;
+  req.group_name = "right_arm";
+
+  acm_.reset(new collision_detection::AllowedCollisionMatrix(robot_model_->getLinkModelNames(), true));
+
+  robot_state::RobotState free_state(robot_model_);
+  free_state.setToDefaultValues();
+  free_state.update();
+
+  Eigen::Affine3d pos1 = Eigen::Affine3d::Identity();
+  pos1.translation().x() = 1.0;
+  robot_state::RobotState colliding_state(free_state);
+  colliding_state.updateStateWithLinkAt("r_gripper_palm_link", pos1);
+
+  cworld_->getWorld()->addToObject("box", shapes::ShapeConstPtr(new shapes::Box(.25, .25, .25)), pos1);
+
+  std::vector<const robot_state::RobotState*> states;
+  for (unsigned int i = 0; i < 4; i++)
+    states.push_back(i == 2 ? &colliding_state : &free_state);
+
+  // the representation generated for the first state is carried over to the others
+  std::vector<collision_detection::CollisionResult> res;
+  EXPECT_EQ(2u, cworld_->checkCollisionBatch(req, res, *crobot_, states, *acm_, false));
+  ASSERT_EQ(states.size(), res.size());
+  for (std::size_t i = 0; i < states.size(); i++)
+  {
+    collision_detection::CollisionResult single;
+    cworld_->checkCollision(req, single, *crobot_, *states[i], *acm_);
+    EXPECT_EQ(single.collision, res[i].collision);
+  }
+  EXPECT_TRUE(res[2].collision);
+  EXPECT_FALSE(res[3].collision);
+}
+
+TEST_F(DistanceFieldCollisionDetectionTester, SphereFilterMatchesFCL)
+{
+  collision_detection::CollisionRobotFCL fcl_robot(robot_model_);
+  collision_detection::CollisionRobotSphereFilter filtered_robot(robot_model_);
+
+  collision_detection::CollisionRequest req;
+  req.group_name = "whole_body";
+  req.contacts = true;
+  req.max_contacts = 100;
+
+  robot_state::RobotState kstate(robot_model_);
+  kstate.setToDefaultValues();
+  kstate.update();
+
+  collision_detection::CollisionResult fcl_res;
+  collision_detection::CollisionResult filtered_res;
+  fcl_robot.checkSelfCollision(req, fcl_res, kstate, *acm_);
+  filtered_robot.checkSelfCollision(req, filtered_res, kstate, *acm_);
+  ASSERT_EQ(fcl_res.collision, filtered_res.collision);
+
+  Eigen::Affine3d offset = Eigen::Affine3d::Identity();
+  offset.translation().x() = .01;
+  kstate.updateStateWithLinkAt("r_gripper_palm_link", Eigen::Affine3d::Identity());
+  kstate.updateStateWithLinkAt("l_gripper_palm_link", offset);
+  acm_->setEntry("r_gripper_palm_link", "l_gripper_palm_link", false);
+
+  fcl_res = collision_detection::CollisionResult();
+  filtered_res = collision_detection::CollisionResult();
+  fcl_robot.checkSelfCollision(req, fcl_res, kstate, *acm_);
+  filtered_robot.checkSelfCollision(req, filtered_res, kstate, *acm_);
+  ASSERT_TRUE(fcl_res.collision);
+  ASSERT_TRUE(filtered_res.collision);
+  EXPECT_EQ(fcl_res.contact_count, filtered_res.contact_count);
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
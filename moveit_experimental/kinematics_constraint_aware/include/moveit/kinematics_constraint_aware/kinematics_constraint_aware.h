@@ -43,7 +43,7 @@
 #include <boost/function.hpp>
 
 // ROS msgs
-#include <moveit_msgs/GetConstraintAwarePositionIK.h>
+#include <moveit_msgs/GetPositionIK.h>
 #include <geometry_msgs/PoseStamped.h>
 #include <moveit_msgs/MoveItErrorCodes.h>
 #include <moveit_msgs/Constraints.h>
@@ -67,6 +67,10 @@ typedef boost::shared_ptr<const KinematicsConstraintAware> KinematicsConstraintA
 
 /**
  * @class A kinematics solver that can be used with multiple arms
+ *
+ * For a group made of independent sub-groups (e.g. two arms), the IK solutions of the sub-groups are computed
+ * concurrently, one thread per sub-group. The solutions found are combined into a bounded number of candidate
+ * states for the whole group, which are checked for collisions and constraints in batches.
  */
 class KinematicsConstraintAware
 {
@@ -95,8 +99,7 @@ public:
    * @return False if group_name is invalid or ik fails
    */
   bool getIK(const planning_scene::PlanningSceneConstPtr& planning_scene,
-             const moveit_msgs::GetConstraintAwarePositionIK::Request& request,
-             moveit_msgs::GetConstraintAwarePositionIK::Response& response) const;
+             const moveit_msgs::GetPositionIK::Request& request, moveit_msgs::GetPositionIK::Response& response) const;
 
   const std::string& getGroupName() const
   {
@@ -108,6 +111,40 @@ public:
     return kinematic_model_;
   }
 
+  /** @brief Set the number of rounds of IK attempts (the default is 10). For a group with sub-groups, each round
+   * computes new solutions for every sub-group and checks the combinations they form with the earlier ones */
+  void setIKAttempts(unsigned int attempts)
+  {
+    ik_attempts_ = attempts;
+  }
+
+  unsigned int getIKAttempts() const
+  {
+    return ik_attempts_;
+  }
+
+  /** @brief Set how many IK solutions each sub-group computes per round (the default is 4) */
+  void setSolutionsPerRound(unsigned int count)
+  {
+    solutions_per_round_ = count;
+  }
+
+  unsigned int getSolutionsPerRound() const
+  {
+    return solutions_per_round_;
+  }
+
+  /** @brief Set the largest number of combined candidate states checked per round (the default is 64) */
+  void setMaxCandidatesPerRound(unsigned int count)
+  {
+    max_candidates_per_round_ = count;
+  }
+
+  unsigned int getMaxCandidatesPerRound() const
+  {
+    return max_candidates_per_round_;
+  }
+
 private:
   EigenSTL::vector_Affine3d transformPoses(const planning_scene::PlanningSceneConstPtr& planning_scene,
                                            const robot_state::RobotState& kinematic_state,
@@ -115,22 +152,37 @@ private:
                                            const std::string& target_frame) const;
 
   bool convertServiceRequest(const planning_scene::PlanningSceneConstPtr& planning_scene,
-                             const moveit_msgs::GetConstraintAwarePositionIK::Request& request,
+                             const moveit_msgs::GetPositionIK::Request& request,
                              kinematics_constraint_aware::KinematicsRequest& kinematics_request,
                              kinematics_constraint_aware::KinematicsResponse& kinematics_response) const;
 
-  geometry_msgs::Pose getTipFramePose(const planning_scene::PlanningSceneConstPtr& planning_scene,
-                                      const robot_state::RobotState& kinematic_state, const geometry_msgs::Pose& pose,
+  geometry_msgs::Pose getTipFramePose(const robot_state::RobotState& kinematic_state, const geometry_msgs::Pose& pose,
                                       const std::string& link_name, unsigned int sub_group_index) const;
 
   bool validityCallbackFn(const planning_scene::PlanningSceneConstPtr& planning_scene,
                           const kinematics_constraint_aware::KinematicsRequest& request,
                           kinematics_constraint_aware::KinematicsResponse& response,
-                          robot_state::JointStateGroup* joint_state_group,
-                          const std::vector<double>& joint_group_variable_values) const;
+                          robot_state::RobotState* kinematic_state, const robot_model::JointModelGroup* joint_group,
+                          const double* joint_group_variable_values) const;
+
+  /** @brief Solve IK for each sub-group concurrently and search the combinations of their solutions for one that is
+   * valid; the goals and tips are in the order of the sub-groups */
+  bool getSubgroupsIK(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                      const kinematics_constraint_aware::KinematicsRequest& request,
+                      kinematics_constraint_aware::KinematicsResponse& response,
+                      robot_state::RobotState& kinematic_state, const EigenSTL::vector_Affine3d& goals,
+                      const std::vector<std::string>& tips) const;
+
+  /** @brief Check a batch of candidate states; returns the index of the first valid one, or states.size() */
+  std::size_t checkCandidates(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                              const kinematics_constraint_aware::KinematicsRequest& request,
+                              kinematics_constraint_aware::KinematicsResponse& response,
+                              std::vector<robot_state::RobotState>& states) const;
 
   std::vector<std::string> sub_groups_names_;
 
+  std::vector<const robot_model::JointModelGroup*> sub_groups_;
+
   robot_model::RobotModelConstPtr kinematic_model_;
 
   const robot_model::JointModelGroup* joint_model_group_;
@@ -139,7 +191,14 @@ private:
 
   bool has_sub_groups_;
 
+  /** @brief True if some sub-groups share joints, so their solutions cannot be computed independently */
+  bool coupled_sub_groups_;
+
   unsigned int ik_attempts_;
+
+  unsigned int solutions_per_round_;
+
+  unsigned int max_candidates_per_round_;
 };
 }
 
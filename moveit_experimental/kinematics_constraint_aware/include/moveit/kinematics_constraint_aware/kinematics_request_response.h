@@ -48,7 +48,7 @@
 #include <moveit_msgs/MoveItErrorCodes.h>
 #include <moveit/robot_model/robot_model.h>
 #include <moveit/robot_state/robot_state.h>
-#include <moveit/robot_model/robot_model.h>
+#include <moveit/collision_detection/collision_common.h>
 #include <moveit/kinematic_constraints/kinematic_constraint.h>
 
 namespace kinematics_constraint_aware
@@ -59,7 +59,7 @@ namespace kinematics_constraint_aware
 class KinematicsRequest
 {
 public:
-  KinematicsRequest()
+  KinematicsRequest() : check_for_collisions_(true)
   {
   }
 
@@ -79,7 +79,8 @@ public:
 
   bool check_for_collisions_;
 
-  robot_state::StateValidityCallbackFn constraint_callback_;
+  /** \brief Called for every candidate solution that is collision free and satisfies the constraints */
+  robot_state::GroupStateValidityCallbackFn constraint_callback_;
 };
 
 /**
@@ -88,7 +89,7 @@ public:
 class KinematicsResponse
 {
 public:
-  KinematicsResponse()
+  KinematicsResponse() : result_(false)
   {
   }
 
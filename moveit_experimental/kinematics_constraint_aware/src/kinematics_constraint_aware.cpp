@@ -35,23 +35,75 @@
 * Author: Sachin Chitta
 *********************************************************************/
 
-// // ROS msgs
 #include <moveit/kinematics_constraint_aware/kinematics_constraint_aware.h>
 #include <moveit/robot_model/robot_model.h>
+#include <moveit/robot_state/conversions.h>
 #include <moveit/planning_scene/planning_scene.h>
-#include <Eigen/Geometry.h>
+#include <Eigen/Geometry>
 #include <eigen_conversions/eigen_msg.h>
 #include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#include <algorithm>
+#include <cmath>
 
 namespace kinematics_constraint_aware
 {
+namespace
+{
+// sub-group solutions closer than this in every variable are considered the same
+static const double SAME_SOLUTION_TOLERANCE = 1e-3;
+
+// the IK solutions of one sub-group, computed on a thread of its own with a private copy of the state
+struct SubgroupSolutions
+{
+  const robot_model::JointModelGroup* group;
+  const Eigen::Affine3d* goal;
+  std::string tip;
+  robot_state::RobotStatePtr state;
+  bool seeded;
+  std::vector<std::vector<double> > solutions;
+};
+
+void computeSubgroupSolutions(SubgroupSolutions* sub, unsigned int count, const ros::WallTime& deadline)
+{
+  std::vector<double> values;
+  for (unsigned int i = 0; i < count && ros::WallTime::now() < deadline; ++i)
+  {
+    // the first attempt starts from the seed state of the request, the later ones from random positions
+    if (sub->seeded)
+      sub->state->setToRandomPositions(sub->group);
+    sub->seeded = true;
+    if (!sub->state->setFromIK(sub->group, *sub->goal, sub->tip, 1, sub->group->getDefaultIKTimeout()))
+      continue;
+    sub->state->copyJointGroupPositions(sub->group, values);
+
+    // different seeds often lead to the same solution, which would only add combinations to check
+    bool known = false;
+    for (std::size_t j = 0; j < sub->solutions.size() && !known; ++j)
+    {
+      double difference = 0.0;
+      for (std::size_t k = 0; k < values.size(); ++k)
+        difference = std::max(difference, std::fabs(values[k] - sub->solutions[j][k]));
+      known = difference < SAME_SOLUTION_TOLERANCE;
+    }
+    if (!known)
+      sub->solutions.push_back(values);
+  }
+}
+}
+
 KinematicsConstraintAware::KinematicsConstraintAware(const robot_model::RobotModelConstPtr& kinematic_model,
                                                      const std::string& group_name)
+  : joint_model_group_(NULL)
+  , has_sub_groups_(false)
+  , coupled_sub_groups_(false)
+  , ik_attempts_(10)
+  , solutions_per_round_(4)
+  , max_candidates_per_round_(64)
 {
   if (!kinematic_model->hasJointModelGroup(group_name))
   {
     logError("The group %s does not exist", group_name.c_str());
-    joint_model_group_ = NULL;
     return;
   }
   kinematic_model_ = kinematic_model;
@@ -59,43 +111,42 @@ KinematicsConstraintAware::KinematicsConstraintAware(const robot_model::RobotMod
   joint_model_group_ = kinematic_model_->getJointModelGroup(group_name);
   if (joint_model_group_->getSolverInstance())
   {
-    has_sub_groups_ = false;
     sub_groups_names_.push_back(group_name_);
+    sub_groups_.push_back(joint_model_group_);
+    return;
   }
-  else
+
+  logDebug("No kinematics solver instance defined for group %s", group_name.c_str());
+  const std::vector<std::string>& sub_groups_names = joint_model_group_->getSubgroupNames();
+  if (sub_groups_names.empty())
   {
-    logDebug("No kinematics solver instance defined for group %s", group_name.c_str());
-    bool is_solvable_group = true;
-    if (!(joint_model_group_->getSubgroupNames().empty()))
-    {
-      const std::vector<std::string> sub_groups_names = joint_model_group_->getSubgroupNames();
-      for (std::size_t i = 0; i < sub_groups_names.size(); ++i)
-      {
-        if (!kinematic_model_->getJointModelGroup(sub_groups_names[i])->getSolverInstance())
-        {
-          is_solvable_group = false;
-          break;
-        }
-      }
-      if (is_solvable_group)
-      {
-        logDebug("Group %s is a group for which we can solve IK", joint_model_group_->getName().c_str());
-        sub_groups_names_ = sub_groups_names;
-      }
-      else
-      {
-        joint_model_group_ = NULL;
-        return;
-      }
-    }
-    else
+    joint_model_group_ = NULL;
+    logInform("No solver allocated for group %s", group_name.c_str());
+    return;
+  }
+  for (std::size_t i = 0; i < sub_groups_names.size(); ++i)
+  {
+    const robot_model::JointModelGroup* sub_group = kinematic_model_->getJointModelGroup(sub_groups_names[i]);
+    if (!sub_group->getSolverInstance())
     {
       joint_model_group_ = NULL;
-      logInform("No solver allocated for group %s", group_name.c_str());
+      sub_groups_.clear();
+      return;
     }
-    has_sub_groups_ = true;
+    sub_groups_.push_back(sub_group);
+  }
+  logDebug("Group %s is a group for which we can solve IK", joint_model_group_->getName().c_str());
+  sub_groups_names_ = sub_groups_names;
+  has_sub_groups_ = true;
+
+  // sub-groups that share joints cannot be solved independently of each other
+  for (std::size_t i = 0; i < sub_groups_.size() && !coupled_sub_groups_; ++i)
+  {
+    const std::vector<const robot_model::JointModel*>& joints = sub_groups_[i]->getActiveJointModels();
+    for (std::size_t j = i + 1; j < sub_groups_.size() && !coupled_sub_groups_; ++j)
+      for (std::size_t k = 0; k < joints.size() && !coupled_sub_groups_; ++k)
+        coupled_sub_groups_ = sub_groups_[j]->hasJointModel(joints[k]->getName());
   }
-  ik_attempts_ = 10;
 }
 
 bool KinematicsConstraintAware::getIK(const planning_scene::PlanningSceneConstPtr& planning_scene,
@@ -119,70 +170,80 @@ bool KinematicsConstraintAware::getIK(const planning_scene::PlanningSceneConstPt
     response.solution_.reset(new robot_state::RobotState(planning_scene->getCurrentState()));
   }
 
-  ros::WallTime start_time = ros::WallTime::now();
   if (request.group_name_ != group_name_)
   {
     response.error_code_.val = response.error_code_.INVALID_GROUP_NAME;
     return false;
   }
 
+  if (request.pose_stamped_vector_.size() != sub_groups_.size() ||
+      (!request.ik_link_names_.empty() && request.ik_link_names_.size() != sub_groups_.size()))
+  {
+    logError("Number of poses (%u) and of ik_link_names (%u) in request must match number of sub groups %u in this "
+             "group",
+             (unsigned int)request.pose_stamped_vector_.size(), (unsigned int)request.ik_link_names_.size(),
+             (unsigned int)sub_groups_.size());
+    response.error_code_.val = response.error_code_.INVALID_GROUP_NAME;
+    return false;
+  }
+
   // Setup the seed and the values for all other joints in the robot
   robot_state::RobotState kinematic_state = *request.robot_state_;
-  std::vector<std::string> ik_link_names = request.ik_link_names_;
+  kinematic_state.update();
+  std::vector<std::string> ik_link_names(sub_groups_.size());
+  std::vector<geometry_msgs::PoseStamped> poses = request.pose_stamped_vector_;
 
   // Transform request to tip frame if necessary
-  if (!request.ik_link_names_.empty())
+  for (std::size_t i = 0; i < sub_groups_.size(); ++i)
   {
-    for (std::size_t i = 0; i < request.pose_stamped_vector_.size(); ++i)
+    const std::string& tip_frame = sub_groups_[i]->getSolverInstance()->getTipFrame();
+    if (request.ik_link_names_.empty())
+      ik_link_names[i] = tip_frame;
+    // The assumption is that this new link is rigidly attached to the tip link for the group
+    else if (!sub_groups_[i]->hasLinkModel(request.ik_link_names_[i]) &&
+             sub_groups_[i]->isLinkUpdated(request.ik_link_names_[i]))
     {
-      geometry_msgs::PoseStamped tmp_pose = request.pose_stamped_vector_[i];
-      // The assumption is that this new link is rigidly attached to the tip link for the group
-      if (!kinematic_model_->getJointModelGroup(sub_groups_names_[i])->hasLinkModel(request.ik_link_names_[i]) &&
-          kinematic_model_->getJointModelGroup(sub_groups_names_[i])->isLinkUpdated(request.ik_link_names_[i]))
-      {
-        tmp_pose.pose = getTipFramePose(planning_scene, kinematic_state, request.pose_stamped_vector_[i].pose,
-                                        request.ik_link_names_[i], i);
-        ik_link_names[i] =
-            kinematic_model_->getJointModelGroup(sub_groups_names_[i])->getSolverInstance()->getTipFrame();
-      }
-      else if (!kinematic_model_->getJointModelGroup(sub_groups_names_[i])
-                    ->canSetStateFromIK(request.ik_link_names_[i]))
-      {
-        logError("Could not find IK solver for link %s for group %s", request.ik_link_names_[i].c_str(),
-                 sub_groups_names_[i].c_str());
-        return false;
-      }
+      poses[i].pose = getTipFramePose(kinematic_state, poses[i].pose, request.ik_link_names_[i], i);
+      ik_link_names[i] = tip_frame;
+    }
+    else if (sub_groups_[i]->canSetStateFromIK(request.ik_link_names_[i]))
+      ik_link_names[i] = request.ik_link_names_[i];
+    else
+    {
+      logError("Could not find IK solver for link %s for group %s", request.ik_link_names_[i].c_str(),
+               sub_groups_names_[i].c_str());
+      return false;
     }
   }
 
   // Transform the requests to the base frame of the kinematic model
   EigenSTL::vector_Affine3d goals =
-      transformPoses(planning_scene, kinematic_state, request.pose_stamped_vector_, kinematic_model_->getModelFrame());
-
-  robot_state::StateValidityCallbackFn constraint_callback_fn =
-      boost::bind(&KinematicsConstraintAware::validityCallbackFn, this, planning_scene, request, response, _1, _2);
+      transformPoses(planning_scene, kinematic_state, poses, kinematic_model_->getModelFrame());
 
   bool result = false;
-  if (has_sub_groups_)
-  {
-    result = kinematic_state.getJointStateGroup(group_name_)
-                 ->setFromIK(goals, ik_link_names, ik_attempts_, request.timeout_.toSec(), constraint_callback_fn);
-  }
+  if (has_sub_groups_ && !coupled_sub_groups_)
+    result = getSubgroupsIK(planning_scene, request, response, kinematic_state, goals, ik_link_names);
   else
   {
-    result =
-        ik_link_names.empty() ?
-            kinematic_state.getJointStateGroup(group_name_)
-                ->setFromIK(goals[0], ik_attempts_, request.timeout_.toSec(), constraint_callback_fn) :
-            kinematic_state.getJointStateGroup(group_name_)
-                ->setFromIK(goals[0], ik_link_names[0], ik_attempts_, request.timeout_.toSec(), constraint_callback_fn);
+    robot_state::GroupStateValidityCallbackFn constraint_callback_fn =
+        boost::bind(&KinematicsConstraintAware::validityCallbackFn, this, planning_scene, boost::cref(request),
+                    boost::ref(response), _1, _2, _3);
+    result = has_sub_groups_ ? kinematic_state.setFromIK(joint_model_group_, goals, ik_link_names, ik_attempts_,
+                                                         request.timeout_.toSec(), constraint_callback_fn) :
+                               kinematic_state.setFromIK(joint_model_group_, goals[0], ik_link_names[0], ik_attempts_,
+                                                         request.timeout_.toSec(), constraint_callback_fn);
   }
 
   if (result)
   {
     std::vector<double> solution_values;
-    kinematic_state.getJointStateGroup(group_name_)->getVariableValues(solution_values);
-    response.solution_->getJointStateGroup(group_name_)->setVariableValues(solution_values);
+    kinematic_state.copyJointGroupPositions(joint_model_group_, solution_values);
+    response.solution_->setJointGroupPositions(joint_model_group_, solution_values);
+    if (request.constraints_)
+    {
+      kinematic_state.update();
+      request.constraints_->decide(kinematic_state, response.constraint_eval_results_);
+    }
     response.error_code_.val = response.error_code_.SUCCESS;
   }
 
@@ -190,16 +251,182 @@ bool KinematicsConstraintAware::getIK(const planning_scene::PlanningSceneConstPt
   {
     response.error_code_.val = response.error_code_.NO_IK_SOLUTION;
   }
+  response.result_ = result;
   return result;
 }
 
+bool KinematicsConstraintAware::getSubgroupsIK(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                                               const kinematics_constraint_aware::KinematicsRequest& request,
+                                               kinematics_constraint_aware::KinematicsResponse& response,
+                                               robot_state::RobotState& kinematic_state,
+                                               const EigenSTL::vector_Affine3d& goals,
+                                               const std::vector<std::string>& tips) const
+{
+  // without a timeout, the rounds are only bounded by the time the IK calls take
+  double timeout = request.timeout_.toSec();
+  if (timeout <= 0.0)
+    for (std::size_t sg = 0; sg < sub_groups_.size(); ++sg)
+      timeout = std::max(timeout, ik_attempts_ * solutions_per_round_ * sub_groups_[sg]->getDefaultIKTimeout());
+  ros::WallTime deadline = ros::WallTime::now() + ros::WallDuration(timeout);
+
+  std::vector<SubgroupSolutions> subs(sub_groups_.size());
+  for (std::size_t sg = 0; sg < subs.size(); ++sg)
+  {
+    subs[sg].group = sub_groups_[sg];
+    subs[sg].goal = &goals[sg];
+    subs[sg].tip = tips[sg];
+    subs[sg].state.reset(new robot_state::RobotState(kinematic_state));
+    subs[sg].seeded = false;
+  }
+
+  // the number of solutions of each sub-group that were available for combining in the earlier rounds
+  std::vector<std::size_t> combined(subs.size(), 0);
+  std::vector<std::size_t> index(subs.size());
+  std::vector<robot_state::RobotState> candidates;
+  candidates.reserve(max_candidates_per_round_);
+  for (unsigned int round = 0; round < ik_attempts_ && ros::WallTime::now() < deadline; ++round)
+  {
+    logDebug("IK round: %u of %u", round, ik_attempts_);
+
+    // this thread computes the solutions of the first sub-group while the other threads compute the rest
+    boost::thread_group threads;
+    for (std::size_t sg = 1; sg < subs.size(); ++sg)
+      threads.create_thread(boost::bind(&computeSubgroupSolutions, &subs[sg], solutions_per_round_, deadline));
+    computeSubgroupSolutions(&subs[0], solutions_per_round_, deadline);
+    threads.join_all();
+
+    bool complete = true;
+    for (std::size_t sg = 0; sg < subs.size(); ++sg)
+      complete &= !subs[sg].solutions.empty();
+    if (!complete)
+    {
+      response.error_code_.val = response.error_code_.NO_IK_SOLUTION;
+      continue;
+    }
+
+    // queue the combinations with at least one solution new in this round, up to the bound on the candidates
+    candidates.clear();
+    std::fill(index.begin(), index.end(), 0);
+    bool done = false;
+    while (!done && candidates.size() < max_candidates_per_round_)
+    {
+      bool is_new = false;
+      for (std::size_t sg = 0; sg < subs.size(); ++sg)
+        is_new |= index[sg] >= combined[sg];
+      if (is_new)
+      {
+        candidates.push_back(kinematic_state);
+        for (std::size_t sg = 0; sg < subs.size(); ++sg)
+          candidates.back().setJointGroupPositions(subs[sg].group, subs[sg].solutions[index[sg]]);
+        candidates.back().update();
+      }
+
+      done = true;
+      for (std::size_t sg = 0; sg < subs.size(); ++sg)
+      {
+        if (++index[sg] < subs[sg].solutions.size())
+        {
+          done = false;
+          break;
+        }
+        index[sg] = 0;
+      }
+    }
+    for (std::size_t sg = 0; sg < subs.size(); ++sg)
+      combined[sg] = subs[sg].solutions.size();
+
+    std::size_t valid = checkCandidates(planning_scene, request, response, candidates);
+    if (valid < candidates.size())
+    {
+      logDebug("Found IK solution");
+      kinematic_state = candidates[valid];
+      return true;
+    }
+  }
+  return false;
+}
+
+std::size_t KinematicsConstraintAware::checkCandidates(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                                                       const kinematics_constraint_aware::KinematicsRequest& request,
+                                                       kinematics_constraint_aware::KinematicsResponse& response,
+                                                       std::vector<robot_state::RobotState>& states) const
+{
+  // the indices of the states not found invalid so far, in order
+  std::vector<std::size_t> valid(states.size());
+  for (std::size_t i = 0; i < valid.size(); ++i)
+    valid[i] = i;
+  std::vector<const robot_state::RobotState*> batch;
+
+  // Now check for collisions
+  if (request.check_for_collisions_ && !valid.empty())
+  {
+    collision_detection::CollisionRequest collision_request;
+    std::vector<collision_detection::CollisionResult> collision_results;
+    collision_request.group_name = request.group_name_;
+    for (std::size_t i = 0; i < valid.size(); ++i)
+      batch.push_back(&states[valid[i]]);
+    planning_scene->checkCollisionBatch(collision_request, collision_results, batch, 0, false);
+
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < valid.size(); ++i)
+      if (!collision_results[i].collision)
+        valid[count++] = valid[i];
+    if (count < valid.size())
+    {
+      logDebug("%u IK solutions are in collision", (unsigned int)(valid.size() - count));
+      response.error_code_.val = response.error_code_.GOAL_IN_COLLISION;
+    }
+    valid.resize(count);
+  }
+
+  // Now check for constraints
+  if (request.constraints_ && !valid.empty())
+  {
+    std::vector<kinematic_constraints::ConstraintEvaluationResult> constraint_results(valid.size());
+    batch.clear();
+    for (std::size_t i = 0; i < valid.size(); ++i)
+      batch.push_back(&states[valid[i]]);
+    request.constraints_->decideBatch(&batch[0], batch.size(), &constraint_results[0]);
+
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < valid.size(); ++i)
+      if (constraint_results[i].satisfied)
+        valid[count++] = valid[i];
+    if (count < valid.size())
+    {
+      logDebug("%u IK solutions violate constraints", (unsigned int)(valid.size() - count));
+      response.error_code_.val = response.error_code_.GOAL_VIOLATES_PATH_CONSTRAINTS;
+    }
+    valid.resize(count);
+  }
+
+  // Now check for user specified constraints, one state at a time since the callback may modify the state
+  if (request.constraint_callback_)
+  {
+    std::vector<double> values;
+    for (std::size_t i = 0; i < valid.size(); ++i)
+    {
+      states[valid[i]].copyJointGroupPositions(joint_model_group_, values);
+      if (request.constraint_callback_(&states[valid[i]], joint_model_group_, &values[0]))
+        return valid[i];
+      logDebug("IK solution violates user specified constraints");
+      response.error_code_.val = response.error_code_.GOAL_VIOLATES_PATH_CONSTRAINTS;
+    }
+    return states.size();
+  }
+
+  return valid.empty() ? states.size() : valid[0];
+}
+
 bool KinematicsConstraintAware::validityCallbackFn(const planning_scene::PlanningSceneConstPtr& planning_scene,
                                                    const kinematics_constraint_aware::KinematicsRequest& request,
                                                    kinematics_constraint_aware::KinematicsResponse& response,
-                                                   robot_state::JointStateGroup* joint_state_group,
-                                                   const std::vector<double>& joint_group_variable_values) const
+                                                   robot_state::RobotState* kinematic_state,
+                                                   const robot_model::JointModelGroup* joint_group,
+                                                   const double* joint_group_variable_values) const
 {
-  joint_state_group->setVariableValues(joint_group_variable_values);
+  kinematic_state->setJointGroupPositions(joint_group, joint_group_variable_values);
+  kinematic_state->update();
 
   // Now check for collisions
   if (request.check_for_collisions_)
@@ -207,7 +434,7 @@ bool KinematicsConstraintAware::validityCallbackFn(const planning_scene::Plannin
     collision_detection::CollisionRequest collision_request;
     collision_detection::CollisionResult collision_result;
     collision_request.group_name = request.group_name_;
-    planning_scene->checkCollision(collision_request, collision_result, *joint_state_group->getRobotState());
+    planning_scene->checkCollision(collision_request, collision_result, *kinematic_state);
     if (collision_result.collision)
     {
       logDebug("IK solution is in collision");
@@ -219,10 +446,7 @@ bool KinematicsConstraintAware::validityCallbackFn(const planning_scene::Plannin
   // Now check for constraints
   if (request.constraints_)
   {
-    kinematic_constraints::ConstraintEvaluationResult constraint_result;
-    constraint_result =
-        request.constraints_->decide(*joint_state_group->getRobotState(), response.constraint_eval_results_);
-    if (!constraint_result.satisfied)
+    if (!request.constraints_->decide(*kinematic_state).satisfied)
     {
       logDebug("IK solution violates constraints");
       response.error_code_.val = response.error_code_.GOAL_VIOLATES_PATH_CONSTRAINTS;
@@ -233,7 +457,7 @@ bool KinematicsConstraintAware::validityCallbackFn(const planning_scene::Plannin
   // Now check for user specified constraints
   if (request.constraint_callback_)
   {
-    if (!request.constraint_callback_(joint_state_group, joint_group_variable_values))
+    if (!request.constraint_callback_(kinematic_state, joint_group, joint_group_variable_values))
     {
       logDebug("IK solution violates user specified constraints");
       response.error_code_.val = response.error_code_.GOAL_VIOLATES_PATH_CONSTRAINTS;
@@ -245,8 +469,8 @@ bool KinematicsConstraintAware::validityCallbackFn(const planning_scene::Plannin
 }
 
 bool KinematicsConstraintAware::getIK(const planning_scene::PlanningSceneConstPtr& planning_scene,
-                                      const moveit_msgs::GetConstraintAwarePositionIK::Request& request,
-                                      moveit_msgs::GetConstraintAwarePositionIK::Response& response) const
+                                      const moveit_msgs::GetPositionIK::Request& request,
+                                      moveit_msgs::GetPositionIK::Response& response) const
 {
   if (!joint_model_group_)
   {
@@ -271,13 +495,12 @@ bool KinematicsConstraintAware::getIK(const planning_scene::PlanningSceneConstPt
 
   bool result = getIK(planning_scene, kinematics_request, kinematics_response);
   response.error_code = kinematics_response.error_code_;
-  kinematics_response.solution_->getStateValues(response.solution.joint_state);
+  robot_state::robotStateToRobotStateMsg(*kinematics_response.solution_, response.solution);
   return result;
 }
 
 bool KinematicsConstraintAware::convertServiceRequest(
-    const planning_scene::PlanningSceneConstPtr& planning_scene,
-    const moveit_msgs::GetConstraintAwarePositionIK::Request& request,
+    const planning_scene::PlanningSceneConstPtr& planning_scene, const moveit_msgs::GetPositionIK::Request& request,
     kinematics_constraint_aware::KinematicsRequest& kinematics_request,
     kinematics_constraint_aware::KinematicsResponse& kinematics_response) const
 {
@@ -291,16 +514,16 @@ bool KinematicsConstraintAware::convertServiceRequest(
   if (!request.ik_request.pose_stamped_vector.empty() &&
       request.ik_request.pose_stamped_vector.size() != sub_groups_names_.size())
   {
-    logError("Number of poses in request: %d must match number of sub groups %d in this group",
-             request.ik_request.pose_stamped_vector.size(), sub_groups_names_.size());
+    logError("Number of poses in request: %u must match number of sub groups %u in this group",
+             (unsigned int)request.ik_request.pose_stamped_vector.size(), (unsigned int)sub_groups_names_.size());
     kinematics_response.error_code_.val = kinematics_response.error_code_.INVALID_GROUP_NAME;
     return false;
   }
 
   if (!request.ik_request.ik_link_names.empty() && request.ik_request.ik_link_names.size() != sub_groups_names_.size())
   {
-    logError("Number of ik_link_names in request: %d must match number of sub groups %d in this group or must be zero",
-             request.ik_request.ik_link_names.size(), sub_groups_names_.size());
+    logError("Number of ik_link_names in request: %u must match number of sub groups %u in this group or must be zero",
+             (unsigned int)request.ik_request.ik_link_names.size(), (unsigned int)sub_groups_names_.size());
     kinematics_response.error_code_.val = kinematics_response.error_code_.INVALID_GROUP_NAME;
     return false;
   }
@@ -316,15 +539,15 @@ bool KinematicsConstraintAware::convertServiceRequest(
     kinematics_request.pose_stamped_vector_ = request.ik_request.pose_stamped_vector;
 
   kinematics_request.robot_state_.reset(new robot_state::RobotState(planning_scene->getCurrentState()));
-  kinematics_request.robot_state_->setStateValues(request.ik_request.robot_state.joint_state);
-  kinematics_request.constraints_.reset(
-      new kinematic_constraints::KinematicConstraintSet(kinematic_model_, planning_scene->getTransforms()));
-  kinematics_request.constraints_->add(request.constraints);
+  robot_state::robotStateMsgToRobotState(planning_scene->getTransforms(), request.ik_request.robot_state,
+                                         *kinematics_request.robot_state_);
+  kinematics_request.constraints_.reset(new kinematic_constraints::KinematicConstraintSet(kinematic_model_));
+  kinematics_request.constraints_->add(request.ik_request.constraints, planning_scene->getTransforms());
   kinematics_request.timeout_ = request.ik_request.timeout;
   kinematics_request.group_name_ = request.ik_request.group_name;
-  kinematics_request.check_for_collisions_ = true;
+  kinematics_request.check_for_collisions_ = request.ik_request.avoid_collisions;
 
-  kinematics_response.solution_.reset(new robot_state::RobotState(planning_scene->getCurrentState()));
+  kinematics_response.solution_.reset(new robot_state::RobotState(*kinematics_request.robot_state_));
 
   return true;
 }
@@ -333,35 +556,31 @@ EigenSTL::vector_Affine3d KinematicsConstraintAware::transformPoses(
     const planning_scene::PlanningSceneConstPtr& planning_scene, const robot_state::RobotState& kinematic_state,
     const std::vector<geometry_msgs::PoseStamped>& poses, const std::string& target_frame) const
 {
-  Eigen::Affine3d eigen_pose, eigen_pose_2;
+  Eigen::Affine3d eigen_pose;
   EigenSTL::vector_Affine3d result(poses.size());
   bool target_frame_is_root_frame = (target_frame == kinematic_state.getRobotModel()->getModelFrame());
   for (std::size_t i = 0; i < poses.size(); ++i)
   {
-    geometry_msgs::Pose pose = poses[i].pose;
-    tf::poseMsgToEigen(pose, eigen_pose_2);
-    planning_scene->getTransforms()->transformPose(kinematic_state, poses[i].header.frame_id, eigen_pose_2, eigen_pose);
+    tf::poseMsgToEigen(poses[i].pose, eigen_pose);
+    eigen_pose = planning_scene->getFrameTransform(kinematic_state, poses[i].header.frame_id) * eigen_pose;
     if (!target_frame_is_root_frame)
-    {
-      eigen_pose_2 = planning_scene->getTransforms()->getTransform(kinematic_state, target_frame);
-      eigen_pose = eigen_pose_2.inverse() * eigen_pose;
-    }
+      eigen_pose = planning_scene->getFrameTransform(kinematic_state, target_frame).inverse() * eigen_pose;
     result[i] = eigen_pose;
   }
   return result;
 }
 
-geometry_msgs::Pose KinematicsConstraintAware::getTipFramePose(
-    const planning_scene::PlanningSceneConstPtr& planning_scene, const robot_state::RobotState& kinematic_state,
-    const geometry_msgs::Pose& pose, const std::string& link_name, unsigned int sub_group_index) const
+geometry_msgs::Pose KinematicsConstraintAware::getTipFramePose(const robot_state::RobotState& kinematic_state,
+                                                               const geometry_msgs::Pose& pose,
+                                                               const std::string& link_name,
+                                                               unsigned int sub_group_index) const
 {
   geometry_msgs::Pose result;
-  Eigen::Affine3d eigen_pose_in, eigen_pose_link, eigen_pose_tip;
-  std::string tip_name =
-      kinematic_model_->getJointModelGroup(sub_groups_names_[sub_group_index])->getSolverInstance()->getTipFrame();
+  Eigen::Affine3d eigen_pose_in;
+  const std::string& tip_name = sub_groups_[sub_group_index]->getSolverInstance()->getTipFrame();
   tf::poseMsgToEigen(pose, eigen_pose_in);
-  eigen_pose_link = planning_scene->getTransforms()->getTransform(kinematic_state, link_name);
-  eigen_pose_tip = planning_scene->getTransforms()->getTransform(kinematic_state, tip_name);
+  const Eigen::Affine3d& eigen_pose_link = kinematic_state.getGlobalLinkTransform(link_name);
+  const Eigen::Affine3d& eigen_pose_tip = kinematic_state.getGlobalLinkTransform(tip_name);
   eigen_pose_in = eigen_pose_in * (eigen_pose_link.inverse() * eigen_pose_tip);
   tf::poseEigenToMsg(eigen_pose_in, result);
   return result;
@@ -0,0 +1,139 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_CACHED_IK_KINEMATICS_PLUGIN_CACHED_IK_KINEMATICS_PLUGIN_
+#define MOVEIT_CACHED_IK_KINEMATICS_PLUGIN_CACHED_IK_KINEMATICS_PLUGIN_
+
+#include <moveit/kinematics_base/kinematics_base.h>
+#include <moveit/cached_ik_kinematics_plugin/ik_cache.h>
+#include <pluginlib/class_loader.h>
+#include <boost/thread/mutex.hpp>
+#include <memory>
+
+namespace cached_ik_kinematics_plugin
+{
+/**
+ * @brief A kinematics plugin that wraps another one and seeds its searches with solutions found earlier for nearby
+ * poses.
+ *
+ * The wrapped solver is named by the private parameter \<group\>/cached_ik/solver. Successful solutions are added to
+ * a persistent IKCache. It is read from the file \<group\>/cached_ik/cache_file (by default
+ * $ROS_HOME/ik_cache_\<group\>.bin) and written back every \<group\>/cached_ik/save_period new solutions, when
+ * saveCache() is called and when the plugin is destroyed.
+ */
+class CachedIKKinematicsPlugin : public kinematics::KinematicsBase
+{
+public:
+  CachedIKKinematicsPlugin();
+  virtual ~CachedIKKinematicsPlugin();
+
+  virtual bool
+  getPositionIK(const geometry_msgs::Pose& ik_pose, const std::vector<double>& ik_seed_state,
+                std::vector<double>& solution, moveit_msgs::MoveItErrorCodes& error_code,
+                const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions()) const;
+
+  virtual bool
+  searchPositionIK(const geometry_msgs::Pose& ik_pose, const std::vector<double>& ik_seed_state, double timeout,
+                   std::vector<double>& solution, moveit_msgs::MoveItErrorCodes& error_code,
+                   const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions()) const;
+
+  virtual bool
+  searchPositionIK(const geometry_msgs::Pose& ik_pose, const std::vector<double>& ik_seed_state, double timeout,
+                   const std::vector<double>& consistency_limits, std::vector<double>& solution,
+                   moveit_msgs::MoveItErrorCodes& error_code,
+                   const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions()) const;
+
+  virtual bool searchPositionIK(
+      const geometry_msgs::Pose& ik_pose, const std::vector<double>& ik_seed_state, double timeout,
+      std::vector<double>& solution, const IKCallbackFn& solution_callback, moveit_msgs::MoveItErrorCodes& error_code,
+      const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions()) const;
+
+  /**
+   * @brief Search for a solution starting from the solutions cached for the poses nearest to \e ik_pose, then from
+   * \e ik_seed_state, spreading \e timeout over the attempts. Consistency limits are relative to \e ik_seed_state,
+   * so when they are given the cache is not used for seeding.
+   */
+  virtual bool
+  searchPositionIK(const geometry_msgs::Pose& ik_pose, const std::vector<double>& ik_seed_state, double timeout,
+                   const std::vector<double>& consistency_limits, std::vector<double>& solution,
+                   const IKCallbackFn& solution_callback, moveit_msgs::MoveItErrorCodes& error_code,
+                   const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions()) const;
+
+  virtual bool getPositionFK(const std::vector<std::string>& link_names, const std::vector<double>& joint_angles,
+                             std::vector<geometry_msgs::Pose>& poses) const;
+
+  virtual bool initialize(const std::string& robot_description, const std::string& group_name,
+                          const std::string& base_name, const std::string& tip_name, double search_discretization);
+
+  virtual bool setRedundantJoints(const std::vector<unsigned int>& redundant_joint_indices);
+
+  virtual bool supportsGroup(const moveit::core::JointModelGroup* jmg, std::string* error_text_out = NULL) const;
+
+  virtual void setDefaultTimeout(double timeout);
+
+  virtual void setSearchThreadCount(unsigned int thread_count);
+
+  virtual const std::vector<std::string>& getJointNames() const;
+
+  virtual const std::vector<std::string>& getLinkNames() const;
+
+  /** @brief Write the cache to its file now, if solutions were added since it was read or last written */
+  bool saveCache() const;
+
+  /** @brief Get the number of solutions in the cache */
+  std::size_t getCacheSize() const;
+
+private:
+  /** @brief Add \e solution to the cache, saving it every save_period_ additions */
+  void addToCache(const geometry_msgs::Pose& ik_pose, const std::vector<double>& solution) const;
+
+  // declared first so that it is destroyed after the solver it loaded
+  std::shared_ptr<pluginlib::ClassLoader<kinematics::KinematicsBase> > solver_loader_;
+  kinematics::KinematicsBasePtr solver_;
+  std::vector<std::string> joint_names_;
+  std::vector<std::string> link_names_;
+
+  mutable boost::mutex cache_lock_;
+  mutable std::shared_ptr<IKCache> cache_;
+  mutable unsigned int additions_since_save_;
+  std::string cache_file_;
+  uint64_t cache_fingerprint_;
+
+  unsigned int seed_count_;
+  double min_pose_distance_;
+  unsigned int save_period_;
+};
+}
+
+#endif
@@ -0,0 +1,135 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_CACHED_IK_KINEMATICS_PLUGIN_IK_CACHE_
+#define MOVEIT_CACHED_IK_KINEMATICS_PLUGIN_IK_CACHE_
+
+#include <geometry_msgs/Pose.h>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/noncopyable.hpp>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace cached_ik_kinematics_plugin
+{
+/** @brief A cache of IK solutions indexed by the poses they reach, for seeding the search for poses that are
+ *  solved over and over again.
+ *
+ *  Lookups find the solutions whose poses are nearest to a query pose in a KD-tree. Poses are compared as points
+ *  (x, y, z, w * qx, w * qy, w * qz, w * qw), where w is the orientation weight and the quaternion is taken with
+ *  either sign. The tree is stored in a file in its search order, so loading the file only maps it into memory;
+ *  solutions added afterwards are kept aside and merged into the tree once there are enough of them.
+ *
+ *  This class is not thread-safe. */
+class IKCache : private boost::noncopyable
+{
+public:
+  /** @brief Construct an empty cache for solutions with \e dimension joint values. Insertions beyond \e max_size
+   *  solutions are ignored. */
+  IKCache(unsigned int dimension, double orientation_weight, std::size_t max_size);
+
+  /** @brief Replace the content of the cache with that of \e filename. This fails (and leaves the cache empty) if
+   *  the file does not exist or was written for different solutions, as told by \e fingerprint. */
+  bool load(const std::string& filename, uint64_t fingerprint);
+
+  /** @brief Write the content of the cache to \e filename, tagged with \e fingerprint. The file is replaced
+   *  atomically, so concurrent readers see either the old or the new content. */
+  bool save(const std::string& filename, uint64_t fingerprint);
+
+  /** @brief Get the solutions of (up to) the \e count poses nearest to \e pose, closest first. If \e distances is
+   *  not NULL, it is filled with the distances to these poses. */
+  void getNearestSolutions(const geometry_msgs::Pose& pose, std::size_t count,
+                           std::vector<std::vector<double> >& solutions, std::vector<double>* distances = NULL) const;
+
+  /** @brief Add a solution for \e pose, unless the cache is full or already holds a pose within \e min_distance.
+   *  @return True if the solution was added */
+  bool addSolution(const geometry_msgs::Pose& pose, const std::vector<double>& solution, double min_distance);
+
+  /** @brief The number of solutions in the cache */
+  std::size_t size() const
+  {
+    return tree_size_ + pending_size_;
+  }
+
+  /** @brief Check whether solutions were added since the cache was last loaded or saved */
+  bool isModified() const
+  {
+    return modified_;
+  }
+
+  /** @brief Compute a fingerprint of \e description for load() and save(), stable across builds and hosts */
+  static uint64_t computeFingerprint(const std::string& description);
+
+private:
+  struct Neighbors;
+
+  /** @brief Fill the first POINT_SIZE values of \e point from \e pose; if \e flip, the quaternion is negated */
+  void poseToPoint(const geometry_msgs::Pose& pose, bool flip, double* point) const;
+
+  /** @brief Search the subtree of the records [begin, end) of tree_, split along coordinate \e axis */
+  void searchTree(std::size_t begin, std::size_t end, unsigned int axis, const double* point,
+                  Neighbors& neighbors) const;
+
+  /** @brief Search the solutions that are not in the tree yet */
+  void searchPending(const double* point, Neighbors& neighbors) const;
+
+  /** @brief Write the records \e records into \e out (starting at record \e begin) in search order */
+  void buildTree(std::vector<const double*>& records, std::size_t begin, std::size_t end, unsigned int axis,
+                 double* out) const;
+
+  /** @brief Merge the pending solutions into the tree, which then lives in tree_storage_ */
+  void rebuildTree();
+
+  unsigned int dimension_;
+  std::size_t record_size_;
+  double orientation_weight_;
+  std::size_t max_size_;
+
+  /** @brief The records of the KD-tree, in a mapped file or in tree_storage_ */
+  const double* tree_;
+  std::size_t tree_size_;
+  std::vector<double> tree_storage_;
+  boost::interprocess::mapped_region region_;
+
+  /** @brief The records added since the tree was built */
+  std::vector<double> pending_;
+  std::size_t pending_size_;
+
+  bool modified_;
+};
+}
+
+#endif
@@ -0,0 +1,332 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/cached_ik_kinematics_plugin/cached_ik_kinematics_plugin.h>
+#include <class_loader/class_loader.h>
+#include <ros/ros.h>
+#include <algorithm>
+#include <cstdlib>
+
+// register CachedIKKinematicsPlugin as a KinematicsBase implementation
+CLASS_LOADER_REGISTER_CLASS(cached_ik_kinematics_plugin::CachedIKKinematicsPlugin, kinematics::KinematicsBase)
+
+namespace cached_ik_kinematics_plugin
+{
+namespace
+{
+const std::string PLUGIN_NAME = "cached_ik_kinematics_plugin/CachedIKKinematicsPlugin";
+
+std::string getDefaultCacheFile(const std::string& group_name)
+{
+  std::string directory;
+  if (const char* ros_home = std::getenv("ROS_HOME"))
+    directory = ros_home;
+  else if (const char* home = std::getenv("HOME"))
+    directory = std::string(home) + "/.ros";
+  else
+    directory = ".";
+  std::string name = group_name;
+  std::replace(name.begin(), name.end(), '/', '_');
+  return directory + "/ik_cache_" + name + ".bin";
+}
+
+std::string getRobotDescriptionString(const ros::NodeHandle& nh, const std::string& param)
+{
+  std::string resolved_param, value;
+  if (nh.searchParam(param, resolved_param))
+    nh.getParam(resolved_param, value);
+  return value;
+}
+}
+
+CachedIKKinematicsPlugin::CachedIKKinematicsPlugin()
+  : additions_since_save_(0), cache_fingerprint_(0), seed_count_(0), min_pose_distance_(0.0), save_period_(0)
+{
+}
+
+CachedIKKinematicsPlugin::~CachedIKKinematicsPlugin()
+{
+  saveCache();
+}
+
+bool CachedIKKinematicsPlugin::initialize(const std::string& robot_description, const std::string& group_name,
+                                          const std::string& base_frame, const std::string& tip_frame,
+                                          double search_discretization)
+{
+  setValues(robot_description, group_name, base_frame, tip_frame, search_discretization);
+
+  ros::NodeHandle private_handle("~");
+  std::string solver_name;
+  private_handle.param(group_name + "/cached_ik/solver", solver_name,
+                       std::string("kdl_kinematics_plugin/KDLKinematicsPlugin"));
+  if (solver_name == PLUGIN_NAME)
+  {
+    ROS_ERROR_NAMED("cached_ik", "The cached IK solver cannot wrap itself");
+    return false;
+  }
+  try
+  {
+    solver_loader_.reset(
+        new pluginlib::ClassLoader<kinematics::KinematicsBase>("moveit_core", "kinematics::KinematicsBase"));
+    solver_ = solver_loader_->createUniqueInstance(solver_name);
+  }
+  catch (pluginlib::PluginlibException& e)
+  {
+    ROS_ERROR_NAMED("cached_ik", "The kinematics plugin (%s) failed to load. Error: %s", solver_name.c_str(),
+                    e.what());
+    solver_.reset();
+    return false;
+  }
+  if (!solver_->initialize(robot_description, group_name, base_frame, tip_frame, search_discretization))
+  {
+    ROS_ERROR_NAMED("cached_ik", "Kinematics solver of type '%s' could not be initialized for group '%s'",
+                    solver_name.c_str(), group_name.c_str());
+    solver_.reset();
+    return false;
+  }
+  joint_names_ = solver_->getJointNames();
+  link_names_ = solver_->getLinkNames();
+  solver_->getRedundantJoints(redundant_joint_indices_);
+
+  int seed_count, max_cache_size, save_period;
+  double orientation_weight;
+  private_handle.param(group_name + "/cached_ik/seed_count", seed_count, 3);
+  private_handle.param(group_name + "/cached_ik/max_cache_size", max_cache_size, 100000);
+  private_handle.param(group_name + "/cached_ik/save_period", save_period, 1000);
+  private_handle.param(group_name + "/cached_ik/min_pose_distance", min_pose_distance_, 1e-3);
+  private_handle.param(group_name + "/cached_ik/orientation_weight", orientation_weight, 0.5);
+  private_handle.param(group_name + "/cached_ik/cache_file", cache_file_, getDefaultCacheFile(group_name));
+  seed_count_ = std::max(seed_count, 0);
+  save_period_ = std::max(save_period, 0);
+
+  // cached solutions are only valid for the same solver on the same robot
+  ros::NodeHandle nh;
+  cache_fingerprint_ = IKCache::computeFingerprint(
+      solver_name + '\n' + group_name + '\n' + base_frame + '\n' + tip_frame + '\n' +
+      getRobotDescriptionString(nh, robot_description) + '\n' +
+      getRobotDescriptionString(nh, robot_description + "_semantic"));
+
+  boost::mutex::scoped_lock slock(cache_lock_);
+  cache_.reset(new IKCache(joint_names_.size(), orientation_weight, std::max(max_cache_size, 0)));
+  if (cache_->load(cache_file_, cache_fingerprint_))
+    ROS_INFO_NAMED("cached_ik", "Loaded %u cached IK solutions for group '%s' from '%s'",
+                   (unsigned int)cache_->size(), group_name.c_str(), cache_file_.c_str());
+  additions_since_save_ = 0;
+  return true;
+}
+
+bool CachedIKKinematicsPlugin::getPositionIK(const geometry_msgs::Pose& ik_pose,
+                                             const std::vector<double>& ik_seed_state, std::vector<double>& solution,
+                                             moveit_msgs::MoveItErrorCodes& error_code,
+                                             const kinematics::KinematicsQueryOptions& options) const
+{
+  if (!solver_)
+  {
+    ROS_ERROR_NAMED("cached_ik", "kinematics not active");
+    error_code.val = moveit_msgs::MoveItErrorCodes::NO_IK_SOLUTION;
+    return false;
+  }
+
+  std::vector<std::vector<double> > seeds;
+  {
+    boost::mutex::scoped_lock slock(cache_lock_);
+    cache_->getNearestSolutions(ik_pose, 1, seeds);
+  }
+  if (!seeds.empty() && solver_->getPositionIK(ik_pose, seeds[0], solution, error_code, options))
+    return true;
+  if (!solver_->getPositionIK(ik_pose, ik_seed_state, solution, error_code, options))
+    return false;
+  addToCache(ik_pose, solution);
+  return true;
+}
+
+bool CachedIKKinematicsPlugin::searchPositionIK(const geometry_msgs::Pose& ik_pose,
+                                                const std::vector<double>& ik_seed_state, double timeout,
+                                                std::vector<double>& solution,
+                                                moveit_msgs::MoveItErrorCodes& error_code,
+                                                const kinematics::KinematicsQueryOptions& options) const
+{
+  const IKCallbackFn solution_callback = 0;
+  std::vector<double> consistency_limits;
+  return searchPositionIK(ik_pose, ik_seed_state, timeout, consistency_limits, solution, solution_callback, error_code,
+                          options);
+}
+
+bool CachedIKKinematicsPlugin::searchPositionIK(const geometry_msgs::Pose& ik_pose,
+                                                const std::vector<double>& ik_seed_state, double timeout,
+                                                const std::vector<double>& consistency_limits,
+                                                std::vector<double>& solution,
+                                                moveit_msgs::MoveItErrorCodes& error_code,
+                                                const kinematics::KinematicsQueryOptions& options) const
+{
+  const IKCallbackFn solution_callback = 0;
+  return searchPositionIK(ik_pose, ik_seed_state, timeout, consistency_limits, solution, solution_callback, error_code,
+                          options);
+}
+
+bool CachedIKKinematicsPlugin::searchPositionIK(const geometry_msgs::Pose& ik_pose,
+                                                const std::vector<double>& ik_seed_state, double timeout,
+                                                std::vector<double>& solution, const IKCallbackFn& solution_callback,
+                                                moveit_msgs::MoveItErrorCodes& error_code,
+                                                const kinematics::KinematicsQueryOptions& options) const
+{
+  std::vector<double> consistency_limits;
+  return searchPositionIK(ik_pose, ik_seed_state, timeout, consistency_limits, solution, solution_callback, error_code,
+                          options);
+}
+
+bool CachedIKKinematicsPlugin::searchPositionIK(const geometry_msgs::Pose& ik_pose,
+                                                const std::vector<double>& ik_seed_state, double timeout,
+                                                const std::vector<double>& consistency_limits,
+                                                std::vector<double>& solution, const IKCallbackFn& solution_callback,
+                                                moveit_msgs::MoveItErrorCodes& error_code,
+                                                const kinematics::KinematicsQueryOptions& options) const
+{
+  if (!solver_)
+  {
+    ROS_ERROR_NAMED("cached_ik", "kinematics not active");
+    error_code.val = moveit_msgs::MoveItErrorCodes::NO_IK_SOLUTION;
+    return false;
+  }
+
+  std::vector<std::vector<double> > seeds;
+  if (consistency_limits.empty())
+  {
+    boost::mutex::scoped_lock slock(cache_lock_);
+    cache_->getNearestSolutions(ik_pose, seed_count_, seeds);
+  }
+
+  // each cached seed gets an equal share of the time that is left, keeping a share for the caller's seed
+  ros::WallTime start_time = ros::WallTime::now();
+  for (std::size_t i = 0; i < seeds.size(); ++i)
+  {
+    double remaining = timeout - (ros::WallTime::now() - start_time).toSec();
+    if (remaining <= 0.0)
+      break;
+    if (solver_->searchPositionIK(ik_pose, seeds[i], remaining / (seeds.size() - i + 1), consistency_limits, solution,
+                                  solution_callback, error_code, options))
+    {
+      ROS_DEBUG_NAMED("cached_ik", "Solved IK from cached seed %u", (unsigned int)i);
+      addToCache(ik_pose, solution);
+      return true;
+    }
+  }
+
+  double remaining = std::max(timeout - (ros::WallTime::now() - start_time).toSec(), 0.0);
+  if (!solver_->searchPositionIK(ik_pose, ik_seed_state, remaining, consistency_limits, solution, solution_callback,
+                                 error_code, options))
+    return false;
+  addToCache(ik_pose, solution);
+  return true;
+}
+
+bool CachedIKKinematicsPlugin::getPositionFK(const std::vector<std::string>& link_names,
+                                             const std::vector<double>& joint_angles,
+                                             std::vector<geometry_msgs::Pose>& poses) const
+{
+  if (!solver_)
+  {
+    ROS_ERROR_NAMED("cached_ik", "kinematics not active");
+    return false;
+  }
+  return solver_->getPositionFK(link_names, joint_angles, poses);
+}
+
+bool CachedIKKinematicsPlugin::setRedundantJoints(const std::vector<unsigned int>& redundant_joint_indices)
+{
+  if (!solver_ || !solver_->setRedundantJoints(redundant_joint_indices))
+    return false;
+  solver_->getRedundantJoints(redundant_joint_indices_);
+  return true;
+}
+
+bool CachedIKKinematicsPlugin::supportsGroup(const moveit::core::JointModelGroup* jmg,
+                                             std::string* error_text_out) const
+{
+  if (!solver_)
+    return KinematicsBase::supportsGroup(jmg, error_text_out);
+  return solver_->supportsGroup(jmg, error_text_out);
+}
+
+void CachedIKKinematicsPlugin::setDefaultTimeout(double timeout)
+{
+  KinematicsBase::setDefaultTimeout(timeout);
+  if (solver_)
+    solver_->setDefaultTimeout(timeout);
+}
+
+void CachedIKKinematicsPlugin::setSearchThreadCount(unsigned int thread_count)
+{
+  KinematicsBase::setSearchThreadCount(thread_count);
+  if (solver_)
+    solver_->setSearchThreadCount(thread_count);
+}
+
+const std::vector<std::string>& CachedIKKinematicsPlugin::getJointNames() const
+{
+  return joint_names_;
+}
+
+const std::vector<std::string>& CachedIKKinematicsPlugin::getLinkNames() const
+{
+  return link_names_;
+}
+
+bool CachedIKKinematicsPlugin::saveCache() const
+{
+  boost::mutex::scoped_lock slock(cache_lock_);
+  if (!cache_ || !cache_->isModified())
+    return true;
+  additions_since_save_ = 0;
+  return cache_->save(cache_file_, cache_fingerprint_);
+}
+
+std::size_t CachedIKKinematicsPlugin::getCacheSize() const
+{
+  boost::mutex::scoped_lock slock(cache_lock_);
+  return cache_ ? cache_->size() : 0;
+}
+
+void CachedIKKinematicsPlugin::addToCache(const geometry_msgs::Pose& ik_pose, const std::vector<double>& solution) const
+{
+  boost::mutex::scoped_lock slock(cache_lock_);
+  if (!cache_->addSolution(ik_pose, solution, min_pose_distance_))
+    return;
+  if (save_period_ > 0 && ++additions_since_save_ >= save_period_)
+  {
+    additions_since_save_ = 0;
+    cache_->save(cache_file_, cache_fingerprint_);
+  }
+}
+}
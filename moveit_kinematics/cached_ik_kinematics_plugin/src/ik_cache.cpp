@@ -0,0 +1,383 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/cached_ik_kinematics_plugin/ik_cache.h>
+#include <ros/console.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+namespace cached_ik_kinematics_plugin
+{
+namespace
+{
+// number of coordinates of the point a pose is compared as
+const unsigned int POINT_SIZE = 7;
+
+// pending solutions are merged into the tree once there are this many, or a sixteenth of the tree size
+const std::size_t MIN_PENDING_MERGE = 256;
+
+const char FILE_MAGIC[8] = { 'M', 'I', 'K', 'C', 'A', 'C', 'H', '1' };
+
+// the records of the tree follow this header in the cache file
+struct FileHeader
+{
+  char magic[8];
+  uint32_t dimension;
+  uint32_t point_size;
+  uint64_t fingerprint;
+  uint64_t size;
+  double orientation_weight;
+};
+
+struct CompareAxis
+{
+  CompareAxis(unsigned int axis) : axis_(axis)
+  {
+  }
+
+  bool operator()(const double* a, const double* b) const
+  {
+    return a[axis_] < b[axis_];
+  }
+
+  unsigned int axis_;
+};
+
+double squaredDistance(const double* a, const double* b)
+{
+  double d = 0.0;
+  for (unsigned int i = 0; i < POINT_SIZE; ++i)
+    d += (a[i] - b[i]) * (a[i] - b[i]);
+  return d;
+}
+}
+
+// the records nearest to a query found so far, closest first
+struct IKCache::Neighbors
+{
+  Neighbors(std::size_t count) : count_(count)
+  {
+    nearest_.reserve(count + 1);
+  }
+
+  double worst() const
+  {
+    return nearest_.size() < count_ ? std::numeric_limits<double>::infinity() : nearest_.back().first;
+  }
+
+  void insert(double distance2, const double* record)
+  {
+    if (distance2 >= worst())
+      return;
+    // the same record can be found once for each sign of the quaternion of the query
+    for (std::size_t i = 0; i < nearest_.size(); ++i)
+      if (nearest_[i].second == record)
+      {
+        if (distance2 >= nearest_[i].first)
+          return;
+        nearest_.erase(nearest_.begin() + i);
+        break;
+      }
+    std::vector<std::pair<double, const double*> >::iterator it = nearest_.begin();
+    while (it != nearest_.end() && it->first <= distance2)
+      ++it;
+    nearest_.insert(it, std::make_pair(distance2, record));
+    if (nearest_.size() > count_)
+      nearest_.pop_back();
+  }
+
+  std::size_t count_;
+  std::vector<std::pair<double, const double*> > nearest_;
+};
+
+IKCache::IKCache(unsigned int dimension, double orientation_weight, std::size_t max_size)
+  : dimension_(dimension)
+  , record_size_(POINT_SIZE + dimension)
+  , orientation_weight_(orientation_weight)
+  , max_size_(max_size)
+  , tree_(NULL)
+  , tree_size_(0)
+  , pending_size_(0)
+  , modified_(false)
+{
+}
+
+bool IKCache::load(const std::string& filename, uint64_t fingerprint)
+{
+  tree_ = NULL;
+  tree_size_ = 0;
+  tree_storage_.clear();
+  pending_.clear();
+  pending_size_ = 0;
+  modified_ = false;
+  boost::interprocess::mapped_region().swap(region_);
+
+  boost::interprocess::mapped_region region;
+  try
+  {
+    boost::interprocess::file_mapping file(filename.c_str(), boost::interprocess::read_only);
+    boost::interprocess::mapped_region(file, boost::interprocess::read_only).swap(region);
+  }
+  catch (boost::interprocess::interprocess_exception& ex)
+  {
+    ROS_DEBUG_NAMED("cached_ik", "Could not map IK cache file '%s': %s", filename.c_str(), ex.what());
+    return false;
+  }
+
+  if (region.get_size() < sizeof(FileHeader))
+  {
+    ROS_WARN_NAMED("cached_ik", "IK cache file '%s' is truncated", filename.c_str());
+    return false;
+  }
+  const FileHeader* header = static_cast<const FileHeader*>(region.get_address());
+  if (memcmp(header->magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || header->point_size != POINT_SIZE)
+  {
+    ROS_WARN_NAMED("cached_ik", "'%s' is not an IK cache file", filename.c_str());
+    return false;
+  }
+  if (header->dimension != dimension_ || header->fingerprint != fingerprint ||
+      header->orientation_weight != orientation_weight_)
+  {
+    ROS_INFO_NAMED("cached_ik", "IK cache file '%s' was written for a different solver or robot; ignoring it",
+                   filename.c_str());
+    return false;
+  }
+  if (region.get_size() != sizeof(FileHeader) + header->size * record_size_ * sizeof(double))
+  {
+    ROS_WARN_NAMED("cached_ik", "IK cache file '%s' is truncated", filename.c_str());
+    return false;
+  }
+
+  tree_size_ = header->size;
+  tree_ = reinterpret_cast<const double*>(static_cast<const char*>(region.get_address()) + sizeof(FileHeader));
+  region_.swap(region);
+  ROS_DEBUG_NAMED("cached_ik", "Mapped %u IK solutions from '%s'", (unsigned int)tree_size_, filename.c_str());
+  return true;
+}
+
+bool IKCache::save(const std::string& filename, uint64_t fingerprint)
+{
+  if (pending_size_ > 0)
+    rebuildTree();
+
+  FileHeader header;
+  memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+  header.dimension = dimension_;
+  header.point_size = POINT_SIZE;
+  header.fingerprint = fingerprint;
+  header.size = tree_size_;
+  header.orientation_weight = orientation_weight_;
+
+  // write next to the target and rename, so processes that map the old file keep a consistent view of it
+  std::string tmp_filename = filename + ".tmp";
+  {
+    std::ofstream file(tmp_filename.c_str(), std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+      ROS_ERROR_NAMED("cached_ik", "Could not open IK cache file '%s' for writing", tmp_filename.c_str());
+      return false;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (tree_size_ > 0)
+      file.write(reinterpret_cast<const char*>(tree_), tree_size_ * record_size_ * sizeof(double));
+    if (!file.good())
+    {
+      ROS_ERROR_NAMED("cached_ik", "Could not write IK cache file '%s'", tmp_filename.c_str());
+      std::remove(tmp_filename.c_str());
+      return false;
+    }
+  }
+  if (std::rename(tmp_filename.c_str(), filename.c_str()) != 0)
+  {
+    ROS_ERROR_NAMED("cached_ik", "Could not replace IK cache file '%s'", filename.c_str());
+    std::remove(tmp_filename.c_str());
+    return false;
+  }
+  modified_ = false;
+  ROS_DEBUG_NAMED("cached_ik", "Wrote %u IK solutions to '%s'", (unsigned int)tree_size_, filename.c_str());
+  return true;
+}
+
+void IKCache::getNearestSolutions(const geometry_msgs::Pose& pose, std::size_t count,
+                                  std::vector<std::vector<double> >& solutions, std::vector<double>* distances) const
+{
+  solutions.clear();
+  if (distances)
+    distances->clear();
+  if (count == 0 || size() == 0)
+    return;
+
+  Neighbors neighbors(count);
+  double point[POINT_SIZE];
+  for (int flip = 0; flip < 2; ++flip)
+  {
+    poseToPoint(pose, flip, point);
+    searchTree(0, tree_size_, 0, point, neighbors);
+    searchPending(point, neighbors);
+  }
+
+  solutions.resize(neighbors.nearest_.size());
+  for (std::size_t i = 0; i < neighbors.nearest_.size(); ++i)
+  {
+    const double* values = neighbors.nearest_[i].second + POINT_SIZE;
+    solutions[i].assign(values, values + dimension_);
+    if (distances)
+      distances->push_back(sqrt(neighbors.nearest_[i].first));
+  }
+}
+
+bool IKCache::addSolution(const geometry_msgs::Pose& pose, const std::vector<double>& solution, double min_distance)
+{
+  if (solution.size() != dimension_ || size() >= max_size_)
+    return false;
+
+  std::vector<std::vector<double> > nearest;
+  std::vector<double> distances;
+  getNearestSolutions(pose, 1, nearest, &distances);
+  if (!distances.empty() && distances[0] < min_distance)
+    return false;
+
+  pending_.resize((pending_size_ + 1) * record_size_);
+  double* record = &pending_[pending_size_ * record_size_];
+  poseToPoint(pose, false, record);
+  std::copy(solution.begin(), solution.end(), record + POINT_SIZE);
+  ++pending_size_;
+  modified_ = true;
+
+  if (pending_size_ >= std::max(MIN_PENDING_MERGE, tree_size_ / 16))
+    rebuildTree();
+  return true;
+}
+
+uint64_t IKCache::computeFingerprint(const std::string& description)
+{
+  // 64 bit FNV-1a
+  uint64_t hash = 14695981039346656037ULL;
+  for (std::size_t i = 0; i < description.size(); ++i)
+  {
+    hash ^= (unsigned char)description[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+void IKCache::poseToPoint(const geometry_msgs::Pose& pose, bool flip, double* point) const
+{
+  // q and -q are the same orientation: store the one with a non-negative w, query with both
+  const geometry_msgs::Quaternion& q = pose.orientation;
+  double scale = orientation_weight_ / sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+  if ((q.w < 0.0) != flip)
+    scale = -scale;
+  point[0] = pose.position.x;
+  point[1] = pose.position.y;
+  point[2] = pose.position.z;
+  point[3] = q.x * scale;
+  point[4] = q.y * scale;
+  point[5] = q.z * scale;
+  point[6] = q.w * scale;
+}
+
+void IKCache::searchTree(std::size_t begin, std::size_t end, unsigned int axis, const double* point,
+                         Neighbors& neighbors) const
+{
+  if (begin >= end)
+    return;
+  std::size_t mid = begin + (end - begin) / 2;
+  const double* record = tree_ + mid * record_size_;
+  neighbors.insert(squaredDistance(point, record), record);
+
+  double diff = point[axis] - record[axis];
+  unsigned int next_axis = (axis + 1) % POINT_SIZE;
+  if (diff < 0.0)
+  {
+    searchTree(begin, mid, next_axis, point, neighbors);
+    if (diff * diff < neighbors.worst())
+      searchTree(mid + 1, end, next_axis, point, neighbors);
+  }
+  else
+  {
+    searchTree(mid + 1, end, next_axis, point, neighbors);
+    if (diff * diff < neighbors.worst())
+      searchTree(begin, mid, next_axis, point, neighbors);
+  }
+}
+
+void IKCache::searchPending(const double* point, Neighbors& neighbors) const
+{
+  for (std::size_t i = 0; i < pending_size_; ++i)
+  {
+    const double* record = &pending_[i * record_size_];
+    neighbors.insert(squaredDistance(point, record), record);
+  }
+}
+
+void IKCache::buildTree(std::vector<const double*>& records, std::size_t begin, std::size_t end, unsigned int axis,
+                        double* out) const
+{
+  if (begin >= end)
+    return;
+  std::size_t mid = begin + (end - begin) / 2;
+  std::nth_element(records.begin() + begin, records.begin() + mid, records.begin() + end, CompareAxis(axis));
+  std::copy(records[mid], records[mid] + record_size_, out + mid * record_size_);
+
+  unsigned int next_axis = (axis + 1) % POINT_SIZE;
+  buildTree(records, begin, mid, next_axis, out);
+  buildTree(records, mid + 1, end, next_axis, out);
+}
+
+void IKCache::rebuildTree()
+{
+  std::vector<const double*> records;
+  records.reserve(size());
+  for (std::size_t i = 0; i < tree_size_; ++i)
+    records.push_back(tree_ + i * record_size_);
+  for (std::size_t i = 0; i < pending_size_; ++i)
+    records.push_back(&pending_[i * record_size_]);
+
+  std::vector<double> storage(records.size() * record_size_);
+  if (!records.empty())
+    buildTree(records, 0, records.size(), 0, &storage[0]);
+
+  tree_storage_.swap(storage);
+  tree_ = tree_storage_.empty() ? NULL : &tree_storage_[0];
+  tree_size_ = records.size();
+  pending_.clear();
+  pending_size_ = 0;
+  boost::interprocess::mapped_region().swap(region_);
+}
+}
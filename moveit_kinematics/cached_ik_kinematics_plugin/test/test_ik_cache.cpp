@@ -0,0 +1,362 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/cached_ik_kinematics_plugin/ik_cache.h>
+#include <gtest/gtest.h>
+#include <boost/filesystem.hpp>
+#include <random_numbers/random_numbers.h>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iterator>
+
+using cached_ik_kinematics_plugin::IKCache;
+
+namespace
+{
+const unsigned int DIMENSION = 3;
+const double ORIENTATION_WEIGHT = 0.5;
+
+geometry_msgs::Pose makePose(double x, double y, double z)
+{
+  geometry_msgs::Pose pose;
+  pose.position.x = x;
+  pose.position.y = y;
+  pose.position.z = z;
+  pose.orientation.w = 1.0;
+  return pose;
+}
+
+geometry_msgs::Pose randomPose(random_numbers::RandomNumberGenerator& rng)
+{
+  geometry_msgs::Pose pose = makePose(rng.uniformReal(-1.0, 1.0), rng.uniformReal(-1.0, 1.0),
+                                      rng.uniformReal(-1.0, 1.0));
+  double q[4];
+  rng.quaternion(q);
+  pose.orientation.x = q[0];
+  pose.orientation.y = q[1];
+  pose.orientation.z = q[2];
+  pose.orientation.w = q[3];
+  return pose;
+}
+
+std::vector<double> makeSolution(double value)
+{
+  return std::vector<double>(DIMENSION, value);
+}
+
+// the distance IKCache uses between two poses
+double poseDistance(const geometry_msgs::Pose& a, const geometry_msgs::Pose& b)
+{
+  const geometry_msgs::Quaternion& qa = a.orientation;
+  const geometry_msgs::Quaternion& qb = b.orientation;
+  double dot = qa.x * qb.x + qa.y * qb.y + qa.z * qb.z + qa.w * qb.w;
+  double na = sqrt(qa.x * qa.x + qa.y * qa.y + qa.z * qa.z + qa.w * qa.w);
+  double nb = sqrt(qb.x * qb.x + qb.y * qb.y + qb.z * qb.z + qb.w * qb.w);
+  double dx = a.position.x - b.position.x;
+  double dy = a.position.y - b.position.y;
+  double dz = a.position.z - b.position.z;
+  // |qa/na - s qb/nb|^2 for the sign s that makes it smallest
+  double dq2 = 2.0 - 2.0 * fabs(dot) / (na * nb);
+  return sqrt(dx * dx + dy * dy + dz * dz + ORIENTATION_WEIGHT * ORIENTATION_WEIGHT * std::max(dq2, 0.0));
+}
+
+class IKCacheFileTest : public testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    filename_ = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string();
+    fingerprint_ = IKCache::computeFingerprint("test robot");
+  }
+
+  virtual void TearDown()
+  {
+    boost::filesystem::remove(filename_);
+  }
+
+  void fillCache(IKCache& cache, std::size_t count)
+  {
+    random_numbers::RandomNumberGenerator rng(1);
+    for (std::size_t i = 0; i < count; ++i)
+      cache.addSolution(randomPose(rng), makeSolution(i), 0.0);
+  }
+
+  std::string readFile() const
+  {
+    std::ifstream file(filename_.c_str(), std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  }
+
+  void writeFile(const std::string& content) const
+  {
+    std::ofstream file(filename_.c_str(), std::ios::binary | std::ios::trunc);
+    file.write(content.data(), content.size());
+  }
+
+  std::string filename_;
+  uint64_t fingerprint_;
+};
+}
+
+TEST(IKCache, NearestSolutionsClosestFirst)
+{
+  IKCache cache(DIMENSION, ORIENTATION_WEIGHT, 100);
+  EXPECT_EQ(0u, cache.size());
+  EXPECT_FALSE(cache.isModified());
+
+  std::vector<std::vector<double> > solutions;
+  std::vector<double> distances;
+  cache.getNearestSolutions(makePose(0.0, 0.0, 0.0), 3, solutions, &distances);
+  EXPECT_TRUE(solutions.empty());
+  EXPECT_TRUE(distances.empty());
+
+  for (int i = 0; i < 5; ++i)
+    EXPECT_TRUE(cache.addSolution(makePose(i, 0.0, 0.0), makeSolution(i), 0.0));
+  EXPECT_EQ(5u, cache.size());
+  EXPECT_TRUE(cache.isModified());
+
+  cache.getNearestSolutions(makePose(2.9, 0.0, 0.0), 3, solutions, &distances);
+  ASSERT_EQ(3u, solutions.size());
+  ASSERT_EQ(3u, distances.size());
+  EXPECT_EQ(makeSolution(3), solutions[0]);
+  EXPECT_EQ(makeSolution(2), solutions[1]);
+  EXPECT_EQ(makeSolution(4), solutions[2]);
+  EXPECT_NEAR(0.1, distances[0], 1e-9);
+  EXPECT_NEAR(0.9, distances[1], 1e-9);
+  EXPECT_NEAR(1.1, distances[2], 1e-9);
+
+  // more neighbors than solutions
+  cache.getNearestSolutions(makePose(0.0, 0.0, 0.0), 10, solutions);
+  EXPECT_EQ(5u, solutions.size());
+}
+
+TEST(IKCache, OppositeQuaternionsAreTheSameOrientation)
+{
+  IKCache cache(DIMENSION, ORIENTATION_WEIGHT, 100);
+  geometry_msgs::Pose pose = makePose(0.5, 0.5, 0.5);
+  pose.orientation.x = 0.5;
+  pose.orientation.y = -0.5;
+  pose.orientation.z = 0.5;
+  pose.orientation.w = -0.5;
+  EXPECT_TRUE(cache.addSolution(pose, makeSolution(1.0), 0.0));
+
+  geometry_msgs::Pose flipped = pose;
+  flipped.orientation.x = -pose.orientation.x;
+  flipped.orientation.y = -pose.orientation.y;
+  flipped.orientation.z = -pose.orientation.z;
+  flipped.orientation.w = -pose.orientation.w;
+  std::vector<std::vector<double> > solutions;
+  std::vector<double> distances;
+  cache.getNearestSolutions(flipped, 2, solutions, &distances);
+  ASSERT_EQ(1u, solutions.size());
+  EXPECT_NEAR(0.0, distances[0], 1e-9);
+
+  // a solution this close to a cached pose is not added
+  EXPECT_FALSE(cache.addSolution(flipped, makeSolution(2.0), 0.01));
+  EXPECT_EQ(1u, cache.size());
+}
+
+TEST(IKCache, RejectedSolutions)
+{
+  IKCache cache(DIMENSION, ORIENTATION_WEIGHT, 2);
+  EXPECT_FALSE(cache.addSolution(makePose(0.0, 0.0, 0.0), std::vector<double>(DIMENSION + 1, 0.0), 0.0));
+  EXPECT_TRUE(cache.addSolution(makePose(0.0, 0.0, 0.0), makeSolution(0.0), 0.1));
+  EXPECT_FALSE(cache.addSolution(makePose(0.05, 0.0, 0.0), makeSolution(1.0), 0.1));
+  EXPECT_TRUE(cache.addSolution(makePose(1.0, 0.0, 0.0), makeSolution(1.0), 0.1));
+  EXPECT_FALSE(cache.addSolution(makePose(2.0, 0.0, 0.0), makeSolution(2.0), 0.1));
+  EXPECT_EQ(2u, cache.size());
+}
+
+TEST(IKCache, NearestMatchesLinearScan)
+{
+  // enough solutions for the pending ones to be merged into the tree several times
+  random_numbers::RandomNumberGenerator rng(7);
+  IKCache cache(DIMENSION, ORIENTATION_WEIGHT, 10000);
+  std::vector<geometry_msgs::Pose> poses;
+  for (std::size_t i = 0; i < 2000; ++i)
+  {
+    poses.push_back(randomPose(rng));
+    ASSERT_TRUE(cache.addSolution(poses.back(), makeSolution(i), 0.0));
+  }
+  ASSERT_EQ(poses.size(), cache.size());
+
+  for (int q = 0; q < 50; ++q)
+  {
+    geometry_msgs::Pose query = randomPose(rng);
+    std::vector<std::vector<double> > solutions;
+    std::vector<double> distances;
+    cache.getNearestSolutions(query, 5, solutions, &distances);
+    ASSERT_EQ(5u, solutions.size());
+
+    std::vector<double> expected(poses.size());
+    for (std::size_t i = 0; i < poses.size(); ++i)
+      expected[i] = poseDistance(query, poses[i]);
+    std::sort(expected.begin(), expected.end());
+    for (std::size_t i = 0; i < distances.size(); ++i)
+    {
+      EXPECT_NEAR(expected[i], distances[i], 1e-9);
+      EXPECT_NEAR(distances[i], poseDistance(query, poses[static_cast<std::size_t>(solutions[i][0])]), 1e-9);
+    }
+  }
+}
+
+TEST_F(IKCacheFileTest, SaveLoadRoundTrip)
+{
+  IKCache cache(DIMENSION, ORIENTATION_WEIGHT, 1000);
+  fillCache(cache, 300);
+  ASSERT_TRUE(cache.save(filename_, fingerprint_));
+  EXPECT_FALSE(cache.isModified());
+
+  IKCache loaded(DIMENSION, ORIENTATION_WEIGHT, 1000);
+  ASSERT_TRUE(loaded.load(filename_, fingerprint_));
+  EXPECT_EQ(cache.size(), loaded.size());
+  EXPECT_FALSE(loaded.isModified());
+
+  random_numbers::RandomNumberGenerator rng(3);
+  for (int q = 0; q < 20; ++q)
+  {
+    geometry_msgs::Pose query = randomPose(rng);
+    std::vector<std::vector<double> > expected, solutions;
+    std::vector<double> expected_distances, distances;
+    cache.getNearestSolutions(query, 4, expected, &expected_distances);
+    loaded.getNearestSolutions(query, 4, solutions, &distances);
+    EXPECT_EQ(expected, solutions);
+    EXPECT_EQ(expected_distances, distances);
+  }
+
+  // solutions added to a loaded cache are saved along with the loaded ones
+  EXPECT_TRUE(loaded.addSolution(makePose(5.0, 5.0, 5.0), makeSolution(-1.0), 0.0));
+  EXPECT_TRUE(loaded.isModified());
+  ASSERT_TRUE(loaded.save(filename_, fingerprint_));
+  IKCache reloaded(DIMENSION, ORIENTATION_WEIGHT, 1000);
+  ASSERT_TRUE(reloaded.load(filename_, fingerprint_));
+  EXPECT_EQ(cache.size() + 1, reloaded.size());
+  std::vector<std::vector<double> > solutions;
+  reloaded.getNearestSolutions(makePose(5.0, 5.0, 5.0), 1, solutions);
+  ASSERT_EQ(1u, solutions.size());
+  EXPECT_EQ(makeSolution(-1.0), solutions[0]);
+
+  // an empty cache round trips too
+  IKCache empty(DIMENSION, ORIENTATION_WEIGHT, 1000);
+  ASSERT_TRUE(empty.save(filename_, fingerprint_));
+  ASSERT_TRUE(reloaded.load(filename_, fingerprint_));
+  EXPECT_EQ(0u, reloaded.size());
+}
+
+TEST_F(IKCacheFileTest, MismatchedFilesAreIgnored)
+{
+  IKCache cache(DIMENSION, ORIENTATION_WEIGHT, 1000);
+  fillCache(cache, 10);
+  ASSERT_TRUE(cache.save(filename_, fingerprint_));
+
+  IKCache other_fingerprint(DIMENSION, ORIENTATION_WEIGHT, 1000);
+  EXPECT_FALSE(other_fingerprint.load(filename_, IKCache::computeFingerprint("other robot")));
+  EXPECT_EQ(0u, other_fingerprint.size());
+
+  IKCache other_dimension(DIMENSION + 1, ORIENTATION_WEIGHT, 1000);
+  EXPECT_FALSE(other_dimension.load(filename_, fingerprint_));
+  EXPECT_EQ(0u, other_dimension.size());
+
+  IKCache other_weight(DIMENSION, 2.0 * ORIENTATION_WEIGHT, 1000);
+  EXPECT_FALSE(other_weight.load(filename_, fingerprint_));
+  EXPECT_EQ(0u, other_weight.size());
+
+  IKCache missing(DIMENSION, ORIENTATION_WEIGHT, 1000);
+  EXPECT_FALSE(missing.load(filename_ + ".missing", fingerprint_));
+  EXPECT_EQ(0u, missing.size());
+}
+
+TEST_F(IKCacheFileTest, TruncatedFilesAreRejected)
+{
+  IKCache cache(DIMENSION, ORIENTATION_WEIGHT, 1000);
+  fillCache(cache, 10);
+  ASSERT_TRUE(cache.save(filename_, fingerprint_));
+  const std::string content = readFile();
+  ASSERT_FALSE(content.empty());
+
+  // cut in the header, in the middle of a record, and at a record boundary
+  const std::size_t record_bytes = (7 + DIMENSION) * sizeof(double);
+  const std::size_t lengths[] = { 0, 4, content.size() - record_bytes / 2, content.size() - record_bytes };
+  for (std::size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); ++i)
+  {
+    writeFile(content.substr(0, lengths[i]));
+    IKCache loaded(DIMENSION, ORIENTATION_WEIGHT, 1000);
+    EXPECT_FALSE(loaded.load(filename_, fingerprint_)) << "file of " << lengths[i] << " bytes";
+    EXPECT_EQ(0u, loaded.size());
+  }
+
+  // trailing bytes are rejected as well
+  writeFile(content + std::string(record_bytes, '\0'));
+  IKCache loaded(DIMENSION, ORIENTATION_WEIGHT, 1000);
+  EXPECT_FALSE(loaded.load(filename_, fingerprint_));
+  EXPECT_EQ(0u, loaded.size());
+}
+
+TEST_F(IKCacheFileTest, CorruptFilesAreRejected)
+{
+  IKCache cache(DIMENSION, ORIENTATION_WEIGHT, 1000);
+  fillCache(cache, 10);
+  ASSERT_TRUE(cache.save(filename_, fingerprint_));
+  std::string content = readFile();
+
+  // a bad magic number
+  std::string corrupt = content;
+  corrupt[0] = 'X';
+  writeFile(corrupt);
+  IKCache bad_magic(DIMENSION, ORIENTATION_WEIGHT, 1000);
+  EXPECT_FALSE(bad_magic.load(filename_, fingerprint_));
+  EXPECT_EQ(0u, bad_magic.size());
+
+  // a file that is not a cache at all
+  writeFile(std::string(content.size(), 'a'));
+  IKCache garbage(DIMENSION, ORIENTATION_WEIGHT, 1000);
+  EXPECT_FALSE(garbage.load(filename_, fingerprint_));
+  EXPECT_EQ(0u, garbage.size());
+
+  // a failed load empties a cache that held solutions
+  writeFile(content);
+  IKCache loaded(DIMENSION, ORIENTATION_WEIGHT, 1000);
+  ASSERT_TRUE(loaded.load(filename_, fingerprint_));
+  ASSERT_EQ(10u, loaded.size());
+  writeFile(corrupt);
+  EXPECT_FALSE(loaded.load(filename_, fingerprint_));
+  EXPECT_EQ(0u, loaded.size());
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -50,9 +50,13 @@
 #include <moveit/kinematics_base/kinematics_base.h>
 #include <urdf/model.h>
 #include <tf_conversions/tf_kdl.h>
+#include <limits>
 
 // Need a floating point tolerance when checking joint limits, in case the joint starts at limit
 const double LIMIT_TOLERANCE = .0000001;
+// Capacities of the buffers the solutions of one IKFast query are filtered in, so that this needs no heap memory
+const int MAX_IKFAST_JOINTS = 16;
+const int MAX_IKFAST_SOLUTIONS = 32;
 /// \brief Search modes for searchPositionIK(), see there
 enum SEARCH_MODE
 {
@@ -139,12 +143,29 @@ enum IkParameterizationType
 // Code generated by IKFast56/61
 #include "_ROBOT_NAME___GROUP_NAME__ikfast_solver.cpp"
 
+void poseEigenToKDL(const Eigen::Affine3d& pose, KDL::Frame& frame)
+{
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    for (unsigned int j = 0; j < 3; ++j)
+      frame.M(i, j) = pose(i, j);
+    frame.p(i) = pose(i, 3);
+  }
+}
+
 class IKFastKinematicsPlugin : public kinematics::KinematicsBase
 {
+  /// \brief The solutions of one IKFast query, one per column, stored on the stack
+  typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::ColMajor, MAX_IKFAST_JOINTS,
+                        MAX_IKFAST_SOLUTIONS>
+      SolutionMatrix;
+
   std::vector<std::string> joint_names_;
   std::vector<double> joint_min_vector_;
   std::vector<double> joint_max_vector_;
   std::vector<bool> joint_has_limits_vector_;
+  Eigen::VectorXd joint_lower_bounds_;  // joint_min_vector_ less LIMIT_TOLERANCE, -inf for joints without limits
+  Eigen::VectorXd joint_upper_bounds_;  // joint_max_vector_ plus LIMIT_TOLERANCE, +inf for joints without limits
   std::vector<std::string> link_names_;
   size_t num_joints_;
   std::vector<int> free_params_;
@@ -204,6 +225,26 @@ public:
                      std::vector<std::vector<double> >& solutions, kinematics::KinematicsResult& result,
                      const kinematics::KinematicsQueryOptions& options) const;
 
+  /**
+   * @brief Solve IK for many poses at once. Like getPositionIK(), this returns for each pose the first closed-form
+   * solution within the joint limits, using the free joint values of the seed.
+   */
+  std::size_t
+  getPositionIKBatch(const EigenSTL::vector_Affine3d& poses, const std::vector<double>& seeds,
+                     std::vector<std::vector<double> >& solutions,
+                     std::vector<moveit_msgs::MoveItErrorCodes>& error_codes,
+                     const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions()) const;
+
+  /**
+   * @brief Compute all closed-form solutions for a pose, with the free joints at their values in the seed, and keep
+   * those within the joint limits and, if \e consistency_limits is not empty, within these limits of the seed.
+   * This skips all message conversions, which makes it the cheapest way to get many solutions.
+   * @param solutions The solutions that pass, stored one after the other with getJointNames().size() values each
+   * @return The number of solutions in \e solutions
+   */
+  std::size_t getAllSolutions(const Eigen::Affine3d& pose, const std::vector<double>& ik_seed_state,
+                              const std::vector<double>& consistency_limits, std::vector<double>& solutions) const;
+
   /**
    * @brief Given a desired pose of the end-effector, search for the joint angles required to reach it.
    * This particular method is intended for "searching" for a solutions by stepping through the redundancy
@@ -300,6 +341,26 @@ private:
    */
   void getSolution(const IkSolutionList<IkReal>& solutions, int i, std::vector<double>& solution) const;
 
+  /**
+   * @brief Copies the first \e numsol solutions in the set (at most MAX_IKFAST_SOLUTIONS) into the columns of \e sols
+   * @return The number of solutions copied
+   */
+  int getSolutions(const IkSolutionList<IkReal>& solutions, int numsol, SolutionMatrix& sols) const;
+
+  /**
+   * @brief Removes the solutions that violate the joint limits from \e sols, and, unless \e consistency_limits is
+   * NULL, those that differ from \e seed by more than these limits
+   * @return The number of solutions left
+   */
+  int filterSolutions(SolutionMatrix& sols, const double* seed, const double* consistency_limits) const;
+
+  /**
+   * @brief Gets the first of the \e numsol solutions in the set that is within the joint limits
+   * @return True if there is such a solution
+   */
+  bool getFirstSolutionWithinLimits(const IkSolutionList<IkReal>& solutions, int numsol,
+                                    std::vector<double>& solution) const;
+
   double harmonize(const std::vector<double>& ik_seed_state, std::vector<double>& solution) const;
   // void getOrderedSolutions(const std::vector<double> &ik_seed_state, std::vector<std::vector<double> >& solslist);
   void getClosestSolution(const IkSolutionList<IkReal>& solutions, const std::vector<double>& ik_seed_state,
@@ -332,6 +393,11 @@ bool IKFastKinematicsPlugin::initialize(const std::string& robot_description, co
   fillFreeParams(GetNumFreeParameters(), GetFreeParameters());
   num_joints_ = GetNumJoints();
 
+  if (num_joints_ > static_cast<size_t>(MAX_IKFAST_JOINTS))
+  {
+    ROS_FATAL("At most %d joints supported!", MAX_IKFAST_JOINTS);
+    return false;
+  }
   if (free_params_.size() > 1)
   {
     ROS_FATAL("Only one free joint parameter supported!");
@@ -432,6 +498,16 @@ bool IKFastKinematicsPlugin::initialize(const std::string& robot_description, co
   std::reverse(joint_max_vector_.begin(), joint_max_vector_.end());
   std::reverse(joint_has_limits_vector_.begin(), joint_has_limits_vector_.end());
 
+  joint_lower_bounds_.resize(num_joints_);
+  joint_upper_bounds_.resize(num_joints_);
+  for (size_t i = 0; i < num_joints_; ++i)
+  {
+    joint_lower_bounds_[i] = joint_has_limits_vector_[i] ? joint_min_vector_[i] - LIMIT_TOLERANCE :
+                                                           -std::numeric_limits<double>::infinity();
+    joint_upper_bounds_[i] = joint_has_limits_vector_[i] ? joint_max_vector_[i] + LIMIT_TOLERANCE :
+                                                           std::numeric_limits<double>::infinity();
+  }
+
   for (size_t i = 0; i < num_joints_; ++i)
     ROS_DEBUG_STREAM_NAMED("ikfast", joint_names_[i] << " " << joint_min_vector_[i] << " " << joint_max_vector_[i]
                                                      << " " << joint_has_limits_vector_[i]);
@@ -576,6 +652,53 @@ void IKFastKinematicsPlugin::getSolution(const IkSolutionList<IkReal>& solutions
   // ROS_ERROR("%f %d",solution[2],vsolfree.size());
 }
 
+int IKFastKinematicsPlugin::getSolutions(const IkSolutionList<IkReal>& solutions, int numsol,
+                                         SolutionMatrix& sols) const
+{
+  if (numsol > MAX_IKFAST_SOLUTIONS)
+  {
+    ROS_WARN_ONCE_NAMED("ikfast", "IKFast found %d solutions, only the first %d are used", numsol,
+                        MAX_IKFAST_SOLUTIONS);
+    numsol = MAX_IKFAST_SOLUTIONS;
+  }
+  sols.resize(num_joints_, numsol);
+
+  // IKFast56/61
+  IkReal vsolfree[MAX_IKFAST_JOINTS];
+  for (int s = 0; s < numsol; ++s)
+  {
+    const IkSolutionBase<IkReal>& sol = solutions.GetSolution(s);
+    sol.GetSolution(sols.col(s).data(), sol.GetFree().size() > 0 ? vsolfree : NULL);
+  }
+  return numsol;
+}
+
+int IKFastKinematicsPlugin::filterSolutions(SolutionMatrix& sols, const double* seed,
+                                            const double* consistency_limits) const
+{
+  int kept = 0;
+  for (int s = 0; s < sols.cols(); ++s)
+  {
+    // whole-vector comparisons, which Eigen vectorizes
+    if ((sols.col(s).array() < joint_lower_bounds_.array()).any() ||
+        (sols.col(s).array() > joint_upper_bounds_.array()).any())
+      continue;
+    if (consistency_limits)
+    {
+      Eigen::Map<const Eigen::VectorXd> seed_state(seed, num_joints_);
+      Eigen::Map<const Eigen::VectorXd> limits(consistency_limits, num_joints_);
+      if (((sols.col(s) - seed_state).array().abs() > limits.array()).any())
+        continue;
+    }
+    if (kept != s)
+      sols.col(kept) = sols.col(s);
+    ++kept;
+  }
+  ROS_DEBUG_STREAM_NAMED("ikfast", kept << " of " << sols.cols() << " solutions are within the limits");
+  sols.conservativeResize(Eigen::NoChange, kept);
+  return kept;
+}
+
 double IKFastKinematicsPlugin::harmonize(const std::vector<double>& ik_seed_state, std::vector<double>& solution) const
 {
   double dist_sqr = 0;
@@ -899,72 +1022,49 @@ bool IKFastKinematicsPlugin::searchPositionIK(const geometry_msgs::Pose& ik_pose
   std::vector<double> best_solution;
   int nattempts = 0, nvalid = 0;
 
+  IkSolutionList<IkReal> solutions;
+  SolutionMatrix sols;
+  Eigen::Map<const Eigen::VectorXd> seed(&ik_seed_state[0], num_joints_);
   while (true)
   {
-    IkSolutionList<IkReal> solutions;
     int numsol = solve(frame, vfree, solutions);
 
     ROS_DEBUG_STREAM_NAMED("ikfast", "Found " << numsol << " solutions from IKFast");
 
     // ROS_INFO("%f",vfree[0]);
 
-    if (numsol > 0)
+    nattempts += getSolutions(solutions, numsol, sols);
+    filterSolutions(sols, NULL, NULL);
+    for (int s = 0; s < sols.cols(); ++s)
     {
-      for (int s = 0; s < numsol; ++s)
+      solution.assign(sols.col(s).data(), sols.col(s).data() + num_joints_);
+
+      // This solution is within joint limits, now check if in collision (if callback provided)
+      if (!solution_callback.empty())
+      {
+        solution_callback(ik_pose, solution, error_code);
+      }
+      else
       {
-        nattempts++;
-        std::vector<double> sol;
-        getSolution(solutions, s, sol);
+        error_code.val = error_code.SUCCESS;
+      }
 
-        bool obeys_limits = true;
-        for (unsigned int i = 0; i < sol.size(); i++)
-        {
-          if (joint_has_limits_vector_[i] && (sol[i] < joint_min_vector_[i] || sol[i] > joint_max_vector_[i]))
-          {
-            obeys_limits = false;
-            break;
-          }
-          // ROS_INFO_STREAM_NAMED("ikfast","Num " << i << " value " << sol[i] << " has limits " <<
-          // joint_has_limits_vector_[i] << " " << joint_min_vector_[i] << " " << joint_max_vector_[i]);
-        }
-        if (obeys_limits)
+      if (error_code.val == error_code.SUCCESS)
+      {
+        nvalid++;
+        if (search_mode & OPTIMIZE_MAX_JOINT)
         {
-          getSolution(solutions, s, solution);
-
-          // This solution is within joint limits, now check if in collision (if callback provided)
-          if (!solution_callback.empty())
-          {
-            solution_callback(ik_pose, solution, error_code);
-          }
-          else
+          // Costs for solution: Largest joint motion
+          double costs = (sols.col(s) - seed).cwiseAbs().maxCoeff();
+          if (costs < best_costs || best_costs == -1.0)
           {
-            error_code.val = error_code.SUCCESS;
-          }
-
-          if (error_code.val == error_code.SUCCESS)
-          {
-            nvalid++;
-            if (search_mode & OPTIMIZE_MAX_JOINT)
-            {
-              // Costs for solution: Largest joint motion
-              double costs = 0.0;
-              for (unsigned int i = 0; i < solution.size(); i++)
-              {
-                double d = fabs(ik_seed_state[i] - solution[i]);
-                if (d > costs)
-                  costs = d;
-              }
-              if (costs < best_costs || best_costs == -1.0)
-              {
-                best_costs = costs;
-                best_solution = solution;
-              }
-            }
-            else
-              // Return first feasible solution
-              return true;
+            best_costs = costs;
+            best_solution = solution;
           }
         }
+        else
+          // Return first feasible solution
+          return true;
       }
     }
 
@@ -1022,48 +1122,109 @@ bool IKFastKinematicsPlugin::getPositionIK(const geometry_msgs::Pose& ik_pose, c
 
   ROS_DEBUG_STREAM_NAMED("ikfast", "Found " << numsol << " solutions from IKFast");
 
-  if (numsol)
+  if (getFirstSolutionWithinLimits(solutions, numsol, solution))
   {
-    for (int s = 0; s < numsol; ++s)
-    {
-      std::vector<double> sol;
-      getSolution(solutions, s, sol);
-      ROS_DEBUG_NAMED("ikfast", "Sol %d: %e   %e   %e   %e   %e   %e", s, sol[0], sol[1], sol[2], sol[3], sol[4],
-                      sol[5]);
-
-      bool obeys_limits = true;
-      for (unsigned int i = 0; i < sol.size(); i++)
-      {
-        // Add tolerance to limit check
-        if (joint_has_limits_vector_[i] && ((sol[i] < (joint_min_vector_[i] - LIMIT_TOLERANCE)) ||
-                                            (sol[i] > (joint_max_vector_[i] + LIMIT_TOLERANCE))))
-        {
-          // One element of solution is not within limits
-          obeys_limits = false;
-          ROS_DEBUG_STREAM_NAMED("ikfast", "Not in limits! " << i << " value " << sol[i] << " has limit: "
-                                                             << joint_has_limits_vector_[i] << "  being  "
-                                                             << joint_min_vector_[i] << " to " << joint_max_vector_[i]);
-          break;
-        }
-      }
-      if (obeys_limits)
-      {
-        // All elements of solution obey limits
-        getSolution(solutions, s, solution);
-        error_code.val = moveit_msgs::MoveItErrorCodes::SUCCESS;
-        return true;
-      }
-    }
+    error_code.val = moveit_msgs::MoveItErrorCodes::SUCCESS;
+    return true;
   }
-  else
-  {
+  if (!numsol)
     ROS_DEBUG_STREAM_NAMED("ikfast", "No IK solution");
-  }
 
   error_code.val = moveit_msgs::MoveItErrorCodes::NO_IK_SOLUTION;
   return false;
 }
 
+bool IKFastKinematicsPlugin::getFirstSolutionWithinLimits(const IkSolutionList<IkReal>& solutions, int numsol,
+                                                          std::vector<double>& solution) const
+{
+  SolutionMatrix sols;
+  getSolutions(solutions, numsol, sols);
+  if (!filterSolutions(sols, NULL, NULL))
+    return false;
+  solution.assign(sols.col(0).data(), sols.col(0).data() + num_joints_);
+  return true;
+}
+
+std::size_t IKFastKinematicsPlugin::getAllSolutions(const Eigen::Affine3d& pose,
+                                                    const std::vector<double>& ik_seed_state,
+                                                    const std::vector<double>& consistency_limits,
+                                                    std::vector<double>& solutions) const
+{
+  solutions.clear();
+  if (!active_)
+  {
+    ROS_ERROR("kinematics not active");
+    return 0;
+  }
+  if (ik_seed_state.size() != num_joints_ || (!consistency_limits.empty() && consistency_limits.size() != num_joints_))
+  {
+    ROS_ERROR_STREAM_NAMED("ikfast", "Seed state and consistency limits must have size " << num_joints_);
+    return 0;
+  }
+
+  std::vector<double> vfree(free_params_.size());
+  for (std::size_t i = 0; i < free_params_.size(); ++i)
+    vfree[i] = ik_seed_state[free_params_[i]];
+
+  KDL::Frame frame;
+  poseEigenToKDL(pose, frame);
+
+  IkSolutionList<IkReal> ik_solutions;
+  SolutionMatrix sols;
+  getSolutions(ik_solutions, solve(frame, vfree, ik_solutions), sols);
+  int count = filterSolutions(sols, &ik_seed_state[0], consistency_limits.empty() ? NULL : &consistency_limits[0]);
+  solutions.assign(sols.data(), sols.data() + count * num_joints_);
+  return count;
+}
+
+std::size_t IKFastKinematicsPlugin::getPositionIKBatch(const EigenSTL::vector_Affine3d& poses,
+                                                       const std::vector<double>& seeds,
+                                                       std::vector<std::vector<double> >& solutions,
+                                                       std::vector<moveit_msgs::MoveItErrorCodes>& error_codes,
+                                                       const kinematics::KinematicsQueryOptions& options) const
+{
+  solutions.assign(poses.size(), std::vector<double>());
+  error_codes.resize(poses.size());
+  for (std::size_t i = 0; i < error_codes.size(); ++i)
+    error_codes[i].val = moveit_msgs::MoveItErrorCodes::NO_IK_SOLUTION;
+  if (!active_)
+  {
+    ROS_ERROR("kinematics not active");
+    return 0;
+  }
+
+  const std::size_t dimension = num_joints_;
+  bool seed_per_pose = poses.size() > 1 && seeds.size() == dimension * poses.size();
+  if (!seed_per_pose && seeds.size() != dimension)
+  {
+    ROS_ERROR_STREAM_NAMED("ikfast", "Seeds must have size " << dimension << " or " << dimension * poses.size()
+                                                             << " instead of size " << seeds.size());
+    return 0;
+  }
+
+  // the closed-form solver is cheap; skip the per-pose message conversions and reuse the solution list
+  IkSolutionList<IkReal> ik_solutions;
+  std::vector<double> vfree(free_params_.size());
+  std::size_t solved = 0;
+  for (std::size_t p = 0; p < poses.size(); ++p)
+  {
+    std::size_t offset = seed_per_pose ? p * dimension : 0;
+    for (std::size_t i = 0; i < free_params_.size(); ++i)
+      vfree[i] = seeds[offset + free_params_[i]];
+
+    KDL::Frame frame;
+    poseEigenToKDL(poses[p], frame);
+
+    int numsol = solve(frame, vfree, ik_solutions);
+    if (getFirstSolutionWithinLimits(ik_solutions, numsol, solutions[p]))
+    {
+      error_codes[p].val = moveit_msgs::MoveItErrorCodes::SUCCESS;
+      ++solved;
+    }
+  }
+  return solved;
+}
+
 bool IKFastKinematicsPlugin::getPositionIK(const std::vector<geometry_msgs::Pose>& ik_poses,
                                            const std::vector<double>& ik_seed_state,
                                            std::vector<std::vector<double> >& solutions,
@@ -1159,37 +1320,15 @@ bool IKFastKinematicsPlugin::getPositionIK(const std::vector<geometry_msgs::Pose
     /*
       Iterating through all solution sets and storing those that do not exceed joint limits.
     */
+    SolutionMatrix sols;
     for (unsigned int r = 0; r < solution_set.size(); r++)
     {
-      ik_solutions = solution_set[r];
-      numsol = ik_solutions.GetNumSolutions();
-      for (int s = 0; s < numsol; ++s)
-      {
-        std::vector<double> sol;
-        getSolution(ik_solutions, s, sol);
-
-        bool obeys_limits = true;
-        for (unsigned int i = 0; i < sol.size(); i++)
-        {
-          // Add tolerance to limit check
-          if (joint_has_limits_vector_[i] && ((sol[i] < (joint_min_vector_[i] - LIMIT_TOLERANCE)) ||
-                                              (sol[i] > (joint_max_vector_[i] + LIMIT_TOLERANCE))))
-          {
-            // One element of solution is not within limits
-            obeys_limits = false;
-            ROS_DEBUG_STREAM_NAMED(
-                "ikfast", "Not in limits! " << i << " value " << sol[i] << " has limit: " << joint_has_limits_vector_[i]
-                                            << "  being  " << joint_min_vector_[i] << " to " << joint_max_vector_[i]);
-            break;
-          }
-        }
-        if (obeys_limits)
-        {
-          // All elements of solution obey limits
-          solutions_found = true;
-          solutions.push_back(sol);
-        }
-      }
+      getSolutions(solution_set[r], solution_set[r].GetNumSolutions(), sols);
+      int count = filterSolutions(sols, NULL, NULL);
+      for (int s = 0; s < count; ++s)
+        solutions.push_back(std::vector<double>(sols.col(s).data(), sols.col(s).data() + num_joints_));
+      if (count > 0)
+        solutions_found = true;
     }
 
     if (solutions_found)
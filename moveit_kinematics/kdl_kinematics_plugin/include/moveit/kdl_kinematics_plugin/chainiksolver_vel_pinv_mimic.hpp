@@ -42,11 +42,18 @@ namespace KDL
  * KDL::Chain. It uses a svd-calculation based on householders
  * rotations.
  *
+ * For (reduced) chains of at most MAX_FIXED_SIZE_DOF active joints, the SVD is replaced by a damped least squares
+ * solve on matrices sized at compile time, using an LDLT decomposition of the damped normal equations. With the
+ * damping set to eps^2 this gives the pseudo inverse solution, without allocating and several times faster.
+ *
  * @ingroup KinematicFamily
  */
 class ChainIkSolverVel_pinv_mimic : public ChainIkSolverVel
 {
 public:
+  /** The largest number of active joints the fixed-size solver is instantiated for */
+  static const unsigned int MAX_FIXED_SIZE_DOF = 7;
+
   /**
    * Constructor of the solver
    *
@@ -115,6 +122,9 @@ private:
   bool jacToJacReduced(const Jacobian& jac, Jacobian& jac_mimic);
   bool jacToJacLocked(const Jacobian& jac, Jacobian& jac_locked);
 
+  // Map the solution of the locked case onto qdot_out
+  int scatterLockedSolution(JntArray& qdot_out);
+
   const Chain chain;
   ChainJntToJacSolver jnt2jac;
 
@@ -169,6 +179,10 @@ private:
   std::vector<unsigned int> locked_joints_map_index;
   unsigned int num_redundant_joints;
   bool redundant_joints_locked;
+
+  // Whether the jacobians of the full and of the locked case are small enough for the fixed-size solver
+  bool fixed_size;
+  bool fixed_size_locked;
 };
 }
 #endif
@@ -40,6 +40,7 @@
 // ROS
 #include <ros/ros.h>
 #include <random_numbers/random_numbers.h>
+#include <boost/thread/mutex.hpp>
 
 // ROS msgs
 #include <geometry_msgs/PoseStamped.h>
@@ -102,9 +103,38 @@ public:
                    const IKCallbackFn& solution_callback, moveit_msgs::MoveItErrorCodes& error_code,
                    const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions()) const;
 
+  /**
+   * @brief Eigen version of searchPositionIK(). Once the solvers of the calling thread have been built by an earlier
+   * query, this does not allocate memory (unless the solution callback does).
+   */
+  virtual bool
+  searchPositionIK(const Eigen::Affine3d& ik_pose, const Eigen::Ref<const Eigen::VectorXd>& ik_seed_state,
+                   double timeout, Eigen::Ref<Eigen::VectorXd> solution, const IKCallbackFn& solution_callback,
+                   moveit_msgs::MoveItErrorCodes& error_code,
+                   const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions()) const;
+
+  /**
+   * @brief Solve IK for many poses at once, reusing the solvers across poses. The poses are spread over the search
+   * threads (see setSearchThreadCount()); each pose is solved with the default timeout.
+   */
+  virtual std::size_t
+  getPositionIKBatch(const EigenSTL::vector_Affine3d& poses, const std::vector<double>& seeds,
+                     std::vector<std::vector<double> >& solutions,
+                     std::vector<moveit_msgs::MoveItErrorCodes>& error_codes,
+                     const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions()) const;
+
   virtual bool getPositionFK(const std::vector<std::string>& link_names, const std::vector<double>& joint_angles,
                              std::vector<geometry_msgs::Pose>& poses) const;
 
+  /** @brief Eigen version of getPositionFK() for the tip frame, which does not allocate memory */
+  virtual bool getPositionFK(const Eigen::Ref<const Eigen::VectorXd>& joint_angles, Eigen::Affine3d& tip_pose) const;
+
+  /** @brief Start a session that keeps its own solvers and, for each pose, runs them once from the last solution,
+   * without random restarts */
+  virtual kinematics::IKTrackingSessionPtr
+  beginTracking(const std::vector<double>& ik_seed_state,
+                const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions()) const;
+
   virtual bool initialize(const std::string& robot_description, const std::string& group_name,
                           const std::string& base_name, const std::string& tip_name, double search_discretization);
 
@@ -143,6 +173,48 @@ protected:
   virtual bool setRedundantJoints(const std::vector<unsigned int>& redundant_joint_indices);
 
 private:
+  /** @brief The input and the outcome of one call to searchPositionIK(), shared by its workers */
+  struct IKSearch;
+
+  /** @brief The KDL solvers and buffers used by one worker; they can be reused for any number of searches */
+  struct IKSolvers;
+
+  /** @brief The session returned by beginTracking() */
+  class TrackingSession;
+
+  /** @brief The input and the outcome of one call to getPositionIKBatch(), shared by its workers */
+  struct IKBatch;
+
+  /** @brief Threads that run the workers of searches and batches; they are started when first needed and kept for
+   *  later queries */
+  class WorkerPool;
+
+  /** @brief Run random restarts of the IK solver until a solution is accepted by the solution callback, the search
+   *  times out or another worker of the same search succeeds. Worker 0 starts from the seed state, the others from
+   *  random configurations. With more than one search thread (see setSearchThreadCount()) one worker runs per
+   *  thread, each with its own \e solvers. */
+  void searchPositionIKWorker(unsigned int worker, IKSolvers* solvers, IKSearch* search) const;
+
+  /** @brief Run the workers of \e search. Worker 0 first tries the seed state once, in the calling thread; only if
+   *  that fails do the other workers join it, on the threads of the worker pool. Worker 0 uses \e solvers; on success
+   *  the solution is left in the buffer of \e solvers. */
+  void runSearch(IKSolvers* solvers, IKSearch* search) const;
+
+  /** @brief Add a finished search to the search statistics, unless they are disabled */
+  void recordSearchStatistics(const IKSearch& search) const;
+
+  /** @brief Set \e error_code from the outcome of \e search and return whether it succeeded */
+  bool checkSearchResult(const IKSearch& search, moveit_msgs::MoveItErrorCodes& error_code) const;
+
+  /** @brief Take solvers from the pool, constructing new ones only if all are in use */
+  std::shared_ptr<IKSolvers> acquireSolvers() const;
+
+  /** @brief Return solvers taken by acquireSolvers() to the pool */
+  void releaseSolvers(const std::shared_ptr<IKSolvers>& solvers) const;
+
+  /** @brief Solve the poses first, first + stride, first + 2 * stride, ... of a batch */
+  void getPositionIKBatchWorker(std::size_t first, std::size_t stride, IKBatch* batch) const;
+
   bool timedOut(const ros::WallTime& start_time, double duration) const;
 
   /** @brief Check whether the solution lies within the consistency limit of the seed state
@@ -160,7 +232,7 @@ private:
 
   int getKDLSegmentIndex(const std::string& name) const;
 
-  void getRandomConfiguration(KDL::JntArray& jnt_array, bool lock_redundancy) const;
+  void getRandomConfiguration(IKSolvers& solvers, KDL::JntArray& jnt_array, bool lock_redundancy) const;
 
   /** @brief Get a random configuration within joint limits close to the seed state
    *  @param seed_state Seed state
@@ -169,8 +241,9 @@ private:
    * [seed_state(redundancy_limit)-consistency_limit,seed_state(redundancy_limit)+consistency_limit]
    *  @param jnt_array Returned random configuration
    */
-  void getRandomConfiguration(const KDL::JntArray& seed_state, const std::vector<double>& consistency_limits,
-                              KDL::JntArray& jnt_array, bool lock_redundancy) const;
+  void getRandomConfiguration(IKSolvers& solvers, const KDL::JntArray& seed_state,
+                              const std::vector<double>& consistency_limits, KDL::JntArray& jnt_array,
+                              bool lock_redundancy) const;
 
   bool isRedundantJoint(unsigned int index) const;
 
@@ -186,7 +259,11 @@ private:
 
   KDL::JntArray joint_min_, joint_max_; /** Joint limits */
 
-  mutable random_numbers::RandomNumberGenerator random_number_generator_;
+  /** @brief Solvers that are not in use, kept to avoid rebuilding them (and allocating memory) for every query */
+  mutable std::vector<std::shared_ptr<IKSolvers> > solver_pool_;
+  mutable boost::mutex solver_pool_lock_;
+
+  std::shared_ptr<WorkerPool> worker_pool_;
 
   robot_model::RobotModelPtr robot_model_;
 
@@ -25,9 +25,68 @@
 
 #include <moveit/kdl_kinematics_plugin/chainiksolver_vel_pinv_mimic.hpp>
 #include <ros/console.h>
+#include <Eigen/Cholesky>
 
 namespace KDL
 {
+namespace
+{
+// Damped least squares solution of jac * qdot = v_in for the first Rows rows and Cols columns of jac, on matrices
+// sized at compile time. Redundant chains solve the Rows x Rows system for the minimum norm solution, the others the
+// Cols x Cols normal equations.
+template <int Rows, int Cols>
+void solveDampedFixedSize(const Eigen::Matrix<double, 6, Eigen::Dynamic>& jac, const Twist& v_in, double damping,
+                          Eigen::VectorXd& qdot)
+{
+  const Eigen::Matrix<double, Rows, Cols> j = jac.topLeftCorner<Rows, Cols>();
+  Eigen::Matrix<double, Rows, 1> v;
+  for (int i = 0; i < Rows; ++i)
+    v(i) = v_in(i);
+  if (Cols >= Rows)
+  {
+    Eigen::Matrix<double, Rows, Rows> a = j * j.transpose();
+    a.diagonal().array() += damping;
+    qdot = j.transpose() * a.ldlt().solve(v);
+  }
+  else
+  {
+    Eigen::Matrix<double, Cols, Cols> a = j.transpose() * j;
+    a.diagonal().array() += damping;
+    qdot = a.ldlt().solve(j.transpose() * v);
+  }
+}
+
+template <int Rows>
+void solveDampedFixedSize(const Eigen::Matrix<double, 6, Eigen::Dynamic>& jac, unsigned int cols, const Twist& v_in,
+                          double damping, Eigen::VectorXd& qdot)
+{
+  switch (cols)
+  {
+    case 1:
+      solveDampedFixedSize<Rows, 1>(jac, v_in, damping, qdot);
+      break;
+    case 2:
+      solveDampedFixedSize<Rows, 2>(jac, v_in, damping, qdot);
+      break;
+    case 3:
+      solveDampedFixedSize<Rows, 3>(jac, v_in, damping, qdot);
+      break;
+    case 4:
+      solveDampedFixedSize<Rows, 4>(jac, v_in, damping, qdot);
+      break;
+    case 5:
+      solveDampedFixedSize<Rows, 5>(jac, v_in, damping, qdot);
+      break;
+    case 6:
+      solveDampedFixedSize<Rows, 6>(jac, v_in, damping, qdot);
+      break;
+    case 7:
+      solveDampedFixedSize<Rows, 7>(jac, v_in, damping, qdot);
+      break;
+  }
+}
+}
+
 ChainIkSolverVel_pinv_mimic::ChainIkSolverVel_pinv_mimic(const Chain& _chain, int _num_mimic_joints,
                                                          int _num_redundant_joints, bool _position_ik, double _eps,
                                                          int _maxiter)
@@ -64,6 +123,8 @@ ChainIkSolverVel_pinv_mimic::ChainIkSolverVel_pinv_mimic(const Chain& _chain, in
   , tmp_translate_locked(VectorXd::Zero(chain.getNrOfJoints() - _num_mimic_joints - _num_redundant_joints))
   , num_redundant_joints(_num_redundant_joints)
   , redundant_joints_locked(false)
+  , fixed_size(chain.getNrOfJoints() - _num_mimic_joints <= MAX_FIXED_SIZE_DOF)
+  , fixed_size_locked(chain.getNrOfJoints() - _num_mimic_joints - _num_redundant_joints <= MAX_FIXED_SIZE_DOF)
 {
   mimic_joints_.resize(chain.getNrOfJoints());
   for (std::size_t i = 0; i < mimic_joints_.size(); ++i)
@@ -153,6 +214,20 @@ int ChainIkSolverVel_pinv_mimic::CartToJntRedundant(const JntArray& q_in, const
   // iterations "maxiter", put the results in "U", "S" and "V"
   // jac = U*S*Vt
 
+  unsigned int columns = chain.getNrOfJoints() - num_mimic_joints - num_redundant_joints;
+  if (fixed_size_locked)
+  {
+    if (!position_ik)
+      solveDampedFixedSize<6>(jac_locked.data, columns, v_in, eps * eps, tmp_locked);
+    else
+      solveDampedFixedSize<3>(jac_locked.data, columns, v_in, eps * eps, tmp_locked);
+    if (num_mimic_joints > 0)
+      qdot_out_reduced_locked.data = tmp_locked;
+    else
+      qdot_out_locked.data = tmp_locked;
+    return scatterLockedSolution(qdot_out);
+  }
+
   int ret;
   if (!position_ik)
     ret = svd_eigen_HH(jac_locked.data, U_locked, S_locked, V_locked, tmp_locked, maxiter);
@@ -211,7 +286,17 @@ int ChainIkSolverVel_pinv_mimic::CartToJntRedundant(const JntArray& q_in, const
       qdot_out_locked(i) = sum;
   }
   ROS_DEBUG_STREAM_NAMED("kdl", "Solution:");
+  scatterLockedSolution(qdot_out);
+
+  // Reset the flag
+  // redundant_joints_locked = false;
+  // return the return value of the svd decomposition
+  return ret;
+}
 
+int ChainIkSolverVel_pinv_mimic::scatterLockedSolution(JntArray& qdot_out)
+{
+  unsigned int i;
   if (num_mimic_joints > 0)
   {
     for (i = 0; i < chain.getNrOfJoints() - num_mimic_joints - num_redundant_joints; ++i)
@@ -230,10 +315,7 @@ int ChainIkSolverVel_pinv_mimic::CartToJntRedundant(const JntArray& q_in, const
       qdot_out(locked_joints_map_index[i]) = qdot_out_locked(i);
     }
   }
-  // Reset the flag
-  // redundant_joints_locked = false;
-  // return the return value of the svd decomposition
-  return ret;
+  return 0;
 }
 
 int ChainIkSolverVel_pinv_mimic::CartToJnt(const JntArray& q_in, const Twist& v_in, JntArray& qdot_out)
@@ -256,6 +338,19 @@ int ChainIkSolverVel_pinv_mimic::CartToJnt(const JntArray& q_in, const Twist& v_
   // iterations "maxiter", put the results in "U", "S" and "V"
   // jac = U*S*Vt
 
+  if (fixed_size)
+  {
+    Eigen::VectorXd& qdot = num_mimic_joints > 0 ? qdot_out_reduced.data : qdot_out.data;
+    if (!position_ik)
+      solveDampedFixedSize<6>(jac_reduced.data, jac_reduced.columns(), v_in, eps * eps, qdot);
+    else
+      solveDampedFixedSize<3>(jac_reduced.data, jac_reduced.columns(), v_in, eps * eps, qdot);
+    if (num_mimic_joints > 0)
+      for (unsigned int i = 0; i < chain.getNrOfJoints(); ++i)
+        qdot_out(i) = qdot_out_reduced(mimic_joints_[i].map_index) * mimic_joints_[i].multiplier;
+    return 0;
+  }
+
   int ret;
   if (!position_ik)
     ret = svd.calculate(jac_reduced, U, S, V, maxiter);
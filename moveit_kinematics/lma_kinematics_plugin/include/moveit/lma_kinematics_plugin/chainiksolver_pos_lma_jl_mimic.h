@@ -39,6 +39,7 @@
 
 #include "kdl/chainiksolverpos_lma.hpp"  // Solver for the inverse position kinematics that uses Levenberg-Marquardt.
 #include "kdl/chainfksolver.hpp"
+#include "kdl/chainjnttojacsolver.hpp"
 
 #include <moveit/lma_kinematics_plugin/joint_mimic.h>
 
@@ -84,6 +85,21 @@ public:
 
   bool setMimicJoints(const std::vector<lma_kinematics_plugin::JointMimic>& mimic_joints);
 
+  /**
+   * Solve chains of at most MAX_FIXED_SIZE_DOF joints with the Levenberg-Marquardt iteration of
+   * ChainIkSolverPos_LMA run on matrices sized at compile time, instead of calling iksolver. The damped normal
+   * equations are solved with an LDLT decomposition rather than an SVD of the jacobian, which gives the same steps
+   * without allocating in the iterations.
+   *
+   * @param weights the task space weights iksolver was constructed with
+   *
+   * @return false if the chain is too long, in which case iksolver keeps being used
+   */
+  bool enableFixedSizeSolver(const Eigen::Matrix<double, 6, 1>& weights);
+
+  /** The largest number of joints the fixed-size solver is instantiated for */
+  static const unsigned int MAX_FIXED_SIZE_DOF = 7;
+
 private:
   const Chain chain;
   JntArray q_min;        // These are the limits for the "reduced" state consisting of only active DOFs
@@ -104,7 +120,13 @@ private:
   void qMimicToq(const JntArray& q, JntArray& q_result);  // Convert from the "full" state to the "reduced" state
   void harmonize(JntArray& q_out);                        // Puts the angles within [-2PI, 2PI]
   bool obeysLimits(const KDL::JntArray& q_out);           // Checks that a set of joint angles obey the urdf limits
+  int solveFixedSize(const JntArray& q_init, const Frame& p_in, JntArray& q_out);  // See enableFixedSizeSolver()
   bool position_ik;
+
+  ChainJntToJacSolver jnt2jac;
+  Jacobian jac;
+  Eigen::Matrix<double, 6, 1, Eigen::DontAlign> weights;
+  bool fixed_size;
 };
 }
 
@@ -36,9 +36,88 @@
 
 #include "moveit/lma_kinematics_plugin/chainiksolver_pos_lma_jl_mimic.h"
 #include <ros/console.h>
+#include <Eigen/Cholesky>
+#include <algorithm>
 
 namespace KDL
 {
+namespace
+{
+// The same defaults as ChainIkSolverPos_LMA
+const double LMA_EPS_JOINTS = 1e-15;
+const double LMA_INITIAL_LAMBDA = 10.0;
+
+inline void computeWeightedError(const Eigen::Matrix<double, 6, 1, Eigen::DontAlign>& weights, const Frame& f,
+                                 const Frame& p_in, Eigen::Matrix<double, 6, 1>& delta)
+{
+  Twist t = diff(f, p_in);
+  for (int i = 0; i < 6; ++i)
+    delta(i) = weights(i) * t(i);
+}
+
+// Levenberg-Marquardt iteration of ChainIkSolverPos_LMA for a chain of N joints; q_out holds the current estimate
+// and q_new the candidate step
+template <int N>
+int solveLMAFixedSize(ChainFkSolverPos& fksolver, ChainJntToJacSolver& jnt2jac, Jacobian& jac_buffer,
+                      const Eigen::Matrix<double, 6, 1, Eigen::DontAlign>& weights, const JntArray& q_init,
+                      const Frame& p_in, JntArray& q_out, JntArray& q_new, unsigned int maxiter, double eps)
+{
+  Frame f;
+  Eigen::Matrix<double, 6, 1> delta, delta_new;
+  Eigen::Matrix<double, 6, N> jac;
+  Eigen::Matrix<double, N, N> a;
+  Eigen::Matrix<double, N, 1> grad, diffq;
+
+  q_out.data = q_init.data;
+  fksolver.JntToCart(q_out, f);
+  computeWeightedError(weights, f, p_in, delta);
+  double delta_norm = delta.norm();
+  if (delta_norm < eps)
+    return 0;
+  jnt2jac.JntToJac(q_out, jac_buffer);
+  jac = weights.asDiagonal() * jac_buffer.data;
+
+  double lambda = LMA_INITIAL_LAMBDA;
+  double v = 2.0;
+  for (unsigned int i = 0; i < maxiter; ++i)
+  {
+    grad = jac.transpose() * delta;
+    a = jac.transpose() * jac;
+    a.diagonal().array() += lambda;
+    diffq = a.ldlt().solve(grad);
+    if (diffq.template lpNorm<Eigen::Infinity>() < LMA_EPS_JOINTS)
+      return -101;  // the joint increment became too small
+    if (grad.squaredNorm() < LMA_EPS_JOINTS * LMA_EPS_JOINTS)
+      return -100;  // the gradient became too small
+
+    q_new.data = q_out.data + diffq;
+    fksolver.JntToCart(q_new, f);
+    computeWeightedError(weights, f, p_in, delta_new);
+    double delta_new_norm = delta_new.norm();
+    double rho = (delta_norm * delta_norm - delta_new_norm * delta_new_norm) / diffq.dot(lambda * diffq + grad);
+    if (rho > 0)
+    {
+      q_out.data = q_new.data;
+      delta = delta_new;
+      delta_norm = delta_new_norm;
+      if (delta_norm < eps)
+        return 0;
+      jnt2jac.JntToJac(q_out, jac_buffer);
+      jac = weights.asDiagonal() * jac_buffer.data;
+      double t = 2 * rho - 1;
+      lambda *= std::max(1 / 3.0, 1 - t * t * t);
+      v = 2.0;
+    }
+    else
+    {
+      lambda *= v;
+      v *= 2;
+    }
+  }
+  return -5;  // the maximum number of iterations was exceeded
+}
+}
+
 ChainIkSolverPos_LMA_JL_Mimic::ChainIkSolverPos_LMA_JL_Mimic(const Chain& _chain, const JntArray& _q_min,
                                                              const JntArray& _q_max, ChainFkSolverPos& _fksolver,
                                                              ChainIkSolverPos_LMA& _iksolver, unsigned int _maxiter,
@@ -55,6 +134,9 @@ ChainIkSolverPos_LMA_JL_Mimic::ChainIkSolverPos_LMA_JL_Mimic(const Chain& _chain
   , maxiter(_maxiter)
   , eps(_eps)
   , position_ik(_position_ik)
+  , jnt2jac(chain)
+  , jac(chain.getNrOfJoints())
+  , fixed_size(false)
 {
   mimic_joints.resize(chain.getNrOfJoints());
   for (std::size_t i = 0; i < mimic_joints.size(); ++i)
@@ -97,6 +179,39 @@ bool ChainIkSolverPos_LMA_JL_Mimic::setMimicJoints(const std::vector<lma_kinemat
   return true;
 }
 
+bool ChainIkSolverPos_LMA_JL_Mimic::enableFixedSizeSolver(const Eigen::Matrix<double, 6, 1>& _weights)
+{
+  if (chain.getNrOfJoints() == 0 || chain.getNrOfJoints() > MAX_FIXED_SIZE_DOF)
+    return false;
+  weights = _weights;
+  fixed_size = true;
+  return true;
+}
+
+int ChainIkSolverPos_LMA_JL_Mimic::solveFixedSize(const JntArray& q_init, const Frame& p_in, JntArray& q_out)
+{
+  if (q_init.rows() != chain.getNrOfJoints() || q_out.rows() != chain.getNrOfJoints())
+    return iksolver.CartToJnt(q_init, p_in, q_out);
+  switch (chain.getNrOfJoints())
+  {
+    case 1:
+      return solveLMAFixedSize<1>(fksolver, jnt2jac, jac, weights, q_init, p_in, q_out, q_temp, maxiter, eps);
+    case 2:
+      return solveLMAFixedSize<2>(fksolver, jnt2jac, jac, weights, q_init, p_in, q_out, q_temp, maxiter, eps);
+    case 3:
+      return solveLMAFixedSize<3>(fksolver, jnt2jac, jac, weights, q_init, p_in, q_out, q_temp, maxiter, eps);
+    case 4:
+      return solveLMAFixedSize<4>(fksolver, jnt2jac, jac, weights, q_init, p_in, q_out, q_temp, maxiter, eps);
+    case 5:
+      return solveLMAFixedSize<5>(fksolver, jnt2jac, jac, weights, q_init, p_in, q_out, q_temp, maxiter, eps);
+    case 6:
+      return solveLMAFixedSize<6>(fksolver, jnt2jac, jac, weights, q_init, p_in, q_out, q_temp, maxiter, eps);
+    case 7:
+      return solveLMAFixedSize<7>(fksolver, jnt2jac, jac, weights, q_init, p_in, q_out, q_temp, maxiter, eps);
+  }
+  return iksolver.CartToJnt(q_init, p_in, q_out);
+}
+
 void ChainIkSolverPos_LMA_JL_Mimic::qToqMimic(const JntArray& q, JntArray& q_result)
 {
   for (std::size_t i = 0; i < chain.getNrOfJoints(); ++i)
@@ -154,7 +269,7 @@ bool ChainIkSolverPos_LMA_JL_Mimic::obeysLimits(const KDL::JntArray& q_out)
 int ChainIkSolverPos_LMA_JL_Mimic::CartToJntAdvanced(const JntArray& q_init, const Frame& p_in, JntArray& q_out,
                                                      bool lock_redundant_joints)
 {
-  int ik_valid = iksolver.CartToJnt(q_init, p_in, q_out);
+  int ik_valid = fixed_size ? solveFixedSize(q_init, p_in, q_out) : iksolver.CartToJnt(q_init, p_in, q_out);
   harmonize(q_out);
 
   if (!obeysLimits(q_out))
@@ -36,6 +36,9 @@
 
 #include <moveit/lma_kinematics_plugin/lma_kinematics_plugin.h>
 #include <class_loader/class_loader.h>
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#include <atomic>
 
 #include <tf_conversions/tf_kdl.h>
 #include <kdl_parser/kdl_parser.hpp>
@@ -45,21 +48,215 @@
 #include <srdfdom/model.h>
 
 #include <moveit/rdf_loader/rdf_loader.h>
+#include <moveit/robot_state/random_number_generator.h>
 
 // register KDLKinematics as a KinematicsBase implementation
 CLASS_LOADER_REGISTER_CLASS(lma_kinematics_plugin::LMAKinematicsPlugin, kinematics::KinematicsBase)
 
 namespace lma_kinematics_plugin
 {
+struct LMAKinematicsPlugin::IKSearch
+{
+  IKSearch(const geometry_msgs::Pose& ik_pose, const KDL::Frame& pose_desired, const KDL::JntArray& jnt_seed_state,
+           const ros::WallTime& start_time, double timeout, const IKCallbackFn& solution_callback,
+           const std::vector<double>& consistency_limits, const kinematics::KinematicsQueryOptions& options)
+    : ik_pose_(ik_pose)
+    , pose_desired_(pose_desired)
+    , jnt_seed_state_(jnt_seed_state)
+    , start_time_(start_time)
+    , timeout_(timeout)
+    , solution_callback_(solution_callback)
+    , consistency_limits_(consistency_limits)
+    , options_(options)
+    , done_(false)
+    , setup_failed_(false)
+    , solution_(NULL)
+    , iterations_(0)
+  {
+  }
+
+  const geometry_msgs::Pose& ik_pose_;
+  KDL::Frame pose_desired_;
+  const KDL::JntArray& jnt_seed_state_;
+  ros::WallTime start_time_;
+  double timeout_;
+  const IKCallbackFn& solution_callback_;
+  const std::vector<double>& consistency_limits_;
+  const kinematics::KinematicsQueryOptions& options_;
+
+  boost::mutex lock_;  // serializes the calls to the solution callback
+  std::atomic<bool> done_;
+  bool setup_failed_;
+  const std::vector<double>* solution_;  // the buffer of the worker that found the solution
+  std::size_t iterations_;               // solver runs of all workers together, for the search statistics
+};
+
+namespace
+{
+// weights of the position and orientation errors used by the LMA solver
+Eigen::Matrix<double, 6, 1> getLMAWeights()
+{
+  Eigen::Matrix<double, 6, 1> L;
+  L(0) = 1;
+  L(1) = 1;
+  L(2) = 1;
+  L(3) = 0.01;
+  L(4) = 0.01;
+  L(5) = 0.01;
+  return L;
+}
+}
+
+struct LMAKinematicsPlugin::IKSolvers
+{
+  IKSolvers(const LMAKinematicsPlugin& plugin)
+    : fk_solver_(plugin.kdl_chain_)
+    , ik_solver_(plugin.kdl_chain_, getLMAWeights(), plugin.epsilon_, plugin.max_solver_iterations_)
+    , ik_solver_vel_(plugin.kdl_chain_, plugin.joint_model_group_->getMimicJointModels().size(),
+                     plugin.redundant_joint_indices_.size(), plugin.position_ik_)
+    , ik_solver_pos_(plugin.kdl_chain_, plugin.joint_min_, plugin.joint_max_, fk_solver_, ik_solver_,
+                     plugin.max_solver_iterations_, plugin.epsilon_, plugin.position_ik_)
+    , jnt_seed_state_(plugin.dimension_)
+    , jnt_pos_in_(plugin.dimension_)
+    , jnt_pos_out_(plugin.dimension_)
+    , solution_(plugin.dimension_)
+    , values_(plugin.dimension_)
+    , near_(plugin.dimension_)
+  {
+    ik_solver_vel_.setMimicJoints(plugin.mimic_joints_);
+    ik_solver_pos_.setMimicJoints(plugin.mimic_joints_);
+    ik_solver_pos_.enableFixedSizeSolver(getLMAWeights());
+    consistency_limits_mimic_.reserve(plugin.dimension_);
+  }
+
+  KDL::ChainFkSolverPos_recursive fk_solver_;
+  KDL::ChainIkSolverPos_LMA ik_solver_;
+  KDL::ChainIkSolverVel_pinv_mimic ik_solver_vel_;
+  KDL::ChainIkSolverPos_LMA_JL_Mimic ik_solver_pos_;
+
+  // buffers for the searches, so that they do not allocate memory
+  KDL::JntArray jnt_seed_state_;
+  KDL::JntArray jnt_pos_in_;
+  KDL::JntArray jnt_pos_out_;
+  std::vector<double> solution_;
+  std::vector<double> values_;
+  std::vector<double> near_;
+  std::vector<double> consistency_limits_mimic_;
+};
+
+namespace
+{
+void poseEigenToKDL(const Eigen::Affine3d& pose, KDL::Frame& frame)
+{
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    for (unsigned int j = 0; j < 3; ++j)
+      frame.M(i, j) = pose(i, j);
+    frame.p(i) = pose(i, 3);
+  }
+}
+
+void poseKDLToEigen(const KDL::Frame& frame, Eigen::Affine3d& pose)
+{
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    for (unsigned int j = 0; j < 3; ++j)
+      pose(i, j) = frame.M(i, j);
+    pose(i, 3) = frame.p(i);
+  }
+  pose.makeAffine();
+}
+}
+
+class LMAKinematicsPlugin::TrackingSession : public kinematics::IKTrackingSession
+{
+public:
+  TrackingSession(const LMAKinematicsPlugin& plugin, const std::vector<double>& ik_seed_state,
+                  const kinematics::KinematicsQueryOptions& options)
+    : plugin_(plugin), solvers_(plugin), setup_failed_(false)
+  {
+    if (!plugin.redundant_joint_indices_.empty() &&
+        !solvers_.ik_solver_vel_.setRedundantJointsMapIndex(plugin.redundant_joints_map_index_))
+    {
+      ROS_ERROR_NAMED("lma", "Could not set redundant joints");
+      setup_failed_ = true;
+    }
+    if (options.lock_redundant_joints)
+      solvers_.ik_solver_vel_.lockRedundantJoints();
+    reset(ik_seed_state);
+  }
+
+  virtual bool track(const Eigen::Affine3d& ik_pose, std::vector<double>& solution,
+                     moveit_msgs::MoveItErrorCodes& error_code)
+  {
+    if (setup_failed_)
+    {
+      error_code.val = error_code.NO_IK_SOLUTION;
+      return false;
+    }
+
+    // the solver converges in a few iterations from the last solution when the pose moved only a little
+    KDL::Frame pose_desired;
+    poseEigenToKDL(ik_pose, pose_desired);
+    if (solvers_.ik_solver_pos_.CartToJnt(solvers_.jnt_seed_state_, pose_desired, solvers_.jnt_pos_out_) >= 0)
+    {
+      solvers_.jnt_seed_state_ = solvers_.jnt_pos_out_;
+      solution.resize(plugin_.dimension_);
+      for (unsigned int i = 0; i < plugin_.dimension_; ++i)
+        solution[i] = solvers_.jnt_pos_out_(i);
+      error_code.val = error_code.SUCCESS;
+      return true;
+    }
+
+    error_code.val = error_code.NO_IK_SOLUTION;
+    return false;
+  }
+
+  virtual void reset(const std::vector<double>& seed)
+  {
+    for (unsigned int i = 0; i < plugin_.dimension_ && i < seed.size(); ++i)
+      solvers_.jnt_seed_state_(i) = seed[i];
+  }
+
+private:
+  const LMAKinematicsPlugin& plugin_;
+  IKSolvers solvers_;  // owned by the session, so that they stay warm between queries
+  bool setup_failed_;
+};
+
+struct LMAKinematicsPlugin::IKBatch
+{
+  IKBatch(const EigenSTL::vector_Affine3d& poses, const std::vector<double>& seeds, bool seed_per_pose,
+          std::vector<std::vector<double> >& solutions, std::vector<moveit_msgs::MoveItErrorCodes>& error_codes,
+          const kinematics::KinematicsQueryOptions& options)
+    : poses_(poses)
+    , seeds_(seeds)
+    , seed_per_pose_(seed_per_pose)
+    , solutions_(solutions)
+    , error_codes_(error_codes)
+    , options_(options)
+    , solved_(0)
+  {
+  }
+
+  const EigenSTL::vector_Affine3d& poses_;
+  const std::vector<double>& seeds_;
+  bool seed_per_pose_;
+  std::vector<std::vector<double> >& solutions_;
+  std::vector<moveit_msgs::MoveItErrorCodes>& error_codes_;
+  const kinematics::KinematicsQueryOptions& options_;
+  std::atomic<std::size_t> solved_;
+};
+
 LMAKinematicsPlugin::LMAKinematicsPlugin() : active_(false)
 {
 }
 
-void LMAKinematicsPlugin::getRandomConfiguration(KDL::JntArray& jnt_array, bool lock_redundancy) const
+void LMAKinematicsPlugin::getRandomConfiguration(IKSolvers& solvers, KDL::JntArray& jnt_array,
+                                                 bool lock_redundancy) const
 {
-  std::vector<double> jnt_array_vector(dimension_, 0.0);
-  state_->setToRandomPositions(joint_model_group_);
-  state_->copyJointGroupPositions(joint_model_group_, &jnt_array_vector[0]);
+  std::vector<double>& jnt_array_vector = solvers.values_;
+  joint_model_group_->getVariableRandomPositions(moveit::core::getThreadRandomNumberGenerator(), jnt_array_vector);
   for (std::size_t i = 0; i < dimension_; ++i)
   {
     if (lock_redundancy)
@@ -77,17 +274,18 @@ bool LMAKinematicsPlugin::isRedundantJoint(unsigned int index) const
   return false;
 }
 
-void LMAKinematicsPlugin::getRandomConfiguration(const KDL::JntArray& seed_state,
+void LMAKinematicsPlugin::getRandomConfiguration(IKSolvers& solvers, const KDL::JntArray& seed_state,
                                                  const std::vector<double>& consistency_limits,
                                                  KDL::JntArray& jnt_array, bool lock_redundancy) const
 {
-  std::vector<double> values(dimension_, 0.0);
-  std::vector<double> near(dimension_, 0.0);
+  std::vector<double>& values = solvers.values_;
+  std::vector<double>& near = solvers.near_;
   for (std::size_t i = 0; i < dimension_; ++i)
     near[i] = seed_state(i);
 
   // Need to resize the consistency limits to remove mimic joints
-  std::vector<double> consistency_limits_mimic;
+  std::vector<double>& consistency_limits_mimic = solvers.consistency_limits_mimic_;
+  consistency_limits_mimic.clear();
   for (std::size_t i = 0; i < dimension_; ++i)
   {
     if (!mimic_joints_[i].active)
@@ -95,7 +293,7 @@ void LMAKinematicsPlugin::getRandomConfiguration(const KDL::JntArray& seed_state
     consistency_limits_mimic.push_back(consistency_limits[i]);
   }
 
-  joint_model_group_->getVariableRandomPositionsNearBy(state_->getRandomNumberGenerator(), values, near,
+  joint_model_group_->getVariableRandomPositionsNearBy(moveit::core::getThreadRandomNumberGenerator(), values, near,
                                                        consistency_limits_mimic);
 
   for (std::size_t i = 0; i < dimension_; ++i)
@@ -282,6 +480,10 @@ bool LMAKinematicsPlugin::initialize(const std::string& robot_description, const
   joint_model_group_ = joint_model_group;
   max_solver_iterations_ = max_solver_iterations;
   epsilon_ = epsilon;
+  {
+    boost::mutex::scoped_lock slock(solver_pool_lock_);
+    solver_pool_.clear();
+  }
 
   active_ = true;
   ROS_DEBUG_NAMED("lma", "KDL solver initialized");
@@ -343,6 +545,10 @@ bool LMAKinematicsPlugin::setRedundantJoints(const std::vector<unsigned int>& re
 
   redundant_joints_map_index_ = redundant_joints_map_index;
   redundant_joint_indices_ = redundant_joints;
+
+  // pooled solvers were built for the previous set of redundant joints
+  boost::mutex::scoped_lock slock(solver_pool_lock_);
+  solver_pool_.clear();
   return true;
 }
 
@@ -460,72 +666,198 @@ bool LMAKinematicsPlugin::searchPositionIK(const geometry_msgs::Pose& ik_pose, c
     return false;
   }
 
-  KDL::JntArray jnt_seed_state(dimension_);
-  KDL::JntArray jnt_pos_in(dimension_);
-  KDL::JntArray jnt_pos_out(dimension_);
+  KDL::Frame pose_desired;
+  tf::poseMsgToKDL(ik_pose, pose_desired);
 
-  // Build Solvers
-  Eigen::Matrix<double, 6, 1> L;
-  L(0) = 1;
-  L(1) = 1;
-  L(2) = 1;
-  L(3) = 0.01;
-  L(4) = 0.01;
-  L(5) = 0.01;
+  ROS_DEBUG_STREAM_NAMED("lma", "searchPositionIK2: Position request pose is "
+                                    << ik_pose.position.x << " " << ik_pose.position.y << " " << ik_pose.position.z
+                                    << " " << ik_pose.orientation.x << " " << ik_pose.orientation.y << " "
+                                    << ik_pose.orientation.z << " " << ik_pose.orientation.w);
+  // Do the IK
+  std::shared_ptr<IKSolvers> solvers = acquireSolvers();
+  for (unsigned int i = 0; i < dimension_; i++)
+    solvers->jnt_seed_state_(i) = ik_seed_state[i];
+  IKSearch search(ik_pose, pose_desired, solvers->jnt_seed_state_, n1, timeout, solution_callback, consistency_limits,
+                  options);
+  runSearch(solvers.get(), &search);
+
+  bool found = checkSearchResult(search, error_code);
+  if (found)
+    solution = *search.solution_;
+  releaseSolvers(solvers);
+  return found;
+}
 
-  KDL::ChainFkSolverPos_recursive fk_solver(kdl_chain_);
-  KDL::ChainIkSolverPos_LMA ik_solver(kdl_chain_, L, epsilon_, max_solver_iterations_);
-  KDL::ChainIkSolverVel_pinv_mimic ik_solver_vel(kdl_chain_, joint_model_group_->getMimicJointModels().size(),
-                                                 redundant_joint_indices_.size(), position_ik_);
-  KDL::ChainIkSolverPos_LMA_JL_Mimic ik_solver_pos(kdl_chain_, joint_min_, joint_max_, fk_solver, ik_solver,
-                                                   max_solver_iterations_, epsilon_, position_ik_);
-  ik_solver_vel.setMimicJoints(mimic_joints_);
-  ik_solver_pos.setMimicJoints(mimic_joints_);
+bool LMAKinematicsPlugin::searchPositionIK(const Eigen::Affine3d& ik_pose,
+                                           const Eigen::Ref<const Eigen::VectorXd>& ik_seed_state, double timeout,
+                                           Eigen::Ref<Eigen::VectorXd> solution,
+                                           const IKCallbackFn& solution_callback,
+                                           moveit_msgs::MoveItErrorCodes& error_code,
+                                           const kinematics::KinematicsQueryOptions& options) const
+{
+  ros::WallTime n1 = ros::WallTime::now();
+  if (!active_)
+  {
+    ROS_ERROR_NAMED("lma", "kinematics not active");
+    error_code.val = error_code.NO_IK_SOLUTION;
+    return false;
+  }
+
+  if (ik_seed_state.size() != dimension_ || solution.size() != dimension_)
+  {
+    ROS_ERROR_STREAM_NAMED("lma", "Seed state and solution must have size " << dimension_ << " instead of size "
+                                                                            << ik_seed_state.size() << " and "
+                                                                            << solution.size());
+    error_code.val = error_code.NO_IK_SOLUTION;
+    return false;
+  }
+
+  KDL::Frame pose_desired;
+  poseEigenToKDL(ik_pose, pose_desired);
+  geometry_msgs::Pose ik_pose_msg;  // only passed to the solution callback
+  tf::poseKDLToMsg(pose_desired, ik_pose_msg);
+  std::vector<double> consistency_limits;
+
+  std::shared_ptr<IKSolvers> solvers = acquireSolvers();
+  for (unsigned int i = 0; i < dimension_; i++)
+    solvers->jnt_seed_state_(i) = ik_seed_state[i];
+  IKSearch search(ik_pose_msg, pose_desired, solvers->jnt_seed_state_, n1, timeout, solution_callback,
+                  consistency_limits, options);
+  runSearch(solvers.get(), &search);
+
+  bool found = checkSearchResult(search, error_code);
+  if (found)
+    for (unsigned int i = 0; i < dimension_; i++)
+      solution[i] = (*search.solution_)[i];
+  releaseSolvers(solvers);
+  return found;
+}
+
+std::shared_ptr<LMAKinematicsPlugin::IKSolvers> LMAKinematicsPlugin::acquireSolvers() const
+{
+  {
+    boost::mutex::scoped_lock slock(solver_pool_lock_);
+    if (!solver_pool_.empty())
+    {
+      std::shared_ptr<IKSolvers> solvers = solver_pool_.back();
+      solver_pool_.pop_back();
+      return solvers;
+    }
+  }
+  return std::shared_ptr<IKSolvers>(new IKSolvers(*this));
+}
+
+void LMAKinematicsPlugin::releaseSolvers(const std::shared_ptr<IKSolvers>& solvers) const
+{
+  boost::mutex::scoped_lock slock(solver_pool_lock_);
+  solver_pool_.push_back(solvers);
+}
+
+void LMAKinematicsPlugin::runSearch(IKSolvers* solvers, IKSearch* search) const
+{
+  unsigned int thread_count = search_thread_count_ ? search_thread_count_ : boost::thread::hardware_concurrency();
+  if (thread_count <= 1)
+  {
+    searchPositionIKWorker(0, solvers, search);
+    recordSearchStatistics(*search);
+    return;
+  }
+
+  // workers race from different seeds; worker 0 runs in this thread, each of the others in its own with its own
+  // solvers
+  std::vector<std::shared_ptr<IKSolvers> > worker_solvers(thread_count - 1);
+  boost::thread_group workers;
+  for (unsigned int i = 1; i < thread_count; ++i)
+  {
+    worker_solvers[i - 1] = acquireSolvers();
+    workers.create_thread(
+        boost::bind(&LMAKinematicsPlugin::searchPositionIKWorker, this, i, worker_solvers[i - 1].get(), search));
+  }
+  searchPositionIKWorker(0, solvers, search);
+  workers.join_all();
+
+  // the caller only owns the buffers of worker 0
+  if (search->solution_ && search->solution_ != &solvers->solution_)
+  {
+    solvers->solution_ = *search->solution_;
+    search->solution_ = &solvers->solution_;
+  }
+  for (std::size_t i = 0; i < worker_solvers.size(); ++i)
+    releaseSolvers(worker_solvers[i]);
+  recordSearchStatistics(*search);
+}
+
+void LMAKinematicsPlugin::recordSearchStatistics(const IKSearch& search) const
+{
+  if (!search_statistics_.isEnabled())
+    return;
+  search_statistics_.record((ros::WallTime::now() - search.start_time_).toSec(), search.solution_ != NULL,
+                            search.iterations_ > 1 ? search.iterations_ - 1 : 0);
+}
+
+bool LMAKinematicsPlugin::checkSearchResult(const IKSearch& search, moveit_msgs::MoveItErrorCodes& error_code) const
+{
+  if (search.setup_failed_)
+    return false;
+  if (!search.done_)
+  {
+    ROS_DEBUG_NAMED("lma", "IK timed out");
+    error_code.val = error_code.TIMED_OUT;
+    return false;
+  }
+  error_code.val = error_code.SUCCESS;
+  return true;
+}
+
+void LMAKinematicsPlugin::searchPositionIKWorker(unsigned int worker, IKSolvers* solvers, IKSearch* search) const
+{
+  KDL::JntArray& jnt_pos_in = solvers->jnt_pos_in_;
+  KDL::JntArray& jnt_pos_out = solvers->jnt_pos_out_;
+
+  KDL::ChainIkSolverVel_pinv_mimic& ik_solver_vel = solvers->ik_solver_vel_;
+  KDL::ChainIkSolverPos_LMA_JL_Mimic& ik_solver_pos = solvers->ik_solver_pos_;
 
   if ((redundant_joint_indices_.size() > 0) && !ik_solver_vel.setRedundantJointsMapIndex(redundant_joints_map_index_))
   {
     ROS_ERROR_NAMED("lma", "Could not set redundant joints");
-    return false;
+    boost::mutex::scoped_lock slock(search->lock_);
+    search->setup_failed_ = true;
+    return;
   }
 
-  if (options.lock_redundant_joints)
+  if (search->options_.lock_redundant_joints)
   {
     ik_solver_vel.lockRedundantJoints();
   }
 
-  solution.resize(dimension_);
-
-  KDL::Frame pose_desired;
-  tf::poseMsgToKDL(ik_pose, pose_desired);
+  const std::vector<double>& consistency_limits = search->consistency_limits_;
+  const KDL::JntArray& jnt_seed_state = search->jnt_seed_state_;
+  bool lock_redundancy = search->options_.lock_redundant_joints;
 
-  ROS_DEBUG_STREAM_NAMED("lma", "searchPositionIK2: Position request pose is "
-                                    << ik_pose.position.x << " " << ik_pose.position.y << " " << ik_pose.position.z
-                                    << " " << ik_pose.orientation.x << " " << ik_pose.orientation.y << " "
-                                    << ik_pose.orientation.z << " " << ik_pose.orientation.w);
-  // Do the IK
-  for (unsigned int i = 0; i < dimension_; i++)
-    jnt_seed_state(i) = ik_seed_state[i];
+  // the first worker starts from the seed state, the others from random configurations
   jnt_pos_in = jnt_seed_state;
+  if (worker > 0)
+  {
+    if (!consistency_limits.empty())
+      getRandomConfiguration(*solvers, jnt_seed_state, consistency_limits, jnt_pos_in, lock_redundancy);
+    else
+      getRandomConfiguration(*solvers, jnt_pos_in, lock_redundancy);
+  }
 
+  std::vector<double>& solution = solvers->solution_;
+  moveit_msgs::MoveItErrorCodes error_code;
   unsigned int counter(0);
-  while (1)
+  while (!search->done_)
   {
-    //    ROS_DEBUG_NAMED("lma","Iteration: %d, time: %f, Timeout:
-    //    %f",counter,(ros::WallTime::now()-n1).toSec(),timeout);
     counter++;
-    if (timedOut(n1, timeout))
-    {
-      ROS_DEBUG_NAMED("lma", "IK timed out");
-      error_code.val = error_code.TIMED_OUT;
-      ik_solver_vel.unlockRedundantJoints();
-      return false;
-    }
-    int ik_valid = ik_solver_pos.CartToJnt(jnt_pos_in, pose_desired, jnt_pos_out);
+    if (timedOut(search->start_time_, search->timeout_))
+      break;
+    int ik_valid = ik_solver_pos.CartToJnt(jnt_pos_in, search->pose_desired_, jnt_pos_out);
     ROS_DEBUG_NAMED("lma", "IK valid: %d", ik_valid);
     if (!consistency_limits.empty())
     {
-      getRandomConfiguration(jnt_seed_state, consistency_limits, jnt_pos_in, options.lock_redundant_joints);
-      if ((ik_valid < 0 && !options.return_approximate_solution) ||
+      getRandomConfiguration(*solvers, jnt_seed_state, consistency_limits, jnt_pos_in, lock_redundancy);
+      if ((ik_valid < 0 && !search->options_.return_approximate_solution) ||
           !checkConsistency(jnt_seed_state, consistency_limits, jnt_pos_out))
       {
         ROS_DEBUG_NAMED("lma", "Could not find IK solution: does not match consistency limits");
@@ -534,12 +866,12 @@ bool LMAKinematicsPlugin::searchPositionIK(const geometry_msgs::Pose& ik_pose, c
     }
     else
     {
-      getRandomConfiguration(jnt_pos_in, options.lock_redundant_joints);
+      getRandomConfiguration(*solvers, jnt_pos_in, lock_redundancy);
       ROS_DEBUG_NAMED("lma", "New random configuration");
       for (unsigned int j = 0; j < dimension_; j++)
         ROS_DEBUG_NAMED("lma", "%d %f", j, jnt_pos_in(j));
 
-      if (ik_valid < 0 && !options.return_approximate_solution)
+      if (ik_valid < 0 && !search->options_.return_approximate_solution)
       {
         ROS_DEBUG_NAMED("lma", "Could not find IK solution");
         continue;
@@ -548,22 +880,105 @@ bool LMAKinematicsPlugin::searchPositionIK(const geometry_msgs::Pose& ik_pose, c
     ROS_DEBUG_NAMED("lma", "Found IK solution");
     for (unsigned int j = 0; j < dimension_; j++)
       solution[j] = jnt_pos_out(j);
-    if (!solution_callback.empty())
-      solution_callback(ik_pose, solution, error_code);
+
+    // solution callbacks are typically not thread safe, and only the first accepted solution is returned
+    boost::mutex::scoped_lock slock(search->lock_);
+    if (search->done_)
+      break;
+    if (!search->solution_callback_.empty())
+      search->solution_callback_(search->ik_pose_, solution, error_code);
     else
       error_code.val = error_code.SUCCESS;
 
     if (error_code.val == error_code.SUCCESS)
     {
-      ROS_DEBUG_STREAM_NAMED("lma", "Solved after " << counter << " iterations");
-      ik_solver_vel.unlockRedundantJoints();
-      return true;
+      ROS_DEBUG_STREAM_NAMED("lma", "Solved after " << counter << " iterations in worker " << worker);
+      search->solution_ = &solution;
+      search->done_ = true;
     }
   }
-  ROS_DEBUG_NAMED("lma", "An IK that satisifes the constraints and is collision free could not be found");
-  error_code.val = error_code.NO_IK_SOLUTION;
   ik_solver_vel.unlockRedundantJoints();
-  return false;
+
+  boost::mutex::scoped_lock slock(search->lock_);
+  search->iterations_ += counter;
+}
+
+std::size_t LMAKinematicsPlugin::getPositionIKBatch(const EigenSTL::vector_Affine3d& poses,
+                                                    const std::vector<double>& seeds,
+                                                    std::vector<std::vector<double> >& solutions,
+                                                    std::vector<moveit_msgs::MoveItErrorCodes>& error_codes,
+                                                    const kinematics::KinematicsQueryOptions& options) const
+{
+  solutions.assign(poses.size(), std::vector<double>());
+  error_codes.resize(poses.size());
+  for (std::size_t i = 0; i < error_codes.size(); ++i)
+    error_codes[i].val = moveit_msgs::MoveItErrorCodes::NO_IK_SOLUTION;
+  if (!active_)
+  {
+    ROS_ERROR_NAMED("lma", "kinematics not active");
+    return 0;
+  }
+  if (poses.empty())
+    return 0;
+
+  bool seed_per_pose = poses.size() > 1 && seeds.size() == dimension_ * poses.size();
+  if (!seed_per_pose && seeds.size() != dimension_)
+  {
+    ROS_ERROR_STREAM_NAMED("lma", "Seeds must have size " << dimension_ << " or " << dimension_ * poses.size()
+                                                          << " instead of size " << seeds.size());
+    return 0;
+  }
+
+  // the poses are spread over the search threads; each thread solves its poses one after the other, reusing its
+  // solvers
+  IKBatch batch(poses, seeds, seed_per_pose, solutions, error_codes, options);
+  unsigned int thread_count = search_thread_count_ ? search_thread_count_ : boost::thread::hardware_concurrency();
+  if (thread_count > poses.size())
+    thread_count = poses.size();
+  if (thread_count <= 1)
+    getPositionIKBatchWorker(0, 1, &batch);
+  else
+  {
+    boost::thread_group workers;
+    for (unsigned int i = 0; i < thread_count; ++i)
+      workers.create_thread(boost::bind(&LMAKinematicsPlugin::getPositionIKBatchWorker, this, i, thread_count, &batch));
+    workers.join_all();
+  }
+  return batch.solved_;
+}
+
+void LMAKinematicsPlugin::getPositionIKBatchWorker(std::size_t first, std::size_t stride, IKBatch* batch) const
+{
+  std::shared_ptr<IKSolvers> solvers = acquireSolvers();
+  const IKCallbackFn solution_callback = 0;
+  std::vector<double> consistency_limits;
+  geometry_msgs::Pose ik_pose;
+  KDL::Frame pose_desired;
+  for (std::size_t i = first; i < batch->poses_.size(); i += stride)
+  {
+    poseEigenToKDL(batch->poses_[i], pose_desired);
+    tf::poseKDLToMsg(pose_desired, ik_pose);
+
+    std::size_t offset = batch->seed_per_pose_ ? i * dimension_ : 0;
+    for (unsigned int j = 0; j < dimension_; j++)
+      solvers->jnt_seed_state_(j) = batch->seeds_[offset + j];
+    IKSearch search(ik_pose, pose_desired, solvers->jnt_seed_state_, ros::WallTime::now(), default_timeout_,
+                    solution_callback, consistency_limits, batch->options_);
+
+    searchPositionIKWorker(0, solvers.get(), &search);
+    recordSearchStatistics(search);
+    if (search.setup_failed_)
+      break;
+    if (search.done_)
+    {
+      batch->solutions_[i] = *search.solution_;
+      batch->error_codes_[i].val = moveit_msgs::MoveItErrorCodes::SUCCESS;
+      ++batch->solved_;
+    }
+    else
+      batch->error_codes_[i].val = moveit_msgs::MoveItErrorCodes::TIMED_OUT;
+  }
+  releaseSolvers(solvers);
 }
 
 bool LMAKinematicsPlugin::getPositionFK(const std::vector<std::string>& link_names,
@@ -612,6 +1027,47 @@ bool LMAKinematicsPlugin::getPositionFK(const std::vector<std::string>& link_nam
   return valid;
 }
 
+bool LMAKinematicsPlugin::getPositionFK(const Eigen::Ref<const Eigen::VectorXd>& joint_angles,
+                                        Eigen::Affine3d& tip_pose) const
+{
+  if (!active_)
+  {
+    ROS_ERROR_NAMED("lma", "kinematics not active");
+    return false;
+  }
+  if (joint_angles.size() != dimension_)
+  {
+    ROS_ERROR_NAMED("lma", "Joint angles vector must have size: %d", dimension_);
+    return false;
+  }
+
+  std::shared_ptr<IKSolvers> solvers = acquireSolvers();
+  for (unsigned int i = 0; i < dimension_; i++)
+    solvers->jnt_pos_in_(i) = joint_angles[i];
+  KDL::Frame p_out;
+  bool valid = solvers->fk_solver_.JntToCart(solvers->jnt_pos_in_, p_out) >= 0;
+  releaseSolvers(solvers);
+
+  if (!valid)
+  {
+    ROS_ERROR_NAMED("lma", "Could not compute FK for %s", getTipFrame().c_str());
+    return false;
+  }
+  poseKDLToEigen(p_out, tip_pose);
+  return true;
+}
+
+kinematics::IKTrackingSessionPtr LMAKinematicsPlugin::beginTracking(const std::vector<double>& ik_seed_state,
+                                                       const kinematics::KinematicsQueryOptions& options) const
+{
+  if (!active_)
+  {
+    ROS_ERROR_NAMED("lma", "kinematics not active");
+    return kinematics::IKTrackingSessionPtr();
+  }
+  return kinematics::IKTrackingSessionPtr(new TrackingSession(*this, ik_seed_state, options));
+}
+
 const std::vector<std::string>& LMAKinematicsPlugin::getJointNames() const
 {
   return ik_chain_info_.joint_names;
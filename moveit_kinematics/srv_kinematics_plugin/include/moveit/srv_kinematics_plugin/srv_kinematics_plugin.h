@@ -46,7 +46,10 @@
 #include <ros/ros.h>
 
 // System
+#include <deque>
 #include <memory>
+#include <boost/thread.hpp>
+#include <boost/thread/future.hpp>
 
 // ROS msgs
 #include <geometry_msgs/PoseStamped.h>
@@ -69,11 +72,42 @@ namespace srv_kinematics_plugin
 class SrvKinematicsPlugin : public kinematics::KinematicsBase
 {
 public:
+  /** @brief The outcome of a request made with getPositionIKAsync() */
+  struct AsyncIKResult
+  {
+    std::vector<double> solution;
+    moveit_msgs::MoveItErrorCodes error_code;
+  };
+  typedef boost::shared_future<AsyncIKResult> AsyncIKFuture;
+
   /**
    *  @brief Default constructor
    */
   SrvKinematicsPlugin();
 
+  virtual ~SrvKinematicsPlugin();
+
+  /**
+   * @brief Queue an IK request for the service and return without waiting for the reply. Requests are sent over a
+   * pool of persistent connections (kinematics_solver_service_connections of them, one by default), so many of them
+   * can be outstanding at once. Solution callbacks are not supported, as they would run on the connection threads.
+   * @param ik_poses The desired pose of each tip frame
+   * @param ik_seed_state The seed for the IK service
+   * @return A future that becomes ready once the reply has arrived
+   */
+  AsyncIKFuture getPositionIKAsync(const std::vector<geometry_msgs::Pose>& ik_poses,
+                                   const std::vector<double>& ik_seed_state) const;
+
+  /**
+   * @brief Solve IK for many poses at once; all requests are queued with getPositionIKAsync() before the first reply
+   * is waited for, so the service round-trips overlap
+   */
+  virtual std::size_t
+  getPositionIKBatch(const EigenSTL::vector_Affine3d& poses, const std::vector<double>& seeds,
+                     std::vector<std::vector<double> >& solutions,
+                     std::vector<moveit_msgs::MoveItErrorCodes>& error_codes,
+                     const kinematics::KinematicsQueryOptions& options = kinematics::KinematicsQueryOptions()) const;
+
   virtual bool
   getPositionIK(const geometry_msgs::Pose& ik_pose, const std::vector<double>& ik_seed_state,
                 std::vector<double>& solution, moveit_msgs::MoveItErrorCodes& error_code,
@@ -147,6 +181,25 @@ protected:
   virtual bool setRedundantJoints(const std::vector<unsigned int>& redundant_joint_indices);
 
 private:
+  /** @brief A request queued by getPositionIKAsync() */
+  struct AsyncIKRequest
+  {
+    moveit_msgs::GetPositionIK srv;
+    boost::promise<AsyncIKResult> promise;
+  };
+
+  /** @brief Check the query and fill in the service request for it; on failure \e error_code is set */
+  bool createRequest(const std::vector<geometry_msgs::Pose>& ik_poses, const std::vector<double>& ik_seed_state,
+                     robot_state::RobotState& state, moveit_msgs::GetPositionIK::Request& request,
+                     moveit_msgs::MoveItErrorCodes& error_code) const;
+
+  /** @brief Extract the group's joint values from a service response, using \e state for the conversion */
+  bool processResponse(const moveit_msgs::GetPositionIK::Response& response, robot_state::RobotState& state,
+                       std::vector<double>& solution, moveit_msgs::MoveItErrorCodes& error_code) const;
+
+  /** @brief Send the queued asynchronous requests over one persistent connection until shutdown */
+  void asyncWorker() const;
+
   bool timedOut(const ros::WallTime& start_time, double duration) const;
 
   int getJointIndex(const std::string& name) const;
@@ -167,6 +220,21 @@ private:
   int num_possible_redundant_joints_;
 
   std::shared_ptr<ros::ServiceClient> ik_service_client_;
+  std::string ik_service_name_;
+
+  unsigned int async_connections_; /** Number of persistent connections asynchronous requests are sent over */
+
+  /** Asynchronous requests waiting for a connection, and the threads that own the connections (started on the
+   * first asynchronous request) */
+  mutable std::deque<std::shared_ptr<AsyncIKRequest> > async_queue_;
+  mutable boost::thread_group async_workers_;
+  mutable bool async_started_;
+  mutable bool async_shutdown_;
+  mutable boost::mutex async_lock_;
+  mutable boost::condition_variable async_condition_;
+
+  /** robot_state_ is used to convert synchronous requests and asynchronous requests as they are queued */
+  mutable boost::mutex robot_state_lock_;
 };
 }
 
@@ -36,6 +36,8 @@
 
 #include <moveit/srv_kinematics_plugin/srv_kinematics_plugin.h>
 #include <class_loader/class_loader.h>
+#include <boost/bind.hpp>
+#include <algorithm>
 
 // URDF, SRDF
 #include <urdf_model/model.h>
@@ -53,10 +55,27 @@ CLASS_LOADER_REGISTER_CLASS(srv_kinematics_plugin::SrvKinematicsPlugin, kinemati
 
 namespace srv_kinematics_plugin
 {
-SrvKinematicsPlugin::SrvKinematicsPlugin() : active_(false)
+SrvKinematicsPlugin::SrvKinematicsPlugin()
+  : active_(false), async_connections_(1), async_started_(false), async_shutdown_(false)
 {
 }
 
+SrvKinematicsPlugin::~SrvKinematicsPlugin()
+{
+  {
+    boost::mutex::scoped_lock slock(async_lock_);
+    async_shutdown_ = true;
+  }
+  async_condition_.notify_all();
+  async_workers_.join_all();
+
+  // nobody is going to send the requests that are still queued
+  AsyncIKResult result;
+  result.error_code.val = moveit_msgs::MoveItErrorCodes::FAILURE;
+  for (std::size_t i = 0; i < async_queue_.size(); ++i)
+    async_queue_[i]->promise.set_value(result);
+}
+
 bool SrvKinematicsPlugin::initialize(const std::string& robot_description, const std::string& group_name,
                                      const std::string& base_frame, const std::vector<std::string>& tip_frames,
                                      double search_discretization)
@@ -127,8 +146,10 @@ bool SrvKinematicsPlugin::initialize(const std::string& robot_description, const
   ROS_DEBUG_STREAM_NAMED("srv", "Looking for ROS service name on rosparm server at location: "
                                     << private_handle.getNamespace() << "/" << group_name_
                                     << "/kinematics_solver_service_name");
-  std::string ik_service_name;
-  private_handle.param(group_name_ + "/kinematics_solver_service_name", ik_service_name, std::string("solve_ik"));
+  private_handle.param(group_name_ + "/kinematics_solver_service_name", ik_service_name_, std::string("solve_ik"));
+  int async_connections;
+  private_handle.param(group_name_ + "/kinematics_solver_service_connections", async_connections, 1);
+  async_connections_ = std::max(async_connections, 1);
 
   // Setup the joint state groups that we need
   robot_state_.reset(new robot_state::RobotState(robot_model_));
@@ -137,7 +158,7 @@ bool SrvKinematicsPlugin::initialize(const std::string& robot_description, const
   // Create the ROS service client
   ros::NodeHandle nonprivate_handle("");
   ik_service_client_ = std::make_shared<ros::ServiceClient>(
-      nonprivate_handle.serviceClient<moveit_msgs::GetPositionIK>(ik_service_name));
+      nonprivate_handle.serviceClient<moveit_msgs::GetPositionIK>(ik_service_name_));
   if (!ik_service_client_->waitForExistence(ros::Duration(0.1)))  // wait 0.1 seconds, blocking
     ROS_WARN_STREAM_NAMED("srv",
                           "Unable to connect to ROS service client with name: " << ik_service_client_->getService());
@@ -272,6 +293,62 @@ bool SrvKinematicsPlugin::searchPositionIK(const std::vector<geometry_msgs::Pose
     return false;
   }
 
+  // Create the service message
+  moveit_msgs::GetPositionIK ik_srv;
+  {
+    boost::mutex::scoped_lock slock(robot_state_lock_);
+    if (!createRequest(ik_poses, ik_seed_state, *robot_state_, ik_srv.request, error_code))
+      return false;
+  }
+
+  ROS_DEBUG_STREAM_NAMED("srv", "Calling service: " << ik_service_client_->getService());
+  if (!ik_service_client_->call(ik_srv))
+  {
+    ROS_ERROR_STREAM("Service call failed to connect to service: " << ik_service_client_->getService());
+    error_code.val = error_code.FAILURE;
+    return false;
+  }
+
+  {
+    boost::mutex::scoped_lock slock(robot_state_lock_);
+    if (!processResponse(ik_srv.response, *robot_state_, solution, error_code))
+      return false;
+  }
+
+  // Run the solution callback (i.e. collision checker) if available
+  if (!solution_callback.empty())
+  {
+    ROS_DEBUG_STREAM_NAMED("srv", "Calling solution callback on IK solution");
+
+    // hack: should use all poses, not just the 0th
+    solution_callback(ik_poses[0], solution, error_code);
+
+    if (error_code.val != error_code.SUCCESS)
+    {
+      switch (error_code.val)
+      {
+        case moveit_msgs::MoveItErrorCodes::FAILURE:
+          ROS_ERROR_STREAM_NAMED("srv", "IK solution callback failed with with error code: FAILURE");
+          break;
+        case moveit_msgs::MoveItErrorCodes::NO_IK_SOLUTION:
+          ROS_ERROR_STREAM_NAMED("srv", "IK solution callback failed with with error code: NO IK SOLUTION");
+          break;
+        default:
+          ROS_ERROR_STREAM_NAMED("srv", "IK solution callback failed with with error code: " << error_code.val);
+      }
+      return false;
+    }
+  }
+
+  ROS_INFO_STREAM_NAMED("srv", "IK Solver Succeeded!");
+  return true;
+}
+
+bool SrvKinematicsPlugin::createRequest(const std::vector<geometry_msgs::Pose>& ik_poses,
+                                        const std::vector<double>& ik_seed_state, robot_state::RobotState& state,
+                                        moveit_msgs::GetPositionIK::Request& request,
+                                        moveit_msgs::MoveItErrorCodes& error_code) const
+{
   // Check if seed state correct
   if (ik_seed_state.size() != dimension_)
   {
@@ -291,14 +368,12 @@ bool SrvKinematicsPlugin::searchPositionIK(const std::vector<geometry_msgs::Pose
     return false;
   }
 
-  // Create the service message
-  moveit_msgs::GetPositionIK ik_srv;
-  ik_srv.request.ik_request.avoid_collisions = true;
-  ik_srv.request.ik_request.group_name = getGroupName();
+  request.ik_request.avoid_collisions = true;
+  request.ik_request.group_name = getGroupName();
 
   // Copy seed state into virtual robot state and convert into moveit_msg
-  robot_state_->setJointGroupPositions(joint_model_group_, ik_seed_state);
-  moveit::core::robotStateToRobotStateMsg(*robot_state_, ik_srv.request.ik_request.robot_state);
+  state.setJointGroupPositions(joint_model_group_, ik_seed_state);
+  moveit::core::robotStateToRobotStateMsg(state, request.ik_request.robot_state);
 
   // Load the poses into the request in difference places depending if there is more than one or not
   geometry_msgs::PoseStamped ik_pose_st;
@@ -309,8 +384,8 @@ bool SrvKinematicsPlugin::searchPositionIK(const std::vector<geometry_msgs::Pose
     for (std::size_t i = 0; i < tip_frames_.size(); ++i)
     {
       ik_pose_st.pose = ik_poses[i];
-      ik_srv.request.ik_request.pose_stamped_vector.push_back(ik_pose_st);
-      ik_srv.request.ik_request.ik_link_names.push_back(tip_frames_[i]);
+      request.ik_request.pose_stamped_vector.push_back(ik_pose_st);
+      request.ik_request.ik_link_names.push_back(tip_frames_[i]);
     }
   }
   else
@@ -318,45 +393,38 @@ bool SrvKinematicsPlugin::searchPositionIK(const std::vector<geometry_msgs::Pose
     ik_pose_st.pose = ik_poses[0];
 
     // Load into single pose value
-    ik_srv.request.ik_request.pose_stamped = ik_pose_st;
-    ik_srv.request.ik_request.ik_link_name = getTipFrames()[0];
+    request.ik_request.pose_stamped = ik_pose_st;
+    request.ik_request.ik_link_name = getTipFrames()[0];
   }
+  return true;
+}
 
-  ROS_DEBUG_STREAM_NAMED("srv", "Calling service: " << ik_service_client_->getService());
-  if (ik_service_client_->call(ik_srv))
+bool SrvKinematicsPlugin::processResponse(const moveit_msgs::GetPositionIK::Response& response,
+                                          robot_state::RobotState& state, std::vector<double>& solution,
+                                          moveit_msgs::MoveItErrorCodes& error_code) const
+{
+  // Check error code
+  error_code.val = response.error_code.val;
+  if (error_code.val != error_code.SUCCESS)
   {
-    // Check error code
-    error_code.val = ik_srv.response.error_code.val;
-    if (error_code.val != error_code.SUCCESS)
+    ROS_DEBUG_NAMED("srv", "An IK that satisifes the constraints and is collision free could not be found.");
+    ROS_DEBUG_STREAM("Response was: \n" << response.solution);
+    switch (error_code.val)
     {
-      ROS_DEBUG_NAMED("srv", "An IK that satisifes the constraints and is collision free could not be found.");
-      switch (error_code.val)
-      {
-        // Debug mode for failure:
-        ROS_DEBUG_STREAM("Request was: \n" << ik_srv.request.ik_request);
-        ROS_DEBUG_STREAM("Response was: \n" << ik_srv.response.solution);
-
-        case moveit_msgs::MoveItErrorCodes::FAILURE:
-          ROS_ERROR_STREAM_NAMED("srv", "Service failed with with error code: FAILURE");
-          break;
-        case moveit_msgs::MoveItErrorCodes::NO_IK_SOLUTION:
-          ROS_ERROR_STREAM_NAMED("srv", "Service failed with with error code: NO IK SOLUTION");
-          break;
-        default:
-          ROS_ERROR_STREAM_NAMED("srv", "Service failed with with error code: " << error_code.val);
-      }
-      return false;
+      case moveit_msgs::MoveItErrorCodes::FAILURE:
+        ROS_ERROR_STREAM_NAMED("srv", "Service failed with with error code: FAILURE");
+        break;
+      case moveit_msgs::MoveItErrorCodes::NO_IK_SOLUTION:
+        ROS_ERROR_STREAM_NAMED("srv", "Service failed with with error code: NO IK SOLUTION");
+        break;
+      default:
+        ROS_ERROR_STREAM_NAMED("srv", "Service failed with with error code: " << error_code.val);
     }
-  }
-  else
-  {
-    ROS_ERROR_STREAM("Service call failed to connect to service: " << ik_service_client_->getService());
-    error_code.val = error_code.FAILURE;
     return false;
   }
 
   // Convert the robot state message to our robot_state representation
-  if (!moveit::core::robotStateMsgToRobotState(ik_srv.response.solution, *robot_state_))
+  if (!moveit::core::robotStateMsgToRobotState(response.solution, state))
   {
     ROS_ERROR_STREAM_NAMED("srv", "An error occured converting recieved robot state message into internal robot "
                                   "state.");
@@ -365,35 +433,149 @@ bool SrvKinematicsPlugin::searchPositionIK(const std::vector<geometry_msgs::Pose
   }
 
   // Get just the joints we are concerned about in our planning group
-  robot_state_->copyJointGroupPositions(joint_model_group_, solution);
+  state.copyJointGroupPositions(joint_model_group_, solution);
+  return true;
+}
 
-  // Run the solution callback (i.e. collision checker) if available
-  if (!solution_callback.empty())
+SrvKinematicsPlugin::AsyncIKFuture SrvKinematicsPlugin::getPositionIKAsync(
+    const std::vector<geometry_msgs::Pose>& ik_poses, const std::vector<double>& ik_seed_state) const
+{
+  std::shared_ptr<AsyncIKRequest> request = std::make_shared<AsyncIKRequest>();
+  AsyncIKFuture future = request->promise.get_future().share();
+
+  AsyncIKResult result;
+  if (!active_)
   {
-    ROS_DEBUG_STREAM_NAMED("srv", "Calling solution callback on IK solution");
+    ROS_ERROR_NAMED("srv", "kinematics not active");
+    result.error_code.val = result.error_code.NO_IK_SOLUTION;
+    request->promise.set_value(result);
+    return future;
+  }
 
-    // hack: should use all poses, not just the 0th
-    solution_callback(ik_poses[0], solution, error_code);
+  bool created;
+  {
+    boost::mutex::scoped_lock slock(robot_state_lock_);
+    created = createRequest(ik_poses, ik_seed_state, *robot_state_, request->srv.request, result.error_code);
+  }
+  if (!created)
+  {
+    request->promise.set_value(result);
+    return future;
+  }
 
-    if (error_code.val != error_code.SUCCESS)
+  {
+    boost::mutex::scoped_lock slock(async_lock_);
+    if (!async_started_)
     {
-      switch (error_code.val)
-      {
-        case moveit_msgs::MoveItErrorCodes::FAILURE:
-          ROS_ERROR_STREAM_NAMED("srv", "IK solution callback failed with with error code: FAILURE");
-          break;
-        case moveit_msgs::MoveItErrorCodes::NO_IK_SOLUTION:
-          ROS_ERROR_STREAM_NAMED("srv", "IK solution callback failed with with error code: NO IK SOLUTION");
-          break;
-        default:
-          ROS_ERROR_STREAM_NAMED("srv", "IK solution callback failed with with error code: " << error_code.val);
-      }
-      return false;
+      for (unsigned int i = 0; i < async_connections_; ++i)
+        async_workers_.create_thread(boost::bind(&SrvKinematicsPlugin::asyncWorker, this));
+      async_started_ = true;
     }
+    async_queue_.push_back(request);
   }
+  async_condition_.notify_one();
+  return future;
+}
 
-  ROS_INFO_STREAM_NAMED("srv", "IK Solver Succeeded!");
-  return true;
+void SrvKinematicsPlugin::asyncWorker() const
+{
+  ros::NodeHandle nonprivate_handle("");
+  ros::ServiceClient client;
+  robot_state::RobotState state(robot_model_);
+  state.setToDefaultValues();
+
+  while (true)
+  {
+    std::shared_ptr<AsyncIKRequest> request;
+    {
+      boost::mutex::scoped_lock slock(async_lock_);
+      while (async_queue_.empty() && !async_shutdown_)
+        async_condition_.wait(slock);
+      if (async_shutdown_)
+        return;
+      request = async_queue_.front();
+      async_queue_.pop_front();
+    }
+
+    // a persistent connection stays open between calls, and becomes invalid if the service goes away
+    if (!client.isValid())
+      client = nonprivate_handle.serviceClient<moveit_msgs::GetPositionIK>(ik_service_name_, true);
+
+    AsyncIKResult result;
+    if (client.call(request->srv))
+      processResponse(request->srv.response, state, result.solution, result.error_code);
+    else
+    {
+      ROS_ERROR_STREAM_NAMED("srv", "Service call failed to connect to service: " << client.getService());
+      result.error_code.val = result.error_code.FAILURE;
+    }
+    request->promise.set_value(result);
+  }
+}
+
+std::size_t SrvKinematicsPlugin::getPositionIKBatch(const EigenSTL::vector_Affine3d& poses,
+                                                    const std::vector<double>& seeds,
+                                                    std::vector<std::vector<double> >& solutions,
+                                                    std::vector<moveit_msgs::MoveItErrorCodes>& error_codes,
+                                                    const kinematics::KinematicsQueryOptions& options) const
+{
+  solutions.assign(poses.size(), std::vector<double>());
+  error_codes.resize(poses.size());
+  for (std::size_t i = 0; i < error_codes.size(); ++i)
+    error_codes[i].val = moveit_msgs::MoveItErrorCodes::NO_IK_SOLUTION;
+  if (!active_)
+  {
+    ROS_ERROR_NAMED("srv", "kinematics not active");
+    return 0;
+  }
+  if (poses.empty())
+    return 0;
+  if (tip_frames_.size() != 1)
+  {
+    ROS_ERROR_NAMED("srv", "Batch IK is only supported for groups with a single tip frame");
+    return 0;
+  }
+
+  bool seed_per_pose = poses.size() > 1 && seeds.size() == dimension_ * poses.size();
+  if (!seed_per_pose && seeds.size() != dimension_)
+  {
+    ROS_ERROR_STREAM_NAMED("srv", "Seeds must have size " << dimension_ << " or " << dimension_ * poses.size()
+                                                          << " instead of size " << seeds.size());
+    return 0;
+  }
+
+  // queue all requests first, so that they are in flight at the same time
+  std::vector<AsyncIKFuture> futures(poses.size());
+  std::vector<geometry_msgs::Pose> ik_poses(1);
+  std::vector<double> seed(dimension_);
+  for (std::size_t p = 0; p < poses.size(); ++p)
+  {
+    const Eigen::Quaterniond q(poses[p].linear());
+    ik_poses[0].position.x = poses[p].translation().x();
+    ik_poses[0].position.y = poses[p].translation().y();
+    ik_poses[0].position.z = poses[p].translation().z();
+    ik_poses[0].orientation.x = q.x();
+    ik_poses[0].orientation.y = q.y();
+    ik_poses[0].orientation.z = q.z();
+    ik_poses[0].orientation.w = q.w();
+
+    std::size_t offset = seed_per_pose ? p * dimension_ : 0;
+    seed.assign(seeds.begin() + offset, seeds.begin() + offset + dimension_);
+    futures[p] = getPositionIKAsync(ik_poses, seed);
+  }
+
+  std::size_t solved = 0;
+  for (std::size_t p = 0; p < poses.size(); ++p)
+  {
+    const AsyncIKResult& result = futures[p].get();
+    error_codes[p] = result.error_code;
+    if (result.error_code.val == moveit_msgs::MoveItErrorCodes::SUCCESS)
+    {
+      solutions[p] = result.solution;
+      ++solved;
+    }
+  }
+  return solved;
 }
 
 bool SrvKinematicsPlugin::getPositionFK(const std::vector<std::string>& link_names,
@@ -70,6 +70,8 @@ void CHOMPInterface::loadParams()
   nh_.param("collision_threshold", params_.collision_threshold_, 0.07);
   nh_.param("random_jump_amount", params_.random_jump_amount_, 1.0);
   nh_.param("use_stochastic_descent", params_.use_stochastic_descent_, true);
+  nh_.param("min_cost_improvement", params_.min_cost_improvement_, 0.0);
+  nh_.param("coarse_to_fine_levels", params_.coarse_to_fine_levels_, 1);
   // filter_mode_ = false;
 }
 }
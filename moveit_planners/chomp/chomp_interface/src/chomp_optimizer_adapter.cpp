@@ -0,0 +1,95 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/planning_request_adapter/planning_request_adapter.h>
+#include <chomp_interface/chomp_interface.h>
+#include <class_loader/class_loader.h>
+#include <ros/console.h>
+
+namespace chomp_interface
+{
+/** \brief Run CHOMP on the solution of the wrapped planner. A sampling-based planner finds a feasible path quickly
+ * and CHOMP only smooths it, which takes far fewer iterations than starting from a straight line. If CHOMP fails or
+ * produces an invalid path, the solution of the wrapped planner is kept. The CHOMP output carries no timing, so
+ * this adapter should be listed after AddTimeParameterization. */
+class CHOMPOptimizerAdapter : public planning_request_adapter::PlanningRequestAdapter
+{
+public:
+  CHOMPOptimizerAdapter() : planning_request_adapter::PlanningRequestAdapter(), chomp_interface_(new CHOMPInterface())
+  {
+  }
+
+  virtual std::string getDescription() const
+  {
+    return "CHOMP Optimizer";
+  }
+
+  virtual bool adaptAndPlan(const PlannerFn& planner, const planning_scene::PlanningSceneConstPtr& planning_scene,
+                            const planning_interface::MotionPlanRequest& req,
+                            planning_interface::MotionPlanResponse& res,
+                            std::vector<std::size_t>& added_path_index) const
+  {
+    bool result = planner(planning_scene, req, res);
+    if (!result || !res.trajectory_ || res.trajectory_->empty())
+      return result;
+
+    ROS_DEBUG("Running '%s'", getDescription().c_str());
+    moveit_msgs::MotionPlanDetailedResponse chomp_res;
+    if (!chomp_interface_->solve(planning_scene, req, chomp_interface_->getParams(), *res.trajectory_, chomp_res))
+    {
+      ROS_WARN("CHOMP could not optimize the planned path. Keeping the path of the planner.");
+      return result;
+    }
+
+    robot_trajectory::RobotTrajectoryPtr trajectory(
+        new robot_trajectory::RobotTrajectory(planning_scene->getRobotModel(), req.group_name));
+    trajectory->setRobotTrajectoryMsg(res.trajectory_->getFirstWayPoint(), chomp_res.trajectory[0]);
+    if (!planning_scene->isPathValid(*trajectory, req.path_constraints, req.group_name))
+    {
+      ROS_WARN("The path optimized by CHOMP is not valid. Keeping the path of the planner.");
+      return result;
+    }
+
+    res.trajectory_ = trajectory;
+    if (!chomp_res.processing_time.empty())
+      res.planning_time_ += chomp_res.processing_time[0];
+    return result;
+  }
+
+private:
+  CHOMPInterfacePtr chomp_interface_;
+};
+}
+
+CLASS_LOADER_REGISTER_CLASS(chomp_interface::CHOMPOptimizerAdapter, planning_request_adapter::PlanningRequestAdapter);
@@ -74,7 +74,7 @@ bool CHOMPPlanningContext::solve(planning_interface::MotionPlanResponse& res)
 
 bool CHOMPPlanningContext::terminate()
 {
-  // TODO - make interruptible
+  chomp_interface_->terminate();
   return true;
 }
 
@@ -39,10 +39,15 @@
 
 #include <eigen3/Eigen/Core>
 #include <chomp_motion_planner/chomp_trajectory.h>
+#include <algorithm>
 #include <vector>
 
 namespace chomp
 {
+// the differentiation rules reach (DIFF_RULE_LENGTH - 1) / 2 points to either side, so the squared differentiation
+// matrices the costs are built from have this many non-zero diagonals on either side of the main one
+static const int QUAD_COST_BANDWIDTH = DIFF_RULE_LENGTH - 1;
+
 /**
  * \brief Represents the smoothness cost for CHOMP, for a single joint
  */
@@ -58,6 +63,10 @@ public:
 
   const Eigen::MatrixXd& getQuadraticCostInverse() const;
 
+  /** \brief Multiply \e vector by the inverse of the quadratic cost. This uses the banded Cholesky factor of the
+   * quadratic cost and takes time linear in the number of free variables. */
+  Eigen::VectorXd multiplyByQuadraticCostInverse(const Eigen::VectorXd& vector) const;
+
   const Eigen::MatrixXd& getQuadraticCost() const;
 
   double getCost(Eigen::MatrixXd::ColXpr joint_trajectory) const;
@@ -71,14 +80,24 @@ private:
   Eigen::MatrixXd quad_cost_;
   // Eigen::VectorXd linear_cost_;
   Eigen::MatrixXd quad_cost_inv_;
+  // lower band of the Cholesky factor L of quad_cost_, by diagonals: quad_cost_factor_(k, i) = L(i + k, i)
+  Eigen::MatrixXd quad_cost_factor_;
 
   Eigen::MatrixXd getDiffMatrix(int size, const double* diff_rule) const;
+
+  void factorQuadraticCost();
 };
 
 template <typename Derived>
 void ChompCost::getDerivative(Eigen::MatrixXd::ColXpr joint_trajectory, Eigen::MatrixBase<Derived>& derivative) const
 {
-  derivative = (quad_cost_full_ * (2.0 * joint_trajectory));
+  const int size = quad_cost_full_.rows();
+  for (int i = 0; i < size; ++i)
+  {
+    const int begin = std::max(0, i - QUAD_COST_BANDWIDTH);
+    const int length = std::min(size - 1, i + QUAD_COST_BANDWIDTH) - begin + 1;
+    derivative(i) = 2.0 * quad_cost_full_.col(i).segment(begin, length).dot(joint_trajectory.segment(begin, length));
+  }
 }
 
 inline const Eigen::MatrixXd& ChompCost::getQuadraticCostInverse() const
@@ -93,7 +112,16 @@ inline const Eigen::MatrixXd& ChompCost::getQuadraticCost() const
 
 inline double ChompCost::getCost(Eigen::MatrixXd::ColXpr joint_trajectory) const
 {
-  return joint_trajectory.dot(quad_cost_full_ * joint_trajectory);
+  const int size = quad_cost_full_.rows();
+  double cost = 0.0;
+  for (int i = 0; i < size; ++i)
+  {
+    const int begin = std::max(0, i - QUAD_COST_BANDWIDTH);
+    const int length = std::min(size - 1, i + QUAD_COST_BANDWIDTH) - begin + 1;
+    cost += joint_trajectory(i) *
+            quad_cost_full_.col(i).segment(begin, length).dot(joint_trajectory.segment(begin, length));
+  }
+  return cost;
 }
 
 }  // namespace chomp
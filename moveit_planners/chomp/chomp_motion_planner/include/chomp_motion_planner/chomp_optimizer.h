@@ -48,6 +48,7 @@
 
 #include <Eigen/Core>
 
+#include <atomic>
 #include <vector>
 
 namespace chomp
@@ -57,7 +58,8 @@ class ChompOptimizer
 public:
   ChompOptimizer(ChompTrajectory* trajectory, const planning_scene::PlanningSceneConstPtr& planning_scene,
                  const std::string& planning_group, const ChompParameters* parameters,
-                 const moveit::core::RobotState& start_state);
+                 const moveit::core::RobotState& start_state,
+                 const collision_detection::CollisionWorldDistanceField* world_distance_field = NULL);
 
   virtual ~ChompOptimizer();
 
@@ -73,6 +75,17 @@ public:
     return initialized_;
   }
 
+  bool isCollisionFree() const
+  {
+    return is_collision_free_;
+  }
+
+  /** \brief optimize() returns the best iterate found so far as soon as \e terminate becomes true */
+  void setTerminationFlag(const std::atomic<bool>* terminate)
+  {
+    terminate_ = terminate;
+  }
+
 private:
   inline double getPotential(double field_distance, double radius, double clearence)
   {
@@ -105,7 +118,7 @@ private:
   //                     const std::string& group_name,
   //                     Eigen::VectorXd& state_vec);
 
-  void setRobotStateFromPoint(ChompTrajectory& group_trajectory, int i);
+  void setRobotStateFromPoint(ChompTrajectory& group_trajectory, int i, moveit::core::RobotState& state) const;
 
   // collision_proximity::CollisionProximitySpace::TrajectorySafety checkCurrentIterValidity();
 
@@ -128,6 +141,7 @@ private:
   moveit::core::RobotState start_state_;
   const moveit::core::JointModelGroup* joint_model_group_;
   const collision_detection::CollisionWorldHybrid* hy_world_;
+  const collision_detection::CollisionWorldDistanceField* world_distance_field_;
   const collision_detection::CollisionRobotHybrid* hy_robot_;
 
   std::vector<ChompCost> joint_costs_;
@@ -147,6 +161,11 @@ private:
   Eigen::MatrixXd best_group_trajectory_;
   double best_group_trajectory_cost_;
   int last_improvement_iteration_;
+  // the cheapest iterate whose collision cost was below the collision threshold
+  Eigen::MatrixXd best_valid_group_trajectory_;
+  double best_valid_group_trajectory_cost_;
+  int best_valid_iteration_;
+  const std::atomic<bool>* terminate_;
   unsigned int num_collision_free_iterations_;
 
   // HMC stuff:
@@ -166,11 +185,24 @@ private:
   Eigen::MatrixXd collision_increments_;
   Eigen::MatrixXd final_increments_;
 
+  /** \brief The state and temporary variables of one of the threads that compute the forward kinematics, collision
+   * gradients and Jacobians of the trajectory points in parallel */
+  struct ThreadBuffers
+  {
+    ThreadBuffers(const moveit::core::RobotState& state) : state_(state)
+    {
+    }
+
+    moveit::core::RobotState state_;
+    collision_detection::GroupStateRepresentationPtr gsr_;
+    Eigen::Matrix<double, 3, Eigen::Dynamic> jacobian_;
+    Eigen::Matrix<double, Eigen::Dynamic, 3> jacobian_pseudo_inverse_;
+    Eigen::Matrix3d jacobian_jacobian_tranpose_;
+  };
+  std::vector<ThreadBuffers> thread_buffers_;
+
   // temporary variables for all functions:
   Eigen::VectorXd smoothness_derivative_;
-  Eigen::MatrixXd jacobian_;
-  Eigen::MatrixXd jacobian_pseudo_inverse_;
-  Eigen::MatrixXd jacobian_jacobian_tranpose_;
   Eigen::VectorXd random_state_;
   Eigen::VectorXd joint_state_velocities_;
 
@@ -210,8 +242,8 @@ private:
   void getRandomMomentum();
   void updateMomentum();
   void updatePositionFromMomentum();
-  void calculatePseudoInverse();
-  void computeJointProperties(int trajectoryPoint);
+  void calculatePseudoInverse(ThreadBuffers& buffers) const;
+  void computeJointProperties(int trajectoryPoint, moveit::core::RobotState& state);
   bool isCurrentTrajectoryMeshToMeshCollisionFree() const;
 };
 }
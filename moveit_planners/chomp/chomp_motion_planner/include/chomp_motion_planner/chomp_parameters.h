@@ -76,6 +76,8 @@ public:
   double getRandomJumpAmount() const;
   void setRandomJumpAmount(double amount);
   bool getUseStochasticDescent() const;
+  double getMinCostImprovement() const;
+  int getCoarseToFineLevels() const;
 
 public:
   double planning_time_limit_;
@@ -104,6 +106,8 @@ public:
   double collision_threshold_;
   bool filter_mode_;
   double random_jump_amount_;
+  double min_cost_improvement_;
+  int coarse_to_fine_levels_;
 };
 
 /////////////////////// inline functions follow ////////////////////////
@@ -248,6 +252,16 @@ inline bool ChompParameters::getUseStochasticDescent() const
   return use_stochastic_descent_;
 }
 
+inline double ChompParameters::getMinCostImprovement() const
+{
+  return min_cost_improvement_;
+}
+
+inline int ChompParameters::getCoarseToFineLevels() const
+{
+  return coarse_to_fine_levels_;
+}
+
 inline std::string ChompParameters::getAnimateEndeffectorSegment() const
 {
   return animate_endeffector_segment_;
@@ -41,6 +41,10 @@
 #include <moveit_msgs/MotionPlanDetailedResponse.h>
 #include <moveit_msgs/MotionPlanRequest.h>
 #include <moveit/planning_scene/planning_scene.h>
+#include <moveit/robot_trajectory/robot_trajectory.h>
+#include <moveit/collision_distance_field/collision_world_distance_field.h>
+#include <boost/thread/mutex.hpp>
+#include <atomic>
 
 namespace chomp
 {
@@ -52,6 +56,35 @@ public:
 
   bool solve(const planning_scene::PlanningSceneConstPtr& planning_scene, const moveit_msgs::MotionPlanRequest& req,
              const ChompParameters& params, moveit_msgs::MotionPlanDetailedResponse& res) const;
+
+  /** \brief Optimize \e seed_trajectory (e.g. the solution of a sampling-based planner) instead of a minimum-jerk
+   * interpolation between the start and the goal of \e req. The seed is resampled to the CHOMP discretization. */
+  bool solve(const planning_scene::PlanningSceneConstPtr& planning_scene, const moveit_msgs::MotionPlanRequest& req,
+             const ChompParameters& params, const robot_trajectory::RobotTrajectory& seed_trajectory,
+             moveit_msgs::MotionPlanDetailedResponse& res) const;
+
+  /** \brief Make a solve() that is running return the best trajectory it has found so far */
+  void terminate()
+  {
+    terminate_ = true;
+  }
+
+private:
+  bool plan(const planning_scene::PlanningSceneConstPtr& planning_scene, const moveit_msgs::MotionPlanRequest& req,
+            const ChompParameters& params, const robot_trajectory::RobotTrajectory* seed_trajectory,
+            moveit_msgs::MotionPlanDetailedResponse& res) const;
+
+  /** \brief Bring the world distance field kept across requests up to date with the world of \e planning_scene.
+   * Only the objects that changed since the last request are updated. Returns NULL if the scene does not use the
+   * hybrid collision detector. Must be called with world_distance_field_lock_ held. */
+  const collision_detection::CollisionWorldDistanceField*
+  updateWorldDistanceField(const planning_scene::PlanningSceneConstPtr& planning_scene) const;
+
+  mutable boost::mutex world_distance_field_lock_;
+  mutable collision_detection::WorldPtr world_distance_field_world_;
+  mutable collision_detection::CollisionWorldDistanceFieldPtr world_distance_field_;
+  mutable uint64_t world_distance_field_version_;
+  mutable std::atomic<bool> terminate_;
 };
 }
 
@@ -115,6 +115,14 @@ public:
    */
   void fillInMinJerk();
 
+  /**
+   * \brief Fills in the points from start index to end index by linear interpolation of \e source
+   *
+   * \e source is taken to cover the same motion at a different discretization, e.g. a coarser trajectory whose
+   * solution is upsampled.
+   */
+  void fillInFromTrajectory(const ChompTrajectory& source);
+
   /**
    * \brief Sets the start and end index for the modifiable part of the trajectory
    *
@@ -36,7 +36,7 @@
 
 #include <chomp_motion_planner/chomp_cost.h>
 #include <chomp_motion_planner/chomp_utils.h>
-#include <eigen3/Eigen/LU>
+#include <cmath>
 
 using namespace Eigen;
 using namespace std;
@@ -64,12 +64,61 @@ ChompCost::ChompCost(const ChompTrajectory& trajectory, int joint_number, const
   // extract the quad cost just for the free variables:
   quad_cost_ = quad_cost_full_.block(DIFF_RULE_LENGTH - 1, DIFF_RULE_LENGTH - 1, num_vars_free, num_vars_free);
 
-  // invert the matrix:
-  quad_cost_inv_ = quad_cost_.inverse();
+  // the optimizer only needs products with the inverse, which the banded factor gives in linear time; the dense
+  // inverse is still built once (from the factor) for the sampling covariance and the cost scale
+  factorQuadraticCost();
+  quad_cost_inv_ = MatrixXd::Zero(num_vars_free, num_vars_free);
+  for (int i = 0; i < num_vars_free; i++)
+    quad_cost_inv_.col(i) = multiplyByQuadraticCostInverse(VectorXd::Unit(num_vars_free, i));
 
   // cout << quad_cost_inv_ << endl;
 }
 
+void ChompCost::factorQuadraticCost()
+{
+  const int size = quad_cost_.rows();
+  quad_cost_factor_ = MatrixXd::Zero(QUAD_COST_BANDWIDTH + 1, size);
+  for (int j = 0; j < size; j++)
+  {
+    double diagonal = quad_cost_(j, j);
+    for (int k = std::max(0, j - QUAD_COST_BANDWIDTH); k < j; k++)
+      diagonal -= quad_cost_factor_(j - k, k) * quad_cost_factor_(j - k, k);
+    diagonal = sqrt(diagonal);
+    quad_cost_factor_(0, j) = diagonal;
+
+    for (int i = j + 1; i <= std::min(size - 1, j + QUAD_COST_BANDWIDTH); i++)
+    {
+      double value = quad_cost_(i, j);
+      for (int k = std::max(0, i - QUAD_COST_BANDWIDTH); k < j; k++)
+        value -= quad_cost_factor_(i - k, k) * quad_cost_factor_(j - k, k);
+      quad_cost_factor_(i - j, j) = value / diagonal;
+    }
+  }
+}
+
+Eigen::VectorXd ChompCost::multiplyByQuadraticCostInverse(const Eigen::VectorXd& vector) const
+{
+  const int size = quad_cost_factor_.cols();
+  VectorXd result = vector;
+
+  // solve L y = vector
+  for (int i = 0; i < size; i++)
+  {
+    for (int k = std::max(0, i - QUAD_COST_BANDWIDTH); k < i; k++)
+      result(i) -= quad_cost_factor_(i - k, k) * result(k);
+    result(i) /= quad_cost_factor_(0, i);
+  }
+
+  // solve L^T result = y
+  for (int i = size - 1; i >= 0; i--)
+  {
+    for (int k = i + 1; k <= std::min(size - 1, i + QUAD_COST_BANDWIDTH); k++)
+      result(i) -= quad_cost_factor_(k - i, i) * result(k);
+    result(i) /= quad_cost_factor_(0, i);
+  }
+  return result;
+}
+
 Eigen::MatrixXd ChompCost::getDiffMatrix(int size, const double* diff_rule) const
 {
   MatrixXd matrix = MatrixXd::Zero(size, size);
@@ -97,6 +146,7 @@ void ChompCost::scale(double scale)
 {
   double inv_scale = 1.0 / scale;
   quad_cost_inv_ *= inv_scale;
+  quad_cost_factor_ *= sqrt(scale);
   quad_cost_ *= scale;
   quad_cost_full_ *= scale;
 }
@@ -43,9 +43,36 @@
 #include <moveit/planning_scene/planning_scene.h>
 #include <eigen3/Eigen/LU>
 #include <eigen3/Eigen/Core>
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace chomp
 {
+namespace
+{
+// the number of threads that evaluate trajectory points in parallel
+int getMaxThreadCount()
+{
+#ifdef _OPENMP
+  return omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+int getThreadIndex()
+{
+#ifdef _OPENMP
+  return omp_get_thread_num();
+#else
+  return 0;
+#endif
+}
+}
+
 double getRandomDouble()
 {
   return ((double)random() / (double)RAND_MAX);
@@ -53,7 +80,8 @@ double getRandomDouble()
 
 ChompOptimizer::ChompOptimizer(ChompTrajectory* trajectory, const planning_scene::PlanningSceneConstPtr& planning_scene,
                                const std::string& planning_group, const ChompParameters* parameters,
-                               const moveit::core::RobotState& start_state)
+                               const moveit::core::RobotState& start_state,
+                               const collision_detection::CollisionWorldDistanceField* world_distance_field)
   : full_trajectory_(trajectory)
   , kmodel_(planning_scene->getRobotModel())
   , planning_group_(planning_group)
@@ -62,7 +90,9 @@ ChompOptimizer::ChompOptimizer(ChompTrajectory* trajectory, const planning_scene
   , planning_scene_(planning_scene)
   , state_(start_state)
   , start_state_(start_state)
+  , world_distance_field_(world_distance_field)
   , initialized_(false)
+  , terminate_(NULL)
 {
   std::vector<std::string> cd_names;
   planning_scene->getCollisionDetectorNames(cd_names);
@@ -84,6 +114,8 @@ ChompOptimizer::ChompOptimizer(ChompTrajectory* trajectory, const planning_scene
     ROS_WARN_STREAM("Could not initialize hybrid collision world from planning scene");
     return;
   }
+  if (!world_distance_field_)
+    world_distance_field_ = hy_world_->getCollisionWorldDistanceField().get();
 
   hy_robot_ = dynamic_cast<const collision_detection::CollisionRobotHybrid*>(
       planning_scene->getCollisionRobot(planning_scene->getActiveCollisionDetectorName()).get());
@@ -109,8 +141,8 @@ void ChompOptimizer::initialize()
   collision_detection::CollisionResult res;
   req.group_name = planning_group_;
   ros::WallTime wt = ros::WallTime::now();
-  hy_world_->getCollisionGradients(req, res, *hy_robot_->getCollisionRobotDistanceField().get(), state_,
-                                   &planning_scene_->getAllowedCollisionMatrix(), gsr_);
+  world_distance_field_->getCollisionGradients(req, res, *hy_robot_->getCollisionRobotDistanceField().get(), state_,
+                                               &planning_scene_->getAllowedCollisionMatrix(), gsr_);
   ROS_INFO_STREAM("First coll check took " << (ros::WallTime::now() - wt));
   num_collision_points_ = 0;
   for (size_t i = 0; i < gsr_->gradients_.size(); i++)
@@ -153,12 +185,32 @@ void ChompOptimizer::initialize()
   collision_increments_ = Eigen::MatrixXd::Zero(num_vars_free_, num_joints_);
   final_increments_ = Eigen::MatrixXd::Zero(num_vars_free_, num_joints_);
   smoothness_derivative_ = Eigen::VectorXd::Zero(num_vars_all_);
-  jacobian_ = Eigen::MatrixXd::Zero(3, num_joints_);
-  jacobian_pseudo_inverse_ = Eigen::MatrixXd::Zero(num_joints_, 3);
-  jacobian_jacobian_tranpose_ = Eigen::MatrixXd::Zero(3, 3);
   random_state_ = Eigen::VectorXd::Zero(num_joints_);
   joint_state_velocities_ = Eigen::VectorXd::Zero(num_joints_);
 
+  // each thread that evaluates trajectory points has its own robot state and collision checking structures; they are
+  // generated here, one at a time, so that the threads only update them
+  int thread_count = std::max(1, std::min(getMaxThreadCount(), num_vars_all_));
+  thread_buffers_.clear();
+  thread_buffers_.reserve(thread_count);
+  for (int t = 0; t < thread_count; ++t)
+  {
+    thread_buffers_.push_back(ThreadBuffers(state_));
+    ThreadBuffers& buffers = thread_buffers_.back();
+    if (t == 0)
+      buffers.gsr_ = gsr_;
+    else
+    {
+      collision_detection::CollisionResult thread_res;
+      world_distance_field_->getCollisionGradients(req, thread_res, *hy_robot_->getCollisionRobotDistanceField().get(),
+                                                   buffers.state_, &planning_scene_->getAllowedCollisionMatrix(),
+                                                   buffers.gsr_);
+    }
+    buffers.jacobian_ = Eigen::Matrix<double, 3, Eigen::Dynamic>::Zero(3, num_joints_);
+    buffers.jacobian_pseudo_inverse_ = Eigen::Matrix<double, Eigen::Dynamic, 3>::Zero(num_joints_, 3);
+    buffers.jacobian_jacobian_tranpose_ = Eigen::Matrix3d::Zero();
+  }
+
   group_trajectory_backup_ = group_trajectory_.getTrajectory();
   best_group_trajectory_ = group_trajectory_.getTrajectory();
 
@@ -179,6 +231,7 @@ void ChompOptimizer::initialize()
   point_is_in_collision_.resize(num_vars_all_, std::vector<int>(num_collision_points_));
 
   last_improvement_iteration_ = -1;
+  best_valid_iteration_ = -1;
 
   // HMC initialization:
   momentum_ = Eigen::MatrixXd::Zero(num_vars_free_, num_joints_);
@@ -332,6 +385,7 @@ void ChompOptimizer::optimize()
   std::vector<double> costs(costWindow, 0.0);
   double minimaThreshold = 0.05;
   bool should_break_out = false;
+  double previous_cost = 0.0;
 
   // if(parameters_->getAnimatePath())
   // {
@@ -341,6 +395,11 @@ void ChompOptimizer::optimize()
   // iterate
   for (iteration_ = 0; iteration_ < parameters_->getMaxIterations(); iteration_++)
   {
+    if (terminate_ && *terminate_)
+    {
+      ROS_WARN("Chomp was terminated at iteration %d", iteration_);
+      break;
+    }
     ros::WallTime for_time = ros::WallTime::now();
     performForwardKinematics();
     ROS_INFO_STREAM("Forward kinematics took " << (ros::WallTime::now() - for_time));
@@ -380,6 +439,22 @@ void ChompOptimizer::optimize()
         last_improvement_iteration_ = iteration_;
       }
     }
+
+    // a valid iterate that barely improves on the previous one is as good as the optimization gets
+    bool is_valid = cCost < parameters_->getCollisionThreshold();
+    if (is_valid && (best_valid_iteration_ < 0 || cost < best_valid_group_trajectory_cost_))
+    {
+      best_valid_group_trajectory_ = group_trajectory_.getTrajectory();
+      best_valid_group_trajectory_cost_ = cost;
+      best_valid_iteration_ = iteration_;
+    }
+    if (is_valid && iteration_ > 0 && parameters_->getMinCostImprovement() > 0.0 &&
+        previous_cost - cost < parameters_->getMinCostImprovement() * fabs(previous_cost))
+    {
+      ROS_INFO("Chomp converged at iteration %d with cost %f", iteration_, cost);
+      break;
+    }
+    previous_cost = cost;
     calculateSmoothnessIncrements();
     ros::WallTime coll_time = ros::WallTime::now();
     calculateCollisionIncrements();
@@ -452,8 +527,7 @@ void ChompOptimizer::optimize()
       }
     }
 
-    if ((ros::WallTime::now() - start_time).toSec() > parameters_->getPlanningTimeLimit() &&
-        !parameters_->getAnimatePath() && !parameters_->getAnimateEndeffector())
+    if ((ros::WallTime::now() - start_time).toSec() > parameters_->getPlanningTimeLimit())
     {
       ROS_WARN("Breaking out early due to time limit constraints.");
       break;
@@ -548,7 +622,14 @@ void ChompOptimizer::optimize()
   //   animatePath();
   // }
 
-  group_trajectory_.getTrajectory() = best_group_trajectory_;
+  // prefer the cheapest iterate that was considered collision free over the cheapest one overall
+  if (best_valid_iteration_ >= 0)
+  {
+    group_trajectory_.getTrajectory() = best_valid_group_trajectory_;
+    last_improvement_iteration_ = best_valid_iteration_;
+  }
+  else
+    group_trajectory_.getTrajectory() = best_group_trajectory_;
   updateFullTrajectory();
 
   // if(parameters_->getAnimatePath())
@@ -620,15 +701,6 @@ void ChompOptimizer::calculateSmoothnessIncrements()
 
 void ChompOptimizer::calculateCollisionIncrements()
 {
-  double potential;
-  double vel_mag_sq;
-  double vel_mag;
-  Eigen::Vector3d potential_gradient;
-  Eigen::Vector3d normalized_velocity;
-  Eigen::Matrix3d orthogonal_projector;
-  Eigen::Vector3d curvature_vector;
-  Eigen::Vector3d cartesian_gradient;
-
   collision_increments_.setZero(num_vars_free_, num_joints_);
 
   int startPoint = 0;
@@ -650,8 +722,21 @@ void ChompOptimizer::calculateCollisionIncrements()
     startPoint = free_vars_start_;
   }
 
+  // the increments of each point are computed from that point only, on the thread's Jacobian buffers
+  const int thread_count = thread_buffers_.size();
+#pragma omp parallel for num_threads(thread_count)
   for (int i = startPoint; i <= endPoint; i++)
   {
+    ThreadBuffers& buffers = thread_buffers_[getThreadIndex()];
+    double potential;
+    double vel_mag_sq;
+    double vel_mag;
+    Eigen::Vector3d potential_gradient;
+    Eigen::Vector3d normalized_velocity;
+    Eigen::Matrix3d orthogonal_projector;
+    Eigen::Vector3d curvature_vector;
+    Eigen::Vector3d cartesian_gradient;
+
     for (int j = 0; j < num_collision_points_; j++)
     {
       potential = collision_point_potential_[i][j];
@@ -672,16 +757,18 @@ void ChompOptimizer::calculateCollisionIncrements()
       cartesian_gradient = vel_mag * (orthogonal_projector * potential_gradient - potential * curvature_vector);
 
       // pass it through the jacobian transpose to get the increments
-      getJacobian(i, collision_point_pos_eigen_[i][j], collision_point_joint_names_[i][j], jacobian_);
+      getJacobian(i, collision_point_pos_eigen_[i][j], collision_point_joint_names_[i][j], buffers.jacobian_);
 
       if (parameters_->getUsePseudoInverse())
       {
-        calculatePseudoInverse();
-        collision_increments_.row(i - free_vars_start_).transpose() -= jacobian_pseudo_inverse_ * cartesian_gradient;
+        calculatePseudoInverse(buffers);
+        collision_increments_.row(i - free_vars_start_).transpose() -=
+            buffers.jacobian_pseudo_inverse_ * cartesian_gradient;
       }
       else
       {
-        collision_increments_.row(i - free_vars_start_).transpose() -= jacobian_.transpose() * cartesian_gradient;
+        collision_increments_.row(i - free_vars_start_).transpose() -=
+            buffers.jacobian_.transpose() * cartesian_gradient;
       }
 
       /*
@@ -695,11 +782,11 @@ void ChompOptimizer::calculateCollisionIncrements()
   // cout << collision_increments_ << endl;
 }
 
-void ChompOptimizer::calculatePseudoInverse()
+void ChompOptimizer::calculatePseudoInverse(ThreadBuffers& buffers) const
 {
-  jacobian_jacobian_tranpose_ =
-      jacobian_ * jacobian_.transpose() + Eigen::MatrixXd::Identity(3, 3) * parameters_->getPseudoInverseRidgeFactor();
-  jacobian_pseudo_inverse_ = jacobian_.transpose() * jacobian_jacobian_tranpose_.inverse();
+  buffers.jacobian_jacobian_tranpose_ = buffers.jacobian_ * buffers.jacobian_.transpose() +
+                                        Eigen::Matrix3d::Identity() * parameters_->getPseudoInverseRidgeFactor();
+  buffers.jacobian_pseudo_inverse_ = buffers.jacobian_.transpose() * buffers.jacobian_jacobian_tranpose_.inverse();
 }
 
 void ChompOptimizer::calculateTotalIncrements()
@@ -707,9 +794,9 @@ void ChompOptimizer::calculateTotalIncrements()
   for (int i = 0; i < num_joints_; i++)
   {
     final_increments_.col(i) =
-        parameters_->getLearningRate() * (joint_costs_[i].getQuadraticCostInverse() *
-                                          (parameters_->getSmoothnessCostWeight() * smoothness_increments_.col(i) +
-                                           parameters_->getObstacleCostWeight() * collision_increments_.col(i)));
+        parameters_->getLearningRate() * joint_costs_[i].multiplyByQuadraticCostInverse(
+                                             parameters_->getSmoothnessCostWeight() * smoothness_increments_.col(i) +
+                                             parameters_->getObstacleCostWeight() * collision_increments_.col(i));
   }
 }
 
@@ -787,12 +874,12 @@ double ChompOptimizer::getCollisionCost()
   return parameters_->getObstacleCostWeight() * collision_cost;
 }
 
-void ChompOptimizer::computeJointProperties(int trajectory_point)
+void ChompOptimizer::computeJointProperties(int trajectory_point, moveit::core::RobotState& state)
 {
   // tf::Transform inverseWorldTransform = collision_space_->getInverseWorldTransform(*state_);
   for (int j = 0; j < num_joints_; j++)
   {
-    const moveit::core::JointModel* joint_model = state_.getJointModel(joint_names_[j]);
+    const moveit::core::JointModel* joint_model = state.getJointModel(joint_names_[j]);
     const moveit::core::RevoluteJointModel* revolute_joint =
         dynamic_cast<const moveit::core::RevoluteJointModel*>(joint_model);
     const moveit::core::PrismaticJointModel* prismatic_joint =
@@ -801,8 +888,8 @@ void ChompOptimizer::computeJointProperties(int trajectory_point)
     std::string parent_link_name = joint_model->getParentLinkModel()->getName();
     std::string child_link_name = joint_model->getChildLinkModel()->getName();
     Eigen::Affine3d joint_transform =
-        state_.getGlobalLinkTransform(parent_link_name) *
-        (kmodel_->getLinkModel(child_link_name)->getJointOriginTransform() * (state_.getJointTransform(joint_model)));
+        state.getGlobalLinkTransform(parent_link_name) *
+        (kmodel_->getLinkModel(child_link_name)->getJointOriginTransform() * (state.getJointTransform(joint_model)));
 
     // joint_transform = inverseWorldTransform * jointTransform;
     Eigen::Vector3d axis;
@@ -922,10 +1009,10 @@ void ChompOptimizer::handleJointLimits()
       if (violation)
       {
         int free_var_index = max_violation_index - free_vars_start_;
-        double multiplier =
-            max_violation / joint_costs_[joint_i].getQuadraticCostInverse()(free_var_index, free_var_index);
-        group_trajectory_.getFreeJointTrajectoryBlock(joint_i) +=
-            multiplier * joint_costs_[joint_i].getQuadraticCostInverse().col(free_var_index);
+        Eigen::VectorXd inverse_column = joint_costs_[joint_i].multiplyByQuadraticCostInverse(
+            Eigen::VectorXd::Unit(num_vars_free_, free_var_index));
+        double multiplier = max_violation / inverse_column(free_var_index);
+        group_trajectory_.getFreeJointTrajectoryBlock(joint_i) += multiplier * inverse_column;
       }
       if (++count > 10)
         break;
@@ -947,31 +1034,31 @@ void ChompOptimizer::performForwardKinematics()
     end = num_vars_all_ - 1;
   }
 
-  is_collision_free_ = true;
-
-  ros::WallDuration total_dur(0.0);
-
-  // for each point in the trajectory
+  // for each point in the trajectory; the points are independent, so they are evaluated in parallel, each thread
+  // with its own robot state and collision checking structures
+  const int thread_count = thread_buffers_.size();
+#pragma omp parallel for num_threads(thread_count)
   for (int i = start; i <= end; ++i)
   {
+    ThreadBuffers& buffers = thread_buffers_[getThreadIndex()];
+
     // Set Robot state from trajectory point...
     collision_detection::CollisionRequest req;
     collision_detection::CollisionResult res;
     req.group_name = planning_group_;
-    setRobotStateFromPoint(group_trajectory_, i);
-    ros::WallTime grad = ros::WallTime::now();
+    setRobotStateFromPoint(group_trajectory_, i, buffers.state_);
 
-    hy_world_->getCollisionGradients(req, res, *hy_robot_->getCollisionRobotDistanceField().get(), state_, NULL, gsr_);
-    total_dur += (ros::WallTime::now() - grad);
-    computeJointProperties(i);
+    world_distance_field_->getCollisionGradients(req, res, *hy_robot_->getCollisionRobotDistanceField().get(),
+                                                 buffers.state_, NULL, buffers.gsr_);
+    computeJointProperties(i, buffers.state_);
     state_is_in_collision_[i] = false;
 
     // Keep vars in scope
     {
       size_t j = 0;
-      for (size_t g = 0; g < gsr_->gradients_.size(); g++)
+      for (size_t g = 0; g < buffers.gsr_->gradients_.size(); g++)
       {
-        collision_detection::GradientInfo& info = gsr_->gradients_[g];
+        collision_detection::GradientInfo& info = buffers.gsr_->gradients_[g];
 
         for (size_t k = 0; k < info.sphere_locations.size(); k++)
         {
@@ -999,7 +1086,6 @@ void ChompOptimizer::performForwardKinematics()
             //   ROS_INFO_STREAM("Radius " << info.sphere_radii[k] << " potential " <<
             //   collision_point_potential_[i][j]);
             // }
-            is_collision_free_ = false;
           }
           j++;
         }
@@ -1007,7 +1093,10 @@ void ChompOptimizer::performForwardKinematics()
     }
   }
 
-  // ROS_INFO_STREAM("Total dur " << total_dur << " total checks " << end-start+1);
+  is_collision_free_ = true;
+  for (int i = start; i <= end; ++i)
+    if (state_is_in_collision_[i])
+      is_collision_free_ = false;
 
   // now, get the vel and acc for each collision point (using finite differencing)
   for (int i = free_vars_start_; i <= free_vars_end_; i++)
@@ -1030,7 +1119,8 @@ void ChompOptimizer::performForwardKinematics()
   }
 }
 
-void ChompOptimizer::setRobotStateFromPoint(ChompTrajectory& group_trajectory, int i)
+void ChompOptimizer::setRobotStateFromPoint(ChompTrajectory& group_trajectory, int i,
+                                            moveit::core::RobotState& state) const
 {
   const Eigen::MatrixXd::RowXpr& point = group_trajectory.getTrajectoryPoint(i);
 
@@ -1040,8 +1130,8 @@ void ChompOptimizer::setRobotStateFromPoint(ChompTrajectory& group_trajectory, i
     joint_states.push_back(point(0, j));
   }
 
-  state_.setJointGroupPositions(planning_group_, joint_states);
-  state_.update();
+  state.setJointGroupPositions(planning_group_, joint_states);
+  state.update();
 }
 
 void ChompOptimizer::perturbTrajectory()
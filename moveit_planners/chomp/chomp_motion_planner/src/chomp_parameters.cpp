@@ -66,6 +66,8 @@ ChompParameters::ChompParameters()
   random_jump_amount_ = 1.0;
   use_stochastic_descent_ = true;
   filter_mode_ = false;
+  min_cost_improvement_ = 0.0;
+  coarse_to_fine_levels_ = 1;
 }
 
 ChompParameters::~ChompParameters()
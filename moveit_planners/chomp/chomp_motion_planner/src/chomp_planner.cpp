@@ -39,17 +39,136 @@
 #include <chomp_motion_planner/chomp_trajectory.h>
 #include <chomp_motion_planner/chomp_optimizer.h>
 #include <moveit/robot_state/conversions.h>
+#include <moveit/collision_distance_field/collision_world_hybrid.h>
 #include <moveit_msgs/MotionPlanRequest.h>
+#include <algorithm>
 
 namespace chomp
 {
-ChompPlanner::ChompPlanner()
+namespace
 {
+// the coarsest level of a coarse-to-fine optimization keeps at least this many time steps
+static const int MIN_COARSE_TRAJECTORY_SEGMENTS = 10;
+
+bool sameFieldGeometry(const distance_field::DistanceField& a, const distance_field::DistanceField& b)
+{
+  return a.getResolution() == b.getResolution() && a.getSizeX() == b.getSizeX() && a.getSizeY() == b.getSizeY() &&
+         a.getSizeZ() == b.getSizeZ() && a.getOriginX() == b.getOriginX() && a.getOriginY() == b.getOriginY() &&
+         a.getOriginZ() == b.getOriginZ();
+}
+
+// place the points of the CHOMP trajectory at equal joint-space distances along the seed path
+void resampleSeedTrajectory(const robot_trajectory::RobotTrajectory& seed, const moveit::core::JointModelGroup* group,
+                            ChompTrajectory& trajectory)
+{
+  const std::vector<const moveit::core::JointModel*>& joints = group->getActiveJointModels();
+  std::vector<double> length(seed.getWayPointCount(), 0.0);
+  for (std::size_t k = 1; k < seed.getWayPointCount(); ++k)
+    length[k] = length[k - 1] + seed.getWayPoint(k - 1).distance(seed.getWayPoint(k), group);
+
+  moveit::core::RobotState state(seed.getFirstWayPoint());
+  const int num_points = trajectory.getNumPoints();
+  std::size_t segment = 0;
+  for (int i = 0; i < num_points; ++i)
+  {
+    const double target = length.back() * i / (num_points - 1);
+    while (segment + 2 < length.size() && length[segment + 1] < target)
+      ++segment;
+    if (length.size() > 1)
+    {
+      const double segment_length = length[segment + 1] - length[segment];
+      const double t = segment_length > 0.0 ? std::min(1.0, (target - length[segment]) / segment_length) : 1.0;
+      seed.getWayPoint(segment).interpolate(seed.getWayPoint(segment + 1), t, state, group);
+    }
+    for (std::size_t j = 0; j < joints.size(); ++j)
+      trajectory(i, j) = state.getJointPositions(joints[j])[0];
+  }
+}
+}
+
+ChompPlanner::ChompPlanner() : world_distance_field_version_(0), terminate_(false)
+{
+}
+
+const collision_detection::CollisionWorldDistanceField*
+ChompPlanner::updateWorldDistanceField(const planning_scene::PlanningSceneConstPtr& planning_scene) const
+{
+  const collision_detection::CollisionWorldHybrid* hy_world =
+      dynamic_cast<const collision_detection::CollisionWorldHybrid*>(
+          planning_scene->getCollisionWorld(planning_scene->getActiveCollisionDetectorName()).get());
+  if (!hy_world)
+    return NULL;
+  collision_detection::CollisionWorldDistanceFieldConstPtr scene_field = hy_world->getCollisionWorldDistanceField();
+
+  // the first request (or a change of field geometry) pays for the full propagation
+  if (!world_distance_field_ ||
+      !sameFieldGeometry(*world_distance_field_->getDistanceField(), *scene_field->getDistanceField()))
+  {
+    world_distance_field_world_.reset(new collision_detection::World(*planning_scene->getWorld()));
+    world_distance_field_.reset(
+        new collision_detection::CollisionWorldDistanceField(*scene_field, world_distance_field_world_));
+    world_distance_field_version_ = planning_scene->getWorldVersion();
+    return world_distance_field_.get();
+  }
+  if (world_distance_field_version_ == planning_scene->getWorldVersion())
+    return world_distance_field_.get();
+
+  // apply only the differences; the field observes its world and updates the affected cells
+  ros::WallTime start_time = ros::WallTime::now();
+  const collision_detection::World& world = *planning_scene->getWorld();
+  std::vector<std::string> ids = world_distance_field_world_->getObjectIds();
+  for (std::size_t i = 0; i < ids.size(); ++i)
+    if (!world.hasObject(ids[i]))
+      world_distance_field_world_->removeObject(ids[i]);
+
+  for (collision_detection::World::const_iterator it = world.begin(); it != world.end(); ++it)
+  {
+    const collision_detection::World::ObjectConstPtr& obj = it->second;
+    collision_detection::World::ObjectConstPtr cached = world_distance_field_world_->getObject(it->first);
+    // objects the scene did not touch are still shared with the copy kept here
+    if (cached == obj)
+      continue;
+    if (cached && cached->shapes_ == obj->shapes_)
+    {
+      for (std::size_t i = 0; i < obj->shapes_.size(); ++i)
+        if (!(cached->shape_poses_[i].matrix() == obj->shape_poses_[i].matrix()))
+          world_distance_field_world_->moveShapeInObject(it->first, obj->shapes_[i], obj->shape_poses_[i]);
+      continue;
+    }
+    if (cached)
+      world_distance_field_world_->removeObject(it->first);
+    world_distance_field_world_->addToObject(it->first, obj->shapes_, obj->shape_poses_);
+  }
+  world_distance_field_version_ = planning_scene->getWorldVersion();
+  ROS_DEBUG("Updating the world distance field took %f sec", (ros::WallTime::now() - start_time).toSec());
+  return world_distance_field_.get();
+}
+
+bool ChompPlanner::solve(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                         const moveit_msgs::MotionPlanRequest& req, const chomp::ChompParameters& params,
+                         moveit_msgs::MotionPlanDetailedResponse& res) const
+{
+  return plan(planning_scene, req, params, NULL, res);
 }
 
 bool ChompPlanner::solve(const planning_scene::PlanningSceneConstPtr& planning_scene,
                          const moveit_msgs::MotionPlanRequest& req, const chomp::ChompParameters& params,
+                         const robot_trajectory::RobotTrajectory& seed_trajectory,
                          moveit_msgs::MotionPlanDetailedResponse& res) const
+{
+  if (seed_trajectory.empty() || seed_trajectory.getGroupName() != req.group_name)
+  {
+    ROS_ERROR("The seed trajectory is empty or not for group '%s'", req.group_name.c_str());
+    res.error_code.val = moveit_msgs::MoveItErrorCodes::INVALID_MOTION_PLAN;
+    return false;
+  }
+  return plan(planning_scene, req, params, &seed_trajectory, res);
+}
+
+bool ChompPlanner::plan(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                        const moveit_msgs::MotionPlanRequest& req, const chomp::ChompParameters& params,
+                        const robot_trajectory::RobotTrajectory* seed_trajectory,
+                        moveit_msgs::MotionPlanDetailedResponse& res) const
 {
   if (!planning_scene)
     ROS_ERROR_STREAM("No planning scene initialized.");
@@ -59,44 +178,53 @@ bool ChompPlanner::solve(const planning_scene::PlanningSceneConstPtr& planning_s
   }
   ros::WallTime start_time = ros::WallTime::now();
   ChompTrajectory trajectory(planning_scene->getRobotModel(), 3.0, .03, req.group_name);
-  jointStateToArray(planning_scene->getRobotModel(), req.start_state.joint_state, req.group_name,
-                    trajectory.getTrajectoryPoint(0));
-
   int goal_index = trajectory.getNumPoints() - 1;
-  trajectory.getTrajectoryPoint(goal_index) = trajectory.getTrajectoryPoint(0);
-  sensor_msgs::JointState js;
-  for (unsigned int i = 0; i < req.goal_constraints[0].joint_constraints.size(); i++)
-  {
-    js.name.push_back(req.goal_constraints[0].joint_constraints[i].joint_name);
-    js.position.push_back(req.goal_constraints[0].joint_constraints[i].position);
-    ROS_INFO_STREAM("Setting joint " << req.goal_constraints[0].joint_constraints[i].joint_name << " to position "
-                                     << req.goal_constraints[0].joint_constraints[i].position);
-  }
-  jointStateToArray(planning_scene->getRobotModel(), js, req.group_name, trajectory.getTrajectoryPoint(goal_index));
-
   const moveit::core::JointModelGroup* model_group =
       planning_scene->getRobotModel()->getJointModelGroup(req.group_name);
-  // fix the goal to move the shortest angular distance for wrap-around joints:
-  for (size_t i = 0; i < model_group->getActiveJointModels().size(); i++)
+
+  if (seed_trajectory)
+  {
+    // the seed already connects start and goal; the optimizer only has to smooth it
+    resampleSeedTrajectory(*seed_trajectory, model_group, trajectory);
+  }
+  else
   {
-    const moveit::core::JointModel* model = model_group->getActiveJointModels()[i];
-    const moveit::core::RevoluteJointModel* revolute_joint =
-        dynamic_cast<const moveit::core::RevoluteJointModel*>(model);
+    jointStateToArray(planning_scene->getRobotModel(), req.start_state.joint_state, req.group_name,
+                      trajectory.getTrajectoryPoint(0));
+
+    trajectory.getTrajectoryPoint(goal_index) = trajectory.getTrajectoryPoint(0);
+    sensor_msgs::JointState js;
+    for (unsigned int i = 0; i < req.goal_constraints[0].joint_constraints.size(); i++)
+    {
+      js.name.push_back(req.goal_constraints[0].joint_constraints[i].joint_name);
+      js.position.push_back(req.goal_constraints[0].joint_constraints[i].position);
+      ROS_INFO_STREAM("Setting joint " << req.goal_constraints[0].joint_constraints[i].joint_name << " to position "
+                                       << req.goal_constraints[0].joint_constraints[i].position);
+    }
+    jointStateToArray(planning_scene->getRobotModel(), js, req.group_name, trajectory.getTrajectoryPoint(goal_index));
 
-    if (revolute_joint != NULL)
+    // fix the goal to move the shortest angular distance for wrap-around joints:
+    for (size_t i = 0; i < model_group->getActiveJointModels().size(); i++)
     {
-      if (revolute_joint->isContinuous())
+      const moveit::core::JointModel* model = model_group->getActiveJointModels()[i];
+      const moveit::core::RevoluteJointModel* revolute_joint =
+          dynamic_cast<const moveit::core::RevoluteJointModel*>(model);
+
+      if (revolute_joint != NULL)
       {
-        double start = (trajectory)(0, i);
-        double end = (trajectory)(goal_index, i);
-        ROS_INFO_STREAM("Start is " << start << " end " << end << " short " << shortestAngularDistance(start, end));
-        (trajectory)(goal_index, i) = start + shortestAngularDistance(start, end);
+        if (revolute_joint->isContinuous())
+        {
+          double start = (trajectory)(0, i);
+          double end = (trajectory)(goal_index, i);
+          ROS_INFO_STREAM("Start is " << start << " end " << end << " short " << shortestAngularDistance(start, end));
+          (trajectory)(goal_index, i) = start + shortestAngularDistance(start, end);
+        }
       }
     }
-  }
 
-  // fill in an initial quintic spline trajectory
-  trajectory.fillInMinJerk();
+    // fill in an initial quintic spline trajectory
+    trajectory.fillInMinJerk();
+  }
 
   // optimize!
   moveit::core::RobotState start_state(planning_scene->getCurrentState());
@@ -104,16 +232,68 @@ bool ChompPlanner::solve(const planning_scene::PlanningSceneConstPtr& planning_s
   start_state.update();
 
   ros::WallTime create_time = ros::WallTime::now();
-  ChompOptimizer optimizer(&trajectory, planning_scene, req.group_name, &params, start_state);
-  if (!optimizer.isInitialized())
+  boost::mutex::scoped_lock slock(world_distance_field_lock_);
+  terminate_ = false;
+
+  const collision_detection::CollisionWorldDistanceField* world_distance_field =
+      updateWorldDistanceField(planning_scene);
+
+  // coarse-to-fine: each level doubles the time step of the next finer one; the coarsest level starts from the
+  // initial trajectory, every other level from the upsampled solution of the level before it
+  int levels = std::max(1, params.getCoarseToFineLevels());
+  while (levels > 1 && (trajectory.getNumPoints() - 1) / (1 << (levels - 1)) < MIN_COARSE_TRAJECTORY_SEGMENTS)
+    --levels;
+
+  boost::shared_ptr<ChompTrajectory> previous_level;
+  for (int level = levels - 1; level >= 0; --level)
   {
-    ROS_WARN_STREAM("Could not initialize optimizer");
-    res.error_code.val = moveit_msgs::MoveItErrorCodes::PLANNING_FAILED;
-    return false;
+    boost::shared_ptr<ChompTrajectory> coarse_trajectory;
+    ChompTrajectory* level_trajectory = &trajectory;
+    if (level > 0)
+    {
+      const int factor = 1 << level;
+      coarse_trajectory.reset(new ChompTrajectory(planning_scene->getRobotModel(),
+                                                  (trajectory.getNumPoints() - 1) / factor + 1,
+                                                  trajectory.getDiscretization() * factor, req.group_name));
+      level_trajectory = coarse_trajectory.get();
+      level_trajectory->getTrajectoryPoint(0) = trajectory.getTrajectoryPoint(0);
+      level_trajectory->getTrajectoryPoint(level_trajectory->getNumPoints() - 1) =
+          trajectory.getTrajectoryPoint(goal_index);
+    }
+    if (coarse_trajectory || previous_level)
+      level_trajectory->fillInFromTrajectory(previous_level ? *previous_level : trajectory);
+
+    // the optimizer stops at the time limit of the parameters or the time the request still allows, whichever is
+    // less
+    ChompParameters optimizer_params = params;
+    if (req.allowed_planning_time > 0.0)
+    {
+      double remaining_time = req.allowed_planning_time - (ros::WallTime::now() - start_time).toSec();
+      optimizer_params.setPlanningTimeLimit(std::min(params.getPlanningTimeLimit(), remaining_time));
+    }
+    ChompOptimizer optimizer(level_trajectory, planning_scene, req.group_name, &optimizer_params, start_state,
+                             world_distance_field);
+    optimizer.setTerminationFlag(&terminate_);
+    if (!optimizer.isInitialized())
+    {
+      ROS_WARN_STREAM("Could not initialize optimizer");
+      res.error_code.val = moveit_msgs::MoveItErrorCodes::PLANNING_FAILED;
+      return false;
+    }
+    ROS_INFO("Optimization took %f sec to create", (ros::WallTime::now() - create_time).toSec());
+    if (levels > 1)
+      ROS_INFO("Optimizing level %d of %d with %d points", levels - level, levels, level_trajectory->getNumPoints());
+    optimizer.optimize();
+    previous_level = coarse_trajectory;
+
+    // a terminated request still returns the best trajectory found so far, at the full resolution
+    if (terminate_)
+    {
+      if (previous_level)
+        trajectory.fillInFromTrajectory(*previous_level);
+      break;
+    }
   }
-  ROS_INFO("Optimization took %f sec to create", (ros::WallTime::now() - create_time).toSec());
-  ROS_INFO("Optimization took %f sec to create", (ros::WallTime::now() - create_time).toSec());
-  optimizer.optimize();
   ROS_INFO("Optimization actually took %f sec to run", (ros::WallTime::now() - create_time).toSec());
   create_time = ros::WallTime::now();
   // assume that the trajectory is now optimized, fill in the output structure:
@@ -36,6 +36,7 @@
 
 #include <ros/ros.h>
 #include <chomp_motion_planner/chomp_trajectory.h>
+#include <algorithm>
 #include <iostream>
 
 namespace chomp
@@ -170,6 +171,19 @@ void ChompTrajectory::updateFromGroupTrajectory(const ChompTrajectory& group_tra
   }
 }
 
+void ChompTrajectory::fillInFromTrajectory(const ChompTrajectory& source)
+{
+  const double scale = double(source.getNumPoints() - 1) / (num_points_ - 1);
+  for (int i = start_index_; i <= end_index_; i++)
+  {
+    double position = i * scale;
+    int index = std::min(int(position), source.getNumPoints() - 2);
+    double t = position - index;
+    for (int j = 0; j < num_joints_; j++)
+      (*this)(i, j) = (1.0 - t) * source(index, j) + t * source(index + 1, j);
+  }
+}
+
 void ChompTrajectory::fillInMinJerk()
 {
   double start_index = start_index_ - 1;
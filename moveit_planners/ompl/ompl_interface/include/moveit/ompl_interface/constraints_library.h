@@ -50,6 +50,57 @@ typedef std::pair<std::vector<std::size_t>, std::map<std::size_t, std::pair<std:
     ConstrainedStateMetadata;
 typedef ompl::base::StateStorageWithMetadata<ConstrainedStateMetadata> ConstraintApproximationStateStorage;
 
+MOVEIT_CLASS_FORWARD(ConstraintApproximationDatabase)
+
+/** \brief Read access to the states and connections of a constraint approximation.
+
+    The states are either held in memory, as they are after construction, or mapped from a database file
+    and read lazily. All access is read-only, so a database can be shared by several planning threads. */
+class ConstraintApproximationDatabase
+{
+public:
+  ConstraintApproximationDatabase(const ompl::base::StateSpacePtr& space) : space_(space)
+  {
+  }
+
+  virtual ~ConstraintApproximationDatabase()
+  {
+  }
+
+  const ompl::base::StateSpacePtr& getStateSpace() const
+  {
+    return space_;
+  }
+
+  /** \brief The number of stored states, milestones first */
+  virtual std::size_t size() const = 0;
+
+  /** \brief Copy the stored state \e index, including its tag, to \e state */
+  virtual void copyState(std::size_t index, ompl::base::State* state) const = 0;
+
+  /** \brief The number of milestones connected to milestone \e index */
+  virtual std::size_t getConnectionCount(std::size_t index) const = 0;
+
+  /** \brief The \e k-th milestone connected to milestone \e index */
+  virtual std::size_t getConnection(std::size_t index, std::size_t k) const = 0;
+
+  /** \brief Get the range of stored states making up the explicit motion between milestones \e from and \e to
+      \return False if there is no explicit motion between the two milestones */
+  virtual bool getMotion(std::size_t from, std::size_t to, std::pair<std::size_t, std::size_t>& states) const = 0;
+
+  /** \brief Write the database to \e filename in the format read by loadConstraintApproximationDatabase() */
+  bool store(const std::string& filename) const;
+
+protected:
+  ompl::base::StateSpacePtr space_;
+};
+
+/** \brief Open the database stored in \e filename for \e space. Databases written by
+    ConstraintApproximationDatabase::store() are memory-mapped; older files are deserialized into memory.
+    \return An empty pointer if the file cannot be read or does not match \e space */
+ConstraintApproximationDatabasePtr loadConstraintApproximationDatabase(const std::string& filename,
+                                                                       const ompl::base::StateSpacePtr& space);
+
 MOVEIT_CLASS_FORWARD(ConstraintApproximation)
 
 class ConstraintApproximation
@@ -59,6 +110,10 @@ public:
                           bool explicit_motions, const moveit_msgs::Constraints& msg, const std::string& filename,
                           const ompl::base::StateStoragePtr& storage, std::size_t milestones = 0);
 
+  ConstraintApproximation(const std::string& group, const std::string& state_space_parameterization,
+                          bool explicit_motions, const moveit_msgs::Constraints& msg, const std::string& filename,
+                          const ConstraintApproximationDatabasePtr& database, std::size_t milestones = 0);
+
   virtual ~ConstraintApproximation()
   {
   }
@@ -102,11 +157,17 @@ public:
     return constraint_msg_;
   }
 
+  /** \brief The in-memory storage the approximation was constructed in; empty if it was loaded from a file */
   const ompl::base::StateStoragePtr& getStateStorage() const
   {
     return state_storage_ptr_;
   }
 
+  const ConstraintApproximationDatabasePtr& getDatabase() const
+  {
+    return database_;
+  }
+
   const std::string& getFilename() const
   {
     return ompldb_filename_;
@@ -123,7 +184,7 @@ protected:
 
   std::string ompldb_filename_;
   ompl::base::StateStoragePtr state_storage_ptr_;
-  ConstraintApproximationStateStorage* state_storage_;
+  ConstraintApproximationDatabasePtr database_;
   std::size_t milestones_;
 };
 
@@ -136,6 +197,7 @@ struct ConstraintApproximationConstructionOptions
     , explicit_motions(false)
     , explicit_points_resolution(0.0)
     , max_explicit_points(0)
+    , threads(0)
   {
   }
 
@@ -146,6 +208,8 @@ struct ConstraintApproximationConstructionOptions
   bool explicit_motions;
   double explicit_points_resolution;
   unsigned int max_explicit_points;
+  /// number of threads sampling states and computing connections; 0 uses one thread per core
+  unsigned int threads;
 };
 
 struct ConstraintApproximationConstructionResults
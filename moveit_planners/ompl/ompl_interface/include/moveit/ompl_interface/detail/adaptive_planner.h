@@ -0,0 +1,92 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_OMPL_INTERFACE_DETAIL_ADAPTIVE_PLANNER_
+#define MOVEIT_OMPL_INTERFACE_DETAIL_ADAPTIVE_PLANNER_
+
+#include <moveit/ompl_interface/model_based_planning_context.h>
+#include <ompl/base/Planner.h>
+
+namespace ompl_interface
+{
+/** \brief A planner that solves each request with one of several planners, the one PlannerStatistics expects to
+    solve the kind of problem at hand fastest, and records how that planner did.
+
+    Planner configurations select it with type: adaptive, and list the planners to choose from with planners (the
+    planner types separated by spaces). The remaining parameters of the configuration are passed to each of them. */
+class AdaptivePlanner : public ob::Planner
+{
+public:
+  AdaptivePlanner(const ob::SpaceInformationPtr& si, const std::string& name,
+                  const ModelBasedPlanningContextSpecification& spec);
+
+  virtual ~AdaptivePlanner();
+
+  /** \brief Set the bucket of the problems solved from now on; statistics are kept separately for each bucket */
+  void setProblemBucket(const std::string& bucket);
+
+  const std::string& getProblemBucket() const
+  {
+    return bucket_;
+  }
+
+  const std::vector<std::string>& getPlannerTypes() const
+  {
+    return planner_types_;
+  }
+
+  /** \brief The planner used by the last call to solve(), if any */
+  const ob::PlannerPtr& getLastPlanner() const
+  {
+    return last_planner_;
+  }
+
+  virtual ob::PlannerStatus solve(const ob::PlannerTerminationCondition& ptc);
+  virtual void clear();
+  virtual void getPlannerData(ob::PlannerData& data) const;
+
+private:
+  std::string getStatisticsKey() const;
+
+  ModelBasedPlanningContextSpecification spec_;
+  std::string group_;
+  std::string bucket_;
+  std::vector<std::string> planner_types_;
+  std::vector<ConfiguredPlannerAllocator> allocators_;
+  std::vector<ob::PlannerPtr> planners_;
+  ob::PlannerPtr last_planner_;
+};
+}
+
+#endif
@@ -44,12 +44,29 @@
 #include <moveit/robot_state/robot_state.h>
 #include <moveit/robot_model/joint_model_group.h>
 
+#include <boost/lockfree/queue.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/thread.hpp>
+#include <atomic>
+
 namespace ompl_interface
 {
 class ModelBasedPlanningContext;
 
 /** @class ConstrainedGoalSampler
- *  An interface to the OMPL goal lazy sampler*/
+ *  An interface to the OMPL goal lazy sampler.
+ *
+ *  When the planning context allows more than one goal sampling thread
+ *  (see ModelBasedPlanningContext::getMaximumGoalSamplingThreads()),
+ *  additional workers sample with their own constraint samplers while the
+ *  goal sampling thread of OMPL is running, and pass the valid goal states
+ *  they find to it through a lock-free queue.
+ *
+ *  If the planning context has a goal state cache, the valid goal states
+ *  found for the same constraints by earlier requests are checked again
+ *  and added as goal states when the sampling thread starts, before any
+ *  new goal is sampled; the goal states found are added to the cache once
+ *  sampling ends. */
 class ConstrainedGoalSampler : public ompl::base::GoalLazySamples
 {
 public:
@@ -57,12 +74,21 @@ public:
       const ModelBasedPlanningContext* pc, const kinematic_constraints::KinematicConstraintSetPtr& ks,
       const constraint_samplers::ConstraintSamplerPtr& cs = constraint_samplers::ConstraintSamplerPtr());
 
+  ~ConstrainedGoalSampler();
+
 private:
   bool sampleUsingConstraintSampler(const ompl::base::GoalLazySamples* gls, ompl::base::State* new_goal);
+  void sampleInWorker(const constraint_samplers::ConstraintSamplerPtr& sampler, unsigned int index);
+  void startWorkers();
+  void stopWorkers();
+  bool popWorkerGoal(ompl::base::State* new_goal);
+  bool workersShouldStop() const;
   bool stateValidityCallback(ompl::base::State* new_goal, robot_state::RobotState const* state,
                              const robot_model::JointModelGroup*, const double*, bool verbose = false) const;
   bool checkStateValidity(ompl::base::State* new_goal, const robot_state::RobotState& state,
                           bool verbose = false) const;
+  void addCachedGoalStates();
+  void storeGoalStates();
 
   const ModelBasedPlanningContext* planning_context_;
   kinematic_constraints::KinematicConstraintSetPtr kinematic_constraint_set_;
@@ -72,6 +98,23 @@ private:
   unsigned int invalid_sampled_constraints_;
   bool warned_invalid_samples_;
   unsigned int verbose_display_;
+
+  /* the key of the goal constraints in the goal state cache of the planning context, if it has one */
+  std::string goal_state_key_;
+  bool cached_goal_states_added_;
+
+  /* the sampling thread whose random number generator was seeded for the request */
+  boost::thread::id seeded_thread_;
+
+  /* constraint samplers of the additional goal sampling workers, one per worker */
+  std::vector<constraint_samplers::ConstraintSamplerPtr> worker_samplers_;
+  boost::scoped_ptr<boost::thread_group> workers_;
+  std::atomic<unsigned int> active_workers_;
+  std::atomic<bool> stop_workers_;
+
+  /* valid goal states found by the workers, not yet passed on to OMPL */
+  boost::lockfree::queue<ompl::base::State*> worker_goals_;
+  std::atomic<unsigned int> worker_goal_count_;
 };
 }
 
@@ -0,0 +1,74 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2026, the MoveIt contributors
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the copyright holder nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#ifndef MOVEIT_OMPL_INTERFACE_DETAIL_CONTINUOUS_MOTION_VALIDATOR_
+#define MOVEIT_OMPL_INTERFACE_DETAIL_CONTINUOUS_MOTION_VALIDATOR_
+
+#include <moveit/ompl_interface/detail/threadsafe_state_storage.h>
+#include <moveit/collision_detection/collision_common.h>
+#include <ompl/base/MotionValidator.h>
+
+namespace ompl_interface
+{
+class ModelBasedPlanningContext;
+
+/** @class ContinuousMotionValidator
+    @brief An OMPL motion validator that checks the whole motion between two states for collisions at once, using
+    continuous collision checking, instead of checking interpolated states at the state validity checking resolution.
+    The end state of the motion is checked with the state validity checker of the space information, so path
+    constraints are only evaluated at the ends of the motion. */
+class ContinuousMotionValidator : public ompl::base::MotionValidator
+{
+public:
+  ContinuousMotionValidator(const ModelBasedPlanningContext* planning_context);
+
+  virtual bool checkMotion(const ompl::base::State* s1, const ompl::base::State* s2) const;
+
+  /** \brief Continuous collision checking does not compute the last valid state along the motion; if the motion is
+      invalid, \e lastValid is set to the start of the motion. */
+  virtual bool checkMotion(const ompl::base::State* s1, const ompl::base::State* s2,
+                           std::pair<ompl::base::State*, double>& lastValid) const;
+
+protected:
+  bool isMotionCollisionFree(const ompl::base::State* s1, const ompl::base::State* s2) const;
+
+  const ModelBasedPlanningContext* planning_context_;
+  TSStateStorage tss1_;
+  TSStateStorage tss2_;
+  collision_detection::CollisionRequest collision_request_;
+};
+}
+
+#endif
@@ -0,0 +1,88 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_OMPL_INTERFACE_DETAIL_GOAL_STATE_CACHE_
+#define MOVEIT_OMPL_INTERFACE_DETAIL_GOAL_STATE_CACHE_
+
+#include <moveit/macros/class_forward.h>
+#include <moveit_msgs/Constraints.h>
+#include <boost/thread/mutex.hpp>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+
+namespace ompl_interface
+{
+MOVEIT_CLASS_FORWARD(GoalStateCache);
+
+/** \brief Valid goal states found by the goal samplers of earlier requests, kept by group and goal constraints.
+
+    A goal sampler for the same constraints starts from these states, so the planner can use goal states right away
+    instead of waiting for the sampler to find them. Validity depends on the planning scene and on the state of the
+    joints outside the group, so the cached states are only candidates: the goal sampler checks them again before
+    using them. */
+class GoalStateCache
+{
+public:
+  /** \brief Keep the goal states of at most \e max_goals goal constraints; the least recently used are dropped */
+  explicit GoalStateCache(std::size_t max_goals = 64);
+
+  /** \brief The key goal states for \e constraints of group \e group are kept under. Time stamps are ignored, so
+      repeated requests for the same goal share the key */
+  static std::string getKey(const std::string& group, const moveit_msgs::Constraints& constraints);
+
+  /** \brief Get the joint values of the goal states kept for \e key, most recently found first */
+  void getGoalStates(const std::string& key, std::vector<std::vector<double> >& states);
+
+  /** \brief Keep \e states for \e key, in front of the states already kept for it, up to \e max_states states */
+  void addGoalStates(const std::string& key, const std::vector<std::vector<double> >& states, std::size_t max_states);
+
+  void clear();
+
+private:
+  struct Entry
+  {
+    std::vector<std::vector<double> > states_;
+    uint64_t last_use_;
+  };
+
+  std::size_t max_goals_;
+  uint64_t use_counter_;
+  std::map<std::string, Entry> entries_;
+  boost::mutex lock_;
+};
+}
+
+#endif
@@ -0,0 +1,122 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_OMPL_INTERFACE_DETAIL_LAZY_MOTION_VALIDATOR_
+#define MOVEIT_OMPL_INTERFACE_DETAIL_LAZY_MOTION_VALIDATOR_
+
+#include <moveit/ompl_interface/detail/same_shared_ptr.hpp>
+#include <moveit/ompl_interface/roadmap_library.h>
+#include <ompl/base/MotionValidator.h>
+#include <ompl/geometric/PathGeometric.h>
+#include <boost/unordered_map.hpp>
+#include <boost/thread/mutex.hpp>
+#include <vector>
+
+namespace ompl_interface
+{
+class ModelBasedPlanningContext;
+
+/** @class LazyMotionValidator
+    @brief An OMPL motion validator that defers the checking of motions to the paths that are candidate solutions.
+
+    While lazy, a motion is accepted if its end state is valid; the states in between are not checked. The context
+    then checks the edges of the solution path the planner found with checkPath(), using the eager motion validator
+    this one wraps, and plans again if an edge is invalid. The validity of checked edges is remembered while the
+    planning scene version does not change: edges known to be invalid are rejected right away, also while lazy, and
+    edges known to be valid are not checked again (e.g. when the solution is simplified). When not lazy, motions are
+    checked by the eager motion validator. */
+class LazyMotionValidator : public ompl::base::MotionValidator
+{
+public:
+  LazyMotionValidator(const ModelBasedPlanningContext* planning_context,
+                      const ompl::base::MotionValidatorPtr& eager_motion_validator);
+
+  virtual bool checkMotion(const ompl::base::State* s1, const ompl::base::State* s2) const;
+  virtual bool checkMotion(const ompl::base::State* s1, const ompl::base::State* s2,
+                           std::pair<ompl::base::State*, double>& lastValid) const;
+
+  /** \brief Check every edge of \e path with the eager motion validator, stopping at the first invalid one. The
+      results are remembered. Returns true if all edges are valid. */
+  bool checkPath(const ompl::geometric::PathGeometric& path) const;
+
+  void setLazy(bool flag)
+  {
+    lazy_ = flag;
+  }
+
+  bool isLazy() const
+  {
+    return lazy_;
+  }
+
+  const ompl::base::MotionValidatorPtr& getEagerMotionValidator() const
+  {
+    return eager_motion_validator_;
+  }
+
+  /** \brief Set the version of the planning scene motions are checked in; the remembered edge validity is discarded
+      if it differs from the previous one */
+  void setSceneVersion(const RoadmapSceneVersion& version);
+
+  void clearCheckedMotions();
+
+private:
+  /** \brief The joint values of both states of a motion, in order */
+  typedef std::vector<double> MotionKey;
+
+  enum MotionValidity
+  {
+    UNKNOWN,
+    VALID,
+    INVALID
+  };
+
+  void getMotionKey(const ompl::base::State* s1, const ompl::base::State* s2, MotionKey& key) const;
+  MotionValidity getCheckedMotion(const MotionKey& key) const;
+  void addCheckedMotion(const MotionKey& key, bool valid) const;
+
+  const ModelBasedPlanningContext* planning_context_;
+  ompl::base::MotionValidatorPtr eager_motion_validator_;
+  unsigned int variable_count_;
+  bool lazy_;
+
+  RoadmapSceneVersion scene_version_;
+  mutable boost::unordered_map<MotionKey, bool> checked_motions_;
+  mutable boost::mutex lock_;
+};
+
+typedef same_shared_ptr<LazyMotionValidator, ompl::base::MotionValidatorPtr>::type LazyMotionValidatorPtr;
+}
+
+#endif
@@ -0,0 +1,463 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_OMPL_INTERFACE_DETAIL_NEAREST_NEIGHBORS_JOINT_KD_TREE_
+#define MOVEIT_OMPL_INTERFACE_DETAIL_NEAREST_NEIGHBORS_JOINT_KD_TREE_
+
+#include <moveit/ompl_interface/parameterization/joint_space/joint_model_state_space.h>
+#include <ompl/datastructures/NearestNeighbors.h>
+#include <ompl/util/Exception.h>
+#include <boost/math/constants/constants.hpp>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <vector>
+
+namespace ompl_interface
+{
+/** \brief While an instance exists, the NearestNeighborsJointKDTree structures constructed by the calling thread
+    index states of \e space. Planners construct their nearest neighbor structures without arguments, so this is
+    how the space is passed on to them. */
+class JointKDTreeSpaceScope
+{
+public:
+  JointKDTreeSpaceScope(const JointModelStateSpace* space);
+  ~JointKDTreeSpaceScope();
+
+  /** \brief The space set by the innermost scope of the calling thread, or NULL */
+  static const JointModelStateSpace* getSpace();
+
+private:
+  const JointModelStateSpace* previous_;
+};
+
+/** \brief A bucketed KD-tree over the packed joint values of the states of a JointModelStateSpace with simple
+    joints (see JointModelStateSpace::hasSimpleJoints()).
+
+    Elements are pointers to planner motions, i.e., types with a \e state member. Their joint values are copied
+    into one contiguous array. Distances are those of the state space, including the wraparound of continuous
+    joints, which is also taken into account when pruning sub-trees. New elements are scanned linearly until there
+    are enough of them to rebuild the whole tree at once, which keeps insertions cheap for planners that add
+    motions one at a time. Instances constructed outside a JointKDTreeSpaceScope fall back to a linear scan with
+    the distance function set by the planner. */
+template <typename T>
+class NearestNeighborsJointKDTree : public ompl::NearestNeighbors<T>
+{
+public:
+  NearestNeighborsJointKDTree() : ompl::NearestNeighbors<T>(), space_(JointKDTreeSpaceScope::getSpace()), dim_(0)
+  {
+    if (space_ && space_->hasSimpleJoints())
+    {
+      dim_ = space_->getJointModelGroup()->getVariableCount();
+      linear_factors_.assign(space_->getLinearDistanceFactors().data(),
+                             space_->getLinearDistanceFactors().data() + dim_);
+      continuous_factors_.assign(dim_, 0.0);
+      for (std::size_t i = 0; i < space_->getContinuousVariables().size(); ++i)
+        continuous_factors_[space_->getContinuousVariables()[i]] = space_->getContinuousDistanceFactors()[i];
+    }
+    else
+      space_ = NULL;
+  }
+
+  virtual ~NearestNeighborsJointKDTree()
+  {
+  }
+
+  virtual bool reportsSortedResults() const
+  {
+    return true;
+  }
+
+  virtual void clear()
+  {
+    tree_items_.clear();
+    tree_points_.clear();
+    nodes_.clear();
+    boxes_.clear();
+    pending_items_.clear();
+    pending_points_.clear();
+  }
+
+  virtual void add(const T& data)
+  {
+    addPending(data);
+    if (pending_items_.size() >= MIN_REBUILD_SIZE && pending_items_.size() * REBUILD_RATIO >= tree_items_.size())
+      rebuild();
+  }
+
+  virtual void add(const std::vector<T>& data)
+  {
+    for (std::size_t i = 0; i < data.size(); ++i)
+      addPending(data[i]);
+    if (pending_items_.size() >= MIN_REBUILD_SIZE)
+      rebuild();
+  }
+
+  virtual bool remove(const T& data)
+  {
+    typename std::vector<T>::iterator it = std::find(pending_items_.begin(), pending_items_.end(), data);
+    if (it != pending_items_.end())
+    {
+      std::size_t index = it - pending_items_.begin();
+      pending_items_.erase(it);
+      pending_points_.erase(pending_points_.begin() + index * dim_, pending_points_.begin() + (index + 1) * dim_);
+      return true;
+    }
+    it = std::find(tree_items_.begin(), tree_items_.end(), data);
+    if (it == tree_items_.end())
+      return false;
+    std::size_t index = it - tree_items_.begin();
+    tree_items_.erase(it);
+    tree_points_.erase(tree_points_.begin() + index * dim_, tree_points_.begin() + (index + 1) * dim_);
+    rebuild();
+    return true;
+  }
+
+  virtual T nearest(const T& data) const
+  {
+    std::vector<Neighbor> neighbors;
+    search(data, 1, std::numeric_limits<double>::infinity(), neighbors);
+    if (neighbors.empty())
+      throw ompl::Exception("No elements found in nearest neighbors data structure");
+    return getItem(neighbors[0].second);
+  }
+
+  virtual void nearestK(const T& data, std::size_t k, std::vector<T>& nbh) const
+  {
+    std::vector<Neighbor> neighbors;
+    if (k > 0)
+      search(data, k, std::numeric_limits<double>::infinity(), neighbors);
+    sortedItems(neighbors, nbh);
+  }
+
+  virtual void nearestR(const T& data, double radius, std::vector<T>& nbh) const
+  {
+    std::vector<Neighbor> neighbors;
+    search(data, std::numeric_limits<std::size_t>::max(), radius, neighbors);
+    sortedItems(neighbors, nbh);
+  }
+
+  virtual std::size_t size() const
+  {
+    return tree_items_.size() + pending_items_.size();
+  }
+
+  virtual void list(std::vector<T>& data) const
+  {
+    data = tree_items_;
+    data.insert(data.end(), pending_items_.begin(), pending_items_.end());
+  }
+
+private:
+  /// the distance to an element and its index (elements of the tree first, then the pending elements)
+  typedef std::pair<double, std::size_t> Neighbor;
+
+  struct Node
+  {
+    std::size_t begin_;
+    std::size_t end_;
+
+    /// the children of inner nodes; leaves have none (left_ == 0, as the root is never a child)
+    std::size_t left_;
+    std::size_t right_;
+  };
+
+  /// the maximum number of elements in a leaf
+  static const std::size_t BUCKET_SIZE = 16;
+
+  /// the tree is rebuilt once there are this many pending elements, and at least 1 / REBUILD_RATIO of the
+  /// elements in the tree
+  static const std::size_t MIN_REBUILD_SIZE = 32;
+  static const std::size_t REBUILD_RATIO = 4;
+
+  static const double* values(const T& data)
+  {
+    return data->state->template as<ModelBasedStateSpace::StateType>()->values;
+  }
+
+  const T& getItem(std::size_t index) const
+  {
+    return index < tree_items_.size() ? tree_items_[index] : pending_items_[index - tree_items_.size()];
+  }
+
+  void addPending(const T& data)
+  {
+    pending_items_.push_back(data);
+    if (space_)
+    {
+      const double* v = values(data);
+      pending_points_.insert(pending_points_.end(), v, v + dim_);
+    }
+  }
+
+
+  /* Keep \e index in \e neighbors (a max-heap of at most k elements) if it is among the k closest within radius */
+  static void consider(double d, std::size_t index, std::size_t k, double radius, std::vector<Neighbor>& neighbors)
+  {
+    if (d > radius)
+      return;
+    if (neighbors.size() < k)
+    {
+      neighbors.push_back(Neighbor(d, index));
+      std::push_heap(neighbors.begin(), neighbors.end());
+    }
+    else if (d < neighbors.front().first)
+    {
+      std::pop_heap(neighbors.begin(), neighbors.end());
+      neighbors.back() = Neighbor(d, index);
+      std::push_heap(neighbors.begin(), neighbors.end());
+    }
+  }
+
+  static double bound(std::size_t k, double radius, const std::vector<Neighbor>& neighbors)
+  {
+    return neighbors.size() < k ? radius : std::min(radius, neighbors.front().first);
+  }
+
+  /* Consider the \e count elements starting at \e index, whose values are stored one after the other at \e points;
+   * their distances are computed a bucket at a time */
+  void considerMany(const double* query, const double* points, std::size_t index, std::size_t count, std::size_t k,
+                    double radius, std::vector<Neighbor>& neighbors) const
+  {
+    double distances[BUCKET_SIZE];
+    for (std::size_t begin = 0; begin < count; begin += BUCKET_SIZE)
+    {
+      const std::size_t n = count - begin < BUCKET_SIZE ? count - begin : BUCKET_SIZE;
+      space_->distanceValuesMany(query, points + begin * dim_, n, distances);
+      for (std::size_t i = 0; i < n; ++i)
+        consider(distances[i], index + begin + i, k, radius, neighbors);
+    }
+  }
+
+  void search(const T& data, std::size_t k, double radius, std::vector<Neighbor>& neighbors) const
+  {
+    if (!space_)
+    {
+      for (std::size_t i = 0; i < size(); ++i)
+        consider(ompl::NearestNeighbors<T>::distFun_(data, getItem(i)), i, k, radius, neighbors);
+      return;
+    }
+    const double* query = values(data);
+    if (!nodes_.empty())
+      searchNode(0, query, k, radius, neighbors);
+    considerMany(query, pending_points_.data(), tree_items_.size(), pending_items_.size(), k, radius, neighbors);
+  }
+
+  void searchNode(std::size_t n, const double* query, std::size_t k, double radius,
+                  std::vector<Neighbor>& neighbors) const
+  {
+    const Node& node = nodes_[n];
+    if (node.left_ == 0)
+    {
+      considerMany(query, &tree_points_[node.begin_ * dim_], node.begin_, node.end_ - node.begin_, k, radius,
+                   neighbors);
+      return;
+    }
+
+    // descend into the closer child first
+    double bound_left = boxDistance(node.left_, query);
+    double bound_right = boxDistance(node.right_, query);
+    std::size_t first = node.left_, second = node.right_;
+    if (bound_right < bound_left)
+    {
+      std::swap(first, second);
+      std::swap(bound_left, bound_right);
+    }
+    if (bound_left <= bound(k, radius, neighbors))
+      searchNode(first, query, k, radius, neighbors);
+    if (bound_right <= bound(k, radius, neighbors))
+      searchNode(second, query, k, radius, neighbors);
+  }
+
+  /* A lower bound on the distance from \e query to the elements of node \e n, from their bounding box. For a
+   * continuous joint, the closest value outside the box is one of the ends of the box, either way around. */
+  double boxDistance(std::size_t n, const double* query) const
+  {
+    const double* lo = &boxes_[2 * n * dim_];
+    const double* hi = lo + dim_;
+    double d = 0.0;
+    for (std::size_t i = 0; i < dim_; ++i)
+    {
+      double q = query[i];
+      if (q >= lo[i] && q <= hi[i])
+        continue;
+      if (continuous_factors_[i] > 0.0)
+        d += continuous_factors_[i] * std::min(circularDistance(q, lo[i]), circularDistance(q, hi[i]));
+      else
+        d += linear_factors_[i] * (q < lo[i] ? lo[i] - q : q - hi[i]);
+    }
+    return d;
+  }
+
+  static double circularDistance(double a, double b)
+  {
+    static const double PI = boost::math::constants::pi<double>();
+    double d = fmod(fabs(a - b), 2.0 * PI);
+    return d > PI ? 2.0 * PI - d : d;
+  }
+
+  void rebuild()
+  {
+    if (!space_)
+    {
+      tree_items_.insert(tree_items_.end(), pending_items_.begin(), pending_items_.end());
+      pending_items_.clear();
+      return;
+    }
+
+    std::vector<T> items;
+    items.swap(tree_items_);
+    items.insert(items.end(), pending_items_.begin(), pending_items_.end());
+    std::vector<double> points;
+    points.swap(tree_points_);
+    points.insert(points.end(), pending_points_.begin(), pending_points_.end());
+    pending_items_.clear();
+    pending_points_.clear();
+    nodes_.clear();
+    boxes_.clear();
+    if (items.empty())
+      return;
+
+    std::vector<std::size_t> order(items.size());
+    for (std::size_t i = 0; i < order.size(); ++i)
+      order[i] = i;
+    buildNode(points, order, 0, order.size());
+
+    // store the elements in the order of the leaves
+    tree_items_.resize(items.size());
+    tree_points_.resize(points.size());
+    for (std::size_t i = 0; i < order.size(); ++i)
+    {
+      tree_items_[i] = items[order[i]];
+      std::copy(&points[order[i] * dim_], &points[order[i] * dim_] + dim_, &tree_points_[i * dim_]);
+    }
+  }
+
+  /* Compares elements by one of their values */
+  struct CompareValue
+  {
+    CompareValue(const std::vector<double>& points, std::size_t dim, std::size_t axis)
+      : points_(points), dim_(dim), axis_(axis)
+    {
+    }
+
+    bool operator()(std::size_t a, std::size_t b) const
+    {
+      return points_[a * dim_ + axis_] < points_[b * dim_ + axis_];
+    }
+
+    const std::vector<double>& points_;
+    std::size_t dim_;
+    std::size_t axis_;
+  };
+
+  std::size_t buildNode(const std::vector<double>& points, std::vector<std::size_t>& order, std::size_t begin,
+                        std::size_t end)
+  {
+    std::size_t n = nodes_.size();
+    Node node;
+    node.begin_ = begin;
+    node.end_ = end;
+    node.left_ = node.right_ = 0;
+    nodes_.push_back(node);
+
+    // bounding box of the elements of the node
+    boxes_.resize(boxes_.size() + 2 * dim_);
+    double* lo = &boxes_[2 * n * dim_];
+    double* hi = lo + dim_;
+    std::fill(lo, lo + dim_, std::numeric_limits<double>::infinity());
+    std::fill(hi, hi + dim_, -std::numeric_limits<double>::infinity());
+    for (std::size_t i = begin; i < end; ++i)
+      for (std::size_t j = 0; j < dim_; ++j)
+      {
+        double v = points[order[i] * dim_ + j];
+        lo[j] = std::min(lo[j], v);
+        hi[j] = std::max(hi[j], v);
+      }
+    if (end - begin <= BUCKET_SIZE)
+      return n;
+
+    // split at the median of the variable with the largest weighted spread
+    std::size_t axis = 0;
+    double spread = -1.0;
+    for (std::size_t j = 0; j < dim_; ++j)
+    {
+      double s = (hi[j] - lo[j]) * std::max(linear_factors_[j], continuous_factors_[j]);
+      if (s > spread)
+      {
+        spread = s;
+        axis = j;
+      }
+    }
+    if (spread <= 0.0)
+      return n;
+    std::size_t middle = begin + (end - begin) / 2;
+    std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end,
+                     CompareValue(points, dim_, axis));
+
+    std::size_t left = buildNode(points, order, begin, middle);
+    std::size_t right = buildNode(points, order, middle, end);
+    nodes_[n].left_ = left;
+    nodes_[n].right_ = right;
+    return n;
+  }
+
+  void sortedItems(std::vector<Neighbor>& neighbors, std::vector<T>& nbh) const
+  {
+    std::sort_heap(neighbors.begin(), neighbors.end());
+    nbh.resize(neighbors.size());
+    for (std::size_t i = 0; i < neighbors.size(); ++i)
+      nbh[i] = getItem(neighbors[i].second);
+  }
+
+  const JointModelStateSpace* space_;
+  std::size_t dim_;
+  std::vector<double> linear_factors_;
+  std::vector<double> continuous_factors_;
+
+  /// the elements in the tree, in the order of the leaves, and their values
+  std::vector<T> tree_items_;
+  std::vector<double> tree_points_;
+  std::vector<Node> nodes_;
+
+  /// the lower and upper bounds of the values in each node
+  std::vector<double> boxes_;
+
+  /// the elements added since the tree was last built, and their values
+  std::vector<T> pending_items_;
+  std::vector<double> pending_points_;
+};
+}
+
+#endif
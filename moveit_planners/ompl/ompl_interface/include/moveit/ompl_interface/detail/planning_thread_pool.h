@@ -0,0 +1,83 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_OMPL_INTERFACE_DETAIL_PLANNING_THREAD_POOL_
+#define MOVEIT_OMPL_INTERFACE_DETAIL_PLANNING_THREAD_POOL_
+
+#include <moveit/macros/class_forward.h>
+#include <boost/thread.hpp>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <deque>
+
+namespace ompl_interface
+{
+MOVEIT_CLASS_FORWARD(PlanningThreadPool);
+
+/** \brief Threads that run planning attempts. The threads are started when first needed and kept for later
+    requests. All threads take jobs from one queue, so a thread that finishes an attempt early picks up the next
+    pending one instead of waiting for the other attempts of its request. */
+class PlanningThreadPool : private boost::noncopyable
+{
+public:
+  typedef boost::function<void()> Job;
+
+  PlanningThreadPool();
+
+  /** \brief Finishes the jobs being executed; jobs still in the queue are discarded */
+  ~PlanningThreadPool();
+
+  /** \brief Make sure at least \e count threads are available */
+  void reserve(unsigned int count);
+
+  /** \brief Get the number of threads started so far */
+  unsigned int getThreadCount() const;
+
+  /** \brief Add a job to the queue. Jobs start in the order they are added */
+  void addJob(const Job& job);
+
+private:
+  void workerThread();
+
+  boost::thread_group threads_;
+  unsigned int thread_count_;
+  bool run_threads_;
+
+  mutable boost::mutex lock_;
+  boost::condition_variable new_job_condition_;
+  std::deque<Job> jobs_;
+};
+}
+
+#endif
@@ -61,6 +61,24 @@ private:
   TSStateStorage tss_;
 };
 
+/** @class ProjectionEvaluatorLinkLinear
+    @brief Approximate the position of a link by linearizing its forward kinematics at the initial state of the
+    planning context. Projecting costs a 3xN matrix-vector product instead of forward kinematics, and stays close to
+    ProjectionEvaluatorLinkPose in the neighborhood of the initial state. */
+class ProjectionEvaluatorLinkLinear : public ompl::base::ProjectionEvaluator
+{
+public:
+  ProjectionEvaluatorLinkLinear(const ModelBasedPlanningContext* pc, const std::string& link);
+
+  virtual unsigned int getDimension() const;
+  virtual void defaultCellSizes();
+  virtual void project(const ompl::base::State* state, ompl::base::EuclideanProjection& projection) const;
+
+private:
+  Eigen::Matrix<double, 3, Eigen::Dynamic> jacobian_;
+  Eigen::Vector3d offset_;
+};
+
 /** @class ProjectionEvaluatorJointValue
     @brief */
 class ProjectionEvaluatorJointValue : public ompl::base::ProjectionEvaluator
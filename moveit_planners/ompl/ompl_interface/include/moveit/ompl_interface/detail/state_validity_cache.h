@@ -0,0 +1,103 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_OMPL_INTERFACE_DETAIL_STATE_VALIDITY_CACHE_
+#define MOVEIT_OMPL_INTERFACE_DETAIL_STATE_VALIDITY_CACHE_
+
+#include <boost/scoped_array.hpp>
+#include <atomic>
+#include <cstddef>
+#include <stdint.h>
+
+namespace ompl_interface
+{
+/** @class StateValidityCache
+    @brief The validity of the states checked for one planning request, keyed by their joint values.
+
+    Unlike the validity flags of ModelBasedStateSpace::StateType, this cache also answers for copies of a checked
+    state, e.g. states cloned by planners or states of the solution path checked again by the simplifier. Values are
+    quantized at a resolution well below the state validity checking resolution, so the states that share an entry
+    are the same for collision checking.
+
+    The cache is a fixed size open addressing table of 64 bit entries, each holding a hash of the quantized values
+    and the validity, which planner threads read and update concurrently without locks. When the slots an entry can
+    go in are taken, it replaces the first one, so memory stays bounded. clear() resizes the table for the number of
+    states the previous request stored, between a minimum and a maximum size. */
+class StateValidityCache
+{
+public:
+  explicit StateValidityCache(unsigned int variable_count, double resolution = 1e-6);
+
+  /** \brief Set \e valid to the cached validity of the state with joint \e values. Returns false if it is unknown */
+  bool lookup(const double* values, bool& valid) const;
+
+  void insert(const double* values, bool valid) const;
+
+  /** \brief Forget all states and reset the counters; the size of the table is adapted to the number of states
+      inserted since the previous call */
+  void clear();
+
+  std::size_t getSize() const
+  {
+    return size_;
+  }
+
+  /** \brief The number of lookups that found the state since the last clear() */
+  std::size_t getHitCount() const
+  {
+    return hits_;
+  }
+
+  /** \brief The number of lookups that did not find the state since the last clear() */
+  std::size_t getMissCount() const
+  {
+    return misses_;
+  }
+
+private:
+  uint64_t hash(const double* values) const;
+
+  unsigned int variable_count_;
+  double inv_resolution_;
+
+  boost::scoped_array<std::atomic<uint64_t> > entries_;
+  std::size_t size_;
+
+  mutable std::atomic<std::size_t> hits_;
+  mutable std::atomic<std::size_t> misses_;
+  mutable std::atomic<std::size_t> inserted_;
+};
+}
+
+#endif
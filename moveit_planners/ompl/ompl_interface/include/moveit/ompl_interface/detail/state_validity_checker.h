@@ -70,6 +70,10 @@ public:
 
   void setVerbose(bool flag);
 
+  /** \brief Set the distance to obstacles beyond which clearances are not computed exactly; larger clearances are
+      only known to be at least \e distance, which makes them much cheaper to compute */
+  void setMaximumClearance(double distance);
+
 protected:
   bool isValidWithoutCache(const ompl::base::State* state, bool verbose) const;
   bool isValidWithoutCache(const ompl::base::State* state, double& dist, bool verbose) const;
@@ -39,9 +39,11 @@
 
 #include <moveit/robot_state/robot_state.h>
 #include <boost/thread.hpp>
+#include <stdint.h>
 
 namespace ompl_interface
 {
+/** \brief A scratch robot state for each thread, initialized as a copy of a start state */
 class TSStateStorage
 {
 public:
@@ -49,9 +51,16 @@ public:
   TSStateStorage(const robot_state::RobotState& start_state);
   ~TSStateStorage();
 
+  /** \brief Get the state of the calling thread. Each thread remembers the states it used last, so repeated calls
+      from the same thread do not lock */
   robot_state::RobotState* getStateStorage() const;
 
 private:
+  robot_state::RobotState* getStateStorageLocked() const;
+
+  /// identifies this storage in the per-thread lookup; unlike the address, it is never reused
+  uint64_t id_;
+
   robot_state::RobotState start_state_;
   mutable std::map<boost::thread::id, robot_state::RobotState*> thread_states_;
   mutable boost::mutex lock_;
@@ -39,15 +39,21 @@
 
 #include <moveit/ompl_interface/parameterization/model_based_state_space.h>
 #include <moveit/ompl_interface/detail/constrained_valid_state_sampler.h>
+#include <moveit/ompl_interface/roadmap_library.h>
+#include <moveit/ompl_interface/planner_statistics.h>
+#include <moveit/ompl_interface/detail/planning_thread_pool.h>
+#include <moveit/ompl_interface/detail/lazy_motion_validator.h>
+#include <moveit/ompl_interface/detail/state_validity_cache.h>
+#include <moveit/ompl_interface/detail/goal_state_cache.h>
 #include <moveit/constraint_samplers/constraint_sampler_manager.h>
 #include <moveit/planning_interface/planning_interface.h>
 
 #include <ompl/geometric/SimpleSetup.h>
 #include <ompl/tools/benchmark/Benchmark.h>
-#include <ompl/tools/multiplan/ParallelPlan.h>
 #include <ompl/base/StateStorage.h>
 
 #include <boost/thread/mutex.hpp>
+#include <boost/cstdint.hpp>
 
 namespace ompl_interface
 {
@@ -69,6 +75,10 @@ struct ModelBasedPlanningContextSpecification
   std::map<std::string, std::string> config_;
   ConfiguredPlannerSelector planner_selector_;
   ConstraintsLibraryConstPtr constraints_library_;
+  RoadmapLibraryPtr roadmap_library_;
+  PlanningThreadPoolPtr planning_thread_pool_;
+  GoalStateCachePtr goal_state_cache_;
+  PlannerStatisticsPtr planner_statistics_;
   constraint_samplers::ConstraintSamplerManagerPtr constraint_sampler_manager_;
 
   ModelBasedStateSpacePtr state_space_;
@@ -81,9 +91,7 @@ class ModelBasedPlanningContext : public planning_interface::PlanningContext
 public:
   ModelBasedPlanningContext(const std::string& name, const ModelBasedPlanningContextSpecification& spec);
 
-  virtual ~ModelBasedPlanningContext()
-  {
-  }
+  virtual ~ModelBasedPlanningContext();
 
   virtual bool solve(planning_interface::MotionPlanResponse& res);
   virtual bool solve(planning_interface::MotionPlanDetailedResponse& res);
@@ -187,6 +195,19 @@ public:
     max_goal_samples_ = max_goal_samples;
   }
 
+  /* \brief Get the maximum number of threads used for sampling goal states */
+  unsigned int getMaximumGoalSamplingThreads() const
+  {
+    return max_goal_sampling_threads_;
+  }
+
+  /* \brief Set the maximum number of threads used for sampling goal states; 1 samples in the goal sampling thread
+   * only */
+  void setMaximumGoalSamplingThreads(unsigned int max_goal_sampling_threads)
+  {
+    max_goal_sampling_threads_ = max_goal_sampling_threads;
+  }
+
   /* \brief Get the maximum number of planning threads allowed */
   unsigned int getMaximumPlanningThreads() const
   {
@@ -249,6 +270,57 @@ public:
     spec_.constraints_library_ = constraints_library;
   }
 
+  /** \brief Set the library that keeps the roadmaps of planner configurations with the persistent_roadmap
+   * parameter set */
+  void setRoadmapLibrary(const RoadmapLibraryPtr& roadmap_library)
+  {
+    spec_.roadmap_library_ = roadmap_library;
+  }
+
+  /** \brief Whether single-attempt solves use (and extend) the roadmap kept for this configuration */
+  bool usePersistentRoadmap() const
+  {
+    return persistent_roadmap_;
+  }
+
+  /** \brief Whether single-attempt solves check motions only on candidate solution paths (the
+   * lazy_collision_checking parameter). Planners that are lazy themselves (LazyRRT, LazyPRM) check motions eagerly */
+  bool useLazyCollisionChecking() const
+  {
+    return lazy_motion_validator_ && lazy_collision_checking_;
+  }
+
+  /** \brief The streams of random numbers the threads of a request use when the random_seed parameter is set; see
+   * seedThreadRandomNumberGenerator() */
+  enum RandomSeedStream
+  {
+    /// the thread that calls solve(); the planning attempts of solveAttempts() take the streams that follow
+    SEED_STREAM_PLANNING = 0,
+    /// the goal sampling thread; the goal sampling workers take the streams that follow
+    SEED_STREAM_GOAL_SAMPLING = 1 << 16,
+    /// the threads that simplify the segments of a solution path, one stream per segment
+    SEED_STREAM_SIMPLIFICATION = 2 << 16
+  };
+
+  /** \brief If the random_seed parameter is set, seed the random number generator of the calling thread (see
+   * moveit::core::seedThreadRandomNumberGenerator()) with the seed derived for \e stream. Every thread that samples
+   * for a request calls this with its own stream, so a request that runs on one thread samples the same states every
+   * time it is solved. With several threads, what each thread samples is still reproducible, but the order in which
+   * their results are combined depends on timing. The generators OMPL planners keep themselves (ompl::RNG) are not
+   * affected. */
+  void seedThreadRandomNumberGenerator(unsigned int stream) const;
+
+  /** \brief The name the roadmap of this configuration and state space is kept under by the roadmap library */
+  std::string getRoadmapKey() const
+  {
+    return name_ + "." + spec_.state_space_->getName();
+  }
+
+  /** \brief The kind of problem the current request poses, for which planners of type adaptive keep their statistics:
+   * how many objects the planning scene has (in powers of two), whether it has an octomap and whether the motion
+   * has path constraints */
+  std::string getProblemBucket() const;
+
   bool useStateValidityCache() const
   {
     return use_state_validity_cache_;
@@ -259,6 +331,12 @@ public:
     use_state_validity_cache_ = flag;
   }
 
+  /** \brief The validity of the states checked for the current request, used if useStateValidityCache() is set */
+  const StateValidityCache& getStateValidityCache() const
+  {
+    return state_validity_cache_;
+  }
+
   bool simplifySolutions() const
   {
     return simplify_solutions_;
@@ -295,7 +373,8 @@ public:
     return last_simplify_time_;
   }
 
-  /* @brief Apply smoothing and try to simplify the plan
+  /* @brief Apply smoothing and try to simplify the plan. Segments of long plans are simplified concurrently on the
+     planning thread pool, using up to max_planning_threads_ threads, before shortcuts across the whole plan are tried
      @param timeout The amount of time allowed to be spent on simplifying the plan*/
   void simplifySolution(double timeout);
 
@@ -316,6 +395,34 @@ protected:
   void startSampling();
   void stopSampling();
 
+  /** \brief Plan with the roadmap kept for this configuration by spec_.roadmap_library_, if persistent_roadmap is
+   * set and the roadmap is not in use */
+  void checkoutRoadmap();
+  void checkinRoadmap();
+
+  /** \brief Tell \e planner the kind of problem it solves, if it is an AdaptivePlanner */
+  void setProblemBucket(const ob::PlannerPtr& planner) const;
+
+  /** \brief Solve with motions checked lazily: the edges of each solution are checked once it is found, and the
+   * problem is solved again from scratch, remembering the invalid edges, until a valid solution is found or \e ptc
+   * terminates. Returns true if an exact solution was found */
+  bool solveLazily(const ob::PlannerTerminationCondition& ptc);
+
+  /** \brief Solve in short slices of time, reporting the solution found at the end of a slice to the intermediate
+   * solution callback if it is better than the ones reported before. Planners that keep improving their solution
+   * (e.g. RRTstar) continue in the next slice; planners that return before the end of a slice are done. Returns true
+   * if an exact solution was found */
+  bool solveAnytime(const ob::PlannerTerminationCondition& ptc);
+
+  /** \brief Pass the current solution, interpolated like the final one, to the intermediate solution callback */
+  void reportIntermediateSolution() const;
+
+  /** \brief Run \e count planning attempts on the planning thread pool, at most max_planning_threads_ at a time if
+   * the pool is not shared with other requests. All attempts add their solutions to the problem definition of
+   * ompl_simple_setup_; the remaining attempts are cancelled once \e count solutions are found or a solution
+   * satisfies the optimization objective. Returns true if an exact solution was found */
+  bool solveAttempts(const ob::PlannerTerminationCondition& ptc, unsigned int count);
+
   virtual ob::ProjectionEvaluatorPtr getProjectionEvaluator(const std::string& peval) const;
   virtual ob::StateSamplerPtr allocPathConstrainedSampler(const ompl::base::StateSpace* ss) const;
   virtual void useConfig();
@@ -334,9 +441,6 @@ protected:
   /// the OMPL tool for benchmarking planners
   ot::Benchmark ompl_benchmark_;
 
-  /// tool used to compute multiple plans in parallel; this uses the problem definition maintained by ompl_simple_setup_
-  ot::ParallelPlan ompl_parallel_plan_;
-
   std::vector<int> space_signature_;
 
   kinematic_constraints::KinematicConstraintSetPtr path_constraints_;
@@ -363,6 +467,9 @@ protected:
   /// maximum number of attempts to be made at sampling a goal states
   unsigned int max_goal_sampling_attempts_;
 
+  /// maximum number of threads that sample goal states concurrently
+  unsigned int max_goal_sampling_threads_;
+
   /// when planning in parallel, this is the maximum number of threads to use at one time
   unsigned int max_planning_threads_;
 
@@ -376,7 +483,28 @@ protected:
 
   bool use_state_validity_cache_;
 
+  /// the validity of the states checked for the current request, by joint values; cleared by configure()
+  StateValidityCache state_validity_cache_;
+
   bool simplify_solutions_;
+
+  /// keep the roadmap of LazyPRM planners between requests (the persistent_roadmap parameter)
+  bool persistent_roadmap_;
+
+  /// the roadmap planner checked out for the current solve, and the scene version it is used in
+  ob::PlannerPtr roadmap_planner_;
+  RoadmapSceneVersion roadmap_version_;
+
+  /// check motions only on candidate solution paths (the lazy_collision_checking parameter)
+  bool lazy_collision_checking_;
+
+  /// seed the random number generators of the threads that sample for a request (the random_seed parameter)
+  bool use_random_seed_;
+  boost::uint32_t random_seed_;
+
+  /// the motion validator used when lazy_collision_checking_ is set; kept between requests, so the validity of the
+  /// edges it checked is remembered while the planning scene does not change
+  LazyMotionValidatorPtr lazy_motion_validator_;
 };
 }
 
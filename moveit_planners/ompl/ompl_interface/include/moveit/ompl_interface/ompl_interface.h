@@ -39,6 +39,7 @@
 
 #include <moveit/ompl_interface/planning_context_manager.h>
 #include <moveit/ompl_interface/constraints_library.h>
+#include <moveit/ompl_interface/roadmap_library.h>
 #include <moveit/constraint_samplers/constraint_sampler_manager.h>
 #include <moveit/constraint_sampler_manager_loader/constraint_sampler_manager_loader.h>
 #include <moveit/planning_interface/planning_interface.h>
@@ -115,6 +116,16 @@ public:
     return *constraints_library_;
   }
 
+  RoadmapLibrary& getRoadmapLibrary()
+  {
+    return *roadmap_library_;
+  }
+
+  const RoadmapLibrary& getRoadmapLibrary() const
+  {
+    return *roadmap_library_;
+  }
+
   constraint_samplers::ConstraintSamplerManager& getConstraintSamplerManager()
   {
     return *constraint_sampler_manager_;
@@ -157,6 +168,24 @@ public:
    * approximations to */
   bool loadConstraintApproximations();
 
+  /** @brief Look up param server 'constraint_approximations_path' and keep the roadmaps of planner configurations
+   * with persistent_roadmap set in that folder. Roadmaps are loaded when first used and saved when this interface is
+   * destroyed */
+  bool loadRoadmaps();
+
+  /** @brief Save the roadmaps of planner configurations with persistent_roadmap set to the folder they were loaded
+   * from (see loadRoadmaps()) */
+  bool saveRoadmaps();
+
+  /** @brief Look up param server 'constraint_approximations_path' and load the statistics of the planners chosen by
+   * planner configurations of type adaptive from that folder. The statistics are saved there when this interface is
+   * destroyed */
+  bool loadPlannerStatistics();
+
+  /** @brief Save the statistics of the planners chosen by adaptive planner configurations to the folder they were
+   * loaded from (see loadPlannerStatistics()) */
+  bool savePlannerStatistics();
+
   /** @brief Print the status of this node*/
   void printStatus();
 
@@ -192,6 +221,8 @@ protected:
   ConstraintsLibraryPtr constraints_library_;
   bool use_constraints_approximations_;
 
+  RoadmapLibraryPtr roadmap_library_;
+
   bool simplify_solutions_;
 
 private:
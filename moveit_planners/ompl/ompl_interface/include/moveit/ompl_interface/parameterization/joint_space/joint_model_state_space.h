@@ -38,6 +38,7 @@
 #define MOVEIT_OMPL_INTERFACE_PARAMETERIZATION_JOINT_SPACE_JOINT_MODEL_STATE_SPACE_
 
 #include <moveit/ompl_interface/parameterization/model_based_state_space.h>
+#include <Eigen/Core>
 
 namespace ompl_interface
 {
@@ -47,6 +48,56 @@ public:
   static const std::string PARAMETERIZATION_TYPE;
 
   JointModelStateSpace(const ModelBasedStateSpaceSpecification& spec);
+
+  virtual void interpolate(const ompl::base::State* from, const ompl::base::State* to, const double t,
+                           ompl::base::State* state) const;
+  virtual double distance(const ompl::base::State* state1, const ompl::base::State* state2) const;
+
+  /** \brief True if the group is made only of revolute and prismatic joints, none of them mimic joints. Distances
+      and interpolation are then computed on all the values at once instead of joint by joint, with the same results
+      as JointModelGroup::distance() and JointModelGroup::interpolate() */
+  bool hasSimpleJoints() const
+  {
+    return simple_joints_;
+  }
+
+  /** \brief The distance between the values of two states of a space with simple joints (see hasSimpleJoints()),
+      ignoring any distance function set for the space */
+  double distanceValues(const double* values1, const double* values2) const;
+
+  /** \brief Compute distanceValues() from \e query to each of \e count states whose values are stored one after
+      the other in \e values, as nearest neighbor structures keep them */
+  void distanceValuesMany(const double* query, const double* values, std::size_t count, double* distances) const;
+
+  /** \brief The distance factor of each variable, zero for the variables of continuous joints (only set if
+      hasSimpleJoints()) */
+  const Eigen::ArrayXd& getLinearDistanceFactors() const
+  {
+    return distance_factors_;
+  }
+
+  /** \brief The variables of the continuous joints (only set if hasSimpleJoints()) */
+  const std::vector<unsigned int>& getContinuousVariables() const
+  {
+    return continuous_variables_;
+  }
+
+  /** \brief The distance factors of the variables in getContinuousVariables() */
+  const std::vector<double>& getContinuousDistanceFactors() const
+  {
+    return continuous_distance_factors_;
+  }
+
+private:
+
+  bool simple_joints_;
+
+  /// the distance factor of each variable; zero for the continuous joints, which are handled separately
+  Eigen::ArrayXd distance_factors_;
+
+  /// the variables of the continuous revolute joints, and their distance factors
+  std::vector<unsigned int> continuous_variables_;
+  std::vector<double> continuous_distance_factors_;
 };
 }
 
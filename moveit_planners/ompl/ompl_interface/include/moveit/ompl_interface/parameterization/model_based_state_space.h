@@ -179,6 +179,11 @@ public:
     distance_function_ = fun;
   }
 
+  bool hasDistanceFunction() const
+  {
+    return static_cast<bool>(distance_function_);
+  }
+
   virtual ompl::base::State* allocState() const;
   virtual void freeState(ompl::base::State* state) const;
   virtual unsigned int getDimension() const;
@@ -189,6 +194,7 @@ public:
   virtual void interpolate(const ompl::base::State* from, const ompl::base::State* to, const double t,
                            ompl::base::State* state) const;
   virtual double distance(const ompl::base::State* state1, const ompl::base::State* state2) const;
+
   virtual bool equalStates(const ompl::base::State* state1, const ompl::base::State* state2) const;
   virtual double getMaximumExtent() const;
   virtual double getMeasure() const;
@@ -235,6 +241,10 @@ public:
   // The joint states \b must be specified in the same order as the joint models in the constructor
   virtual void copyToRobotState(robot_state::RobotState& rstate, const ompl::base::State* state) const;
 
+  /// Copy the data from an OMPL state to a set of joint states, like copyToRobotState(), but without updating any
+  /// transforms of \e rstate
+  virtual void copyJointValuesToRobotState(robot_state::RobotState& rstate, const ompl::base::State* state) const;
+
   /// Copy the data from a set of joint states to an OMPL state.
   //  The joint states \b must be specified in the same order as the joint models in the constructor
   virtual void copyToOMPLState(ompl::base::State* state, const robot_state::RobotState& rstate) const;
@@ -259,12 +269,27 @@ protected:
   ModelBasedStateSpaceSpecification spec_;
   std::vector<robot_model::JointModel::Bounds> joint_bounds_storage_;
   std::vector<const robot_model::JointModel*> joint_model_vector_;
+  /// The index of the first value of each of the joints in joint_model_vector_ within the state values; the values of
+  /// the group's mimic joints are in between
+  std::vector<int> joint_value_index_;
   unsigned int variable_count_;
   size_t state_values_size_;
 
   InterpolationFunction interpolation_function_;
   DistanceFunction distance_function_;
 
+  /// Set the tag of \e state, interpolated at \e t between \e from and \e to, from the tags of the end states
+  void interpolateTag(const ompl::base::State* from, const ompl::base::State* to, const double t,
+                      ompl::base::State* state) const
+  {
+    if (from->as<StateType>()->tag >= 0 && t < 1.0 - tag_snap_to_segment_)
+      state->as<StateType>()->tag = from->as<StateType>()->tag;
+    else if (to->as<StateType>()->tag >= 0 && t > tag_snap_to_segment_)
+      state->as<StateType>()->tag = to->as<StateType>()->tag;
+    else
+      state->as<StateType>()->tag = -1;
+  }
+
   double tag_snap_to_segment_;
   double tag_snap_to_segment_complement_;
 };
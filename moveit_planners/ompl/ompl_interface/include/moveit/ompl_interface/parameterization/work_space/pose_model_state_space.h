@@ -39,6 +39,7 @@
 
 #include <moveit/ompl_interface/parameterization/model_based_state_space.h>
 #include <ompl/base/spaces/SE3StateSpace.h>
+#include <boost/shared_ptr.hpp>
 
 namespace ompl_interface
 {
@@ -112,6 +113,9 @@ public:
   virtual void sanityChecks() const;
 
 private:
+  /** \brief IK solutions computed for earlier poses, see PoseComponent::computeStateIK() */
+  struct IKCache;
+
   struct PoseComponent
   {
     PoseComponent(const robot_model::JointModelGroup* subgroup,
@@ -130,6 +134,7 @@ private:
     std::vector<unsigned int> bijection_;
     ompl::base::StateSpacePtr state_space_;
     std::vector<std::string> fk_link_;
+    boost::shared_ptr<IKCache> ik_cache_;
   };
 
   std::vector<PoseComponent> poses_;
@@ -0,0 +1,114 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_OMPL_INTERFACE_PLANNER_STATISTICS_
+#define MOVEIT_OMPL_INTERFACE_PLANNER_STATISTICS_
+
+#include <moveit/macros/class_forward.h>
+#include <boost/thread/mutex.hpp>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+
+namespace ompl_interface
+{
+MOVEIT_CLASS_FORWARD(PlannerStatistics);
+
+/** \brief The outcomes of the planners the adaptive planner chose from, kept per kind of problem, so that later
+    planning requests (and, once saved, later runs) pick the planner that solved such problems fastest.
+
+    A kind of problem is identified by a key made of the planning group and a bucket describing the planning scene
+    (see ModelBasedPlanningContext::getProblemBucket()). Planners are chosen with the UCB1 rule of multi-armed
+    bandits: each planner is tried once, then the one with the best mean reward plus an exploration bonus, which
+    shrinks as the planner is tried more often, is chosen. A solved attempt is rewarded more the faster it was; a
+    failed one is not rewarded. Statistics are saved as text, one line per key and planner, to a single file. */
+class PlannerStatistics
+{
+public:
+  struct Record
+  {
+    Record() : attempts_(0), successes_(0), total_time_(0.0), total_reward_(0.0)
+    {
+    }
+
+    unsigned int attempts_;
+    unsigned int successes_;
+    double total_time_;
+    double total_reward_;
+  };
+
+  PlannerStatistics();
+  ~PlannerStatistics();
+
+  /** \brief Set the folder statistics are saved to by saveStatistics(), and load the statistics saved there */
+  void setStatisticsPath(const std::string& path);
+
+  const std::string& getStatisticsPath() const
+  {
+    return path_;
+  }
+
+  /** \brief Choose which of \e planners to use next for a problem of kind \e key */
+  std::string selectPlanner(const std::string& key, const std::vector<std::string>& planners) const;
+
+  /** \brief Record that \e planner did (\e solved) or did not solve a problem of kind \e key in \e time seconds */
+  void addOutcome(const std::string& key, const std::string& planner, bool solved, double time);
+
+  /** \brief Get the outcomes recorded for \e planner on problems of kind \e key */
+  Record getRecord(const std::string& key, const std::string& planner) const;
+
+  /** \brief Save the statistics to the folder set by setStatisticsPath() */
+  void saveStatistics() const;
+
+  /** \brief Save the statistics to the folder \e path */
+  void saveStatistics(const std::string& path) const;
+
+  /** \brief Add the statistics saved in the folder \e path to the ones recorded so far */
+  void loadStatistics(const std::string& path);
+
+  void clearStatistics();
+
+  void printStatistics(std::ostream& out) const;
+
+private:
+  std::string getStatisticsFilename(const std::string& path) const;
+
+  std::string path_;
+  std::map<std::string, std::map<std::string, Record> > records_;
+  mutable boost::mutex lock_;
+};
+}
+
+#endif
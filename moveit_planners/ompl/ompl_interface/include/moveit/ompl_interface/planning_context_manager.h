@@ -101,6 +101,19 @@ public:
     max_goal_samples_ = max_goal_samples;
   }
 
+  /* \brief Get the maximum number of threads used for sampling goal states */
+  unsigned int getMaximumGoalSamplingThreads() const
+  {
+    return max_goal_sampling_threads_;
+  }
+
+  /* \brief Set the maximum number of threads used for sampling goal states. Planner configurations can override this
+   * with the goal_sampling_threads parameter */
+  void setMaximumGoalSamplingThreads(unsigned int max_goal_sampling_threads)
+  {
+    max_goal_sampling_threads_ = max_goal_sampling_threads;
+  }
+
   /* \brief Get the maximum number of planning threads allowed */
   unsigned int getMaximumPlanningThreads() const
   {
@@ -141,6 +154,16 @@ public:
     return kmodel_;
   }
 
+  /** \brief Set the maximum number of planning contexts kept for reuse while no request uses them. When there are
+   * more, the least recently used ones are destroyed */
+  void setMaximumCachedContexts(std::size_t max_cached_contexts);
+
+  std::size_t getMaximumCachedContexts() const;
+
+  /** \brief Construct the planning contexts for the planner configurations \e configs ahead of the first requests
+   * that use them (at most getMaximumCachedContexts()) */
+  void prewarmPlanningContexts(const std::vector<std::string>& configs);
+
   ModelBasedPlanningContextPtr getLastPlanningContext() const;
 
   ModelBasedPlanningContextPtr getPlanningContext(const std::string& config,
@@ -172,6 +195,12 @@ public:
 
   ConfiguredPlannerSelector getPlannerSelector() const;
 
+  /** \brief The outcomes recorded by planner configurations of type adaptive, shared by all planning contexts */
+  const PlannerStatisticsPtr& getPlannerStatistics() const
+  {
+    return planner_statistics_;
+  }
+
 protected:
   typedef boost::function<const ModelBasedStateSpaceFactoryPtr&(const std::string&)> StateSpaceFactoryTypeSelector;
 
@@ -215,6 +244,9 @@ protected:
   /// maximum number of attempts to be made at sampling goals
   unsigned int max_goal_sampling_attempts_;
 
+  /// maximum number of threads that sample goal states concurrently
+  unsigned int max_goal_sampling_threads_;
+
   /// when planning in parallel, this is the maximum number of threads to use at one time
   unsigned int max_planning_threads_;
 
@@ -226,6 +258,15 @@ protected:
   /// needed)
   unsigned int minimum_waypoint_count_;
 
+  /// the threads that run the attempts of multi-attempt requests, shared by all planning contexts
+  PlanningThreadPoolPtr planning_thread_pool_;
+
+  /// the goal states found for earlier requests, shared by all planning contexts
+  GoalStateCachePtr goal_state_cache_;
+
+  /// the outcomes of the planners chosen by adaptive planners, shared by all planning contexts
+  PlannerStatisticsPtr planner_statistics_;
+
 private:
   MOVEIT_CLASS_FORWARD(LastPlanningContext);
   LastPlanningContextPtr last_planning_context_;
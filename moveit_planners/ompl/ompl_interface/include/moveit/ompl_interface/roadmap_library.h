@@ -0,0 +1,137 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_OMPL_INTERFACE_ROADMAP_LIBRARY_
+#define MOVEIT_OMPL_INTERFACE_ROADMAP_LIBRARY_
+
+#include <moveit/macros/class_forward.h>
+#include <moveit/planning_scene/planning_scene.h>
+#include <ompl/base/Planner.h>
+#include <ompl/base/PlannerData.h>
+#include <boost/thread/mutex.hpp>
+#include <iostream>
+#include <string>
+#include <map>
+
+namespace ompl_interface
+{
+MOVEIT_CLASS_FORWARD(RoadmapLibrary);
+
+/** \brief The versions of the parts of a planning scene that decide whether a state or a motion is valid (see
+    planning_scene::PlanningScene::getWorldVersion()). Validity computed for a roadmap holds only for the scene
+    version it was computed in. */
+struct RoadmapSceneVersion
+{
+  RoadmapSceneVersion();
+  explicit RoadmapSceneVersion(const planning_scene::PlanningScene& scene);
+
+  bool operator==(const RoadmapSceneVersion& other) const;
+  bool operator!=(const RoadmapSceneVersion& other) const
+  {
+    return !(*this == other);
+  }
+
+  uint64_t world_;
+  uint64_t octomap_;
+  uint64_t allowed_collision_matrix_;
+  uint64_t robot_padding_;
+  uint64_t attached_bodies_;
+};
+
+/** \brief Roadmaps built by LazyPRM and LazyPRMstar planners, kept so that later planning requests (and, once
+    saved, later runs) start from the experience gathered so far instead of from an empty roadmap.
+
+    A roadmap is used by one planning request at a time: it is checked out before solving and checked in after.
+    The validity established for its vertices and edges is kept while the planning scene does not change, and is
+    discarded otherwise; the planner then checks the stored edges again, lazily, for the paths it tries. Roadmaps
+    are saved as OMPL planner data, one file per key, and are loaded when first checked out. */
+class RoadmapLibrary
+{
+public:
+  RoadmapLibrary();
+  ~RoadmapLibrary();
+
+  /** \brief Set the folder roadmaps are loaded from when first checked out, and saved to by saveRoadmaps() */
+  void setRoadmapsPath(const std::string& path);
+
+  const std::string& getRoadmapsPath() const
+  {
+    return path_;
+  }
+
+  /** \brief Check out the roadmap planner for \e key, for solving in space \e si a problem posed in scene \e version.
+
+      The stored planner is returned if it uses \e si. Otherwise a planner is allocated with \e allocator and seeded
+      with the stored roadmap, or the one saved for \e key, if any. Returns an empty pointer if the roadmap is
+      already checked out or if \e allocator does not produce a LazyPRM planner; the caller then plans without a
+      persistent roadmap. */
+  ompl::base::PlannerPtr checkoutRoadmap(const std::string& key, const ompl::base::SpaceInformationPtr& si,
+                                         const ompl::base::PlannerAllocator& allocator,
+                                         const RoadmapSceneVersion& version);
+
+  /** \brief Return the planner obtained from checkoutRoadmap(), after using it in scene \e version */
+  void checkinRoadmap(const std::string& key, const ompl::base::PlannerPtr& planner,
+                      const RoadmapSceneVersion& version);
+
+  /** \brief Save the roadmaps that are not checked out to the folder set by setRoadmapsPath() */
+  void saveRoadmaps() const;
+
+  /** \brief Save the roadmaps that are not checked out to \e path */
+  void saveRoadmaps(const std::string& path) const;
+
+  void clearRoadmaps();
+
+  void printRoadmaps(std::ostream& out) const;
+
+private:
+  struct Roadmap
+  {
+    Roadmap() : checked_out_(false)
+    {
+    }
+
+    ompl::base::PlannerPtr planner_;
+    RoadmapSceneVersion version_;
+    bool checked_out_;
+  };
+
+  std::string getRoadmapFilename(const std::string& path, const std::string& key) const;
+
+  std::string path_;
+  std::map<std::string, Roadmap> roadmaps_;
+  mutable boost::mutex lock_;
+};
+}
+
+#endif
@@ -40,7 +40,14 @@
 #include <ompl/tools/config/SelfConfig.h>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/thread/thread.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <fstream>
+#include <stdint.h>
 
 namespace ompl_interface
 {
@@ -78,12 +85,186 @@ void hexToMsg(const std::string& hex, T& msg)
 }
 }
 
+/** \brief The database built by ConstraintsLibrary, held in memory */
+class StoredConstraintApproximationDatabase : public ConstraintApproximationDatabase
+{
+public:
+  StoredConstraintApproximationDatabase(const ob::StateStoragePtr& storage)
+    : ConstraintApproximationDatabase(storage->getStateSpace())
+    , storage_ptr_(storage)
+    , storage_(static_cast<ConstraintApproximationStateStorage*>(storage.get()))
+  {
+  }
+
+  virtual std::size_t size() const
+  {
+    return storage_->size();
+  }
+
+  virtual void copyState(std::size_t index, ob::State* state) const
+  {
+    space_->copyState(state, storage_->getState(index));
+  }
+
+  virtual std::size_t getConnectionCount(std::size_t index) const
+  {
+    return storage_->getMetadata(index).first.size();
+  }
+
+  virtual std::size_t getConnection(std::size_t index, std::size_t k) const
+  {
+    return storage_->getMetadata(index).first[k];
+  }
+
+  virtual bool getMotion(std::size_t from, std::size_t to, std::pair<std::size_t, std::size_t>& states) const
+  {
+    const ConstrainedStateMetadata& md = storage_->getMetadata(from);
+    std::map<std::size_t, std::pair<std::size_t, std::size_t> >::const_iterator it = md.second.find(to);
+    if (it == md.second.end())
+      return false;
+    states = it->second;
+    return true;
+  }
+
+private:
+  ob::StateStoragePtr storage_ptr_;
+  const ConstraintApproximationStateStorage* storage_;
+};
+
+// Layout of a database file. All fields are 64 bit and the sections follow each other in this order:
+// the header, the connection offsets (size + 1) and connections, the motion offsets (size + 1) and motions
+// (target milestone, first state, end state), and the serialized states, each padded to a multiple of 8 bytes.
+const char DATABASE_MAGIC[8] = { 'M', 'O', 'V', 'E', 'I', 'T', 'C', 'A' };
+const uint64_t DATABASE_VERSION = 1;
+
+struct DatabaseHeader
+{
+  char magic[8];
+  uint64_t version;
+  uint64_t state_count;
+  uint64_t state_size;
+  uint64_t state_stride;
+  uint64_t connection_count;
+  uint64_t motion_count;
+};
+
+/** \brief A database file mapped into memory; states are deserialized only when they are used */
+class MappedConstraintApproximationDatabase : public ConstraintApproximationDatabase
+{
+public:
+  MappedConstraintApproximationDatabase(const ob::StateSpacePtr& space)
+    : ConstraintApproximationDatabase(space)
+    , count_(0)
+    , stride_(0)
+    , connection_offsets_(NULL)
+    , connections_(NULL)
+    , motion_offsets_(NULL)
+    , motions_(NULL)
+    , states_(NULL)
+  {
+  }
+
+  bool open(const std::string& filename)
+  {
+    try
+    {
+      file_ = boost::interprocess::file_mapping(filename.c_str(), boost::interprocess::read_only);
+      region_ = boost::interprocess::mapped_region(file_, boost::interprocess::read_only);
+    }
+    catch (boost::interprocess::interprocess_exception& ex)
+    {
+      logError("Unable to map constraint approximation database '%s': %s", filename.c_str(), ex.what());
+      return false;
+    }
+
+    const std::size_t file_size = region_.get_size();
+    const char* data = static_cast<const char*>(region_.get_address());
+    if (file_size < sizeof(DatabaseHeader))
+      return false;
+    const DatabaseHeader* header = reinterpret_cast<const DatabaseHeader*>(data);
+    if (header->version != DATABASE_VERSION || header->state_size != space_->getSerializationLength() ||
+        header->state_stride < header->state_size)
+    {
+      logError("Constraint approximation database '%s' does not match the state space", filename.c_str());
+      return false;
+    }
+
+    count_ = header->state_count;
+    stride_ = header->state_stride;
+    const std::size_t index_words = 2 * (count_ + 1) + header->connection_count + 3 * header->motion_count;
+    if (file_size < sizeof(DatabaseHeader) + index_words * sizeof(uint64_t) + count_ * stride_)
+    {
+      logError("Constraint approximation database '%s' is truncated", filename.c_str());
+      return false;
+    }
+
+    connection_offsets_ = reinterpret_cast<const uint64_t*>(data + sizeof(DatabaseHeader));
+    connections_ = connection_offsets_ + count_ + 1;
+    motion_offsets_ = connections_ + header->connection_count;
+    motions_ = motion_offsets_ + count_ + 1;
+    states_ = reinterpret_cast<const char*>(motions_ + 3 * header->motion_count);
+    return true;
+  }
+
+  virtual std::size_t size() const
+  {
+    return count_;
+  }
+
+  virtual void copyState(std::size_t index, ob::State* state) const
+  {
+    space_->deserialize(state, states_ + index * stride_);
+    state->as<ModelBasedStateSpace::StateType>()->clearKnownInformation();
+  }
+
+  virtual std::size_t getConnectionCount(std::size_t index) const
+  {
+    return connection_offsets_[index + 1] - connection_offsets_[index];
+  }
+
+  virtual std::size_t getConnection(std::size_t index, std::size_t k) const
+  {
+    return connections_[connection_offsets_[index] + k];
+  }
+
+  virtual bool getMotion(std::size_t from, std::size_t to, std::pair<std::size_t, std::size_t>& states) const
+  {
+    // the motions of each milestone are sorted by target, so they can be bisected
+    std::size_t lo = motion_offsets_[from];
+    std::size_t hi = motion_offsets_[from + 1];
+    while (lo < hi)
+    {
+      std::size_t mid = (lo + hi) / 2;
+      if (motions_[3 * mid] < to)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    if (lo >= motion_offsets_[from + 1] || motions_[3 * lo] != to)
+      return false;
+    states.first = motions_[3 * lo + 1];
+    states.second = motions_[3 * lo + 2];
+    return true;
+  }
+
+private:
+  boost::interprocess::file_mapping file_;
+  boost::interprocess::mapped_region region_;
+  std::size_t count_;
+  std::size_t stride_;
+  const uint64_t* connection_offsets_;
+  const uint64_t* connections_;
+  const uint64_t* motion_offsets_;
+  const uint64_t* motions_;
+  const char* states_;
+};
+
 class ConstraintApproximationStateSampler : public ob::StateSampler
 {
 public:
-  ConstraintApproximationStateSampler(const ob::StateSpace* space,
-                                      const ConstraintApproximationStateStorage* state_storage, std::size_t milestones)
-    : ob::StateSampler(space), state_storage_(state_storage)
+  ConstraintApproximationStateSampler(const ob::StateSpace* space, const ConstraintApproximationDatabasePtr& database,
+                                      std::size_t milestones)
+    : ob::StateSampler(space), database_(database)
   {
     max_index_ = milestones - 1;
     inv_dim_ = space->getDimension() > 0 ? 1.0 / (double)space->getDimension() : 1.0;
@@ -91,7 +272,7 @@ public:
 
   virtual void sampleUniform(ob::State* state)
   {
-    space_->copyState(state, state_storage_->getState(rng_.uniformInt(0, max_index_)));
+    database_->copyState(rng_.uniformInt(0, max_index_), state);
   }
 
   virtual void sampleUniformNear(ob::State* state, const ob::State* near, const double distance)
@@ -101,14 +282,14 @@ public:
 
     if (tag >= 0)
     {
-      const ConstrainedStateMetadata& md = state_storage_->getMetadata(tag);
-      if (!md.first.empty())
+      std::size_t connections = database_->getConnectionCount(tag);
+      if (connections > 0)
       {
-        std::size_t matt = md.first.size() / 3;
+        std::size_t matt = connections / 3;
         std::size_t att = 0;
         do
         {
-          index = md.first[rng_.uniformInt(0, md.first.size() - 1)];
+          index = database_->getConnection(tag, rng_.uniformInt(0, connections - 1));
         } while (dirty_.find(index) != dirty_.end() && ++att < matt);
         if (att >= matt)
           index = -1;
@@ -119,15 +300,14 @@ public:
     if (index < 0)
       index = rng_.uniformInt(0, max_index_);
 
-    double dist = space_->distance(near, state_storage_->getState(index));
+    database_->copyState(index, state);
+    double dist = space_->distance(near, state);
 
     if (dist > distance)
     {
       double d = pow(rng_.uniform01(), inv_dim_) * distance;
-      space_->interpolate(near, state_storage_->getState(index), d / dist, state);
+      space_->interpolate(near, state, d / dist, state);
     }
-    else
-      space_->copyState(state, state_storage_->getState(index));
   }
 
   virtual void sampleGaussian(ob::State* state, const ob::State* mean, const double stdDev)
@@ -137,13 +317,13 @@ public:
 
 protected:
   /** \brief The states to sample from */
-  const ConstraintApproximationStateStorage* state_storage_;
+  ConstraintApproximationDatabasePtr database_;
   std::set<std::size_t> dirty_;
   unsigned int max_index_;
   double inv_dim_;
 };
 
-bool interpolateUsingStoredStates(const ConstraintApproximationStateStorage* state_storage, const ob::State* from,
+bool interpolateUsingStoredStates(const ConstraintApproximationDatabasePtr& database, const ob::State* from,
                                   const ob::State* to, const double t, ob::State* state)
 {
   int tag_from = from->as<ModelBasedStateSpace::StateType>()->tag;
@@ -153,26 +333,23 @@ bool interpolateUsingStoredStates(const ConstraintApproximationStateStorage* sta
     return false;
 
   if (tag_from == tag_to)
-    state_storage->getStateSpace()->copyState(state, to);
+    database->getStateSpace()->copyState(state, to);
   else
   {
-    const ConstrainedStateMetadata& md = state_storage->getMetadata(tag_from);
-
-    std::map<std::size_t, std::pair<std::size_t, std::size_t> >::const_iterator it = md.second.find(tag_to);
-    if (it == md.second.end())
+    std::pair<std::size_t, std::size_t> istates;
+    if (!database->getMotion(tag_from, tag_to, istates))
       return false;
-    const std::pair<std::size_t, std::size_t>& istates = it->second;
     std::size_t index = (std::size_t)((istates.second - istates.first + 2) * t + 0.5);
 
     if (index == 0)
-      state_storage->getStateSpace()->copyState(state, from);
+      database->getStateSpace()->copyState(state, from);
     else
     {
       --index;
       if (index >= istates.second - istates.first)
-        state_storage->getStateSpace()->copyState(state, to);
+        database->getStateSpace()->copyState(state, to);
       else
-        state_storage->getStateSpace()->copyState(state, state_storage->getState(istates.first + index));
+        database->copyState(istates.first + index, state);
     }
   }
   return true;
@@ -180,22 +357,240 @@ bool interpolateUsingStoredStates(const ConstraintApproximationStateStorage* sta
 
 ompl_interface::InterpolationFunction ompl_interface::ConstraintApproximation::getInterpolationFunction() const
 {
-  if (explicit_motions_ && milestones_ > 0 && milestones_ < state_storage_->size())
-    return boost::bind(&interpolateUsingStoredStates, state_storage_, _1, _2, _3, _4);
+  if (explicit_motions_ && milestones_ > 0 && milestones_ < database_->size())
+    return boost::bind(&interpolateUsingStoredStates, database_, _1, _2, _3, _4);
   return InterpolationFunction();
 }
 
-ompl::base::StateSamplerPtr allocConstraintApproximationStateSampler(
-    const ob::StateSpace* space, const std::vector<int>& expected_signature,
-    const ConstraintApproximationStateStorage* state_storage, std::size_t milestones)
+ompl::base::StateSamplerPtr allocConstraintApproximationStateSampler(const ob::StateSpace* space,
+                                                                     const std::vector<int>& expected_signature,
+                                                                     const ConstraintApproximationDatabasePtr& database,
+                                                                     std::size_t milestones)
 {
   std::vector<int> sig;
   space->computeSignature(sig);
   if (sig != expected_signature)
     return ompl::base::StateSamplerPtr();
   else
-    return ompl::base::StateSamplerPtr(new ConstraintApproximationStateSampler(space, state_storage, milestones));
+    return ompl::base::StateSamplerPtr(new ConstraintApproximationStateSampler(space, database, milestones));
 }
+
+/** \brief Progress shared by the threads constructing a constraint approximation */
+struct ConstructionProgress
+{
+  ConstructionProgress() : kept(0), attempts(0), next(0)
+  {
+  }
+
+  std::atomic<unsigned int> kept;
+  std::atomic<unsigned int> attempts;
+  std::atomic<std::size_t> next;
+};
+
+void sampleConstrainedStates(const ModelBasedPlanningContext* pcontext,
+                             const kinematic_constraints::KinematicConstraintSet* kset,
+                             const ob::StateSamplerPtr* sampler, unsigned int samples, bool report,
+                             ConstructionProgress* progress, std::vector<ob::State*>* states)
+{
+  const ModelBasedStateSpacePtr& space = pcontext->getOMPLStateSpace();
+  robot_state::RobotState kstate(pcontext->getCompleteInitialRobotState());
+  ob::State* temp = space->allocState();
+  int done = -1;
+  bool slow_warn = false;
+  while (progress->kept < samples)
+  {
+    unsigned int attempts = ++progress->attempts;
+    unsigned int kept = progress->kept;
+    if (report)
+    {
+      int done_now = 100 * kept / samples;
+      if (done != done_now)
+      {
+        done = done_now;
+        logInform("%d%% complete (kept %0.1lf%% sampled states)", done, 100.0 * (double)kept / (double)attempts);
+      }
+
+      if (!slow_warn && attempts > 10 && attempts > kept * 100)
+      {
+        slow_warn = true;
+        logWarn("Computation of valid state database is very slow...");
+      }
+    }
+
+    if (attempts > samples && kept == 0)
+    {
+      if (report)
+        logError("Unable to generate any samples");
+      break;
+    }
+
+    (*sampler)->sampleUniform(temp);
+    space->copyToRobotState(kstate, temp);
+    if (kset->isSatisfied(kstate))
+    {
+      if (progress->kept++ >= samples)
+        break;
+      states->push_back(temp);
+      temp = space->allocState();
+    }
+  }
+  space->freeState(temp);
+}
+
+bool isMotionSatisfied(const ModelBasedPlanningContext* pcontext,
+                       const kinematic_constraints::KinematicConstraintSet* kset, const ob::State* from,
+                       const ob::State* to, unsigned int isteps, std::vector<ob::State*>& int_states,
+                       robot_state::RobotState& kstate)
+{
+  const ModelBasedStateSpacePtr& space = pcontext->getOMPLStateSpace();
+  double step = 1.0 / (double)isteps;
+  space->interpolate(from, to, step, int_states[0]);
+  for (unsigned int k = 1; k < isteps; ++k)
+  {
+    double this_step = step / (1.0 - (k - 1) * step);
+    space->interpolate(int_states[k - 1], to, this_step, int_states[k]);
+    space->copyToRobotState(kstate, int_states[k]);
+    if (!kset->isSatisfied(kstate))
+      return false;
+  }
+  return true;
+}
+
+// Finds up to edges_per_sample satisfied connections from each milestone to later milestones. Milestones are
+// handed out through progress->next; the caps are applied afterwards, in milestone order.
+void findConnections(const ModelBasedPlanningContext* pcontext,
+                     const kinematic_constraints::KinematicConstraintSet* kset,
+                     const ConstraintApproximationStateStorage* cass,
+                     const ConstraintApproximationConstructionOptions* options, unsigned int milestones, bool report,
+                     ConstructionProgress* progress, std::vector<std::vector<std::size_t> >* candidates)
+{
+  const ModelBasedStateSpacePtr& space = pcontext->getOMPLStateSpace();
+  robot_state::RobotState kstate(pcontext->getCompleteInitialRobotState());
+  std::vector<ob::State*> int_states(std::max(options->max_explicit_points, 1u), NULL);
+  pcontext->getOMPLSimpleSetup()->getSpaceInformation()->allocStates(int_states);
+
+  int done = -1;
+  for (std::size_t j = progress->next++; j < milestones; j = progress->next++)
+  {
+    if (report)
+    {
+      int done_now = 100 * j / milestones;
+      if (done != done_now)
+      {
+        done = done_now;
+        logInform("%d%% complete", done);
+      }
+    }
+
+    const ob::State* sj = cass->getState(j);
+    std::vector<std::size_t>& found = (*candidates)[j];
+    for (std::size_t i = j + 1; i < milestones && found.size() < options->edges_per_sample; ++i)
+    {
+      double d = space->distance(cass->getState(i), sj);
+      if (d >= options->max_edge_length)
+        continue;
+      unsigned int isteps =
+          std::min<unsigned int>(options->max_explicit_points, d / options->explicit_points_resolution);
+      if (isteps == 0 || isMotionSatisfied(pcontext, kset, cass->getState(i), sj, isteps, int_states, kstate))
+        found.push_back(i);
+    }
+  }
+  pcontext->getOMPLSimpleSetup()->getSpaceInformation()->freeStates(int_states);
+}
+}
+
+bool ompl_interface::ConstraintApproximationDatabase::store(const std::string& filename) const
+{
+  const std::size_t count = size();
+  const std::size_t state_size = space_->getSerializationLength();
+  const std::size_t stride = (state_size + 7) / 8 * 8;
+
+  std::vector<uint64_t> connection_offsets(1, 0), connections, motion_offsets(1, 0), motions;
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    std::vector<std::pair<std::size_t, std::pair<std::size_t, std::size_t> > > state_motions;
+    for (std::size_t k = 0; k < getConnectionCount(i); ++k)
+    {
+      std::size_t to = getConnection(i, k);
+      connections.push_back(to);
+      std::pair<std::size_t, std::size_t> motion;
+      if (getMotion(i, to, motion))
+        state_motions.push_back(std::make_pair(to, motion));
+    }
+    std::sort(state_motions.begin(), state_motions.end());
+    for (std::size_t k = 0; k < state_motions.size(); ++k)
+    {
+      motions.push_back(state_motions[k].first);
+      motions.push_back(state_motions[k].second.first);
+      motions.push_back(state_motions[k].second.second);
+    }
+    connection_offsets.push_back(connections.size());
+    motion_offsets.push_back(motions.size() / 3);
+  }
+
+  std::ofstream out(filename.c_str(), std::ios::binary);
+  if (!out.good())
+  {
+    logError("Unable to write constraint approximation database '%s'", filename.c_str());
+    return false;
+  }
+
+  DatabaseHeader header;
+  memcpy(header.magic, DATABASE_MAGIC, sizeof(DATABASE_MAGIC));
+  header.version = DATABASE_VERSION;
+  header.state_count = count;
+  header.state_size = state_size;
+  header.state_stride = stride;
+  header.connection_count = connections.size();
+  header.motion_count = motions.size() / 3;
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  out.write(reinterpret_cast<const char*>(&connection_offsets[0]), connection_offsets.size() * sizeof(uint64_t));
+  if (!connections.empty())
+    out.write(reinterpret_cast<const char*>(&connections[0]), connections.size() * sizeof(uint64_t));
+  out.write(reinterpret_cast<const char*>(&motion_offsets[0]), motion_offsets.size() * sizeof(uint64_t));
+  if (!motions.empty())
+    out.write(reinterpret_cast<const char*>(&motions[0]), motions.size() * sizeof(uint64_t));
+
+  std::vector<char> buffer(stride, 0);
+  ob::State* temp = space_->allocState();
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    copyState(i, temp);
+    space_->serialize(&buffer[0], temp);
+    out.write(&buffer[0], stride);
+  }
+  space_->freeState(temp);
+  return out.good();
+}
+
+ompl_interface::ConstraintApproximationDatabasePtr
+ompl_interface::loadConstraintApproximationDatabase(const std::string& filename, const ob::StateSpacePtr& space)
+{
+  char magic[sizeof(DATABASE_MAGIC)] = { 0 };
+  {
+    std::ifstream in(filename.c_str(), std::ios::binary);
+    if (!in.good())
+    {
+      logError("Unable to open constraint approximation database '%s'", filename.c_str());
+      return ConstraintApproximationDatabasePtr();
+    }
+    in.read(magic, sizeof(magic));
+  }
+
+  if (memcmp(magic, DATABASE_MAGIC, sizeof(DATABASE_MAGIC)) == 0)
+  {
+    MappedConstraintApproximationDatabase* mapped = new MappedConstraintApproximationDatabase(space);
+    ConstraintApproximationDatabasePtr database(mapped);
+    if (!mapped->open(filename))
+      return ConstraintApproximationDatabasePtr();
+    return database;
+  }
+
+  // files written before the mapped format are boost serializations of the state storage
+  ConstraintApproximationStateStorage* cass = new ConstraintApproximationStateStorage(space);
+  ob::StateStoragePtr storage(cass);
+  cass->load(filename.c_str());
+  return ConstraintApproximationDatabasePtr(new StoredConstraintApproximationDatabase(storage));
 }
 
 ompl_interface::ConstraintApproximation::ConstraintApproximation(
@@ -208,20 +603,37 @@ ompl_interface::ConstraintApproximation::ConstraintApproximation(
   , constraint_msg_(msg)
   , ompldb_filename_(filename)
   , state_storage_ptr_(storage)
+  , database_(new StoredConstraintApproximationDatabase(storage))
   , milestones_(milestones)
 {
-  state_storage_ = static_cast<ConstraintApproximationStateStorage*>(state_storage_ptr_.get());
-  state_storage_->getStateSpace()->computeSignature(space_signature_);
+  database_->getStateSpace()->computeSignature(space_signature_);
   if (milestones_ == 0)
-    milestones_ = state_storage_->size();
+    milestones_ = database_->size();
+}
+
+ompl_interface::ConstraintApproximation::ConstraintApproximation(
+    const std::string& group, const std::string& state_space_parameterization, bool explicit_motions,
+    const moveit_msgs::Constraints& msg, const std::string& filename,
+    const ConstraintApproximationDatabasePtr& database, std::size_t milestones)
+  : group_(group)
+  , state_space_parameterization_(state_space_parameterization)
+  , explicit_motions_(explicit_motions)
+  , constraint_msg_(msg)
+  , ompldb_filename_(filename)
+  , database_(database)
+  , milestones_(milestones)
+{
+  database_->getStateSpace()->computeSignature(space_signature_);
+  if (milestones_ == 0)
+    milestones_ = database_->size();
 }
 
 ompl::base::StateSamplerAllocator
 ompl_interface::ConstraintApproximation::getStateSamplerAllocator(const moveit_msgs::Constraints& msg) const
 {
-  if (state_storage_->size() == 0)
+  if (database_->size() == 0)
     return ompl::base::StateSamplerAllocator();
-  return boost::bind(&allocConstraintApproximationStateSampler, _1, space_signature_, state_storage_, milestones_);
+  return boost::bind(&allocConstraintApproximationStateSampler, _1, space_signature_, database_, milestones_);
 }
 /*
 void ompl_interface::ConstraintApproximation::visualizeDistribution(const std::string &link_name, unsigned int count,
@@ -304,21 +716,17 @@ void ompl_interface::ConstraintsLibrary::loadConstraintApproximations(const std:
     {
       moveit_msgs::Constraints msg;
       hexToMsg(serialization, msg);
-      ConstraintApproximationStateStorage* cass =
-          new ConstraintApproximationStateStorage(pc->getOMPLSimpleSetup()->getStateSpace());
-      cass->load((path + "/" + filename).c_str());
+      ConstraintApproximationDatabasePtr database =
+          loadConstraintApproximationDatabase(path + "/" + filename, pc->getOMPLSimpleSetup()->getStateSpace());
+      if (!database)
+        continue;
       ConstraintApproximationPtr cap(new ConstraintApproximation(group, state_space_parameterization, explicit_motions,
-                                                                 msg, filename, ompl::base::StateStoragePtr(cass),
-                                                                 milestones));
+                                                                 msg, filename, database, milestones));
       if (constraint_approximations_.find(cap->getName()) != constraint_approximations_.end())
         logWarn("Overwriting constraint approximation named '%s'", cap->getName().c_str());
       constraint_approximations_[cap->getName()] = cap;
-      std::size_t sum = 0;
-      for (std::size_t i = 0; i < cass->size(); ++i)
-        sum += cass->getMetadata(i).first.size();
-      logInform("Loaded %lu states (%lu milestones) and %lu connections (%0.1lf per state) for constraint named '%s'%s",
-                cass->size(), cap->getMilestoneCount(), sum, (double)sum / (double)cap->getMilestoneCount(),
-                msg.name.c_str(), explicit_motions ? ". Explicit motions included." : "");
+      logInform("Loaded %lu states (%lu milestones) for constraint named '%s'%s", database->size(),
+                cap->getMilestoneCount(), msg.name.c_str(), explicit_motions ? ". Explicit motions included." : "");
     }
   }
   logInform("Done loading constrained space approximations.");
@@ -349,8 +757,10 @@ void ompl_interface::ConstraintsLibrary::saveConstraintApproximations(const std:
       msgToHex(it->second->getConstraintsMsg(), serialization);
       fout << serialization << std::endl;
       fout << it->second->getFilename() << std::endl;
-      if (it->second->getStateStorage())
-        it->second->getStateStorage()->store((path + "/" + it->second->getFilename()).c_str());
+      // a database mapped from this very file is already stored, and must not be truncated while mapped
+      std::string filename = path + "/" + it->second->getFilename();
+      if (it->second->getStateStorage() || !boost::filesystem::exists(filename))
+        it->second->getDatabase()->store(filename);
     }
   else
     logError("Unable to save constraint approximation to '%s'", path.c_str());
@@ -444,73 +854,58 @@ ompl::base::StateStoragePtr ompl_interface::ConstraintsLibrary::constructConstra
   robot_state::Transforms no_transforms(pcontext->getRobotModel()->getModelFrame());
   kset.add(constr_hard, no_transforms);
 
-  const robot_state::RobotState& default_state = pcontext->getCompleteInitialRobotState();
-
-  unsigned int attempts = 0;
+  unsigned int threads = options.threads ? options.threads : boost::thread::hardware_concurrency();
+  threads = std::max(threads, 1u);
 
   double bounds_val = std::numeric_limits<double>::max() / 2.0 - 1.0;
   pcontext->getOMPLStateSpace()->setPlanningVolume(-bounds_val, bounds_val, -bounds_val, bounds_val, -bounds_val,
                                                    bounds_val);
   pcontext->getOMPLStateSpace()->setup();
 
-  // construct the constrained states
-
-  robot_state::RobotState kstate(default_state);
+  // construct the constrained states; each thread gets its own sampler, selected here because the sampler
+  // manager hands out a separate sampler for each caller that still holds one
   const constraint_samplers::ConstraintSamplerManagerPtr& csmng = pcontext->getConstraintSamplerManager();
-  ConstrainedSampler* csmp = NULL;
-  if (csmng)
+  std::vector<ConstrainedSampler*> csmps(threads, NULL);
+  std::vector<ob::StateSamplerPtr> samplers(threads);
+  for (unsigned int t = 0; t < threads; ++t)
   {
-    constraint_samplers::ConstraintSamplerPtr cs =
-        csmng->selectSampler(pcontext->getPlanningScene(), pcontext->getJointModelGroup()->getName(), constr_sampling);
-    if (cs)
-      csmp = new ConstrainedSampler(pcontext.get(), cs);
+    if (csmng)
+    {
+      constraint_samplers::ConstraintSamplerPtr cs = csmng->selectSampler(
+          pcontext->getPlanningScene(), pcontext->getJointModelGroup()->getName(), constr_sampling);
+      if (cs)
+        csmps[t] = new ConstrainedSampler(pcontext.get(), cs);
+    }
+    samplers[t] = csmps[t] ? ob::StateSamplerPtr(csmps[t]) : pcontext->getOMPLStateSpace()->allocDefaultStateSampler();
   }
 
-  ob::StateSamplerPtr ss(csmp ? ob::StateSamplerPtr(csmp) : pcontext->getOMPLStateSpace()->allocDefaultStateSampler());
-
-  ompl::base::ScopedState<> temp(pcontext->getOMPLStateSpace());
-  int done = -1;
-  bool slow_warn = false;
+  logInform("Sampling %u states using %u threads", options.samples, threads);
+  ConstructionProgress sampling;
+  std::vector<std::vector<ob::State*> > sampled(threads);
   ompl::time::point start = ompl::time::now();
-  while (sstor->size() < options.samples)
   {
-    ++attempts;
-    int done_now = 100 * sstor->size() / options.samples;
-    if (done != done_now)
-    {
-      done = done_now;
-      logInform("%d%% complete (kept %0.1lf%% sampled states)", done, 100.0 * (double)sstor->size() / (double)attempts);
-    }
-
-    if (!slow_warn && attempts > 10 && attempts > sstor->size() * 100)
-    {
-      slow_warn = true;
-      logWarn("Computation of valid state database is very slow...");
-    }
+    boost::thread_group workers;
+    for (unsigned int t = 0; t < threads; ++t)
+      workers.create_thread(boost::bind(&sampleConstrainedStates, pcontext.get(), &kset, &samplers[t], options.samples,
+                                        t == 0, &sampling, &sampled[t]));
+    workers.join_all();
+  }
 
-    if (attempts > options.samples && sstor->size() == 0)
+  for (unsigned int t = 0; t < threads; ++t)
+    for (std::size_t i = 0; i < sampled[t].size(); ++i)
     {
-      logError("Unable to generate any samples");
-      break;
+      sampled[t][i]->as<ModelBasedStateSpace::StateType>()->tag = sstor->size();
+      sstor->addState(sampled[t][i]);
+      pcontext->getOMPLStateSpace()->freeState(sampled[t][i]);
     }
 
-    ss->sampleUniform(temp.get());
-    pcontext->getOMPLStateSpace()->copyToRobotState(kstate, temp.get());
-    if (kset.decide(kstate).satisfied)
-    {
-      if (sstor->size() < options.samples)
-      {
-        temp->as<ModelBasedStateSpace::StateType>()->tag = sstor->size();
-        sstor->addState(temp.get());
-      }
-    }
-  }
-
   result.state_sampling_time = ompl::time::seconds(ompl::time::now() - start);
   logInform("Generated %u states in %lf seconds", (unsigned int)sstor->size(), result.state_sampling_time);
-  if (csmp)
+  if (csmps[0])
   {
-    result.sampling_success_rate = csmp->getConstrainedSamplingRate();
+    result.sampling_success_rate = 0.0;
+    for (unsigned int t = 0; t < threads; ++t)
+      result.sampling_success_rate += csmps[t]->getConstrainedSamplingRate() / (double)threads;
     logInform("Constrained sampling rate: %lf", result.sampling_success_rate);
   }
 
@@ -519,82 +914,71 @@ ompl::base::StateStoragePtr ompl_interface::ConstraintsLibrary::constructConstra
   {
     logInform("Computing graph connections (max %u edges per sample) ...", options.edges_per_sample);
 
-    // construct connexions
+    // the expensive part, checking the constraints along candidate edges, is done in parallel;
+    // the candidates are then accepted in milestone order, respecting the per sample limit
     const ob::StateSpacePtr& space = pcontext->getOMPLSimpleSetup()->getStateSpace();
     unsigned int milestones = sstor->size();
-    std::vector<ob::State*> int_states(options.max_explicit_points, NULL);
-    pcontext->getOMPLSimpleSetup()->getSpaceInformation()->allocStates(int_states);
+    std::vector<std::vector<std::size_t> > candidates(milestones);
 
     ompl::time::point start = ompl::time::now();
-    int good = 0;
-    int done = -1;
+    ConstructionProgress connecting;
+    {
+      boost::thread_group workers;
+      for (unsigned int t = 0; t < threads; ++t)
+        workers.create_thread(boost::bind(&findConnections, pcontext.get(), &kset, cass, &options, milestones, t == 0,
+                                          &connecting, &candidates));
+      workers.join_all();
+    }
 
+    std::vector<ob::State*> int_states(std::max(options.max_explicit_points, 1u), NULL);
+    pcontext->getOMPLSimpleSetup()->getSpaceInformation()->allocStates(int_states);
+    int good = 0;
     for (std::size_t j = 0; j < milestones; ++j)
     {
-      int done_now = 100 * j / milestones;
-      if (done != done_now)
-      {
-        done = done_now;
-        logInform("%d%% complete", done);
-      }
       if (cass->getMetadata(j).first.size() >= options.edges_per_sample)
         continue;
 
       const ob::State* sj = sstor->getState(j);
-
-      for (std::size_t i = j + 1; i < milestones; ++i)
+      for (std::size_t c = 0; c < candidates[j].size(); ++c)
       {
+        std::size_t i = candidates[j][c];
         if (cass->getMetadata(i).first.size() >= options.edges_per_sample)
           continue;
-        double d = space->distance(sstor->getState(i), sj);
-        if (d >= options.max_edge_length)
-          continue;
-        unsigned int isteps =
-            std::min<unsigned int>(options.max_explicit_points, d / options.explicit_points_resolution);
-        double step = 1.0 / (double)isteps;
-        double remain = 1.0;
-        bool ok = true;
-        space->interpolate(sstor->getState(i), sj, step, int_states[0]);
-        for (unsigned int k = 1; k < isteps; ++k)
-        {
-          double this_step = step / (1.0 - (k - 1) * step);
-          space->interpolate(int_states[k - 1], sj, this_step, int_states[k]);
-          pcontext->getOMPLStateSpace()->copyToRobotState(kstate, int_states[k]);
-          if (!kset.decide(kstate).satisfied)
-          {
-            ok = false;
-            break;
-          }
-        }
 
-        if (ok)
-        {
-          cass->getMetadata(i).first.push_back(j);
-          cass->getMetadata(j).first.push_back(i);
+        cass->getMetadata(i).first.push_back(j);
+        cass->getMetadata(j).first.push_back(i);
 
-          if (options.explicit_motions)
+        if (options.explicit_motions)
+        {
+          double d = space->distance(sstor->getState(i), sj);
+          unsigned int isteps =
+              std::min<unsigned int>(options.max_explicit_points, d / options.explicit_points_resolution);
+          double step = 1.0 / (double)isteps;
+          if (isteps > 0)
+            space->interpolate(sstor->getState(i), sj, step, int_states[0]);
+          for (unsigned int k = 1; k < isteps; ++k)
+            space->interpolate(int_states[k - 1], sj, step / (1.0 - (k - 1) * step), int_states[k]);
+
+          cass->getMetadata(i).second[j].first = sstor->size();
+          for (unsigned int k = 0; k < isteps; ++k)
           {
-            cass->getMetadata(i).second[j].first = sstor->size();
-            for (unsigned int k = 0; k < isteps; ++k)
-            {
-              int_states[k]->as<ModelBasedStateSpace::StateType>()->tag = -1;
-              sstor->addState(int_states[k]);
-            }
-            cass->getMetadata(i).second[j].second = sstor->size();
-            cass->getMetadata(j).second[i] = cass->getMetadata(i).second[j];
+            int_states[k]->as<ModelBasedStateSpace::StateType>()->tag = -1;
+            sstor->addState(int_states[k]);
           }
-
-          good++;
-          if (cass->getMetadata(j).first.size() >= options.edges_per_sample)
-            break;
+          cass->getMetadata(i).second[j].second = sstor->size();
+          cass->getMetadata(j).second[i] = cass->getMetadata(i).second[j];
         }
+
+        good++;
+        if (cass->getMetadata(j).first.size() >= options.edges_per_sample)
+          break;
       }
     }
 
     result.state_connection_time = ompl::time::seconds(ompl::time::now() - start);
     logInform("Computed possible connexions in %lf seconds. Added %d connexions", result.state_connection_time, good);
     pcontext->getOMPLSimpleSetup()->getSpaceInformation()->freeStates(int_states);
-
-    return sstor;
   }
+
+  return sstor;
 }
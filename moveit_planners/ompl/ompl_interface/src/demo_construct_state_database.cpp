@@ -61,7 +61,7 @@ moveit_msgs::Constraints getConstraints()
   return cmsg;
 }
 
-void computeDB(const robot_model::RobotModelPtr& robot_model, unsigned int ns, unsigned int ne)
+void computeDB(const robot_model::RobotModelPtr& robot_model, unsigned int ns, unsigned int ne, unsigned int nt)
 {
   planning_scene::PlanningScenePtr ps(new planning_scene::PlanningScene(robot_model));
   ompl_interface::OMPLInterface ompl_interface(robot_model);
@@ -74,6 +74,7 @@ void computeDB(const robot_model::RobotModelPtr& robot_model, unsigned int ns, u
   opt.max_edge_length = 0.2;
   opt.explicit_points_resolution = 0.05;
   opt.max_explicit_points = 10;
+  opt.threads = nt;
 
   ompl_interface.getConstraintsLibrary().addConstraintApproximation(c, "right_arm", ps, opt);
   ompl_interface.getConstraintsLibrary().saveConstraintApproximations("~/constraints_approximation_database");
@@ -113,6 +114,7 @@ int main(int argc, char** argv)
 
   unsigned int nstates = 1000;
   unsigned int nedges = 0;
+  unsigned int nthreads = 0;
 
   if (argc > 1)
     try
@@ -132,8 +134,17 @@ int main(int argc, char** argv)
     {
     }
 
+  if (argc > 3)
+    try
+    {
+      nthreads = boost::lexical_cast<unsigned int>(argv[3]);
+    }
+    catch (...)
+    {
+    }
+
   robot_model_loader::RobotModelLoader rml(ROBOT_DESCRIPTION);
-  computeDB(rml.getModel(), nstates, nedges);
+  computeDB(rml.getModel(), nstates, nedges, nthreads);
 
   ros::shutdown();
   return 0;
@@ -0,0 +1,149 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/ompl_interface/detail/adaptive_planner.h>
+#include <ompl/util/Console.h>
+#include <ompl/util/Time.h>
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/tokenizer.hpp>
+#include <algorithm>
+
+namespace ompl_interface
+{
+namespace
+{
+// the planners chosen from when the planner configuration does not list any
+static const std::string DEFAULT_ADAPTIVE_PLANNERS = "geometric::RRTConnect geometric::BKPIECE geometric::BiEST "
+                                                     "geometric::SBL";
+}
+}
+
+ompl_interface::AdaptivePlanner::AdaptivePlanner(const ob::SpaceInformationPtr& si, const std::string& name,
+                                                 const ModelBasedPlanningContextSpecification& spec)
+  : ob::Planner(si, name.empty() ? "AdaptivePlanner" : name), spec_(spec)
+{
+  // the simple setup owns this planner
+  spec_.ompl_simple_setup_.reset();
+  if (spec_.state_space_)
+    group_ = spec_.state_space_->getJointModelGroupName();
+
+  std::map<std::string, std::string>::const_iterator it = spec_.config_.find("planners");
+  std::string types = it == spec_.config_.end() ? DEFAULT_ADAPTIVE_PLANNERS : it->second;
+  boost::char_separator<char> sep(" ");
+  boost::tokenizer<boost::char_separator<char> > tok(types, sep);
+  for (boost::tokenizer<boost::char_separator<char> >::iterator beg = tok.begin(); beg != tok.end(); ++beg)
+  {
+    std::string type = boost::trim_copy(*beg);
+    // the adaptive planner does not choose itself
+    if (type.empty() || type == "adaptive" ||
+        std::find(planner_types_.begin(), planner_types_.end(), type) != planner_types_.end())
+      continue;
+    ConfiguredPlannerAllocator allocator;
+    if (spec_.planner_selector_)
+      allocator = spec_.planner_selector_(type);
+    if (!allocator)
+      continue;
+    planner_types_.push_back(type);
+    allocators_.push_back(allocator);
+  }
+  planners_.resize(planner_types_.size());
+
+  if (planner_types_.empty())
+    logError("%s: None of the planners '%s' can be used", getName().c_str(), types.c_str());
+  else if (!spec_.planner_statistics_)
+    logWarn("%s: No planner statistics are kept. Always using '%s'.", getName().c_str(),
+            planner_types_.front().c_str());
+}
+
+ompl_interface::AdaptivePlanner::~AdaptivePlanner()
+{
+}
+
+void ompl_interface::AdaptivePlanner::setProblemBucket(const std::string& bucket)
+{
+  bucket_ = bucket;
+}
+
+std::string ompl_interface::AdaptivePlanner::getStatisticsKey() const
+{
+  return bucket_.empty() ? group_ : group_ + "/" + bucket_;
+}
+
+ompl::base::PlannerStatus ompl_interface::AdaptivePlanner::solve(const ob::PlannerTerminationCondition& ptc)
+{
+  checkValidity();
+  if (planner_types_.empty())
+    return ob::PlannerStatus::UNKNOWN;
+
+  const std::string key = getStatisticsKey();
+  std::size_t index = 0;
+  if (spec_.planner_statistics_)
+  {
+    std::string type = spec_.planner_statistics_->selectPlanner(key, planner_types_);
+    index = std::find(planner_types_.begin(), planner_types_.end(), type) - planner_types_.begin();
+  }
+
+  // planners are allocated when first chosen and kept for later requests
+  ob::PlannerPtr& planner = planners_[index];
+  if (!planner)
+    planner = allocators_[index](si_, "", spec_);
+  if (planner->getProblemDefinition() != pdef_)
+    planner->setProblemDefinition(pdef_);
+  if (!planner->isSetup())
+    planner->setup();
+  last_planner_ = planner;
+
+  logDebug("%s: Solving '%s' with '%s'", getName().c_str(), key.c_str(), planner_types_[index].c_str());
+  ompl::time::point start = ompl::time::now();
+  ob::PlannerStatus status = planner->solve(ptc);
+  if (spec_.planner_statistics_)
+    spec_.planner_statistics_->addOutcome(key, planner_types_[index], status == ob::PlannerStatus::EXACT_SOLUTION,
+                                          ompl::time::seconds(ompl::time::now() - start));
+  return status;
+}
+
+void ompl_interface::AdaptivePlanner::clear()
+{
+  ob::Planner::clear();
+  for (std::size_t i = 0; i < planners_.size(); ++i)
+    if (planners_[i])
+      planners_[i]->clear();
+}
+
+void ompl_interface::AdaptivePlanner::getPlannerData(ob::PlannerData& data) const
+{
+  ob::Planner::getPlannerData(data);
+  if (last_planner_)
+    last_planner_->getPlannerData(data);
+}
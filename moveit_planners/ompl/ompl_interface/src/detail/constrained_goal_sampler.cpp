@@ -38,6 +38,7 @@
 #include <moveit/ompl_interface/model_based_planning_context.h>
 #include <moveit/ompl_interface/detail/state_validity_checker.h>
 #include <moveit/profiler/profiler.h>
+#include <algorithm>
 
 ompl_interface::ConstrainedGoalSampler::ConstrainedGoalSampler(
     const ModelBasedPlanningContext* pc, const kinematic_constraints::KinematicConstraintSetPtr& ks,
@@ -51,13 +52,148 @@ ompl_interface::ConstrainedGoalSampler::ConstrainedGoalSampler(
   , invalid_sampled_constraints_(0)
   , warned_invalid_samples_(false)
   , verbose_display_(0)
+  , cached_goal_states_added_(false)
+  , active_workers_(0)
+  , stop_workers_(false)
+  , worker_goals_(pc->getMaximumGoalSamples())
+  , worker_goal_count_(0)
 {
   if (!constraint_sampler_)
     default_sampler_ = si_->allocStateSampler();
+  else if (pc->getSpecification().constraint_sampler_manager_)
+  {
+    // there is no point in running more workers than there are goal states to find
+    unsigned int workers = std::min(pc->getMaximumGoalSamplingThreads(), pc->getMaximumGoalSamples());
+    for (unsigned int i = 1; i < workers; ++i)
+    {
+      constraint_samplers::ConstraintSamplerPtr cs = pc->getSpecification().constraint_sampler_manager_->selectSampler(
+          pc->getPlanningScene(), pc->getGroupName(), ks->getAllConstraints());
+      if (!cs)
+        break;
+      worker_samplers_.push_back(cs);
+    }
+    if (!worker_samplers_.empty())
+      logDebug("Sampling goals using %u additional threads", (unsigned int)worker_samplers_.size());
+  }
+  if (pc->getSpecification().goal_state_cache_)
+    goal_state_key_ = GoalStateCache::getKey(pc->getGroupName(), ks->getAllConstraints());
   logDebug("Constructed a ConstrainedGoalSampler instance at address %p", this);
   startSampling();
 }
 
+ompl_interface::ConstrainedGoalSampler::~ConstrainedGoalSampler()
+{
+  // the sampling thread calls into this instance, so it needs to be stopped before the members are destroyed
+  stopSampling();
+  stopWorkers();
+  storeGoalStates();
+  ob::State* goal;
+  while (worker_goals_.pop(goal))
+    si_->freeState(goal);
+}
+
+void ompl_interface::ConstrainedGoalSampler::addCachedGoalStates()
+{
+  std::vector<std::vector<double> > states;
+  planning_context_->getSpecification().goal_state_cache_->getGoalStates(goal_state_key_, states);
+  const unsigned int variable_count = planning_context_->getJointModelGroup()->getVariableCount();
+  ob::State* goal = si_->allocState();
+  for (std::size_t i = 0; i < states.size() && getStateCount() < planning_context_->getMaximumGoalSamples(); ++i)
+  {
+    if (states[i].size() != variable_count)
+      continue;
+    std::copy(states[i].begin(), states[i].end(), goal->as<ModelBasedStateSpace::StateType>()->values);
+    goal->as<ModelBasedStateSpace::StateType>()->clearKnownInformation();
+    // the states were valid in the scene and for the start state of the request that found them
+    planning_context_->getOMPLStateSpace()->copyToRobotState(work_state_, goal);
+    if (kinematic_constraint_set_->isSatisfied(work_state_) &&
+        static_cast<const StateValidityChecker*>(si_->getStateValidityChecker().get())->isValid(goal))
+      addState(goal);
+  }
+  si_->freeState(goal);
+  if (!states.empty())
+    logDebug("Using %u of %u cached goal states", getStateCount(), (unsigned int)states.size());
+}
+
+void ompl_interface::ConstrainedGoalSampler::storeGoalStates()
+{
+  if (goal_state_key_.empty())
+    return;
+  const unsigned int variable_count = planning_context_->getJointModelGroup()->getVariableCount();
+  std::vector<std::vector<double> > states(getStateCount());
+  for (std::size_t i = 0; i < states.size(); ++i)
+  {
+    const double* values = getState(i)->as<ModelBasedStateSpace::StateType>()->values;
+    states[i].assign(values, values + variable_count);
+  }
+  planning_context_->getSpecification().goal_state_cache_->addGoalStates(goal_state_key_, states,
+                                                                        planning_context_->getMaximumGoalSamples());
+}
+
+void ompl_interface::ConstrainedGoalSampler::startWorkers()
+{
+  if (worker_samplers_.empty() || active_workers_ > 0)
+    return;
+  // workers that stopped on their own still need to be joined
+  stopWorkers();
+  stop_workers_ = false;
+  active_workers_ = worker_samplers_.size();
+  workers_.reset(new boost::thread_group());
+  for (std::size_t i = 0; i < worker_samplers_.size(); ++i)
+    workers_->create_thread(boost::bind(&ConstrainedGoalSampler::sampleInWorker, this, worker_samplers_[i], i));
+}
+
+void ompl_interface::ConstrainedGoalSampler::stopWorkers()
+{
+  if (!workers_)
+    return;
+  stop_workers_ = true;
+  workers_->join_all();
+  workers_.reset();
+}
+
+bool ompl_interface::ConstrainedGoalSampler::popWorkerGoal(ob::State* new_goal)
+{
+  ob::State* goal;
+  if (!worker_goals_.pop(goal))
+    return false;
+  --worker_goal_count_;
+  si_->copyState(new_goal, goal);
+  si_->freeState(goal);
+  return true;
+}
+
+bool ompl_interface::ConstrainedGoalSampler::workersShouldStop() const
+{
+  return stop_workers_ || !isSampling() ||
+         getStateCount() + worker_goal_count_ >= planning_context_->getMaximumGoalSamples() ||
+         planning_context_->getOMPLSimpleSetup()->getProblemDefinition()->hasSolution();
+}
+
+void ompl_interface::ConstrainedGoalSampler::sampleInWorker(const constraint_samplers::ConstraintSamplerPtr& sampler,
+                                                            unsigned int index)
+{
+  planning_context_->seedThreadRandomNumberGenerator(ModelBasedPlanningContext::SEED_STREAM_GOAL_SAMPLING + 1 + index);
+  robot_state::RobotState work_state(planning_context_->getCompleteInitialRobotState());
+  ob::State* goal = si_->allocState();
+  while (!workersShouldStop())
+  {
+    sampler->setGroupStateValidityCallback(
+        boost::bind(&ompl_interface::ConstrainedGoalSampler::stateValidityCallback, this, goal, _1, _2, _3, false));
+    if (!sampler->project(work_state, planning_context_->getMaximumStateSamplingAttempts()))
+      continue;
+    work_state.update();
+    if (kinematic_constraint_set_->isSatisfied(work_state) && checkStateValidity(goal, work_state) &&
+        worker_goals_.push(goal))
+    {
+      ++worker_goal_count_;
+      goal = si_->allocState();
+    }
+  }
+  si_->freeState(goal);
+  --active_workers_;
+}
+
 bool ompl_interface::ConstrainedGoalSampler::checkStateValidity(ob::State* new_goal,
                                                                 const robot_state::RobotState& state,
                                                                 bool verbose) const
@@ -83,24 +219,58 @@ bool ompl_interface::ConstrainedGoalSampler::sampleUsingConstraintSampler(const
 {
   //  moveit::Profiler::ScopedBlock sblock("ConstrainedGoalSampler::sampleUsingConstraintSampler");
 
+  // OMPL starts a new sampling thread for every request
+  if (seeded_thread_ != boost::this_thread::get_id())
+  {
+    seeded_thread_ = boost::this_thread::get_id();
+    planning_context_->seedThreadRandomNumberGenerator(ModelBasedPlanningContext::SEED_STREAM_GOAL_SAMPLING);
+  }
+
+  // the cached goal states are checked by the sampling thread, once the context set up its state validity checker
+  if (!cached_goal_states_added_ && !goal_state_key_.empty() && si_->getStateValidityChecker())
+  {
+    cached_goal_states_added_ = true;
+    addCachedGoalStates();
+  }
+
   unsigned int max_attempts = planning_context_->getMaximumGoalSamplingAttempts();
   unsigned int attempts_so_far = gls->samplingAttemptsCount();
 
-  // terminate after too many attempts
-  if (attempts_so_far >= max_attempts)
-    return false;
-
   // terminate after a maximum number of samples
   if (gls->getStateCount() >= planning_context_->getMaximumGoalSamples())
+  {
+    stopWorkers();
+    storeGoalStates();
     return false;
+  }
 
   // terminate the sampling thread when a solution has been found
   if (planning_context_->getOMPLSimpleSetup()->getProblemDefinition()->hasSolution())
+  {
+    stopWorkers();
+    storeGoalStates();
     return false;
+  }
+
+  // goals found by the workers are passed on first, even if this thread ran out of attempts
+  if (popWorkerGoal(new_goal))
+    return true;
+
+  // terminate after too many attempts
+  if (attempts_so_far >= max_attempts)
+  {
+    stopWorkers();
+    return popWorkerGoal(new_goal);
+  }
+
+  startWorkers();
 
   unsigned int max_attempts_div2 = max_attempts / 2;
   for (unsigned int a = gls->samplingAttemptsCount(); a < max_attempts && gls->isSampling(); ++a)
   {
+    if (popWorkerGoal(new_goal))
+      return true;
+
     bool verbose = false;
     if (gls->getStateCount() == 0 && a >= max_attempts_div2)
       if (verbose_display_ < 1)
@@ -123,7 +293,7 @@ bool ompl_interface::ConstrainedGoalSampler::sampleUsingConstraintSampler(const
       if (constraint_sampler_->project(work_state_, planning_context_->getMaximumStateSamplingAttempts()))
       {
         work_state_.update();
-        if (kinematic_constraint_set_->decide(work_state_, verbose).satisfied)
+        if (kinematic_constraint_set_->isSatisfied(work_state_, verbose))
         {
           if (checkStateValidity(new_goal, work_state_, verbose))
             return true;
@@ -146,10 +316,11 @@ bool ompl_interface::ConstrainedGoalSampler::sampleUsingConstraintSampler(const
       if (static_cast<const StateValidityChecker*>(si_->getStateValidityChecker().get())->isValid(new_goal, verbose))
       {
         planning_context_->getOMPLStateSpace()->copyToRobotState(work_state_, new_goal);
-        if (kinematic_constraint_set_->decide(work_state_, verbose).satisfied)
+        if (kinematic_constraint_set_->isSatisfied(work_state_, verbose))
           return true;
       }
     }
   }
-  return false;
+  stopWorkers();
+  return popWorkerGoal(new_goal);
 }
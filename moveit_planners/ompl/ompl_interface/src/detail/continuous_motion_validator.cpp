@@ -0,0 +1,89 @@
+/*********************************************************************
+* Software License Agreement (BSD License)
+*
+*  Copyright (c) 2026, the MoveIt contributors
+*  All rights reserved.
+*
+*  Redistribution and use in source and binary forms, with or without
+*  modification, are permitted provided that the following conditions
+*  are met:
+*
+*   * Redistributions of source code must retain the above copyright
+*     notice, this list of conditions and the following disclaimer.
+*   * Redistributions in binary form must reproduce the above
+*     copyright notice, this list of conditions and the following
+*     disclaimer in the documentation and/or other materials provided
+*     with the distribution.
+*   * Neither the name of the copyright holder nor the names of its
+*     contributors may be used to endorse or promote products derived
+*     from this software without specific prior written permission.
+*
+*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+*  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+*  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+*  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+*  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+*  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+*  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+*  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+*  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+*  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+*  POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************/
+
+
+#include <moveit/ompl_interface/detail/continuous_motion_validator.h>
+#include <moveit/ompl_interface/model_based_planning_context.h>
+
+ompl_interface::ContinuousMotionValidator::ContinuousMotionValidator(const ModelBasedPlanningContext* pc)
+  : ompl::base::MotionValidator(pc->getOMPLSimpleSetup()->getSpaceInformation())
+  , planning_context_(pc)
+  , tss1_(pc->getCompleteInitialRobotState())
+  , tss2_(pc->getCompleteInitialRobotState())
+{
+  collision_request_.group_name = planning_context_->getGroupName();
+}
+
+bool ompl_interface::ContinuousMotionValidator::checkMotion(const ompl::base::State* s1,
+                                                            const ompl::base::State* s2) const
+{
+  // the start state is assumed to be valid, as in the discrete motion validator
+  bool result = si_->isValid(s2) && isMotionCollisionFree(s1, s2);
+  if (result)
+    valid_++;
+  else
+    invalid_++;
+  return result;
+}
+
+bool ompl_interface::ContinuousMotionValidator::checkMotion(const ompl::base::State* s1, const ompl::base::State* s2,
+                                                            std::pair<ompl::base::State*, double>& lastValid) const
+{
+  if (checkMotion(s1, s2))
+    return true;
+  if (lastValid.first)
+    si_->copyState(lastValid.first, s1);
+  lastValid.second = 0.0;
+  return false;
+}
+
+bool ompl_interface::ContinuousMotionValidator::isMotionCollisionFree(const ompl::base::State* s1,
+                                                                      const ompl::base::State* s2) const
+{
+  robot_state::RobotState* kstate1 = tss1_.getStateStorage();
+  robot_state::RobotState* kstate2 = tss2_.getStateStorage();
+  planning_context_->getOMPLStateSpace()->copyToRobotState(*kstate1, s1);
+  planning_context_->getOMPLStateSpace()->copyToRobotState(*kstate2, s2);
+
+  // same robot representations as planning_scene::PlanningScene::checkCollision()
+  const planning_scene::PlanningSceneConstPtr& scene = planning_context_->getPlanningScene();
+  collision_detection::CollisionResult res;
+  scene->getCollisionWorld()->checkRobotCollision(collision_request_, res, *scene->getCollisionRobot(), *kstate1,
+                                                  *kstate2, scene->getAllowedCollisionMatrix());
+  if (res.collision)
+    return false;
+  scene->getCollisionRobotUnpadded()->checkSelfCollision(collision_request_, res, *kstate1, *kstate2,
+                                                         scene->getAllowedCollisionMatrix());
+  return !res.collision;
+}
@@ -0,0 +1,115 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/ompl_interface/detail/goal_state_cache.h>
+#include <ros/serialization.h>
+#include <algorithm>
+
+ompl_interface::GoalStateCache::GoalStateCache(std::size_t max_goals) : max_goals_(max_goals), use_counter_(0)
+{
+}
+
+std::string ompl_interface::GoalStateCache::getKey(const std::string& group,
+                                                   const moveit_msgs::Constraints& constraints)
+{
+  moveit_msgs::Constraints c = constraints;
+  for (std::size_t i = 0; i < c.position_constraints.size(); ++i)
+    c.position_constraints[i].header.stamp = ros::Time();
+  for (std::size_t i = 0; i < c.orientation_constraints.size(); ++i)
+    c.orientation_constraints[i].header.stamp = ros::Time();
+  for (std::size_t i = 0; i < c.visibility_constraints.size(); ++i)
+  {
+    c.visibility_constraints[i].target_pose.header.stamp = ros::Time();
+    c.visibility_constraints[i].sensor_pose.header.stamp = ros::Time();
+  }
+
+  // the group name, followed by the serialized constraints
+  std::string key = group;
+  key.push_back('\0');
+  const std::size_t offset = key.size();
+  const uint32_t length = ros::serialization::serializationLength(c);
+  key.resize(offset + length);
+  ros::serialization::OStream stream(reinterpret_cast<uint8_t*>(&key[offset]), length);
+  ros::serialization::serialize(stream, c);
+  return key;
+}
+
+void ompl_interface::GoalStateCache::getGoalStates(const std::string& key, std::vector<std::vector<double> >& states)
+{
+  boost::mutex::scoped_lock slock(lock_);
+  std::map<std::string, Entry>::iterator it = entries_.find(key);
+  if (it == entries_.end())
+  {
+    states.clear();
+    return;
+  }
+  it->second.last_use_ = ++use_counter_;
+  states = it->second.states_;
+}
+
+void ompl_interface::GoalStateCache::addGoalStates(const std::string& key,
+                                                   const std::vector<std::vector<double> >& states,
+                                                   std::size_t max_states)
+{
+  if (states.empty())
+    return;
+  boost::mutex::scoped_lock slock(lock_);
+  Entry& entry = entries_[key];
+  entry.last_use_ = ++use_counter_;
+
+  std::vector<std::vector<double> > merged;
+  merged.reserve(std::min(max_states, states.size() + entry.states_.size()));
+  for (std::size_t i = 0; i < states.size() && merged.size() < max_states; ++i)
+    if (std::find(merged.begin(), merged.end(), states[i]) == merged.end())
+      merged.push_back(states[i]);
+  for (std::size_t i = 0; i < entry.states_.size() && merged.size() < max_states; ++i)
+    if (std::find(merged.begin(), merged.end(), entry.states_[i]) == merged.end())
+      merged.push_back(entry.states_[i]);
+  entry.states_.swap(merged);
+
+  if (entries_.size() > max_goals_)
+  {
+    std::map<std::string, Entry>::iterator oldest = entries_.begin();
+    for (std::map<std::string, Entry>::iterator it = entries_.begin(); it != entries_.end(); ++it)
+      if (it->second.last_use_ < oldest->second.last_use_)
+        oldest = it;
+    entries_.erase(oldest);
+  }
+}
+
+void ompl_interface::GoalStateCache::clear()
+{
+  boost::mutex::scoped_lock slock(lock_);
+  entries_.clear();
+}
@@ -0,0 +1,165 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/ompl_interface/detail/lazy_motion_validator.h>
+#include <moveit/ompl_interface/model_based_planning_context.h>
+
+namespace ompl_interface
+{
+namespace
+{
+// the remembered edges are discarded when there are more than this many, so memory stays bounded
+static const std::size_t MAX_CHECKED_MOTIONS = 1 << 16;
+}
+}
+
+ompl_interface::LazyMotionValidator::LazyMotionValidator(const ModelBasedPlanningContext* pc,
+                                                         const ompl::base::MotionValidatorPtr& eager_motion_validator)
+  : ompl::base::MotionValidator(pc->getOMPLSimpleSetup()->getSpaceInformation())
+  , planning_context_(pc)
+  , eager_motion_validator_(eager_motion_validator)
+  , variable_count_(pc->getJointModelGroup()->getVariableCount())
+  , lazy_(false)
+{
+}
+
+bool ompl_interface::LazyMotionValidator::checkMotion(const ompl::base::State* s1, const ompl::base::State* s2) const
+{
+  MotionKey key;
+  getMotionKey(s1, s2, key);
+  MotionValidity validity = getCheckedMotion(key);
+  bool result;
+  if (validity != UNKNOWN)
+    result = validity == VALID;
+  else if (lazy_)
+    // the motion is checked later, if it is part of a solution path
+    result = si_->isValid(s2);
+  else
+    result = eager_motion_validator_->checkMotion(s1, s2);
+
+  if (result)
+    valid_++;
+  else
+    invalid_++;
+  return result;
+}
+
+bool ompl_interface::LazyMotionValidator::checkMotion(const ompl::base::State* s1, const ompl::base::State* s2,
+                                                      std::pair<ompl::base::State*, double>& lastValid) const
+{
+  MotionKey key;
+  getMotionKey(s1, s2, key);
+  MotionValidity validity = getCheckedMotion(key);
+  bool result;
+  if (validity == VALID || (validity == UNKNOWN && lazy_ && si_->isValid(s2)))
+    result = true;
+  else
+    // the eager motion validator finds the last valid state of the motion
+    result = eager_motion_validator_->checkMotion(s1, s2, lastValid);
+
+  if (result)
+    valid_++;
+  else
+    invalid_++;
+  return result;
+}
+
+bool ompl_interface::LazyMotionValidator::checkPath(const ompl::geometric::PathGeometric& path) const
+{
+  MotionKey key;
+  for (std::size_t i = 1; i < path.getStateCount(); ++i)
+  {
+    getMotionKey(path.getState(i - 1), path.getState(i), key);
+    MotionValidity validity = getCheckedMotion(key);
+    if (validity == UNKNOWN)
+    {
+      bool valid = eager_motion_validator_->checkMotion(path.getState(i - 1), path.getState(i));
+      addCheckedMotion(key, valid);
+      validity = valid ? VALID : INVALID;
+    }
+    if (validity == INVALID)
+    {
+      logDebug("%s: Edge %u of %u of the candidate solution is invalid", planning_context_->getName().c_str(),
+               (unsigned int)i, (unsigned int)path.getStateCount() - 1);
+      return false;
+    }
+  }
+  return true;
+}
+
+void ompl_interface::LazyMotionValidator::setSceneVersion(const RoadmapSceneVersion& version)
+{
+  boost::mutex::scoped_lock slock(lock_);
+  if (scene_version_ != version)
+  {
+    checked_motions_.clear();
+    scene_version_ = version;
+  }
+}
+
+void ompl_interface::LazyMotionValidator::clearCheckedMotions()
+{
+  boost::mutex::scoped_lock slock(lock_);
+  checked_motions_.clear();
+}
+
+void ompl_interface::LazyMotionValidator::getMotionKey(const ompl::base::State* s1, const ompl::base::State* s2,
+                                                       MotionKey& key) const
+{
+  const double* values1 = s1->as<ModelBasedStateSpace::StateType>()->values;
+  const double* values2 = s2->as<ModelBasedStateSpace::StateType>()->values;
+  key.resize(2 * variable_count_);
+  std::copy(values1, values1 + variable_count_, key.begin());
+  std::copy(values2, values2 + variable_count_, key.begin() + variable_count_);
+}
+
+ompl_interface::LazyMotionValidator::MotionValidity
+ompl_interface::LazyMotionValidator::getCheckedMotion(const MotionKey& key) const
+{
+  boost::mutex::scoped_lock slock(lock_);
+  if (checked_motions_.empty())
+    return UNKNOWN;
+  boost::unordered_map<MotionKey, bool>::const_iterator it = checked_motions_.find(key);
+  if (it == checked_motions_.end())
+    return UNKNOWN;
+  return it->second ? VALID : INVALID;
+}
+
+void ompl_interface::LazyMotionValidator::addCheckedMotion(const MotionKey& key, bool valid) const
+{
+  boost::mutex::scoped_lock slock(lock_);
+  if (checked_motions_.size() >= MAX_CHECKED_MOTIONS)
+    checked_motions_.clear();
+  checked_motions_[key] = valid;
+}
@@ -0,0 +1,90 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/ompl_interface/detail/planning_thread_pool.h>
+
+ompl_interface::PlanningThreadPool::PlanningThreadPool() : thread_count_(0), run_threads_(true)
+{
+}
+
+ompl_interface::PlanningThreadPool::~PlanningThreadPool()
+{
+  {
+    boost::mutex::scoped_lock slock(lock_);
+    run_threads_ = false;
+    jobs_.clear();
+  }
+  new_job_condition_.notify_all();
+  threads_.join_all();
+}
+
+void ompl_interface::PlanningThreadPool::reserve(unsigned int count)
+{
+  boost::mutex::scoped_lock slock(lock_);
+  for (; thread_count_ < count; ++thread_count_)
+    threads_.create_thread(boost::bind(&PlanningThreadPool::workerThread, this));
+}
+
+unsigned int ompl_interface::PlanningThreadPool::getThreadCount() const
+{
+  boost::mutex::scoped_lock slock(lock_);
+  return thread_count_;
+}
+
+void ompl_interface::PlanningThreadPool::addJob(const Job& job)
+{
+  {
+    boost::mutex::scoped_lock slock(lock_);
+    jobs_.push_back(job);
+  }
+  new_job_condition_.notify_one();
+}
+
+void ompl_interface::PlanningThreadPool::workerThread()
+{
+  while (true)
+  {
+    Job job;
+    {
+      boost::mutex::scoped_lock slock(lock_);
+      while (run_threads_ && jobs_.empty())
+        new_job_condition_.wait(slock);
+      if (!run_threads_)
+        return;
+      job = jobs_.front();
+      jobs_.pop_front();
+    }
+    job();
+  }
+}
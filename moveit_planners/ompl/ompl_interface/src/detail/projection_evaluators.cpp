@@ -66,12 +66,65 @@ void ompl_interface::ProjectionEvaluatorLinkPose::project(const ompl::base::Stat
   robot_state::RobotState* s = tss_.getStateStorage();
   planning_context_->getOMPLStateSpace()->copyToRobotState(*s, state);
 
-  const Eigen::Vector3d& o = s->getGlobalLinkTransform(link_).translation();
+  // only the transforms on the way to the link are needed, not those of the rest of the robot
+  s->updateLinkTransformChain(link_);
+  const robot_state::RobotState& updated_state = *s;
+  const Eigen::Vector3d& o = updated_state.getGlobalLinkTransform(link_).translation();
   projection(0) = o.x();
   projection(1) = o.y();
   projection(2) = o.z();
 }
 
+ompl_interface::ProjectionEvaluatorLinkLinear::ProjectionEvaluatorLinkLinear(const ModelBasedPlanningContext* pc,
+                                                                             const std::string& link)
+  : ompl::base::ProjectionEvaluator(pc->getOMPLStateSpace())
+{
+  const robot_model::JointModelGroup* jmg = pc->getJointModelGroup();
+  robot_state::RobotState state = pc->getCompleteInitialRobotState();
+  state.update();
+  const robot_model::LinkModel* link_model = pc->getRobotModel()->getLinkModel(link);
+
+  Eigen::MatrixXd jacobian;
+  if (!state.getJacobian(jmg, link_model, Eigen::Vector3d::Zero(), jacobian))
+  {
+    logError("Unable to compute the Jacobian of link '%s' for group '%s'; the linear projection is constant",
+             link.c_str(), jmg->getName().c_str());
+    jacobian = Eigen::MatrixXd::Zero(6, jmg->getVariableCount());
+  }
+  jacobian_ = jacobian.topRows(3);
+
+  // fold the linearization point into the offset, so that projecting is a single matrix-vector product
+  Eigen::VectorXd values(jmg->getVariableCount());
+  state.copyJointGroupPositions(jmg, values);
+  offset_ = state.getGlobalLinkTransform(link_model).translation() - jacobian_ * values;
+}
+
+unsigned int ompl_interface::ProjectionEvaluatorLinkLinear::getDimension() const
+{
+  return 3;
+}
+
+void ompl_interface::ProjectionEvaluatorLinkLinear::defaultCellSizes()
+{
+  cellSizes_.resize(3);
+  cellSizes_[0] = 0.1;
+  cellSizes_[1] = 0.1;
+  cellSizes_[2] = 0.1;
+}
+
+void ompl_interface::ProjectionEvaluatorLinkLinear::project(const ompl::base::State* state,
+                                                            ompl::base::EuclideanProjection& projection) const
+{
+  const double* values = state->as<ModelBasedStateSpace::StateType>()->values;
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    double p = offset_(i);
+    for (unsigned int j = 0; j < jacobian_.cols(); ++j)
+      p += jacobian_(i, j) * values[j];
+    projection(i) = p;
+  }
+}
+
 ompl_interface::ProjectionEvaluatorJointValue::ProjectionEvaluatorJointValue(const ModelBasedPlanningContext* pc,
                                                                              const std::vector<unsigned int>& variables)
   : ompl::base::ProjectionEvaluator(pc->getOMPLStateSpace()), planning_context_(pc), variables_(variables)
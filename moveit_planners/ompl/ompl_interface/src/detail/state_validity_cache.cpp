@@ -0,0 +1,146 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/ompl_interface/detail/state_validity_cache.h>
+#include <cmath>
+
+namespace ompl_interface
+{
+namespace
+{
+// bounds of the number of entries of the table (8 bytes each); sizes are powers of two
+static const std::size_t MIN_CACHE_SIZE = 1 << 12;
+static const std::size_t MAX_CACHE_SIZE = 1 << 20;
+
+// the number of consecutive slots an entry can be stored in
+static const std::size_t PROBE_LENGTH = 8;
+
+// the low bits of an entry: the entry is in use, and the state is valid; the hash is kept in the other bits
+static const uint64_t ENTRY_USED = 1;
+static const uint64_t ENTRY_VALID = 2;
+static const uint64_t ENTRY_FLAGS = ENTRY_USED | ENTRY_VALID;
+}
+}
+
+ompl_interface::StateValidityCache::StateValidityCache(unsigned int variable_count, double resolution)
+  : variable_count_(variable_count)
+  , inv_resolution_(1.0 / resolution)
+  , entries_(new std::atomic<uint64_t>[MIN_CACHE_SIZE])
+  , size_(MIN_CACHE_SIZE)
+  , hits_(0)
+  , misses_(0)
+  , inserted_(0)
+{
+  for (std::size_t i = 0; i < size_; ++i)
+    entries_[i].store(0, std::memory_order_relaxed);
+}
+
+uint64_t ompl_interface::StateValidityCache::hash(const double* values) const
+{
+  uint64_t h = 0xcbf29ce484222325ULL;
+  for (unsigned int i = 0; i < variable_count_; ++i)
+  {
+    h ^= (uint64_t)std::llround(values[i] * inv_resolution_);
+    h *= 0x9e3779b97f4a7c15ULL;
+    h ^= h >> 29;
+  }
+  h ^= h >> 32;
+  h *= 0xd6e8feb86659fd93ULL;
+  h ^= h >> 32;
+  return h & ~ENTRY_FLAGS;
+}
+
+bool ompl_interface::StateValidityCache::lookup(const double* values, bool& valid) const
+{
+  const uint64_t h = hash(values);
+  const std::size_t mask = size_ - 1;
+  for (std::size_t i = 0, slot = (h >> 2) & mask; i < PROBE_LENGTH; ++i, slot = (slot + 1) & mask)
+  {
+    const uint64_t entry = entries_[slot].load(std::memory_order_relaxed);
+    if (entry == 0)
+      break;
+    if ((entry & ~ENTRY_FLAGS) == h)
+    {
+      valid = entry & ENTRY_VALID;
+      hits_.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  misses_.fetch_add(1, std::memory_order_relaxed);
+  return false;
+}
+
+void ompl_interface::StateValidityCache::insert(const double* values, bool valid) const
+{
+  const uint64_t h = hash(values);
+  const uint64_t new_entry = h | ENTRY_USED | (valid ? ENTRY_VALID : 0);
+  const std::size_t mask = size_ - 1;
+  const std::size_t first_slot = (h >> 2) & mask;
+  for (std::size_t i = 0, slot = first_slot; i < PROBE_LENGTH; ++i, slot = (slot + 1) & mask)
+  {
+    uint64_t entry = entries_[slot].load(std::memory_order_relaxed);
+    if (entry == 0)
+    {
+      if (entries_[slot].compare_exchange_strong(entry, new_entry, std::memory_order_relaxed))
+      {
+        inserted_.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+      // another thread took the slot; it may have stored this same state
+    }
+    if ((entry & ~ENTRY_FLAGS) == h)
+      return;
+  }
+  // all slots are taken: replace the first one
+  entries_[first_slot].store(new_entry, std::memory_order_relaxed);
+  inserted_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void ompl_interface::StateValidityCache::clear()
+{
+  // keep the table at most half full for as many states as the previous request stored
+  std::size_t size = MIN_CACHE_SIZE;
+  while (size < MAX_CACHE_SIZE && size < 2 * inserted_)
+    size *= 2;
+  if (size != size_)
+  {
+    entries_.reset(new std::atomic<uint64_t>[size]);
+    size_ = size;
+  }
+  for (std::size_t i = 0; i < size_; ++i)
+    entries_[i].store(0, std::memory_order_relaxed);
+  hits_ = 0;
+  misses_ = 0;
+  inserted_ = 0;
+}
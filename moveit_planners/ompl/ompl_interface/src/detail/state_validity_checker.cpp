@@ -68,6 +68,12 @@ void ompl_interface::StateValidityChecker::setVerbose(bool flag)
   verbose_ = flag;
 }
 
+void ompl_interface::StateValidityChecker::setMaximumClearance(double distance)
+{
+  collision_request_with_distance_.max_distance = distance;
+  collision_request_with_distance_verbose_.max_distance = distance;
+}
+
 bool ompl_interface::StateValidityChecker::isValid(const ompl::base::State* state, bool verbose) const
 {
   //  moveit::Profiler::ScopedBlock sblock("isValid");
@@ -122,12 +128,17 @@ bool ompl_interface::StateValidityChecker::isValidWithoutCache(const ompl::base:
 
   // convert ompl state to moveit robot state
   robot_state::RobotState* kstate = tss_.getStateStorage();
-  planning_context_->getOMPLStateSpace()->copyToRobotState(*kstate, state);
+  planning_context_->getOMPLStateSpace()->copyJointValuesToRobotState(*kstate, state);
 
-  // check path constraints
+  // check path constraints; only the links they look at are computed, so violating states are rejected cheaply
   const kinematic_constraints::KinematicConstraintSetPtr& kset = planning_context_->getPathConstraints();
-  if (kset && !kset->decide(*kstate, verbose).satisfied)
-    return false;
+  if (kset)
+  {
+    kset->updateLinkTransforms(*kstate);
+    if (!kset->isSatisfied(*kstate, verbose))
+      return false;
+  }
+  kstate->update();
 
   // check feasibility
   if (!planning_context_->getPlanningScene()->isStateFeasible(*kstate, verbose))
@@ -151,12 +162,13 @@ bool ompl_interface::StateValidityChecker::isValidWithoutCache(const ompl::base:
   }
 
   robot_state::RobotState* kstate = tss_.getStateStorage();
-  planning_context_->getOMPLStateSpace()->copyToRobotState(*kstate, state);
+  planning_context_->getOMPLStateSpace()->copyJointValuesToRobotState(*kstate, state);
 
   // check path constraints
   const kinematic_constraints::KinematicConstraintSetPtr& kset = planning_context_->getPathConstraints();
   if (kset)
   {
+    kset->updateLinkTransforms(*kstate);
     kinematic_constraints::ConstraintEvaluationResult cer = kset->decide(*kstate, verbose);
     if (!cer.satisfied)
     {
@@ -164,6 +176,7 @@ bool ompl_interface::StateValidityChecker::isValidWithoutCache(const ompl::base:
       return false;
     }
   }
+  kstate->update();
 
   // check feasibility
   if (!planning_context_->getPlanningScene()->isStateFeasible(*kstate, verbose))
@@ -193,21 +206,41 @@ bool ompl_interface::StateValidityChecker::isValidWithCache(const ompl::base::St
     return false;
   }
 
+  // copies of this state may have been checked already
+  const double* values = state->as<ModelBasedStateSpace::StateType>()->values;
+  const StateValidityCache& cache = planning_context_->getStateValidityCache();
+  bool cached_valid;
+  if (cache.lookup(values, cached_valid))
+  {
+    if (cached_valid)
+      const_cast<ob::State*>(state)->as<ModelBasedStateSpace::StateType>()->markValid();
+    else
+      const_cast<ob::State*>(state)->as<ModelBasedStateSpace::StateType>()->markInvalid();
+    return cached_valid;
+  }
+
   robot_state::RobotState* kstate = tss_.getStateStorage();
-  planning_context_->getOMPLStateSpace()->copyToRobotState(*kstate, state);
+  planning_context_->getOMPLStateSpace()->copyJointValuesToRobotState(*kstate, state);
 
-  // check path constraints
+  // check path constraints; only the links they look at are computed, so violating states are rejected cheaply
   const kinematic_constraints::KinematicConstraintSetPtr& kset = planning_context_->getPathConstraints();
-  if (kset && !kset->decide(*kstate, verbose).satisfied)
+  if (kset)
   {
-    const_cast<ob::State*>(state)->as<ModelBasedStateSpace::StateType>()->markInvalid();
-    return false;
+    kset->updateLinkTransforms(*kstate);
+    if (!kset->isSatisfied(*kstate, verbose))
+    {
+      const_cast<ob::State*>(state)->as<ModelBasedStateSpace::StateType>()->markInvalid();
+      cache.insert(values, false);
+      return false;
+    }
   }
+  kstate->update();
 
   // check feasibility
   if (!planning_context_->getPlanningScene()->isStateFeasible(*kstate, verbose))
   {
     const_cast<ob::State*>(state)->as<ModelBasedStateSpace::StateType>()->markInvalid();
+    cache.insert(values, false);
     return false;
   }
 
@@ -215,6 +248,7 @@ bool ompl_interface::StateValidityChecker::isValidWithCache(const ompl::base::St
   collision_detection::CollisionResult res;
   planning_context_->getPlanningScene()->checkCollision(
       verbose ? collision_request_simple_verbose_ : collision_request_simple_, res, *kstate);
+  cache.insert(values, res.collision == false);
   if (res.collision == false)
   {
     const_cast<ob::State*>(state)->as<ModelBasedStateSpace::StateType>()->markValid();
@@ -246,12 +280,13 @@ bool ompl_interface::StateValidityChecker::isValidWithCache(const ompl::base::St
   }
 
   robot_state::RobotState* kstate = tss_.getStateStorage();
-  planning_context_->getOMPLStateSpace()->copyToRobotState(*kstate, state);
+  planning_context_->getOMPLStateSpace()->copyJointValuesToRobotState(*kstate, state);
 
   // check path constraints
   const kinematic_constraints::KinematicConstraintSetPtr& kset = planning_context_->getPathConstraints();
   if (kset)
   {
+    kset->updateLinkTransforms(*kstate);
     kinematic_constraints::ConstraintEvaluationResult cer = kset->decide(*kstate, verbose);
     if (!cer.satisfied)
     {
@@ -260,6 +295,7 @@ bool ompl_interface::StateValidityChecker::isValidWithCache(const ompl::base::St
       return false;
     }
   }
+  kstate->update();
 
   // check feasibility
   if (!planning_context_->getPlanningScene()->isStateFeasible(*kstate, verbose))
@@ -35,27 +35,71 @@
 /* Author: Ioan Sucan */
 
 #include <moveit/ompl_interface/detail/threadsafe_state_storage.h>
+#include <atomic>
 
-ompl_interface::TSStateStorage::TSStateStorage(const robot_model::RobotModelPtr& kmodel) : start_state_(kmodel)
+namespace
+{
+// the number of storages whose states each thread remembers
+static const std::size_t THREAD_CACHE_SIZE = 8;
+
+struct ThreadStateCache
+{
+  ThreadStateCache() : next_(0)
+  {
+    for (std::size_t i = 0; i < THREAD_CACHE_SIZE; ++i)
+    {
+      ids_[i] = 0;
+      states_[i] = NULL;
+    }
+  }
+
+  uint64_t ids_[THREAD_CACHE_SIZE];
+  robot_state::RobotState* states_[THREAD_CACHE_SIZE];
+  std::size_t next_;
+};
+
+thread_local ThreadStateCache thread_state_cache;
+
+std::atomic<uint64_t> next_storage_id(1);
+}
+
+ompl_interface::TSStateStorage::TSStateStorage(const robot_model::RobotModelPtr& kmodel)
+  : id_(next_storage_id.fetch_add(1)), start_state_(kmodel)
 {
   start_state_.setToDefaultValues();
 }
 
-ompl_interface::TSStateStorage::TSStateStorage(const robot_state::RobotState& start_state) : start_state_(start_state)
+ompl_interface::TSStateStorage::TSStateStorage(const robot_state::RobotState& start_state)
+  : id_(next_storage_id.fetch_add(1)), start_state_(start_state)
 {
 }
 
 ompl_interface::TSStateStorage::~TSStateStorage()
 {
+  // entries for this storage left in the caches of threads are never matched again, as ids are not reused
   for (std::map<boost::thread::id, robot_state::RobotState*>::iterator it = thread_states_.begin();
        it != thread_states_.end(); ++it)
     delete it->second;
 }
 
 robot_state::RobotState* ompl_interface::TSStateStorage::getStateStorage() const
+{
+  ThreadStateCache& cache = thread_state_cache;
+  for (std::size_t i = 0; i < THREAD_CACHE_SIZE; ++i)
+    if (cache.ids_[i] == id_)
+      return cache.states_[i];
+
+  robot_state::RobotState* st = getStateStorageLocked();
+  cache.ids_[cache.next_] = id_;
+  cache.states_[cache.next_] = st;
+  cache.next_ = (cache.next_ + 1) % THREAD_CACHE_SIZE;
+  return st;
+}
+
+robot_state::RobotState* ompl_interface::TSStateStorage::getStateStorageLocked() const
 {
   robot_state::RobotState* st = NULL;
-  boost::mutex::scoped_lock slock(lock_);  /// \todo use Thread Local Storage?
+  boost::mutex::scoped_lock slock(lock_);
   std::map<boost::thread::id, robot_state::RobotState*>::const_iterator it =
       thread_states_.find(boost::this_thread::get_id());
   if (it == thread_states_.end())
@@ -35,16 +35,21 @@
 /* Author: Ioan Sucan */
 
 #include <boost/algorithm/string/trim.hpp>
+#include <boost/lexical_cast.hpp>
 
 #include <moveit/ompl_interface/model_based_planning_context.h>
 #include <moveit/ompl_interface/detail/state_validity_checker.h>
+#include <moveit/ompl_interface/detail/continuous_motion_validator.h>
 #include <moveit/ompl_interface/detail/constrained_sampler.h>
 #include <moveit/ompl_interface/detail/constrained_goal_sampler.h>
 #include <moveit/ompl_interface/detail/goal_union.h>
 #include <moveit/ompl_interface/detail/projection_evaluators.h>
+#include <moveit/ompl_interface/detail/adaptive_planner.h>
 #include <moveit/ompl_interface/constraints_library.h>
 #include <moveit/kinematic_constraints/utils.h>
+#include <moveit/robot_state/random_number_generator.h>
 #include <moveit/profiler/profiler.h>
+#include <moveit/profiler/tracer.h>
 #include <eigen_conversions/eigen_msg.h>
 
 #include <ompl/base/samplers/UniformValidStateSampler.h>
@@ -52,6 +57,10 @@
 #include <ompl/tools/config/SelfConfig.h>
 #include <ompl/base/spaces/SE3StateSpace.h>
 #include <ompl/datastructures/PDF.h>
+#include <ompl/geometric/planners/prm/LazyPRM.h>
+#include <ompl/geometric/planners/rrt/LazyRRT.h>
+#include <ompl/geometric/PathHybridization.h>
+#include <ompl/geometric/PathSimplifier.h>
 
 #include "ompl/base/objectives/PathLengthOptimizationObjective.h"
 #include "ompl/base/objectives/MechanicalWorkOptimizationObjective.h"
@@ -66,25 +75,37 @@ ompl_interface::ModelBasedPlanningContext::ModelBasedPlanningContext(const std::
   , complete_initial_robot_state_(spec.state_space_->getRobotModel())
   , ompl_simple_setup_(spec.ompl_simple_setup_)
   , ompl_benchmark_(*ompl_simple_setup_)
-  , ompl_parallel_plan_(ompl_simple_setup_->getProblemDefinition())
   , ptc_(NULL)
   , last_plan_time_(0.0)
   , last_simplify_time_(0.0)
   , max_goal_samples_(0)
   , max_state_sampling_attempts_(0)
   , max_goal_sampling_attempts_(0)
+  , max_goal_sampling_threads_(1)
   , max_planning_threads_(0)
   , max_solution_segment_length_(0.0)
   , minimum_waypoint_count_(0)
   , use_state_validity_cache_(true)
+  , state_validity_cache_(spec.state_space_->getJointModelGroup()->getVariableCount())
   , simplify_solutions_(true)
+  , persistent_roadmap_(false)
+  , lazy_collision_checking_(false)
+  , use_random_seed_(false)
+  , random_seed_(0)
 {
   complete_initial_robot_state_.update();
+  if (!spec_.planning_thread_pool_)
+    spec_.planning_thread_pool_.reset(new PlanningThreadPool());
   ompl_simple_setup_->getStateSpace()->computeSignature(space_signature_);
   ompl_simple_setup_->getStateSpace()->setStateSamplerAllocator(
       boost::bind(&ModelBasedPlanningContext::allocPathConstrainedSampler, this, _1));
 }
 
+ompl_interface::ModelBasedPlanningContext::~ModelBasedPlanningContext()
+{
+  checkinRoadmap();
+}
+
 void ompl_interface::ModelBasedPlanningContext::setProjectionEvaluator(const std::string& peval)
 {
   if (!spec_.state_space_)
@@ -100,7 +121,17 @@ void ompl_interface::ModelBasedPlanningContext::setProjectionEvaluator(const std
 ompl::base::ProjectionEvaluatorPtr
 ompl_interface::ModelBasedPlanningContext::getProjectionEvaluator(const std::string& peval) const
 {
-  if (peval.find_first_of("link(") == 0 && peval[peval.length() - 1] == ')')
+  if (peval.compare(0, 12, "linear_link(") == 0 && peval[peval.length() - 1] == ')')
+  {
+    std::string link_name = peval.substr(12, peval.length() - 13);
+    if (getJointModelGroup()->hasLinkModel(link_name))
+      return ob::ProjectionEvaluatorPtr(new ProjectionEvaluatorLinkLinear(this, link_name));
+    else
+      logError("Attempted to set a linear projection evaluator with respect to position of link '%s', but that link "
+               "is not part of group '%s'.",
+               link_name.c_str(), getGroupName().c_str());
+  }
+  else if (peval.find_first_of("link(") == 0 && peval[peval.length() - 1] == ')')
   {
     std::string link_name = peval.substr(5, peval.length() - 6);
     if (getRobotModel()->hasLinkModel(link_name))
@@ -197,6 +228,9 @@ ompl_interface::ModelBasedPlanningContext::allocPathConstrainedSampler(const omp
 
 void ompl_interface::ModelBasedPlanningContext::configure()
 {
+  // validity depends on the scene and the path constraints of the request
+  state_validity_cache_.clear();
+
   // convert the input state to the corresponding OMPL state
   ompl::base::ScopedState<> ompl_start_state(spec_.state_space_);
   spec_.state_space_->copyToOMPLState(ompl_start_state.get(), getCompleteInitialRobotState());
@@ -222,6 +256,9 @@ void ompl_interface::ModelBasedPlanningContext::configure()
 void ompl_interface::ModelBasedPlanningContext::useConfig()
 {
   const std::map<std::string, std::string>& config = spec_.config_;
+  persistent_roadmap_ = false;
+  lazy_collision_checking_ = false;
+  use_random_seed_ = false;
   if (config.empty())
     return;
   std::map<std::string, std::string> cfg = config;
@@ -234,6 +271,99 @@ void ompl_interface::ModelBasedPlanningContext::useConfig()
     cfg.erase(it);
   }
 
+  // used when the goal is constructed, see PlanningContextManager::getPlanningContext()
+  it = cfg.find("goal_sampling_threads");
+  if (it != cfg.end())
+    cfg.erase(it);
+
+  // the planners an adaptive planner chooses from; see AdaptivePlanner
+  it = cfg.find("planners");
+  if (it != cfg.end())
+    cfg.erase(it);
+
+  // keep the roadmap of the planner between requests; see checkoutRoadmap()
+  it = cfg.find("persistent_roadmap");
+  if (it != cfg.end())
+  {
+    const std::string value = boost::trim_copy(it->second);
+    persistent_roadmap_ = value == "1" || value == "true";
+    cfg.erase(it);
+  }
+
+  // make the sampling of requests reproducible; see seedThreadRandomNumberGenerator()
+  it = cfg.find("random_seed");
+  if (it != cfg.end())
+  {
+    try
+    {
+      random_seed_ = boost::lexical_cast<boost::uint32_t>(boost::trim_copy(it->second));
+      use_random_seed_ = true;
+    }
+    catch (boost::bad_lexical_cast& e)
+    {
+      logError("%s: Invalid random_seed '%s'; it must be an unsigned integer", name_.c_str(), it->second.c_str());
+    }
+    cfg.erase(it);
+  }
+
+  // bound the distance to obstacles computed for clearance based costs; see StateValidityChecker::setMaximumClearance()
+  it = cfg.find("max_clearance");
+  if (it != cfg.end())
+  {
+    try
+    {
+      const double max_clearance = boost::lexical_cast<double>(boost::trim_copy(it->second));
+      if (max_clearance <= 0.0)
+        throw boost::bad_lexical_cast();
+      static_cast<StateValidityChecker*>(ompl_simple_setup_->getStateValidityChecker().get())
+          ->setMaximumClearance(max_clearance);
+    }
+    catch (boost::bad_lexical_cast& e)
+    {
+      logError("%s: Invalid max_clearance '%s'; it must be a positive distance", name_.c_str(), it->second.c_str());
+    }
+    cfg.erase(it);
+  }
+
+  // check motions with continuous collision checking instead of discretizing them
+  it = cfg.find("continuous_collision_checking");
+  if (it != cfg.end())
+  {
+    const std::string value = boost::trim_copy(it->second);
+    if (value == "1" || value == "true")
+      ompl_simple_setup_->getSpaceInformation()->setMotionValidator(
+          ob::MotionValidatorPtr(new ContinuousMotionValidator(this)));
+    cfg.erase(it);
+  }
+
+  // check motions only on candidate solution paths; the motion validator set so far checks them there
+  it = cfg.find("lazy_collision_checking");
+  if (it != cfg.end())
+  {
+    const std::string value = boost::trim_copy(it->second);
+    lazy_collision_checking_ = value == "1" || value == "true";
+    cfg.erase(it);
+  }
+  const ob::SpaceInformationPtr& si = ompl_simple_setup_->getSpaceInformation();
+  if (lazy_collision_checking_)
+  {
+    ob::MotionValidatorPtr eager = si->getMotionValidator();
+    if (lazy_motion_validator_ && eager.get() == lazy_motion_validator_.get())
+      eager = lazy_motion_validator_->getEagerMotionValidator();
+    // the default motion validator of the space information is allocated when it is set up
+    if (!eager)
+    {
+      si->setup();
+      eager = si->getMotionValidator();
+    }
+    if (!lazy_motion_validator_ || lazy_motion_validator_->getEagerMotionValidator() != eager)
+      lazy_motion_validator_.reset(new LazyMotionValidator(this, eager));
+    lazy_motion_validator_->setSceneVersion(RoadmapSceneVersion(*getPlanningScene()));
+    si->setMotionValidator(lazy_motion_validator_);
+  }
+  else if (lazy_motion_validator_ && si->getMotionValidator().get() == lazy_motion_validator_.get())
+    si->setMotionValidator(lazy_motion_validator_->getEagerMotionValidator());
+
   if (cfg.empty())
     return;
 
@@ -318,10 +448,89 @@ void ompl_interface::ModelBasedPlanningContext::setPlanningVolume(const moveit_m
                                         wparams.max_corner.y, wparams.min_corner.z, wparams.max_corner.z);
 }
 
+namespace ompl_interface
+{
+namespace
+{
+// solution paths are split for simplification only in segments of at least this many edges
+static const std::size_t MIN_SIMPLIFICATION_SEGMENT_EDGES = 8;
+
+/* The segments of a solution path simplified concurrently by ModelBasedPlanningContext::simplifySolution() */
+struct SimplificationSegments
+{
+  SimplificationSegments(const ob::PlannerTerminationCondition& ptc, std::size_t count)
+    : ptc_(ptc), remaining_(count)
+  {
+  }
+
+  ob::PlannerTerminationCondition ptc_;
+  std::vector<og::PathGeometric> paths_;
+  std::size_t remaining_;
+  boost::mutex lock_;
+  boost::condition_variable done_condition_;
+};
+
+void simplifySegment(const ModelBasedPlanningContext* context, SimplificationSegments* segments, std::size_t index)
+{
+  context->seedThreadRandomNumberGenerator(ModelBasedPlanningContext::SEED_STREAM_SIMPLIFICATION + index);
+
+  // the ends of a segment are not changed, so the simplified segments still join up
+  og::PathSimplifier simplifier(segments->paths_[index].getSpaceInformation());
+  if (!segments->ptc_())
+    simplifier.simplify(segments->paths_[index], segments->ptc_);
+
+  boost::mutex::scoped_lock slock(segments->lock_);
+  if (--segments->remaining_ == 0)
+    segments->done_condition_.notify_all();
+}
+}
+}
+
 void ompl_interface::ModelBasedPlanningContext::simplifySolution(double timeout)
 {
-  ompl_simple_setup_->simplifySolution(timeout);
-  last_simplify_time_ = ompl_simple_setup_->getLastSimplificationTime();
+  ompl::time::point start = ompl::time::now();
+  og::PathGeometric& path = ompl_simple_setup_->getSolutionPath();
+
+  // long paths are first split in segments that are simplified concurrently, for at most half of the time
+  const std::size_t edge_count = path.getStateCount() > 0 ? path.getStateCount() - 1 : 0;
+  const std::size_t segment_count =
+      std::min<std::size_t>(max_planning_threads_, edge_count / MIN_SIMPLIFICATION_SEGMENT_EDGES);
+  if (segment_count > 1)
+  {
+    ob::PlannerTerminationCondition ptc = ob::timedPlannerTerminationCondition(timeout / 2.0);
+    registerTerminationCondition(ptc);
+    SimplificationSegments segments(ptc, segment_count);
+    segments.paths_.resize(segment_count, og::PathGeometric(ompl_simple_setup_->getSpaceInformation()));
+    for (std::size_t i = 0; i < segment_count; ++i)
+      for (std::size_t j = i * edge_count / segment_count; j <= (i + 1) * edge_count / segment_count; ++j)
+        segments.paths_[i].append(path.getState(j));
+
+    spec_.planning_thread_pool_->reserve(segment_count);
+    for (std::size_t i = 0; i < segment_count; ++i)
+      spec_.planning_thread_pool_->addJob(boost::bind(&simplifySegment, this, &segments, i));
+    {
+      boost::mutex::scoped_lock slock(segments.lock_);
+      while (segments.remaining_ > 0)
+        segments.done_condition_.wait(slock);
+    }
+    unregisterTerminationCondition();
+
+    og::PathGeometric joined(segments.paths_[0]);
+    for (std::size_t i = 1; i < segment_count; ++i)
+      for (std::size_t j = 1; j < segments.paths_[i].getStateCount(); ++j)
+        joined.append(segments.paths_[i].getState(j));
+    logDebug("%s: Simplified %lu path segments concurrently, from %lu to %lu states", name_.c_str(), segment_count,
+             path.getStateCount(), joined.getStateCount());
+    path = joined;
+  }
+
+  // shortcuts across the whole path, in the time that remains
+  ob::PlannerTerminationCondition ptc =
+      ob::timedPlannerTerminationCondition(timeout - ompl::time::seconds(ompl::time::now() - start));
+  registerTerminationCondition(ptc);
+  ompl_simple_setup_->simplifySolution(ptc);
+  unregisterTerminationCondition();
+  last_simplify_time_ = ompl::time::seconds(ompl::time::now() - start);
 }
 
 void ompl_interface::ModelBasedPlanningContext::interpolateSolution()
@@ -395,6 +604,7 @@ void ompl_interface::ModelBasedPlanningContext::setCompleteInitialState(
 
 void ompl_interface::ModelBasedPlanningContext::clear()
 {
+  intermediate_solution_callback_ = planning_interface::IntermediateSolutionCallback();
   ompl_simple_setup_->clear();
   ompl_simple_setup_->clearStartStates();
   ompl_simple_setup_->setGoal(ob::GoalPtr());
@@ -496,12 +706,71 @@ void ompl_interface::ModelBasedPlanningContext::preSolve()
   ompl_simple_setup_->getSpaceInformation()->getMotionValidator()->resetMotionCounter();
 }
 
+void ompl_interface::ModelBasedPlanningContext::checkoutRoadmap()
+{
+  if (!persistent_roadmap_ || !spec_.roadmap_library_ || !ompl_simple_setup_->getPlannerAllocator() ||
+      !getPlanningScene())
+    return;
+  roadmap_version_ = RoadmapSceneVersion(*getPlanningScene());
+  roadmap_planner_ =
+      spec_.roadmap_library_->checkoutRoadmap(getRoadmapKey(), ompl_simple_setup_->getSpaceInformation(),
+                                              ompl_simple_setup_->getPlannerAllocator(), roadmap_version_);
+  if (!roadmap_planner_)
+    return;
+  // only the query of the previous request is discarded; the roadmap is kept
+  static_cast<og::LazyPRM*>(roadmap_planner_.get())->clearQuery();
+  ompl_simple_setup_->setPlanner(roadmap_planner_);
+}
+
+void ompl_interface::ModelBasedPlanningContext::checkinRoadmap()
+{
+  if (!roadmap_planner_)
+    return;
+  // the solution path is kept by the problem definition; the roadmap can be used by other requests from now on
+  ompl_simple_setup_->setPlanner(ob::PlannerPtr());
+  spec_.roadmap_library_->checkinRoadmap(getRoadmapKey(), roadmap_planner_, roadmap_version_);
+  roadmap_planner_.reset();
+}
+
+std::string ompl_interface::ModelBasedPlanningContext::getProblemBucket() const
+{
+  std::stringstream bucket;
+  std::size_t objects = 0;
+  bool octomap = false;
+  if (getPlanningScene())
+  {
+    const collision_detection::WorldConstPtr& world = getPlanningScene()->getWorld();
+    octomap = world->hasObject(planning_scene::PlanningScene::OCTOMAP_NS);
+    objects = world->size() - (octomap ? 1 : 0);
+  }
+  unsigned int clutter = 0;
+  while (objects >> clutter)
+    ++clutter;
+  bucket << "objects" << clutter;
+  if (octomap)
+    bucket << "_octomap";
+  if (path_constraints_ && !path_constraints_->empty())
+    bucket << "_path_constraints";
+  return bucket.str();
+}
+
+void ompl_interface::ModelBasedPlanningContext::setProblemBucket(const ob::PlannerPtr& planner) const
+{
+  AdaptivePlanner* adaptive = dynamic_cast<AdaptivePlanner*>(planner.get());
+  if (adaptive)
+    adaptive->setProblemBucket(getProblemBucket());
+}
+
 void ompl_interface::ModelBasedPlanningContext::postSolve()
 {
   stopSampling();
   int v = ompl_simple_setup_->getSpaceInformation()->getMotionValidator()->getValidMotionCount();
   int iv = ompl_simple_setup_->getSpaceInformation()->getMotionValidator()->getInvalidMotionCount();
   logDebug("There were %d valid motions and %d invalid motions.", v, iv);
+  if (use_state_validity_cache_)
+    logDebug("The state validity cache had %lu hits and %lu misses using %lu entries",
+             state_validity_cache_.getHitCount(), state_validity_cache_.getMissCount(),
+             state_validity_cache_.getSize());
 
   if (ompl_simple_setup_->getProblemDefinition()->hasApproximateSolution())
     logWarn("Computed solution is approximate");
@@ -509,15 +778,30 @@ void ompl_interface::ModelBasedPlanningContext::postSolve()
 
 bool ompl_interface::ModelBasedPlanningContext::solve(planning_interface::MotionPlanResponse& res)
 {
+  MOVEIT_TRACE_SCOPE("ModelBasedPlanningContext::solve");
   if (solve(request_.allowed_planning_time, request_.num_planning_attempts))
   {
     double ptime = getLastPlanTime();
+    res.statistics_["solve_time"] = ptime;
     if (simplify_solutions_ && ptime < request_.allowed_planning_time)
     {
+      MOVEIT_TRACE_SCOPE("ModelBasedPlanningContext::simplifySolution");
       simplifySolution(request_.allowed_planning_time - ptime);
       ptime += getLastSimplifyTime();
+      res.statistics_["simplify_time"] = getLastSimplifyTime();
+    }
+
+    ompl::time::point start_interpolate = ompl::time::now();
+    {
+      MOVEIT_TRACE_SCOPE("ModelBasedPlanningContext::interpolateSolution");
+      interpolateSolution();
+    }
+    res.statistics_["interpolate_time"] = ompl::time::seconds(ompl::time::now() - start_interpolate);
+    if (use_state_validity_cache_)
+    {
+      res.statistics_["state_validity_cache_hits"] = state_validity_cache_.getHitCount();
+      res.statistics_["state_validity_cache_misses"] = state_validity_cache_.getMissCount();
     }
-    interpolateSolution();
 
     // fill the response
     logDebug("%s: Returning successful solution with %lu states", getName().c_str(),
@@ -569,6 +853,13 @@ bool ompl_interface::ModelBasedPlanningContext::solve(planning_interface::Motion
     res.trajectory_.back().reset(new robot_trajectory::RobotTrajectory(getRobotModel(), getGroupName()));
     getSolutionPath(*res.trajectory_.back());
 
+    if (use_state_validity_cache_)
+    {
+      res.statistics_["state_validity_cache_hits"] = state_validity_cache_.getHitCount();
+      res.statistics_["state_validity_cache_misses"] = state_validity_cache_.getMissCount();
+      res.statistics_["state_validity_cache_size"] = state_validity_cache_.getSize();
+    }
+
     // fill the response
     logDebug("%s: Returning successful solution with %lu states", getName().c_str(),
              getOMPLSimpleSetup()->getSolutionPath().getStateCount());
@@ -586,80 +877,235 @@ bool ompl_interface::ModelBasedPlanningContext::solve(double timeout, unsigned i
 {
   moveit::tools::Profiler::ScopedBlock sblock("PlanningContext:Solve");
   ompl::time::point start = ompl::time::now();
+  seedThreadRandomNumberGenerator(SEED_STREAM_PLANNING);
   preSolve();
 
   bool result = false;
   if (count <= 1)
   {
     logDebug("%s: Solving the planning problem once...", name_.c_str());
+    checkoutRoadmap();
     ob::PlannerTerminationCondition ptc =
         ob::timedPlannerTerminationCondition(timeout - ompl::time::seconds(ompl::time::now() - start));
     registerTerminationCondition(ptc);
-    result = ompl_simple_setup_->solve(ptc) == ompl::base::PlannerStatus::EXACT_SOLUTION;
-    last_plan_time_ = ompl_simple_setup_->getLastPlanComputationTime();
+    const ob::PlannerPtr& planner = ompl_simple_setup_->getPlanner();
+    setProblemBucket(planner);
+    if (useLazyCollisionChecking() && !dynamic_cast<og::LazyRRT*>(planner.get()) &&
+        !dynamic_cast<og::LazyPRM*>(planner.get()))
+    {
+      result = solveLazily(ptc);
+      last_plan_time_ = ompl::time::seconds(ompl::time::now() - start);
+    }
+    else if (intermediate_solution_callback_)
+    {
+      result = solveAnytime(ptc);
+      last_plan_time_ = ompl::time::seconds(ompl::time::now() - start);
+    }
+    else
+    {
+      result = ompl_simple_setup_->solve(ptc) == ompl::base::PlannerStatus::EXACT_SOLUTION;
+      last_plan_time_ = ompl_simple_setup_->getLastPlanComputationTime();
+    }
     unregisterTerminationCondition();
+    checkinRoadmap();
   }
   else
   {
     logDebug("%s: Solving the planning problem %u times...", name_.c_str(), count);
-    ompl_parallel_plan_.clearHybridizationPaths();
-    if (count <= max_planning_threads_)
-    {
-      ompl_parallel_plan_.clearPlanners();
-      if (ompl_simple_setup_->getPlannerAllocator())
-        for (unsigned int i = 0; i < count; ++i)
-          ompl_parallel_plan_.addPlannerAllocator(ompl_simple_setup_->getPlannerAllocator());
-      else
-        for (unsigned int i = 0; i < count; ++i)
-          ompl_parallel_plan_.addPlanner(ompl::tools::SelfConfig::getDefaultPlanner(ompl_simple_setup_->getGoal()));
+    ob::PlannerTerminationCondition ptc =
+        ob::timedPlannerTerminationCondition(timeout - ompl::time::seconds(ompl::time::now() - start));
+    registerTerminationCondition(ptc);
+    result = solveAttempts(ptc, count);
+    last_plan_time_ = ompl::time::seconds(ompl::time::now() - start);
+    unregisterTerminationCondition();
+  }
 
-      ob::PlannerTerminationCondition ptc =
-          ob::timedPlannerTerminationCondition(timeout - ompl::time::seconds(ompl::time::now() - start));
-      registerTerminationCondition(ptc);
-      result = ompl_parallel_plan_.solve(ptc, 1, count, true) == ompl::base::PlannerStatus::EXACT_SOLUTION;
-      last_plan_time_ = ompl::time::seconds(ompl::time::now() - start);
-      unregisterTerminationCondition();
+  postSolve();
+
+  return result;
+}
+
+bool ompl_interface::ModelBasedPlanningContext::solveLazily(const ob::PlannerTerminationCondition& ptc)
+{
+  bool result = false;
+  lazy_motion_validator_->setLazy(true);
+  while (ompl_simple_setup_->solve(ptc) == ompl::base::PlannerStatus::EXACT_SOLUTION)
+  {
+    if (lazy_motion_validator_->checkPath(ompl_simple_setup_->getSolutionPath()))
+    {
+      result = true;
+      break;
     }
-    else
+    if (ptc())
+      break;
+    // the planner may have built on the invalid edge, so it starts over; that edge is now rejected right away
+    logDebug("%s: Candidate solution is invalid; solving again", name_.c_str());
+    ompl_simple_setup_->getProblemDefinition()->clearSolutionPaths();
+    ompl_simple_setup_->getPlanner()->clear();
+  }
+  // shortcuts tried when simplifying the solution are checked eagerly
+  lazy_motion_validator_->setLazy(false);
+  if (!result)
+    ompl_simple_setup_->getProblemDefinition()->clearSolutionPaths();
+  return result;
+}
+
+namespace ompl_interface
+{
+namespace
+{
+// the time between reports of intermediate solutions, in seconds
+static const double INTERMEDIATE_SOLUTION_PERIOD = 0.1;
+}
+}
+
+bool ompl_interface::ModelBasedPlanningContext::solveAnytime(const ob::PlannerTerminationCondition& ptc)
+{
+  const ob::ProblemDefinitionPtr& pdef = ompl_simple_setup_->getProblemDefinition();
+  bool result = false;
+  bool reported = false;
+  double best_cost = 0.0;
+  while (!ptc())
+  {
+    ompl::time::point slice_start = ompl::time::now();
+    ob::PlannerStatus status = ompl_simple_setup_->solve(ob::plannerOrTerminationCondition(
+        ptc, ob::timedPlannerTerminationCondition(INTERMEDIATE_SOLUTION_PERIOD)));
+    bool slice_used = ompl::time::seconds(ompl::time::now() - slice_start) >= INTERMEDIATE_SOLUTION_PERIOD;
+
+    if (status == ob::PlannerStatus::EXACT_SOLUTION)
     {
-      ob::PlannerTerminationCondition ptc =
-          ob::timedPlannerTerminationCondition(timeout - ompl::time::seconds(ompl::time::now() - start));
-      registerTerminationCondition(ptc);
-      int n = count / max_planning_threads_;
       result = true;
-      for (int i = 0; i < n && ptc() == false; ++i)
-      {
-        ompl_parallel_plan_.clearPlanners();
-        if (ompl_simple_setup_->getPlannerAllocator())
-          for (unsigned int i = 0; i < max_planning_threads_; ++i)
-            ompl_parallel_plan_.addPlannerAllocator(ompl_simple_setup_->getPlannerAllocator());
-        else
-          for (unsigned int i = 0; i < max_planning_threads_; ++i)
-            ompl_parallel_plan_.addPlanner(ompl::tools::SelfConfig::getDefaultPlanner(ompl_simple_setup_->getGoal()));
-        bool r = ompl_parallel_plan_.solve(ptc, 1, count, true) == ompl::base::PlannerStatus::EXACT_SOLUTION;
-        result = result && r;
-      }
-      n = count % max_planning_threads_;
-      if (n && ptc() == false)
+      // solutions that are not better for the optimization objective (path length if there is none) are not reported
+      const ob::OptimizationObjectivePtr& objective = pdef->getOptimizationObjective();
+      const og::PathGeometric& path = ompl_simple_setup_->getSolutionPath();
+      double cost = objective ? path.cost(objective).value() : path.length();
+      if (!reported ||
+          (objective ? objective->isCostBetterThan(ob::Cost(cost), ob::Cost(best_cost)) : cost < best_cost))
       {
-        ompl_parallel_plan_.clearPlanners();
-        if (ompl_simple_setup_->getPlannerAllocator())
-          for (int i = 0; i < n; ++i)
-            ompl_parallel_plan_.addPlannerAllocator(ompl_simple_setup_->getPlannerAllocator());
-        else
-          for (int i = 0; i < n; ++i)
-            ompl_parallel_plan_.addPlanner(ompl::tools::SelfConfig::getDefaultPlanner(ompl_simple_setup_->getGoal()));
-        bool r = ompl_parallel_plan_.solve(ptc, 1, count, true) == ompl::base::PlannerStatus::EXACT_SOLUTION;
-        result = result && r;
+        reportIntermediateSolution();
+        reported = true;
+        best_cost = cost;
       }
-      last_plan_time_ = ompl::time::seconds(ompl::time::now() - start);
-      unregisterTerminationCondition();
+      if (!slice_used || pdef->hasOptimizedSolution())
+        break;
     }
+    else if (status != ob::PlannerStatus::TIMEOUT && status != ob::PlannerStatus::APPROXIMATE_SOLUTION)
+      break;
   }
+  return result;
+}
 
-  postSolve();
+void ompl_interface::ModelBasedPlanningContext::reportIntermediateSolution() const
+{
+  og::PathGeometric path(ompl_simple_setup_->getSolutionPath());
+  path.interpolate(
+      std::max((unsigned int)floor(0.5 + path.length() / max_solution_segment_length_), minimum_waypoint_count_));
+  robot_trajectory::RobotTrajectoryPtr trajectory(
+      new robot_trajectory::RobotTrajectory(getRobotModel(), getGroupName()));
+  convertPath(path, *trajectory);
+  logDebug("%s: Reporting an intermediate solution with %lu states", name_.c_str(), path.getStateCount());
+  intermediate_solution_callback_(trajectory);
+}
 
-  return result;
+namespace ompl_interface
+{
+namespace
+{
+/* The attempts of one call to ModelBasedPlanningContext::solveAttempts() */
+struct PlanningAttempts
+{
+  PlanningAttempts(const ob::ProblemDefinitionPtr& pdef, const ob::PlannerTerminationCondition& ptc,
+                   unsigned int count)
+    : pdef_(pdef)
+    , ptc_(ptc)
+    , hybridization_(pdef->getSpaceInformation())
+    , remaining_(count)
+    , max_solutions_(count)
+    , solutions_(0)
+  {
+  }
+
+  ob::ProblemDefinitionPtr pdef_;
+  ob::PlannerTerminationCondition ptc_;
+  og::PathHybridization hybridization_;
+  unsigned int remaining_;
+  unsigned int max_solutions_;
+  unsigned int solutions_;
+  boost::mutex lock_;
+  boost::condition_variable done_condition_;
+};
+
+void runPlanningAttempt(const ModelBasedPlanningContext* context, PlanningAttempts* attempts,
+                        const ob::PlannerPtr& planner, unsigned int index)
+{
+  context->seedThreadRandomNumberGenerator(ModelBasedPlanningContext::SEED_STREAM_PLANNING + 1 + index);
+
+  // attempts that start after the others have terminated the request are skipped
+  bool solved = !attempts->ptc_() && planner->solve(attempts->ptc_) == ob::PlannerStatus::EXACT_SOLUTION;
+
+  boost::mutex::scoped_lock slock(attempts->lock_);
+  if (solved)
+  {
+    // the problem definition keeps the solutions of all attempts, best first
+    attempts->hybridization_.recordPath(attempts->pdef_->getSolutionPath(), false);
+    if (++attempts->solutions_ >= attempts->max_solutions_ || attempts->pdef_->hasOptimizedSolution())
+      attempts->ptc_.terminate();
+  }
+  if (--attempts->remaining_ == 0)
+    attempts->done_condition_.notify_all();
+}
+}
+}
+
+bool ompl_interface::ModelBasedPlanningContext::solveAttempts(const ob::PlannerTerminationCondition& ptc,
+                                                              unsigned int count)
+{
+  const ob::ProblemDefinitionPtr& pdef = ompl_simple_setup_->getProblemDefinition();
+  std::vector<ob::PlannerPtr> planners(count);
+  for (unsigned int i = 0; i < count; ++i)
+  {
+    if (ompl_simple_setup_->getPlannerAllocator())
+      planners[i] = ompl_simple_setup_->getPlannerAllocator()(ompl_simple_setup_->getSpaceInformation());
+    else
+      planners[i] = ompl::tools::SelfConfig::getDefaultPlanner(ompl_simple_setup_->getGoal());
+    planners[i]->setProblemDefinition(pdef);
+    if (!planners[i]->isSetup())
+      planners[i]->setup();
+    setProblemBucket(planners[i]);
+  }
+
+  PlanningAttempts attempts(pdef, ptc, count);
+  spec_.planning_thread_pool_->reserve(max_planning_threads_);
+  for (unsigned int i = 0; i < count; ++i)
+    spec_.planning_thread_pool_->addJob(boost::bind(&runPlanningAttempt, this, &attempts, planners[i], i));
+
+  {
+    boost::mutex::scoped_lock slock(attempts.lock_);
+    while (attempts.remaining_ > 0)
+      attempts.done_condition_.wait(slock);
+  }
+
+  if (attempts.hybridization_.pathCount() > 1)
+  {
+    attempts.hybridization_.computeHybridPath();
+    const ob::PathPtr& hybrid = attempts.hybridization_.getHybridPath();
+    if (hybrid)
+    {
+      const og::PathGeometric& path = static_cast<const og::PathGeometric&>(*hybrid);
+      double difference = 0.0;
+      bool approximate = !pdef->getGoal()->isSatisfied(path.getStates().back(), &difference);
+      pdef->addSolutionPath(hybrid, approximate, difference, attempts.hybridization_.getName());
+    }
+  }
+
+  return pdef->hasExactSolution();
+}
+
+void ompl_interface::ModelBasedPlanningContext::seedThreadRandomNumberGenerator(unsigned int stream) const
+{
+  // every stream gets a different seed
+  if (use_random_seed_)
+    moveit::core::seedThreadRandomNumberGenerator(random_seed_ ^ (stream * 0x9e3779b9u));
 }
 
 void ompl_interface::ModelBasedPlanningContext::registerTerminationCondition(const ob::PlannerTerminationCondition& ptc)
@@ -48,11 +48,14 @@ ompl_interface::OMPLInterface::OMPLInterface(const robot_model::RobotModelConstP
   , context_manager_(kmodel, constraint_sampler_manager_)
   , constraints_library_(new ConstraintsLibrary(context_manager_))
   , use_constraints_approximations_(true)
+  , roadmap_library_(new RoadmapLibrary())
   , simplify_solutions_(true)
 {
   ROS_INFO("Initializing OMPL interface using ROS parameters");
   loadPlannerConfigurations();
   loadConstraintApproximations();
+  loadRoadmaps();
+  loadPlannerStatistics();
   loadConstraintSamplers();
 }
 
@@ -65,16 +68,21 @@ ompl_interface::OMPLInterface::OMPLInterface(const robot_model::RobotModelConstP
   , context_manager_(kmodel, constraint_sampler_manager_)
   , constraints_library_(new ConstraintsLibrary(context_manager_))
   , use_constraints_approximations_(true)
+  , roadmap_library_(new RoadmapLibrary())
   , simplify_solutions_(true)
 {
   ROS_INFO("Initializing OMPL interface using specified configuration");
   setPlannerConfigurations(pconfig);
   loadConstraintApproximations();
+  loadRoadmaps();
+  loadPlannerStatistics();
   loadConstraintSamplers();
 }
 
 ompl_interface::OMPLInterface::~OMPLInterface()
 {
+  roadmap_library_->saveRoadmaps();
+  context_manager_.getPlannerStatistics()->saveStatistics();
 }
 
 void ompl_interface::OMPLInterface::setPlannerConfigurations(const planning_interface::PlannerConfigurationMap& pconfig)
@@ -128,6 +136,7 @@ void ompl_interface::OMPLInterface::configureContext(const ModelBasedPlanningCon
     context->setConstraintsApproximations(constraints_library_);
   else
     context->setConstraintsApproximations(ConstraintsLibraryPtr());
+  context->setRoadmapLibrary(roadmap_library_);
   context->simplifySolutions(simplify_solutions_);
 }
 
@@ -167,6 +176,51 @@ bool ompl_interface::OMPLInterface::loadConstraintApproximations()
   return false;
 }
 
+bool ompl_interface::OMPLInterface::loadRoadmaps()
+{
+  std::string cpath;
+  if (nh_.getParam("constraint_approximations_path", cpath))
+  {
+    roadmap_library_->setRoadmapsPath(cpath);
+    return true;
+  }
+  return false;
+}
+
+bool ompl_interface::OMPLInterface::saveRoadmaps()
+{
+  if (roadmap_library_->getRoadmapsPath().empty())
+  {
+    ROS_WARN("ROS param 'constraint_approximations_path' not found. Unable to save roadmaps");
+    return false;
+  }
+  roadmap_library_->saveRoadmaps();
+  return true;
+}
+
+bool ompl_interface::OMPLInterface::loadPlannerStatistics()
+{
+  std::string cpath;
+  if (nh_.getParam("constraint_approximations_path", cpath))
+  {
+    context_manager_.getPlannerStatistics()->setStatisticsPath(cpath);
+    return true;
+  }
+  return false;
+}
+
+bool ompl_interface::OMPLInterface::savePlannerStatistics()
+{
+  const PlannerStatisticsPtr& statistics = context_manager_.getPlannerStatistics();
+  if (statistics->getStatisticsPath().empty())
+  {
+    ROS_WARN("ROS param 'constraint_approximations_path' not found. Unable to save planner statistics");
+    return false;
+  }
+  statistics->saveStatistics();
+  return true;
+}
+
 void ompl_interface::OMPLInterface::loadConstraintSamplers()
 {
   constraint_sampler_manager_loader_.reset(
@@ -219,12 +273,17 @@ void ompl_interface::OMPLInterface::loadPlannerConfigurations()
   const std::vector<std::string>& group_names = kmodel_->getJointModelGroupNames();
   planning_interface::PlannerConfigurationMap pconfig;
 
+  // the default configurations of the groups that have planner configurations on the param server
+  std::vector<std::string> configured_groups;
+
   // read the planning configuration for each group
   pconfig.clear();
   for (std::size_t i = 0; i < group_names.size(); ++i)
   {
     // the set of planning parameters that can be specific for the group (inherited by configurations of that group)
-    static const std::string KNOWN_GROUP_PARAMS[] = { "projection_evaluator", "longest_valid_segment_fraction" };
+    static const std::string KNOWN_GROUP_PARAMS[] = { "projection_evaluator", "longest_valid_segment_fraction",
+                                                      "continuous_collision_checking", "goal_sampling_threads",
+                                                      "persistent_roadmap", "lazy_collision_checking", "random_seed" };
 
     // get parameters specific for the robot planning group
     std::map<std::string, std::string> specific_group_params;
@@ -279,6 +338,8 @@ void ompl_interface::OMPLInterface::loadPlannerConfigurations()
     }
     default_pc.name = group_names[i];  // this is the name of the default config
     pconfig[default_pc.name] = default_pc;
+    if (!default_planner_id.empty() || nh_.hasParam(group_names[i] + "/planner_configs"))
+      configured_groups.push_back(default_pc.name);
 
     // get parameters specific to each planner type
     XmlRpc::XmlRpcValue config_names;
@@ -316,6 +377,15 @@ void ompl_interface::OMPLInterface::loadPlannerConfigurations()
       ROS_DEBUG_STREAM_NAMED("parameters", " - " << config_it->first << " = " << config_it->second);
   }
   setPlannerConfigurations(pconfig);
+
+  int max_cached_contexts;
+  if (nh_.getParam("max_cached_planning_contexts", max_cached_contexts) && max_cached_contexts >= 0)
+    context_manager_.setMaximumCachedContexts(max_cached_contexts);
+
+  bool prewarm_contexts;
+  nh_.param("prewarm_planning_contexts", prewarm_contexts, true);
+  if (prewarm_contexts)
+    context_manager_.prewarmPlanningContexts(configured_groups);
 }
 
 void ompl_interface::OMPLInterface::printStatus()
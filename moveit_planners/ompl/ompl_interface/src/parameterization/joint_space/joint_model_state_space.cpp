@@ -35,11 +35,122 @@
 /* Author: Ioan Sucan */
 
 #include <moveit/ompl_interface/parameterization/joint_space/joint_model_state_space.h>
+#include <boost/math/constants/constants.hpp>
+#include <cmath>
+
+namespace
+{
+const double PI = boost::math::constants::pi<double>();
+}
 
 const std::string ompl_interface::JointModelStateSpace::PARAMETERIZATION_TYPE = "JointModel";
 
 ompl_interface::JointModelStateSpace::JointModelStateSpace(const ModelBasedStateSpaceSpecification& spec)
-  : ModelBasedStateSpace(spec)
+  : ModelBasedStateSpace(spec), simple_joints_(joint_model_vector_.size() == variable_count_ && variable_count_ > 0)
 {
   setName(getName() + "_" + PARAMETERIZATION_TYPE);
+
+  distance_factors_.setZero(variable_count_);
+  for (std::size_t i = 0; simple_joints_ && i < joint_model_vector_.size(); ++i)
+  {
+    const robot_model::JointModel* jm = joint_model_vector_[i];
+    if (jm->getVariableCount() != 1 || (jm->getType() != robot_model::JointModel::REVOLUTE &&
+                                        jm->getType() != robot_model::JointModel::PRISMATIC))
+    {
+      simple_joints_ = false;
+      break;
+    }
+    int index = spec_.joint_model_group_->getVariableGroupIndex(jm->getName());
+    if (jm->getType() == robot_model::JointModel::REVOLUTE &&
+        static_cast<const robot_model::RevoluteJointModel*>(jm)->isContinuous())
+    {
+      continuous_variables_.push_back(index);
+      continuous_distance_factors_.push_back(jm->getDistanceFactor());
+    }
+    else
+      distance_factors_[index] = jm->getDistanceFactor();
+  }
+}
+
+double ompl_interface::JointModelStateSpace::distanceValues(const double* values1, const double* values2) const
+{
+  Eigen::Map<const Eigen::ArrayXd> v1(values1, variable_count_);
+  Eigen::Map<const Eigen::ArrayXd> v2(values2, variable_count_);
+  double d = (distance_factors_ * (v1 - v2).abs()).sum();
+
+  // same as RevoluteJointModel::distance() for continuous joints
+  for (std::size_t i = 0; i < continuous_variables_.size(); ++i)
+  {
+    double dc = fmod(fabs(values1[continuous_variables_[i]] - values2[continuous_variables_[i]]), 2.0 * PI);
+    d += continuous_distance_factors_[i] * (dc > PI ? 2.0 * PI - dc : dc);
+  }
+  return d;
+}
+
+double ompl_interface::JointModelStateSpace::distance(const ompl::base::State* state1,
+                                                      const ompl::base::State* state2) const
+{
+  if (!simple_joints_ || distance_function_)
+    return ModelBasedStateSpace::distance(state1, state2);
+  return distanceValues(state1->as<StateType>()->values, state2->as<StateType>()->values);
+}
+
+void ompl_interface::JointModelStateSpace::distanceValuesMany(const double* query, const double* values,
+                                                              std::size_t count, double* distances) const
+{
+  // one column per state, so the linear part of all the distances is a single array expression
+  Eigen::Map<const Eigen::ArrayXd> q(query, variable_count_);
+  Eigen::Map<const Eigen::ArrayXXd> v(values, variable_count_, count);
+  Eigen::Map<Eigen::ArrayXd> d(distances, count);
+  d = ((v.colwise() - q).abs().colwise() * distance_factors_).colwise().sum().transpose();
+
+  for (std::size_t i = 0; i < continuous_variables_.size(); ++i)
+  {
+    const unsigned int c = continuous_variables_[i];
+    for (std::size_t j = 0; j < count; ++j)
+    {
+      double dc = fmod(fabs(query[c] - values[j * variable_count_ + c]), 2.0 * PI);
+      distances[j] += continuous_distance_factors_[i] * (dc > PI ? 2.0 * PI - dc : dc);
+    }
+  }
+}
+
+void ompl_interface::JointModelStateSpace::interpolate(const ompl::base::State* from, const ompl::base::State* to,
+                                                       const double t, ompl::base::State* state) const
+{
+  if (!simple_joints_)
+  {
+    ModelBasedStateSpace::interpolate(from, to, t, state);
+    return;
+  }
+
+  // clear any cached info (such as validity known or not)
+  state->as<StateType>()->clearKnownInformation();
+  if (interpolation_function_ && interpolation_function_(from, to, t, state))
+    return;
+
+  const double* f = from->as<StateType>()->values;
+  const double* g = to->as<StateType>()->values;
+  double* s = state->as<StateType>()->values;
+  Eigen::Map<const Eigen::ArrayXd> vf(f, variable_count_);
+  Eigen::Map<const Eigen::ArrayXd> vg(g, variable_count_);
+  Eigen::Map<Eigen::ArrayXd>(s, variable_count_) = vf + (vg - vf) * t;
+
+  // same as RevoluteJointModel::interpolate() for continuous joints
+  for (std::size_t i = 0; i < continuous_variables_.size(); ++i)
+  {
+    unsigned int k = continuous_variables_[i];
+    double diff = g[k] - f[k];
+    if (fabs(diff) > PI)
+    {
+      diff = diff > 0.0 ? 2.0 * PI - diff : -2.0 * PI - diff;
+      s[k] = f[k] - diff * t;
+      if (s[k] > PI)
+        s[k] -= 2.0 * PI;
+      else if (s[k] < -PI)
+        s[k] += 2.0 * PI;
+    }
+  }
+
+  interpolateTag(from, to, t, state);
 }
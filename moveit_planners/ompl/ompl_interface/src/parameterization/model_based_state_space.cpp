@@ -35,6 +35,7 @@
 /* Author: Ioan Sucan */
 
 #include <moveit/ompl_interface/parameterization/model_based_state_space.h>
+#include <moveit/robot_state/random_number_generator.h>
 #include <boost/bind.hpp>
 
 ompl_interface::ModelBasedStateSpace::ModelBasedStateSpace(const ModelBasedStateSpaceSpecification& spec)
@@ -45,6 +46,9 @@ ompl_interface::ModelBasedStateSpace::ModelBasedStateSpace(const ModelBasedState
   variable_count_ = spec_.joint_model_group_->getVariableCount();
   state_values_size_ = variable_count_ * sizeof(double);
   joint_model_vector_ = spec_.joint_model_group_->getActiveJointModels();
+  for (std::size_t i = 0; i < joint_model_vector_.size(); ++i)
+    joint_value_index_.push_back(
+        spec_.joint_model_group_->getVariableGroupIndex(joint_model_vector_[i]->getVariableNames()[0]));
 
   // make sure we have bounds for every joint stored within the spec (use default bounds if not specified)
   if (!spec_.joint_bounds_.empty() && spec_.joint_bounds_.size() != joint_model_vector_.size())
@@ -206,12 +210,7 @@ void ompl_interface::ModelBasedStateSpace::interpolate(const ompl::base::State*
                                           state->as<StateType>()->values);
 
     // compute tag
-    if (from->as<StateType>()->tag >= 0 && t < 1.0 - tag_snap_to_segment_)
-      state->as<StateType>()->tag = from->as<StateType>()->tag;
-    else if (to->as<StateType>()->tag >= 0 && t > tag_snap_to_segment_)
-      state->as<StateType>()->tag = to->as<StateType>()->tag;
-    else
-      state->as<StateType>()->tag = -1;
+    interpolateTag(from, to, t, state);
   }
 }
 
@@ -258,13 +257,15 @@ ompl::base::StateSamplerPtr ompl_interface::ModelBasedStateSpace::allocDefaultSt
 
     virtual void sampleUniform(ompl::base::State* state)
     {
-      joint_model_group_->getVariableRandomPositions(moveit_rng_, state->as<StateType>()->values, *joint_bounds_);
+      joint_model_group_->getVariableRandomPositions(moveit::core::getThreadRandomNumberGenerator(),
+                                                     state->as<StateType>()->values, *joint_bounds_);
       state->as<StateType>()->clearKnownInformation();
     }
 
     virtual void sampleUniformNear(ompl::base::State* state, const ompl::base::State* near, const double distance)
     {
-      joint_model_group_->getVariableRandomPositionsNearBy(moveit_rng_, state->as<StateType>()->values, *joint_bounds_,
+      joint_model_group_->getVariableRandomPositionsNearBy(moveit::core::getThreadRandomNumberGenerator(),
+                                                           state->as<StateType>()->values, *joint_bounds_,
                                                            near->as<StateType>()->values, distance);
       state->as<StateType>()->clearKnownInformation();
     }
@@ -275,7 +276,6 @@ ompl::base::StateSamplerPtr ompl_interface::ModelBasedStateSpace::allocDefaultSt
     }
 
   protected:
-    random_numbers::RandomNumberGenerator moveit_rng_;
     const robot_model::JointModelGroup* joint_model_group_;
     const robot_model::JointBoundsVector* joint_bounds_;
   };
@@ -294,7 +294,7 @@ void ompl_interface::ModelBasedStateSpace::printState(const ompl::base::State* s
   for (std::size_t j = 0; j < joint_model_vector_.size(); ++j)
   {
     out << joint_model_vector_[j]->getName() << " = ";
-    const int idx = spec_.joint_model_group_->getVariableGroupIndex(joint_model_vector_[j]->getName());
+    const int idx = joint_value_index_[j];
     const int vc = joint_model_vector_[j]->getVariableCount();
     for (int i = 0; i < vc; ++i)
       out << state->as<StateType>()->values[idx + i] << " ";
@@ -318,10 +318,27 @@ void ompl_interface::ModelBasedStateSpace::printState(const ompl::base::State* s
 void ompl_interface::ModelBasedStateSpace::copyToRobotState(robot_state::RobotState& rstate,
                                                             const ompl::base::State* state) const
 {
-  rstate.setJointGroupPositions(spec_.joint_model_group_, state->as<StateType>()->values);
+  copyJointValuesToRobotState(rstate, state);
   rstate.update();
 }
 
+void ompl_interface::ModelBasedStateSpace::copyJointValuesToRobotState(robot_state::RobotState& rstate,
+                                                                       const ompl::base::State* state) const
+{
+  // only the joints whose values change are marked dirty, so rstate.update() recomputes only the links they move
+  // the mimic joints follow the active joints they mimic
+  const double* values = state->as<StateType>()->values;
+  const double* current = rstate.getVariablePositions();
+  for (std::size_t i = 0; i < joint_model_vector_.size(); ++i)
+  {
+    const robot_model::JointModel* joint_model = joint_model_vector_[i];
+    const double* joint_values = values + joint_value_index_[i];
+    if (memcmp(current + joint_model->getFirstVariableIndex(), joint_values,
+               joint_model->getVariableCount() * sizeof(double)) != 0)
+      rstate.setJointPositions(joint_model, joint_values);
+  }
+}
+
 void ompl_interface::ModelBasedStateSpace::copyToOMPLState(ompl::base::State* state,
                                                            const robot_state::RobotState& rstate) const
 {
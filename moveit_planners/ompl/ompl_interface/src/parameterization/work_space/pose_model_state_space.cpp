@@ -37,9 +37,121 @@
 #include <moveit/ompl_interface/parameterization/work_space/pose_model_state_space.h>
 #include <ompl/base/spaces/SE3StateSpace.h>
 #include <moveit/profiler/profiler.h>
+#include <boost/unordered_map.hpp>
+#include <boost/thread/mutex.hpp>
+#include <cstring>
 
 const std::string ompl_interface::PoseModelStateSpace::PARAMETERIZATION_TYPE = "PoseModel";
 
+namespace ompl_interface
+{
+namespace
+{
+// poses that agree to this resolution (in meters and quaternion components) share their IK solution
+static const double IK_CACHE_POSE_RESOLUTION = 1e-6;
+
+// poses in the same cell of this size share the seed tried when IK from the joint values of the state fails
+static const double IK_CACHE_NEARBY_POSITION_RESOLUTION = 0.05;
+static const double IK_CACHE_NEARBY_ORIENTATION_RESOLUTION = 0.25;
+
+// a cached solution is used only if no joint is further than this from the seed, so it is on the seed's IK branch
+static const double IK_CACHE_MAX_SEED_DISTANCE = 0.5;
+
+// the cache is emptied when it holds more poses than this
+static const std::size_t IK_CACHE_MAX_POSES = 1 << 16;
+
+void quantizePose(const geometry_msgs::Pose& pose, double position_resolution, double orientation_resolution,
+                  std::vector<int64_t>& key)
+{
+  // q and -q are the same orientation
+  const double sign = pose.orientation.w < 0.0 ? -1.0 : 1.0;
+  key.resize(7);
+  key[0] = (int64_t)floor(pose.position.x / position_resolution + 0.5);
+  key[1] = (int64_t)floor(pose.position.y / position_resolution + 0.5);
+  key[2] = (int64_t)floor(pose.position.z / position_resolution + 0.5);
+  key[3] = (int64_t)floor(sign * pose.orientation.x / orientation_resolution + 0.5);
+  key[4] = (int64_t)floor(sign * pose.orientation.y / orientation_resolution + 0.5);
+  key[5] = (int64_t)floor(sign * pose.orientation.z / orientation_resolution + 0.5);
+  key[6] = (int64_t)floor(sign * pose.orientation.w / orientation_resolution + 0.5);
+}
+
+/* The joint values of the last state interpolated by this thread, after IK. The steps along the same motion (e.g.
+ * those checked by a motion validator) are seeded with them when they are closer to the step than the ends of the
+ * motion, so that consecutive steps stay on the same IK branch and converge in fewer iterations */
+struct InterpolationSeed
+{
+  InterpolationSeed() : space_(NULL), t_(0.0)
+  {
+  }
+
+  const PoseModelStateSpace* space_;
+  std::vector<double> from_;
+  std::vector<double> to_;
+  std::vector<double> values_;
+  double t_;
+};
+
+thread_local InterpolationSeed interpolation_seed;
+
+bool sameValues(const std::vector<double>& stored, const double* values)
+{
+  return memcmp(&stored[0], values, stored.size() * sizeof(double)) == 0;
+}
+}
+}
+
+struct ompl_interface::PoseModelStateSpace::IKCache
+{
+  /* Get the solution of \e pose computed earlier, if it is close to \e seed */
+  bool lookup(const geometry_msgs::Pose& pose, const std::vector<double>& seed, std::vector<double>& solution)
+  {
+    std::vector<int64_t> key;
+    quantizePose(pose, IK_CACHE_POSE_RESOLUTION, IK_CACHE_POSE_RESOLUTION, key);
+    boost::mutex::scoped_lock slock(lock_);
+    boost::unordered_map<std::vector<int64_t>, std::vector<double> >::const_iterator it = solutions_.find(key);
+    if (it == solutions_.end() || it->second.size() != seed.size())
+      return false;
+    for (std::size_t i = 0; i < seed.size(); ++i)
+      if (fabs(it->second[i] - seed[i]) > IK_CACHE_MAX_SEED_DISTANCE)
+        return false;
+    solution = it->second;
+    return true;
+  }
+
+  /* Get the last solution computed for a pose near \e pose */
+  bool lookupNearby(const geometry_msgs::Pose& pose, std::vector<double>& seed)
+  {
+    std::vector<int64_t> key;
+    quantizePose(pose, IK_CACHE_NEARBY_POSITION_RESOLUTION, IK_CACHE_NEARBY_ORIENTATION_RESOLUTION, key);
+    boost::mutex::scoped_lock slock(lock_);
+    boost::unordered_map<std::vector<int64_t>, std::vector<double> >::const_iterator it =
+        nearby_solutions_.find(key);
+    if (it == nearby_solutions_.end())
+      return false;
+    seed = it->second;
+    return true;
+  }
+
+  void insert(const geometry_msgs::Pose& pose, const std::vector<double>& solution)
+  {
+    std::vector<int64_t> key, nearby_key;
+    quantizePose(pose, IK_CACHE_POSE_RESOLUTION, IK_CACHE_POSE_RESOLUTION, key);
+    quantizePose(pose, IK_CACHE_NEARBY_POSITION_RESOLUTION, IK_CACHE_NEARBY_ORIENTATION_RESOLUTION, nearby_key);
+    boost::mutex::scoped_lock slock(lock_);
+    if (solutions_.size() >= IK_CACHE_MAX_POSES)
+    {
+      solutions_.clear();
+      nearby_solutions_.clear();
+    }
+    solutions_[key] = solution;
+    nearby_solutions_[nearby_key] = solution;
+  }
+
+  boost::unordered_map<std::vector<int64_t>, std::vector<double> > solutions_;
+  boost::unordered_map<std::vector<int64_t>, std::vector<double> > nearby_solutions_;
+  boost::mutex lock_;
+};
+
 ompl_interface::PoseModelStateSpace::PoseModelStateSpace(const ModelBasedStateSpaceSpecification& spec)
   : ModelBasedStateSpace(spec)
 {
@@ -130,6 +242,15 @@ void ompl_interface::PoseModelStateSpace::interpolate(const ompl::base::State* f
   // interpolate in joint space
   ModelBasedStateSpace::interpolate(from, to, t, state);
 
+  // seed IK with the solution of the previous step along this motion, if that step is closer than the ends
+  InterpolationSeed& seed = interpolation_seed;
+  const double* from_values = from->as<StateType>()->values;
+  const double* to_values = to->as<StateType>()->values;
+  double* values = state->as<StateType>()->values;
+  if (seed.space_ == this && fabs(t - seed.t_) < std::min(t, 1.0 - t) && sameValues(seed.from_, from_values) &&
+      sameValues(seed.to_, to_values))
+    memcpy(values, &seed.values_[0], variable_count_ * sizeof(double));
+
   // interpolate SE3 components
   for (std::size_t i = 0; i < poses_.size(); ++i)
     poses_[i].state_space_->interpolate(from->as<StateType>()->poses[i], to->as<StateType>()->poses[i], t,
@@ -157,7 +278,15 @@ void ompl_interface::PoseModelStateSpace::interpolate(const ompl::base::State* f
     // if the joint value jumped too much
     if (d_from + d_to > std::max(0.2, dj))  // \todo make 0.2 a param
       state->as<StateType>()->markInvalid();
+
+    seed.space_ = this;
+    seed.from_.assign(from_values, from_values + variable_count_);
+    seed.to_.assign(to_values, to_values + variable_count_);
+    seed.values_.assign(values, values + variable_count_);
+    seed.t_ = t;
   }
+  else
+    seed.space_ = NULL;
 }
 
 void ompl_interface::PoseModelStateSpace::setPlanningVolume(double minX, double maxX, double minY, double maxY,
@@ -177,7 +306,7 @@ void ompl_interface::PoseModelStateSpace::setPlanningVolume(double minX, double
 
 ompl_interface::PoseModelStateSpace::PoseComponent::PoseComponent(
     const robot_model::JointModelGroup* subgroup, const robot_model::JointModelGroup::KinematicsSolver& k)
-  : subgroup_(subgroup), kinematics_solver_(k.allocator_(subgroup)), bijection_(k.bijection_)
+  : subgroup_(subgroup), kinematics_solver_(k.allocator_(subgroup)), bijection_(k.bijection_), ik_cache_(new IKCache())
 {
   state_space_.reset(new ompl::base::SE3StateSpace());
   state_space_->setName(subgroup_->getName() + "_Workspace");
@@ -236,15 +365,25 @@ bool ompl_interface::PoseModelStateSpace::PoseComponent::computeStateIK(StateTyp
   pose.orientation.z = so3_state.z;
   pose.orientation.w = so3_state.w;
 
-  // run IK
+  // run IK, unless it was run for this pose before with a similar seed
   std::vector<double> solution(bijection_.size());
-  moveit_msgs::MoveItErrorCodes err_code;
-  if (!kinematics_solver_->getPositionIK(pose, seed_values, solution, err_code))
+  if (!ik_cache_->lookup(pose, seed_values, solution))
   {
-    if (err_code.val != moveit_msgs::MoveItErrorCodes::TIMED_OUT ||
-        !kinematics_solver_->searchPositionIK(pose, seed_values, kinematics_solver_->getDefaultTimeout() * 2.0,
-                                              solution, err_code))
+    moveit_msgs::MoveItErrorCodes err_code;
+    bool found = kinematics_solver_->getPositionIK(pose, seed_values, solution, err_code);
+    std::vector<double> nearby_seed_values;
+    if (!found && ik_cache_->lookupNearby(pose, nearby_seed_values))
+    {
+      // a single attempt from the solution of a nearby pose is cheaper than searching
+      moveit_msgs::MoveItErrorCodes nearby_err_code;
+      found = kinematics_solver_->getPositionIK(pose, nearby_seed_values, solution, nearby_err_code);
+    }
+    if (!found &&
+        (err_code.val != moveit_msgs::MoveItErrorCodes::TIMED_OUT ||
+         !kinematics_solver_->searchPositionIK(pose, seed_values, kinematics_solver_->getDefaultTimeout() * 2.0,
+                                               solution, err_code)))
       return false;
+    ik_cache_->insert(pose, solution);
   }
 
   for (std::size_t i = 0; i < bijection_.size(); ++i)
@@ -0,0 +1,253 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/ompl_interface/planner_statistics.h>
+#include <ompl/util/Console.h>
+#include <boost/filesystem.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/lexical_cast.hpp>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <cmath>
+
+namespace ompl_interface
+{
+namespace
+{
+// solved attempts are rewarded with 1 / (1 + t / REWARD_TIME_SCALE), for a solving time t in seconds
+static const double REWARD_TIME_SCALE = 1.0;
+
+// weight of the exploration bonus of UCB1; smaller values settle sooner on the planner that did best so far
+static const double EXPLORATION_WEIGHT = 0.5;
+}
+}
+
+ompl_interface::PlannerStatistics::PlannerStatistics()
+{
+}
+
+ompl_interface::PlannerStatistics::~PlannerStatistics()
+{
+}
+
+void ompl_interface::PlannerStatistics::setStatisticsPath(const std::string& path)
+{
+  {
+    boost::mutex::scoped_lock slock(lock_);
+    path_ = path;
+  }
+  loadStatistics(path);
+}
+
+std::string ompl_interface::PlannerStatistics::getStatisticsFilename(const std::string& path) const
+{
+  return path + "/planner_statistics";
+}
+
+std::string ompl_interface::PlannerStatistics::selectPlanner(const std::string& key,
+                                                             const std::vector<std::string>& planners) const
+{
+  if (planners.empty())
+    return std::string();
+
+  boost::mutex::scoped_lock slock(lock_);
+  std::map<std::string, std::map<std::string, Record> >::const_iterator it = records_.find(key);
+  if (it == records_.end())
+    return planners.front();
+
+  std::vector<const Record*> records(planners.size(), NULL);
+  unsigned int total_attempts = 0;
+  for (std::size_t i = 0; i < planners.size(); ++i)
+  {
+    std::map<std::string, Record>::const_iterator r = it->second.find(planners[i]);
+    if (r == it->second.end() || r->second.attempts_ == 0)
+      return planners[i];
+    records[i] = &r->second;
+    total_attempts += r->second.attempts_;
+  }
+
+  std::size_t best = 0;
+  double best_value = 0.0;
+  for (std::size_t i = 0; i < planners.size(); ++i)
+  {
+    double attempts = records[i]->attempts_;
+    double value = records[i]->total_reward_ / attempts +
+                   EXPLORATION_WEIGHT * sqrt(2.0 * log((double)total_attempts) / attempts);
+    if (i == 0 || value > best_value)
+    {
+      best = i;
+      best_value = value;
+    }
+  }
+  return planners[best];
+}
+
+void ompl_interface::PlannerStatistics::addOutcome(const std::string& key, const std::string& planner, bool solved,
+                                                   double time)
+{
+  boost::mutex::scoped_lock slock(lock_);
+  Record& record = records_[key][planner];
+  record.attempts_++;
+  record.total_time_ += time;
+  if (solved)
+  {
+    record.successes_++;
+    record.total_reward_ += 1.0 / (1.0 + std::max(0.0, time) / REWARD_TIME_SCALE);
+  }
+}
+
+ompl_interface::PlannerStatistics::Record ompl_interface::PlannerStatistics::getRecord(const std::string& key,
+                                                                                       const std::string& planner) const
+{
+  boost::mutex::scoped_lock slock(lock_);
+  std::map<std::string, std::map<std::string, Record> >::const_iterator it = records_.find(key);
+  if (it != records_.end())
+  {
+    std::map<std::string, Record>::const_iterator r = it->second.find(planner);
+    if (r != it->second.end())
+      return r->second;
+  }
+  return Record();
+}
+
+void ompl_interface::PlannerStatistics::saveStatistics() const
+{
+  std::string path;
+  {
+    boost::mutex::scoped_lock slock(lock_);
+    path = path_;
+  }
+  if (!path.empty())
+    saveStatistics(path);
+}
+
+void ompl_interface::PlannerStatistics::saveStatistics(const std::string& path) const
+{
+  boost::mutex::scoped_lock slock(lock_);
+  if (records_.empty())
+    return;
+  logInform("Saving planner statistics for %u kinds of problems to '%s'", (unsigned int)records_.size(),
+            path.c_str());
+  try
+  {
+    boost::filesystem::create_directories(path);
+  }
+  catch (...)
+  {
+  }
+
+  std::ofstream fout(getStatisticsFilename(path).c_str());
+  if (!fout.good())
+  {
+    logError("Unable to save planner statistics to '%s'", getStatisticsFilename(path).c_str());
+    return;
+  }
+  fout << std::setprecision(12);
+  for (std::map<std::string, std::map<std::string, Record> >::const_iterator it = records_.begin();
+       it != records_.end(); ++it)
+    for (std::map<std::string, Record>::const_iterator r = it->second.begin(); r != it->second.end(); ++r)
+      fout << it->first << "\t" << r->first << "\t" << r->second.attempts_ << "\t" << r->second.successes_ << "\t"
+           << r->second.total_time_ << "\t" << r->second.total_reward_ << std::endl;
+}
+
+void ompl_interface::PlannerStatistics::loadStatistics(const std::string& path)
+{
+  std::string filename = getStatisticsFilename(path);
+  if (!boost::filesystem::exists(filename))
+    return;
+  std::ifstream fin(filename.c_str());
+  if (!fin.good())
+  {
+    logError("Unable to load planner statistics from '%s'", filename.c_str());
+    return;
+  }
+
+  boost::mutex::scoped_lock slock(lock_);
+  std::size_t count = 0;
+  std::string line;
+  std::vector<std::string> fields;
+  while (std::getline(fin, line))
+  {
+    if (line.empty())
+      continue;
+    boost::split(fields, line, boost::is_any_of("\t"));
+    if (fields.size() != 6)
+    {
+      logWarn("Ignoring malformed planner statistics line '%s' in '%s'", line.c_str(), filename.c_str());
+      continue;
+    }
+    try
+    {
+      Record record;
+      record.attempts_ = boost::lexical_cast<unsigned int>(fields[2]);
+      record.successes_ = boost::lexical_cast<unsigned int>(fields[3]);
+      record.total_time_ = boost::lexical_cast<double>(fields[4]);
+      record.total_reward_ = boost::lexical_cast<double>(fields[5]);
+
+      Record& current = records_[fields[0]][fields[1]];
+      current.attempts_ += record.attempts_;
+      current.successes_ += record.successes_;
+      current.total_time_ += record.total_time_;
+      current.total_reward_ += record.total_reward_;
+      ++count;
+    }
+    catch (boost::bad_lexical_cast&)
+    {
+      logWarn("Ignoring malformed planner statistics line '%s' in '%s'", line.c_str(), filename.c_str());
+    }
+  }
+  logInform("Loaded planner statistics for %u planners from '%s'", (unsigned int)count, filename.c_str());
+}
+
+void ompl_interface::PlannerStatistics::clearStatistics()
+{
+  boost::mutex::scoped_lock slock(lock_);
+  records_.clear();
+}
+
+void ompl_interface::PlannerStatistics::printStatistics(std::ostream& out) const
+{
+  boost::mutex::scoped_lock slock(lock_);
+  for (std::map<std::string, std::map<std::string, Record> >::const_iterator it = records_.begin();
+       it != records_.end(); ++it)
+  {
+    out << it->first << std::endl;
+    for (std::map<std::string, Record>::const_iterator r = it->second.begin(); r != it->second.end(); ++r)
+      out << "  " << r->first << ": " << r->second.successes_ << "/" << r->second.attempts_ << " solved, "
+          << (r->second.attempts_ > 0 ? r->second.total_time_ / r->second.attempts_ : 0.0) << "s mean time"
+          << std::endl;
+  }
+}
@@ -35,10 +35,14 @@
 /* Author: Ioan Sucan */
 
 #include <moveit/ompl_interface/planning_context_manager.h>
+#include <moveit/ompl_interface/detail/adaptive_planner.h>
 #include <moveit/robot_state/conversions.h>
 #include <moveit/profiler/profiler.h>
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/lexical_cast.hpp>
 #include <algorithm>
 #include <set>
+#include <list>
 
 #include <ompl/geometric/planners/rrt/RRT.h>
 #include <ompl/geometric/planners/rrt/pRRT.h>
@@ -69,6 +73,8 @@
 
 #include <moveit/ompl_interface/parameterization/joint_space/joint_model_state_space_factory.h>
 #include <moveit/ompl_interface/parameterization/work_space/pose_model_state_space_factory.h>
+#include <moveit/ompl_interface/parameterization/joint_space/joint_model_state_space.h>
+#include <moveit/ompl_interface/detail/nearest_neighbors_joint_kd_tree.h>
 
 namespace ompl_interface
 {
@@ -99,10 +105,109 @@ private:
   boost::mutex lock_;
 };
 
+/** \brief The planning contexts not in use, kept for later requests with the same configuration and state space
+    factory. Contexts are handed out through handles that return them to the cache once the last handle is gone;
+    when more than max_idle_contexts_ are idle, the least recently used ones are destroyed. */
 struct PlanningContextManager::CachedContexts
 {
-  std::map<std::pair<std::string, std::string>, std::vector<ModelBasedPlanningContextPtr> > contexts_;
-  boost::mutex lock_;
+  /// the name of the planner configuration and the type of the state space factory
+  typedef std::pair<std::string, std::string> Key;
+
+  /// the idle contexts, most recently used first
+  typedef std::list<std::pair<Key, ModelBasedPlanningContextPtr> > IdleContexts;
+
+  /** \brief Deleter of the handles to cached contexts; holds the context while the handles exist */
+  struct ReturnContext
+  {
+    ReturnContext(const std::weak_ptr<CachedContexts>& cache, const Key& key,
+                  const ModelBasedPlanningContextPtr& context)
+      : cache_(cache), key_(key), context_(context)
+    {
+    }
+
+    void operator()(ModelBasedPlanningContext* /* handle */)
+    {
+      CachedContextsPtr cache = cache_.lock();
+      if (cache)
+        cache->checkin(key_, context_);
+      context_.reset();
+    }
+
+    std::weak_ptr<CachedContexts> cache_;
+    Key key_;
+    ModelBasedPlanningContextPtr context_;
+  };
+
+  CachedContexts() : max_idle_contexts_(64)
+  {
+  }
+
+  /** \brief Get a handle to \e context; the context is returned to \e cache when the last copy of the handle is
+   * destroyed */
+  static ModelBasedPlanningContextPtr share(const CachedContextsPtr& cache, const Key& key,
+                                            const ModelBasedPlanningContextPtr& context)
+  {
+    return ModelBasedPlanningContextPtr(context.get(), ReturnContext(cache, key, context));
+  }
+
+  /** \brief Take the most recently used idle context for \e key; returns an empty pointer if there is none */
+  ModelBasedPlanningContextPtr checkout(const Key& key)
+  {
+    boost::mutex::scoped_lock slock(lock_);
+    std::map<Key, std::list<IdleContexts::iterator> >::iterator it = idle_by_key_.find(key);
+    if (it == idle_by_key_.end())
+      return ModelBasedPlanningContextPtr();
+    ModelBasedPlanningContextPtr context = it->second.front()->second;
+    idle_.erase(it->second.front());
+    it->second.pop_front();
+    if (it->second.empty())
+      idle_by_key_.erase(it);
+    return context;
+  }
+
+  void checkin(const Key& key, const ModelBasedPlanningContextPtr& context)
+  {
+    // evicted contexts are destroyed after the lock is released
+    std::vector<ModelBasedPlanningContextPtr> evicted;
+    boost::mutex::scoped_lock slock(lock_);
+    idle_.push_front(std::make_pair(key, context));
+    idle_by_key_[key].push_front(idle_.begin());
+    trim(evicted);
+  }
+
+  void setMaximumIdleContexts(std::size_t max_idle_contexts)
+  {
+    std::vector<ModelBasedPlanningContextPtr> evicted;
+    boost::mutex::scoped_lock slock(lock_);
+    max_idle_contexts_ = max_idle_contexts;
+    trim(evicted);
+  }
+
+  std::size_t getMaximumIdleContexts() const
+  {
+    boost::mutex::scoped_lock slock(lock_);
+    return max_idle_contexts_;
+  }
+
+private:
+  void trim(std::vector<ModelBasedPlanningContextPtr>& evicted)
+  {
+    while (idle_.size() > max_idle_contexts_)
+    {
+      // the least recently used context is also the least recently used one of its key
+      std::map<Key, std::list<IdleContexts::iterator> >::iterator it = idle_by_key_.find(idle_.back().first);
+      it->second.pop_back();
+      if (it->second.empty())
+        idle_by_key_.erase(it);
+      evicted.push_back(idle_.back().second);
+      idle_.pop_back();
+    }
+  }
+
+  IdleContexts idle_;
+  std::map<Key, std::list<IdleContexts::iterator> > idle_by_key_;
+  std::size_t max_idle_contexts_;
+  mutable boost::mutex lock_;
 };
 
 }  // namespace ompl_interface
@@ -114,9 +219,13 @@ ompl_interface::PlanningContextManager::PlanningContextManager(
   , max_goal_samples_(10)
   , max_state_sampling_attempts_(4)
   , max_goal_sampling_attempts_(1000)
+  , max_goal_sampling_threads_(1)
   , max_planning_threads_(4)
   , max_solution_segment_length_(0.0)
   , minimum_waypoint_count_(2)
+  , planning_thread_pool_(new PlanningThreadPool())
+  , goal_state_cache_(new GoalStateCache())
+  , planner_statistics_(new PlannerStatistics())
 {
   last_planning_context_.reset(new LastPlanningContext());
   cached_contexts_.reset(new CachedContexts());
@@ -143,6 +252,47 @@ static ompl::base::PlannerPtr allocatePlanner(const ob::SpaceInformationPtr& si,
   planner->setup();
   return planner;
 }
+
+/* Allocate a tree-based planner that can use a NearestNeighborsJointKDTree; the planner configuration selects it
+ * with nearest_neighbors: joint_kd_tree */
+template <typename T>
+static ompl::base::PlannerPtr allocateTreePlanner(const ob::SpaceInformationPtr& si, const std::string& new_name,
+                                                  const ModelBasedPlanningContextSpecification& spec)
+{
+  T* tree_planner = new T(si);
+  ompl::base::PlannerPtr planner(tree_planner);
+  if (!new_name.empty())
+    planner->setName(new_name);
+  planner->params().setParams(spec.config_, true);
+
+  std::map<std::string, std::string>::const_iterator it = spec.config_.find("nearest_neighbors");
+  if (it != spec.config_.end() && boost::trim_copy(it->second) == "joint_kd_tree")
+  {
+    const JointModelStateSpace* space = dynamic_cast<const JointModelStateSpace*>(si->getStateSpace().get());
+    if (space && space->hasSimpleJoints() && !space->hasDistanceFunction())
+    {
+      JointKDTreeSpaceScope scope(space);
+      tree_planner->template setNearestNeighbors<NearestNeighborsJointKDTree>();
+    }
+    else
+      logWarn("%s: The joint KD-tree needs a joint space made of revolute and prismatic joints only. Using the "
+              "default nearest neighbors structure instead.",
+              planner->getName().c_str());
+  }
+
+  planner->setup();
+  return planner;
+}
+
+/* Allocate a planner that chooses, for each request, the planner of the configuration's planners list that solved
+ * such requests fastest so far */
+static ompl::base::PlannerPtr allocateAdaptivePlanner(const ob::SpaceInformationPtr& si, const std::string& new_name,
+                                                      const ModelBasedPlanningContextSpecification& spec)
+{
+  ompl::base::PlannerPtr planner(new AdaptivePlanner(si, new_name, spec));
+  planner->setup();
+  return planner;
+}
 }
 
 ompl_interface::ConfiguredPlannerAllocator
@@ -160,16 +310,16 @@ ompl_interface::PlanningContextManager::plannerSelector(const std::string& plann
 
 void ompl_interface::PlanningContextManager::registerDefaultPlanners()
 {
-  registerPlannerAllocator("geometric::RRT", boost::bind(&allocatePlanner<og::RRT>, _1, _2, _3));
-  registerPlannerAllocator("geometric::RRTConnect", boost::bind(&allocatePlanner<og::RRTConnect>, _1, _2, _3));
-  registerPlannerAllocator("geometric::LazyRRT", boost::bind(&allocatePlanner<og::LazyRRT>, _1, _2, _3));
-  registerPlannerAllocator("geometric::TRRT", boost::bind(&allocatePlanner<og::TRRT>, _1, _2, _3));
+  registerPlannerAllocator("geometric::RRT", boost::bind(&allocateTreePlanner<og::RRT>, _1, _2, _3));
+  registerPlannerAllocator("geometric::RRTConnect", boost::bind(&allocateTreePlanner<og::RRTConnect>, _1, _2, _3));
+  registerPlannerAllocator("geometric::LazyRRT", boost::bind(&allocateTreePlanner<og::LazyRRT>, _1, _2, _3));
+  registerPlannerAllocator("geometric::TRRT", boost::bind(&allocateTreePlanner<og::TRRT>, _1, _2, _3));
   registerPlannerAllocator("geometric::EST", boost::bind(&allocatePlanner<og::EST>, _1, _2, _3));
   registerPlannerAllocator("geometric::SBL", boost::bind(&allocatePlanner<og::SBL>, _1, _2, _3));
   registerPlannerAllocator("geometric::KPIECE", boost::bind(&allocatePlanner<og::KPIECE1>, _1, _2, _3));
   registerPlannerAllocator("geometric::BKPIECE", boost::bind(&allocatePlanner<og::BKPIECE1>, _1, _2, _3));
   registerPlannerAllocator("geometric::LBKPIECE", boost::bind(&allocatePlanner<og::LBKPIECE1>, _1, _2, _3));
-  registerPlannerAllocator("geometric::RRTstar", boost::bind(&allocatePlanner<og::RRTstar>, _1, _2, _3));
+  registerPlannerAllocator("geometric::RRTstar", boost::bind(&allocateTreePlanner<og::RRTstar>, _1, _2, _3));
   registerPlannerAllocator("geometric::PRM", boost::bind(&allocatePlanner<og::PRM>, _1, _2, _3));
   registerPlannerAllocator("geometric::PRMstar", boost::bind(&allocatePlanner<og::PRMstar>, _1, _2, _3));
   registerPlannerAllocator("geometric::FMT", boost::bind(&allocatePlanner<og::FMT>, _1, _2, _3));
@@ -184,6 +334,7 @@ void ompl_interface::PlanningContextManager::registerDefaultPlanners()
   registerPlannerAllocator("geometric::LazyPRMstar", boost::bind(&allocatePlanner<og::LazyPRMstar>, _1, _2, _3));
   registerPlannerAllocator("geometric::SPARS", boost::bind(&allocatePlanner<og::SPARS>, _1, _2, _3));
   registerPlannerAllocator("geometric::SPARStwo", boost::bind(&allocatePlanner<og::SPARStwo>, _1, _2, _3));
+  registerPlannerAllocator("adaptive", boost::bind(&allocateAdaptivePlanner, _1, _2, _3));
 }
 
 void ompl_interface::PlanningContextManager::registerDefaultStateSpaces()
@@ -228,23 +379,10 @@ ompl_interface::ModelBasedPlanningContextPtr ompl_interface::PlanningContextMana
   const ompl_interface::ModelBasedStateSpaceFactoryPtr& factory = factory_selector(config.group);
 
   // Check for a cached planning context
-  ModelBasedPlanningContextPtr context;
-
-  {
-    boost::mutex::scoped_lock slock(cached_contexts_->lock_);
-    std::map<std::pair<std::string, std::string>, std::vector<ModelBasedPlanningContextPtr> >::const_iterator cc =
-        cached_contexts_->contexts_.find(std::make_pair(config.name, factory->getType()));
-    if (cc != cached_contexts_->contexts_.end())
-    {
-      for (std::size_t i = 0; i < cc->second.size(); ++i)
-        if (cc->second[i].unique())
-        {
-          logDebug("Reusing cached planning context");
-          context = cc->second[i];
-          break;
-        }
-    }
-  }
+  CachedContexts::Key key(config.name, factory->getType());
+  ModelBasedPlanningContextPtr context = cached_contexts_->checkout(key);
+  if (context)
+    logDebug("Reusing cached planning context");
 
   // Create a new planning context
   if (!context)
@@ -254,6 +392,9 @@ ompl_interface::ModelBasedPlanningContextPtr ompl_interface::PlanningContextMana
     context_spec.config_ = config.config;
     context_spec.planner_selector_ = getPlannerSelector();
     context_spec.constraint_sampler_manager_ = constraint_sampler_manager_;
+    context_spec.planning_thread_pool_ = planning_thread_pool_;
+    context_spec.goal_state_cache_ = goal_state_cache_;
+    context_spec.planner_statistics_ = planner_statistics_;
     context_spec.state_space_ = factory->getNewStateSpace(space_spec);
 
     // Choose the correct simple setup type to load
@@ -281,16 +422,28 @@ ompl_interface::ModelBasedPlanningContextPtr ompl_interface::PlanningContextMana
     logDebug("Creating new planning context");
     context.reset(new ModelBasedPlanningContext(config.name, context_spec));
     context->useStateValidityCache(state_validity_cache);
-    {
-      boost::mutex::scoped_lock slock(cached_contexts_->lock_);
-      cached_contexts_->contexts_[std::make_pair(config.name, factory->getType())].push_back(context);
-    }
   }
+  context = CachedContexts::share(cached_contexts_, key, context);
 
   context->setMaximumPlanningThreads(max_planning_threads_);
   context->setMaximumGoalSamples(max_goal_samples_);
   context->setMaximumStateSamplingAttempts(max_state_sampling_attempts_);
   context->setMaximumGoalSamplingAttempts(max_goal_sampling_attempts_);
+  unsigned int goal_sampling_threads = max_goal_sampling_threads_;
+  std::map<std::string, std::string>::const_iterator threads_it = config.config.find("goal_sampling_threads");
+  if (threads_it != config.config.end())
+  {
+    try
+    {
+      goal_sampling_threads = std::max(1, boost::lexical_cast<int>(boost::trim_copy(threads_it->second)));
+    }
+    catch (boost::bad_lexical_cast&)
+    {
+      logWarn("Ignoring invalid goal_sampling_threads value '%s' for planner configuration '%s'",
+              threads_it->second.c_str(), config.name.c_str());
+    }
+  }
+  context->setMaximumGoalSamplingThreads(goal_sampling_threads);
   if (max_solution_segment_length_ <= std::numeric_limits<double>::epsilon())
     context->setMaximumSolutionSegmentLength(context->getOMPLSimpleSetup()->getStateSpace()->getMaximumExtent() /
                                              100.0);
@@ -427,6 +580,33 @@ ompl_interface::ModelBasedPlanningContextPtr ompl_interface::PlanningContextMana
   return context;
 }
 
+void ompl_interface::PlanningContextManager::setMaximumCachedContexts(std::size_t max_cached_contexts)
+{
+  cached_contexts_->setMaximumIdleContexts(max_cached_contexts);
+}
+
+std::size_t ompl_interface::PlanningContextManager::getMaximumCachedContexts() const
+{
+  return cached_contexts_->getMaximumIdleContexts();
+}
+
+void ompl_interface::PlanningContextManager::prewarmPlanningContexts(const std::vector<std::string>& configs)
+{
+  std::vector<ModelBasedPlanningContextPtr> contexts;
+  for (std::size_t i = 0; i < configs.size() && contexts.size() < getMaximumCachedContexts(); ++i)
+  {
+    ModelBasedPlanningContextPtr context = getPlanningContext(configs[i]);
+    if (!context)
+      continue;
+    // computes the state space's internals (extents, projections, signature) ahead of the first request
+    context->getOMPLStateSpace()->setup();
+    contexts.push_back(context);
+  }
+  // the contexts become idle, ready for the first requests, when the handles are released
+  last_planning_context_->clear();
+  logDebug("Prepared %u planning contexts", (unsigned int)contexts.size());
+}
+
 ompl_interface::ModelBasedPlanningContextPtr ompl_interface::PlanningContextManager::getLastPlanningContext() const
 {
   return last_planning_context_->getContext();
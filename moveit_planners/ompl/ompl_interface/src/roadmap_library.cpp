@@ -0,0 +1,257 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/ompl_interface/roadmap_library.h>
+#include <ompl/base/PlannerDataStorage.h>
+#include <ompl/geometric/planners/prm/LazyPRM.h>
+#include <ompl/geometric/planners/prm/LazyPRMstar.h>
+#include <ompl/util/Console.h>
+#include <boost/filesystem.hpp>
+
+namespace ompl_interface
+{
+namespace
+{
+/* Copy the roadmap of \e source to \e data, which belongs to a different space information; the copied states are
+ * owned by \e data */
+void copyRoadmap(const ompl::base::PlannerPtr& source, ompl::base::PlannerData& data)
+{
+  ompl::base::PlannerData source_data(source->getSpaceInformation());
+  source->getPlannerData(source_data);
+
+  std::vector<unsigned int> index(source_data.numVertices());
+  for (unsigned int i = 0; i < source_data.numVertices(); ++i)
+    index[i] = data.addVertex(ompl::base::PlannerDataVertex(source_data.getVertex(i).getState()));
+
+  std::vector<unsigned int> edges;
+  for (unsigned int i = 0; i < source_data.numVertices(); ++i)
+  {
+    source_data.getEdges(i, edges);
+    for (std::size_t j = 0; j < edges.size(); ++j)
+    {
+      ompl::base::Cost weight;
+      source_data.getEdgeWeight(i, edges[j], &weight);
+      data.addEdge(index[i], index[edges[j]], ompl::base::PlannerDataEdge(), weight);
+    }
+  }
+  data.decoupleFromPlanner();
+}
+
+/* Construct a planner like \e planner (which is a LazyPRM) whose roadmap is \e data */
+ompl::base::PlannerPtr seedPlanner(const ompl::base::PlannerPtr& planner, const ompl::base::PlannerData& data)
+{
+  bool star = dynamic_cast<ompl::geometric::LazyPRMstar*>(planner.get()) != NULL;
+  ompl::geometric::LazyPRM* seeded = new ompl::geometric::LazyPRM(data, star);
+  ompl::base::PlannerPtr result(seeded);
+  result->setName(planner->getName());
+  std::map<std::string, std::string> params;
+  planner->params().getParams(params);
+  result->params().setParams(params, true);
+  seeded->clearValidity();
+  return result;
+}
+}
+}
+
+ompl_interface::RoadmapSceneVersion::RoadmapSceneVersion()
+  : world_(0), octomap_(0), allowed_collision_matrix_(0), robot_padding_(0), attached_bodies_(0)
+{
+}
+
+ompl_interface::RoadmapSceneVersion::RoadmapSceneVersion(const planning_scene::PlanningScene& scene)
+  : world_(scene.getWorldVersion())
+  , octomap_(scene.getOctomapVersion())
+  , allowed_collision_matrix_(scene.getAllowedCollisionMatrixVersion())
+  , robot_padding_(scene.getRobotPaddingVersion())
+  , attached_bodies_(scene.getAttachedBodiesVersion())
+{
+}
+
+bool ompl_interface::RoadmapSceneVersion::operator==(const RoadmapSceneVersion& other) const
+{
+  return world_ == other.world_ && octomap_ == other.octomap_ &&
+         allowed_collision_matrix_ == other.allowed_collision_matrix_ && robot_padding_ == other.robot_padding_ &&
+         attached_bodies_ == other.attached_bodies_;
+}
+
+ompl_interface::RoadmapLibrary::RoadmapLibrary()
+{
+}
+
+ompl_interface::RoadmapLibrary::~RoadmapLibrary()
+{
+}
+
+void ompl_interface::RoadmapLibrary::setRoadmapsPath(const std::string& path)
+{
+  boost::mutex::scoped_lock slock(lock_);
+  path_ = path;
+}
+
+std::string ompl_interface::RoadmapLibrary::getRoadmapFilename(const std::string& path, const std::string& key) const
+{
+  return path + "/" + key + ".roadmap";
+}
+
+ompl::base::PlannerPtr ompl_interface::RoadmapLibrary::checkoutRoadmap(const std::string& key,
+                                                                       const ompl::base::SpaceInformationPtr& si,
+                                                                       const ompl::base::PlannerAllocator& allocator,
+                                                                       const RoadmapSceneVersion& version)
+{
+  boost::mutex::scoped_lock slock(lock_);
+  Roadmap& roadmap = roadmaps_[key];
+  if (roadmap.checked_out_)
+  {
+    logDebug("Roadmap '%s' is in use by another request", key.c_str());
+    return ompl::base::PlannerPtr();
+  }
+
+  if (roadmap.planner_ && roadmap.planner_->getSpaceInformation() == si)
+  {
+    // the validity of what the roadmap already checked is only known for the scene it was checked in
+    if (roadmap.version_ != version)
+      static_cast<ompl::geometric::LazyPRM*>(roadmap.planner_.get())->clearValidity();
+    roadmap.checked_out_ = true;
+    return roadmap.planner_;
+  }
+
+  ompl::base::PlannerPtr planner = allocator(si);
+  if (!dynamic_cast<ompl::geometric::LazyPRM*>(planner.get()))
+  {
+    logWarn("Planner '%s' does not build a LazyPRM roadmap. Not keeping a persistent roadmap for '%s'.",
+            planner ? planner->getName().c_str() : "", key.c_str());
+    return ompl::base::PlannerPtr();
+  }
+
+  ompl::base::PlannerData data(si);
+  if (roadmap.planner_)
+    copyRoadmap(roadmap.planner_, data);
+  else if (!path_.empty())
+  {
+    std::string filename = getRoadmapFilename(path_, key);
+    if (boost::filesystem::exists(filename))
+    {
+      ompl::base::PlannerDataStorage storage;
+      storage.load(filename.c_str(), data);
+      logInform("Loaded roadmap with %u vertices and %u edges for '%s' from '%s'", data.numVertices(),
+                data.numEdges(), key.c_str(), filename.c_str());
+    }
+  }
+  if (data.numVertices() > 0)
+    planner = seedPlanner(planner, data);
+
+  roadmap.planner_ = planner;
+  roadmap.version_ = version;
+  roadmap.checked_out_ = true;
+  return planner;
+}
+
+void ompl_interface::RoadmapLibrary::checkinRoadmap(const std::string& key, const ompl::base::PlannerPtr& planner,
+                                                    const RoadmapSceneVersion& version)
+{
+  boost::mutex::scoped_lock slock(lock_);
+  std::map<std::string, Roadmap>::iterator it = roadmaps_.find(key);
+  if (it == roadmaps_.end() || it->second.planner_ != planner)
+    return;
+  it->second.version_ = version;
+  it->second.checked_out_ = false;
+}
+
+void ompl_interface::RoadmapLibrary::saveRoadmaps() const
+{
+  std::string path;
+  {
+    boost::mutex::scoped_lock slock(lock_);
+    path = path_;
+  }
+  if (!path.empty())
+    saveRoadmaps(path);
+}
+
+void ompl_interface::RoadmapLibrary::saveRoadmaps(const std::string& path) const
+{
+  boost::mutex::scoped_lock slock(lock_);
+  if (roadmaps_.empty())
+    return;
+  logInform("Saving %u roadmaps to '%s'", (unsigned int)roadmaps_.size(), path.c_str());
+  try
+  {
+    boost::filesystem::create_directories(path);
+  }
+  catch (...)
+  {
+  }
+
+  ompl::base::PlannerDataStorage storage;
+  for (std::map<std::string, Roadmap>::const_iterator it = roadmaps_.begin(); it != roadmaps_.end(); ++it)
+  {
+    if (!it->second.planner_)
+      continue;
+    if (it->second.checked_out_)
+    {
+      logWarn("Roadmap '%s' is in use and will not be saved", it->first.c_str());
+      continue;
+    }
+    ompl::base::PlannerData data(it->second.planner_->getSpaceInformation());
+    it->second.planner_->getPlannerData(data);
+    storage.store(data, getRoadmapFilename(path, it->first).c_str());
+  }
+}
+
+void ompl_interface::RoadmapLibrary::clearRoadmaps()
+{
+  boost::mutex::scoped_lock slock(lock_);
+  for (std::map<std::string, Roadmap>::iterator it = roadmaps_.begin(); it != roadmaps_.end();)
+    if (it->second.checked_out_)
+      ++it;
+    else
+      roadmaps_.erase(it++);
+}
+
+void ompl_interface::RoadmapLibrary::printRoadmaps(std::ostream& out) const
+{
+  boost::mutex::scoped_lock slock(lock_);
+  for (std::map<std::string, Roadmap>::const_iterator it = roadmaps_.begin(); it != roadmaps_.end(); ++it)
+  {
+    out << it->first << std::endl;
+    if (it->second.planner_ && !it->second.checked_out_)
+    {
+      ompl::base::PlannerData data(it->second.planner_->getSpaceInformation());
+      it->second.planner_->getPlannerData(data);
+      out << data.numVertices() << " vertices, " << data.numEdges() << " edges" << std::endl;
+    }
+    else
+      out << (it->second.checked_out_ ? "in use" : "empty") << std::endl;
+  }
+}
@@ -36,6 +36,8 @@
 
 #include <moveit/ompl_interface/parameterization/joint_space/joint_model_state_space.h>
 #include <moveit/ompl_interface/parameterization/work_space/pose_model_state_space.h>
+#include <moveit/ompl_interface/detail/state_validity_cache.h>
+#include <moveit/ompl_interface/planner_statistics.h>
 #include <moveit_resources/config.h>
 
 #include <urdf_parser/urdf_parser.h>
@@ -45,6 +47,7 @@
 #include <gtest/gtest.h>
 #include <fstream>
 #include <boost/filesystem/path.hpp>
+#include <boost/filesystem/operations.hpp>
 
 class LoadPlanningModelsPr2 : public testing::Test
 {
@@ -170,6 +173,168 @@ TEST_F(LoadPlanningModelsPr2, StateSpaceCopy)
   ss.freeState(state);
 }
 
+TEST_F(LoadPlanningModelsPr2, SimpleJointsDistanceInterpolation)
+{
+  ompl_interface::ModelBasedStateSpaceSpecification spec(robot_model_, "right_arm");
+  ompl_interface::JointModelStateSpace ss(spec);
+  ss.setup();
+  ASSERT_TRUE(ss.hasSimpleJoints());
+  const robot_model::JointModelGroup* jmg = ss.getJointModelGroup();
+
+  ompl::base::StateSamplerPtr sampler = ss.allocStateSampler();
+  const unsigned int count = 20;
+  std::vector<ompl::base::State*> states(count);
+  for (unsigned int i = 0; i < count; ++i)
+  {
+    states[i] = ss.allocState();
+    sampler->sampleUniform(states[i]);
+  }
+  ompl::base::State* state = ss.allocState();
+  std::vector<double> expected(jmg->getVariableCount());
+  std::vector<double> values(count * jmg->getVariableCount());
+  for (unsigned int i = 0; i < count; ++i)
+    std::copy(states[i]->as<ompl_interface::ModelBasedStateSpace::StateType>()->values,
+              states[i]->as<ompl_interface::ModelBasedStateSpace::StateType>()->values + jmg->getVariableCount(),
+              &values[i * jmg->getVariableCount()]);
+  std::vector<double> distances(count);
+  ss.distanceValuesMany(states[0]->as<ompl_interface::ModelBasedStateSpace::StateType>()->values, &values[0], count,
+                        &distances[0]);
+
+  for (unsigned int i = 0; i < count; ++i)
+  {
+    const double* from = states[0]->as<ompl_interface::ModelBasedStateSpace::StateType>()->values;
+    const double* to = states[i]->as<ompl_interface::ModelBasedStateSpace::StateType>()->values;
+    EXPECT_NEAR(jmg->distance(from, to), ss.distance(states[0], states[i]), 1e-9);
+    EXPECT_NEAR(jmg->distance(from, to), distances[i], 1e-9);
+
+    ss.interpolate(states[0], states[i], 0.3, state);
+    jmg->interpolate(from, to, 0.3, &expected[0]);
+    for (std::size_t k = 0; k < expected.size(); ++k)
+      EXPECT_NEAR(expected[k], state->as<ompl_interface::ModelBasedStateSpace::StateType>()->values[k], 1e-9);
+  }
+
+  ss.freeState(state);
+  for (unsigned int i = 0; i < count; ++i)
+    ss.freeState(states[i]);
+
+  // the base of the whole body is a planar joint
+  ompl_interface::ModelBasedStateSpaceSpecification spec2(robot_model_, "whole_body");
+  ompl_interface::JointModelStateSpace ss2(spec2);
+  EXPECT_FALSE(ss2.hasSimpleJoints());
+}
+
+TEST_F(LoadPlanningModelsPr2, MimicJointValues)
+{
+  // the values of the active joints after a mimic joint are read from their own slots of the state
+  std::size_t tested = 0;
+  const std::vector<const robot_model::JointModelGroup*>& groups = robot_model_->getJointModelGroups();
+  for (std::size_t g = 0; g < groups.size(); ++g)
+  {
+    if (groups[g]->getMimicJointModels().empty() || groups[g]->getActiveJointModels().size() < 2)
+      continue;
+    ompl_interface::ModelBasedStateSpaceSpecification spec(robot_model_, groups[g]->getName());
+    ompl_interface::JointModelStateSpace ss(spec);
+    ss.setup();
+
+    robot_state::RobotState kstate(robot_model_);
+    kstate.setToRandomPositions();
+    kstate.update();
+    ompl::base::State* state = ss.allocState();
+    ss.copyToOMPLState(state, kstate);
+
+    robot_state::RobotState expected(robot_model_);
+    expected.setToRandomPositions();
+    robot_state::RobotState actual(expected);
+    expected.setJointGroupPositions(groups[g], state->as<ompl_interface::ModelBasedStateSpace::StateType>()->values);
+    ss.copyJointValuesToRobotState(actual, state);
+    const std::vector<std::string>& variables = groups[g]->getVariableNames();
+    for (std::size_t i = 0; i < variables.size(); ++i)
+      EXPECT_NEAR(expected.getVariablePosition(variables[i]), actual.getVariablePosition(variables[i]), 1e-12)
+          << groups[g]->getName() << ": " << variables[i];
+    ss.freeState(state);
+    tested++;
+  }
+  EXPECT_GT(tested, 0u);
+}
+
+TEST(StateValidityCache, LookupAndResize)
+{
+  ompl_interface::StateValidityCache cache(3);
+  const std::size_t initial_size = cache.getSize();
+  const double valid_state[3] = { 0.1, -0.2, 0.3 };
+  const double invalid_state[3] = { 0.1, -0.2, 0.4 };
+  const double copied_state[3] = { 0.1 + 1e-9, -0.2, 0.3 };
+
+  bool valid = false;
+  EXPECT_FALSE(cache.lookup(valid_state, valid));
+  cache.insert(valid_state, true);
+  cache.insert(invalid_state, false);
+  EXPECT_TRUE(cache.lookup(valid_state, valid));
+  EXPECT_TRUE(valid);
+  EXPECT_TRUE(cache.lookup(copied_state, valid));
+  EXPECT_TRUE(valid);
+  EXPECT_TRUE(cache.lookup(invalid_state, valid));
+  EXPECT_FALSE(valid);
+  EXPECT_EQ(3u, cache.getHitCount());
+  EXPECT_EQ(1u, cache.getMissCount());
+
+  // the table grows for requests that store more states than fit in it
+  double state[3] = { 0.0, 0.0, 0.0 };
+  for (std::size_t i = 0; i < initial_size; ++i)
+  {
+    state[0] = 0.001 * i;
+    cache.insert(state, true);
+  }
+  cache.clear();
+  EXPECT_GT(cache.getSize(), initial_size);
+  EXPECT_FALSE(cache.lookup(valid_state, valid));
+  EXPECT_EQ(0u, cache.getHitCount());
+}
+
+TEST(PlannerStatistics, SelectAndPersist)
+{
+  ompl_interface::PlannerStatistics statistics;
+  std::vector<std::string> planners;
+  planners.push_back("geometric::RRTConnect");
+  planners.push_back("geometric::EST");
+
+  // every planner is tried once before the statistics are used
+  EXPECT_EQ("geometric::RRTConnect", statistics.selectPlanner("arm", planners));
+  statistics.addOutcome("arm", "geometric::RRTConnect", true, 0.1);
+  EXPECT_EQ("geometric::EST", statistics.selectPlanner("arm", planners));
+  statistics.addOutcome("arm", "geometric::EST", false, 1.0);
+
+  // the faster, more reliable planner is preferred, while the other one is still tried now and then
+  for (int i = 0; i < 40; ++i)
+  {
+    std::string planner = statistics.selectPlanner("arm", planners);
+    if (planner == "geometric::RRTConnect")
+      statistics.addOutcome("arm", planner, true, 0.1);
+    else
+      statistics.addOutcome("arm", planner, false, 1.0);
+  }
+  ompl_interface::PlannerStatistics::Record fast = statistics.getRecord("arm", "geometric::RRTConnect");
+  ompl_interface::PlannerStatistics::Record slow = statistics.getRecord("arm", "geometric::EST");
+  EXPECT_EQ(42u, fast.attempts_ + slow.attempts_);
+  EXPECT_GT(fast.attempts_, 3 * slow.attempts_);
+  EXPECT_GT(slow.attempts_, 1u);
+  EXPECT_EQ(fast.attempts_, fast.successes_);
+
+  // other kinds of problems are kept apart
+  EXPECT_EQ(0u, statistics.getRecord("arm/objects1", "geometric::RRTConnect").attempts_);
+
+  boost::filesystem::path path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+  statistics.saveStatistics(path.string());
+  ompl_interface::PlannerStatistics loaded;
+  loaded.setStatisticsPath(path.string());
+  EXPECT_EQ(fast.attempts_, loaded.getRecord("arm", "geometric::RRTConnect").attempts_);
+  EXPECT_EQ(slow.attempts_, loaded.getRecord("arm", "geometric::EST").attempts_);
+  EXPECT_EQ(0u, loaded.getRecord("arm", "geometric::EST").successes_);
+  EXPECT_NEAR(fast.total_time_, loaded.getRecord("arm", "geometric::RRTConnect").total_time_, 1e-9);
+  EXPECT_NEAR(fast.total_reward_, loaded.getRecord("arm", "geometric::RRTConnect").total_reward_, 1e-9);
+  boost::filesystem::remove_all(path);
+}
+
 int main(int argc, char** argv)
 {
   testing::InitGoogleTest(&argc, argv);
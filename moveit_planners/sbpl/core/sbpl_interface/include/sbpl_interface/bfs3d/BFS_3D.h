@@ -38,21 +38,35 @@
 #define _SBPL_BFS_3D_H_
 
 #include <boost/thread.hpp>
+#include <vector>
 
 namespace sbpl_interface
 {
 #define WALL 0x7FFFFFFF
 #define UNDISCOVERED 0xFFFFFFFF
 
+/** The searches for the most recent goals are kept, so that a BFS_3D that persists across queries only searches
+    again when the goal or the walls change. */
 class BFS_3D
 {
 private:
+  static const unsigned int MAX_CACHED_GOALS = 4;
+
+  struct CachedGrid
+  {
+    int origin;  // goal node the grid was searched from, -1 if invalid
+    int volatile* distance_grid;
+  };
+
   int dim_x, dim_y, dim_z;
   int dim_xy, dim_xyz;
 
   int origin;
   int volatile* distance_grid;
 
+  // most recently used first; distance_grid always points at the front entry
+  std::vector<CachedGrid> grids_;
+
   int* queue;
   int queue_head, queue_tail;
 
@@ -63,6 +77,9 @@ private:
   void search(int, int, int volatile*, int*, int&, int&);
   inline int getNode(int, int, int);
 
+  void stopSearch();
+  void setCell(int, int);
+
 public:
   BFS_3D(int, int, int);
   ~BFS_3D();
@@ -70,6 +87,7 @@ public:
   void getDimensions(int*, int*, int*);
 
   void setWall(int, int, int);
+  void clearWall(int, int, int);
   bool isWall(int, int, int);
 
   void run(int, int, int);
@@ -236,6 +236,18 @@ public:
 
   void attemptShortcut(const trajectory_msgs::JointTrajectory& traj_in, trajectory_msgs::JointTrajectory& traj_out);
 
+  /** @brief Use a BFS heuristic kept from an earlier query. Its walls are updated to the current scene in
+      setupForMotionPlan, and a search is only run again if the walls or the goal changed. */
+  void setBFS(const boost::shared_ptr<BFS_3D>& bfs)
+  {
+    bfs_ = bfs;
+  }
+
+  const boost::shared_ptr<BFS_3D>& getBFS() const
+  {
+    return bfs_;
+  }
+
 protected:
   bool getGridXYZInt(const Eigen::Affine3d& pose, int (&xyz)[3]) const;
 
@@ -244,7 +256,7 @@ protected:
   planning_scene::PlanningSceneConstPtr planning_scene_;
 
   double angle_discretization_;
-  BFS_3D* bfs_;
+  boost::shared_ptr<BFS_3D> bfs_;
 
   std::vector<boost::shared_ptr<JointMotionWrapper> > joint_motion_wrappers_;
   std::vector<boost::shared_ptr<JointMotionPrimitive> > possible_actions_;
@@ -270,13 +282,21 @@ protected:
   planning_models::RobotState* ::JointStateGroup* interpolation_joint_state_group_1_;
   planning_models::RobotState* ::JointStateGroup* interpolation_joint_state_group_2_;
   planning_models::RobotState* ::JointStateGroup* interpolation_joint_state_group_temp_;
-  std::map<int, std::map<int, std::vector<std::vector<double> > > > generated_interpolations_map_;
+  EnvChain3DInterpolationTable generated_interpolations_;
+
+  // per-expansion buffers, sized once for the motion primitives and reused by every call to GetSuccs
+  std::vector<std::vector<double> > successor_angles_;
+  std::vector<char> successor_generated_;
+  std::vector<int> successor_coord_;
+  EnvChain3DStateKey successor_key_;
+  std::vector<std::vector<double> > successor_interpolation_;
 
   void setMotionPrimitives(const std::string& group_name);
   void determineMaximumEndEffectorTravel();
 
   void convertCoordToJointAngles(const std::vector<int>& coord, std::vector<double>& angles);
   void convertJointAnglesToCoord(const std::vector<double>& angle, std::vector<int>& coord);
+  bool convertJointAnglesToKey(const std::vector<double>& angle, std::vector<int>& coord, EnvChain3DStateKey& key);
 
   int calculateCost(EnvChain3DHashEntry* HashEntry1, EnvChain3DHashEntry* HashEntry2);
   int getBFSCostToGoal(int x, int y, int z) const;
@@ -293,7 +313,7 @@ protected:
   // double getJointDistanceMax(const std::vector<double>& angles1,
   //                            const std::vector<double>& angles2);
 
-  bool interpolateAndCollisionCheck(const std::vector<double> angles1, const std::vector<double> angles2,
+  bool interpolateAndCollisionCheck(const std::vector<double>& angles1, const std::vector<double>& angles2,
                                     std::vector<std::vector<double> >& state_values);
 
   inline double getEuclideanDistance(double x1, double y1, double z1, double x2, double y2, double z2) const
@@ -327,6 +347,13 @@ inline void EnvironmentChain3D::convertJointAnglesToCoord(const std::vector<doub
   }
 }
 
+inline bool EnvironmentChain3D::convertJointAnglesToKey(const std::vector<double>& angle, std::vector<int>& coord,
+                                                        EnvChain3DStateKey& key)
+{
+  convertJointAnglesToCoord(angle, coord);
+  return key.pack(coord);
+}
+
 // inline double EnvironmentChain3D::getEuclideanDistance(double x1, double y1, double z1, double x2, double y2, double
 // z2) const
 // {
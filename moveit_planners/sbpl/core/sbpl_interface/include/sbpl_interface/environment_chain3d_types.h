@@ -38,12 +38,16 @@
 #define _ENVIRONMENT_CHAIN3D_TYPES_H_
 
 #include <vector>
+#include <stdint.h>
 #include <planning_models/robot_model.h>
 #include <planning_models/angle_utils.h>
 
 namespace sbpl_interface
 {
 static unsigned int HASH_TABLE_SIZE = 32 * 1024;
+static unsigned int STATE_ENTRY_BLOCK_SIZE = 4 * 1024;
+static unsigned int INTERPOLATION_TABLE_SIZE = 32 * 1024;
+static const uint64_t INTERPOLATION_TABLE_EMPTY_KEY = ~(uint64_t)0;
 
 static inline unsigned int intHash(unsigned int key)
 {
@@ -57,13 +61,53 @@ static inline unsigned int intHash(unsigned int key)
   key ^= (key >> 12);
   return key;
 }
+
+// each coordinate of the angle discretization is packed into 16 bits, four to a word
+static const unsigned int STATE_KEY_WORDS = 4;
+static const unsigned int STATE_KEY_COORD_BITS = 16;
+static const unsigned int STATE_KEY_COORDS_PER_WORD = 64 / STATE_KEY_COORD_BITS;
+static const int STATE_KEY_MAX_COORD = (1 << STATE_KEY_COORD_BITS) - 1;
+static const unsigned int STATE_KEY_MAX_DOFS = STATE_KEY_WORDS * STATE_KEY_COORDS_PER_WORD;
+
+/** @brief fixed width key of a position in the angle discretization */
+struct EnvChain3DStateKey
+{
+  uint64_t words[STATE_KEY_WORDS];
+
+  /** @brief pack \e coord into the key; false if it has too many joints or a coordinate does not fit */
+  bool pack(const std::vector<int>& coord)
+  {
+    if (coord.size() > STATE_KEY_MAX_DOFS)
+      return false;
+    for (unsigned int i = 0; i < STATE_KEY_WORDS; ++i)
+      words[i] = 0;
+    for (unsigned int i = 0; i < coord.size(); ++i)
+    {
+      if (coord[i] < 0 || coord[i] > STATE_KEY_MAX_COORD)
+        return false;
+      words[i / STATE_KEY_COORDS_PER_WORD] |= (uint64_t)coord[i]
+                                              << (STATE_KEY_COORD_BITS * (i % STATE_KEY_COORDS_PER_WORD));
+    }
+    return true;
+  }
+
+  bool operator==(const EnvChain3DStateKey& other) const
+  {
+    for (unsigned int i = 0; i < STATE_KEY_WORDS; ++i)
+      if (words[i] != other.words[i])
+        return false;
+    return true;
+  }
+};
+
 struct EnvChain3DHashEntry
 {
   unsigned char dist;          // distance to closest obstacle
   int stateID;                 // hash entry ID number
   int action;                  // which action in the list was required to get here
+  int goal_heuristic;          // cached heuristic to the goal, -1 until computed
   int xyz[3];                  // tip link coordinates in space
-  std::vector<int> coord;      // position in the angle discretization
+  EnvChain3DStateKey key;      // packed position in the angle discretization
   std::vector<double> angles;  // position of joints in continuous space
 };
 
@@ -93,39 +137,60 @@ struct EnvChain3DPlanningData
     , start_hash_entry_(NULL)
     , hash_table_size_(HASH_TABLE_SIZE)
   {
-    coord_to_state_ID_table_.resize(hash_table_size_);
+    coord_to_state_ID_table_.resize(hash_table_size_, NULL);
   }
 
   ~EnvChain3DPlanningData()
   {
-    for (unsigned int i = 0; i < state_ID_to_coord_table_.size(); i++)
+    for (unsigned int i = 0; i < entry_blocks_.size(); i++)
     {
-      delete state_ID_to_coord_table_[i];
+      delete[] entry_blocks_[i];
     }
   }
 
-  unsigned int getHashBin(const std::vector<int>& coord)
+  unsigned int getHashBin(const EnvChain3DStateKey& key) const
   {
     unsigned int val = 0;
 
-    for (size_t i = 0; i < coord.size(); i++)
-      val += intHash(coord[i]) << i;
+    for (size_t i = 0; i < STATE_KEY_WORDS; i++)
+      val += (intHash(key.words[i]) ^ intHash(key.words[i] >> 32)) << i;
 
     return intHash(val) & (hash_table_size_ - 1);
   }
 
-  EnvChain3DHashEntry* addHashEntry(const std::vector<int>& coord, const std::vector<double>& angles,
+  /** @brief the bin holding \e key, or the empty bin where it would be inserted */
+  unsigned int findHashBin(const EnvChain3DStateKey& key) const
+  {
+    unsigned int bin = getHashBin(key);
+    while (coord_to_state_ID_table_[bin] && !(coord_to_state_ID_table_[bin]->key == key))
+      bin = (bin + 1) & (hash_table_size_ - 1);
+    return bin;
+  }
+
+  EnvChain3DHashEntry* addHashEntry(const EnvChain3DStateKey& key, const std::vector<double>& angles,
                                     const int (&xyz)[3], int action)
   {
-    EnvChain3DHashEntry* new_hash_entry = new EnvChain3DHashEntry();
+    // keep the load factor at or below one half so probe sequences stay short
+    if (2 * (state_ID_to_coord_table_.size() + 1) > hash_table_size_)
+    {
+      growHashTable();
+    }
+
+    // entries are carved out of blocks instead of being allocated one at a time
+    std::size_t block_index = state_ID_to_coord_table_.size() % STATE_ENTRY_BLOCK_SIZE;
+    if (block_index == 0)
+    {
+      entry_blocks_.push_back(new EnvChain3DHashEntry[STATE_ENTRY_BLOCK_SIZE]);
+    }
+    EnvChain3DHashEntry* new_hash_entry = &entry_blocks_.back()[block_index];
     new_hash_entry->stateID = state_ID_to_coord_table_.size();
-    new_hash_entry->coord = coord;
+    new_hash_entry->key = key;
     new_hash_entry->angles = angles;
     memcpy(new_hash_entry->xyz, xyz, sizeof(int) * 3);
     new_hash_entry->action = action;
+    new_hash_entry->goal_heuristic = -1;
     state_ID_to_coord_table_.push_back(new_hash_entry);
-    unsigned int bin = getHashBin(coord);
-    coord_to_state_ID_table_[bin].push_back(new_hash_entry);
+    coord_to_state_ID_table_[findHashBin(key)] = new_hash_entry;
 
     // have to do for DiscreteSpaceInformation
     // insert into and initialize the mappings
@@ -140,17 +205,23 @@ struct EnvChain3DPlanningData
     return new_hash_entry;
   }
 
-  EnvChain3DHashEntry* getHashEntry(const std::vector<int>& coord, int action)
+  EnvChain3DHashEntry* getHashEntry(const EnvChain3DStateKey& key, int action)
+  {
+    return coord_to_state_ID_table_[findHashBin(key)];
+  }
+
+  void growHashTable()
   {
-    unsigned int bin = getHashBin(coord);
-    for (unsigned int i = 0; i < coord_to_state_ID_table_[bin].size(); i++)
+    std::vector<EnvChain3DHashEntry*> old_table(hash_table_size_ * 2, NULL);
+    coord_to_state_ID_table_.swap(old_table);
+    hash_table_size_ *= 2;
+    for (unsigned int i = 0; i < old_table.size(); i++)
     {
-      if (coord_to_state_ID_table_[bin][i]->coord == coord)
+      if (old_table[i])
       {
-        return coord_to_state_ID_table_[bin][i];
+        coord_to_state_ID_table_[findHashBin(old_table[i]->key)] = old_table[i];
       }
     }
-    return NULL;
   }
 
   bool convertFromStateIDsToAngles(const std::vector<int>& state_ids,
@@ -175,11 +246,97 @@ struct EnvChain3DPlanningData
   EnvChain3DHashEntry* start_hash_entry_;
 
   unsigned int hash_table_size_;
-  // maps from coords to stateID
-  std::vector<std::vector<EnvChain3DHashEntry*> > coord_to_state_ID_table_;
+  // open-addressing table that maps from packed coords to stateID, NULL marks an empty bin
+  std::vector<EnvChain3DHashEntry*> coord_to_state_ID_table_;
 
   // vector that maps from stateID to coords
   std::vector<EnvChain3DHashEntry*> state_ID_to_coord_table_;
+
+  // the entries themselves, STATE_ENTRY_BLOCK_SIZE at a time
+  std::vector<EnvChain3DHashEntry*> entry_blocks_;
+};
+
+/** @brief open-addressing table holding the interpolated segment between two states, keyed by the
+    packed pair of their state IDs */
+class EnvChain3DInterpolationTable
+{
+public:
+  EnvChain3DInterpolationTable()
+  {
+    clear();
+  }
+
+  void clear()
+  {
+    keys_.assign(INTERPOLATION_TABLE_SIZE, INTERPOLATION_TABLE_EMPTY_KEY);
+    slots_.assign(INTERPOLATION_TABLE_SIZE, -1);
+    segments_.clear();
+  }
+
+  std::size_t size() const
+  {
+    return segments_.size();
+  }
+
+  /** @brief store the segment from \e from_state_id to \e to_state_id, replacing any previous one */
+  void insert(int from_state_id, int to_state_id, const std::vector<std::vector<double> >& values)
+  {
+    // keep the load factor at or below one half so probe sequences stay short
+    if (2 * (segments_.size() + 1) > keys_.size())
+      grow();
+    uint64_t key = packKey(from_state_id, to_state_id);
+    std::size_t bin = findBin(key);
+    if (keys_[bin] == INTERPOLATION_TABLE_EMPTY_KEY)
+    {
+      keys_[bin] = key;
+      slots_[bin] = segments_.size();
+      segments_.push_back(values);
+    }
+    else
+      segments_[slots_[bin]] = values;
+  }
+
+  /** @brief get the segment from \e from_state_id to \e to_state_id, or NULL if none was stored */
+  const std::vector<std::vector<double> >* find(int from_state_id, int to_state_id) const
+  {
+    std::size_t bin = findBin(packKey(from_state_id, to_state_id));
+    return keys_[bin] == INTERPOLATION_TABLE_EMPTY_KEY ? NULL : &segments_[slots_[bin]];
+  }
+
+private:
+  static uint64_t packKey(int from_state_id, int to_state_id)
+  {
+    return ((uint64_t)(uint32_t)from_state_id << 32) | (uint32_t)to_state_id;
+  }
+
+  std::size_t findBin(uint64_t key) const
+  {
+    std::size_t mask = keys_.size() - 1;
+    std::size_t bin = intHash(intHash((unsigned int)(key >> 32)) + (unsigned int)key) & mask;
+    while (keys_[bin] != INTERPOLATION_TABLE_EMPTY_KEY && keys_[bin] != key)
+      bin = (bin + 1) & mask;
+    return bin;
+  }
+
+  void grow()
+  {
+    std::vector<uint64_t> old_keys(keys_.size() * 2, INTERPOLATION_TABLE_EMPTY_KEY);
+    std::vector<int> old_slots(slots_.size() * 2, -1);
+    keys_.swap(old_keys);
+    slots_.swap(old_slots);
+    for (std::size_t i = 0; i < old_keys.size(); ++i)
+      if (old_keys[i] != INTERPOLATION_TABLE_EMPTY_KEY)
+      {
+        std::size_t bin = findBin(old_keys[i]);
+        keys_[bin] = old_keys[i];
+        slots_[bin] = old_slots[i];
+      }
+  }
+
+  // capacity is always a power of two
+  std::vector<uint64_t> keys_;
+  std::vector<int> slots_;
+  std::vector<std::vector<std::vector<double> > > segments_;
 };
 
 class JointMotionWrapper
@@ -64,6 +64,9 @@ public:
 protected:
   PlanningStatistics last_planning_statistics_;
 
+  // BFS heuristic shared by consecutive queries
+  boost::shared_ptr<BFS_3D> bfs_;
+
   // DummyEnvironment* dummy_env_;
   // SBPLPlanner *planner_;
 };
@@ -29,6 +29,9 @@ BFS_3D::BFS_3D(int width, int height, int length)
 
   distance_grid = new int[dim_xyz];
   queue = new int[width * height * length];
+  origin = -1;
+  CachedGrid grid = { origin, distance_grid };
+  grids_.push_back(grid);
 
   for (int node = 0; node < dim_xyz; node++)
   {
@@ -50,7 +53,8 @@ BFS_3D::~BFS_3D()
     search_thread_->join();
   }
 
-  delete[] distance_grid;
+  for (std::size_t i = 0; i < grids_.size(); ++i)
+    delete[] grids_[i].distance_grid;
   delete[] queue;
 }
 
@@ -61,16 +65,45 @@ void BFS_3D::getDimensions(int* width, int* height, int* length)
   *length = dim_z - 2;
 }
 
-void BFS_3D::setWall(int x, int y, int z)
+void BFS_3D::stopSearch()
 {
+  if (!search_thread_)
+    return;
+  if (running)
+    search_thread_->interrupt();
+  search_thread_->join();
+  search_thread_.reset();
+
+  // an interrupted search leaves running set and its grid incomplete
   if (running)
   {
-    // error "Cannot modify grid while search is running"
+    running = false;
+    grids_.front().origin = -1;
+  }
+}
+
+void BFS_3D::setCell(int node, int value)
+{
+  if (node < 0 || (distance_grid[node] == WALL) == (value == WALL))
     return;
+
+  // the walls are shared by all cached grids, so changing one invalidates every cached search
+  stopSearch();
+  for (std::size_t i = 0; i < grids_.size(); ++i)
+  {
+    grids_[i].distance_grid[node] = value;
+    grids_[i].origin = -1;
   }
+}
 
-  int node = getNode(x, y, z);
-  distance_grid[node] = WALL;
+void BFS_3D::setWall(int x, int y, int z)
+{
+  setCell(getNode(x, y, z), WALL);
+}
+
+void BFS_3D::clearWall(int x, int y, int z)
+{
+  setCell(getNode(x, y, z), UNDISCOVERED);
 }
 
 bool BFS_3D::isWall(int x, int y, int z)
@@ -81,17 +114,55 @@ bool BFS_3D::isWall(int x, int y, int z)
 
 void BFS_3D::run(int x, int y, int z)
 {
-  if (running)
-  {
-    // error "Search already running"
+  int node = getNode(x, y, z);
+
+  // a search for this goal is already finished or still running on the current grid
+  if (grids_.front().origin == node)
     return;
+
+  stopSearch();
+
+  for (std::size_t i = 1; i < grids_.size(); ++i)
+    if (grids_[i].origin == node)
+    {
+      CachedGrid hit = grids_[i];
+      grids_.erase(grids_.begin() + i);
+      grids_.insert(grids_.begin(), hit);
+      distance_grid = hit.distance_grid;
+      origin = node;
+      return;
+    }
+
+  // prefer a grid whose search was invalidated, then a new one, then the least recently used
+  std::size_t reuse = grids_.size() - 1;
+  for (std::size_t i = 0; i < grids_.size(); ++i)
+    if (grids_[i].origin < 0)
+    {
+      reuse = i;
+      break;
+    }
+  if (grids_[reuse].origin >= 0 && grids_.size() < MAX_CACHED_GOALS)
+  {
+    // new grids copy the walls from the current one
+    CachedGrid grid = { -1, new int[dim_xyz] };
+    for (int i = 0; i < dim_xyz; i++)
+      grid.distance_grid[i] = distance_grid[i];
+    grids_.insert(grids_.begin(), grid);
+  }
+  else
+  {
+    CachedGrid grid = grids_[reuse];
+    grids_.erase(grids_.begin() + reuse);
+    grids_.insert(grids_.begin(), grid);
   }
+  distance_grid = grids_.front().distance_grid;
 
   for (int i = 0; i < dim_xyz; i++)
     if (distance_grid[i] != WALL)
       distance_grid[i] = UNDISCOVERED;
 
-  origin = getNode(x, y, z);
+  origin = node;
+  grids_.front().origin = origin;
 
   queue_head = 0;
   queue_tail = 1;
@@ -49,7 +49,6 @@ namespace sbpl_interface
 {
 EnvironmentChain3D::EnvironmentChain3D(const planning_scene::PlanningSceneConstPtr& planning_scene)
   : planning_scene_(planning_scene)
-  , bfs_(NULL)
   , state_(planning_scene->getCurrentState())
   , planning_data_(StateID2IndexMapping)
   , goal_constraint_set_(planning_scene->getRobotModel(), planning_scene->getTransforms())
@@ -63,10 +62,6 @@ EnvironmentChain3D::EnvironmentChain3D(const planning_scene::PlanningSceneConstP
 
 EnvironmentChain3D::~EnvironmentChain3D()
 {
-  if (bfs_ != NULL)
-  {
-    delete bfs_;
-  }
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -173,24 +168,32 @@ void EnvironmentChain3D::GetSuccs(int source_state_ID, std::vector<int>* succ_id
 
   EnvChain3DHashEntry* hash_entry = planning_data_.state_ID_to_coord_table_[source_state_ID];
 
-  std::vector<double> source_joint_angles = hash_entry->angles;
+  const std::vector<double>& source_joint_angles = hash_entry->angles;
   // convertCoordToJointAngles(hash_entry->coord, source_joint_angles);
 
-  std::vector<int> succ_coord;
-  std::vector<double> succ_joint_angles;
-
   // for(unsigned int i = 0; i < source_joint_angles.size(); i++) {
   //   std::cerr << "Source " << i << " " << source_joint_angles[i] << std::endl;
   // }
 
   planning_statistics_.total_expansions_++;
 
+  succ_idv->reserve(possible_actions_.size());
+  cost_v->reserve(possible_actions_.size());
+
+  // the primitives only depend on the source angles, so all candidate successors are generated up front into the
+  // preallocated buffers; the collision checks below share state_ and gsr_ and therefore stay sequential
+  for (unsigned int i = 0; i < possible_actions_.size(); i++)
+    successor_generated_[i] = possible_actions_[i]->generateSuccessorState(source_joint_angles, successor_angles_[i]);
+
+  std::vector<int>& succ_coord = successor_coord_;
+  std::vector<std::vector<double> >& interpolated_values = successor_interpolation_;
   for (unsigned int i = 0; i < possible_actions_.size(); i++)
   {
-    if (!possible_actions_[i]->generateSuccessorState(source_joint_angles, succ_joint_angles))
+    if (!successor_generated_[i])
     {
       continue;
     }
+    const std::vector<double>& succ_joint_angles = successor_angles_[i];
 
     // for(unsigned int j = 0; j < planning_data_.goal_hash_entry_->angles.size(); j++) {
     //   if(joint_is_continuous_[j]) {
@@ -226,7 +229,11 @@ void EnvironmentChain3D::GetSuccs(int source_state_ID, std::vector<int>* succ_id
     //   //   }
     //   // }
     // }
-    convertJointAnglesToCoord(succ_joint_angles, succ_coord);
+    if (!convertJointAnglesToKey(succ_joint_angles, succ_coord, successor_key_))
+    {
+      ROS_WARN_STREAM("Successor coordinates can't be packed into a state key");
+      continue;
+    }
 
     joint_state_group_->setStateValues(succ_joint_angles);
 
@@ -306,13 +313,13 @@ void EnvironmentChain3D::GetSuccs(int source_state_ID, std::vector<int>* succ_id
     {
       // std::cerr << "Joint distance for goal move " <<
       // getJointDistanceDoubleSum(planning_data_.goal_hash_entry_->angles, succ_joint_angles) << std::endl;
-      std::vector<std::vector<double> > interpolated_values;
       if (interpolateAndCollisionCheck(source_joint_angles, planning_data_.goal_hash_entry_->angles,
                                        interpolated_values))
       {
         // std::cerr << "Interpolation generated from id " << source_state_ID << " is " << interpolated_values.size() <<
         // " states\n";
-        generated_interpolations_map_[source_state_ID][planning_data_.goal_hash_entry_->stateID] = interpolated_values;
+        generated_interpolations_.insert(source_state_ID, planning_data_.goal_hash_entry_->stateID,
+                                         interpolated_values);
         succ_hash_entry = planning_data_.goal_hash_entry_;
         succ_is_goal_state = true;
       }
@@ -321,7 +328,6 @@ void EnvironmentChain3D::GetSuccs(int source_state_ID, std::vector<int>* succ_id
         // std::cerr << "Interpolation in collision\n";
       }
     }
-    std::vector<std::vector<double> > interpolated_values;
     if (!succ_is_goal_state)
     {
       if (planning_parameters_.interpolation_distance_ < planning_parameters_.joint_motion_primitive_distance_)
@@ -332,7 +338,7 @@ void EnvironmentChain3D::GetSuccs(int source_state_ID, std::vector<int>* succ_id
           continue;
         }
       }
-      succ_hash_entry = planning_data_.getHashEntry(succ_coord, i);
+      succ_hash_entry = planning_data_.getHashEntry(successor_key_, i);
     }
     // double max_dist = getJointDistanceMax(planning_data_.goal_hash_entry_->angles, succ_joint_angles);
     // if(max_dist < closest_to_goal_) {
@@ -362,7 +368,7 @@ void EnvironmentChain3D::GetSuccs(int source_state_ID, std::vector<int>* succ_id
     // }
     if (!succ_hash_entry)
     {
-      succ_hash_entry = planning_data_.addHashEntry(succ_coord, succ_joint_angles, xyz, i);
+      succ_hash_entry = planning_data_.addHashEntry(successor_key_, succ_joint_angles, xyz, i);
     }
     else
     {
@@ -376,7 +382,7 @@ void EnvironmentChain3D::GetSuccs(int source_state_ID, std::vector<int>* succ_id
         !succ_is_goal_state)
     {
       // std::cerr << "Adding segment from " << source_state_ID << " to " << succ_hash_entry->stateID << std::endl;
-      generated_interpolations_map_[source_state_ID][succ_hash_entry->stateID] = interpolated_values;
+      generated_interpolations_.insert(source_state_ID, succ_hash_entry->stateID, interpolated_values);
     }
 
     // std::cerr << "Adding hash entry" << std::endl;
@@ -503,8 +509,20 @@ bool EnvironmentChain3D::setupForMotionPlan(const planning_scene::PlanningSceneC
   }
   if (!planning_parameters_.use_standard_collision_checking_ && planning_parameters_.use_bfs_)
   {
-    bfs_ = new BFS_3D(gsr_->dfce_->distance_field_->getXNumCells(), gsr_->dfce_->distance_field_->getYNumCells(),
-                      gsr_->dfce_->distance_field_->getZNumCells());
+    // a BFS kept from an earlier query is reused if the distance field has the same size
+    int bfs_dims[3];
+    if (bfs_)
+    {
+      bfs_->getDimensions(&bfs_dims[0], &bfs_dims[1], &bfs_dims[2]);
+    }
+    if (!bfs_ || bfs_dims[0] != gsr_->dfce_->distance_field_->getXNumCells() ||
+        bfs_dims[1] != gsr_->dfce_->distance_field_->getYNumCells() ||
+        bfs_dims[2] != gsr_->dfce_->distance_field_->getZNumCells())
+    {
+      bfs_.reset(new BFS_3D(gsr_->dfce_->distance_field_->getXNumCells(),
+                            gsr_->dfce_->distance_field_->getYNumCells(),
+                            gsr_->dfce_->distance_field_->getZNumCells()));
+    }
 
     boost::shared_ptr<const distance_field::DistanceField> world_distance_field =
         hy_world_->getCollisionWorldDistanceField()->getDistanceField();
@@ -535,6 +553,11 @@ bool EnvironmentChain3D::setupForMotionPlan(const planning_scene::PlanningSceneC
             bfs_->setWall(i + 1, j + 1, k + 1);
             wall_count++;
           }
+          else
+          {
+            // cells freed since the last query; unchanged cells leave the cached searches intact
+            bfs_->clearWall(i + 1, j + 1, k + 1);
+          }
         }
       }
     }
@@ -547,7 +570,13 @@ bool EnvironmentChain3D::setupForMotionPlan(const planning_scene::PlanningSceneC
   std::vector<double> start_joint_values;
   joint_state_group_->getGroupStateValues(start_joint_values);
   std::vector<int> start_coords;
-  convertJointAnglesToCoord(start_joint_values, start_coords);
+  EnvChain3DStateKey start_key;
+  if (!convertJointAnglesToKey(start_joint_values, start_coords, start_key))
+  {
+    ROS_WARN_STREAM("Group has more than " << STATE_KEY_MAX_DOFS << " joints or too fine an angle discretization");
+    mres.error_code.val = moveit_msgs::MoveItErrorCodes::INVALID_ROBOT_STATE;
+    return false;
+  }
   Eigen::Affine3d start_pose = tip_link_state_->getGlobalLinkTransform();
 
   int start_xyz[3];
@@ -566,7 +595,7 @@ bool EnvironmentChain3D::setupForMotionPlan(const planning_scene::PlanningSceneC
     start_xyz[1] = 0.0;
     start_xyz[2] = 0.0;
   }
-  planning_data_.start_hash_entry_ = planning_data_.addHashEntry(start_coords, start_joint_values, start_xyz, 0);
+  planning_data_.start_hash_entry_ = planning_data_.addHashEntry(start_key, start_joint_values, start_xyz, 0);
 
   // setting goal position
   planning_models::RobotState* goal_state(state_);
@@ -597,7 +626,13 @@ bool EnvironmentChain3D::setupForMotionPlan(const planning_scene::PlanningSceneC
       goal_state.getJointStateGroup(planning_group_);
   goal_joint_state_group->getGroupStateValues(goal_joint_values);
   std::vector<int> goal_coords;
-  convertJointAnglesToCoord(goal_joint_values, goal_coords);
+  EnvChain3DStateKey goal_key;
+  if (!convertJointAnglesToKey(goal_joint_values, goal_coords, goal_key))
+  {
+    ROS_WARN_STREAM("Goal coordinates can't be packed into a state key");
+    mres.error_code.val = moveit_msgs::MoveItErrorCodes::INVALID_GOAL_CONSTRAINTS;
+    return false;
+  }
   goal_pose_ = goal_state.getLinkState(tip_link_state_->getName())->getGlobalLinkTransform();
   int goal_xyz[3];
   if (!planning_parameters_.use_standard_collision_checking_)
@@ -633,7 +668,7 @@ bool EnvironmentChain3D::setupForMotionPlan(const planning_scene::PlanningSceneC
   }
   goal_constraint_set_.clear();
   goal_constraint_set_.add(mreq.motion_plan_request.goal_constraints[0]);
-  planning_data_.goal_hash_entry_ = planning_data_.addHashEntry(goal_coords, goal_joint_values, goal_xyz, 0);
+  planning_data_.goal_hash_entry_ = planning_data_.addHashEntry(goal_key, goal_joint_values, goal_xyz, 0);
   path_constraint_set_.clear();
   path_constraint_set_.add(mreq.motion_plan_request.path_constraints);
   return true;
@@ -663,6 +698,12 @@ void EnvironmentChain3D::setMotionPrimitives(const std::string& group_name)
       possible_actions_.push_back(sing_neg);
     }
   }
+  successor_angles_.resize(possible_actions_.size());
+  for (unsigned int i = 0; i < successor_angles_.size(); i++)
+  {
+    successor_angles_[i].reserve(jmg->getActiveDOFNames().size());
+  }
+  successor_generated_.resize(possible_actions_.size());
   determineMaximumEndEffectorTravel();
 }
 
@@ -855,19 +896,31 @@ int EnvironmentChain3D::getEndEffectorHeuristic(int from_stateID, int to_stateID
   boost::this_thread::interruption_point();
   EnvChain3DHashEntry* from_hash_entry = planning_data_.state_ID_to_coord_table_[from_stateID];
   EnvChain3DHashEntry* to_hash_entry = planning_data_.state_ID_to_coord_table_[to_stateID];
+  // ARA* asks for the goal heuristic of a state every time it is reinserted into the open list
+  bool to_goal = to_hash_entry == planning_data_.goal_hash_entry_;
+  if (to_goal && from_hash_entry->goal_heuristic >= 0)
+  {
+    return from_hash_entry->goal_heuristic;
+  }
+  int heuristic;
   // if(planning_data_.state_ID_to_coord_table_.size() < PRINT_HEURISTIC_UNDER) {
   // std::cerr << " Dist " << dist << " heur " << getBFSCostToGoal(from_hash_entry->xyz[0], from_hash_entry->xyz[1],
   // from_hash_entry->xyz[2]) << std::endl;
   if (planning_parameters_.use_bfs_)
   {
-    return getBFSCostToGoal(from_hash_entry->xyz[0], from_hash_entry->xyz[1], from_hash_entry->xyz[2]);
+    heuristic = getBFSCostToGoal(from_hash_entry->xyz[0], from_hash_entry->xyz[1], from_hash_entry->xyz[2]);
   }
   else
   {
-    return getJointDistanceIntegerSum(from_hash_entry->angles, to_hash_entry->angles,
-                                      planning_parameters_.joint_motion_primitive_distance_) *
-           JOINT_DIST_MULT;
+    heuristic = getJointDistanceIntegerSum(from_hash_entry->angles, to_hash_entry->angles,
+                                           planning_parameters_.joint_motion_primitive_distance_) *
+                JOINT_DIST_MULT;
+  }
+  if (to_goal)
+  {
+    from_hash_entry->goal_heuristic = heuristic;
   }
+  return heuristic;
   // return getBFSCostToGoal(from_hash_entry->xyz[0], from_hash_entry->xyz[1], from_hash_entry->xyz[2]);
   // else
   //{
@@ -913,21 +966,12 @@ bool EnvironmentChain3D::populateTrajectoryFromStateIDSequence(const std::vector
   }
   if (planning_parameters_.interpolation_distance_ >= planning_parameters_.joint_motion_primitive_distance_)
   {
-    std::map<int, std::map<int, std::vector<std::vector<double> > > >::const_iterator it =
-        generated_interpolations_map_.find(*(state_ids.end() - 2));
+    const std::vector<std::vector<double> >* segment =
+        generated_interpolations_.find(*(state_ids.end() - 2), state_ids.back());
     std::vector<std::vector<double> > end_points;
-    if (it != generated_interpolations_map_.end())
+    if (segment)
     {
-      std::map<int, std::vector<std::vector<double> > >::const_iterator it2 = it->second.find(state_ids.back());
-      if (it2 == it->second.end())
-      {
-        std::cerr << "No interpolated segment connecting state id " << (*state_ids.end() - 2) << " and goal "
-                  << state_ids.back() << std::endl;
-      }
-      else
-      {
-        end_points = it2->second;
-      }
+      end_points = *segment;
     }
     else
     {
@@ -965,28 +1009,17 @@ bool EnvironmentChain3D::populateTrajectoryFromStateIDSequence(const std::vector
       //                                          INTERPOLATION_DISTANCE) << std::endl;
       //}
       traj.points.push_back(statep);
-      std::map<int, std::map<int, std::vector<std::vector<double> > > >::const_iterator it =
-          generated_interpolations_map_.find(state_ids[i]);
-      if (it != generated_interpolations_map_.end())
+      const std::vector<std::vector<double> >* segment = generated_interpolations_.find(state_ids[i], state_ids[i + 1]);
+      if (segment)
       {
-        std::map<int, std::vector<std::vector<double> > >::const_iterator it2 = it->second.find(state_ids[i + 1]);
-        if (it2 == it->second.end())
+        for (unsigned int j = 0; j < segment->size(); j++)
         {
-          std::cerr << "No interpolated segment connecting state id " << state_ids[i] << " and state "
-                    << state_ids[i + 1] << std::endl;
-          continue;
-        }
-        else
-        {
-          for (unsigned int j = 0; j < it2->second.size(); j++)
-          {
-            trajectory_msgs::JointTrajectoryPoint p;
-            p.positions = it2->second[j];
-            // std::cerr << "Interp " << getJointDistanceIntegerMax(traj.points.back().positions,
-            //                                                      p.positions,
-            //                                                      INTERPOLATION_DISTANCE) << std::endl;
-            traj.points.push_back(p);
-          }
+          trajectory_msgs::JointTrajectoryPoint p;
+          p.positions = (*segment)[j];
+          // std::cerr << "Interp " << getJointDistanceIntegerMax(traj.points.back().positions,
+          //                                                      p.positions,
+          //                                                      INTERPOLATION_DISTANCE) << std::endl;
+          traj.points.push_back(p);
         }
       }
       else
@@ -1066,8 +1099,8 @@ bool EnvironmentChain3D::getPlaneBFSMarker(visualization_msgs::Marker& plane_mar
   return true;
 }
 
-bool EnvironmentChain3D::interpolateAndCollisionCheck(const std::vector<double> angles1,
-                                                      const std::vector<double> angles2,
+bool EnvironmentChain3D::interpolateAndCollisionCheck(const std::vector<double>& angles1,
+                                                      const std::vector<double>& angles2,
                                                       std::vector<std::vector<double> >& state_values)
 {
   static bool print_first = false;
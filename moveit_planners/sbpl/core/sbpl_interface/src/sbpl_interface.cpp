@@ -50,7 +50,11 @@ bool SBPLInterface::solve(const planning_scene::PlanningSceneConstPtr& planning_
 
   ros::WallTime wt = ros::WallTime::now();
   boost::shared_ptr<EnvironmentChain3D> env_chain(new EnvironmentChain3D(planning_scene));
-  if (!env_chain->setupForMotionPlan(planning_scene, req, res, params))
+  env_chain->setBFS(bfs_);
+  bool setup = env_chain->setupForMotionPlan(planning_scene, req, res, params);
+  if (env_chain->getBFS())
+    (const_cast<SBPLInterface*>(this))->bfs_ = env_chain->getBFS();
+  if (!setup)
   {
     // std::cerr << "Env chain setup failing" << std::endl;
     return false;
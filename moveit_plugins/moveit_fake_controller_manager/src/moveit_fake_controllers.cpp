@@ -45,8 +45,14 @@ namespace moveit_fake_controller_manager
 {
 BaseFakeController::BaseFakeController(const std::string& name, const std::vector<std::string>& joints,
                                        const ros::Publisher& pub)
-  : moveit_controller_manager::MoveItControllerHandle(name), joints_(joints), pub_(pub)
+  : moveit_controller_manager::MoveItControllerHandle(name), joints_(joints), pub_(pub), time_scale_(1.0)
 {
+  if (ros::param::get("~fake_execution_time_scale", time_scale_) && time_scale_ < 0.0)
+  {
+    ROS_WARN("Negative fake_execution_time_scale %g, executing in real time", time_scale_);
+    time_scale_ = 1.0;
+  }
+
   std::stringstream ss;
   ss << "Fake controller '" << name << "' with joints [ ";
   std::copy(joints.begin(), joints.end(), std::ostream_iterator<std::string>(ss, " "));
@@ -100,7 +106,10 @@ bool LastPointController::cancelExecution()
 
 bool LastPointController::waitForExecution(const ros::Duration&)
 {
-  ros::Duration(0.5).sleep();  // give some time to receive the published JointState
+  // give some time to receive the published JointState
+  // (consumers that need the new state wait for it in the CurrentStateMonitor anyway)
+  if (time_scale_ > 0.0)
+    ros::Duration(0.5 * time_scale_).sleep();
   return true;
 }
 
@@ -178,8 +187,8 @@ void ViaPointController::execTrajectory(const moveit_msgs::RobotTrajectory& t)
     js.velocity = via->velocities;
     js.effort = via->effort;
 
-    ros::Duration waitTime = via->time_from_start - (ros::Time::now() - startTime);
-    if (waitTime.toSec() > std::numeric_limits<float>::epsilon())
+    ros::Duration waitTime = via->time_from_start * time_scale_ - (ros::Time::now() - startTime);
+    if (time_scale_ > 0.0 && waitTime.toSec() > std::numeric_limits<float>::epsilon())
     {
       ROS_DEBUG("Fake execution: waiting %0.1fs for next via point, %ld remaining", waitTime.toSec(), end - via);
       waitTime.sleep();
@@ -196,7 +205,7 @@ InterpolatingController::InterpolatingController(const std::string& name, const
 {
   double r;
   if (ros::param::get("~fake_interpolating_controller_rate", r))
-    rate_ = ros::WallRate(r);
+    rate_ = ros::Rate(r);
 }
 
 InterpolatingController::~InterpolatingController()
@@ -236,10 +245,12 @@ void InterpolatingController::execTrajectory(const moveit_msgs::RobotTrajectory&
       next = points.begin() + 1,  // currently targetted via point
       end = points.end();
 
+  // when executions complete instantly, only the last point is published
   ros::Time startTime = ros::Time::now();
-  while (!cancelled())
+  while (!cancelled() && time_scale_ > 0.0)
   {
-    ros::Duration elapsed = ros::Time::now() - startTime;
+    // elapsed time along the trajectory
+    ros::Duration elapsed = (ros::Time::now() - startTime) * (1.0 / time_scale_);
     // hop to next targetted via point
     while (next != end && elapsed > next->time_from_start)
     {
@@ -267,6 +278,7 @@ void InterpolatingController::execTrajectory(const moveit_msgs::RobotTrajectory&
             next - points.begin(), end - points.begin());
 
   // publish last point
+  prev = end - 1;
   interpolate(js, *prev, *prev, prev->time_from_start);
   js.header.stamp = ros::Time::now();
   pub_.publish(js);
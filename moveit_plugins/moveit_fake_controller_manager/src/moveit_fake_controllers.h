@@ -60,6 +60,10 @@ public:
 protected:
   std::vector<std::string> joints_;
   const ros::Publisher& pub_;
+
+  /// factor applied to the time of trajectories (~fake_execution_time_scale, default 1.0):
+  /// values below 1 execute faster than real time, 0 completes executions instantly
+  double time_scale_;
 };
 
 class LastPointController : public BaseFakeController
@@ -120,7 +124,7 @@ protected:
   virtual void execTrajectory(const moveit_msgs::RobotTrajectory& t);
 
 private:
-  ros::WallRate rate_;
+  ros::Rate rate_;
 };
 }
 
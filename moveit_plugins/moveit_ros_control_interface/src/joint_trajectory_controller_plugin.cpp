@@ -38,12 +38,17 @@
 #include <moveit_ros_control_interface/ControllerHandle.h>
 #include <pluginlib/class_list_macros.h>
 #include <moveit_simple_controller_manager/follow_joint_trajectory_controller_handle.h>
+#include <moveit_simple_controller_manager/joint_trajectory_streaming_controller_handle.h>
+#include <algorithm>
 #include <memory>
 
 namespace moveit_ros_control_interface
 {
 /**
  * \brief Simple allocator for moveit_simple_controller_manager::FollowJointTrajectoryControllerHandle instances.
+ * Controllers listed in the private parameter 'streaming_controllers' are driven through their command topic by
+ * moveit_simple_controller_manager::JointTrajectoryStreamingControllerHandle instances instead, at the rate and
+ * horizon given by 'streaming_rate' and 'streaming_horizon'.
  */
 class JointTrajectoryControllerAllocator : public ControllerHandleAllocator
 {
@@ -51,6 +56,13 @@ public:
   virtual moveit_controller_manager::MoveItControllerHandlePtr alloc(const std::string& name,
                                                                      const std::vector<std::string>& resources)
   {
+    ros::NodeHandle nh("~");
+    std::vector<std::string> streaming_controllers;
+    nh.getParam("streaming_controllers", streaming_controllers);
+    if (std::find(streaming_controllers.begin(), streaming_controllers.end(), name) != streaming_controllers.end())
+      return std::make_shared<moveit_simple_controller_manager::JointTrajectoryStreamingControllerHandle>(
+          name, "command", nh.param("streaming_rate", 100.0), nh.param("streaming_horizon", 0.1));
+
     return std::make_shared<moveit_simple_controller_manager::FollowJointTrajectoryControllerHandle>(
         name, "follow_joint_trajectory");
   }
@@ -41,12 +41,14 @@
 #include <moveit/controller_manager/controller_manager.h>
 #include <actionlib/client/simple_action_client.h>
 #include <moveit/macros/class_forward.h>
+#include <boost/thread/mutex.hpp>
 #include <memory>
 
 namespace moveit_simple_controller_manager
 {
 /*
- * This exist solely to inject addJoint/getJoints into base non-templated class.
+ * This exist solely to inject addJoint/getJoints into base non-templated class, along with the reporting of
+ * completed executions shared by all handles.
  */
 class ActionBasedControllerHandleBase : public moveit_controller_manager::MoveItControllerHandle
 {
@@ -57,6 +59,26 @@ public:
 
   virtual void addJoint(const std::string& name) = 0;
   virtual void getJoints(std::vector<std::string>& joints) = 0;
+
+  virtual bool setExecutionCompleteCallback(const ExecutionCompleteCallback& callback)
+  {
+    boost::mutex::scoped_lock slock(execution_complete_callback_mutex_);
+    execution_complete_callback_ = callback;
+    return true;
+  }
+
+protected:
+  /* called by the handles once done_ is set */
+  void notifyExecutionComplete()
+  {
+    boost::mutex::scoped_lock slock(execution_complete_callback_mutex_);
+    if (execution_complete_callback_)
+      execution_complete_callback_(this);
+  }
+
+private:
+  ExecutionCompleteCallback execution_complete_callback_;
+  boost::mutex execution_complete_callback_mutex_;
 };
 
 MOVEIT_CLASS_FORWARD(ActionBasedControllerHandleBase);
@@ -100,6 +122,7 @@ public:
       controller_action_client_->cancelGoal();
       last_exec_ = moveit_controller_manager::ExecutionStatus::PREEMPTED;
       done_ = true;
+      notifyExecutionComplete();
     }
     return true;
   }
@@ -149,6 +172,7 @@ protected:
     else
       last_exec_ = moveit_controller_manager::ExecutionStatus::FAILED;
     done_ = true;
+    notifyExecutionComplete();
   }
 
   /* execution status */
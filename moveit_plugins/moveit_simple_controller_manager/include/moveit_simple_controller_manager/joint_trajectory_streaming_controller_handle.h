@@ -0,0 +1,222 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_PLUGINS_JOINT_TRAJECTORY_STREAMING_CONTROLLER_HANDLE
+#define MOVEIT_PLUGINS_JOINT_TRAJECTORY_STREAMING_CONTROLLER_HANDLE
+
+#include <moveit_simple_controller_manager/action_based_controller_handle.h>
+#include <trajectory_msgs/JointTrajectory.h>
+#include <boost/thread.hpp>
+#include <ros/ros.h>
+#include <algorithm>
+
+namespace moveit_simple_controller_manager
+{
+/*
+ * Streams trajectories to the command topic of a joint trajectory controller, instead of sending a goal for the whole
+ * trajectory. At a fixed rate, a cursor advances to the last point that is due, and the points from there up to a
+ * short horizon ahead are published whenever a new point enters the horizon. The controller splices each chunk
+ * into the trajectory it executes, so a streamed trajectory can be replaced while it executes, and the controller
+ * holds its position if the stream stops. The command topic reports no result: the execution succeeds once the last
+ * point is due.
+ */
+class JointTrajectoryStreamingControllerHandle : public ActionBasedControllerHandleBase
+{
+public:
+  JointTrajectoryStreamingControllerHandle(const std::string& name, const std::string& command_topic,
+                                           double rate = 100.0, double horizon = 0.1)
+    : ActionBasedControllerHandleBase(name)
+    , period_(1.0 / (rate > 0.0 ? rate : 100.0))
+    , horizon_(horizon)
+    , done_(true)
+    , run_(true)
+    , next_(0)
+    , sent_end_(0)
+  {
+    ros::NodeHandle nh;
+    publisher_ = nh.advertise<trajectory_msgs::JointTrajectory>(
+        command_topic.empty() ? name_ : name_ + "/" + command_topic, 1);
+    last_exec_ = moveit_controller_manager::ExecutionStatus::SUCCEEDED;
+    stream_thread_ = boost::thread(&JointTrajectoryStreamingControllerHandle::streamThread, this);
+  }
+
+  ~JointTrajectoryStreamingControllerHandle()
+  {
+    {
+      boost::mutex::scoped_lock slock(mutex_);
+      run_ = false;
+      condition_.notify_all();
+    }
+    stream_thread_.join();
+  }
+
+  virtual bool sendTrajectory(const moveit_msgs::RobotTrajectory& trajectory)
+  {
+    ROS_DEBUG_STREAM_NAMED("moveit_simple_controller_manager", "Streaming new trajectory to " << name_);
+    if (!trajectory.multi_dof_joint_trajectory.points.empty())
+      ROS_WARN_NAMED("moveit_simple_controller_manager", "%s cannot execute multi-dof trajectories.", name_.c_str());
+
+    boost::mutex::scoped_lock slock(mutex_);
+    trajectory_ = trajectory.joint_trajectory;
+    start_time_ = trajectory_.header.stamp.isZero() ? ros::Time::now() : trajectory_.header.stamp;
+    chunk_.joint_names = trajectory_.joint_names;
+    chunk_.header.stamp = start_time_;
+    next_ = 0;
+    sent_end_ = 0;
+    done_ = trajectory_.points.empty();
+    last_exec_ = done_ ? moveit_controller_manager::ExecutionStatus::SUCCEEDED :
+                         moveit_controller_manager::ExecutionStatus::RUNNING;
+    condition_.notify_all();
+    if (done_)
+      notifyExecutionComplete();
+    return true;
+  }
+
+  virtual bool cancelExecution()
+  {
+    boost::mutex::scoped_lock slock(mutex_);
+    if (!done_)
+    {
+      ROS_INFO_STREAM_NAMED("moveit_simple_controller_manager", "Cancelling execution for " << name_);
+      // an empty trajectory makes the controller hold its current position
+      publisher_.publish(trajectory_msgs::JointTrajectory());
+      last_exec_ = moveit_controller_manager::ExecutionStatus::PREEMPTED;
+      done_ = true;
+      condition_.notify_all();
+      notifyExecutionComplete();
+    }
+    return true;
+  }
+
+  virtual bool waitForExecution(const ros::Duration& timeout = ros::Duration(0))
+  {
+    boost::unique_lock<boost::mutex> ulock(mutex_);
+    const boost::system_time deadline =
+        boost::get_system_time() + boost::posix_time::microseconds((long)(timeout.toSec() * 1e6));
+    while (!done_)
+      if (timeout.isZero())
+        condition_.wait(ulock);
+      else if (!condition_.timed_wait(ulock, deadline))
+        return done_;
+    return true;
+  }
+
+  virtual moveit_controller_manager::ExecutionStatus getLastExecutionStatus()
+  {
+    boost::mutex::scoped_lock slock(mutex_);
+    return last_exec_;
+  }
+
+  virtual void addJoint(const std::string& name)
+  {
+    joints_.push_back(name);
+  }
+
+  virtual void getJoints(std::vector<std::string>& joints)
+  {
+    joints = joints_;
+  }
+
+private:
+  void streamThread()
+  {
+    boost::unique_lock<boost::mutex> ulock(mutex_);
+    while (run_)
+    {
+      if (done_)
+      {
+        condition_.wait(ulock);
+        continue;
+      }
+
+      const std::vector<trajectory_msgs::JointTrajectoryPoint>& points = trajectory_.points;
+      const ros::Duration elapsed = ros::Time::now() - start_time_;
+
+      // the chunk starts at the last point that is due, so the controller interpolates from there
+      while (next_ + 1 < points.size() && points[next_ + 1].time_from_start <= elapsed)
+        ++next_;
+      std::size_t end = sent_end_;
+      while (end < points.size() && points[end].time_from_start <= elapsed + horizon_)
+        ++end;
+      // the controller always needs the point after the one that is due
+      end = std::max(end, std::min(next_ + 2, points.size()));
+
+      // the points reused from the previous chunk keep their memory
+      if (end > sent_end_)
+      {
+        chunk_.points.assign(points.begin() + next_, points.begin() + end);
+        publisher_.publish(chunk_);
+        sent_end_ = end;
+      }
+
+      if (sent_end_ == points.size() && elapsed >= points.back().time_from_start)
+      {
+        last_exec_ = moveit_controller_manager::ExecutionStatus::SUCCEEDED;
+        done_ = true;
+        condition_.notify_all();
+        notifyExecutionComplete();
+        continue;
+      }
+      condition_.timed_wait(ulock, boost::posix_time::microseconds((long)(period_ * 1e6)));
+    }
+  }
+
+  /* streaming rate and horizon */
+  double period_;
+  ros::Duration horizon_;
+
+  /* execution status */
+  moveit_controller_manager::ExecutionStatus last_exec_;
+  bool done_;
+  bool run_;
+
+  /* the trajectory being streamed, the first point of the chunk and the end of the points sent so far */
+  trajectory_msgs::JointTrajectory trajectory_;
+  ros::Time start_time_;
+  std::size_t next_;
+  std::size_t sent_end_;
+  trajectory_msgs::JointTrajectory chunk_;
+
+  /* the joints controlled by this controller */
+  std::vector<std::string> joints_;
+
+  ros::Publisher publisher_;
+  boost::mutex mutex_;
+  boost::condition_variable condition_;
+  boost::thread stream_thread_;
+};
+
+}  // end namespace moveit_simple_controller_manager
+
+#endif  // MOVEIT_PLUGINS_JOINT_TRAJECTORY_STREAMING_CONTROLLER_HANDLE
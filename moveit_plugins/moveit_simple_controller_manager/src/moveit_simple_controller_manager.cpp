@@ -39,6 +39,7 @@
 #include <moveit_simple_controller_manager/action_based_controller_handle.h>
 #include <moveit_simple_controller_manager/gripper_controller_handle.h>
 #include <moveit_simple_controller_manager/follow_joint_trajectory_controller_handle.h>
+#include <moveit_simple_controller_manager/joint_trajectory_streaming_controller_handle.h>
 #include <pluginlib/class_list_macros.h>
 #include <algorithm>
 #include <map>
@@ -146,6 +147,21 @@ public:
             controllers_[name] = new_handle;
           }
         }
+        else if (type == "JointTrajectoryStreaming")
+        {
+          std::string command_topic = "command";
+          if (controller_list[i].hasMember("command_topic"))
+            command_topic = std::string(controller_list[i]["command_topic"]);
+          double rate = 100.0;
+          if (controller_list[i].hasMember("stream_rate"))
+            rate = double(controller_list[i]["stream_rate"]);
+          double horizon = 0.1;
+          if (controller_list[i].hasMember("stream_horizon"))
+            horizon = double(controller_list[i]["stream_horizon"]);
+          new_handle.reset(new JointTrajectoryStreamingControllerHandle(name, command_topic, rate, horizon));
+          ROS_INFO_STREAM_NAMED("manager", "Added JointTrajectoryStreaming controller for " << name);
+          controllers_[name] = new_handle;
+        }
         else
         {
           ROS_ERROR_STREAM_NAMED("manager", "Unknown controller type: " << type.c_str());
@@ -38,6 +38,7 @@
 #define MOVEIT_ROS_BENCHMARKS_BENCHMARK_EXECUTOR_
 
 #include <moveit/benchmarks/BenchmarkOptions.h>
+#include <moveit/benchmarks/BenchmarkScenario.h>
 
 #include <moveit/planning_scene_monitor/planning_scene_monitor.h>
 
@@ -50,10 +51,14 @@
 #include <warehouse_ros/database_loader.h>
 #include <pluginlib/class_loader.h>
 
+#include <ctime>
 #include <map>
 #include <vector>
 #include <string>
 #include <boost/function.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/progress.hpp>
+#include <atomic>
 #include <memory>
 
 namespace moveit_ros_benchmarks
@@ -87,6 +92,8 @@ public:
       PlannerCompletionEventFunction;
 
   /// Definition of a pre-run benchmark event function.  Invoked immediately before each planner calls solve().
+  /// When runs execute concurrently (see BenchmarkOptions::getNumThreads()), pre-run and post-run events are called
+  /// from the worker threads, but never concurrently with each other.
   typedef boost::function<void(moveit_msgs::MotionPlanRequest& request)> PreRunEventFunction;
 
   /// Definition of a post-run benchmark event function.  Invoked immediately after each planner calls solve().
@@ -156,6 +163,25 @@ protected:
   bool queriesAndPlannersCompatible(const std::vector<BenchmarkRequest>& requests,
                                     const std::map<std::string, std::vector<std::string>>& planners);
 
+  /// Connect to the warehouse named in \e opts
+  bool connectToWarehouse(const BenchmarkOptions& opts);
+
+  /// Read the scenario file named in \e opts (reusing the last read, if the file did not change since) and select the
+  /// states, constraints and queries whose names match the regular expressions of \e opts
+  bool loadScenario(const BenchmarkOptions& opts, moveit_msgs::PlanningScene& scene_msg,
+                    std::vector<StartState>& start_states, std::vector<PathConstraints>& goal_constraints,
+                    std::vector<PathConstraints>& path_constraints,
+                    std::vector<TrajectoryConstraints>& traj_constraints, std::vector<BenchmarkRequest>& queries);
+
+  /// Write the given benchmark inputs to the scenario file \e filename, so that they can be benchmarked again without
+  /// the warehouse
+  bool exportScenario(const std::string& filename, const std::string& scene_name,
+                      const moveit_msgs::PlanningScene& scene_msg, const std::vector<StartState>& start_states,
+                      const std::vector<PathConstraints>& goal_constraints,
+                      const std::vector<PathConstraints>& path_constraints,
+                      const std::vector<TrajectoryConstraints>& traj_constraints,
+                      const std::vector<BenchmarkRequest>& queries);
+
   /// Load the planning scene with the given name from the warehouse
   bool loadPlanningScene(const std::string& scene_name, moveit_msgs::PlanningScene& scene_msg);
 
@@ -180,6 +206,22 @@ protected:
   void runBenchmark(moveit_msgs::MotionPlanRequest request,
                     const std::map<std::string, std::vector<std::string>>& planners, int runs);
 
+  /// Same as runBenchmark(), but distributes the runs over \e threads worker threads. Each worker plans in its own
+  /// copy of the planning scene with its own planning contexts; results are stored in the same order as the
+  /// sequential execution, so the output does not depend on scheduling.
+  void runBenchmarkParallel(moveit_msgs::MotionPlanRequest request,
+                            const std::map<std::string, std::vector<std::string>>& planners, int runs,
+                            unsigned int threads);
+
+  /// (plugin, planner id) pairs, in the order of the benchmark output
+  typedef std::vector<std::pair<std::string, std::string>> PlannerConfigurations;
+
+  /// Thread function of runBenchmarkParallel(): executes runs until all \e runs runs of every configuration in
+  /// \e configs have been claimed through \e next
+  void runBenchmarkWorker(unsigned int worker, const PlannerConfigurations& configs,
+                          const std::vector<moveit_msgs::MotionPlanRequest>& requests, int runs,
+                          std::atomic<std::size_t>* next, boost::progress_display* progress, boost::mutex* lock);
+
   planning_scene_monitor::PlanningSceneMonitor* psm_;
   moveit_warehouse::PlanningSceneStorage* pss_;
   moveit_warehouse::PlanningSceneWorldStorage* psws_;
@@ -197,6 +239,9 @@ protected:
 
   std::vector<PlannerBenchmarkData> benchmark_data_;
 
+  /// The scenarios read so far, with the modification time of their file
+  std::map<std::string, std::pair<std::time_t, BenchmarkScenarioConstPtr>> scenarios_;
+
   std::vector<PreRunEventFunction> pre_event_fns_;
   std::vector<PostRunEventFunction> post_event_fns_;
   std::vector<PlannerStartEventFunction> planner_start_fns_;
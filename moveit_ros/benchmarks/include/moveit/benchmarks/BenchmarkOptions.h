@@ -59,6 +59,10 @@ public:
   const std::string& getSceneName() const;
 
   int getNumRuns() const;
+  /// Number of runs executed concurrently; 1 runs them sequentially, 0 uses one thread per core
+  int getNumThreads() const;
+  /// Whether each benchmark thread is pinned to its own CPU, for more accurate timing of concurrent runs
+  bool getPinThreads() const;
   double getTimeout() const;
   const std::string& getBenchmarkName() const;
   const std::string& getGroupName() const;
@@ -68,6 +72,10 @@ public:
   const std::string& getGoalConstraintRegex() const;
   const std::string& getPathConstraintRegex() const;
   const std::string& getTrajectoryConstraintRegex() const;
+  /// The benchmark scenario file to read the scene, queries, states and constraints from instead of the warehouse
+  const std::string& getScenarioFile() const;
+  /// The file to write the scene, queries, states and constraints loaded from the warehouse to, as a scenario
+  const std::string& getScenarioExportFile() const;
   void getGoalOffsets(std::vector<double>& offsets) const;
   const std::map<std::string, std::vector<std::string>>& getPlannerConfigurations() const;
   void getPlannerPluginList(std::vector<std::string>& plugin_list) const;
@@ -92,6 +100,8 @@ protected:
 
   /// benchmark parameters
   int runs_;
+  int threads_;
+  bool pin_threads_;
   double timeout_;
   std::string benchmark_name_;
   std::string group_name_;
@@ -101,6 +111,8 @@ protected:
   std::string goal_constraint_regex_;
   std::string path_constraint_regex_;
   std::string trajectory_constraint_regex_;
+  std::string scenario_file_;
+  std::string scenario_export_file_;
   double goal_offsets[6];
 
   /// planner configurations
@@ -0,0 +1,87 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_ROS_BENCHMARKS_BENCHMARK_SCENARIO_
+#define MOVEIT_ROS_BENCHMARKS_BENCHMARK_SCENARIO_
+
+#include <moveit_msgs/PlanningScene.h>
+#include <moveit_msgs/MotionPlanRequest.h>
+#include <moveit_msgs/RobotState.h>
+#include <moveit_msgs/Constraints.h>
+#include <moveit_msgs/TrajectoryConstraints.h>
+#include <boost/shared_ptr.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace moveit_ros_benchmarks
+{
+/// A self-contained benchmark suite: one planning scene, with the queries, start states, constraints and trajectory
+/// constraints that can be combined with it, in the form they are stored in the warehouse.
+///
+/// On disk, a scenario (bundle) is the magic string "MOVEIT_BENCHMARK_SCENARIO", a uint32 format version and then a
+/// sequence of records. Each record is a uint8 type, a uint32-length-prefixed name and a uint32-length-prefixed ROS
+/// serialization of the message; integers are in host byte order. The entries of a file are deserialized in parallel.
+class BenchmarkScenario
+{
+public:
+  template <typename T>
+  struct Entry
+  {
+    std::string name;
+    T message;
+  };
+
+  BenchmarkScenario();
+
+  /// Read the scenario stored in \e filename, deserializing on \e threads threads (0 uses one thread per core)
+  bool load(const std::string& filename, unsigned int threads = 0);
+
+  /// Write the scenario to \e filename
+  bool save(const std::string& filename) const;
+
+  std::string scene_name;
+  moveit_msgs::PlanningScene scene;
+  std::vector<Entry<moveit_msgs::MotionPlanRequest> > queries;
+  std::vector<Entry<moveit_msgs::RobotState> > start_states;
+  std::vector<Entry<moveit_msgs::Constraints> > constraints;
+  std::vector<Entry<moveit_msgs::TrajectoryConstraints> > trajectory_constraints;
+};
+
+typedef boost::shared_ptr<BenchmarkScenario> BenchmarkScenarioPtr;
+typedef boost::shared_ptr<const BenchmarkScenario> BenchmarkScenarioConstPtr;
+}
+
+#endif
@@ -43,7 +43,14 @@
 #include <boost/math/constants/constants.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
+#include <set>
 #include <unistd.h>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 using namespace moveit_ros_benchmarks;
 
@@ -61,6 +68,20 @@ static std::string getHostname()
   }
 }
 
+static void pinThreadToCpu(unsigned int cpu)
+{
+#ifdef __linux__
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  CPU_SET(cpu, &cpus);
+  int err = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+  if (err != 0)
+    ROS_WARN("Unable to pin benchmark thread to CPU %u (error %d)", cpu, err);
+#else
+  ROS_WARN_ONCE("Pinning benchmark threads to CPUs is only supported on Linux");
+#endif
+}
+
 BenchmarkExecutor::BenchmarkExecutor(const std::string& robot_description_param)
 {
   pss_ = NULL;
@@ -287,30 +308,6 @@ bool BenchmarkExecutor::initializeBenchmarks(const BenchmarkOptions& opts, movei
   if (!plannerConfigurationsExist(opts.getPlannerConfigurations(), opts.getGroupName()))
     return false;
 
-  try
-  {
-    warehouse_ros::DatabaseConnection::Ptr conn = dbloader.loadDatabase();
-    conn->setParams(opts.getHostName(), opts.getPort(), 20);
-    if (conn->connect())
-    {
-      pss_ = new moveit_warehouse::PlanningSceneStorage(conn);
-      psws_ = new moveit_warehouse::PlanningSceneWorldStorage(conn);
-      rs_ = new moveit_warehouse::RobotStateStorage(conn);
-      cs_ = new moveit_warehouse::ConstraintsStorage(conn);
-      tcs_ = new moveit_warehouse::TrajectoryConstraintsStorage(conn);
-    }
-    else
-    {
-      ROS_ERROR("Failed to connect to DB");
-      return false;
-    }
-  }
-  catch (std::exception& e)
-  {
-    ROS_ERROR("Failed to initialize benchmark server: '%s'", e.what());
-    return false;
-  }
-
   std::vector<StartState> start_states;
   std::vector<PathConstraints> path_constraints;
   std::vector<PathConstraints> goal_constraints;
@@ -319,11 +316,21 @@ bool BenchmarkExecutor::initializeBenchmarks(const BenchmarkOptions& opts, movei
 
   const std::string& group_name = opts.getGroupName();
 
-  bool ok = loadPlanningScene(opts.getSceneName(), scene_msg) && loadStates(opts.getStartStateRegex(), start_states) &&
-            loadPathConstraints(opts.getGoalConstraintRegex(), goal_constraints) &&
-            loadPathConstraints(opts.getPathConstraintRegex(), path_constraints) &&
-            loadTrajectoryConstraints(opts.getTrajectoryConstraintRegex(), traj_constraints) &&
-            loadQueries(opts.getQueryRegex(), opts.getSceneName(), queries);
+  bool ok;
+  if (!opts.getScenarioFile().empty())
+    ok = loadScenario(opts, scene_msg, start_states, goal_constraints, path_constraints, traj_constraints, queries);
+  else
+  {
+    ok = connectToWarehouse(opts) && loadPlanningScene(opts.getSceneName(), scene_msg) &&
+         loadStates(opts.getStartStateRegex(), start_states) &&
+         loadPathConstraints(opts.getGoalConstraintRegex(), goal_constraints) &&
+         loadPathConstraints(opts.getPathConstraintRegex(), path_constraints) &&
+         loadTrajectoryConstraints(opts.getTrajectoryConstraintRegex(), traj_constraints) &&
+         loadQueries(opts.getQueryRegex(), opts.getSceneName(), queries);
+    if (ok && !opts.getScenarioExportFile().empty())
+      exportScenario(opts.getScenarioExportFile(), opts.getSceneName(), scene_msg, start_states, goal_constraints,
+                     path_constraints, traj_constraints, queries);
+  }
 
   if (!ok)
   {
@@ -558,6 +565,195 @@ bool BenchmarkExecutor::plannerConfigurationsExist(const std::map<std::string, s
   return true;
 }
 
+bool BenchmarkExecutor::connectToWarehouse(const BenchmarkOptions& opts)
+{
+  if (pss_)
+    return true;
+  try
+  {
+    warehouse_ros::DatabaseConnection::Ptr conn = dbloader.loadDatabase();
+    conn->setParams(opts.getHostName(), opts.getPort(), 20);
+    if (conn->connect())
+    {
+      pss_ = new moveit_warehouse::PlanningSceneStorage(conn);
+      psws_ = new moveit_warehouse::PlanningSceneWorldStorage(conn);
+      rs_ = new moveit_warehouse::RobotStateStorage(conn);
+      cs_ = new moveit_warehouse::ConstraintsStorage(conn);
+      tcs_ = new moveit_warehouse::TrajectoryConstraintsStorage(conn);
+    }
+    else
+    {
+      ROS_ERROR("Failed to connect to DB");
+      return false;
+    }
+  }
+  catch (std::exception& e)
+  {
+    ROS_ERROR("Failed to initialize benchmark server: '%s'", e.what());
+    return false;
+  }
+  return true;
+}
+
+namespace
+{
+/// Select the entries of \e entries whose names match \e regex; an empty expression selects nothing
+template <typename T>
+std::vector<const moveit_ros_benchmarks::BenchmarkScenario::Entry<T>*>
+selectEntries(const std::vector<moveit_ros_benchmarks::BenchmarkScenario::Entry<T>>& entries, const std::string& regex)
+{
+  std::vector<const moveit_ros_benchmarks::BenchmarkScenario::Entry<T>*> selected;
+  if (regex.empty())
+    return selected;
+  boost::regex expression(regex);
+  for (std::size_t i = 0; i < entries.size(); ++i)
+    if (boost::regex_match(entries[i].name, expression))
+      selected.push_back(&entries[i]);
+  return selected;
+}
+}
+
+bool BenchmarkExecutor::loadScenario(const BenchmarkOptions& opts, moveit_msgs::PlanningScene& scene_msg,
+                                     std::vector<StartState>& start_states,
+                                     std::vector<PathConstraints>& goal_constraints,
+                                     std::vector<PathConstraints>& path_constraints,
+                                     std::vector<TrajectoryConstraints>& traj_constraints,
+                                     std::vector<BenchmarkRequest>& queries)
+{
+  const std::string& filename = opts.getScenarioFile();
+  boost::system::error_code ec;
+  std::time_t modified = boost::filesystem::last_write_time(filename, ec);
+  if (ec)
+  {
+    ROS_ERROR("Unable to access benchmark scenario '%s': %s", filename.c_str(), ec.message().c_str());
+    return false;
+  }
+
+  BenchmarkScenarioConstPtr scenario;
+  if (scenarios_.count(filename) && scenarios_[filename].first == modified)
+    scenario = scenarios_[filename].second;
+  else
+  {
+    BenchmarkScenarioPtr loaded(new BenchmarkScenario());
+    if (!loaded->load(filename))
+      return false;
+    scenarios_[filename] = std::make_pair(modified, loaded);
+    scenario = loaded;
+  }
+
+  if (!opts.getSceneName().empty() && opts.getSceneName() != scenario->scene_name)
+    ROS_WARN("Benchmark scenario '%s' contains scene '%s', not '%s'", filename.c_str(), scenario->scene_name.c_str(),
+             opts.getSceneName().c_str());
+  scene_msg = scenario->scene;
+
+  try
+  {
+    std::vector<const BenchmarkScenario::Entry<moveit_msgs::RobotState>*> states =
+        selectEntries(scenario->start_states, opts.getStartStateRegex());
+    for (std::size_t i = 0; i < states.size(); ++i)
+    {
+      StartState start_state;
+      start_state.name = states[i]->name;
+      start_state.state = states[i]->message;
+      start_states.push_back(start_state);
+    }
+
+    const std::string* regex[] = { &opts.getGoalConstraintRegex(), &opts.getPathConstraintRegex() };
+    std::vector<PathConstraints>* selected[] = { &goal_constraints, &path_constraints };
+    for (std::size_t k = 0; k < 2; ++k)
+    {
+      std::vector<const BenchmarkScenario::Entry<moveit_msgs::Constraints>*> constraints =
+          selectEntries(scenario->constraints, *regex[k]);
+      for (std::size_t i = 0; i < constraints.size(); ++i)
+      {
+        PathConstraints constraint;
+        constraint.name = constraints[i]->name;
+        constraint.constraints.push_back(constraints[i]->message);
+        selected[k]->push_back(constraint);
+      }
+    }
+
+    std::vector<const BenchmarkScenario::Entry<moveit_msgs::TrajectoryConstraints>*> trajectory_constraints =
+        selectEntries(scenario->trajectory_constraints, opts.getTrajectoryConstraintRegex());
+    for (std::size_t i = 0; i < trajectory_constraints.size(); ++i)
+    {
+      TrajectoryConstraints constraint;
+      constraint.name = trajectory_constraints[i]->name;
+      constraint.constraints = trajectory_constraints[i]->message;
+      traj_constraints.push_back(constraint);
+    }
+
+    std::vector<const BenchmarkScenario::Entry<moveit_msgs::MotionPlanRequest>*> requests =
+        selectEntries(scenario->queries, opts.getQueryRegex());
+    for (std::size_t i = 0; i < requests.size(); ++i)
+    {
+      BenchmarkRequest query;
+      query.name = requests[i]->name;
+      query.request = requests[i]->message;
+      queries.push_back(query);
+    }
+  }
+  catch (boost::regex_error& ex)
+  {
+    ROS_ERROR("Invalid regular expression for benchmark scenario '%s': %s", filename.c_str(), ex.what());
+    return false;
+  }
+  return true;
+}
+
+bool BenchmarkExecutor::exportScenario(const std::string& filename, const std::string& scene_name,
+                                       const moveit_msgs::PlanningScene& scene_msg,
+                                       const std::vector<StartState>& start_states,
+                                       const std::vector<PathConstraints>& goal_constraints,
+                                       const std::vector<PathConstraints>& path_constraints,
+                                       const std::vector<TrajectoryConstraints>& traj_constraints,
+                                       const std::vector<BenchmarkRequest>& queries)
+{
+  BenchmarkScenario scenario;
+  scenario.scene_name = scene_name;
+  scenario.scene = scene_msg;
+
+  scenario.start_states.resize(start_states.size());
+  for (std::size_t i = 0; i < start_states.size(); ++i)
+  {
+    scenario.start_states[i].name = start_states[i].name;
+    scenario.start_states[i].message = start_states[i].state;
+  }
+
+  // goal and path constraints come from the same storage; store each once
+  std::set<std::string> constraint_names;
+  const std::vector<PathConstraints>* constraints[] = { &goal_constraints, &path_constraints };
+  for (std::size_t k = 0; k < 2; ++k)
+    for (std::size_t i = 0; i < constraints[k]->size(); ++i)
+    {
+      const PathConstraints& c = (*constraints[k])[i];
+      if (c.constraints.empty() || !constraint_names.insert(c.name).second)
+        continue;
+      scenario.constraints.resize(scenario.constraints.size() + 1);
+      scenario.constraints.back().name = c.name;
+      scenario.constraints.back().message = c.constraints[0];
+    }
+
+  scenario.trajectory_constraints.resize(traj_constraints.size());
+  for (std::size_t i = 0; i < traj_constraints.size(); ++i)
+  {
+    scenario.trajectory_constraints[i].name = traj_constraints[i].name;
+    scenario.trajectory_constraints[i].message = traj_constraints[i].constraints;
+  }
+
+  scenario.queries.resize(queries.size());
+  for (std::size_t i = 0; i < queries.size(); ++i)
+  {
+    scenario.queries[i].name = queries[i].name;
+    scenario.queries[i].message = queries[i].request;
+  }
+
+  if (!scenario.save(filename))
+    return false;
+  ROS_INFO("Wrote the benchmark inputs to scenario '%s'", filename.c_str());
+  return true;
+}
+
 bool BenchmarkExecutor::loadPlanningScene(const std::string& scene_name, moveit_msgs::PlanningScene& scene_msg)
 {
   bool ok = false;
@@ -753,6 +949,17 @@ void BenchmarkExecutor::runBenchmark(moveit_msgs::MotionPlanRequest request,
 {
   benchmark_data_.clear();
 
+  if (options_.getNumThreads() != 1)
+  {
+    unsigned int threads =
+        options_.getNumThreads() > 0 ? options_.getNumThreads() : boost::thread::hardware_concurrency();
+    if (threads > 1)
+    {
+      runBenchmarkParallel(request, planners, runs, threads);
+      return;
+    }
+  }
+
   unsigned int num_planners = 0;
   for (std::map<std::string, std::vector<std::string>>::const_iterator it = planners.begin(); it != planners.end();
        ++it)
@@ -812,6 +1019,98 @@ void BenchmarkExecutor::runBenchmark(moveit_msgs::MotionPlanRequest request,
   }
 }
 
+void BenchmarkExecutor::runBenchmarkParallel(moveit_msgs::MotionPlanRequest request,
+                                             const std::map<std::string, std::vector<std::string>>& planners, int runs,
+                                             unsigned int threads)
+{
+  // Flatten the planners in the order in which runBenchmark() visits them
+  PlannerConfigurations configs;
+  for (std::map<std::string, std::vector<std::string>>::const_iterator it = planners.begin(); it != planners.end();
+       ++it)
+    for (std::size_t i = 0; i < it->second.size(); ++i)
+      configs.push_back(std::make_pair(it->first, it->second[i]));
+
+  benchmark_data_.assign(configs.size(), PlannerBenchmarkData(runs));
+  std::vector<moveit_msgs::MotionPlanRequest> requests(configs.size(), request);
+  for (std::size_t i = 0; i < configs.size(); ++i)
+  {
+    requests[i].planner_id = configs[i].second;
+
+    // Planner start events
+    for (std::size_t j = 0; j < planner_start_fns_.size(); ++j)
+      planner_start_fns_[j](requests[i], benchmark_data_[i]);
+  }
+
+  const std::size_t total_runs = configs.size() * runs;
+  if (threads > total_runs)
+    threads = total_runs;
+  ROS_INFO("Executing %lu runs on %u threads", total_runs, threads);
+
+  boost::progress_display progress(total_runs, std::cout);
+  boost::mutex lock;
+  std::atomic<std::size_t> next(0);
+  boost::thread_group workers;
+  for (unsigned int i = 0; i < threads; ++i)
+    workers.create_thread(boost::bind(&BenchmarkExecutor::runBenchmarkWorker, this, i, boost::cref(configs),
+                                      boost::cref(requests), runs, &next, &progress, &lock));
+  workers.join_all();
+
+  // Planner completion events
+  for (std::size_t i = 0; i < configs.size(); ++i)
+    for (std::size_t j = 0; j < planner_completion_fns_.size(); ++j)
+      planner_completion_fns_[j](requests[i], benchmark_data_[i]);
+}
+
+void BenchmarkExecutor::runBenchmarkWorker(unsigned int worker, const PlannerConfigurations& configs,
+                                           const std::vector<moveit_msgs::MotionPlanRequest>& requests, int runs,
+                                           std::atomic<std::size_t>* next, boost::progress_display* progress,
+                                           boost::mutex* lock)
+{
+  if (options_.getPinThreads())
+    pinThreadToCpu(worker % std::max(1u, boost::thread::hardware_concurrency()));
+
+  // A private scene, so that planners caching state in the scene they plan in do not share it across threads
+  planning_scene::PlanningScenePtr scene = planning_scene::PlanningScene::clone(planning_scene_);
+  std::vector<planning_interface::PlanningContextPtr> contexts(configs.size());
+
+  const std::size_t total_runs = configs.size() * runs;
+  for (std::size_t k = next->fetch_add(1); k < total_runs; k = next->fetch_add(1))
+  {
+    const std::size_t c = k / runs;
+    const std::size_t j = k % runs;
+    PlannerRunData& run_data = benchmark_data_[c][j];
+    moveit_msgs::MotionPlanRequest request = requests[c];
+
+    {
+      boost::mutex::scoped_lock slock(*lock);
+      if (!contexts[c])
+        contexts[c] = planner_interfaces_[configs[c].first]->getPlanningContext(scene, request);
+
+      // Pre-run events
+      for (std::size_t i = 0; i < pre_event_fns_.size(); ++i)
+        pre_event_fns_[i](request);
+    }
+
+    // Solve problem
+    planning_interface::MotionPlanDetailedResponse mp_res;
+    ros::WallTime start = ros::WallTime::now();
+    bool solved = contexts[c]->solve(mp_res);
+    double total_time = (ros::WallTime::now() - start).toSec();
+
+    {
+      boost::mutex::scoped_lock slock(*lock);
+
+      // Post-run events
+      for (std::size_t i = 0; i < post_event_fns_.size(); ++i)
+        post_event_fns_[i](request, mp_res, run_data);
+    }
+    collectMetrics(run_data, mp_res, solved, total_time);
+
+    boost::mutex::scoped_lock slock(*lock);
+    ++(*progress);
+  }
+}
+
 void BenchmarkExecutor::collectMetrics(PlannerRunData& metrics,
                                        const planning_interface::MotionPlanDetailedResponse& mp_res, bool solved,
                                        double total_time)
@@ -819,6 +1118,11 @@ void BenchmarkExecutor::collectMetrics(PlannerRunData& metrics,
   metrics["time REAL"] = boost::lexical_cast<std::string>(total_time);
   metrics["solved BOOLEAN"] = boost::lexical_cast<std::string>(solved);
 
+  // counters reported by the planner, e.g. the hits of the OMPL state validity cache
+  for (std::map<std::string, double>::const_iterator it = mp_res.statistics_.begin(); it != mp_res.statistics_.end();
+       ++it)
+    metrics[it->first + " REAL"] = boost::lexical_cast<std::string>(it->second);
+
   if (solved)
   {
     // Analyzing the trajectory(ies) geometrically
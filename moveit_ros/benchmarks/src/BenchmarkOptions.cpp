@@ -93,6 +93,16 @@ int BenchmarkOptions::getNumRuns() const
   return runs_;
 }
 
+int BenchmarkOptions::getNumThreads() const
+{
+  return threads_;
+}
+
+bool BenchmarkOptions::getPinThreads() const
+{
+  return pin_threads_;
+}
+
 double BenchmarkOptions::getTimeout() const
 {
   return timeout_;
@@ -138,6 +148,16 @@ const std::string& BenchmarkOptions::getTrajectoryConstraintRegex() const
   return trajectory_constraint_regex_;
 }
 
+const std::string& BenchmarkOptions::getScenarioFile() const
+{
+  return scenario_file_;
+}
+
+const std::string& BenchmarkOptions::getScenarioExportFile() const
+{
+  return scenario_export_file_;
+}
+
 void BenchmarkOptions::getGoalOffsets(std::vector<double>& offsets) const
 {
   offsets.resize(6);
@@ -184,6 +204,8 @@ void BenchmarkOptions::readBenchmarkParameters(ros::NodeHandle& nh)
 {
   nh.param(std::string("benchmark_config/parameters/name"), benchmark_name_, std::string(""));
   nh.param(std::string("benchmark_config/parameters/runs"), runs_, 10);
+  nh.param(std::string("benchmark_config/parameters/threads"), threads_, 1);
+  nh.param(std::string("benchmark_config/parameters/pin_threads"), pin_threads_, false);
   nh.param(std::string("benchmark_config/parameters/timeout"), timeout_, 10.0);
   nh.param(std::string("benchmark_config/parameters/output_directory"), output_directory_, std::string(""));
   nh.param(std::string("benchmark_config/parameters/queries"), query_regex_, std::string(".*"));
@@ -192,6 +214,8 @@ void BenchmarkOptions::readBenchmarkParameters(ros::NodeHandle& nh)
   nh.param(std::string("benchmark_config/parameters/path_constraints"), path_constraint_regex_, std::string(""));
   nh.param(std::string("benchmark_config/parameters/trajectory_constraints"), trajectory_constraint_regex_,
            std::string(""));
+  nh.param(std::string("benchmark_config/parameters/scenario_file"), scenario_file_, std::string(""));
+  nh.param(std::string("benchmark_config/parameters/export_scenario_file"), scenario_export_file_, std::string(""));
 
   if (!nh.getParam(std::string("benchmark_config/parameters/group"), group_name_))
     ROS_WARN("Benchmark group NOT specified");
@@ -0,0 +1,336 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/benchmarks/BenchmarkScenario.h>
+#include <ros/console.h>
+#include <ros/serialization.h>
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+using namespace moveit_ros_benchmarks;
+
+namespace
+{
+const char MAGIC[] = "MOVEIT_BENCHMARK_SCENARIO";
+const uint32_t VERSION = 1;
+
+enum RecordType
+{
+  SCENE = 0,
+  QUERY = 1,
+  START_STATE = 2,
+  CONSTRAINTS = 3,
+  TRAJECTORY_CONSTRAINTS = 4
+};
+
+/// Where the serialized message of a record is in the file, and which entry it is deserialized into
+struct Record
+{
+  uint8_t type;
+  std::size_t index;
+  std::size_t offset;
+  uint32_t length;
+};
+
+void writeUInt32(std::ostream& out, uint32_t value)
+{
+  out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void writeString(std::ostream& out, const std::string& s)
+{
+  writeUInt32(out, s.size());
+  out.write(s.data(), s.size());
+}
+
+template <typename T>
+void writeRecord(std::ostream& out, RecordType type, const std::string& name, const T& message)
+{
+  uint32_t length = ros::serialization::serializationLength(message);
+  std::vector<uint8_t> buffer(length);
+  ros::serialization::OStream stream(buffer.data(), length);
+  ros::serialization::serialize(stream, message);
+
+  const uint8_t t = type;
+  out.write(reinterpret_cast<const char*>(&t), sizeof(t));
+  writeString(out, name);
+  writeUInt32(out, length);
+  out.write(reinterpret_cast<const char*>(buffer.data()), length);
+}
+
+template <typename T>
+void writeRecords(std::ostream& out, RecordType type, const std::vector<BenchmarkScenario::Entry<T> >& entries)
+{
+  for (std::size_t i = 0; i < entries.size(); ++i)
+    writeRecord(out, type, entries[i].name, entries[i].message);
+}
+
+/// Sequential reader of the raw bytes of a scenario file
+class Reader
+{
+public:
+  Reader(const std::vector<uint8_t>& data) : data_(data), offset_(0)
+  {
+  }
+
+  bool done() const
+  {
+    return offset_ == data_.size();
+  }
+
+  std::size_t offset() const
+  {
+    return offset_;
+  }
+
+  bool read(void* value, std::size_t size)
+  {
+    if (data_.size() - offset_ < size)
+      return false;
+    memcpy(value, &data_[offset_], size);
+    offset_ += size;
+    return true;
+  }
+
+  bool readString(std::string& s)
+  {
+    uint32_t size;
+    if (!read(&size, sizeof(size)) || data_.size() - offset_ < size)
+      return false;
+    s.assign(reinterpret_cast<const char*>(&data_[offset_]), size);
+    offset_ += size;
+    return true;
+  }
+
+  bool skip(std::size_t size)
+  {
+    if (data_.size() - offset_ < size)
+      return false;
+    offset_ += size;
+    return true;
+  }
+
+private:
+  const std::vector<uint8_t>& data_;
+  std::size_t offset_;
+};
+
+template <typename T>
+void deserialize(std::vector<uint8_t>& data, const Record& record, T& message)
+{
+  ros::serialization::IStream stream(data.data() + record.offset, record.length);
+  ros::serialization::deserialize(stream, message);
+}
+
+void deserializeRecords(BenchmarkScenario* scenario, std::vector<uint8_t>* data, const std::vector<Record>* records,
+                        std::atomic<std::size_t>* next, std::atomic<bool>* failed)
+{
+  for (std::size_t i = next->fetch_add(1); i < records->size(); i = next->fetch_add(1))
+  {
+    const Record& record = (*records)[i];
+    try
+    {
+      switch (record.type)
+      {
+        case SCENE:
+          deserialize(*data, record, scenario->scene);
+          break;
+        case QUERY:
+          deserialize(*data, record, scenario->queries[record.index].message);
+          break;
+        case START_STATE:
+          deserialize(*data, record, scenario->start_states[record.index].message);
+          break;
+        case CONSTRAINTS:
+          deserialize(*data, record, scenario->constraints[record.index].message);
+          break;
+        case TRAJECTORY_CONSTRAINTS:
+          deserialize(*data, record, scenario->trajectory_constraints[record.index].message);
+          break;
+      }
+    }
+    catch (ros::Exception& ex)
+    {
+      ROS_ERROR("Unable to deserialize benchmark scenario record %lu: %s", i, ex.what());
+      *failed = true;
+    }
+  }
+}
+}
+
+BenchmarkScenario::BenchmarkScenario()
+{
+}
+
+bool BenchmarkScenario::load(const std::string& filename, unsigned int threads)
+{
+  std::ifstream in(filename.c_str(), std::ios::binary);
+  if (!in.good())
+  {
+    ROS_ERROR("Unable to open benchmark scenario '%s'", filename.c_str());
+    return false;
+  }
+  std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+  // Index the records; the names are read here, the messages in parallel below
+  Reader reader(data);
+  char magic[sizeof(MAGIC) - 1];
+  uint32_t version;
+  if (!reader.read(magic, sizeof(magic)) || memcmp(magic, MAGIC, sizeof(magic)) != 0 ||
+      !reader.read(&version, sizeof(version)))
+  {
+    ROS_ERROR("'%s' is not a benchmark scenario", filename.c_str());
+    return false;
+  }
+  if (version != VERSION)
+  {
+    ROS_ERROR("Benchmark scenario '%s' has version %u, but only version %u is supported", filename.c_str(), version,
+              VERSION);
+    return false;
+  }
+
+  queries.clear();
+  start_states.clear();
+  constraints.clear();
+  trajectory_constraints.clear();
+  std::vector<Record> records;
+  bool have_scene = false;
+  while (!reader.done())
+  {
+    Record record;
+    std::string name;
+    if (!reader.read(&record.type, sizeof(record.type)) || !reader.readString(name) ||
+        !reader.read(&record.length, sizeof(record.length)))
+    {
+      ROS_ERROR("Benchmark scenario '%s' is truncated", filename.c_str());
+      return false;
+    }
+    record.offset = reader.offset();
+    if (!reader.skip(record.length))
+    {
+      ROS_ERROR("Benchmark scenario '%s' is truncated", filename.c_str());
+      return false;
+    }
+
+    switch (record.type)
+    {
+      case SCENE:
+        have_scene = true;
+        scene_name = name;
+        record.index = 0;
+        break;
+      case QUERY:
+        record.index = queries.size();
+        queries.resize(queries.size() + 1);
+        queries.back().name = name;
+        break;
+      case START_STATE:
+        record.index = start_states.size();
+        start_states.resize(start_states.size() + 1);
+        start_states.back().name = name;
+        break;
+      case CONSTRAINTS:
+        record.index = constraints.size();
+        constraints.resize(constraints.size() + 1);
+        constraints.back().name = name;
+        break;
+      case TRAJECTORY_CONSTRAINTS:
+        record.index = trajectory_constraints.size();
+        trajectory_constraints.resize(trajectory_constraints.size() + 1);
+        trajectory_constraints.back().name = name;
+        break;
+      default:
+        ROS_WARN("Skipping record '%s' of unknown type %u in benchmark scenario '%s'", name.c_str(),
+                 (unsigned int)record.type, filename.c_str());
+        continue;
+    }
+    records.push_back(record);
+  }
+  if (!have_scene)
+  {
+    ROS_ERROR("Benchmark scenario '%s' does not contain a planning scene", filename.c_str());
+    return false;
+  }
+
+  if (threads == 0)
+    threads = std::max(1u, boost::thread::hardware_concurrency());
+  if (threads > records.size())
+    threads = records.size();
+
+  std::atomic<std::size_t> next(0);
+  std::atomic<bool> failed(false);
+  boost::thread_group workers;
+  for (unsigned int i = 1; i < threads; ++i)
+    workers.create_thread(boost::bind(&deserializeRecords, this, &data, &records, &next, &failed));
+  deserializeRecords(this, &data, &records, &next, &failed);
+  workers.join_all();
+
+  if (failed)
+    return false;
+  ROS_INFO("Loaded benchmark scenario '%s': scene '%s', %lu queries, %lu start states, %lu constraints and %lu "
+           "trajectory constraints",
+           filename.c_str(), scene_name.c_str(), queries.size(), start_states.size(), constraints.size(),
+           trajectory_constraints.size());
+  return true;
+}
+
+bool BenchmarkScenario::save(const std::string& filename) const
+{
+  std::ofstream out(filename.c_str(), std::ios::binary);
+  if (!out.good())
+  {
+    ROS_ERROR("Unable to open '%s' to write a benchmark scenario", filename.c_str());
+    return false;
+  }
+  out.write(MAGIC, sizeof(MAGIC) - 1);
+  writeUInt32(out, VERSION);
+  writeRecord(out, SCENE, scene_name, scene);
+  writeRecords(out, QUERY, queries);
+  writeRecords(out, START_STATE, start_states);
+  writeRecords(out, CONSTRAINTS, constraints);
+  writeRecords(out, TRAJECTORY_CONSTRAINTS, trajectory_constraints);
+  out.close();
+  if (!out)
+  {
+    ROS_ERROR("Failed to write benchmark scenario '%s'", filename.c_str());
+    return false;
+  }
+  return true;
+}
@@ -253,6 +253,7 @@ bool move_group::MoveGroupPickPlaceAction::planUsingPickPlace_Place(const moveit
 void move_group::MoveGroupPickPlaceAction::executePickupCallback_PlanAndExecute(
     const moveit_msgs::PickupGoalConstPtr& goal, moveit_msgs::PickupResult& action_res)
 {
+  boost::unique_lock<boost::mutex> lock = serializeRequest();
   plan_execution::PlanExecution::Options opt;
 
   opt.replan_ = goal->planning_options.replan;
@@ -284,6 +285,7 @@ void move_group::MoveGroupPickPlaceAction::executePickupCallback_PlanAndExecute(
 void move_group::MoveGroupPickPlaceAction::executePlaceCallback_PlanAndExecute(
     const moveit_msgs::PlaceGoalConstPtr& goal, moveit_msgs::PlaceResult& action_res)
 {
+  boost::unique_lock<boost::mutex> lock = serializeRequest();
   plan_execution::PlanExecution::Options opt;
 
   opt.replan_ = goal->planning_options.replan;
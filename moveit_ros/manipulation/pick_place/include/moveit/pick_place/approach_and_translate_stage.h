@@ -60,6 +60,7 @@ private:
   unsigned int max_fail_;
   double max_step_;
   double jump_factor_;
+  unsigned int retreat_batch_threads_;
 };
 }
 
@@ -42,7 +42,8 @@
 #include <boost/shared_ptr.hpp>
 #include <boost/function.hpp>
 #include <vector>
-#include <deque>
+#include <map>
+#include <functional>
 
 namespace pick_place
 {
@@ -75,11 +76,24 @@ public:
 
   void setVerbose(bool flag);
 
+  /** \brief Set the number of successful plans after which processing stops (default is 1) */
+  void setRequiredSolutionCount(unsigned int count);
+
+  unsigned int getRequiredSolutionCount() const
+  {
+    return required_solutions_;
+  }
+
   void signalStop();
   void start();
   void stop();
 
+  /** \brief Queue a plan; queued plans are processed in order of decreasing ManipulationPlan::priority_,
+      and in the order they were added when priorities are equal */
   void push(const ManipulationPlanPtr& grasp);
+
+  /** \brief Queue a set of plans, taking the queue lock and waking up the processing threads only once */
+  void push(const std::vector<ManipulationPlanPtr>& plans);
   void clear();
 
   const std::vector<ManipulationPlanPtr>& getSuccessfulManipulationPlans() const
@@ -102,7 +116,8 @@ protected:
   bool verbose_;
   std::vector<ManipulationStagePtr> stages_;
 
-  std::deque<ManipulationPlanPtr> queue_;
+  // Sorted by decreasing priority; a multimap keeps insertion order among equal keys
+  std::multimap<double, ManipulationPlanPtr, std::greater<double> > queue_;
   std::vector<ManipulationPlanPtr> success_;
   std::vector<ManipulationPlanPtr> failed_;
 
@@ -115,6 +130,8 @@ protected:
   boost::function<void()> empty_queue_callback_;
   unsigned int empty_queue_threads_;
 
+  unsigned int required_solutions_;
+
   bool stop_processing_;
 };
 }
@@ -86,7 +86,7 @@ MOVEIT_CLASS_FORWARD(ManipulationPlan);
 struct ManipulationPlan
 {
   ManipulationPlan(const ManipulationPlanSharedDataConstPtr& shared_data)
-    : shared_data_(shared_data), processing_stage_(0)
+    : shared_data_(shared_data), processing_stage_(0), priority_(0.0)
   {
   }
 
@@ -139,6 +139,9 @@ struct ManipulationPlan
 
   // An id for this plan; this is usually the index of the Grasp / PlaceLocation in the input request
   std::size_t id_;
+
+  // Plans with a higher priority are taken from the pipeline queue first; this is usually the grasp quality
+  double priority_;
 };
 }
 
@@ -42,6 +42,7 @@
 #include <moveit/pick_place/pick_place_params.h>
 #include <moveit/constraint_sampler_manager_loader/constraint_sampler_manager_loader.h>
 #include <moveit/planning_pipeline/planning_pipeline.h>
+#include <moveit/kinematics_metrics/reachability_map.h>
 #include <moveit_msgs/PickupAction.h>
 #include <moveit_msgs/PlaceAction.h>
 #include <boost/noncopyable.hpp>
@@ -140,6 +141,10 @@ public:
   PlacePlanPtr planPlace(const planning_scene::PlanningSceneConstPtr& planning_scene,
                          const moveit_msgs::PlaceGoal& goal) const;
 
+  /** \brief Get the reachability map of a group, loaded from the file named by the ~reachability_maps/<group>
+   * parameter the first time it is asked for. Returns NULL if the parameter is not set or the file fails to load. */
+  kinematics_metrics::ReachabilityMapConstPtr getReachabilityMap(const std::string& group_name) const;
+
   void displayComputedMotionPlans(bool flag);
   void displayProcessedGrasps(bool flag);
 
@@ -158,6 +163,10 @@ private:
   ros::Publisher grasps_publisher_;
 
   constraint_sampler_manager_loader::ConstraintSamplerManagerLoaderPtr constraint_sampler_manager_loader_;
+
+  /** \brief The reachability maps loaded so far, by group (NULL for groups without one) */
+  mutable std::map<std::string, kinematics_metrics::ReachabilityMapConstPtr> reachability_maps_;
+  mutable boost::mutex reachability_maps_lock_;
 };
 }
 
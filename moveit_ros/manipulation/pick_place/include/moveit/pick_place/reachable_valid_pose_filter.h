@@ -39,6 +39,7 @@
 
 #include <moveit/pick_place/manipulation_stage.h>
 #include <moveit/constraint_samplers/constraint_sampler_manager.h>
+#include <moveit/kinematics_metrics/reachability_map.h>
 #include <moveit/planning_scene/planning_scene.h>
 
 namespace pick_place
@@ -48,16 +49,22 @@ class ReachableAndValidPoseFilter : public ManipulationStage
 public:
   ReachableAndValidPoseFilter(const planning_scene::PlanningSceneConstPtr& scene,
                               const collision_detection::AllowedCollisionMatrixConstPtr& collision_matrix,
-                              const constraint_samplers::ConstraintSamplerManagerPtr& constraints_sampler_manager);
+                              const constraint_samplers::ConstraintSamplerManagerPtr& constraints_sampler_manager,
+                              const kinematics_metrics::ReachabilityMapConstPtr& reachability_map =
+                                  kinematics_metrics::ReachabilityMapConstPtr());
 
   virtual bool evaluate(const ManipulationPlanPtr& plan) const;
 
 private:
   bool isEndEffectorFree(const ManipulationPlanPtr& plan, robot_state::RobotState& token_state) const;
 
+  /** \brief Check the goal pose (once transformed) against the reachability map, if there is one for the IK link */
+  bool isInReach(const ManipulationPlanPtr& plan, robot_state::RobotState& token_state) const;
+
   planning_scene::PlanningSceneConstPtr planning_scene_;
   collision_detection::AllowedCollisionMatrixConstPtr collision_matrix_;
   constraint_samplers::ConstraintSamplerManagerPtr constraints_sampler_manager_;
+  kinematics_metrics::ReachabilityMapConstPtr reachability_map_;
 };
 }
 
@@ -37,6 +37,8 @@
 #include <moveit/pick_place/pick_place.h>
 #include <moveit/pick_place/approach_and_translate_stage.h>
 #include <moveit/trajectory_processing/trajectory_tools.h>
+#include <moveit/trajectory_processing/batch_time_parameterization.h>
+#include <boost/bind.hpp>
 #include <eigen_conversions/eigen_msg.h>
 #include <ros/console.h>
 
@@ -51,6 +53,7 @@ ApproachAndTranslateStage::ApproachAndTranslateStage(
   max_fail_ = GetGlobalPickPlaceParams().max_fail_;
   max_step_ = GetGlobalPickPlaceParams().max_step_;
   jump_factor_ = GetGlobalPickPlaceParams().jump_factor_;
+  retreat_batch_threads_ = GetGlobalPickPlaceParams().retreat_batch_threads_;
 }
 
 namespace
@@ -73,6 +76,7 @@ bool isStateCollisionFree(const planning_scene::PlanningScene* planning_scene,
     for (std::size_t i = 0; i < grasp_posture->points.size(); ++i)
     {
       state->setVariablePositions(grasp_posture->joint_names, grasp_posture->points[i].positions);
+      state->update();
       collision_detection::CollisionResult res;
       planning_scene->checkCollision(req, res, *state, *collision_matrix);
       if (res.collision)
@@ -81,6 +85,7 @@ bool isStateCollisionFree(const planning_scene::PlanningScene* planning_scene,
   }
   else
   {
+    state->update();
     collision_detection::CollisionResult res;
     planning_scene->checkCollision(req, res, *state, *collision_matrix);
     if (res.collision)
@@ -89,6 +94,50 @@ bool isStateCollisionFree(const planning_scene::PlanningScene* planning_scene,
   return planning_scene->isStateFeasible(*state);
 }
 
+// Batched version of isStateCollisionFree(): returns the index of the first of the states that is not valid, or
+// states.size() if they all are
+std::size_t areStatesCollisionFree(const planning_scene::PlanningScene* planning_scene,
+                                   const collision_detection::AllowedCollisionMatrix* collision_matrix, bool verbose,
+                                   const trajectory_msgs::JointTrajectory* grasp_posture, unsigned int thread_count,
+                                   const std::vector<const robot_state::RobotState*>& states,
+                                   const robot_state::JointModelGroup* group)
+{
+  // every state is checked once for each point of the grasp posture, on a copy that has the posture applied
+  const bool apply_posture = grasp_posture->joint_names.size() > 0;
+  const std::size_t checks_per_state = apply_posture ? grasp_posture->points.size() : 1;
+  std::vector<robot_state::RobotState> checked_states;
+  checked_states.reserve(states.size() * checks_per_state);
+  for (std::size_t i = 0; i < states.size(); ++i)
+    for (std::size_t j = 0; j < checks_per_state; ++j)
+    {
+      checked_states.push_back(*states[i]);
+      if (apply_posture)
+        checked_states.back().setVariablePositions(grasp_posture->joint_names, grasp_posture->points[j].positions);
+      checked_states.back().update();
+    }
+
+  collision_detection::CollisionRequest req;
+  req.verbose = verbose;
+  req.group_name = group->getName();
+
+  std::size_t valid = states.size();
+  if (checks_per_state > 0)
+  {
+    std::vector<const robot_state::RobotState*> batch(checked_states.size());
+    for (std::size_t i = 0; i < checked_states.size(); ++i)
+      batch[i] = &checked_states[i];
+    std::vector<collision_detection::CollisionResult> res;
+    valid = planning_scene->checkCollisionBatch(req, res, batch, *collision_matrix, thread_count) / checks_per_state;
+  }
+
+  // feasibility is checked for the state as the last posture point leaves it, like isStateCollisionFree() does
+  for (std::size_t i = 0; i < valid; ++i)
+    if (!planning_scene->isStateFeasible(checks_per_state > 0 ? checked_states[(i + 1) * checks_per_state - 1] :
+                                                                *states[i]))
+      return i;
+  return valid;
+}
+
 bool samplePossibleGoalStates(const ManipulationPlanPtr& plan, const robot_state::RobotState& reference_state,
                               double min_distance, unsigned int attempts)
 {
@@ -118,6 +167,44 @@ bool samplePossibleGoalStates(const ManipulationPlanPtr& plan, const robot_state
   return false;
 }
 
+// Compute the approach path that ends at reused.front(). The states in reused are already validated waypoints that
+// lead back from that goal along the approach line (the close-up motion produces them), so they are taken as they are
+// and IK is only solved for the part of the approach distance they do not cover.
+double computeApproachPath(const ManipulationPlanPtr& plan, const std::vector<robot_state::RobotStatePtr>& reused,
+                           const Eigen::Vector3d& approach_direction, bool global_reference_frame, double max_step,
+                           double jump_factor, const robot_state::GroupStateValidityCallbackFn& valid_callback,
+                           std::vector<robot_state::RobotStatePtr>& approach_states)
+{
+  const robot_model::LinkModel* ik_link = plan->shared_data_->ik_link_;
+  const Eigen::Vector3d goal_position = reused.front()->getGlobalLinkTransform(ik_link).translation();
+
+  approach_states.clear();
+  approach_states.push_back(reused.front());
+  double covered = 0.0;
+  for (std::size_t k = 1; k < reused.size(); ++k)
+  {
+    double d = (reused[k]->getGlobalLinkTransform(ik_link).translation() - goal_position).norm();
+    if (d > plan->approach_.desired_distance)
+      break;
+    approach_states.push_back(reused[k]);
+    covered = d;
+  }
+
+  double remaining = plan->approach_.desired_distance - covered;
+  if (remaining <= std::numeric_limits<double>::epsilon())
+    return covered;
+
+  robot_state::RobotStatePtr start_state(new robot_state::RobotState(*approach_states.back()));
+  std::vector<robot_state::RobotStatePtr> remaining_states;
+  double d_remaining = start_state->computeCartesianPath(plan->shared_data_->planning_group_, remaining_states, ik_link,
+                                                         -approach_direction, global_reference_frame, remaining,
+                                                         max_step, jump_factor, valid_callback);
+  // the first state of the computed path is a copy of the state it started from
+  if (remaining_states.size() > 1)
+    approach_states.insert(approach_states.end(), remaining_states.begin() + 1, remaining_states.end());
+  return covered + d_remaining;
+}
+
 // This function is called during trajectory execution, after the gripper is closed, to attach the currently gripped
 // object
 bool executeAttachObject(const ManipulationPlanSharedDataConstPtr& shared_plan_data,
@@ -222,6 +309,9 @@ bool ApproachAndTranslateStage::evaluate(const ManipulationPlanPtr& plan) const
     for (std::size_t i = attempted_possible_goal_states; i < plan->possible_goal_states_.size() && !signal_stop_;
          ++i, ++attempted_possible_goal_states)
     {
+      // states known to be valid on the approach line, ordered from the goal backwards
+      std::vector<robot_state::RobotStatePtr> reused_states;
+
       // if we are trying to get as close as possible to the goal (maximum one meter)
       if (plan->shared_data_->minimize_object_distance_)
       {
@@ -231,19 +321,23 @@ bool ApproachAndTranslateStage::evaluate(const ManipulationPlanPtr& plan) const
         double d_close_up = close_up_state->computeCartesianPath(
             plan->shared_data_->planning_group_, close_up_states, plan->shared_data_->ik_link_, approach_direction,
             approach_direction_is_global_frame, MAX_CLOSE_UP_DIST, max_step_, jump_factor_, approach_validCallback);
-        // if progress towards the object was made, update the desired goal state
+        // if progress towards the object was made, update the desired goal state; the close-up waypoints up to the
+        // new goal are also the first waypoints of the approach path, so they are kept instead of being solved again
         if (d_close_up > 0.0 && close_up_states.size() > 1)
+        {
           *plan->possible_goal_states_[i] = *close_up_states[close_up_states.size() - 2];
+          reused_states.assign(close_up_states.rbegin() + 1, close_up_states.rend());
+        }
       }
+      if (reused_states.empty())
+        reused_states.push_back(
+            robot_state::RobotStatePtr(new robot_state::RobotState(*plan->possible_goal_states_[i])));
 
       // try to compute a straight line path that arrives at the goal using the specified approach direction
-      robot_state::RobotStatePtr first_approach_state(new robot_state::RobotState(*plan->possible_goal_states_[i]));
-
       std::vector<robot_state::RobotStatePtr> approach_states;
-      double d_approach = first_approach_state->computeCartesianPath(
-          plan->shared_data_->planning_group_, approach_states, plan->shared_data_->ik_link_, -approach_direction,
-          approach_direction_is_global_frame, plan->approach_.desired_distance, max_step_, jump_factor_,
-          approach_validCallback);
+      double d_approach =
+          computeApproachPath(plan, reused_states, approach_direction, approach_direction_is_global_frame, max_step_,
+                              jump_factor_, approach_validCallback, approach_states);
 
       // if we were able to follow the approach direction for sufficient length, try to compute a retreat direction
       if (d_approach > plan->approach_.min_distance && !signal_stop_)
@@ -269,10 +363,28 @@ bool ApproachAndTranslateStage::evaluate(const ManipulationPlanPtr& plan) const
           robot_state::RobotStatePtr last_retreat_state(
               new robot_state::RobotState(planning_scene_after_approach->getCurrentState()));
           std::vector<robot_state::RobotStatePtr> retreat_states;
-          double d_retreat = last_retreat_state->computeCartesianPath(
-              plan->shared_data_->planning_group_, retreat_states, plan->shared_data_->ik_link_, retreat_direction,
-              retreat_direction_is_global_frame, plan->retreat_.desired_distance, max_step_, jump_factor_,
-              retreat_validCallback);
+          double d_retreat;
+          if (retreat_batch_threads_ > 0)
+          {
+            // the whole retreat is solved first and its waypoints are then collision checked together
+            EigenSTL::vector_Affine3d target(
+                1, last_retreat_state->getGlobalLinkTransform(plan->shared_data_->ik_link_));
+            const Eigen::Vector3d rotated_direction =
+                retreat_direction_is_global_frame ? retreat_direction : target[0].rotation() * retreat_direction;
+            target[0].translation() += rotated_direction * plan->retreat_.desired_distance;
+            d_retreat = plan->retreat_.desired_distance *
+                        last_retreat_state->computeCartesianPathBatch(
+                            plan->shared_data_->planning_group_, retreat_states, plan->shared_data_->ik_link_, target,
+                            true, max_step_, jump_factor_,
+                            boost::bind(&areStatesCollisionFree, planning_scene_after_approach.get(),
+                                        collision_matrix_.get(), verbose_, &plan->retreat_posture_,
+                                        retreat_batch_threads_, _1, _2));
+          }
+          else
+            d_retreat = last_retreat_state->computeCartesianPath(
+                plan->shared_data_->planning_group_, retreat_states, plan->shared_data_->ik_link_, retreat_direction,
+                retreat_direction_is_global_frame, plan->retreat_.desired_distance, max_step_, jump_factor_,
+                retreat_validCallback);
 
           // if sufficient progress was made in the desired direction, we have a goal state that we can consider for
           // future stages
@@ -292,8 +404,12 @@ bool ApproachAndTranslateStage::evaluate(const ManipulationPlanPtr& plan) const
               retreat_traj->addSuffixWayPoint(retreat_states[k], 0.0);
 
             // Add timestamps to approach|retreat trajectories
-            time_param_.computeTimeStamps(*approach_traj);
-            time_param_.computeTimeStamps(*retreat_traj);
+            std::vector<robot_trajectory::RobotTrajectoryPtr> segments;
+            segments.push_back(approach_traj);
+            segments.push_back(retreat_traj);
+            trajectory_processing::computeTimeStamps(
+                segments, boost::bind(&trajectory_processing::IterativeParabolicTimeParameterization::computeTimeStamps,
+                                      &time_param_, _1, 1.0, 1.0));
 
             // Convert approach trajectory to an executable trajectory
             plan_execution::ExecutableTrajectory et_approach(approach_traj, "approach");
@@ -314,9 +430,6 @@ bool ApproachAndTranslateStage::evaluate(const ManipulationPlanPtr& plan) const
         }
         else  // No retreat was specified, so package up approach and grip trajectories.
         {
-          // Reset the approach_state_ RobotStatePtr so that we can retry computing the cartesian path
-          plan->approach_state_.swap(first_approach_state);
-
           // Create approach trajectory
           std::reverse(approach_states.begin(), approach_states.end());
           robot_trajectory::RobotTrajectoryPtr approach_traj(new robot_trajectory::RobotTrajectory(
@@ -36,11 +36,12 @@
 
 #include <moveit/pick_place/manipulation_pipeline.h>
 #include <ros/console.h>
+#include <algorithm>
 
 namespace pick_place
 {
 ManipulationPipeline::ManipulationPipeline(const std::string& name, unsigned int nthreads)
-  : name_(name), nthreads_(nthreads), verbose_(false), stop_processing_(true)
+  : name_(name), nthreads_(nthreads), verbose_(false), required_solutions_(1), stop_processing_(true)
 {
   processing_threads_.resize(nthreads, NULL);
 }
@@ -117,6 +118,11 @@ void ManipulationPipeline::start()
       processing_threads_[i] = new boost::thread(boost::bind(&ManipulationPipeline::processingThread, this, i));
 }
 
+void ManipulationPipeline::setRequiredSolutionCount(unsigned int count)
+{
+  required_solutions_ = std::max(1u, count);
+}
+
 void ManipulationPipeline::signalStop()
 {
   for (std::size_t i = 0; i < stages_.size(); ++i)
@@ -157,8 +163,8 @@ void ManipulationPipeline::processingThread(unsigned int index)
       queue_access_cond_.wait(ulock);
     while (!stop_processing_ && !queue_.empty())
     {
-      ManipulationPlanPtr g = queue_.front();
-      queue_.pop_front();
+      ManipulationPlanPtr g = queue_.begin()->second;
+      queue_.erase(queue_.begin());
       if (inc_queue)
       {
         empty_queue_threads_--;
@@ -186,11 +192,14 @@ void ManipulationPipeline::processingThread(unsigned int index)
         if (g->error_code_.val == moveit_msgs::MoveItErrorCodes::SUCCESS)
         {
           g->processing_stage_++;
+          bool done;
           {
             boost::mutex::scoped_lock slock(result_lock_);
             success_.push_back(g);
+            done = success_.size() >= required_solutions_;
           }
-          signalStop();
+          if (done)
+            signalStop();
           ROS_INFO_STREAM_NAMED("manipulation", "Found successful manipulation plan!");
           if (solution_callback_)
             solution_callback_();
@@ -208,21 +217,37 @@ void ManipulationPipeline::processingThread(unsigned int index)
 void ManipulationPipeline::push(const ManipulationPlanPtr& plan)
 {
   boost::mutex::scoped_lock slock(queue_access_lock_);
-  queue_.push_back(plan);
+  queue_.insert(std::make_pair(plan->priority_, plan));
   ROS_INFO_STREAM_NAMED("manipulation", "Added plan for pipeline '" << name_ << "'. Queue is now of size "
                                                                     << queue_.size());
   queue_access_cond_.notify_all();
 }
 
-void ManipulationPipeline::reprocessLastFailure()
+void ManipulationPipeline::push(const std::vector<ManipulationPlanPtr>& plans)
 {
-  boost::mutex::scoped_lock slock(queue_access_lock_);
-  if (failed_.empty())
+  if (plans.empty())
     return;
-  ManipulationPlanPtr plan = failed_.back();
-  failed_.pop_back();
+  boost::mutex::scoped_lock slock(queue_access_lock_);
+  for (std::size_t i = 0; i < plans.size(); ++i)
+    queue_.insert(std::make_pair(plans[i]->priority_, plans[i]));
+  ROS_INFO_STREAM_NAMED("manipulation", "Added " << plans.size() << " plans for pipeline '" << name_
+                                                 << "'. Queue is now of size " << queue_.size());
+  queue_access_cond_.notify_all();
+}
+
+void ManipulationPipeline::reprocessLastFailure()
+{
+  ManipulationPlanPtr plan;
+  {
+    boost::mutex::scoped_lock slock(result_lock_);
+    if (failed_.empty())
+      return;
+    plan = failed_.back();
+    failed_.pop_back();
+  }
   plan->clear();
-  queue_.push_back(plan);
+  boost::mutex::scoped_lock slock(queue_access_lock_);
+  queue_.insert(std::make_pair(plan->priority_, plan));
   ROS_INFO_STREAM_NAMED("manipulation", "Re-added last failed plan for pipeline '"
                                             << name_ << "'. Queue is now of size " << queue_.size());
   queue_access_cond_.notify_all();
@@ -46,23 +46,6 @@ PickPlan::PickPlan(const PickPlaceConstPtr& pick_place) : PickPlacePlanBase(pick
 {
 }
 
-namespace
-{
-struct OrderGraspQuality
-{
-  OrderGraspQuality(const std::vector<moveit_msgs::Grasp>& grasps) : grasps_(grasps)
-  {
-  }
-
-  bool operator()(const std::size_t a, const std::size_t b) const
-  {
-    return grasps_[a].grasp_quality > grasps_[b].grasp_quality;
-  }
-
-  const std::vector<moveit_msgs::Grasp>& grasps_;
-};
-}
-
 bool PickPlan::plan(const planning_scene::PlanningSceneConstPtr& planning_scene, const moveit_msgs::PickupGoal& goal)
 {
   double timeout = goal.allowed_planning_time;
@@ -159,7 +142,8 @@ bool PickPlan::plan(const planning_scene::PlanningSceneConstPtr& planning_scene,
   // configure the manipulation pipeline
   pipeline_.reset();
   ManipulationStagePtr stage1(
-      new ReachableAndValidPoseFilter(planning_scene, approach_grasp_acm, pick_place_->getConstraintsSamplerManager()));
+      new ReachableAndValidPoseFilter(planning_scene, approach_grasp_acm, pick_place_->getConstraintsSamplerManager(),
+                                      pick_place_->getReachabilityMap(plan_data->planning_group_->getName())));
   ManipulationStagePtr stage2(new ApproachAndTranslateStage(planning_scene, approach_grasp_acm));
   ManipulationStagePtr stage3(new PlanStage(planning_scene, pick_place_->getPlanningPipeline()));
   pipeline_.addStage(stage1).addStage(stage2).addStage(stage3);
@@ -168,28 +152,25 @@ bool PickPlan::plan(const planning_scene::PlanningSceneConstPtr& planning_scene,
   pipeline_.start();
 
   // order the grasps by quality
-  std::vector<std::size_t> grasp_order(goal.possible_grasps.size());
-  for (std::size_t i = 0; i < goal.possible_grasps.size(); ++i)
-    grasp_order[i] = i;
-  OrderGraspQuality oq(goal.possible_grasps);
-  std::sort(grasp_order.begin(), grasp_order.end(), oq);
-
-  // feed the available grasps to the stages we set up
+  // feed the available grasps to the stages we set up; the pipeline processes them by decreasing grasp quality
+  std::vector<ManipulationPlanPtr> grasp_plans(goal.possible_grasps.size());
   for (std::size_t i = 0; i < goal.possible_grasps.size(); ++i)
   {
     ManipulationPlanPtr p(new ManipulationPlan(const_plan_data));
-    const moveit_msgs::Grasp& g = goal.possible_grasps[grasp_order[i]];
+    const moveit_msgs::Grasp& g = goal.possible_grasps[i];
     p->approach_ = g.pre_grasp_approach;
     p->retreat_ = g.post_grasp_retreat;
     p->goal_pose_ = g.grasp_pose;
-    p->id_ = grasp_order[i];
+    p->id_ = i;
+    p->priority_ = g.grasp_quality;
     // if no frame of reference was specified, assume the transform to be in the reference frame of the object
     if (p->goal_pose_.header.frame_id.empty())
       p->goal_pose_.header.frame_id = goal.target_name;
     p->approach_posture_ = g.pre_grasp_posture;
     p->retreat_posture_ = g.grasp_posture;
-    pipeline_.push(p);
+    grasp_plans[i] = p;
   }
+  pipeline_.push(grasp_plans);
 
   // wait till we're done
   waitForPipeline(endtime);
@@ -99,6 +99,33 @@ PickPlace::PickPlace(const planning_pipeline::PlanningPipelinePtr& planning_pipe
   constraint_sampler_manager_loader_.reset(new constraint_sampler_manager_loader::ConstraintSamplerManagerLoader());
 }
 
+kinematics_metrics::ReachabilityMapConstPtr PickPlace::getReachabilityMap(const std::string& group_name) const
+{
+  boost::mutex::scoped_lock slock(reachability_maps_lock_);
+  std::map<std::string, kinematics_metrics::ReachabilityMapConstPtr>::const_iterator it =
+      reachability_maps_.find(group_name);
+  if (it != reachability_maps_.end())
+    return it->second;
+
+  kinematics_metrics::ReachabilityMapPtr map;
+  std::string filename;
+  if (nh_.getParam("reachability_maps/" + group_name, filename))
+  {
+    map.reset(new kinematics_metrics::ReachabilityMap());
+    if (map->loadFromFile(filename) && map->getGroupName() == group_name)
+      ROS_INFO_NAMED("manipulation", "Loaded reachability map for group '%s' from '%s'", group_name.c_str(),
+                     filename.c_str());
+    else
+    {
+      ROS_ERROR_NAMED("manipulation", "Unable to load a reachability map for group '%s' from '%s'", group_name.c_str(),
+                      filename.c_str());
+      map.reset();
+    }
+  }
+  reachability_maps_[group_name] = map;
+  return map;
+}
+
 void PickPlace::displayProcessedGrasps(bool flag)
 {
   if (display_grasps_ && !flag)
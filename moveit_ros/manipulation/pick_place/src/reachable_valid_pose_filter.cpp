@@ -43,11 +43,13 @@
 pick_place::ReachableAndValidPoseFilter::ReachableAndValidPoseFilter(
     const planning_scene::PlanningSceneConstPtr& scene,
     const collision_detection::AllowedCollisionMatrixConstPtr& collision_matrix,
-    const constraint_samplers::ConstraintSamplerManagerPtr& constraints_sampler_manager)
+    const constraint_samplers::ConstraintSamplerManagerPtr& constraints_sampler_manager,
+    const kinematics_metrics::ReachabilityMapConstPtr& reachability_map)
   : ManipulationStage("reachable & valid pose filter")
   , planning_scene_(scene)
   , collision_matrix_(collision_matrix)
   , constraints_sampler_manager_(constraints_sampler_manager)
+  , reachability_map_(reachability_map)
 {
 }
 
@@ -104,12 +106,31 @@ bool pick_place::ReachableAndValidPoseFilter::isEndEffectorFree(const Manipulati
   return res.collision == false;
 }
 
+bool pick_place::ReachableAndValidPoseFilter::isInReach(const ManipulationPlanPtr& plan,
+                                                        robot_state::RobotState& token_state) const
+{
+  if (!reachability_map_ || reachability_map_->getTipFrame() != plan->shared_data_->ik_link_->getName())
+    return true;
+  Eigen::Vector3d position = token_state.getFrameTransform(reachability_map_->getBaseFrame()).inverse(Eigen::Isometry) *
+                             plan->transformed_goal_pose_.translation();
+  return reachability_map_->isReachable(position);
+}
+
 bool pick_place::ReachableAndValidPoseFilter::evaluate(const ManipulationPlanPtr& plan) const
 {
   // initialize with scene state
   robot_state::RobotStatePtr token_state(new robot_state::RobotState(planning_scene_->getCurrentState()));
   if (isEndEffectorFree(plan, *token_state))
   {
+    // a pose the arm cannot get to is rejected here, before the (much more expensive) IK sampling
+    if (!isInReach(plan, *token_state))
+    {
+      if (verbose_)
+        ROS_INFO_NAMED("manipulation", "Goal pose is outside of the reachability map");
+      plan->error_code_.val = moveit_msgs::MoveItErrorCodes::NO_IK_SOLUTION;
+      return false;
+    }
+
     // update the goal pose message if anything has changed; this is because the name of the frame in the input goal
     // pose
     // can be that of objects in the collision world but most components are unaware of those transforms,
@@ -72,18 +72,32 @@ static const std::string GET_PLANNER_PARAMS_SERVICE_NAME =
 static const std::string SET_PLANNER_PARAMS_SERVICE_NAME =
     "set_planner_params";                                 // service name to set planner parameters
 static const std::string MOVE_ACTION = "move_group";      // name of 'move' action
+static const std::string MOVE_ACTION_INTERMEDIATE_PATH_TOPIC =
+    "move_group/intermediate_planned_path";  // the improving solutions found while planning for the 'move' action
+static const std::string MOVE_ACTION_METRICS_TOPIC =
+    "move_group/request_metrics";  // the latency breakdown of each request of the 'move' action, if enabled
 static const std::string IK_SERVICE_NAME = "compute_ik";  // name of ik service
 static const std::string FK_SERVICE_NAME = "compute_fk";  // name of fk service
+static const std::string IK_BATCH_SERVICE_NAME = "compute_ik_batch";  // name of the service solving many ik queries
+static const std::string FK_BATCH_SERVICE_NAME = "compute_fk_batch";  // name of the service solving many fk queries
 static const std::string STATE_VALIDITY_SERVICE_NAME =
     "check_state_validity";  // name of the service that validates states
+static const std::string STATE_VALIDITY_BATCH_SERVICE_NAME =
+    "check_state_validity_batch";  // name of the service that validates many states in one call
 static const std::string CARTESIAN_PATH_SERVICE_NAME =
     "compute_cartesian_path";  // name of the service that computes cartesian paths
+static const std::string CARTESIAN_PATHS_SERVICE_NAME =
+    "compute_cartesian_paths";  // name of the service that computes batches of independent cartesian paths
 static const std::string GET_PLANNING_SCENE_SERVICE_NAME =
     "get_planning_scene";  // name of the service that can be used to query the planning scene
 static const std::string APPLY_PLANNING_SCENE_SERVICE_NAME =
     "apply_planning_scene";  // name of the service that applies a given planning scene
 static const std::string CLEAR_OCTOMAP_SERVICE_NAME =
     "clear_octomap";  // name of the service that can be used to clear the octomap
+static const std::string GET_IK_STATISTICS_SERVICE_NAME =
+    "get_ik_statistics";  // name of the service that reports the statistics of the IK solvers
+static const std::string RESET_IK_STATISTICS_SERVICE_NAME =
+    "reset_ik_statistics";  // name of the service that clears the statistics of the IK solvers
 }
 
 #endif
@@ -93,6 +93,17 @@ protected:
   moveit_msgs::PlanningScene clearSceneRobotState(const moveit_msgs::PlanningScene& scene) const;
   bool performTransform(geometry_msgs::PoseStamped& pose_msg, const std::string& target_frame) const;
 
+  /** \brief Capabilities call this for requests that must not run concurrently with other such requests, e.g.,
+      because they execute trajectories. When requests are handled on several threads, the returned lock is held
+      until it goes out of scope; otherwise no lock is taken. */
+  boost::unique_lock<boost::mutex> serializeRequest() const;
+
+  /** \brief Call \e fn on consecutive ranges [begin, end) that together cover [0, \e count), from \e thread_count
+      threads (one per core if 0). The calling thread takes part, so \e fn is called on it alone if one thread is
+      used. Batched services use this to evaluate their queries in parallel. */
+  void processBatch(std::size_t count, unsigned int thread_count,
+                    const boost::function<void(std::size_t, std::size_t)>& fn) const;
+
   ros::NodeHandle root_node_handle_;
   ros::NodeHandle node_handle_;
   std::string capability_name_;
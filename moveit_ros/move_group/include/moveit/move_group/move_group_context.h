@@ -38,6 +38,7 @@
 #define MOVEIT_MOVE_GROUP_CONTEXT_
 
 #include <moveit/macros/class_forward.h>
+#include <boost/thread/mutex.hpp>
 
 namespace planning_scene_monitor
 {
@@ -79,6 +80,11 @@ struct MoveGroupContext
   plan_execution::PlanWithSensingPtr plan_with_sensing_;
   bool allow_trajectory_execution_;
   bool debug_;
+
+  /// True if capability requests are handled on several threads, each against its own scene snapshot
+  bool concurrent_requests_;
+  /// Held by the requests that must not run concurrently with each other, such as trajectory execution
+  boost::mutex serialized_requests_mutex_;
 };
 }
 
@@ -43,9 +43,10 @@
 #include <moveit/planning_pipeline/planning_pipeline.h>
 #include <moveit_msgs/DisplayTrajectory.h>
 #include <moveit/trajectory_processing/iterative_time_parameterization.h>
+#include <boost/thread.hpp>
 
 move_group::MoveGroupCartesianPathService::MoveGroupCartesianPathService()
-  : MoveGroupCapability("CartesianPathService"), display_computed_paths_(true)
+  : MoveGroupCapability("CartesianPathService"), display_computed_paths_(true), batch_threads_(0)
 {
 }
 
@@ -55,6 +56,13 @@ void move_group::MoveGroupCartesianPathService::initialize()
       planning_pipeline::PlanningPipeline::DISPLAY_PATH_TOPIC, 10, true);
   cartesian_path_service_ = root_node_handle_.advertiseService(CARTESIAN_PATH_SERVICE_NAME,
                                                                &MoveGroupCartesianPathService::computeService, this);
+
+  // the number of threads computing the segments of a batch; 0 uses one per core
+  int batch_threads = 0;
+  node_handle_.param("cartesian_path_batch_threads", batch_threads, 0);
+  batch_threads_ = std::max(batch_threads, 0);
+  cartesian_paths_service_ = root_node_handle_.advertiseService(
+      CARTESIAN_PATHS_SERVICE_NAME, &MoveGroupCartesianPathService::computeBatchService, this);
 }
 
 namespace
@@ -66,7 +74,7 @@ bool isStateValid(const planning_scene::PlanningScene* planning_scene,
   state->setJointGroupPositions(group, ik_solution);
   state->update();
   return (!planning_scene || !planning_scene->isStateColliding(*state, group->getName())) &&
-         (!constraint_set || constraint_set->decide(*state).satisfied);
+         (!constraint_set || constraint_set->isSatisfied(*state));
 }
 }
 
@@ -76,8 +84,108 @@ bool move_group::MoveGroupCartesianPathService::computeService(moveit_msgs::GetC
   ROS_INFO("Received request to compute Cartesian path");
   context_->planning_scene_monitor_->updateFrameTransforms();
 
-  robot_state::RobotState start_state =
-      planning_scene_monitor::LockedPlanningSceneRO(context_->planning_scene_monitor_)->getCurrentState();
+  moveit_msgs::RobotState path_start;
+  computePath(planning_scene_monitor::LockedPlanningSceneRO(context_->planning_scene_monitor_), req, res, path_start);
+  if (display_computed_paths_ && !res.solution.joint_trajectory.points.empty())
+  {
+    moveit_msgs::DisplayTrajectory disp;
+    disp.model_id = context_->planning_scene_monitor_->getRobotModel()->getName();
+    disp.trajectory.resize(1, res.solution);
+    disp.trajectory_start = path_start;
+    display_path_.publish(disp);
+  }
+  return true;
+}
+
+bool move_group::MoveGroupCartesianPathService::computeBatchService(
+    moveit_ros_move_group::GetCartesianPaths::Request& req, moveit_ros_move_group::GetCartesianPaths::Response& res)
+{
+  ROS_INFO("Received request to compute %u Cartesian paths", (unsigned int)req.segments.size());
+  context_->planning_scene_monitor_->updateFrameTransforms();
+
+  std::vector<moveit_msgs::GetCartesianPath::Request> requests(req.segments.size());
+  for (std::size_t i = 0; i < req.segments.size(); ++i)
+  {
+    const moveit_ros_move_group::CartesianPathSegment& segment = req.segments[i];
+    requests[i].header = segment.header;
+    requests[i].start_state = segment.start_state;
+    requests[i].group_name = segment.group_name;
+    requests[i].link_name = segment.link_name;
+    requests[i].waypoints = segment.waypoints;
+    requests[i].max_step = segment.max_step;
+    requests[i].jump_threshold = segment.jump_threshold;
+    requests[i].avoid_collisions = segment.avoid_collisions;
+    requests[i].path_constraints = segment.path_constraints;
+  }
+
+  std::vector<moveit_msgs::GetCartesianPath::Response> responses(requests.size());
+  std::vector<moveit_msgs::RobotState> path_starts(requests.size());
+  {
+    // all the segments are computed against the same scene
+    planning_scene_monitor::LockedPlanningSceneRO ls(context_->planning_scene_monitor_);
+    const planning_scene::PlanningSceneConstPtr& scene = ls;
+    std::atomic<std::size_t> next(0);
+    std::size_t thread_count = batch_threads_ > 0 ? batch_threads_ : boost::thread::hardware_concurrency();
+    thread_count = std::max<std::size_t>(1, std::min(thread_count, requests.size()));
+
+    // the calling thread takes part, so a single segment is computed without starting any thread
+    boost::thread_group threads;
+    for (std::size_t i = 1; i < thread_count; ++i)
+      threads.create_thread(boost::bind(&MoveGroupCartesianPathService::computePaths, this, scene, &requests,
+                                        &responses, &path_starts, &next));
+    computePaths(scene, &requests, &responses, &path_starts, &next);
+    threads.join_all();
+  }
+
+  moveit_msgs::DisplayTrajectory disp;
+  res.results.resize(responses.size());
+  for (std::size_t i = 0; i < responses.size(); ++i)
+  {
+    res.results[i].start_state = responses[i].start_state;
+    res.results[i].solution = responses[i].solution;
+    res.results[i].fraction = responses[i].fraction;
+    res.results[i].error_code = responses[i].error_code;
+    if (!responses[i].solution.joint_trajectory.points.empty())
+    {
+      if (disp.trajectory.empty())
+        disp.trajectory_start = path_starts[i];
+      disp.trajectory.push_back(responses[i].solution);
+    }
+  }
+  if (display_computed_paths_ && !disp.trajectory.empty())
+  {
+    disp.model_id = context_->planning_scene_monitor_->getRobotModel()->getName();
+    display_path_.publish(disp);
+  }
+  return true;
+}
+
+void move_group::MoveGroupCartesianPathService::computePaths(
+    const planning_scene::PlanningSceneConstPtr& scene,
+    const std::vector<moveit_msgs::GetCartesianPath::Request>* requests,
+    std::vector<moveit_msgs::GetCartesianPath::Response>* responses, std::vector<moveit_msgs::RobotState>* path_starts,
+    std::atomic<std::size_t>* next)
+{
+  for (std::size_t i = (*next)++; i < requests->size(); i = (*next)++)
+  {
+    try
+    {
+      computePath(scene, (*requests)[i], (*responses)[i], (*path_starts)[i]);
+    }
+    catch (std::exception& ex)
+    {
+      ROS_ERROR("Computing Cartesian path %u failed: %s", (unsigned int)i, ex.what());
+      (*responses)[i].error_code.val = moveit_msgs::MoveItErrorCodes::FAILURE;
+    }
+  }
+}
+
+void move_group::MoveGroupCartesianPathService::computePath(const planning_scene::PlanningSceneConstPtr& scene,
+                                                            const moveit_msgs::GetCartesianPath::Request& req,
+                                                            moveit_msgs::GetCartesianPath::Response& res,
+                                                            moveit_msgs::RobotState& path_start)
+{
+  robot_state::RobotState start_state = scene->getCurrentState();
   robot_state::robotStateMsgToRobotState(req.start_state, start_state);
   if (const robot_model::JointModelGroup* jmg = start_state.getJointModelGroup(req.group_name))
   {
@@ -125,17 +233,13 @@ bool move_group::MoveGroupCartesianPathService::computeService(moveit_msgs::GetC
         if (waypoints.size() > 0)
         {
           robot_state::GroupStateValidityCallbackFn constraint_fn;
-          std::unique_ptr<planning_scene_monitor::LockedPlanningSceneRO> ls;
           std::unique_ptr<kinematic_constraints::KinematicConstraintSet> kset;
           if (req.avoid_collisions || !kinematic_constraints::isEmpty(req.path_constraints))
           {
-            ls.reset(new planning_scene_monitor::LockedPlanningSceneRO(context_->planning_scene_monitor_));
-            kset.reset(new kinematic_constraints::KinematicConstraintSet((*ls)->getRobotModel()));
-            kset->add(req.path_constraints, (*ls)->getTransforms());
-            constraint_fn = boost::bind(
-                &isStateValid,
-                req.avoid_collisions ? static_cast<const planning_scene::PlanningSceneConstPtr&>(*ls).get() : NULL,
-                kset->empty() ? NULL : kset.get(), _1, _2, _3);
+            kset.reset(new kinematic_constraints::KinematicConstraintSet(scene->getRobotModel()));
+            kset->add(req.path_constraints, scene->getTransforms());
+            constraint_fn = boost::bind(&isStateValid, req.avoid_collisions ? scene.get() : NULL,
+                                        kset->empty() ? NULL : kset.get(), _1, _2, _3);
           }
           bool global_frame = !robot_state::Transforms::sameFrame(link_name, req.header.frame_id);
           ROS_INFO("Attempting to follow %u waypoints for link '%s' using a step of %lf m and jump threshold %lf (in "
@@ -160,14 +264,8 @@ bool move_group::MoveGroupCartesianPathService::computeService(moveit_msgs::GetC
           rt.getRobotTrajectoryMsg(res.solution);
           ROS_INFO("Computed Cartesian path with %u points (followed %lf%% of requested trajectory)",
                    (unsigned int)traj.size(), res.fraction * 100.0);
-          if (display_computed_paths_ && rt.getWayPointCount() > 0)
-          {
-            moveit_msgs::DisplayTrajectory disp;
-            disp.model_id = context_->planning_scene_monitor_->getRobotModel()->getName();
-            disp.trajectory.resize(1, res.solution);
-            robot_state::robotStateToRobotStateMsg(rt.getFirstWayPoint(), disp.trajectory_start);
-            display_path_.publish(disp);
-          }
+          if (rt.getWayPointCount() > 0)
+            robot_state::robotStateToRobotStateMsg(rt.getFirstWayPoint(), path_start);
         }
         res.error_code.val = moveit_msgs::MoveItErrorCodes::SUCCESS;
       }
@@ -177,8 +275,6 @@ bool move_group::MoveGroupCartesianPathService::computeService(moveit_msgs::GetC
   }
   else
     res.error_code.val = moveit_msgs::MoveItErrorCodes::INVALID_GROUP_NAME;
-
-  return true;
 }
 
 #include <class_loader/class_loader.h>
@@ -39,6 +39,8 @@
 
 #include <moveit/move_group/move_group_capability.h>
 #include <moveit_msgs/GetCartesianPath.h>
+#include <moveit_ros_move_group/GetCartesianPaths.h>
+#include <atomic>
 
 namespace move_group
 {
@@ -51,10 +53,26 @@ public:
 
 private:
   bool computeService(moveit_msgs::GetCartesianPath::Request& req, moveit_msgs::GetCartesianPath::Response& res);
+  bool computeBatchService(moveit_ros_move_group::GetCartesianPaths::Request& req,
+                           moveit_ros_move_group::GetCartesianPaths::Response& res);
+
+  /* compute the path for \e req against \e scene, which must be locked; \e path_start is set to the first waypoint
+     of the path, if there is one */
+  void computePath(const planning_scene::PlanningSceneConstPtr& scene,
+                   const moveit_msgs::GetCartesianPath::Request& req, moveit_msgs::GetCartesianPath::Response& res,
+                   moveit_msgs::RobotState& path_start);
+
+  /* compute the paths of a batch, taking the index of the next request from \e next, until none is left */
+  void computePaths(const planning_scene::PlanningSceneConstPtr& scene,
+                    const std::vector<moveit_msgs::GetCartesianPath::Request>* requests,
+                    std::vector<moveit_msgs::GetCartesianPath::Response>* responses,
+                    std::vector<moveit_msgs::RobotState>* path_starts, std::atomic<std::size_t>* next);
 
   ros::ServiceServer cartesian_path_service_;
+  ros::ServiceServer cartesian_paths_service_;
   ros::Publisher display_path_;
   bool display_computed_paths_;
+  unsigned int batch_threads_;
 };
 }
 
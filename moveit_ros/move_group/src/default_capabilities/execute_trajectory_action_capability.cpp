@@ -69,6 +69,7 @@ void MoveGroupExecuteTrajectoryAction::executePathCallback(const moveit_msgs::Ex
     return;
   }
 
+  boost::unique_lock<boost::mutex> lock = serializeRequest();
   executePathCallback_Execute(goal, action_res);
 
   std::string response = getActionResultString(action_res.error_code, false, false);
@@ -78,6 +78,7 @@ bool move_group::MoveGroupExecuteService::executeTrajectoryService(moveit_msgs::
   // \todo unwind trajectory before execution
   //    robot_trajectory::RobotTrajectory to_exec(planning_scene_monitor_->getRobotModel(), ;
 
+  boost::unique_lock<boost::mutex> lock = serializeRequest();
   context_->trajectory_execution_manager_->clear();
   if (context_->trajectory_execution_manager_->push(req.trajectory))
   {
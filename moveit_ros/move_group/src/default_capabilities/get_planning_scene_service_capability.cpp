@@ -53,10 +53,77 @@ bool move_group::MoveGroupGetPlanningSceneService::getPlanningSceneService(movei
 {
   if (req.components.components & moveit_msgs::PlanningSceneComponents::TRANSFORMS)
     context_->planning_scene_monitor_->updateFrameTransforms();
-  planning_scene_monitor::LockedPlanningSceneRO ps(context_->planning_scene_monitor_);
-  ps->getPlanningSceneMsg(res.scene, req.components);
+
+  // the world geometry, octomap and allowed collision matrix are served from a cache while their versions are the
+  // same; everything else is cheap and built for every request
+  const uint32_t components = req.components.components;
+  moveit_msgs::PlanningSceneComponents uncached = req.components;
+  uncached.components &= ~(moveit_msgs::PlanningSceneComponents::OCTOMAP |
+                           moveit_msgs::PlanningSceneComponents::ALLOWED_COLLISION_MATRIX);
+  if (components & moveit_msgs::PlanningSceneComponents::WORLD_OBJECT_GEOMETRY)
+    uncached.components &= ~(moveit_msgs::PlanningSceneComponents::WORLD_OBJECT_GEOMETRY |
+                             moveit_msgs::PlanningSceneComponents::WORLD_OBJECT_NAMES);
+
+  std::shared_ptr<const moveit_msgs::PlanningScene> world, octomap, acm;
+  planning_scene::ObjectTypeMap object_types;
+  uint32_t octomap_seq = 0;
+  {
+    planning_scene_monitor::LockedPlanningSceneRO ps(context_->planning_scene_monitor_);
+    ps->getPlanningSceneMsg(res.scene, uncached);
+    if (components & moveit_msgs::PlanningSceneComponents::WORLD_OBJECT_GEOMETRY)
+    {
+      // object types are not versioned, so they are always taken from the scene
+      world = getCachedComponent(*ps, moveit_msgs::PlanningSceneComponents::WORLD_OBJECT_GEOMETRY,
+                                 ps->getWorldVersion(), world_cache_);
+      ps->getKnownObjectTypes(object_types);
+    }
+    if (components & moveit_msgs::PlanningSceneComponents::OCTOMAP)
+    {
+      octomap = getCachedComponent(*ps, moveit_msgs::PlanningSceneComponents::OCTOMAP, ps->getOctomapVersion(),
+                                   octomap_cache_);
+      octomap_seq = ps->getOctomapSequenceNumber();
+    }
+    if (components & moveit_msgs::PlanningSceneComponents::ALLOWED_COLLISION_MATRIX)
+      acm = getCachedComponent(*ps, moveit_msgs::PlanningSceneComponents::ALLOWED_COLLISION_MATRIX,
+                               ps->getAllowedCollisionMatrixVersion(), acm_cache_);
+  }
+
+  // copy the cached components outside of the scene lock
+  if (world)
+  {
+    res.scene.world.collision_objects = world->world.collision_objects;
+    for (std::size_t i = 0; i < res.scene.world.collision_objects.size(); ++i)
+    {
+      moveit_msgs::CollisionObject& co = res.scene.world.collision_objects[i];
+      planning_scene::ObjectTypeMap::const_iterator it = object_types.find(co.id);
+      co.type = it != object_types.end() ? it->second : object_recognition_msgs::ObjectType();
+    }
+  }
+  if (octomap)
+  {
+    res.scene.world.octomap = octomap->world.octomap;
+    res.scene.world.octomap.header.seq = octomap_seq;
+  }
+  if (acm)
+    res.scene.allowed_collision_matrix = acm->allowed_collision_matrix;
   return true;
 }
 
+std::shared_ptr<const moveit_msgs::PlanningScene> move_group::MoveGroupGetPlanningSceneService::getCachedComponent(
+    const planning_scene::PlanningScene& scene, uint32_t component, uint64_t version, CachedComponent& cache)
+{
+  boost::mutex::scoped_lock slock(cache_lock_);
+  if (!cache.msg_ || cache.version_ != version)
+  {
+    std::shared_ptr<moveit_msgs::PlanningScene> msg(new moveit_msgs::PlanningScene());
+    moveit_msgs::PlanningSceneComponents comp;
+    comp.components = component;
+    scene.getPlanningSceneMsg(*msg, comp);
+    cache.msg_ = msg;
+    cache.version_ = version;
+  }
+  return cache.msg_;
+}
+
 #include <class_loader/class_loader.h>
 CLASS_LOADER_REGISTER_CLASS(move_group::MoveGroupGetPlanningSceneService, move_group::MoveGroupCapability)
@@ -39,6 +39,8 @@
 
 #include <moveit/move_group/move_group_capability.h>
 #include <moveit_msgs/GetPlanningScene.h>
+#include <boost/thread/mutex.hpp>
+#include <memory>
 
 namespace move_group
 {
@@ -53,7 +55,27 @@ private:
   bool getPlanningSceneService(moveit_msgs::GetPlanningScene::Request& req,
                                moveit_msgs::GetPlanningScene::Response& res);
 
+  /* a scene message holding a single expensive component, built from the given version of the scene component */
+  struct CachedComponent
+  {
+    CachedComponent() : version_(0)
+    {
+    }
+    uint64_t version_;
+    std::shared_ptr<const moveit_msgs::PlanningScene> msg_;
+  };
+
+  /* return the message of the component of \e scene in \e cache, rebuilding it if the version changed */
+  std::shared_ptr<const moveit_msgs::PlanningScene> getCachedComponent(const planning_scene::PlanningScene& scene,
+                                                                       uint32_t component, uint64_t version,
+                                                                       CachedComponent& cache);
+
   ros::ServiceServer get_scene_service_;
+
+  boost::mutex cache_lock_;
+  CachedComponent<moveit_msgs::PlanningScene> world_cache_;
+  CachedComponent<moveit_msgs::PlanningScene> octomap_cache_;
+  CachedComponent<moveit_msgs::PlanningScene> acm_cache_;
 };
 }
 
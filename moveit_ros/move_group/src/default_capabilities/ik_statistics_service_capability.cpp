@@ -0,0 +1,95 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include "ik_statistics_service_capability.h"
+#include <moveit/move_group/capability_names.h>
+#include <sstream>
+
+move_group::IKStatisticsService::IKStatisticsService() : MoveGroupCapability("IKStatisticsService")
+{
+}
+
+void move_group::IKStatisticsService::initialize()
+{
+  const std::vector<const robot_model::JointModelGroup*>& groups =
+      context_->planning_scene_monitor_->getRobotModel()->getJointModelGroups();
+  for (std::size_t i = 0; i < groups.size(); ++i)
+    if (const kinematics::KinematicsBaseConstPtr& solver = groups[i]->getSolverInstance())
+    {
+      solver->getSearchStatistics().setEnabled(true);
+      solver->getSetFromIKStatistics().setEnabled(true);
+    }
+
+  get_service_ =
+      root_node_handle_.advertiseService(GET_IK_STATISTICS_SERVICE_NAME, &IKStatisticsService::getStatistics, this);
+  reset_service_ =
+      root_node_handle_.advertiseService(RESET_IK_STATISTICS_SERVICE_NAME, &IKStatisticsService::resetStatistics, this);
+}
+
+bool move_group::IKStatisticsService::getStatistics(std_srvs::Trigger::Request& req,
+                                                    std_srvs::Trigger::Response& res)
+{
+  std::stringstream ss;
+  const std::vector<const robot_model::JointModelGroup*>& groups =
+      context_->planning_scene_monitor_->getRobotModel()->getJointModelGroups();
+  for (std::size_t i = 0; i < groups.size(); ++i)
+    if (const kinematics::KinematicsBaseConstPtr& solver = groups[i]->getSolverInstance())
+    {
+      ss << groups[i]->getName() << " IK searches: "
+         << kinematics::IKStatistics::toString(solver->getSearchStatistics().getSummary()) << std::endl;
+      ss << groups[i]->getName() << " setFromIK: "
+         << kinematics::IKStatistics::toString(solver->getSetFromIKStatistics().getSummary()) << std::endl;
+    }
+  res.message = ss.str();
+  res.success = true;
+  return true;
+}
+
+bool move_group::IKStatisticsService::resetStatistics(std_srvs::Trigger::Request& req,
+                                                      std_srvs::Trigger::Response& res)
+{
+  const std::vector<const robot_model::JointModelGroup*>& groups =
+      context_->planning_scene_monitor_->getRobotModel()->getJointModelGroups();
+  for (std::size_t i = 0; i < groups.size(); ++i)
+    if (const kinematics::KinematicsBaseConstPtr& solver = groups[i]->getSolverInstance())
+    {
+      solver->getSearchStatistics().reset();
+      solver->getSetFromIKStatistics().reset();
+    }
+  res.success = true;
+  return true;
+}
+
+#include <class_loader/class_loader.h>
+CLASS_LOADER_REGISTER_CLASS(move_group::IKStatisticsService, move_group::MoveGroupCapability)
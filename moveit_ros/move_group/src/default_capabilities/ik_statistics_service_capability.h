@@ -0,0 +1,63 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_MOVE_GROUP_IK_STATISTICS_SERVICE_CAPABILITY_
+#define MOVEIT_MOVE_GROUP_IK_STATISTICS_SERVICE_CAPABILITY_
+
+#include <moveit/move_group/move_group_capability.h>
+#include <std_srvs/Trigger.h>
+
+namespace move_group
+{
+/**
+ * Enables the statistics of the IK solvers of all groups and reports them through a service. Not loaded by default,
+ * so the solvers do not record anything unless it is listed in the capabilities parameter.
+ */
+class IKStatisticsService : public MoveGroupCapability
+{
+public:
+  IKStatisticsService();
+
+  virtual void initialize();
+
+private:
+  bool getStatistics(std_srvs::Trigger::Request& req, std_srvs::Trigger::Response& res);
+  bool resetStatistics(std_srvs::Trigger::Request& req, std_srvs::Trigger::Response& res);
+
+  ros::ServiceServer get_service_;
+  ros::ServiceServer reset_service_;
+};
+}
+
+#endif  // MOVEIT_MOVE_GROUP_IK_STATISTICS_SERVICE_CAPABILITY_
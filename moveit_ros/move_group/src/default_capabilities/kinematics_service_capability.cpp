@@ -40,7 +40,8 @@
 #include <eigen_conversions/eigen_msg.h>
 #include <moveit/move_group/capability_names.h>
 
-move_group::MoveGroupKinematicsService::MoveGroupKinematicsService() : MoveGroupCapability("KinematicsService")
+move_group::MoveGroupKinematicsService::MoveGroupKinematicsService()
+  : MoveGroupCapability("KinematicsService"), ik_batch_threads_(1), fk_batch_threads_(0)
 {
 }
 
@@ -50,6 +51,17 @@ void move_group::MoveGroupKinematicsService::initialize()
       root_node_handle_.advertiseService(FK_SERVICE_NAME, &MoveGroupKinematicsService::computeFKService, this);
   ik_service_ =
       root_node_handle_.advertiseService(IK_SERVICE_NAME, &MoveGroupKinematicsService::computeIKService, this);
+
+  // IK is solved on a single thread by default, since not every solver can be queried concurrently
+  int ik_threads = 1, fk_threads = 0;
+  node_handle_.param("ik_batch_threads", ik_threads, 1);
+  node_handle_.param("fk_batch_threads", fk_threads, 0);
+  ik_batch_threads_ = std::max(ik_threads, 0);
+  fk_batch_threads_ = std::max(fk_threads, 0);
+  fk_batch_service_ = root_node_handle_.advertiseService(FK_BATCH_SERVICE_NAME,
+                                                         &MoveGroupKinematicsService::computeFKBatchService, this);
+  ik_batch_service_ = root_node_handle_.advertiseService(IK_BATCH_SERVICE_NAME,
+                                                         &MoveGroupKinematicsService::computeIKBatchService, this);
 }
 
 namespace
@@ -62,7 +74,43 @@ bool isIKSolutionValid(const planning_scene::PlanningScene* planning_scene,
   state->setJointGroupPositions(jmg, ik_solution);
   state->update();
   return (!planning_scene || !planning_scene->isStateColliding(*state, jmg->getName())) &&
-         (!constraint_set || constraint_set->decide(*state).satisfied);
+         (!constraint_set || constraint_set->isSatisfied(*state));
+}
+
+void solveIK(const robot_state::RobotState* seed_state, const robot_model::JointModelGroup* jmg,
+             const std::string* ik_link, const EigenSTL::vector_Affine3d* poses, unsigned int attempts, double timeout,
+             const robot_state::GroupStateValidityCallbackFn* constraint, std::vector<double>* solutions,
+             std::vector<char>* solved, std::size_t begin, std::size_t end)
+{
+  robot_state::RobotState state(*seed_state);
+  std::vector<double> seed;
+  seed_state->copyJointGroupPositions(jmg, seed);
+  for (std::size_t i = begin; i < end; ++i)
+  {
+    state.setJointGroupPositions(jmg, seed);
+    bool found = ik_link->empty() ? state.setFromIK(jmg, (*poses)[i], attempts, timeout, *constraint) :
+                                    state.setFromIK(jmg, (*poses)[i], *ik_link, attempts, timeout, *constraint);
+    if (found)
+    {
+      state.copyJointGroupPositions(jmg, &(*solutions)[i * seed.size()]);
+      (*solved)[i] = 1;
+    }
+  }
+}
+
+void computeFK(const robot_state::RobotState* start_state, const robot_model::JointModelGroup* jmg,
+               const std::vector<const robot_model::LinkModel*>* links, const Eigen::Affine3d* frame,
+               const std::vector<double>* positions, std::vector<geometry_msgs::Pose>* poses, std::size_t begin,
+               std::size_t end)
+{
+  robot_state::RobotState state(*start_state);
+  for (std::size_t i = begin; i < end; ++i)
+  {
+    state.setJointGroupPositions(jmg, &(*positions)[i * jmg->getVariableCount()]);
+    state.updateLinkTransforms();
+    for (std::size_t j = 0; j < links->size(); ++j)
+      tf::poseEigenToMsg(*frame * state.getGlobalLinkTransform((*links)[j]), (*poses)[i * links->size() + j]);
+  }
 }
 }
 
@@ -211,5 +259,126 @@ bool move_group::MoveGroupKinematicsService::computeFKService(moveit_msgs::GetPo
   return true;
 }
 
+bool move_group::MoveGroupKinematicsService::computeIKBatchService(
+    moveit_ros_move_group::GetPositionIKBatch::Request& req, moveit_ros_move_group::GetPositionIKBatch::Response& res)
+{
+  context_->planning_scene_monitor_->updateFrameTransforms();
+
+  planning_scene_monitor::LockedPlanningSceneRO ls(context_->planning_scene_monitor_);
+  const robot_model::JointModelGroup* jmg = ls->getRobotModel()->getJointModelGroup(req.group_name);
+  if (!jmg)
+  {
+    res.error_code.val = moveit_msgs::MoveItErrorCodes::INVALID_GROUP_NAME;
+    return true;
+  }
+
+  // all the poses share a frame, so it is looked up once
+  const std::string& default_frame = context_->planning_scene_monitor_->getRobotModel()->getModelFrame();
+  Eigen::Affine3d frame = Eigen::Affine3d::Identity();
+  if (!req.header.frame_id.empty() && !robot_state::Transforms::sameFrame(req.header.frame_id, default_frame))
+  {
+    geometry_msgs::PoseStamped origin;
+    origin.header = req.header;
+    origin.pose.orientation.w = 1.0;
+    if (!performTransform(origin, default_frame))
+    {
+      res.error_code.val = moveit_msgs::MoveItErrorCodes::FRAME_TRANSFORM_FAILURE;
+      return true;
+    }
+    tf::poseMsgToEigen(origin.pose, frame);
+  }
+  EigenSTL::vector_Affine3d poses(req.poses.size());
+  for (std::size_t i = 0; i < req.poses.size(); ++i)
+  {
+    tf::poseMsgToEigen(req.poses[i], poses[i]);
+    poses[i] = frame * poses[i];
+  }
+
+  robot_state::RobotState seed_state = ls->getCurrentState();
+  robot_state::robotStateMsgToRobotState(req.robot_state, seed_state);
+  kinematic_constraints::KinematicConstraintSet kset(ls->getRobotModel());
+  kset.add(req.constraints, ls->getTransforms());
+  const planning_scene::PlanningSceneConstPtr& scene = ls;
+  robot_state::GroupStateValidityCallbackFn constraint;
+  if (req.avoid_collisions || !kset.empty())
+    constraint = boost::bind(&isIKSolutionValid, req.avoid_collisions ? scene.get() : NULL, kset.empty() ? NULL : &kset,
+                             _1, _2, _3);
+
+  res.joint_names = jmg->getVariableNames();
+  res.solutions.resize(poses.size() * jmg->getVariableCount(), 0.0);
+  std::vector<char> solved(poses.size(), 0);
+  processBatch(poses.size(), ik_batch_threads_,
+               boost::bind(&solveIK, &seed_state, jmg, &req.ik_link_name, &poses, req.attempts, req.timeout.toSec(),
+                           &constraint, &res.solutions, &solved, _1, _2));
+
+  res.solved.resize((poses.size() + 7) / 8, 0);
+  for (std::size_t i = 0; i < poses.size(); ++i)
+    if (solved[i])
+      res.solved[i / 8] |= 1 << (i % 8);
+  res.error_code.val = moveit_msgs::MoveItErrorCodes::SUCCESS;
+  return true;
+}
+
+bool move_group::MoveGroupKinematicsService::computeFKBatchService(
+    moveit_ros_move_group::GetPositionFKBatch::Request& req, moveit_ros_move_group::GetPositionFKBatch::Response& res)
+{
+  const robot_model::RobotModelConstPtr& robot_model = context_->planning_scene_monitor_->getRobotModel();
+  const robot_model::JointModelGroup* jmg = robot_model->getJointModelGroup(req.group_name);
+  if (!jmg)
+  {
+    res.error_code.val = moveit_msgs::MoveItErrorCodes::INVALID_GROUP_NAME;
+    return true;
+  }
+  const std::size_t dof = jmg->getVariableCount();
+  if (dof == 0 || req.positions.size() % dof != 0)
+  {
+    ROS_ERROR("The %u positions of the batch are not a multiple of the %u variables of group '%s'",
+              (unsigned int)req.positions.size(), (unsigned int)dof, req.group_name.c_str());
+    res.error_code.val = moveit_msgs::MoveItErrorCodes::INVALID_ROBOT_STATE;
+    return true;
+  }
+  std::vector<const robot_model::LinkModel*> links(req.fk_link_names.size());
+  for (std::size_t j = 0; j < links.size(); ++j)
+    if (!(links[j] = robot_model->getLinkModel(req.fk_link_names[j])))
+    {
+      res.error_code.val = moveit_msgs::MoveItErrorCodes::INVALID_LINK_NAME;
+      return true;
+    }
+
+  context_->planning_scene_monitor_->updateFrameTransforms();
+
+  // the poses are reported in the frame of the request, which is looked up once for the whole batch
+  const std::string& default_frame = robot_model->getModelFrame();
+  Eigen::Affine3d frame = Eigen::Affine3d::Identity();
+  res.header.frame_id = default_frame;
+  res.header.stamp = ros::Time::now();
+  if (!req.header.frame_id.empty() && !robot_state::Transforms::sameFrame(req.header.frame_id, default_frame) &&
+      context_->planning_scene_monitor_->getTFClient())
+  {
+    geometry_msgs::PoseStamped origin;
+    origin.header.frame_id = default_frame;
+    origin.header.stamp = req.header.stamp;
+    origin.pose.orientation.w = 1.0;
+    if (!performTransform(origin, req.header.frame_id))
+    {
+      res.error_code.val = moveit_msgs::MoveItErrorCodes::FRAME_TRANSFORM_FAILURE;
+      return true;
+    }
+    tf::poseMsgToEigen(origin.pose, frame);
+    res.header.frame_id = req.header.frame_id;
+  }
+
+  robot_state::RobotState start_state =
+      planning_scene_monitor::LockedPlanningSceneRO(context_->planning_scene_monitor_)->getCurrentState();
+  robot_state::robotStateMsgToRobotState(req.robot_state, start_state);
+
+  const std::size_t count = req.positions.size() / dof;
+  res.poses.resize(count * links.size());
+  processBatch(count, fk_batch_threads_,
+               boost::bind(&computeFK, &start_state, jmg, &links, &frame, &req.positions, &res.poses, _1, _2));
+  res.error_code.val = moveit_msgs::MoveItErrorCodes::SUCCESS;
+  return true;
+}
+
 #include <class_loader/class_loader.h>
 CLASS_LOADER_REGISTER_CLASS(move_group::MoveGroupKinematicsService, move_group::MoveGroupCapability)
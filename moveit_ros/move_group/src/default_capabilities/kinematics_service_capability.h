@@ -40,6 +40,8 @@
 #include <moveit/move_group/move_group_capability.h>
 #include <moveit_msgs/GetPositionIK.h>
 #include <moveit_msgs/GetPositionFK.h>
+#include <moveit_ros_move_group/GetPositionIKBatch.h>
+#include <moveit_ros_move_group/GetPositionFKBatch.h>
 
 namespace move_group
 {
@@ -53,6 +55,10 @@ public:
 private:
   bool computeIKService(moveit_msgs::GetPositionIK::Request& req, moveit_msgs::GetPositionIK::Response& res);
   bool computeFKService(moveit_msgs::GetPositionFK::Request& req, moveit_msgs::GetPositionFK::Response& res);
+  bool computeIKBatchService(moveit_ros_move_group::GetPositionIKBatch::Request& req,
+                             moveit_ros_move_group::GetPositionIKBatch::Response& res);
+  bool computeFKBatchService(moveit_ros_move_group::GetPositionFKBatch::Request& req,
+                             moveit_ros_move_group::GetPositionFKBatch::Response& res);
 
   void computeIK(
       moveit_msgs::PositionIKRequest& req, moveit_msgs::RobotState& solution, moveit_msgs::MoveItErrorCodes& error_code,
@@ -61,6 +67,12 @@ private:
 
   ros::ServiceServer fk_service_;
   ros::ServiceServer ik_service_;
+  ros::ServiceServer fk_batch_service_;
+  ros::ServiceServer ik_batch_service_;
+
+  /* the number of threads solving the queries of a batch; 0 uses one per core */
+  unsigned int ik_batch_threads_;
+  unsigned int fk_batch_threads_;
 };
 }
 
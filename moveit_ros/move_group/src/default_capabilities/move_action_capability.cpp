@@ -42,8 +42,18 @@
 #include <moveit/trajectory_processing/trajectory_tools.h>
 #include <moveit/kinematic_constraints/utils.h>
 #include <moveit/move_group/capability_names.h>
+#include <moveit/robot_state/conversions.h>
+#include <moveit/profiler/tracer.h>
+#include <moveit_msgs/DisplayTrajectory.h>
+#include <diagnostic_msgs/DiagnosticStatus.h>
+#include <boost/lexical_cast.hpp>
 
-move_group::MoveGroupMoveAction::MoveGroupMoveAction() : MoveGroupCapability("MoveAction"), move_state_(IDLE)
+move_group::MoveGroupMoveAction::MoveGroupMoveAction()
+  : MoveGroupCapability("MoveAction")
+  , publish_request_metrics_(false)
+  , request_count_(0)
+  , failed_request_count_(0)
+  , move_state_(IDLE)
 {
 }
 
@@ -54,14 +64,26 @@ void move_group::MoveGroupMoveAction::initialize()
       root_node_handle_, MOVE_ACTION, boost::bind(&MoveGroupMoveAction::executeMoveCallback, this, _1), false));
   move_action_server_->registerPreemptCallback(boost::bind(&MoveGroupMoveAction::preemptMoveCallback, this));
   move_action_server_->start();
+
+  intermediate_path_publisher_ =
+      root_node_handle_.advertise<moveit_msgs::DisplayTrajectory>(MOVE_ACTION_INTERMEDIATE_PATH_TOPIC, 10);
+
+  node_handle_.param("publish_request_metrics", publish_request_metrics_, false);
+  if (publish_request_metrics_)
+    request_metrics_publisher_ =
+        root_node_handle_.advertise<diagnostic_msgs::DiagnosticStatus>(MOVE_ACTION_METRICS_TOPIC, 10);
 }
 
 void move_group::MoveGroupMoveAction::executeMoveCallback(const moveit_msgs::MoveGroupGoalConstPtr& goal)
 {
+  MOVEIT_TRACE_SCOPE("MoveGroupMoveAction::executeMoveCallback");
+  resetRequestMetrics();
   setMoveState(PLANNING);
   // before we start planning, ensure that we have the latest robot state received...
+  ros::WallTime start = ros::WallTime::now();
   context_->planning_scene_monitor_->waitForCurrentRobotState(ros::Time::now());
   context_->planning_scene_monitor_->updateFrameTransforms();
+  addRequestMetric("wait_for_current_state", (ros::WallTime::now() - start).toSec());
 
   moveit_msgs::MoveGroupResult action_res;
   if (goal->planning_options.plan_only || !context_->allow_trajectory_execution_)
@@ -86,6 +108,7 @@ void move_group::MoveGroupMoveAction::executeMoveCallback(const moveit_msgs::Mov
     else
       move_action_server_->setAborted(action_res, response);
   }
+  publishRequestMetrics(action_res.error_code, response);
 
   setMoveState(IDLE);
 }
@@ -96,9 +119,14 @@ void move_group::MoveGroupMoveAction::executeMoveCallback_PlanAndExecute(const m
   ROS_INFO("Combined planning and execution request received for MoveGroup action. Forwarding to planning and "
            "execution pipeline.");
 
+  ros::WallTime start = ros::WallTime::now();
+  boost::unique_lock<boost::mutex> lock = serializeRequest();
+  addRequestMetric("wait_for_other_requests", (ros::WallTime::now() - start).toSec());
   if (planning_scene::PlanningScene::isEmpty(goal->planning_options.planning_scene_diff))
   {
+    start = ros::WallTime::now();
     planning_scene_monitor::LockedPlanningSceneRO lscene(context_->planning_scene_monitor_);
+    addRequestMetric("planning_scene_lock", (ros::WallTime::now() - start).toSec());
     const robot_state::RobotState& current_state = lscene->getCurrentState();
 
     // check to see if the desired constraints are already met
@@ -140,6 +168,8 @@ void move_group::MoveGroupMoveAction::executeMoveCallback_PlanAndExecute(const m
 
   plan_execution::ExecutableMotionPlan plan;
   context_->plan_execution_->planAndExecute(plan, planning_scene_diff, opt);
+  if (!execution_start_.isZero())
+    addRequestMetric("execution", (ros::WallTime::now() - execution_start_).toSec());
 
   convertToMsg(plan.plan_components_, action_res.trajectory_start, action_res.planned_trajectory);
   if (plan.executed_trajectory_)
@@ -152,6 +182,7 @@ void move_group::MoveGroupMoveAction::executeMoveCallback_PlanOnly(const moveit_
 {
   ROS_INFO("Planning request received for MoveGroup action. Forwarding to planning pipeline.");
 
+  ros::WallTime start = ros::WallTime::now();
   planning_scene_monitor::LockedPlanningSceneRO lscene(context_->planning_scene_monitor_);  // lock the scene so that it
                                                                                             // does not modify the world
                                                                                             // representation while
@@ -160,10 +191,11 @@ void move_group::MoveGroupMoveAction::executeMoveCallback_PlanOnly(const moveit_
       (planning_scene::PlanningScene::isEmpty(goal->planning_options.planning_scene_diff)) ?
           static_cast<const planning_scene::PlanningSceneConstPtr&>(lscene) :
           lscene->diff(goal->planning_options.planning_scene_diff);
+  addRequestMetric("planning_scene_lock", (ros::WallTime::now() - start).toSec());
   planning_interface::MotionPlanResponse res;
   try
   {
-    context_->planning_pipeline_->generatePlan(the_scene, goal->request, res);
+    generatePlan(the_scene, goal->request, res);
   }
   catch (std::exception& ex)
   {
@@ -181,12 +213,14 @@ bool move_group::MoveGroupMoveAction::planUsingPlanningPipeline(const planning_i
 {
   setMoveState(PLANNING);
 
+  ros::WallTime start = ros::WallTime::now();
   planning_scene_monitor::LockedPlanningSceneRO lscene(plan.planning_scene_monitor_);
+  addRequestMetric("planning_scene_lock", (ros::WallTime::now() - start).toSec());
   bool solved = false;
   planning_interface::MotionPlanResponse res;
   try
   {
-    solved = context_->planning_pipeline_->generatePlan(plan.planning_scene_, req, res);
+    solved = generatePlan(plan.planning_scene_, req, res);
   }
   catch (std::exception& ex)
   {
@@ -203,8 +237,40 @@ bool move_group::MoveGroupMoveAction::planUsingPlanningPipeline(const planning_i
   return solved;
 }
 
+bool move_group::MoveGroupMoveAction::generatePlan(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                                                   const planning_interface::MotionPlanRequest& req,
+                                                   planning_interface::MotionPlanResponse& res)
+{
+  std::vector<std::size_t> adapter_added_state_index;
+  planning_interface::IntermediateSolutionCallback callback;
+  if (intermediate_path_publisher_.getNumSubscribers() > 0)
+    callback = boost::bind(&MoveGroupMoveAction::publishIntermediateSolution, this, _1);
+  ros::WallTime start = ros::WallTime::now();
+  bool solved =
+      context_->planning_pipeline_->generatePlan(planning_scene, req, res, adapter_added_state_index, callback);
+  addRequestMetric("planning", (ros::WallTime::now() - start).toSec());
+  addPlanningMetrics(res);
+  return solved;
+}
+
+void move_group::MoveGroupMoveAction::publishIntermediateSolution(
+    const robot_trajectory::RobotTrajectoryPtr& trajectory)
+{
+  if (trajectory->empty())
+    return;
+  moveit_msgs::DisplayTrajectory disp;
+  disp.model_id = trajectory->getRobotModel()->getName();
+  disp.trajectory.resize(1);
+  trajectory->getRobotTrajectoryMsg(disp.trajectory[0]);
+  robot_state::robotStateToRobotStateMsg(trajectory->getFirstWayPoint(), disp.trajectory_start);
+  intermediate_path_publisher_.publish(disp);
+}
+
 void move_group::MoveGroupMoveAction::startMoveExecutionCallback()
 {
+  // with replanning, execution counts from the start of the first trajectory
+  if (execution_start_.isZero())
+    execution_start_ = ros::WallTime::now();
   setMoveState(MONITOR);
 }
 
@@ -225,5 +291,66 @@ void move_group::MoveGroupMoveAction::setMoveState(MoveGroupState state)
   move_action_server_->publishFeedback(move_feedback_);
 }
 
+void move_group::MoveGroupMoveAction::resetRequestMetrics()
+{
+  request_metrics_.clear();
+  request_start_ = ros::WallTime::now();
+  execution_start_ = ros::WallTime();
+}
+
+void move_group::MoveGroupMoveAction::addRequestMetric(const std::string& key, double value)
+{
+  if (!publish_request_metrics_)
+    return;
+  for (std::size_t i = 0; i < request_metrics_.size(); ++i)
+    if (request_metrics_[i].first == key)
+    {
+      request_metrics_[i].second += value;
+      return;
+    }
+  request_metrics_.push_back(std::make_pair(key, value));
+}
+
+void move_group::MoveGroupMoveAction::addPlanningMetrics(const planning_interface::MotionPlanResponse& res)
+{
+  if (!publish_request_metrics_)
+    return;
+  for (std::size_t i = 0; i < res.stage_description_.size() && i < res.stage_processing_time_.size(); ++i)
+    addRequestMetric("stage/" + res.stage_description_[i], res.stage_processing_time_[i]);
+  for (std::map<std::string, double>::const_iterator it = res.statistics_.begin(); it != res.statistics_.end(); ++it)
+    addRequestMetric("planner/" + it->first, it->second);
+}
+
+void move_group::MoveGroupMoveAction::publishRequestMetrics(const moveit_msgs::MoveItErrorCodes& error_code,
+                                                            const std::string& message)
+{
+  if (!publish_request_metrics_)
+    return;
+  ++request_count_;
+  if (error_code.val != moveit_msgs::MoveItErrorCodes::SUCCESS)
+    ++failed_request_count_;
+
+  diagnostic_msgs::DiagnosticStatus status;
+  status.level = error_code.val == moveit_msgs::MoveItErrorCodes::SUCCESS ? diagnostic_msgs::DiagnosticStatus::OK :
+                                                                             diagnostic_msgs::DiagnosticStatus::WARN;
+  status.name = root_node_handle_.resolveName(MOVE_ACTION);
+  status.message = message;
+  status.values.resize(request_metrics_.size() + 4);
+  status.values[0].key = "total";
+  status.values[0].value = boost::lexical_cast<std::string>((ros::WallTime::now() - request_start_).toSec());
+  status.values[1].key = "error_code";
+  status.values[1].value = boost::lexical_cast<std::string>(error_code.val);
+  status.values[2].key = "requests";
+  status.values[2].value = boost::lexical_cast<std::string>(request_count_);
+  status.values[3].key = "failed_requests";
+  status.values[3].value = boost::lexical_cast<std::string>(failed_request_count_);
+  for (std::size_t i = 0; i < request_metrics_.size(); ++i)
+  {
+    status.values[i + 4].key = request_metrics_[i].first;
+    status.values[i + 4].value = boost::lexical_cast<std::string>(request_metrics_[i].second);
+  }
+  request_metrics_publisher_.publish(status);
+}
+
 #include <class_loader/class_loader.h>
 CLASS_LOADER_REGISTER_CLASS(move_group::MoveGroupMoveAction, move_group::MoveGroupCapability)
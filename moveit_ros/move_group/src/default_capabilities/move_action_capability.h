@@ -41,6 +41,8 @@
 #include <actionlib/server/simple_action_server.h>
 #include <moveit_msgs/MoveGroupAction.h>
 #include <memory>
+#include <utility>
+#include <vector>
 
 namespace move_group
 {
@@ -63,10 +65,36 @@ private:
   void setMoveState(MoveGroupState state);
   bool planUsingPlanningPipeline(const planning_interface::MotionPlanRequest& req,
                                  plan_execution::ExecutableMotionPlan& plan);
+  bool generatePlan(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                    const planning_interface::MotionPlanRequest& req, planning_interface::MotionPlanResponse& res);
+  void publishIntermediateSolution(const robot_trajectory::RobotTrajectoryPtr& trajectory);
+
+  /// Start collecting the latency breakdown of a new request
+  void resetRequestMetrics();
+  /// Add \e value (in seconds, or a count) to the metric \e key of the current request; no-op unless enabled
+  void addRequestMetric(const std::string& key, double value);
+  /// Add the times of the planning stages and the statistics of the planner reported in \e res
+  void addPlanningMetrics(const planning_interface::MotionPlanResponse& res);
+  void publishRequestMetrics(const moveit_msgs::MoveItErrorCodes& error_code, const std::string& message);
 
   std::unique_ptr<actionlib::SimpleActionServer<moveit_msgs::MoveGroupAction> > move_action_server_;
   moveit_msgs::MoveGroupFeedback move_feedback_;
 
+  /// the improving solutions found while planning, as moveit_msgs::DisplayTrajectory; these are computed only while
+  /// there are subscribers
+  ros::Publisher intermediate_path_publisher_;
+
+  /// whether the latency breakdown of each request is published on MOVE_ACTION_METRICS_TOPIC, as a
+  /// diagnostic_msgs::DiagnosticStatus (parameter ~publish_request_metrics)
+  bool publish_request_metrics_;
+  ros::Publisher request_metrics_publisher_;
+  /// the metrics of the request being processed, in the order in which they were first added
+  std::vector<std::pair<std::string, double> > request_metrics_;
+  ros::WallTime request_start_;
+  ros::WallTime execution_start_;
+  std::size_t request_count_;
+  std::size_t failed_request_count_;
+
   MoveGroupState move_state_;
 };
 }
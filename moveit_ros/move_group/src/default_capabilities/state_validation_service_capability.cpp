@@ -42,7 +42,7 @@
 #include <moveit/move_group/capability_names.h>
 
 move_group::MoveGroupStateValidationService::MoveGroupStateValidationService()
-  : MoveGroupCapability("StateValidationService")
+  : MoveGroupCapability("StateValidationService"), batch_threads_(0)
 {
 }
 
@@ -50,6 +50,33 @@ void move_group::MoveGroupStateValidationService::initialize()
 {
   validity_service_ = root_node_handle_.advertiseService(STATE_VALIDITY_SERVICE_NAME,
                                                          &MoveGroupStateValidationService::computeService, this);
+
+  // the number of threads checking the states of a batch; 0 uses one per core
+  int batch_threads = 0;
+  node_handle_.param("state_validity_batch_threads", batch_threads, 0);
+  batch_threads_ = std::max(batch_threads, 0);
+  validity_batch_service_ = root_node_handle_.advertiseService(
+      STATE_VALIDITY_BATCH_SERVICE_NAME, &MoveGroupStateValidationService::computeBatchService, this);
+}
+
+namespace
+{
+void checkStates(const planning_scene::PlanningScene* scene, const kinematic_constraints::KinematicConstraintSet* kset,
+                 const robot_state::RobotState* start_state, const robot_model::JointModelGroup* jmg,
+                 const std::vector<double>* positions, std::vector<char>* valid, std::size_t begin, std::size_t end)
+{
+  robot_state::RobotState state(*start_state);
+  collision_detection::CollisionRequest creq;
+  creq.group_name = jmg->getName();
+  for (std::size_t i = begin; i < end; ++i)
+  {
+    state.setJointGroupPositions(jmg, &(*positions)[i * jmg->getVariableCount()]);
+    state.update();
+    collision_detection::CollisionResult cres;
+    scene->checkCollision(creq, cres, state);
+    (*valid)[i] = !cres.collision && (kset->empty() || kset->isSatisfied(state));
+  }
+}
 }
 
 bool move_group::MoveGroupStateValidationService::computeService(moveit_msgs::GetStateValidity::Request& req,
@@ -122,5 +149,45 @@ bool move_group::MoveGroupStateValidationService::computeService(moveit_msgs::Ge
   return true;
 }
 
+bool move_group::MoveGroupStateValidationService::computeBatchService(
+    moveit_ros_move_group::GetStateValidityBatch::Request& req,
+    moveit_ros_move_group::GetStateValidityBatch::Response& res)
+{
+  planning_scene_monitor::LockedPlanningSceneRO ls(context_->planning_scene_monitor_);
+  const robot_model::JointModelGroup* jmg = ls->getRobotModel()->getJointModelGroup(req.group_name);
+  if (!jmg)
+  {
+    res.error_code.val = moveit_msgs::MoveItErrorCodes::INVALID_GROUP_NAME;
+    return true;
+  }
+  const std::size_t dof = jmg->getVariableCount();
+  if (dof == 0 || req.positions.size() % dof != 0)
+  {
+    ROS_ERROR("The %u positions of the batch are not a multiple of the %u variables of group '%s'",
+              (unsigned int)req.positions.size(), (unsigned int)dof, req.group_name.c_str());
+    res.error_code.val = moveit_msgs::MoveItErrorCodes::INVALID_ROBOT_STATE;
+    return true;
+  }
+
+  robot_state::RobotState start_state = ls->getCurrentState();
+  robot_state::robotStateMsgToRobotState(req.robot_state, start_state);
+  kinematic_constraints::KinematicConstraintSet kset(ls->getRobotModel());
+  kset.add(req.constraints, ls->getTransforms());
+
+  const std::size_t count = req.positions.size() / dof;
+  std::vector<char> valid(count, 0);
+  processBatch(count, batch_threads_,
+               boost::bind(&checkStates, static_cast<const planning_scene::PlanningSceneConstPtr&>(ls).get(), &kset,
+                           &start_state, jmg, &req.positions, &valid, _1, _2));
+
+  res.count = count;
+  res.valid.resize((count + 7) / 8, 0);
+  for (std::size_t i = 0; i < count; ++i)
+    if (valid[i])
+      res.valid[i / 8] |= 1 << (i % 8);
+  res.error_code.val = moveit_msgs::MoveItErrorCodes::SUCCESS;
+  return true;
+}
+
 #include <class_loader/class_loader.h>
 CLASS_LOADER_REGISTER_CLASS(move_group::MoveGroupStateValidationService, move_group::MoveGroupCapability)
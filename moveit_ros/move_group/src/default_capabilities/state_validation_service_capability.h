@@ -39,6 +39,7 @@
 
 #include <moveit/move_group/move_group_capability.h>
 #include <moveit_msgs/GetStateValidity.h>
+#include <moveit_ros_move_group/GetStateValidityBatch.h>
 
 namespace move_group
 {
@@ -51,8 +52,12 @@ public:
 
 private:
   bool computeService(moveit_msgs::GetStateValidity::Request& req, moveit_msgs::GetStateValidity::Response& res);
+  bool computeBatchService(moveit_ros_move_group::GetStateValidityBatch::Request& req,
+                           moveit_ros_move_group::GetStateValidityBatch::Response& res);
 
   ros::ServiceServer validity_service_;
+  ros::ServiceServer validity_batch_service_;
+  unsigned int batch_threads_;
 };
 }
 
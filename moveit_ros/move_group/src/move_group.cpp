@@ -53,13 +53,15 @@ namespace move_group
 class MoveGroupExe
 {
 public:
-  MoveGroupExe(const planning_scene_monitor::PlanningSceneMonitorPtr& psm, bool debug) : node_handle_("~")
+  MoveGroupExe(const planning_scene_monitor::PlanningSceneMonitorPtr& psm, bool debug, bool concurrent_requests)
+    : node_handle_("~")
   {
     // if the user wants to be able to disable execution of paths, they can just set this ROS param to false
     bool allow_trajectory_execution;
     node_handle_.param("allow_trajectory_execution", allow_trajectory_execution, true);
 
     context_.reset(new MoveGroupContext(psm, allow_trajectory_execution, debug));
+    context_->concurrent_requests_ = concurrent_requests;
 
     // start the capabilities
     configureCapabilities();
@@ -170,7 +172,16 @@ int main(int argc, char** argv)
 {
   ros::init(argc, argv, move_group::NODE_NAME);
 
-  ros::AsyncSpinner spinner(1);
+  // with more than one request thread, capability requests are handled concurrently
+  int request_threads = 1;
+  ros::NodeHandle("~").param("request_threads", request_threads, 1);
+  if (request_threads < 1)
+  {
+    ROS_WARN("Param 'request_threads' must be at least 1. Using a single request thread.");
+    request_threads = 1;
+  }
+
+  ros::AsyncSpinner spinner(request_threads);
   spinner.start();
 
   boost::shared_ptr<tf::TransformListener> tf(new tf::TransformListener(ros::Duration(10.0)));
@@ -196,9 +207,35 @@ int main(int argc, char** argv)
     planning_scene_monitor->startSceneMonitor();
     planning_scene_monitor->startWorldGeometryMonitor();
     planning_scene_monitor->startStateMonitor();
+
+    // let planners read immutable copies of the scene instead of waiting for scene updates
+    bool scene_snapshots = false;
+    ros::NodeHandle("~").param("planning_scene_snapshots", scene_snapshots, false);
+    if (request_threads > 1 && !scene_snapshots)
+    {
+      // concurrent requests each read the snapshot taken when they start, so they do not contend for the scene lock
+      ROS_INFO("Enabling planning scene snapshots for %d request threads", request_threads);
+      scene_snapshots = true;
+    }
+    planning_scene_monitor->setSceneSnapshotsEnabled(scene_snapshots);
+
+    // send only the changed octomap leaves to subscribers of the monitored planning scene
+    bool octomap_diffs = false;
+    ros::NodeHandle("~").param("publish_octomap_diffs", octomap_diffs, false);
+    planning_scene_monitor->setPublishOctomapDiffs(octomap_diffs);
+
+    // apply bursts of collision objects and octomap updates as one scene update
+    double coalescing_window = 0.0;
+    ros::NodeHandle("~").param("scene_update_coalescing_window", coalescing_window, 0.0);
+    planning_scene_monitor->setSceneUpdateCoalescingWindow(coalescing_window);
+
+    // let monitors on the same host read the published scenes from shared memory
+    std::string shared_memory_segment;
+    ros::NodeHandle("~").param("shared_memory_scene_segment", shared_memory_segment, std::string());
+    planning_scene_monitor->setSharedMemoryPublishing(shared_memory_segment);
     printf(MOVEIT_CONSOLE_COLOR_CYAN "Context monitors started.\n" MOVEIT_CONSOLE_COLOR_RESET);
 
-    move_group::MoveGroupExe mge(planning_scene_monitor, debug);
+    move_group::MoveGroupExe mge(planning_scene_monitor, debug, request_threads > 1);
 
     planning_scene_monitor->publishDebugInformation(debug);
 
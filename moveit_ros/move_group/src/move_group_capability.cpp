@@ -36,12 +36,49 @@
 
 #include <moveit/move_group/move_group_capability.h>
 #include <moveit/robot_state/conversions.h>
+#include <boost/thread.hpp>
+#include <atomic>
+
+namespace
+{
+void processRanges(std::size_t count, std::size_t range_size, std::atomic<std::size_t>* next,
+                   const boost::function<void(std::size_t, std::size_t)>* fn)
+{
+  for (std::size_t begin = next->fetch_add(range_size); begin < count; begin = next->fetch_add(range_size))
+    (*fn)(begin, std::min(begin + range_size, count));
+}
+}
 
 void move_group::MoveGroupCapability::setContext(const MoveGroupContextPtr& context)
 {
   context_ = context;
 }
 
+boost::unique_lock<boost::mutex> move_group::MoveGroupCapability::serializeRequest() const
+{
+  if (context_->concurrent_requests_)
+    return boost::unique_lock<boost::mutex>(context_->serialized_requests_mutex_);
+  return boost::unique_lock<boost::mutex>();
+}
+
+void move_group::MoveGroupCapability::processBatch(std::size_t count, unsigned int thread_count,
+                                                   const boost::function<void(std::size_t, std::size_t)>& fn) const
+{
+  if (count == 0)
+    return;
+  std::size_t threads = thread_count > 0 ? thread_count : boost::thread::hardware_concurrency();
+  threads = std::max<std::size_t>(1, std::min<std::size_t>(threads, count));
+
+  // several ranges per thread, so that threads that finish early take over work from slower ones
+  const std::size_t range_size = std::max<std::size_t>(1, count / (threads * 8));
+  std::atomic<std::size_t> next(0);
+  boost::thread_group workers;
+  for (std::size_t i = 1; i < threads; ++i)
+    workers.create_thread(boost::bind(&processRanges, count, range_size, &next, &fn));
+  processRanges(count, range_size, &next, &fn);
+  workers.join_all();
+}
+
 void move_group::MoveGroupCapability::convertToMsg(const std::vector<plan_execution::ExecutableTrajectory>& trajectory,
                                                    moveit_msgs::RobotState& first_state_msg,
                                                    std::vector<moveit_msgs::RobotTrajectory>& trajectory_msg) const
@@ -46,6 +46,7 @@ move_group::MoveGroupContext::MoveGroupContext(
   : planning_scene_monitor_(planning_scene_monitor)
   , allow_trajectory_execution_(allow_trajectory_execution)
   , debug_(debug)
+  , concurrent_requests_(false)
 {
   planning_pipeline_.reset(new planning_pipeline::PlanningPipeline(planning_scene_monitor_->getRobotModel()));
 
@@ -90,6 +90,14 @@ private:
   unsigned int skip_vertical_pixels_;
   unsigned int skip_horizontal_pixels_;
 
+  /* back-project the depth image and compute its octree keys on the GPU, in the mesh filter's context */
+  bool compute_keys_on_gpu_;
+
+  /* batching of the free space ray casting, see LazyFreeSpaceUpdater */
+  unsigned int free_space_max_batch_size_;
+  double free_space_max_batch_delay_;
+  double free_space_max_frame_age_;
+
   unsigned int image_callback_count_;
   double average_callback_dt_;
   unsigned int good_tf_;
@@ -101,6 +109,7 @@ private:
   std::vector<float> x_cache_, y_cache_;
   double inv_fx_, inv_fy_, K0_, K2_, K4_, K5_;
   std::vector<unsigned int> filtered_labels_;
+  std::vector<unsigned short> filtered_keys_;
   ros::WallTime last_depth_callback_start_;
 };
 }
@@ -61,6 +61,10 @@ DepthImageOctomapUpdater::DepthImageOctomapUpdater()
   , padding_offset_(0.02)
   , skip_vertical_pixels_(4)
   , skip_horizontal_pixels_(6)
+  , compute_keys_on_gpu_(false)
+  , free_space_max_batch_size_(10)
+  , free_space_max_batch_delay_(0.2)
+  , free_space_max_frame_age_(1.0)
   , image_callback_count_(0)
   , average_callback_dt_(0.0)
   , good_tf_(5)
@@ -95,6 +99,11 @@ bool DepthImageOctomapUpdater::setParams(XmlRpc::XmlRpcValue& params)
     readXmlParam(params, "padding_offset", &padding_offset_);
     readXmlParam(params, "skip_vertical_pixels", &skip_vertical_pixels_);
     readXmlParam(params, "skip_horizontal_pixels", &skip_horizontal_pixels_);
+    readXmlParam(params, "free_space_max_batch_size", &free_space_max_batch_size_);
+    readXmlParam(params, "free_space_max_batch_delay", &free_space_max_batch_delay_);
+    readXmlParam(params, "free_space_max_frame_age", &free_space_max_frame_age_);
+    if (params.hasMember("compute_keys_on_gpu"))
+      compute_keys_on_gpu_ = static_cast<bool>(params["compute_keys_on_gpu"]);
     if (params.hasMember("filtered_cloud_topic"))
       filtered_cloud_topic_ = static_cast<const std::string&>(params["filtered_cloud_topic"]);
   }
@@ -110,7 +119,8 @@ bool DepthImageOctomapUpdater::setParams(XmlRpc::XmlRpcValue& params)
 bool DepthImageOctomapUpdater::initialize()
 {
   tf_ = monitor_->getTFClient();
-  free_space_updater_.reset(new LazyFreeSpaceUpdater(tree_));
+  free_space_updater_.reset(new LazyFreeSpaceUpdater(tree_, free_space_max_batch_size_, free_space_max_batch_delay_,
+                                                     free_space_max_frame_age_));
 
   // create our mesh filter
   mesh_filter_.reset(new mesh_filter::MeshFilter<mesh_filter::StereoCameraModel>(
@@ -371,9 +381,10 @@ void DepthImageOctomapUpdater::depthImageCallback(const sensor_msgs::ImageConstP
   if (filtered_labels_.size() < img_size)
     filtered_labels_.resize(img_size);
 
-  // get the labels of the filtered data
+  // get the labels of the filtered data; they are only looked at on the GPU when it computes the keys
   const unsigned int* labels_row = &filtered_labels_[0];
-  mesh_filter_->getFilteredLabels(&filtered_labels_[0]);
+  if (!compute_keys_on_gpu_)
+    mesh_filter_->getFilteredLabels(&filtered_labels_[0]);
 
   // publish debug information if needed
   if (debug_info_)
@@ -444,7 +455,33 @@ void DepthImageOctomapUpdater::depthImageCallback(const sensor_msgs::ImageConstP
     const int h_bound = h - skip_vertical_pixels_;
     const int w_bound = w - skip_horizontal_pixels_;
 
-    if (is_u_short)
+    if (compute_keys_on_gpu_)
+    {
+      // back-projection, transformation and discretization happened on the GPU; only the sets are built here
+      Eigen::Affine3f map_H_sensor_eigen = Eigen::Affine3f::Identity();
+      const tf::Matrix3x3& basis = map_H_sensor.getBasis();
+      for (int i = 0; i < 3; ++i)
+      {
+        for (int j = 0; j < 3; ++j)
+          map_H_sensor_eigen.linear()(i, j) = basis[i][j];
+        map_H_sensor_eigen.translation()[i] = map_H_sensor.getOrigin()[i];
+      }
+      if (filtered_keys_.size() < 4 * img_size)
+        filtered_keys_.resize(4 * img_size);
+      mesh_filter_->getFilteredKeys(map_H_sensor_eigen, info_msg->K[0], info_msg->K[4], px, py,
+                                    tree_->getResolution(), &filtered_keys_[0]);
+
+      for (int y = skip_vertical_pixels_; y < h_bound; ++y)
+      {
+        const unsigned short* key = &filtered_keys_[4 * (y * w + skip_horizontal_pixels_)];
+        for (int x = skip_horizontal_pixels_; x < w_bound; ++x, key += 4)
+          if (key[3] == mesh_filter::MeshFilterBase::OccupiedKey)
+            occupied_cells.insert(octomap::OcTreeKey(key[0], key[1], key[2]));
+          else if (key[3] == mesh_filter::MeshFilterBase::ModelKey)
+            model_cells.insert(octomap::OcTreeKey(key[0], key[1], key[2]));
+      }
+    }
+    else if (is_u_short)
     {
       const uint16_t* input_row = reinterpret_cast<const uint16_t*>(&depth_msg->data[0]);
 
@@ -516,19 +553,24 @@ void DepthImageOctomapUpdater::depthImageCallback(const sensor_msgs::ImageConstP
     occupied_cells.erase(*it);
 
   // mark occupied cells
-  tree_->lockWrite();
-  try
-  {
-    /* now mark all occupied cells */
-    for (octomap::KeySet::iterator it = occupied_cells.begin(), end = occupied_cells.end(); it != end; ++it)
-      tree_->updateNode(*it, true);
-  }
-  catch (...)
+  if (OccupancyMapUpdateMerger* merger = monitor_->getUpdateMerger())
+    merger->pushUpdate(octomap::KeySet(), occupied_cells, octomap::KeySet());
+  else
   {
-    ROS_ERROR("Internal error while updating octree");
+    tree_->lockWrite();
+    try
+    {
+      /* now mark all occupied cells */
+      for (octomap::KeySet::iterator it = occupied_cells.begin(), end = occupied_cells.end(); it != end; ++it)
+        tree_->updateNode(*it, true);
+    }
+    catch (...)
+    {
+      ROS_ERROR("Internal error while updating octree");
+    }
+    tree_->unlockWrite();
+    tree_->triggerUpdateCallback();
   }
-  tree_->unlockWrite();
-  tree_->triggerUpdateCallback();
 
   // at this point we still have not freed the space
   free_space_updater_->pushLazyUpdate(occupied_cells_ptr, model_cells_ptr, sensor_origin);
@@ -38,7 +38,9 @@
 #define MOVEIT_OCCUPANCY_MAP_MONITOR_LAZY_FREE_SPACE_UPDATER_
 
 #include <moveit/occupancy_map_monitor/occupancy_map.h>
+#include <ros/time.h>
 #include <boost/thread.hpp>
+#include <atomic>
 #include <deque>
 
 namespace occupancy_map_monitor
@@ -46,12 +48,28 @@ namespace occupancy_map_monitor
 class LazyFreeSpaceUpdater
 {
 public:
-  LazyFreeSpaceUpdater(const OccMapTreePtr& tree, unsigned int max_batch_size = 10);
+  /** \brief Frames pushed from the same sensor origin are coalesced into one ray casting batch of up to
+      \e max_batch_size frames. A batch is processed at the latest \e max_batch_delay seconds after its first frame
+      was pushed, and frames still queued \e max_frame_age seconds after they were pushed are dropped. */
+  LazyFreeSpaceUpdater(const OccMapTreePtr& tree, unsigned int max_batch_size = 10, double max_batch_delay = 0.2,
+                       double max_frame_age = 1.0);
   ~LazyFreeSpaceUpdater();
 
   void pushLazyUpdate(octomap::KeySet* occupied_cells, octomap::KeySet* model_cells,
                       const octomap::point3d& sensor_origin);
 
+  /** \brief The number of frames pushed but not passed on to ray casting yet */
+  std::size_t getBacklog() const
+  {
+    return backlog_;
+  }
+
+  /** \brief The number of frames dropped so far, because they got too old or the ray casting could not keep up */
+  std::size_t getDroppedFrameCount() const
+  {
+    return dropped_frames_;
+  }
+
 private:
 #ifdef __APPLE__
   typedef std::unordered_map<octomap::OcTreeKey, unsigned int, octomap::OcTreeKey::KeyHash> OcTreeKeyCountMap;
@@ -59,9 +77,14 @@ private:
   typedef std::tr1::unordered_map<octomap::OcTreeKey, unsigned int, octomap::OcTreeKey::KeyHash> OcTreeKeyCountMap;
 #endif
 
-  void pushBatchToProcess(OcTreeKeyCountMap* occupied_cells, octomap::KeySet* model_cells,
+  /** \brief Hand a batch to processThread(). Returns false, keeping ownership of the sets with the caller, if the
+      previous batch is still being processed */
+  bool pushBatchToProcess(OcTreeKeyCountMap* occupied_cells, octomap::KeySet* model_cells,
                           const octomap::point3d& sensor_origin);
 
+  /** \brief Drop the queued frames older than max_frame_age_; called with update_cell_sets_lock_ held */
+  void dropStaleFrames();
+
   void lazyUpdateThread();
   void processThread();
 
@@ -69,10 +92,15 @@ private:
   bool running_;
   std::size_t max_batch_size_;
   double max_sensor_delta_;
+  ros::WallDuration max_batch_delay_;
+  ros::WallDuration max_frame_age_;
 
   std::deque<octomap::KeySet*> occupied_cells_sets_;
   std::deque<octomap::KeySet*> model_cells_sets_;
   std::deque<octomap::point3d> sensor_origins_;
+  std::deque<ros::WallTime> push_times_;
+  std::atomic<std::size_t> backlog_;
+  std::atomic<std::size_t> dropped_frames_;
   boost::condition_variable update_condition_;
   boost::mutex update_cell_sets_lock_;
 
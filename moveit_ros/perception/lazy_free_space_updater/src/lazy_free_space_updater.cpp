@@ -36,16 +36,21 @@
 
 #include <moveit/lazy_free_space_updater/lazy_free_space_updater.h>
 #include <ros/console.h>
+#include <algorithm>
 
 namespace occupancy_map_monitor
 {
-LazyFreeSpaceUpdater::LazyFreeSpaceUpdater(const OccMapTreePtr& tree, unsigned int max_batch_size)
+LazyFreeSpaceUpdater::LazyFreeSpaceUpdater(const OccMapTreePtr& tree, unsigned int max_batch_size,
+                                           double max_batch_delay, double max_frame_age)
   : tree_(tree)
   , running_(true)
-  , max_batch_size_(max_batch_size)
-  , max_sensor_delta_(1e-3)
-  ,  // 1mm
-  process_occupied_cells_set_(NULL)
+  , max_batch_size_(std::max(1u, max_batch_size))
+  , max_sensor_delta_(1e-3)  // 1mm
+  , max_batch_delay_(max_batch_delay)
+  , max_frame_age_(max_frame_age)
+  , backlog_(0)
+  , dropped_frames_(0)
+  , process_occupied_cells_set_(NULL)
   , process_model_cells_set_(NULL)
   , update_thread_(boost::bind(&LazyFreeSpaceUpdater::lazyUpdateThread, this))
   , process_thread_(boost::bind(&LazyFreeSpaceUpdater::processThread, this))
@@ -76,28 +81,50 @@ void LazyFreeSpaceUpdater::pushLazyUpdate(octomap::KeySet* occupied_cells, octom
   occupied_cells_sets_.push_back(occupied_cells);
   model_cells_sets_.push_back(model_cells);
   sensor_origins_.push_back(sensor_origin);
+  push_times_.push_back(ros::WallTime::now());
+  backlog_++;
   update_condition_.notify_one();
 }
 
-void LazyFreeSpaceUpdater::pushBatchToProcess(OcTreeKeyCountMap* occupied_cells, octomap::KeySet* model_cells,
+bool LazyFreeSpaceUpdater::pushBatchToProcess(OcTreeKeyCountMap* occupied_cells, octomap::KeySet* model_cells,
                                               const octomap::point3d& sensor_origin)
 {
-  // this is basically a queue of size 1. if this function is called repeatedly without any work being done by
-  // processThread(),
-  // data can be lost; this is intentional, to avoid spending too much time clearing the octomap
-  if (cell_process_lock_.try_lock())
+  // this is basically a queue of size 1; the lock is held by processThread() while a batch is being ray cast, in
+  // which case the caller keeps the batch and decides whether to coalesce more frames into it or to drop it
+  if (!cell_process_lock_.try_lock())
+    return false;
+  bool accepted = process_occupied_cells_set_ == NULL;
+  if (accepted)
   {
     process_occupied_cells_set_ = occupied_cells;
     process_model_cells_set_ = model_cells;
     process_sensor_origin_ = sensor_origin;
     process_condition_.notify_one();
-    cell_process_lock_.unlock();
   }
-  else
+  cell_process_lock_.unlock();
+  return accepted;
+}
+
+void LazyFreeSpaceUpdater::dropStaleFrames()
+{
+  const ros::WallTime now = ros::WallTime::now();
+  std::size_t dropped = 0;
+  while (!push_times_.empty() && now - push_times_.front() > max_frame_age_)
   {
-    ROS_WARN("Previous batch update did not complete. Ignoring set of cells to be freed.");
-    delete occupied_cells;
-    delete model_cells;
+    delete occupied_cells_sets_.front();
+    occupied_cells_sets_.pop_front();
+    delete model_cells_sets_.front();
+    model_cells_sets_.pop_front();
+    sensor_origins_.pop_front();
+    push_times_.pop_front();
+    dropped++;
+  }
+  if (dropped > 0)
+  {
+    backlog_ -= dropped;
+    dropped_frames_ += dropped;
+    ROS_WARN_THROTTLE(1.0, "Dropped %lu frames older than %lf s waiting to be freed (%lu dropped in total)",
+                      (long unsigned int)dropped, max_frame_age_.toSec(), (long unsigned int)dropped_frames_);
   }
 }
 
@@ -198,6 +225,11 @@ void LazyFreeSpaceUpdater::processThread()
     process_occupied_cells_set_ = NULL;
     delete process_model_cells_set_;
     process_model_cells_set_ = NULL;
+    ulock.unlock();
+
+    // wake up lazyUpdateThread() in case it holds a batch it could not hand over while this one was processed
+    boost::mutex::scoped_lock _(update_cell_sets_lock_);
+    update_condition_.notify_one();
   }
 }
 
@@ -206,62 +238,107 @@ void LazyFreeSpaceUpdater::lazyUpdateThread()
   OcTreeKeyCountMap* occupied_cells_set = NULL;
   octomap::KeySet* model_cells_set = NULL;
   octomap::point3d sensor_origin;
+  ros::WallTime batch_start;
   unsigned int batch_size = 0;
+  // set while processThread() is busy; the batch then keeps growing past max_batch_size_ instead of queueing frames
+  bool coalescing = false;
 
+  boost::unique_lock<boost::mutex> ulock(update_cell_sets_lock_);
   while (running_)
   {
-    boost::unique_lock<boost::mutex> ulock(update_cell_sets_lock_);
-    while (occupied_cells_sets_.empty() && running_)
-      update_condition_.wait(ulock);
-
-    if (!running_)
-      break;
-
-    if (batch_size == 0)
-    {
-      occupied_cells_set = new OcTreeKeyCountMap();
-      octomap::KeySet* s = occupied_cells_sets_.front();
-      occupied_cells_sets_.pop_front();
-      for (octomap::KeySet::iterator it = s->begin(), end = s->end(); it != end; ++it)
-        (*occupied_cells_set)[*it]++;
-      delete s;
-      model_cells_set = model_cells_sets_.front();
-      model_cells_sets_.pop_front();
-      sensor_origin = sensor_origins_.front();
-      sensor_origins_.pop_front();
-      batch_size++;
-    }
+    dropStaleFrames();
 
-    while (!occupied_cells_sets_.empty())
+    /* merge the queued frames that were taken from the same sensor origin into the current batch */
+    bool origin_changed = false;
+    while (!occupied_cells_sets_.empty() && (coalescing || batch_size < max_batch_size_))
     {
-      if ((sensor_origins_.front() - sensor_origin).norm() > max_sensor_delta_)
+      if (batch_size > 0 && (sensor_origins_.front() - sensor_origin).norm() > max_sensor_delta_)
       {
-        ROS_DEBUG("Pushing %u sets of occupied/model cells to free cells update thread (origin changed)", batch_size);
-        pushBatchToProcess(occupied_cells_set, model_cells_set, sensor_origin);
-        batch_size = 0;
+        origin_changed = true;
         break;
       }
-      sensor_origins_.pop_front();
 
       octomap::KeySet* add_occ = occupied_cells_sets_.front();
+      octomap::KeySet* add_mod = model_cells_sets_.front();
+      if (batch_size == 0)
+      {
+        occupied_cells_set = new OcTreeKeyCountMap();
+        model_cells_set = add_mod;
+        sensor_origin = sensor_origins_.front();
+        batch_start = push_times_.front();
+      }
+      else
+      {
+        model_cells_set->insert(add_mod->begin(), add_mod->end());
+        delete add_mod;
+      }
       for (octomap::KeySet::iterator it = add_occ->begin(), end = add_occ->end(); it != end; ++it)
         (*occupied_cells_set)[*it]++;
-      occupied_cells_sets_.pop_front();
       delete add_occ;
-      octomap::KeySet* mod_occ = model_cells_sets_.front();
-      model_cells_set->insert(mod_occ->begin(), mod_occ->end());
+
+      occupied_cells_sets_.pop_front();
       model_cells_sets_.pop_front();
-      delete mod_occ;
+      sensor_origins_.pop_front();
+      push_times_.pop_front();
       batch_size++;
     }
 
-    if (batch_size >= max_batch_size_)
+    if (batch_size == 0)
+    {
+      if (running_)
+        update_condition_.wait(ulock);
+      continue;
+    }
+
+    /* wait for more frames unless the batch is complete or its first frame has waited long enough */
+    const ros::WallTime now = ros::WallTime::now();
+    if (!origin_changed && !coalescing && batch_size < max_batch_size_ && now - batch_start < max_batch_delay_)
+    {
+      update_condition_.timed_wait(ulock, (batch_start + max_batch_delay_ - now).toBoost());
+      continue;
+    }
+
+    if (pushBatchToProcess(occupied_cells_set, model_cells_set, sensor_origin))
     {
-      ROS_DEBUG("Pushing %u sets of occupied/model cells to free cells update thread", batch_size);
-      pushBatchToProcess(occupied_cells_set, model_cells_set, sensor_origin);
+      ROS_DEBUG("Pushed %u sets of occupied/model cells to free cells update thread after %lf ms%s", batch_size,
+                (now - batch_start).toSec() * 1000.0, origin_changed ? " (origin changed)" : "");
+      backlog_ -= batch_size;
       occupied_cells_set = NULL;
+      model_cells_set = NULL;
       batch_size = 0;
+      coalescing = false;
+      continue;
     }
+
+    if (origin_changed)
+    {
+      // the batch cannot absorb frames from a different origin, so it is dropped rather than delaying them further
+      ROS_WARN_THROTTLE(1.0, "Previous batch update did not complete. Ignoring %u sets of cells to be freed.",
+                        batch_size);
+      delete occupied_cells_set;
+      occupied_cells_set = NULL;
+      delete model_cells_set;
+      model_cells_set = NULL;
+      backlog_ -= batch_size;
+      dropped_frames_ += batch_size;
+      batch_size = 0;
+      coalescing = false;
+      continue;
+    }
+
+    // processThread() is busy: keep merging new frames into this batch until it completes and wakes us up
+    coalescing = true;
+    update_condition_.timed_wait(ulock, max_batch_delay_.toBoost());
+  }
+
+  delete occupied_cells_set;
+  delete model_cells_set;
+  while (!occupied_cells_sets_.empty())
+  {
+    delete occupied_cells_sets_.front();
+    occupied_cells_sets_.pop_front();
+    delete model_cells_sets_.front();
+    model_cells_sets_.pop_front();
   }
 }
 }
@@ -0,0 +1,162 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_MESH_FILTER_DEPTH_VISIBILITY_EVALUATOR_
+#define MOVEIT_MESH_FILTER_DEPTH_VISIBILITY_EVALUATOR_
+
+#include <moveit/kinematic_constraints/kinematic_constraint.h>
+#include <moveit/macros/class_forward.h>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <queue>
+#include <vector>
+
+namespace mesh_filter
+{
+MOVEIT_CLASS_FORWARD(Job);
+MOVEIT_CLASS_FORWARD(GLMesh);
+MOVEIT_CLASS_FORWARD(GLRenderer);
+MOVEIT_CLASS_FORWARD(DepthVisibilityEvaluator);
+
+/**
+ * \brief Decides whether the target of a visibility constraint is occluded by rendering the robot's collision
+ * geometry from the sensor's viewpoint into a depth buffer, instead of checking a cone mesh for collisions.
+ *
+ * The camera is aimed at the center of the target disc and the image is sized to cover the disc. A robot pixel inside
+ * the disc that is closer to the sensor than the disc itself (by more than the depth tolerance) means an occlusion.
+ * As with the cone check, the sensor and target links and attached bodies are ignored.
+ *
+ * All rendering happens in a thread that owns the OpenGL context. A batch of states is rendered in a single job.
+ */
+class DepthVisibilityEvaluator : public kinematic_constraints::VisibilityEvaluator
+{
+public:
+  /**
+   * \brief Constructs the evaluator and starts its rendering thread
+   * \param[in] model the robot model whose link collision geometry is rendered
+   * \param[in] resolution width and height in pixels of the image covering the target disc
+   */
+  DepthVisibilityEvaluator(const robot_model::RobotModelConstPtr& model, unsigned int resolution = 64);
+
+  /** \brief Destructor, stops the rendering thread */
+  virtual ~DepthVisibilityEvaluator();
+
+  virtual kinematic_constraints::ConstraintEvaluationResult
+  decideOcclusion(const kinematic_constraints::VisibilityConstraint& constraint, const robot_state::RobotState& state,
+                  bool verbose);
+
+  virtual void decideOcclusion(const kinematic_constraints::VisibilityConstraint& constraint,
+                               const robot_state::RobotState* const* states, std::size_t count,
+                               kinematic_constraints::ConstraintEvaluationResult* results);
+
+  /**
+   * \brief Set how far in meters the robot must be in front of the target disc to count as occluding it
+   * \param[in] tolerance the depth tolerance in meters
+   */
+  void setDepthTolerance(double tolerance)
+  {
+    depth_tolerance_ = tolerance;
+  }
+
+  double getDepthTolerance() const
+  {
+    return depth_tolerance_;
+  }
+
+private:
+  /** \brief Main loop of the rendering thread */
+  void run();
+
+  /** \brief Creates the renderer and uploads the robot meshes. Called in the rendering thread */
+  void initialize();
+
+  /** \brief Releases the OpenGL resources. Called in the rendering thread */
+  void deInitialize();
+
+  /** \brief Queues a job for the rendering thread */
+  void addJob(const JobPtr& job) const;
+
+  /** \brief Decides the occlusion of all states. Called in the rendering thread */
+  void renderStates(const kinematic_constraints::VisibilityConstraint* constraint,
+                    const robot_state::RobotState* const* states, std::size_t count,
+                    kinematic_constraints::ConstraintEvaluationResult* results, bool verbose);
+
+  /** \brief Renders a single state and compares the robot depth with the target disc */
+  kinematic_constraints::ConstraintEvaluationResult renderState(const kinematic_constraints::VisibilityConstraint& c,
+                                                                const robot_state::RobotState& state,
+                                                                const std::vector<bool>& skip, bool verbose);
+
+  /** \brief the robot model whose collision geometry is rendered */
+  robot_model::RobotModelConstPtr robot_model_;
+
+  /** \brief width and height of the rendered image in pixels */
+  unsigned int resolution_;
+
+  /** \brief distance in meters the robot must be in front of the target to occlude it */
+  double depth_tolerance_;
+
+  /** \brief the renderer, only accessed from the rendering thread */
+  GLRendererPtr renderer_;
+
+  /** \brief meshes of the link collision shapes, uploaded to the OpenGL context */
+  std::vector<GLMeshPtr> meshes_;
+
+  /** \brief the link each entry of meshes_ belongs to */
+  std::vector<const robot_model::LinkModel*> mesh_links_;
+
+  /** \brief the collision origin of each entry of meshes_, relative to its link */
+  EigenSTL::vector_Affine3d mesh_offsets_;
+
+  /** \brief buffer for reading back the rendered depth */
+  std::vector<float> depth_;
+
+  /** \brief thread owning the OpenGL context */
+  boost::thread render_thread_;
+
+  /** \brief condition variable to notify the rendering thread of new jobs */
+  mutable boost::condition_variable jobs_condition_;
+
+  /** \brief mutex for the job queue */
+  mutable boost::mutex jobs_mutex_;
+
+  /** \brief jobs to be executed by the rendering thread */
+  mutable std::queue<JobPtr> jobs_queue_;
+
+  /** \brief whether the rendering thread should stop */
+  bool stop_;
+};
+}  // namespace mesh_filter
+
+#endif
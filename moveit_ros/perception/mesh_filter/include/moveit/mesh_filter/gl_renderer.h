@@ -58,6 +58,9 @@ MOVEIT_CLASS_FORWARD(GLRenderer);
 class GLRenderer
 {
 public:
+  /** \brief number of asynchronous reads of the buffers that can be in flight, see readBuffersAsync() */
+  static const unsigned READBACK_SLOTS = 2;
+
   /**
    * \brief constructs the frame buffer object in a new OpenGL context.
    * \author Suat Gedikli (gedikli@willowgarage.com)
@@ -97,6 +100,12 @@ public:
    */
   void getColorBuffer(unsigned char* buffer) const;
 
+  /**
+   * \brief retrieves the color buffer from OpenGL with 16 bits per channel
+   * \param[out] buffer pointer to memory where the four channels of each pixel need to be stored
+   */
+  void getColorBuffer(unsigned short* buffer) const;
+
   /**
    * \brief retrieves the depth buffer from OpenGL
    * \author Suat Gedikli (gedikli@willowgarage.com)
@@ -104,6 +113,29 @@ public:
    */
   void getDepthBuffer(float* buffer) const;
 
+  /**
+   * \brief starts reading the color (as 8 bit RGBA) and depth buffers into the pixel buffer objects of \e slot and
+   * returns without waiting for the rendering to complete. The results are retrieved with mapReadBuffers(); the other
+   * slot can be read into in the meantime. Changing the buffer size discards the reads in flight.
+   * \param[in] slot index of the pixel buffer objects to read into, smaller than READBACK_SLOTS
+   */
+  void readBuffersAsync(unsigned slot) const;
+
+  /**
+   * \brief maps the buffers read by readBuffersAsync() into memory, waiting for the read to complete if necessary
+   * \param[in] slot the slot passed to readBuffersAsync()
+   * \param[out] color the four channels of each pixel; valid until unmapReadBuffers() is called
+   * \param[out] depth the depth value of each pixel; valid until unmapReadBuffers() is called
+   * \return false if the slot was not read into or could not be mapped; nothing needs to be unmapped then
+   */
+  bool mapReadBuffers(unsigned slot, const unsigned char*& color, const float*& depth) const;
+
+  /**
+   * \brief releases the memory returned by mapReadBuffers()
+   * \param[in] slot the slot passed to mapReadBuffers()
+   */
+  void unmapReadBuffers(unsigned slot) const;
+
   /**
    * \brief loads, compiles, links and adds GLSL shaders from files to the current OpenGL context.
    * \author Suat Gedikli (gedikli@willowgarage.com)
@@ -177,6 +209,13 @@ public:
    */
   void setBufferSize(unsigned width, unsigned height);
 
+  /**
+   * \brief set the internal format of the color buffer (GL_RGBA by default), e.g. GL_RGBA16 for renderers whose
+   * output is not a color
+   * \param[in] format the OpenGL internal format of the color texture
+   */
+  void setColorBufferFormat(GLint format);
+
   /**
    * \returns the current programID
    * \author Suat Gedikli (gedikli@willowgarage.com)
@@ -273,6 +312,12 @@ private:
   /** \brief handle to depth buffer*/
   GLuint depth_id_;
 
+  /** \brief internal format of the color buffer*/
+  GLint color_format_;
+
+  /** \brief color and depth pixel buffer objects of each readback slot; created on first use*/
+  mutable GLuint readback_pbo_[READBACK_SLOTS][2];
+
   /** \brief handle to program that is currently used*/
   GLuint program_;
 
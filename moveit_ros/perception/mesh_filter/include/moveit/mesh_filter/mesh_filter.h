@@ -88,6 +88,15 @@ public:
    * \return const reference of the parameters object of the used Sensor
    */
   const typename SensorType::Parameters& parameters() const;
+
+  /**
+   * \brief registers another sensor of this type, sharing the meshes and OpenGL context of this filter
+   * \param[in] sensor_parameters the parameters of the sensor
+   * \param[in] transform_callback callback returning the transformation of each mesh in the frame of this sensor
+   * \return handle of the sensor, to be passed to filter() and to the getters of the filtered data
+   */
+  SensorHandle addSensor(const typename SensorType::Parameters& sensor_parameters,
+                         const TransformCallback& transform_callback);
 };
 
 template <typename SensorType>
@@ -111,5 +120,14 @@ const typename SensorType::Parameters& MeshFilter<SensorType>::parameters() cons
   return static_cast<typename SensorType::Parameters&>(*sensor_parameters_);
 }
 
+template <typename SensorType>
+SensorHandle MeshFilter<SensorType>::addSensor(const typename SensorType::Parameters& sensor_parameters,
+                                               const TransformCallback& transform_callback)
+{
+  return MeshFilterBase::addSensor(sensor_parameters, transform_callback, SensorType::renderVertexShaderSource,
+                                   SensorType::renderFragmentShaderSource, SensorType::filterVertexShaderSource,
+                                   SensorType::filterFragmentShaderSource);
+}
+
 }  // namespace mesh_filter
 #endif
@@ -44,7 +44,9 @@
 #include <boost/function.hpp>
 #include <boost/thread/mutex.hpp>
 #include <Eigen/Eigen>
+#include <deque>
 #include <queue>
+#include <vector>
 
 // forward declarations
 namespace shapes
@@ -58,6 +60,7 @@ MOVEIT_CLASS_FORWARD(Job);
 MOVEIT_CLASS_FORWARD(GLMesh);
 
 typedef unsigned int MeshHandle;
+typedef unsigned int SensorHandle;
 typedef uint32_t LabelType;
 
 class MeshFilterBase
@@ -65,6 +68,9 @@ class MeshFilterBase
   // inner types and typedefs
 public:
   typedef boost::function<bool(MeshHandle, Eigen::Affine3d&)> TransformCallback;
+  /** \brief receives the filtered labels and metric depth of an image passed to filterAsync(); both buffers are only
+   * valid during the call, which is made from the filtering thread and must not wait for other filter calls */
+  typedef boost::function<void(const LabelType* labels, const float* depth)> FilterCallback;
   // \todo @suat: to avoid a few comparisons, it would be much nicer if background = 14 and shadow = 15 (near/far clip
   // can be anything below that)
   // this would allow me to do a single comparison instead of 3, in the code i write
@@ -77,6 +83,17 @@ public:
     FirstLabel = 16
   };
 
+  /** \brief The classes of the pixels returned by getFilteredKeys() */
+  enum
+  {
+    NoKey = 0,
+    OccupiedKey = 1,
+    ModelKey = 2
+  };
+
+  /** \brief The handle of the sensor given to the constructor; further sensors are registered with addSensor() */
+  static const SensorHandle DefaultSensor = 0;
+
 public:
   /**
    * \brief Constructor
@@ -108,13 +125,48 @@ public:
    */
   void removeMesh(MeshHandle mesh_handle);
 
+  /**
+   * \brief registers another sensor with this filter. All sensors share the filter thread, its OpenGL context and
+   *        the meshes, and their depth images are filtered in the order they are passed to filter().
+   * \param[in] sensor_parameters the parameters of the sensor; copied
+   * \param[in] transform_callback callback returning the transformation of each mesh in the frame of this sensor
+   * \param[in] render_vertex_shader, render_fragment_shader, filter_vertex_shader, filter_fragment_shader shaders of
+   *            the sensor model, see MeshFilter::addSensor()
+   * \return handle of the sensor, to be passed to filter() and to the getters of the filtered data
+   */
+  SensorHandle addSensor(const SensorModel::Parameters& sensor_parameters, const TransformCallback& transform_callback,
+                         const std::string& render_vertex_shader, const std::string& render_fragment_shader,
+                         const std::string& filter_vertex_shader, const std::string& filter_fragment_shader);
+
+  /**
+   * \brief removes a sensor registered with addSensor() and frees its buffers. Filtering with its handle must have
+   *        completed.
+   * \param[in] sensor_handle the handle of the sensor to be removed.
+   */
+  void removeSensor(SensorHandle sensor_handle);
+
   /**
    * \brief label/remove pixels from input depth-image
    * \author Suat Gedikli (gedikli@willowgarage.com)
    * \param[in] sensor_data pointer to the input depth image from sensor readings.
+   * \param[in] sensor the sensor the image was taken with
    * \todo what is type?
    */
-  void filter(const void* sensor_data, GLushort type, bool wait = false) const;
+  void filter(const void* sensor_data, GLushort type, bool wait = false, SensorHandle sensor = DefaultSensor) const;
+
+  /**
+   * \brief label/remove pixels from input depth-image and pass the results to a callback instead of reading them
+   *        back with getFilteredLabels() and getFilteredDepth(). The results are read back through pixel buffer
+   *        objects: the filtering thread goes on rendering the next queued image while the transfer of this one
+   *        completes, and delivers the results when it runs out of images or has started the transfer of the next.
+   * \param[in] sensor_data pointer to the input depth image; must stay valid until the depth has been uploaded,
+   *            which is before the callback is called
+   * \param[in] type GL_FLOAT or GL_UNSIGNED_SHORT
+   * \param[in] callback called from the filtering thread with the results
+   * \param[in] sensor the sensor the image was taken with
+   */
+  void filterAsync(const void* sensor_data, GLushort type, const FilterCallback& callback,
+                   SensorHandle sensor = DefaultSensor) const;
 
   /**
    * \brief retrieves the labels of the input data
@@ -124,14 +176,14 @@ public:
    * shadow (1)
    *       The upper 8bit of a label is filled with the user given flag (see addMesh)
    */
-  void getFilteredLabels(LabelType* labels) const;
+  void getFilteredLabels(LabelType* labels, SensorHandle sensor = DefaultSensor) const;
 
   /**
    * \brief retrieves the filtered depth values
    * \author Suat Gedikli (gedikli@willowgarage.com)
    * \param[out] depth pointer to buffer to be filled with depth values.
    */
-  void getFilteredDepth(float* depth) const;
+  void getFilteredDepth(float* depth, SensorHandle sensor = DefaultSensor) const;
 
   /**
    * \brief retrieves the labels of the rendered model
@@ -142,14 +194,28 @@ public:
    *       The upper 8bit of a label is filled with the user given flag (see addMesh)
    * \todo How is this data different from the filtered labels?
    */
-  void getModelLabels(LabelType* labels) const;
+  void getModelLabels(LabelType* labels, SensorHandle sensor = DefaultSensor) const;
 
   /**
    * \brief retrieves the depth values of the rendered model
    * \author Suat Gedikli (gedikli@willowgarage.com)
    * \param[out] depth pointer to buffer to be filled with depth values.
    */
-  void getModelDepth(float* depth) const;
+  void getModelDepth(float* depth, SensorHandle sensor = DefaultSensor) const;
+
+  /**
+   * \brief computes the octree keys of the pixels of the last filtered depth image on the GPU. Each pixel is
+   *        back-projected with the given pinhole parameters, transformed into the map frame and discretized at the
+   *        given resolution, the way octomap::OcTree::coordToKey() does.
+   * \param[in] map_H_sensor transform from the sensor frame to the map frame
+   * \param[in] fx, fy, cx, cy pinhole parameters of the depth image
+   * \param[in] resolution resolution of the octree
+   * \param[out] keys buffer of four values per pixel: the three key coordinates and the class of the pixel, which is
+   *             OccupiedKey for unfiltered pixels, ModelKey for pixels on the model or beyond the far plane and NoKey
+   *             for the others and for points outside the octree
+   */
+  void getFilteredKeys(const Eigen::Affine3f& map_H_sensor, float fx, float fy, float cx, float cy, float resolution,
+                       unsigned short* keys, SensorHandle sensor = DefaultSensor) const;
 
   /**
    * \brief set the shadow threshold. points that are further away than the rendered model are filtered out.
@@ -164,8 +230,9 @@ public:
    * \brief set the callback for retrieving transformations for each mesh.
    * \author Suat Gedikli (gedikli@willowgarage.com)
    * \param[in] transform_callback the callback
+   * \param[in] sensor the sensor whose mesh transformations the callback returns
    */
-  void setTransformCallback(const TransformCallback& transform_callback);
+  void setTransformCallback(const TransformCallback& transform_callback, SensorHandle sensor = DefaultSensor);
 
   /**
    * \brief set the scale component of padding used to multiply with sensor-specific padding coefficients to get final
@@ -181,12 +248,78 @@ public:
   void setPaddingOffset(float offset);
 
 protected:
+  /** \brief the parameters and OpenGL resources of one registered sensor */
+  struct Sensor
+  {
+    /** \brief the parameters of the sensor model */
+    SensorModel::ParametersPtr parameters;
+
+    /** \brief first pass renderer for rendering the mesh*/
+    GLRendererPtr mesh_renderer;
+
+    /** \brief second pass renderer for filtering the results of first pass*/
+    GLRendererPtr depth_filter;
+
+    /** \brief handle depth texture from sensor data*/
+    GLuint sensor_depth_texture;
+
+    /** \brief handle to GLSL location of shadow threshold*/
+    GLuint shadow_threshold_location;
+
+    /** \brief callback function for retrieving the mesh transformations*/
+    TransformCallback transform_callback;
+
+    /** \brief the readback slot of depth_filter the next filterAsync() call reads into */
+    unsigned next_readback_slot;
+
+    /** \brief the metric depth passed to filterAsync() callbacks */
+    std::vector<float> readback_depth;
+  };
+
+  /** \brief the results of a filterAsync() call that are being read back */
+  struct PendingReadback
+  {
+    SensorHandle sensor;
+    unsigned slot;
+    FilterCallback callback;
+  };
+
   /**
    * \brief initializes OpenGL related things as well as renderers
    */
   void initialize(const std::string& render_vertex_shader, const std::string& render_fragment_shader,
                   const std::string& filter_vertex_shader, const std::string& filter_fragment_shader);
 
+  /**
+   * \brief creates the renderers and textures of a sensor; runs in the filtering thread
+   */
+  void initializeSensor(Sensor& sensor, const std::string& render_vertex_shader,
+                        const std::string& render_fragment_shader, const std::string& filter_vertex_shader,
+                        const std::string& filter_fragment_shader);
+
+  /**
+   * \brief frees the renderers and textures of a sensor; runs in the filtering thread
+   */
+  void deInitializeSensor(Sensor& sensor);
+
+  /**
+   * \brief used within a Job to add a sensor; the entry of the sensor is created beforehand
+   */
+  void addSensorHelper(SensorHandle handle, const std::string& render_vertex_shader,
+                       const std::string& render_fragment_shader, const std::string& filter_vertex_shader,
+                       const std::string& filter_fragment_shader);
+
+  /**
+   * \brief used within a Job to remove a sensor
+   */
+  bool removeSensorHelper(SensorHandle handle);
+
+  /**
+   * \brief returns the sensor with the given handle
+   * \throws std::runtime_error if there is no such sensor
+   */
+  Sensor& getSensor(SensorHandle handle) const;
+
   /**
    * \brief cleaning up
    */
@@ -203,7 +336,25 @@ protected:
    * \param[in] sensor_data pointer to the buffer containing the depth readings
    * \param[in] encoding the representation of the depth readings in the buffer
    */
-  void doFilter(const void* sensor_data, const int encoding) const;
+  void doFilter(const void* sensor_data, const int encoding, SensorHandle sensor) const;
+
+  /**
+   * \brief filters and starts reading back the results for filterAsync()
+   */
+  void doFilterAsync(const void* sensor_data, const int encoding, const FilterCallback& callback,
+                     SensorHandle sensor) const;
+
+  /**
+   * \brief maps the oldest pending readbacks and passes them to their callbacks, until at most \e keep are pending;
+   *        runs in the filtering thread
+   */
+  void completeReadbacks(std::size_t keep) const;
+
+  /**
+   * \brief the GPU pass behind getFilteredKeys(); runs in the filtering thread
+   */
+  void doComputeKeys(const Eigen::Affine3f& map_H_sensor, float fx, float fy, float cx, float cy, float resolution,
+                     unsigned short* keys, SensorHandle sensor) const;
 
   /**
    * \brief used within a Job to allow the main thread adding meshes
@@ -225,7 +376,7 @@ protected:
   void addJob(const JobPtr& job) const;
 
   /**
-   * \brief sets the size of the fram buffers
+   * \brief sets the size of the fram buffers of the default sensor
    * \author Suat Gedikli (gedikli@willowgarage.com)
    * \param[in] width width of frame buffers in pixels
    * \param[in] height height of frame buffers in pixels
@@ -235,9 +386,18 @@ protected:
   /** \brief storage for meshed to be filtered */
   std::map<MeshHandle, GLMeshPtr> meshes_;
 
-  /** \brief the parameters of the used sensor model*/
+  /** \brief the parameters of the default sensor model; shared with its entry in sensors_ */
   SensorModel::ParametersPtr sensor_parameters_;
 
+  /** \brief the registered sensors; the default sensor is always present */
+  mutable std::map<SensorHandle, Sensor> sensors_;
+
+  /** \brief mutex for synchronization of adding/removing and looking up sensors */
+  mutable boost::mutex sensors_mutex_;
+
+  /** \brief next handle to be used for the next sensor that is added */
+  SensorHandle next_sensor_handle_;
+
   /** \brief next handle to be used for next mesh that is added*/
   MeshHandle next_handle_;
 
@@ -257,33 +417,24 @@ protected:
   /** \brief OpenGL job queue that need to be processed by the worker thread*/
   mutable std::queue<JobPtr> jobs_queue_;
 
+  /** \brief the filterAsync() results that are being read back, oldest first; only used by the filtering thread*/
+  mutable std::deque<PendingReadback> pending_readbacks_;
+
   /** \brief mutex for synchronization of updating filtered meshes */
   mutable boost::mutex meshes_mutex_;
 
-  /** \brief mutex for synchronization of setting/calling transform_callback_ */
+  /** \brief mutex for synchronization of setting/calling the transform callbacks of the sensors */
   mutable boost::mutex transform_callback_mutex_;
 
   /** \brief indicates whether the filtering loop should stop*/
   bool stop_;
 
-  /** \brief first pass renderer for rendering the mesh*/
-  GLRendererPtr mesh_renderer_;
-
-  /** \brief second pass renderer for filtering the results of first pass*/
-  GLRendererPtr depth_filter_;
+  /** \brief third pass renderer computing octree keys from the results of the second pass; created on first use*/
+  mutable GLRendererPtr key_renderer_;
 
   /** \brief canvas element (screen-filling quad) for second pass*/
   GLuint canvas_;
 
-  /** \brief handle depth texture from sensor data*/
-  GLuint sensor_depth_texture_;
-
-  /** \brief handle to GLSL location of shadow threshold*/
-  GLuint shadow_threshold_location_;
-
-  /** \brief callback function for retrieving the mesh transformations*/
-  TransformCallback transform_callback_;
-
   /** \brief padding scale*/
   float padding_scale_;
 
@@ -0,0 +1,267 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/mesh_filter/depth_visibility_evaluator.h>
+#include <moveit/mesh_filter/gl_renderer.h>
+#include <moveit/mesh_filter/gl_mesh.h>
+#include <moveit/mesh_filter/filter_job.h>
+
+#include <geometric_shapes/shapes.h>
+#include <geometric_shapes/shape_operations.h>
+#include <boost/bind.hpp>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+
+#include <ros/console.h>
+
+using kinematic_constraints::ConstraintEvaluationResult;
+using kinematic_constraints::VisibilityConstraint;
+
+mesh_filter::DepthVisibilityEvaluator::DepthVisibilityEvaluator(const robot_model::RobotModelConstPtr& model,
+                                                                unsigned int resolution)
+  : robot_model_(model), resolution_(std::max(resolution, 2u)), depth_tolerance_(0.01), stop_(false)
+{
+  render_thread_ = boost::thread(boost::bind(&DepthVisibilityEvaluator::run, this));
+}
+
+mesh_filter::DepthVisibilityEvaluator::~DepthVisibilityEvaluator()
+{
+  {
+    boost::unique_lock<boost::mutex> lock(jobs_mutex_);
+    stop_ = true;
+    while (!jobs_queue_.empty())
+    {
+      jobs_queue_.front()->cancel();
+      jobs_queue_.pop();
+    }
+  }
+  jobs_condition_.notify_one();
+  render_thread_.join();
+}
+
+void mesh_filter::DepthVisibilityEvaluator::addJob(const JobPtr& job) const
+{
+  {
+    boost::unique_lock<boost::mutex> _(jobs_mutex_);
+    jobs_queue_.push(job);
+  }
+  jobs_condition_.notify_one();
+}
+
+void mesh_filter::DepthVisibilityEvaluator::initialize()
+{
+  renderer_.reset(new GLRenderer(resolution_, resolution_));
+  depth_.resize(resolution_ * resolution_);
+
+  const std::vector<const robot_model::LinkModel*>& links = robot_model_->getLinkModelsWithCollisionGeometry();
+  for (std::size_t i = 0; i < links.size(); ++i)
+  {
+    const std::vector<shapes::ShapeConstPtr>& shapes = links[i]->getShapes();
+    const EigenSTL::vector_Affine3d& origins = links[i]->getCollisionOriginTransforms();
+    for (std::size_t j = 0; j < shapes.size(); ++j)
+    {
+      std::unique_ptr<shapes::Mesh> mesh(shapes::createMeshFromShape(shapes[j].get()));
+      if (!mesh)
+        continue;
+      mesh->computeVertexNormals();
+      meshes_.push_back(GLMeshPtr(new GLMesh(*mesh, meshes_.size() + 1)));
+      mesh_links_.push_back(links[i]);
+      mesh_offsets_.push_back(origins[j]);
+    }
+  }
+}
+
+void mesh_filter::DepthVisibilityEvaluator::deInitialize()
+{
+  meshes_.clear();
+  renderer_.reset();
+}
+
+void mesh_filter::DepthVisibilityEvaluator::run()
+{
+  try
+  {
+    initialize();
+  }
+  catch (std::exception& ex)
+  {
+    ROS_ERROR("Unable to render visibility constraints, falling back to cone collision checks: %s", ex.what());
+    deInitialize();
+  }
+
+  while (!stop_)
+  {
+    boost::unique_lock<boost::mutex> lock(jobs_mutex_);
+    if (jobs_queue_.empty())
+      jobs_condition_.wait(lock);
+
+    if (!jobs_queue_.empty())
+    {
+      JobPtr job = jobs_queue_.front();
+      jobs_queue_.pop();
+      lock.unlock();
+      job->execute();
+      lock.lock();
+    }
+  }
+  deInitialize();
+}
+
+ConstraintEvaluationResult
+mesh_filter::DepthVisibilityEvaluator::decideOcclusion(const VisibilityConstraint& constraint,
+                                                       const robot_state::RobotState& state, bool verbose)
+{
+  const robot_state::RobotState* states[1] = { &state };
+  ConstraintEvaluationResult result(false, 0.0);
+  JobPtr job(new FilterJob<void>(
+      boost::bind(&DepthVisibilityEvaluator::renderStates, this, &constraint, &states[0], 1, &result, verbose)));
+  addJob(job);
+  job->wait();
+  return result;
+}
+
+void mesh_filter::DepthVisibilityEvaluator::decideOcclusion(const VisibilityConstraint& constraint,
+                                                            const robot_state::RobotState* const* states,
+                                                            std::size_t count, ConstraintEvaluationResult* results)
+{
+  JobPtr job(new FilterJob<void>(
+      boost::bind(&DepthVisibilityEvaluator::renderStates, this, &constraint, states, count, results, false)));
+  addJob(job);
+  job->wait();
+}
+
+void mesh_filter::DepthVisibilityEvaluator::renderStates(const VisibilityConstraint* constraint,
+                                                         const robot_state::RobotState* const* states,
+                                                         std::size_t count, ConstraintEvaluationResult* results,
+                                                         bool verbose)
+{
+  if (!renderer_)
+  {
+    for (std::size_t i = 0; i < count; ++i)
+      results[i] = constraint->decideCone(*states[i], verbose);
+    return;
+  }
+
+  // as in the cone check, the sensor and target links may touch the visibility region
+  std::vector<bool> skip(meshes_.size(), false);
+  for (std::size_t i = 0; i < mesh_links_.size(); ++i)
+    skip[i] = robot_state::Transforms::sameFrame(mesh_links_[i]->getName(), constraint->getSensorFrameId()) ||
+              robot_state::Transforms::sameFrame(mesh_links_[i]->getName(), constraint->getTargetFrameId());
+
+  for (std::size_t i = 0; i < count; ++i)
+    results[i] = renderState(*constraint, *states[i], skip, verbose);
+}
+
+ConstraintEvaluationResult mesh_filter::DepthVisibilityEvaluator::renderState(const VisibilityConstraint& constraint,
+                                                                              const robot_state::RobotState& state,
+                                                                              const std::vector<bool>& skip,
+                                                                              bool verbose)
+{
+  const Eigen::Affine3d sensor = constraint.getSensorPose(state);
+  const Eigen::Affine3d target = constraint.getTargetPose(state);
+  const double radius = constraint.getTargetRadius();
+
+  Eigen::Vector3d axis = target.translation() - sensor.translation();
+  const double distance = axis.norm();
+  // the disc surrounds the sensor, so there is no view to render
+  if (distance <= radius)
+    return constraint.decideCone(state, verbose);
+  axis /= distance;
+
+  // aim the camera at the center of the disc; the rotation about the view axis does not matter
+  Eigen::Affine3d camera = Eigen::Affine3d::Identity();
+  camera.translation() = sensor.translation();
+  camera.linear().col(2) = axis;
+  camera.linear().col(0) = axis.unitOrthogonal();
+  camera.linear().col(1) = axis.cross(camera.linear().col(0));
+  const Eigen::Affine3d world_to_camera = camera.inverse(Eigen::Isometry);
+
+  const Eigen::Vector3d center(0.0, 0.0, distance);
+  const Eigen::Vector3d normal = world_to_camera.linear() * target.linear().col(2);
+  const double normal_dot_center = normal.dot(center);
+
+  // choose the focal length so the disc fits in the image, and clip everything behind it
+  const double half = resolution_ * 0.5;
+  const double focal = half * sqrt(distance * distance - radius * radius) / radius;
+  const float near = std::max(distance * 1e-3, 1e-4);
+  const float far = distance + radius + depth_tolerance_;
+  renderer_->setCameraParameters(focal, focal, half, half);
+  renderer_->setClippingRange(near, far);
+
+  renderer_->begin();
+  glEnable(GL_DEPTH_TEST);
+  glDepthFunc(GL_LESS);
+  glDisable(GL_CULL_FACE);
+  glDisable(GL_BLEND);
+  for (std::size_t i = 0; i < meshes_.size(); ++i)
+    if (!skip[i])
+      meshes_[i]->render(world_to_camera * state.getGlobalLinkTransform(mesh_links_[i]) * mesh_offsets_[i]);
+  renderer_->end();
+  renderer_->getDepthBuffer(&depth_[0]);
+
+  // rows of the depth buffer start at the bottom of the image, which is the camera's +y side
+  double occlusion = 0.0;
+  std::size_t occluded_pixels = 0;
+  const double radius2 = radius * radius;
+  for (unsigned int row = 0; row < resolution_; ++row)
+    for (unsigned int col = 0; col < resolution_; ++col)
+    {
+      const float d = depth_[row * resolution_ + col];
+      if (d >= 1.0f)
+        continue;
+
+      const Eigen::Vector3d ray((col + 0.5 - half) / focal, (half - row - 0.5) / focal, 1.0);
+      const double normal_dot_ray = normal.dot(ray);
+      if (fabs(normal_dot_ray) < std::numeric_limits<double>::epsilon())
+        continue;
+      const double disc_depth = normal_dot_center / normal_dot_ray;
+      if (disc_depth <= 0.0 || (ray * disc_depth - center).squaredNorm() > radius2)
+        continue;
+
+      const double robot_depth = near * far / (far - d * (far - near));
+      if (robot_depth + depth_tolerance_ < disc_depth)
+      {
+        occlusion = std::max(occlusion, disc_depth - robot_depth);
+        ++occluded_pixels;
+      }
+    }
+
+  if (verbose)
+    ROS_INFO("Visibility constraint %ssatisfied: %u of %u rendered pixels of the target are occluded",
+             occluded_pixels ? "not " : "", (unsigned int)occluded_pixels, resolution_ * resolution_);
+
+  return ConstraintEvaluationResult(occluded_pixels == 0, occlusion);
+}
@@ -53,6 +53,8 @@
 
 using namespace std;
 
+const unsigned mesh_filter::GLRenderer::READBACK_SLOTS;
+
 mesh_filter::GLRenderer::GLRenderer(unsigned width, unsigned height, float near, float far)
   : width_(width)
   , height_(height)
@@ -60,6 +62,7 @@ mesh_filter::GLRenderer::GLRenderer(unsigned width, unsigned height, float near,
   , rbo_id_(0)
   , rgb_id_(0)
   , depth_id_(0)
+  , color_format_(GL_RGBA)
   , program_(0)
   , near_(near)
   , far_(far)
@@ -68,6 +71,8 @@ mesh_filter::GLRenderer::GLRenderer(unsigned width, unsigned height, float near,
   , cx_(width >> 1)
   , cy_(height >> 1)
 {
+  for (unsigned slot = 0; slot < READBACK_SLOTS; ++slot)
+    readback_pbo_[slot][0] = readback_pbo_[slot][1] = 0;
   createGLContext();
   initFrameBuffers();
 }
@@ -92,6 +97,16 @@ void mesh_filter::GLRenderer::setBufferSize(unsigned width, unsigned height)
   }
 }
 
+void mesh_filter::GLRenderer::setColorBufferFormat(GLint format)
+{
+  if (color_format_ != format)
+  {
+    color_format_ = format;
+    deleteFrameBuffers();
+    initFrameBuffers();
+  }
+}
+
 void mesh_filter::GLRenderer::setClippingRange(float near, float far)
 {
   if (near_ <= 0)
@@ -130,7 +145,7 @@ void mesh_filter::GLRenderer::initFrameBuffers()
 {
   glGenTextures(1, &rgb_id_);
   glBindTexture(GL_TEXTURE_2D, rgb_id_);
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width_, height_, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+  glTexImage2D(GL_TEXTURE_2D, 0, color_format_, width_, height_, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
   glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
   glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -180,6 +195,13 @@ void mesh_filter::GLRenderer::deleteFrameBuffers()
     glDeleteTextures(1, &rgb_id_);
 
   rbo_id_ = fbo_id_ = depth_id_ = rgb_id_ = 0;
+
+  for (unsigned slot = 0; slot < READBACK_SLOTS; ++slot)
+    if (readback_pbo_[slot][0])
+    {
+      glDeleteBuffers(2, readback_pbo_[slot]);
+      readback_pbo_[slot][0] = readback_pbo_[slot][1] = 0;
+    }
 }
 
 void mesh_filter::GLRenderer::begin() const
@@ -214,6 +236,14 @@ void mesh_filter::GLRenderer::getColorBuffer(unsigned char* buffer) const
   glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
+void mesh_filter::GLRenderer::getColorBuffer(unsigned short* buffer) const
+{
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo_id_);
+  glBindTexture(GL_TEXTURE_2D, rgb_id_);
+  glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_SHORT, buffer);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
 void mesh_filter::GLRenderer::getDepthBuffer(float* buffer) const
 {
   glBindFramebuffer(GL_FRAMEBUFFER, fbo_id_);
@@ -222,6 +252,63 @@ void mesh_filter::GLRenderer::getDepthBuffer(float* buffer) const
   glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
+void mesh_filter::GLRenderer::readBuffersAsync(unsigned slot) const
+{
+  if (!readback_pbo_[slot][0])
+  {
+    // both 8 bit RGBA and float depth take four bytes per pixel
+    glGenBuffers(2, readback_pbo_[slot]);
+    for (unsigned i = 0; i < 2; ++i)
+    {
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, readback_pbo_[slot][i]);
+      glBufferData(GL_PIXEL_PACK_BUFFER, width_ * height_ * 4, NULL, GL_STREAM_READ);
+    }
+  }
+
+  // with a pack buffer bound, glReadPixels only queues the transfer and returns
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo_id_);
+  glReadBuffer(GL_COLOR_ATTACHMENT0);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, readback_pbo_[slot][0]);
+  glReadPixels(0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, readback_pbo_[slot][1]);
+  glReadPixels(0, 0, width_, height_, GL_DEPTH_COMPONENT, GL_FLOAT, 0);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+bool mesh_filter::GLRenderer::mapReadBuffers(unsigned slot, const unsigned char*& color, const float*& depth) const
+{
+  if (!readback_pbo_[slot][0])
+    return false;
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, readback_pbo_[slot][0]);
+  color = static_cast<const unsigned char*>(glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY));
+  if (!color)
+  {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return false;
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, readback_pbo_[slot][1]);
+  depth = static_cast<const float*>(glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY));
+  if (!depth)
+  {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback_pbo_[slot][0]);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  return depth != NULL;
+}
+
+void mesh_filter::GLRenderer::unmapReadBuffers(unsigned slot) const
+{
+  for (unsigned i = 0; i < 2; ++i)
+  {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback_pbo_[slot][i]);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
 GLuint mesh_filter::GLRenderer::setShadersFromFile(const string& vertex_filename, const string& fragment_filename)
 {
   if (program_)
@@ -52,6 +52,46 @@
 #include <xmmintrin.h>
 #endif
 
+namespace
+{
+const std::string key_vertex_shader = "#version 120\n"
+                                      "void main ()"
+                                      "{"
+                                      "  gl_TexCoord[0] = gl_MultiTexCoord0;"
+                                      "  gl_Position = gl_Vertex;"
+                                      "  gl_Position.w = 1.0;"
+                                      "}";
+
+// back-projects the sensor depth of each pixel, transforms it into the map frame and writes its octree key and
+// pixel class (see MeshFilterBase::getFilteredKeys) as 16 bit normalized values; keys are offset by 32768 like
+// octomap's for trees of depth 16
+const std::string key_fragment_shader =
+    "#version 120\n"
+    "uniform sampler2D sensor;"
+    "uniform sampler2D label;"
+    "uniform float near;"
+    "uniform float far;"
+    "uniform vec4 camera;"
+    "uniform mat4 map_H_sensor;"
+    "uniform float inv_resolution;"
+    "void main()"
+    "{"
+    "  vec4 l = floor(texture2D(label, gl_TexCoord[0].st) * 255.0 + 0.5);"
+    "  float id = l.r + l.g * 256.0 + l.b * 65536.0 + l.a * 16777216.0;"
+    "  float z = near + float(texture2D(sensor, gl_TexCoord[0].st)) * (far - near);"
+    "  vec2 pixel = gl_FragCoord.xy - vec2(0.5);"
+    "  vec4 point = map_H_sensor * vec4((pixel - camera.zw) / camera.xy * z, z, 1.0);"
+    "  vec3 key = floor(point.xyz * inv_resolution) + vec3(32768.0);"
+    "  float cls = id < 0.5 ? 1.0 : (id > 2.5 ? 2.0 : 0.0);"
+    "  if (cls == 0.0 || any(lessThan(key, vec3(0.0))) || any(greaterThan(key, vec3(65535.0))))"
+    "    gl_FragColor = vec4(0.0);"
+    "  else"
+    "    gl_FragColor = vec4(key, cls) / 65535.0;"
+    "}";
+}
+
+const mesh_filter::SensorHandle mesh_filter::MeshFilterBase::DefaultSensor;
+
 mesh_filter::MeshFilterBase::MeshFilterBase(const TransformCallback& transform_callback,
                                             const SensorModel::Parameters& sensor_parameters,
                                             const std::string& render_vertex_shader,
@@ -61,12 +101,16 @@ mesh_filter::MeshFilterBase::MeshFilterBase(const TransformCallback& transform_c
   : sensor_parameters_(sensor_parameters.clone())
   , next_handle_(FirstLabel)  // 0 and 1 are reserved!
   , min_handle_(FirstLabel)
+  , next_sensor_handle_(DefaultSensor + 1)
   , stop_(false)
-  , transform_callback_(transform_callback)
   , padding_scale_(1.0)
   , padding_offset_(0.01)
   , shadow_threshold_(0.5)
 {
+  // the entry exists before the filter thread starts, so transform callbacks can be set right away
+  Sensor& sensor = sensors_[DefaultSensor];
+  sensor.parameters = sensor_parameters_;
+  sensor.transform_callback = transform_callback;
   filter_thread_ = boost::thread(boost::bind(&MeshFilterBase::run, this, render_vertex_shader, render_fragment_shader,
                                              filter_vertex_shader, filter_fragment_shader));
 }
@@ -76,27 +120,8 @@ void mesh_filter::MeshFilterBase::initialize(const std::string& render_vertex_sh
                                              const std::string& filter_vertex_shader,
                                              const std::string& filter_fragment_shader)
 {
-  mesh_renderer_.reset(new GLRenderer(sensor_parameters_->getWidth(), sensor_parameters_->getHeight(),
-                                      sensor_parameters_->getNearClippingPlaneDistance(),
-                                      sensor_parameters_->getFarClippingPlaneDistance()));
-  depth_filter_.reset(new GLRenderer(sensor_parameters_->getWidth(), sensor_parameters_->getHeight(),
-                                     sensor_parameters_->getNearClippingPlaneDistance(),
-                                     sensor_parameters_->getFarClippingPlaneDistance()));
-
-  mesh_renderer_->setShadersFromString(render_vertex_shader, render_fragment_shader);
-  depth_filter_->setShadersFromString(filter_vertex_shader, filter_fragment_shader);
-
-  depth_filter_->begin();
-
-  glGenTextures(1, &sensor_depth_texture_);
-
-  glUniform1i(glGetUniformLocation(depth_filter_->getProgramID(), "sensor"), 0);
-  glUniform1i(glGetUniformLocation(depth_filter_->getProgramID(), "depth"), 2);
-  glUniform1i(glGetUniformLocation(depth_filter_->getProgramID(), "label"), 4);
-
-  shadow_threshold_location_ = glGetUniformLocation(depth_filter_->getProgramID(), "shadow_threshold");
-
-  depth_filter_->end();
+  initializeSensor(getSensor(DefaultSensor), render_vertex_shader, render_fragment_shader, filter_vertex_shader,
+                   filter_fragment_shader);
 
   canvas_ = glGenLists(1);
   glNewList(canvas_, GL_COMPILE);
@@ -119,6 +144,120 @@ void mesh_filter::MeshFilterBase::initialize(const std::string& render_vertex_sh
   glEndList();
 }
 
+void mesh_filter::MeshFilterBase::initializeSensor(Sensor& sensor, const std::string& render_vertex_shader,
+                                                   const std::string& render_fragment_shader,
+                                                   const std::string& filter_vertex_shader,
+                                                   const std::string& filter_fragment_shader)
+{
+  const SensorModel::Parameters& parameters = *sensor.parameters;
+  sensor.mesh_renderer.reset(new GLRenderer(parameters.getWidth(), parameters.getHeight(),
+                                            parameters.getNearClippingPlaneDistance(),
+                                            parameters.getFarClippingPlaneDistance()));
+  sensor.depth_filter.reset(new GLRenderer(parameters.getWidth(), parameters.getHeight(),
+                                           parameters.getNearClippingPlaneDistance(),
+                                           parameters.getFarClippingPlaneDistance()));
+
+  sensor.mesh_renderer->setShadersFromString(render_vertex_shader, render_fragment_shader);
+  sensor.depth_filter->setShadersFromString(filter_vertex_shader, filter_fragment_shader);
+
+  sensor.depth_filter->begin();
+
+  glGenTextures(1, &sensor.sensor_depth_texture);
+
+  glUniform1i(glGetUniformLocation(sensor.depth_filter->getProgramID(), "sensor"), 0);
+  glUniform1i(glGetUniformLocation(sensor.depth_filter->getProgramID(), "depth"), 2);
+  glUniform1i(glGetUniformLocation(sensor.depth_filter->getProgramID(), "label"), 4);
+
+  sensor.shadow_threshold_location = glGetUniformLocation(sensor.depth_filter->getProgramID(), "shadow_threshold");
+
+  sensor.depth_filter->end();
+  sensor.next_readback_slot = 0;
+}
+
+void mesh_filter::MeshFilterBase::deInitializeSensor(Sensor& sensor)
+{
+  if (sensor.mesh_renderer)
+    glDeleteTextures(1, &sensor.sensor_depth_texture);
+  sensor.mesh_renderer.reset();
+  sensor.depth_filter.reset();
+}
+
+mesh_filter::MeshFilterBase::Sensor& mesh_filter::MeshFilterBase::getSensor(SensorHandle handle) const
+{
+  boost::mutex::scoped_lock _(sensors_mutex_);
+  std::map<SensorHandle, Sensor>::iterator it = sensors_.find(handle);
+  if (it == sensors_.end())
+  {
+    std::stringstream msg;
+    msg << "unknown sensor handle " << handle;
+    throw std::runtime_error(msg.str());
+  }
+  return it->second;
+}
+
+mesh_filter::SensorHandle mesh_filter::MeshFilterBase::addSensor(const SensorModel::Parameters& sensor_parameters,
+                                                                 const TransformCallback& transform_callback,
+                                                                 const std::string& render_vertex_shader,
+                                                                 const std::string& render_fragment_shader,
+                                                                 const std::string& filter_vertex_shader,
+                                                                 const std::string& filter_fragment_shader)
+{
+  SensorHandle handle;
+  {
+    boost::mutex::scoped_lock _(sensors_mutex_);
+    handle = next_sensor_handle_++;
+    Sensor& sensor = sensors_[handle];
+    sensor.parameters.reset(sensor_parameters.clone());
+    sensor.transform_callback = transform_callback;
+  }
+
+  // the renderers need the OpenGL context, which is owned by the filtering thread
+  JobPtr job(new FilterJob<void>(boost::bind(&MeshFilterBase::addSensorHelper, this, handle, render_vertex_shader,
+                                             render_fragment_shader, filter_vertex_shader, filter_fragment_shader)));
+  addJob(job);
+  job->wait();
+  return handle;
+}
+
+void mesh_filter::MeshFilterBase::addSensorHelper(SensorHandle handle, const std::string& render_vertex_shader,
+                                                  const std::string& render_fragment_shader,
+                                                  const std::string& filter_vertex_shader,
+                                                  const std::string& filter_fragment_shader)
+{
+  initializeSensor(getSensor(handle), render_vertex_shader, render_fragment_shader, filter_vertex_shader,
+                   filter_fragment_shader);
+}
+
+void mesh_filter::MeshFilterBase::removeSensor(SensorHandle handle)
+{
+  if (handle == DefaultSensor)
+    throw std::runtime_error("Could not remove sensor. The default sensor cannot be removed!");
+
+  FilterJob<bool>* remover = new FilterJob<bool>(boost::bind(&MeshFilterBase::removeSensorHelper, this, handle));
+  JobPtr job(remover);
+  addJob(job);
+  job->wait();
+
+  if (!remover->getResult())
+    throw std::runtime_error("Could not remove sensor. Sensor not found!");
+}
+
+bool mesh_filter::MeshFilterBase::removeSensorHelper(SensorHandle handle)
+{
+  boost::mutex::scoped_lock _(sensors_mutex_);
+  std::map<SensorHandle, Sensor>::iterator it = sensors_.find(handle);
+  if (it == sensors_.end())
+    return false;
+  for (std::deque<PendingReadback>::iterator pt = pending_readbacks_.begin(); pt != pending_readbacks_.end();)
+    if (pt->sensor == handle)
+      pt = pending_readbacks_.erase(pt);
+    else
+      ++pt;
+  deInitializeSensor(it->second);
+  sensors_.erase(it);
+  return true;
+}
+
 mesh_filter::MeshFilterBase::~MeshFilterBase()
 {
   {
@@ -146,26 +285,33 @@ void mesh_filter::MeshFilterBase::addJob(const JobPtr& job) const
 void mesh_filter::MeshFilterBase::deInitialize()
 {
   glDeleteLists(canvas_, 1);
-  glDeleteTextures(1, &sensor_depth_texture_);
+  pending_readbacks_.clear();
+  {
+    boost::mutex::scoped_lock _(sensors_mutex_);
+    for (std::map<SensorHandle, Sensor>::iterator it = sensors_.begin(); it != sensors_.end(); ++it)
+      deInitializeSensor(it->second);
+  }
 
   meshes_.clear();
-  mesh_renderer_.reset();
-  depth_filter_.reset();
+  key_renderer_.reset();
 }
 
 void mesh_filter::MeshFilterBase::setSize(unsigned int width, unsigned int height)
 {
-  mesh_renderer_->setBufferSize(width, height);
-  mesh_renderer_->setCameraParameters(width, width, width >> 1, height >> 1);
+  Sensor& sensor = getSensor(DefaultSensor);
+  sensor.mesh_renderer->setBufferSize(width, height);
+  sensor.mesh_renderer->setCameraParameters(width, width, width >> 1, height >> 1);
 
-  depth_filter_->setBufferSize(width, height);
-  depth_filter_->setCameraParameters(width, width, width >> 1, height >> 1);
+  sensor.depth_filter->setBufferSize(width, height);
+  sensor.depth_filter->setCameraParameters(width, width, width >> 1, height >> 1);
 }
 
-void mesh_filter::MeshFilterBase::setTransformCallback(const TransformCallback& transform_callback)
+void mesh_filter::MeshFilterBase::setTransformCallback(const TransformCallback& transform_callback,
+                                                       SensorHandle sensor)
 {
+  Sensor& s = getSensor(sensor);
   boost::mutex::scoped_lock _(transform_callback_mutex_);
-  transform_callback_ = transform_callback;
+  s.transform_callback = transform_callback;
 }
 
 mesh_filter::MeshHandle mesh_filter::MeshFilterBase::addMesh(const shapes::Mesh& mesh)
@@ -216,19 +362,21 @@ void mesh_filter::MeshFilterBase::setShadowThreshold(float threshold)
   shadow_threshold_ = threshold;
 }
 
-void mesh_filter::MeshFilterBase::getModelLabels(LabelType* labels) const
+void mesh_filter::MeshFilterBase::getModelLabels(LabelType* labels, SensorHandle sensor) const
 {
+  const Sensor& s = getSensor(sensor);
   JobPtr job(
-      new FilterJob<void>(boost::bind(&GLRenderer::getColorBuffer, mesh_renderer_.get(), (unsigned char*)labels)));
+      new FilterJob<void>(boost::bind(&GLRenderer::getColorBuffer, s.mesh_renderer.get(), (unsigned char*)labels)));
   addJob(job);
   job->wait();
 }
 
-void mesh_filter::MeshFilterBase::getModelDepth(float* depth) const
+void mesh_filter::MeshFilterBase::getModelDepth(float* depth, SensorHandle sensor) const
 {
-  JobPtr job1(new FilterJob<void>(boost::bind(&GLRenderer::getDepthBuffer, mesh_renderer_.get(), depth)));
+  const Sensor& s = getSensor(sensor);
+  JobPtr job1(new FilterJob<void>(boost::bind(&GLRenderer::getDepthBuffer, s.mesh_renderer.get(), depth)));
   JobPtr job2(new FilterJob<void>(
-      boost::bind(&SensorModel::Parameters::transformModelDepthToMetricDepth, sensor_parameters_.get(), depth)));
+      boost::bind(&SensorModel::Parameters::transformModelDepthToMetricDepth, s.parameters.get(), depth)));
   {
     boost::unique_lock<boost::mutex> lock(jobs_mutex_);
     jobs_queue_.push(job1);
@@ -239,11 +387,12 @@ void mesh_filter::MeshFilterBase::getModelDepth(float* depth) const
   job2->wait();
 }
 
-void mesh_filter::MeshFilterBase::getFilteredDepth(float* depth) const
+void mesh_filter::MeshFilterBase::getFilteredDepth(float* depth, SensorHandle sensor) const
 {
-  JobPtr job1(new FilterJob<void>(boost::bind(&GLRenderer::getDepthBuffer, depth_filter_.get(), depth)));
+  const Sensor& s = getSensor(sensor);
+  JobPtr job1(new FilterJob<void>(boost::bind(&GLRenderer::getDepthBuffer, s.depth_filter.get(), depth)));
   JobPtr job2(new FilterJob<void>(
-      boost::bind(&SensorModel::Parameters::transformFilteredDepthToMetricDepth, sensor_parameters_.get(), depth)));
+      boost::bind(&SensorModel::Parameters::transformFilteredDepthToMetricDepth, s.parameters.get(), depth)));
   {
     boost::unique_lock<boost::mutex> lock(jobs_mutex_);
     jobs_queue_.push(job1);
@@ -254,10 +403,65 @@ void mesh_filter::MeshFilterBase::getFilteredDepth(float* depth) const
   job2->wait();
 }
 
-void mesh_filter::MeshFilterBase::getFilteredLabels(LabelType* labels) const
+void mesh_filter::MeshFilterBase::getFilteredKeys(const Eigen::Affine3f& map_H_sensor, float fx, float fy, float cx,
+                                                  float cy, float resolution, unsigned short* keys,
+                                                  SensorHandle sensor) const
+{
+  // the job is waited for, so the transform can be passed by reference (and keeps its alignment)
+  JobPtr job(new FilterJob<void>(boost::bind(&MeshFilterBase::doComputeKeys, this, boost::cref(map_H_sensor), fx, fy,
+                                             cx, cy, resolution, keys, sensor)));
+  addJob(job);
+  job->wait();
+}
+
+void mesh_filter::MeshFilterBase::doComputeKeys(const Eigen::Affine3f& map_H_sensor, float fx, float fy, float cx,
+                                                float cy, float resolution, unsigned short* keys,
+                                                SensorHandle sensor) const
+{
+  const Sensor& s = getSensor(sensor);
+  const SensorModel::Parameters& parameters = *s.parameters;
+  // shared by all sensors; only its buffer size follows the sensor
+  if (!key_renderer_)
+  {
+    key_renderer_.reset(new GLRenderer(parameters.getWidth(), parameters.getHeight(),
+                                       parameters.getNearClippingPlaneDistance(),
+                                       parameters.getFarClippingPlaneDistance()));
+    key_renderer_->setColorBufferFormat(GL_RGBA16);
+    key_renderer_->setShadersFromString(key_vertex_shader, key_fragment_shader);
+  }
+  key_renderer_->setBufferSize(parameters.getWidth(), parameters.getHeight());
+
+  key_renderer_->begin();
+  glDisable(GL_DEPTH_TEST);
+  glDisable(GL_CULL_FACE);
+  glDisable(GL_ALPHA_TEST);
+  glDisable(GL_BLEND);
+
+  const GLuint program = key_renderer_->getProgramID();
+  glUniform1i(glGetUniformLocation(program, "sensor"), 0);
+  glUniform1i(glGetUniformLocation(program, "label"), 4);
+  glUniform1f(glGetUniformLocation(program, "near"), parameters.getNearClippingPlaneDistance());
+  glUniform1f(glGetUniformLocation(program, "far"), parameters.getFarClippingPlaneDistance());
+  glUniform4f(glGetUniformLocation(program, "camera"), fx, fy, cx, cy);
+  glUniformMatrix4fv(glGetUniformLocation(program, "map_H_sensor"), 1, GL_FALSE, map_H_sensor.matrix().data());
+  glUniform1f(glGetUniformLocation(program, "inv_resolution"), 1.0f / resolution);
+
+  // the sensor depth uploaded by doFilter and the labels the second pass computed from it
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, s.sensor_depth_texture);
+  glActiveTexture(GL_TEXTURE4);
+  glBindTexture(GL_TEXTURE_2D, s.depth_filter->getColorTexture());
+  glCallList(canvas_);
+  key_renderer_->end();
+
+  key_renderer_->getColorBuffer(keys);
+}
+
+void mesh_filter::MeshFilterBase::getFilteredLabels(LabelType* labels, SensorHandle sensor) const
 {
+  const Sensor& s = getSensor(sensor);
   JobPtr job(
-      new FilterJob<void>(boost::bind(&GLRenderer::getColorBuffer, depth_filter_.get(), (unsigned char*)labels)));
+      new FilterJob<void>(boost::bind(&GLRenderer::getColorBuffer, s.depth_filter.get(), (unsigned char*)labels)));
   addJob(job);
   job->wait();
 }
@@ -272,6 +476,14 @@ void mesh_filter::MeshFilterBase::run(const std::string& render_vertex_shader,
   while (!stop_)
   {
     boost::unique_lock<boost::mutex> lock(jobs_mutex_);
+    // deliver the results still being read back before going idle; there is no rendering left to overlap them with
+    if (jobs_queue_.empty() && !pending_readbacks_.empty())
+    {
+      lock.unlock();
+      completeReadbacks(0);
+      continue;
+    }
+
     // check if we have new sensor data to be processed. If not, wait until we get notified.
     if (jobs_queue_.empty())
       jobs_condition_.wait(lock);
@@ -288,7 +500,7 @@ void mesh_filter::MeshFilterBase::run(const std::string& render_vertex_shader,
   deInitialize();
 }
 
-void mesh_filter::MeshFilterBase::filter(const void* sensor_data, GLushort type, bool wait) const
+void mesh_filter::MeshFilterBase::filter(const void* sensor_data, GLushort type, bool wait, SensorHandle sensor) const
 {
   if (type != GL_FLOAT && type != GL_UNSIGNED_SHORT)
   {
@@ -297,18 +509,82 @@ void mesh_filter::MeshFilterBase::filter(const void* sensor_data, GLushort type,
     throw std::runtime_error(msg.str());
   }
 
-  JobPtr job(new FilterJob<void>(boost::bind(&MeshFilterBase::doFilter, this, sensor_data, type)));
+  // the images of all sensors are rendered one after the other by the filtering thread, in its single context
+  JobPtr job(new FilterJob<void>(boost::bind(&MeshFilterBase::doFilter, this, sensor_data, type, sensor)));
   addJob(job);
   if (wait)
     job->wait();
 }
 
-void mesh_filter::MeshFilterBase::doFilter(const void* sensor_data, const int encoding) const
+void mesh_filter::MeshFilterBase::filterAsync(const void* sensor_data, GLushort type, const FilterCallback& callback,
+                                              SensorHandle sensor) const
+{
+  if (type != GL_FLOAT && type != GL_UNSIGNED_SHORT)
+  {
+    std::stringstream msg;
+    msg << "unknown type \"" << type << "\". Allowed values are GL_FLOAT or GL_UNSIGNED_SHORT.";
+    throw std::runtime_error(msg.str());
+  }
+
+  JobPtr job(
+      new FilterJob<void>(boost::bind(&MeshFilterBase::doFilterAsync, this, sensor_data, type, callback, sensor)));
+  addJob(job);
+}
+
+void mesh_filter::MeshFilterBase::doFilterAsync(const void* sensor_data, const int encoding,
+                                                const FilterCallback& callback, SensorHandle sensor) const
+{
+  doFilter(sensor_data, encoding, sensor);
+
+  Sensor& s = getSensor(sensor);
+  PendingReadback readback;
+  readback.sensor = sensor;
+  readback.slot = s.next_readback_slot;
+  readback.callback = callback;
+  s.next_readback_slot = (s.next_readback_slot + 1) % GLRenderer::READBACK_SLOTS;
+  s.depth_filter->readBuffersAsync(readback.slot);
+  pending_readbacks_.push_back(readback);
+
+  // the transfer of the previous image had the rendering of this one to complete, so it is mapped now; the
+  // transfer just started is left to overlap with the next image
+  completeReadbacks(1);
+}
+
+void mesh_filter::MeshFilterBase::completeReadbacks(std::size_t keep) const
+{
+  while (pending_readbacks_.size() > keep)
+  {
+    PendingReadback readback = pending_readbacks_.front();
+    pending_readbacks_.pop_front();
+
+    Sensor& s = getSensor(readback.sensor);
+    const unsigned char* color;
+    const float* depth;
+    if (!s.depth_filter->mapReadBuffers(readback.slot, color, depth))
+    {
+      ROS_ERROR("Could not map the filtered depth image read back from the GPU");
+      continue;
+    }
+
+    // the mapped memory is read-only, so the depth is converted to metric in a copy
+    const std::size_t size = s.parameters->getWidth() * s.parameters->getHeight();
+    s.readback_depth.assign(depth, depth + size);
+    s.parameters->transformFilteredDepthToMetricDepth(&s.readback_depth[0]);
+    readback.callback(reinterpret_cast<const LabelType*>(color), &s.readback_depth[0]);
+    s.depth_filter->unmapReadBuffers(readback.slot);
+  }
+}
+
+void mesh_filter::MeshFilterBase::doFilter(const void* sensor_data, const int encoding, SensorHandle sensor) const
 {
+  const Sensor& s = getSensor(sensor);
+  const SensorModel::Parameters& parameters = *s.parameters;
+  const GLRendererPtr& mesh_renderer = s.mesh_renderer;
+  const GLRendererPtr& depth_filter = s.depth_filter;
   boost::mutex::scoped_lock _(transform_callback_mutex_);
 
-  mesh_renderer_->begin();
-  sensor_parameters_->setRenderParameters(*mesh_renderer_);
+  mesh_renderer->begin();
+  parameters.setRenderParameters(*mesh_renderer);
 
   glEnable(GL_TEXTURE_2D);
   glEnable(GL_DEPTH_TEST);
@@ -318,23 +594,23 @@ void mesh_filter::MeshFilterBase::doFilter(const void* sensor_data, const int en
   glDisable(GL_ALPHA_TEST);
   glDisable(GL_BLEND);
 
-  GLuint padding_coefficients_id = glGetUniformLocation(mesh_renderer_->getProgramID(), "padding_coefficients");
+  GLuint padding_coefficients_id = glGetUniformLocation(mesh_renderer->getProgramID(), "padding_coefficients");
   Eigen::Vector3f padding_coefficients =
-      sensor_parameters_->getPaddingCoefficients() * padding_scale_ + Eigen::Vector3f(0, 0, padding_offset_);
+      parameters.getPaddingCoefficients() * padding_scale_ + Eigen::Vector3f(0, 0, padding_offset_);
   glUniform3f(padding_coefficients_id, padding_coefficients[0], padding_coefficients[1], padding_coefficients[2]);
 
   Eigen::Affine3d transform;
   for (std::map<MeshHandle, GLMeshPtr>::const_iterator meshIt = meshes_.begin(); meshIt != meshes_.end(); ++meshIt)
-    if (transform_callback_(meshIt->first, transform))
+    if (s.transform_callback(meshIt->first, transform))
       meshIt->second->render(transform);
 
-  mesh_renderer_->end();
+  mesh_renderer->end();
 
   // now filter the depth_map with the second rendering stage
   // depth_filter_.setBufferSize (width, height);
   // depth_filter_.setCameraParameters (fx, fy, cx, cy);
-  depth_filter_->begin();
-  sensor_parameters_->setFilterParameters(*depth_filter_);
+  depth_filter->begin();
+  parameters.setFilterParameters(*depth_filter);
   glEnable(GL_TEXTURE_2D);
   glEnable(GL_DEPTH_TEST);
   glDepthFunc(GL_ALWAYS);
@@ -344,17 +620,17 @@ void mesh_filter::MeshFilterBase::doFilter(const void* sensor_data, const int en
 
   //  glUniform1f (near_location_, depth_filter_.getNearClippingDistance ());
   //  glUniform1f (far_location_, depth_filter_.getFarClippingDistance ());
-  glUniform1f(shadow_threshold_location_, shadow_threshold_);
+  glUniform1f(s.shadow_threshold_location, shadow_threshold_);
 
-  GLuint depth_texture = mesh_renderer_->getDepthTexture();
-  GLuint color_texture = mesh_renderer_->getColorTexture();
+  GLuint depth_texture = mesh_renderer->getDepthTexture();
+  GLuint color_texture = mesh_renderer->getColorTexture();
 
   // bind sensor depth
   glActiveTexture(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_2D, sensor_depth_texture_);
+  glBindTexture(GL_TEXTURE_2D, s.sensor_depth_texture);
 
   float scale =
-      1.0 / (sensor_parameters_->getFarClippingPlaneDistance() - sensor_parameters_->getNearClippingPlaneDistance());
+      1.0 / (parameters.getFarClippingPlaneDistance() - parameters.getNearClippingPlaneDistance());
 
   if (encoding == GL_UNSIGNED_SHORT)
     // unsigned shorts shorts will be mapped to the range 0-1 during transfer. Afterwards we can apply another scale +
@@ -365,9 +641,9 @@ void mesh_filter::MeshFilterBase::doFilter(const void* sensor_data, const int en
     glPixelTransferf(GL_DEPTH_SCALE, scale * 65.535);
   else
     glPixelTransferf(GL_DEPTH_SCALE, scale);
-  glPixelTransferf(GL_DEPTH_BIAS, -scale * sensor_parameters_->getNearClippingPlaneDistance());
+  glPixelTransferf(GL_DEPTH_BIAS, -scale * parameters.getNearClippingPlaneDistance());
 
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, sensor_parameters_->getWidth(), sensor_parameters_->getHeight(), 0,
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, parameters.getWidth(), parameters.getHeight(), 0,
                GL_DEPTH_COMPONENT, encoding, sensor_data);
   glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
   glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
@@ -382,7 +658,7 @@ void mesh_filter::MeshFilterBase::doFilter(const void* sensor_data, const int en
   glActiveTexture(GL_TEXTURE4);
   glBindTexture(GL_TEXTURE_2D, color_texture);
   glCallList(canvas_);
-  depth_filter_->end();
+  depth_filter->end();
 }
 
 void mesh_filter::MeshFilterBase::setPaddingOffset(float offset)
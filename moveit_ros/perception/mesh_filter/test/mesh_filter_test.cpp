@@ -39,6 +39,7 @@
 #include <geometric_shapes/shape_operations.h>
 #include <eigen3/Eigen/Eigen>
 #include <vector>
+#include <stdexcept>
 
 using namespace mesh_filter;
 using namespace Eigen;
@@ -86,6 +87,8 @@ public:
   MeshFilterTest(unsigned width = 500, unsigned height = 500, double near = 0.5, double far = 5.0, double shadow = 0.1,
                  double epsilon = 1e-7);
   void test();
+  void testSecondSensor();
+  void testAsync();
   void setMeshDistance(double distance)
   {
     distance_ = distance;
@@ -95,6 +98,7 @@ private:
   shapes::Mesh createMesh(double z) const;
   bool transform_callback(MeshHandle handle, Affine3d& transform) const;
   void getGroundTruth(unsigned int* labels, float* depth) const;
+  void asyncCallback(const LabelType* labels, const float* depth);
   const unsigned int width_;
   const unsigned int height_;
   const double near_;
@@ -106,6 +110,10 @@ private:
   MeshHandle handle_;
   vector<Type> sensor_data_;
   double distance_;
+  vector<float> async_depth_;
+  vector<unsigned int> async_labels_;
+  boost::mutex async_mutex_;
+  boost::condition_variable async_condition_;
 };
 
 template <typename Type>
@@ -238,6 +246,65 @@ void MeshFilterTest<Type>::test()
   filter_.removeMesh(handle);
 }
 
+template <typename Type>
+void MeshFilterTest<Type>::testSecondSensor()
+{
+  // a second sensor with the same parameters and view has to give the same results from the shared meshes
+  mesh_filter::SensorHandle sensor =
+      filter_.addSensor(sensor_parameters_, boost::bind(&MeshFilterTest<Type>::transform_callback, this, _1, _2));
+  ASSERT_NE(sensor, MeshFilterBase::DefaultSensor);
+  filter_.filter(&sensor_data_[0], FilterTraits<Type>::FILTER_GL_TYPE, false);
+  filter_.filter(&sensor_data_[0], FilterTraits<Type>::FILTER_GL_TYPE, false, sensor);
+
+  vector<float> default_depth(width_ * height_), sensor_depth(width_ * height_);
+  vector<unsigned int> default_labels(width_ * height_), sensor_labels(width_ * height_);
+  filter_.getFilteredDepth(&default_depth[0]);
+  filter_.getFilteredLabels(&default_labels[0]);
+  filter_.getFilteredDepth(&sensor_depth[0], sensor);
+  filter_.getFilteredLabels(&sensor_labels[0], sensor);
+
+  for (unsigned idx = 0; idx < width_ * height_; ++idx)
+  {
+    ASSERT_FLOAT_EQ(default_depth[idx], sensor_depth[idx]);
+    ASSERT_EQ(default_labels[idx], sensor_labels[idx]);
+  }
+  filter_.removeSensor(sensor);
+  EXPECT_THROW(filter_.removeSensor(sensor), std::runtime_error);
+}
+
+template <typename Type>
+void MeshFilterTest<Type>::asyncCallback(const LabelType* labels, const float* depth)
+{
+  boost::mutex::scoped_lock lock(async_mutex_);
+  async_labels_.assign(labels, labels + width_ * height_);
+  async_depth_.assign(depth, depth + width_ * height_);
+  async_condition_.notify_all();
+}
+
+template <typename Type>
+void MeshFilterTest<Type>::testAsync()
+{
+  // the results read back through pixel buffer objects have to match the ones read back synchronously
+  filter_.filter(&sensor_data_[0], FilterTraits<Type>::FILTER_GL_TYPE, true);
+  vector<float> filtered_depth(width_ * height_);
+  vector<unsigned int> filtered_labels(width_ * height_);
+  filter_.getFilteredDepth(&filtered_depth[0]);
+  filter_.getFilteredLabels(&filtered_labels[0]);
+
+  boost::mutex::scoped_lock lock(async_mutex_);
+  async_labels_.clear();
+  filter_.filterAsync(&sensor_data_[0], FilterTraits<Type>::FILTER_GL_TYPE,
+                      boost::bind(&MeshFilterTest<Type>::asyncCallback, this, _1, _2));
+  while (async_labels_.empty())
+    ASSERT_TRUE(async_condition_.timed_wait(lock, boost::posix_time::seconds(5)));
+
+  for (unsigned idx = 0; idx < width_ * height_; ++idx)
+  {
+    ASSERT_FLOAT_EQ(filtered_depth[idx], async_depth_[idx]);
+    ASSERT_EQ(filtered_labels[idx], async_labels_[idx]);
+  }
+}
+
 template <typename Type>
 void MeshFilterTest<Type>::getGroundTruth(unsigned int* labels, float* depth) const
 {
@@ -308,6 +375,22 @@ TEST_P(MeshFilterTestFloat, float)
 }
 INSTANTIATE_TEST_CASE_P(float_test, MeshFilterTestFloat, ::testing::Range<double>(0.0f, 6.0f, 0.5f));
 
+typedef mesh_filter_test::MeshFilterTest<float> MeshFilterTestSecondSensor;
+TEST_P(MeshFilterTestSecondSensor, second_sensor)
+{
+  this->setMeshDistance(this->GetParam());
+  this->testSecondSensor();
+}
+INSTANTIATE_TEST_CASE_P(second_sensor_test, MeshFilterTestSecondSensor, ::testing::Range<double>(0.0f, 6.0f, 1.5f));
+
+typedef mesh_filter_test::MeshFilterTest<unsigned short> MeshFilterTestAsync;
+TEST_P(MeshFilterTestAsync, async)
+{
+  this->setMeshDistance(this->GetParam());
+  this->testAsync();
+}
+INSTANTIATE_TEST_CASE_P(async_test, MeshFilterTestAsync, ::testing::Range<double>(0.0f, 6.0f, 1.5f));
+
 typedef mesh_filter_test::MeshFilterTest<unsigned short> MeshFilterTestUnsignedShort;
 TEST_P(MeshFilterTestUnsignedShort, unsigned_short)
 {
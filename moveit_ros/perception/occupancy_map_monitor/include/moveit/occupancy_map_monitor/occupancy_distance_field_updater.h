@@ -0,0 +1,121 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_OCCUPANCY_MAP_MONITOR_OCCUPANCY_DISTANCE_FIELD_UPDATER_
+#define MOVEIT_OCCUPANCY_MAP_MONITOR_OCCUPANCY_DISTANCE_FIELD_UPDATER_
+
+#include <moveit/occupancy_map_monitor/occupancy_map.h>
+#include <moveit/distance_field/distance_field.h>
+#include <moveit/macros/class_forward.h>
+#include <boost/thread/shared_mutex.hpp>
+
+namespace occupancy_map_monitor
+{
+MOVEIT_CLASS_FORWARD(OccupancyDistanceFieldUpdater);
+
+/**
+ * @brief Keeps a distance field in sync with the occupied leaves of an
+ * OccMapTree.
+ *
+ * On every update of the tree, the leaves reported by the octomap change
+ * detection are compared with the occupied cells the field was last given,
+ * and only the cells that became occupied or free are passed to
+ * DistanceField::updatePointsInField(). The field should have the
+ * resolution of the tree, so that every leaf maps to one cell.
+ *
+ * The change detection of the tree is shared with other users, e.g. the
+ * PlanningSceneMonitor resets it when it publishes octomap diffs. Unless
+ * told otherwise, the updater therefore only reads the changed leaves;
+ * leaves that are reported again are compared with the field and cost
+ * little. rebuild() resynchronizes the field with all leaves.
+ */
+class OccupancyDistanceFieldUpdater
+{
+public:
+  /** @brief Construct an updater that keeps \e field in sync with \e tree once started.
+   *  @param reset_change_detection Whether to reset the change detection of the tree after every update; only
+   *  set this if nothing else uses the change detection of the tree */
+  OccupancyDistanceFieldUpdater(const OccMapTreePtr& tree, const distance_field::DistanceFieldPtr& field,
+                                bool reset_change_detection = false);
+  ~OccupancyDistanceFieldUpdater();
+
+  /** @brief Fill the field from the current tree and follow its updates */
+  void start();
+
+  /** @brief Stop following the updates of the tree */
+  void stop();
+
+  /** @brief Pass the leaves changed since the last update to the field. Called on every update of the tree. */
+  void update();
+
+  /** @brief Clear the field and add all occupied leaves of the tree */
+  void rebuild();
+
+  /** @brief Get the distance field. Use reading() while querying it, as it is written on every tree update. */
+  const distance_field::DistanceFieldPtr& getDistanceField() const
+  {
+    return field_;
+  }
+
+  typedef boost::shared_lock<boost::shared_mutex> ReadLock;
+
+  /** @brief Lock the distance field for reading; no updates are applied to it while the lock is held */
+  ReadLock reading() const
+  {
+    return ReadLock(field_mutex_);
+  }
+
+  /** @brief Set a callback to trigger after the field has been updated */
+  void setUpdateCallback(const boost::function<void()>& update_callback)
+  {
+    update_callback_ = update_callback;
+  }
+
+private:
+  OccMapTreePtr tree_;
+  distance_field::DistanceFieldPtr field_;
+  bool reset_change_detection_;
+
+  mutable boost::shared_mutex field_mutex_;
+
+  /** @brief The leaves that are occupied cells of the field */
+  octomap::KeySet occupied_keys_;
+
+  bool active_;
+  std::size_t tree_callback_handle_;
+  boost::function<void()> update_callback_;
+};
+}
+
+#endif
@@ -39,21 +39,38 @@
 
 #include <octomap/octomap.h>
 #include <boost/thread/shared_mutex.hpp>
+#include <boost/thread/mutex.hpp>
 #include <boost/function.hpp>
 #include <memory>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
 
 namespace occupancy_map_monitor
 {
 typedef octomap::OcTreeNode OccMapNode;
 
+/** @brief A leaf of the octree in the form it is persisted in: the key of the leaf at its depth, and its log-odds */
+struct OccMapLeaf
+{
+  octomap::key_type key[3];
+  uint8_t depth;
+  uint8_t reserved;
+  float log_odds;
+};
+
+/** @brief Leaves of the octree grouped by the key of the node at a fixed depth containing them */
+typedef std::unordered_map<octomap::OcTreeKey, std::vector<OccMapLeaf>, octomap::OcTreeKey::KeyHash> OccMapTileLeaves;
+
 class OccMapTree : public octomap::OcTree
 {
 public:
-  OccMapTree(double resolution) : octomap::OcTree(resolution)
+  OccMapTree(double resolution) : octomap::OcTree(resolution), next_update_callback_handle_(0)
   {
   }
 
-  OccMapTree(const std::string& filename) : octomap::OcTree(filename)
+  OccMapTree(const std::string& filename) : octomap::OcTree(filename), next_update_callback_handle_(0)
   {
   }
 
@@ -100,6 +117,10 @@ public:
   {
     if (update_callback_)
       update_callback_();
+    boost::mutex::scoped_lock lock(update_callbacks_lock_);
+    for (std::map<std::size_t, boost::function<void()> >::iterator it = update_callbacks_.begin();
+         it != update_callbacks_.end(); ++it)
+      it->second();
   }
 
   /** @brief Set the callback to trigger when updates are received */
@@ -108,9 +129,56 @@ public:
     update_callback_ = update_callback;
   }
 
+  /** @brief Add a callback to trigger when updates are received, in addition to the one set with
+   *  setUpdateCallback(). The returned handle identifies the callback for removeUpdateCallback().
+   *  The callback must not add or remove update callbacks itself. */
+  std::size_t addUpdateCallback(const boost::function<void()>& update_callback)
+  {
+    boost::mutex::scoped_lock lock(update_callbacks_lock_);
+    update_callbacks_[next_update_callback_handle_] = update_callback;
+    return next_update_callback_handle_++;
+  }
+
+  /** @brief Remove a callback added with addUpdateCallback(). Once this returns, the callback is not running and
+   *  will not be called again. */
+  void removeUpdateCallback(std::size_t handle)
+  {
+    boost::mutex::scoped_lock lock(update_callbacks_lock_);
+    update_callbacks_.erase(handle);
+  }
+
+  /** @brief Remove the leaves that lie entirely outside the axis-aligned box [\e min, \e max]; leaves crossing its
+   *  boundary are kept. Returns the number of leaves removed. The write lock must be held. */
+  std::size_t cropToBox(const octomap::point3d& min, const octomap::point3d& max);
+
+  /** @brief Replace the leaves deeper than \e depth that lie in cells of that depth entirely outside the box
+   *  [\e min, \e max] by a single leaf per cell, holding the maximum log-odds of the leaves it replaces. The tree is
+   *  then only kept at full resolution inside the box. Returns the number of cells coarsened. The write lock must be
+   *  held. */
+  std::size_t coarsenOutsideBox(const octomap::point3d& min, const octomap::point3d& max, unsigned int depth);
+
+  /** @brief Collect the leaves of the tree into \e tiles, grouped by the key of the node at \e depth that contains
+   *  them. A leaf coarser than \e depth is reported once for every node at \e depth it covers. The read lock must be
+   *  held. */
+  void getTileLeaves(unsigned int depth, OccMapTileLeaves& tiles) const;
+
+  /** @brief Insert \e count leaves into the tree, replacing whatever it holds in the cells they cover. The occupancy of
+   *  inner nodes is not updated; call updateInnerOccupancy() once all leaves are inserted. The write lock must be
+   *  held. */
+  void setLeaves(const OccMapLeaf* leaves, std::size_t count);
+
 private:
+  void collectTileLeaves(const OccMapNode* node, const octomap::OcTreeKey& key, unsigned int depth,
+                         unsigned int tile_depth, OccMapTileLeaves& tiles) const;
+  void collectLeaves(const OccMapNode* node, const octomap::OcTreeKey& key, unsigned int depth,
+                     std::vector<OccMapLeaf>& leaves) const;
+
   boost::shared_mutex tree_mutex_;
   boost::function<void()> update_callback_;
+
+  boost::mutex update_callbacks_lock_;
+  std::map<std::size_t, boost::function<void()> > update_callbacks_;
+  std::size_t next_update_callback_handle_;
 };
 
 typedef std::shared_ptr<OccMapTree> OccMapTreePtr;
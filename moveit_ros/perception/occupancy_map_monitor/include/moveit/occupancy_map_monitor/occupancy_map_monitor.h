@@ -47,6 +47,8 @@
 #include <moveit_msgs/LoadMap.h>
 #include <moveit/occupancy_map_monitor/occupancy_map.h>
 #include <moveit/occupancy_map_monitor/occupancy_map_updater.h>
+#include <moveit/occupancy_map_monitor/occupancy_map_update_merger.h>
+#include <moveit/occupancy_map_monitor/occupancy_map_tile_store.h>
 
 #include <boost/thread/mutex.hpp>
 
@@ -124,6 +126,13 @@ public:
     return active_;
   }
 
+  /** @brief Get the merger the updaters should push their cells to instead of writing to the octree themselves,
+   *  or NULL if each updater writes its own frames. A merger is used when the octomap_update_rate parameter is set. */
+  OccupancyMapUpdateMerger* getUpdateMerger() const
+  {
+    return update_merger_.get();
+  }
+
 private:
   void initialize();
 
@@ -133,6 +142,18 @@ private:
   /** @brief Load octree from a binary file (gets rid of current octree data) */
   bool loadMapCallback(moveit_msgs::LoadMap::Request& request, moveit_msgs::LoadMap::Response& response);
 
+  /** @brief Read the region of interest and dual resolution parameters */
+  void initializeRegionOfInterest();
+
+  /** @brief Crop and coarsen the octree around the current position of the region of interest frame */
+  void cropMapCallback(const ros::WallTimerEvent& event);
+
+  /** @brief Read the parameters of the tile store the octree is persisted in */
+  void initializeTileStore();
+
+  /** @brief Write the tiles of the octree that changed since they were last read or written */
+  void saveTilesCallback(const ros::WallTimerEvent& event);
+
   bool getShapeTransformCache(std::size_t index, const std::string& target_frame, const ros::Time& target_time,
                               ShapeTransformCache& cache) const;
 
@@ -144,6 +165,21 @@ private:
   OccMapTreePtr tree_;
   OccMapTreeConstPtr tree_const_;
 
+  std::unique_ptr<OccupancyMapUpdateMerger> update_merger_;
+
+  /* the octree is periodically cropped to a box of size roi_size_ centered at the origin of roi_frame_, and kept
+     at full resolution only inside a box of size fine_size_; a zero size disables the corresponding step */
+  std::string roi_frame_;
+  octomap::point3d roi_size_;
+  octomap::point3d fine_size_;
+  unsigned int coarse_depth_;
+  ros::WallTimer crop_timer_;
+
+  /* when a tile directory is given, the octree is persisted in tiles that are read and written as the region of
+     interest moves, and the changed tiles are also written periodically */
+  std::unique_ptr<OccupancyMapTileStore> tile_store_;
+  ros::WallTimer tile_save_timer_;
+
   std::unique_ptr<pluginlib::ClassLoader<OccupancyMapUpdater> > updater_plugin_loader_;
   std::vector<OccupancyMapUpdaterPtr> map_updaters_;
   std::vector<std::map<ShapeHandle, ShapeHandle> > mesh_handles_;
@@ -0,0 +1,113 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_OCCUPANCY_MAP_MONITOR_OCCUPANCY_MAP_TILE_STORE_
+#define MOVEIT_OCCUPANCY_MAP_MONITOR_OCCUPANCY_MAP_TILE_STORE_
+
+#include <moveit/occupancy_map_monitor/occupancy_map.h>
+#include <boost/thread/mutex.hpp>
+#include <string>
+
+namespace occupancy_map_monitor
+{
+/** @brief Persists an octree as a directory of tiles, one file per node at a fixed depth of the tree. Tiles are read
+ *  on demand as a region of interest moves through the map, and only the tiles whose content changed since they were
+ *  read or last written are written back. The methods lock the tree themselves and may be called from any thread. */
+class OccupancyMapTileStore
+{
+public:
+  /** @brief Use the tiles in \e directory, which is created if needed. The edge length of the tiles is \e tile_size
+   *  rounded to a power of two times the resolution of \e tree. */
+  OccupancyMapTileStore(const OccMapTreePtr& tree, const std::string& directory, double tile_size);
+
+  const std::string& getDirectory() const
+  {
+    return directory_;
+  }
+
+  double getTileSize() const
+  {
+    return tree_->getNodeSize(tile_depth_);
+  }
+
+  /** @brief Read the stored tiles that intersect the box [\e min, \e max] and are not in the tree yet. Returns the
+   *  number of tiles read. */
+  std::size_t loadTiles(const octomap::point3d& min, const octomap::point3d& max);
+
+  /** @brief Read all stored tiles that are not in the tree yet. Returns the number of tiles read. */
+  std::size_t loadAllTiles();
+
+  /** @brief Write the changed tiles that lie entirely outside the box [\e min, \e max] and remove them from the
+   *  tree. Returns the number of leaves removed. */
+  std::size_t unloadTiles(const octomap::point3d& min, const octomap::point3d& max);
+
+  /** @brief Write the tiles in the tree that changed since they were read or last written. Returns the number of
+   *  tiles written. */
+  std::size_t saveTiles();
+
+  /** @brief Forget which tiles are in the tree, for instance after the tree was replaced. Stored tiles are read
+   *  again when the region of interest next covers them. */
+  void resetLoadedTiles();
+
+private:
+  typedef std::unordered_map<octomap::OcTreeKey, std::size_t, octomap::OcTreeKey::KeyHash> TileHashes;
+
+  /** @brief Scan the directory for tiles of the configured depth */
+  void scanDirectory();
+
+  /** @brief Get the key of the tile containing \e point, clamped to the extent of the tree */
+  octomap::OcTreeKey getTileKey(const octomap::point3d& point) const;
+
+  /** @brief Write a tile taken from the tree if it changed since it was last read or written. A stored tile that was
+   *  not read is never written, since the tree only holds the part of it observed since. Returns true if the tile
+   *  was written. */
+  bool saveTile(const octomap::OcTreeKey& tile_key, const std::vector<OccMapLeaf>& leaves);
+
+  std::string getTilePath(const octomap::OcTreeKey& tile_key) const;
+  bool readTile(const octomap::OcTreeKey& tile_key, std::vector<OccMapLeaf>& leaves) const;
+  bool writeTile(const octomap::OcTreeKey& tile_key, const std::vector<OccMapLeaf>& leaves) const;
+
+  OccMapTreePtr tree_;
+  std::string directory_;
+  unsigned int tile_depth_;
+
+  /* the hash of the content of each tile in the tree when it was last read or written; the tiles not listed were
+     either never stored or not read yet */
+  boost::mutex store_lock_;
+  TileHashes loaded_tiles_;
+  octomap::KeySet stored_tiles_;
+};
+}
+
+#endif
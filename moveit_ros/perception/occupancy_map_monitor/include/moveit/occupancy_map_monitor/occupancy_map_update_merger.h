@@ -0,0 +1,93 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_OCCUPANCY_MAP_MONITOR_OCCUPANCY_MAP_UPDATE_MERGER_
+#define MOVEIT_OCCUPANCY_MAP_MONITOR_OCCUPANCY_MAP_UPDATE_MERGER_
+
+#include <moveit/occupancy_map_monitor/occupancy_map.h>
+#include <boost/thread.hpp>
+#include <unordered_map>
+
+namespace occupancy_map_monitor
+{
+/** \brief Merges the cells observed by several sensors and applies them to the octree from a single writer thread.
+    Updaters compute their cell sets without holding the tree lock and push them here; the writer takes the write
+    lock once per period for all the cells pushed since the previous batch, so the time the lock is held depends on
+    the number of distinct cells observed, not on the number of sensors. */
+class OccupancyMapUpdateMerger
+{
+public:
+  /** \brief Construct a merger that applies at most \e update_rate batches per second to \e tree */
+  OccupancyMapUpdateMerger(const OccMapTreePtr& tree, double update_rate);
+  ~OccupancyMapUpdateMerger();
+
+  /** \brief Start the writer thread */
+  void start();
+
+  /** \brief Stop the writer thread. Cells pushed but not applied yet are discarded. */
+  void stop();
+
+  /** \brief Queue the cells one sensor observed in one frame. The sets are expected to be disjoint, as an updater
+      writing them directly would make them. Cells observed several times in a batch are updated as many times. */
+  void pushUpdate(const octomap::KeySet& free_cells, const octomap::KeySet& occupied_cells,
+                  const octomap::KeySet& model_cells);
+
+  double getUpdateRate() const
+  {
+    return update_rate_;
+  }
+
+private:
+  typedef std::unordered_map<octomap::OcTreeKey, unsigned int, octomap::OcTreeKey::KeyHash> OcTreeKeyCountMap;
+
+  void writerThread();
+  void applyBatch(const OcTreeKeyCountMap& free_cells, const OcTreeKeyCountMap& occupied_cells,
+                  const octomap::KeySet& model_cells);
+
+  OccMapTreePtr tree_;
+  double update_rate_;
+  bool running_;
+
+  /* the cells pushed since the last batch was taken */
+  OcTreeKeyCountMap pending_free_cells_;
+  OcTreeKeyCountMap pending_occupied_cells_;
+  octomap::KeySet pending_model_cells_;
+  boost::mutex pending_lock_;
+  boost::condition_variable pending_condition_;
+
+  boost::thread writer_thread_;
+};
+}
+
+#endif
@@ -0,0 +1,166 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/occupancy_map_monitor/occupancy_distance_field_updater.h>
+#include <boost/bind.hpp>
+#include <ros/console.h>
+#include <cmath>
+
+namespace occupancy_map_monitor
+{
+OccupancyDistanceFieldUpdater::OccupancyDistanceFieldUpdater(const OccMapTreePtr& tree,
+                                                             const distance_field::DistanceFieldPtr& field,
+                                                             bool reset_change_detection)
+  : tree_(tree)
+  , field_(field)
+  , reset_change_detection_(reset_change_detection)
+  , active_(false)
+  , tree_callback_handle_(0)
+{
+  if (fabs(field_->getResolution() - tree_->getResolution()) > 1e-9)
+    ROS_WARN("Distance field resolution %g differs from octree resolution %g; leaves that share a cell will not "
+             "be updated correctly",
+             field_->getResolution(), tree_->getResolution());
+}
+
+OccupancyDistanceFieldUpdater::~OccupancyDistanceFieldUpdater()
+{
+  stop();
+}
+
+void OccupancyDistanceFieldUpdater::start()
+{
+  if (active_)
+    return;
+  tree_->lockWrite();
+  tree_->enableChangeDetection(true);
+  tree_->unlockWrite();
+
+  // updates that arrive while rebuilding wait for it, and find their leaves already in the field
+  tree_callback_handle_ = tree_->addUpdateCallback(boost::bind(&OccupancyDistanceFieldUpdater::update, this));
+  active_ = true;
+  rebuild();
+}
+
+void OccupancyDistanceFieldUpdater::stop()
+{
+  if (!active_)
+    return;
+  tree_->removeUpdateCallback(tree_callback_handle_);
+  active_ = false;
+}
+
+void OccupancyDistanceFieldUpdater::update()
+{
+  boost::unique_lock<boost::shared_mutex> lock(field_mutex_);
+  EigenSTL::vector_Vector3d added, removed;
+  {
+    OccMapTree::ReadLock tree_lock = tree_->reading();
+    for (octomap::KeyBoolMap::const_iterator it = tree_->changedKeysBegin(), end = tree_->changedKeysEnd(); it != end;
+         ++it)
+    {
+      const OccMapNode* node = tree_->search(it->first);
+      bool occupied = node && tree_->isNodeOccupied(node);
+      octomap::KeySet::iterator key = occupied_keys_.find(it->first);
+      if (occupied == (key != occupied_keys_.end()))
+        continue;
+
+      octomap::point3d p = tree_->keyToCoord(it->first);
+      if (occupied)
+      {
+        occupied_keys_.insert(it->first);
+        added.push_back(Eigen::Vector3d(p.x(), p.y(), p.z()));
+      }
+      else
+      {
+        occupied_keys_.erase(key);
+        removed.push_back(Eigen::Vector3d(p.x(), p.y(), p.z()));
+      }
+    }
+    if (reset_change_detection_)
+      tree_->resetChangeDetection();
+  }
+
+  if (added.empty() && removed.empty())
+    return;
+  field_->updatePointsInField(removed, added);
+  lock.unlock();
+
+  ROS_DEBUG("Updated distance field with %u new and %u removed occupied cells", (unsigned int)added.size(),
+            (unsigned int)removed.size());
+  if (update_callback_)
+    update_callback_();
+}
+
+void OccupancyDistanceFieldUpdater::rebuild()
+{
+  boost::unique_lock<boost::shared_mutex> lock(field_mutex_);
+  EigenSTL::vector_Vector3d points;
+  occupied_keys_.clear();
+  {
+    OccMapTree::ReadLock tree_lock = tree_->reading();
+    const double resolution = tree_->getResolution();
+    for (OccMapTree::leaf_iterator it = tree_->begin_leafs(), end = tree_->end_leafs(); it != end; ++it)
+    {
+      if (!tree_->isNodeOccupied(*it))
+        continue;
+      // pruned leaves stand for all the leaves of the maximum depth they contain
+      const int n = 1 << (tree_->getTreeDepth() - it.getDepth());
+      const double start_x = it.getX() - 0.5 * it.getSize() + 0.5 * resolution;
+      const double start_y = it.getY() - 0.5 * it.getSize() + 0.5 * resolution;
+      const double start_z = it.getZ() - 0.5 * it.getSize() + 0.5 * resolution;
+      for (int i = 0; i < n; ++i)
+        for (int j = 0; j < n; ++j)
+          for (int k = 0; k < n; ++k)
+          {
+            octomap::OcTreeKey key = tree_->coordToKey(start_x + i * resolution, start_y + j * resolution,
+                                                       start_z + k * resolution);
+            occupied_keys_.insert(key);
+            octomap::point3d p = tree_->keyToCoord(key);
+            points.push_back(Eigen::Vector3d(p.x(), p.y(), p.z()));
+          }
+    }
+    if (reset_change_detection_)
+      tree_->resetChangeDetection();
+  }
+
+  field_->reset();
+  field_->addPointsToField(points);
+  lock.unlock();
+
+  ROS_DEBUG("Rebuilt distance field from %u occupied cells", (unsigned int)points.size());
+  if (update_callback_)
+    update_callback_();
+}
+}
@@ -0,0 +1,212 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/occupancy_map_monitor/occupancy_map.h>
+#include <unordered_map>
+#include <algorithm>
+#include <vector>
+
+namespace occupancy_map_monitor
+{
+namespace
+{
+// true if the cube centered at c with half size h does not intersect the box [min, max]
+bool cellOutsideBox(const octomap::point3d& c, double h, const octomap::point3d& min, const octomap::point3d& max)
+{
+  return c.x() + h < min.x() || c.x() - h > max.x() || c.y() + h < min.y() || c.y() - h > max.y() ||
+         c.z() + h < min.z() || c.z() - h > max.z();
+}
+}
+
+std::size_t OccMapTree::cropToBox(const octomap::point3d& min, const octomap::point3d& max)
+{
+  std::vector<std::pair<octomap::OcTreeKey, unsigned int> > outside;
+  for (leaf_iterator it = begin_leafs(), end = end_leafs(); it != end; ++it)
+    if (cellOutsideBox(it.getCoordinate(), it.getSize() * 0.5, min, max))
+      outside.push_back(std::make_pair(it.getKey(), it.getDepth()));
+
+  // deleting while iterating would invalidate the iterator, so the leaves are removed afterwards
+  for (std::size_t i = 0; i < outside.size(); ++i)
+    deleteNode(outside[i].first, outside[i].second);
+  return outside.size();
+}
+
+std::size_t OccMapTree::coarsenOutsideBox(const octomap::point3d& min, const octomap::point3d& max,
+                                          unsigned int depth)
+{
+  const unsigned int tree_depth = getTreeDepth();
+  if (depth >= tree_depth)
+    return 0;
+
+  /* find the cells at the coarse depth that still hold finer leaves, and the largest log-odds among those leaves */
+  const double coarse_half_size = getNodeSize(depth) * 0.5;
+  std::unordered_map<octomap::OcTreeKey, float, octomap::OcTreeKey::KeyHash> coarse_cells;
+  for (leaf_iterator it = begin_leafs(), end = end_leafs(); it != end; ++it)
+  {
+    if (it.getDepth() <= depth)
+      continue;
+    const octomap::OcTreeKey key = adjustKeyAtDepth(it.getKey(), depth);
+    if (!cellOutsideBox(keyToCoord(key, depth), coarse_half_size, min, max))
+      continue;
+    const float log_odds = it->getLogOdds();
+    std::pair<std::unordered_map<octomap::OcTreeKey, float, octomap::OcTreeKey::KeyHash>::iterator, bool> ins =
+        coarse_cells.insert(std::make_pair(key, log_odds));
+    if (!ins.second)
+      ins.first->second = std::max(ins.first->second, log_odds);
+  }
+  if (coarse_cells.empty())
+    return 0;
+
+  /* octomap only creates nodes at the finest depth, so each coarse cell is refilled with identical leaves that
+     prune() then collapses into one */
+  const unsigned int levels = tree_depth - depth;
+  const octomap::key_type cells_per_axis = 1 << levels;
+  const octomap::key_type first_offset = cells_per_axis >> 1;
+  for (std::unordered_map<octomap::OcTreeKey, float, octomap::OcTreeKey::KeyHash>::const_iterator
+           it = coarse_cells.begin(),
+           end = coarse_cells.end();
+       it != end; ++it)
+  {
+    deleteNode(it->first, depth);
+    octomap::OcTreeKey key;
+    for (octomap::key_type i = 0; i < cells_per_axis; ++i)
+    {
+      key[0] = it->first[0] - first_offset + i;
+      for (octomap::key_type j = 0; j < cells_per_axis; ++j)
+      {
+        key[1] = it->first[1] - first_offset + j;
+        for (octomap::key_type k = 0; k < cells_per_axis; ++k)
+        {
+          key[2] = it->first[2] - first_offset + k;
+          setNodeValue(key, it->second, true);
+        }
+      }
+    }
+  }
+  updateInnerOccupancy();
+  prune();
+  return coarse_cells.size();
+}
+
+void OccMapTree::getTileLeaves(unsigned int depth, OccMapTileLeaves& tiles) const
+{
+  if (root)
+    collectTileLeaves(root, octomap::OcTreeKey(tree_max_val, tree_max_val, tree_max_val), 0,
+                      std::min(depth, getTreeDepth()), tiles);
+}
+
+void OccMapTree::collectTileLeaves(const OccMapNode* node, const octomap::OcTreeKey& key, unsigned int depth,
+                                   unsigned int tile_depth, OccMapTileLeaves& tiles) const
+{
+  if (depth == tile_depth)
+  {
+    collectLeaves(node, key, depth, tiles[key]);
+    return;
+  }
+
+  // a leaf above the tile depth is descended into as if it had eight children identical to itself
+  const bool leaf = !nodeHasChildren(node);
+  const octomap::key_type center_offset = tree_max_val >> (depth + 1);
+  octomap::OcTreeKey child_key;
+  for (unsigned int i = 0; i < 8; ++i)
+    if (leaf || nodeChildExists(node, i))
+    {
+      octomap::computeChildKey(i, center_offset, key, child_key);
+      collectTileLeaves(leaf ? node : getNodeChild(node, i), child_key, depth + 1, tile_depth, tiles);
+    }
+}
+
+void OccMapTree::collectLeaves(const OccMapNode* node, const octomap::OcTreeKey& key, unsigned int depth,
+                               std::vector<OccMapLeaf>& leaves) const
+{
+  if (!nodeHasChildren(node))
+  {
+    OccMapLeaf leaf;
+    leaf.key[0] = key[0];
+    leaf.key[1] = key[1];
+    leaf.key[2] = key[2];
+    leaf.depth = depth;
+    leaf.reserved = 0;
+    leaf.log_odds = node->getLogOdds();
+    leaves.push_back(leaf);
+    return;
+  }
+
+  const octomap::key_type center_offset = tree_max_val >> (depth + 1);
+  octomap::OcTreeKey child_key;
+  for (unsigned int i = 0; i < 8; ++i)
+    if (nodeChildExists(node, i))
+    {
+      octomap::computeChildKey(i, center_offset, key, child_key);
+      collectLeaves(getNodeChild(node, i), child_key, depth + 1, leaves);
+    }
+}
+
+void OccMapTree::setLeaves(const OccMapLeaf* leaves, std::size_t count)
+{
+  const unsigned int tree_depth = getTreeDepth();
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    const OccMapLeaf& leaf = leaves[i];
+    const octomap::OcTreeKey key(leaf.key[0], leaf.key[1], leaf.key[2]);
+    const unsigned int depth = std::min<unsigned int>(leaf.depth, tree_depth);
+
+    /* octomap's own setters only reach the finest depth, so the path to the leaf is built directly */
+    if (!root)
+    {
+      root = new OccMapNode();
+      ++tree_size;
+    }
+    OccMapNode* node = root;
+    for (unsigned int d = 0; d < depth; ++d)
+    {
+      const unsigned int pos = octomap::computeChildIdx(key, tree_depth - 1 - d);
+      if (!nodeChildExists(node, pos))
+      {
+        if (!nodeHasChildren(node) && node != root)
+          expandNode(node);  // a pruned leaf covers the cell
+        else
+          createNodeChild(node, pos);
+      }
+      node = getNodeChild(node, pos);
+    }
+
+    if (nodeHasChildren(node))
+      for (unsigned int j = 0; j < 8; ++j)
+        if (nodeChildExists(node, j))
+          deleteNodeChild(node, j);
+    node->setLogOdds(leaf.log_odds);
+  }
+}
+}
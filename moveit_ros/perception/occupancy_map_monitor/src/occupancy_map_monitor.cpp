@@ -40,6 +40,7 @@
 #include <moveit/occupancy_map_monitor/occupancy_map.h>
 #include <moveit/occupancy_map_monitor/occupancy_map_monitor.h>
 #include <XmlRpcException.h>
+#include <cmath>
 
 namespace occupancy_map_monitor
 {
@@ -85,6 +86,16 @@ void OccupancyMapMonitor::initialize()
   tree_.reset(new OccMapTree(map_resolution_));
   tree_const_ = tree_;
 
+  double update_rate = 0.0;
+  if (nh_.getParam("octomap_update_rate", update_rate) && update_rate > 0.0)
+  {
+    update_merger_.reset(new OccupancyMapUpdateMerger(tree_, update_rate));
+    ROS_DEBUG("Merging the updates of all sensors into the octomap at %lf Hz", update_rate);
+  }
+
+  initializeRegionOfInterest();
+  initializeTileStore();
+
   XmlRpc::XmlRpcValue sensor_list;
   if (nh_.getParam("sensors", sensor_list))
   {
@@ -169,6 +180,178 @@ void OccupancyMapMonitor::initialize()
   load_map_srv_ = nh_.advertiseService("load_map", &OccupancyMapMonitor::loadMapCallback, this);
 }
 
+namespace
+{
+bool readBoxSize(const ros::NodeHandle& nh, const std::string& param_name, octomap::point3d& size)
+{
+  std::vector<double> values;
+  if (!nh.getParam(param_name, values))
+    return false;
+  if (values.size() != 3 || values[0] <= 0.0 || values[1] <= 0.0 || values[2] <= 0.0)
+  {
+    ROS_ERROR("Parameter '%s' must list three positive box dimensions; ignoring it", param_name.c_str());
+    return false;
+  }
+  size = octomap::point3d(values[0], values[1], values[2]);
+  return true;
+}
+}
+
+void OccupancyMapMonitor::initializeRegionOfInterest()
+{
+  // filling a coarse cell creates 8^levels leaves before they are pruned, so the coarse resolution is limited
+  static const int MAX_COARSE_LEVELS = 3;
+
+  coarse_depth_ = tree_->getTreeDepth();
+  bool crop = readBoxSize(nh_, "octomap_roi_size", roi_size_);
+  if (!crop)
+    roi_size_ = octomap::point3d(0.0, 0.0, 0.0);
+
+  double coarse_resolution = 0.0;
+  if (nh_.getParam("octomap_coarse_resolution", coarse_resolution) && readBoxSize(nh_, "octomap_fine_size", fine_size_))
+  {
+    int levels = (int)std::floor(std::log(coarse_resolution / map_resolution_) / std::log(2.0) + 0.5);
+    if (levels > MAX_COARSE_LEVELS)
+    {
+      ROS_WARN("Coarse octomap resolution %lf is more than %d times the resolution %lf; using %lf instead",
+               coarse_resolution, 1 << MAX_COARSE_LEVELS, map_resolution_, map_resolution_ * (1 << MAX_COARSE_LEVELS));
+      levels = MAX_COARSE_LEVELS;
+    }
+    if (levels > 0)
+    {
+      coarse_depth_ -= levels;
+      crop = true;
+      ROS_DEBUG("Keeping the octomap at resolution %lf outside a box of size %lf x %lf x %lf",
+                map_resolution_ * (1 << levels), fine_size_.x(), fine_size_.y(), fine_size_.z());
+    }
+    else
+      ROS_WARN("Coarse octomap resolution %lf is not coarser than the resolution %lf; ignoring it", coarse_resolution,
+               map_resolution_);
+  }
+  if (!crop)
+    return;
+
+  nh_.getParam("octomap_roi_frame", roi_frame_);
+  if (!roi_frame_.empty() && !tf_)
+  {
+    ROS_WARN("Octomap region of interest frame '%s' specified but no TF instance specified. The region of interest "
+             "stays centered at the origin of the map frame.",
+             roi_frame_.c_str());
+    roi_frame_.clear();
+  }
+
+  double roi_update_rate = 1.0;
+  nh_.getParam("octomap_roi_update_rate", roi_update_rate);
+  if (roi_update_rate <= 0.0)
+    roi_update_rate = 1.0;
+  crop_timer_ = nh_.createWallTimer(ros::WallDuration(1.0 / roi_update_rate), &OccupancyMapMonitor::cropMapCallback,
+                                    this, false, false);
+}
+
+void OccupancyMapMonitor::cropMapCallback(const ros::WallTimerEvent& event)
+{
+  octomap::point3d center(0.0, 0.0, 0.0);
+  if (!roi_frame_.empty())
+  {
+    std::string map_frame;
+    {
+      boost::mutex::scoped_lock _(parameters_lock_);
+      map_frame = map_frame_;
+    }
+    tf::StampedTransform transform;
+    try
+    {
+      tf_->lookupTransform(map_frame, roi_frame_, ros::Time(0), transform);
+    }
+    catch (tf::TransformException& ex)
+    {
+      ROS_WARN_THROTTLE(5.0, "Unable to locate the octomap region of interest: %s", ex.what());
+      return;
+    }
+    center = octomap::point3d(transform.getOrigin().x(), transform.getOrigin().y(), transform.getOrigin().z());
+  }
+
+  ros::WallTime start = ros::WallTime::now();
+  if (tile_store_)
+  {
+    const octomap::point3d min = center - roi_size_ * 0.5;
+    const octomap::point3d max = center + roi_size_ * 0.5;
+    const std::size_t removed = tile_store_->unloadTiles(min, max);
+    const std::size_t loaded = tile_store_->loadTiles(min, max);
+    if (removed > 0 || loaded > 0)
+    {
+      ROS_DEBUG("Removed %lu octree leaves outside the region of interest and read %lu tiles in %lf ms",
+                (long unsigned int)removed, (long unsigned int)loaded, (ros::WallTime::now() - start).toSec() * 1000.0);
+      tree_->triggerUpdateCallback();
+    }
+    return;
+  }
+
+  std::size_t removed = 0, coarsened = 0;
+  tree_->lockWrite();
+  try
+  {
+    if (roi_size_.x() > 0.0)
+      removed = tree_->cropToBox(center - roi_size_ * 0.5, center + roi_size_ * 0.5);
+    if (coarse_depth_ < tree_->getTreeDepth())
+      coarsened = tree_->coarsenOutsideBox(center - fine_size_ * 0.5, center + fine_size_ * 0.5, coarse_depth_);
+  }
+  catch (...)
+  {
+    ROS_ERROR("Internal error while cropping octree");
+  }
+  tree_->unlockWrite();
+
+  if (removed > 0 || coarsened > 0)
+  {
+    ROS_DEBUG("Removed %lu octree leaves outside the region of interest and coarsened %lu cells in %lf ms",
+              (long unsigned int)removed, (long unsigned int)coarsened,
+              (ros::WallTime::now() - start).toSec() * 1000.0);
+    tree_->triggerUpdateCallback();
+  }
+}
+
+void OccupancyMapMonitor::initializeTileStore()
+{
+  std::string directory;
+  if (!nh_.getParam("octomap_tile_directory", directory) || directory.empty())
+    return;
+  double tile_size = map_resolution_ * 256.0;
+  nh_.getParam("octomap_tile_size", tile_size);
+  tile_store_.reset(new OccupancyMapTileStore(tree_, directory, tile_size));
+  ROS_INFO("Persisting the octomap in tiles of size %lf in '%s'", tile_store_->getTileSize(), directory.c_str());
+
+  // coarsened cells would be written back at the coarse resolution
+  if (coarse_depth_ < tree_->getTreeDepth())
+  {
+    ROS_WARN("The octomap cannot be coarsened when it is persisted in tiles; keeping it at full resolution");
+    coarse_depth_ = tree_->getTreeDepth();
+  }
+
+  /* without a region of interest all tiles are kept in memory; otherwise the crop timer reads them as needed */
+  if (roi_size_.x() <= 0.0)
+  {
+    crop_timer_ = ros::WallTimer();
+    std::size_t loaded = tile_store_->loadAllTiles();
+    ROS_DEBUG("Read %lu octomap tiles", (long unsigned int)loaded);
+  }
+
+  double save_period = 10.0;
+  nh_.getParam("octomap_tile_save_period", save_period);
+  if (save_period > 0.0)
+    tile_save_timer_ = nh_.createWallTimer(ros::WallDuration(save_period), &OccupancyMapMonitor::saveTilesCallback,
+                                           this, false, false);
+}
+
+void OccupancyMapMonitor::saveTilesCallback(const ros::WallTimerEvent& event)
+{
+  ros::WallTime start = ros::WallTime::now();
+  std::size_t written = tile_store_->saveTiles();
+  if (written > 0)
+    ROS_DEBUG("Wrote %lu changed octomap tiles in %lf ms", (long unsigned int)written,
+              (ros::WallTime::now() - start).toSec() * 1000.0);
+}
+
 void OccupancyMapMonitor::addUpdater(const OccupancyMapUpdaterPtr& updater)
 {
   if (updater)
@@ -320,12 +503,22 @@ bool OccupancyMapMonitor::loadMapCallback(moveit_msgs::LoadMap::Request& request
   }
   tree_->unlockWrite();
 
+  // the loaded map replaced the tiles that were in memory
+  if (tile_store_)
+    tile_store_->resetLoadedTiles();
+
   return true;
 }
 
 void OccupancyMapMonitor::startMonitor()
 {
   active_ = true;
+  if (update_merger_)
+    update_merger_->start();
+  if (crop_timer_)
+    crop_timer_.start();
+  if (tile_save_timer_)
+    tile_save_timer_.start();
   /* initialize all of the occupancy map updaters */
   for (std::size_t i = 0; i < map_updaters_.size(); ++i)
     map_updaters_[i]->start();
@@ -334,8 +527,16 @@ void OccupancyMapMonitor::startMonitor()
 void OccupancyMapMonitor::stopMonitor()
 {
   active_ = false;
+  if (crop_timer_)
+    crop_timer_.stop();
+  if (tile_save_timer_)
+    tile_save_timer_.stop();
   for (std::size_t i = 0; i < map_updaters_.size(); ++i)
     map_updaters_[i]->stop();
+  if (update_merger_)
+    update_merger_->stop();
+  if (tile_store_)
+    tile_store_->saveTiles();
 }
 
 OccupancyMapMonitor::~OccupancyMapMonitor()
@@ -0,0 +1,102 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/occupancy_map_monitor/occupancy_map_monitor.h>
+#include <octomap_msgs/conversions.h>
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+#include <tf/transform_listener.h>
+#include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
+#include <memory>
+
+namespace occupancy_map_monitor
+{
+/** \brief The occupancy map server as a nodelet. Loaded into the same nodelet manager as the camera drivers, the
+    updaters receive the point clouds as shared pointers, without serializing, sending and deserializing them. The
+    parameters are read from the private namespace of the nodelet, as the occupancy map server reads them from its
+    private namespace. */
+class OccupancyMapServerNodelet : public nodelet::Nodelet
+{
+public:
+  virtual ~OccupancyMapServerNodelet()
+  {
+    // stop the updaters before the publisher goes away
+    monitor_.reset();
+  }
+
+private:
+  virtual void onInit()
+  {
+    ros::NodeHandle& nh = getNodeHandle();
+    ros::NodeHandle& private_nh = getPrivateNodeHandle();
+    octree_binary_pub_ = nh.advertise<octomap_msgs::Octomap>("octomap_binary", 1);
+    tf_ = boost::make_shared<tf::TransformListener>(nh, ros::Duration(5.0));
+    monitor_.reset(new OccupancyMapMonitor(tf_, private_nh));
+    monitor_->setUpdateCallback(boost::bind(&OccupancyMapServerNodelet::publishOctomap, this));
+    monitor_->startMonitor();
+  }
+
+  void publishOctomap()
+  {
+    if (octree_binary_pub_.getNumSubscribers() == 0)
+      return;
+
+    // published as shared pointer, so subscribers in this process get it without a copy
+    boost::shared_ptr<octomap_msgs::Octomap> map(new octomap_msgs::Octomap());
+    map->header.frame_id = monitor_->getMapFrame();
+    map->header.stamp = ros::Time::now();
+
+    monitor_->getOcTreePtr()->lockRead();
+    try
+    {
+      if (!octomap_msgs::binaryMapToMsgData(*monitor_->getOcTreePtr(), map->data))
+        NODELET_ERROR_THROTTLE(1, "Could not generate OctoMap message");
+    }
+    catch (...)
+    {
+      NODELET_ERROR_THROTTLE(1, "Exception thrown while generating OctoMap message");
+    }
+    monitor_->getOcTreePtr()->unlockRead();
+
+    octree_binary_pub_.publish(map);
+  }
+
+  ros::Publisher octree_binary_pub_;
+  boost::shared_ptr<tf::Transformer> tf_;
+  std::unique_ptr<OccupancyMapMonitor> monitor_;
+};
+}
+
+PLUGINLIB_EXPORT_CLASS(occupancy_map_monitor::OccupancyMapServerNodelet, nodelet::Nodelet);
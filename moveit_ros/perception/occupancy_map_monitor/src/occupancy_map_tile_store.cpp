@@ -0,0 +1,361 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/occupancy_map_monitor/occupancy_map_tile_store.h>
+#include <ros/console.h>
+#include <boost/filesystem.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+
+namespace occupancy_map_monitor
+{
+namespace
+{
+/* a tile file is a header followed by the leaves of the tile, both in the byte order of the machine that wrote it */
+const char TILE_MAGIC[4] = { 'O', 'M', 'T', 'L' };
+const uint32_t TILE_VERSION = 1;
+
+struct TileHeader
+{
+  char magic[4];
+  uint32_t version;
+  double resolution;
+  uint32_t tile_depth;
+  uint32_t leaf_count;
+};
+
+static_assert(sizeof(TileHeader) == 24 && sizeof(OccMapLeaf) == 12, "octomap tile records must not be padded");
+
+std::size_t hashLeaves(const std::vector<OccMapLeaf>& leaves)
+{
+  std::size_t seed = leaves.size();
+  for (std::size_t i = 0; i < leaves.size(); ++i)
+  {
+    boost::hash_combine(seed, leaves[i].key[0]);
+    boost::hash_combine(seed, leaves[i].key[1]);
+    boost::hash_combine(seed, leaves[i].key[2]);
+    boost::hash_combine(seed, leaves[i].depth);
+    boost::hash_combine(seed, leaves[i].log_odds);
+  }
+  return seed;
+}
+
+bool keyInRange(const octomap::OcTreeKey& key, const octomap::OcTreeKey& min_key, const octomap::OcTreeKey& max_key)
+{
+  return key[0] >= min_key[0] && key[0] <= max_key[0] && key[1] >= min_key[1] && key[1] <= max_key[1] &&
+         key[2] >= min_key[2] && key[2] <= max_key[2];
+}
+}
+
+OccupancyMapTileStore::OccupancyMapTileStore(const OccMapTreePtr& tree, const std::string& directory,
+                                             double tile_size)
+  : tree_(tree), directory_(directory)
+{
+  const int tree_depth = tree_->getTreeDepth();
+  int levels = 1;
+  if (tile_size > 0.0)
+    levels = (int)std::floor(std::log(tile_size / tree_->getResolution()) / std::log(2.0) + 0.5);
+  levels = std::max(1, std::min(levels, tree_depth - 1));
+  tile_depth_ = tree_depth - levels;
+  scanDirectory();
+}
+
+void OccupancyMapTileStore::scanDirectory()
+{
+  boost::system::error_code ec;
+  boost::filesystem::create_directories(directory_, ec);
+  if (ec)
+  {
+    ROS_ERROR("Unable to create the octomap tile directory '%s': %s", directory_.c_str(), ec.message().c_str());
+    return;
+  }
+
+  /* tiles are named after their index along each axis, counted from the tile at the origin */
+  const unsigned int levels = tree_->getTreeDepth() - tile_depth_;
+  const int tiles_per_half_axis = (1 << (tree_->getTreeDepth() - 1)) >> levels;
+  unsigned int ignored = 0;
+  for (boost::filesystem::directory_iterator it(directory_, ec), end; !ec && it != end; it.increment(ec))
+  {
+    const std::string name = it->path().filename().string();
+    unsigned int depth;
+    int index[3];
+    int length = 0;
+    if (std::sscanf(name.c_str(), "%u_%d_%d_%d.tile%n", &depth, &index[0], &index[1], &index[2], &length) != 4 ||
+        length != (int)name.size())
+      continue;
+    if (depth != tile_depth_)
+    {
+      ++ignored;
+      continue;
+    }
+
+    octomap::OcTreeKey key;
+    bool valid = true;
+    for (int i = 0; i < 3; ++i)
+    {
+      valid = valid && index[i] >= -tiles_per_half_axis && index[i] < tiles_per_half_axis;
+      key[i] = ((index[i] + tiles_per_half_axis) << levels) + (1 << (levels - 1));
+    }
+    if (valid)
+      stored_tiles_.insert(key);
+  }
+  if (ec)
+    ROS_ERROR("Unable to list the octomap tile directory '%s': %s", directory_.c_str(), ec.message().c_str());
+  if (ignored > 0)
+    ROS_WARN("Ignoring %u octomap tiles in '%s' written with a different tile size", ignored, directory_.c_str());
+  ROS_DEBUG("Found %lu octomap tiles in '%s'", (long unsigned int)stored_tiles_.size(), directory_.c_str());
+}
+
+octomap::OcTreeKey OccupancyMapTileStore::getTileKey(const octomap::point3d& point) const
+{
+  const double limit = (tree_->getNodeSize(0) - tree_->getResolution()) * 0.5;
+  const octomap::point3d clamped(std::max(-limit, std::min<double>(point.x(), limit)),
+                                 std::max(-limit, std::min<double>(point.y(), limit)),
+                                 std::max(-limit, std::min<double>(point.z(), limit)));
+  return tree_->adjustKeyAtDepth(tree_->coordToKey(clamped), tile_depth_);
+}
+
+std::string OccupancyMapTileStore::getTilePath(const octomap::OcTreeKey& tile_key) const
+{
+  const unsigned int levels = tree_->getTreeDepth() - tile_depth_;
+  const int tiles_per_half_axis = (1 << (tree_->getTreeDepth() - 1)) >> levels;
+  char name[64];
+  std::snprintf(name, sizeof(name), "%u_%d_%d_%d.tile", tile_depth_, (int)(tile_key[0] >> levels) - tiles_per_half_axis,
+                (int)(tile_key[1] >> levels) - tiles_per_half_axis, (int)(tile_key[2] >> levels) - tiles_per_half_axis);
+  return (boost::filesystem::path(directory_) / name).string();
+}
+
+bool OccupancyMapTileStore::readTile(const octomap::OcTreeKey& tile_key, std::vector<OccMapLeaf>& leaves) const
+{
+  const std::string path = getTilePath(tile_key);
+  try
+  {
+    boost::iostreams::mapped_file_source file(path);
+    TileHeader header;
+    if (file.size() < sizeof(header))
+    {
+      ROS_ERROR("Octomap tile '%s' is truncated", path.c_str());
+      return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, TILE_MAGIC, sizeof(TILE_MAGIC)) != 0 || header.version != TILE_VERSION)
+    {
+      ROS_ERROR("'%s' is not an octomap tile", path.c_str());
+      return false;
+    }
+    if (header.tile_depth != tile_depth_ || std::abs(header.resolution - tree_->getResolution()) > 1e-9)
+    {
+      ROS_ERROR("Octomap tile '%s' was written for a different resolution or tile size", path.c_str());
+      return false;
+    }
+    if (file.size() != sizeof(header) + header.leaf_count * sizeof(OccMapLeaf))
+    {
+      ROS_ERROR("Octomap tile '%s' is truncated", path.c_str());
+      return false;
+    }
+    leaves.resize(header.leaf_count);
+    if (!leaves.empty())
+      std::memcpy(&leaves[0], file.data() + sizeof(header), leaves.size() * sizeof(OccMapLeaf));
+  }
+  catch (std::exception& ex)
+  {
+    ROS_ERROR("Unable to read octomap tile '%s': %s", path.c_str(), ex.what());
+    return false;
+  }
+
+  // a damaged tile must not write outside its own cell of the tree
+  for (std::size_t i = 0; i < leaves.size(); ++i)
+    if (leaves[i].depth < tile_depth_ || leaves[i].depth > tree_->getTreeDepth() ||
+        tree_->adjustKeyAtDepth(octomap::OcTreeKey(leaves[i].key[0], leaves[i].key[1], leaves[i].key[2]),
+                                tile_depth_) != tile_key)
+    {
+      ROS_ERROR("Octomap tile '%s' holds leaves outside the tile", path.c_str());
+      return false;
+    }
+  return true;
+}
+
+bool OccupancyMapTileStore::writeTile(const octomap::OcTreeKey& tile_key, const std::vector<OccMapLeaf>& leaves) const
+{
+  const std::string path = getTilePath(tile_key);
+  const std::string temp_path = path + ".tmp";
+
+  TileHeader header;
+  std::memcpy(header.magic, TILE_MAGIC, sizeof(TILE_MAGIC));
+  header.version = TILE_VERSION;
+  header.resolution = tree_->getResolution();
+  header.tile_depth = tile_depth_;
+  header.leaf_count = leaves.size();
+
+  std::ofstream out(temp_path.c_str(), std::ios::binary | std::ios::trunc);
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  if (!leaves.empty())
+    out.write(reinterpret_cast<const char*>(&leaves[0]), leaves.size() * sizeof(OccMapLeaf));
+  out.close();
+  if (!out)
+  {
+    ROS_ERROR("Unable to write octomap tile '%s'", temp_path.c_str());
+    return false;
+  }
+
+  // the tile is replaced in one step, so an interrupted write never leaves a damaged tile behind
+  boost::system::error_code ec;
+  boost::filesystem::rename(temp_path, path, ec);
+  if (ec)
+  {
+    ROS_ERROR("Unable to write octomap tile '%s': %s", path.c_str(), ec.message().c_str());
+    return false;
+  }
+  return true;
+}
+
+bool OccupancyMapTileStore::saveTile(const octomap::OcTreeKey& tile_key, const std::vector<OccMapLeaf>& leaves)
+{
+  TileHashes::iterator loaded = loaded_tiles_.find(tile_key);
+  if (loaded == loaded_tiles_.end() && stored_tiles_.find(tile_key) != stored_tiles_.end())
+    return false;
+
+  const std::size_t hash = hashLeaves(leaves);
+  if (loaded != loaded_tiles_.end() && loaded->second == hash)
+    return false;
+  if (!writeTile(tile_key, leaves))
+    return false;
+
+  stored_tiles_.insert(tile_key);
+  loaded_tiles_[tile_key] = hash;
+  return true;
+}
+
+std::size_t OccupancyMapTileStore::loadTiles(const octomap::point3d& min, const octomap::point3d& max)
+{
+  boost::mutex::scoped_lock _(store_lock_);
+  const octomap::OcTreeKey min_key = getTileKey(min);
+  const octomap::OcTreeKey max_key = getTileKey(max);
+
+  /* the files are read before the tree is locked, so the updaters are only held up while the leaves are inserted */
+  OccMapTileLeaves tiles;
+  std::vector<octomap::OcTreeKey> damaged;
+  for (octomap::KeySet::const_iterator it = stored_tiles_.begin(), end = stored_tiles_.end(); it != end; ++it)
+    if (keyInRange(*it, min_key, max_key) && loaded_tiles_.find(*it) == loaded_tiles_.end())
+      if (!readTile(*it, tiles[*it]))
+      {
+        tiles.erase(*it);
+        damaged.push_back(*it);
+      }
+
+  // a tile that cannot be read is replaced by what is observed from now on
+  for (std::size_t i = 0; i < damaged.size(); ++i)
+    stored_tiles_.erase(damaged[i]);
+  if (tiles.empty())
+    return 0;
+
+  {
+    OccMapTree::WriteLock tree_lock = tree_->writing();
+    for (OccMapTileLeaves::const_iterator it = tiles.begin(), end = tiles.end(); it != end; ++it)
+      if (!it->second.empty())
+        tree_->setLeaves(&it->second[0], it->second.size());
+    tree_->updateInnerOccupancy();
+  }
+
+  for (OccMapTileLeaves::const_iterator it = tiles.begin(), end = tiles.end(); it != end; ++it)
+    loaded_tiles_[it->first] = hashLeaves(it->second);
+  return tiles.size();
+}
+
+std::size_t OccupancyMapTileStore::loadAllTiles()
+{
+  const float limit = std::numeric_limits<float>::max();
+  return loadTiles(octomap::point3d(-limit, -limit, -limit), octomap::point3d(limit, limit, limit));
+}
+
+std::size_t OccupancyMapTileStore::unloadTiles(const octomap::point3d& min, const octomap::point3d& max)
+{
+  boost::mutex::scoped_lock _(store_lock_);
+  const octomap::OcTreeKey min_key = getTileKey(min);
+  const octomap::OcTreeKey max_key = getTileKey(max);
+
+  /* changes made to the tiles that leave the box between taking this copy and cropping the tree are lost, as they
+     would be when cropping without a tile store */
+  OccMapTileLeaves tiles;
+  {
+    OccMapTree::ReadLock tree_lock = tree_->reading();
+    tree_->getTileLeaves(tile_depth_, tiles);
+  }
+  for (OccMapTileLeaves::const_iterator it = tiles.begin(), end = tiles.end(); it != end; ++it)
+    if (!keyInRange(it->first, min_key, max_key))
+      saveTile(it->first, it->second);
+
+  for (TileHashes::iterator it = loaded_tiles_.begin(); it != loaded_tiles_.end();)
+    if (keyInRange(it->first, min_key, max_key))
+      ++it;
+    else
+      it = loaded_tiles_.erase(it);
+
+  /* everything outside the tiles that intersect the box goes; the cropping box is slightly smaller than these tiles
+     so that the leaves just outside them do not count as touching it */
+  const double half_tile = getTileSize() * 0.5 - tree_->getResolution() * 0.25;
+  const octomap::point3d offset(half_tile, half_tile, half_tile);
+  OccMapTree::WriteLock tree_lock = tree_->writing();
+  return tree_->cropToBox(tree_->keyToCoord(min_key, tile_depth_) - offset,
+                          tree_->keyToCoord(max_key, tile_depth_) + offset);
+}
+
+std::size_t OccupancyMapTileStore::saveTiles()
+{
+  boost::mutex::scoped_lock _(store_lock_);
+  OccMapTileLeaves tiles;
+  {
+    OccMapTree::ReadLock tree_lock = tree_->reading();
+    tree_->getTileLeaves(tile_depth_, tiles);
+  }
+
+  std::size_t written = 0;
+  for (OccMapTileLeaves::const_iterator it = tiles.begin(), end = tiles.end(); it != end; ++it)
+    if (saveTile(it->first, it->second))
+      ++written;
+  return written;
+}
+
+void OccupancyMapTileStore::resetLoadedTiles()
+{
+  boost::mutex::scoped_lock _(store_lock_);
+  loaded_tiles_.clear();
+}
+}
@@ -0,0 +1,155 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/occupancy_map_monitor/occupancy_map_update_merger.h>
+#include <ros/console.h>
+#include <ros/time.h>
+
+namespace occupancy_map_monitor
+{
+OccupancyMapUpdateMerger::OccupancyMapUpdateMerger(const OccMapTreePtr& tree, double update_rate)
+  : tree_(tree), update_rate_(update_rate), running_(false)
+{
+}
+
+OccupancyMapUpdateMerger::~OccupancyMapUpdateMerger()
+{
+  stop();
+}
+
+void OccupancyMapUpdateMerger::start()
+{
+  boost::mutex::scoped_lock _(pending_lock_);
+  if (running_)
+    return;
+  running_ = true;
+  writer_thread_ = boost::thread(boost::bind(&OccupancyMapUpdateMerger::writerThread, this));
+}
+
+void OccupancyMapUpdateMerger::stop()
+{
+  {
+    boost::mutex::scoped_lock _(pending_lock_);
+    if (!running_)
+      return;
+    running_ = false;
+    pending_condition_.notify_all();
+  }
+  writer_thread_.join();
+
+  pending_free_cells_.clear();
+  pending_occupied_cells_.clear();
+  pending_model_cells_.clear();
+}
+
+void OccupancyMapUpdateMerger::pushUpdate(const octomap::KeySet& free_cells, const octomap::KeySet& occupied_cells,
+                                          const octomap::KeySet& model_cells)
+{
+  boost::mutex::scoped_lock _(pending_lock_);
+  for (octomap::KeySet::const_iterator it = free_cells.begin(), end = free_cells.end(); it != end; ++it)
+    ++pending_free_cells_[*it];
+  for (octomap::KeySet::const_iterator it = occupied_cells.begin(), end = occupied_cells.end(); it != end; ++it)
+    ++pending_occupied_cells_[*it];
+  pending_model_cells_.insert(model_cells.begin(), model_cells.end());
+  pending_condition_.notify_one();
+}
+
+void OccupancyMapUpdateMerger::writerThread()
+{
+  const boost::posix_time::time_duration period = boost::posix_time::microseconds((int64_t)(1e6 / update_rate_));
+  OcTreeKeyCountMap free_cells, occupied_cells;
+  octomap::KeySet model_cells;
+
+  boost::unique_lock<boost::mutex> lock(pending_lock_);
+  while (running_)
+  {
+    if (pending_free_cells_.empty() && pending_occupied_cells_.empty() && pending_model_cells_.empty())
+    {
+      pending_condition_.wait(lock);
+      continue;
+    }
+
+    // take the whole batch; the sensors keep pushing into the emptied maps while it is applied
+    free_cells.swap(pending_free_cells_);
+    occupied_cells.swap(pending_occupied_cells_);
+    model_cells.swap(pending_model_cells_);
+    lock.unlock();
+
+    const boost::system_time next_batch = boost::get_system_time() + period;
+    applyBatch(free_cells, occupied_cells, model_cells);
+    free_cells.clear();
+    occupied_cells.clear();
+    model_cells.clear();
+
+    // apply batches at a fixed rate; what is pushed meanwhile goes into the next batch
+    lock.lock();
+    while (running_ && boost::get_system_time() < next_batch)
+      pending_condition_.timed_wait(lock, next_batch);
+  }
+}
+
+void OccupancyMapUpdateMerger::applyBatch(const OcTreeKeyCountMap& free_cells,
+                                          const OcTreeKeyCountMap& occupied_cells,
+                                          const octomap::KeySet& model_cells)
+{
+  ros::WallTime start = ros::WallTime::now();
+  const float lg_hit = tree_->getProbHitLog();
+  const float lg_miss = tree_->getProbMissLog();
+  const float lg_0 = tree_->getClampingThresMinLog() - tree_->getClampingThresMaxLog();
+
+  tree_->lockWrite();
+  try
+  {
+    for (OcTreeKeyCountMap::const_iterator it = free_cells.begin(), end = free_cells.end(); it != end; ++it)
+      tree_->updateNode(it->first, it->second * lg_miss);
+
+    for (OcTreeKeyCountMap::const_iterator it = occupied_cells.begin(), end = occupied_cells.end(); it != end; ++it)
+      tree_->updateNode(it->first, it->second * lg_hit);
+
+    // set the logodds to the minimum for the cells that are part of the model
+    for (octomap::KeySet::const_iterator it = model_cells.begin(), end = model_cells.end(); it != end; ++it)
+      tree_->updateNode(*it, lg_0);
+  }
+  catch (...)
+  {
+    ROS_ERROR("Internal error while updating octree");
+  }
+  tree_->unlockWrite();
+  tree_->triggerUpdateCallback();
+
+  ROS_DEBUG("Applied merged update of %lu free, %lu occupied and %lu model cells in %lf ms",
+            (long unsigned int)free_cells.size(), (long unsigned int)occupied_cells.size(),
+            (long unsigned int)model_cells.size(), (ros::WallTime::now() - start).toSec() * 1000.0);
+}
+}
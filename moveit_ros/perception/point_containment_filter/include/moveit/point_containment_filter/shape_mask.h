@@ -126,7 +126,13 @@ private:
   mutable boost::mutex shapes_lock_;
   std::set<SeeShape, SortBodies> bodies_;
   std::map<ShapeHandle, std::set<SeeShape, SortBodies>::iterator> used_handles_;
+
+  /** \brief The bodies posed for the last call to maskContainment(), with their bounding spheres in bspheres_ */
+  std::vector<const bodies::Body*> posed_bodies_;
   std::vector<bodies::BoundingSphere> bspheres_;
+
+  /** \brief The indices of the points maskContainment() tests against the bodies */
+  std::vector<int> candidates_;
 };
 }
 
@@ -38,6 +38,13 @@
 #include <geometric_shapes/body_operations.h>
 #include <ros/console.h>
 #include <sensor_msgs/point_cloud2_iterator.h>
+#include <limits>
+
+namespace
+{
+// the number of candidate points handed to a thread at a time by maskContainment()
+const int CONTAINMENT_CHUNK_SIZE = 1024;
+}
 
 point_containment_filter::ShapeMask::ShapeMask(const TransformCallback& transform_callback)
   : transform_callback_(transform_callback), next_handle_(1), min_handle_(1)
@@ -123,43 +130,69 @@ void point_containment_filter::ShapeMask::maskContainment(const sensor_msgs::Poi
     std::fill(mask.begin(), mask.end(), (int)OUTSIDE);
   else
   {
+    // only bodies with a known transform are tested, in the order of bodies_ (largest first)
     Eigen::Affine3d tmp;
-    bspheres_.resize(bodies_.size());
-    std::size_t j = 0;
+    posed_bodies_.clear();
+    bspheres_.clear();
     for (std::set<SeeShape>::const_iterator it = bodies_.begin(); it != bodies_.end(); ++it)
     {
       if (transform_callback_(it->handle, tmp))
       {
         it->body->setPose(tmp);
-        it->body->computeBoundingSphere(bspheres_[j++]);
+        bspheres_.resize(bspheres_.size() + 1);
+        it->body->computeBoundingSphere(bspheres_.back());
+        posed_bodies_.push_back(it->body);
       }
     }
 
-    // compute a sphere that bounds the entire robot
-    bodies::BoundingSphere bound;
-    bodies::mergeBoundingSpheres(bspheres_, bound);
-    const double radiusSquared = bound.radius * bound.radius;
+    // compute a box that bounds the entire robot
+    Eigen::Vector3d bound_min = Eigen::Vector3d::Constant(std::numeric_limits<double>::infinity());
+    Eigen::Vector3d bound_max = -bound_min;
+    for (std::size_t j = 0; j < bspheres_.size(); ++j)
+    {
+      bound_min = bound_min.cwiseMin(bspheres_[j].center - Eigen::Vector3d::Constant(bspheres_[j].radius));
+      bound_max = bound_max.cwiseMax(bspheres_[j].center + Eigen::Vector3d::Constant(bspheres_[j].radius));
+    }
 
-    // we now decide which points we keep
     sensor_msgs::PointCloud2ConstIterator<float> iter_x(data_in, "x");
     sensor_msgs::PointCloud2ConstIterator<float> iter_y(data_in, "y");
     sensor_msgs::PointCloud2ConstIterator<float> iter_z(data_in, "z");
 
-    // Cloud iterators are not incremented in the for loop, because of the pragma
-    // Comment out below parallelization as it can result in very high CPU consumption
-    //#pragma omp parallel for schedule(dynamic)
+    // first pass: clip by distance and keep the points inside the bound of the robot as candidates. This is a
+    // sequential scan with no inner loop, so it stays cheap even for large clouds
+    candidates_.clear();
     for (int i = 0; i < (int)np; ++i)
     {
-      Eigen::Vector3d pt = Eigen::Vector3d(*(iter_x + i), *(iter_y + i), *(iter_z + i));
-      double d = pt.norm();
-      int out = OUTSIDE;
-      if (d < min_sensor_dist || d > max_sensor_dist)
-        out = CLIP;
-      else if ((bound.center - pt).squaredNorm() < radiusSquared)
-        for (std::set<SeeShape>::const_iterator it = bodies_.begin(); it != bodies_.end() && out == OUTSIDE; ++it)
-          if (it->body->containsPoint(pt))
-            out = INSIDE;
-      mask[i] = out;
+      const double x = *(iter_x + i);
+      const double y = *(iter_y + i);
+      const double z = *(iter_z + i);
+      const double d2 = x * x + y * y + z * z;
+      if (d2 < min_sensor_dist * min_sensor_dist || d2 > max_sensor_dist * max_sensor_dist)
+      {
+        mask[i] = CLIP;
+        continue;
+      }
+      mask[i] = OUTSIDE;
+      if (x >= bound_min.x() && x <= bound_max.x() && y >= bound_min.y() && y <= bound_max.y() &&
+          z >= bound_min.z() && z <= bound_max.z())
+        candidates_.push_back(i);
+    }
+
+    // second pass: test the candidates against the bodies whose bounding spheres contain them. The candidates are
+    // split in large chunks, as scheduling single points costs more than testing them
+    const int candidate_count = candidates_.size();
+#pragma omp parallel for schedule(dynamic, CONTAINMENT_CHUNK_SIZE) if (candidate_count > CONTAINMENT_CHUNK_SIZE)
+    for (int k = 0; k < candidate_count; ++k)
+    {
+      const int i = candidates_[k];
+      const Eigen::Vector3d pt(*(iter_x + i), *(iter_y + i), *(iter_z + i));
+      for (std::size_t j = 0; j < posed_bodies_.size(); ++j)
+        if ((bspheres_[j].center - pt).squaredNorm() <= bspheres_[j].radius * bspheres_[j].radius &&
+            posed_bodies_[j]->containsPoint(pt))
+        {
+          mask[i] = INSIDE;
+          break;
+        }
     }
   }
 }
@@ -70,6 +70,9 @@ protected:
 private:
   bool getShapeTransform(ShapeHandle h, Eigen::Affine3d& transform) const;
   void cloudMsgCallback(const sensor_msgs::PointCloud2::ConstPtr& cloud_msg);
+
+  /* add the keys in \e cells to ray_ends_, skipping those whose downsampling voxel already has an endpoint */
+  void addRayEnds(const octomap::KeySet& cells, unsigned int voxel_factor);
   void stopHelper();
 
   ros::NodeHandle root_nh_;
@@ -82,15 +85,25 @@ private:
   double padding_;
   double max_range_;
   unsigned int point_subsample_;
+
+  /* the size of the voxels ray endpoints are merged in; at most one ray is cast per voxel. values below the octree
+     resolution merge the endpoints that fall in the same leaf only */
+  double downsample_resolution_;
   std::string filtered_cloud_topic_;
   ros::Publisher filtered_cloud_publisher_;
 
   message_filters::Subscriber<sensor_msgs::PointCloud2>* point_cloud_subscriber_;
   tf::MessageFilter<sensor_msgs::PointCloud2>* point_cloud_filter_;
 
-  /* used to store all cells in the map which a given ray passes through during raycasting.
-     we cache this here because it dynamically pre-allocates a lot of memory in its contsructor */
-  octomap::KeyRay key_ray_;
+  /* used to store all cells in the map which a given ray passes through during raycasting, one per thread.
+     we cache these here because they dynamically pre-allocate a lot of memory in their constructor */
+  std::vector<octomap::KeyRay> key_rays_;
+
+  /* the cells the rays cast for a cloud end at, so they can be split between threads */
+  std::vector<octomap::OcTreeKey> ray_ends_;
+
+  /* the downsampling voxels ray_ends_ already has an endpoint in */
+  octomap::KeySet ray_end_voxels_;
 
   std::unique_ptr<point_containment_filter::ShapeMask> shape_mask_;
   std::vector<int> mask_;
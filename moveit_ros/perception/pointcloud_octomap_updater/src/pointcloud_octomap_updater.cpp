@@ -43,8 +43,33 @@
 
 #include <memory>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 namespace occupancy_map_monitor
 {
+namespace
+{
+int getMaxThreadCount()
+{
+#ifdef _OPENMP
+  return omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+int getThreadIndex()
+{
+#ifdef _OPENMP
+  return omp_get_thread_num();
+#else
+  return 0;
+#endif
+}
+}
+
 PointCloudOctomapUpdater::PointCloudOctomapUpdater()
   : OccupancyMapUpdater("PointCloudUpdater")
   , private_nh_("~")
@@ -52,6 +77,7 @@ PointCloudOctomapUpdater::PointCloudOctomapUpdater()
   , padding_(0.0)
   , max_range_(std::numeric_limits<double>::infinity())
   , point_subsample_(1)
+  , downsample_resolution_(0.0)
   , point_cloud_subscriber_(NULL)
   , point_cloud_filter_(NULL)
 {
@@ -74,6 +100,7 @@ bool PointCloudOctomapUpdater::setParams(XmlRpc::XmlRpcValue& params)
     readXmlParam(params, "padding_offset", &padding_);
     readXmlParam(params, "padding_scale", &scale_);
     readXmlParam(params, "point_subsample", &point_subsample_);
+    readXmlParam(params, "downsample_resolution", &downsample_resolution_);
     if (params.hasMember("filtered_cloud_topic"))
       filtered_cloud_topic_ = static_cast<const std::string&>(params["filtered_cloud_topic"]);
   }
@@ -163,6 +190,17 @@ void PointCloudOctomapUpdater::updateMask(const sensor_msgs::PointCloud2& cloud,
 {
 }
 
+void PointCloudOctomapUpdater::addRayEnds(const octomap::KeySet& cells, unsigned int voxel_factor)
+{
+  for (octomap::KeySet::const_iterator it = cells.begin(), end = cells.end(); it != end; ++it)
+  {
+    const octomap::OcTreeKey& key = *it;
+    octomap::OcTreeKey voxel(key[0] / voxel_factor, key[1] / voxel_factor, key[2] / voxel_factor);
+    if (ray_end_voxels_.insert(voxel).second)
+      ray_ends_.push_back(key);
+  }
+}
+
 void PointCloudOctomapUpdater::cloudMsgCallback(const sensor_msgs::PointCloud2::ConstPtr& cloud_msg)
 {
   ROS_DEBUG("Received a new point cloud message");
@@ -238,65 +276,78 @@ void PointCloudOctomapUpdater::cloudMsgCallback(const sensor_msgs::PointCloud2::
 
   try
   {
-    /* do ray tracing to find which cells this point cloud indicates should be free, and which it indicates
-     * should be occupied */
-    for (unsigned int row = 0; row < cloud_msg->height; row += point_subsample_)
+    const int height = cloud_msg->height;
+    const int step = point_subsample_;
+
+    /* classify the ray endpoints; each thread collects the keys of the rows it is given in sets of its own, which
+     * are merged once it is done */
+#pragma omp parallel
     {
-      unsigned int row_c = row * cloud_msg->width;
-      sensor_msgs::PointCloud2ConstIterator<float> pt_iter(*cloud_msg, "x");
-      // set iterator to point at start of the current row
-      pt_iter += row_c;
+      octomap::KeySet thread_occupied_cells, thread_model_cells, thread_clip_cells;
 
-      for (unsigned int col = 0; col < cloud_msg->width; col += point_subsample_, pt_iter += point_subsample_)
+#pragma omp for schedule(dynamic) nowait
+      for (int row = 0; row < height; row += step)
       {
-        // if (mask_[row_c + col] == point_containment_filter::ShapeMask::CLIP)
-        //  continue;
+        unsigned int row_c = row * cloud_msg->width;
+        sensor_msgs::PointCloud2ConstIterator<float> pt_iter(*cloud_msg, "x");
+        // set iterator to point at start of the current row
+        pt_iter += row_c;
 
-        /* check for NaN */
-        if (!std::isnan(pt_iter[0]) && !std::isnan(pt_iter[1]) && !std::isnan(pt_iter[2]))
+        for (unsigned int col = 0; col < cloud_msg->width; col += point_subsample_, pt_iter += point_subsample_)
         {
+          /* check for NaN */
+          if (std::isnan(pt_iter[0]) || std::isnan(pt_iter[1]) || std::isnan(pt_iter[2]))
+            continue;
+
           /* transform to map frame */
           tf::Vector3 point_tf = map_H_sensor * tf::Vector3(pt_iter[0], pt_iter[1], pt_iter[2]);
+          octomap::OcTreeKey key = tree_->coordToKey(point_tf.getX(), point_tf.getY(), point_tf.getZ());
 
           /* occupied cell at ray endpoint if ray is shorter than max range and this point
              isn't on a part of the robot*/
           if (mask_[row_c + col] == point_containment_filter::ShapeMask::INSIDE)
-            model_cells.insert(tree_->coordToKey(point_tf.getX(), point_tf.getY(), point_tf.getZ()));
+            thread_model_cells.insert(key);
           else if (mask_[row_c + col] == point_containment_filter::ShapeMask::CLIP)
-            clip_cells.insert(tree_->coordToKey(point_tf.getX(), point_tf.getY(), point_tf.getZ()));
+            thread_clip_cells.insert(key);
           else
-          {
-            occupied_cells.insert(tree_->coordToKey(point_tf.getX(), point_tf.getY(), point_tf.getZ()));
-            // build list of valid points if we want to publish them
-            if (filtered_cloud)
-            {
-              **iter_filtered_x = pt_iter[0];
-              **iter_filtered_y = pt_iter[1];
-              **iter_filtered_z = pt_iter[2];
-              ++filtered_cloud_size;
-              ++*iter_filtered_x;
-              ++*iter_filtered_y;
-              ++*iter_filtered_z;
-            }
-          }
+            thread_occupied_cells.insert(key);
         }
       }
+
+#pragma omp critical
+      {
+        occupied_cells.insert(thread_occupied_cells.begin(), thread_occupied_cells.end());
+        model_cells.insert(thread_model_cells.begin(), thread_model_cells.end());
+        clip_cells.insert(thread_clip_cells.begin(), thread_clip_cells.end());
+      }
     }
 
-    /* compute the free cells along each ray that ends at an occupied cell */
-    for (octomap::KeySet::iterator it = occupied_cells.begin(), end = occupied_cells.end(); it != end; ++it)
-      if (tree_->computeRayKeys(sensor_origin, tree_->keyToCoord(*it), key_ray_))
-        free_cells.insert(key_ray_.begin(), key_ray_.end());
+    /* compute the free cells along each ray that ends at an occupied, a model or a clipped cell; a single ray is
+     * cast for all the endpoints in the same downsampling voxel */
+    unsigned int voxel_factor = 1;
+    if (downsample_resolution_ > tree_->getResolution())
+      voxel_factor = (unsigned int)(downsample_resolution_ / tree_->getResolution() + 0.5);
+    ray_ends_.clear();
+    ray_end_voxels_.clear();
+    addRayEnds(occupied_cells, voxel_factor);
+    addRayEnds(model_cells, voxel_factor);
+    addRayEnds(clip_cells, voxel_factor);
+    const int ray_count = ray_ends_.size();
+    key_rays_.resize(getMaxThreadCount());
+
+#pragma omp parallel
+    {
+      octomap::KeyRay& key_ray = key_rays_[getThreadIndex()];
+      octomap::KeySet thread_free_cells;
 
-    /* compute the free cells along each ray that ends at a model cell */
-    for (octomap::KeySet::iterator it = model_cells.begin(), end = model_cells.end(); it != end; ++it)
-      if (tree_->computeRayKeys(sensor_origin, tree_->keyToCoord(*it), key_ray_))
-        free_cells.insert(key_ray_.begin(), key_ray_.end());
+#pragma omp for schedule(dynamic, 64) nowait
+      for (int i = 0; i < ray_count; ++i)
+        if (tree_->computeRayKeys(sensor_origin, tree_->keyToCoord(ray_ends_[i]), key_ray))
+          thread_free_cells.insert(key_ray.begin(), key_ray.end());
 
-    /* compute the free cells along each ray that ends at a clipped cell */
-    for (octomap::KeySet::iterator it = clip_cells.begin(), end = clip_cells.end(); it != end; ++it)
-      if (tree_->computeRayKeys(sensor_origin, tree_->keyToCoord(*it), key_ray_))
-        free_cells.insert(key_ray_.begin(), key_ray_.end());
+#pragma omp critical
+      free_cells.insert(thread_free_cells.begin(), thread_free_cells.end());
+    }
   }
   catch (...)
   {
@@ -306,6 +357,29 @@ void PointCloudOctomapUpdater::cloudMsgCallback(const sensor_msgs::PointCloud2::
 
   tree_->unlockRead();
 
+  /* build list of valid points if we want to publish them */
+  if (filtered_cloud)
+    for (unsigned int row = 0; row < cloud_msg->height; row += point_subsample_)
+    {
+      unsigned int row_c = row * cloud_msg->width;
+      sensor_msgs::PointCloud2ConstIterator<float> pt_iter(*cloud_msg, "x");
+      pt_iter += row_c;
+
+      for (unsigned int col = 0; col < cloud_msg->width; col += point_subsample_, pt_iter += point_subsample_)
+        if (!std::isnan(pt_iter[0]) && !std::isnan(pt_iter[1]) && !std::isnan(pt_iter[2]) &&
+            mask_[row_c + col] != point_containment_filter::ShapeMask::INSIDE &&
+            mask_[row_c + col] != point_containment_filter::ShapeMask::CLIP)
+        {
+          **iter_filtered_x = pt_iter[0];
+          **iter_filtered_y = pt_iter[1];
+          **iter_filtered_z = pt_iter[2];
+          ++filtered_cloud_size;
+          ++*iter_filtered_x;
+          ++*iter_filtered_y;
+          ++*iter_filtered_z;
+        }
+    }
+
   /* cells that overlap with the model are not occupied */
   for (octomap::KeySet::iterator it = model_cells.begin(), end = model_cells.end(); it != end; ++it)
     occupied_cells.erase(*it);
@@ -314,30 +388,39 @@ void PointCloudOctomapUpdater::cloudMsgCallback(const sensor_msgs::PointCloud2::
   for (octomap::KeySet::iterator it = occupied_cells.begin(), end = occupied_cells.end(); it != end; ++it)
     free_cells.erase(*it);
 
-  tree_->lockWrite();
-
-  try
+  if (OccupancyMapUpdateMerger* merger = monitor_->getUpdateMerger())
   {
-    /* mark free cells only if not seen occupied in this cloud */
-    for (octomap::KeySet::iterator it = free_cells.begin(), end = free_cells.end(); it != end; ++it)
-      tree_->updateNode(*it, false);
-
-    /* now mark all occupied cells */
-    for (octomap::KeySet::iterator it = occupied_cells.begin(), end = occupied_cells.end(); it != end; ++it)
-      tree_->updateNode(*it, true);
-
-    // set the logodds to the minimum for the cells that are part of the model
-    const float lg = tree_->getClampingThresMinLog() - tree_->getClampingThresMaxLog();
-    for (octomap::KeySet::iterator it = model_cells.begin(), end = model_cells.end(); it != end; ++it)
-      tree_->updateNode(*it, lg);
+    // the cells are written to the octree along with those of the other sensors
+    merger->pushUpdate(free_cells, occupied_cells, model_cells);
+    ROS_DEBUG("Processed point cloud in %lf ms", (ros::WallTime::now() - start).toSec() * 1000.0);
   }
-  catch (...)
+  else
   {
-    ROS_ERROR("Internal error while updating octree");
+    tree_->lockWrite();
+
+    try
+    {
+      /* mark free cells only if not seen occupied in this cloud */
+      for (octomap::KeySet::iterator it = free_cells.begin(), end = free_cells.end(); it != end; ++it)
+        tree_->updateNode(*it, false);
+
+      /* now mark all occupied cells */
+      for (octomap::KeySet::iterator it = occupied_cells.begin(), end = occupied_cells.end(); it != end; ++it)
+        tree_->updateNode(*it, true);
+
+      // set the logodds to the minimum for the cells that are part of the model
+      const float lg = tree_->getClampingThresMinLog() - tree_->getClampingThresMaxLog();
+      for (octomap::KeySet::iterator it = model_cells.begin(), end = model_cells.end(); it != end; ++it)
+        tree_->updateNode(*it, lg);
+    }
+    catch (...)
+    {
+      ROS_ERROR("Internal error while updating octree");
+    }
+    tree_->unlockWrite();
+    ROS_DEBUG("Processed point cloud in %lf ms", (ros::WallTime::now() - start).toSec() * 1000.0);
+    tree_->triggerUpdateCallback();
   }
-  tree_->unlockWrite();
-  ROS_DEBUG("Processed point cloud in %lf ms", (ros::WallTime::now() - start).toSec() * 1000.0);
-  tree_->triggerUpdateCallback();
 
   if (filtered_cloud)
   {
@@ -134,6 +134,30 @@ public:
                             double min_distance_from_edge = 0.0, double min_vertical_offset = 0.0) const;
 
 private:
+  /** @brief A table's convex hull prepared for containment tests, in the table frame */
+  struct TableContour
+  {
+    /** @brief An edge of the hull: for a point (x, y), nx * x + ny * y + offset is its distance to the line through
+        the edge, positive on the inner side */
+    struct Edge
+    {
+      double nx, ny, offset;
+    };
+
+    std::vector<Edge> edges;
+    double min_x, min_y, max_x, max_y;
+  };
+
+  /** @brief Compute the contour of a table; returns false if its hull does not span an area */
+  static bool computeTableContour(const object_recognition_msgs::Table& table, TableContour& contour);
+
+  /** @brief The distance of a point (table frame) to the boundary of a contour, if it is inside; negative otherwise */
+  static double getContourDistance(const TableContour& contour, double x, double y);
+
+  bool isInsideTableContour(const geometry_msgs::Pose& pose, const object_recognition_msgs::Table& table,
+                            const TableContour& contour, double min_distance_from_edge,
+                            double min_vertical_offset) const;
+
   shapes::Mesh* createSolidMeshFromPlanarPolygon(const shapes::Mesh& polygon, double thickness) const;
 
   shapes::Mesh* orientPlanarPolygon(const shapes::Mesh& polygon) const;
@@ -152,6 +176,9 @@ private:
 
   std::map<std::string, object_recognition_msgs::Table> current_tables_in_collision_world_;
 
+  /** @brief The contours of the tables in current_tables_in_collision_world_ */
+  std::map<std::string, TableContour> table_contours_;
+
   //  boost::mutex table_lock_;
 
   ros::Subscriber table_subscriber_;
@@ -43,9 +43,6 @@
 #include <geometric_shapes/shape_operations.h>
 #include <moveit_msgs/PlanningScene.h>
 
-// OpenCV
-#include <opencv2/imgproc/imgproc.hpp>
-
 // Eigen
 #include <eigen_conversions/eigen_msg.h>
 #include <Eigen/Geometry>
@@ -54,6 +51,27 @@ namespace moveit
 {
 namespace semantic_world
 {
+namespace
+{
+bool samePoint(const geometry_msgs::Point& a, const geometry_msgs::Point& b)
+{
+  return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+bool sameTable(const object_recognition_msgs::Table& a, const object_recognition_msgs::Table& b)
+{
+  if (a.header.frame_id != b.header.frame_id || a.convex_hull.size() != b.convex_hull.size() ||
+      !samePoint(a.pose.position, b.pose.position) || a.pose.orientation.x != b.pose.orientation.x ||
+      a.pose.orientation.y != b.pose.orientation.y || a.pose.orientation.z != b.pose.orientation.z ||
+      a.pose.orientation.w != b.pose.orientation.w)
+    return false;
+  for (std::size_t i = 0; i < a.convex_hull.size(); ++i)
+    if (!samePoint(a.convex_hull[i], b.convex_hull[i]))
+      return false;
+  return true;
+}
+}
+
 SemanticWorld::SemanticWorld(const planning_scene::PlanningSceneConstPtr& planning_scene)
   : planning_scene_(planning_scene)
 {
@@ -96,31 +114,45 @@ bool SemanticWorld::addTablesToCollisionWorld()
   moveit_msgs::PlanningScene planning_scene;
   planning_scene.is_diff = true;
 
-  // Remove the existing tables
-  std::map<std::string, object_recognition_msgs::Table>::iterator it;
-  for (it = current_tables_in_collision_world_.begin(); it != current_tables_in_collision_world_.end(); ++it)
+  std::map<std::string, const object_recognition_msgs::Table*> new_tables;
+  for (std::size_t i = 0; i < table_array_.tables.size(); ++i)
+  {
+    std::stringstream ss;
+    ss << "table_" << i;
+    new_tables[ss.str()] = &table_array_.tables[i];
+  }
+
+  // Remove the tables that are gone or changed; the ones that did not change stay in the collision world
+  std::map<std::string, object_recognition_msgs::Table>::iterator it = current_tables_in_collision_world_.begin();
+  while (it != current_tables_in_collision_world_.end())
   {
+    std::map<std::string, const object_recognition_msgs::Table*>::iterator jt = new_tables.find(it->first);
+    if (jt != new_tables.end() && sameTable(it->second, *jt->second))
+    {
+      new_tables.erase(jt);
+      ++it;
+      continue;
+    }
     moveit_msgs::CollisionObject co;
     co.id = it->first;
     co.operation = moveit_msgs::CollisionObject::REMOVE;
     planning_scene.world.collision_objects.push_back(co);
-    //    collision_object_publisher_.publish(co);
+    table_contours_.erase(it->first);
+    current_tables_in_collision_world_.erase(it++);
   }
 
-  planning_scene_diff_publisher_.publish(planning_scene);
-  planning_scene.world.collision_objects.clear();
-  current_tables_in_collision_world_.clear();
-  // Add the new tables
-  for (std::size_t i = 0; i < table_array_.tables.size(); ++i)
+  // Add the new and changed tables
+  for (std::map<std::string, const object_recognition_msgs::Table*>::const_iterator jt = new_tables.begin();
+       jt != new_tables.end(); ++jt)
   {
+    const object_recognition_msgs::Table& table = *jt->second;
     moveit_msgs::CollisionObject co;
-    std::stringstream ss;
-    ss << "table_" << i;
-    co.id = ss.str();
-    current_tables_in_collision_world_[co.id] = table_array_.tables[i];
+    co.id = jt->first;
     co.operation = moveit_msgs::CollisionObject::ADD;
 
-    const std::vector<geometry_msgs::Point>& convex_hull = table_array_.tables[i].convex_hull;
+    const std::vector<geometry_msgs::Point>& convex_hull = table.convex_hull;
+    if (convex_hull.size() < 3)
+      continue;
 
     EigenSTL::vector_Vector3d vertices(convex_hull.size());
     std::vector<unsigned int> triangles((vertices.size() - 2) * 3);
@@ -157,14 +189,20 @@ bool SemanticWorld::addTablesToCollisionWorld()
     const shape_msgs::Mesh& table_shape_msg_mesh = boost::get<shape_msgs::Mesh>(table_shape_msg);
 
     co.meshes.push_back(table_shape_msg_mesh);
-    co.mesh_poses.push_back(table_array_.tables[i].pose);
-    co.header = table_array_.tables[i].header;
+    co.mesh_poses.push_back(table.pose);
+    co.header = table.header;
     planning_scene.world.collision_objects.push_back(co);
-    //    collision_object_publisher_.publish(co);
+    current_tables_in_collision_world_[co.id] = table;
+    TableContour& contour = table_contours_[co.id];
+    if (!computeTableContour(table, contour))
+      table_contours_.erase(co.id);
     delete table_shape;
     delete table_mesh_solid;
   }
-  planning_scene_diff_publisher_.publish(planning_scene);
+
+  // a single diff, so the tables that did not change are not flickering out of the collision world
+  if (!planning_scene.world.collision_objects.empty())
+    planning_scene_diff_publisher_.publish(planning_scene);
   return true;
 }
 
@@ -206,6 +244,7 @@ void SemanticWorld::clear()
 {
   table_array_.tables.clear();
   current_tables_in_collision_world_.clear();
+  table_contours_.clear();
 }
 
 std::vector<geometry_msgs::PoseStamped>
@@ -310,122 +349,114 @@ std::vector<geometry_msgs::PoseStamped> SemanticWorld::generatePlacePoses(const
 {
   std::vector<geometry_msgs::PoseStamped> place_poses;
   // Assumption that the table's normal is along the Z axis
-  if (table.convex_hull.empty())
+  TableContour contour;
+  if (!computeTableContour(table, contour))
     return place_poses;
-  const int scale_factor = 100;
-  std::vector<cv::Point2f> table_contour;
-  float x_min = table.convex_hull[0].x, x_max = x_min, y_min = table.convex_hull[0].y, y_max = y_min;
-  for (std::size_t j = 1; j < table.convex_hull.size(); ++j)
-  {
-    if (table.convex_hull[j].x < x_min)
-      x_min = table.convex_hull[j].x;
-    else if (table.convex_hull[j].x > x_max)
-      x_max = table.convex_hull[j].x;
-    if (table.convex_hull[j].y < y_min)
-      y_min = table.convex_hull[j].y;
-    else if (table.convex_hull[j].y > y_max)
-      y_max = table.convex_hull[j].y;
-  }
-  for (std::size_t j = 0; j < table.convex_hull.size(); ++j)
-    table_contour.push_back(
-        cv::Point((table.convex_hull[j].x - x_min) * scale_factor, (table.convex_hull[j].y - y_min) * scale_factor));
-
-  double x_range = fabs(x_max - x_min);
-  double y_range = fabs(y_max - y_min);
-  int max_range = (int)x_range + 1;
-  if (max_range < (int)y_range + 1)
-    max_range = (int)y_range + 1;
 
-  int image_scale = std::max<int>(max_range, 4);
-  cv::Mat src = cv::Mat::zeros(image_scale * scale_factor, image_scale * scale_factor, CV_8UC1);
-
-  for (std::size_t j = 0; j < table.convex_hull.size(); ++j)
-  {
-    cv::line(src, table_contour[j], table_contour[(j + 1) % table.convex_hull.size()], cv::Scalar(255), 3, 8);
-  }
-
-  unsigned int num_x = fabs(x_max - x_min) / resolution + 1;
-  unsigned int num_y = fabs(y_max - y_min) / resolution + 1;
+  unsigned int num_x = fabs(contour.max_x - contour.min_x) / resolution + 1;
+  unsigned int num_y = fabs(contour.max_y - contour.min_y) / resolution + 1;
 
   ROS_DEBUG("Num points for possible place operations: %d %d", num_x, num_y);
 
-  std::vector<std::vector<cv::Point> > contours;
-  std::vector<cv::Vec4i> hierarchy;
-  cv::findContours(src, contours, hierarchy, cv::RETR_TREE, cv::CHAIN_APPROX_SIMPLE);
+  Eigen::Affine3d pose;
+  tf::poseMsgToEigen(table.pose, pose);
 
   for (std::size_t j = 0; j < num_x; ++j)
   {
-    int point_x = j * resolution * scale_factor;
+    double point_x = contour.min_x + j * resolution;
     for (std::size_t k = 0; k < num_y; ++k)
     {
+      double point_y = contour.min_y + k * resolution;
+      if (getContourDistance(contour, point_x, point_y) < min_distance_from_edge)
+        continue;
       for (std::size_t mm = 0; mm < num_heights; ++mm)
       {
-        int point_y = k * resolution * scale_factor;
-        cv::Point2f point2f(point_x, point_y);
-        double result = cv::pointPolygonTest(contours[0], point2f, true);
-        if ((int)result >= (int)(min_distance_from_edge * scale_factor))
-        {
-          Eigen::Vector3d point((double)(point_x) / scale_factor + x_min, (double)(point_y) / scale_factor + y_min,
-                                height_above_table + mm * delta_height);
-          Eigen::Affine3d pose;
-          tf::poseMsgToEigen(table.pose, pose);
-          point = pose * point;
-          geometry_msgs::PoseStamped place_pose;
-          place_pose.pose.orientation.w = 1.0;
-          place_pose.pose.position.x = point.x();
-          place_pose.pose.position.y = point.y();
-          place_pose.pose.position.z = point.z();
-          place_pose.header = table.header;
-          place_poses.push_back(place_pose);
-        }
+        Eigen::Vector3d point = pose * Eigen::Vector3d(point_x, point_y, height_above_table + mm * delta_height);
+        geometry_msgs::PoseStamped place_pose;
+        place_pose.pose.orientation.w = 1.0;
+        place_pose.pose.position.x = point.x();
+        place_pose.pose.position.y = point.y();
+        place_pose.pose.position.z = point.z();
+        place_pose.header = table.header;
+        place_poses.push_back(place_pose);
       }
     }
   }
   return place_poses;
 }
 
-bool SemanticWorld::isInsideTableContour(const geometry_msgs::Pose& pose, const object_recognition_msgs::Table& table,
-                                         double min_distance_from_edge, double min_vertical_offset) const
+bool SemanticWorld::computeTableContour(const object_recognition_msgs::Table& table, TableContour& contour)
 {
-  // Assumption that the table's normal is along the Z axis
-  if (table.convex_hull.empty())
+  const std::vector<geometry_msgs::Point>& hull = table.convex_hull;
+  contour.edges.clear();
+  if (hull.size() < 3)
     return false;
-  float x_min = table.convex_hull[0].x, x_max = x_min, y_min = table.convex_hull[0].y, y_max = y_min;
-  for (std::size_t j = 1; j < table.convex_hull.size(); ++j)
+
+  contour.min_x = contour.max_x = hull[0].x;
+  contour.min_y = contour.max_y = hull[0].y;
+  double area = 0.0;
+  for (std::size_t j = 0; j < hull.size(); ++j)
+  {
+    const geometry_msgs::Point& a = hull[j];
+    const geometry_msgs::Point& b = hull[(j + 1) % hull.size()];
+    area += a.x * b.y - b.x * a.y;
+    contour.min_x = std::min(contour.min_x, a.x);
+    contour.max_x = std::max(contour.max_x, a.x);
+    contour.min_y = std::min(contour.min_y, a.y);
+    contour.max_y = std::max(contour.max_y, a.y);
+  }
+  if (fabs(area) < std::numeric_limits<double>::epsilon())
+    return false;
+
+  // the inner side of an edge is on its left for a counter-clockwise hull
+  const double orientation = area > 0.0 ? 1.0 : -1.0;
+  for (std::size_t j = 0; j < hull.size(); ++j)
   {
-    if (table.convex_hull[j].x < x_min)
-      x_min = table.convex_hull[j].x;
-    else if (table.convex_hull[j].x > x_max)
-      x_max = table.convex_hull[j].x;
-    if (table.convex_hull[j].y < y_min)
-      y_min = table.convex_hull[j].y;
-    else if (table.convex_hull[j].y > y_max)
-      y_max = table.convex_hull[j].y;
+    const geometry_msgs::Point& a = hull[j];
+    const geometry_msgs::Point& b = hull[(j + 1) % hull.size()];
+    const double dx = b.x - a.x, dy = b.y - a.y;
+    const double length = sqrt(dx * dx + dy * dy);
+    if (length < std::numeric_limits<double>::epsilon())
+      continue;
+    TableContour::Edge edge;
+    edge.nx = -dy * orientation / length;
+    edge.ny = dx * orientation / length;
+    edge.offset = -(edge.nx * a.x + edge.ny * a.y);
+    contour.edges.push_back(edge);
   }
-  const int scale_factor = 100;
-  std::vector<cv::Point2f> table_contour;
-  for (std::size_t j = 0; j < table.convex_hull.size(); ++j)
-    table_contour.push_back(
-        cv::Point((table.convex_hull[j].x - x_min) * scale_factor, (table.convex_hull[j].y - y_min) * scale_factor));
-
-  double x_range = fabs(x_max - x_min);
-  double y_range = fabs(y_max - y_min);
-  int max_range = (int)x_range + 1;
-  if (max_range < (int)y_range + 1)
-    max_range = (int)y_range + 1;
-
-  int image_scale = std::max<int>(max_range, 4);
-  cv::Mat src = cv::Mat::zeros(image_scale * scale_factor, image_scale * scale_factor, CV_8UC1);
-
-  for (std::size_t j = 0; j < table.convex_hull.size(); ++j)
+  return contour.edges.size() >= 3;
+}
+
+double SemanticWorld::getContourDistance(const TableContour& contour, double x, double y)
+{
+  if (x < contour.min_x || x > contour.max_x || y < contour.min_y || y > contour.max_y)
+    return -1.0;
+  // for a point inside a convex polygon, the closest point of the boundary lies on the closest edge line
+  double distance = std::numeric_limits<double>::max();
+  for (std::size_t j = 0; j < contour.edges.size(); ++j)
   {
-    cv::line(src, table_contour[j], table_contour[(j + 1) % table.convex_hull.size()], cv::Scalar(255), 3, 8);
+    const TableContour::Edge& edge = contour.edges[j];
+    distance = std::min(distance, edge.nx * x + edge.ny * y + edge.offset);
+    if (distance < 0.0)
+      break;
   }
+  return distance;
+}
 
-  std::vector<std::vector<cv::Point> > contours;
-  std::vector<cv::Vec4i> hierarchy;
-  cv::findContours(src, contours, hierarchy, cv::RETR_TREE, cv::CHAIN_APPROX_SIMPLE);
+bool SemanticWorld::isInsideTableContour(const geometry_msgs::Pose& pose, const object_recognition_msgs::Table& table,
+                                         double min_distance_from_edge, double min_vertical_offset) const
+{
+  // Assumption that the table's normal is along the Z axis
+  TableContour contour;
+  if (!computeTableContour(table, contour))
+    return false;
+  return isInsideTableContour(pose, table, contour, min_distance_from_edge, min_vertical_offset);
+}
 
+bool SemanticWorld::isInsideTableContour(const geometry_msgs::Pose& pose, const object_recognition_msgs::Table& table,
+                                         const TableContour& contour, double min_distance_from_edge,
+                                         double min_vertical_offset) const
+{
   Eigen::Vector3d point(pose.position.x, pose.position.y, pose.position.z);
   Eigen::Affine3d pose_table;
   tf::poseMsgToEigen(table.pose, pose_table);
@@ -439,16 +470,10 @@ bool SemanticWorld::isInsideTableContour(const geometry_msgs::Pose& pose, const
     return false;
   }
 
-  int point_x = (point.x() - x_min) * scale_factor;
-  int point_y = (point.y() - y_min) * scale_factor;
-  cv::Point2f point2f(point_x, point_y);
-  double result = cv::pointPolygonTest(contours[0], point2f, true);
+  double result = getContourDistance(contour, point.x(), point.y());
   ROS_DEBUG("table distance: %f", result);
 
-  if ((int)result >= (int)(min_distance_from_edge * scale_factor))
-    return true;
-
-  return false;
+  return result >= min_distance_from_edge;
 }
 
 std::string SemanticWorld::findObjectTable(const geometry_msgs::Pose& pose, double min_distance_from_edge,
@@ -458,7 +483,9 @@ std::string SemanticWorld::findObjectTable(const geometry_msgs::Pose& pose, doub
   for (it = current_tables_in_collision_world_.begin(); it != current_tables_in_collision_world_.end(); ++it)
   {
     ROS_DEBUG("Testing table: %s", it->first.c_str());
-    if (isInsideTableContour(pose, it->second, min_distance_from_edge, min_vertical_offset))
+    std::map<std::string, TableContour>::const_iterator jt = table_contours_.find(it->first);
+    if (jt != table_contours_.end() &&
+        isInsideTableContour(pose, it->second, jt->second, min_distance_from_edge, min_vertical_offset))
       return it->first;
   }
   return std::string();
@@ -35,10 +35,12 @@
 /* Author: Ioan Sucan */
 
 #include <moveit/constraint_sampler_manager_loader/constraint_sampler_manager_loader.h>
+#include <moveit/constraint_samplers/projection_constraint_sampler.h>
 #include <pluginlib/class_loader.h>
 #include <ros/ros.h>
 #include <boost/tokenizer.hpp>
 #include <memory>
+#include <set>
 
 namespace constraint_sampler_manager_loader
 {
@@ -47,6 +49,22 @@ class ConstraintSamplerManagerLoader::Helper
 public:
   Helper(const constraint_samplers::ConstraintSamplerManagerPtr& csm) : nh_("~")
   {
+    int cache_size = 0;
+    if (nh_.getParam("constraint_sampler_cache_size", cache_size) && cache_size > 0)
+      csm->setSamplerCacheSize(cache_size);
+
+    // groups for which states are projected onto position and orientation constraints instead of sampled by IK
+    std::string projection_groups;
+    if (nh_.getParam("projection_constraint_sampler_groups", projection_groups) && !projection_groups.empty())
+    {
+      boost::char_separator<char> sep(" ");
+      boost::tokenizer<boost::char_separator<char> > tok(projection_groups, sep);
+      std::set<std::string> groups(tok.begin(), tok.end());
+      csm->registerSamplerAllocator(constraint_samplers::ConstraintSamplerAllocatorPtr(
+          new constraint_samplers::ProjectionConstraintSamplerAllocator(groups)));
+      ROS_INFO("Using projection-based constraint sampling for groups: %s", projection_groups.c_str());
+    }
+
     std::string constraint_samplers;
     if (nh_.getParam("constraint_samplers", constraint_samplers))
     {
@@ -105,6 +105,12 @@ public:
     return ik_attempts_;
   }
 
+  /** \brief Get a map from group name to the number of threads an IK search may use (kinematics_solver_threads) */
+  const std::map<std::string, unsigned int>& getIKThreads() const
+  {
+    return ik_threads_;
+  }
+
   void status() const;
 
 private:
@@ -117,6 +123,7 @@ private:
   std::vector<std::string> groups_;
   std::map<std::string, double> ik_timeout_;
   std::map<std::string, unsigned int> ik_attempts_;
+  std::map<std::string, unsigned int> ik_threads_;
 
   // default configuration
   std::string default_solver_plugin_;
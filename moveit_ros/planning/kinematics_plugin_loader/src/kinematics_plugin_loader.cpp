@@ -56,15 +56,18 @@ public:
    * \param possible_kinematics_solvers
    * \param search_res
    * \param iksolver_to_tip_links - a map between each ik solver and a vector of custom-specified tip link(s)
+   * \param search_threads - a map between each group and the number of threads its IK searches may use
    */
   KinematicsLoaderImpl(const std::string& robot_description,
                        const std::map<std::string, std::vector<std::string> >& possible_kinematics_solvers,
                        const std::map<std::string, std::vector<double> >& search_res,
-                       const std::map<std::string, std::vector<std::string> >& iksolver_to_tip_links)
+                       const std::map<std::string, std::vector<std::string> >& iksolver_to_tip_links,
+                       const std::map<std::string, unsigned int>& search_threads)
     : robot_description_(robot_description)
     , possible_kinematics_solvers_(possible_kinematics_solvers)
     , search_res_(search_res)
     , iksolver_to_tip_links_(iksolver_to_tip_links)
+    , search_threads_(search_threads)
   {
     try
     {
@@ -173,6 +176,9 @@ public:
                 else
                 {
                   result->setDefaultTimeout(jmg->getDefaultIKTimeout());
+                  std::map<std::string, unsigned int>::const_iterator threads = search_threads_.find(jmg->getName());
+                  if (threads != search_threads_.end())
+                    result->setSearchThreadCount(threads->second);
                   ROS_DEBUG("Successfully allocated and initialized a kinematics solver of type '%s' with search "
                             "resolution %lf for group '%s' at address %p",
                             it->second[i].c_str(), search_res, jmg->getName().c_str(), result.get());
@@ -238,6 +244,7 @@ private:
   std::map<std::string, std::vector<double> > search_res_;
   std::map<std::string, std::vector<std::string> > iksolver_to_tip_links_;  // a map between each ik solver and a vector
                                                                             // of custom-specified tip link(s)
+  std::map<std::string, unsigned int> search_threads_;
   std::shared_ptr<pluginlib::ClassLoader<kinematics::KinematicsBase> > kinematics_loader_;
   std::map<const robot_model::JointModelGroup*, std::vector<kinematics::KinematicsBasePtr> > instances_;
   boost::mutex lock_;
@@ -355,6 +362,14 @@ kinematics_plugin_loader::KinematicsPluginLoader::getLoaderFunction(const srdf::
               ik_attempts_[known_groups[i].name_] = ksolver_attempts;
           }
 
+          std::string ksolver_threads_param_name;
+          if (nh.searchParam(base_param_name + "/kinematics_solver_threads", ksolver_threads_param_name))
+          {
+            int ksolver_threads;
+            if (nh.getParam(ksolver_threads_param_name, ksolver_threads) && ksolver_threads >= 0)
+              ik_threads_[known_groups[i].name_] = ksolver_threads;
+          }
+
           std::string ksolver_res_param_name;
           if (nh.searchParam(base_param_name + "/kinematics_solver_search_resolution", ksolver_res_param_name))
           {
@@ -446,7 +461,8 @@ kinematics_plugin_loader::KinematicsPluginLoader::getLoaderFunction(const srdf::
     }
 
     loader_.reset(
-        new KinematicsLoaderImpl(robot_description_, possible_kinematics_solvers, search_res, iksolver_to_tip_links));
+        new KinematicsLoaderImpl(robot_description_, possible_kinematics_solvers, search_res, iksolver_to_tip_links,
+                                 ik_threads_));
   }
 
   return boost::bind(&KinematicsPluginLoader::KinematicsLoaderImpl::allocKinematicsSolverWithCache, loader_.get(), _1);
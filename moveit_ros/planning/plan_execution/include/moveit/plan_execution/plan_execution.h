@@ -43,7 +43,10 @@
 #include <moveit/planning_scene_monitor/planning_scene_monitor.h>
 #include <moveit/planning_scene_monitor/trajectory_monitor.h>
 #include <moveit/sensor_manager/sensor_manager.h>
+#include <moveit/dynamics_solver/dynamics_solver.h>
 #include <pluginlib/class_loader.h>
+#include <boost/thread.hpp>
+#include <memory>
 
 /** \brief This namespace includes functionality specific to the execution and monitoring of motion plans */
 namespace plan_execution
@@ -127,6 +130,36 @@ public:
     return default_max_replan_attempts_;
   }
 
+  /** \brief When replanning is allowed and this is positive, a path that becomes invalid while it is executed is not
+      stopped right away: the robot keeps moving along the part of the path that is still valid, while a new plan is
+      computed in the background from the waypoint the robot is expected to reach \e lookahead seconds later. Once
+      that plan is ready (or that waypoint is reached), the remaining motion to the waypoint is joined with the new
+      plan and executed in place of the current path. This only applies to the last trajectory of a plan; if the
+      robot would reach the invalid part of the path within the lookahead, execution stops as usual. 0 (the default)
+      disables this. */
+  void setReplanLookahead(double lookahead)
+  {
+    replan_lookahead_ = lookahead;
+  }
+
+  double getReplanLookahead() const
+  {
+    return replan_lookahead_;
+  }
+
+  /** \brief When enabled, the torques needed along each trajectory of a plan are computed before it is sent for
+      execution, and a plan that exceeds the effort limits of a joint is not executed. Only trajectories of groups
+      that are kinematic chains can be checked; the others are executed as before. Disabled by default. */
+  void setTorqueLimitCheck(bool flag)
+  {
+    check_torque_limits_ = flag;
+  }
+
+  bool getTorqueLimitCheck() const
+  {
+    return check_torque_limits_;
+  }
+
   void planAndExecute(ExecutableMotionPlan& plan, const Options& opt);
   void planAndExecute(ExecutableMotionPlan& plan, const moveit_msgs::PlanningScene& scene_diff, const Options& opt);
 
@@ -136,9 +169,29 @@ public:
 
 private:
   void planAndExecuteHelper(ExecutableMotionPlan& plan, const Options& opt);
-  moveit_msgs::MoveItErrorCodes executeAndMonitor(const ExecutableMotionPlan& plan);
-  bool isRemainingPathValid(const ExecutableMotionPlan& plan);
-  bool isRemainingPathValid(const ExecutableMotionPlan& plan, const std::pair<int, int>& path_segment);
+  moveit_msgs::MoveItErrorCodes executeAndMonitor(const ExecutableMotionPlan& plan, const Options& opt,
+                                                  ExecutableMotionPlan& next_plan, bool& have_next_plan);
+  bool isRemainingPathValid(const ExecutableMotionPlan& plan, std::size_t* first_invalid = NULL);
+  bool isRemainingPathValid(const ExecutableMotionPlan& plan, const std::pair<int, int>& path_segment,
+                            std::size_t* first_invalid = NULL);
+
+  /* bounds the geometry added to the scene since the remaining path was last checked, so that only the waypoints
+     near it need to be checked again; when \e changes is passed, the other waypoints are not checked */
+  class PathChangeTracker;
+  bool isRemainingPathValid(const ExecutableMotionPlan& plan, const std::pair<int, int>& path_segment,
+                            std::size_t* first_invalid, PathChangeTracker* changes);
+
+  /* start planning in the background from the waypoint of the executed path the robot reaches after the replan
+     lookahead, if that is before the first invalid waypoint of the path */
+  bool startBackgroundPlanning(const ExecutableMotionPlan& plan, const Options& opt,
+                               const std::pair<int, int>& path_segment, std::size_t first_invalid);
+  void computeBackgroundPlan(const Options* opt);
+  /* join the remaining motion to the waypoint the background plan starts from with that plan, in \e next_plan */
+  bool spliceBackgroundPlan(const ExecutableMotionPlan& plan, const std::pair<int, int>& path_segment,
+                            ExecutableMotionPlan& next_plan);
+
+  /* check the torques needed along \e trajectory against the effort limits of its group, if that group is a chain */
+  bool isWithinTorqueLimits(const robot_trajectory::RobotTrajectory& trajectory);
 
   void planningSceneUpdatedCallback(const planning_scene_monitor::PlanningSceneMonitor::SceneUpdateType update_type);
   void doneWithTrajectoryExecution(const moveit_controller_manager::ExecutionStatus& status);
@@ -150,6 +203,20 @@ private:
   planning_scene_monitor::TrajectoryMonitorPtr trajectory_monitor_;
 
   unsigned int default_max_replan_attempts_;
+  double replan_lookahead_;
+
+  bool check_torque_limits_;
+  /// the dynamics solvers used for the torque limit check, by group name; NULL for groups that cannot be checked
+  std::map<std::string, dynamics_solver::DynamicsSolverPtr> dynamics_solvers_;
+
+  // the plan computed in the background while a path that became invalid is still executed
+  std::unique_ptr<boost::thread> background_plan_thread_;
+  std::unique_ptr<ExecutableMotionPlan> background_plan_;
+  boost::mutex background_plan_mutex_;
+  bool background_plan_done_;
+  bool background_plan_solved_;
+  /// the trajectory being executed and its waypoint the background plan starts from
+  std::pair<int, int> background_plan_start_;
 
   bool preempt_requested_;
   bool new_scene_update_;
@@ -38,6 +38,9 @@
 #include <moveit/robot_state/conversions.h>
 #include <moveit/trajectory_processing/trajectory_tools.h>
 #include <moveit/collision_detection/collision_tools.h>
+#include <moveit/trajectory_processing/iterative_time_parameterization.h>
+#include <geometric_shapes/bodies.h>
+#include <octomap/octomap.h>
 #include <boost/algorithm/string/join.hpp>
 
 #include <dynamic_reconfigure/server.h>
@@ -62,11 +65,214 @@ private:
   {
     owner_->setMaxReplanAttempts(config.max_replan_attempts);
     owner_->setTrajectoryStateRecordingFrequency(config.record_trajectory_state_frequency);
+    owner_->setReplanLookahead(config.replan_lookahead);
+    owner_->setTorqueLimitCheck(config.check_torque_limits);
   }
 
   PlanExecution* owner_;
   dynamic_reconfigure::Server<PlanExecutionDynamicReconfigureConfig> dynamic_reconfigure_server_;
 };
+
+class PlanExecution::PathChangeTracker
+{
+public:
+  PathChangeTracker() : scene_(NULL), octree_pose_(Eigen::Affine3d::Identity()), bounded_(false)
+  {
+  }
+
+  ~PathChangeTracker()
+  {
+    for (std::size_t i = 0; i < link_bodies_.size(); ++i)
+      for (std::size_t j = 0; j < link_bodies_[i].size(); ++j)
+        delete link_bodies_[i][j];
+  }
+
+  /* Find the region of \e scene where geometry was added or moved since the previous call, by comparing the world
+     objects and the occupied octree cells within the bounds of \e trajectory. Removed geometry cannot invalidate
+     the path and is ignored. If the changes cannot be bounded, every waypoint needs to be checked. The scene must be
+     locked for reading. */
+  void update(const planning_scene::PlanningScene& scene, const robot_trajectory::RobotTrajectoryPtr& trajectory)
+  {
+    bounded_ = scene_ == &scene && trajectory_ == trajectory && !waypoint_bounds_.empty() &&
+               acm_version_ == scene.getAllowedCollisionMatrixVersion() && !scene.getStateFeasibilityPredicate();
+    region_.setEmpty();
+
+    if (trajectory_ != trajectory)
+    {
+      trajectory_ = trajectory;
+      computeWaypointBounds();
+    }
+
+    if (!bounded_ || world_version_ != scene.getWorldVersion())
+      bounded_ &= updateObjects(*scene.getWorld());
+    if (!bounded_ || octomap_version_ != scene.getOctomapVersion())
+      bounded_ &= updateOctree(*scene.getWorld());
+
+    scene_ = &scene;
+    acm_version_ = scene.getAllowedCollisionMatrixVersion();
+    world_version_ = scene.getWorldVersion();
+    octomap_version_ = scene.getOctomapVersion();
+  }
+
+  /* true if the changes found by update() may invalidate waypoint \e index */
+  bool needsCheck(std::size_t index) const
+  {
+    return !bounded_ || (index < waypoint_bounds_.size() && waypoint_bounds_[index].intersects(region_));
+  }
+
+private:
+  // extend \e box by the bounding spheres of \e body placed at \e pose; false if the body is unbounded
+  static bool extend(Eigen::AlignedBox3d& box, bodies::Body* body, const Eigen::Affine3d& pose)
+  {
+    if (!body)
+      return false;
+    bodies::BoundingSphere sphere;
+    body->setPose(pose);
+    body->computeBoundingSphere(sphere);
+    box.extend(sphere.center - Eigen::Vector3d::Constant(sphere.radius));
+    box.extend(sphere.center + Eigen::Vector3d::Constant(sphere.radius));
+    return true;
+  }
+
+  static bool extend(Eigen::AlignedBox3d& box, const std::vector<shapes::ShapeConstPtr>& shapes,
+                     const EigenSTL::vector_Affine3d& poses)
+  {
+    for (std::size_t i = 0; i < shapes.size(); ++i)
+    {
+      std::unique_ptr<bodies::Body> body(bodies::createBodyFromShape(shapes[i].get()));
+      if (!extend(box, body.get(), poses[i]))
+        return false;
+    }
+    return true;
+  }
+
+  // the axis-aligned box containing \e box transformed by \e pose
+  static Eigen::AlignedBox3d transform(const Eigen::Affine3d& pose, const Eigen::AlignedBox3d& box)
+  {
+    Eigen::AlignedBox3d result;
+    for (int i = 0; i < 8; ++i)
+      result.extend(pose * box.corner(static_cast<Eigen::AlignedBox3d::CornerType>(i)));
+    return result;
+  }
+
+  void computeWaypointBounds()
+  {
+    waypoint_bounds_.clear();
+    path_bounds_.setEmpty();
+    const std::vector<const robot_model::LinkModel*>& links =
+        trajectory_->getRobotModel()->getLinkModelsWithCollisionGeometry();
+    if (link_bodies_.empty())
+    {
+      link_bodies_.resize(links.size());
+      for (std::size_t i = 0; i < links.size(); ++i)
+        for (std::size_t j = 0; j < links[i]->getShapes().size(); ++j)
+          link_bodies_[i].push_back(bodies::createBodyFromShape(links[i]->getShapes()[j].get()));
+    }
+
+    std::vector<Eigen::AlignedBox3d> bounds(trajectory_->getWayPointCount());
+    for (std::size_t k = 0; k < bounds.size(); ++k)
+    {
+      robot_state::RobotState state(trajectory_->getWayPoint(k));
+      state.updateCollisionBodyTransforms();
+      for (std::size_t i = 0; i < links.size(); ++i)
+        for (std::size_t j = 0; j < link_bodies_[i].size(); ++j)
+          if (!extend(bounds[k], link_bodies_[i][j], state.getCollisionBodyTransform(links[i], j)))
+            return;
+
+      std::vector<const robot_state::AttachedBody*> attached;
+      state.getAttachedBodies(attached);
+      for (std::size_t i = 0; i < attached.size(); ++i)
+        if (!extend(bounds[k], attached[i]->getShapes(), attached[i]->getGlobalCollisionBodyTransforms()))
+          return;
+      path_bounds_.extend(bounds[k]);
+    }
+    waypoint_bounds_.swap(bounds);
+  }
+
+  bool updateObjects(const collision_detection::World& world)
+  {
+    // the world copies an object before changing it while it is referenced here, so changes show as new pointers
+    bool bounded = true;
+    std::map<std::string, collision_detection::World::ObjectConstPtr> objects;
+    for (collision_detection::World::const_iterator it = world.begin(); it != world.end(); ++it)
+    {
+      if (it->first == planning_scene::PlanningScene::OCTOMAP_NS)
+        continue;
+      objects[it->first] = it->second;
+      std::map<std::string, collision_detection::World::ObjectConstPtr>::const_iterator previous =
+          objects_.find(it->first);
+      if (previous == objects_.end() || previous->second != it->second)
+        bounded &= extend(region_, it->second->shapes_, it->second->shape_poses_);
+    }
+    objects_.swap(objects);
+    return bounded;
+  }
+
+  bool updateOctree(const collision_detection::World& world)
+  {
+    collision_detection::World::ObjectConstPtr map = world.getObject(planning_scene::PlanningScene::OCTOMAP_NS);
+    std::shared_ptr<const octomap::OcTree> octree;
+    Eigen::Affine3d pose = Eigen::Affine3d::Identity();
+    if (map && map->shapes_.size() == 1 && map->shapes_[0]->type == shapes::OCTREE)
+    {
+      octree = static_cast<const shapes::OcTree*>(map->shapes_[0].get())->octree;
+      pose = map->shape_poses_[0];
+    }
+    else if (map)
+      return false;
+
+    std::vector<octomap::KeySet> occupied;
+    bool bounded = octree == octree_ && pose.isApprox(octree_pose_);
+    if (octree && !waypoint_bounds_.empty())
+    {
+      // only the cells within the bounds of the path can invalidate it
+      const Eigen::AlignedBox3d box = transform(pose.inverse(), path_bounds_);
+      const double limit = octree->getResolution() * 32767.0;  // the range of the 16 bit keys, centered at 0
+      const Eigen::Vector3d min = box.min().cwiseMax(Eigen::Vector3d::Constant(-limit));
+      const Eigen::Vector3d max = box.max().cwiseMin(Eigen::Vector3d::Constant(limit));
+      occupied.resize(octree->getTreeDepth() + 1);
+      for (octomap::OcTree::leaf_bbx_iterator it = octree->begin_leafs_bbx(
+                                                  octomap::point3d(min.x(), min.y(), min.z()),
+                                                  octomap::point3d(max.x(), max.y(), max.z())),
+                                              end = octree->end_leafs_bbx();
+           it != end; ++it)
+      {
+        if (!octree->isNodeOccupied(*it))
+          continue;
+        occupied[it.getDepth()].insert(it.getKey());
+        if (bounded && (occupied_.size() <= it.getDepth() || occupied_[it.getDepth()].count(it.getKey()) == 0))
+        {
+          const octomap::point3d c = it.getCoordinate();
+          const Eigen::Vector3d half = Eigen::Vector3d::Constant(it.getSize() / 2.0);
+          const Eigen::Vector3d center(c.x(), c.y(), c.z());
+          region_.extend(transform(pose, Eigen::AlignedBox3d(center - half, center + half)));
+        }
+      }
+    }
+    occupied_.swap(occupied);
+    octree_ = octree;
+    octree_pose_ = pose;
+    return bounded;
+  }
+
+  const planning_scene::PlanningScene* scene_;
+  uint64_t acm_version_;
+  uint64_t world_version_;
+  uint64_t octomap_version_;
+
+  robot_trajectory::RobotTrajectoryPtr trajectory_;
+  std::vector<std::vector<bodies::Body*> > link_bodies_;
+  std::vector<Eigen::AlignedBox3d> waypoint_bounds_;  // empty if some waypoint cannot be bounded
+  Eigen::AlignedBox3d path_bounds_;
+
+  std::map<std::string, collision_detection::World::ObjectConstPtr> objects_;
+  std::shared_ptr<const octomap::OcTree> octree_;
+  Eigen::Affine3d octree_pose_;
+  std::vector<octomap::KeySet> occupied_;  // occupied octree leaves within path_bounds_, by depth
+
+  bool bounded_;
+  Eigen::AlignedBox3d region_;
+};
 }
 
 plan_execution::PlanExecution::PlanExecution(
@@ -81,6 +287,10 @@ plan_execution::PlanExecution::PlanExecution(
         planning_scene_monitor_->getRobotModel(), planning_scene_monitor_->getStateMonitor()));
 
   default_max_replan_attempts_ = 5;
+  replan_lookahead_ = 0.0;
+  check_torque_limits_ = false;
+  background_plan_done_ = false;
+  background_plan_solved_ = false;
 
   preempt_requested_ = false;
   new_scene_update_ = false;
@@ -168,6 +378,10 @@ void plan_execution::PlanExecution::planAndExecuteHelper(ExecutableMotionPlan& p
   unsigned int replan_attempts = 0;
   bool previously_solved = false;
 
+  // a plan computed while the previous one was still executing, to be executed next without planning again
+  ExecutableMotionPlan next_plan;
+  bool have_next_plan = false;
+
   // run a planning loop for at most the maximum replanning attempts;
   // re-planning is executed only in case of known types of failures (e.g., environment changed)
   do
@@ -175,18 +389,29 @@ void plan_execution::PlanExecution::planAndExecuteHelper(ExecutableMotionPlan& p
     replan_attempts++;
     ROS_INFO("Planning attempt %u of at most %u", replan_attempts, max_replan_attempts);
 
-    if (opt.before_plan_callback_)
-      opt.before_plan_callback_();
+    bool solved;
+    if (have_next_plan)
+    {
+      plan.plan_components_.swap(next_plan.plan_components_);
+      plan.error_code_ = next_plan.error_code_;
+      next_plan.plan_components_.clear();
+      have_next_plan = false;
+      solved = true;
+    }
+    else
+    {
+      if (opt.before_plan_callback_)
+        opt.before_plan_callback_();
 
-    new_scene_update_ = false;  // we clear any scene updates to be evaluated because we are about to compute a new
-                                // plan, which should consider most recent updates already
+      new_scene_update_ = false;  // we clear any scene updates to be evaluated because we are about to compute a new
+                                  // plan, which should consider most recent updates already
 
-    // if we never had a solved plan, or there is no specified way of fixing plans, just call the planner; otherwise,
-    // try to repair the plan we previously had;
-    bool solved =
-        (!previously_solved || !opt.repair_plan_callback_) ?
-            opt.plan_callback_(plan) :
-            opt.repair_plan_callback_(plan, trajectory_execution_manager_->getCurrentExpectedTrajectoryIndex());
+      // if we never had a solved plan, or there is no specified way of fixing plans, just call the planner;
+      // otherwise, try to repair the plan we previously had;
+      solved = (!previously_solved || !opt.repair_plan_callback_) ?
+                   opt.plan_callback_(plan) :
+                   opt.repair_plan_callback_(plan, trajectory_execution_manager_->getCurrentExpectedTrajectoryIndex());
+    }
 
     if (preempt_requested_)
       break;
@@ -221,7 +446,7 @@ void plan_execution::PlanExecution::planAndExecuteHelper(ExecutableMotionPlan& p
         break;
 
       // execute the trajectory, and monitor its executionm
-      plan.error_code_ = executeAndMonitor(plan);
+      plan.error_code_ = executeAndMonitor(plan, opt, next_plan, have_next_plan);
     }
 
     // if we are done, then we exit the loop
@@ -234,7 +459,7 @@ void plan_execution::PlanExecution::planAndExecuteHelper(ExecutableMotionPlan& p
     else
     {
       // othewrise, we wait (if needed)
-      if (opt.replan_delay_ > 0.0)
+      if (opt.replan_delay_ > 0.0 && !have_next_plan)
       {
         ROS_INFO("Waiting for a %lf seconds before attempting a new plan ...", opt.replan_delay_);
         ros::WallDuration d(opt.replan_delay_);
@@ -260,15 +485,23 @@ void plan_execution::PlanExecution::planAndExecuteHelper(ExecutableMotionPlan& p
               getErrorCodeString(plan.error_code_).c_str());
 }
 
-bool plan_execution::PlanExecution::isRemainingPathValid(const ExecutableMotionPlan& plan)
+bool plan_execution::PlanExecution::isRemainingPathValid(const ExecutableMotionPlan& plan, std::size_t* first_invalid)
 {
   // check the validity of the currently executed path segment only, since there could be
   // changes in the world in between path segments
-  return isRemainingPathValid(plan, trajectory_execution_manager_->getCurrentExpectedTrajectoryIndex());
+  return isRemainingPathValid(plan, trajectory_execution_manager_->getCurrentExpectedTrajectoryIndex(), first_invalid);
 }
 
 bool plan_execution::PlanExecution::isRemainingPathValid(const ExecutableMotionPlan& plan,
-                                                         const std::pair<int, int>& path_segment)
+                                                         const std::pair<int, int>& path_segment,
+                                                         std::size_t* first_invalid)
+{
+  return isRemainingPathValid(plan, path_segment, first_invalid, NULL);
+}
+
+bool plan_execution::PlanExecution::isRemainingPathValid(const ExecutableMotionPlan& plan,
+                                                         const std::pair<int, int>& path_segment,
+                                                         std::size_t* first_invalid, PathChangeTracker* changes)
 {
   if (path_segment.first >= 0 && path_segment.second >= 0 &&
       plan.plan_components_[path_segment.first].trajectory_monitoring_)
@@ -283,8 +516,12 @@ bool plan_execution::PlanExecution::isRemainingPathValid(const ExecutableMotionP
     std::size_t wpc = t.getWayPointCount();
     collision_detection::CollisionRequest req;
     req.group_name = t.getGroupName();
+    if (changes)
+      changes->update(*plan.planning_scene_, plan.plan_components_[path_segment.first].trajectory_);
     for (std::size_t i = std::max(path_segment.second - 1, 0); i < wpc; ++i)
     {
+      if (changes && !changes->needsCheck(i))
+        continue;
       collision_detection::CollisionResult res;
       if (acm)
         plan.planning_scene_->checkCollisionUnpadded(req, res, t.getWayPoint(i), *acm);
@@ -305,6 +542,8 @@ bool plan_execution::PlanExecution::isRemainingPathValid(const ExecutableMotionP
           plan.planning_scene_->checkCollisionUnpadded(req, res, t.getWayPoint(i), *acm);
         else
           plan.planning_scene_->checkCollisionUnpadded(req, res, t.getWayPoint(i));
+        if (first_invalid)
+          *first_invalid = i;
         return false;
       }
     }
@@ -312,8 +551,13 @@ bool plan_execution::PlanExecution::isRemainingPathValid(const ExecutableMotionP
   return true;
 }
 
-moveit_msgs::MoveItErrorCodes plan_execution::PlanExecution::executeAndMonitor(const ExecutableMotionPlan& plan)
+moveit_msgs::MoveItErrorCodes plan_execution::PlanExecution::executeAndMonitor(const ExecutableMotionPlan& plan,
+                                                                               const Options& opt,
+                                                                               ExecutableMotionPlan& next_plan,
+                                                                               bool& have_next_plan)
 {
+  have_next_plan = false;
+
   moveit_msgs::MoveItErrorCodes result;
 
   // try to execute the trajectory
@@ -372,6 +616,15 @@ moveit_msgs::MoveItErrorCodes plan_execution::PlanExecution::executeAndMonitor(c
 
     prev = i;
 
+    if (check_torque_limits_ && !isWithinTorqueLimits(*plan.plan_components_[i].trajectory_))
+    {
+      trajectory_execution_manager_->clear();
+      ROS_ERROR_STREAM("Trajectory for '" << plan.plan_components_[i].description_ << "' exceeds the torque limits");
+      execution_complete_ = true;
+      result.val = moveit_msgs::MoveItErrorCodes::INVALID_MOTION_PLAN;
+      return result;
+    }
+
     // convert to message, pass along
     moveit_msgs::RobotTrajectory msg;
     plan.plan_components_[i].trajectory_->getRobotTrajectoryMsg(msg);
@@ -400,14 +653,47 @@ moveit_msgs::MoveItErrorCodes plan_execution::PlanExecution::executeAndMonitor(c
   // wait for path to be done, while checking that the path does not become invalid
   ros::Rate r(100);
   path_became_invalid_ = false;
+  std::pair<int, int> index(-1, -1);
+  bool background_plan_usable = true;
+  PathChangeTracker changes;
   while (node_handle_.ok() && !execution_complete_ && !preempt_requested_ && !path_became_invalid_)
   {
     r.sleep();
+    index = trajectory_execution_manager_->getCurrentExpectedTrajectoryIndex();
+
     // check the path if there was an environment update in the meantime
     if (new_scene_update_)
     {
       new_scene_update_ = false;
-      if (!isRemainingPathValid(plan))
+      std::size_t first_invalid = 0;
+      if (!isRemainingPathValid(plan, index, &first_invalid, &changes))
+      {
+        if (background_plan_thread_)
+        {
+          // the motion to where the background plan starts is no longer valid either
+          if (index.first != background_plan_start_.first || (int)first_invalid <= background_plan_start_.second)
+          {
+            background_plan_usable = false;
+            path_became_invalid_ = true;
+            break;
+          }
+        }
+        // keep moving along the part of the path that is still valid while the next plan is computed, if possible
+        else if (!opt.replan_ || replan_lookahead_ <= 0.0 ||
+                 !startBackgroundPlanning(plan, opt, index, first_invalid))
+        {
+          path_became_invalid_ = true;
+          break;
+        }
+      }
+    }
+
+    // switch to the background plan once it is ready; do not go past the waypoint it starts from
+    if (background_plan_thread_)
+    {
+      boost::mutex::scoped_lock slock(background_plan_mutex_);
+      if (background_plan_done_ || index.first != background_plan_start_.first ||
+          index.second >= background_plan_start_.second)
       {
         path_became_invalid_ = true;
         break;
@@ -423,7 +709,10 @@ moveit_msgs::MoveItErrorCodes plan_execution::PlanExecution::executeAndMonitor(c
   }
   else if (path_became_invalid_)
   {
-    ROS_INFO("Stopping execution because the path to execute became invalid (probably the environment changed)");
+    if (background_plan_thread_ && background_plan_usable)
+      ROS_INFO("Switching to the plan computed while the path that became invalid was executed");
+    else
+      ROS_INFO("Stopping execution because the path to execute became invalid (probably the environment changed)");
     trajectory_execution_manager_->stopExecution();
   }
   else if (!execution_complete_)
@@ -436,6 +725,18 @@ moveit_msgs::MoveItErrorCodes plan_execution::PlanExecution::executeAndMonitor(c
   if (trajectory_monitor_)
     trajectory_monitor_->stopTrajectoryMonitor();
 
+  // wait for the background plan, and use it next if the robot is still on its way to where it starts
+  if (background_plan_thread_)
+  {
+    background_plan_thread_->join();
+    background_plan_thread_.reset();
+    if (path_became_invalid_ && background_plan_usable && background_plan_solved_ && !preempt_requested_)
+      have_next_plan = spliceBackgroundPlan(plan, index, next_plan);
+    if (!have_next_plan)
+      ROS_INFO("The plan computed while executing cannot be used");
+    background_plan_.reset();
+  }
+
   // decide return value
   if (path_became_invalid_)
     result.val = moveit_msgs::MoveItErrorCodes::MOTION_PLAN_INVALIDATED_BY_ENVIRONMENT_CHANGE;
@@ -460,6 +761,137 @@ moveit_msgs::MoveItErrorCodes plan_execution::PlanExecution::executeAndMonitor(c
   return result;
 }
 
+bool plan_execution::PlanExecution::startBackgroundPlanning(const ExecutableMotionPlan& plan, const Options& opt,
+                                                            const std::pair<int, int>& path_segment,
+                                                            std::size_t first_invalid)
+{
+  if (!opt.plan_callback_ || path_segment.first < 0 || path_segment.second < 0)
+    return false;
+  for (std::size_t i = path_segment.first + 1; i < plan.plan_components_.size(); ++i)
+    if (plan.plan_components_[i].trajectory_ && !plan.plan_components_[i].trajectory_->empty())
+      return false;
+
+  // find the waypoint the robot is expected to reach after the lookahead, which must come before the invalid one
+  const robot_trajectory::RobotTrajectory& t = *plan.plan_components_[path_segment.first].trajectory_;
+  std::size_t start = path_segment.second;
+  double time = 0.0;
+  while (time < replan_lookahead_ && start + 1 < first_invalid)
+    time += t.getWayPointDurationFromPrevious(++start);
+  if (time < replan_lookahead_)
+    return false;
+
+  background_plan_.reset(new ExecutableMotionPlan());
+  background_plan_->planning_scene_monitor_ = plan.planning_scene_monitor_;
+  {
+    planning_scene_monitor::LockedPlanningSceneRO lscene(plan.planning_scene_monitor_);  // lock the scene so that it
+                                                                                         // does not modify the world
+                                                                                         // representation while
+                                                                                         // diff() is called
+    planning_scene::PlanningScenePtr scene = plan.planning_scene_->diff();
+    scene->setCurrentState(t.getWayPoint(start));
+    background_plan_->planning_scene_ = scene;
+  }
+  background_plan_start_ = std::make_pair(path_segment.first, (int)start);
+  background_plan_done_ = false;
+  background_plan_solved_ = false;
+
+  ROS_INFO("Path became invalid at waypoint %u. Planning from waypoint %u, %lf seconds ahead, while it is executed",
+           (unsigned int)first_invalid, (unsigned int)start, time);
+  background_plan_thread_.reset(new boost::thread(&PlanExecution::computeBackgroundPlan, this, &opt));
+  return true;
+}
+
+void plan_execution::PlanExecution::computeBackgroundPlan(const Options* opt)
+{
+  bool solved = false;
+  try
+  {
+    solved = opt->plan_callback_(*background_plan_);
+  }
+  catch (std::exception& ex)
+  {
+    ROS_ERROR("Exception caught while planning in the background: %s", ex.what());
+  }
+
+  boost::mutex::scoped_lock slock(background_plan_mutex_);
+  background_plan_solved_ = solved && background_plan_->error_code_.val == moveit_msgs::MoveItErrorCodes::SUCCESS;
+  background_plan_done_ = true;
+}
+
+bool plan_execution::PlanExecution::spliceBackgroundPlan(const ExecutableMotionPlan& plan,
+                                                         const std::pair<int, int>& path_segment,
+                                                         ExecutableMotionPlan& next_plan)
+{
+  std::size_t first = 0;
+  while (first < background_plan_->plan_components_.size() &&
+         (!background_plan_->plan_components_[first].trajectory_ ||
+          background_plan_->plan_components_[first].trajectory_->empty()))
+    ++first;
+  if (first == background_plan_->plan_components_.size())
+    return false;
+
+  const robot_trajectory::RobotTrajectory& executed = *plan.plan_components_[background_plan_start_.first].trajectory_;
+  const robot_trajectory::RobotTrajectory& planned = *background_plan_->plan_components_[first].trajectory_;
+  robot_trajectory::RobotTrajectoryPtr spliced(
+      new robot_trajectory::RobotTrajectory(planned.getRobotModel(), planned.getGroup()));
+
+  // the robot stopped on its way to the start of the new plan; the rest of the way is prefixed to that plan
+  spliced->addSuffixWayPoint(plan.planning_scene_monitor_ && plan.planning_scene_monitor_->getStateMonitor() ?
+                                 *plan.planning_scene_monitor_->getStateMonitor()->getCurrentState() :
+                                 plan.planning_scene_->getCurrentState(),
+                             0.0);
+  int begin = path_segment.first == background_plan_start_.first ? std::max(path_segment.second + 1, 0) :
+                                                                   background_plan_start_.second;
+  for (int i = begin; i < background_plan_start_.second; ++i)
+    spliced->addSuffixWayPoint(executed.getWayPoint(i), 0.0);
+  for (std::size_t i = 0; i < planned.getWayPointCount(); ++i)
+    spliced->addSuffixWayPoint(planned.getWayPoint(i), 0.0);
+
+  // the spliced path starts at rest, so it is timed again as a whole
+  trajectory_processing::IterativeParabolicTimeParameterization time_param;
+  if (!time_param.computeTimeStamps(*spliced))
+    return false;
+
+  next_plan.plan_components_ = background_plan_->plan_components_;
+  next_plan.plan_components_[first].trajectory_ = spliced;
+  next_plan.error_code_.val = moveit_msgs::MoveItErrorCodes::SUCCESS;
+  return true;
+}
+
+bool plan_execution::PlanExecution::isWithinTorqueLimits(const robot_trajectory::RobotTrajectory& trajectory)
+{
+  const robot_model::JointModelGroup* group = trajectory.getGroup();
+  if (!group)
+    return true;
+
+  std::map<std::string, dynamics_solver::DynamicsSolverPtr>::iterator it = dynamics_solvers_.find(group->getName());
+  if (it == dynamics_solvers_.end())
+  {
+    geometry_msgs::Vector3 gravity_vector;
+    gravity_vector.z = 9.81;
+    dynamics_solver::DynamicsSolverPtr solver(
+        new dynamics_solver::DynamicsSolver(trajectory.getRobotModel(), group->getName(), gravity_vector));
+    // the solver leaves its group unset if it cannot be used for this group
+    if (!solver->getGroup())
+    {
+      ROS_DEBUG("Torque limits of group '%s' cannot be checked", group->getName().c_str());
+      solver.reset();
+    }
+    it = dynamics_solvers_.insert(std::make_pair(group->getName(), solver)).first;
+  }
+  if (!it->second)
+    return true;
+
+  std::size_t first_violation = trajectory.getWayPointCount();
+  unsigned int joint_saturated = 0;
+  if (it->second->checkTorqueLimits(trajectory, &first_violation, &joint_saturated))
+    return true;
+  if (first_violation < trajectory.getWayPointCount())
+    ROS_ERROR("Waypoint %zu of the trajectory for group '%s' exceeds the effort limit of joint %u", first_violation,
+              group->getName().c_str(), joint_saturated);
+  return false;
+}
+
 void plan_execution::PlanExecution::planningSceneUpdatedCallback(
     const planning_scene_monitor::PlanningSceneMonitor::SceneUpdateType update_type)
 {
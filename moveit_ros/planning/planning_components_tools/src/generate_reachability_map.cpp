@@ -0,0 +1,84 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/robot_model_loader/robot_model_loader.h>
+#include <moveit/kinematics_metrics/reachability_map.h>
+#include <ros/ros.h>
+#include <boost/program_options/parsers.hpp>
+#include <boost/program_options/variables_map.hpp>
+
+static const std::string ROBOT_DESCRIPTION = "robot_description";
+
+int main(int argc, char** argv)
+{
+  ros::init(argc, argv, "generate_reachability_map");
+
+  kinematics_metrics::ReachabilityMap::GenerationOptions options;
+  std::string group_name, output;
+  boost::program_options::options_description desc;
+  desc.add_options()("group", boost::program_options::value<std::string>(&group_name), "The group to map")(
+      "output", boost::program_options::value<std::string>(&output), "The file to write the map to")(
+      "resolution", boost::program_options::value<double>(&options.resolution)->default_value(options.resolution),
+      "The edge length of a voxel (m)")(
+      "samples", boost::program_options::value<std::size_t>(&options.samples)->default_value(options.samples),
+      "The number of joint states to sample")(
+      "nthreads", boost::program_options::value<unsigned int>(&options.thread_count)->default_value(0),
+      "Number of threads to use (0 means one per core)")("help", "this screen");
+  boost::program_options::variables_map vm;
+  boost::program_options::parsed_options po = boost::program_options::parse_command_line(argc, argv, desc);
+  boost::program_options::store(po, vm);
+  boost::program_options::notify(vm);
+
+  if (vm.count("help") || group_name.empty() || output.empty())
+  {
+    std::cout << desc << std::endl;
+    return vm.count("help") ? 0 : 1;
+  }
+
+  robot_model_loader::RobotModelLoader rml(ROBOT_DESCRIPTION);
+  if (!rml.getModel())
+  {
+    ROS_ERROR("Unable to load the robot model from '%s'", ROBOT_DESCRIPTION.c_str());
+    return 1;
+  }
+
+  kinematics_metrics::ReachabilityMap map;
+  ros::WallTime start = ros::WallTime::now();
+  if (!map.generate(rml.getModel(), group_name, options) || !map.saveToFile(output))
+    return 1;
+  ROS_INFO("Wrote the reachability map of '%s' to '%s' in %lf seconds", group_name.c_str(), output.c_str(),
+           (ros::WallTime::now() - start).toSec());
+
+  return 0;
+}
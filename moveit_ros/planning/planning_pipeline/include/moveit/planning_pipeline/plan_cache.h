@@ -0,0 +1,130 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_PLANNING_PIPELINE_PLAN_CACHE_
+#define MOVEIT_PLANNING_PIPELINE_PLAN_CACHE_
+
+#include <moveit/planning_interface/planning_interface.h>
+#include <moveit/planning_scene/planning_scene.h>
+#include <boost/thread/mutex.hpp>
+#include <boost/unordered_map.hpp>
+#include <list>
+#include <string>
+
+namespace planning_pipeline
+{
+/** \brief A bounded cache of motion plans, for setups that repeatedly plan the same motions.
+
+    Entries are keyed by the request (ignoring its planning time and attempt limits), the start state of the request
+    with its variables quantized to a given resolution, and the versions of the world geometry, allowed collision
+    matrix, robot padding and attached bodies of the scene. The octomap is not part of the key, since it changes with
+    every sensor update; instead, a cached plan is checked against the scene it is returned for, and dropped if it is
+    no longer valid. When the cache is full, the least recently used entry is replaced. All functions are thread
+    safe. */
+class PlanCache
+{
+public:
+  /** \brief Counters for the lookups done so far */
+  struct Statistics
+  {
+    Statistics() : hits_(0), misses_(0), invalidated_(0), entries_(0)
+    {
+    }
+
+    /// Number of lookups that returned a cached plan
+    std::size_t hits_;
+    /// Number of lookups that did not return a plan, including the invalidated ones
+    std::size_t misses_;
+    /// Number of cached plans that were found for a request but were no longer valid in its scene
+    std::size_t invalidated_;
+    /// Number of plans currently in the cache
+    std::size_t entries_;
+  };
+
+  /** \brief Create a cache holding at most \e capacity plans. Start states whose variables differ by less than about
+      \e resolution share an entry */
+  PlanCache(std::size_t capacity, double resolution = 1e-3);
+
+  /** \brief Look for a plan computed for a request equivalent to \e req in a scene equivalent to \e scene. If one is
+      found and its path is valid in \e scene, it is copied to \e res, with its first waypoint replaced by the start
+      state of \e req, and true is returned. */
+  bool lookup(const planning_scene::PlanningSceneConstPtr& scene, const planning_interface::MotionPlanRequest& req,
+              planning_interface::MotionPlanResponse& res);
+
+  /** \brief Store the plan in \e res as the solution for \e req in \e scene */
+  void insert(const planning_scene::PlanningSceneConstPtr& scene, const planning_interface::MotionPlanRequest& req,
+              const planning_interface::MotionPlanResponse& res);
+
+  /** \brief Remove all cached plans; the statistics are kept */
+  void clear();
+
+  std::size_t getCapacity() const
+  {
+    return capacity_;
+  }
+
+  double getResolution() const
+  {
+    return resolution_;
+  }
+
+  /** \brief Get the counters of the lookups done so far */
+  Statistics getStatistics() const;
+
+private:
+  struct Entry
+  {
+    std::string key_;
+    robot_trajectory::RobotTrajectoryPtr trajectory_;
+  };
+  typedef std::list<Entry> EntryList;
+
+  /** \brief Compute the key of \e req in \e scene, and the start state of the request */
+  std::string computeKey(const planning_scene::PlanningSceneConstPtr& scene,
+                         const planning_interface::MotionPlanRequest& req, robot_state::RobotState& start_state) const;
+
+  std::size_t capacity_;
+  double resolution_;
+
+  /// The cached plans, most recently used first
+  EntryList entries_;
+  boost::unordered_map<std::string, EntryList::iterator> index_;
+  Statistics statistics_;
+  mutable boost::mutex lock_;
+};
+
+MOVEIT_CLASS_FORWARD(PlanCache);
+}
+
+#endif
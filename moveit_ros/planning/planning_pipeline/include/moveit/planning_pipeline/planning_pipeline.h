@@ -39,6 +39,7 @@
 
 #include <moveit/planning_interface/planning_interface.h>
 #include <moveit/planning_request_adapter/planning_request_adapter.h>
+#include <moveit/planning_pipeline/plan_cache.h>
 #include <pluginlib/class_loader.h>
 #include <ros/ros.h>
 
@@ -68,7 +69,14 @@ public:
    * this topic (visualization_msgs::MarkerArray) */
   static const std::string MOTION_CONTACTS_TOPIC;
 
+  /** \brief When the plan cache is enabled, its statistics are published on this topic after every request
+   * (diagnostic_msgs::DiagnosticStatus) */
+  static const std::string PLAN_CACHE_STATISTICS_TOPIC;
+
   /** \brief Given a robot model (\e model), a node handle (\e nh), initialize the planning pipeline.
+      If the ~planning_portfolio parameter lists several planning plugins (each optionally followed by ':' and a
+      planner_id), these are run concurrently on every request instead of the planning plugin (see
+      PortfolioPlannerManager; ~portfolio_wait_for_best selects whether the first or the best solution is returned).
       \param model The robot model for which this pipeline is initialized.
       \param nh The ROS node handle that should be used for reading parameters needed for configuration
       \param planning_plugin_param_name The name of the ROS parameter under which the name of the planning plugin is
@@ -101,6 +109,17 @@ public:
    * This is true by default.  */
   void checkSolutionPaths(bool flag);
 
+  /** \brief Keep up to \e capacity computed plans and return them, after checking them against the scene, for
+   * equivalent requests (see PlanCache). A capacity of 0 disables the cache. By default, the capacity is read from
+   * the ~plan_cache_size parameter (0 if not set) and the resolution from ~plan_cache_resolution. */
+  void enablePlanCache(std::size_t capacity, double resolution = 1e-3);
+
+  /** \brief Get the plan cache set up by enablePlanCache(); empty if the cache is disabled */
+  const PlanCachePtr& getPlanCache() const
+  {
+    return plan_cache_;
+  }
+
   /** \brief Get the flag set by displayComputedMotionPlans() */
   bool getDisplayComputedMotionPlans() const
   {
@@ -134,10 +153,16 @@ public:
       \param adapter_added_state_index Sometimes planning request adapters may add states on the solution path (e.g.,
      add the current state of the robot as prefix, when the robot started to plan only from near that state, as the
      current state itself appears to touch obstacles). This is helpful because the added states should not be considered
-     invalid in all situations. */
+     invalid in all situations.
+      \param intermediate_solution_callback If set, the planning context is asked to report the improving solutions
+     it finds before it returns (see planning_interface::PlanningContext::setIntermediateSolutionCallback()). These
+     are reported as computed by the planner: the planning request adapters and the solution check of the pipeline are
+     applied to the final solution only. */
   bool generatePlan(const planning_scene::PlanningSceneConstPtr& planning_scene,
                     const planning_interface::MotionPlanRequest& req, planning_interface::MotionPlanResponse& res,
-                    std::vector<std::size_t>& adapter_added_state_index) const;
+                    std::vector<std::size_t>& adapter_added_state_index,
+                    const planning_interface::IntermediateSolutionCallback& intermediate_solution_callback =
+                        planning_interface::IntermediateSolutionCallback()) const;
 
   /** \brief Request termination, if a generatePlan() function is currently computing plans */
   void terminate() const;
@@ -169,6 +194,13 @@ public:
 private:
   void configure();
 
+  /* load and initialize the planning plugin \e plugin_name, one of the declared \e classes */
+  planning_interface::PlannerManagerPtr loadPlanner(const std::string& plugin_name,
+                                                    const std::vector<std::string>& classes) const;
+
+  void displayPlan(const robot_trajectory::RobotTrajectory& trajectory) const;
+  void publishPlanCacheStatistics() const;
+
   ros::NodeHandle nh_;
 
   /// Flag indicating whether motion plans should be published as a moveit_msgs::DisplayTrajectory
@@ -193,6 +225,9 @@ private:
   /// Flag indicating whether the reported plans should be checked once again, by the planning pipeline itself
   bool check_solution_paths_;
   ros::Publisher contacts_publisher_;
+
+  PlanCachePtr plan_cache_;
+  ros::Publisher plan_cache_statistics_publisher_;
 };
 
 MOVEIT_CLASS_FORWARD(PlanningPipeline);
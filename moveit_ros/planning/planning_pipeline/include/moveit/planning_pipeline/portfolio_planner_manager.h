@@ -0,0 +1,111 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_PLANNING_PIPELINE_PORTFOLIO_PLANNER_MANAGER_
+#define MOVEIT_PLANNING_PIPELINE_PORTFOLIO_PLANNER_MANAGER_
+
+#include <moveit/planning_interface/planning_interface.h>
+#include <string>
+#include <vector>
+
+namespace planning_pipeline
+{
+/** \brief A planner that runs several planners concurrently on the same request.
+
+    Each member of the portfolio is a planner, optionally with the planner_id that replaces the one of the request
+    it is given (so that one plugin can take part with several of its configurations). The planning contexts of the
+    members that can service a request are solved in parallel threads. By default, the first valid solution is
+    returned and the other members are terminated; if the portfolio waits for the best solution, all members run
+    until they finish (within the allowed planning time of the request) and the shortest valid solution is
+    returned. */
+class PortfolioPlannerManager : public planning_interface::PlannerManager
+{
+public:
+  struct Member
+  {
+    Member(const planning_interface::PlannerManagerPtr& planner, const std::string& planner_id = "")
+      : planner_(planner), planner_id_(planner_id)
+    {
+    }
+
+    planning_interface::PlannerManagerPtr planner_;
+    /// If not empty, the planner_id used for the requests given to this member
+    std::string planner_id_;
+  };
+
+  /** \brief Construct a portfolio of initialized planners */
+  PortfolioPlannerManager(const std::vector<Member>& members, bool wait_for_best = false);
+
+  virtual std::string getDescription() const;
+
+  virtual void getPlanningAlgorithms(std::vector<std::string>& algs) const;
+
+  virtual planning_interface::PlanningContextPtr
+  getPlanningContext(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                     const planning_interface::MotionPlanRequest& req, moveit_msgs::MoveItErrorCodes& error_code) const;
+
+  /** \brief True if any member can service the request */
+  virtual bool canServiceRequest(const planning_interface::MotionPlanRequest& req) const;
+
+  /** \brief Pass the settings to every member */
+  virtual void setPlannerConfigurations(const planning_interface::PlannerConfigurationMap& pcs);
+
+  const std::vector<Member>& getMembers() const
+  {
+    return members_;
+  }
+
+  /** \brief Set whether to wait for all members and return the best solution, instead of the first one */
+  void setWaitForBest(bool flag)
+  {
+    wait_for_best_ = flag;
+  }
+
+  bool getWaitForBest() const
+  {
+    return wait_for_best_;
+  }
+
+private:
+  planning_interface::MotionPlanRequest getMemberRequest(const Member& member,
+                                                         const planning_interface::MotionPlanRequest& req) const;
+
+  std::vector<Member> members_;
+  bool wait_for_best_;
+};
+
+MOVEIT_CLASS_FORWARD(PortfolioPlannerManager);
+}
+
+#endif
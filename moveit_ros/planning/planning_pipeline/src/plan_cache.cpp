@@ -0,0 +1,195 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/planning_pipeline/plan_cache.h>
+#include <moveit/robot_state/conversions.h>
+#include <ros/serialization.h>
+#include <cmath>
+
+namespace planning_pipeline
+{
+namespace
+{
+template <typename T>
+void appendBytes(std::string& key, const T& value)
+{
+  key.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+robot_trajectory::RobotTrajectoryPtr copyTrajectory(const robot_trajectory::RobotTrajectory& trajectory)
+{
+  // the copy constructor of RobotTrajectory shares the waypoints; cached plans need their own
+  robot_trajectory::RobotTrajectoryPtr copy(
+      new robot_trajectory::RobotTrajectory(trajectory.getRobotModel(), trajectory.getGroup()));
+  for (std::size_t i = 0; i < trajectory.getWayPointCount(); ++i)
+    copy->addSuffixWayPoint(trajectory.getWayPoint(i), trajectory.getWayPointDurationFromPrevious(i));
+  return copy;
+}
+}
+
+PlanCache::PlanCache(std::size_t capacity, double resolution) : capacity_(capacity), resolution_(resolution)
+{
+  if (resolution_ <= 0.0)
+  {
+    ROS_WARN("Plan cache resolution must be positive. Using 1e-3.");
+    resolution_ = 1e-3;
+  }
+}
+
+std::string PlanCache::computeKey(const planning_scene::PlanningSceneConstPtr& scene,
+                                  const planning_interface::MotionPlanRequest& req,
+                                  robot_state::RobotState& start_state) const
+{
+  start_state = scene->getCurrentState();
+  robot_state::robotStateMsgToRobotState(scene->getTransforms(), req.start_state, start_state);
+
+  // the joint values of the start state are keyed after quantization, and the limits on the planning effort do not
+  // change what a valid plan is
+  moveit_msgs::MotionPlanRequest request = req;
+  request.start_state.joint_state = sensor_msgs::JointState();
+  request.start_state.multi_dof_joint_state = sensor_msgs::MultiDOFJointState();
+  request.num_planning_attempts = 0;
+  request.allowed_planning_time = 0.0;
+
+  std::string key;
+  appendBytes(key, scene->getWorldVersion());
+  appendBytes(key, scene->getAllowedCollisionMatrixVersion());
+  appendBytes(key, scene->getRobotPaddingVersion());
+  appendBytes(key, scene->getAttachedBodiesVersion());
+
+  const double* positions = start_state.getVariablePositions();
+  for (std::size_t i = 0; i < start_state.getVariableCount(); ++i)
+    appendBytes(key, static_cast<int64_t>(std::floor(positions[i] / resolution_ + 0.5)));
+
+  std::size_t offset = key.size();
+  key.resize(offset + ros::serialization::serializationLength(request));
+  ros::serialization::OStream stream(reinterpret_cast<uint8_t*>(&key[offset]), key.size() - offset);
+  ros::serialization::serialize(stream, request);
+  return key;
+}
+
+bool PlanCache::lookup(const planning_scene::PlanningSceneConstPtr& scene,
+                       const planning_interface::MotionPlanRequest& req, planning_interface::MotionPlanResponse& res)
+{
+  ros::WallTime start = ros::WallTime::now();
+  robot_state::RobotState start_state(scene->getRobotModel());
+  std::string key = computeKey(scene, req, start_state);
+
+  robot_trajectory::RobotTrajectoryPtr trajectory;
+  {
+    boost::mutex::scoped_lock slock(lock_);
+    boost::unordered_map<std::string, EntryList::iterator>::iterator it = index_.find(key);
+    if (it == index_.end())
+    {
+      ++statistics_.misses_;
+      return false;
+    }
+    entries_.splice(entries_.begin(), entries_, it->second);
+    trajectory = copyTrajectory(*it->second->trajectory_);
+  }
+
+  // the plan starts from the actual start state, which may differ from the cached one by the resolution
+  trajectory->getFirstWayPointPtr()->setVariablePositions(start_state.getVariablePositions());
+
+  // the octomap is not part of the key, and the start state only matches approximately; like the planning pipeline,
+  // accept plans whose only invalid state is the start state
+  std::vector<std::size_t> index;
+  bool valid = scene->isPathValid(*trajectory, req.path_constraints, req.group_name, false, &index) ||
+               (index.size() == 1 && index[0] == 0);
+
+  boost::mutex::scoped_lock slock(lock_);
+  if (!valid)
+  {
+    boost::unordered_map<std::string, EntryList::iterator>::iterator it = index_.find(key);
+    if (it != index_.end())
+    {
+      entries_.erase(it->second);
+      index_.erase(it);
+    }
+    ++statistics_.invalidated_;
+    ++statistics_.misses_;
+    return false;
+  }
+  ++statistics_.hits_;
+
+  res.trajectory_ = trajectory;
+  res.planning_time_ = (ros::WallTime::now() - start).toSec();
+  res.error_code_.val = moveit_msgs::MoveItErrorCodes::SUCCESS;
+  return true;
+}
+
+void PlanCache::insert(const planning_scene::PlanningSceneConstPtr& scene,
+                       const planning_interface::MotionPlanRequest& req,
+                       const planning_interface::MotionPlanResponse& res)
+{
+  if (capacity_ == 0 || !res.trajectory_ || res.trajectory_->empty())
+    return;
+
+  robot_state::RobotState start_state(scene->getRobotModel());
+  Entry entry;
+  entry.key_ = computeKey(scene, req, start_state);
+  entry.trajectory_ = copyTrajectory(*res.trajectory_);
+
+  boost::mutex::scoped_lock slock(lock_);
+  boost::unordered_map<std::string, EntryList::iterator>::iterator it = index_.find(entry.key_);
+  if (it != index_.end())
+  {
+    it->second->trajectory_ = entry.trajectory_;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return;
+  }
+  if (entries_.size() >= capacity_)
+  {
+    index_.erase(entries_.back().key_);
+    entries_.pop_back();
+  }
+  entries_.push_front(entry);
+  index_[entries_.front().key_] = entries_.begin();
+}
+
+void PlanCache::clear()
+{
+  boost::mutex::scoped_lock slock(lock_);
+  entries_.clear();
+  index_.clear();
+}
+
+PlanCache::Statistics PlanCache::getStatistics() const
+{
+  boost::mutex::scoped_lock slock(lock_);
+  Statistics statistics = statistics_;
+  statistics.entries_ = entries_.size();
+  return statistics;
+}
+}
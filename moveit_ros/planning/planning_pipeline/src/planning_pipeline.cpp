@@ -35,18 +35,23 @@
 /* Author: Ioan Sucan */
 
 #include <moveit/planning_pipeline/planning_pipeline.h>
+#include <moveit/planning_pipeline/portfolio_planner_manager.h>
 #include <moveit/robot_state/conversions.h>
 #include <moveit/collision_detection/collision_tools.h>
 #include <moveit/trajectory_processing/trajectory_tools.h>
+#include <moveit/profiler/tracer.h>
 #include <moveit_msgs/DisplayTrajectory.h>
+#include <diagnostic_msgs/DiagnosticStatus.h>
 #include <visualization_msgs/MarkerArray.h>
 #include <boost/tokenizer.hpp>
 #include <boost/algorithm/string/join.hpp>
+#include <boost/lexical_cast.hpp>
 #include <sstream>
 
 const std::string planning_pipeline::PlanningPipeline::DISPLAY_PATH_TOPIC = "display_planned_path";
 const std::string planning_pipeline::PlanningPipeline::MOTION_PLAN_REQUEST_TOPIC = "motion_plan_request";
 const std::string planning_pipeline::PlanningPipeline::MOTION_CONTACTS_TOPIC = "display_contacts";
+const std::string planning_pipeline::PlanningPipeline::PLAN_CACHE_STATISTICS_TOPIC = "plan_cache_statistics";
 
 planning_pipeline::PlanningPipeline::PlanningPipeline(const robot_model::RobotModelConstPtr& model,
                                                       const ros::NodeHandle& nh,
@@ -111,18 +116,40 @@ void planning_pipeline::PlanningPipeline::configure()
              "now.",
              planner_plugin_name_.c_str());
   }
-  try
+
+  // a portfolio lists planning plugins, each optionally followed by ':' and the planner_id it is used with
+  std::string portfolio;
+  if (nh_.getParam("planning_portfolio", portfolio) && !portfolio.empty())
   {
-    planner_instance_.reset(planner_plugin_loader_->createUnmanagedInstance(planner_plugin_name_));
-    if (!planner_instance_->initialize(kmodel_, nh_.getNamespace()))
-      throw std::runtime_error("Unable to initialize planning plugin");
-    ROS_INFO_STREAM("Using planning interface '" << planner_instance_->getDescription() << "'");
+    std::map<std::string, planning_interface::PlannerManagerPtr> plugins;
+    std::vector<PortfolioPlannerManager::Member> members;
+    boost::char_separator<char> sep(" ");
+    boost::tokenizer<boost::char_separator<char> > tok(portfolio, sep);
+    for (boost::tokenizer<boost::char_separator<char> >::iterator beg = tok.begin(); beg != tok.end(); ++beg)
+    {
+      std::size_t colon = beg->find(':');
+      std::string plugin_name = beg->substr(0, colon);
+      std::string planner_id = colon == std::string::npos ? std::string() : beg->substr(colon + 1);
+      planning_interface::PlannerManagerPtr& planner = plugins[plugin_name];
+      if (!planner)
+        planner = loadPlanner(plugin_name, classes);
+      if (planner)
+        members.push_back(PortfolioPlannerManager::Member(planner, planner_id));
+    }
+    if (!members.empty())
+    {
+      bool wait_for_best;
+      nh_.param("portfolio_wait_for_best", wait_for_best, false);
+      planner_instance_.reset(new PortfolioPlannerManager(members, wait_for_best));
+      planner_plugin_name_ = portfolio;
+      ROS_INFO_STREAM("Using planning interface '" << planner_instance_->getDescription() << "'");
+    }
   }
-  catch (pluginlib::PluginlibException& ex)
+  else
   {
-    ROS_ERROR_STREAM("Exception while loading planner '"
-                     << planner_plugin_name_ << "': " << ex.what() << std::endl
-                     << "Available plugins: " << boost::algorithm::join(classes, ", "));
+    planner_instance_ = loadPlanner(planner_plugin_name_, classes);
+    if (planner_instance_)
+      ROS_INFO_STREAM("Using planning interface '" << planner_instance_->getDescription() << "'");
   }
 
   // load the planner request adapters
@@ -167,6 +194,49 @@ void planning_pipeline::PlanningPipeline::configure()
   }
   displayComputedMotionPlans(true);
   checkSolutionPaths(true);
+
+  int plan_cache_size;
+  double plan_cache_resolution;
+  nh_.param("plan_cache_size", plan_cache_size, 0);
+  nh_.param("plan_cache_resolution", plan_cache_resolution, 1e-3);
+  if (plan_cache_size > 0)
+    enablePlanCache(plan_cache_size, plan_cache_resolution);
+}
+
+planning_interface::PlannerManagerPtr
+planning_pipeline::PlanningPipeline::loadPlanner(const std::string& plugin_name,
+                                                 const std::vector<std::string>& classes) const
+{
+  planning_interface::PlannerManagerPtr planner;
+  try
+  {
+    planner.reset(planner_plugin_loader_->createUnmanagedInstance(plugin_name));
+    if (!planner->initialize(kmodel_, nh_.getNamespace()))
+      throw std::runtime_error("Unable to initialize planning plugin");
+  }
+  catch (pluginlib::PluginlibException& ex)
+  {
+    ROS_ERROR_STREAM("Exception while loading planner '" << plugin_name << "': " << ex.what() << std::endl
+                                                         << "Available plugins: "
+                                                         << boost::algorithm::join(classes, ", "));
+    planner.reset();
+  }
+  return planner;
+}
+
+void planning_pipeline::PlanningPipeline::enablePlanCache(std::size_t capacity, double resolution)
+{
+  if (capacity == 0)
+  {
+    plan_cache_.reset();
+    plan_cache_statistics_publisher_.shutdown();
+    return;
+  }
+  plan_cache_.reset(new PlanCache(capacity, resolution));
+  if (!plan_cache_statistics_publisher_)
+    plan_cache_statistics_publisher_ =
+        nh_.advertise<diagnostic_msgs::DiagnosticStatus>(PLAN_CACHE_STATISTICS_TOPIC, 10, true);
+  ROS_INFO("Caching up to %u motion plans", (unsigned int)capacity);
 }
 
 void planning_pipeline::PlanningPipeline::displayComputedMotionPlans(bool flag)
@@ -204,11 +274,61 @@ bool planning_pipeline::PlanningPipeline::generatePlan(const planning_scene::Pla
   return generatePlan(planning_scene, req, res, dummy);
 }
 
-bool planning_pipeline::PlanningPipeline::generatePlan(const planning_scene::PlanningSceneConstPtr& planning_scene,
-                                                       const planning_interface::MotionPlanRequest& req,
-                                                       planning_interface::MotionPlanResponse& res,
-                                                       std::vector<std::size_t>& adapter_added_state_index) const
+namespace planning_pipeline
+{
+namespace
+{
+/* Forwards to the planner plugin, setting the intermediate solution callback of the planning contexts it returns;
+   this reaches the context created at the end of the planning request adapter chain */
+class IntermediateSolutionPlannerManager : public planning_interface::PlannerManager
+{
+public:
+  IntermediateSolutionPlannerManager(const planning_interface::PlannerManagerPtr& planner,
+                                     const planning_interface::IntermediateSolutionCallback& callback)
+    : planner_(planner), callback_(callback)
+  {
+    config_settings_ = planner_->getPlannerConfigurations();
+  }
+
+  virtual std::string getDescription() const
+  {
+    return planner_->getDescription();
+  }
+
+  virtual void getPlanningAlgorithms(std::vector<std::string>& algs) const
+  {
+    planner_->getPlanningAlgorithms(algs);
+  }
+
+  virtual planning_interface::PlanningContextPtr
+  getPlanningContext(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                     const planning_interface::MotionPlanRequest& req, moveit_msgs::MoveItErrorCodes& error_code) const
+  {
+    planning_interface::PlanningContextPtr context = planner_->getPlanningContext(planning_scene, req, error_code);
+    if (context)
+      context->setIntermediateSolutionCallback(callback_);
+    return context;
+  }
+
+  virtual bool canServiceRequest(const planning_interface::MotionPlanRequest& req) const
+  {
+    return planner_->canServiceRequest(req);
+  }
+
+private:
+  planning_interface::PlannerManagerPtr planner_;
+  planning_interface::IntermediateSolutionCallback callback_;
+};
+}
+}
+
+bool planning_pipeline::PlanningPipeline::generatePlan(
+    const planning_scene::PlanningSceneConstPtr& planning_scene, const planning_interface::MotionPlanRequest& req,
+    planning_interface::MotionPlanResponse& res, std::vector<std::size_t>& adapter_added_state_index,
+    const planning_interface::IntermediateSolutionCallback& intermediate_solution_callback) const
 {
+  MOVEIT_TRACE_SCOPE("PlanningPipeline::generatePlan");
+
   // broadcast the request we are about to work on, if needed
   if (publish_received_requests_)
     received_request_publisher_.publish(req);
@@ -220,12 +340,30 @@ bool planning_pipeline::PlanningPipeline::generatePlan(const planning_scene::Pla
     return false;
   }
 
+  // plans computed for an equivalent request are returned once they are checked against the scene
+  if (plan_cache_ && plan_cache_->lookup(planning_scene, req, res))
+  {
+    ROS_DEBUG("Using a cached plan with %u states", (unsigned int)res.trajectory_->getWayPointCount());
+    publishPlanCacheStatistics();
+    if (display_computed_motion_plans_)
+      displayPlan(*res.trajectory_);
+    return true;
+  }
+
+  planning_interface::PlannerManagerPtr planner = planner_instance_;
+  if (intermediate_solution_callback)
+    planner.reset(new IntermediateSolutionPlannerManager(planner_instance_, intermediate_solution_callback));
+
   bool solved = false;
   try
   {
+    MOVEIT_TRACE_SCOPE("PlanningPipeline::plan");
     if (adapter_chain_)
     {
-      solved = adapter_chain_->adaptAndPlan(planner_instance_, planning_scene, req, res, adapter_added_state_index);
+      solved = adapter_chain_->adaptAndPlan(planner, planning_scene, req, res, adapter_added_state_index);
+      for (std::size_t i = 0; i < res.stage_description_.size(); ++i)
+        ROS_DEBUG("Planning stage '%s' took %lf seconds", res.stage_description_[i].c_str(),
+                  res.stage_processing_time_[i]);
       if (!adapter_added_state_index.empty())
       {
         std::stringstream ss;
@@ -237,7 +375,7 @@ bool planning_pipeline::PlanningPipeline::generatePlan(const planning_scene::Pla
     else
     {
       planning_interface::PlanningContextPtr context =
-          planner_instance_->getPlanningContext(planning_scene, req, res.error_code_);
+          planner->getPlanningContext(planning_scene, req, res.error_code_);
       solved = context ? context->solve(res) : false;
     }
   }
@@ -254,6 +392,8 @@ bool planning_pipeline::PlanningPipeline::generatePlan(const planning_scene::Pla
     ROS_DEBUG_STREAM("Motion planner reported a solution path with " << state_count << " states");
     if (check_solution_paths_)
     {
+      MOVEIT_TRACE_SCOPE("PlanningPipeline::checkSolutionPath");
+      ros::WallTime check_start = ros::WallTime::now();
       std::vector<std::size_t> index;
       if (!planning_scene->isPathValid(*res.trajectory_, req.path_constraints, req.group_name, false, &index))
       {
@@ -325,23 +465,58 @@ bool planning_pipeline::PlanningPipeline::generatePlan(const planning_scene::Pla
       }
       else
         ROS_DEBUG("Planned path was found to be valid when rechecked");
+      res.stage_description_.push_back("Solution path check");
+      res.stage_processing_time_.push_back((ros::WallTime::now() - check_start).toSec());
     }
   }
 
-  // display solution path if needed
-  if (display_computed_motion_plans_ && solved)
+  if (plan_cache_)
   {
-    moveit_msgs::DisplayTrajectory disp;
-    disp.model_id = kmodel_->getName();
-    disp.trajectory.resize(1);
-    res.trajectory_->getRobotTrajectoryMsg(disp.trajectory[0]);
-    robot_state::robotStateToRobotStateMsg(res.trajectory_->getFirstWayPoint(), disp.trajectory_start);
-    display_path_publisher_.publish(disp);
+    if (solved && valid)
+      plan_cache_->insert(planning_scene, req, res);
+    publishPlanCacheStatistics();
   }
 
+  // display solution path if needed
+  if (display_computed_motion_plans_ && solved)
+    displayPlan(*res.trajectory_);
+
   return solved && valid;
 }
 
+void planning_pipeline::PlanningPipeline::displayPlan(const robot_trajectory::RobotTrajectory& trajectory) const
+{
+  moveit_msgs::DisplayTrajectory disp;
+  disp.model_id = kmodel_->getName();
+  disp.trajectory.resize(1);
+  trajectory.getRobotTrajectoryMsg(disp.trajectory[0]);
+  robot_state::robotStateToRobotStateMsg(trajectory.getFirstWayPoint(), disp.trajectory_start);
+  display_path_publisher_.publish(disp);
+}
+
+void planning_pipeline::PlanningPipeline::publishPlanCacheStatistics() const
+{
+  PlanCache::Statistics statistics = plan_cache_->getStatistics();
+  diagnostic_msgs::DiagnosticStatus status;
+  status.level = diagnostic_msgs::DiagnosticStatus::OK;
+  status.name = nh_.resolveName(PLAN_CACHE_STATISTICS_TOPIC);
+  std::stringstream ss;
+  ss << statistics.hits_ << " hits, " << statistics.misses_ << " misses";
+  status.message = ss.str();
+
+  const std::pair<const char*, std::size_t> values[] = { std::make_pair("hits", statistics.hits_),
+                                                         std::make_pair("misses", statistics.misses_),
+                                                         std::make_pair("invalidated", statistics.invalidated_),
+                                                         std::make_pair("entries", statistics.entries_) };
+  status.values.resize(sizeof(values) / sizeof(values[0]));
+  for (std::size_t i = 0; i < status.values.size(); ++i)
+  {
+    status.values[i].key = values[i].first;
+    status.values[i].value = boost::lexical_cast<std::string>(values[i].second);
+  }
+  plan_cache_statistics_publisher_.publish(status);
+}
+
 void planning_pipeline::PlanningPipeline::terminate() const
 {
   if (planner_instance_)
@@ -0,0 +1,297 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/planning_pipeline/portfolio_planner_manager.h>
+#include <moveit/planning_scene/planning_scene.h>
+#include <ros/ros.h>
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#include <algorithm>
+#include <sstream>
+
+namespace planning_pipeline
+{
+namespace
+{
+double getPathLength(const robot_trajectory::RobotTrajectory& trajectory)
+{
+  double length = 0.0;
+  for (std::size_t i = 1; i < trajectory.getWayPointCount(); ++i)
+    length += trajectory.getWayPoint(i - 1).distance(trajectory.getWayPoint(i));
+  return length;
+}
+
+/* Solves the planning contexts of the members of a portfolio in parallel threads */
+class PortfolioPlanningContext : public planning_interface::PlanningContext
+{
+public:
+  PortfolioPlanningContext(const std::string& group,
+                           const std::vector<planning_interface::PlanningContextPtr>& contexts, bool wait_for_best)
+    : planning_interface::PlanningContext("portfolio", group)
+    , contexts_(contexts)
+    , wait_for_best_(wait_for_best)
+    , winner_(contexts.size())
+  {
+  }
+
+  virtual bool solve(planning_interface::MotionPlanResponse& res)
+  {
+    ros::WallTime start = ros::WallTime::now();
+    std::vector<planning_interface::MotionPlanResponse> responses(contexts_.size());
+    std::vector<char> valid(contexts_.size(), 0);
+    winner_ = contexts_.size();
+
+    boost::thread_group threads;
+    for (std::size_t i = 0; i < contexts_.size(); ++i)
+    {
+      contexts_[i]->setIntermediateSolutionCallback(intermediate_solution_callback_);
+      threads.create_thread(boost::bind(&PortfolioPlanningContext::solveMember, this, i, &responses[i], &valid[i]));
+    }
+    threads.join_all();
+
+    // the first valid solution, or the shortest one if all members ran to completion
+    std::size_t best = winner_;
+    if (wait_for_best_)
+    {
+      double best_length = 0.0;
+      for (std::size_t i = 0; i < contexts_.size(); ++i)
+        if (valid[i])
+        {
+          double length = getPathLength(*responses[i].trajectory_);
+          if (best == contexts_.size() || length < best_length)
+          {
+            best = i;
+            best_length = length;
+          }
+        }
+    }
+
+    if (best == contexts_.size())
+    {
+      res.error_code_.val = moveit_msgs::MoveItErrorCodes::PLANNING_FAILED;
+      for (std::size_t i = 0; i < responses.size(); ++i)
+        if (responses[i].error_code_.val != moveit_msgs::MoveItErrorCodes::SUCCESS &&
+            responses[i].error_code_.val != 0)
+        {
+          res.error_code_ = responses[i].error_code_;
+          break;
+        }
+      res.planning_time_ = (ros::WallTime::now() - start).toSec();
+      ROS_INFO("None of the %u planners in the portfolio found a valid solution", (unsigned int)contexts_.size());
+      return false;
+    }
+
+    ROS_DEBUG("Using the solution of planning context '%s' from the portfolio", contexts_[best]->getName().c_str());
+    res = responses[best];
+    res.planning_time_ = (ros::WallTime::now() - start).toSec();
+    best_name_ = contexts_[best]->getName();
+    return true;
+  }
+
+  virtual bool solve(planning_interface::MotionPlanDetailedResponse& res)
+  {
+    planning_interface::MotionPlanResponse plan;
+    bool solved = solve(plan);
+    res.error_code_ = plan.error_code_;
+    if (solved)
+    {
+      res.trajectory_.push_back(plan.trajectory_);
+      res.description_.push_back(best_name_);
+      res.processing_time_.push_back(plan.planning_time_);
+    }
+    return solved;
+  }
+
+  virtual bool terminate()
+  {
+    bool result = true;
+    for (std::size_t i = 0; i < contexts_.size(); ++i)
+      if (!contexts_[i]->terminate())
+        result = false;
+    return result;
+  }
+
+  virtual void clear()
+  {
+    for (std::size_t i = 0; i < contexts_.size(); ++i)
+      contexts_[i]->clear();
+    intermediate_solution_callback_ = planning_interface::IntermediateSolutionCallback();
+  }
+
+private:
+  void solveMember(std::size_t index, planning_interface::MotionPlanResponse* res, char* valid)
+  {
+    bool solved = false;
+    try
+    {
+      solved = contexts_[index]->solve(*res);
+    }
+    catch (std::exception& ex)
+    {
+      ROS_ERROR("Exception caught solving planning context '%s' of the portfolio: %s",
+                contexts_[index]->getName().c_str(), ex.what());
+    }
+
+    // the members are checked against the scene here, so that an invalid solution does not end the race
+    if (solved && res->trajectory_ && !res->trajectory_->empty())
+    {
+      std::vector<std::size_t> invalid_index;
+      solved = planning_scene_->isPathValid(*res->trajectory_, request_.path_constraints, request_.group_name, false,
+                                            &invalid_index) ||
+               (invalid_index.size() == 1 && invalid_index[0] == 0);
+    }
+    else
+      solved = false;
+    *valid = solved;
+
+    if (!solved || wait_for_best_)
+      return;
+    {
+      boost::mutex::scoped_lock slock(lock_);
+      if (winner_ < contexts_.size())
+        return;
+      winner_ = index;
+    }
+    for (std::size_t i = 0; i < contexts_.size(); ++i)
+      if (i != index)
+        contexts_[i]->terminate();
+  }
+
+  std::vector<planning_interface::PlanningContextPtr> contexts_;
+  bool wait_for_best_;
+
+  /// The index of the member that found the first valid solution, or the number of members if there is none yet
+  std::size_t winner_;
+  boost::mutex lock_;
+  std::string best_name_;
+};
+}
+
+PortfolioPlannerManager::PortfolioPlannerManager(const std::vector<Member>& members, bool wait_for_best)
+  : members_(members), wait_for_best_(wait_for_best)
+{
+  for (std::size_t i = 0; i < members_.size(); ++i)
+  {
+    const planning_interface::PlannerConfigurationMap& pcs = members_[i].planner_->getPlannerConfigurations();
+    config_settings_.insert(pcs.begin(), pcs.end());
+  }
+}
+
+std::string PortfolioPlannerManager::getDescription() const
+{
+  std::stringstream ss;
+  ss << "Portfolio of";
+  for (std::size_t i = 0; i < members_.size(); ++i)
+  {
+    ss << (i == 0 ? " " : ", ") << members_[i].planner_->getDescription();
+    if (!members_[i].planner_id_.empty())
+      ss << " (" << members_[i].planner_id_ << ")";
+  }
+  return ss.str();
+}
+
+void PortfolioPlannerManager::getPlanningAlgorithms(std::vector<std::string>& algs) const
+{
+  algs.clear();
+  for (std::size_t i = 0; i < members_.size(); ++i)
+  {
+    std::vector<std::string> member_algs;
+    members_[i].planner_->getPlanningAlgorithms(member_algs);
+    for (std::size_t j = 0; j < member_algs.size(); ++j)
+      if (std::find(algs.begin(), algs.end(), member_algs[j]) == algs.end())
+        algs.push_back(member_algs[j]);
+  }
+}
+
+planning_interface::MotionPlanRequest
+PortfolioPlannerManager::getMemberRequest(const Member& member, const planning_interface::MotionPlanRequest& req) const
+{
+  planning_interface::MotionPlanRequest member_req = req;
+  if (!member.planner_id_.empty())
+    member_req.planner_id = member.planner_id_;
+  return member_req;
+}
+
+planning_interface::PlanningContextPtr
+PortfolioPlannerManager::getPlanningContext(const planning_scene::PlanningSceneConstPtr& planning_scene,
+                                            const planning_interface::MotionPlanRequest& req,
+                                            moveit_msgs::MoveItErrorCodes& error_code) const
+{
+  std::vector<planning_interface::PlanningContextPtr> contexts;
+  for (std::size_t i = 0; i < members_.size(); ++i)
+  {
+    planning_interface::MotionPlanRequest member_req = getMemberRequest(members_[i], req);
+    if (!members_[i].planner_->canServiceRequest(member_req))
+      continue;
+    planning_interface::PlanningContextPtr context =
+        members_[i].planner_->getPlanningContext(planning_scene, member_req, error_code);
+    if (context)
+      contexts.push_back(context);
+  }
+
+  if (contexts.empty())
+  {
+    if (error_code.val == moveit_msgs::MoveItErrorCodes::SUCCESS || error_code.val == 0)
+      error_code.val = moveit_msgs::MoveItErrorCodes::PLANNING_FAILED;
+    ROS_ERROR("None of the planners in the portfolio can service the request");
+    return planning_interface::PlanningContextPtr();
+  }
+  error_code.val = moveit_msgs::MoveItErrorCodes::SUCCESS;
+
+  // a single planner is used directly
+  if (contexts.size() == 1)
+    return contexts[0];
+
+  planning_interface::PlanningContextPtr context(
+      new PortfolioPlanningContext(req.group_name, contexts, wait_for_best_));
+  context->setPlanningScene(planning_scene);
+  context->setMotionPlanRequest(req);
+  return context;
+}
+
+bool PortfolioPlannerManager::canServiceRequest(const planning_interface::MotionPlanRequest& req) const
+{
+  for (std::size_t i = 0; i < members_.size(); ++i)
+    if (members_[i].planner_->canServiceRequest(getMemberRequest(members_[i], req)))
+      return true;
+  return false;
+}
+
+void PortfolioPlannerManager::setPlannerConfigurations(const planning_interface::PlannerConfigurationMap& pcs)
+{
+  PlannerManager::setPlannerConfigurations(pcs);
+  for (std::size_t i = 0; i < members_.size(); ++i)
+    members_[i].planner_->setPlannerConfigurations(pcs);
+}
+}
@@ -36,16 +36,32 @@
 
 #include <moveit/planning_request_adapter/planning_request_adapter.h>
 #include <moveit/trajectory_processing/iterative_time_parameterization.h>
+#include <moveit/trajectory_processing/reachability_time_parameterization.h>
 #include <class_loader/class_loader.h>
-#include <ros/console.h>
+#include <ros/ros.h>
 
 namespace default_planner_request_adapters
 {
 class AddTimeParameterization : public planning_request_adapter::PlanningRequestAdapter
 {
 public:
-  AddTimeParameterization() : planning_request_adapter::PlanningRequestAdapter()
+  static const std::string ALGORITHM_PARAM_NAME;
+
+  AddTimeParameterization() : planning_request_adapter::PlanningRequestAdapter(), nh_("~")
   {
+    std::string algorithm;
+    if (!nh_.getParam(ALGORITHM_PARAM_NAME, algorithm))
+    {
+      algorithm = "iterative_parabolic";
+      ROS_INFO_STREAM("Param '" << ALGORITHM_PARAM_NAME << "' was not set. Using default value: " << algorithm);
+    }
+    else
+      ROS_INFO_STREAM("Param '" << ALGORITHM_PARAM_NAME << "' was set to " << algorithm);
+
+    // "reachability" selects the time-optimal parameterization, anything else the iterative parabolic one
+    use_reachability_ = algorithm == "reachability";
+    if (!use_reachability_ && algorithm != "iterative_parabolic")
+      ROS_WARN_STREAM("Unknown time parameterization '" << algorithm << "'. Using 'iterative_parabolic' instead.");
   }
 
   virtual std::string getDescription() const
@@ -62,8 +78,14 @@ public:
     if (result && res.trajectory_)
     {
       ROS_DEBUG("Running '%s'", getDescription().c_str());
-      if (!time_param_.computeTimeStamps(*res.trajectory_, req.max_velocity_scaling_factor,
-                                         req.max_acceleration_scaling_factor))
+      bool success;
+      if (use_reachability_)
+        success = reachability_time_param_.computeTimeStamps(*res.trajectory_, req.max_velocity_scaling_factor,
+                                                             req.max_acceleration_scaling_factor);
+      else
+        success = time_param_.computeTimeStamps(*res.trajectory_, req.max_velocity_scaling_factor,
+                                                req.max_acceleration_scaling_factor);
+      if (!success)
         ROS_WARN("Time parametrization for the solution path failed.");
     }
 
@@ -71,8 +93,13 @@ public:
   }
 
 private:
+  ros::NodeHandle nh_;
+  bool use_reachability_;
   trajectory_processing::IterativeParabolicTimeParameterization time_param_;
+  trajectory_processing::ReachabilityTimeParameterization reachability_time_param_;
 };
+
+const std::string AddTimeParameterization::ALGORITHM_PARAM_NAME = "time_parameterization";
 }
 
 CLASS_LOADER_REGISTER_CLASS(default_planner_request_adapters::AddTimeParameterization,
@@ -39,6 +39,7 @@
 #include <moveit/trajectory_processing/trajectory_tools.h>
 #include <class_loader/class_loader.h>
 #include <ros/ros.h>
+#include <algorithm>
 
 namespace default_planner_request_adapters
 {
@@ -48,6 +49,7 @@ public:
   static const std::string DT_PARAM_NAME;
   static const std::string JIGGLE_PARAM_NAME;
   static const std::string ATTEMPTS_PARAM_NAME;
+  static const std::string BATCH_PARAM_NAME;
 
   FixStartStateCollision() : planning_request_adapter::PlanningRequestAdapter(), nh_("~")
   {
@@ -81,6 +83,21 @@ public:
       }
       ROS_INFO_STREAM("Param '" << ATTEMPTS_PARAM_NAME << "' was set to " << sampling_attempts_);
     }
+
+    if (!nh_.getParam(BATCH_PARAM_NAME, sampling_batch_size_))
+    {
+      sampling_batch_size_ = 16;
+      ROS_INFO_STREAM("Param '" << BATCH_PARAM_NAME << "' was not set. Using default value: " << sampling_batch_size_);
+    }
+    else
+    {
+      if (sampling_batch_size_ < 1)
+      {
+        sampling_batch_size_ = 1;
+        ROS_WARN_STREAM("Param '" << BATCH_PARAM_NAME << "' needs to be at least 1.");
+      }
+      ROS_INFO_STREAM("Param '" << BATCH_PARAM_NAME << "' was set to " << sampling_batch_size_);
+    }
   }
 
   virtual std::string getDescription() const
@@ -124,25 +141,51 @@ public:
               planning_scene->getRobotModel()->getJointModelGroup(req.group_name)->getJointModels() :
               planning_scene->getRobotModel()->getJointModels();
 
+      // candidates are sampled in batches that are checked for collision in parallel; the valid candidate nearest
+      // to the start state is used from the first batch that has one
+      std::vector<robot_state::RobotState> candidates(std::min(sampling_batch_size_, sampling_attempts_), start_state);
+      std::vector<const robot_state::RobotState*> batch;
+      std::vector<collision_detection::CollisionResult> batch_results;
+      std::vector<double> values(start_state.getVariableCount());
       bool found = false;
-      for (int c = 0; !found && c < sampling_attempts_; ++c)
+      int attempts = 0;
+      while (!found && attempts < sampling_attempts_)
       {
-        for (std::size_t i = 0; !found && i < jmodels.size(); ++i)
+        std::size_t batch_size = std::min<std::size_t>(candidates.size(), sampling_attempts_ - attempts);
+        batch.resize(batch_size);
+        for (std::size_t c = 0; c < batch_size; ++c)
+        {
+          const double* original_values = prefix_state->getVariablePositions();
+          std::copy(original_values, original_values + values.size(), values.begin());
+          for (std::size_t i = 0; i < jmodels.size(); ++i)
+          {
+            std::size_t first = jmodels[i]->getFirstVariableIndex();
+            jmodels[i]->getVariableRandomPositionsNearBy(rng, &values[first], original_values + first,
+                                                         jmodels[i]->getMaximumExtent() * jiggle_fraction_);
+          }
+          candidates[c].setVariablePositions(values);
+          candidates[c].updateCollisionBodyTransforms();
+          batch[c] = &candidates[c];
+        }
+        attempts += batch_size;
+
+        planning_scene->checkCollisionBatch(creq, batch_results, batch, 0, false);
+        double best_distance = 0.0;
+        for (std::size_t c = 0; c < batch_size; ++c)
         {
-          std::vector<double> sampled_variable_values(jmodels[i]->getVariableCount());
-          const double* original_values = prefix_state->getJointPositions(jmodels[i]);
-          jmodels[i]->getVariableRandomPositionsNearBy(rng, &sampled_variable_values[0], original_values,
-                                                       jmodels[i]->getMaximumExtent() * jiggle_fraction_);
-          start_state.setJointPositions(jmodels[i], sampled_variable_values);
-          collision_detection::CollisionResult cres;
-          planning_scene->checkCollision(creq, cres, start_state);
-          if (!cres.collision)
+          if (batch_results[c].collision)
+            continue;
+          double distance = prefix_state->distance(candidates[c]);
+          if (!found || distance < best_distance)
           {
+            start_state = candidates[c];
+            best_distance = distance;
             found = true;
-            ROS_INFO("Found a valid state near the start state at distance %lf after %d attempts",
-                     prefix_state->distance(start_state), c);
           }
         }
+        if (found)
+          ROS_INFO("Found a valid state near the start state at distance %lf after %d attempts", best_distance,
+                   attempts);
       }
 
       if (found)
@@ -187,11 +230,13 @@ private:
   double max_dt_offset_;
   double jiggle_fraction_;
   int sampling_attempts_;
+  int sampling_batch_size_;
 };
 
 const std::string FixStartStateCollision::DT_PARAM_NAME = "start_state_max_dt";
 const std::string FixStartStateCollision::JIGGLE_PARAM_NAME = "jiggle_fraction";
 const std::string FixStartStateCollision::ATTEMPTS_PARAM_NAME = "max_sampling_attempts";
+const std::string FixStartStateCollision::BATCH_PARAM_NAME = "sampling_batch_size";
 }
 
 CLASS_LOADER_REGISTER_CLASS(default_planner_request_adapters::FixStartStateCollision,
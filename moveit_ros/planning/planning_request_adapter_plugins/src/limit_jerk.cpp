@@ -0,0 +1,92 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/planning_request_adapter/planning_request_adapter.h>
+#include <moveit/trajectory_processing/jerk_limited_smoothing.h>
+#include <class_loader/class_loader.h>
+#include <ros/ros.h>
+
+namespace default_planner_request_adapters
+{
+/** \brief Limits the jerk of the time parameterized solution path. It must be listed before
+    AddTimeParameterization, so that it runs after the time parameterization. */
+class LimitJerk : public planning_request_adapter::PlanningRequestAdapter
+{
+public:
+  static const std::string MAX_JERK_PARAM_NAME;
+
+  LimitJerk() : planning_request_adapter::PlanningRequestAdapter(), nh_("~")
+  {
+    double max_jerk;
+    if (!nh_.getParam(MAX_JERK_PARAM_NAME, max_jerk))
+    {
+      max_jerk = 10.0;
+      ROS_INFO_STREAM("Param '" << MAX_JERK_PARAM_NAME << "' was not set. Using default value: " << max_jerk);
+    }
+    else
+      ROS_INFO_STREAM("Param '" << MAX_JERK_PARAM_NAME << "' was set to " << max_jerk);
+    smoothing_ = trajectory_processing::JerkLimitedSmoothing(max_jerk);
+  }
+
+  virtual std::string getDescription() const
+  {
+    return "Limit Jerk";
+  }
+
+  virtual bool adaptAndPlan(const PlannerFn& planner, const planning_scene::PlanningSceneConstPtr& planning_scene,
+                            const planning_interface::MotionPlanRequest& req,
+                            planning_interface::MotionPlanResponse& res,
+                            std::vector<std::size_t>& added_path_index) const
+  {
+    bool result = planner(planning_scene, req, res);
+    if (result && res.trajectory_)
+    {
+      ROS_DEBUG("Running '%s'", getDescription().c_str());
+      if (!smoothing_.smooth(*res.trajectory_))
+        ROS_WARN("Jerk limiting for the solution path failed.");
+    }
+
+    return result;
+  }
+
+private:
+  ros::NodeHandle nh_;
+  trajectory_processing::JerkLimitedSmoothing smoothing_;
+};
+
+const std::string LimitJerk::MAX_JERK_PARAM_NAME = "max_jerk";
+}
+
+CLASS_LOADER_REGISTER_CLASS(default_planner_request_adapters::LimitJerk,
+                            planning_request_adapter::PlanningRequestAdapter);
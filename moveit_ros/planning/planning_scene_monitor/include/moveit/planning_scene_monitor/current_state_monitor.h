@@ -46,6 +46,8 @@
 #include <boost/thread/mutex.hpp>
 #include <moveit/macros/deprecation.h>
 #include <boost/thread/condition_variable.hpp>
+#include <atomic>
+#include <memory>
 
 namespace planning_scene_monitor
 {
@@ -125,6 +127,12 @@ public:
   /** @brief Set the state \e upd to the current state maintained by this class. */
   void setToCurrentState(robot_state::RobotState& upd) const;
 
+  /** @brief Copy the positions of the most recent joint state into \e upd without taking the update lock or
+      allocating; readers only retry if a joint state arrives during the copy. If \e stamp is not NULL, it is set to
+      the time stamp of the copied state.
+      @return false if some non-passive, non-mimic variable has not been received yet */
+  bool copyCurrentState(robot_state::RobotState& upd, ros::Time* stamp = NULL) const;
+
   /** @brief Get the time stamp for the current state */
   ros::Time getCurrentStateTime() const;
 
@@ -192,14 +200,39 @@ public:
   }
 
 private:
+  /** @brief The joints named by a joint state message, in the order of the message; NULL for names that are not
+      single-variable joints of the model. Publishers send the same names in every message, so this is computed once
+      per distinct name vector. */
+  struct JointStateNameMapping
+  {
+    std::vector<std::string> names;
+    std::vector<const robot_model::JointModel*> joints;
+  };
+
   void jointStateCallback(const sensor_msgs::JointStateConstPtr& joint_state);
   bool isPassiveOrMimicDOF(const std::string& dof) const;
 
+  /** @brief Return the mapping for the names of \e joint_state, computing it if needed */
+  const JointStateNameMapping& getJointStateNameMapping(const sensor_msgs::JointState& joint_state);
+
+  /** @brief Mark variable \e index as received, keeping missing_variables_ up to date */
+  void markReceived(std::size_t index);
+
+  /** @brief Publish robot_state_ to the snapshot read by copyCurrentState(); called with state_update_lock_ held */
+  void updateSnapshot();
+
   ros::NodeHandle nh_;
   boost::shared_ptr<tf::Transformer> tf_;
   robot_model::RobotModelConstPtr robot_model_;
   robot_state::RobotState robot_state_;
-  std::map<std::string, ros::Time> joint_time_;
+  /// Time of the last update of each variable, indexed by variable index; only valid if joint_received_ is set
+  std::vector<ros::Time> joint_time_;
+  std::vector<bool> joint_received_;
+  /// For each variable, whether it belongs to a passive or mimic joint and need not be received
+  std::vector<bool> passive_or_mimic_;
+  /// Number of variables that are neither passive nor mimic and have not been received yet
+  std::size_t missing_variables_;
+  std::vector<JointStateNameMapping> name_mappings_;
   bool state_monitor_started_;
   bool copy_dynamics_;  // Copy velocity and effort from joint_state
   ros::Time monitor_start_time_;
@@ -211,6 +244,12 @@ private:
   mutable boost::mutex state_update_lock_;
   mutable boost::condition_variable state_update_condition_;
   std::vector<JointStateUpdateCallback> update_callbacks_;
+
+  /// Seqlock protecting the snapshot below: odd while updateSnapshot() is writing it
+  std::atomic<unsigned int> snapshot_sequence_;
+  std::unique_ptr<std::atomic<double>[]> snapshot_positions_;
+  std::atomic<uint64_t> snapshot_stamp_;  // in nanoseconds
+  std::atomic<bool> snapshot_complete_;
 };
 
 MOVEIT_CLASS_FORWARD(CurrentStateMonitor);
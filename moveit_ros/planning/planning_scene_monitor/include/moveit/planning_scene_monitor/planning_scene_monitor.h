@@ -46,11 +46,14 @@
 #include <moveit/robot_model_loader/robot_model_loader.h>
 #include <moveit/occupancy_map_monitor/occupancy_map_monitor.h>
 #include <moveit/planning_scene_monitor/current_state_monitor.h>
+#include <moveit/planning_scene_monitor/shared_memory_scene_transport.h>
 #include <moveit/collision_plugin_loader/collision_plugin_loader.h>
 #include <boost/noncopyable.hpp>
 #include <boost/thread/shared_mutex.hpp>
 #include <boost/thread/recursive_mutex.hpp>
+#include <atomic>
 #include <memory>
+#include <set>
 
 namespace planning_scene_monitor
 {
@@ -189,6 +192,23 @@ public:
     return scene_const_;
   }
 
+  /** @brief Enable or disable scene snapshots. When enabled, LockedPlanningSceneRO instances hold an immutable copy
+      of the scene instead of locking the scene, so readers do not hold up writers. The copy is made when a reader
+      asks for it and the scene changed since the previous copy, so updates that nobody reads in between cost
+      nothing. Disabled by default. */
+  void setSceneSnapshotsEnabled(bool flag);
+
+  /** @brief Return true if scene snapshots are enabled (see setSceneSnapshotsEnabled()) */
+  bool getSceneSnapshotsEnabled() const
+  {
+    return scene_snapshots_enabled_;
+  }
+
+  /** @brief Return an immutable copy of the current scene. The copy is shared by all readers until the scene is
+      updated; the first reader after an update makes a new copy, which waits for the writers of the scene. Returns
+      an empty pointer if scene snapshots are disabled. */
+  planning_scene::PlanningSceneConstPtr getPlanningSceneSnapshot() const;
+
   /** @brief Return true if the scene \e scene can be updated directly
       or indirectly by this monitor. This function will return true if
       the pointer of the scene is the same as the one maintained,
@@ -257,6 +277,23 @@ public:
   /** \brief Set the maximum frequency at which planning scenes are being published */
   void setPlanningScenePublishingFrequency(double hz);
 
+  /** \brief When publishing scene diffs, send only the octomap leaves that changed since the octomap was last
+      published (see PlanningScene::processOctomapDiffMsg()) instead of the full octomap. Each published octomap carries
+      a version number in its header.seq field; subscribing monitors that miss a version request the full scene from
+      the get_planning_scene service. Disabled by default. */
+  void setPublishOctomapDiffs(bool flag);
+
+  /** \brief Return true if octomap diffs are published (see setPublishOctomapDiffs()) */
+  bool getPublishOctomapDiffs() const
+  {
+    return publish_octomap_diffs_;
+  }
+
+  /** \brief In addition to the planning scene topic, write the published planning scenes to the shared memory
+      segment \e segment_name, so that monitors on the same host can read them without going through a socket (see
+      startSceneMonitor()). An empty name stops writing to shared memory. */
+  void setSharedMemoryPublishing(const std::string& segment_name);
+
   /** \brief Get the maximum frequency at which planning scenes are published (Hz) */
   double getPlanningScenePublishingFrequency() const
   {
@@ -282,6 +319,16 @@ public:
    */
   void updateFrameTransforms();
 
+  /** @brief Look up only the given frames (and the frames referenced by received collision objects) in
+   *  updateFrameTransforms(), instead of every frame known to tf. This is also configured by the
+   *  "<robot_description>_planning/tracked_frames" parameter. Frames of constraints the scene should transform
+   *  need to be added by the caller, see addTrackedFrame() */
+  void setTrackedFrames(const std::vector<std::string>& frames);
+
+  /** @brief Add \e frame to the frames looked up by updateFrameTransforms(); this enables the selective lookup
+   *  described for setTrackedFrames() */
+  void addTrackedFrame(const std::string& frame);
+
   /** @brief Start the current state monitor
       @param joint_states_topic the topic to listen to for joint states
       @param attached_objects_topic the topic to listen to for attached collision objects */
@@ -312,10 +359,28 @@ public:
       return 0.0;
   }
 
+  /** @brief Coalesce the scene updates received within a window of \e seconds. Collision object messages and
+     octomap updates are then queued and applied as one batch, under a single write lock, and the update callbacks
+     are called once per window with the union of the update types that occurred. Attached collision object
+     messages are applied immediately, after any queued collision objects. A window of 0 (the default) applies and
+     reports every update as soon as it is received.
+      @param seconds the length of the window */
+  void setSceneUpdateCoalescingWindow(double seconds);
+
+  /** @brief Get the window within which scene updates are coalesced (0 if they are not) */
+  double getSceneUpdateCoalescingWindow() const
+  {
+    return dt_scene_update_coalescing_.toSec();
+  }
+
   /** @brief Start the scene monitor
    *  @param scene_topic The name of the planning scene topic
+   *  @param shared_memory_segment If not empty, and a monitor on the same host writes its scenes to this shared
+   *     memory segment (see setSharedMemoryPublishing()), the scenes are read from there instead of from
+   *     \e scene_topic. If the segment does not exist, \e scene_topic is used.
    */
-  void startSceneMonitor(const std::string& scene_topic = DEFAULT_PLANNING_SCENE_TOPIC);
+  void startSceneMonitor(const std::string& scene_topic = DEFAULT_PLANNING_SCENE_TOPIC,
+                         const std::string& shared_memory_segment = "");
 
   /** @brief Request planning scene state using a service call
    *  @param service_name The name of the service to use for requesting the
@@ -474,9 +539,20 @@ protected:
   SceneUpdateType publish_update_types_;
   SceneUpdateType new_scene_update_;
   boost::condition_variable_any new_scene_update_condition_;
+  bool publish_octomap_diffs_;
+  bool octomap_full_publish_needed_;        /// the octree changed in a way that cannot be sent as a diff
+  ros::WallTime last_octomap_resync_time_;  /// last time the full scene was requested after missed updates
+
+  // writes the published scenes to shared memory, if enabled
+  SharedMemorySceneWriterPtr shared_memory_writer_;
+  boost::mutex shared_memory_writer_lock_;
 
   // subscribe to various sources of data
   ros::Subscriber planning_scene_subscriber_;
+
+  // reads planning scenes from shared memory instead of planning_scene_subscriber_
+  std::unique_ptr<boost::thread> shared_memory_reader_thread_;
+  std::atomic<bool> shared_memory_reader_running_;
   ros::Subscriber planning_scene_world_subscriber_;
 
   ros::Subscriber attached_collision_object_subscriber_;
@@ -512,9 +588,22 @@ protected:
 private:
   void getUpdatedFrameTransforms(std::vector<geometry_msgs::TransformStamped>& transforms);
 
+  // add \e frame to the tracked frames if only those are looked up
+  void trackReferencedFrame(const std::string& frame);
+
+  // called by tf_ whenever it receives transforms
+  void transformsChangedCallback();
+
   // publish planning scene update diffs (runs in its own thread)
   void scenePublishingThread();
 
+  // record that the scene snapshot is out of date, if snapshots are enabled; the next reader replaces it
+  void updateSceneSnapshot(SceneUpdateType update_type);
+
+  // when publishing octomap diffs, replace the octomap in the scene message \e msg by the octree leaves that changed
+  // since the previous call and give it a new version number; the octree must be locked for writing
+  void encodeOctomapDiff(moveit_msgs::PlanningScene& msg, bool is_full);
+
   // called by current_state_monitor_ when robot state (as monitored on joint state topic) changes
   void onStateUpdate(const sensor_msgs::JointStateConstPtr& joint_state);
 
@@ -524,6 +613,29 @@ private:
   // Callback for a new planning scene msg
   void newPlanningSceneCallback(const moveit_msgs::PlanningSceneConstPtr& scene);
 
+  // publish \e msg on planning_scene_publisher_ and write it to shared memory, if enabled
+  void publishPlanningSceneMsg(const moveit_msgs::PlanningScene& msg);
+
+  // feed the scenes written to shared memory by another monitor to newPlanningSceneCallback()
+  void sharedMemoryReaderThread(SharedMemorySceneReaderPtr reader);
+
+  // call the update callbacks, wake up the publishing thread and update the snapshot
+  void fireSceneUpdateEvent(SceneUpdateType update_type);
+
+  // apply the octree maintained by octomap_monitor_ to the scene; scene_update_mutex_ must be locked for writing
+  void applyOctomapUpdate();
+
+  // apply the collision objects and octomap update queued while coalescing scene updates; scene_update_mutex_ must
+  // be locked for writing. Every other change to the scene calls this first, so the queued updates are never applied
+  // after changes received later. Returns true if anything was applied
+  bool applyQueuedGeometryUpdates();
+
+  // apply the queued scene updates and report them with a single update event
+  void processPendingSceneUpdates();
+
+  // called by scene_update_timer_ at the end of each coalescing window
+  void sceneUpdateTimerCallback(const ros::WallTimerEvent& event);
+
   // Lock for state_update_pending_ and dt_state_update_
   boost::mutex state_pending_mutex_;
 
@@ -549,11 +661,57 @@ private:
   // Only access this from callback functions (and constructor)
   ros::WallTime last_robot_state_update_wall_time_;
 
+  /// Lock for the scene updates queued while they are coalesced (the fields below)
+  boost::mutex pending_scene_updates_mutex_;
+
+  /// The window within which scene updates are coalesced; zero if they are not
+  ros::WallDuration dt_scene_update_coalescing_;
+
+  /// The update types reported since the last update event
+  SceneUpdateType pending_scene_update_;
+
+  /// Collision object messages received but not yet applied
+  std::vector<moveit_msgs::CollisionObjectConstPtr> pending_collision_objects_;
+
+  /// True if the octomap changed since it was last applied to the scene
+  bool pending_octomap_update_;
+
+  /// timer that applies the queued scene updates at the end of each coalescing window
+  ros::WallTimer scene_update_timer_;
+
+  /// Lock for the frames looked up by updateFrameTransforms() and the transforms found (the fields below)
+  boost::mutex frame_transforms_mutex_;
+
+  /// True if only tracked_frames_ are looked up, instead of every frame known to tf
+  bool track_selected_frames_;
+
+  /// The frames looked up when track_selected_frames_ is set
+  std::set<std::string> tracked_frames_;
+
+  /// The transforms found by the last lookup; reapplied to the scene until tf or tracked_frames_ change
+  std::vector<geometry_msgs::TransformStamped> frame_transforms_;
+
+  /// Set whenever tf receives transforms or a frame is tracked, cleared when the transforms are looked up again
+  std::atomic<bool> frame_transforms_changed_;
+
+  /// The connection of transformsChangedCallback() to tf_
+  boost::signals2::connection tf_changed_connection_;
+
   robot_model_loader::RobotModelLoaderPtr rm_loader_;
   robot_model::RobotModelConstPtr robot_model_;
 
   collision_detection::CollisionPluginLoader collision_loader_;
 
+  /// The latest immutable copy of the scene; only accessed through std::atomic_load() and std::atomic_store()
+  mutable planning_scene::PlanningSceneConstPtr scene_snapshot_;
+  /// Copy of the monitored octree used by the snapshots, so they do not share a tree that is being updated
+  mutable std::shared_ptr<const octomap::OcTree> snapshot_octree_;
+  /// Serializes the creation of snapshots and protects snapshot_octree_
+  mutable boost::mutex scene_snapshot_mutex_;
+  std::atomic<bool> scene_snapshots_enabled_;
+  /// The update types (a SceneUpdateType mask) the scene received since scene_snapshot_ was made
+  mutable std::atomic<int> scene_snapshot_pending_update_;
+
   class DynamicReconfigureImpl;
   DynamicReconfigureImpl* reconfigure_impl_;
 };
@@ -576,7 +734,8 @@ private:
  * Any number of these "ReadOnly" locks can exist at a given time.
  * The intention is that users which only need to read from the
  * PlanningScene will use these and will thus not interfere with each
- * other.
+ * other. If the monitor publishes scene snapshots, no lock is taken and
+ * the latest snapshot is used instead.
  *
  * @see LockedPlanningSceneRW */
 class LockedPlanningSceneRO
@@ -595,16 +754,20 @@ public:
 
   operator bool() const
   {
-    return planning_scene_monitor_ && planning_scene_monitor_->getPlanningScene();
+    return snapshot_ || (planning_scene_monitor_ && planning_scene_monitor_->getPlanningScene());
   }
 
   operator const planning_scene::PlanningSceneConstPtr&() const
   {
+    if (snapshot_)
+      return snapshot_;
     return static_cast<const PlanningSceneMonitor*>(planning_scene_monitor_.get())->getPlanningScene();
   }
 
   const planning_scene::PlanningSceneConstPtr& operator->() const
   {
+    if (snapshot_)
+      return snapshot_;
     return static_cast<const PlanningSceneMonitor*>(planning_scene_monitor_.get())->getPlanningScene();
   }
 
@@ -617,7 +780,12 @@ protected:
 
   void initialize(bool read_only)
   {
-    if (planning_scene_monitor_)
+    if (!planning_scene_monitor_)
+      return;
+    // readers use the latest snapshot when there is one, which does not need locking
+    if (read_only)
+      snapshot_ = planning_scene_monitor_->getPlanningSceneSnapshot();
+    if (!snapshot_)
       lock_.reset(new SingleUnlock(planning_scene_monitor_.get(), read_only));
   }
 
@@ -648,6 +816,7 @@ protected:
 
   PlanningSceneMonitorPtr planning_scene_monitor_;
   SingleUnlockPtr lock_;
+  planning_scene::PlanningSceneConstPtr snapshot_;
 };
 
 /** \brief This is a convenience class for obtaining access to an
@@ -0,0 +1,135 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_PLANNING_SCENE_MONITOR_SHARED_MEMORY_SCENE_TRANSPORT_
+#define MOVEIT_PLANNING_SCENE_MONITOR_SHARED_MEMORY_SCENE_TRANSPORT_
+
+#include <moveit/macros/class_forward.h>
+#include <moveit_msgs/PlanningScene.h>
+#include <boost/interprocess/shared_memory_object.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/noncopyable.hpp>
+#include <string>
+#include <vector>
+
+namespace planning_scene_monitor
+{
+struct SharedMemorySceneHeader;
+
+MOVEIT_CLASS_FORWARD(SharedMemorySceneWriter);
+MOVEIT_CLASS_FORWARD(SharedMemorySceneReader);
+
+/** \brief Publishes planning scene messages to other processes on the same host through a named shared memory
+    segment.
+
+    The segment holds the latest message in serialized form, together with a sequence number that is incremented for
+    every message written and the id of the writing process. The message is serialized straight into the mapped
+    segment; readers copy it out under the segment lock and deserialize it afterwards, so the writer is only blocked
+    for the copy. Readers that do not keep up only see the latest message and can tell from the sequence number that
+    they missed some. */
+class SharedMemorySceneWriter : private boost::noncopyable
+{
+public:
+  /** \brief The number of bytes reserved for messages by default (64 MiB) */
+  static const std::size_t DEFAULT_CAPACITY;
+
+  /** \brief Create (or replace) the segment \e name, with room for messages of up to \e capacity bytes. Throws
+      boost::interprocess::interprocess_exception if the segment cannot be created. */
+  SharedMemorySceneWriter(const std::string& name, std::size_t capacity = DEFAULT_CAPACITY);
+
+  /** \brief Mark the segment as closed and remove it. Readers that have it mapped keep their mapping until they
+      close it or reopen() the segment. */
+  ~SharedMemorySceneWriter();
+
+  /** \brief Write \e msg as the latest message. Returns false if the message is larger than the capacity of the
+      segment; the sequence number is still incremented, so readers notice that they did not get that message. */
+  bool write(const moveit_msgs::PlanningScene& msg);
+
+  const std::string& getName() const
+  {
+    return name_;
+  }
+
+private:
+  std::string name_;
+  boost::interprocess::shared_memory_object segment_;
+  boost::interprocess::mapped_region region_;
+  SharedMemorySceneHeader* header_;
+};
+
+/** \brief Reads the planning scene messages written by a SharedMemorySceneWriter in another process */
+class SharedMemorySceneReader : private boost::noncopyable
+{
+public:
+  /** \brief Map the existing segment \e name. Throws boost::interprocess::interprocess_exception if the segment does
+      not exist. The message the segment holds at this point, if any, is the first one reported by read(). */
+  SharedMemorySceneReader(const std::string& name);
+
+  /** \brief Wait until a message newer than the last one read is available, or until \e deadline (universal time)
+      passes. Returns true if a message was deserialized into \e msg. \e missed is set to true if messages were
+      written since the previous call that this reader did not get, either because they were overwritten or because
+      they did not fit in the segment, and the message returned (if any) is a diff that does not make up for them. */
+  bool read(moveit_msgs::PlanningScene& msg, const boost::posix_time::ptime& deadline, bool& missed);
+
+  /** \brief Return true if the writer removed the segment; no more messages will arrive through it */
+  bool isClosed() const;
+
+  /** \brief Return true if the segment is not closed and the process that created it is still running. A writer that
+      crashed leaves the segment open, so this is the check to use to decide whether to reopen() it. */
+  bool isWriterAlive() const;
+
+  /** \brief Map the segment \e name again, e.g. after a restarted writer replaced it. Returns false, and keeps the
+      current mapping, if the segment does not exist. As for a new reader, the message the segment holds is the
+      first one reported by read(). */
+  bool reopen();
+
+  const std::string& getName() const
+  {
+    return name_;
+  }
+
+private:
+  std::string name_;
+  boost::interprocess::shared_memory_object segment_;
+  boost::interprocess::mapped_region region_;
+  SharedMemorySceneHeader* header_;
+  uint64_t last_sequence_;
+
+  // the serialized message, copied out of the segment so it can be deserialized without holding the segment lock
+  std::vector<uint8_t> buffer_;
+};
+}
+
+#endif
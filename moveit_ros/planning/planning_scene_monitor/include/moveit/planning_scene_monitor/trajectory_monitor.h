@@ -40,7 +40,10 @@
 #include <moveit/macros/class_forward.h>
 #include <moveit/planning_scene_monitor/current_state_monitor.h>
 #include <moveit/robot_trajectory/robot_trajectory.h>
+#include <ros/subscriber.h>
+#include <sensor_msgs/JointState.h>
 #include <boost/thread.hpp>
+#include <atomic>
 #include <memory>
 
 namespace planning_scene_monitor
@@ -93,8 +96,34 @@ public:
     state_add_callback_ = callback;
   }
 
+  /** @brief Record the variables of \e group from every message on the monitored joint states topic, instead of
+      polling full states at the sampling frequency. Samples go to a ring buffer of \e capacity entries that is
+      allocated here; the joint states callback writes to it without locking and without allocating. When the buffer
+      is full, new samples are dropped until getRecordedTrajectory() makes room. Variables of the group that are
+      not part of a message keep their last known value. */
+  void startStateRecording(const robot_model::JointModelGroup* group, std::size_t capacity = 10000);
+
+  void stopStateRecording();
+
+  bool isRecordingStates() const
+  {
+    return static_cast<bool>(joint_state_subscriber_);
+  }
+
+  /** @brief Move the samples recorded so far out of the ring buffer and append them to \e trajectory as waypoints
+      of the recorded group. Variables outside of the group take their values from the current state. If
+      \e trajectory is empty, its group is set to the recorded group. Returns the number of samples appended. */
+  std::size_t getRecordedTrajectory(robot_trajectory::RobotTrajectory& trajectory);
+
+  /// Number of samples dropped because the ring buffer was full
+  std::size_t getDroppedStateCount() const
+  {
+    return dropped_samples_;
+  }
+
 private:
   void recordStates();
+  void jointStateCallback(const sensor_msgs::JointStateConstPtr& joint_state);
 
   CurrentStateMonitorConstPtr current_state_monitor_;
   double sampling_frequency_;
@@ -105,6 +134,24 @@ private:
 
   std::unique_ptr<boost::thread> record_states_thread_;
   TrajectoryStateAddedCallback state_add_callback_;
+
+  // callback driven recording: a single producer (the joint states callback) / single consumer ring buffer of
+  // (stamp, group variables) samples, each sample taking recording_stride_ doubles
+  const robot_model::JointModelGroup* recording_group_;
+  ros::Subscriber joint_state_subscriber_;
+  std::vector<double> samples_;
+  std::size_t sample_capacity_;
+  std::size_t recording_stride_;
+  std::atomic<std::size_t> sample_head_;  // next sample to be written, only changed by the producer
+  std::atomic<std::size_t> sample_tail_;  // next sample to be read, only changed by the consumer
+  std::atomic<std::size_t> dropped_samples_;
+  boost::mutex consumer_lock_;
+  double last_exported_stamp_;
+
+  // producer state: last known group values and the mapping of the last message's names to them
+  std::vector<double> recording_values_;
+  std::vector<std::string> message_names_;
+  std::vector<int> message_to_group_;
 };
 }
 
@@ -36,6 +36,7 @@
 
 #include <moveit/planning_scene_monitor/current_state_monitor.h>
 #include <tf_conversions/tf_eigen.h>
+#include <algorithm>
 #include <limits>
 
 planning_scene_monitor::CurrentStateMonitor::CurrentStateMonitor(const robot_model::RobotModelConstPtr& robot_model,
@@ -54,8 +55,24 @@ planning_scene_monitor::CurrentStateMonitor::CurrentStateMonitor(const robot_mod
   , state_monitor_started_(false)
   , copy_dynamics_(false)
   , error_(std::numeric_limits<double>::epsilon())
+  , snapshot_sequence_(0)
+  , snapshot_stamp_(0)
+  , snapshot_complete_(false)
 {
   robot_state_.setToDefaultValues();
+  const std::vector<std::string>& dof = robot_model_->getVariableNames();
+  joint_time_.resize(dof.size());
+  joint_received_.resize(dof.size(), false);
+  passive_or_mimic_.resize(dof.size());
+  missing_variables_ = 0;
+  for (std::size_t i = 0; i < dof.size(); ++i)
+  {
+    passive_or_mimic_[i] = isPassiveOrMimicDOF(dof[i]);
+    if (!passive_or_mimic_[i])
+      ++missing_variables_;
+  }
+  snapshot_positions_.reset(new std::atomic<double>[dof.size()]);
+  updateSnapshot();
 }
 
 planning_scene_monitor::CurrentStateMonitor::~CurrentStateMonitor()
@@ -102,6 +119,66 @@ void planning_scene_monitor::CurrentStateMonitor::setToCurrentState(robot_state:
   upd.setVariablePositions(pos);
 }
 
+bool planning_scene_monitor::CurrentStateMonitor::copyCurrentState(robot_state::RobotState& upd,
+                                                                   ros::Time* stamp) const
+{
+  const std::size_t n = robot_model_->getVariableCount();
+  double* pos = upd.getVariablePositions();
+  unsigned int sequence;
+  uint64_t nsec;
+  bool copied = false;
+  do
+  {
+    sequence = snapshot_sequence_.load(std::memory_order_acquire);
+    if (sequence & 1)
+      continue;
+    if (!snapshot_complete_.load(std::memory_order_relaxed))
+    {
+      // only possible after a partial copy if the monitor was restarted concurrently
+      if (copied)
+        upd.setVariablePositions(pos);
+      return false;
+    }
+    copied = true;
+    nsec = snapshot_stamp_.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i < n; ++i)
+      pos[i] = snapshot_positions_[i].load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+  } while ((sequence & 1) || snapshot_sequence_.load(std::memory_order_relaxed) != sequence);
+
+  // the positions were written in place; this only invalidates the transforms of upd
+  upd.setVariablePositions(pos);
+  if (stamp)
+    stamp->fromNSec(nsec);
+  return true;
+}
+
+void planning_scene_monitor::CurrentStateMonitor::markReceived(std::size_t index)
+{
+  if (!joint_received_[index])
+  {
+    joint_received_[index] = true;
+    if (!passive_or_mimic_[index])
+      --missing_variables_;
+  }
+}
+
+void planning_scene_monitor::CurrentStateMonitor::updateSnapshot()
+{
+  const unsigned int sequence = snapshot_sequence_.load(std::memory_order_relaxed);
+  snapshot_sequence_.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  const std::size_t n = robot_model_->getVariableCount();
+  const double* pos = robot_state_.getVariablePositions();
+  for (std::size_t i = 0; i < n; ++i)
+    snapshot_positions_[i].store(pos[i], std::memory_order_relaxed);
+  snapshot_stamp_.store(current_state_time_.toNSec(), std::memory_order_relaxed);
+  snapshot_complete_.store(missing_variables_ == 0, std::memory_order_relaxed);
+
+  snapshot_sequence_.store(sequence + 2, std::memory_order_release);
+}
+
 void planning_scene_monitor::CurrentStateMonitor::addUpdateCallback(const JointStateUpdateCallback& fn)
 {
   if (fn)
@@ -117,7 +194,12 @@ void planning_scene_monitor::CurrentStateMonitor::startStateMonitor(const std::s
 {
   if (!state_monitor_started_ && robot_model_)
   {
-    joint_time_.clear();
+    {
+      boost::mutex::scoped_lock slock(state_update_lock_);
+      joint_received_.assign(joint_received_.size(), false);
+      missing_variables_ = std::count(passive_or_mimic_.begin(), passive_or_mimic_.end(), false);
+      updateSnapshot();
+    }
     if (joint_states_topic.empty())
       ROS_ERROR("The joint states topic cannot be an empty string");
     else
@@ -179,13 +261,10 @@ bool planning_scene_monitor::CurrentStateMonitor::haveCompleteState() const
   const std::vector<std::string>& dof = robot_model_->getVariableNames();
   boost::mutex::scoped_lock slock(state_update_lock_);
   for (std::size_t i = 0; i < dof.size(); ++i)
-    if (joint_time_.find(dof[i]) == joint_time_.end())
+    if (!joint_received_[i] && !passive_or_mimic_[i])
     {
-      if (!isPassiveOrMimicDOF(dof[i]))
-      {
-        ROS_DEBUG("Joint variable '%s' has never been updated", dof[i].c_str());
-        result = false;
-      }
+      ROS_DEBUG("Joint variable '%s' has never been updated", dof[i].c_str());
+      result = false;
     }
   return result;
 }
@@ -196,12 +275,11 @@ bool planning_scene_monitor::CurrentStateMonitor::haveCompleteState(std::vector<
   const std::vector<std::string>& dof = robot_model_->getVariableNames();
   boost::mutex::scoped_lock slock(state_update_lock_);
   for (std::size_t i = 0; i < dof.size(); ++i)
-    if (joint_time_.find(dof[i]) == joint_time_.end())
-      if (!isPassiveOrMimicDOF(dof[i]))
-      {
-        missing_states.push_back(dof[i]);
-        result = false;
-      }
+    if (!joint_received_[i] && !passive_or_mimic_[i])
+    {
+      missing_states.push_back(dof[i]);
+      result = false;
+    }
   return result;
 }
 
@@ -214,18 +292,17 @@ bool planning_scene_monitor::CurrentStateMonitor::haveCompleteState(const ros::D
   boost::mutex::scoped_lock slock(state_update_lock_);
   for (std::size_t i = 0; i < dof.size(); ++i)
   {
-    if (isPassiveOrMimicDOF(dof[i]))
+    if (passive_or_mimic_[i])
       continue;
-    std::map<std::string, ros::Time>::const_iterator it = joint_time_.find(dof[i]);
-    if (it == joint_time_.end())
+    if (!joint_received_[i])
     {
       ROS_DEBUG("Joint variable '%s' has never been updated", dof[i].c_str());
       result = false;
     }
-    else if (it->second < old)
+    else if (joint_time_[i] < old)
     {
       ROS_DEBUG("Joint variable '%s' was last updated %0.3lf seconds ago (older than the allowed %0.3lf seconds)",
-                dof[i].c_str(), (now - it->second).toSec(), age.toSec());
+                dof[i].c_str(), (now - joint_time_[i]).toSec(), age.toSec());
       result = false;
     }
   }
@@ -242,19 +319,18 @@ bool planning_scene_monitor::CurrentStateMonitor::haveCompleteState(const ros::D
   boost::mutex::scoped_lock slock(state_update_lock_);
   for (std::size_t i = 0; i < dof.size(); ++i)
   {
-    if (isPassiveOrMimicDOF(dof[i]))
+    if (passive_or_mimic_[i])
       continue;
-    std::map<std::string, ros::Time>::const_iterator it = joint_time_.find(dof[i]);
-    if (it == joint_time_.end())
+    if (!joint_received_[i])
     {
       ROS_DEBUG("Joint variable '%s' has never been updated", dof[i].c_str());
       missing_states.push_back(dof[i]);
       result = false;
     }
-    else if (it->second < old)
+    else if (joint_time_[i] < old)
     {
       ROS_DEBUG("Joint variable '%s' was last updated %0.3lf seconds ago (older than the allowed %0.3lf seconds)",
-                dof[i].c_str(), (now - it->second).toSec(), age.toSec());
+                dof[i].c_str(), (now - joint_time_[i]).toSec(), age.toSec());
       missing_states.push_back(dof[i]);
       result = false;
     }
@@ -328,6 +404,32 @@ bool planning_scene_monitor::CurrentStateMonitor::waitForCurrentState(const std:
   waitForCompleteState(group, wait_time);
 }
 
+const planning_scene_monitor::CurrentStateMonitor::JointStateNameMapping&
+planning_scene_monitor::CurrentStateMonitor::getJointStateNameMapping(const sensor_msgs::JointState& joint_state)
+{
+  for (std::size_t i = 0; i < name_mappings_.size(); ++i)
+    if (name_mappings_[i].names == joint_state.name)
+      return name_mappings_[i];
+
+  // publishers that change their names all the time would make the cache grow without bounds
+  static const std::size_t MAX_NAME_MAPPINGS = 32;
+  if (name_mappings_.size() >= MAX_NAME_MAPPINGS)
+    name_mappings_.clear();
+
+  name_mappings_.resize(name_mappings_.size() + 1);
+  JointStateNameMapping& mapping = name_mappings_.back();
+  mapping.names = joint_state.name;
+  mapping.joints.resize(joint_state.name.size(), NULL);
+  for (std::size_t i = 0; i < joint_state.name.size(); ++i)
+  {
+    const robot_model::JointModel* jm = robot_model_->getJointModel(joint_state.name[i]);
+    // ignore fixed joints, multi-dof joints (they should not even be in the message)
+    if (jm && jm->getVariableCount() == 1)
+      mapping.joints[i] = jm;
+  }
+  return mapping;
+}
+
 void planning_scene_monitor::CurrentStateMonitor::jointStateCallback(const sensor_msgs::JointStateConstPtr& joint_state)
 {
   if (joint_state->name.size() != joint_state->position.size())
@@ -343,16 +445,16 @@ void planning_scene_monitor::CurrentStateMonitor::jointStateCallback(const senso
     // read the received values, and update their time stamps
     std::size_t n = joint_state->name.size();
     current_state_time_ = joint_state->header.stamp;
+    const std::vector<const robot_model::JointModel*>& joints = getJointStateNameMapping(*joint_state).joints;
     for (std::size_t i = 0; i < n; ++i)
     {
-      const robot_model::JointModel* jm = robot_model_->getJointModel(joint_state->name[i]);
+      const robot_model::JointModel* jm = joints[i];
       if (!jm)
         continue;
-      // ignore fixed joints, multi-dof joints (they should not even be in the message)
-      if (jm->getVariableCount() != 1)
-        continue;
 
-      joint_time_[joint_state->name[i]] = joint_state->header.stamp;
+      const int index = jm->getFirstVariableIndex();
+      joint_time_[index] = joint_state->header.stamp;
+      markReceived(index);
 
       if (robot_state_.getJointPositions(jm)[0] != joint_state->position[i])
       {
@@ -423,14 +525,19 @@ void planning_scene_monitor::CurrentStateMonitor::jointStateCallback(const senso
       {
         update = true;
         last_tf_update_ = tm;
-        const std::vector<std::string>& vars = robot_model_->getRootJoint()->getVariableNames();
-        for (std::size_t j = 0; j < vars.size(); ++j)
-          joint_time_[vars[j]] = tm;
+        const robot_model::JointModel* root = robot_model_->getRootJoint();
+        for (std::size_t j = 0; j < root->getVariableCount(); ++j)
+        {
+          joint_time_[root->getFirstVariableIndex() + j] = tm;
+          markReceived(root->getFirstVariableIndex() + j);
+        }
         Eigen::Affine3d eigen_transf;
         tf::transformTFToEigen(transf, eigen_transf);
         robot_state_.setJointPositions(robot_model_->getRootJoint(), eigen_transf);
       }
     }
+
+    updateSnapshot();
   }
 
   // callbacks, if needed
@@ -38,6 +38,7 @@
 #include <moveit/robot_model_loader/robot_model_loader.h>
 #include <moveit/exceptions/exceptions.h>
 #include <moveit_msgs/GetPlanningScene.h>
+#include <octomap_msgs/conversions.h>
 
 #include <dynamic_reconfigure/server.h>
 #include <moveit_ros_planning/PlanningSceneMonitorDynamicReconfigureConfig.h>
@@ -156,6 +157,9 @@ planning_scene_monitor::PlanningSceneMonitor::~PlanningSceneMonitor()
     scene_->setCollisionObjectUpdateCallback(collision_detection::World::ObserverCallbackFn());
     scene_->setAttachedBodyUpdateCallback(robot_state::AttachedBodyCallback());
   }
+  scene_update_timer_.stop();
+  if (tf_)
+    tf_->removeTransformsChangedListener(tf_changed_connection_);
   stopPublishingPlanningScene();
   stopStateMonitor();
   stopWorldGeometryMonitor();
@@ -163,6 +167,7 @@ planning_scene_monitor::PlanningSceneMonitor::~PlanningSceneMonitor()
 
   delete reconfigure_impl_;
   current_state_monitor_.reset();
+  std::atomic_store(&scene_snapshot_, planning_scene::PlanningSceneConstPtr());
   scene_const_.reset();
   scene_.reset();
   parent_scene_.reset();
@@ -175,6 +180,11 @@ void planning_scene_monitor::PlanningSceneMonitor::initialize(const planning_sce
   moveit::tools::Profiler::ScopedStart prof_start;
   moveit::tools::Profiler::ScopedBlock prof_block("PlanningSceneMonitor::initialize");
   enforce_next_state_update_ = false;
+  scene_snapshots_enabled_ = false;
+  scene_snapshot_pending_update_ = UPDATE_NONE;
+  shared_memory_reader_running_ = false;
+  publish_octomap_diffs_ = false;
+  octomap_full_publish_needed_ = true;
 
   if (monitor_name_.empty())
     monitor_name_ = "planning_scene_monitor";
@@ -243,11 +253,26 @@ void planning_scene_monitor::PlanningSceneMonitor::initialize(const planning_sce
 
   shape_transform_cache_lookup_wait_time_ = ros::Duration(temp_wait_time);
 
+  track_selected_frames_ = false;
+  frame_transforms_changed_ = true;
+  std::vector<std::string> tracked_frames;
+  if (!robot_description_.empty() && nh_.getParam(robot_description_ + "_planning/tracked_frames", tracked_frames))
+    setTrackedFrames(tracked_frames);
+  if (tf_)
+    tf_changed_connection_ =
+        tf_->addTransformsChangedListener(boost::bind(&PlanningSceneMonitor::transformsChangedCallback, this));
+
   state_update_pending_ = false;
   state_update_timer_ = nh_.createWallTimer(dt_state_update_, &PlanningSceneMonitor::stateUpdateTimerCallback, this,
                                             false,   // not a oneshot timer
                                             false);  // do not start the timer yet
 
+  pending_scene_update_ = UPDATE_NONE;
+  pending_octomap_update_ = false;
+  scene_update_timer_ = nh_.createWallTimer(ros::WallDuration(0.1), &PlanningSceneMonitor::sceneUpdateTimerCallback,
+                                            this, false,  // not a oneshot timer
+                                            false);       // started by setSceneUpdateCoalescingWindow()
+
   reconfigure_impl_ = new DynamicReconfigureImpl(this);
 }
 
@@ -260,6 +285,7 @@ void planning_scene_monitor::PlanningSceneMonitor::monitorDiffs(bool flag)
       boost::unique_lock<boost::shared_mutex> ulock(scene_update_mutex_);
       if (scene_)
       {
+        applyQueuedGeometryUpdates();
         scene_->setAttachedBodyUpdateCallback(robot_state::AttachedBodyCallback());
         scene_->setCollisionObjectUpdateCallback(collision_detection::World::ObserverCallbackFn());
         scene_->decoupleParent();
@@ -284,6 +310,7 @@ void planning_scene_monitor::PlanningSceneMonitor::monitorDiffs(bool flag)
         boost::unique_lock<boost::shared_mutex> ulock(scene_update_mutex_);
         if (scene_)
         {
+          applyQueuedGeometryUpdates();
           scene_->decoupleParent();
           parent_scene_.reset();
           // remove the '+' added by .diff() at the end of the scene name
@@ -332,12 +359,20 @@ void planning_scene_monitor::PlanningSceneMonitor::scenePublishingThread()
   // publish the full planning scene
   moveit_msgs::PlanningScene msg;
   {
+    boost::unique_lock<boost::shared_mutex> ulock(scene_update_mutex_);
     occupancy_map_monitor::OccMapTree::ReadLock lock;
+    occupancy_map_monitor::OccMapTree::WriteLock write_lock;  // octree changes are reset when sending diffs
     if (octomap_monitor_)
-      lock = octomap_monitor_->getOcTreePtr()->reading();
+    {
+      if (publish_octomap_diffs_)
+        write_lock = octomap_monitor_->getOcTreePtr()->writing();
+      else
+        lock = octomap_monitor_->getOcTreePtr()->reading();
+    }
     scene_->getPlanningSceneMsg(msg);
+    encodeOctomapDiff(msg, true);
   }
-  planning_scene_publisher_.publish(msg);
+  publishPlanningSceneMsg(msg);
   ROS_DEBUG_NAMED(LOGNAME, "Published the full planning scene: '%s'", msg.name.c_str());
 
   do
@@ -358,9 +393,16 @@ void planning_scene_monitor::PlanningSceneMonitor::scenePublishingThread()
           else
           {
             occupancy_map_monitor::OccMapTree::ReadLock lock;
+            occupancy_map_monitor::OccMapTree::WriteLock write_lock;
             if (octomap_monitor_)
-              lock = octomap_monitor_->getOcTreePtr()->reading();
+            {
+              if (publish_octomap_diffs_)
+                write_lock = octomap_monitor_->getOcTreePtr()->writing();
+              else
+                lock = octomap_monitor_->getOcTreePtr()->reading();
+            }
             scene_->getPlanningSceneDiffMsg(msg);
+            encodeOctomapDiff(msg, false);
           }
           boost::recursive_mutex::scoped_lock prevent_shape_cache_updates(shape_handles_lock_);  // we don't want the
                                                                                                  // transform cache to
@@ -383,9 +425,16 @@ void planning_scene_monitor::PlanningSceneMonitor::scenePublishingThread()
           if (is_full)
           {
             occupancy_map_monitor::OccMapTree::ReadLock lock;
+            occupancy_map_monitor::OccMapTree::WriteLock write_lock;
             if (octomap_monitor_)
-              lock = octomap_monitor_->getOcTreePtr()->reading();
+            {
+              if (publish_octomap_diffs_)
+                write_lock = octomap_monitor_->getOcTreePtr()->writing();
+              else
+                lock = octomap_monitor_->getOcTreePtr()->reading();
+            }
             scene_->getPlanningSceneMsg(msg);
+            encodeOctomapDiff(msg, true);
           }
           // also publish timestamp of this robot_state
           msg.robot_state.joint_state.header.stamp = last_robot_motion_time_;
@@ -397,7 +446,7 @@ void planning_scene_monitor::PlanningSceneMonitor::scenePublishingThread()
     if (publish_msg)
     {
       rate.reset();
-      planning_scene_publisher_.publish(msg);
+      publishPlanningSceneMsg(msg);
       if (is_full)
         ROS_DEBUG_NAMED(LOGNAME, "Published full planning scene: '%s'", msg.name.c_str());
       rate.sleep();
@@ -405,6 +454,86 @@ void planning_scene_monitor::PlanningSceneMonitor::scenePublishingThread()
   } while (publish_planning_scene_);
 }
 
+void planning_scene_monitor::PlanningSceneMonitor::publishPlanningSceneMsg(const moveit_msgs::PlanningScene& msg)
+{
+  planning_scene_publisher_.publish(msg);
+
+  boost::mutex::scoped_lock lock(shared_memory_writer_lock_);
+  if (shared_memory_writer_ && !shared_memory_writer_->write(msg))
+    ROS_WARN_THROTTLE_NAMED(10, LOGNAME, "Planning scene does not fit in shared memory segment '%s'; readers will "
+                                         "request it from the planning scene service",
+                            shared_memory_writer_->getName().c_str());
+}
+
+void planning_scene_monitor::PlanningSceneMonitor::setSharedMemoryPublishing(const std::string& segment_name)
+{
+  boost::mutex::scoped_lock lock(shared_memory_writer_lock_);
+  shared_memory_writer_.reset();
+  if (segment_name.empty())
+    return;
+  try
+  {
+    shared_memory_writer_.reset(new SharedMemorySceneWriter(segment_name));
+    ROS_INFO_NAMED(LOGNAME, "Writing published planning scenes to shared memory segment '%s'", segment_name.c_str());
+  }
+  catch (boost::interprocess::interprocess_exception& ex)
+  {
+    ROS_ERROR_NAMED(LOGNAME, "Unable to create shared memory segment '%s': %s", segment_name.c_str(), ex.what());
+  }
+}
+
+void planning_scene_monitor::PlanningSceneMonitor::setPublishOctomapDiffs(bool flag)
+{
+  boost::unique_lock<boost::shared_mutex> ulock(scene_update_mutex_);
+  publish_octomap_diffs_ = flag;
+  // the next octomap is sent in full, so that subscribers can start applying diffs
+  octomap_full_publish_needed_ = true;
+}
+
+void planning_scene_monitor::PlanningSceneMonitor::encodeOctomapDiff(moveit_msgs::PlanningScene& msg, bool is_full)
+{
+  if (!publish_octomap_diffs_ || !octomap_monitor_ || msg.world.octomap.octomap.data.empty())
+    return;
+
+  const occupancy_map_monitor::OccMapTreePtr& tree = octomap_monitor_->getOcTreePtr();
+  bool send_diff = !is_full && !octomap_full_publish_needed_ && tree->isChangeDetectionEnabled();
+
+  // only the octree maintained by the octomap monitor has its changes recorded
+  collision_detection::World::ObjectConstPtr map =
+      scene_->getWorld()->getObject(planning_scene::PlanningScene::OCTOMAP_NS);
+  if (!map || map->shapes_.size() != 1 || static_cast<const shapes::OcTree*>(map->shapes_[0].get())->octree != tree)
+    send_diff = false;
+
+  if (send_diff)
+  {
+    octomap::OcTree diff(tree->getResolution());
+    for (octomap::KeyBoolMap::const_iterator it = tree->changedKeysBegin(); it != tree->changedKeysEnd(); ++it)
+    {
+      const octomap::OcTreeNode* node = tree->search(it->first);
+      // deleted nodes cannot be expressed as changed leaves
+      if (!node)
+      {
+        send_diff = false;
+        break;
+      }
+      diff.setNodeValue(it->first, node->getLogOdds(), true);
+    }
+    if (send_diff)
+    {
+      diff.updateInnerOccupancy();
+      octomap_msgs::fullMapToMsg(diff, msg.world.octomap.octomap);
+      msg.world.octomap.octomap.id = planning_scene::PlanningScene::OCTOMAP_DIFF_ID;
+    }
+  }
+
+  // every published octomap is a new version, so subscribers can tell whether they missed a diff
+  scene_->setOctomapSequenceNumber(scene_->getOctomapSequenceNumber() + 1);
+  msg.world.octomap.header.seq = scene_->getOctomapSequenceNumber();
+  tree->enableChangeDetection(true);
+  tree->resetChangeDetection();
+  octomap_full_publish_needed_ = false;
+}
+
 void planning_scene_monitor::PlanningSceneMonitor::getMonitoredTopics(std::vector<std::string>& topics) const
 {
   topics.clear();
@@ -448,13 +577,94 @@ bool planning_scene_monitor::PlanningSceneMonitor::updatesScene(
 
 void planning_scene_monitor::PlanningSceneMonitor::triggerSceneUpdateEvent(SceneUpdateType update_type)
 {
-  // do not modify update functions while we are calling them
-  boost::recursive_mutex::scoped_lock lock(update_lock_);
+  {
+    // while coalescing, the update is reported at the end of the window
+    boost::mutex::scoped_lock lock(pending_scene_updates_mutex_);
+    if (!dt_scene_update_coalescing_.isZero())
+    {
+      pending_scene_update_ = (SceneUpdateType)((int)pending_scene_update_ | (int)update_type);
+      return;
+    }
+  }
+  fireSceneUpdateEvent(update_type);
+}
+
+void planning_scene_monitor::PlanningSceneMonitor::fireSceneUpdateEvent(SceneUpdateType update_type)
+{
+  {
+    // do not modify update functions while we are calling them
+    boost::recursive_mutex::scoped_lock lock(update_lock_);
+
+    for (std::size_t i = 0; i < update_callbacks_.size(); ++i)
+      update_callbacks_[i](update_type);
+    new_scene_update_ = (SceneUpdateType)((int)new_scene_update_ | (int)update_type);
+    new_scene_update_condition_.notify_all();
+  }
+
+  updateSceneSnapshot(update_type);
+}
+
+void planning_scene_monitor::PlanningSceneMonitor::setSceneSnapshotsEnabled(bool flag)
+{
+  boost::mutex::scoped_lock slock(scene_snapshot_mutex_);
+  scene_snapshots_enabled_ = flag;
+  std::atomic_store(&scene_snapshot_, planning_scene::PlanningSceneConstPtr());
+  snapshot_octree_.reset();
+  scene_snapshot_pending_update_ = flag ? UPDATE_SCENE : UPDATE_NONE;
+}
+
+void planning_scene_monitor::PlanningSceneMonitor::updateSceneSnapshot(SceneUpdateType update_type)
+{
+  if (scene_snapshots_enabled_ && update_type != UPDATE_NONE)
+    scene_snapshot_pending_update_.fetch_or(update_type);
+}
+
+planning_scene::PlanningSceneConstPtr planning_scene_monitor::PlanningSceneMonitor::getPlanningSceneSnapshot() const
+{
+  if (scene_snapshot_pending_update_ == UPDATE_NONE)
+    return std::atomic_load(&scene_snapshot_);
+
+  boost::mutex::scoped_lock slock(scene_snapshot_mutex_);
+  // another reader may have made the copy while we waited for the lock
+  int update_type = scene_snapshot_pending_update_.exchange(UPDATE_NONE);
+  if (update_type == UPDATE_NONE || !scene_snapshots_enabled_)
+    return std::atomic_load(&scene_snapshot_);
 
-  for (std::size_t i = 0; i < update_callbacks_.size(); ++i)
-    update_callbacks_[i](update_type);
-  new_scene_update_ = (SceneUpdateType)((int)new_scene_update_ | (int)update_type);
-  new_scene_update_condition_.notify_all();
+  planning_scene::PlanningScenePtr snapshot;
+  {
+    boost::shared_lock<boost::shared_mutex> lock(scene_update_mutex_);
+    if (!scene_)
+      return planning_scene::PlanningSceneConstPtr();
+    snapshot = planning_scene::PlanningScene::clone(scene_);
+
+    // the octree maintained by the octomap monitor keeps being updated; the snapshot gets its own copy
+    collision_detection::World::ObjectConstPtr map =
+        snapshot->getWorld()->getObject(planning_scene::PlanningScene::OCTOMAP_NS);
+    if (octomap_monitor_ && map && map->shapes_.size() == 1 &&
+        static_cast<const shapes::OcTree*>(map->shapes_[0].get())->octree == octomap_monitor_->getOcTreePtr())
+    {
+      if (!snapshot_octree_ || (update_type & UPDATE_GEOMETRY))
+      {
+        octomap_monitor_->getOcTreePtr()->lockRead();
+        try
+        {
+          snapshot_octree_.reset(new octomap::OcTree(*octomap_monitor_->getOcTreePtr()));
+          octomap_monitor_->getOcTreePtr()->unlockRead();
+        }
+        catch (...)
+        {
+          octomap_monitor_->getOcTreePtr()->unlockRead();  // unlock and rethrow
+          throw;
+        }
+      }
+      Eigen::Affine3d pose = map->shape_poses_[0];
+      map.reset();
+      snapshot->processOctomapPtr(snapshot_octree_, pose);
+    }
+  }
+  planning_scene::PlanningSceneConstPtr result(snapshot);
+  std::atomic_store(&scene_snapshot_, result);
+  return result;
 }
 
 bool planning_scene_monitor::PlanningSceneMonitor::requestPlanningSceneState(const std::string& service_name)
@@ -492,13 +702,31 @@ bool planning_scene_monitor::PlanningSceneMonitor::requestPlanningSceneState(con
 void planning_scene_monitor::PlanningSceneMonitor::newPlanningSceneCallback(
     const moveit_msgs::PlanningSceneConstPtr& scene)
 {
+  // check if an incremental octomap update was missed
+  bool octomap_gap = false;
+  if (scene->is_diff && scene->world.octomap.octomap.id == planning_scene::PlanningScene::OCTOMAP_DIFF_ID)
+  {
+    boost::shared_lock<boost::shared_mutex> slock(scene_update_mutex_);
+    octomap_gap = scene_ && !scene_->canApplyOctomapDiff(scene->world.octomap);
+  }
+
   newPlanningSceneMessage(*scene);
+
+  // the octomap can only be brought up to date by getting the full scene; do not ask more than once a second
+  if (octomap_gap && ros::WallTime::now() - last_octomap_resync_time_ > ros::WallDuration(1.0))
+  {
+    last_octomap_resync_time_ = ros::WallTime::now();
+    ROS_INFO_NAMED(LOGNAME, "Missed an octomap update; requesting the full planning scene");
+    requestPlanningSceneState();
+  }
 }
 
 void planning_scene_monitor::PlanningSceneMonitor::clearOctomap()
 {
   octomap_monitor_->getOcTreePtr()->lockWrite();
   octomap_monitor_->getOcTreePtr()->clear();
+  // clearing is not recorded by the change detection of the octree
+  octomap_full_publish_needed_ = true;
   octomap_monitor_->getOcTreePtr()->unlockWrite();
 }
 
@@ -516,6 +744,8 @@ bool planning_scene_monitor::PlanningSceneMonitor::newPlanningSceneMessage(const
     // we don't want the transform cache to update while we are potentially changing attached bodies
     boost::recursive_mutex::scoped_lock prevent_shape_cache_updates(shape_handles_lock_);
 
+    // collision objects received before this message must not be applied after it
+    applyQueuedGeometryUpdates();
     last_update_time_ = ros::Time::now();
     last_robot_motion_time_ = scene.robot_state.joint_state.header.stamp;
     ROS_DEBUG_STREAM_NAMED("planning_scene_monitor",
@@ -587,9 +817,13 @@ void planning_scene_monitor::PlanningSceneMonitor::newPlanningSceneWorldCallback
 {
   if (scene_)
   {
+    for (std::size_t i = 0; i < world->collision_objects.size(); ++i)
+      trackReferencedFrame(world->collision_objects[i].header.frame_id);
     updateFrameTransforms();
     {
       boost::unique_lock<boost::shared_mutex> ulock(scene_update_mutex_);
+      // collision objects received before this message must not be applied after it
+      applyQueuedGeometryUpdates();
       last_update_time_ = ros::Time::now();
       scene_->getWorldNonConst()->clearObjects();
       scene_->processPlanningSceneWorldMsg(*world);
@@ -620,9 +854,20 @@ void planning_scene_monitor::PlanningSceneMonitor::collisionObjectCallback(
 {
   if (scene_)
   {
+    trackReferencedFrame(obj->header.frame_id);
+    {
+      boost::mutex::scoped_lock lock(pending_scene_updates_mutex_);
+      if (!dt_scene_update_coalescing_.isZero())
+      {
+        pending_collision_objects_.push_back(obj);
+        return;
+      }
+    }
     updateFrameTransforms();
     {
       boost::unique_lock<boost::shared_mutex> ulock(scene_update_mutex_);
+      // objects queued before coalescing was turned off come first
+      applyQueuedGeometryUpdates();
       last_update_time_ = ros::Time::now();
       scene_->processCollisionObjectMsg(*obj);
     }
@@ -635,10 +880,13 @@ void planning_scene_monitor::PlanningSceneMonitor::attachObjectCallback(
 {
   if (scene_)
   {
+    trackReferencedFrame(obj->object.header.frame_id);
     updateFrameTransforms();
     {
       boost::unique_lock<boost::shared_mutex> ulock(scene_update_mutex_);
       last_update_time_ = ros::Time::now();
+      // the object may be among the queued collision objects
+      applyQueuedGeometryUpdates();
       scene_->processAttachedCollisionObjectMsg(*obj);
     }
     triggerSceneUpdateEvent(UPDATE_GEOMETRY);
@@ -927,6 +1175,9 @@ void planning_scene_monitor::PlanningSceneMonitor::unlockSceneRead()
 void planning_scene_monitor::PlanningSceneMonitor::lockSceneWrite()
 {
   scene_update_mutex_.lock();
+  // the caller's changes must come after the collision objects received so far
+  if (scene_)
+    applyQueuedGeometryUpdates();
   if (octomap_monitor_)
     octomap_monitor_->getOcTreePtr()->lockWrite();
 }
@@ -936,13 +1187,37 @@ void planning_scene_monitor::PlanningSceneMonitor::unlockSceneWrite()
   if (octomap_monitor_)
     octomap_monitor_->getOcTreePtr()->unlockWrite();
   scene_update_mutex_.unlock();
+
+  // the scene may have been modified in any way
+  updateSceneSnapshot(UPDATE_SCENE);
 }
 
-void planning_scene_monitor::PlanningSceneMonitor::startSceneMonitor(const std::string& scene_topic)
+void planning_scene_monitor::PlanningSceneMonitor::startSceneMonitor(const std::string& scene_topic,
+                                                                     const std::string& shared_memory_segment)
 {
   stopSceneMonitor();
 
   ROS_INFO_NAMED(LOGNAME, "Starting scene monitor");
+
+  // a publisher on the same host may provide the scenes through shared memory
+  if (!shared_memory_segment.empty())
+  {
+    try
+    {
+      SharedMemorySceneReaderPtr reader(new SharedMemorySceneReader(shared_memory_segment));
+      shared_memory_reader_running_ = true;
+      shared_memory_reader_thread_.reset(
+          new boost::thread(boost::bind(&PlanningSceneMonitor::sharedMemoryReaderThread, this, reader)));
+      ROS_INFO_NAMED(LOGNAME, "Reading planning scenes from shared memory segment '%s'", shared_memory_segment.c_str());
+      return;
+    }
+    catch (boost::interprocess::interprocess_exception& ex)
+    {
+      ROS_INFO_NAMED(LOGNAME, "Shared memory segment '%s' is not available (%s); using the planning scene topic",
+                     shared_memory_segment.c_str(), ex.what());
+    }
+  }
+
   // listen for planning scene updates; these messages include transforms, so no need for filters
   if (!scene_topic.empty())
   {
@@ -959,6 +1234,54 @@ void planning_scene_monitor::PlanningSceneMonitor::stopSceneMonitor()
     ROS_INFO_NAMED(LOGNAME, "Stopping scene monitor");
     planning_scene_subscriber_.shutdown();
   }
+  if (shared_memory_reader_thread_)
+  {
+    ROS_INFO_NAMED(LOGNAME, "Stopping scene monitor");
+    shared_memory_reader_running_ = false;
+    shared_memory_reader_thread_->join();
+    shared_memory_reader_thread_.reset();
+  }
+}
+
+void planning_scene_monitor::PlanningSceneMonitor::sharedMemoryReaderThread(SharedMemorySceneReaderPtr reader)
+{
+  bool resync_needed = false;
+  while (shared_memory_reader_running_)
+  {
+    // the publisher went away or crashed; wait for it to create the segment again
+    if (!reader->isWriterAlive())
+    {
+      if (!reader->reopen() || !reader->isWriterAlive())
+      {
+        ros::WallDuration(0.5).sleep();
+        continue;
+      }
+      ROS_INFO_NAMED(LOGNAME, "Reopened shared memory segment '%s'", reader->getName().c_str());
+      // the scene of the new publisher is only known once a complete scene arrives
+      resync_needed = true;
+    }
+
+    moveit_msgs::PlanningScenePtr msg(new moveit_msgs::PlanningScene());
+    bool missed = false;
+    boost::posix_time::ptime deadline =
+        boost::posix_time::microsec_clock::universal_time() + boost::posix_time::milliseconds(100);
+    if (reader->read(*msg, deadline, missed))
+    {
+      newPlanningSceneCallback(msg);
+      if (!msg->is_diff)
+        resync_needed = false;
+    }
+    resync_needed |= missed;
+
+    // diffs were missed; only the full scene brings us up to date. Do not ask more than once a second
+    if (resync_needed && ros::WallTime::now() - last_octomap_resync_time_ > ros::WallDuration(1.0))
+    {
+      last_octomap_resync_time_ = ros::WallTime::now();
+      resync_needed = false;
+      ROS_INFO_NAMED(LOGNAME, "Missed planning scene updates in shared memory; requesting the full planning scene");
+      requestPlanningSceneState();
+    }
+  }
 }
 
 bool planning_scene_monitor::PlanningSceneMonitor::getShapeTransformCache(
@@ -1196,25 +1519,116 @@ void planning_scene_monitor::PlanningSceneMonitor::octomapUpdateCallback()
   if (!octomap_monitor_)
     return;
 
+  {
+    boost::mutex::scoped_lock lock(pending_scene_updates_mutex_);
+    if (!dt_scene_update_coalescing_.isZero())
+    {
+      pending_octomap_update_ = true;
+      return;
+    }
+  }
+
   updateFrameTransforms();
   {
     boost::unique_lock<boost::shared_mutex> ulock(scene_update_mutex_);
+    applyQueuedGeometryUpdates();
     last_update_time_ = ros::Time::now();
-    octomap_monitor_->getOcTreePtr()->lockRead();
-    try
-    {
-      scene_->processOctomapPtr(octomap_monitor_->getOcTreePtr(), Eigen::Affine3d::Identity());
-      octomap_monitor_->getOcTreePtr()->unlockRead();
-    }
-    catch (...)
-    {
-      octomap_monitor_->getOcTreePtr()->unlockRead();  // unlock and rethrow
-      throw;
-    }
+    applyOctomapUpdate();
   }
   triggerSceneUpdateEvent(UPDATE_GEOMETRY);
 }
 
+void planning_scene_monitor::PlanningSceneMonitor::applyOctomapUpdate()
+{
+  octomap_monitor_->getOcTreePtr()->lockRead();
+  try
+  {
+    scene_->processOctomapPtr(octomap_monitor_->getOcTreePtr(), Eigen::Affine3d::Identity());
+    octomap_monitor_->getOcTreePtr()->unlockRead();
+  }
+  catch (...)
+  {
+    octomap_monitor_->getOcTreePtr()->unlockRead();  // unlock and rethrow
+    throw;
+  }
+}
+
+bool planning_scene_monitor::PlanningSceneMonitor::applyQueuedGeometryUpdates()
+{
+  std::vector<moveit_msgs::CollisionObjectConstPtr> objects;
+  bool octomap = false;
+  {
+    boost::mutex::scoped_lock lock(pending_scene_updates_mutex_);
+    objects.swap(pending_collision_objects_);
+    std::swap(octomap, pending_octomap_update_);
+    if (objects.empty() && !octomap)
+      return false;
+    // reported with the next update event, whichever writer applied the updates
+    pending_scene_update_ = (SceneUpdateType)((int)pending_scene_update_ | (int)UPDATE_GEOMETRY);
+  }
+
+  last_update_time_ = ros::Time::now();
+  for (std::size_t i = 0; i < objects.size(); ++i)
+    scene_->processCollisionObjectMsg(*objects[i]);
+  if (octomap && octomap_monitor_)
+    applyOctomapUpdate();
+  return true;
+}
+
+void planning_scene_monitor::PlanningSceneMonitor::processPendingSceneUpdates()
+{
+  bool geometry_queued;
+  {
+    boost::mutex::scoped_lock lock(pending_scene_updates_mutex_);
+    geometry_queued = !pending_collision_objects_.empty() || pending_octomap_update_;
+  }
+
+  if (geometry_queued && scene_)
+  {
+    updateFrameTransforms();
+    boost::unique_lock<boost::shared_mutex> ulock(scene_update_mutex_);
+    applyQueuedGeometryUpdates();
+  }
+
+  SceneUpdateType update_type;
+  {
+    boost::mutex::scoped_lock lock(pending_scene_updates_mutex_);
+    update_type = pending_scene_update_;
+    pending_scene_update_ = UPDATE_NONE;
+  }
+  if (update_type != UPDATE_NONE)
+    fireSceneUpdateEvent(update_type);
+}
+
+void planning_scene_monitor::PlanningSceneMonitor::sceneUpdateTimerCallback(const ros::WallTimerEvent& event)
+{
+  processPendingSceneUpdates();
+}
+
+void planning_scene_monitor::PlanningSceneMonitor::setSceneUpdateCoalescingWindow(double seconds)
+{
+  bool enabled = seconds > 0.0;
+
+  // stop must be called with pending_scene_updates_mutex_ unlocked to avoid deadlock
+  scene_update_timer_.stop();
+  {
+    boost::mutex::scoped_lock lock(pending_scene_updates_mutex_);
+    dt_scene_update_coalescing_ = enabled ? ros::WallDuration(seconds) : ros::WallDuration(0, 0);
+  }
+
+  if (enabled)
+  {
+    scene_update_timer_.setPeriod(dt_scene_update_coalescing_);
+    scene_update_timer_.start();
+    ROS_INFO_NAMED(LOGNAME, "Coalescing planning scene updates received within %lf seconds", seconds);
+  }
+  else
+  {
+    // report what was queued before coalescing was turned off
+    processPendingSceneUpdates();
+  }
+}
+
 void planning_scene_monitor::PlanningSceneMonitor::setStateUpdateFrequency(double hz)
 {
   bool update = false;
@@ -1255,6 +1669,7 @@ void planning_scene_monitor::PlanningSceneMonitor::updateSceneWithCurrentState()
 
     {
       boost::unique_lock<boost::shared_mutex> ulock(scene_update_mutex_);
+      applyQueuedGeometryUpdates();
       last_update_time_ = last_robot_motion_time_ = current_state_monitor_->getCurrentStateTime();
       ROS_DEBUG_STREAM_NAMED(LOGNAME, "robot state update " << fmod(last_robot_motion_time_.toSec(), 10.));
       current_state_monitor_->setToCurrentState(scene_->getCurrentStateNonConst());
@@ -1292,7 +1707,15 @@ void planning_scene_monitor::PlanningSceneMonitor::getUpdatedFrameTransforms(
   const std::string& target = getRobotModel()->getModelFrame();
 
   std::vector<std::string> all_frame_names;
-  tf_->getFrameStrings(all_frame_names);
+  bool track_selected_frames;
+  {
+    boost::mutex::scoped_lock lock(frame_transforms_mutex_);
+    track_selected_frames = track_selected_frames_;
+    if (track_selected_frames)
+      all_frame_names.assign(tracked_frames_.begin(), tracked_frames_.end());
+  }
+  if (!track_selected_frames)
+    tf_->getFrameStrings(all_frame_names);
   for (std::size_t i = 0; i < all_frame_names.size(); ++i)
   {
     const std::string& frame_no_slash = (!all_frame_names[i].empty() && all_frame_names[i][0] == '/') ?
@@ -1348,10 +1771,23 @@ void planning_scene_monitor::PlanningSceneMonitor::updateFrameTransforms()
 
   if (scene_)
   {
+    // unless tf received transforms or frames were tracked since the last lookup, its results still hold
     std::vector<geometry_msgs::TransformStamped> transforms;
-    getUpdatedFrameTransforms(transforms);
+    if (frame_transforms_changed_.exchange(false))
+    {
+      getUpdatedFrameTransforms(transforms);
+      boost::mutex::scoped_lock lock(frame_transforms_mutex_);
+      frame_transforms_ = transforms;
+    }
+    else
+    {
+      boost::mutex::scoped_lock lock(frame_transforms_mutex_);
+      transforms = frame_transforms_;
+    }
     {
       boost::unique_lock<boost::shared_mutex> ulock(scene_update_mutex_);
+      // queued objects are placed with the transforms that were current when they were received
+      applyQueuedGeometryUpdates();
       scene_->getTransformsNonConst().setTransforms(transforms);
       last_update_time_ = ros::Time::now();
     }
@@ -1359,6 +1795,48 @@ void planning_scene_monitor::PlanningSceneMonitor::updateFrameTransforms()
   }
 }
 
+void planning_scene_monitor::PlanningSceneMonitor::setTrackedFrames(const std::vector<std::string>& frames)
+{
+  {
+    boost::mutex::scoped_lock lock(frame_transforms_mutex_);
+    track_selected_frames_ = true;
+    tracked_frames_.clear();
+    for (std::size_t i = 0; i < frames.size(); ++i)
+      if (!frames[i].empty())
+        tracked_frames_.insert(frames[i]);
+  }
+  frame_transforms_changed_ = true;
+  ROS_DEBUG_NAMED(LOGNAME, "Looking up transforms for %u tracked frames only", (unsigned int)frames.size());
+}
+
+void planning_scene_monitor::PlanningSceneMonitor::addTrackedFrame(const std::string& frame)
+{
+  {
+    boost::mutex::scoped_lock lock(frame_transforms_mutex_);
+    track_selected_frames_ = true;
+    if (frame.empty() || !tracked_frames_.insert(frame).second)
+      return;
+  }
+  frame_transforms_changed_ = true;
+}
+
+void planning_scene_monitor::PlanningSceneMonitor::trackReferencedFrame(const std::string& frame)
+{
+  if (frame.empty())
+    return;
+  {
+    boost::mutex::scoped_lock lock(frame_transforms_mutex_);
+    if (!track_selected_frames_ || !tracked_frames_.insert(frame).second)
+      return;
+  }
+  frame_transforms_changed_ = true;
+}
+
+void planning_scene_monitor::PlanningSceneMonitor::transformsChangedCallback()
+{
+  frame_transforms_changed_ = true;
+}
+
 void planning_scene_monitor::PlanningSceneMonitor::publishDebugInformation(bool flag)
 {
   if (octomap_monitor_)
@@ -0,0 +1,192 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/planning_scene_monitor/shared_memory_scene_transport.h>
+#include <boost/interprocess/sync/interprocess_mutex.hpp>
+#include <boost/interprocess/sync/interprocess_condition.hpp>
+#include <boost/interprocess/sync/scoped_lock.hpp>
+#include <ros/serialization.h>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <signal.h>
+#include <unistd.h>
+
+namespace planning_scene_monitor
+{
+/** \brief The layout of the beginning of the segment; the serialized message follows it */
+struct SharedMemorySceneHeader
+{
+  boost::interprocess::interprocess_mutex mutex;
+  boost::interprocess::interprocess_condition condition;
+  uint64_t sequence;  // incremented for every message written
+  uint64_t size;      // size of the serialized message; 0 if the latest message did not fit
+  uint64_t capacity;  // number of bytes available for the message
+  int64_t writer_pid; // id of the process that created the segment
+  bool closed;        // set when the writer goes away
+
+  uint8_t* data()
+  {
+    return reinterpret_cast<uint8_t*>(this + 1);
+  }
+};
+
+typedef boost::interprocess::scoped_lock<boost::interprocess::interprocess_mutex> SegmentLock;
+
+const std::size_t SharedMemorySceneWriter::DEFAULT_CAPACITY = 64 * 1024 * 1024;
+
+SharedMemorySceneWriter::SharedMemorySceneWriter(const std::string& name, std::size_t capacity) : name_(name)
+{
+  // a segment left behind by a previous writer is replaced
+  boost::interprocess::shared_memory_object::remove(name_.c_str());
+  segment_ = boost::interprocess::shared_memory_object(boost::interprocess::create_only, name_.c_str(),
+                                                       boost::interprocess::read_write);
+  segment_.truncate(sizeof(SharedMemorySceneHeader) + capacity);
+  region_ = boost::interprocess::mapped_region(segment_, boost::interprocess::read_write);
+
+  header_ = new (region_.get_address()) SharedMemorySceneHeader();
+  header_->sequence = 0;
+  header_->size = 0;
+  header_->capacity = capacity;
+  header_->writer_pid = getpid();
+  header_->closed = false;
+}
+
+SharedMemorySceneWriter::~SharedMemorySceneWriter()
+{
+  {
+    SegmentLock lock(header_->mutex);
+    header_->closed = true;
+    header_->condition.notify_all();
+  }
+  boost::interprocess::shared_memory_object::remove(name_.c_str());
+}
+
+bool SharedMemorySceneWriter::write(const moveit_msgs::PlanningScene& msg)
+{
+  uint32_t length = ros::serialization::serializationLength(msg);
+
+  SegmentLock lock(header_->mutex);
+  ++header_->sequence;
+  bool fits = length <= header_->capacity;
+  if (fits)
+  {
+    ros::serialization::OStream stream(header_->data(), length);
+    ros::serialization::serialize(stream, msg);
+    header_->size = length;
+  }
+  else
+    header_->size = 0;
+  header_->condition.notify_all();
+  return fits;
+}
+
+SharedMemorySceneReader::SharedMemorySceneReader(const std::string& name)
+  : name_(name)
+  , segment_(boost::interprocess::open_only, name.c_str(), boost::interprocess::read_write)
+  , region_(segment_, boost::interprocess::read_write)
+  , header_(static_cast<SharedMemorySceneHeader*>(region_.get_address()))
+  , last_sequence_(0)
+{
+}
+
+bool SharedMemorySceneReader::read(moveit_msgs::PlanningScene& msg, const boost::posix_time::ptime& deadline,
+                                   bool& missed)
+{
+  missed = false;
+  {
+    // a writer that died while holding the lock does not block us past the deadline
+    SegmentLock lock(header_->mutex, deadline);
+    if (!lock.owns())
+      return false;
+    while (header_->sequence == last_sequence_ && !header_->closed)
+      if (!header_->condition.timed_wait(lock, deadline))
+        break;
+    if (header_->sequence == last_sequence_)
+      return false;
+
+    missed = header_->sequence != last_sequence_ + 1 || header_->size == 0;
+    last_sequence_ = header_->sequence;
+    if (header_->size == 0)
+      return false;
+
+    // only copy the message under the lock, so the writer is not held up by deserialization
+    buffer_.resize(header_->size);
+    memcpy(buffer_.data(), header_->data(), buffer_.size());
+  }
+
+  ros::serialization::IStream stream(buffer_.data(), buffer_.size());
+  ros::serialization::deserialize(stream, msg);
+
+  // a complete scene makes up for whatever was missed before it
+  if (!msg.is_diff)
+    missed = false;
+  return true;
+}
+
+bool SharedMemorySceneReader::isClosed() const
+{
+  SegmentLock lock(header_->mutex);
+  return header_->closed;
+}
+
+bool SharedMemorySceneReader::isWriterAlive() const
+{
+  // the pid does not change after the segment is created, so it can be read without the lock; a writer that crashed
+  // may still hold it
+  pid_t pid = header_->writer_pid;
+  if (kill(pid, 0) != 0 && errno != EPERM)
+    return false;
+  return !isClosed();
+}
+
+bool SharedMemorySceneReader::reopen()
+{
+  try
+  {
+    boost::interprocess::shared_memory_object segment(boost::interprocess::open_only, name_.c_str(),
+                                                      boost::interprocess::read_write);
+    boost::interprocess::mapped_region region(segment, boost::interprocess::read_write);
+    segment_.swap(segment);
+    region_.swap(region);
+  }
+  catch (boost::interprocess::interprocess_exception& ex)
+  {
+    return false;
+  }
+  header_ = static_cast<SharedMemorySceneHeader*>(region_.get_address());
+  last_sequence_ = 0;
+  return true;
+}
+}
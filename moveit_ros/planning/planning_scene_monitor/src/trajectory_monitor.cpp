@@ -37,6 +37,8 @@
 #include <moveit/planning_scene_monitor/trajectory_monitor.h>
 #include <moveit/trajectory_processing/trajectory_tools.h>
 #include <ros/rate.h>
+#include <ros/node_handle.h>
+#include <algorithm>
 #include <limits>
 #include <memory>
 
@@ -45,6 +47,13 @@ planning_scene_monitor::TrajectoryMonitor::TrajectoryMonitor(const CurrentStateM
   : current_state_monitor_(state_monitor)
   , sampling_frequency_(5.0)
   , trajectory_(current_state_monitor_->getRobotModel(), "")
+  , recording_group_(NULL)
+  , sample_capacity_(0)
+  , recording_stride_(0)
+  , sample_head_(0)
+  , sample_tail_(0)
+  , dropped_samples_(0)
+  , last_exported_stamp_(0.0)
 {
   setSamplingFrequency(sampling_frequency);
 }
@@ -52,6 +61,7 @@ planning_scene_monitor::TrajectoryMonitor::TrajectoryMonitor(const CurrentStateM
 planning_scene_monitor::TrajectoryMonitor::~TrajectoryMonitor()
 {
   stopTrajectoryMonitor();
+  stopStateRecording();
 }
 
 void planning_scene_monitor::TrajectoryMonitor::setSamplingFrequency(double sampling_frequency)
@@ -123,3 +133,111 @@ void planning_scene_monitor::TrajectoryMonitor::recordStates()
       state_add_callback_(state.first, state.second);
   }
 }
+
+void planning_scene_monitor::TrajectoryMonitor::startStateRecording(const robot_model::JointModelGroup* group,
+                                                                   std::size_t capacity)
+{
+  stopStateRecording();
+  if (!group || !current_state_monitor_ || capacity == 0)
+  {
+    ROS_ERROR("State recording needs a joint model group and a positive capacity");
+    return;
+  }
+
+  boost::mutex::scoped_lock slock(consumer_lock_);
+  recording_group_ = group;
+  recording_stride_ = 1 + group->getVariableCount();
+  sample_capacity_ = capacity;
+  samples_.assign(sample_capacity_ * recording_stride_, 0.0);
+  sample_head_ = 0;
+  sample_tail_ = 0;
+  dropped_samples_ = 0;
+  last_exported_stamp_ = 0.0;
+
+  recording_values_.resize(group->getVariableCount());
+  current_state_monitor_->getCurrentState()->copyJointGroupPositions(group, recording_values_);
+  message_names_.clear();
+  message_to_group_.clear();
+
+  std::string topic = current_state_monitor_->getMonitoredTopic();
+  if (topic.empty())
+    topic = "joint_states";
+  ros::NodeHandle nh;
+  joint_state_subscriber_ = nh.subscribe(topic, 100, &TrajectoryMonitor::jointStateCallback, this);
+  ROS_DEBUG("Recording states of group '%s' from '%s'", group->getName().c_str(), topic.c_str());
+}
+
+void planning_scene_monitor::TrajectoryMonitor::stopStateRecording()
+{
+  // once shutdown() returns, the callback is not running anymore
+  if (joint_state_subscriber_)
+  {
+    joint_state_subscriber_.shutdown();
+    ROS_DEBUG("Stopped recording states");
+  }
+}
+
+void planning_scene_monitor::TrajectoryMonitor::jointStateCallback(const sensor_msgs::JointStateConstPtr& joint_state)
+{
+  // the names rarely change between messages, so the mapping to the group variables is only rebuilt when they do
+  if (joint_state->name != message_names_)
+  {
+    message_names_ = joint_state->name;
+    message_to_group_.resize(message_names_.size());
+    const std::vector<std::string>& variables = recording_group_->getVariableNames();
+    for (std::size_t i = 0; i < message_names_.size(); ++i)
+    {
+      std::vector<std::string>::const_iterator it = std::find(variables.begin(), variables.end(), message_names_[i]);
+      message_to_group_[i] = it == variables.end() ? -1 : it - variables.begin();
+    }
+  }
+
+  bool changed = false;
+  for (std::size_t i = 0, end = std::min(message_to_group_.size(), joint_state->position.size()); i < end; ++i)
+    if (message_to_group_[i] >= 0)
+    {
+      recording_values_[message_to_group_[i]] = joint_state->position[i];
+      changed = true;
+    }
+  if (!changed)
+    return;
+
+  const std::size_t head = sample_head_.load(std::memory_order_relaxed);
+  if (head - sample_tail_.load(std::memory_order_acquire) >= sample_capacity_)
+  {
+    ++dropped_samples_;
+    return;
+  }
+  double* sample = &samples_[(head % sample_capacity_) * recording_stride_];
+  sample[0] = joint_state->header.stamp.isZero() ? ros::Time::now().toSec() : joint_state->header.stamp.toSec();
+  std::copy(recording_values_.begin(), recording_values_.end(), sample + 1);
+  sample_head_.store(head + 1, std::memory_order_release);
+}
+
+std::size_t
+planning_scene_monitor::TrajectoryMonitor::getRecordedTrajectory(robot_trajectory::RobotTrajectory& trajectory)
+{
+  boost::mutex::scoped_lock slock(consumer_lock_);
+  const std::size_t tail = sample_tail_.load(std::memory_order_relaxed);
+  const std::size_t head = sample_head_.load(std::memory_order_acquire);
+  if (head == tail)
+    return 0;
+
+  if (trajectory.empty())
+  {
+    trajectory.setGroupName(recording_group_->getName());
+    last_exported_stamp_ = samples_[(tail % sample_capacity_) * recording_stride_];
+  }
+
+  const robot_state::RobotStatePtr reference = current_state_monitor_->getCurrentState();
+  for (std::size_t i = tail; i != head; ++i)
+  {
+    const double* sample = &samples_[(i % sample_capacity_) * recording_stride_];
+    robot_state::RobotStatePtr state(new robot_state::RobotState(*reference));
+    state->setJointGroupPositions(recording_group_, sample + 1);
+    trajectory.addSuffixWayPoint(state, std::max(0.0, sample[0] - last_exported_stamp_));
+    last_exported_stamp_ = sample[0];
+  }
+  sample_tail_.store(head, std::memory_order_release);
+  return head - tail;
+}
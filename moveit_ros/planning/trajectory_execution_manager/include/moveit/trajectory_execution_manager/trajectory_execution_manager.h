@@ -240,6 +240,11 @@ public:
   /// Set joint-value tolerance for validating trajectory's start point against current robot state
   void setAllowedStartTolerance(double tolerance);
 
+  /// Enable or disable pipelined execution. When enabled, each pushed trajectory is sent to the controllers while the
+  /// previous one executes, stamped to start when the previous one ends, so the robot does not stop between them.
+  /// Each trajectory is validated against the end of the previous one instead of the current robot state
+  void enablePipelinedExecution(bool flag);
+
 private:
   struct ControllerInformation
   {
@@ -257,16 +262,35 @@ private:
     }
   };
 
+  /// Controller states refreshed in the background
+  struct ControllerStates
+  {
+    ros::Time stamp_;
+    std::map<std::string, moveit_controller_manager::MoveItControllerManager::ControllerState> states_;
+  };
+  typedef std::shared_ptr<const ControllerStates> ControllerStatesConstPtr;
+
+  /// Actuated joints and available controllers of a controller selection
+  typedef std::pair<std::set<std::string>, std::vector<std::string> > ControllerCombinationKey;
+
   void initialize();
 
   void reloadControllerInformation();
 
   /// Validate first point of trajectory matches current robot state
   bool validate(const TrajectoryExecutionContext& context) const;
+  /// Validate first point of trajectory matches the last point of the previous trajectory
+  bool validate(const TrajectoryExecutionContext& context, const TrajectoryExecutionContext& previous) const;
+  bool validate(const TrajectoryExecutionContext& context, const robot_state::RobotState& reference_state,
+                const std::string& reference_name) const;
   bool configure(TrajectoryExecutionContext& context, const moveit_msgs::RobotTrajectory& trajectory,
                  const std::vector<std::string>& controllers);
 
   void updateControllersState(const ros::Duration& age);
+  /// Periodically query the states of all controllers, so updateControllerState() does not have to
+  void controllerStateRefreshThread();
+  /// Discard the refreshed controller states and refresh them right away, e.g. after switching controllers
+  void invalidateControllerStates();
   void updateControllerState(const std::string& controller, const ros::Duration& age);
   void updateControllerState(ControllerInformation& ci, const ros::Duration& age);
 
@@ -276,12 +300,11 @@ private:
   bool findControllers(const std::set<std::string>& actuated_joints, std::size_t controller_count,
                        const std::vector<std::string>& available_controllers,
                        std::vector<std::string>& selected_controllers);
-  bool checkControllerCombination(std::vector<std::string>& controllers, const std::set<std::string>& actuated_joints);
-  void generateControllerCombination(std::size_t start_index, std::size_t controller_count,
-                                     const std::vector<std::string>& available_controllers,
-                                     std::vector<std::string>& selected_controllers,
-                                     std::vector<std::vector<std::string> >& selected_options,
-                                     const std::set<std::string>& actuated_joints);
+  /// Find the combinations of \e controller_count controllers among \e available_controllers that operate on
+  /// disjoint sets of joints and together cover \e actuated_joints. The result is cached for identical queries
+  void generateControllerCombinations(const std::set<std::string>& actuated_joints, std::size_t controller_count,
+                                      const std::vector<std::string>& available_controllers,
+                                      std::vector<std::vector<std::string> >& selected_options);
   bool selectControllers(const std::set<std::string>& actuated_joints,
                          const std::vector<std::string>& available_controllers,
                          std::vector<std::string>& selected_controllers);
@@ -289,6 +312,24 @@ private:
   void executeThread(const ExecutionCompleteCallback& callback, const PathSegmentCompleteCallback& part_callback,
                      bool auto_clear);
   bool executePart(std::size_t part_index);
+  /// Send the trajectory to its controllers, whose handles are returned in \e handles
+  bool sendPart(const TrajectoryExecutionContext& context,
+                std::vector<moveit_controller_manager::MoveItControllerHandlePtr>& handles);
+  /// Wait for the trajectory sent to \e handles to complete. The goals of \e next_handles were replaced by the next
+  /// trajectory, so these are not waited for; this trajectory completes at \e end_time instead
+  bool waitForPart(std::size_t part_index, const TrajectoryExecutionContext& context,
+                   const std::vector<moveit_controller_manager::MoveItControllerHandlePtr>& handles,
+                   const std::vector<moveit_controller_manager::MoveItControllerHandlePtr>& next_handles,
+                   const ros::Time& end_time);
+  /// Wait until \e handle completes its execution, until \e deadline (if not zero) or until execution is stopped.
+  /// Return false if the deadline was reached first
+  bool waitForHandle(const moveit_controller_manager::MoveItControllerHandlePtr& handle, const ros::Time& deadline);
+  /// Wait until \e time or until execution is stopped. Return false if execution was stopped
+  bool waitUntil(const ros::Time& time);
+  /// Called by the controller handles that report completed executions
+  void handleExecutionComplete(moveit_controller_manager::MoveItControllerHandle* handle);
+  /// Execute the trajectories with pipelining and return the number of trajectories started
+  std::size_t executePipelined(const PathSegmentCompleteCallback& part_callback);
   bool waitForRobotToStop(const TrajectoryExecutionContext& context, double wait_time = 1.0);
   void continuousExecutionThread();
 
@@ -303,6 +344,11 @@ private:
   ros::Subscriber event_topic_subscriber_;
 
   std::map<std::string, ControllerInformation> known_controllers_;
+
+  // controller combinations found by generateControllerCombinations(), by query and number of controllers
+  std::map<ControllerCombinationKey, std::map<std::size_t, std::vector<std::vector<std::string> > > >
+      controller_combinations_;
+  boost::mutex controller_combinations_mutex_;
   bool manage_controllers_;
 
   // thread used to execute trajectories using the execute() command
@@ -321,6 +367,12 @@ private:
 
   moveit_controller_manager::ExecutionStatus last_execution_status_;
   std::vector<moveit_controller_manager::MoveItControllerHandlePtr> active_handles_;
+
+  // whether the execution sent to each handle that reports completions has completed; the executing thread waits on
+  // the condition for all of them, and for stop requests, instead of blocking in each handle in turn
+  std::map<const moveit_controller_manager::MoveItControllerHandle*, bool> handle_execution_complete_;
+  boost::mutex handle_event_mutex_;
+  boost::condition_variable handle_event_condition_;
   int current_context_;
   std::vector<ros::Time> time_index_;
   mutable boost::mutex time_index_mutex_;
@@ -345,6 +397,16 @@ private:
   double allowed_goal_duration_margin_;
   double allowed_start_tolerance_;  // joint tolerance for validate(): radians for revolute joints
   double execution_velocity_scaling_;
+  bool pipeline_execution_;
+
+  // thread refreshing controller_states_; they are read without locking, by atomic access to the pointer
+  std::unique_ptr<boost::thread> controller_state_refresh_thread_;
+  boost::mutex controller_state_refresh_mutex_;
+  boost::condition_variable controller_state_refresh_condition_;
+  bool run_controller_state_refresh_thread_;
+  unsigned int controller_states_generation_;  // incremented when the refreshed states are invalidated
+  double controller_state_refresh_period_;
+  ControllerStatesConstPtr controller_states_;
 };
 }
 
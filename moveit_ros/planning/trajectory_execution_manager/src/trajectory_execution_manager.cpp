@@ -36,14 +36,20 @@
 
 #include <moveit/trajectory_execution_manager/trajectory_execution_manager.h>
 #include <moveit/robot_state/robot_state.h>
+#include <moveit/profiler/tracer.h>
 #include <moveit_ros_planning/TrajectoryExecutionDynamicReconfigureConfig.h>
 #include <dynamic_reconfigure/server.h>
+#include <algorithm>
+#include <cstdint>
 
 namespace trajectory_execution_manager
 {
 const std::string TrajectoryExecutionManager::EXECUTION_EVENT_TOPIC = "trajectory_execution_event";
 
 static const ros::Duration DEFAULT_CONTROLLER_INFORMATION_VALIDITY_AGE(1.0);
+static const double DEFAULT_CONTROLLER_STATE_REFRESH_PERIOD = 0.5;  // refresh controller states in the background
+                                                                    // faster than they expire, so push() does not
+                                                                    // query them
 static const double DEFAULT_CONTROLLER_GOAL_DURATION_MARGIN = 0.5;  // allow 0.5s more than the expected execution time
                                                                     // before triggering a trajectory cancel (applied
                                                                     // after scaling)
@@ -52,6 +58,35 @@ static const double DEFAULT_CONTROLLER_GOAL_DURATION_SCALING =
 
 using namespace moveit_ros_planning;
 
+namespace
+{
+// the time the last point of the trajectory is reached, if it starts at start_time or at its stamp if that is later
+ros::Time getEndTime(const TrajectoryExecutionManager::TrajectoryExecutionContext& context, const ros::Time& start_time)
+{
+  ros::Time end_time = start_time;
+  for (const auto& trajectory : context.trajectory_parts_)
+  {
+    if (!trajectory.joint_trajectory.points.empty())
+      end_time = std::max(end_time, std::max(start_time, trajectory.joint_trajectory.header.stamp) +
+                                        trajectory.joint_trajectory.points.back().time_from_start);
+    if (!trajectory.multi_dof_joint_trajectory.points.empty())
+      end_time = std::max(end_time, std::max(start_time, trajectory.multi_dof_joint_trajectory.header.stamp) +
+                                        trajectory.multi_dof_joint_trajectory.points.back().time_from_start);
+  }
+  return end_time;
+}
+
+// make the controllers start the trajectory at start_time, replacing what they execute from then on
+void setStartTime(TrajectoryExecutionManager::TrajectoryExecutionContext& context, const ros::Time& start_time)
+{
+  for (auto& trajectory : context.trajectory_parts_)
+  {
+    trajectory.joint_trajectory.header.stamp = start_time;
+    trajectory.multi_dof_joint_trajectory.header.stamp = start_time;
+  }
+}
+}
+
 class TrajectoryExecutionManager::DynamicReconfigureImpl
 {
 public:
@@ -70,6 +105,7 @@ private:
     owner_->setAllowedGoalDurationMargin(config.allowed_goal_duration_margin);
     owner_->setExecutionVelocityScaling(config.execution_velocity_scaling);
     owner_->setAllowedStartTolerance(config.allowed_start_tolerance);
+    owner_->enablePipelinedExecution(config.pipeline_execution);
   }
 
   TrajectoryExecutionManager* owner_;
@@ -98,6 +134,17 @@ TrajectoryExecutionManager::~TrajectoryExecutionManager()
 {
   run_continuous_execution_thread_ = false;
   stopExecution(true);
+  // handles sent a trajectory ahead may still report to this manager, and they can outlive it
+  for (std::size_t i = 0; i < active_handles_.size(); ++i)
+    active_handles_[i]->setExecutionCompleteCallback(
+        moveit_controller_manager::MoveItControllerHandle::ExecutionCompleteCallback());
+  {
+    boost::mutex::scoped_lock slock(controller_state_refresh_mutex_);
+    run_controller_state_refresh_thread_ = false;
+    controller_state_refresh_condition_.notify_all();
+  }
+  if (controller_state_refresh_thread_)
+    controller_state_refresh_thread_->join();
   delete reconfigure_impl_;
 }
 
@@ -116,6 +163,11 @@ void TrajectoryExecutionManager::initialize()
   execution_duration_monitoring_ = true;
   execution_velocity_scaling_ = 1.0;
   allowed_start_tolerance_ = 0.01;
+  pipeline_execution_ = false;
+  run_controller_state_refresh_thread_ = true;
+  controller_states_generation_ = 0;
+  node_handle_.param("trajectory_execution/controller_state_refresh_period", controller_state_refresh_period_,
+                     DEFAULT_CONTROLLER_STATE_REFRESH_PERIOD);
 
   // TODO: Reading from old param location should be removed in L-turtle. Handled by DynamicReconfigure.
   if (node_handle_.getParam("allowed_execution_duration_scaling", allowed_execution_duration_scaling_))
@@ -175,6 +227,10 @@ void TrajectoryExecutionManager::initialize()
   // other configuration steps
   reloadControllerInformation();
 
+  if (controller_manager_ && controller_state_refresh_period_ > 0.0)
+    controller_state_refresh_thread_.reset(
+        new boost::thread(&TrajectoryExecutionManager::controllerStateRefreshThread, this));
+
   event_topic_subscriber_ =
       root_node_handle_.subscribe(EXECUTION_EVENT_TOPIC, 100, &TrajectoryExecutionManager::receiveEvent, this);
 
@@ -211,6 +267,11 @@ void TrajectoryExecutionManager::setAllowedStartTolerance(double tolerance)
   allowed_start_tolerance_ = tolerance;
 }
 
+void TrajectoryExecutionManager::enablePipelinedExecution(bool flag)
+{
+  pipeline_execution_ = flag;
+}
+
 bool TrajectoryExecutionManager::isManagingControllers() const
 {
   return manage_controllers_;
@@ -514,7 +575,12 @@ void TrajectoryExecutionManager::continuousExecutionThread()
 
 void TrajectoryExecutionManager::reloadControllerInformation()
 {
+  invalidateControllerStates();
   known_controllers_.clear();
+  {
+    boost::mutex::scoped_lock slock(controller_combinations_mutex_);
+    controller_combinations_.clear();
+  }
   if (controller_manager_)
   {
     std::vector<std::string> names;
@@ -556,10 +622,69 @@ void TrajectoryExecutionManager::updateControllerState(const std::string& contro
     ROS_ERROR_NAMED("traj_execution", "Controller '%s' is not known.", controller.c_str());
 }
 
+void TrajectoryExecutionManager::controllerStateRefreshThread()
+{
+  boost::unique_lock<boost::mutex> ulock(controller_state_refresh_mutex_);
+  while (run_controller_state_refresh_thread_)
+  {
+    // the controller manager is queried without the lock, so invalidateControllerStates() does not wait for it
+    const unsigned int generation = controller_states_generation_;
+    ulock.unlock();
+    std::shared_ptr<ControllerStates> states(new ControllerStates());
+    states->stamp_ = ros::Time::now();
+    try
+    {
+      std::vector<std::string> names;
+      controller_manager_->getControllersList(names);
+      for (std::size_t i = 0; i < names.size(); ++i)
+        states->states_[names[i]] = controller_manager_->getControllerState(names[i]);
+    }
+    catch (std::exception& ex)
+    {
+      ROS_ERROR_NAMED("traj_execution", "Caught %s when refreshing controller states", ex.what());
+      states.reset();
+    }
+    ulock.lock();
+
+    // states queried while controllers were switched may be outdated already; these are queried again right away
+    if (generation != controller_states_generation_)
+      continue;
+    if (states)
+      std::atomic_store(&controller_states_, ControllerStatesConstPtr(states));
+    if (run_controller_state_refresh_thread_)
+      controller_state_refresh_condition_.timed_wait(
+          ulock, boost::posix_time::microseconds((long)(controller_state_refresh_period_ * 1e6)));
+  }
+}
+
+void TrajectoryExecutionManager::invalidateControllerStates()
+{
+  boost::mutex::scoped_lock slock(controller_state_refresh_mutex_);
+  ++controller_states_generation_;
+  std::atomic_store(&controller_states_, ControllerStatesConstPtr());
+  controller_state_refresh_condition_.notify_all();
+}
+
 void TrajectoryExecutionManager::updateControllerState(ControllerInformation& ci, const ros::Duration& age)
 {
   if (ros::Time::now() - ci.last_update_ >= age)
   {
+    // use the states refreshed in the background, if these are recent enough
+    ControllerStatesConstPtr states = std::atomic_load(&controller_states_);
+    if (states && ros::Time::now() - states->stamp_ < age)
+    {
+      std::map<std::string, moveit_controller_manager::MoveItControllerManager::ControllerState>::const_iterator it =
+          states->states_.find(ci.name_);
+      if (it != states->states_.end())
+      {
+        if (verbose_)
+          ROS_INFO_NAMED("traj_execution", "Using refreshed information for controller '%s'.", ci.name_.c_str());
+        ci.state_ = it->second;
+        ci.last_update_ = states->stamp_;
+        return;
+      }
+    }
+
     if (controller_manager_)
     {
       if (verbose_)
@@ -579,61 +704,130 @@ void TrajectoryExecutionManager::updateControllersState(const ros::Duration& age
     updateControllerState(it->second, age);
 }
 
-bool TrajectoryExecutionManager::checkControllerCombination(std::vector<std::string>& selected,
-                                                            const std::set<std::string>& actuated_joints)
+namespace
+{
+// a set of indices, as the bits of consecutive words
+typedef std::vector<std::uint64_t> Bitmask;
+
+void setBit(Bitmask& mask, std::size_t index)
+{
+  mask[index / 64] |= std::uint64_t(1) << (index % 64);
+}
+
+bool intersects(const Bitmask& a, const Bitmask& b)
+{
+  for (std::size_t w = 0; w < a.size(); ++w)
+    if (a[w] & b[w])
+      return true;
+  return false;
+}
+
+// Enumerates the combinations of controllers that operate on disjoint sets of joints and together cover all
+// actuated joints. Controllers are identified by their index among the available ones.
+struct ControllerCombinationSearch
 {
-  std::set<std::string> combined_joints;
-  for (std::size_t i = 0; i < selected.size(); ++i)
+  ControllerCombinationSearch(std::size_t controller_count, std::size_t joint_count, std::size_t available_count)
+    : controller_count_(controller_count)
+    , joints_(available_count, Bitmask((joint_count + 63) / 64, 0))
+    , overlaps_(available_count, Bitmask((available_count + 63) / 64, 0))
+    , all_joints_((joint_count + 63) / 64, 0)
+    , covered_(controller_count + 1, all_joints_)
+    , chosen_(controller_count + 1, Bitmask((available_count + 63) / 64, 0))
   {
-    const ControllerInformation& ci = known_controllers_[selected[i]];
-    combined_joints.insert(ci.joints_.begin(), ci.joints_.end());
+    for (std::size_t j = 0; j < joint_count; ++j)
+      setBit(all_joints_, j);
   }
 
-  if (verbose_)
+  void generate(std::size_t start_index)
   {
-    std::stringstream ss, saj, sac;
-    for (std::size_t i = 0; i < selected.size(); ++i)
-      ss << selected[i] << " ";
-    for (std::set<std::string>::const_iterator it = actuated_joints.begin(); it != actuated_joints.end(); ++it)
-      saj << *it << " ";
-    for (std::set<std::string>::const_iterator it = combined_joints.begin(); it != combined_joints.end(); ++it)
-      sac << *it << " ";
-    ROS_INFO_NAMED("traj_execution", "Checking if controllers [ %s] operating on joints [ %s] cover joints [ %s]",
-                   ss.str().c_str(), sac.str().c_str(), saj.str().c_str());
+    const std::size_t depth = selected_.size();
+    if (depth == controller_count_)
+    {
+      if (covered_[depth] == all_joints_)
+        options_.push_back(selected_);
+      return;
+    }
+
+    // stop when too few controllers are left to complete the combination
+    for (std::size_t i = start_index; i + controller_count_ - depth <= joints_.size(); ++i)
+    {
+      if (intersects(overlaps_[i], chosen_[depth]))
+        continue;
+      for (std::size_t w = 0; w < all_joints_.size(); ++w)
+        covered_[depth + 1][w] = covered_[depth][w] | joints_[i][w];
+      chosen_[depth + 1] = chosen_[depth];
+      setBit(chosen_[depth + 1], i);
+      selected_.push_back(i);
+      generate(i + 1);
+      selected_.pop_back();
+    }
   }
 
-  return std::includes(combined_joints.begin(), combined_joints.end(), actuated_joints.begin(), actuated_joints.end());
+  std::size_t controller_count_;
+  std::vector<Bitmask> joints_;    // for each available controller, the actuated joints it operates on
+  std::vector<Bitmask> overlaps_;  // for each available controller, the available controllers sharing joints with it
+  Bitmask all_joints_;
+
+  // the joints covered and the controllers chosen at each depth of the search
+  std::vector<Bitmask> covered_;
+  std::vector<Bitmask> chosen_;
+  std::vector<std::size_t> selected_;
+  std::vector<std::vector<std::size_t> > options_;
+};
 }
 
-void TrajectoryExecutionManager::generateControllerCombination(std::size_t start_index, std::size_t controller_count,
-                                                               const std::vector<std::string>& available_controllers,
-                                                               std::vector<std::string>& selected_controllers,
-                                                               std::vector<std::vector<std::string> >& selected_options,
-                                                               const std::set<std::string>& actuated_joints)
+void TrajectoryExecutionManager::generateControllerCombinations(
+    const std::set<std::string>& actuated_joints, std::size_t controller_count,
+    const std::vector<std::string>& available_controllers, std::vector<std::vector<std::string> >& selected_options)
 {
-  if (selected_controllers.size() == controller_count)
+  // the combinations only depend on the joints of the controllers, so these are computed once for each query
+  const ControllerCombinationKey key(actuated_joints, available_controllers);
   {
-    if (checkControllerCombination(selected_controllers, actuated_joints))
-      selected_options.push_back(selected_controllers);
-    return;
+    boost::mutex::scoped_lock slock(controller_combinations_mutex_);
+    std::map<ControllerCombinationKey, std::map<std::size_t, std::vector<std::vector<std::string> > > >::const_iterator
+        it = controller_combinations_.find(key);
+    if (it != controller_combinations_.end())
+    {
+      std::map<std::size_t, std::vector<std::vector<std::string> > >::const_iterator jt =
+          it->second.find(controller_count);
+      if (jt != it->second.end())
+      {
+        selected_options = jt->second;
+        return;
+      }
+    }
   }
 
-  for (std::size_t i = start_index; i < available_controllers.size(); ++i)
+  std::map<std::string, std::size_t> joint_index;
+  for (std::set<std::string>::const_iterator it = actuated_joints.begin(); it != actuated_joints.end(); ++it)
+    joint_index.insert(std::make_pair(*it, joint_index.size()));
+
+  ControllerCombinationSearch search(controller_count, actuated_joints.size(), available_controllers.size());
+  for (std::size_t i = 0; i < available_controllers.size(); ++i)
   {
-    bool overlap = false;
     const ControllerInformation& ci = known_controllers_[available_controllers[i]];
-    for (std::size_t j = 0; j < selected_controllers.size() && !overlap; ++j)
+    for (std::set<std::string>::const_iterator it = ci.joints_.begin(); it != ci.joints_.end(); ++it)
     {
-      if (ci.overlapping_controllers_.find(selected_controllers[j]) != ci.overlapping_controllers_.end())
-        overlap = true;
+      std::map<std::string, std::size_t>::const_iterator jt = joint_index.find(*it);
+      if (jt != joint_index.end())
+        setBit(search.joints_[i], jt->second);
     }
-    if (overlap)
-      continue;
-    selected_controllers.push_back(available_controllers[i]);
-    generateControllerCombination(i + 1, controller_count, available_controllers, selected_controllers,
-                                  selected_options, actuated_joints);
-    selected_controllers.pop_back();
+    for (std::size_t k = 0; k < available_controllers.size(); ++k)
+      if (ci.overlapping_controllers_.find(available_controllers[k]) != ci.overlapping_controllers_.end())
+        setBit(search.overlaps_[i], k);
+  }
+  search.generate(0);
+
+  selected_options.resize(search.options_.size());
+  for (std::size_t i = 0; i < search.options_.size(); ++i)
+  {
+    selected_options[i].resize(search.options_[i].size());
+    for (std::size_t k = 0; k < search.options_[i].size(); ++k)
+      selected_options[i][k] = available_controllers[search.options_[i][k]];
   }
+
+  boost::mutex::scoped_lock slock(controller_combinations_mutex_);
+  controller_combinations_[key][controller_count] = selected_options;
 }
 
 namespace
@@ -676,11 +870,9 @@ bool TrajectoryExecutionManager::findControllers(const std::set<std::string>& ac
                                                  std::vector<std::string>& selected_controllers)
 {
   // generate all combinations of controller_count controllers that operate on disjoint sets of joints
-  std::vector<std::string> work_area;
   OrderPotentialControllerCombination order;
   std::vector<std::vector<std::string> >& selected_options = order.selected_options;
-  generateControllerCombination(0, controller_count, available_controllers, work_area, selected_options,
-                                actuated_joints);
+  generateControllerCombinations(actuated_joints, controller_count, available_controllers, selected_options);
 
   if (verbose_)
   {
@@ -923,7 +1115,36 @@ bool TrajectoryExecutionManager::validate(const TrajectoryExecutionContext& cont
                                      "1s");
     return false;
   }
+  return validate(context, *current_state, "current robot state");
+}
+
+bool TrajectoryExecutionManager::validate(const TrajectoryExecutionContext& context,
+                                          const TrajectoryExecutionContext& previous) const
+{
+  if (allowed_start_tolerance_ == 0)  // skip validation on this magic number
+    return true;
+
+  ROS_DEBUG_NAMED("traj_execution", "Validating trajectory against the end of the previous one");
+
+  // the joints the previous trajectory does not move stay at their current position
+  robot_state::RobotStatePtr current_state = csm_->getCurrentState();
+  if (!current_state)
+  {
+    ROS_WARN_NAMED("traj_execution", "Failed to validate trajectory: no current joint state");
+    return false;
+  }
+  for (const auto& trajectory : previous.trajectory_parts_)
+    if (!trajectory.joint_trajectory.points.empty() &&
+        trajectory.joint_trajectory.points.back().positions.size() == trajectory.joint_trajectory.joint_names.size())
+      current_state->setVariablePositions(trajectory.joint_trajectory.joint_names,
+                                          trajectory.joint_trajectory.points.back().positions);
+  return validate(context, *current_state, "final state of the previous trajectory");
+}
 
+bool TrajectoryExecutionManager::validate(const TrajectoryExecutionContext& context,
+                                          const robot_state::RobotState& reference_state,
+                                          const std::string& reference_name) const
+{
   for (const auto& trajectory : context.trajectory_parts_)
   {
     const std::vector<double>& positions = trajectory.joint_trajectory.points.front().positions;
@@ -937,7 +1158,7 @@ bool TrajectoryExecutionManager::validate(const TrajectoryExecutionContext& cont
 
     for (std::size_t i = 0; i < n; ++i)
     {
-      const robot_model::JointModel* jm = current_state->getJointModel(joint_names[i]);
+      const robot_model::JointModel* jm = reference_state.getJointModel(joint_names[i]);
       if (!jm)
       {
         ROS_ERROR_STREAM_NAMED("traj_execution", "Unknown joint in trajectory: " << joint_names[i]);
@@ -945,7 +1166,7 @@ bool TrajectoryExecutionManager::validate(const TrajectoryExecutionContext& cont
       }
 
       // TODO: check multi-DoF joints ?
-      double cur_position = current_state->getJointPositions(jm)[0];
+      double cur_position = reference_state.getJointPositions(jm)[0];
       double traj_position = positions[i];
       // normalize positions and compare
       jm->enforcePositionBounds(&cur_position);
@@ -953,9 +1174,10 @@ bool TrajectoryExecutionManager::validate(const TrajectoryExecutionContext& cont
       if (fabs(cur_position - traj_position) > allowed_start_tolerance_)
       {
         ROS_ERROR_NAMED("traj_execution",
-                        "\nInvalid Trajectory: start point deviates from current robot state more than %g"
+                        "\nInvalid Trajectory: start point deviates from %s more than %g"
                         "\njoint '%s': expected: %g, current: %g",
-                        allowed_start_tolerance_, joint_names[i].c_str(), traj_position, cur_position);
+                        reference_name.c_str(), allowed_start_tolerance_, joint_names[i].c_str(), traj_position,
+                        cur_position);
         return false;
       }
     }
@@ -1077,6 +1299,10 @@ void TrajectoryExecutionManager::stopExecutionInternal()
     {
       ROS_ERROR_NAMED("traj_execution", "Caught %s when canceling execution.", ex.what());
     }
+
+  // wake up the executing thread, also when it waits for handles that do not report the cancellation
+  boost::mutex::scoped_lock slock(handle_event_mutex_);
+  handle_event_condition_.notify_all();
 }
 
 void TrajectoryExecutionManager::stopExecution(bool auto_clear)
@@ -1202,17 +1428,20 @@ void TrajectoryExecutionManager::executeThread(const ExecutionCompleteCallback&
   // execute each trajectory, one after the other (executePart() is blocking) or until one fails.
   // on failure, the status is set by executePart(). Otherwise, it will remain as set above (success)
   std::size_t i = 0;
-  for (; i < trajectories_.size(); ++i)
-  {
-    bool epart = executePart(i);
-    if (epart && part_callback)
-      part_callback(i);
-    if (!epart || execution_complete_)
+  if (pipeline_execution_)
+    i = executePipelined(part_callback);
+  else
+    for (; i < trajectories_.size(); ++i)
     {
-      ++i;
-      break;
+      bool epart = executePart(i);
+      if (epart && part_callback)
+        part_callback(i);
+      if (!epart || execution_complete_)
+      {
+        ++i;
+        break;
+      }
     }
-  }
 
   // only report that execution finished when the robot stopped moving
   waitForRobotToStop(*trajectories_[i - 1]);
@@ -1235,210 +1464,381 @@ void TrajectoryExecutionManager::executeThread(const ExecutionCompleteCallback&
     callback(last_execution_status_);
 }
 
-bool TrajectoryExecutionManager::executePart(std::size_t part_index)
+bool TrajectoryExecutionManager::sendPart(const TrajectoryExecutionContext& context,
+                                          std::vector<moveit_controller_manager::MoveItControllerHandlePtr>& handles)
 {
-  TrajectoryExecutionContext& context = *trajectories_[part_index];
+  MOVEIT_TRACE_SCOPE("TrajectoryExecutionManager::sendPart");
+  handles.clear();
 
   // first make sure desired controllers are active
-  if (ensureActiveControllers(context.controllers_))
+  if (!ensureActiveControllers(context.controllers_))
   {
-    // stop if we are already asked to do so
-    if (execution_complete_)
+    last_execution_status_ = moveit_controller_manager::ExecutionStatus::ABORTED;
+    return false;
+  }
+
+  // stop if we are already asked to do so
+  if (execution_complete_)
+    return false;
+
+  boost::mutex::scoped_lock slock(execution_state_mutex_);
+  if (execution_complete_)
+    return false;
+
+  for (std::size_t i = 0; i < context.controllers_.size(); ++i)
+  {
+    moveit_controller_manager::MoveItControllerHandlePtr h;
+    try
+    {
+      h = controller_manager_->getControllerHandle(context.controllers_[i]);
+    }
+    catch (std::exception& ex)
+    {
+      ROS_ERROR_NAMED("traj_execution", "Caught %s when retrieving controller handle", ex.what());
+    }
+    if (!h)
+    {
+      handles.clear();
+      last_execution_status_ = moveit_controller_manager::ExecutionStatus::ABORTED;
+      ROS_ERROR_NAMED("traj_execution", "No controller handle for controller '%s'. Aborting.",
+                      context.controllers_[i].c_str());
       return false;
+    }
+    handles.push_back(h);
+  }
+
+  // the completions reported from now on are those of the trajectories sent below
+  for (std::size_t i = 0; i < handles.size(); ++i)
+  {
+    bool reports = handles[i]->setExecutionCompleteCallback(
+        boost::bind(&TrajectoryExecutionManager::handleExecutionComplete, this, _1));
+    boost::mutex::scoped_lock slock(handle_event_mutex_);
+    if (reports)
+      handle_execution_complete_[handles[i].get()] = false;
+    else
+      handle_execution_complete_.erase(handles[i].get());
+  }
 
-    std::vector<moveit_controller_manager::MoveItControllerHandlePtr> handles;
+  for (std::size_t i = 0; i < context.trajectory_parts_.size(); ++i)
+  {
+    bool ok = false;
+    try
     {
-      boost::mutex::scoped_lock slock(execution_state_mutex_);
-      if (!execution_complete_)
-      {
-        // time indexing uses this member too, so we lock this mutex as well
-        time_index_mutex_.lock();
-        current_context_ = part_index;
-        time_index_mutex_.unlock();
-        active_handles_.resize(context.controllers_.size());
-        for (std::size_t i = 0; i < context.controllers_.size(); ++i)
+      ok = handles[i]->sendTrajectory(context.trajectory_parts_[i]);
+    }
+    catch (std::exception& ex)
+    {
+      ROS_ERROR_NAMED("traj_execution", "Caught %s when sending trajectory to controller", ex.what());
+    }
+    if (!ok)
+    {
+      for (std::size_t j = 0; j < i; ++j)
+        try
         {
-          moveit_controller_manager::MoveItControllerHandlePtr h;
-          try
-          {
-            h = controller_manager_->getControllerHandle(context.controllers_[i]);
-          }
-          catch (std::exception& ex)
-          {
-            ROS_ERROR_NAMED("traj_execution", "Caught %s when retrieving controller handle", ex.what());
-          }
-          if (!h)
-          {
-            active_handles_.clear();
-            current_context_ = -1;
-            last_execution_status_ = moveit_controller_manager::ExecutionStatus::ABORTED;
-            ROS_ERROR_NAMED("traj_execution", "No controller handle for controller '%s'. Aborting.",
-                            context.controllers_[i].c_str());
-            return false;
-          }
-          active_handles_[i] = h;
+          handles[j]->cancelExecution();
         }
-        handles = active_handles_;  // keep a copy for later, to avoid thread safety issues
-        for (std::size_t i = 0; i < context.trajectory_parts_.size(); ++i)
+        catch (std::exception& ex)
         {
-          bool ok = false;
-          try
-          {
-            ok = active_handles_[i]->sendTrajectory(context.trajectory_parts_[i]);
-          }
-          catch (std::exception& ex)
-          {
-            ROS_ERROR_NAMED("traj_execution", "Caught %s when sending trajectory to controller", ex.what());
-          }
-          if (!ok)
-          {
-            for (std::size_t j = 0; j < i; ++j)
-              try
-              {
-                active_handles_[j]->cancelExecution();
-              }
-              catch (std::exception& ex)
-              {
-                ROS_ERROR_NAMED("traj_execution", "Caught %s when canceling execution", ex.what());
-              }
-            ROS_ERROR_NAMED("traj_execution", "Failed to send trajectory part %zu of %zu to controller %s", i + 1,
-                            context.trajectory_parts_.size(), active_handles_[i]->getName().c_str());
-            if (i > 0)
-              ROS_ERROR_NAMED("traj_execution", "Cancelling previously sent trajectory parts");
-            active_handles_.clear();
-            current_context_ = -1;
-            last_execution_status_ = moveit_controller_manager::ExecutionStatus::ABORTED;
-            return false;
-          }
+          ROS_ERROR_NAMED("traj_execution", "Caught %s when canceling execution", ex.what());
         }
-      }
+      ROS_ERROR_NAMED("traj_execution", "Failed to send trajectory part %zu of %zu to controller %s", i + 1,
+                      context.trajectory_parts_.size(), handles[i]->getName().c_str());
+      if (i > 0)
+        ROS_ERROR_NAMED("traj_execution", "Cancelling previously sent trajectory parts");
+      for (std::size_t j = 0; j < handles.size(); ++j)
+        if (std::find(active_handles_.begin(), active_handles_.end(), handles[j]) == active_handles_.end())
+        {
+          handles[j]->setExecutionCompleteCallback(
+              moveit_controller_manager::MoveItControllerHandle::ExecutionCompleteCallback());
+          boost::mutex::scoped_lock slock(handle_event_mutex_);
+          handle_execution_complete_.erase(handles[j].get());
+        }
+      handles.clear();
+      last_execution_status_ = moveit_controller_manager::ExecutionStatus::ABORTED;
+      return false;
+    }
+  }
+
+  // stopExecution() cancels the active handles; in pipelined mode these include the ones of the executing trajectory
+  for (std::size_t i = 0; i < handles.size(); ++i)
+    if (std::find(active_handles_.begin(), active_handles_.end(), handles[i]) == active_handles_.end())
+      active_handles_.push_back(handles[i]);
+  return true;
+}
+
+bool TrajectoryExecutionManager::waitForPart(
+    std::size_t part_index, const TrajectoryExecutionContext& context,
+    const std::vector<moveit_controller_manager::MoveItControllerHandlePtr>& handles,
+    const std::vector<moveit_controller_manager::MoveItControllerHandlePtr>& next_handles, const ros::Time& end_time)
+{
+  MOVEIT_TRACE_SCOPE("TrajectoryExecutionManager::waitForPart");
+  {
+    // time indexing uses this member too, so we lock this mutex as well
+    boost::mutex::scoped_lock slock(time_index_mutex_);
+    current_context_ = part_index;
+  }
+
+  // compute the expected duration of the trajectory and find the part of the trajectory that takes longest to execute
+  ros::Time current_time = ros::Time::now();
+  ros::Duration expected_trajectory_duration(0.0);
+  int longest_part = -1;
+  for (std::size_t i = 0; i < context.trajectory_parts_.size(); ++i)
+  {
+    ros::Duration d(0.0);
+    if (!context.trajectory_parts_[i].joint_trajectory.points.empty())
+    {
+      if (context.trajectory_parts_[i].joint_trajectory.header.stamp > current_time)
+        d = context.trajectory_parts_[i].joint_trajectory.header.stamp - current_time;
+      if (context.trajectory_parts_[i].multi_dof_joint_trajectory.header.stamp > current_time)
+        d = std::max(d, context.trajectory_parts_[i].multi_dof_joint_trajectory.header.stamp - current_time);
+      d += std::max(context.trajectory_parts_[i].joint_trajectory.points.empty() ?
+                        ros::Duration(0.0) :
+                        context.trajectory_parts_[i].joint_trajectory.points.back().time_from_start,
+                    context.trajectory_parts_[i].multi_dof_joint_trajectory.points.empty() ?
+                        ros::Duration(0.0) :
+                        context.trajectory_parts_[i].multi_dof_joint_trajectory.points.back().time_from_start);
+
+      if (longest_part < 0 ||
+          std::max(context.trajectory_parts_[i].joint_trajectory.points.size(),
+                   context.trajectory_parts_[i].multi_dof_joint_trajectory.points.size()) >
+              std::max(context.trajectory_parts_[longest_part].joint_trajectory.points.size(),
+                       context.trajectory_parts_[longest_part].multi_dof_joint_trajectory.points.size()))
+        longest_part = i;
     }
+    expected_trajectory_duration = std::max(d, expected_trajectory_duration);
+  }
+  // add 10% + 0.5s to the expected duration; this is just to allow things to finish propery
+
+  expected_trajectory_duration = expected_trajectory_duration * allowed_execution_duration_scaling_ +
+                                 ros::Duration(allowed_goal_duration_margin_);
 
-    // compute the expected duration of the trajectory and find the part of the trajectory that takes longest to execute
-    ros::Time current_time = ros::Time::now();
-    ros::Duration expected_trajectory_duration(0.0);
-    int longest_part = -1;
-    for (std::size_t i = 0; i < context.trajectory_parts_.size(); ++i)
+  if (longest_part >= 0)
+  {
+    boost::mutex::scoped_lock slock(time_index_mutex_);
+
+    // construct a map from expected time to state index, for easy access to expected state location
+    if (context.trajectory_parts_[longest_part].joint_trajectory.points.size() >=
+        context.trajectory_parts_[longest_part].multi_dof_joint_trajectory.points.size())
     {
       ros::Duration d(0.0);
-      if (!context.trajectory_parts_[i].joint_trajectory.points.empty())
-      {
-        if (context.trajectory_parts_[i].joint_trajectory.header.stamp > current_time)
-          d = context.trajectory_parts_[i].joint_trajectory.header.stamp - current_time;
-        if (context.trajectory_parts_[i].multi_dof_joint_trajectory.header.stamp > current_time)
-          d = std::max(d, context.trajectory_parts_[i].multi_dof_joint_trajectory.header.stamp - current_time);
-        d += std::max(context.trajectory_parts_[i].joint_trajectory.points.empty() ?
-                          ros::Duration(0.0) :
-                          context.trajectory_parts_[i].joint_trajectory.points.back().time_from_start,
-                      context.trajectory_parts_[i].multi_dof_joint_trajectory.points.empty() ?
-                          ros::Duration(0.0) :
-                          context.trajectory_parts_[i].multi_dof_joint_trajectory.points.back().time_from_start);
-
-        if (longest_part < 0 ||
-            std::max(context.trajectory_parts_[i].joint_trajectory.points.size(),
-                     context.trajectory_parts_[i].multi_dof_joint_trajectory.points.size()) >
-                std::max(context.trajectory_parts_[longest_part].joint_trajectory.points.size(),
-                         context.trajectory_parts_[longest_part].multi_dof_joint_trajectory.points.size()))
-          longest_part = i;
-      }
-      expected_trajectory_duration = std::max(d, expected_trajectory_duration);
+      if (context.trajectory_parts_[longest_part].joint_trajectory.header.stamp > current_time)
+        d = context.trajectory_parts_[longest_part].joint_trajectory.header.stamp - current_time;
+      for (std::size_t j = 0; j < context.trajectory_parts_[longest_part].joint_trajectory.points.size(); ++j)
+        time_index_.push_back(current_time + d +
+                              context.trajectory_parts_[longest_part].joint_trajectory.points[j].time_from_start);
     }
-    // add 10% + 0.5s to the expected duration; this is just to allow things to finish propery
+    else
+    {
+      ros::Duration d(0.0);
+      if (context.trajectory_parts_[longest_part].multi_dof_joint_trajectory.header.stamp > current_time)
+        d = context.trajectory_parts_[longest_part].multi_dof_joint_trajectory.header.stamp - current_time;
+      for (std::size_t j = 0; j < context.trajectory_parts_[longest_part].multi_dof_joint_trajectory.points.size();
+           ++j)
+        time_index_.push_back(
+            current_time + d +
+            context.trajectory_parts_[longest_part].multi_dof_joint_trajectory.points[j].time_from_start);
+    }
+  }
 
-    expected_trajectory_duration = expected_trajectory_duration * allowed_execution_duration_scaling_ +
-                                   ros::Duration(allowed_goal_duration_margin_);
+  // all the handles have to complete by the same deadline
+  const ros::Time deadline =
+      execution_duration_monitoring_ ? current_time + expected_trajectory_duration : ros::Time();
 
-    if (longest_part >= 0)
-    {
-      boost::mutex::scoped_lock slock(time_index_mutex_);
+  bool result = true;
+  for (std::size_t i = 0; i < handles.size(); ++i)
+  {
+    // the goal of a controller that already received the next trajectory was replaced by it; its completion is
+    // reported with the next trajectory
+    if (std::find(next_handles.begin(), next_handles.end(), handles[i]) != next_handles.end())
+      continue;
 
-      // construct a map from expected time to state index, for easy access to expected state location
-      if (context.trajectory_parts_[longest_part].joint_trajectory.points.size() >=
-          context.trajectory_parts_[longest_part].multi_dof_joint_trajectory.points.size())
-      {
-        ros::Duration d(0.0);
-        if (context.trajectory_parts_[longest_part].joint_trajectory.header.stamp > current_time)
-          d = context.trajectory_parts_[longest_part].joint_trajectory.header.stamp - current_time;
-        for (std::size_t j = 0; j < context.trajectory_parts_[longest_part].joint_trajectory.points.size(); ++j)
-          time_index_.push_back(current_time + d +
-                                context.trajectory_parts_[longest_part].joint_trajectory.points[j].time_from_start);
-      }
-      else
+    if (!waitForHandle(handles[i], deadline) && !execution_complete_ && ros::Time::now() >= deadline)
+    {
+      ROS_ERROR_NAMED("traj_execution", "Controller is taking too long to execute trajectory (the expected upper "
+                                        "bound for the trajectory execution was %lf seconds). Stopping "
+                                        "trajectory.",
+                      expected_trajectory_duration.toSec());
       {
-        ros::Duration d(0.0);
-        if (context.trajectory_parts_[longest_part].multi_dof_joint_trajectory.header.stamp > current_time)
-          d = context.trajectory_parts_[longest_part].multi_dof_joint_trajectory.header.stamp - current_time;
-        for (std::size_t j = 0; j < context.trajectory_parts_[longest_part].multi_dof_joint_trajectory.points.size();
-             ++j)
-          time_index_.push_back(
-              current_time + d +
-              context.trajectory_parts_[longest_part].multi_dof_joint_trajectory.points[j].time_from_start);
+        boost::mutex::scoped_lock slock(execution_state_mutex_);
+        stopExecutionInternal();  // this is trally tricky. we can't call stopExecution() here, so we call the
+                                  // internal function only
       }
+      last_execution_status_ = moveit_controller_manager::ExecutionStatus::TIMED_OUT;
+      result = false;
+      break;
     }
 
-    bool result = true;
-    for (std::size_t i = 0; i < handles.size(); ++i)
+    // if something made the trajectory stop, we stop this thread too
+    if (execution_complete_)
     {
-      if (execution_duration_monitoring_)
-      {
-        if (!handles[i]->waitForExecution(expected_trajectory_duration))
-          if (!execution_complete_ && ros::Time::now() - current_time > expected_trajectory_duration)
-          {
-            ROS_ERROR_NAMED("traj_execution", "Controller is taking too long to execute trajectory (the expected upper "
-                                              "bound for the trajectory execution was %lf seconds). Stopping "
-                                              "trajectory.",
-                            expected_trajectory_duration.toSec());
-            {
-              boost::mutex::scoped_lock slock(execution_state_mutex_);
-              stopExecutionInternal();  // this is trally tricky. we can't call stopExecution() here, so we call the
-                                        // internal function only
-            }
-            last_execution_status_ = moveit_controller_manager::ExecutionStatus::TIMED_OUT;
-            result = false;
-            break;
-          }
-      }
-      else
-        handles[i]->waitForExecution();
+      result = false;
+      break;
+    }
+    else if (handles[i]->getLastExecutionStatus() != moveit_controller_manager::ExecutionStatus::SUCCEEDED)
+    {
+      ROS_WARN_STREAM_NAMED("traj_execution", "Controller handle "
+                                                  << handles[i]->getName() << " reports status "
+                                                  << handles[i]->getLastExecutionStatus().asString());
+      last_execution_status_ = handles[i]->getLastExecutionStatus();
+      result = false;
+    }
+  }
 
-      // if something made the trajectory stop, we stop this thread too
-      if (execution_complete_)
-      {
-        result = false;
-        break;
-      }
-      else if (handles[i]->getLastExecutionStatus() != moveit_controller_manager::ExecutionStatus::SUCCEEDED)
+  // the trajectory sent to the controllers that execute this one continues it at end_time
+  if (result && !next_handles.empty())
+    result = waitUntil(end_time);
+
+  // the handles done with this trajectory stop reporting to this manager
+  for (std::size_t i = 0; i < handles.size(); ++i)
+    if (std::find(next_handles.begin(), next_handles.end(), handles[i]) == next_handles.end())
+    {
+      handles[i]->setExecutionCompleteCallback(
+          moveit_controller_manager::MoveItControllerHandle::ExecutionCompleteCallback());
+      boost::mutex::scoped_lock slock(handle_event_mutex_);
+      handle_execution_complete_.erase(handles[i].get());
+    }
+
+  // clear the active handles, keeping the ones still executing the next trajectory
+  execution_state_mutex_.lock();
+  active_handles_ = next_handles;
+
+  // clear the time index
+  time_index_mutex_.lock();
+  time_index_.clear();
+  current_context_ = -1;
+  time_index_mutex_.unlock();
+
+  execution_state_mutex_.unlock();
+  return result;
+}
+
+bool TrajectoryExecutionManager::waitForHandle(const moveit_controller_manager::MoveItControllerHandlePtr& handle,
+                                               const ros::Time& deadline)
+{
+  {
+    boost::unique_lock<boost::mutex> ulock(handle_event_mutex_);
+    std::map<const moveit_controller_manager::MoveItControllerHandle*, bool>::const_iterator it =
+        handle_execution_complete_.find(handle.get());
+    if (it != handle_execution_complete_.end())
+    {
+      while (!it->second && !execution_complete_)
       {
-        ROS_WARN_STREAM_NAMED("traj_execution", "Controller handle "
-                                                    << handles[i]->getName() << " reports status "
-                                                    << handles[i]->getLastExecutionStatus().asString());
-        last_execution_status_ = handles[i]->getLastExecutionStatus();
-        result = false;
+        if (deadline.isZero())
+        {
+          handle_event_condition_.wait(ulock);
+          continue;
+        }
+        ros::Duration remaining = deadline - ros::Time::now();
+        if (remaining <= ros::Duration(0.0))
+          return false;
+        // the deadline is in ROS time, which may be simulated, so it is checked again at least every 0.1s
+        handle_event_condition_.timed_wait(
+            ulock, boost::posix_time::microseconds((long)(std::min(remaining.toSec(), 0.1) * 1e6)));
       }
+      if (execution_complete_)
+        return true;
     }
+  }
 
-    // clear the active handles
-    execution_state_mutex_.lock();
-    active_handles_.clear();
-
-    // clear the time index
-    time_index_mutex_.lock();
-    time_index_.clear();
-    current_context_ = -1;
-    time_index_mutex_.unlock();
+  // a handle that reported its completion returns at once; this also covers completions reported for a trajectory
+  // replaced by the one sent last. The handles that do not report completions block here
+  if (deadline.isZero())
+    return handle->waitForExecution();
+  return handle->waitForExecution(std::max(deadline - ros::Time::now(), ros::Duration(0.001)));
+}
 
-    execution_state_mutex_.unlock();
-    return result;
+bool TrajectoryExecutionManager::waitUntil(const ros::Time& time)
+{
+  boost::unique_lock<boost::mutex> ulock(handle_event_mutex_);
+  while (!execution_complete_)
+  {
+    ros::Duration remaining = time - ros::Time::now();
+    if (remaining <= ros::Duration(0.0))
+      return true;
+    handle_event_condition_.timed_wait(
+        ulock, boost::posix_time::microseconds((long)(std::min(remaining.toSec(), 0.1) * 1e6)));
   }
-  else
+  return false;
+}
+
+void TrajectoryExecutionManager::handleExecutionComplete(moveit_controller_manager::MoveItControllerHandle* handle)
+{
+  boost::mutex::scoped_lock slock(handle_event_mutex_);
+  std::map<const moveit_controller_manager::MoveItControllerHandle*, bool>::iterator it =
+      handle_execution_complete_.find(handle);
+  if (it != handle_execution_complete_.end())
   {
-    last_execution_status_ = moveit_controller_manager::ExecutionStatus::ABORTED;
+    it->second = true;
+    handle_event_condition_.notify_all();
+  }
+}
+
+bool TrajectoryExecutionManager::executePart(std::size_t part_index)
+{
+  const TrajectoryExecutionContext& context = *trajectories_[part_index];
+  std::vector<moveit_controller_manager::MoveItControllerHandlePtr> handles;
+  if (!sendPart(context, handles))
     return false;
+  return waitForPart(part_index, context, handles, std::vector<moveit_controller_manager::MoveItControllerHandlePtr>(),
+                     ros::Time());
+}
+
+std::size_t TrajectoryExecutionManager::executePipelined(const PathSegmentCompleteCallback& part_callback)
+{
+  if (trajectories_.empty())
+    return 0;
+
+  // each trajectory is sent to the controllers while the previous one executes, stamped to start when that one ends,
+  // so the controllers continue with it without stopping. Stamped copies are sent, so the pushed trajectories can be
+  // executed again
+  TrajectoryExecutionContext context = *trajectories_[0];
+  TrajectoryExecutionContext next_context;
+  std::vector<moveit_controller_manager::MoveItControllerHandlePtr> handles, next_handles;
+  if (!sendPart(context, handles))
+    return 1;
+  ros::Time start_time = ros::Time::now();
+
+  for (std::size_t i = 0; i < trajectories_.size(); ++i)
+  {
+    const ros::Time end_time = getEndTime(context, start_time);
+    next_handles.clear();
+
+    // the next trajectory is validated against the end of this one while this one executes. It is only sent ahead
+    // if its controllers are active already, as switching controllers would interrupt this trajectory
+    bool next_valid = true;
+    bool send_ahead = false;
+    if (i + 1 < trajectories_.size())
+    {
+      next_context = *trajectories_[i + 1];
+      next_valid = validate(next_context, context);
+      if (next_valid && areControllersActive(next_context.controllers_))
+      {
+        setStartTime(next_context, end_time);
+        // on failure, the status is set by sendPart()
+        next_valid = send_ahead = sendPart(next_context, next_handles);
+      }
+      else if (!next_valid)
+        last_execution_status_ = moveit_controller_manager::ExecutionStatus::ABORTED;
+    }
+
+    bool epart = waitForPart(i, context, handles, next_handles, end_time);
+    if (epart && part_callback)
+      part_callback(i);
+    if (!epart || !next_valid || execution_complete_ || i + 1 == trajectories_.size())
+      return i + 1;
+
+    if (!send_ahead && !sendPart(next_context, next_handles))
+      return i + 2;
+    start_time = send_ahead ? end_time : ros::Time::now();
+    context = next_context;
+    handles.swap(next_handles);
   }
+  return trajectories_.size();
 }
 
 bool TrajectoryExecutionManager::waitForRobotToStop(const TrajectoryExecutionContext& context, double wait_time)
 {
+  MOVEIT_TRACE_SCOPE("TrajectoryExecutionManager::waitForRobotToStop");
   if (allowed_start_tolerance_ == 0)  // skip validation on this magic number
     return true;
 
@@ -1635,7 +2035,10 @@ bool TrajectoryExecutionManager::ensureActiveControllers(const std::vector<std::
         // reset the state update cache
         for (std::size_t a = 0; a < controllers_to_deactivate.size(); ++a)
           known_controllers_[controllers_to_deactivate[a]].last_update_ = ros::Time();
-        return controller_manager_->switchControllers(controllers_to_activate, controllers_to_deactivate);
+        bool switched = controller_manager_->switchControllers(controllers_to_activate, controllers_to_deactivate);
+        // the states refreshed in the background may predate the switch
+        invalidateControllerStates();
+        return switched;
       }
       else
         return false;
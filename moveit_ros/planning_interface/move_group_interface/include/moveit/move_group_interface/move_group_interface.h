@@ -52,6 +52,11 @@
 #include <boost/shared_ptr.hpp>
 #include <tf/tf.h>
 
+namespace move_group
+{
+MOVEIT_CLASS_FORWARD(MoveGroupContext);
+}
+
 namespace moveit
 {
 /** \brief Simple interface to MoveIt! components */
@@ -110,6 +115,11 @@ public:
     robot_model::RobotModelConstPtr robot_model_;
 
     ros::NodeHandle node_handle_;
+
+    /// Optionally, a MoveGroupContext of this process to plan and execute with directly, instead of going through the
+    /// actions of a move_group node. Its planning scene monitor is used for the current state, and its robot model if
+    /// robot_model_ is not set. Pick and place, and the other services, still go to a move_group node, if one runs.
+    move_group::MoveGroupContextPtr move_group_context_;
   };
 
   MOVEIT_STRUCT_FORWARD(Plan);
@@ -809,6 +819,13 @@ public:
   /** \brief Get the current state of the robot */
   robot_state::RobotStatePtr getCurrentState();
 
+  /** \brief Copy the most recently received state of the robot into \e state. Unlike getCurrentState(), this does
+      not wait for a joint state newer than the call and does not allocate; the positions are read without locking
+      from the state monitor shared by all instances for this robot model. Only if no complete state has been received
+      yet, this waits up to \e wait seconds for one.
+      @return false if no complete state is known */
+  bool getCurrentState(robot_state::RobotState& state, double wait = 1.0);
+
   /** \brief Get the pose for the end-effector \e end_effector_link.
       If \e end_effector_link is empty (the default value) then the end-effector reported by getEndEffectorLink() is
      assumed */
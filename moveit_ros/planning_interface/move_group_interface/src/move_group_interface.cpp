@@ -42,6 +42,9 @@
 #include <moveit/warehouse/constraints_storage.h>
 #include <moveit/kinematic_constraints/utils.h>
 #include <moveit/move_group/capability_names.h>
+#include <moveit/move_group/move_group_context.h>
+#include <moveit/planning_pipeline/planning_pipeline.h>
+#include <moveit/plan_execution/plan_execution.h>
 #include <moveit/move_group_pick_place_capability/capability_names.h>
 #include <moveit/move_group_interface/move_group_interface.h>
 #include <moveit/planning_scene_monitor/current_state_monitor.h>
@@ -69,6 +72,7 @@
 #include <tf_conversions/tf_eigen.h>
 #include <ros/console.h>
 #include <ros/ros.h>
+#include <boost/bind.hpp>
 
 namespace moveit
 {
@@ -97,7 +101,12 @@ public:
                          const ros::WallDuration& wait_for_servers)
     : opt_(opt), node_handle_(opt.node_handle_), tf_(tf)
   {
-    robot_model_ = opt.robot_model_ ? opt.robot_model_ : getSharedRobotModel(opt.robot_description_);
+    if (opt.robot_model_)
+      robot_model_ = opt.robot_model_;
+    else if (opt.move_group_context_)
+      robot_model_ = opt.move_group_context_->planning_scene_monitor_->getRobotModel();
+    else
+      robot_model_ = getSharedRobotModel(opt.robot_description_);
     if (!getRobotModel())
     {
       std::string error = "Unable to construct robot model. Please make sure all needed information is on the "
@@ -139,30 +148,44 @@ public:
     attached_object_publisher_ = node_handle_.advertise<moveit_msgs::AttachedCollisionObject>(
         planning_scene_monitor::PlanningSceneMonitor::DEFAULT_ATTACHED_COLLISION_OBJECT_TOPIC, 1, false);
 
-    current_state_monitor_ = getSharedStateMonitor(robot_model_, tf_, node_handle_);
+    if (opt.move_group_context_)
+      current_state_monitor_ = opt.move_group_context_->planning_scene_monitor_->getStateMonitor();
+    if (!current_state_monitor_)
+      current_state_monitor_ = getSharedStateMonitor(robot_model_, tf_, node_handle_);
 
-    ros::WallTime timeout_for_servers = ros::WallTime::now() + wait_for_servers;
-    if (wait_for_servers == ros::WallDuration())
-      timeout_for_servers = ros::WallTime();  // wait for ever
-    double allotted_time = wait_for_servers.toSec();
+    if (opt.move_group_context_)
+    {
+      // planning and execution are direct calls; pick and place are only available if a move_group node runs
+      pick_action_client_.reset(
+          new actionlib::SimpleActionClient<moveit_msgs::PickupAction>(node_handle_, move_group::PICKUP_ACTION, false));
+      place_action_client_.reset(
+          new actionlib::SimpleActionClient<moveit_msgs::PlaceAction>(node_handle_, move_group::PLACE_ACTION, false));
+    }
+    else
+    {
+      ros::WallTime timeout_for_servers = ros::WallTime::now() + wait_for_servers;
+      if (wait_for_servers == ros::WallDuration())
+        timeout_for_servers = ros::WallTime();  // wait for ever
+      double allotted_time = wait_for_servers.toSec();
 
-    move_action_client_.reset(
-        new actionlib::SimpleActionClient<moveit_msgs::MoveGroupAction>(node_handle_, move_group::MOVE_ACTION, false));
-    waitForAction(move_action_client_, move_group::MOVE_ACTION, timeout_for_servers, allotted_time);
+      move_action_client_.reset(new actionlib::SimpleActionClient<moveit_msgs::MoveGroupAction>(
+          node_handle_, move_group::MOVE_ACTION, false));
+      waitForAction(move_action_client_, move_group::MOVE_ACTION, timeout_for_servers, allotted_time);
 
-    pick_action_client_.reset(
-        new actionlib::SimpleActionClient<moveit_msgs::PickupAction>(node_handle_, move_group::PICKUP_ACTION, false));
-    waitForAction(pick_action_client_, move_group::PICKUP_ACTION, timeout_for_servers, allotted_time);
+      pick_action_client_.reset(
+          new actionlib::SimpleActionClient<moveit_msgs::PickupAction>(node_handle_, move_group::PICKUP_ACTION, false));
+      waitForAction(pick_action_client_, move_group::PICKUP_ACTION, timeout_for_servers, allotted_time);
 
-    place_action_client_.reset(
-        new actionlib::SimpleActionClient<moveit_msgs::PlaceAction>(node_handle_, move_group::PLACE_ACTION, false));
-    waitForAction(place_action_client_, move_group::PLACE_ACTION, timeout_for_servers, allotted_time);
+      place_action_client_.reset(
+          new actionlib::SimpleActionClient<moveit_msgs::PlaceAction>(node_handle_, move_group::PLACE_ACTION, false));
+      waitForAction(place_action_client_, move_group::PLACE_ACTION, timeout_for_servers, allotted_time);
 
-    execute_action_client_.reset(new actionlib::SimpleActionClient<moveit_msgs::ExecuteTrajectoryAction>(
-        node_handle_, move_group::EXECUTE_ACTION_NAME, false));
-    // TODO: after deprecation period, i.e. for L-turtle, switch back to standard waitForAction function
-    // waitForAction(execute_action_client_, move_group::EXECUTE_ACTION_NAME, timeout_for_servers, allotted_time);
-    waitForExecuteActionOrService(timeout_for_servers);
+      execute_action_client_.reset(new actionlib::SimpleActionClient<moveit_msgs::ExecuteTrajectoryAction>(
+          node_handle_, move_group::EXECUTE_ACTION_NAME, false));
+      // TODO: after deprecation period, i.e. for L-turtle, switch back to standard waitForAction function
+      // waitForAction(execute_action_client_, move_group::EXECUTE_ACTION_NAME, timeout_for_servers, allotted_time);
+      waitForExecuteActionOrService(timeout_for_servers);
+    }
 
     query_service_ =
         node_handle_.serviceClient<moveit_msgs::QueryPlannerInterfaces>(move_group::QUERY_PLANNERS_SERVICE_NAME);
@@ -309,6 +332,12 @@ public:
   {
     if (constraints_init_thread_)
       constraints_init_thread_->join();
+    if (embedded_move_thread_)
+    {
+      if (opt_.move_group_context_->plan_execution_)
+        opt_.move_group_context_->plan_execution_->stop();
+      embedded_move_thread_->join();
+    }
   }
 
   const boost::shared_ptr<tf::Transformer>& getTF() const
@@ -639,6 +668,29 @@ public:
     return true;
   }
 
+  bool copyCurrentState(robot_state::RobotState& state, double wait_seconds)
+  {
+    if (!current_state_monitor_)
+    {
+      ROS_ERROR_NAMED("move_group_interface", "Unable to get current robot state");
+      return false;
+    }
+
+    if (!current_state_monitor_->isActive())
+      current_state_monitor_->startStateMonitor();
+
+    if (current_state_monitor_->copyCurrentState(state))
+      return true;
+
+    // nothing complete has been received yet, so this is the only case in which we block
+    if (!current_state_monitor_->waitForCompleteState(wait_seconds) || !current_state_monitor_->copyCurrentState(state))
+    {
+      ROS_ERROR_NAMED("move_group_interface", "Failed to fetch current robot state");
+      return false;
+    }
+    return true;
+  }
+
   /** \brief Place an object at one of the specified possible locations */
   MoveItErrorCode place(const std::string& object, const std::vector<geometry_msgs::PoseStamped>& poses)
   {
@@ -791,6 +843,8 @@ public:
 
   MoveItErrorCode plan(Plan& plan)
   {
+    if (opt_.move_group_context_)
+      return planEmbedded(plan);
     if (!move_action_client_)
     {
       return MoveItErrorCode(moveit_msgs::MoveItErrorCodes::FAILURE);
@@ -830,6 +884,8 @@ public:
 
   MoveItErrorCode move(bool wait)
   {
+    if (opt_.move_group_context_)
+      return moveEmbedded(wait);
     if (!move_action_client_)
     {
       return MoveItErrorCode(moveit_msgs::MoveItErrorCodes::FAILURE);
@@ -873,6 +929,8 @@ public:
 
   MoveItErrorCode execute(const Plan& plan, bool wait)
   {
+    if (opt_.move_group_context_)
+      return executeEmbedded(plan, wait);
     if (!execute_action_client_)
     {
       // TODO: Remove this backwards compatibility code in L-turtle
@@ -921,6 +979,136 @@ public:
     }
   }
 
+  /* The embedded counterparts of plan(), move() and execute(), which do what the MoveGroupMoveAction and
+     MoveGroupExecuteTrajectoryAction capabilities do, on the MoveGroupContext of this process */
+
+  MoveItErrorCode planEmbedded(Plan& plan)
+  {
+    const move_group::MoveGroupContextPtr& context = opt_.move_group_context_;
+    moveit_msgs::MotionPlanRequest request;
+    constructMotionPlanRequest(request);
+    context->planning_scene_monitor_->waitForCurrentRobotState(ros::Time::now());
+    context->planning_scene_monitor_->updateFrameTransforms();
+
+    ::planning_interface::MotionPlanResponse res;
+    {
+      planning_scene_monitor::LockedPlanningSceneRO lscene(context->planning_scene_monitor_);
+      try
+      {
+        context->planning_pipeline_->generatePlan(lscene, request, res);
+      }
+      catch (std::exception& ex)
+      {
+        ROS_ERROR_NAMED("move_group_interface", "Planning pipeline threw an exception: %s", ex.what());
+        res.error_code_.val = moveit_msgs::MoveItErrorCodes::FAILURE;
+      }
+    }
+    if (res.trajectory_ && !res.trajectory_->empty())
+    {
+      robot_state::robotStateToRobotStateMsg(res.trajectory_->getFirstWayPoint(), plan.start_state_);
+      res.trajectory_->getRobotTrajectoryMsg(plan.trajectory_);
+    }
+    plan.planning_time_ = res.planning_time_;
+    return MoveItErrorCode(res.error_code_);
+  }
+
+  bool planForExecution(const moveit_msgs::MotionPlanRequest& request, plan_execution::ExecutableMotionPlan& plan)
+  {
+    planning_scene_monitor::LockedPlanningSceneRO lscene(plan.planning_scene_monitor_);
+    ::planning_interface::MotionPlanResponse res;
+    bool solved = false;
+    try
+    {
+      solved = opt_.move_group_context_->planning_pipeline_->generatePlan(plan.planning_scene_, request, res);
+    }
+    catch (std::exception& ex)
+    {
+      ROS_ERROR_NAMED("move_group_interface", "Planning pipeline threw an exception: %s", ex.what());
+      res.error_code_.val = moveit_msgs::MoveItErrorCodes::FAILURE;
+    }
+    if (res.trajectory_)
+    {
+      plan.plan_components_.resize(1);
+      plan.plan_components_[0].trajectory_ = res.trajectory_;
+      plan.plan_components_[0].description_ = "plan";
+    }
+    plan.error_code_ = res.error_code_;
+    return solved;
+  }
+
+  MoveItErrorCode planAndExecuteEmbedded(const moveit_msgs::MotionPlanRequest& request)
+  {
+    const move_group::MoveGroupContextPtr& context = opt_.move_group_context_;
+    plan_execution::PlanExecution::Options opt;
+    opt.replan_ = can_replan_;
+    opt.replan_delay_ = replan_delay_;
+    opt.plan_callback_ = boost::bind(&MoveGroupInterfaceImpl::planForExecution, this, boost::cref(request), _1);
+
+    boost::unique_lock<boost::mutex> lock;
+    if (context->concurrent_requests_)
+      lock = boost::unique_lock<boost::mutex>(context->serialized_requests_mutex_);
+    plan_execution::ExecutableMotionPlan plan;
+    context->plan_execution_->planAndExecute(plan, opt);
+    return MoveItErrorCode(plan.error_code_);
+  }
+
+  MoveItErrorCode moveEmbedded(bool wait)
+  {
+    const move_group::MoveGroupContextPtr& context = opt_.move_group_context_;
+    if (!context->plan_execution_)
+    {
+      ROS_ERROR_NAMED("move_group_interface", "The MoveGroupContext does not allow trajectory execution");
+      return MoveItErrorCode(moveit_msgs::MoveItErrorCodes::FAILURE);
+    }
+    if (embedded_move_thread_)
+    {
+      embedded_move_thread_->join();
+      embedded_move_thread_.reset();
+    }
+
+    moveit_msgs::MotionPlanRequest request;
+    constructMotionPlanRequest(request);
+    // execution starts from the current state
+    request.start_state = moveit_msgs::RobotState();
+    request.start_state.is_diff = true;
+    context->planning_scene_monitor_->waitForCurrentRobotState(ros::Time::now());
+    context->planning_scene_monitor_->updateFrameTransforms();
+    if (wait)
+      return planAndExecuteEmbedded(request);
+
+    // the bound copy of the request lives as long as the thread
+    embedded_move_thread_.reset(
+        new boost::thread(boost::bind(&MoveGroupInterfaceImpl::planAndExecuteEmbedded, this, request)));
+    return MoveItErrorCode(moveit_msgs::MoveItErrorCodes::SUCCESS);
+  }
+
+  MoveItErrorCode executeEmbedded(const Plan& plan, bool wait)
+  {
+    const trajectory_execution_manager::TrajectoryExecutionManagerPtr& tem =
+        opt_.move_group_context_->trajectory_execution_manager_;
+    if (!tem)
+    {
+      ROS_ERROR_NAMED("move_group_interface", "The MoveGroupContext does not allow trajectory execution");
+      return MoveItErrorCode(moveit_msgs::MoveItErrorCodes::FAILURE);
+    }
+
+    tem->clear();
+    if (!tem->push(plan.trajectory_))
+      return MoveItErrorCode(moveit_msgs::MoveItErrorCodes::CONTROL_FAILED);
+    tem->execute();
+    if (!wait)
+      return MoveItErrorCode(moveit_msgs::MoveItErrorCodes::SUCCESS);
+
+    moveit_controller_manager::ExecutionStatus es = tem->waitForExecution();
+    if (es == moveit_controller_manager::ExecutionStatus::SUCCEEDED)
+      return MoveItErrorCode(moveit_msgs::MoveItErrorCodes::SUCCESS);
+    if (es == moveit_controller_manager::ExecutionStatus::PREEMPTED)
+      return MoveItErrorCode(moveit_msgs::MoveItErrorCodes::PREEMPTED);
+    if (es == moveit_controller_manager::ExecutionStatus::TIMED_OUT)
+      return MoveItErrorCode(moveit_msgs::MoveItErrorCodes::TIMED_OUT);
+    return MoveItErrorCode(moveit_msgs::MoveItErrorCodes::CONTROL_FAILED);
+  }
+
   double computeCartesianPath(const std::vector<geometry_msgs::Pose>& waypoints, double step, double jump_threshold,
                               moveit_msgs::RobotTrajectory& msg, const moveit_msgs::Constraints& path_constraints,
                               bool avoid_collisions, moveit_msgs::MoveItErrorCodes& error_code)
@@ -962,6 +1150,13 @@ public:
 
   void stop()
   {
+    if (opt_.move_group_context_)
+    {
+      if (opt_.move_group_context_->plan_execution_)
+        opt_.move_group_context_->plan_execution_->stop();
+      if (opt_.move_group_context_->trajectory_execution_manager_)
+        opt_.move_group_context_->trajectory_execution_manager_->stopExecution(true);
+    }
     if (trajectory_event_publisher_)
     {
       std_msgs::String event;
@@ -1323,6 +1518,7 @@ private:
   ros::ServiceClient plan_grasps_service_;
   std::unique_ptr<moveit_warehouse::ConstraintsStorage> constraints_storage_;
   std::unique_ptr<boost::thread> constraints_init_thread_;
+  std::unique_ptr<boost::thread> embedded_move_thread_;
   bool initializing_constraints_;
 };
 }
@@ -2109,6 +2305,11 @@ robot_state::RobotStatePtr moveit::planning_interface::MoveGroupInterface::getCu
   return current_state;
 }
 
+bool moveit::planning_interface::MoveGroupInterface::getCurrentState(robot_state::RobotState& state, double wait)
+{
+  return impl_->copyCurrentState(state, wait);
+}
+
 void moveit::planning_interface::MoveGroupInterface::rememberJointValues(const std::string& name,
                                                                          const std::vector<double>& values)
 {
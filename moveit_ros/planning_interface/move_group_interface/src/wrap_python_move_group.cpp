@@ -44,6 +44,7 @@
 #include <eigen_conversions/eigen_msg.h>
 #include <tf_conversions/tf_eigen.h>
 
+#include <stdexcept>
 #include <boost/python.hpp>
 #include <boost/shared_ptr.hpp>
 #include <Python.h>
@@ -143,6 +144,14 @@ public:
     return py_bindings_tools::listFromDouble(getCurrentJointValues());
   }
 
+  bp::object getCurrentJointValuesArray()
+  {
+    const std::vector<double> values = getCurrentJointValues();
+    py_bindings_tools::DoubleArray result(values.size());
+    std::copy(values.begin(), values.end(), result.data());
+    return result.object();
+  }
+
   bp::list getRandomJointValuesList()
   {
     return py_bindings_tools::listFromDouble(getRandomJointValues());
@@ -395,6 +404,76 @@ public:
     return py_bindings_tools::serializeMsg(plan.trajectory_);
   }
 
+  // Plans and trajectories as flat float64 arrays (one row of joint values per waypoint) instead of serialized
+  // RobotTrajectory messages. Only the joint trajectory part is represented.
+
+  bp::tuple getPlanArraysPython()
+  {
+    MoveGroupInterface::Plan plan;
+    bool success = MoveGroupInterface::plan(plan);
+    const trajectory_msgs::JointTrajectory& traj = plan.trajectory_.joint_trajectory;
+    const std::size_t count = traj.points.size();
+    const std::size_t n = traj.joint_names.size();
+
+    bool has_velocities = count > 0;
+    bool has_accelerations = count > 0;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      has_velocities = has_velocities && traj.points[i].velocities.size() == n;
+      has_accelerations = has_accelerations && traj.points[i].accelerations.size() == n;
+    }
+
+    py_bindings_tools::DoubleArray positions(n * count);
+    py_bindings_tools::DoubleArray velocities(has_velocities ? n * count : 0);
+    py_bindings_tools::DoubleArray accelerations(has_accelerations ? n * count : 0);
+    py_bindings_tools::DoubleArray times(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      const trajectory_msgs::JointTrajectoryPoint& point = traj.points[i];
+      if (point.positions.size() != n)
+        throw std::runtime_error("MoveGroupInterfaceWrapper: planned waypoints do not set all the joints");
+      std::copy(point.positions.begin(), point.positions.end(), positions.data() + i * n);
+      if (has_velocities)
+        std::copy(point.velocities.begin(), point.velocities.end(), velocities.data() + i * n);
+      if (has_accelerations)
+        std::copy(point.accelerations.begin(), point.accelerations.end(), accelerations.data() + i * n);
+      times.data()[i] = point.time_from_start.toSec();
+    }
+    return bp::make_tuple(success, py_bindings_tools::listFromString(traj.joint_names), positions.object(),
+                          velocities.object(), accelerations.object(), times.object());
+  }
+
+  bool executeArraysPython(const bp::list& joint_names, const bp::object& positions, const bp::object& velocities,
+                           const bp::object& accelerations, const bp::object& times, bool wait)
+  {
+    MoveGroupInterface::Plan plan;
+    trajectory_msgs::JointTrajectory& traj = plan.trajectory_.joint_trajectory;
+    traj.joint_names = py_bindings_tools::stringFromList(joint_names);
+    const std::size_t n = traj.joint_names.size();
+
+    py_bindings_tools::DoubleBuffer p(positions), v(velocities), a(accelerations), t(times);
+    const std::size_t count = t.size();
+    if (n == 0 || p.size() != n * count || (v.size() && v.size() != n * count) || (a.size() && a.size() != n * count))
+    {
+      ROS_ERROR("Trajectory arrays do not match %u joints and %u waypoints", (unsigned int)n, (unsigned int)count);
+      return false;
+    }
+
+    traj.header.stamp = ros::Time::now();
+    traj.points.resize(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      trajectory_msgs::JointTrajectoryPoint& point = traj.points[i];
+      point.positions.assign(p.data() + i * n, p.data() + (i + 1) * n);
+      if (v.size())
+        point.velocities.assign(v.data() + i * n, v.data() + (i + 1) * n);
+      if (a.size())
+        point.accelerations.assign(a.data() + i * n, a.data() + (i + 1) * n);
+      point.time_from_start = ros::Duration(t.data()[i]);
+    }
+    return wait ? execute(plan) : asyncExecute(plan);
+  }
+
   bp::tuple computeCartesianPathPython(const bp::list& waypoints, double eef_step, double jump_threshold,
                                        bool avoid_collisions)
   {
@@ -560,6 +639,8 @@ static void wrap_move_group_interface()
 
   MoveGroupInterfaceClass.def("start_state_monitor", &MoveGroupInterfaceWrapper::startStateMonitor);
   MoveGroupInterfaceClass.def("get_current_joint_values", &MoveGroupInterfaceWrapper::getCurrentJointValuesList);
+  MoveGroupInterfaceClass.def("get_current_joint_values_array",
+                              &MoveGroupInterfaceWrapper::getCurrentJointValuesArray);
   MoveGroupInterfaceClass.def("get_random_joint_values", &MoveGroupInterfaceWrapper::getRandomJointValuesList);
   MoveGroupInterfaceClass.def("get_remembered_joint_values",
                               &MoveGroupInterfaceWrapper::getRememberedJointValuesPython);
@@ -599,6 +680,8 @@ static void wrap_move_group_interface()
   MoveGroupInterfaceClass.def("set_planner_id", &MoveGroupInterfaceWrapper::setPlannerId);
   MoveGroupInterfaceClass.def("set_num_planning_attempts", &MoveGroupInterfaceWrapper::setNumPlanningAttempts);
   MoveGroupInterfaceClass.def("compute_plan", &MoveGroupInterfaceWrapper::getPlanPython);
+  MoveGroupInterfaceClass.def("compute_plan_arrays", &MoveGroupInterfaceWrapper::getPlanArraysPython);
+  MoveGroupInterfaceClass.def("execute_arrays", &MoveGroupInterfaceWrapper::executeArraysPython);
   MoveGroupInterfaceClass.def("compute_cartesian_path", &MoveGroupInterfaceWrapper::computeCartesianPathPython);
   MoveGroupInterfaceClass.def("set_support_surface_name", &MoveGroupInterfaceWrapper::setSupportSurfaceName);
   MoveGroupInterfaceClass.def("attach_object", &MoveGroupInterfaceWrapper::attachObjectPython);
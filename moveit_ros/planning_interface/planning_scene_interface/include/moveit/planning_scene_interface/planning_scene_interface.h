@@ -139,6 +139,27 @@ public:
 
   /**@}*/
 
+  /**
+   * \name Local scene mirror
+   */
+  /**@{*/
+
+  /** \brief Keep a local copy of the objects in the planning scene of the move_group node, updated from the scene
+      diffs published on \e topic. While the mirror runs, the object queries are answered from the local copy
+      instead of calling the get_planning_scene service. Also, updates of collision objects only send the objects
+      that changed, and objects whose geometry did not change are sent as MOVE operations with just their poses.
+      The updates are received by the global callback queue, which needs to be spun. Returns false if the current
+      scene could not be retrieved. */
+  bool startSceneMirror(const std::string& topic = "move_group/monitored_planning_scene");
+
+  /** \brief Stop mirroring the planning scene; queries go to the move_group node again */
+  void stopSceneMirror();
+
+  /** \brief Check whether startSceneMirror() was called (and successful) */
+  bool isSceneMirrorActive() const;
+
+  /**@}*/
+
 private:
   class PlanningSceneInterfaceImpl;
   PlanningSceneInterfaceImpl* impl_;
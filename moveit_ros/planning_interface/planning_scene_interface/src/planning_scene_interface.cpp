@@ -39,16 +39,46 @@
 #include <moveit_msgs/GetPlanningScene.h>
 #include <moveit_msgs/ApplyPlanningScene.h>
 #include <ros/ros.h>
+#include <ros/serialization.h>
+#include <boost/thread/mutex.hpp>
 #include <algorithm>
+#include <atomic>
 
 namespace moveit
 {
 namespace planning_interface
 {
+namespace
+{
+template <typename T>
+bool sameSerialization(const T& a, const T& b)
+{
+  uint32_t size = ros::serialization::serializationLength(a);
+  if (size != ros::serialization::serializationLength(b))
+    return false;
+  std::vector<uint8_t> buffer_a(size), buffer_b(size);
+  ros::serialization::OStream stream_a(buffer_a.data(), size);
+  ros::serialization::serialize(stream_a, a);
+  ros::serialization::OStream stream_b(buffer_b.data(), size);
+  ros::serialization::serialize(stream_b, b);
+  return buffer_a == buffer_b;
+}
+
+bool isInROI(const std::vector<geometry_msgs::Pose>& poses, double minx, double miny, double minz, double maxx,
+             double maxy, double maxz)
+{
+  for (std::size_t j = 0; j < poses.size(); ++j)
+    if (!(poses[j].position.x >= minx && poses[j].position.x <= maxx && poses[j].position.y >= miny &&
+          poses[j].position.y <= maxy && poses[j].position.z >= minz && poses[j].position.z <= maxz))
+      return false;
+  return true;
+}
+}
+
 class PlanningSceneInterface::PlanningSceneInterfaceImpl
 {
 public:
-  PlanningSceneInterfaceImpl()
+  PlanningSceneInterfaceImpl() : mirror_active_(false)
   {
     planning_scene_service_ =
         node_handle_.serviceClient<moveit_msgs::GetPlanningScene>(move_group::GET_PLANNING_SCENE_SERVICE_NAME);
@@ -59,6 +89,16 @@ public:
 
   std::vector<std::string> getKnownObjectNames(bool with_type)
   {
+    if (mirror_active_)
+    {
+      boost::mutex::scoped_lock slock(mirror_lock_);
+      std::vector<std::string> result;
+      for (ObjectMap::const_iterator it = mirror_objects_.begin(); it != mirror_objects_.end(); ++it)
+        if (!with_type || !it->second.type.key.empty())
+          result.push_back(it->first);
+      return result;
+    }
+
     moveit_msgs::GetPlanningScene::Request request;
     moveit_msgs::GetPlanningScene::Response response;
     std::vector<std::string> result;
@@ -82,9 +122,17 @@ public:
   std::vector<std::string> getKnownObjectNamesInROI(double minx, double miny, double minz, double maxx, double maxy,
                                                     double maxz, bool with_type, std::vector<std::string>& types)
   {
+    std::vector<std::string> result;
+    if (mirror_active_)
+    {
+      boost::mutex::scoped_lock slock(mirror_lock_);
+      for (ObjectMap::const_iterator it = mirror_objects_.begin(); it != mirror_objects_.end(); ++it)
+        addIfInROI(it->second, minx, miny, minz, maxx, maxy, maxz, with_type, result, types);
+      return result;
+    }
+
     moveit_msgs::GetPlanningScene::Request request;
     moveit_msgs::GetPlanningScene::Response response;
-    std::vector<std::string> result;
     request.components.components = request.components.WORLD_OBJECT_GEOMETRY;
     if (!planning_scene_service_.call(request, response))
     {
@@ -93,50 +141,49 @@ public:
     }
 
     for (std::size_t i = 0; i < response.scene.world.collision_objects.size(); ++i)
+      addIfInROI(response.scene.world.collision_objects[i], minx, miny, minz, maxx, maxy, maxz, with_type, result,
+                 types);
+    return result;
+  }
+
+  static void addIfInROI(const moveit_msgs::CollisionObject& object, double minx, double miny, double minz,
+                         double maxx, double maxy, double maxz, bool with_type, std::vector<std::string>& result,
+                         std::vector<std::string>& types)
+  {
+    if (with_type && object.type.key.empty())
+      return;
+    if (object.mesh_poses.empty() && object.primitive_poses.empty())
+      return;
+    if (isInROI(object.mesh_poses, minx, miny, minz, maxx, maxy, maxz) &&
+        isInROI(object.primitive_poses, minx, miny, minz, maxx, maxy, maxz))
     {
-      if (with_type && response.scene.world.collision_objects[i].type.key.empty())
-        continue;
-      if (response.scene.world.collision_objects[i].mesh_poses.empty() &&
-          response.scene.world.collision_objects[i].primitive_poses.empty())
-        continue;
-      bool good = true;
-      for (std::size_t j = 0; j < response.scene.world.collision_objects[i].mesh_poses.size(); ++j)
-        if (!(response.scene.world.collision_objects[i].mesh_poses[j].position.x >= minx &&
-              response.scene.world.collision_objects[i].mesh_poses[j].position.x <= maxx &&
-              response.scene.world.collision_objects[i].mesh_poses[j].position.y >= miny &&
-              response.scene.world.collision_objects[i].mesh_poses[j].position.y <= maxy &&
-              response.scene.world.collision_objects[i].mesh_poses[j].position.z >= minz &&
-              response.scene.world.collision_objects[i].mesh_poses[j].position.z <= maxz))
-        {
-          good = false;
-          break;
-        }
-      for (std::size_t j = 0; j < response.scene.world.collision_objects[i].primitive_poses.size(); ++j)
-        if (!(response.scene.world.collision_objects[i].primitive_poses[j].position.x >= minx &&
-              response.scene.world.collision_objects[i].primitive_poses[j].position.x <= maxx &&
-              response.scene.world.collision_objects[i].primitive_poses[j].position.y >= miny &&
-              response.scene.world.collision_objects[i].primitive_poses[j].position.y <= maxy &&
-              response.scene.world.collision_objects[i].primitive_poses[j].position.z >= minz &&
-              response.scene.world.collision_objects[i].primitive_poses[j].position.z <= maxz))
-        {
-          good = false;
-          break;
-        }
-      if (good)
-      {
-        result.push_back(response.scene.world.collision_objects[i].id);
-        if (with_type)
-          types.push_back(response.scene.world.collision_objects[i].type.key);
-      }
+      result.push_back(object.id);
+      if (with_type)
+        types.push_back(object.type.key);
     }
-    return result;
   }
 
   std::map<std::string, geometry_msgs::Pose> getObjectPoses(const std::vector<std::string>& object_ids)
   {
+    std::map<std::string, geometry_msgs::Pose> result;
+    if (mirror_active_)
+    {
+      boost::mutex::scoped_lock slock(mirror_lock_);
+      for (std::size_t i = 0; i < object_ids.size(); ++i)
+      {
+        ObjectMap::const_iterator it = mirror_objects_.find(object_ids[i]);
+        if (it == mirror_objects_.end())
+          continue;
+        if (!it->second.mesh_poses.empty())
+          result[it->first] = it->second.mesh_poses[0];
+        else if (!it->second.primitive_poses.empty())
+          result[it->first] = it->second.primitive_poses[0];
+      }
+      return result;
+    }
+
     moveit_msgs::GetPlanningScene::Request request;
     moveit_msgs::GetPlanningScene::Response response;
-    std::map<std::string, geometry_msgs::Pose> result;
     request.components.components = request.components.WORLD_OBJECT_GEOMETRY;
     if (!planning_scene_service_.call(request, response))
     {
@@ -165,9 +212,23 @@ public:
 
   std::map<std::string, moveit_msgs::CollisionObject> getObjects(const std::vector<std::string>& object_ids)
   {
+    std::map<std::string, moveit_msgs::CollisionObject> result;
+    if (mirror_active_)
+    {
+      boost::mutex::scoped_lock slock(mirror_lock_);
+      if (object_ids.empty())
+        return mirror_objects_;
+      for (std::size_t i = 0; i < object_ids.size(); ++i)
+      {
+        ObjectMap::const_iterator it = mirror_objects_.find(object_ids[i]);
+        if (it != mirror_objects_.end())
+          result.insert(*it);
+      }
+      return result;
+    }
+
     moveit_msgs::GetPlanningScene::Request request;
     moveit_msgs::GetPlanningScene::Response response;
-    std::map<std::string, moveit_msgs::CollisionObject> result;
     request.components.components = request.components.WORLD_OBJECT_GEOMETRY;
     if (!planning_scene_service_.call(request, response))
     {
@@ -190,9 +251,23 @@ public:
   std::map<std::string, moveit_msgs::AttachedCollisionObject>
   getAttachedObjects(const std::vector<std::string>& object_ids)
   {
+    std::map<std::string, moveit_msgs::AttachedCollisionObject> result;
+    if (mirror_active_)
+    {
+      boost::mutex::scoped_lock slock(mirror_lock_);
+      if (object_ids.empty())
+        return mirror_attached_objects_;
+      for (std::size_t i = 0; i < object_ids.size(); ++i)
+      {
+        AttachedObjectMap::const_iterator it = mirror_attached_objects_.find(object_ids[i]);
+        if (it != mirror_attached_objects_.end())
+          result.insert(*it);
+      }
+      return result;
+    }
+
     moveit_msgs::GetPlanningScene::Request request;
     moveit_msgs::GetPlanningScene::Response response;
-    std::map<std::string, moveit_msgs::AttachedCollisionObject> result;
     request.components.components = request.components.ROBOT_STATE_ATTACHED_OBJECTS;
     if (!planning_scene_service_.call(request, response))
     {
@@ -214,6 +289,27 @@ public:
     return result;
   }
 
+  bool applyCollisionObjects(const std::vector<moveit_msgs::CollisionObject>& collision_objects,
+                             const std::vector<moveit_msgs::ObjectColor>& object_colors)
+  {
+    moveit_msgs::PlanningScene ps;
+    ps.robot_state.is_diff = true;
+    ps.is_diff = true;
+    ps.world.collision_objects = collision_objects;
+    ps.object_colors = object_colors;
+    if (mirror_active_)
+    {
+      reduceToChanges(ps.world.collision_objects);
+      if (ps.world.collision_objects.empty() && ps.object_colors.empty())
+        return true;
+    }
+    if (!applyPlanningScene(ps))
+      return false;
+    if (mirror_active_)
+      applyToMirror(ps.world.collision_objects);
+    return true;
+  }
+
   bool applyPlanningScene(const moveit_msgs::PlanningScene& planning_scene)
   {
     moveit_msgs::ApplyPlanningScene::Request request;
@@ -234,7 +330,15 @@ public:
     planning_scene.world.collision_objects = collision_objects;
     planning_scene.object_colors = object_colors;
     planning_scene.is_diff = true;
+    if (mirror_active_)
+    {
+      reduceToChanges(planning_scene.world.collision_objects);
+      if (planning_scene.world.collision_objects.empty() && planning_scene.object_colors.empty())
+        return;
+    }
     planning_scene_diff_publisher_.publish(planning_scene);
+    if (mirror_active_)
+      applyToMirror(planning_scene.world.collision_objects);
   }
 
   void removeCollisionObjects(const std::vector<std::string>& object_ids) const
@@ -249,14 +353,190 @@ public:
     }
     planning_scene.is_diff = true;
     planning_scene_diff_publisher_.publish(planning_scene);
+    if (mirror_active_)
+      applyToMirror(planning_scene.world.collision_objects);
+  }
+
+  bool startSceneMirror(const std::string& topic)
+  {
+    if (mirror_active_)
+      return true;
+    scene_subscriber_ = node_handle_.subscribe(topic, 100, &PlanningSceneInterfaceImpl::sceneCallback, this);
+
+    moveit_msgs::GetPlanningScene::Request request;
+    moveit_msgs::GetPlanningScene::Response response;
+    request.components.components =
+        request.components.WORLD_OBJECT_GEOMETRY | request.components.ROBOT_STATE_ATTACHED_OBJECTS;
+    if (!planning_scene_service_.call(request, response))
+    {
+      ROS_WARN_NAMED("planning_scene_interface", "Could not call planning scene service to start the scene mirror");
+      scene_subscriber_.shutdown();
+      return false;
+    }
+    response.scene.is_diff = false;
+    applyToMirror(response.scene);
+    mirror_active_ = true;
+    return true;
+  }
+
+  void stopSceneMirror()
+  {
+    mirror_active_ = false;
+    scene_subscriber_.shutdown();
+    boost::mutex::scoped_lock slock(mirror_lock_);
+    mirror_objects_.clear();
+    mirror_attached_objects_.clear();
+  }
+
+  bool isSceneMirrorActive() const
+  {
+    return mirror_active_;
   }
 
 private:
+  typedef std::map<std::string, moveit_msgs::CollisionObject> ObjectMap;
+  typedef std::map<std::string, moveit_msgs::AttachedCollisionObject> AttachedObjectMap;
+
+  void sceneCallback(const moveit_msgs::PlanningSceneConstPtr& scene)
+  {
+    applyToMirror(*scene);
+  }
+
+  void applyToMirror(const moveit_msgs::PlanningScene& scene) const
+  {
+    boost::mutex::scoped_lock slock(mirror_lock_);
+    if (!scene.is_diff)
+      mirror_objects_.clear();
+    for (std::size_t i = 0; i < scene.world.collision_objects.size(); ++i)
+      applyToMirror(scene.world.collision_objects[i]);
+
+    // scene diffs carry the complete robot state when it changed, and an empty one otherwise
+    const moveit_msgs::RobotState& state = scene.robot_state;
+    if (!scene.is_diff ||
+        (!state.is_diff && (!state.joint_state.name.empty() || !state.multi_dof_joint_state.joint_names.empty())))
+    {
+      mirror_attached_objects_.clear();
+      for (std::size_t i = 0; i < state.attached_collision_objects.size(); ++i)
+        mirror_attached_objects_[state.attached_collision_objects[i].object.id] = state.attached_collision_objects[i];
+    }
+    else
+      for (std::size_t i = 0; i < state.attached_collision_objects.size(); ++i)
+      {
+        const moveit_msgs::AttachedCollisionObject& aco = state.attached_collision_objects[i];
+        if (aco.object.operation == moveit_msgs::CollisionObject::REMOVE)
+        {
+          if (aco.object.id.empty())
+            mirror_attached_objects_.clear();
+          else
+            mirror_attached_objects_.erase(aco.object.id);
+        }
+        else
+          mirror_attached_objects_[aco.object.id] = aco;
+      }
+  }
+
+  void applyToMirror(const std::vector<moveit_msgs::CollisionObject>& objects) const
+  {
+    boost::mutex::scoped_lock slock(mirror_lock_);
+    for (std::size_t i = 0; i < objects.size(); ++i)
+      applyToMirror(objects[i]);
+  }
+
+  // called with mirror_lock_ held
+  void applyToMirror(const moveit_msgs::CollisionObject& object) const
+  {
+    switch (object.operation)
+    {
+      case moveit_msgs::CollisionObject::ADD:
+        mirror_objects_[object.id] = object;
+        break;
+      case moveit_msgs::CollisionObject::REMOVE:
+        if (object.id.empty())
+          mirror_objects_.clear();
+        else
+          mirror_objects_.erase(object.id);
+        break;
+      case moveit_msgs::CollisionObject::APPEND:
+      {
+        ObjectMap::iterator it = mirror_objects_.find(object.id);
+        if (it == mirror_objects_.end())
+        {
+          mirror_objects_[object.id] = object;
+          mirror_objects_[object.id].operation = moveit_msgs::CollisionObject::ADD;
+          break;
+        }
+        moveit_msgs::CollisionObject& mirrored = it->second;
+        mirrored.primitives.insert(mirrored.primitives.end(), object.primitives.begin(), object.primitives.end());
+        mirrored.primitive_poses.insert(mirrored.primitive_poses.end(), object.primitive_poses.begin(),
+                                        object.primitive_poses.end());
+        mirrored.meshes.insert(mirrored.meshes.end(), object.meshes.begin(), object.meshes.end());
+        mirrored.mesh_poses.insert(mirrored.mesh_poses.end(), object.mesh_poses.begin(), object.mesh_poses.end());
+        mirrored.planes.insert(mirrored.planes.end(), object.planes.begin(), object.planes.end());
+        mirrored.plane_poses.insert(mirrored.plane_poses.end(), object.plane_poses.begin(), object.plane_poses.end());
+        break;
+      }
+      case moveit_msgs::CollisionObject::MOVE:
+      {
+        ObjectMap::iterator it = mirror_objects_.find(object.id);
+        if (it != mirror_objects_.end() && it->second.primitives.size() == object.primitive_poses.size() &&
+            it->second.meshes.size() == object.mesh_poses.size() &&
+            it->second.planes.size() == object.plane_poses.size())
+        {
+          it->second.header = object.header;
+          it->second.primitive_poses = object.primitive_poses;
+          it->second.mesh_poses = object.mesh_poses;
+          it->second.plane_poses = object.plane_poses;
+        }
+        break;
+      }
+    }
+  }
+
+  /** \brief Drop the objects that are already in the scene as they are, and turn the ones whose geometry did not
+      change into MOVE operations that only carry the new poses */
+  void reduceToChanges(std::vector<moveit_msgs::CollisionObject>& objects) const
+  {
+    boost::mutex::scoped_lock slock(mirror_lock_);
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i < objects.size(); ++i)
+    {
+      moveit_msgs::CollisionObject& object = objects[i];
+      ObjectMap::const_iterator it = mirror_objects_.end();
+      if (object.operation == moveit_msgs::CollisionObject::ADD)
+        it = mirror_objects_.find(object.id);
+      if (it != mirror_objects_.end() && it->second.header.frame_id == object.header.frame_id &&
+          it->second.type.key == object.type.key && it->second.type.db == object.type.db &&
+          sameSerialization(it->second.primitives, object.primitives) &&
+          sameSerialization(it->second.meshes, object.meshes) && sameSerialization(it->second.planes, object.planes))
+      {
+        if (sameSerialization(it->second.primitive_poses, object.primitive_poses) &&
+            sameSerialization(it->second.mesh_poses, object.mesh_poses) &&
+            sameSerialization(it->second.plane_poses, object.plane_poses))
+          continue;
+        object.operation = moveit_msgs::CollisionObject::MOVE;
+        object.primitives.clear();
+        object.meshes.clear();
+        object.planes.clear();
+      }
+      if (kept != i)
+        std::swap(objects[kept], object);
+      ++kept;
+    }
+    objects.resize(kept);
+  }
+
   ros::NodeHandle node_handle_;
   ros::ServiceClient planning_scene_service_;
   ros::ServiceClient apply_planning_scene_service_;
   ros::Publisher planning_scene_diff_publisher_;
   robot_model::RobotModelConstPtr robot_model_;
+
+  ros::Subscriber scene_subscriber_;
+  std::atomic<bool> mirror_active_;
+  // the mirror is also updated by the const methods that publish scene updates
+  mutable boost::mutex mirror_lock_;
+  mutable ObjectMap mirror_objects_;
+  mutable AttachedObjectMap mirror_attached_objects_;
 };
 
 PlanningSceneInterface::PlanningSceneInterface()
@@ -302,38 +582,24 @@ PlanningSceneInterface::getAttachedObjects(const std::vector<std::string>& objec
 
 bool PlanningSceneInterface::applyCollisionObject(const moveit_msgs::CollisionObject& collision_object)
 {
-  moveit_msgs::PlanningScene ps;
-  ps.robot_state.is_diff = true;
-  ps.is_diff = true;
-  ps.world.collision_objects.reserve(1);
-  ps.world.collision_objects.push_back(collision_object);
-  return applyPlanningScene(ps);
+  return impl_->applyCollisionObjects(std::vector<moveit_msgs::CollisionObject>(1, collision_object),
+                                      std::vector<moveit_msgs::ObjectColor>());
 }
 
 bool PlanningSceneInterface::applyCollisionObject(const moveit_msgs::CollisionObject& collision_object,
                                                   const std_msgs::ColorRGBA& object_color)
 {
-  moveit_msgs::PlanningScene ps;
-  ps.robot_state.is_diff = true;
-  ps.is_diff = true;
-  ps.world.collision_objects.reserve(1);
-  ps.world.collision_objects.push_back(collision_object);
   moveit_msgs::ObjectColor oc;
   oc.id = collision_object.id;
   oc.color = object_color;
-  ps.object_colors.push_back(oc);
-  return applyPlanningScene(ps);
+  return impl_->applyCollisionObjects(std::vector<moveit_msgs::CollisionObject>(1, collision_object),
+                                      std::vector<moveit_msgs::ObjectColor>(1, oc));
 }
 
 bool PlanningSceneInterface::applyCollisionObjects(const std::vector<moveit_msgs::CollisionObject>& collision_objects,
                                                    const std::vector<moveit_msgs::ObjectColor>& object_colors)
 {
-  moveit_msgs::PlanningScene ps;
-  ps.robot_state.is_diff = true;
-  ps.is_diff = true;
-  ps.world.collision_objects = collision_objects;
-  ps.object_colors = object_colors;
-  return applyPlanningScene(ps);
+  return impl_->applyCollisionObjects(collision_objects, object_colors);
 }
 
 bool PlanningSceneInterface::applyAttachedCollisionObject(const moveit_msgs::AttachedCollisionObject& collision_object)
@@ -371,5 +637,20 @@ void PlanningSceneInterface::removeCollisionObjects(const std::vector<std::strin
 {
   impl_->removeCollisionObjects(object_ids);
 }
+
+bool PlanningSceneInterface::startSceneMirror(const std::string& topic)
+{
+  return impl_->startSceneMirror(topic);
+}
+
+void PlanningSceneInterface::stopSceneMirror()
+{
+  impl_->stopSceneMirror();
+}
+
+bool PlanningSceneInterface::isSceneMirrorActive() const
+{
+  return impl_->isSceneMirrorActive();
+}
 }
 }
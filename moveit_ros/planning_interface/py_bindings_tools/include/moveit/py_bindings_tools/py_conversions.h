@@ -39,6 +39,7 @@
 
 #include <boost/python.hpp>
 #include <boost/python/stl_iterator.hpp>
+#include <Python.h>
 #include <string>
 #include <vector>
 #include <map>
@@ -93,6 +94,71 @@ boost::python::list listFromString(const std::vector<std::string>& v)
 {
   return listFromType<std::string>(v);
 }
+
+/** \brief Read access to the memory of a C-contiguous array of doubles exported through the buffer protocol (e.g., a
+    float64 NumPy array). The values are not copied; the buffer is held until this object is destroyed. */
+class DoubleBuffer
+{
+public:
+  explicit DoubleBuffer(const boost::python::object& values)
+  {
+    if (PyObject_GetBuffer(values.ptr(), &view_, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) != 0)
+      boost::python::throw_error_already_set();
+    // only native doubles are accepted
+    const std::string format = view_.format ? view_.format : "B";
+    if (view_.itemsize != sizeof(double) || (format != "d" && format != "@d" && format != "=d"))
+    {
+      PyBuffer_Release(&view_);
+      PyErr_SetString(PyExc_TypeError, "expected a contiguous buffer of float64 values");
+      boost::python::throw_error_already_set();
+    }
+  }
+
+  ~DoubleBuffer()
+  {
+    PyBuffer_Release(&view_);
+  }
+
+  const double* data() const
+  {
+    return static_cast<const double*>(view_.buf);
+  }
+
+  std::size_t size() const
+  {
+    return view_.len / sizeof(double);
+  }
+
+private:
+  DoubleBuffer(const DoubleBuffer&);
+  DoubleBuffer& operator=(const DoubleBuffer&);
+
+  Py_buffer view_;
+};
+
+/** \brief A Python bytearray of \e count doubles that is filled in place from C++. Python code wraps it without
+    copying using numpy.frombuffer(array, dtype=numpy.float64). */
+class DoubleArray
+{
+public:
+  explicit DoubleArray(std::size_t count)
+    : array_(boost::python::handle<>(PyByteArray_FromStringAndSize(NULL, count * sizeof(double))))
+  {
+  }
+
+  double* data()
+  {
+    return reinterpret_cast<double*>(PyByteArray_AS_STRING(array_.ptr()));
+  }
+
+  const boost::python::object& object() const
+  {
+    return array_;
+  }
+
+private:
+  boost::python::object array_;
+};
 }
 }
 
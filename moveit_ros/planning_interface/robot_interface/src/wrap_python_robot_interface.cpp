@@ -36,12 +36,16 @@
 
 #include <moveit/common_planning_interface_objects/common_objects.h>
 #include <moveit/robot_state/conversions.h>
+#include <moveit/robot_state/batch_robot_state.h>
+#include <moveit/planning_scene/planning_scene.h>
 #include <moveit/py_bindings_tools/roscpp_initializer.h>
 #include <moveit/py_bindings_tools/py_conversions.h>
 #include <moveit/py_bindings_tools/serialize_msg.h>
 #include <moveit_msgs/RobotState.h>
 
 #include <stdexcept>
+#include <limits>
+#include <boost/lexical_cast.hpp>
 #include <boost/python.hpp>
 #include <Python.h>
 
@@ -230,9 +234,169 @@ public:
     return robot_model_->hasJointModelGroup(group);
   }
 
+  bp::list getVariableNames() const
+  {
+    return py_bindings_tools::listFromString(robot_model_->getVariableNames());
+  }
+
+  bp::list getGroupVariableNames(const std::string& group) const
+  {
+    return py_bindings_tools::listFromString(getGroup(group)->getVariableNames());
+  }
+
+  unsigned int getGroupVariableCount(const std::string& group) const
+  {
+    return getGroup(group)->getVariableCount();
+  }
+
+  bp::object getCurrentVariableArray()
+  {
+    robot_state::RobotStatePtr state = getReferenceState();
+    py_bindings_tools::DoubleArray result(robot_model_->getVariableCount());
+    std::copy(state->getVariablePositions(), state->getVariablePositions() + robot_model_->getVariableCount(),
+              result.data());
+    return result.object();
+  }
+
+  // the batched calls below take and return flat float64 arrays; configurations are the variables of the group, in
+  // the order of getVariableNames() for the group, and poses are (x, y, z, qx, qy, qz, qw) in the planning frame
+
+  bp::object computeFKBatch(const std::string& group, const std::string& link, const bp::object& positions)
+  {
+    const robot_model::JointModelGroup* jmg = getGroup(group);
+    const robot_model::LinkModel* lm = robot_model_->getLinkModel(link);
+    if (!lm)
+      throw std::runtime_error("RobotInterfacePython: unknown link '" + link + "'");
+    py_bindings_tools::DoubleBuffer values(positions);
+    const std::size_t count = getBatchCount(jmg, values.size());
+
+    robot_state::RobotStatePtr state = getReferenceState();
+    robot_state::BatchRobotState batch(*state, jmg);
+    batch.computeFKBatch(values.data(), count);
+
+    py_bindings_tools::DoubleArray result(7 * count);
+    double* out = result.data();
+    for (std::size_t i = 0; i < count; ++i, out += 7)
+    {
+      const Eigen::Affine3d t = batch.getGlobalLinkTransform(lm, i);
+      const Eigen::Quaterniond q(t.rotation());
+      out[0] = t.translation().x();
+      out[1] = t.translation().y();
+      out[2] = t.translation().z();
+      out[3] = q.x();
+      out[4] = q.y();
+      out[5] = q.z();
+      out[6] = q.w();
+    }
+    return result.object();
+  }
+
+  bp::tuple computeIKBatch(const std::string& group, const bp::object& poses, const std::string& tip, double timeout)
+  {
+    const robot_model::JointModelGroup* jmg = getGroup(group);
+    py_bindings_tools::DoubleBuffer values(poses);
+    if (values.size() % 7)
+      throw std::runtime_error("RobotInterfacePython: poses must be given as 7 values each");
+    const std::size_t count = values.size() / 7;
+    const std::size_t n = jmg->getVariableCount();
+
+    // each solution seeds the next one, so consecutive poses along a path give consecutive configurations
+    robot_state::RobotState state(*getReferenceState());
+    py_bindings_tools::DoubleArray result(n * count);
+    double* out = result.data();
+    bp::list found;
+    for (std::size_t i = 0; i < count; ++i, out += n)
+    {
+      const double* p = values.data() + 7 * i;
+      Eigen::Affine3d pose(Eigen::Quaterniond(p[6], p[3], p[4], p[5]).normalized());
+      pose.translation() = Eigen::Vector3d(p[0], p[1], p[2]);
+      const bool ok =
+          tip.empty() ? state.setFromIK(jmg, pose, 0, timeout) : state.setFromIK(jmg, pose, tip, 0, timeout);
+      if (ok)
+        state.copyJointGroupPositions(jmg, out);
+      else
+        std::fill(out, out + n, std::numeric_limits<double>::quiet_NaN());
+      found.append(ok);
+    }
+    return bp::make_tuple(result.object(), found);
+  }
+
+  bp::list isValidBatch(const std::string& group, const bp::object& positions)
+  {
+    const robot_model::JointModelGroup* jmg = getGroup(group);
+    py_bindings_tools::DoubleBuffer values(positions);
+    const std::size_t count = getBatchCount(jmg, values.size());
+    if (!scene_)
+      scene_.reset(new planning_scene::PlanningScene(robot_model_));
+
+    robot_state::RobotState state(*getReferenceState());
+    bp::list valid;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      state.setJointGroupPositions(jmg, values.data() + i * jmg->getVariableCount());
+      valid.append(state.satisfiesBounds(jmg) && !scene_->isStateColliding(state, group));
+    }
+    return valid;
+  }
+
+  bp::object getJacobianBatch(const std::string& group, const bp::object& positions, const std::string& link)
+  {
+    const robot_model::JointModelGroup* jmg = getGroup(group);
+    const robot_model::LinkModel* lm = link.empty() ? jmg->getLinkModels().back() : robot_model_->getLinkModel(link);
+    if (!lm)
+      throw std::runtime_error("RobotInterfacePython: unknown link '" + link + "'");
+    py_bindings_tools::DoubleBuffer values(positions);
+    const std::size_t count = getBatchCount(jmg, values.size());
+    const std::size_t n = jmg->getVariableCount();
+
+    // row-major 6 x n matrices, one after the other
+    robot_state::RobotState state(*getReferenceState());
+    Eigen::MatrixXd jacobian;
+    py_bindings_tools::DoubleArray result(6 * n * count);
+    typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RowMajorMatrix;
+    Eigen::Map<RowMajorMatrix> out(result.data(), 6 * count, n);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      state.setJointGroupPositions(jmg, values.data() + i * n);
+      if (!state.getJacobian(jmg, lm, Eigen::Vector3d::Zero(), jacobian))
+        throw std::runtime_error("RobotInterfacePython: unable to compute the Jacobian of group '" + group + "'");
+      out.block(6 * i, 0, 6, n) = jacobian;
+    }
+    return result.object();
+  }
+
 private:
+  const robot_model::JointModelGroup* getGroup(const std::string& group) const
+  {
+    const robot_model::JointModelGroup* jmg = robot_model_->getJointModelGroup(group);
+    if (!jmg)
+      throw std::runtime_error("RobotInterfacePython: unknown group '" + group + "'");
+    return jmg;
+  }
+
+  std::size_t getBatchCount(const robot_model::JointModelGroup* jmg, std::size_t value_count) const
+  {
+    const std::size_t n = jmg->getVariableCount();
+    if (n == 0 || value_count % n)
+      throw std::runtime_error("RobotInterfacePython: configurations of group '" + jmg->getName() +
+                               "' must be given as " + boost::lexical_cast<std::string>(n) + " values each");
+    return value_count / n;
+  }
+
+  /** \brief The current state if it is known, otherwise the default state; variables outside the batched group take
+      their values from it */
+  robot_state::RobotStatePtr getReferenceState()
+  {
+    if (ensureCurrentState())
+      return current_state_monitor_->getCurrentState();
+    robot_state::RobotStatePtr state(new robot_state::RobotState(robot_model_));
+    state->setToDefaultValues();
+    return state;
+  }
+
   robot_model::RobotModelConstPtr robot_model_;
   planning_scene_monitor::CurrentStateMonitorPtr current_state_monitor_;
+  planning_scene::PlanningScenePtr scene_;
 };
 }
 
@@ -257,6 +421,14 @@ static void wrap_robot_interface()
   RobotClass.def("get_robot_root_link", &RobotInterfacePython::getRobotRootLink);
   RobotClass.def("has_group", &RobotInterfacePython::hasGroup);
   RobotClass.def("get_robot_name", &RobotInterfacePython::getRobotName);
+  RobotClass.def("get_variable_names", &RobotInterfacePython::getVariableNames);
+  RobotClass.def("get_group_variable_names", &RobotInterfacePython::getGroupVariableNames);
+  RobotClass.def("get_group_variable_count", &RobotInterfacePython::getGroupVariableCount);
+  RobotClass.def("get_current_variable_array", &RobotInterfacePython::getCurrentVariableArray);
+  RobotClass.def("compute_fk_batch", &RobotInterfacePython::computeFKBatch);
+  RobotClass.def("compute_ik_batch", &RobotInterfacePython::computeIKBatch);
+  RobotClass.def("is_valid_batch", &RobotInterfacePython::isValidBatch);
+  RobotClass.def("get_jacobian_batch", &RobotInterfacePython::getJacobianBatch);
 }
 
 BOOST_PYTHON_MODULE(_moveit_robot_interface)
@@ -7,6 +7,7 @@ import rostest
 import os
 
 from moveit_ros_planning_interface._moveit_move_group_interface import MoveGroupInterface
+from moveit_ros_planning_interface._moveit_robot_interface import RobotInterface
 
 
 class PythonMoveGroupTest(unittest.TestCase):
@@ -56,6 +57,41 @@ class PythonMoveGroupTest(unittest.TestCase):
         plan3 = self.plan(current)
         self.assertTrue(self.group.execute(plan3))
 
+    def test_arrays(self):
+        current = np.frombuffer(self.group.get_current_joint_values_array())
+        self.assertTrue(np.allclose(current, self.group.get_current_joint_values()))
+
+        self.group.set_joint_value_target(current + 0.2)
+        (success, names, positions, velocities, accelerations, times) = self.group.compute_plan_arrays()
+        self.assertTrue(success)
+        positions = np.frombuffer(positions).reshape(-1, len(names))
+        self.assertTrue(np.allclose(positions[-1], current + 0.2))
+        self.assertTrue(self.group.execute_arrays(names, positions, np.frombuffer(velocities),
+                                                  np.frombuffer(accelerations), np.frombuffer(times), True))
+
+    def test_batches(self):
+        robot = RobotInterface("robot_description")
+        n = robot.get_group_variable_count(self.PLANNING_GROUP)
+        link = robot.get_group_link_names(self.PLANNING_GROUP)[-1]
+        positions = np.zeros((3, n))
+        positions[1] += 0.1
+        positions[2] += 10.0
+
+        poses = np.frombuffer(robot.compute_fk_batch(self.PLANNING_GROUP, link, positions)).reshape(-1, 7)
+        self.assertEqual(poses.shape, (3, 7))
+        self.assertFalse(np.allclose(poses[0], poses[1]))
+
+        (solutions, found) = robot.compute_ik_batch(self.PLANNING_GROUP, poses[:2], "", 0.1)
+        self.assertEqual(found, [True, True])
+        solutions = np.frombuffer(solutions).reshape(-1, n)
+        refound = np.frombuffer(robot.compute_fk_batch(self.PLANNING_GROUP, link, solutions)).reshape(-1, 7)
+        self.assertTrue(np.allclose(refound[:, :3], poses[:2, :3], atol=1e-4))
+
+        self.assertEqual(robot.is_valid_batch(self.PLANNING_GROUP, positions)[2], False)
+
+        jacobians = np.frombuffer(robot.get_jacobian_batch(self.PLANNING_GROUP, positions, "")).reshape(-1, 6, n)
+        self.assertEqual(jacobians.shape, (3, 6, n))
+
 
 if __name__ == '__main__':
     PKGNAME = 'moveit_ros_planning_interface'
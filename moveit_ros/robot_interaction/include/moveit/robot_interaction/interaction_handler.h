@@ -43,6 +43,7 @@
 #include <visualization_msgs/InteractiveMarkerFeedback.h>
 #include <interactive_markers/menu_handler.h>
 #include <tf/tf.h>
+#include <atomic>
 
 namespace robot_interaction
 {
@@ -223,6 +224,15 @@ public:
    */
   void setRobotInteraction(RobotInteraction* robot_interaction);
 
+  /** \brief This should only be called by RobotInteraction.
+   * Signal that newer feedback is waiting for the marker whose feedback is
+   * being handled, so IK for the older feedback stops after its current
+   * attempt. */
+  void setSuperseded(bool superseded)
+  {
+    superseded_ = superseded;
+  }
+
 protected:
   bool transformFeedbackPose(const visualization_msgs::InteractiveMarkerFeedbackConstPtr& feedback,
                              const geometry_msgs::Pose& offset, geometry_msgs::PoseStamped& tpose);
@@ -321,6 +331,9 @@ private:
   // PROTECTED BY state_lock_
   bool display_controls_;
 
+  // set while newer feedback is waiting for the marker being handled
+  std::atomic<bool> superseded_;
+
   // remove '_' characters from name
   static std::string fixName(std::string name);
 
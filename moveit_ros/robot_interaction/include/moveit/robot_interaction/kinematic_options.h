@@ -39,6 +39,7 @@
 
 #include <moveit/kinematics_base/kinematics_base.h>
 #include <moveit/robot_state/robot_state.h>
+#include <atomic>
 
 namespace robot_interaction
 {
@@ -75,6 +76,14 @@ struct KinematicOptions
   bool setStateFromIK(robot_state::RobotState& state, const std::string& group, const std::string& tip,
                       const geometry_msgs::Pose& pose) const;
 
+  /// Set \e state using inverse kinematics, giving up before the next IK
+  /// attempt once \e cancel is set. The first attempt starts from the current
+  /// joint values of \e state; if no solution is found, they are restored.
+  /// @param cancel set by another thread when the result is no longer needed
+  /// @param result true if IK succeeded.
+  bool setStateFromIK(robot_state::RobotState& state, const std::string& group, const std::string& tip,
+                      const geometry_msgs::Pose& pose, const std::atomic<bool>& cancel) const;
+
   /// Copy a subset of source to this.
   /// For each bit set in fields the corresponding member is copied from
   /// source to this.
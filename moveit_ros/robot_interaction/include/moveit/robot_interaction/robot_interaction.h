@@ -204,6 +204,10 @@ private:
   boost::condition_variable new_feedback_condition_;
   std::map<std::string, visualization_msgs::InteractiveMarkerFeedbackConstPtr> feedback_map_;
 
+  // the marker whose feedback the processing thread is handling, and its handler
+  std::string processing_marker_;
+  ::robot_interaction::InteractionHandlerPtr processing_handler_;
+
   robot_model::RobotModelConstPtr robot_model_;
 
   std::vector<EndEffectorInteraction> active_eef_;
@@ -65,6 +65,7 @@ InteractionHandler::InteractionHandler(const RobotInteractionPtr& robot_interact
   , kinematic_options_map_(robot_interaction->getKinematicOptionsMap())
   , display_meshes_(true)
   , display_controls_(true)
+  , superseded_(false)
 {
   setRobotInteraction(robot_interaction.get());
 }
@@ -79,6 +80,7 @@ InteractionHandler::InteractionHandler(const RobotInteractionPtr& robot_interact
   , kinematic_options_map_(robot_interaction->getKinematicOptionsMap())
   , display_meshes_(true)
   , display_controls_(true)
+  , superseded_(false)
 {
   setRobotInteraction(robot_interaction.get());
 }
@@ -94,6 +96,7 @@ InteractionHandler::InteractionHandler(const std::string& name, const robot_stat
   , kinematic_options_map_(new KinematicOptionsMap)
   , display_meshes_(true)
   , display_controls_(true)
+  , superseded_(false)
 {
 }
 
@@ -108,6 +111,7 @@ InteractionHandler::InteractionHandler(const std::string& name, const robot_mode
   , kinematic_options_map_(new KinematicOptionsMap)
   , display_meshes_(true)
   , display_controls_(true)
+  , superseded_(false)
 {
 }
 
@@ -328,7 +332,7 @@ void InteractionHandler::updateStateEndEffector(robot_state::RobotState* state,
   // access kinematic_options_map_.
   KinematicOptions kinematic_options = kinematic_options_map_->getOptions(eef->parent_group);
 
-  bool ok = kinematic_options.setStateFromIK(*state, eef->parent_group, eef->parent_link, *pose);
+  bool ok = kinematic_options.setStateFromIK(*state, eef->parent_group, eef->parent_link, *pose, superseded_);
   bool error_state_changed = setErrorState(eef->parent_group, !ok);
   if (update_callback_)
     *callback = boost::bind(update_callback_, _1, error_state_changed);
@@ -60,6 +60,43 @@ bool robot_interaction::KinematicOptions::setStateFromIK(robot_state::RobotState
   return result;
 }
 
+bool robot_interaction::KinematicOptions::setStateFromIK(robot_state::RobotState& state, const std::string& group,
+                                                         const std::string& tip, const geometry_msgs::Pose& pose,
+                                                         const std::atomic<bool>& cancel) const
+{
+  const robot_model::JointModelGroup* jmg = state.getJointModelGroup(group);
+  if (!jmg)
+  {
+    ROS_ERROR("No getJointModelGroup('%s') found", group.c_str());
+    return false;
+  }
+
+  // random restarts would not keep the redundant joints locked, so this is left to setFromIK()
+  if (options_.lock_redundant_joints)
+    return setStateFromIK(state, group, tip, pose);
+
+  // the attempts are made here rather than in setFromIK() so they can stop early; the first one is seeded with the
+  // current joint values, which usually are the solution for the previous pose of the same marker
+  unsigned int attempts = max_attempts_ ? max_attempts_ : jmg->getDefaultIKAttempts();
+  std::vector<double> initial_values;
+  state.copyJointGroupPositions(jmg, initial_values);
+  bool result = false;
+  for (unsigned int i = 0; i < attempts && !result; ++i)
+  {
+    if (i > 0)
+    {
+      if (cancel.load())
+        break;
+      state.setToRandomPositions(jmg);
+    }
+    result = state.setFromIK(jmg, pose, tip, 1, timeout_seconds_, state_validity_callback_, options_);
+  }
+  if (!result)
+    state.setJointGroupPositions(jmg, initial_values);
+  state.update();
+  return result;
+}
+
 void robot_interaction::KinematicOptions::setOptions(const KinematicOptions& source, OptionBitmask fields)
 {
 // This function is implemented with the O_FIELDS and QO_FIELDS macros to
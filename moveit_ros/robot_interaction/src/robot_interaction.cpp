@@ -742,6 +742,9 @@ void RobotInteraction::processInteractiveMarkerFeedback(
   }
 
   feedback_map_[feedback->marker_name] = feedback;
+  // IK for older feedback of the same marker is not worth finishing
+  if (processing_handler_ && processing_marker_ == feedback->marker_name)
+    processing_handler_->setSuperseded(true);
   new_feedback_condition_.notify_all();
 }
 
@@ -794,6 +797,9 @@ void RobotInteraction::processingThread()
           // make a copy of the data, so we do not lose it while we are unlocked
           EndEffectorInteraction eef = active_eef_[it->second];
           ::robot_interaction::InteractionHandlerPtr ih = jt->second;
+          ih->setSuperseded(false);
+          processing_marker_ = feedback->marker_name;
+          processing_handler_ = ih;
           marker_access_lock_.unlock();
           try
           {
@@ -804,6 +810,8 @@ void RobotInteraction::processingThread()
             ROS_ERROR("Exception caught while handling end-effector update: %s", ex.what());
           }
           marker_access_lock_.lock();
+          processing_handler_.reset();
+          processing_marker_.clear();
         }
         else if (marker_class == "JJ")
         {
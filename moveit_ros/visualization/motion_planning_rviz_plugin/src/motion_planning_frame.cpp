@@ -318,7 +318,7 @@ void MotionPlanningFrame::changePlanningGroupHelper()
       if (move_group_->getInterfaceDescription(desc))
         planning_display_->addMainLoopJob(boost::bind(&MotionPlanningFrame::populatePlannersList, this, desc));
       planning_display_->addBackgroundJob(boost::bind(&MotionPlanningFrame::populateConstraintsList, this),
-                                          "populateConstraintsList");
+                                          "populateConstraintsList", moveit::tools::BackgroundProcessing::LOW_PRIORITY);
 
       if (first_time_)
       {
@@ -54,7 +54,7 @@ namespace moveit_rviz_plugin
 void MotionPlanningFrame::databaseConnectButtonClicked()
 {
   planning_display_->addBackgroundJob(boost::bind(&MotionPlanningFrame::computeDatabaseConnectButtonClicked, this),
-                                      "connect to database");
+                                      "connect to database", moveit::tools::BackgroundProcessing::LOW_PRIORITY);
 }
 
 void MotionPlanningFrame::publishSceneButtonClicked()
@@ -104,7 +104,8 @@ void MotionPlanningFrame::resetDbButtonClicked()
     return;
 
   planning_display_->addBackgroundJob(
-      boost::bind(&MotionPlanningFrame::computeResetDbButtonClicked, this, response.toStdString()), "reset database");
+      boost::bind(&MotionPlanningFrame::computeResetDbButtonClicked, this, response.toStdString()), "reset database",
+      moveit::tools::BackgroundProcessing::LOW_PRIORITY);
 }
 
 void MotionPlanningFrame::computeDatabaseConnectButtonClicked()
@@ -201,7 +202,7 @@ void MotionPlanningFrame::computeDatabaseConnectButtonClickedHelper(int mode)
     {
       move_group_->setConstraintsDatabase(ui_->database_host->text().toStdString(), ui_->database_port->value());
       planning_display_->addBackgroundJob(boost::bind(&MotionPlanningFrame::populateConstraintsList, this),
-                                          "populateConstraintsList");
+                                          "populateConstraintsList", moveit::tools::BackgroundProcessing::LOW_PRIORITY);
     }
   }
 }
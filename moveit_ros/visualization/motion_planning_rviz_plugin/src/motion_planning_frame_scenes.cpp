@@ -109,7 +109,7 @@ void MotionPlanningFrame::saveSceneButtonClicked()
     }
 
     planning_display_->addBackgroundJob(boost::bind(&MotionPlanningFrame::computeSaveSceneButtonClicked, this),
-                                        "save scene");
+                                        "save scene", moveit::tools::BackgroundProcessing::LOW_PRIORITY);
   }
 }
 
@@ -132,7 +132,8 @@ void MotionPlanningFrame::saveQueryButtonClicked()
       {
         std::string scene = s->text(0).toStdString();
         planning_display_->addBackgroundJob(
-            boost::bind(&MotionPlanningFrame::computeSaveQueryButtonClicked, this, scene, ""), "save query");
+            boost::bind(&MotionPlanningFrame::computeSaveQueryButtonClicked, this, scene, ""), "save query",
+            moveit::tools::BackgroundProcessing::LOW_PRIORITY);
       }
       else
       {
@@ -176,7 +177,8 @@ void MotionPlanningFrame::saveQueryButtonClicked()
           }
         }
         planning_display_->addBackgroundJob(
-            boost::bind(&MotionPlanningFrame::computeSaveQueryButtonClicked, this, scene, query_name), "save query");
+            boost::bind(&MotionPlanningFrame::computeSaveQueryButtonClicked, this, scene, query_name), "save query",
+            moveit::tools::BackgroundProcessing::LOW_PRIORITY);
       }
     }
   }
@@ -185,25 +187,25 @@ void MotionPlanningFrame::saveQueryButtonClicked()
 void MotionPlanningFrame::deleteSceneButtonClicked()
 {
   planning_display_->addBackgroundJob(boost::bind(&MotionPlanningFrame::computeDeleteSceneButtonClicked, this),
-                                      "delete scene");
+                                      "delete scene", moveit::tools::BackgroundProcessing::LOW_PRIORITY);
 }
 
 void MotionPlanningFrame::deleteQueryButtonClicked()
 {
   planning_display_->addBackgroundJob(boost::bind(&MotionPlanningFrame::computeDeleteQueryButtonClicked, this),
-                                      "delete query");
+                                      "delete query", moveit::tools::BackgroundProcessing::LOW_PRIORITY);
 }
 
 void MotionPlanningFrame::loadSceneButtonClicked()
 {
-  planning_display_->addBackgroundJob(boost::bind(&MotionPlanningFrame::computeLoadSceneButtonClicked, this), "load "
-                                                                                                              "scene");
+  planning_display_->addBackgroundJob(boost::bind(&MotionPlanningFrame::computeLoadSceneButtonClicked, this),
+                                      "load scene", moveit::tools::BackgroundProcessing::LOW_PRIORITY);
 }
 
 void MotionPlanningFrame::loadQueryButtonClicked()
 {
-  planning_display_->addBackgroundJob(boost::bind(&MotionPlanningFrame::computeLoadQueryButtonClicked, this), "load "
-                                                                                                              "query");
+  planning_display_->addBackgroundJob(boost::bind(&MotionPlanningFrame::computeLoadQueryButtonClicked, this),
+                                      "load query", moveit::tools::BackgroundProcessing::LOW_PRIORITY);
 }
 
 void MotionPlanningFrame::warehouseItemNameChanged(QTreeWidgetItem* item, int column)
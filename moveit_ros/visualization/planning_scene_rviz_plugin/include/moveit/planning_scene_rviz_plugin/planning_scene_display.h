@@ -84,9 +84,12 @@ public:
 
   void queueRenderSceneGeometry();
 
-  /** Queue this function call for execution within the background thread
-      All jobs are queued and processed in order by a single background thread. */
-  void addBackgroundJob(const boost::function<void()>& job, const std::string& name);
+  /** Queue this function call for execution within the background threads
+      Jobs of the same priority are processed in order, one at a time. Slow jobs that do not depend on the
+      others, like warehouse queries, should use LOW_PRIORITY so that they run beside the other jobs. */
+  void addBackgroundJob(const boost::function<void()>& job, const std::string& name,
+                        moveit::tools::BackgroundProcessing::JobPriority priority =
+                            moveit::tools::BackgroundProcessing::NORMAL_PRIORITY);
 
   /** Directly spawn a (detached) background thread for execution of this function call
       Should be used, when order of processing is not relevant / job can run in parallel.
@@ -63,7 +63,11 @@ namespace moveit_rviz_plugin
 // Base class contructor
 // ******************************************************************************************
 PlanningSceneDisplay::PlanningSceneDisplay(bool listen_to_planning_scene, bool show_scene_robot)
-  : Display(), model_is_loading_(false), planning_scene_needs_render_(true), current_scene_time_(0.0f)
+  : Display()
+  , model_is_loading_(false)
+  , background_process_(2)
+  , planning_scene_needs_render_(true)
+  , current_scene_time_(0.0f)
 {
   move_group_ns_property_ = new rviz::StringProperty("Move Group Namespace", "", "The name of the ROS namespace in "
                                                                                  "which the move_group node is running",
@@ -212,9 +216,10 @@ void PlanningSceneDisplay::reset()
   }
 }
 
-void PlanningSceneDisplay::addBackgroundJob(const boost::function<void()>& job, const std::string& name)
+void PlanningSceneDisplay::addBackgroundJob(const boost::function<void()>& job, const std::string& name,
+                                            moveit::tools::BackgroundProcessing::JobPriority priority)
 {
-  background_process_.addJob(job, name);
+  background_process_.addJob(job, name, priority);
 }
 
 void PlanningSceneDisplay::spawnBackgroundJob(const boost::function<void()>& job)
@@ -77,6 +77,11 @@ public:
                Ogre::SceneNode* parent_node);
   virtual ~OcTreeRender();
 
+  /** \brief Check whether this object renders \e octree with the specified modes. An octree is not expected to change
+      after it was passed to the constructor, so a rendering that matches can be displayed again as it is */
+  bool isRendering(const std::shared_ptr<const octomap::OcTree>& octree, OctreeVoxelRenderMode octree_voxel_rendering,
+                   OctreeVoxelColorMode octree_color_mode) const;
+
 private:
   void setColor(double z_pos, double min_z, double max_z, double color_factor, rviz::PointCloud::Point* point);
   void setProbColor(double prob, rviz::PointCloud::Point* point);
@@ -87,6 +92,8 @@ private:
   // Ogre-rviz point clouds
   std::vector<rviz::PointCloud*> cloud_;
   std::shared_ptr<const octomap::OcTree> octree_;
+  OctreeVoxelRenderMode octree_voxel_rendering_;
+  OctreeVoxelColorMode octree_color_mode_;
 
   Ogre::SceneNode* scene_node_;
   Ogre::SceneManager* scene_manager_;
@@ -42,6 +42,8 @@
 #include <moveit/rviz_plugin_render_tools/render_shapes.h>
 #include <rviz/helpers/color.h>
 #include <OgreMaterial.h>
+#include <map>
+#include <string>
 
 namespace Ogre
 {
@@ -82,10 +84,33 @@ public:
   void clear();
 
 private:
+  /** \brief The rendering of a world object. It is kept as long as the object's shapes and color do not change; if
+      only the object moves, its scene node is moved */
+  struct ObjectRender
+  {
+    ObjectRender() : node_(NULL), alpha_(0.0f)
+    {
+    }
+
+    Ogre::SceneNode* node_;
+    RenderShapesPtr render_shapes_;
+
+    // what was rendered: the shapes, at these poses, in this color
+    std::vector<shapes::ShapeConstPtr> shapes_;
+    EigenSTL::vector_Affine3d shape_poses_;
+    rviz::Color color_;
+    float alpha_;
+  };
+
+  void destroyObjectRender(ObjectRender& render);
+
   Ogre::SceneNode* planning_scene_geometry_node_;
   rviz::DisplayContext* context_;
-  RenderShapesPtr render_shapes_;
   RobotStateVisualizationPtr scene_robot_;
+
+  std::map<std::string, ObjectRender> object_renders_;
+  OctreeVoxelRenderMode octree_voxel_rendering_;
+  OctreeVoxelColorMode octree_color_mode_;
 };
 }
 
@@ -72,11 +72,22 @@ public:
                    const rviz::Color& color, float alpha);
   void clear();
 
+  /** \brief Remove the rendered shapes before a new set of shapes is rendered. Unlike clear(), octree renderings are
+      kept until finishUpdate(), so renderShape() can reuse them if their octree did not change; rebuilding the
+      rendering of a large octree is expensive */
+  void startUpdate();
+
+  /** \brief Remove the octree renderings kept by startUpdate() that were not reused */
+  void finishUpdate();
+
 private:
   rviz::DisplayContext* context_;
 
   std::vector<std::unique_ptr<rviz::Shape> > scene_shapes_;
   std::vector<OcTreeRenderPtr> octree_voxel_grids_;
+
+  // octree renderings of the previous update, which renderShape() can reuse
+  std::vector<OcTreeRenderPtr> previous_octree_voxel_grids_;
 };
 }
 
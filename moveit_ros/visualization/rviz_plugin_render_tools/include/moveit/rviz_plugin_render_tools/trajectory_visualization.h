@@ -132,6 +132,8 @@ protected:
   robot_trajectory::RobotTrajectoryPtr displaying_trajectory_message_;
   robot_trajectory::RobotTrajectoryPtr trajectory_message_to_display_;
   std::vector<rviz::Robot*> trajectory_trail_;
+  // the waypoint shown by each robot of the trail
+  std::vector<int> trajectory_trail_waypoints_;
   ros::Subscriber trajectory_topic_sub_;
   bool animating_path_;
   int current_state_;
@@ -162,6 +164,7 @@ protected:
   rviz::ColorProperty* robot_color_property_;
   rviz::BoolProperty* enable_robot_color_property_;
   rviz::IntProperty* trail_step_size_property_;
+  rviz::IntProperty* trail_max_count_property_;
 };
 
 }  // namespace moveit_rviz_plugin
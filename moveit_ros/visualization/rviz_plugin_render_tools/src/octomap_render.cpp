@@ -53,7 +53,10 @@ OcTreeRender::OcTreeRender(const std::shared_ptr<const octomap::OcTree>& octree,
                            OctreeVoxelRenderMode octree_voxel_rendering, OctreeVoxelColorMode octree_color_mode,
                            std::size_t max_octree_depth, Ogre::SceneManager* scene_manager,
                            Ogre::SceneNode* parent_node = NULL)
-  : octree_(octree), colorFactor_(0.8)
+  : octree_(octree)
+  , octree_voxel_rendering_(octree_voxel_rendering)
+  , octree_color_mode_(octree_color_mode)
+  , colorFactor_(0.8)
 {
   if (!parent_node)
   {
@@ -96,6 +99,14 @@ OcTreeRender::~OcTreeRender()
   }
 }
 
+bool OcTreeRender::isRendering(const std::shared_ptr<const octomap::OcTree>& octree,
+                               OctreeVoxelRenderMode octree_voxel_rendering,
+                               OctreeVoxelColorMode octree_color_mode) const
+{
+  return octree_ == octree && octree_voxel_rendering_ == octree_voxel_rendering &&
+         octree_color_mode_ == octree_color_mode;
+}
+
 // method taken from octomap_server package
 void OcTreeRender::setColor(double z_pos, double min_z, double max_z, double color_factor,
                             rviz::PointCloud::Point* point)
@@ -167,29 +178,28 @@ void OcTreeRender::octreeDecoding(const std::shared_ptr<const octomap::OcTree>&
       // the left part evaluates to 1 for free voxels and 2 for occupied voxels
       if (((int)octree->isNodeOccupied(*it) + 1) & render_mode_mask)
       {
-        // check if current voxel has neighbors on all sides -> no need to be displayed
+        // check if current voxel has neighbors on all six faces -> no need to be displayed
         bool allNeighborsFound = true;
 
-        octomap::OcTreeKey key;
-        octomap::OcTreeKey nKey = it.getKey();
+        // the key of a voxel is its center; voxels above the maximum depth span several keys, so the neighbors
+        // across the faces are searched just outside that span, at the depth of the voxel itself
+        unsigned int depth = it.getDepth();
+        unsigned int half_span = depth < octree->getTreeDepth() ? 1u << (octree->getTreeDepth() - depth - 1) : 0u;
+        const octomap::OcTreeKey& nKey = it.getKey();
 
-        for (key[2] = nKey[2] - 1; allNeighborsFound && key[2] <= nKey[2] + 1; ++key[2])
+        for (unsigned int axis = 0; allNeighborsFound && axis < 3; ++axis)
         {
-          for (key[1] = nKey[1] - 1; allNeighborsFound && key[1] <= nKey[1] + 1; ++key[1])
+          for (int side = 0; allNeighborsFound && side < 2; ++side)
           {
-            for (key[0] = nKey[0] - 1; allNeighborsFound && key[0] <= nKey[0] + 1; ++key[0])
+            octomap::OcTreeKey key = nKey;
+            key[axis] = side ? nKey[axis] + std::max(half_span, 1u) : nKey[axis] - half_span - 1;
+            octomap::OcTreeNode* node = octree->search(key, depth);
+
+            // the left part evaluates to 1 for free voxels and 2 for occupied voxels
+            if (!(node && (((int)octree->isNodeOccupied(node)) + 1) & render_mode_mask))
             {
-              if (key != nKey)
-              {
-                octomap::OcTreeNode* node = octree->search(key);
-
-                // the left part evaluates to 1 for free voxels and 2 for occupied voxels
-                if (!(node && (((int)octree->isNodeOccupied(node)) + 1) & render_mode_mask))
-                {
-                  // we do not have a neighbor => break!
-                  allNeighborsFound = false;
-                }
-              }
+              // we do not have a neighbor => break!
+              allNeighborsFound = false;
             }
           }
         }
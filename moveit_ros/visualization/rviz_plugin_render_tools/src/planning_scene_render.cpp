@@ -44,21 +44,59 @@
 
 namespace moveit_rviz_plugin
 {
+namespace
+{
+bool sameColor(const rviz::Color& a, const rviz::Color& b)
+{
+  return a.r_ == b.r_ && a.g_ == b.g_ && a.b_ == b.b_ && a.a_ == b.a_;
+}
+
+// compute the transform that moves shapes rendered at poses \e rendered to \e poses; this fails if the shapes did not
+// all move together
+bool computeObjectMotion(const EigenSTL::vector_Affine3d& rendered, const EigenSTL::vector_Affine3d& poses,
+                         Eigen::Affine3d& motion)
+{
+  static const double EPSILON = 1e-6;
+  if (rendered.empty() || rendered.size() != poses.size())
+    return false;
+  motion = poses[0] * rendered[0].inverse();
+  for (std::size_t i = 1; i < poses.size(); ++i)
+    if (((motion * rendered[i]).matrix() - poses[i].matrix()).cwiseAbs().maxCoeff() > EPSILON)
+      return false;
+  return true;
+}
+}
+
 PlanningSceneRender::PlanningSceneRender(Ogre::SceneNode* node, rviz::DisplayContext* context,
                                          const RobotStateVisualizationPtr& robot)
-  : planning_scene_geometry_node_(node->createChildSceneNode()), context_(context), scene_robot_(robot)
+  : planning_scene_geometry_node_(node->createChildSceneNode())
+  , context_(context)
+  , scene_robot_(robot)
+  , octree_voxel_rendering_(OCTOMAP_OCCUPIED_VOXELS)
+  , octree_color_mode_(OCTOMAP_Z_AXIS_COLOR)
 {
-  render_shapes_.reset(new RenderShapes(context));
 }
 
 PlanningSceneRender::~PlanningSceneRender()
 {
+  clear();
   context_->getSceneManager()->destroySceneNode(planning_scene_geometry_node_->getName());
 }
 
 void PlanningSceneRender::clear()
 {
-  render_shapes_->clear();
+  for (std::map<std::string, ObjectRender>::iterator it = object_renders_.begin(); it != object_renders_.end(); ++it)
+    destroyObjectRender(it->second);
+  object_renders_.clear();
+}
+
+void PlanningSceneRender::destroyObjectRender(ObjectRender& render)
+{
+  // the shapes own scene nodes below the node of the object, so they go first
+  render.render_shapes_.reset();
+  if (render.node_)
+    context_->getSceneManager()->destroySceneNode(render.node_);
+  render.node_ = NULL;
 }
 
 void PlanningSceneRender::renderPlanningScene(const planning_scene::PlanningSceneConstPtr& scene,
@@ -70,7 +108,13 @@ void PlanningSceneRender::renderPlanningScene(const planning_scene::PlanningScen
   if (!scene)
     return;
 
-  clear();
+  // objects are only rendered again if they changed, unless the way octrees are rendered changed
+  if (octree_voxel_rendering != octree_voxel_rendering_ || octree_color_mode != octree_color_mode_)
+  {
+    clear();
+    octree_voxel_rendering_ = octree_voxel_rendering;
+    octree_color_mode_ = octree_color_mode;
+  }
 
   if (scene_robot_)
   {
@@ -87,7 +131,17 @@ void PlanningSceneRender::renderPlanningScene(const planning_scene::PlanningScen
     scene_robot_->update(robot_state::RobotStateConstPtr(rs), color, color_map);
   }
 
-  const std::vector<std::string>& ids = scene->getWorld()->getObjectIds();
+  const collision_detection::WorldConstPtr& world = scene->getWorld();
+  for (std::map<std::string, ObjectRender>::iterator it = object_renders_.begin(); it != object_renders_.end();)
+    if (world->hasObject(it->first))
+      ++it;
+    else
+    {
+      destroyObjectRender(it->second);
+      object_renders_.erase(it++);
+    }
+
+  const std::vector<std::string>& ids = world->getObjectIds();
   for (std::size_t i = 0; i < ids.size(); ++i)
   {
     collision_detection::CollisionWorld::ObjectConstPtr o = scene->getWorld()->getObject(ids[i]);
@@ -101,9 +155,41 @@ void PlanningSceneRender::renderPlanningScene(const planning_scene::PlanningScen
       color.b_ = c.b;
       alpha = c.a;
     }
+
+    ObjectRender& render = object_renders_[ids[i]];
+    if (render.node_ && render.shapes_ == o->shapes_ && sameColor(render.color_, color) && render.alpha_ == alpha)
+    {
+      // the geometry is already rendered; if the object moved as a whole, its node is moved instead
+      Eigen::Affine3d motion;
+      if (computeObjectMotion(render.shape_poses_, o->shape_poses_, motion))
+      {
+        Eigen::Quaterniond q(motion.rotation());
+        render.node_->setPosition(Ogre::Vector3(motion.translation().x(), motion.translation().y(),
+                                                motion.translation().z()));
+        render.node_->setOrientation(Ogre::Quaternion(q.w(), q.x(), q.y(), q.z()));
+        continue;
+      }
+    }
+
+    if (!render.node_)
+    {
+      render.node_ = planning_scene_geometry_node_->createChildSceneNode();
+      render.render_shapes_.reset(new RenderShapes(context_));
+    }
+    render.node_->setPosition(Ogre::Vector3::ZERO);
+    render.node_->setOrientation(Ogre::Quaternion::IDENTITY);
+
+    // octree renderings are kept if the octree did not change
+    render.render_shapes_->startUpdate();
     for (std::size_t j = 0; j < o->shapes_.size(); ++j)
-      render_shapes_->renderShape(planning_scene_geometry_node_, o->shapes_[j].get(), o->shape_poses_[j],
-                                  octree_voxel_rendering, octree_color_mode, color, alpha);
+      render.render_shapes_->renderShape(render.node_, o->shapes_[j].get(), o->shape_poses_[j],
+                                         octree_voxel_rendering, octree_color_mode, color, alpha);
+    render.render_shapes_->finishUpdate();
+
+    render.shapes_ = o->shapes_;
+    render.shape_poses_ = o->shape_poses_;
+    render.color_ = color;
+    render.alpha_ = alpha;
   }
 }
 }
@@ -69,6 +69,19 @@ void RenderShapes::clear()
 {
   scene_shapes_.clear();
   octree_voxel_grids_.clear();
+  previous_octree_voxel_grids_.clear();
+}
+
+void RenderShapes::startUpdate()
+{
+  scene_shapes_.clear();
+  previous_octree_voxel_grids_.swap(octree_voxel_grids_);
+  octree_voxel_grids_.clear();
+}
+
+void RenderShapes::finishUpdate()
+{
+  previous_octree_voxel_grids_.clear();
 }
 
 void RenderShapes::renderShape(Ogre::SceneNode* node, const shapes::Shape* s, const Eigen::Affine3d& p,
@@ -152,8 +165,18 @@ void RenderShapes::renderShape(Ogre::SceneNode* node, const shapes::Shape* s, co
 
     case shapes::OCTREE:
     {
-      OcTreeRenderPtr octree(new OcTreeRender(static_cast<const shapes::OcTree*>(s)->octree, octree_voxel_rendering,
-                                              octree_color_mode, 0u, context_->getSceneManager(), node));
+      const std::shared_ptr<const octomap::OcTree>& tree = static_cast<const shapes::OcTree*>(s)->octree;
+      OcTreeRenderPtr octree;
+      for (std::size_t i = 0; i < previous_octree_voxel_grids_.size(); ++i)
+        if (previous_octree_voxel_grids_[i]->isRendering(tree, octree_voxel_rendering, octree_color_mode))
+        {
+          octree = previous_octree_voxel_grids_[i];
+          previous_octree_voxel_grids_.erase(previous_octree_voxel_grids_.begin() + i);
+          break;
+        }
+      if (!octree)
+        octree.reset(new OcTreeRender(tree, octree_voxel_rendering, octree_color_mode, 0u, context_->getSceneManager(),
+                                      node));
 
       octree_voxel_grids_.push_back(octree);
     }
@@ -108,6 +108,12 @@ TrajectoryVisualization::TrajectoryVisualization(rviz::Property* widget, rviz::D
                                                     widget, SLOT(changedTrailStepSize()), this);
   trail_step_size_property_->setMin(1);
 
+  trail_max_count_property_ =
+      new rviz::IntProperty("Trail Max Count", 0, "The maximum number of robots shown in the trajectory trail; the "
+                                                  "step size is increased as needed. 0 means there is no limit.",
+                            widget, SLOT(changedTrailStepSize()), this);
+  trail_max_count_property_->setMin(0);
+
   interrupt_display_property_ = new rviz::BoolProperty(
       "Interrupt Display", false,
       "Immediately show newly planned trajectory, interrupting the currently displayed one.", widget);
@@ -199,6 +205,7 @@ void TrajectoryVisualization::clearTrajectoryTrail()
   for (std::size_t i = 0; i < trajectory_trail_.size(); ++i)
     delete trajectory_trail_[i];
   trajectory_trail_.clear();
+  trajectory_trail_waypoints_.clear();
 }
 
 void TrajectoryVisualization::changedLoopDisplay()
@@ -220,14 +227,29 @@ void TrajectoryVisualization::changedShowTrail()
   if (!t)
     return;
 
+  int waypoint_count = t->getWayPointCount();
   int stepsize = trail_step_size_property_->getInt();
   // always include last trajectory point
-  trajectory_trail_.resize((int)std::ceil((t->getWayPointCount() + stepsize - 1) / (float)stepsize));
+  int trail_count = (int)std::ceil((waypoint_count + stepsize - 1) / (float)stepsize);
+  // every trail robot is a complete robot model, so long trajectories are sub-sampled to the maximum count
+  int max_count = trail_max_count_property_->getInt();
+  while (max_count > 0 && trail_count > max_count && stepsize < waypoint_count)
+  {
+    ++stepsize;
+    trail_count = (int)std::ceil((waypoint_count + stepsize - 1) / (float)stepsize);
+  }
+
+  // only the geometry that is displayed is loaded; the trail is rebuilt if that changes
+  bool visual = display_path_visual_enabled_property_->getBool();
+  bool collision = display_path_collision_enabled_property_->getBool();
+
+  trajectory_trail_.resize(trail_count);
+  trajectory_trail_waypoints_.resize(trail_count);
   for (std::size_t i = 0; i < trajectory_trail_.size(); i++)
   {
-    int waypoint_i = std::min(i * stepsize, t->getWayPointCount() - 1);  // limit to last trajectory point
+    int waypoint_i = std::min((int)i * stepsize, waypoint_count - 1);  // limit to last trajectory point
     rviz::Robot* r = new rviz::Robot(scene_node_, context_, "Trail Robot " + boost::lexical_cast<std::string>(i), NULL);
-    r->load(*robot_model_->getURDF());
+    r->load(*robot_model_->getURDF(), visual, collision);
     r->setVisualVisible(display_path_visual_enabled_property_->getBool());
     r->setCollisionVisible(display_path_collision_enabled_property_->getBool());
     r->setAlpha(robot_path_alpha_property_->getFloat());
@@ -236,6 +258,7 @@ void TrajectoryVisualization::changedShowTrail()
       setRobotColor(r, robot_color_property_->getColor());
     r->setVisible(display_->isEnabled() && (!animating_path_ || waypoint_i <= current_state_));
     trajectory_trail_[i] = r;
+    trajectory_trail_waypoints_[i] = waypoint_i;
   }
 }
 
@@ -268,8 +291,8 @@ void TrajectoryVisualization::changedDisplayPathVisualEnabled()
   {
     display_path_robot_->setVisualVisible(display_path_visual_enabled_property_->getBool());
     display_path_robot_->setVisible(display_->isEnabled() && displaying_trajectory_message_ && animating_path_);
-    for (std::size_t i = 0; i < trajectory_trail_.size(); ++i)
-      trajectory_trail_[i]->setVisualVisible(display_path_visual_enabled_property_->getBool());
+    // the trail robots only have the geometry that was displayed when they were created
+    changedShowTrail();
   }
 }
 
@@ -283,8 +306,7 @@ void TrajectoryVisualization::changedDisplayPathCollisionEnabled()
   {
     display_path_robot_->setCollisionVisible(display_path_collision_enabled_property_->getBool());
     display_path_robot_->setVisible(display_->isEnabled() && displaying_trajectory_message_ && animating_path_);
-    for (std::size_t i = 0; i < trajectory_trail_.size(); ++i)
-      trajectory_trail_[i]->setCollisionVisible(display_path_collision_enabled_property_->getBool());
+    changedShowTrail();
   }
 }
 
@@ -405,10 +427,13 @@ void TrajectoryVisualization::update(float wall_dt, float ros_dt)
       {
         trajectory_slider_panel_->setSliderPosition(current_state_);
         display_path_robot_->update(displaying_trajectory_message_->getWayPointPtr(current_state_));
+        // only the trail robots whose visibility changes are updated
         for (std::size_t i = 0; i < trajectory_trail_.size(); ++i)
-          trajectory_trail_[i]->setVisible(
-              std::min(waypoint_count - 1, static_cast<int>(i) * trail_step_size_property_->getInt()) <=
-              current_state_);
+        {
+          bool visible = trajectory_trail_waypoints_[i] <= current_state_;
+          if (trajectory_trail_[i]->isVisible() != visible)
+            trajectory_trail_[i]->setVisible(visible);
+        }
       }
       else
       {
@@ -42,6 +42,9 @@
 #include <moveit_msgs/PlanningScene.h>
 #include <moveit_msgs/MotionPlanRequest.h>
 #include <moveit_msgs/RobotTrajectory.h>
+#include <shape_msgs/Mesh.h>
+#include <boost/thread/mutex.hpp>
+#include <map>
 
 namespace moveit_warehouse
 {
@@ -52,6 +55,7 @@ typedef warehouse_ros::MessageWithMetadata<moveit_msgs::RobotTrajectory>::ConstP
 typedef warehouse_ros::MessageCollection<moveit_msgs::PlanningScene>::Ptr PlanningSceneCollection;
 typedef warehouse_ros::MessageCollection<moveit_msgs::MotionPlanRequest>::Ptr MotionPlanRequestCollection;
 typedef warehouse_ros::MessageCollection<moveit_msgs::RobotTrajectory>::Ptr RobotTrajectoryCollection;
+typedef warehouse_ros::MessageCollection<shape_msgs::Mesh>::Ptr MeshCollection;
 
 MOVEIT_CLASS_FORWARD(PlanningSceneStorage);
 
@@ -62,6 +66,13 @@ public:
 
   static const std::string PLANNING_SCENE_ID_NAME;
   static const std::string MOTION_PLAN_REQUEST_ID_NAME;
+  /// Metadata field holding a hash of the serialized MotionPlanRequest, so that a request can be found by content
+  static const std::string MOTION_PLAN_REQUEST_HASH_NAME;
+  /// Metadata field of a planning scene listing the hashes of its meshes, which are stored once in a separate
+  /// collection
+  static const std::string MESH_HASHES_NAME;
+  /// Metadata field holding the hash identifying a stored mesh
+  static const std::string MESH_HASH_NAME;
 
   PlanningSceneStorage(warehouse_ros::DatabaseConnection::Ptr conn);
 
@@ -110,6 +121,19 @@ public:
 private:
   void createCollections();
 
+  /// Move the meshes of \e scene to the mesh collection (unless already stored), leaving empty meshes in their place;
+  /// return the list of their hashes
+  std::string storeMeshes(moveit_msgs::PlanningScene& scene);
+
+  /// Fill the empty meshes of \e scene from the mesh collection, given the list of hashes returned by storeMeshes()
+  bool restoreMeshes(moveit_msgs::PlanningScene& scene, const std::string& hashes) const;
+
+  /// Get the stored mesh with hash \e hash, from the cache if it was fetched before
+  bool getMesh(const std::string& hash, shape_msgs::Mesh& mesh) const;
+
+  /// Add the content hash to stored requests that predate it, so that getMotionPlanRequestName() can find them
+  void addMissingRequestHashes();
+
   std::string getMotionPlanRequestName(const moveit_msgs::MotionPlanRequest& planning_query,
                                        const std::string& scene_name) const;
   std::string addNewPlanningRequest(const moveit_msgs::MotionPlanRequest& planning_query, const std::string& scene_name,
@@ -118,6 +142,11 @@ private:
   PlanningSceneCollection planning_scene_collection_;
   MotionPlanRequestCollection motion_plan_request_collection_;
   RobotTrajectoryCollection robot_trajectory_collection_;
+  MeshCollection mesh_collection_;
+
+  /// The meshes stored or fetched so far, by hash
+  mutable std::map<std::string, shape_msgs::Mesh> mesh_cache_;
+  mutable boost::mutex mesh_cache_lock_;
 };
 }
 
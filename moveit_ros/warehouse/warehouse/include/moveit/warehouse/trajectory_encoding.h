@@ -0,0 +1,58 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_MOVEIT_WAREHOUSE_TRAJECTORY_ENCODING_
+#define MOVEIT_MOVEIT_WAREHOUSE_TRAJECTORY_ENCODING_
+
+#include <moveit_msgs/RobotTrajectory.h>
+#include <stdint.h>
+#include <vector>
+
+namespace moveit_warehouse
+{
+/** \brief Encode \e trajectory in a compact columnar format: the joint names are stored once, the time offsets and
+    each joint's positions, velocities, accelerations and efforts are stored as variable length deltas between
+    consecutive points, after quantization to multiples of \e resolution (in the units of each column).
+
+    The multi-DOF part of the trajectory is stored ROS-serialized. Return false if the points of the joint trajectory
+    do not all have one value per joint in each of their non-empty columns. */
+bool encodeTrajectory(const moveit_msgs::RobotTrajectory& trajectory, std::vector<uint8_t>& data,
+                      double resolution = 1e-6);
+
+/** \brief Decode a trajectory produced by encodeTrajectory(). Values are restored to within half of the resolution
+    they were quantized with. Return false if \e data is not a valid encoding. */
+bool decodeTrajectory(const std::vector<uint8_t>& data, moveit_msgs::RobotTrajectory& trajectory);
+}
+
+#endif
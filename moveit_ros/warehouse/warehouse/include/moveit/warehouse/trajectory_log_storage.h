@@ -0,0 +1,127 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#ifndef MOVEIT_MOVEIT_WAREHOUSE_TRAJECTORY_LOG_STORAGE_
+#define MOVEIT_MOVEIT_WAREHOUSE_TRAJECTORY_LOG_STORAGE_
+
+#include "moveit/warehouse/moveit_message_storage.h"
+#include <moveit/macros/class_forward.h>
+#include <moveit_msgs/RobotTrajectory.h>
+#include <std_msgs/UInt8MultiArray.h>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <deque>
+
+namespace moveit_warehouse
+{
+typedef warehouse_ros::MessageWithMetadata<std_msgs::UInt8MultiArray>::ConstPtr EncodedTrajectoryWithMetadata;
+typedef warehouse_ros::MessageCollection<std_msgs::UInt8MultiArray>::Ptr EncodedTrajectoryCollection;
+
+MOVEIT_CLASS_FORWARD(TrajectoryLogStorage);
+
+/** \brief Log of trajectories (e.g., the executed ones), stored in the compact encoding of encodeTrajectory().
+
+    Logged trajectories are queued and written to the database by a background thread, so logTrajectory() does not
+    wait for the database. */
+class TrajectoryLogStorage : public MoveItMessageStorage
+{
+public:
+  static const std::string DATABASE_NAME;
+
+  static const std::string TRAJECTORY_ID_NAME;
+  static const std::string ROBOT_NAME;
+  static const std::string GROUP_NAME;
+  static const std::string LOG_TIME_NAME;
+
+  /** \brief At most \e max_queue_size trajectories wait to be written; trajectories logged while the queue is full are
+      dropped. Positions, velocities, accelerations and efforts are stored to within half of \e resolution. */
+  TrajectoryLogStorage(warehouse_ros::DatabaseConnection::Ptr conn, std::size_t max_queue_size = 1000,
+                       double resolution = 1e-6);
+
+  /** \brief Write the queued trajectories and stop the writer thread */
+  ~TrajectoryLogStorage();
+
+  /** \brief Queue \e trajectory to be logged as \e id, with the current time. Return false if the queue is full and
+      the trajectory was dropped. */
+  bool logTrajectory(const moveit_msgs::RobotTrajectory& trajectory, const std::string& id,
+                     const std::string& robot = "", const std::string& group = "");
+
+  /** \brief Wait until all trajectories queued so far are written */
+  void flush();
+
+  /** \brief The number of trajectories that were dropped, because the queue was full or they could not be encoded */
+  std::size_t getDroppedCount() const;
+
+  /** \brief Get the ids of the trajectories logged between \e from and \e to */
+  void getLoggedTrajectoryIds(std::vector<std::string>& ids, const ros::Time& from, const ros::Time& to,
+                              const std::string& robot = "", const std::string& group = "") const;
+
+  /** \brief Get the trajectory logged as \e id. Return false on failure. */
+  bool getLoggedTrajectory(moveit_msgs::RobotTrajectory& trajectory, const std::string& id,
+                           const std::string& robot = "", const std::string& group = "") const;
+
+  void reset();
+
+private:
+  struct LogEntry
+  {
+    moveit_msgs::RobotTrajectory trajectory;
+    std::string id;
+    std::string robot;
+    std::string group;
+    ros::Time time;
+  };
+
+  void createCollections();
+  void writeThread();
+
+  EncodedTrajectoryCollection trajectory_collection_;
+  /// Serializes the use of the collection by the writer thread and the queries
+  mutable boost::mutex collection_lock_;
+
+  double resolution_;
+  std::size_t max_queue_size_;
+  std::size_t dropped_;
+  std::deque<LogEntry> queue_;
+  bool writing_;
+  bool stop_;
+  mutable boost::mutex queue_lock_;
+  boost::condition_variable queue_condition_;
+  boost::condition_variable written_condition_;
+  boost::thread write_thread_;
+};
+}
+
+#endif
@@ -41,6 +41,7 @@
 #include <moveit/kinematic_constraints/utils.h>
 #include <moveit/robot_state/conversions.h>
 #include <eigen_conversions/eigen_msg.h>
+#include <boost/algorithm/string/predicate.hpp>
 #include <boost/program_options/cmdline.hpp>
 #include <boost/program_options/options_description.hpp>
 #include <boost/program_options/parsers.hpp>
@@ -207,7 +208,8 @@ int main(int argc, char** argv)
   boost::program_options::options_description desc;
   desc.add_options()("help", "Show help message")("queries", boost::program_options::value<std::string>(),
                                                   "Name of file containing motion planning queries.")(
-      "scene", boost::program_options::value<std::string>(), "Name of file containing motion planning scene.")(
+      "scene", boost::program_options::value<std::string>(),
+      "Name of file containing motion planning scene (binary geometry if it ends in .bscene).")(
       "host", boost::program_options::value<std::string>(),
       "Host for the DB.")("port", boost::program_options::value<std::size_t>(), "Port for the DB.");
 
@@ -244,9 +246,18 @@ int main(int argc, char** argv)
 
   if (vm.count("scene"))
   {
-    std::ifstream fin(vm["scene"].as<std::string>().c_str());
-    psm.getPlanningScene()->loadGeometryFromStream(fin);
-    fin.close();
+    const std::string& scene_file = vm["scene"].as<std::string>();
+    if (boost::algorithm::ends_with(scene_file, ".bscene"))
+    {
+      std::ifstream fin(scene_file.c_str(), std::ios::binary);
+      if (!psm.getPlanningScene()->loadGeometryFromBinaryStream(fin))
+        return 1;
+    }
+    else
+    {
+      std::ifstream fin(scene_file.c_str());
+      psm.getPlanningScene()->loadGeometryFromStream(fin);
+    }
     moveit_msgs::PlanningScene psmsg;
     psm.getPlanningScene()->getPlanningSceneMsg(psmsg);
     pss.addPlanningScene(psmsg);
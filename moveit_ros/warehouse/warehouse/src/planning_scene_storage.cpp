@@ -36,19 +36,63 @@
 
 #include <moveit/warehouse/planning_scene_storage.h>
 #include <boost/regex.hpp>
+#include <boost/algorithm/string.hpp>
+#include <cstdio>
 
 const std::string moveit_warehouse::PlanningSceneStorage::DATABASE_NAME = "moveit_planning_scenes";
 
 const std::string moveit_warehouse::PlanningSceneStorage::PLANNING_SCENE_ID_NAME = "planning_scene_id";
 const std::string moveit_warehouse::PlanningSceneStorage::MOTION_PLAN_REQUEST_ID_NAME = "motion_request_id";
+const std::string moveit_warehouse::PlanningSceneStorage::MOTION_PLAN_REQUEST_HASH_NAME = "motion_request_hash";
+const std::string moveit_warehouse::PlanningSceneStorage::MESH_HASHES_NAME = "mesh_hashes";
+const std::string moveit_warehouse::PlanningSceneStorage::MESH_HASH_NAME = "mesh_hash";
 
 using warehouse_ros::Metadata;
 using warehouse_ros::Query;
 
+namespace
+{
+template <typename T>
+void serializeMessage(const T& message, std::vector<uint8_t>& buffer)
+{
+  buffer.resize(ros::serialization::serializationLength(message));
+  ros::serialization::OStream stream(buffer.data(), buffer.size());
+  ros::serialization::serialize(stream, message);
+}
+
+// 64-bit FNV-1a of the serialized message, as hex; equal messages have equal hashes
+std::string hashMessage(const std::vector<uint8_t>& buffer)
+{
+  uint64_t hash = 14695981039346656037ULL;
+  for (std::size_t i = 0; i < buffer.size(); ++i)
+  {
+    hash ^= buffer[i];
+    hash *= 1099511628211ULL;
+  }
+  char hex[17];
+  snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)hash);
+  return hex;
+}
+
+// All meshes of a scene, in the order their hashes are listed
+std::vector<shape_msgs::Mesh*> getMeshes(moveit_msgs::PlanningScene& scene)
+{
+  std::vector<shape_msgs::Mesh*> meshes;
+  for (std::size_t i = 0; i < scene.world.collision_objects.size(); ++i)
+    for (std::size_t j = 0; j < scene.world.collision_objects[i].meshes.size(); ++j)
+      meshes.push_back(&scene.world.collision_objects[i].meshes[j]);
+  for (std::size_t i = 0; i < scene.robot_state.attached_collision_objects.size(); ++i)
+    for (std::size_t j = 0; j < scene.robot_state.attached_collision_objects[i].object.meshes.size(); ++j)
+      meshes.push_back(&scene.robot_state.attached_collision_objects[i].object.meshes[j]);
+  return meshes;
+}
+}
+
 moveit_warehouse::PlanningSceneStorage::PlanningSceneStorage(warehouse_ros::DatabaseConnection::Ptr conn)
   : MoveItMessageStorage(conn)
 {
   createCollections();
+  addMissingRequestHashes();
 }
 
 void moveit_warehouse::PlanningSceneStorage::createCollections()
@@ -58,6 +102,36 @@ void moveit_warehouse::PlanningSceneStorage::createCollections()
       conn_->openCollectionPtr<moveit_msgs::MotionPlanRequest>(DATABASE_NAME, "motion_plan_request");
   robot_trajectory_collection_ =
       conn_->openCollectionPtr<moveit_msgs::RobotTrajectory>(DATABASE_NAME, "robot_trajectory");
+  mesh_collection_ = conn_->openCollectionPtr<shape_msgs::Mesh>(DATABASE_NAME, "mesh");
+}
+
+void moveit_warehouse::PlanningSceneStorage::addMissingRequestHashes()
+{
+  // only the metadata is read, unless a request has no hash yet
+  Query::Ptr q = motion_plan_request_collection_->createQuery();
+  std::vector<MotionPlanRequestWithMetadata> requests = motion_plan_request_collection_->queryList(q, true);
+  std::vector<uint8_t> buffer;
+  unsigned int added = 0;
+  for (std::size_t i = 0; i < requests.size(); ++i)
+  {
+    if (requests[i]->lookupField(MOTION_PLAN_REQUEST_HASH_NAME) ||
+        !requests[i]->lookupField(PLANNING_SCENE_ID_NAME) || !requests[i]->lookupField(MOTION_PLAN_REQUEST_ID_NAME))
+      continue;
+    Query::Ptr rq = motion_plan_request_collection_->createQuery();
+    rq->append(PLANNING_SCENE_ID_NAME, requests[i]->lookupString(PLANNING_SCENE_ID_NAME));
+    rq->append(MOTION_PLAN_REQUEST_ID_NAME, requests[i]->lookupString(MOTION_PLAN_REQUEST_ID_NAME));
+    std::vector<MotionPlanRequestWithMetadata> request = motion_plan_request_collection_->queryList(rq, false);
+    // the metadata update would apply to all requests with this name, so ambiguous names are left alone
+    if (request.size() != 1)
+      continue;
+    serializeMessage(*request[0], buffer);
+    Metadata::Ptr m = motion_plan_request_collection_->createMetadata();
+    m->append(MOTION_PLAN_REQUEST_HASH_NAME, hashMessage(buffer));
+    motion_plan_request_collection_->modifyMetadata(rq, m);
+    ++added;
+  }
+  if (added > 0)
+    ROS_DEBUG("Added the content hash to %u stored MotionPlanRequest messages", added);
 }
 
 void moveit_warehouse::PlanningSceneStorage::reset()
@@ -65,6 +139,11 @@ void moveit_warehouse::PlanningSceneStorage::reset()
   planning_scene_collection_.reset();
   motion_plan_request_collection_.reset();
   robot_trajectory_collection_.reset();
+  mesh_collection_.reset();
+  {
+    boost::mutex::scoped_lock slock(mesh_cache_lock_);
+    mesh_cache_.clear();
+  }
   conn_->dropDatabase(DATABASE_NAME);
   createCollections();
 }
@@ -77,12 +156,86 @@ void moveit_warehouse::PlanningSceneStorage::addPlanningScene(const moveit_msgs:
     removePlanningScene(scene.name);
     replace = true;
   }
+  moveit_msgs::PlanningScene stored_scene = scene;
   Metadata::Ptr metadata = planning_scene_collection_->createMetadata();
   metadata->append(PLANNING_SCENE_ID_NAME, scene.name);
-  planning_scene_collection_->insert(scene, metadata);
+  metadata->append(MESH_HASHES_NAME, storeMeshes(stored_scene));
+  planning_scene_collection_->insert(stored_scene, metadata);
   ROS_DEBUG("%s scene '%s'", replace ? "Replaced" : "Added", scene.name.c_str());
 }
 
+std::string moveit_warehouse::PlanningSceneStorage::storeMeshes(moveit_msgs::PlanningScene& scene)
+{
+  std::vector<shape_msgs::Mesh*> meshes = getMeshes(scene);
+  std::string hashes;
+  std::vector<uint8_t> buffer;
+  boost::mutex::scoped_lock slock(mesh_cache_lock_);
+  for (std::size_t i = 0; i < meshes.size(); ++i)
+  {
+    serializeMessage(*meshes[i], buffer);
+    const std::string hash = hashMessage(buffer);
+    if (mesh_cache_.find(hash) == mesh_cache_.end())
+    {
+      Query::Ptr q = mesh_collection_->createQuery();
+      q->append(MESH_HASH_NAME, hash);
+      if (mesh_collection_->queryList(q, true).empty())
+      {
+        Metadata::Ptr metadata = mesh_collection_->createMetadata();
+        metadata->append(MESH_HASH_NAME, hash);
+        mesh_collection_->insert(*meshes[i], metadata);
+      }
+      mesh_cache_[hash].triangles.swap(meshes[i]->triangles);
+      mesh_cache_[hash].vertices.swap(meshes[i]->vertices);
+    }
+    *meshes[i] = shape_msgs::Mesh();
+    if (!hashes.empty())
+      hashes += ",";
+    hashes += hash;
+  }
+  return hashes;
+}
+
+bool moveit_warehouse::PlanningSceneStorage::restoreMeshes(moveit_msgs::PlanningScene& scene,
+                                                           const std::string& hashes) const
+{
+  std::vector<shape_msgs::Mesh*> meshes = getMeshes(scene);
+  std::vector<std::string> mesh_hashes;
+  if (!hashes.empty())
+    boost::split(mesh_hashes, hashes, boost::is_any_of(","));
+  if (mesh_hashes.size() != meshes.size())
+  {
+    ROS_ERROR("Planning scene '%s' has %u meshes, but %u are stored", scene.name.c_str(),
+              (unsigned int)meshes.size(), (unsigned int)mesh_hashes.size());
+    return false;
+  }
+  for (std::size_t i = 0; i < meshes.size(); ++i)
+    if (!getMesh(mesh_hashes[i], *meshes[i]))
+    {
+      ROS_ERROR("Mesh '%s' of planning scene '%s' was not found in the database", mesh_hashes[i].c_str(),
+                scene.name.c_str());
+      return false;
+    }
+  return true;
+}
+
+bool moveit_warehouse::PlanningSceneStorage::getMesh(const std::string& hash, shape_msgs::Mesh& mesh) const
+{
+  boost::mutex::scoped_lock slock(mesh_cache_lock_);
+  std::map<std::string, shape_msgs::Mesh>::const_iterator it = mesh_cache_.find(hash);
+  if (it == mesh_cache_.end())
+  {
+    Query::Ptr q = mesh_collection_->createQuery();
+    q->append(MESH_HASH_NAME, hash);
+    std::vector<warehouse_ros::MessageWithMetadata<shape_msgs::Mesh>::ConstPtr> stored =
+        mesh_collection_->queryList(q, false);
+    if (stored.empty())
+      return false;
+    it = mesh_cache_.insert(std::make_pair(hash, static_cast<const shape_msgs::Mesh&>(*stored.front()))).first;
+  }
+  mesh = it->second;
+  return true;
+}
+
 bool moveit_warehouse::PlanningSceneStorage::hasPlanningScene(const std::string& name) const
 {
   Query::Ptr q = planning_scene_collection_->createQuery();
@@ -94,33 +247,22 @@ bool moveit_warehouse::PlanningSceneStorage::hasPlanningScene(const std::string&
 std::string moveit_warehouse::PlanningSceneStorage::getMotionPlanRequestName(
     const moveit_msgs::MotionPlanRequest& planning_query, const std::string& scene_name) const
 {
-  // get all existing motion planning requests for this planning scene
+  // compute the serialization of the message passed as argument
+  std::vector<uint8_t> buffer_arg;
+  serializeMessage(planning_query, buffer_arg);
+
+  // only the requests of this scene with the same hash are candidates
   Query::Ptr q = motion_plan_request_collection_->createQuery();
   q->append(PLANNING_SCENE_ID_NAME, scene_name);
+  q->append(MOTION_PLAN_REQUEST_HASH_NAME, hashMessage(buffer_arg));
   std::vector<MotionPlanRequestWithMetadata> existing_requests = motion_plan_request_collection_->queryList(q, false);
 
-  // if there are no requests stored, we are done
-  if (existing_requests.empty())
-    return "";
-
-  // compute the serialization of the message passed as argument
-  const size_t serial_size_arg = ros::serialization::serializationLength(planning_query);
-  boost::shared_array<uint8_t> buffer_arg(new uint8_t[serial_size_arg]);
-  ros::serialization::OStream stream_arg(buffer_arg.get(), serial_size_arg);
-  ros::serialization::serialize(stream_arg, planning_query);
-  const void* data_arg = buffer_arg.get();
-
+  // the hash may collide, so compare the serializations
+  std::vector<uint8_t> buffer;
   for (std::size_t i = 0; i < existing_requests.size(); ++i)
   {
-    const size_t serial_size = ros::serialization::serializationLength(
-        static_cast<const moveit_msgs::MotionPlanRequest&>(*existing_requests[i]));
-    if (serial_size != serial_size_arg)
-      continue;
-    boost::shared_array<uint8_t> buffer(new uint8_t[serial_size]);
-    ros::serialization::OStream stream(buffer.get(), serial_size);
-    ros::serialization::serialize(stream, static_cast<const moveit_msgs::MotionPlanRequest&>(*existing_requests[i]));
-    const void* data = buffer.get();
-    if (memcmp(data_arg, data, serial_size) == 0)
+    serializeMessage(*existing_requests[i], buffer);
+    if (buffer == buffer_arg)
       // we found the same message twice
       return existing_requests[i]->lookupString(MOTION_PLAN_REQUEST_ID_NAME);
   }
@@ -160,9 +302,12 @@ std::string moveit_warehouse::PlanningSceneStorage::addNewPlanningRequest(
       index++;
     } while (used.find(id) != used.end());
   }
+  std::vector<uint8_t> buffer;
+  serializeMessage(planning_query, buffer);
   Metadata::Ptr metadata = motion_plan_request_collection_->createMetadata();
   metadata->append(PLANNING_SCENE_ID_NAME, scene_name);
   metadata->append(MOTION_PLAN_REQUEST_ID_NAME, id);
+  metadata->append(MOTION_PLAN_REQUEST_HASH_NAME, hashMessage(buffer));
   motion_plan_request_collection_->insert(planning_query, metadata);
   ROS_DEBUG("Saved planning query '%s' for scene '%s'", id.c_str(), scene_name.c_str());
   return id;
@@ -224,9 +369,13 @@ bool moveit_warehouse::PlanningSceneStorage::getPlanningScene(PlanningSceneWithM
     return false;
   }
   scene_m = planning_scenes.back();
+  moveit_msgs::PlanningScene* scene =
+      const_cast<moveit_msgs::PlanningScene*>(static_cast<const moveit_msgs::PlanningScene*>(scene_m.get()));
   // in case the scene was renamed, the name in the message may be out of date
-  const_cast<moveit_msgs::PlanningScene*>(static_cast<const moveit_msgs::PlanningScene*>(scene_m.get()))->name =
-      scene_name;
+  scene->name = scene_name;
+  // scenes stored before meshes were deduplicated embed their meshes
+  if (scene_m->lookupField(MESH_HASHES_NAME))
+    return restoreMeshes(*scene, scene_m->lookupString(MESH_HASHES_NAME));
   return true;
 }
 
@@ -82,7 +82,8 @@ int main(int argc, char** argv)
   boost::program_options::options_description desc;
   desc.add_options()("help", "Show help message")("host", boost::program_options::value<std::string>(), "Host for the "
                                                                                                         "DB.")(
-      "port", boost::program_options::value<std::size_t>(), "Port for the DB.");
+      "port", boost::program_options::value<std::size_t>(), "Port for the DB.")(
+      "binary", "Save the scene geometry in the binary format (.bscene), which loads faster.");
 
   boost::program_options::variables_map vm;
   boost::program_options::store(boost::program_options::parse_command_line(argc, argv, desc), vm);
@@ -119,9 +120,16 @@ int main(int argc, char** argv)
     {
       ROS_INFO("Saving scene '%s'", scene_names[i].c_str());
       psm.getPlanningScene()->setPlanningSceneMsg(static_cast<const moveit_msgs::PlanningScene&>(*pswm));
-      std::ofstream fout((scene_names[i] + ".scene").c_str());
-      psm.getPlanningScene()->saveGeometryToStream(fout);
-      fout.close();
+      if (vm.count("binary"))
+      {
+        std::ofstream fout((scene_names[i] + ".bscene").c_str(), std::ios::binary);
+        psm.getPlanningScene()->saveGeometryToBinaryStream(fout);
+      }
+      else
+      {
+        std::ofstream fout((scene_names[i] + ".scene").c_str());
+        psm.getPlanningScene()->saveGeometryToStream(fout);
+      }
 
       std::vector<std::string> robotStateNames;
       robot_model::RobotModelConstPtr km = psm.getRobotModel();
@@ -0,0 +1,332 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/warehouse/trajectory_encoding.h>
+#include <ros/serialization.h>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+const uint8_t VERSION = 1;
+
+// flags of the per-joint columns present in an encoding
+enum Column
+{
+  POSITIONS = 1,
+  VELOCITIES = 2,
+  ACCELERATIONS = 4,
+  EFFORT = 8
+};
+
+class Writer
+{
+public:
+  Writer(std::vector<uint8_t>& data) : data_(data)
+  {
+  }
+
+  void writeVarint(uint64_t value)
+  {
+    while (value >= 0x80)
+    {
+      data_.push_back(static_cast<uint8_t>(value | 0x80));
+      value >>= 7;
+    }
+    data_.push_back(static_cast<uint8_t>(value));
+  }
+
+  // zig-zag encoding, so that small negative values are short too
+  void writeSignedVarint(int64_t value)
+  {
+    writeVarint((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+  }
+
+  void writeBytes(const void* bytes, std::size_t size)
+  {
+    const uint8_t* b = static_cast<const uint8_t*>(bytes);
+    data_.insert(data_.end(), b, b + size);
+  }
+
+  void writeString(const std::string& s)
+  {
+    writeVarint(s.size());
+    writeBytes(s.data(), s.size());
+  }
+
+private:
+  std::vector<uint8_t>& data_;
+};
+
+class Reader
+{
+public:
+  Reader(const std::vector<uint8_t>& data) : data_(data), offset_(0)
+  {
+  }
+
+  std::size_t remaining() const
+  {
+    return data_.size() - offset_;
+  }
+
+  bool readVarint(uint64_t& value)
+  {
+    value = 0;
+    for (unsigned int shift = 0; shift < 64 && offset_ < data_.size(); shift += 7)
+    {
+      uint8_t b = data_[offset_++];
+      value |= static_cast<uint64_t>(b & 0x7f) << shift;
+      if (!(b & 0x80))
+        return true;
+    }
+    return false;
+  }
+
+  bool readSignedVarint(int64_t& value)
+  {
+    uint64_t v;
+    if (!readVarint(v))
+      return false;
+    value = static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+    return true;
+  }
+
+  bool readBytes(void* bytes, std::size_t size)
+  {
+    if (remaining() < size)
+      return false;
+    memcpy(bytes, &data_[offset_], size);
+    offset_ += size;
+    return true;
+  }
+
+  bool readString(std::string& s)
+  {
+    uint64_t size;
+    if (!readVarint(size) || remaining() < size)
+      return false;
+    s.assign(reinterpret_cast<const char*>(&data_[offset_]), size);
+    offset_ += size;
+    return true;
+  }
+
+  const uint8_t* current() const
+  {
+    return &data_[offset_];
+  }
+
+  void skip(std::size_t size)
+  {
+    offset_ += size;
+  }
+
+private:
+  const std::vector<uint8_t>& data_;
+  std::size_t offset_;
+};
+
+std::vector<double>& getColumn(trajectory_msgs::JointTrajectoryPoint& point, Column column)
+{
+  switch (column)
+  {
+    case VELOCITIES:
+      return point.velocities;
+    case ACCELERATIONS:
+      return point.accelerations;
+    case EFFORT:
+      return point.effort;
+    default:
+      return point.positions;
+  }
+}
+
+const std::vector<double>& getColumn(const trajectory_msgs::JointTrajectoryPoint& point, Column column)
+{
+  return getColumn(const_cast<trajectory_msgs::JointTrajectoryPoint&>(point), column);
+}
+
+const Column COLUMNS[] = { POSITIONS, VELOCITIES, ACCELERATIONS, EFFORT };
+}
+
+bool moveit_warehouse::encodeTrajectory(const moveit_msgs::RobotTrajectory& trajectory, std::vector<uint8_t>& data,
+                                        double resolution)
+{
+  const trajectory_msgs::JointTrajectory& jt = trajectory.joint_trajectory;
+  const std::size_t joints = jt.joint_names.size();
+
+  // a column is stored if all points have it, and omitted if none has it
+  uint8_t columns = 0;
+  for (std::size_t c = 0; c < 4; ++c)
+  {
+    std::size_t with_column = 0;
+    for (std::size_t i = 0; i < jt.points.size(); ++i)
+    {
+      std::size_t size = getColumn(jt.points[i], COLUMNS[c]).size();
+      if (size == joints && joints > 0)
+        ++with_column;
+      else if (size != 0)
+        return false;
+    }
+    if (with_column == jt.points.size() && with_column > 0)
+      columns |= COLUMNS[c];
+    else if (with_column > 0)
+      return false;
+  }
+
+  data.clear();
+  Writer out(data);
+  out.writeVarint(VERSION);
+  out.writeBytes(&resolution, sizeof(resolution));
+  out.writeVarint(jt.header.seq);
+  out.writeVarint(jt.header.stamp.sec);
+  out.writeVarint(jt.header.stamp.nsec);
+  out.writeString(jt.header.frame_id);
+  out.writeVarint(joints);
+  for (std::size_t j = 0; j < joints; ++j)
+    out.writeString(jt.joint_names[j]);
+  out.writeVarint(jt.points.size());
+  out.writeVarint(columns);
+
+  int64_t previous_time = 0;
+  for (std::size_t i = 0; i < jt.points.size(); ++i)
+  {
+    int64_t time = jt.points[i].time_from_start.toNSec();
+    out.writeSignedVarint(time - previous_time);
+    previous_time = time;
+  }
+
+  for (std::size_t c = 0; c < 4; ++c)
+    if (columns & COLUMNS[c])
+      for (std::size_t j = 0; j < joints; ++j)
+      {
+        int64_t previous = 0;
+        for (std::size_t i = 0; i < jt.points.size(); ++i)
+        {
+          double value = getColumn(jt.points[i], COLUMNS[c])[j] / resolution;
+          if (!std::isfinite(value) || std::fabs(value) > 1e18)
+            return false;
+          int64_t quantized = llround(value);
+          out.writeSignedVarint(quantized - previous);
+          previous = quantized;
+        }
+      }
+
+  const trajectory_msgs::MultiDOFJointTrajectory& mdt = trajectory.multi_dof_joint_trajectory;
+  if (mdt.joint_names.empty() && mdt.points.empty() && mdt.header.frame_id.empty())
+    out.writeVarint(0);
+  else
+  {
+    uint32_t length = ros::serialization::serializationLength(mdt);
+    std::vector<uint8_t> buffer(length);
+    ros::serialization::OStream stream(buffer.data(), length);
+    ros::serialization::serialize(stream, mdt);
+    out.writeVarint(length);
+    out.writeBytes(buffer.data(), length);
+  }
+  return true;
+}
+
+bool moveit_warehouse::decodeTrajectory(const std::vector<uint8_t>& data, moveit_msgs::RobotTrajectory& trajectory)
+{
+  trajectory = moveit_msgs::RobotTrajectory();
+  trajectory_msgs::JointTrajectory& jt = trajectory.joint_trajectory;
+  Reader in(data);
+
+  uint64_t version, seq, sec, nsec, joints, points, columns;
+  double resolution;
+  if (!in.readVarint(version) || version != VERSION || !in.readBytes(&resolution, sizeof(resolution)) ||
+      !in.readVarint(seq) || !in.readVarint(sec) || !in.readVarint(nsec) || !in.readString(jt.header.frame_id) ||
+      !in.readVarint(joints) || joints > in.remaining())
+    return false;
+  jt.header.seq = seq;
+  jt.header.stamp.sec = sec;
+  jt.header.stamp.nsec = nsec;
+
+  jt.joint_names.resize(joints);
+  for (std::size_t j = 0; j < joints; ++j)
+    if (!in.readString(jt.joint_names[j]))
+      return false;
+  // every point takes at least one byte, for its time offset
+  if (!in.readVarint(points) || points > in.remaining() || !in.readVarint(columns))
+    return false;
+
+  jt.points.resize(points);
+  int64_t time = 0;
+  for (std::size_t i = 0; i < points; ++i)
+  {
+    int64_t delta;
+    if (!in.readSignedVarint(delta))
+      return false;
+    time += delta;
+    jt.points[i].time_from_start.fromNSec(time);
+  }
+
+  for (std::size_t c = 0; c < 4; ++c)
+    if (columns & COLUMNS[c])
+    {
+      for (std::size_t i = 0; i < points; ++i)
+        getColumn(jt.points[i], COLUMNS[c]).resize(joints);
+      for (std::size_t j = 0; j < joints; ++j)
+      {
+        int64_t quantized = 0;
+        for (std::size_t i = 0; i < points; ++i)
+        {
+          int64_t delta;
+          if (!in.readSignedVarint(delta))
+            return false;
+          quantized += delta;
+          getColumn(jt.points[i], COLUMNS[c])[j] = quantized * resolution;
+        }
+      }
+    }
+
+  uint64_t length;
+  if (!in.readVarint(length) || length > in.remaining())
+    return false;
+  if (length > 0)
+  {
+    try
+    {
+      ros::serialization::IStream stream(const_cast<uint8_t*>(in.current()), length);
+      ros::serialization::deserialize(stream, trajectory.multi_dof_joint_trajectory);
+    }
+    catch (ros::Exception& ex)
+    {
+      return false;
+    }
+    in.skip(length);
+  }
+  return in.remaining() == 0;
+}
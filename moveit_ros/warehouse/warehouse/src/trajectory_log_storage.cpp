@@ -0,0 +1,213 @@
+/*********************************************************************
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2026, the MoveIt contributors
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of the copyright holder nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *********************************************************************/
+
+#include <moveit/warehouse/trajectory_log_storage.h>
+#include <moveit/warehouse/trajectory_encoding.h>
+
+const std::string moveit_warehouse::TrajectoryLogStorage::DATABASE_NAME = "moveit_trajectory_log";
+
+const std::string moveit_warehouse::TrajectoryLogStorage::TRAJECTORY_ID_NAME = "trajectory_id";
+const std::string moveit_warehouse::TrajectoryLogStorage::ROBOT_NAME = "robot_id";
+const std::string moveit_warehouse::TrajectoryLogStorage::GROUP_NAME = "group_id";
+const std::string moveit_warehouse::TrajectoryLogStorage::LOG_TIME_NAME = "log_time";
+
+using warehouse_ros::Metadata;
+using warehouse_ros::Query;
+
+moveit_warehouse::TrajectoryLogStorage::TrajectoryLogStorage(warehouse_ros::DatabaseConnection::Ptr conn,
+                                                             std::size_t max_queue_size, double resolution)
+  : MoveItMessageStorage(conn)
+  , resolution_(resolution)
+  , max_queue_size_(max_queue_size)
+  , dropped_(0)
+  , writing_(false)
+  , stop_(false)
+{
+  createCollections();
+  write_thread_ = boost::thread(&TrajectoryLogStorage::writeThread, this);
+}
+
+moveit_warehouse::TrajectoryLogStorage::~TrajectoryLogStorage()
+{
+  {
+    boost::mutex::scoped_lock slock(queue_lock_);
+    stop_ = true;
+    queue_condition_.notify_all();
+  }
+  write_thread_.join();
+}
+
+void moveit_warehouse::TrajectoryLogStorage::createCollections()
+{
+  trajectory_collection_ = conn_->openCollectionPtr<std_msgs::UInt8MultiArray>(DATABASE_NAME, "trajectories");
+}
+
+void moveit_warehouse::TrajectoryLogStorage::reset()
+{
+  flush();
+  boost::mutex::scoped_lock slock(collection_lock_);
+  trajectory_collection_.reset();
+  conn_->dropDatabase(DATABASE_NAME);
+  createCollections();
+}
+
+bool moveit_warehouse::TrajectoryLogStorage::logTrajectory(const moveit_msgs::RobotTrajectory& trajectory,
+                                                           const std::string& id, const std::string& robot,
+                                                           const std::string& group)
+{
+  // copy outside of the lock, so the writer thread is not held up
+  LogEntry entry;
+  entry.trajectory = trajectory;
+  entry.id = id;
+  entry.robot = robot;
+  entry.group = group;
+  entry.time = ros::Time::now();
+
+  boost::mutex::scoped_lock slock(queue_lock_);
+  if (queue_.size() >= max_queue_size_)
+  {
+    ++dropped_;
+    ROS_WARN_THROTTLE(1.0, "Trajectory log queue is full; dropped trajectory '%s'", id.c_str());
+    return false;
+  }
+  queue_.push_back(LogEntry());
+  std::swap(queue_.back(), entry);
+  queue_condition_.notify_all();
+  return true;
+}
+
+void moveit_warehouse::TrajectoryLogStorage::flush()
+{
+  boost::mutex::scoped_lock slock(queue_lock_);
+  while (!queue_.empty() || writing_)
+    written_condition_.wait(slock);
+}
+
+std::size_t moveit_warehouse::TrajectoryLogStorage::getDroppedCount() const
+{
+  boost::mutex::scoped_lock slock(queue_lock_);
+  return dropped_;
+}
+
+void moveit_warehouse::TrajectoryLogStorage::writeThread()
+{
+  std::deque<LogEntry> batch;
+  std_msgs::UInt8MultiArray encoded;
+  boost::mutex::scoped_lock slock(queue_lock_);
+  while (true)
+  {
+    while (queue_.empty() && !stop_)
+      queue_condition_.wait(slock);
+    if (queue_.empty())
+      break;
+
+    // take everything queued so far and write it without holding the queue
+    batch.swap(queue_);
+    writing_ = true;
+    slock.unlock();
+
+    std::size_t failed = 0;
+    {
+      boost::mutex::scoped_lock clock(collection_lock_);
+      for (std::size_t i = 0; i < batch.size(); ++i)
+      {
+        if (!encodeTrajectory(batch[i].trajectory, encoded.data, resolution_))
+        {
+          ROS_ERROR("Unable to encode trajectory '%s' for the log: the points do not have one value per joint",
+                    batch[i].id.c_str());
+          ++failed;
+          continue;
+        }
+        Metadata::Ptr metadata = trajectory_collection_->createMetadata();
+        metadata->append(TRAJECTORY_ID_NAME, batch[i].id);
+        metadata->append(ROBOT_NAME, batch[i].robot);
+        metadata->append(GROUP_NAME, batch[i].group);
+        metadata->append(LOG_TIME_NAME, batch[i].time.toSec());
+        trajectory_collection_->insert(encoded, metadata);
+      }
+    }
+    ROS_DEBUG("Logged %u trajectories", (unsigned int)(batch.size() - failed));
+    batch.clear();
+
+    slock.lock();
+    dropped_ += failed;
+    writing_ = false;
+    written_condition_.notify_all();
+  }
+}
+
+void moveit_warehouse::TrajectoryLogStorage::getLoggedTrajectoryIds(std::vector<std::string>& ids,
+                                                                    const ros::Time& from, const ros::Time& to,
+                                                                    const std::string& robot,
+                                                                    const std::string& group) const
+{
+  ids.clear();
+  boost::mutex::scoped_lock slock(collection_lock_);
+  Query::Ptr q = trajectory_collection_->createQuery();
+  q->appendRangeInclusive(LOG_TIME_NAME, from.toSec(), to.toSec());
+  if (!robot.empty())
+    q->append(ROBOT_NAME, robot);
+  if (!group.empty())
+    q->append(GROUP_NAME, group);
+  std::vector<EncodedTrajectoryWithMetadata> logged = trajectory_collection_->queryList(q, true, LOG_TIME_NAME, true);
+  for (std::size_t i = 0; i < logged.size(); ++i)
+    if (logged[i]->lookupField(TRAJECTORY_ID_NAME))
+      ids.push_back(logged[i]->lookupString(TRAJECTORY_ID_NAME));
+}
+
+bool moveit_warehouse::TrajectoryLogStorage::getLoggedTrajectory(moveit_msgs::RobotTrajectory& trajectory,
+                                                                 const std::string& id, const std::string& robot,
+                                                                 const std::string& group) const
+{
+  std::vector<EncodedTrajectoryWithMetadata> logged;
+  {
+    boost::mutex::scoped_lock slock(collection_lock_);
+    Query::Ptr q = trajectory_collection_->createQuery();
+    q->append(TRAJECTORY_ID_NAME, id);
+    if (!robot.empty())
+      q->append(ROBOT_NAME, robot);
+    if (!group.empty())
+      q->append(GROUP_NAME, group);
+    logged = trajectory_collection_->queryList(q, false, LOG_TIME_NAME, false);
+  }
+  if (logged.empty())
+    return false;
+  // the most recent trajectory with this id
+  if (!decodeTrajectory(logged.front()->data, trajectory))
+  {
+    ROS_ERROR("Logged trajectory '%s' could not be decoded", id.c_str());
+    return false;
+  }
+  return true;
+}
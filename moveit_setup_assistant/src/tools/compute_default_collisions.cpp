@@ -59,29 +59,13 @@ const boost::unordered_map<std::string, DisabledReason> reasonsFromString = boos
 // Unique set of pairs of links in string-based form
 typedef std::set<std::pair<std::string, std::string> > StringPairSet;
 
-// Struct for passing parameters to threads, for cleaner code
-struct ThreadComputation
-{
-  ThreadComputation(planning_scene::PlanningScene& scene, const collision_detection::CollisionRequest& req,
-                    int thread_id, int num_trials, StringPairSet* links_seen_colliding, boost::mutex* lock,
-                    unsigned int* progress)
-    : scene_(scene)
-    , req_(req)
-    , thread_id_(thread_id)
-    , num_trials_(num_trials)
-    , links_seen_colliding_(links_seen_colliding)
-    , lock_(lock)
-    , progress_(progress)
-  {
-  }
-  planning_scene::PlanningScene& scene_;
-  const collision_detection::CollisionRequest& req_;
-  int thread_id_;
-  unsigned int num_trials_;
-  StringPairSet* links_seen_colliding_;
-  boost::mutex* lock_;
-  unsigned int* progress_;  // only to be updated by thread 0
-};
+// Number of random states sampled and checked together while searching for never colliding pairs
+static const unsigned int NEVER_COLLISION_BATCH_SIZE = 256;
+
+// Fraction of the requested trials that must pass without finding a new colliding pair before sampling stops early.
+// By the rule of three, the pairs still unseen then collide in less than 3 / (fraction * num_trials) of all states
+// with 95% confidence
+static const double NEVER_COLLISION_STALL_FRACTION = 0.25;
 
 // LinkGraph defines a Link's model and a set of unique links it connects
 typedef std::map<const robot_model::LinkModel*, std::set<const robot_model::LinkModel*> > LinkGraph;
@@ -150,7 +134,8 @@ static unsigned int disableAlwaysInCollision(planning_scene::PlanningScene& scen
                                              StringPairSet& links_seen_colliding, double min_collision_faction = 0.95);
 
 /**
- * \brief Get the pairs of links that are never in collision
+ * \brief Get the pairs of links that are never in collision. Sampling stops before num_trials once a quarter of them
+ * have passed without finding a new colliding pair
  * \param scene A reference to the robot in the planning scene
  * \param link_pairs List of all unique link pairs and each pair's properties
  * \param req A reference to a collision request that is already initialized
@@ -161,12 +146,6 @@ static unsigned int disableNeverInCollision(const unsigned int num_trials, plann
                                             LinkPairMap& link_pairs, const collision_detection::CollisionRequest& req,
                                             StringPairSet& links_seen_colliding, unsigned int* progress);
 
-/**
- * \brief Thread for getting the pairs of links that are never in collision
- * \param tc Struct that encapsulates all the data each thread needs
- */
-static void disableNeverInCollisionThread(ThreadComputation tc);
-
 // ******************************************************************************************
 // Generates an adjacency list of links that are always and never in collision, to speed up collision detection
 // ******************************************************************************************
@@ -555,29 +534,57 @@ unsigned int disableNeverInCollision(const unsigned int num_trials, planning_sce
 {
   unsigned int num_disabled = 0;
 
-  boost::thread_group bgroup;  // create a group of threads
-  boost::mutex lock;           // used for sharing the same data structures
+  // Sample the states in batches so the collision checks of each batch are spread over all cores by the collision
+  // robot. Every state has its own result, so the contacts are merged here, between batches, without any locking
+  const collision_detection::CollisionRobotConstPtr& crobot = scene.getCollisionRobotUnpadded();
+  const unsigned int batch_size = std::max(1u, std::min(num_trials, NEVER_COLLISION_BATCH_SIZE));
+  std::vector<robot_state::RobotState> kstates(batch_size, robot_state::RobotState(scene.getRobotModel()));
+  std::vector<const robot_state::RobotState*> states(batch_size);
+  for (unsigned int i = 0; i < batch_size; ++i)
+    states[i] = &kstates[i];
+  std::vector<collision_detection::CollisionResult> results;
+
+  // Stop early once no new colliding pair has been found for a while: the remaining pairs are never colliding
+  const unsigned int stall_trials =
+      std::max(batch_size, static_cast<unsigned int>(num_trials * NEVER_COLLISION_STALL_FRACTION));
+  unsigned int trials_since_new_pair = 0;
+
+  for (unsigned int trial = 0; trial < num_trials && trials_since_new_pair < stall_trials; trial += batch_size)
+  {
+    boost::this_thread::interruption_point();
+    *progress = trial * 92 / num_trials + 8;  // 8 is the amount of progress already completed in prev steps
 
-  int num_threads = boost::thread::hardware_concurrency();  // how many cores does this computer have?
-  // ROS_INFO_STREAM("Performing " << num_trials << " trials for 'always in collision' checking on " <<
-  //   num_threads << " threads...");
+    const unsigned int count = std::min(batch_size, num_trials - trial);
+    states.resize(count);
+    for (unsigned int i = 0; i < count; ++i)
+    {
+      kstates[i].setToRandomPositions();
+      kstates[i].update();
+    }
 
-  for (int i = 0; i < num_threads; ++i)
-  {
-    ThreadComputation tc(scene, req, i, num_trials / num_threads, &links_seen_colliding, &lock, progress);
-    bgroup.create_thread(boost::bind(&disableNeverInCollisionThread, tc));
-  }
+    // Pairs already seen colliding are allowed in the matrix, so only contacts of new pairs are reported
+    crobot->checkSelfCollisionBatch(req, results, states, scene.getAllowedCollisionMatrix(), false);
 
-  try
-  {
-    bgroup.join_all();  // wait for all threads to finish
-  }
-  catch (boost::thread_interrupted)
-  {
-    ROS_WARN("disableNeverInCollision interrupted");
-    bgroup.interrupt_all();
-    bgroup.join_all();  // wait for all threads to interrupt
-    throw;
+    bool found_new_pair = false;
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+      // Check all contacts
+      for (collision_detection::CollisionResult::ContactMap::const_iterator it = results[i].contacts.begin();
+           it != results[i].contacts.end(); ++it)
+      {
+        if (links_seen_colliding.insert(it->first).second)
+        {
+          scene.getAllowedCollisionMatrixNonConst().setEntry(it->first.first, it->first.second,
+                                                             true);  // disable link checking in the collision matrix
+          found_new_pair = true;
+        }
+      }
+    }
+
+    if (found_new_pair)
+      trials_since_new_pair = 0;
+    else
+      trials_since_new_pair += count;
   }
 
   // Loop through every possible link pair and check if it has ever been seen in collision
@@ -603,53 +610,6 @@ unsigned int disableNeverInCollision(const unsigned int num_trials, planning_sce
   return num_disabled;
 }
 
-// ******************************************************************************************
-// Thread for getting the pairs of links that are never in collision
-// ******************************************************************************************
-void disableNeverInCollisionThread(ThreadComputation tc)
-{
-  // ROS_INFO_STREAM("Thread " << tc.thread_id_ << " running " << tc.num_trials_ << " trials");
-
-  // User feedback vars
-  const unsigned int progress_interval = tc.num_trials_ / 20;  // show progress update every 5%
-
-  // Create a new kinematic state for this thread to work on
-  robot_state::RobotState kstate(tc.scene_.getRobotModel());
-
-  // Do a large number of tests
-  for (unsigned int i = 0; i < tc.num_trials_; ++i)
-  {
-    boost::this_thread::interruption_point();
-
-    // Status update at intervals and only for 0 thread
-    if (i % progress_interval == 0 && tc.thread_id_ == 0)
-    {
-      (*tc.progress_) = i * 92 / tc.num_trials_ + 8;  // 8 is the amount of progress already completed in prev steps
-    }
-
-    collision_detection::CollisionResult res;
-    kstate.setToRandomPositions();
-    tc.scene_.checkSelfCollision(tc.req_, res, kstate);
-
-    // Check all contacts
-    for (collision_detection::CollisionResult::ContactMap::const_iterator it = res.contacts.begin();
-         it != res.contacts.end(); ++it)
-    {
-      // Check if this collision pair is unique before doing a thread lock
-      if (tc.links_seen_colliding_->find(it->first) == tc.links_seen_colliding_->end())
-      {
-        // Collision Matrix and links_seen_colliding is modified only if needed, based on above if statement
-
-        boost::mutex::scoped_lock slock(*tc.lock_);
-        tc.links_seen_colliding_->insert(it->first);
-
-        tc.scene_.getAllowedCollisionMatrixNonConst().setEntry(it->first.first, it->first.second,
-                                                               true);  // disable link checking in the collision matrix
-      }
-    }
-  }
-}
-
 // ******************************************************************************************
 // Converts a reason for disabling a link pair into a string
 // ******************************************************************************************